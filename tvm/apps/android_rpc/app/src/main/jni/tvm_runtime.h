@@ -42,6 +42,7 @@
 #include "../src/runtime/dso_library.cc"
 #include "../src/runtime/file_utils.cc"
 #include "../src/runtime/graph/graph_runtime.cc"
+#include "../src/runtime/graph/op_sampler.cc"
 #include "../src/runtime/graph/debug/graph_runtime_debug.cc"
 #include "../src/runtime/graph/graph_runtime_factory.cc"
 #include "../src/runtime/library_module.cc"
@@ -61,6 +62,7 @@
 #include "../src/runtime/system_library.cc"
 #include "../src/runtime/thread_pool.cc"
 #include "../src/runtime/threading_backend.cc"
+#include "../src/runtime/memory_stats.cc"
 #include "../src/runtime/workspace_pool.cc"
 
 #ifdef TVM_OPENCL_RUNTIME
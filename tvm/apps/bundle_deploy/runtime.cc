@@ -27,6 +27,8 @@
 #include "../../src/runtime/cpu_device_api.cc"
 #include "../../src/runtime/file_utils.cc"
 #include "../../src/runtime/graph/graph_runtime.cc"
+#include "../../src/runtime/graph/op_sampler.cc"
+#include "../../src/runtime/profiling.cc"
 #include "../../src/runtime/library_module.cc"
 #include "../../src/runtime/module.cc"
 #include "../../src/runtime/ndarray.cc"
@@ -35,4 +37,5 @@
 #include "../../src/runtime/system_library.cc"
 #include "../../src/runtime/thread_pool.cc"
 #include "../../src/runtime/threading_backend.cc"
+#include "../../src/runtime/memory_stats.cc"
 #include "../../src/runtime/workspace_pool.cc"
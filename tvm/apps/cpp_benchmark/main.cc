@@ -0,0 +1,428 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file main.cc
+ * \brief Native benchmark of a deployed graph runtime or VM module, for the devices where no
+ *  Python runtime is available.
+ */
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sys/resource.h>
+#endif
+#include <dmlc/logging.h>
+#include <tvm/runtime/data_type.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/vm/memory_manager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace tvm::runtime;
+
+static const string kUsage =
+    "Command line usage\n"
+    "--lib         - The deployed library, exported by export_library\n"
+    "--params      - The saved parameters of a graph runtime module, Default=\"\"\n"
+    "--vm-code     - The bytecode of a VM executable, benchmark a VM module when set\n"
+    "--device      - cpu, cuda, opencl, vulkan or metal, Default=cpu\n"
+    "--device-id   - The device id, Default=0\n"
+    "--input       - An input as name:shape:dtype, e.g. data:1x3x224x224:float32. Repeat it\n"
+    "                for several inputs, they are zero filled. The VM takes them in order.\n"
+    "--warmup      - The number of runs before the measurement, Default=10\n"
+    "--iter        - The number of measured runs, Default=100\n"
+    "--affinity    - big, little or weighted, the cores of the CPU thread pool, Default=\"\"\n"
+    "--threads     - The number of CPU threads, 0 for all, Default=0\n"
+    "--profile     - Report the time of every op with the debug graph runtime\n"
+    "--json        - Print the report as one JSON object\n"
+    "\n"
+    "  Example\n"
+    "  ./tvm_benchmark --lib=deploy.so --params=deploy.params --device=opencl "
+    "--input=data:1x3x224x224:float32 --affinity=big --iter=200"
+    "\n";
+
+/*! \brief An input of the benchmarked module. */
+struct BenchmarkInput {
+  string name;
+  vector<int64_t> shape;
+  DLDataType dtype;
+};
+
+/*!
+ * \brief BenchmarkArgs.
+ * \arg lib The deployed library.
+ * \arg params The saved parameters of a graph runtime module.
+ * \arg vm_code The bytecode of a VM executable, empty for a graph runtime module.
+ * \arg ctx The device of the module.
+ * \arg inputs The inputs set before the runs.
+ * \arg warmup The number of runs before the measurement.
+ * \arg iter The number of measured runs.
+ * \arg affinity The affinity mode of the CPU thread pool, 0 to keep the default.
+ * \arg threads The number of CPU threads.
+ * \arg profile Whether to report the time of every op.
+ * \arg json Whether to print the report as JSON.
+ */
+struct BenchmarkArgs {
+  string lib;
+  string params;
+  string vm_code;
+  TVMContext ctx{kDLCPU, 0};
+  vector<BenchmarkInput> inputs;
+  int warmup = 10;
+  int iter = 100;
+  int affinity = 0;
+  int threads = 0;
+  bool profile = false;
+  bool json = false;
+};
+
+/*!
+ * \brief GetCmdOptions Find all the values of a command option.
+ * \param argc arg counter
+ * \param argv arg values
+ * \param option command line option to search for, ending with '='.
+ * \return the values of every occurrence of the option.
+ */
+vector<string> GetCmdOptions(int argc, char* argv[], const string& option) {
+  vector<string> values;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg.find(option) == 0) {
+      ICHECK_EQ(*option.rbegin(), '=');
+      values.push_back(arg.substr(option.size()));
+    }
+  }
+  return values;
+}
+
+/*!
+ * \brief GetCmdOption Find the last value of a command option.
+ * \return the value, or the default when the option is absent.
+ */
+string GetCmdOption(int argc, char* argv[], const string& option, const string& dft = "") {
+  vector<string> values = GetCmdOptions(argc, argv, option);
+  return values.empty() ? dft : values.back();
+}
+
+/*! \brief HasCmdFlag Whether a flag without value is present. */
+bool HasCmdFlag(int argc, char* argv[], const string& flag) {
+  for (int i = 1; i < argc; ++i) {
+    if (flag == argv[i]) return true;
+  }
+  return false;
+}
+
+/*! \brief Split a string at every occurrence of a delimiter. */
+vector<string> Split(const string& str, char delim) {
+  vector<string> parts;
+  stringstream ss(str);
+  string part;
+  while (getline(ss, part, delim)) parts.push_back(part);
+  return parts;
+}
+
+/*! \brief Parse an input given as name:shape:dtype. */
+BenchmarkInput ParseInput(const string& str) {
+  vector<string> parts = Split(str, ':');
+  if (parts.size() != 3) {
+    LOG(FATAL) << "Wrong input format " << str << ", expected name:shape:dtype\n" << kUsage;
+  }
+  BenchmarkInput input;
+  input.name = parts[0];
+  for (const string& dim : Split(parts[1], 'x')) {
+    input.shape.push_back(stoll(dim));
+  }
+  input.dtype = String2DLDataType(parts[2]);
+  return input;
+}
+
+/*!
+ * \brief ParseCmdArgs parses the command line arguments.
+ * \param argc arg counter
+ * \param argv arg values
+ * \param args the output structure which holds the parsed values
+ */
+void ParseCmdArgs(int argc, char* argv[], BenchmarkArgs& args) {
+  args.lib = GetCmdOption(argc, argv, "--lib=");
+  if (args.lib.empty()) {
+    LOG(FATAL) << "The deployed library is required\n" << kUsage;
+  }
+  args.params = GetCmdOption(argc, argv, "--params=");
+  args.vm_code = GetCmdOption(argc, argv, "--vm-code=");
+
+  const string device = GetCmdOption(argc, argv, "--device=", "cpu");
+  if (device == "cpu") {
+    args.ctx.device_type = kDLCPU;
+  } else if (device == "cuda") {
+    args.ctx.device_type = kDLGPU;
+  } else if (device == "opencl") {
+    args.ctx.device_type = kDLOpenCL;
+  } else if (device == "vulkan") {
+    args.ctx.device_type = kDLVulkan;
+  } else if (device == "metal") {
+    args.ctx.device_type = kDLMetal;
+  } else {
+    LOG(FATAL) << "Unknown device " << device << "\n" << kUsage;
+  }
+  args.ctx.device_id = stoi(GetCmdOption(argc, argv, "--device-id=", "0"));
+
+  for (const string& input : GetCmdOptions(argc, argv, "--input=")) {
+    args.inputs.push_back(ParseInput(input));
+  }
+  args.warmup = stoi(GetCmdOption(argc, argv, "--warmup=", "10"));
+  args.iter = stoi(GetCmdOption(argc, argv, "--iter=", "100"));
+  ICHECK_GE(args.warmup, 0);
+  ICHECK_GT(args.iter, 0);
+
+  const string affinity = GetCmdOption(argc, argv, "--affinity=");
+  if (affinity == "big") {
+    args.affinity = 1;
+  } else if (affinity == "little") {
+    args.affinity = -1;
+  } else if (affinity == "weighted") {
+    args.affinity = 2;
+  } else if (!affinity.empty()) {
+    LOG(FATAL) << "Unknown affinity " << affinity << "\n" << kUsage;
+  }
+  args.threads = stoi(GetCmdOption(argc, argv, "--threads=", "0"));
+  args.profile = HasCmdFlag(argc, argv, "--profile");
+  args.json = HasCmdFlag(argc, argv, "--json");
+}
+
+/*! \brief Read a whole file in binary mode, pass it as a TVMByteArray to keep its zeros. */
+string ReadFile(const string& path) {
+  ifstream fs(path, ios::in | ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open " << path;
+  stringstream ss;
+  ss << fs.rdbuf();
+  return ss.str();
+}
+
+/*! \brief Create the zero filled inputs on the device of the module. */
+vector<NDArray> CreateInputs(const BenchmarkArgs& args) {
+  vector<NDArray> arrays;
+  for (const BenchmarkInput& input : args.inputs) {
+    NDArray host = NDArray::Empty(input.shape, input.dtype, {kDLCPU, 0});
+    size_t nbytes = (input.dtype.bits * input.dtype.lanes + 7) / 8;
+    for (int64_t dim : input.shape) nbytes *= dim;
+    memset(host->data, 0, nbytes);
+    arrays.push_back(host.CopyTo(args.ctx));
+  }
+  return arrays;
+}
+
+/*! \brief Create a graph runtime, or its debug variant, with the parameters and the inputs. */
+Module CreateGraphRuntime(const BenchmarkArgs& args, Module lib, bool debug) {
+  Module gmod = debug ? lib.GetFunction("debug_create")("default", args.ctx)
+                      : lib.GetFunction("default")(args.ctx);
+  if (!args.params.empty()) {
+    string params = ReadFile(args.params);
+    gmod.GetFunction("load_params")(TVMByteArray{params.data(), params.size()});
+  }
+  PackedFunc set_input = gmod.GetFunction("set_input");
+  vector<NDArray> arrays = CreateInputs(args);
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    set_input(args.inputs[i].name, arrays[i]);
+  }
+  return gmod;
+}
+
+/*! \brief Create a VM with its inputs set, returns the function running it once. */
+PackedFunc CreateVM(const BenchmarkArgs& args, Module lib) {
+  const PackedFunc* load = Registry::Get("runtime.Load_Executable");
+  const PackedFunc* create = Registry::Get("runtime._VirtualMachine");
+  ICHECK(load != nullptr && create != nullptr) << "The runtime is built without the VM";
+  string code = ReadFile(args.vm_code);
+  Module exec = (*load)(TVMByteArray{code.data(), code.size()}, lib);
+  Module vm = (*create)(exec);
+  // The pooled allocator, like the Python VirtualMachine
+  vm.GetFunction("init")(static_cast<int>(args.ctx.device_type), args.ctx.device_id,
+                         static_cast<int>(vm::kPooled));
+  vector<NDArray> arrays = CreateInputs(args);
+  vector<TVMValue> values(arrays.size() + 1);
+  vector<int> codes(arrays.size() + 1);
+  TVMArgsSetter setter(values.data(), codes.data());
+  setter(0, "main");
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    setter(i + 1, arrays[i]);
+  }
+  TVMRetValue rv;
+  vm.GetFunction("set_input").CallPacked(TVMArgs(values.data(), codes.data(), values.size()), &rv);
+  PackedFunc invoke = vm.GetFunction("invoke");
+  return PackedFunc([vm, invoke](TVMArgs args, TVMRetValue* rv) { invoke("main"); });
+}
+
+/*! \brief The value at a percentile of sorted samples, by the nearest rank. */
+double Percentile(const vector<double>& sorted, double p) {
+  size_t rank = static_cast<size_t>(ceil(p / 100.0 * sorted.size()));
+  return sorted[min(max(rank, static_cast<size_t>(1)), sorted.size()) - 1];
+}
+
+/*! \brief The peak resident set size of the process in bytes, -1 when unknown. */
+int64_t PeakRSSBytes() {
+#if defined(__linux__) || defined(__ANDROID__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+  }
+#endif
+  return -1;
+}
+
+/*! \brief The memory statistics of the runtime allocators available for the device. */
+vector<pair<string, int64_t>> MemoryStats(const BenchmarkArgs& args) {
+  vector<pair<string, int64_t>> stats;
+  stats.emplace_back("peak_rss_bytes", PeakRSSBytes());
+  if (args.ctx.device_type == kDLOpenCL) {
+    if (const PackedFunc* f = Registry::Get("device_api.opencl.TexturePoolStats")) {
+      for (const char* counter : {"hits", "grows", "misses", "bytes_wasted", "releases"}) {
+        int64_t value = (*f)(args.ctx.device_id, counter);
+        stats.emplace_back(string("texture_pool_") + counter, value);
+      }
+    }
+  }
+  if (const PackedFunc* f = Registry::Get("runtime.MemoryStat")) {
+    for (const char* kind : {"global", "texture", "workspace", "texture_pool", "vm_allocator"}) {
+      int64_t peak = (*f)(static_cast<int>(args.ctx.device_type), args.ctx.device_id, kind,
+                          "peak");
+      if (peak > 0) stats.emplace_back(string(kind) + "_peak_bytes", peak);
+    }
+  }
+  return stats;
+}
+
+/*!
+ * \brief RunBenchmark Runs the benchmark and prints the report.
+ * \param args the parsed arguments
+ * \return result of operation.
+ */
+int RunBenchmark(const BenchmarkArgs& args) {
+  if (args.affinity != 0 || args.threads != 0) {
+    const PackedFunc* config = Registry::Get("runtime.config_threadpool");
+    ICHECK(config != nullptr);
+    (*config)(args.affinity, args.threads);
+  }
+  Module lib = Module::LoadFromFile(args.lib);
+  PackedFunc run;
+  if (args.vm_code.empty()) {
+    run = CreateGraphRuntime(args, lib, false).GetFunction("run");
+  } else {
+    run = CreateVM(args, lib);
+  }
+  DeviceAPI* api = DeviceAPI::Get(args.ctx);
+
+  for (int i = 0; i < args.warmup; ++i) {
+    run();
+  }
+  api->StreamSync(args.ctx, nullptr);
+  vector<double> latency_ms;
+  latency_ms.reserve(args.iter);
+  for (int i = 0; i < args.iter; ++i) {
+    auto tbegin = chrono::steady_clock::now();
+    run();
+    api->StreamSync(args.ctx, nullptr);
+    auto tend = chrono::steady_clock::now();
+    latency_ms.push_back(chrono::duration<double, milli>(tend - tbegin).count());
+  }
+
+  vector<double> sorted = latency_ms;
+  sort(sorted.begin(), sorted.end());
+  double mean = 0;
+  for (double v : sorted) mean += v;
+  mean /= sorted.size();
+  double var = 0;
+  for (double v : sorted) var += (v - mean) * (v - mean);
+  double stddev = sqrt(var / sorted.size());
+  vector<pair<string, double>> latency{{"mean", mean},
+                                       {"std", stddev},
+                                       {"min", sorted.front()},
+                                       {"p50", Percentile(sorted, 50)},
+                                       {"p90", Percentile(sorted, 90)},
+                                       {"p99", Percentile(sorted, 99)},
+                                       {"max", sorted.back()}};
+  vector<pair<string, int64_t>> memory = MemoryStats(args);
+
+  string profile;
+  if (args.profile) {
+    if (args.vm_code.empty()) {
+      Module debug = CreateGraphRuntime(args, lib, true);
+      profile = debug.GetFunction("run_roofline")(1, args.iter, 0).operator string();
+    } else {
+      LOG(WARNING) << "The per op profile is only supported for graph runtime modules";
+    }
+  }
+
+  if (args.json) {
+    cout << "{\"device\": \"" << args.ctx << "\", \"iterations\": " << args.iter
+         << ", \"latency_ms\": {";
+    for (size_t i = 0; i < latency.size(); ++i) {
+      cout << (i ? ", " : "") << "\"" << latency[i].first << "\": " << latency[i].second;
+    }
+    cout << "}, \"memory\": {";
+    for (size_t i = 0; i < memory.size(); ++i) {
+      cout << (i ? ", " : "") << "\"" << memory[i].first << "\": " << memory[i].second;
+    }
+    cout << "}}" << endl;
+  } else {
+    cout << "Device: " << args.ctx << ", " << args.iter << " iterations after " << args.warmup
+         << " warmup runs\n";
+    cout << "Latency (ms):\n" << fixed << setprecision(3);
+    for (const auto& kv : latency) {
+      cout << "  " << left << setw(6) << kv.first << right << setw(12) << kv.second << "\n";
+    }
+    cout << "Memory:\n";
+    for (const auto& kv : memory) {
+      cout << "  " << left << setw(28) << kv.first << right << setw(16) << kv.second << "\n";
+    }
+  }
+  // The profile is a table, it goes to stderr in JSON mode to keep stdout parseable
+  if (!profile.empty()) {
+    (args.json ? cerr : cout) << profile;
+  }
+  return 0;
+}
+
+/*!
+ * \brief main The main function.
+ * \param argc arg counter
+ * \param argv arg values
+ * \return result of operation.
+ */
+int main(int argc, char* argv[]) {
+  if (argc <= 1 || HasCmdFlag(argc, argv, "--help")) {
+    LOG(INFO) << kUsage;
+    return 0;
+  }
+  BenchmarkArgs args;
+  ParseCmdArgs(argc, argv, args);
+  return RunBenchmark(args);
+}
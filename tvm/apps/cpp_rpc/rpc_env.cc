@@ -27,17 +27,26 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <utime.h>
 #else
 #include <Windows.h>
 #include <direct.h>
+#include <sys/stat.h>
+#include <sys/utime.h>
 namespace {
 int mkdir(const char* path, int /* ignored */) { return _mkdir(path); }
 }  // namespace
 #endif
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "../../src/support/utils.h"
@@ -61,6 +70,14 @@ std::string GenerateUntarCommand(const std::string& tar_file, const std::string&
   return untar_cmd;
 }
 
+void CopyFile(const std::string& from, const std::string& to) {
+  std::ifstream in(from, std::ios::in | std::ios::binary);
+  ICHECK(!in.fail()) << "Cannot open " << from;
+  std::ofstream out(to, std::ios::out | std::ios::binary);
+  ICHECK(!out.fail()) << "Cannot open " << to;
+  out << in.rdbuf();
+}
+
 }  // Anonymous namespace
 
 namespace tvm {
@@ -85,6 +102,13 @@ void CleanDir(const std::string& dirname);
  */
 std::string BuildSharedLibrary(std::string file_in);
 
+/*!
+ * \brief ContentHash The cache key of a file content
+ * \param data The content of the file
+ * \return The key clients are expected to advertise for the content.
+ */
+std::string ContentHash(const std::string& data);
+
 RPCEnv::RPCEnv() {
 #ifndef _WIN32
   char cwd[PATH_MAX];
@@ -98,18 +122,56 @@ RPCEnv::RPCEnv() {
 #endif
 
   mkdir(base_.c_str(), 0777);
-  TVM_REGISTER_GLOBAL("tvm.rpc.server.workpath").set_body([this](TVMArgs args, TVMRetValue* rv) {
-    *rv = this->GetPath(args[0]);
-  });
+  root_ = base_;
 
-  TVM_REGISTER_GLOBAL("tvm.rpc.server.load_module").set_body([this](TVMArgs args, TVMRetValue* rv) {
-    std::string file_name = this->GetPath(args[0]);
-    file_name = BuildSharedLibrary(file_name);
-    *rv = Module::LoadFromFile(file_name, "");
-    LOG(INFO) << "Load module from " << file_name << " ...";
-  });
+  // The cache sits next to the work path so that it survives the clean up of every session.
+  cache_ = base_ + "_cache";
+  const char* cache_mb = getenv("TVM_RPC_CACHE_SIZE_MB");
+  cache_limit_ = static_cast<size_t>(cache_mb != nullptr ? atoi(cache_mb) : 1024) << 20;
+  if (cache_limit_ != 0) {
+    mkdir(cache_.c_str(), 0777);
+  }
+
+  // The runtime already registers a plain upload, override it with the caching one.
+  Registry::Register("tvm.rpc.server.upload", true)
+      .set_body([this](TVMArgs args, TVMRetValue* rv) {
+        std::string file_name = this->GetPath(args[0]);
+        std::string data = args[1];
+        std::ofstream fs(file_name, std::ios::out | std::ios::binary);
+        ICHECK(!fs.fail()) << "Cannot open " << file_name;
+        fs.write(data.data(), data.size());
+        fs.close();
+        LOG(INFO) << "Upload " << file_name << " ... nbytes=" << data.size();
+        if (args.size() > 2) {
+          // Only trust the key advertised by the client if it is the hash of what was sent.
+          std::string key = args[2];
+          if (key == ContentHash(data)) {
+            this->CacheInsert(key, args[0]);
+          } else {
+            LOG(WARNING) << "Cache key " << key << " does not match the content of " << file_name;
+          }
+        }
+      });
+
+  // Clients send the content hash of a file first, and only upload it on a miss.
+  Registry::Register("tvm.rpc.server.cache_lookup", true)
+      .set_body([this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->CacheLookup(args[0], args[1]);
+      });
+
+  // Every environment rebinds the work path functions, so they never refer to a previous one.
+  Registry::Register("tvm.rpc.server.workpath", true)
+      .set_body([this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetPath(args[0]); });
+
+  Registry::Register("tvm.rpc.server.load_module", true)
+      .set_body([this](TVMArgs args, TVMRetValue* rv) {
+        std::string file_name = this->GetPath(args[0]);
+        file_name = BuildSharedLibrary(file_name);
+        *rv = Module::LoadFromFile(file_name, "");
+        LOG(INFO) << "Load module from " << file_name << " ...";
+      });
 
-  TVM_REGISTER_GLOBAL("tvm.rpc.server.download_linked_module")
+  Registry::Register("tvm.rpc.server.download_linked_module", true)
       .set_body([this](TVMArgs args, TVMRetValue* rv) {
         std::string file_name = this->GetPath(args[0]);
         file_name = BuildSharedLibrary(file_name);
@@ -151,6 +213,11 @@ void RPCEnv::CleanUp() const {
   }
 }
 
+void RPCEnv::SetSession(const std::string& name) {
+  base_ = name.empty() ? root_ : root_ + "/" + name;
+  mkdir(base_.c_str(), 0777);
+}
+
 /*!
  * \brief ListDir get the list of files in a directory
  * \param dirname The root directory name
@@ -203,6 +270,64 @@ std::vector<std::string> ListDir(const std::string& dirname) {
   return vec;
 }
 
+std::string ContentHash(const std::string& data) {
+  // 64-bit FNV-1a, printed as 16 lower case hex digits.
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    hash = (hash ^ c) * 1099511628211ULL;
+  }
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));  // NOLINT(*)
+  return std::string(buf);
+}
+
+/*!
+ * \brief IsValidCacheKey Whether a cache key can be used as a file name
+ * \param key The cache key
+ */
+bool IsValidCacheKey(const std::string& key) {
+  return !key.empty() && std::all_of(key.begin(), key.end(), [](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  });
+}
+
+bool RPCEnv::CacheLookup(const std::string& key, const std::string& file_name) const {
+  if (cache_limit_ == 0 || !IsValidCacheKey(key)) return false;
+  std::string cache_file = cache_ + "/" + key;
+  struct stat st;
+  if (stat(cache_file.c_str(), &st) != 0) return false;
+  CopyFile(cache_file, this->GetPath(file_name));
+  // The modification time orders the cached files by their last use.
+  utime(cache_file.c_str(), nullptr);
+  LOG(INFO) << "Cache hit " << key << " for " << file_name;
+  return true;
+}
+
+void RPCEnv::CacheInsert(const std::string& key, const std::string& file_name) const {
+  if (cache_limit_ == 0 || !IsValidCacheKey(key)) return;
+  CopyFile(this->GetPath(file_name), cache_ + "/" + key);
+
+  // Evict the least recently used files until the cache fits in its limit.
+  std::vector<std::pair<time_t, std::string>> files;
+  size_t total_bytes = 0;
+  for (const auto& path : ListDir(cache_)) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+      files.emplace_back(st.st_mtime, path);
+      total_bytes += static_cast<size_t>(st.st_size);
+    }
+  }
+  std::sort(files.begin(), files.end());
+  for (const auto& file : files) {
+    if (total_bytes <= cache_limit_) break;
+    struct stat st;
+    if (stat(file.second.c_str(), &st) == 0 && std::remove(file.second.c_str()) == 0) {
+      total_bytes -= static_cast<size_t>(st.st_size);
+      LOG(INFO) << "Cache evict " << file.second;
+    }
+  }
+}
+
 #if defined(__linux__) || defined(__ANDROID__)
 /*!
  * \brief LinuxShared Creates a linux shared library
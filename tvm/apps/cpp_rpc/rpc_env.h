@@ -50,12 +50,44 @@ struct RPCEnv {
    * \brief The RPC Environment cleanup function
    */
   void CleanUp() const;
+  /*!
+   * \brief Move the work path to a sub directory, so that the files of the sessions served
+   *  by one process do not collide.
+   * \param name The name of the sub directory, empty for the top level work path.
+   */
+  void SetSession(const std::string& name);
+  /*!
+   * \brief Copy a cached file to the work path.
+   * \param key The content hash of the file computed by the client.
+   * \param file_name The file name in the work path.
+   * \return Whether the file was in the cache.
+   */
+  bool CacheLookup(const std::string& key, const std::string& file_name) const;
+  /*!
+   * \brief Add a file of the work path to the cache, evicting the least recently used files
+   *  once the cache exceeds its size limit.
+   * \param key The content hash of the file computed by the client.
+   * \param file_name The file name in the work path.
+   */
+  void CacheInsert(const std::string& key, const std::string& file_name) const;
 
  private:
   /*!
    * \brief Holds the environment path.
    */
   std::string base_;
+  /*!
+   * \brief Holds the top level environment path, which contains the session paths.
+   */
+  std::string root_;
+  /*!
+   * \brief Holds the cache path, which outlives the sessions unlike the environment path.
+   */
+  std::string cache_;
+  /*!
+   * \brief The size limit of the cache in bytes, 0 when the cache is disabled.
+   */
+  size_t cache_limit_;
 };  // RPCEnv
 
 }  // namespace runtime
@@ -23,15 +23,29 @@
  */
 #include <tvm/runtime/registry.h>
 #if defined(__linux__) || defined(__ANDROID__)
+#include <poll.h>
+#include <sys/epoll.h>
 #include <sys/select.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
+#include <unistd.h>
 #endif
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <future>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "../../src/runtime/rpc/rpc_endpoint.h"
 #include "../../src/runtime/rpc/rpc_socket_impl.h"
@@ -83,6 +97,35 @@ static std::string getNextString(std::stringstream* iss) {
 }
 #endif
 
+#if defined(__linux__) || defined(__ANDROID__)
+/*!
+ * \brief SessionChannel The channel of a session served by the session loop.
+ *
+ *  Only the sends go through the channel, the session loop feeds the received bytes to the
+ *  endpoint. The socket is owned and closed by the session loop.
+ */
+class SessionChannel final : public RPCChannel {
+ public:
+  explicit SessionChannel(support::TCPSocket sock) : sock_(sock) {}
+
+  size_t Send(const void* data, size_t size) final {
+    // A client that went away must not take the other sessions down with a SIGPIPE.
+    ssize_t n = sock_.Send(data, size, MSG_NOSIGNAL);
+    if (n == -1) {
+      support::Socket::Error("SessionChannel::Send");
+    }
+    return static_cast<size_t>(n);
+  }
+  size_t Recv(void* data, size_t size) final {
+    LOG(FATAL) << "Do not allow explicit receive";
+    return 0;
+  }
+
+ private:
+  support::TCPSocket sock_;
+};
+#endif
+
 /*!
  * \brief RPCServer RPC Server class.
  * \param host The hostname of the server, Default=0.0.0.0
@@ -91,6 +134,7 @@ static std::string getNextString(std::stringstream* iss) {
  * \param tracker The address of RPC tracker in host:port format e.g. 10.77.1.234:9190 Default=""
  * \param key The key used to identify the device type in tracker. Default=""
  * \param custom_addr Custom IP Address to Report to RPC Tracker. Default=""
+ * \param max_sessions The number of sessions served at the same time. Default=1
  */
 class RPCServer {
  public:
@@ -98,14 +142,15 @@ class RPCServer {
    * \brief Constructor.
    */
   RPCServer(std::string host, int port, int port_end, std::string tracker_addr, std::string key,
-            std::string custom_addr)
+            std::string custom_addr, int max_sessions)
       : host_(std::move(host)),
         port_(port),
         my_port_(0),
         port_end_(port_end),
         tracker_addr_(std::move(tracker_addr)),
         key_(std::move(key)),
-        custom_addr_(std::move(custom_addr)) {}
+        custom_addr_(std::move(custom_addr)),
+        max_sessions_(max_sessions) {}
 
   /*!
    * \brief Destructor.
@@ -126,7 +171,14 @@ class RPCServer {
     listen_sock_.Create();
     my_port_ = listen_sock_.TryBindHost(host_, port_, port_end_);
     LOG(INFO) << "bind to " << host_ << ":" << my_port_;
-    listen_sock_.Listen(1);
+    listen_sock_.Listen(std::max(max_sessions_, 1));
+#if defined(__linux__) || defined(__ANDROID__)
+    if (max_sessions_ > 1) {
+      SessionLoopProc();
+      listen_sock_.Close();
+      return;
+    }
+#endif
     std::future<void> proc(std::async(std::launch::async, &RPCServer::ListenLoopProc, this));
     proc.get();
     // Close the listen socket
@@ -225,6 +277,355 @@ class RPCServer {
     }
   }
 
+#if defined(__linux__) || defined(__ANDROID__)
+  /*!
+   * \brief Session A connection served by the session loop.
+   */
+  struct Session {
+    /*! \brief The connection. */
+    support::TCPSocket sock;
+    /*! \brief The address of the client. */
+    support::SockAddr addr;
+    /*! \brief The sub directory of the work path owned by the session. */
+    std::string name;
+    /*! \brief The endpoint, created once the connection is known not to be multiplexed. */
+    std::shared_ptr<RPCEndpoint> endpoint;
+    /*! \brief Whether the connection is multiplexed and served by a child of the spawner. */
+    bool spawned{false};
+    /*! \brief Whether the session is closed once the deadline passes. */
+    bool has_deadline{false};
+    /*! \brief The end of the session as requested by the -timeout option. */
+    steady_clock::time_point deadline;
+  };
+
+  /*! \brief The epoll event ids of the wake pipe and the spawner, the sessions start at 1. */
+  static constexpr uint64_t kWakeEventId = 0;
+  static constexpr uint64_t kSpawnerEventId = std::numeric_limits<uint64_t>::max();
+
+  /*!
+   * \brief SessionLoopProc Serves up to max_sessions_ connections from a single process.
+   *
+   *  An accept thread performs the tracker and key handshake, while the calling thread waits
+   *  on the connections with epoll and feeds the received bytes to the endpoint of each
+   *  session. A request is executed to completion before the next one is read, so sessions
+   *  do not disturb the time measurements of each other, and the device stays busy while a
+   *  client is compiling or uploading. Each session has its own sub directory of the work
+   *  path, removed when the session ends.
+   *
+   *  The multiplexed connections are served by the children of a spawner process, forked
+   *  before the accept thread starts, see SpawnerProc.
+   */
+  void SessionLoopProc() {
+    RPCEnv env;
+    int spawner_fds[2];
+    ICHECK_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, spawner_fds), 0)
+        << "socketpair failed: " << strerror(errno);
+    const pid_t spawner = fork();
+    ICHECK_GE(spawner, 0) << "fork failed: " << strerror(errno);
+    if (spawner == 0) {
+      listen_sock_.Close();
+      close(spawner_fds[0]);
+      SpawnerProc(spawner_fds[1], &env);
+      exit(0);
+    }
+    close(spawner_fds[1]);
+    const int spawner_fd = spawner_fds[0];
+
+    const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    ICHECK_GE(epoll_fd, 0) << "epoll_create1 failed: " << strerror(errno);
+    // The accept thread writes to the pipe to wake up the loop on new connections.
+    int wake_fds[2];
+    ICHECK_EQ(pipe(wake_fds), 0) << "pipe failed: " << strerror(errno);
+    epoll_event wake_event{};
+    wake_event.events = EPOLLIN;
+    wake_event.data.u64 = kWakeEventId;
+    ICHECK_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fds[0], &wake_event), 0);
+    // The spawner sends the id of a session back once its child exited.
+    epoll_event spawner_event{};
+    spawner_event.events = EPOLLIN;
+    spawner_event.data.u64 = kSpawnerEventId;
+    ICHECK_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, spawner_fd, &spawner_event), 0);
+
+    std::mutex mutex;
+    std::condition_variable slot_free;
+    std::deque<Session> pending;
+    int num_sessions = 0;
+
+    std::future<void> acceptor(std::async(std::launch::async, [&]() {
+      TrackerClient tracker(tracker_addr_, key_, custom_addr_);
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          slot_free.wait(lock, [&]() { return num_sessions < max_sessions_; });
+        }
+        Session sess;
+        sess.addr = support::SockAddr("0.0.0.0", 0);
+        try {
+          std::string opts;
+          tracker.TryConnect();
+          AcceptConnection(&tracker, &sess.sock, &sess.addr, &opts);
+          const int timeout = GetTimeOutFromOpts(opts);
+          if (timeout != 0) {
+            sess.has_deadline = true;
+            sess.deadline = steady_clock::now() + seconds(timeout);
+          }
+        } catch (const char* msg) {
+          LOG(WARNING) << "Socket exception: " << msg;
+          tracker.Close();
+          continue;
+        } catch (const std::exception& e) {
+          tracker.Close();
+          LOG(WARNING) << "Exception standard: " << e.what();
+          continue;
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          pending.push_back(std::move(sess));
+          ++num_sessions;
+        }
+        char byte = 0;
+        ICHECK_EQ(write(wake_fds[1], &byte, 1), 1);
+      }
+    }));
+
+    std::map<uint64_t, Session> sessions;
+    uint64_t next_id = 1;
+    std::vector<char> buffer(64 << 10);
+    std::vector<epoll_event> events(max_sessions_ + 1);
+
+    auto close_session = [&](std::map<uint64_t, Session>::iterator it) {
+      Session& sess = it->second;
+      if (!sess.spawned) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sess.sock.sockfd, nullptr);
+        // The endpoint sends the shutdown packet when destructed, close after it.
+        sess.endpoint.reset();
+        sess.sock.Close();
+      }
+      env.SetSession(sess.name);
+      env.CleanUp();
+      LOG(INFO) << "Finish serving " << sess.addr.AsString();
+      sessions.erase(it);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --num_sessions;
+      }
+      slot_free.notify_one();
+    };
+
+    while (true) {
+      // Wake up for the nearest deadline.
+      int wait_ms = -1;
+      const auto now = steady_clock::now();
+      for (const auto& kv : sessions) {
+        if (kv.second.spawned || !kv.second.has_deadline) continue;
+        const int ms = static_cast<int>(
+            std::max<int64_t>(duration_cast<milliseconds>(kv.second.deadline - now).count(), 0));
+        if (wait_ms < 0 || ms < wait_ms) wait_ms = ms;
+      }
+      const int num_events =
+          epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), wait_ms);
+      if (num_events < 0) {
+        ICHECK_EQ(errno, EINTR) << "epoll_wait failed: " << strerror(errno);
+        continue;
+      }
+
+      for (int i = 0; i < num_events; ++i) {
+        const uint64_t id = events[i].data.u64;
+        if (id == kSpawnerEventId) {
+          uint64_t sess_id = 0;
+          const ssize_t n = recv(spawner_fd, &sess_id, sizeof(sess_id), 0);
+          ICHECK_EQ(n, static_cast<ssize_t>(sizeof(sess_id))) << "The session spawner exited";
+          auto it = sessions.find(sess_id);
+          if (it != sessions.end()) close_session(it);
+          continue;
+        }
+        if (id == kWakeEventId) {
+          char bytes[64];
+          ICHECK_GT(read(wake_fds[0], bytes, sizeof(bytes)), 0);
+          std::lock_guard<std::mutex> lock(mutex);
+          for (; !pending.empty(); pending.pop_front()) {
+            const uint64_t sess_id = next_id++;
+            Session& sess = sessions[sess_id] = std::move(pending.front());
+            sess.name = SessionName(sess_id);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = sess_id;
+            ICHECK_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sess.sock.sockfd, &event), 0);
+          }
+          continue;
+        }
+        auto it = sessions.find(id);
+        if (it == sessions.end()) continue;
+        bool keep = false;
+        try {
+          keep = HandleSessionEvent(&env, epoll_fd, spawner_fd, id, &it->second, &buffer);
+        } catch (const std::exception& e) {
+          LOG(WARNING) << "Session " << it->second.addr.AsString() << " failed: " << e.what();
+        }
+        if (!keep) close_session(it);
+      }
+
+      for (auto it = sessions.begin(); it != sessions.end();) {
+        auto next = std::next(it);
+        if (!it->second.spawned && it->second.has_deadline &&
+            steady_clock::now() >= it->second.deadline) {
+          LOG(INFO) << "Session " << it->second.addr.AsString() << " closed on timeout";
+          close_session(it);
+        }
+        it = next;
+      }
+    }
+  }
+
+  /*!
+   * \brief SpawnerProc Serves each multiplexed connection from a child process.
+   *
+   *  The spawner is forked before the session loop starts its accept thread, so it forks its
+   *  children from a single threaded process, and they do not inherit the sockets of the
+   *  other sessions. It receives a connection with the id of its session over ctrl_fd, and
+   *  sends the id back once the child serving it exited.
+   * \param ctrl_fd The socket connected to the session loop.
+   * \param env The environment shared by the sessions.
+   */
+  static void SpawnerProc(int ctrl_fd, RPCEnv* env) {
+    std::map<pid_t, uint64_t> children;
+    while (true) {
+      pollfd ctrl{ctrl_fd, POLLIN, 0};
+      // Wake up periodically to reap the children.
+      const int ready = poll(&ctrl, 1, children.empty() ? -1 : 1000);
+      if (ready < 0 && errno != EINTR) {
+        perror("poll");
+        abort();
+      }
+      if (ready > 0) {
+        uint64_t id = 0;
+        int sockfd = -1;
+        if (!RecvSession(ctrl_fd, &id, &sockfd)) break;
+        const pid_t pid = fork();
+        if (pid == 0) {
+          // The child only keeps the connection it serves.
+          close(ctrl_fd);
+          env->SetSession(SessionName(id));
+          RPCServerLoop(sockfd);
+          exit(0);
+        }
+        close(sockfd);
+        if (pid > 0) {
+          children[pid] = id;
+        } else {
+          // A failed fork is reported as an exited child.
+          perror("fork");
+          send(ctrl_fd, &id, sizeof(id), MSG_NOSIGNAL);
+        }
+      }
+      int status = 0;
+      pid_t pid;
+      while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto it = children.find(pid);
+        if (it == children.end()) continue;
+        LOG(INFO) << "Child pid=" << pid << " exited, Process status =" << status;
+        send(ctrl_fd, &it->second, sizeof(it->second), MSG_NOSIGNAL);
+        children.erase(it);
+      }
+    }
+    // The session loop went away, wait for the children still serving.
+    for (; !children.empty(); children.erase(children.begin())) {
+      int status = 0;
+      waitPidEintr(&status);
+    }
+  }
+
+  /*!
+   * \brief SendSession Hands a connection over to the spawner.
+   * \param ctrl_fd The socket connected to the spawner.
+   * \param id The id of the session.
+   * \param sockfd The connection.
+   */
+  static void SendSession(int ctrl_fd, uint64_t id, int sockfd) {
+    iovec iov{&id, sizeof(id)};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &sockfd, sizeof(int));
+    ICHECK_EQ(sendmsg(ctrl_fd, &msg, MSG_NOSIGNAL), static_cast<ssize_t>(sizeof(id)))
+        << "sendmsg failed: " << strerror(errno);
+  }
+
+  /*!
+   * \brief RecvSession Receives a connection sent by SendSession.
+   * \param ctrl_fd The socket connected to the session loop.
+   * \param id The id of the session.
+   * \param sockfd The connection.
+   * \return False once the session loop closed its end.
+   */
+  static bool RecvSession(int ctrl_fd, uint64_t* id, int* sockfd) {
+    iovec iov{id, sizeof(*id)};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    while ((n = recvmsg(ctrl_fd, &msg, 0)) < 0 && errno == EINTR) {
+    }
+    if (n <= 0) return false;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    ICHECK(cmsg != nullptr && cmsg->cmsg_type == SCM_RIGHTS) << "No connection received";
+    memcpy(sockfd, CMSG_DATA(cmsg), sizeof(int));
+    return true;
+  }
+
+  /*! \brief The name of the work sub directory of a session. */
+  static std::string SessionName(uint64_t id) { return "session" + std::to_string(id); }
+
+  /*!
+   * \brief HandleSessionEvent Serves the bytes received on a session.
+   * \param env The environment shared by the sessions.
+   * \param epoll_fd The epoll instance of the session loop.
+   * \param spawner_fd The socket connected to the spawner.
+   * \param id The id of the session.
+   * \param sess The session.
+   * \param buffer The receive buffer.
+   * \return Whether the session continues.
+   */
+  static bool HandleSessionEvent(RPCEnv* env, int epoll_fd, int spawner_fd, uint64_t id,
+                                 Session* sess, std::vector<char>* buffer) {
+    if (sess->endpoint == nullptr) {
+      // A multiplexed connection starts with a magic that is never a valid packet size, and
+      // is handed to the spawner, whose child runs the blocking server loop.
+      uint64_t magic = 0;
+      const ssize_t npeek = sess->sock.Recv(&magic, sizeof(magic), MSG_PEEK);
+      if (npeek <= 0) return false;
+      if (static_cast<size_t>(npeek) < sizeof(magic)) return true;
+      if (magic == kRPCMultiplexMagic) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sess->sock.sockfd, nullptr);
+        SendSession(spawner_fd, id, sess->sock.sockfd);
+        sess->sock.Close();
+        sess->spawned = true;
+        return true;
+      }
+      sess->endpoint = RPCEndpoint::Create(
+          std::unique_ptr<SessionChannel>(new SessionChannel(sess->sock)), "SockServerLoop", "");
+    }
+    const ssize_t n = sess->sock.Recv(buffer->data(), buffer->size());
+    if (n <= 0) return false;
+    env->SetSession(sess->name);
+    int code = sess->endpoint->ServerAsyncIOEventHandler(std::string(buffer->data(), n), 1);
+    while (code == 2) {
+      code = sess->endpoint->ServerAsyncIOEventHandler(std::string(), 2);
+    }
+    return code != 0;
+  }
+#endif
+
   /*!
    * \brief AcceptConnection Accepts the RPC Server connection.
    * \param tracker Tracker details.
@@ -339,6 +740,7 @@ class RPCServer {
   std::string tracker_addr_;
   std::string key_;
   std::string custom_addr_;
+  int max_sessions_;
   support::TCPSocket listen_sock_;
   support::TCPSocket tracker_sock_;
 };
@@ -367,22 +769,24 @@ void ServerLoopFromChild(SOCKET socket) {
  * \param tracker_addr The address of RPC tracker in host:port format e.g. 10.77.1.234:9190
  * Default="" \param key The key used to identify the device type in tracker. Default="" \param
  * custom_addr Custom IP Address to Report to RPC Tracker. Default="" \param silent Whether run in
- * silent mode. Default=True
+ * silent mode. Default=True \param max_sessions The number of sessions served at the same time.
+ * Default=1
  */
 void RPCServerCreate(std::string host, int port, int port_end, std::string tracker_addr,
-                     std::string key, std::string custom_addr, bool silent) {
+                     std::string key, std::string custom_addr, bool silent, int max_sessions) {
   if (silent) {
     // Only errors and fatal is logged
     dmlc::InitLogging("--minloglevel=2");
   }
   // Start the rpc server
   RPCServer rpc(std::move(host), port, port_end, std::move(tracker_addr), std::move(key),
-                std::move(custom_addr));
+                std::move(custom_addr), max_sessions);
   rpc.Start();
 }
 
 TVM_REGISTER_GLOBAL("rpc.ServerCreate").set_body([](TVMArgs args, TVMRetValue* rv) {
-  RPCServerCreate(args[0], args[1], args[2], args[3], args[4], args[5], args[6]);
+  RPCServerCreate(args[0], args[1], args[2], args[3], args[4], args[5], args[6],
+                  args.size() > 7 ? args[7].operator int() : 1);
 });
 }  // namespace runtime
 }  // namespace tvm
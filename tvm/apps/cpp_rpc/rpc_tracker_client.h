@@ -24,13 +24,21 @@
 #ifndef TVM_APPS_CPP_RPC_TRACKER_CLIENT_H_
 #define TVM_APPS_CPP_RPC_TRACKER_CLIENT_H_
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <random>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
 #include "../../src/runtime/rpc/rpc_endpoint.h"
 #include "../../src/support/socket.h"
 
@@ -78,16 +86,33 @@ class TrackerClient {
       ICHECK_EQ(tracker_sock_.RecvAll(&code, sizeof(code)), sizeof(code));
       ICHECK_EQ(code, kRPCTrackerMagic) << tracker_addr_.c_str() << " is not RPC Tracker";
 
-      std::ostringstream ss;
-      ss << "[" << static_cast<int>(TrackerCode::kUpdateInfo) << ", {\"key\": \"server:" << key_
-         << "\"}]";
-      tracker_sock_.SendBytes(ss.str());
-
-      // Receive status and validate
-      std::string remote_status = tracker_sock_.RecvBytes();
-      ICHECK_EQ(std::stoi(remote_status), static_cast<int>(TrackerCode::kSuccess));
+      UpdateInfo();
     }
   }
+  /*!
+   * \brief UpdateInfo Report the key, the capability and the health of the device to the
+   *  tracker, so that requests can be matched by capability and sent to the least loaded and
+   *  coolest device of a pool of heterogeneous devices.
+   */
+  void UpdateInfo() {
+    std::ostringstream ss;
+    ss << "[" << static_cast<int>(TrackerCode::kUpdateInfo) << ", {\"key\": \"server:" << key_
+       << "\"";
+    std::string gpu_model = ReadFirstLine("/sys/class/kgsl/kgsl-3d0/gpu_model");
+    if (!gpu_model.empty()) {
+      ss << ", \"gpu_model\": \"" << EscapeJSON(gpu_model) << "\"";
+    }
+    double temperature = MaxTemperature();
+    if (temperature > 0) {
+      ss << ", \"temperature\": " << temperature;
+    }
+    ss << ", \"sessions_served\": " << sessions_served_ << "}]";
+    tracker_sock_.SendBytes(ss.str());
+
+    // Receive status and validate
+    std::string remote_status = tracker_sock_.RecvBytes();
+    ICHECK_EQ(std::stoi(remote_status), static_cast<int>(TrackerCode::kSuccess));
+  }
   /*!
    * \brief Close Clean up tracker resources.
    */
@@ -140,6 +165,9 @@ class TrackerClient {
         poller.WatchRead(listen_sock.sockfd);
         poller.Poll(ping_period * 1000);
         if (!poller.CheckRead(listen_sock.sockfd)) {
+          // refresh the health of the device while it waits in the pool.
+          UpdateInfo();
+
           std::ostringstream ss;
           ss << "[" << int(TrackerCode::kGetPendingMatchKeys) << "]";
           tracker_sock_.SendBytes(ss.str());
@@ -175,9 +203,61 @@ class TrackerClient {
       }
       break;
     }
+    ++sessions_served_;
   }
 
  private:
+  /*!
+   * \brief ReadFirstLine Read the first line of a file.
+   * \param path The path of the file.
+   * \return The line, empty when the file cannot be read.
+   */
+  static std::string ReadFirstLine(const std::string& path) {
+    std::ifstream fs(path);
+    std::string line;
+    if (fs.good()) {
+      std::getline(fs, line);
+    }
+    return line;
+  }
+  /*!
+   * \brief MaxTemperature Get the hottest thermal zone of the device.
+   * \return The temperature in degree Celsius, 0 when it is not available.
+   */
+  static double MaxTemperature() {
+    double temperature = 0;
+#ifndef _WIN32
+    // The zones are not numbered contiguously on every device, and some cannot be read.
+    const std::string root = "/sys/class/thermal/";
+    DIR* dir = opendir(root.c_str());
+    if (dir == nullptr) return temperature;
+    while (dirent* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.compare(0, 12, "thermal_zone") != 0) continue;
+      std::string line = ReadFirstLine(root + name + "/temp");
+      if (line.empty()) continue;
+      // thermal zones report millidegrees for the temp
+      temperature = std::max(temperature, std::atof(line.c_str()) / 1000.0);
+    }
+    closedir(dir);
+#endif
+    return temperature;
+  }
+  /*!
+   * \brief EscapeJSON Escape a string to be put in a JSON string.
+   */
+  static std::string EscapeJSON(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        escaped += '\\';
+      }
+      if (static_cast<unsigned char>(c) >= 0x20) {
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
   /*!
    * \brief Connect to a RPC address with retry.
             This function is only reliable to short period of server restart.
@@ -232,6 +312,7 @@ class TrackerClient {
   std::string custom_addr_;
   support::TCPSocket tracker_sock_;
   std::set<std::string> old_keyset_;
+  int sessions_served_{0};
   std::mt19937 gen_;
   std::uniform_real_distribution<float> dis_;
 };
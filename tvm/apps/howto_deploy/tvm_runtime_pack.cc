@@ -47,6 +47,7 @@
 #include "../../src/runtime/registry.cc"
 #include "../../src/runtime/thread_pool.cc"
 #include "../../src/runtime/threading_backend.cc"
+#include "../../src/runtime/memory_stats.cc"
 #include "../../src/runtime/workspace_pool.cc"
 
 // NOTE: all the files after this are optional modules
@@ -60,6 +61,8 @@
 
 // Graph runtime
 #include "../../src/runtime/graph/graph_runtime.cc"
+#include "../../src/runtime/graph/op_sampler.cc"
+#include "../../src/runtime/profiling.cc"
 #include "../../src/runtime/graph/graph_runtime_factory.cc"
 
 // Uncomment the following lines to enable RPC
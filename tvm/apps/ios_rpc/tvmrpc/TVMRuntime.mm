@@ -35,6 +35,7 @@
 #include "../../../src/runtime/system_library.cc"
 #include "../../../src/runtime/thread_pool.cc"
 #include "../../../src/runtime/threading_backend.cc"
+#include "../../../src/runtime/memory_stats.cc"
 #include "../../../src/runtime/workspace_pool.cc"
 
 // RPC server
@@ -47,6 +48,8 @@
 #include "../../../src/runtime/rpc/rpc_socket_impl.cc"
 // Graph runtime
 #include "../../../src/runtime/graph/graph_runtime.cc"
+#include "../../../src/runtime/graph/op_sampler.cc"
+#include "../../../src/runtime/profiling.cc"
 // Metal
 #include "../../../src/runtime/metal/metal_device_api.mm"
 #include "../../../src/runtime/metal/metal_module.mm"
@@ -612,3 +612,42 @@ func TestArrayCopySliceFloat64(t *testing.T) {
         }
     }
 }
+
+// Fill an array in place and check its data and size.
+func TestArrayDataPointer(t *testing.T) {
+    arr, err := Empty([]int64{3, 4}, "float32")
+    if err != nil {
+        t.Error(err.Error())
+        return
+    }
+
+    if arr.GetNBytes() != 48 {
+        t.Errorf("NBytes expected: 48 Got :%v\n", arr.GetNBytes())
+        return
+    }
+
+    ptr, err := arr.DataPointer()
+    if err != nil {
+        t.Error(err.Error())
+        return
+    }
+
+    view := (*[12]float32)(ptr)[:]
+    for i := range view {
+        view[i] = float32(i)
+    }
+
+    ret, err := arr.AsSlice()
+    if err != nil {
+        t.Error(err.Error())
+        return
+    }
+
+    dataRet := ret.([]float32)
+    for i := range view {
+        if dataRet[i] != float32(i) {
+            t.Errorf("Data expected: %v Got :%v\n", view, dataRet)
+            return
+        }
+    }
+}
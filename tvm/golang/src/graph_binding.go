@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief gotvm package source for binding Arrays to a graph runtime once
+ * \file graph_binding.go
+ */
+
+package gotvm
+
+import (
+    "fmt"
+)
+
+// GraphBinding holds Arrays bound once to the inputs and outputs of a graph runtime module.
+//
+// The inputs are bound with set_input_zero_copy, so that every request fills them in place,
+// e.g. through DataPointer, and Run only calls run and copies the outputs into the output
+// Arrays. The functions of the module are looked up once.
+type GraphBinding struct {
+    // Inputs are the Arrays read by the graph, in the order of the names they were bound to.
+    Inputs []*Array
+    // Outputs are the Arrays the outputs are copied into, in the order of the graph outputs.
+    Outputs []*Array
+    run *Function
+    getOutput *Function
+}
+
+// NewGraphBinding binds Arrays to the inputs and outputs of a graph runtime module.
+//
+// `graphmod` is the graph runtime module.
+//
+// `inputNames` are the names of the bound inputs.
+//
+// `inputs` are the Arrays of the inputs, with the alignment, shape and dtype of the graph's.
+//
+// `outputs` are the Arrays receiving the outputs, with the shape and dtype of the graph's.
+//
+// returns the binding and err if any.
+func NewGraphBinding(graphmod *Module, inputNames []string, inputs []*Array,
+                     outputs []*Array) (retVal *GraphBinding, err error) {
+    if len(inputNames) != len(inputs) {
+        err = fmt.Errorf("Got %v input names for %v inputs", len(inputNames), len(inputs))
+        return
+    }
+    setInput, err := graphmod.GetFunction("set_input_zero_copy")
+    if err != nil {
+        return
+    }
+    for ii := range inputs {
+        _, err = setInput.Invoke(inputNames[ii], inputs[ii])
+        if err != nil {
+            return
+        }
+    }
+    binding := new(GraphBinding)
+    binding.Inputs = inputs
+    binding.Outputs = outputs
+    binding.run, err = graphmod.GetFunction("run")
+    if err != nil {
+        return
+    }
+    binding.getOutput, err = graphmod.GetFunction("get_output")
+    if err != nil {
+        return
+    }
+    retVal = binding
+    return
+}
+
+// Run runs the graph on the bound inputs and copies its outputs into the bound outputs.
+//
+// returns err if any.
+func (binding *GraphBinding) Run() (err error) {
+    _, err = binding.run.Invoke()
+    if err != nil {
+        return
+    }
+    for ii := range binding.Outputs {
+        _, err = binding.getOutput.Invoke(int64(ii), binding.Outputs[ii])
+        if err != nil {
+            return
+        }
+    }
+    return
+}
@@ -219,6 +219,33 @@ func (parray Array) AsSlice() (retVal interface{}, err error) {
     return
 }
 
+// DataPointer returns the pointer to the data of a CPU Array.
+//
+// The data can be filled and read in place through the pointer, without the copies of
+// CopyFrom and AsSlice. It stays valid while the Array is alive.
+//
+// returns the pointer and err if the Array is not on CPU.
+func (parray Array) DataPointer() (retVal unsafe.Pointer, err error) {
+    ctx := parray.GetCtx()
+    if ctx.DeviceType != KDLCPU {
+        err = fmt.Errorf("DataPointer expects a CPU Array, got device type %v", ctx.DeviceType)
+        return
+    }
+    tensor := (*C.DLTensor)(unsafe.Pointer(parray))
+    retVal = unsafe.Pointer(uintptr(tensor.data) + uintptr(tensor.byte_offset))
+    return
+}
+
+// GetNBytes returns the number of bytes of the data in Array
+func (parray Array) GetNBytes() (retVal int64) {
+    dtype := ((*C.DLTensor)(unsafe.Pointer(parray))).dtype
+    retVal = int64((int(dtype.bits) * int(dtype.lanes) + 7) / 8)
+    for _, dim := range parray.GetShape() {
+        retVal *= dim
+    }
+    return
+}
+
 // GetNdim returns the number of dimentions in Array
 func (parray Array) GetNdim() (retVal int32) {
     retVal = int32(((*C.DLTensor)(unsafe.Pointer(parray))).ndim)
@@ -31,6 +31,7 @@
 #include "src/runtime/registry.cc"
 #include "src/runtime/thread_pool.cc"
 #include "src/runtime/threading_backend.cc"
+#include "src/runtime/memory_stats.cc"
 #include "src/runtime/workspace_pool.cc"
 
 // NOTE: all the files after this are optional modules
@@ -44,6 +45,8 @@
 
 // Graph runtime
 #include "src/runtime/graph/graph_runtime.cc"
+#include "src/runtime/graph/op_sampler.cc"
+#include "src/runtime/profiling.cc"
 
 // Uncomment the following lines to enable RPC
 // #include "../../src/runtime/rpc/rpc_session.cc"
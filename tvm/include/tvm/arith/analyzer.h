@@ -26,11 +26,14 @@
 
 #include <tvm/arith/int_set.h>
 #include <tvm/ir/expr.h>
+#include <tvm/node/structural_equal.h>
+#include <tvm/node/structural_hash.h>
 #include <tvm/support/with.h>
 
 #include <limits>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace tvm {
@@ -383,9 +386,17 @@ class IntSetAnalyzer {
  * NOTE for sub-analyzer developers:
  * If the analyzer uses memoization, we need to clear the internal
  * cache when information about a Var has been overridden.
+ *
+ * Simplify memoizes its results by the structure of the expression.
+ * The memo belongs to the analyzer and holds a bounded number of
+ * results. It is dropped whenever a variable is bound or a constraint
+ * context is entered or exited.
  */
 class TVM_DLL Analyzer {
  public:
+  /*! \brief The memoized results of Simplify and their number of steps. */
+  using SimplifyCache =
+      std::unordered_map<PrimExpr, std::pair<int, PrimExpr>, StructuralHash, StructuralEqual>;
   /*
    * Disable copy constructor.
    */
@@ -481,6 +492,18 @@ class TVM_DLL Analyzer {
    * \note Analyzer will call into sub-analyzers to get the result.
    */
   PrimExpr Simplify(const PrimExpr& expr, int steps = 2);
+  /*!
+   * \brief Drop the memoized results of Simplify.
+   *
+   * \note Must be called after updating a sub-analyzer directly
+   *       instead of through Bind.
+   */
+  void InvalidateSimplifyCache();
+
+ private:
+  friend class ConstraintContext;
+  /*! \brief The memo of Simplify under the bindings and constraints of this analyzer. */
+  SimplifyCache simplify_cache_;
 };
 
 }  // namespace arith
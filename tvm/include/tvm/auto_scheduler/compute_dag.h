@@ -38,6 +38,7 @@
 #include <tvm/runtime/c_runtime_api.h>
 #include <tvm/te/schedule.h>
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -46,6 +47,8 @@
 namespace tvm {
 namespace auto_scheduler {
 
+class ComputeDAGReplayCache;
+
 /*! \brief Static analyzer for a ComputeDAG */
 class AccessAnalyzerNode : public Object {
  public:
@@ -181,6 +184,11 @@ class ComputeDAGNode : public Object {
   State init_state;
   /*! \brief The static read-write access analyzer. */
   AccessAnalyzer access_analyzer;
+  /*!
+   * \brief The schedules replayed from transform steps and the DAGs got by `ReplayAndGetDAG`,
+   * kept to replay only the steps that differ from a cached prefix. Not visited as an attribute.
+   */
+  std::shared_ptr<ComputeDAGReplayCache> replay_cache;
 
   void VisitAttrs(tvm::AttrVisitor* v) {
     v->Visit("tensors", &tensors);
@@ -318,6 +326,14 @@ class ComputeDAG : public ObjectRef {
  */
 Array<PrimExpr> GetShapeFromRewrittenLayout(String rewritten_layout, Array<String> axis_names);
 
+/*!
+ * \brief Estimate the number of float operations needed to compute some tensors, the same way
+ *  as ComputeDAGNode::flop_ct but without building a ComputeDAG.
+ * \param outputs The computed tensors.
+ * \return The number of float operations, -1 if it cannot be estimated, e.g. for extern ops.
+ */
+TVM_DLL double EstimateFlop(const Array<te::Tensor>& outputs);
+
 }  // namespace auto_scheduler
 }  // namespace tvm
 
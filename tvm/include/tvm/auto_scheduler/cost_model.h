@@ -30,6 +30,7 @@
 #include <tvm/node/node.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <random>
 #include <vector>
 
 namespace tvm {
@@ -48,6 +49,14 @@ class CostModelNode : public Object {
    */
   virtual void Update(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results) = 0;
 
+  /*!
+   * \brief Update the cost model with the records of some workloads in a log file, e.g. to
+   * pre-train it on the records of similar workloads. It reads the records and calls Update.
+   * \param log_file The name of the record log file
+   * \param workload_keys The workloads whose records are used, all of them when empty
+   */
+  void UpdateFromFile(const String& log_file, const Array<String>& workload_keys);
+
   /*!
    * \brief Predict the scores of states
    * \param task The search task of states
@@ -118,6 +127,92 @@ class RandomModel : public CostModel {
   using ContainerType = RandomModelNode;
 };
 
+/*!
+ * \brief A native gradient boosted decision tree cost model.
+ *  It is trained on the per-store features and predicts the score of a state as the sum of
+ *  the predictions of all its BufferStore rows, the same "pack-sum" formulation used by the
+ *  python XGBoost model, but without going through python for every update and prediction.
+ */
+class GBDTModelNode : public CostModelNode {
+ public:
+  /*! \brief The number of boosting rounds */
+  int n_trees;
+  /*! \brief The maximum depth of a tree */
+  int max_depth;
+  /*! \brief The shrinkage applied to every leaf value */
+  float learning_rate;
+  /*! \brief The L2 regularization on leaf values */
+  float reg_lambda;
+  /*! \brief The minimum sum of hessian in a child */
+  float min_child_weight;
+  /*! \brief Predict random scores until this many samples have been measured */
+  int num_warmup_sample;
+  /*! \brief The maximum number of extracted buffers for one statement */
+  int max_n_bufs;
+
+  void Update(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results) final;
+
+  void Predict(const SearchTask& task, const Array<State>& states,
+               std::vector<float>* scores) final;
+
+  /*!
+   * \brief Train the model from scratch on serialized per-store features.
+   * \param features The per-state features in the layout of GetPerStoreFeaturesFromStates
+   * \param throughputs The normalized throughputs for all states
+   */
+  void Fit(const std::vector<std::vector<float>>& features, const std::vector<float>& throughputs);
+
+  /*!
+   * \brief Predict the scores of serialized per-store features.
+   * \param features The per-state features in the layout of GetPerStoreFeaturesFromStates
+   * \param scores The predicted scores, -inf for states without features
+   */
+  void PredictFeatures(const std::vector<std::vector<float>>& features,
+                       std::vector<float>* scores) const;
+
+  static constexpr const char* _type_key = "auto_scheduler.GBDTModel";
+  TVM_DECLARE_FINAL_OBJECT_INFO(GBDTModelNode, CostModelNode);
+
+ private:
+  /*! \brief A node of a regression tree, a leaf when left < 0 */
+  struct TreeNode {
+    int feature;
+    float threshold;
+    int left;
+    int right;
+    float value;
+  };
+
+  /*! \brief The trained trees */
+  std::vector<std::vector<TreeNode>> trees_;
+  /*! \brief The length of one per-store feature row the model was trained on */
+  size_t row_length_{0};
+  /*! \brief All the measured features */
+  std::vector<std::vector<float>> features_;
+  /*! \brief All the measured normalized throughputs */
+  std::vector<float> throughputs_;
+  /*! \brief The random number generator used during warm up */
+  std::mt19937 rng_;
+};
+
+/*!
+ * \brief Managed reference to GBDTModelNode.
+ * \sa GBDTModelNode
+ */
+class GBDTModel : public CostModel {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param n_trees The number of boosting rounds
+   * \param max_depth The maximum depth of a tree
+   * \param learning_rate The shrinkage applied to every leaf value
+   * \param num_warmup_sample Predict random scores until this many samples have been measured
+   */
+  GBDTModel(int n_trees, int max_depth, double learning_rate, int num_warmup_sample);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(GBDTModel, CostModel, GBDTModelNode);
+};
+
 /*! \brief A wrapper for cost model defined by python code
  *  This class will call functions defined in the python */
 class PythonBasedModelNode : public CostModelNode {
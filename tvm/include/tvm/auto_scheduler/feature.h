@@ -46,16 +46,19 @@ namespace auto_scheduler {
  * \param cache_line_size The size of cache line in bytes
  * \param max_n_bufs The maximum number of extracted buffers for one statement
  * \param ret The returned feature vector
+ * \param texture_features Whether to append the texture related features of the buffers
  */
 void GetPerStoreFeature(const Stmt& stmt, int cache_line_size, int max_n_bufs,
-                        std::vector<float>* ret);
+                        std::vector<float>* ret, bool texture_features = false);
 
 /*
  * \brief Get the names of elements in the feature vector. Use this for debug and inspection.
  * \param max_n_bufs The maximum number of extracted buffers for one statement
  * \param ret The returned names.
+ * \param texture_features Whether the texture related features are appended
  */
-void GetPerStoreFeatureName(int max_n_bufs, std::vector<std::string>* ret);
+void GetPerStoreFeatureName(int max_n_bufs, std::vector<std::string>* ret,
+                            bool texture_features = false);
 
 /*!
  * \brief Get per-store feature from states of the same task
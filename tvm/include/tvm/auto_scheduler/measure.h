@@ -45,6 +45,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace tvm {
 namespace auto_scheduler {
@@ -451,6 +452,56 @@ class RPCRunner : public ProgramRunner {
   TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RPCRunner, ProgramRunner, RPCRunnerNode);
 };
 
+/*!
+ * \brief A runner that shards every batch across several identical devices and measures the
+ * shards concurrently, each with its own runner (e.g. one RPCRunner per device key).
+ *
+ * One reference program of the batch is measured on every device, which gives the speed of each
+ * device relative to the median one. Timings are normalized by this factor, and a device slower
+ * than the median by more than `outlier_threshold` (e.g. thermally throttled) or failing
+ * completely is quarantined for `quarantine_rounds` batches.
+ */
+class MultiDeviceRunnerNode : public ProgramRunnerNode {
+ public:
+  /*! \brief The runner of every device. */
+  Array<ProgramRunner> runners;
+  /*! \brief The relative slowdown to the median device above which a device is quarantined. */
+  double outlier_threshold;
+  /*! \brief The number of batches a quarantined device sits out. */
+  int quarantine_rounds;
+
+  Array<MeasureResult> Run(const Array<MeasureInput>& inputs,
+                           const Array<BuildResult>& build_results, int verbose) final;
+
+  static constexpr const char* _type_key = "auto_scheduler.MultiDeviceRunner";
+  TVM_DECLARE_FINAL_OBJECT_INFO(MultiDeviceRunnerNode, ProgramRunnerNode);
+
+ private:
+  /*! \brief The remaining quarantined batches of every device. */
+  std::vector<int> quarantine_;
+  /*! \brief The last measured speed factor of every device, larger is slower. */
+  std::vector<double> speed_factors_;
+};
+
+/*!
+ * \brief Managed reference to MultiDeviceRunnerNode.
+ * \sa MultiDeviceRunnerNode
+ */
+class MultiDeviceRunner : public ProgramRunner {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param runners The runner of every device.
+   * \param outlier_threshold The relative slowdown to the median device above which a device is
+   * quarantined.
+   * \param quarantine_rounds The number of batches a quarantined device sits out.
+   */
+  MultiDeviceRunner(Array<ProgramRunner> runners, double outlier_threshold,
+                    int quarantine_rounds);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(MultiDeviceRunner, ProgramRunner, MultiDeviceRunnerNode);
+};
+
 /*!
  * \brief Measurer that measures the time costs of tvm programs
  * This class combines ProgramBuilder and ProgramRunner, and provides a simpler API */
@@ -29,6 +29,7 @@
 
 #include <fstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 namespace tvm {
@@ -113,6 +114,126 @@ class RecordReader : public ObjectRef {
   TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordReader, ObjectRef, RecordReaderNode);
 };
 
+/*!
+ * \brief A binary store of measure records, indexed by the workload key and the target, which
+ *  answers queries of the best record in milliseconds for logs of millions of records.
+ *
+ *  The file appends the records, each with its key, its mean cost, infinite for the failed
+ *  ones, and the record in the json log format. The index of the best valid record of every key
+ *  is kept in the file named filename + ".index", which is completed by scanning the records
+ *  appended after it when the store is opened or written.
+ *
+ * \note The store expects a single writer at a time.
+ */
+class RecordStoreNode : public Object {
+ public:
+  /*! \brief The name of the record file. */
+  String filename;
+
+  /*!
+   * \brief Append measure records to the store.
+   * \param inputs The MeasureInputs to be written.
+   * \param results The MeasureResults to be written.
+   */
+  void Append(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results);
+
+  /*!
+   * \brief Append all records of another store, without parsing them.
+   * \param other_filename The record file of the other store.
+   */
+  void Merge(const String& other_filename);
+
+  /*!
+   * \brief Append all records of a json log file.
+   * \param log_filename The name of the json log file.
+   */
+  void ImportLog(const String& log_filename);
+
+  /*!
+   * \brief Read the valid record with the lowest mean cost of a workload and a target.
+   * \param workload_key The workload key of the search task.
+   * \param target The target of the search task, compared by its string.
+   * \param inp A pointer to a MeasureInputNode, this is used as output.
+   * \param res A pointer to a MeasureResultNode, this is used as output.
+   * \return Whether the store has a valid record of the key.
+   */
+  bool QueryBest(const String& workload_key, const Target& target, MeasureInputNode* inp,
+                 MeasureResultNode* res);
+
+  /*! \brief Load the index and complete it with the records appended after it. */
+  void Load();
+
+  static constexpr const char* _type_key = "auto_scheduler.RecordStore";
+  TVM_DECLARE_FINAL_OBJECT_INFO(RecordStoreNode, Object);
+
+ private:
+  /*! \brief The position and the mean cost of the best record of a key. */
+  struct IndexEntry {
+    uint64_t offset;
+    double cost;
+  };
+
+  /*! \brief Index the records from an offset of the file to its end. */
+  void Scan(uint64_t begin);
+  /*!
+   * \brief Open the file to append records after the indexed ones.
+   * \return The size of the file.
+   */
+  uint64_t BeginAppend(std::ofstream* fs);
+  /*! \brief Record a record in the index when it is the best of its key. */
+  void UpdateIndex(const std::string& key, uint64_t offset, double cost);
+  /*! \brief Write the index file. */
+  void SaveIndex() const;
+
+  /*! \brief The best record of every key. */
+  std::unordered_map<std::string, IndexEntry> index_;
+  /*! \brief The size of the file covered by the index. */
+  uint64_t indexed_size_{0};
+};
+
+/*!
+ * \brief Managed reference to RecordStoreNode.
+ * \sa RecordStoreNode
+ */
+class RecordStore : public ObjectRef {
+ public:
+  /*!
+   * \brief The constructor, which creates the store when the file does not exist.
+   * \param filename The name of the record file
+   */
+  explicit RecordStore(String filename);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordStore, ObjectRef, RecordStoreNode);
+};
+
+/*! \brief Callback for appending the input and results of measurements to a record store */
+class RecordToStoreNode : public MeasureCallbackNode {
+ public:
+  /*! \brief The record store. */
+  RecordStore store;
+
+  void Callback(const SearchPolicy& policy, const Array<MeasureInput>& inputs,
+                const Array<MeasureResult>& results) final;
+
+  static constexpr const char* _type_key = "auto_scheduler.RecordToStore";
+  TVM_DECLARE_FINAL_OBJECT_INFO(RecordToStoreNode, MeasureCallbackNode);
+};
+
+/*!
+ * \brief Managed reference to RecordToStoreNode.
+ * \sa RecordToStoreNode
+ */
+class RecordToStore : public MeasureCallback {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param filename The name of the record file of the store
+   */
+  explicit RecordToStore(String filename);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordToStore, MeasureCallback, RecordToStoreNode);
+};
+
 /*!
  * \brief Append measure records to an output stream.
  * \param os A pointer to a output stream.
@@ -112,6 +112,38 @@ class PreloadMeasuredStates : public SearchCallback {
                                         PreloadMeasuredStatesNode);
 };
 
+/*! \brief Preload good states of structurally similar workloads from a log file.
+ * This warm starts the search of a new workload from the records of other ones */
+class PreloadSimilarStatesNode : public SearchCallbackNode {
+ public:
+  /*! \brief The name of the record log file. */
+  String filename;
+  /*! \brief The maximum number of transferred states to keep. */
+  int max_states;
+
+  void Callback(SearchPolicyNode* policy) final;
+
+  static constexpr const char* _type_key = "auto_scheduler.PreloadSimilarStates";
+  TVM_DECLARE_FINAL_OBJECT_INFO(PreloadSimilarStatesNode, SearchCallbackNode);
+};
+
+/*!
+ * \brief Managed reference to PreloadSimilarStatesNode.
+ * \sa PreloadSimilarStatesNode
+ */
+class PreloadSimilarStates : public SearchCallback {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param filename The name of the record log file.
+   * \param max_states The maximum number of transferred states to keep.
+   */
+  PreloadSimilarStates(String filename, int max_states);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(PreloadSimilarStates, SearchCallback,
+                                        PreloadSimilarStatesNode);
+};
+
 /*! \brief Attribute keys of ops used for SearchPolicy. */
 struct SearchPolicyKey {
   /*! \brief Always apply unroll to the inner most iterator of the specificed iterators. */
@@ -168,6 +200,14 @@ class SearchPolicyNode : public Object {
    */
   void PreloadMeasuredStates(const String& log_file);
 
+  /*!
+   * \brief Preload the good states of other workloads whose compute DAG has the same structure as
+   * the current one, to seed the initial population of the search.
+   * \param log_file The name of the record log file.
+   * \param max_states The maximum number of transferred states to keep.
+   */
+  virtual void PreloadSimilarStates(const String& log_file, int max_states);
+
   /*!
    * \brief Call SearchCallback with the current SearchPolicyNode
    * \param callbacks SearchCallback to be called.
@@ -189,6 +229,13 @@ class SearchPolicyNode : public Object {
   std::vector<State> measured_states_vector_;
   /*! \brief The throughputs of already measured states */
   std::vector<float> measured_states_throughputs_;
+  /*! \brief The states transferred from structurally similar workloads.
+   *  They are replayed on the current DAG but have never been measured for it. */
+  std::vector<State> similar_states_vector_;
+  /*! \brief The throughputs of the transferred states, normalized within their own workload */
+  std::vector<float> similar_states_throughputs_;
+  /*! \brief The workloads of the preloaded log files with the same structure as the current one */
+  Array<String> similar_workload_keys_;
 };
 
 /*!
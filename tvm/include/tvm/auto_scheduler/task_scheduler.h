@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/auto_scheduler/task_scheduler.h
+ * \brief The task scheduler that allocates the measurement trials of several tasks, e.g. all the
+ * tasks of one or several networks, by their estimated gain on the end-to-end latency.
+ */
+
+#ifndef TVM_AUTO_SCHEDULER_TASK_SCHEDULER_H_
+#define TVM_AUTO_SCHEDULER_TASK_SCHEDULER_H_
+
+#include <tvm/auto_scheduler/measure.h>
+#include <tvm/auto_scheduler/search_policy.h>
+#include <tvm/auto_scheduler/search_task.h>
+
+#include <vector>
+
+namespace tvm {
+namespace auto_scheduler {
+
+/*!
+ * \brief The task scheduler.
+ *
+ * The end-to-end latency is estimated as sum(weight_i * best_cost_i) over all tasks, where the
+ * weight of a task is the number of times it appears in the graphs. Every task is first measured
+ * for one round, then each round goes to the task with the largest expected latency gain per
+ * trial:
+ *
+ *   gain_i = weight_i * max(recent improvement of best_cost_i per trial,
+ *                           best_cost_i / trials_i)
+ *
+ * The first term follows the measured progress of the task, the second one is an optimistic
+ * estimate that decays as the task receives more trials.
+ *
+ * A task stops receiving trials once its share of the estimated latency falls below
+ * `min_latency_share`, once its best cost did not improve in its last `early_stopping` trials,
+ * or once its search space is exhausted. Tuning stops when all tasks stopped, the total number
+ * of trials is reached or the wall-clock budget is used up.
+ */
+class TaskSchedulerNode : public Object {
+ public:
+  /*! \brief The tasks to tune. */
+  Array<SearchTask> tasks;
+  /*! \brief The number of times every task appears in the graphs. */
+  std::vector<double> task_weights;
+  /*! \brief The search policy of every task. */
+  Array<SearchPolicy> search_policies;
+  /*! \brief The best measured cost of every task in seconds, 1e10 when there is none. */
+  std::vector<double> best_costs;
+  /*! \brief The number of trials measured for every task. */
+  std::vector<int> task_cts;
+
+  /*!
+   * \brief Tune all the tasks.
+   * \param n_trials The total number of measurement trials of all the tasks.
+   * \param num_measures_per_round The number of programs measured in one round of a task.
+   * \param measurer The measurer shared by all the tasks.
+   * \param time_budget_s The wall-clock budget in seconds, non-positive for no budget.
+   * \param early_stopping Stop tuning a task after this many trials without improvement,
+   * negative to disable.
+   * \param min_latency_share Stop tuning a task whose share of the estimated end-to-end latency
+   * is below this fraction.
+   * \param verbose Verbosity level. 0 for silent, 1 to output the progress of the tuning.
+   */
+  void Tune(int n_trials, int num_measures_per_round, ProgramMeasurer measurer,
+            double time_budget_s, int early_stopping, double min_latency_share, int verbose);
+
+  static constexpr const char* _type_key = "auto_scheduler.TaskScheduler";
+  TVM_DECLARE_FINAL_OBJECT_INFO(TaskSchedulerNode, Object);
+
+ private:
+  /*!
+   * \brief Tune one task for one round, and update its book keeping.
+   * \return Whether any program was measured.
+   */
+  bool TuneTaskOneRound(size_t task_id, int num_measures, ProgramMeasurer measurer);
+
+  /*! \brief The best cost of every task before its last round. */
+  std::vector<double> prev_best_costs_;
+  /*! \brief The number of trials of the last round of every task. */
+  std::vector<int> last_round_cts_;
+  /*! \brief The trial count of every task at which its best cost last improved. */
+  std::vector<int> best_cts_;
+  /*! \brief Whether every task stopped receiving trials. */
+  std::vector<bool> done_;
+};
+
+/*!
+ * \brief Managed reference to TaskSchedulerNode.
+ * \sa TaskSchedulerNode
+ */
+class TaskScheduler : public ObjectRef {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param tasks The tasks to tune.
+   * \param task_weights The number of times every task appears in the graphs.
+   * \param search_policies The search policy of every task.
+   */
+  TaskScheduler(Array<SearchTask> tasks, std::vector<double> task_weights,
+                Array<SearchPolicy> search_policies);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(TaskScheduler, ObjectRef, TaskSchedulerNode);
+};
+
+}  // namespace auto_scheduler
+}  // namespace tvm
+
+#endif  // TVM_AUTO_SCHEDULER_TASK_SCHEDULER_H_
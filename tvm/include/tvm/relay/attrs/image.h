@@ -195,6 +195,33 @@ struct GridSampleAttrs : public tvm::AttrsNode<GridSampleAttrs> {
   }
 };
 
+/*! \brief Attributes used in image yuv_to_rgb operator */
+struct YUVToRGBAttrs : public tvm::AttrsNode<YUVToRGBAttrs> {
+  Array<IndexExpr> size;
+  String format;
+  String layout;
+  Array<FloatImm> mean;
+  Array<FloatImm> stddev;
+  DataType out_dtype;
+
+  TVM_DECLARE_ATTRS(YUVToRGBAttrs, "relay.attrs.YUVToRGBAttrs") {
+    TVM_ATTR_FIELD(size)
+        .set_default(NullValue<Array<IndexExpr> >())
+        .describe("Output size (H, W), the size of the frame if not given.");
+    TVM_ATTR_FIELD(format).set_default("NV21").describe(
+        "The semi-planar YUV 4:2:0 format of the frame, NV21 or NV12.");
+    TVM_ATTR_FIELD(layout).set_default("NCHW").describe(
+        "Dimension ordering of the output, NCHW, NHWC or NCHW4c with a zero fourth channel.");
+    TVM_ATTR_FIELD(mean)
+        .set_default(Array<FloatImm>(3, FloatImm(DataType::Float(64), 0.0)))
+        .describe("The means of the R, G and B channels in [0, 1].");
+    TVM_ATTR_FIELD(stddev)
+        .set_default(Array<FloatImm>(3, FloatImm(DataType::Float(64), 1.0)))
+        .describe("The standard deviations of the R, G and B channels in [0, 1].");
+    TVM_ATTR_FIELD(out_dtype).set_default(DataType::Float(32)).describe("Output data type.");
+  }
+};
+
 }  // namespace relay
 }  // namespace tvm
 #endif  // TVM_RELAY_ATTRS_IMAGE_H_
@@ -44,6 +44,7 @@ struct AllocStorageAttrs : public tvm::AttrsNode<AllocStorageAttrs> {
   DataType dtype;
   int device_id;
   int device_type;
+  String scope;
 
   TVM_DECLARE_ATTRS(AllocStorageAttrs, "relay.attrs.AllocStorageAttrs") {
     TVM_ATTR_FIELD(dtype)
@@ -51,6 +52,9 @@ struct AllocStorageAttrs : public tvm::AttrsNode<AllocStorageAttrs> {
         .set_default(DataType::Float(32, 1));
     TVM_ATTR_FIELD(device_id).describe("The device id on which to allocate memory.");
     TVM_ATTR_FIELD(device_type).describe("The device type on which to allocate memory.");
+    TVM_ATTR_FIELD(scope)
+        .describe("The memory scope of the storage, e.g. a texture scope.")
+        .set_default("global");
   }
 };
 
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace tvm {
@@ -67,6 +68,66 @@ class DFPatternCallback : public ObjectRef {
   TVM_DEFINE_OBJECT_REF_METHODS(DFPatternCallback, ObjectRef, DFPatternCallbackNode);
 };
 
+/*!
+ * \brief The nodes of an expression bucketed by kind, calls by their operator and the other
+ * nodes by their type.
+ */
+struct ExprNodeIndex {
+  /*! \brief The operators called in the expression. */
+  std::unordered_set<const Object*> call_ops;
+  /*! \brief Whether the expression has calls of something other than an operator. */
+  bool has_other_calls{false};
+  /*! \brief The type indices of the other nodes of the expression. */
+  std::unordered_set<uint32_t> node_types;
+
+  /*!
+   * \brief Index the nodes of an expression.
+   * \param expr The expression.
+   */
+  TVM_DLL explicit ExprNodeIndex(const Expr& expr);
+};
+
+/*!
+ * \brief A filter of the expressions a pattern can match at its root, made of the operators or
+ * the node types the root may have, e.g. calls of nn.conv2d for a conv2d + bias + relu pattern.
+ * It rejects most nodes without running the matcher.
+ */
+class PatternRootFilter {
+ public:
+  /*!
+   * \brief Collect the roots a pattern may match.
+   * \param pattern The pattern.
+   */
+  TVM_DLL explicit PatternRootFilter(const DFPattern& pattern);
+
+  /*!
+   * \brief Whether the pattern may match an expression at its root.
+   * \param expr The expression.
+   * \return False if the pattern cannot match, true if the matcher must decide.
+   */
+  TVM_DLL bool MayMatch(const Expr& expr) const;
+
+  /*!
+   * \brief Whether the pattern may match any node of an indexed expression.
+   * \param index The nodes of the expression.
+   * \return False if the pattern matches no node, true if the matcher must decide.
+   */
+  TVM_DLL bool MayMatchAny(const ExprNodeIndex& index) const;
+
+ private:
+  void Collect(const DFPattern& pattern);
+  bool CollectOps(const DFPattern& op);
+
+  /*! \brief Whether any expression may match. */
+  bool any_{false};
+  /*! \brief Whether any call may match. */
+  bool any_call_{false};
+  /*! \brief The operators of the calls that may match. */
+  std::unordered_set<const Object*> ops_;
+  /*! \brief The type indices of the other nodes that may match. */
+  std::unordered_set<uint32_t> node_types_;
+};
+
 /*!
  * \brief Determine if a pattern matches an expression
  *
@@ -97,10 +158,13 @@ Expr RewritePatterns(Array<DFPatternCallback> callbacks, Expr expr, IRModule mod
  * \param attrs A set of parameter names and values to apply to the partitioned function
  * \param check A callback function for checking more complicated properties of the matched
  * expressions, returns true if the match is accepted and false otherwise
+ * \param types_inferred Whether the types of expr were just inferred, the type patterns then use
+ * the checked types of its nodes instead of inferring them
  *
  * \return Return the paritioned Expr.
  */
-Expr PartitionPattern(DFPattern pattern, Expr expr, Map<String, ObjectRef> attrs, PackedFunc check);
+Expr PartitionPattern(DFPattern pattern, Expr expr, Map<String, ObjectRef> attrs, PackedFunc check,
+                      bool types_inferred = false);
 
 }  // namespace relay
 }  // namespace tvm
@@ -29,6 +29,7 @@
 #include <tvm/ir/module.h>
 #include <tvm/ir/op.h>
 
+#include <atomic>
 #include <functional>
 #include <string>
 
@@ -77,10 +78,26 @@ class ConstantNode : public ExprNode {
     return equal(data, other->data);
   }
 
-  void SHashReduce(SHashReducer hash_reduce) const { hash_reduce(data); }
+  void SHashReduce(SHashReducer hash_reduce) const {
+    hash_reduce->SHashReduceHashedValue(DataHash());
+  }
+
+  /*!
+   * \return The structural hash of the data.
+   * \note The data of a constant is immutable, the hash is computed once and cached,
+   *  so that hashing a function does not go over the bytes of all its weights again.
+   */
+  TVM_DLL size_t DataHash() const;
 
   static constexpr const char* _type_key = "relay.Constant";
   TVM_DECLARE_FINAL_OBJECT_INFO(ConstantNode, ExprNode);
+
+ private:
+  /*!
+   * \brief The cached hash of the data, 0 when it is not computed yet. Threads hashing
+   *  the same constant at once compute the same value, relaxed accesses suffice.
+   */
+  mutable std::atomic<size_t> data_hash_{0};
 };
 
 class Constant : public Expr {
@@ -91,6 +91,22 @@ TVM_DLL Pass DeadCodeElimination(bool inline_once = false);
  */
 TVM_DLL Pass LazyGradientInit();
 
+/*!
+ * \brief Wrap segments of the let bindings of functions in annotation.checkpoint, so that
+ * the gradient pass recomputes their intermediates in the backward pass instead of keeping
+ * them alive from the forward pass.
+ *
+ * The functions are turned into A-Normal Form, and a segment only ends at a binding after
+ * the last use of each of its other bindings. InferType must be run again before gradient.
+ *
+ * \param policy "sqrt" for segments of about sqrt(n) of the n bindings, which keeps
+ *  O(sqrt(n)) intermediates for one extra forward pass, or "cheap" for the runs of
+ *  injective operators, so that only the outputs of the heavy operators are kept.
+ *
+ * \return the pass
+ */
+TVM_DLL Pass AnnotateCheckpoints(String policy);
+
 /*!
  * \brief Fold constant expressions.
  *
@@ -125,6 +141,23 @@ TVM_DLL Pass DefuseOps();
  */
 TVM_DLL Pass RewriteAnnotatedOps(int fallback_device);
 
+/*!
+ * \brief Annotate the operators with the device of their data type, for models split between
+ *  an integer accelerator and a float16 one, e.g. a Hexagon DSP and an Adreno GPU.
+ *
+ *  The operators reading or producing 8 bit integers, and the integer operators on their
+ *  results, go to quantized_device. The float16 operators go to float_device. The other
+ *  operators, and those already annotated, are left as they are. RewriteAnnotatedOps then
+ *  inserts the copies between the devices.
+ *
+ * \param quantized_device The device type of the quantized operators.
+ * \param float_device The device type of the float16 operators, 0 to leave them to the
+ *  fallback device.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass AnnotateDeviceByDType(int quantized_device, int float_device);
+
 /*!
  * \brief Turn an expression to Basic Block Normal Form.
  *
@@ -218,6 +251,22 @@ TVM_DLL Pass SimplifyInference();
  */
 TVM_DLL Pass FastMath();
 
+/*!
+ * \brief Select float16 or float32 accumulation for the float16 convolutions and dense layers.
+ *
+ *  A layer accumulates in float32, and casts its result back to float16, when the policy
+ *  returns "float32" for it, or when the policy returns an empty string and more than
+ *  max_fp16_reduction products are summed up for one of its outputs. Otherwise it
+ *  accumulates in float16.
+ *
+ * \param max_fp16_reduction The longest reduction accumulated in float16.
+ * \param policy An optional function called with the layer call and its reduction length,
+ *  returning "float16", "float32", or an empty string or None to apply the reduction length rule.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass MixedPrecisionAccumulation(int64_t max_fp16_reduction, runtime::PackedFunc policy);
+
 /*!
  * \brief Find Dynamic ops and make them static
  *
@@ -236,6 +285,11 @@ TVM_DLL Pass DynamicToStatic();
  * type information filled in, as well as it's checked type field
  * populated with the result type.
  *
+ * When the pass config "relay.InferType.incremental" is set, the dataflow subgraphs with
+ * static types left untouched since the last inference keep their checked types and only
+ * the rewritten parts of the functions are solved again. This trusts every checked type
+ * found in the functions, which passes setting checked types by hand break.
+ *
  * \return The pass.
  */
 TVM_DLL Pass InferType();
@@ -324,6 +378,15 @@ TVM_DLL Pass CanonicalizeOps();
  */
 TVM_DLL Pass AlterOpLayout();
 
+/*!
+ * \brief Push the layout transforms inserted by AlterOpLayout and ConvertLayout through layout
+ * agnostic ops, i.e. elementwise ops, concatenations along an axis which is not packed, 2D
+ * pooling and resizing, and merge or cancel back-to-back transforms.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass PropagateLayoutTransform();
+
 /*!
  * \brief Do layout rewrite according to the tile structure created by auto-scheduler.
  * \return The pass
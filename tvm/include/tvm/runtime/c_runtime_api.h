@@ -415,6 +415,23 @@ TVM_DLL int TVMArrayCopyFromBytes(TVMArrayHandle handle, void* data, size_t nbyt
  */
 TVM_DLL int TVMArrayCopyToBytes(TVMArrayHandle handle, void* data, size_t nbytes);
 
+/*!
+ * \brief Convert an array of float32 to float16 on the host, with SIMD when the CPU supports
+ *  it, e.g. to stage float32 parameters for a float16 model before the upload.
+ * \param src The float32 values.
+ * \param dst The float16 values, as their bit patterns.
+ * \param n The number of values.
+ */
+TVM_DLL void TVMConvertFloat32ToFloat16(const float* src, uint16_t* dst, int64_t n);
+
+/*!
+ * \brief Convert an array of float16 to float32 on the host, with SIMD when the CPU supports it.
+ * \param src The float16 values, as their bit patterns.
+ * \param dst The float32 values.
+ * \param n The number of values.
+ */
+TVM_DLL void TVMConvertFloat16ToFloat32(const uint16_t* src, float* dst, int64_t n);
+
 /*!
  * \brief Copy the array, both from and to must be valid during the copy.
  * \param from The array to be copied from.
@@ -25,10 +25,15 @@
 
 #include <tvm/runtime/object.h>
 
+#include <cstddef>
 #include <cstdlib>
 #include <type_traits>
 #include <utility>
 
+#ifndef USE_OBJECT_POOL
+#define USE_OBJECT_POOL 0
+#endif
+
 namespace tvm {
 namespace runtime {
 /*!
@@ -40,6 +45,50 @@ namespace runtime {
 template <typename T, typename... Args>
 inline ObjectPtr<T> make_object(Args&&... args);
 
+/*!
+ * \brief Thread local recycling of the memory of small objects.
+ *
+ *  While a scope is active on a thread, the memory of the small objects freed on that thread
+ *  is kept in free lists, one per size class, and reused by the next allocations of the same
+ *  size class instead of going through the global allocator. Compiler passes that create and
+ *  drop many short lived IR nodes benefit from it. The cached memory is released when the
+ *  outermost scope of the thread exits. The objects that outlive a scope need no special care,
+ *  their memory is an ordinary heap block that is freed normally.
+ *
+ *  SimpleObjAllocator only allocates through the pool when built with USE_OBJECT_POOL, and
+ *  outside of a scope the pool forwards to operator new and delete.
+ */
+class ObjectPool {
+ public:
+  /*! \brief The largest object size served by the pool. */
+  static constexpr size_t kMaxObjectSize = 256;
+  /*!
+   * \brief Allocate the memory of an object.
+   * \param size The size of the object, at most kMaxObjectSize.
+   * \return The memory, aligned for std::max_align_t.
+   */
+  TVM_DLL static void* Allocate(size_t size);
+  /*!
+   * \brief Free the memory of an object allocated by Allocate.
+   * \param ptr The memory.
+   * \param size The size the memory was allocated with.
+   */
+  TVM_DLL static void Free(void* ptr, size_t size);
+  /*! \brief Enter a recycling scope on the current thread, scopes can be nested. */
+  TVM_DLL static void EnterScope();
+  /*! \brief Exit a recycling scope, the outermost one releases the cached memory. */
+  TVM_DLL static void ExitScope();
+};
+
+/*! \brief RAII helper of ObjectPool scopes. */
+class ObjectPoolScope {
+ public:
+  ObjectPoolScope() { ObjectPool::EnterScope(); }
+  ~ObjectPoolScope() { ObjectPool::ExitScope(); }
+  ObjectPoolScope(const ObjectPoolScope&) = delete;
+  ObjectPoolScope& operator=(const ObjectPoolScope&) = delete;
+};
+
 // Detail implementations after this
 //
 // The current design allows swapping the
@@ -103,6 +152,11 @@ class SimpleObjAllocator : public ObjAllocatorBase<SimpleObjAllocator> {
    public:
     using StorageType = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
 
+    // Whether the object goes through the ObjectPool
+    static constexpr bool kPooled = USE_OBJECT_POOL != 0 &&
+                                    sizeof(StorageType) <= ObjectPool::kMaxObjectSize &&
+                                    alignof(StorageType) <= alignof(std::max_align_t);
+
     template <typename... Args>
     static T* New(SimpleObjAllocator*, Args&&... args) {
       // NOTE: the first argument is not needed for SimpleObjAllocator
@@ -118,6 +172,11 @@ class SimpleObjAllocator : public ObjAllocatorBase<SimpleObjAllocator> {
       // class with non-virtual destructor.
       // We are fine here as we captured the right deleter during construction.
       // This is also the right way to get storage type for an object pool.
+      if (kPooled) {
+        void* data = ObjectPool::Allocate(sizeof(StorageType));
+        new (data) T(std::forward<Args>(args)...);
+        return reinterpret_cast<T*>(data);
+      }
       StorageType* data = new StorageType();
       new (data) T(std::forward<Args>(args)...);
       return reinterpret_cast<T*>(data);
@@ -136,7 +195,11 @@ class SimpleObjAllocator : public ObjAllocatorBase<SimpleObjAllocator> {
       // instead of tptr->~T(), which could mean the intention
       // call a virtual destructor(which may not be available and is not required).
       tptr->T::~T();
-      delete reinterpret_cast<StorageType*>(tptr);
+      if (kPooled) {
+        ObjectPool::Free(tptr, sizeof(StorageType));
+      } else {
+        delete reinterpret_cast<StorageType*>(tptr);
+      }
     }
   };
 
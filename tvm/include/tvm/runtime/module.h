@@ -230,8 +230,28 @@ constexpr const char* tvm_module_main = "__tvm_main__";
 constexpr const char* tvm_param_prefix = "__tvm_param__";
 /*! \brief A PackedFunc that looks up linked parameters by storage_id. */
 constexpr const char* tvm_lookup_linked_param = "_lookup_linked_param";
+/*!
+ * \brief A PackedFunc that looks up the storage entries of the static arena by storage_id.
+ *  The arena is used by one graph runtime at a time, it is acquired with the storage_id
+ *  kStorageArenaAcquire and given back with kStorageArenaRelease.
+ */
+constexpr const char* tvm_lookup_storage_arena = "_lookup_storage_arena";
+/*! \brief The symbol of the static arena holding the storage entries of the graph. */
+constexpr const char* tvm_storage_arena = "__tvm_storage_arena";
+/*! \brief The PackedFunc running the graph with the ahead-of-time executor. */
+constexpr const char* tvm_run_aot = "_run_aot";
+/*!
+ * \brief Suffix of the entry of a packed function that skips the argument checks, see the
+ *  tir.packed_api.unchecked_entry option of MakePackedAPI.
+ */
+constexpr const char* tvm_unchecked_entry_suffix = "__tvm_unchecked";
 }  // namespace symbol
 
+/*! \brief The storage_id acquiring the static arena of symbol::tvm_lookup_storage_arena. */
+constexpr int64_t kStorageArenaAcquire = -1;
+/*! \brief The storage_id releasing the static arena of symbol::tvm_lookup_storage_arena. */
+constexpr int64_t kStorageArenaRelease = -2;
+
 // implementations of inline functions.
 
 inline void Module::Import(Module other) { return (*this)->Import(other); }
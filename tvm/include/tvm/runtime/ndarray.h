@@ -30,6 +30,7 @@
 #include <tvm/runtime/object.h>
 #include <tvm/runtime/serializer.h>
 
+#include <algorithm>
 #include <atomic>
 #include <utility>
 #include <vector>
@@ -232,11 +233,31 @@ class NDArray::ContainerBase {
   void* manager_ctx{nullptr};
 
  protected:
+  /*! \brief The number of dimensions of the shapes kept inline, without a heap allocation. */
+  static constexpr int kInlineNDim = 6;
+  /*!
+   * \brief Set the shape of dl_tensor, kept in the container.
+   * \param shape The shape.
+   * \param ndim The number of dimensions.
+   */
+  void SetShape(const int64_t* shape, int ndim) {
+    if (ndim <= kInlineNDim) {
+      if (shape != inline_shape_) std::copy(shape, shape + ndim, inline_shape_);
+      shape_.clear();
+      dl_tensor.shape = ndim != 0 ? inline_shape_ : nullptr;
+    } else {
+      shape_.assign(shape, shape + ndim);
+      dl_tensor.shape = shape_.data();
+    }
+    dl_tensor.ndim = ndim;
+  }
   /*!
    * \brief The shape container,
    *  can be used used for shape data.
    */
   std::vector<int64_t> shape_;
+  /*! \brief The shape of up to kInlineNDim dimensions, shape_ is empty then. */
+  int64_t inline_shape_[kInlineNDim];
 };
 
 /*!
@@ -256,13 +277,11 @@ class NDArray::Container : public Object, public NDArray::ContainerBase {
     dl_tensor.byte_offset = 0;
   }
 
-  Container(void* data, std::vector<int64_t> shape, DLDataType dtype, DLContext ctx) {
+  Container(void* data, const std::vector<int64_t>& shape, DLDataType dtype, DLContext ctx) {
     // Initialize the type index.
     type_index_ = Container::RuntimeTypeIndex();
     dl_tensor.data = data;
-    shape_ = std::move(shape);
-    dl_tensor.ndim = static_cast<int>(shape_.size());
-    dl_tensor.shape = dmlc::BeginPtr(shape_);
+    SetShape(shape.data(), static_cast<int>(shape.size()));
     dl_tensor.dtype = dtype;
     dl_tensor.strides = nullptr;
     dl_tensor.byte_offset = 0;
@@ -24,6 +24,8 @@
 #ifndef TVM_RUNTIME_THREADING_BACKEND_H_
 #define TVM_RUNTIME_THREADING_BACKEND_H_
 
+#include <tvm/runtime/object.h>
+
 #include <functional>
 #include <memory>
 #include <vector>
@@ -64,12 +66,17 @@ class ThreadGroup {
   enum AffinityMode : int {
     kBig = 1,
     kLittle = -1,
+    /*!
+     * \brief Use all the cores, big and little, and let the thread pool split the work by the
+     *  measured throughput of every worker.
+     */
+    kWeighted = 2,
   };
 
   /*!
    * \brief configure the CPU id affinity
    *
-   * \param mode The preferred CPU type (1 = big, -1 = little).
+   * \param mode The preferred CPU type (1 = big, -1 = little, 2 = all with weighted splits).
    * \param nthreads The number of threads to use (0 = use all).
    * \param exclude_worker0 Whether to use the main thread as a worker.
    *        If  `true`, worker0 will not be launched in a new thread and
@@ -80,6 +87,17 @@ class ThreadGroup {
    */
   int Configure(AffinityMode mode, int nthreads, bool exclude_worker0);
 
+  /*!
+   * \brief Pin every worker thread to the given cores, worker i to cores[i].
+   *
+   * \param cores The ids of the cores, at least one per worker.
+   * \param exclude_worker0 Whether the main thread is used as worker 0, in which case
+   *        cores[0] is left to it and its affinity is not changed.
+   *
+   * \return The number of workers to use.
+   */
+  int ConfigureCores(const std::vector<unsigned int>& cores, bool exclude_worker0);
+
  private:
   Impl* impl_;
 };
@@ -94,6 +112,34 @@ void Yield();
  */
 int MaxConcurrency();
 
+/*!
+ * \brief Create a thread pool isolated from the thread local default ones, with one worker
+ *  pinned to every given core. Executors bound to different pools run side by side without
+ *  contending for the same workers.
+ * \param cores The ids of the cores of the pool.
+ * \return The pool, to be bound with ThreadPoolScope.
+ */
+ObjectRef CreateThreadPool(const std::vector<unsigned int>& cores);
+
+/*!
+ * \brief While alive, the parallel launches of the current thread go to the given pool
+ *  instead of the thread local default one. Launches from several threads bound to the same
+ *  pool are serialized.
+ */
+class ThreadPoolScope {
+ public:
+  /*!
+   * \brief Bind the pool to the current thread.
+   * \param pool A pool from CreateThreadPool, an undefined one keeps the current binding.
+   */
+  explicit ThreadPoolScope(const ObjectRef& pool);
+  ~ThreadPoolScope();
+
+ private:
+  /*! \brief The previous binding, restored on destruction. */
+  void* prev_;
+};
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
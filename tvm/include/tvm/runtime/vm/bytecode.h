@@ -200,6 +200,8 @@ struct Instruction {
       DLDataType dtype_hint;
       /*! \brief The device type of the allocation. */
       Index device_type;
+      /*! \brief The index of the memory scope in the executable. */
+      Index memory_scope;
     } alloc_storage;
     struct /* ShapeOf Operands */ {
       RegName tensor;
@@ -353,11 +355,12 @@ struct Instruction {
    * \param alignment The allocation's alignment.
    * \param dtype_hint The data type hint for the allocator.
    * \param device_type The device type for the allocator.
+   * \param memory_scope The index of the memory scope of the storage in the executable.
    * \param dst The destination to place the storage.
    * \return The alloc storage instruction.
    */
   static Instruction AllocStorage(RegName size, Index alignment, DLDataType dtype_hint,
-                                  Index device_type, RegName dst);
+                                  Index device_type, Index memory_scope, RegName dst);
   /*!
    * \brief Get the shape of an input tensor.
    * \param tensor The input tensor.
@@ -29,12 +29,16 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/vm/bytecode.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace tvm {
 namespace runtime {
+
+struct MappedFile;
+
 namespace vm {
 
 struct VMFunction;
@@ -46,7 +50,9 @@ struct VMFunction;
  * to run in a virtual machine.
  *
  *  - Global section, containing all globals.
- *  - Constant section, storing the constant pool.
+ *  - Constant section, storing the constant pool. The data of every constant
+ *  is aligned in the serialized bytes, so that a mapped executable file can
+ *  use it in place.
  *  - Primitive name section, containing the function name of the primitive ops
  *  used by the virtual machine.
  *  - Code section, handling the VM functions and bytecode.
@@ -81,6 +87,20 @@ class Executable : public ModuleNode {
    */
   static runtime::Module Load(const std::string& code, const runtime::Module lib);
 
+  /*!
+   * \brief Load a VM executable saved to a file.
+   *
+   * The file is mapped in memory. The constants in host memory view their data
+   * in the mapping, so their pages are only read when they are used, and the weights
+   * are not copied at load time.
+   *
+   * \param path The path of the file containing the saved bytes.
+   * \param lib The compiled runtime library.
+   *
+   * \return exe The constructed executable.
+   */
+  static runtime::Module LoadFromFile(const std::string& path, const runtime::Module lib);
+
   /*!
    * \brief Get the serialized form of the `functions`. This is
    * essentially bytecode serialization.
@@ -163,6 +183,13 @@ class Executable : public ModuleNode {
   std::vector<VMFunction> functions;
   /*! \brief The device type for each constant. */
   std::vector<Index> const_device_type;
+  /*! \brief The memory scopes of storage allocations, referred to by their index. */
+  std::vector<std::string> memory_scopes;
+  /*!
+   * \brief The indices of the packed functions that are shape functions,
+   * whose outputs only depend on the content of their inputs.
+   */
+  std::vector<Index> shape_funcs;
 
  private:
   /*!
@@ -175,9 +202,9 @@ class Executable : public ModuleNode {
   /*!
    * \brief Save the constant pool.
    *
-   * \param strm The input stream.
+   * \param strm The input stream, positioned at its offset from the start of the executable.
    */
-  void SaveConstantSection(dmlc::Stream* strm);
+  void SaveConstantSection(dmlc::SeekStream* strm);
 
   /*!
    * \brief Save primitive op names.
@@ -186,6 +213,20 @@ class Executable : public ModuleNode {
    */
   void SavePrimitiveOpNames(dmlc::Stream* strm);
 
+  /*!
+   * \brief Save the memory scopes.
+   *
+   * \param strm The input stream.
+   */
+  void SaveMemoryScopes(dmlc::Stream* strm);
+
+  /*!
+   * \brief Save the indices of the shape functions.
+   *
+   * \param strm The input stream.
+   */
+  void SaveShapeFuncs(dmlc::Stream* strm);
+
   /*!
    * \brief Save the vm functions.
    *
@@ -203,9 +244,10 @@ class Executable : public ModuleNode {
   /*!
    * \brief Load the constant pool.
    *
-   * \param strm The input stream.
+   * \param strm The input stream, positioned at its offset from the start of the executable.
+   * \param file The mapped executable file the stream reads, nullptr if it is not mapped.
    */
-  void LoadConstantSection(dmlc::Stream* strm);
+  void LoadConstantSection(dmlc::SeekStream* strm, const std::shared_ptr<MappedFile>& file);
 
   /*!
    * \brief Load primitive op names.
@@ -214,6 +256,20 @@ class Executable : public ModuleNode {
    */
   void LoadPrimitiveOpNames(dmlc::Stream* strm);
 
+  /*!
+   * \brief Load the memory scopes.
+   *
+   * \param strm The input stream.
+   */
+  void LoadMemoryScopes(dmlc::Stream* strm);
+
+  /*!
+   * \brief Load the indices of the shape functions.
+   *
+   * \param strm The input stream.
+   */
+  void LoadShapeFuncs(dmlc::Stream* strm);
+
   /*!
    * \brief Load the vm functions.
    *
@@ -221,8 +277,18 @@ class Executable : public ModuleNode {
    */
   void LoadCodeSection(dmlc::Stream* strm);
 
+  /*!
+   * \brief Load all the sections of a saved executable.
+   *
+   * \param strm The input stream, positioned at the start of the executable.
+   * \param file The mapped executable file the stream reads, nullptr if it is not mapped.
+   */
+  void LoadSections(dmlc::SeekStream* strm, const std::shared_ptr<MappedFile>& file);
+
   /*! \brief The serialized bytecode. */
   std::string code_;
+  /*! \brief The format version of the loaded bytecode, which selects the sections read. */
+  uint64_t format_version_{0};
 };
 
 }  // namespace vm
@@ -31,6 +31,7 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -62,11 +63,18 @@ struct Buffer {
   size_t size{0};
   /*! \brief The context of the allocated buffers. */
   TVMContext ctx;
+  /*! \brief The memory scope of the buffer, empty for flat device memory. */
+  std::string scope;
+  /*! \brief The tensor shape a scoped buffer was allocated for. */
+  std::vector<int64_t> shape;
+  /*! \brief The element type a scoped buffer was allocated for. */
+  DLDataType dtype;
 };
 
 enum AllocatorType {
   kNaive = 1,
   kPooled,
+  kBinned,
 };
 
 class Allocator {
@@ -89,6 +97,14 @@ class Allocator {
    *  \return A sized allocation in the form of a buffer.
    */
   virtual Buffer Alloc(size_t nbytes, size_t alignment, DLDataType type_hint) = 0;
+  /*! \brief Allocate a buffer in a memory scope which is not flat, e.g. a texture.
+   *  \param shape The shape of the tensor the buffer is allocated for.
+   *  \param type_hint The element type of the tensor.
+   *  \param mem_scope The memory scope of the buffer.
+   *  \return An allocation in the form of a buffer.
+   */
+  virtual Buffer Alloc(const std::vector<int64_t>& shape, DLDataType type_hint,
+                       const std::string& mem_scope) = 0;
   /*! \brief Free a buffer allocated by the allocator.
    *  \param buffer The buffer to free.
    */
@@ -133,13 +149,20 @@ class StorageObj : public Object {
   /*! \brief The index into the VM function table. */
   Buffer buffer;
 
-  /*! \brief Allocate an NDArray from a given piece of storage. */
+  /*!
+   * \brief Allocate an NDArray from a given piece of storage.
+   *
+   *  Scoped storage is materialized by its first array, since the layout of
+   *  e.g. a texture depends on the shape rather than on the size alone.
+   */
   NDArray AllocNDArray(size_t offset, std::vector<int64_t> shape, DLDataType dtype);
 
   /*! \brief The deleter for an NDArray when allocated from underlying storage. */
   static void Deleter(Object* ptr);
 
   ~StorageObj() {
+    // Scoped storage which was never used holds no memory
+    if (buffer.data == nullptr) return;
     auto alloc = MemoryManager::Global()->GetAllocator(buffer.ctx);
     alloc->Free(buffer);
   }
@@ -33,7 +33,9 @@
 #include <tvm/runtime/vm/executable.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -143,6 +145,34 @@ struct VMFrame {
  * multiple threads, or serialize them to disk or over the
  * wire.
  */
+/*!
+ * \brief The constants of an executable copied to their devices. The pool is shared
+ * by a virtual machine and the execution contexts forked from it.
+ *
+ * A constant is copied once under the mutex, the loads of a copied constant only
+ * read its flag.
+ */
+struct VMConstantPool {
+  /*! \param num_constants The number of constants of the executable. */
+  explicit VMConstantPool(size_t num_constants = 0)
+      : objects(num_constants), loaded(num_constants) {}
+  /*! \brief Protect the copy of the constants. */
+  std::mutex mutex;
+  /*! \brief The device copy of each constant, undefined until it is first loaded. */
+  std::vector<ObjectRef> objects;
+  /*! \brief Whether each constant is copied, set after its object. */
+  std::vector<std::atomic<bool>> loaded;
+};
+
+/*!
+ * \brief The virtual machine.
+ *
+ * A virtual machine holds the state of one call, so it cannot run several calls at
+ * once. For concurrent calls, `Fork` creates execution contexts that share the
+ * executable, the contexts, the allocators and the device constants, and own only the
+ * frames and registers of a call. The "run" function does this transparently by
+ * running each call on an idle context.
+ */
 class VirtualMachine : public runtime::ModuleNode {
  public:
   /*!
@@ -168,7 +198,13 @@ class VirtualMachine : public runtime::ModuleNode {
 
   const char* type_key() const final { return "VirtualMachine"; }
 
-  VirtualMachine() : frames_(), func_index_(0), code_(nullptr), pc_(0), exec_(nullptr) {}
+  VirtualMachine()
+      : frames_(),
+        func_index_(0),
+        code_(nullptr),
+        pc_(0),
+        exec_(nullptr),
+        const_pool_(std::make_shared<VMConstantPool>()) {}
 
   /*!
    * \brief load the executable for the virtual machine.
@@ -176,6 +212,18 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   virtual void LoadExecutable(const Executable* exec);
 
+  /*!
+   * \brief Create an execution context of this virtual machine.
+   *
+   * The context shares the executable, the loaded packed functions, the contexts, the
+   * allocators and the device constants of this virtual machine, and owns the state of a
+   * call. Contexts forked from one virtual machine can run on different threads at once.
+   *
+   * \return The execution context, a plain VirtualMachine.
+   * \note The virtual machine must be initialized before it is forked.
+   */
+  ObjectPtr<VirtualMachine> Fork() const;
+
  protected:
   /*! \brief Push a call frame on to the call stack. */
   void PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func);
@@ -196,9 +244,9 @@ class VirtualMachine : public runtime::ModuleNode {
   /*!
    * \brief Read a VM register.
    * \param reg The register to read from.
-   * \return The read object.
+   * \return The read object, only valid until the next frame is pushed.
    */
-  inline ObjectRef ReadRegister(RegName reg) const;
+  inline const ObjectRef& ReadRegister(RegName reg) const;
 
   /*!
    * \brief Read a VM register and cast it to int32_t
@@ -238,6 +286,17 @@ class VirtualMachine : public runtime::ModuleNode {
   virtual void InvokePacked(Index packed_index, const PackedFunc& func, Index arg_count,
                             Index output_size, const std::vector<ObjectRef>& args);
 
+  /*!
+   * \brief Invoke a shape function. When its inputs have the same content as in the last
+   * call at the same instruction, the outputs of that call are copied instead.
+   *
+   * \param instr The InvokePacked instruction.
+   * \param func The shape function.
+   * \param args The arguments of the shape function, its inputs followed by its outputs.
+   */
+  void InvokeShapeFunc(const Instruction& instr, const PackedFunc& func,
+                       const std::vector<ObjectRef>& args);
+
   /*!
    * \brief Initialize the virtual machine for a set of contexts.
    * \param contexts The set of TVM contexts.
@@ -258,6 +317,29 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   void InvokeGlobal(const VMFunction& func, const std::vector<ObjectRef>& args);
 
+  /*!
+   * \brief Find a function of the executable.
+   * \param func_name The function's name.
+   * \return The function.
+   */
+  const VMFunction& GetVMFunction(const std::string& func_name) const;
+
+  /*!
+   * \brief Copy the arguments of a function to the devices of its parameters.
+   * \param vm_func The function.
+   * \param args The packed arguments.
+   * \param offset The index of the first argument of the function in args.
+   * \return The function arguments.
+   */
+  std::vector<ObjectRef> GetInputs(const VMFunction& vm_func, const TVMArgs& args,
+                                   int offset) const;
+
+  /*! \brief Take an idle execution context, forking a new one if there is none. */
+  ObjectPtr<VirtualMachine> AcquireContext();
+
+  /*! \brief Return an execution context after a successful call. */
+  void ReleaseContext(ObjectPtr<VirtualMachine> context);
+
  protected:
   /*! \brief The virtual machine's packed function table. */
   std::vector<PackedFunc> packed_funcs_;
@@ -273,6 +355,10 @@ class VirtualMachine : public runtime::ModuleNode {
   ObjectRef return_register_;
   /*! \brief The executable the VM will operate on. */
   const Executable* exec_;
+  /*! \brief Keep the executable alive while the VM and its contexts use it. */
+  ObjectRef exec_ref_;
+  /*! \brief The virtual machine a context returned by "fork" comes from, kept alive with it. */
+  ObjectRef parent_;
   /*! \brief The function name to inputs mapping. */
   std::unordered_map<std::string, std::vector<ObjectRef>> inputs_;
   /*! \brief The set of TVM contexts the VM is currently executing on. */
@@ -283,7 +369,33 @@ class VirtualMachine : public runtime::ModuleNode {
    * \brief The constant pool for runtime. It caches the device dependent
    * object to avoid rellocation of constants during inference.
    */
-  std::vector<ObjectRef> const_pool_;
+  std::shared_ptr<VMConstantPool> const_pool_;
+  /*! \brief Whether each packed function is a shape function. */
+  std::vector<bool> is_shape_func_;
+  /*! \brief The inputs and outputs of the last call of a shape function. */
+  struct ShapeFuncCacheEntry {
+    /*! \brief The dtypes, shapes and data of the inputs. */
+    std::string inputs;
+    /*! \brief Host copies of the outputs. */
+    std::vector<NDArray> outputs;
+  };
+  /*! \brief The last shape function call of every InvokePacked instruction of one. */
+  std::unordered_map<const Instruction*, ShapeFuncCacheEntry> shape_func_cache_;
+  /*!
+   * \brief The arguments of the InvokePacked instruction being executed, kept
+   * between instructions so that its storage is reused.
+   */
+  std::vector<ObjectRef> packed_args_;
+  /*! \brief The argument values passed to packed functions, reused between calls. */
+  std::vector<TVMValue> packed_values_;
+  /*! \brief The argument type codes passed to packed functions, reused between calls. */
+  std::vector<int> packed_codes_;
+  /*! \brief The thread pool the kernels launch on, undefined for the default one. */
+  ObjectRef thread_pool_;
+  /*! \brief The execution contexts not running a call of "run". */
+  std::vector<ObjectPtr<VirtualMachine>> idle_contexts_;
+  /*! \brief Protect the idle execution contexts. */
+  std::mutex context_mutex_;
 };
 
 }  // namespace vm
@@ -67,6 +67,20 @@ TVM_DLL std::vector<std::vector<int>> rr_partitioner(int begin, int end, int ste
 TVM_DLL void parallel_for(int begin, int end, const std::function<void(int)>& f, int step = 1,
                           const PartitionerFuncType partitioner = rr_partitioner);
 
+/*!
+ * \brief A runtime api to run the task function in parallel with a dynamic partition.
+ *  Unlike `parallel_for`, the tasks are not assigned to the threads ahead of time: any thread
+ *  which is idle fetches the next task, which balances tasks of very different costs.
+ * \param begin The start index of this parallel loop(inclusive).
+ * \param end The end index of this parallel loop(exclusive).
+ * \param num_threads The number of threads to launch.
+ * \param f The task function to be excuted. It takes the index of the thread running it and the
+ *  index of the task as input, with no output.
+ * \note Nested parallel loops are not supported, the same as `parallel_for`.
+ */
+TVM_DLL void parallel_for_dynamic(int begin, int end, int num_threads,
+                                  const std::function<void(int thread_id, int task_id)>& f);
+
 }  // namespace support
 }  // namespace tvm
 
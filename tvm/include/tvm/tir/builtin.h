@@ -104,6 +104,18 @@ TVM_DLL const Op& large_uint_imm();
  */
 TVM_DLL const Op& q_multiply_shift();
 
+/*!
+ * \brief Dot product of the four int8 lanes of two vectors accumulated in int32
+ *
+ *  int32 dp4a(int8x4 a, int8x4 b, int32 c) {
+ *    return c + a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+ *  }
+ *
+ *  Targets with integer dot product instructions lower it to one instruction,
+ *  the default lowering expands the lanes.
+ */
+TVM_DLL const Op& dp4a();
+
 /*!
  * \brief See pesudo code
  *
@@ -567,6 +579,8 @@ TVM_DLL const Op& vectorcombine();
 TVM_DLL const Op& atomic_add();
 /*!
  * \brief Create a texture 2d memory allocation
+ *
+ *  Handle texture2d_alloca(width, height, channel)
  */
 TVM_DLL const Op& texture2d_alloca();
 
@@ -580,6 +594,42 @@ TVM_DLL const Op& texture2d_store();
  */
 TVM_DLL const Op& texture2d_load();
 
+/*!
+ * \brief Store to one image of a texture 2d array
+ *
+ *  texture2d_array_store(tex, x, y, layer, value)
+ */
+TVM_DLL const Op& texture2d_array_store();
+
+/*!
+ * \brief Load from one image of a texture 2d array
+ *
+ *  texture2d_array_load(tex, x, y, layer, channel)
+ */
+TVM_DLL const Op& texture2d_array_load();
+
+/*!
+ * \brief Sample texture 2d memory through the texture unit
+ *
+ *  texture2d_sample(tex, sampler, u, v, channel)
+ *
+ *  u and v are floating point coordinates along the width and the height of the
+ *  texture, sampler is a constant combination of TextureSamplerFlag. Texel centers
+ *  are at half integer coordinates, so a linear filter interpolates the four texels
+ *  around the sampled point in hardware.
+ */
+TVM_DLL const Op& texture2d_sample();
+
+/*! \brief The flags of the sampler of texture2d_sample, 0 samples the nearest texel */
+enum TextureSamplerFlag : int {
+  /*! \brief Interpolate the texels around the coordinates instead of taking the nearest one */
+  kSamplerFilterLinear = 1,
+  /*! \brief Repeat the border texels outside the texture instead of returning zeros */
+  kSamplerAddressClampToEdge = 2,
+  /*! \brief The coordinates are normalized to [0, 1] over the texture extent */
+  kSamplerNormalizedCoords = 4
+};
+
 /*! \brief The kind of structure field info used in intrinsic */
 enum TVMStructFieldKind : int {
   // array head address
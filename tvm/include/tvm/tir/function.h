@@ -220,6 +220,14 @@ constexpr const char* kDeviceThreadAxis = "tir.device_thread_axis";
  */
 constexpr const char* kNoAlias = "tir.noalias";
 
+/*!
+ * \brief The compiler flags to build the device kernel with, from the build_options
+ *  pragmas around it.
+ *
+ * Type: String
+ */
+constexpr const char* kDeviceBuildOptions = "tir.device_build_options";
+
 /*!
  * \brief Mark the function as the entry function of
  *        the final generated runtime module.
@@ -240,6 +248,31 @@ constexpr const char* kIsEntryFunc = "tir.is_entry_func";
  */
 constexpr const char* kLinkedParams = "tir.linked_params";
 
+/*!
+ * \brief The static memory plan of the graph linked by the codegen: the size in bytes of every
+ *  storage id, 0 for the storage ids left out of the arena.
+ *
+ * Type: Array<Integer>
+ *
+ * \note This should be present only on a function named
+ *     tvm::runtime::symbol::tvm_lookup_storage_arena.
+ */
+constexpr const char* kStorageArena = "tir.storage_arena";
+
+/*!
+ * \brief The graph run by the ahead-of-time executor, with the keys
+ *  - entry_storage_ids, entry_shapes, entry_dtypes: the storage id, shape and dtype of every
+ *    graph entry;
+ *  - storage_params: the name of the linked param of every storage id, "" for the others;
+ *  - input_entries, output_entries: the entries of the graph inputs and outputs;
+ *  - call_funcs, call_args: the fused functions in execution order and their entries.
+ *
+ * Type: Map<String, ObjectRef>
+ *
+ * \note This should be present only on a function named tvm::runtime::symbol::tvm_run_aot.
+ */
+constexpr const char* kAOTPlan = "tir.aot_plan";
+
 }  // namespace attr
 }  // namespace tir
 }  // namespace tvm
@@ -1245,6 +1245,11 @@ constexpr const char* pragma_scope_prefix = "pragma_";
 constexpr const char* pragma_import_c = "pragma_import_c";
 /*! \brief Import llvm source or file into the final code gen module */
 constexpr const char* pragma_import_llvm = "pragma_import_llvm";
+/*!
+ * \brief The device compiler flags of the kernels in the region, a StringImm such as
+ *  "-cl-mad-enable", passed to the OpenCL program build.
+ */
+constexpr const char* pragma_build_options = "pragma_build_options";
 /*! \brief Try to modify the AST to support Tensor Core */
 constexpr const char* pragma_tensor_core = "pragma_tensor_core";
 /*!
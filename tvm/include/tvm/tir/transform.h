@@ -90,6 +90,18 @@ TVM_DLL Pass StorageFlatten(int cache_line_size, bool create_bound_attribute = f
  */
 TVM_DLL Pass InjectCopyIntrin(String pragma_key, runtime::PackedFunc fintrin);
 
+/*!
+ * \brief Lower the copies marked with the "vtcm_copy" pragma, typically the cache reads of a
+ *  Hexagon schedule into "vtcm" buffers, to the row copies of the Hexagon device runtime.
+ *
+ *  Together with double_buffer on the cache stage, the copy of the next tile is issued before
+ *  the current tile is computed. The pass is run by lower() when the current target is
+ *  Hexagon.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass InjectVTCMCopy();
+
 /*!
  * \brief Detect and insert sync points to co-processor.
  *
@@ -160,6 +172,15 @@ TVM_DLL Pass UnrollLoop();
  */
 TVM_DLL Pass RemoveNoOp();
 
+/*!
+ * \brief Remove the texture stores no texture load can observe: the stores to the textures
+ *  allocated in the function but never read, and the stores overwritten by a later store to
+ *  the same texel before the texture is read.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass RemoveDeadTextureStore();
+
 /*!
  * \brief Detect and rewrite unsafe select that contains memory access.
  *
@@ -321,6 +342,20 @@ TVM_DLL Pass CombineContextCall();
  */
 TVM_DLL Pass NarrowDataType(int target_bits);
 
+/*!
+ * \brief Narrow the index arithmetic of the device kernels to the `index_bits`
+ *  attribute of the target of a function.
+ *
+ *  The chains of Add, Sub and Mul computing load and store indices are narrowed
+ *  without a bound, as they only wrap around when an index is out of its buffer.
+ *  The host asserts that the buffers, the allocations and the launch extents fit,
+ *  and a function whose allocations are not checkable is left unchanged.
+ *
+ * \note Run this pass after the target is bound and before MakePackedAPI.
+ * \return The pass.
+ */
+TVM_DLL Pass NarrowDeviceIndex();
+
 /*!
  * \brief Legalize bf16 typed Ops. Add a cast to fp32
  *   before Ops, then add a cast back to bf16.
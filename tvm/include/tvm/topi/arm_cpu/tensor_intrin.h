@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file arm_cpu/tensor_intrin.h
+ * \brief Tensorize intrinsics for the int8 dot product and matrix multiply instructions of ARM
+ *  CPUs, sdot/udot with -mattr=+dotprod and smmla/ummla with -mattr=+i8mm. The LLVM codegen
+ *  emulates the instructions on targets without the features.
+ */
+#ifndef TVM_TOPI_ARM_CPU_TENSOR_INTRIN_H_
+#define TVM_TOPI_ARM_CPU_TENSOR_INTRIN_H_
+
+#include <tvm/runtime/registry.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/tensor_intrin.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/op.h>
+
+#include <string>
+
+namespace tvm {
+namespace topi {
+
+using namespace tvm::te;
+
+namespace arm_cpu {
+
+namespace detail {
+/*!
+ * \brief Get the id of an LLVM intrinsic.
+ * \param name The name of the intrinsic.
+ * \return The id.
+ */
+inline int64_t LookupLLVMIntrinsic(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get("target.llvm_lookup_intrinsic_id");
+  ICHECK(f != nullptr) << "The ARM tensor intrinsics need TVM to be built with LLVM";
+  int64_t id = (*f)(name);
+  ICHECK_NE(id, 0) << "LLVM does not have the intrinsic " << name;
+  return id;
+}
+
+/*!
+ * \brief A compact buffer at any offset, for the operands of an intrinsic.
+ * \param t The tensor.
+ * \param name The name of the buffer.
+ * \return The buffer.
+ */
+inline tir::Buffer IntrinBuffer(const Tensor& t, const std::string& name) {
+  return tir::Buffer(tir::Var(name, DataType::Handle()), t->dtype, t->shape, {},
+                     tir::Var(name + "_elem_offset", DataType::Int(32)), name, "", -1, 1,
+                     tir::kDefault);
+}
+
+/*!
+ * \brief The body, reset and update statements of an intrinsic accumulating into an int32x4.
+ * \param intrin The name of the LLVM intrinsic, called as intrin(acc, a, b).
+ * \param a The first int8x16 operand.
+ * \param b The second int8x16 operand.
+ * \param c The buffer of the int32 accumulator.
+ * \param c_begin The index of the accumulator in c.
+ * \return The body, reset and update statements.
+ */
+inline Array<tir::Stmt> AccumulateInt32x4(const std::string& intrin, const PrimExpr& a,
+                                          const PrimExpr& b, const tir::Buffer& c,
+                                          const Array<PrimExpr>& c_begin) {
+  DataType int32x4 = DataType::Int(32, 4);
+  int64_t id = LookupLLVMIntrinsic(intrin);
+  auto accumulate = [&](PrimExpr acc) {
+    PrimExpr call = tir::Call(int32x4, tir::builtin::call_llvm_pure_intrin(),
+                              {IntImm(DataType::UInt(32), id), IntImm(DataType::UInt(32), 3), acc,
+                               a, b});
+    return c.vstore(c_begin, call);
+  };
+  PrimExpr zero = tir::Broadcast(IntImm(DataType::Int(32), 0), 4);
+  return {accumulate(zero), c.vstore(c_begin, zero), accumulate(c.vload(c_begin, int32x4))};
+}
+}  // namespace detail
+
+/*!
+ * \brief The dot product of 4 int8 with each of 4 rows of 4 int8, accumulated in 4 int32,
+ *  with sdot/udot: C[i] += sum_k A[k] * B[i, k].
+ *
+ * \param is_signed Whether the int8 values are signed.
+ *
+ * \return The tensor intrinsic.
+ */
+inline TensorIntrin DotInt8Int8Int32(bool is_signed) {
+  DataType int8 = is_signed ? DataType::Int(8) : DataType::UInt(8);
+  Tensor data = placeholder({4}, int8, "data");
+  Tensor kernel = placeholder({4, 4}, int8, "kernel");
+  IterVar k = reduce_axis(Range(0, 4), "k");
+  Tensor out = compute(
+      {4},
+      [&](Var i) {
+        return sum(
+            cast(DataType::Int(32), data(k->var)) * cast(DataType::Int(32), kernel(i, k->var)),
+            {k});
+      },
+      "C");
+  tir::Buffer a_buf = detail::IntrinBuffer(data, "a_buffer");
+  tir::Buffer b_buf = detail::IntrinBuffer(kernel, "b_buffer");
+  tir::Buffer c_buf = detail::IntrinBuffer(out, "c_buffer");
+  // the 4 values of data, broadcast to the 4 rows
+  PrimExpr a = reinterpret(
+      int8.with_lanes(16),
+      tir::Broadcast(reinterpret(DataType::Int(32), a_buf.vload({0}, int8.with_lanes(4))), 4));
+  PrimExpr b = b_buf.vload({0, 0}, int8.with_lanes(16));
+  Array<tir::Stmt> stmts = detail::AccumulateInt32x4(
+      is_signed ? "llvm.aarch64.neon.sdot" : "llvm.aarch64.neon.udot", a, b, c_buf, {0});
+  return TensorIntrin(is_signed ? "dot_int8_int8_int32" : "dot_uint8_uint8_int32", out->op,
+                      {data, kernel}, {a_buf, b_buf, c_buf}, {}, stmts[0], stmts[1], stmts[2]);
+}
+
+/*!
+ * \brief The 2x2 int32 product of a 2x8 int8 matrix with the transpose of another one, with
+ *  smmla/ummla: C[i, j] += sum_k A[i, k] * B[j, k].
+ *
+ * \param is_signed Whether the int8 values are signed.
+ *
+ * \return The tensor intrinsic.
+ */
+inline TensorIntrin MMLAInt8Int8Int32(bool is_signed) {
+  DataType int8 = is_signed ? DataType::Int(8) : DataType::UInt(8);
+  Tensor data = placeholder({2, 8}, int8, "data");
+  Tensor kernel = placeholder({2, 8}, int8, "kernel");
+  IterVar k = reduce_axis(Range(0, 8), "k");
+  Tensor out = compute(
+      {2, 2},
+      [&](Var i, Var j) {
+        return sum(
+            cast(DataType::Int(32), data(i, k->var)) * cast(DataType::Int(32), kernel(j, k->var)),
+            {k});
+      },
+      "C");
+  tir::Buffer a_buf = detail::IntrinBuffer(data, "a_buffer");
+  tir::Buffer b_buf = detail::IntrinBuffer(kernel, "b_buffer");
+  tir::Buffer c_buf = detail::IntrinBuffer(out, "c_buffer");
+  Array<tir::Stmt> stmts = detail::AccumulateInt32x4(
+      is_signed ? "llvm.aarch64.neon.smmla" : "llvm.aarch64.neon.ummla",
+      a_buf.vload({0, 0}, int8.with_lanes(16)), b_buf.vload({0, 0}, int8.with_lanes(16)), c_buf,
+      {0, 0});
+  return TensorIntrin(is_signed ? "mmla_int8_int8_int32" : "mmla_uint8_uint8_int32", out->op,
+                      {data, kernel}, {a_buf, b_buf, c_buf}, {}, stmts[0], stmts[1], stmts[2]);
+}
+
+}  // namespace arm_cpu
+}  // namespace topi
+}  // namespace tvm
+#endif  // TVM_TOPI_ARM_CPU_TENSOR_INTRIN_H_
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief External function interface to the OpenCL kernels of the runtime
+ * \file opencl.h
+ */
+#ifndef TVM_TOPI_CONTRIB_OPENCL_H_
+#define TVM_TOPI_CONTRIB_OPENCL_H_
+
+#include <tvm/te/operation.h>
+#include <tvm/topi/detail/extern.h>
+
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace topi {
+namespace contrib {
+
+using namespace tvm::te;
+using namespace topi::detail;
+
+/*!
+ * \brief Whether the OpenCL sort supports keys of `key` and indices of `index`
+ */
+inline bool opencl_sort_supported(DataType key, DataType index) {
+  return (key == DataType::Float(32) || key == DataType::Int(32)) &&
+         (index == DataType::Int(32) || index == DataType::Int(64) ||
+          index == DataType::Float(32));
+}
+
+/*!
+ * \brief Create an op that sorts data along an axis with the OpenCL sort
+ *
+ * \param data The input tensor
+ * \param axis The sorted axis
+ * \param is_ascend Whether to sort in ascending order
+ *
+ * \return The sorted tensor
+ */
+inline Tensor opencl_sort(const Tensor& data, int axis, bool is_ascend) {
+  return make_extern(
+      {data->shape}, {data->dtype}, {data},
+      [&](Array<Buffer> ins, Array<Buffer> outs) {
+        return call_packed({StringImm("tvm.contrib.opencl.sort"), pack_buffer(ins[0]),
+                            pack_buffer(outs[0]), axis, is_ascend});
+      },
+      "sort_opencl", "sort_opencl", {})[0];
+}
+
+/*!
+ * \brief Create an op that gives the indices sorting data along an axis with the OpenCL sort
+ *
+ * \param data The input tensor
+ * \param axis The sorted axis
+ * \param is_ascend Whether to sort in ascending order
+ * \param dtype The type of the indices
+ *
+ * \return The indices of the sorted elements
+ */
+inline Tensor opencl_argsort(const Tensor& data, int axis, bool is_ascend, DataType dtype) {
+  return make_extern(
+      {data->shape}, {dtype}, {data},
+      [&](Array<Buffer> ins, Array<Buffer> outs) {
+        return call_packed({StringImm("tvm.contrib.opencl.argsort"), pack_buffer(ins[0]),
+                            pack_buffer(outs[0]), axis, is_ascend});
+      },
+      "argsort_opencl", "argsort_opencl", {})[0];
+}
+
+/*!
+ * \brief Create an op that gives the first k elements of data sorted along an axis with the
+ *  OpenCL sort
+ *
+ * \param data The input tensor
+ * \param k The number of elements, the whole axis when less than 1
+ * \param axis The sorted axis
+ * \param ret_type One of "both", "values" and "indices"
+ * \param is_ascend Whether to sort in ascending order
+ * \param dtype The type of the indices
+ *
+ * \return The values and/or the indices, as asked by ret_type
+ */
+inline Array<Tensor> opencl_topk(const Tensor& data, int k, int axis, const std::string& ret_type,
+                                 bool is_ascend, DataType dtype) {
+  int ndim = static_cast<int>(data->shape.size());
+  int real_axis = axis < 0 ? axis + ndim : axis;
+  Array<PrimExpr> out_shape = data->shape;
+  if (k >= 1) out_shape.Set(real_axis, k);
+  Array<Array<PrimExpr>> out_shapes;
+  std::vector<DataType> out_types;
+  if (ret_type != "indices") {
+    out_shapes.push_back(out_shape);
+    out_types.push_back(data->dtype);
+  }
+  if (ret_type != "values") {
+    out_shapes.push_back(out_shape);
+    out_types.push_back(dtype);
+  }
+  return make_extern(
+      out_shapes, out_types, {data},
+      [&](Array<Buffer> ins, Array<Buffer> outs) {
+        Array<PrimExpr> args{StringImm("tvm.contrib.opencl.topk"), pack_buffer(ins[0])};
+        for (const Buffer& out : outs) {
+          args.push_back(pack_buffer(out));
+        }
+        args.push_back(k);
+        args.push_back(axis);
+        args.push_back(StringImm(ret_type));
+        args.push_back(is_ascend);
+        return call_packed(args);
+      },
+      "topk_opencl", "topk_opencl", {});
+}
+
+/*!
+ * \brief Create an op that moves the valid boxes to the top with the OpenCL get_valid_counts
+ *
+ * \param data The boxes, float32 of shape [batch, num_anchors, elem_length]
+ * \param score_threshold The float32 scalar lower limit of the valid scores
+ * \param id_index The index of the class id in a box, negative without one
+ * \param score_index The index of the score in a box
+ *
+ * \return The valid count of every batch, the valid boxes and their indices in data
+ */
+inline Array<Tensor> opencl_get_valid_counts(const Tensor& data, const Tensor& score_threshold,
+                                             int id_index, int score_index) {
+  return make_extern(
+      {{data->shape[0]}, data->shape, {data->shape[0], data->shape[1]}},
+      {DataType::Int(32), data->dtype, DataType::Int(32)}, {data, score_threshold},
+      [&](Array<Buffer> ins, Array<Buffer> outs) {
+        return call_packed({StringImm("tvm.contrib.opencl.get_valid_counts"), pack_buffer(ins[0]),
+                            ins[1]->data, id_index, score_index, pack_buffer(outs[0]),
+                            pack_buffer(outs[1]), pack_buffer(outs[2])});
+      },
+      "get_valid_counts_opencl", "get_valid_counts_opencl", {});
+}
+
+/*!
+ * \brief Create an op that suppresses the overlapping boxes with the OpenCL non_max_suppression
+ *
+ * \param data The boxes, float32 of shape [batch, num_anchors, elem_length]
+ * \param valid_count The int32 number of valid boxes of every batch
+ * \param max_output_size The int32 scalar maximum number of kept boxes, non-positive for all
+ * \param iou_threshold The float32 scalar overlap above which a box is suppressed
+ * \param force_suppress Whether to suppress boxes of different classes
+ * \param top_k The number of boxes considered, non-positive for all
+ * \param coord_start The index of the first coordinate in a box
+ * \param score_index The index of the score in a box
+ * \param id_index The index of the class id in a box, negative without one
+ * \param invalid_to_bottom Whether to move the kept boxes to the top
+ *
+ * \return The boxes with the suppressed ones marked by -1
+ */
+inline Tensor opencl_non_max_suppression(const Tensor& data, const Tensor& valid_count,
+                                         const Tensor& max_output_size,
+                                         const Tensor& iou_threshold, bool force_suppress,
+                                         int top_k, int coord_start, int score_index,
+                                         int id_index, bool invalid_to_bottom) {
+  return make_extern(
+      {data->shape}, {data->dtype}, {data, valid_count, max_output_size, iou_threshold},
+      [&](Array<Buffer> ins, Array<Buffer> outs) {
+        return call_packed({StringImm("tvm.contrib.opencl.non_max_suppression"),
+                            pack_buffer(ins[0]), pack_buffer(ins[1]), ins[2]->data, ins[3]->data,
+                            force_suppress, top_k, coord_start, score_index, id_index,
+                            invalid_to_bottom, pack_buffer(outs[0])});
+      },
+      "non_max_suppression_opencl", "non_max_suppression_opencl", {})[0];
+}
+
+}  // namespace contrib
+}  // namespace topi
+}  // namespace tvm
+
+#endif  // TVM_TOPI_CONTRIB_OPENCL_H_
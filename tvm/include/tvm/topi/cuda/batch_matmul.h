@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file cuda/batch_matmul.h
+ * \brief CUDA schedule for batch_matmul operation
+ */
+#ifndef TVM_TOPI_CUDA_BATCH_MATMUL_H_
+#define TVM_TOPI_CUDA_BATCH_MATMUL_H_
+
+#include <tvm/target/generic_func.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule_pass.h>
+#include <tvm/topi/cuda/injective.h>
+#include <tvm/topi/detail/array_utils.h>
+#include <tvm/topi/detail/fuse.h>
+#include <tvm/topi/nn/batch_matmul.h>
+#include <tvm/topi/tags.h>
+
+namespace tvm {
+namespace topi {
+
+using namespace tvm::te;
+
+namespace cuda {
+
+/*!
+ * \brief Create a CUDA schedule for batch_matmul
+ *
+ * Every thread computes a 4x4 tile of the output in registers. The inputs are staged through
+ * shared memory, or local memory on OpenCL, in tiles along K that the threads of a block fetch
+ * together with vectorized loads. The 8 and 16 bit inputs fetch 4 elements per load and the 8
+ * bit ones take longer K tiles, so that a load moves at least 32 bits.
+ *
+ * \param target The target to generate a schedule for.
+ * \param outs The output tensors.
+ *
+ * \return A schedule for the given ops.
+ */
+inline Schedule schedule_batch_matmul(const Target& target, const Array<Tensor>& outs) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+
+  auto _schedule = [&](const Tensor& bmm, bool fuse_epilogue) {
+    const int num_thread = 8;
+    const int tile = 4;
+    Array<Tensor> inputs = bmm->op->InputTensors();
+    ICHECK_EQ(inputs.size(), 2) << "The batch_matmul schedule expects two distinct inputs";
+    Tensor A = inputs[0];
+    Tensor B = inputs[1];
+    // The layout transforms in front of the matmul, e.g. those of einsum, are read in place
+    for (const Tensor& t : {A, B}) {
+      if (t->op.as<ComputeOpNode>() && is_injective(t->op->tag) &&
+          !detail::contains(s->outputs, t->op)) {
+        s[t].compute_inline();
+      }
+    }
+    int bits = A->dtype.bits();
+    int vec = bits <= 16 ? 4 : 1;
+    int k_tile = bits <= 8 ? 16 : 8;
+
+    auto AS = s.cache_read(A, "shared", {bmm->op});
+    auto AL = s.cache_read(AS, "local", {bmm->op});
+    auto BS = s.cache_read(B, "shared", {bmm->op});
+    auto BL = s.cache_read(BS, "local", {bmm->op});
+    auto CC = s.cache_write(bmm, "local");
+    Tensor out = bmm;
+    if (fuse_epilogue && !detail::contains(s->outputs, bmm->op)) {
+      s[bmm].compute_inline();
+      out = outs[0]->op.output(0);
+    }
+
+    auto block_x = tvm::te::thread_axis(Range(), "blockIdx.x");
+    auto block_y = tvm::te::thread_axis(Range(), "blockIdx.y");
+    auto block_z = tvm::te::thread_axis(Range(), "blockIdx.z");
+    auto thread_x = tvm::te::thread_axis(Range(0, num_thread), "threadIdx.x");
+    auto thread_y = tvm::te::thread_axis(Range(0, num_thread), "threadIdx.y");
+
+    auto out_axis = s[out]->op.as<ComputeOpNode>()->axis;
+    IterVar by, yt, ty, yi, bx, xt, tx, xi;
+    s[out].split(out_axis[1], num_thread * tile, &by, &yt);
+    s[out].split(yt, tile, &ty, &yi);
+    s[out].split(out_axis[2], num_thread * tile, &bx, &xt);
+    s[out].split(xt, tile, &tx, &xi);
+    s[out].reorder({out_axis[0], by, bx, ty, tx, yi, xi});
+    s[out].bind(out_axis[0], block_z);
+    s[out].bind(by, block_y);
+    s[out].bind(bx, block_x);
+    s[out].bind(ty, thread_y);
+    s[out].bind(tx, thread_x);
+
+    s[CC].compute_at(s[out], tx);
+    auto cc_axis = s[CC]->op.as<ComputeOpNode>()->axis;
+    IterVar ko, ki;
+    s[CC].split(s[CC]->op.as<ComputeOpNode>()->reduce_axis[0], k_tile, &ko, &ki);
+    s[CC].reorder({ko, ki, cc_axis[1], cc_axis[2]});
+    s[CC].unroll(ki);
+
+    for (const Tensor& shared : {AS, BS}) {
+      s[shared].compute_at(s[CC], ko);
+      IterVar fused = detail::Fuse(s[shared], s[shared]->op.as<ComputeOpNode>()->axis);
+      IterVar fo, fv, fy, fx;
+      s[shared].split(fused, vec, &fo, &fv);
+      s[shared].split(fo, num_thread, &fy, &fx);
+      IterVar fyo, fyi;
+      s[shared].split(fy, num_thread, &fyo, &fyi);
+      s[shared].bind(fyi, thread_y);
+      s[shared].bind(fx, thread_x);
+      s[shared].vectorize(fv);
+    }
+    s[AL].compute_at(s[CC], ki);
+    s[BL].compute_at(s[CC], ki);
+  };
+
+  // Whether the output is an elementwise function of the matmul, which runs in its kernel
+  std::function<bool(Operation)> elemwise_of_matmul;
+  elemwise_of_matmul = [&](const Operation& op) {
+    if (op->tag == "batch_matmul") return true;
+    if (!is_broadcast(op->tag)) return false;
+    for (auto tensor : op->InputTensors()) {
+      if (tensor->op->InputTensors().size() > 0 && !elemwise_of_matmul(tensor->op)) return false;
+    }
+    return true;
+  };
+  bool fuse_epilogue = elemwise_of_matmul(outs[0]->op);
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    if (is_injective(op->tag)) {
+      // Layout transforms after the matmul, e.g. those of einsum, run in their own kernel
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      } else if (!fuse_epilogue) {
+        schedule_injective_from_existing(s, op.output(0));
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == "batch_matmul") {
+      _schedule(op.output(0), fuse_epilogue);
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
+}  // namespace cuda
+}  // namespace topi
+}  // namespace tvm
+#endif  // TVM_TOPI_CUDA_BATCH_MATMUL_H_
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file cuda/depthwise_conv2d.h
+ * \brief CUDA schedule for depthwise conv2d operations
+ */
+#ifndef TVM_TOPI_CUDA_DEPTHWISE_CONV2D_H_
+#define TVM_TOPI_CUDA_DEPTHWISE_CONV2D_H_
+
+#include <tvm/target/generic_func.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule_pass.h>
+#include <tvm/topi/detail/array_utils.h>
+#include <tvm/topi/detail/fuse.h>
+#include <tvm/topi/tags.h>
+
+namespace tvm {
+namespace topi {
+
+using namespace tvm::te;
+
+namespace cuda {
+
+/*!
+ * \brief Create a CUDA schedule for depthwise conv2d in NCHW4c layout
+ *
+ * Every work item computes one texel of several consecutive output rows. The input texels of
+ * the rows and the weights of the window are loaded once into registers, as whole texels, and
+ * reused across the window and the rows. Elementwise epilogues, e.g. bias and relu6, are fused
+ * into the kernel.
+ *
+ * \param target The target to generate a schedule for.
+ * \param outs The output tensors.
+ *
+ * \return A schedule for the given ops.
+ */
+inline Schedule schedule_depthwise_conv2d_NCHW4c(const Target& target, const Array<Tensor>& outs) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+
+  auto _schedule = [&](const Tensor& conv) {
+    const int rows = 4;
+    const int num_thread_x = 16;
+    const int num_thread_y = 4;
+    Tensor data = conv->op->InputTensors()[0];
+    Tensor kernel = conv->op->InputTensors()[1];
+    // The padding is read through the guards of the register loads
+    if (data->op.as<ComputeOpNode>() && !detail::contains(s->outputs, data->op)) {
+      s[data].compute_inline();
+    }
+
+    auto DL = s.cache_read(data, "local", {conv->op});
+    auto WL = s.cache_read(kernel, "local", {conv->op});
+    Tensor CC;
+    Tensor out;
+    if (detail::contains(s->outputs, conv->op)) {
+      CC = s.cache_write(conv, "local");
+      out = conv;
+    } else {
+      s[conv].set_scope("local");
+      CC = conv;
+      out = outs[0]->op.output(0);
+    }
+
+    auto out_axis = s[out]->op.as<ComputeOpNode>()->axis;
+    IterVar ho, hi, by, ty, bx, tx;
+    s[out].split(out_axis[2], rows, &ho, &hi);
+    s[out].split(ho, num_thread_y, &by, &ty);
+    s[out].split(out_axis[3], num_thread_x, &bx, &tx);
+    IterVar bz = detail::Fuse(s[out], {out_axis[0], out_axis[1]});
+    s[out].reorder({bz, by, bx, ty, tx, hi, out_axis[4]});
+    s[out].bind(bz, tvm::te::thread_axis(Range(), "blockIdx.z"));
+    s[out].bind(by, tvm::te::thread_axis(Range(), "blockIdx.y"));
+    s[out].bind(bx, tvm::te::thread_axis(Range(), "blockIdx.x"));
+    s[out].bind(ty, tvm::te::thread_axis(Range(0, num_thread_y), "threadIdx.y"));
+    s[out].bind(tx, tvm::te::thread_axis(Range(0, num_thread_x), "threadIdx.x"));
+    s[out].unroll(hi);
+    s[out].vectorize(out_axis[4]);
+
+    s[CC].compute_at(s[out], tx);
+    const auto* cc_op = s[CC]->op.as<ComputeOpNode>();
+    s[CC].reorder({cc_op->reduce_axis[0], cc_op->reduce_axis[1], cc_op->axis[2], cc_op->axis[4]});
+    s[CC].unroll(cc_op->reduce_axis[0]);
+    s[CC].unroll(cc_op->reduce_axis[1]);
+    s[CC].unroll(cc_op->axis[2]);
+    s[CC].vectorize(cc_op->axis[4]);
+
+    // The input window of all the rows of a work item, and the weights, as whole texels
+    for (const Tensor& cache : {DL, WL}) {
+      s[cache].compute_at(s[out], tx);
+      s[cache].vectorize(s[cache]->op.as<ComputeOpNode>()->axis[4]);
+    }
+  };
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    if (is_broadcast(op->tag)) {
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == kDepthwiseConv2dNCHW4c) {
+      _schedule(op.output(0));
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
+}  // namespace cuda
+}  // namespace topi
+}  // namespace tvm
+#endif  // TVM_TOPI_CUDA_DEPTHWISE_CONV2D_H_
@@ -19,7 +19,7 @@
 
 /*!
  * \file cuda/normalization.h
- * \brief CUDA schedule for LRN and l2 normalization operations
+ * \brief CUDA schedule for LRN, l2 and layer normalization operations
  */
 #ifndef TVM_TOPI_CUDA_NORMALIZATION_H_
 #define TVM_TOPI_CUDA_NORMALIZATION_H_
@@ -27,8 +27,12 @@
 #include <tvm/target/generic_func.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule_pass.h>
+#include <tvm/topi/detail/fuse.h>
 #include <tvm/topi/tags.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace tvm {
 namespace topi {
 
@@ -69,6 +73,94 @@ inline Schedule schedule_lrn(const Array<Tensor>& outs) {
   return s;
 }
 
+/*! \brief The input of a normalization computed by its row reduction. */
+inline Tensor FindRowReduction(const Tensor& out) {
+  for (const Tensor& t : out->op->InputTensors()) {
+    const auto* op = t->op.as<ComputeOpNode>();
+    if (op != nullptr && !op->reduce_axis.empty()) return t;
+  }
+  LOG(FATAL) << "No row reduction in the inputs of " << out->op->name;
+  return Tensor();
+}
+
+/*!
+ * \brief Schedule a normalization over a row reduction as one kernel. Every row is one block,
+ *  whose threads reduce the row cooperatively and then normalize it, so that the row is read
+ *  once per stage and the statistics never leave the block.
+ *
+ * \param sch The schedule to update.
+ * \param out The normalized output, with the attr "axis" of its normalized axes.
+ * \param red An output of the reduction, reducing the normalized axes of out.
+ * \param num_thread The number of threads per block.
+ */
+inline void ScheduleRowNormalize(Schedule sch, const Tensor& out, const Tensor& red,
+                                 int num_thread) {
+  auto block_x = tvm::te::thread_axis(Range(), "blockIdx.x");
+  auto thread_x = tvm::te::thread_axis(Range(0, num_thread), "threadIdx.x");
+  const auto* out_op = out->op.as<ComputeOpNode>();
+  std::vector<int> red_axis;
+  ObjectRef axis = out_op->attrs.at("axis");
+  if (const auto* imm = axis.as<IntImmNode>()) {
+    red_axis.push_back(static_cast<int>(imm->value));
+  } else {
+    for (const Integer& i : Downcast<Array<Integer>>(axis)) {
+      red_axis.push_back(static_cast<int>(i->value));
+    }
+  }
+
+  // The threads of a block reduce a row together
+  IterVar k = detail::Fuse(sch[red], red->op.as<ComputeOpNode>()->reduce_axis);
+  IterVar ko, ki;
+  sch[red].split(k, num_thread, &ko, &ki);
+  auto rf = sch.rfactor(red, ki)[0];
+  IterVar tx = sch[red]->op.as<ComputeOpNode>()->reduce_axis[0];
+  sch[red].bind(tx, thread_x);
+  sch[rf].compute_at(sch[red], tx);
+  sch[red].set_store_predicate(thread_x->var == 0);
+
+  // The rows of the output are the blocks, the threads normalize consecutive elements
+  Array<IterVar> row_axes, col_axes;
+  for (size_t i = 0; i < out_op->axis.size(); ++i) {
+    if (std::count(red_axis.begin(), red_axis.end(), static_cast<int>(i))) {
+      col_axes.push_back(out_op->axis[i]);
+    } else {
+      row_axes.push_back(out_op->axis[i]);
+    }
+  }
+  Array<IterVar> order = row_axes;
+  for (const IterVar& iv : col_axes) order.push_back(iv);
+  sch[out].reorder(order);
+  IterVar row = detail::Fuse(sch[out], row_axes);
+  IterVar col = detail::Fuse(sch[out], col_axes);
+  IterVar co, ci;
+  sch[out].split(col, num_thread, &co, &ci);
+  sch[out].bind(row, block_x);
+  sch[out].bind(ci, thread_x);
+  sch[red].compute_at(sch[out], row);
+}
+
+/*!
+ * \brief Create a CUDA schedule for layer normalization
+ *
+ * \param target The target to generate a schedule for.
+ * \param outs The output tensors.
+ *
+ * \return A schedule for the given ops.
+ */
+inline Schedule schedule_layer_norm(const Target& target, const Array<Tensor>& outs) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  Schedule s = create_schedule(out_ops);
+  int num_thread = target->GetAttr<Integer>("max_num_threads").value();
+  num_thread = std::min(num_thread, 256);
+  Tensor out = outs[0];
+  ICHECK_EQ(out->op.as<ComputeOpNode>()->tag, "layer_norm_output");
+  ScheduleRowNormalize(s, out, FindRowReduction(out), num_thread);
+  return s;
+}
+
 }  // namespace cuda
 }  // namespace topi
 }  // namespace tvm
@@ -181,6 +181,68 @@ inline Schedule schedule_global_pool(const Target& target, const Array<Tensor>&
   return s;
 }
 
+/*!
+ * \brief Create a CUDA schedule for global_pool_multistage, also used by the other GPU
+ *  targets. Both reduction stages spread their outputs over all the threads, so the chunks of
+ *  every channel are reduced in parallel before the final reduction.
+ *
+ * \param target The target to generate a schedule for.
+ * \param outs The output tensors.
+ *
+ * \return A schedule for the given ops.
+ */
+inline Schedule schedule_global_pool_multistage(const Target& target, const Array<Tensor>& outs) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+  int num_thread = target->GetAttr<Integer>("max_num_threads").value();
+
+  auto bind_fused = [&](Stage stage) {
+    auto fused = detail::Fuse(stage, stage->op.as<ComputeOpNode>()->axis);
+    IterVar bx, tx;
+    stage.split(fused, num_thread, &bx, &tx);
+    stage.bind(bx, tvm::te::thread_axis(Range(), "blockIdx.x"));
+    stage.bind(tx, tvm::te::thread_axis(Range(), "threadIdx.x"));
+    return tx;
+  };
+
+  auto _schedule = [&](const Tensor& pool) {
+    Tensor partial = pool->op->InputTensors()[0];
+    bind_fused(s[partial]);
+    if (detail::contains(s->outputs, pool->op)) {
+      bind_fused(s[pool]);
+    } else {
+      s[pool].set_scope("local");
+      IterVar tx = bind_fused(s[outs[0]]);
+      s[pool].compute_at(s[outs[0]], tx);
+    }
+  };
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    // Inline all one-to-one-mapping operators except the last stage (output)
+    if (is_broadcast(op->tag)) {
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == "global_pool_multistage") {
+      _schedule(op.output(0));
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
 }  // namespace cuda
 }  // namespace topi
 }  // namespace tvm
@@ -27,9 +27,12 @@
 #include <tvm/target/generic_func.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule_pass.h>
+#include <tvm/topi/cuda/normalization.h>
 #include <tvm/topi/detail/fuse.h>
 #include <tvm/topi/tags.h>
 
+#include <algorithm>
+
 namespace tvm {
 namespace topi {
 
@@ -97,6 +100,29 @@ inline Schedule schedule_softmax(const Target& target, const Array<Tensor>& outs
   return s;
 }
 
+/*!
+ * \brief Create a CUDA schedule for the given online softmax output tensors. Every row is
+ *  reduced and normalized by one block, in a single kernel.
+ *
+ * \param target The target to generate a schedule for.
+ * \param outs The output tensors.
+ *
+ * \return A schedule for the given ops.
+ */
+inline Schedule schedule_online_softmax(const Target& target, const Array<Tensor>& outs) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+  int num_thread = target->GetAttr<Integer>("max_num_threads").value();
+  num_thread = std::min(num_thread, 256);
+  auto softmax = outs[0];
+  ICHECK_EQ(softmax->op.as<ComputeOpNode>()->tag, "online_softmax_output");
+  ScheduleRowNormalize(s, softmax, FindRowReduction(softmax), num_thread);
+  return s;
+}
+
 }  // namespace cuda
 }  // namespace topi
 }  // namespace tvm
@@ -33,7 +33,10 @@
 #include <tvm/topi/detail/constant_utils.h>
 #include <tvm/topi/detail/ravel_unravel.h>
 #include <tvm/topi/detail/tensor_utils.h>
+#include <tvm/topi/nn/batch_matmul.h>
+#include <tvm/topi/nn/dense.h>
 #include <tvm/topi/tags.h>
+#include <tvm/topi/transform.h>
 
 #include <algorithm>
 #include <bitset>
@@ -938,6 +941,122 @@ inline Tensor einsum(const std::string& subscripts_str, const Array<Tensor> inpu
   return compute(oshape, func, name, tag);
 }
 
+/*!
+ * \brief Express a two operand einsum as a matrix product, a batch_matmul or a dense between
+ *  layout transforms, so that it runs with the tuned matmul schedules instead of the generic
+ *  einsum compute.
+ *
+ * Every label of the subscripts falls in one of the groups batch (both operands and the output),
+ * M (the first operand and the output), N (the second operand and the output) and K (both
+ * operands only). The operands are transposed and reshaped to [batch, M, K] and [batch, N, K],
+ * and the product is reshaped and transposed to the output labels.
+ *
+ * \param subscripts_str The subscripts of the einsum.
+ * \param inputs The two operands.
+ * \param out_dtype The output data type. Used for mixed precision.
+ *
+ * \return The einsum, or an undefined Tensor when the subscripts use ellipses, repeated labels,
+ *  labels summed over one operand only or broadcast dimensions.
+ */
+inline Tensor einsum_as_matmul(const std::string& subscripts_str, const Array<Tensor>& inputs,
+                               DataType out_dtype) {
+  std::string subscripts = subscripts_str;
+  subscripts.erase(std::remove(subscripts.begin(), subscripts.end(), ' '), subscripts.end());
+  if (inputs.size() != 2 || subscripts.find('.') != std::string::npos) return Tensor();
+  size_t arrow = subscripts.find("->");
+  std::string in_labels = subscripts.substr(0, arrow);
+  size_t comma = in_labels.find(',');
+  if (comma == std::string::npos) return Tensor();
+  std::string a = in_labels.substr(0, comma);
+  std::string b = in_labels.substr(comma + 1);
+  if (a.size() != inputs[0]->shape.size() || b.size() != inputs[1]->shape.size()) {
+    return Tensor();
+  }
+  std::string out;
+  if (arrow != std::string::npos) {
+    out = subscripts.substr(arrow + 2);
+  } else {
+    // Without an output, the labels which appear once in alphabetical order
+    for (char c : a + b) {
+      if (CountSubstring(a + b, std::string(1, c)) == 1) out.push_back(c);
+    }
+    std::sort(out.begin(), out.end());
+  }
+  for (const std::string& labels : {a, b, out}) {
+    if (Str2Set(labels).count() != labels.size()) return Tensor();
+  }
+
+  std::string batch, m, n, k;
+  for (char c : out) {
+    bool in_a = a.find(c) != std::string::npos;
+    bool in_b = b.find(c) != std::string::npos;
+    if (in_a && in_b) {
+      batch.push_back(c);
+    } else if (in_a) {
+      m.push_back(c);
+    } else if (in_b) {
+      n.push_back(c);
+    } else {
+      return Tensor();
+    }
+  }
+  for (char c : a) {
+    if (out.find(c) != std::string::npos) continue;
+    if (b.find(c) == std::string::npos) return Tensor();
+    k.push_back(c);
+  }
+  for (char c : b) {
+    if (out.find(c) == std::string::npos && a.find(c) == std::string::npos) return Tensor();
+  }
+  for (char c : batch + k) {
+    if (!EqualCheck(inputs[0]->shape[a.find(c)], inputs[1]->shape[b.find(c)])) return Tensor();
+  }
+
+  auto dims = [&](const std::string& labels) {
+    Array<PrimExpr> shape;
+    for (char c : labels) {
+      size_t i = a.find(c);
+      shape.push_back(i != std::string::npos ? inputs[0]->shape[i] : inputs[1]->shape[b.find(c)]);
+    }
+    return shape;
+  };
+  auto size = [&](const std::string& labels) {
+    PrimExpr prod = make_const(DataType::Int(32), 1);
+    for (const PrimExpr& dim : dims(labels)) prod = prod * dim;
+    return prod;
+  };
+  // Transpose t from the labels from to the labels to, unless they are in the same order
+  auto permute = [](const Tensor& t, const std::string& from, const std::string& to) {
+    if (from == to) return t;
+    Array<Integer> axes;
+    for (char c : to) axes.push_back(static_cast<int>(from.find(c)));
+    return transpose(t, axes);
+  };
+  // The operands are already 2-D or 3-D matrices when every group has one label
+  bool is_matrix = m.size() == 1 && n.size() == 1 && k.size() == 1 && batch.size() <= 1;
+
+  Tensor x = permute(inputs[0], a, batch + m + k);
+  Tensor y = permute(inputs[1], b, batch + n + k);
+  Tensor result;
+  if (batch.empty()) {
+    if (!is_matrix) {
+      x = reshape(x, {size(m), size(k)});
+      y = reshape(y, {size(n), size(k)});
+    }
+    result = nn::dense(x, y, Tensor(), out_dtype);
+  } else {
+    if (!is_matrix) {
+      x = reshape(x, {size(batch), size(m), size(k)});
+      y = reshape(y, {size(batch), size(n), size(k)});
+    }
+    result = nn::batch_matmul(x, y, out_dtype);
+  }
+  if (!is_matrix) {
+    result = reshape(result, dims(batch + m + n));
+  }
+  return permute(result, batch + m + n, out);
+}
+
 }  // namespace topi
 }  // namespace tvm
 #endif  // TVM_TOPI_EINSUM_H_
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief YUV to RGB conversion of camera frames
+ * \file image/yuv_to_rgb.h
+ */
+#ifndef TVM_TOPI_IMAGE_YUV_TO_RGB_H_
+#define TVM_TOPI_IMAGE_YUV_TO_RGB_H_
+
+#include <tvm/te/operation.h>
+#include <tvm/topi/tags.h>
+
+#include <string>
+
+namespace tvm {
+namespace topi {
+namespace image {
+
+using namespace tvm::te;
+
+/*!
+ * \brief Convert YUV 4:2:0 semi-planar frames to normalized RGB images.
+ *
+ *  Every output pixel samples the nearest pixel of the frame, which is scaled to the output
+ *  size, and converts it with the BT.601 full range coefficients. Channel c is then written
+ *  as (rgb / 255 - mean[c]) / stddev[c].
+ *
+ * \param data The uint8 frames of shape (batch, height * 3 / 2, width), the luma rows
+ *  followed by the rows of interleaved chroma.
+ * \param size The output height and width, empty for the size of the frame.
+ * \param format "NV21" for chroma in V, U order, "NV12" for U, V.
+ * \param layout The output layout, "NCHW", "NHWC" or "NCHW4c", whose fourth channel is zero.
+ * \param mean The means of the three channels.
+ * \param stddev The standard deviations of the three channels.
+ * \param out_dtype The output data type.
+ * \param name The name of the operation
+ * \param tag The tag to mark the operation
+ *
+ * \return A Tensor of the images in the output layout
+ */
+inline Tensor yuv_to_rgb(const Tensor& data, const Array<PrimExpr>& size,
+                         const std::string& format, const std::string& layout,
+                         const Array<FloatImm>& mean, const Array<FloatImm>& stddev,
+                         DataType out_dtype, std::string name = "T_yuv_to_rgb",
+                         std::string tag = kInjective) {
+  ICHECK_EQ(data->shape.size(), 3) << "The frames should be of shape (batch, height * 3 / 2, "
+                                      "width)";
+  ICHECK(format == "NV21" || format == "NV12") << "Unsupported YUV format " << format;
+  ICHECK(mean.size() == 3 && stddev.size() == 3)
+      << "Expect the mean and standard deviation of three channels";
+  PrimExpr in_h = indexdiv(data->shape[1] * 2, 3);
+  PrimExpr in_w = data->shape[2];
+  PrimExpr out_h = size.empty() ? in_h : size[0];
+  PrimExpr out_w = size.empty() ? in_w : size[1];
+  bool v_first = format == "NV21";
+
+  auto color = [&](const PrimExpr& n, const PrimExpr& c, const PrimExpr& y, const PrimExpr& x) {
+    auto nearest = [](const PrimExpr& dst, const PrimExpr& dst_size, const PrimExpr& src_size) {
+      PrimExpr src = floor((cast(DataType::Float(32), dst) + 0.5f) *
+                           cast(DataType::Float(32), src_size) /
+                           cast(DataType::Float(32), dst_size));
+      return min(cast(src_size.dtype(), src), src_size - 1);
+    };
+    PrimExpr sy = nearest(y, out_h, in_h);
+    PrimExpr sx = nearest(x, out_w, in_w);
+    auto at = [&](const PrimExpr& row, const PrimExpr& col) {
+      return cast(DataType::Float(32), data(n, row, col));
+    };
+    PrimExpr chroma_row = in_h + indexdiv(sy, 2);
+    PrimExpr chroma_col = indexdiv(sx, 2) * 2;
+    PrimExpr luma = at(sy, sx);
+    PrimExpr cr = at(chroma_row, v_first ? chroma_col : chroma_col + 1) - 128.0f;
+    PrimExpr cb = at(chroma_row, v_first ? chroma_col + 1 : chroma_col) - 128.0f;
+    PrimExpr rgb[3] = {luma + 1.402f * cr, luma - 0.344136f * cb - 0.714136f * cr,
+                       luma + 1.772f * cb};
+    PrimExpr out[3];
+    for (int i = 0; i < 3; ++i) {
+      PrimExpr value = max(min(rgb[i], 255.0f), 0.0f) / 255.0f;
+      out[i] = (value - static_cast<float>(mean[i]->value)) *
+               static_cast<float>(1.0 / stddev[i]->value);
+    }
+    PrimExpr value = if_then_else(c == 0, out[0], if_then_else(c == 1, out[1], out[2]));
+    return cast(out_dtype, value);
+  };
+
+  PrimExpr batch = data->shape[0];
+  if (layout == "NCHW") {
+    return compute(
+        {batch, 3, out_h, out_w},
+        [&](const Array<Var>& i) { return color(i[0], i[1], i[2], i[3]); }, name, tag);
+  } else if (layout == "NHWC") {
+    return compute(
+        {batch, out_h, out_w, 3},
+        [&](const Array<Var>& i) { return color(i[0], i[3], i[1], i[2]); }, name, tag);
+  }
+  ICHECK_EQ(layout, "NCHW4c") << "Unsupported layout " << layout;
+  return compute(
+      {batch, 1, out_h, out_w, 4},
+      [&](const Array<Var>& i) {
+        return if_then_else(i[4] < 3, color(i[0], i[4], i[2], i[3]), make_zero(out_dtype));
+      },
+      name, tag);
+}
+
+}  // namespace image
+}  // namespace topi
+}  // namespace tvm
+#endif  // TVM_TOPI_IMAGE_YUV_TO_RGB_H_
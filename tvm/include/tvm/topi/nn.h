@@ -410,6 +410,57 @@ inline tvm::te::Tensor depthwise_conv2d_nhwc(const tvm::te::Tensor& I, const tvm
   return tvm::te::compute(output_shape, l, name, tag);
 }
 
+/*!
+ * \brief Creates an operation that performs a 2-D depthwise convolution with
+ * an NCHW4c-layout, the channels packed by 4 into the texels of a texture
+ *
+ * \param I The 5-D input tensor [batch, channel / 4, height, width, 4]
+ * \param W The 5-D weight tensor [channel / 4, 1, kernel_h, kernel_w, 4]
+ * \param pad_h A static constant padding amount applied to the height of the
+ * image, before and after (symmetric padding)
+ * \param pad_w A static constant padding amount applied to the width of the
+ * image, before and after (symmetric padding)
+ * \param stride_h A static constant striding amount applied to the height of
+ * the image
+ * \param stride_w A static constant striding amount applied to the width of
+ * the image
+ * \param out_dtype The output data type. Used for mixed precision.
+ * \param name The name of the operation
+ * \param tag The tag to mark the operation
+ *
+ * \return A Tensor whose op member is the 2-D depthwise convolution operation
+ * (NCHW4c layout)
+ */
+inline tvm::te::Tensor depthwise_conv2d_NCHW4c(const tvm::te::Tensor& I, const tvm::te::Tensor& W,
+                                               int pad_h = 0, int pad_w = 0, int stride_h = 1,
+                                               int stride_w = 1, DataType out_dtype = DataType(),
+                                               std::string name = "T_depthwise_conv2d_NCHW4c",
+                                               std::string tag = kDepthwiseConv2dNCHW4c) {
+  ICHECK_EQ(5, I->shape.size());
+  ICHECK_EQ(5, W->shape.size());
+  ICHECK(tvm::tir::is_one(W->shape[1])) << "Only a channel multiplier of 1 is supported";
+  if (out_dtype.is_void()) out_dtype = I->dtype;
+  tvm::Array<tvm::PrimExpr> output_shape{
+      I->shape[0],                                                    // B
+      I->shape[1],                                                    // C / 4
+      indexdiv(I->shape[2] - W->shape[2] + 2 * pad_h, stride_h) + 1,  // H
+      indexdiv(I->shape[3] - W->shape[3] + 2 * pad_w, stride_w) + 1,  // W
+      I->shape[4]                                                     // 4
+  };
+  auto kh = tvm::te::reduce_axis(tvm::Range{0, W->shape[2]}, "kh");
+  auto kw = tvm::te::reduce_axis(tvm::Range{0, W->shape[3]}, "kw");
+  auto T = (pad_h == 0 && pad_w == 0)
+               ? I
+               : pad(I, {tvm::PrimExpr(0), tvm::PrimExpr(0), pad_h, pad_w, tvm::PrimExpr(0)});
+  auto l = [&](tvm::tir::Var b, tvm::tir::Var c, tvm::tir::Var h, tvm::tir::Var w,
+               tvm::tir::Var v) {
+    return tvm::sum(tvm::cast(out_dtype, T(b, c, stride_h * h + kh, stride_w * w + kw, v)) *
+                        tvm::cast(out_dtype, W(c, 0, kh, kw, v)),
+                    {kh, kw});
+  };
+  return tvm::te::compute(output_shape, l, name, tag);
+}
+
 /*!
  * \brief Creates an operation that performs a 2-D group convolution with
  * an NGCHW-layout
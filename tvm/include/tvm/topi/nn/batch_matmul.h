@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \brief Batch matmul op constructions
+ * \file nn/batch_matmul.h
+ */
+#ifndef TVM_TOPI_NN_BATCH_MATMUL_H_
+#define TVM_TOPI_NN_BATCH_MATMUL_H_
+
+#include <tvm/te/operation.h>
+#include <tvm/topi/detail/constant_utils.h>
+#include <tvm/topi/tags.h>
+
+#include <string>
+
+namespace tvm {
+namespace topi {
+namespace nn {
+
+using namespace tvm::te;
+
+/*!
+ * \brief Creates an operation that calculates matrix multiplication in batch, x * y^T.
+ *
+ * \param x Tensor with shape [batch, M, K]
+ * \param y Tensor with shape [batch, N, K]
+ * \param out_dtype Output data type. Used for mixed precision, e.g. int8 inputs with an int32
+ *  output.
+ *
+ * A batch of 1 in either input is broadcast to the batch of the other.
+ *
+ * \return Tensor with shape [batch, M, N]
+ */
+inline tvm::te::Tensor batch_matmul(const tvm::te::Tensor& x, const tvm::te::Tensor& y,
+                                    const DataType& out_dtype) {
+  ICHECK_EQ(x->shape.size(), 3) << "batch_matmul requires 3-D x";
+  ICHECK_EQ(y->shape.size(), 3) << "batch_matmul requires 3-D y";
+
+  auto x_batch = x->shape[0];
+  auto y_batch = y->shape[0];
+  bool x_bcast = detail::EqualCheck(x_batch, 1);
+  bool y_bcast = detail::EqualCheck(y_batch, 1);
+  auto batch = x_bcast ? y_batch : x_batch;
+  auto M = x->shape[1];
+  auto N = y->shape[1];
+  auto K = x->shape[2];
+
+  auto k = tvm::te::reduce_axis(Range(0, K), "k");
+  return tvm::te::compute(
+      {batch, M, N},
+      [&](Var b, Var i, Var j) {
+        PrimExpr xb = x_bcast ? make_zero(b.dtype()) : PrimExpr(b);
+        PrimExpr yb = y_bcast ? make_zero(b.dtype()) : PrimExpr(b);
+        return tvm::sum(tvm::cast(out_dtype, x(xb, i, k)) * tvm::cast(out_dtype, y(yb, j, k)),
+                        {k});
+      },
+      "T_batch_matmul", "batch_matmul");
+}
+
+}  // namespace nn
+}  // namespace topi
+}  // namespace tvm
+#endif  // TVM_TOPI_NN_BATCH_MATMUL_H_
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief Layer normalization op constructions
+ * \file nn/layer_norm.h
+ */
+#ifndef TVM_TOPI_NN_LAYER_NORM_H_
+#define TVM_TOPI_NN_LAYER_NORM_H_
+
+#include <tvm/te/operation.h>
+#include <tvm/topi/reduction.h>
+#include <tvm/topi/tags.h>
+
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace topi {
+namespace nn {
+
+using namespace tvm::te;
+
+/*!
+ * \brief Layer normalization, with the mean and the variance computed in a single pass.
+ *
+ * The count, mean and sum of squared deviations are one tuple reduction combined with
+ * Welford's update, accumulated in float32 for the lower precision inputs, so that the input
+ * is read once for the statistics and once for the normalization without the cancellation of
+ * the sum of squares minus the squared sum.
+ *
+ * \param data The input tensor.
+ * \param gamma The scale, with the shape of the normalized axes of data.
+ * \param beta The offset, with the shape of the normalized axes of data.
+ * \param axis The normalized axes.
+ * \param epsilon The epsilon added to the variance.
+ * \param name The name of the operation
+ * \param tag The tag to mark the operation
+ *
+ * \return A Tensor whose op member is the layer normalization operation
+ */
+inline Tensor layer_norm(const Tensor& data, const Tensor& gamma, const Tensor& beta,
+                         const Array<Integer>& axis, double epsilon,
+                         std::string name = "T_layer_norm",
+                         std::string tag = "layer_norm_output") {
+  auto ndim = data->shape.size();
+  auto real_axis = GetRealAxis(static_cast<int>(ndim), axis);
+  auto reduce_axes = MakeReduceAxes(real_axis, data);
+  auto reduced_shape = MakeReduceTargetShape(real_axis, data, false, false);
+  ICHECK_EQ(gamma->shape.size(), real_axis.size())
+      << "gamma should have the rank of the normalized axes";
+  ICHECK_EQ(beta->shape.size(), real_axis.size())
+      << "beta should have the rank of the normalized axes";
+
+  Array<Integer> attr_axis;
+  PrimExpr count = make_const(DataType::Float(32), 1);
+  for (int i : real_axis) {
+    attr_axis.push_back(i);
+    count = count * cast(DataType::Float(32), data->shape[i]);
+  }
+  tvm::Map<String, ObjectRef> attrs;
+  attrs.Set("axis", attr_axis);
+  attrs.Set("epsilon", FloatImm(DataType::Float(64), epsilon));
+
+  DataType acc_type = data->dtype.bits() < 32 ? DataType::Float(32) : data->dtype;
+  // (count, mean, m2) of two partitions, m2 being the sum of the squared deviations
+  auto fcombine = [](Array<Var> lhs, Array<Var> rhs) {
+    PrimExpr n = lhs[0] + rhs[0];
+    PrimExpr delta = rhs[1] - lhs[1];
+    PrimExpr ratio = rhs[0] / tvm::max(n, make_const(n.dtype(), 1));
+    PrimExpr m2 = lhs[2] + rhs[2] + delta * delta * lhs[0] * ratio;
+    return Array<PrimExpr>{n, lhs[1] + delta * ratio, m2};
+  };
+  auto fidentity = [](std::vector<DataType> types) {
+    return Array<PrimExpr>{make_zero(types[0]), make_zero(types[1]), make_zero(types[2])};
+  };
+  auto reducer = MakeCommReducer(fcombine, fidentity, "layer_norm");
+
+  auto moments = tvm::te::compute(
+      reduced_shape,
+      [&](const Array<Var>& indices) {
+        Array<PrimExpr> eval_range;
+        size_t arg_counter = 0, red_counter = 0;
+        for (size_t i = 0; i < ndim; ++i) {
+          if (red_counter < real_axis.size() && real_axis[red_counter] == static_cast<int>(i)) {
+            eval_range.push_back(reduce_axes[red_counter++]);
+          } else {
+            eval_range.push_back(indices[arg_counter++]);
+          }
+        }
+        PrimExpr value = cast(acc_type, data(eval_range));
+        return reducer({make_const(acc_type, 1), value, make_zero(acc_type)}, reduce_axes,
+                       nullptr);
+      },
+      data->op->name + "_moments", kCommReduce);
+  auto mean = moments[1];
+  auto m2 = moments[2];
+
+  return tvm::te::compute(
+      data->shape,
+      [&](const Array<Var>& indices) {
+        Array<PrimExpr> non_reduce_indices, reduce_indices;
+        size_t red_counter = 0;
+        for (size_t i = 0; i < ndim; ++i) {
+          if (red_counter < real_axis.size() && real_axis[red_counter] == static_cast<int>(i)) {
+            reduce_indices.push_back(indices[i]);
+            red_counter++;
+          } else {
+            non_reduce_indices.push_back(indices[i]);
+          }
+        }
+        PrimExpr var = m2(non_reduce_indices) / cast(acc_type, count);
+        PrimExpr normalized = (cast(acc_type, data(indices)) - mean(non_reduce_indices)) *
+                              tvm::rsqrt(var + make_const(acc_type, epsilon));
+        return cast(data->dtype, normalized) * gamma(reduce_indices) + beta(reduce_indices);
+      },
+      name, tag, attrs);
+}
+
+}  // namespace nn
+}  // namespace topi
+}  // namespace tvm
+#endif  // TVM_TOPI_NN_LAYER_NORM_H_
@@ -642,6 +642,69 @@ inline Tensor global_pool(const Tensor& x, PoolType pool_type, const std::string
   return adaptive_pool(x, Array<PrimExpr>{1, 1}, pool_type, layout);
 }
 
+/*!
+ * \brief Perform global pooling on height and width dimension of data in two reduction stages,
+ *        so that a GPU schedule can spread the reduction of every channel over many threads.
+ *        The first stage reduces the flattened spatial plane in chunks of chunk_size
+ *        elements into the height axis of a partial tensor, the second one reduces the chunks.
+ *        The inner axes of a packed layout, e.g. the 4 channels of a texel in NCHW4c, stay
+ *        innermost in both stages so that they can be vectorized.
+ *
+ * \param x The input tensor represent as layout
+ * \param pool_type The type of pooling operator
+ * \param layout The input layout, see \a global_pool.
+ * \param chunk_size The number of elements reduced by one partial of the first stage.
+ *
+ * \return The output tensor in same layout with height and width dimension size of 1.
+ */
+inline Tensor global_pool_multistage(const Tensor& x, PoolType pool_type,
+                                     const std::string& layout = "NCHW", int chunk_size = 64) {
+  int height_axis = -1, width_axis = -1;
+  ICHECK(find_height_width(layout, &height_axis, &width_axis)) << "Unsupported layout " << layout;
+  ICHECK(pool_type == kMaxPool || pool_type == kAvgPool) << "Unrecognized pool_type: " << pool_type;
+  ICHECK_GT(chunk_size, 0);
+  PrimExpr height = cast(DataType::Int(32), x->shape[height_axis]);
+  PrimExpr width = cast(DataType::Int(32), x->shape[width_axis]);
+  PrimExpr plane = height * width;
+  PrimExpr num_chunks = indexdiv(plane + chunk_size - 1, chunk_size);
+
+  Array<PrimExpr> partial_shape = x->shape;
+  partial_shape.Set(height_axis, num_chunks);
+  partial_shape.Set(width_axis, 1);
+  auto partial = tvm::te::compute(
+      partial_shape,
+      [&](const Array<Var>& output) {
+        auto rv = tvm::te::reduce_axis(Range(0, chunk_size), "rv");
+        PrimExpr p = output[height_axis] * chunk_size + rv;
+        Array<PrimExpr> indices(output.begin(), output.end());
+        indices.Set(height_axis, indexdiv(p, width));
+        indices.Set(width_axis, indexmod(p, width));
+        // The last chunk may be partial, it must not read past the plane
+        if (pool_type == kMaxPool) {
+          return tvm::max(tvm::if_then_else(p < plane, x(indices), tvm::min_value(x->dtype)),
+                          {rv});
+        }
+        return tvm::sum(tvm::if_then_else(p < plane, x(indices), make_zero(x->dtype)), {rv});
+      },
+      "tensor", "global_pool_partial");
+
+  Array<PrimExpr> out_shape = x->shape;
+  out_shape.Set(height_axis, 1);
+  out_shape.Set(width_axis, 1);
+  return tvm::te::compute(
+      out_shape,
+      [&](const Array<Var>& output) {
+        auto rc = tvm::te::reduce_axis(Range(0, num_chunks), "rc");
+        Array<PrimExpr> indices(output.begin(), output.end());
+        indices.Set(height_axis, rc);
+        if (pool_type == kMaxPool) {
+          return tvm::max(partial(indices), {rc});
+        }
+        return div(tvm::sum(partial(indices), {rc}), cast(x->dtype, plane));
+      },
+      "tensor", "global_pool_multistage");
+}
+
 /*!
  * \brief Perform pooling on N-dimension of data.
  *
@@ -453,6 +453,56 @@ JNIEXPORT jint JNICALL Java_org_apache_tvm_LibInfo_tvmArrayCopyToJArray(JNIEnv*
   return ret;
 }
 
+// Wrap the data of a CPU array into a direct ByteBuffer, which fills and reads it in place,
+// or return null with the last error set. The buffer is valid while the array is alive, it is
+// bound once to the inputs and outputs reused across runs, without the JNI array copies of
+// tvmArrayCopyFromJArray.
+JNIEXPORT jobject JNICALL Java_org_apache_tvm_LibInfo_tvmArrayGetDirectBuffer(JNIEnv* env,
+                                                                              jobject obj,
+                                                                              jlong jhandle) {
+  DLTensor* array = reinterpret_cast<DLTensor*>(jhandle);
+  if (array->ctx.device_type != kDLCPU) {
+    TVMAPISetLastError("tvmArrayGetDirectBuffer expects a CPU array");
+    return NULL;
+  }
+  size_t size = (array->dtype.bits * array->dtype.lanes + 7) / 8;
+  for (int i = 0; i < array->ndim; ++i) {
+    size *= static_cast<size_t>(array->shape[i]);
+  }
+  void* data = static_cast<char*>(array->data) + array->byte_offset;
+  jobject buffer = env->NewDirectByteBuffer(data, static_cast<jlong>(size));
+  if (buffer == NULL) {
+    TVMAPISetLastError("The JVM does not support direct buffer access");
+  }
+  return buffer;
+}
+
+// Copy between a direct ByteBuffer and an array of any device, without JNI array copies.
+JNIEXPORT jint JNICALL Java_org_apache_tvm_LibInfo_tvmArrayCopyFromDirectBuffer(
+    JNIEnv* env, jobject obj, jobject jbuffer, jlong jnbytes, jlong jto) {
+  void* data = env->GetDirectBufferAddress(jbuffer);
+  if (data == NULL || env->GetDirectBufferCapacity(jbuffer) < jnbytes) {
+    TVMAPISetLastError("Expect a direct ByteBuffer of at least the copied bytes");
+    return -1;
+  }
+  return TVMArrayCopyFromBytes(reinterpret_cast<TVMArrayHandle>(jto), data,
+                               static_cast<size_t>(jnbytes));
+}
+
+JNIEXPORT jint JNICALL Java_org_apache_tvm_LibInfo_tvmArrayCopyToDirectBuffer(JNIEnv* env,
+                                                                              jobject obj,
+                                                                              jlong jfrom,
+                                                                              jobject jbuffer,
+                                                                              jlong jnbytes) {
+  void* data = env->GetDirectBufferAddress(jbuffer);
+  if (data == NULL || env->GetDirectBufferCapacity(jbuffer) < jnbytes) {
+    TVMAPISetLastError("Expect a direct ByteBuffer of at least the copied bytes");
+    return -1;
+  }
+  return TVMArrayCopyToBytes(reinterpret_cast<TVMArrayHandle>(jfrom), data,
+                             static_cast<size_t>(jnbytes));
+}
+
 // Context
 JNIEXPORT jint JNICALL Java_org_apache_tvm_LibInfo_tvmSynchronize(JNIEnv* env, jint deviceType,
                                                                   jint deviceId) {
@@ -24,10 +24,14 @@
 #include <tvm/runtime/registry.h>
 #include <tvm/tir/expr.h>
 #include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
 
 namespace tvm {
 namespace arith {
 
+/*! \brief The maximum number of memoized Simplify results of an analyzer. */
+static constexpr size_t kMaxSimplifyCacheSize = 1024;
+
 Analyzer::Analyzer()
     : const_int_bound(this),
       modular_set(this),
@@ -44,6 +48,7 @@ void Analyzer::Bind(const Var& var, const PrimExpr& expr, bool allow_override) {
   this->modular_set.Update(var, this->modular_set(new_expr), allow_override);
   this->rewrite_simplify.Update(var, new_expr, allow_override);
   this->canonical_simplify.Update(var, new_expr, allow_override);
+  this->InvalidateSimplifyCache();
 }
 
 void Analyzer::Bind(const Var& var, const Range& range, bool allow_override) {
@@ -52,6 +57,7 @@ void Analyzer::Bind(const Var& var, const Range& range, bool allow_override) {
     this->Bind(var, range->min, allow_override);
   } else {
     this->const_int_bound.Bind(var, range, allow_override);
+    this->InvalidateSimplifyCache();
   }
   // skip modular_set
   // skip rewrite simplify
@@ -75,11 +81,13 @@ void ConstraintContext::EnterWithScope() {
     if (f1 != nullptr) f1();
     if (f0 != nullptr) f0();
   };
+  analyzer_->InvalidateSimplifyCache();
 }
 
 void ConstraintContext::ExitWithScope() {
   ICHECK(exit_ != nullptr);
   exit_();
+  analyzer_->InvalidateSimplifyCache();
 }
 
 bool Analyzer::CanProveGreaterEqual(const PrimExpr& expr, int64_t lower_bound) {
@@ -117,16 +125,36 @@ bool Analyzer::CanProve(const PrimExpr& expr) {
 
 PrimExpr Analyzer::Simplify(const PrimExpr& expr, int steps) {
   if (tir::is_const_int(expr)) return expr;
+  // Let and Reduce define variables, a memoized result would reuse
+  // the variables of the first structurally equal expression.
+  bool cacheable = true;
+  tir::PostOrderVisit(expr, [&cacheable](const ObjectRef& node) {
+    if (node->IsInstance<tir::LetNode>() || node->IsInstance<tir::ReduceNode>()) {
+      cacheable = false;
+    }
+  });
+  if (cacheable) {
+    auto it = simplify_cache_.find(expr);
+    if (it != simplify_cache_.end() && it->second.first == steps) return it->second.second;
+  }
   PrimExpr res = expr;
   for (int i = 0; i < steps; ++i) {
     res = this->rewrite_simplify(res);
-    if (tir::is_const_int(res) || ++i == steps) return res;
+    if (tir::is_const_int(res) || ++i == steps) break;
     res = this->canonical_simplify(res);
-    if (tir::is_const_int(res)) return res;
+    if (tir::is_const_int(res)) break;
+  }
+  if (cacheable) {
+    if (simplify_cache_.size() >= kMaxSimplifyCacheSize) simplify_cache_.clear();
+    simplify_cache_[expr] = {steps, res};
   }
   return res;
 }
 
+void Analyzer::InvalidateSimplifyCache() {
+  if (!simplify_cache_.empty()) simplify_cache_.clear();
+}
+
 TVM_REGISTER_GLOBAL("arith.CreateAnalyzer").set_body([](TVMArgs args, TVMRetValue* ret) {
   using runtime::PackedFunc;
   using runtime::TypedPackedFunc;
@@ -141,6 +169,7 @@ TVM_REGISTER_GLOBAL("arith.CreateAnalyzer").set_body([](TVMArgs args, TVMRetValu
     } else if (name == "const_int_bound_update") {
       return PackedFunc([self](TVMArgs args, TVMRetValue* ret) {
         self->const_int_bound.Update(args[0], args[1], args[2]);
+        self->InvalidateSimplifyCache();
       });
     } else if (name == "Simplify") {
       return PackedFunc([self](TVMArgs args, TVMRetValue* ret) {
@@ -28,6 +28,7 @@
 #include <tvm/auto_scheduler/transform_step.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/support/parallel_for.h>
+#include <tvm/target/target.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule.h>
 #include <tvm/te/schedule_pass.h>
@@ -37,7 +38,12 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
 #include <queue>
+#include <sstream>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -660,6 +666,27 @@ class FlopEstimator : public ExprFunctor<double(const PrimExpr& n)> {
   int cur_type_code_;
 };
 
+double EstimateFlop(const Array<te::Tensor>& outputs) {
+  // collect the ops in post order, the estimator only knows compute and placeholder ops
+  Array<te::Operation> ops;
+  std::unordered_set<te::Operation, ObjectPtrHash, ObjectPtrEqual> visited;
+  std::function<bool(const te::Operation&)> visit = [&](const te::Operation& op) {
+    if (!visited.insert(op).second) return true;
+    if (!op->IsInstance<te::ComputeOpNode>() && !op->IsInstance<te::PlaceholderOpNode>()) {
+      return false;
+    }
+    for (const te::Tensor& input : op->InputTensors()) {
+      if (!visit(input->op)) return false;
+    }
+    ops.push_back(op);
+    return true;
+  };
+  for (const te::Tensor& output : outputs) {
+    if (!visit(output->op)) return -1;
+  }
+  return FlopEstimator().EstimateFlop(ops);
+}
+
 void CheckComputeValidity(const te::Schedule& sch) {
   // Check the validity of a compute definition:
   // The name of each iterator should be unique.
@@ -676,6 +703,171 @@ void CheckComputeValidity(const te::Schedule& sch) {
   }
 }
 
+/*!
+ * \brief The replay cache of a ComputeDAG.
+ * Candidate states of a search share most of their transform steps with the states they are
+ * derived from, so they share the Step objects too. The cache keeps the TVM schedules got by
+ * replaying recent step lists, and ApplySteps copies the schedule of the longest cached prefix and
+ * applies only the remaining steps. The cache also keeps the DAGs got by ReplayAndGetDAG, so the
+ * access analysis of a DAG with the same cache and rfactor steps is done once per workload.
+ */
+class ComputeDAGReplayCache {
+ public:
+  /*!
+   * \brief Get a copy of the schedule of the longest cached prefix of the steps.
+   * \param steps The transform steps to replay.
+   * \param schedule The copied schedule.
+   * \param stages The stages of the copied schedule.
+   * \param stage_to_axes The axes of the stages of the copied schedule.
+   * \return The number of steps already applied to the copied schedule, 0 if there is no cached
+   * prefix.
+   */
+  size_t LookupPrefix(const Array<Step>& steps, te::Schedule* schedule, Array<te::Stage>* stages,
+                      StageToAxesMap* stage_to_axes) {
+    std::shared_ptr<const Entry> best;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto best_it = entries_.end();
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        const Array<Step>& cached = (*it)->steps;
+        if (cached.size() > steps.size() || (best && cached.size() <= best->steps.size())) {
+          continue;
+        }
+        bool match = true;
+        // The last steps differ most often, so compare from the end.
+        for (size_t i = cached.size(); i > 0; --i) {
+          if (!cached[i - 1].same_as(steps[i - 1])) {
+            match = false;
+            break;
+          }
+        }
+        if (match) {
+          best = *it;
+          best_it = it;
+          if (best->steps.size() == steps.size()) break;
+        }
+      }
+      if (best_it != entries_.end()) {
+        entries_.splice(entries_.begin(), entries_, best_it);
+      }
+    }
+    if (best == nullptr) {
+      return 0;
+    }
+    // Cached schedules are never modified, so they can be copied without the lock.
+    if (!CopySchedule(best->schedule, best->stages, best->stage_to_axes, schedule, stages,
+                      stage_to_axes)) {
+      return 0;
+    }
+    return best->steps.size();
+  }
+
+  /*!
+   * \brief Cache a copy of the schedule got by replaying the steps.
+   * \param steps The replayed transform steps.
+   * \param schedule The replayed schedule.
+   * \param stages The stages of the replayed schedule.
+   * \param stage_to_axes The axes of the stages of the replayed schedule.
+   */
+  void InsertPrefix(const Array<Step>& steps, const te::Schedule& schedule,
+                    const Array<te::Stage>& stages, const StageToAxesMap& stage_to_axes) {
+    auto entry = std::make_shared<Entry>();
+    entry->steps = steps;
+    if (!CopySchedule(schedule, stages, stage_to_axes, &entry->schedule, &entry->stages,
+                      &entry->stage_to_axes)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_front(std::move(entry));
+    if (entries_.size() > kMaxEntries) {
+      entries_.pop_back();
+    }
+  }
+
+  /*!
+   * \brief Get the DAG cached for a list of steps.
+   * \param key The key made from the steps.
+   * \param dag The cached DAG.
+   * \return Whether the DAG is cached.
+   */
+  bool LookupDAG(const std::string& key, ComputeDAG* dag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = dags_.find(key);
+    if (it == dags_.end()) {
+      return false;
+    }
+    *dag = it->second;
+    return true;
+  }
+
+  /*!
+   * \brief Cache the DAG got for a list of steps.
+   * \param key The key made from the steps.
+   * \param dag The DAG.
+   */
+  void InsertDAG(const std::string& key, const ComputeDAG& dag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dags_.size() >= kMaxEntries) {
+      dags_.clear();
+    }
+    dags_.emplace(key, dag);
+  }
+
+ private:
+  /*! \brief A replayed schedule and the steps it was replayed from. */
+  struct Entry {
+    Array<Step> steps;
+    te::Schedule schedule;
+    Array<te::Stage> stages;
+    StageToAxesMap stage_to_axes;
+  };
+
+  /*!
+   * \brief Copy a schedule, and map its stages and their axes to the stages of the copy.
+   * \return False if a stage is not part of the schedule.
+   */
+  static bool CopySchedule(const te::Schedule& src, const Array<te::Stage>& src_stages,
+                           const StageToAxesMap& src_stage_to_axes, te::Schedule* dst,
+                           Array<te::Stage>* dst_stages, StageToAxesMap* dst_stage_to_axes) {
+    te::Schedule copy = src.copy();
+    // Schedule::copy keeps the order of the stages.
+    std::unordered_map<const Object*, te::Stage> stage_map;
+    for (size_t i = 0; i < src->stages.size(); ++i) {
+      stage_map[src->stages[i].get()] = copy->stages[i];
+    }
+    Array<te::Stage> stages;
+    StageToAxesMap stage_to_axes;
+    for (const auto& stage : src_stages) {
+      auto it = stage_map.find(stage.get());
+      if (it == stage_map.end()) {
+        return false;
+      }
+      stages.push_back(it->second);
+    }
+    for (const auto& kv : src_stage_to_axes) {
+      auto it = stage_map.find(kv.first.get());
+      if (it == stage_map.end()) {
+        return false;
+      }
+      stage_to_axes.Set(it->second, kv.second);
+    }
+    *dst = std::move(copy);
+    *dst_stages = std::move(stages);
+    *dst_stage_to_axes = std::move(stage_to_axes);
+    return true;
+  }
+
+  /*! \brief The maximum number of cached schedules and of cached DAGs. */
+  static constexpr size_t kMaxEntries = 128;
+
+  /*! \brief The cached schedules, most recently used first. */
+  std::list<std::shared_ptr<const Entry>> entries_;
+  /*! \brief The cached DAGs of ReplayAndGetDAG. */
+  std::unordered_map<std::string, ComputeDAG> dags_;
+  /*! \brief Protect the cache from the threads of the search. */
+  std::mutex mutex_;
+};
+
 ComputeDAG::ComputeDAG(Array<te::Tensor> tensors) {
   auto node = make_object<ComputeDAGNode>();
   node->tensors = std::move(tensors);
@@ -697,6 +889,7 @@ ComputeDAG::ComputeDAG(Array<te::Tensor> tensors) {
 
   node->flop_ct = FlopEstimator().EstimateFlop(node->ops);
   node->init_state = State(node->ops);
+  node->replay_cache = std::make_shared<ComputeDAGReplayCache>();
   data_ = std::move(node);
 }
 
@@ -724,6 +917,7 @@ ComputeDAG::ComputeDAG(const te::Schedule& sch) {
   node->access_analyzer = AccessAnalyzer(node->tensors);
   node->flop_ct = FlopEstimator().EstimateFlop(node->ops);
   node->init_state = State(node->ops);
+  node->replay_cache = std::make_shared<ComputeDAGReplayCache>();
   data_ = std::move(node);
 }
 
@@ -819,6 +1013,43 @@ std::string GetOrigLayout(std::set<std::string>* placeholder_axis_names, const t
   return orig_layout;
 }
 
+/*!
+ * \brief Whether rewritten layouts should be packed for texture memory, which is the case when
+ * building for an OpenCL Adreno target whose weights can be stored as "texture:weight".
+ */
+bool RewriteLayoutForTexture(const te::Tensor& placeholder) {
+  Target target = Target::Current(true);
+  if (!target.defined() || target->kind->device_type != kDLOpenCL ||
+      target->GetAttr<String>("device").value_or("") != "adreno") {
+    return false;
+  }
+  DataType dtype = placeholder->dtype;
+  return dtype.is_float() && (dtype.bits() == 16 || dtype.bits() == 32);
+}
+
+/*!
+ * \brief Make an extent 4 axis the innermost one of a layout, so it maps onto the RGBA channels
+ * of texels. The factor of 4 is taken from the innermost tile of the schedule that has one.
+ * The layout is left unchanged when no tile extent is a multiple of 4.
+ */
+void PackTexelInnerAxis(std::vector<PrimExpr>* extents, std::vector<std::string>* names) {
+  for (int i = static_cast<int>(extents->size()) - 1; i >= 0; --i) {
+    const auto* extent = (*extents)[i].as<IntImmNode>();
+    if (extent == nullptr || extent->value % 4 != 0) {
+      continue;
+    }
+    if (i == static_cast<int>(extents->size()) - 1 && extent->value == 4) {
+      return;
+    }
+    std::string name = (*names)[i];
+    (*extents)[i] = Integer(extent->value / 4);
+    // The trailing entry becomes the lowest digit of this axis
+    extents->push_back(Integer(4));
+    names->push_back(name);
+    return;
+  }
+}
+
 std::string GetNewLayout(const State& state, const int stage_id, const Stage& stage,
                          const te::Operation& op, const te::Tensor& placeholder,
                          const std::set<std::string>& placeholder_axis_names) {
@@ -853,6 +1084,7 @@ std::string GetNewLayout(const State& state, const int stage_id, const Stage& st
     }
   }
 
+  std::vector<PrimExpr> new_extents;
   std::vector<std::string> new_names;
   std::vector<std::string> new_axis_names;
   for (const Iterator& iter : iters) {
@@ -880,10 +1112,16 @@ std::string GetNewLayout(const State& state, const int stage_id, const Stage& st
         // This iter is simplified by InferBound, so it must have a length of one.
         extent = 1;
       }
-      os << extent << ori_iter_name;
+      new_extents.push_back(extent);
       new_names.push_back(ori_iter_name);
     }
   }
+  if (RewriteLayoutForTexture(placeholder)) {
+    PackTexelInnerAxis(&new_extents, &new_names);
+  }
+  for (size_t i = 0; i < new_names.size(); ++i) {
+    os << new_extents[i] << new_names[i];
+  }
   std::string new_layout = os.str();
   os.str("");
   ::tvm::relay::AutoSchedulerLayoutRewriter::global_new_layouts_queue.push_back(new_layout);
@@ -896,6 +1134,8 @@ ComputeDAG ComputeDAG::RewriteLayout(Array<Step>* transform_steps,
       << "Call ComputeDAG::RewriteLayout with NoRewrite.";
   ComputeDAG new_dag = *this;
   ComputeDAGNode* p_dag = new_dag.CopyOnWrite();
+  // The rewritten DAG has different ops, so it cannot share the replayed schedules
+  p_dag->replay_cache = std::make_shared<ComputeDAGReplayCache>();
 
   auto node = make_object<StateNode>();
   node->transform_steps = *transform_steps;
@@ -1173,27 +1413,42 @@ std::pair<te::Schedule, Array<te::Tensor>> ComputeDAG::ApplySteps(
   if (stage_to_axes == nullptr) {
     stage_to_axes = &temp_stage_to_axes;
   }
-  Array<te::Operation> out_ops;
-  for (const auto& op : operator->()->ops) {
-    if (operator->()->access_analyzer.IsOutput(op)) {
-      out_ops.push_back(op);
-    }
+  const auto& replay_cache = operator->()->replay_cache;
+  te::Schedule schedule;
+  size_t num_applied = 0;
+
+  // Start from the schedule of the longest cached prefix of the steps
+  if (replay_cache != nullptr && !transform_steps.empty()) {
+    num_applied = replay_cache->LookupPrefix(transform_steps, &schedule, stages, stage_to_axes);
   }
 
-  // Create the initial schedule
-  te::Schedule schedule = te::create_schedule(out_ops);
+  if (num_applied == 0) {
+    Array<te::Operation> out_ops;
+    for (const auto& op : operator->()->ops) {
+      if (operator->()->access_analyzer.IsOutput(op)) {
+        out_ops.push_back(op);
+      }
+    }
 
-  // init axes
-  for (const auto& x : operator->()->ops) {
-    const te::Stage& stage = schedule[x];
-    stages->push_back(stage);
-    UpdateStageToAxesMap(stage, stage_to_axes);
+    // Create the initial schedule
+    schedule = te::create_schedule(out_ops);
+
+    // init axes
+    for (const auto& x : operator->()->ops) {
+      const te::Stage& stage = schedule[x];
+      stages->push_back(stage);
+      UpdateStageToAxesMap(stage, stage_to_axes);
+    }
   }
 
   // Apply the history steps to TVM schedule
   // Call each step's ApplyToSchedule method
-  for (const auto& step : transform_steps) {
-    StepApplyToSchedule(step, stages, stage_to_axes, &schedule, transform_steps);
+  for (size_t i = num_applied; i < transform_steps.size(); ++i) {
+    StepApplyToSchedule(transform_steps[i], stages, stage_to_axes, &schedule, transform_steps);
+  }
+
+  if (replay_cache != nullptr && num_applied < transform_steps.size()) {
+    replay_cache->InsertPrefix(transform_steps, schedule, *stages, *stage_to_axes);
   }
 
   return std::make_pair(schedule, operator->()->tensors);
@@ -1378,10 +1633,36 @@ Array<State> ComputeDAG::InferBound(const Array<State>& states) const {
 }
 
 ComputeDAG ComputeDAG::ReplayAndGetDAG(const Array<Step>& transform_steps) const {
+  const auto& replay_cache = operator->()->replay_cache;
+  std::string key;
+  if (replay_cache != nullptr) {
+    // Equal steps of different states are different objects, so key the DAG by their records
+    std::ostringstream os;
+    dmlc::JSONWriter writer(&os);
+    writer.BeginArray(false);
+    for (const auto& step : transform_steps) {
+      writer.WriteArraySeperator();
+      writer.BeginArray(false);
+      step->WriteToRecord(&writer);
+      writer.EndArray();
+    }
+    writer.EndArray();
+    key = os.str();
+
+    ComputeDAG dag;
+    if (replay_cache->LookupDAG(key, &dag)) {
+      return dag;
+    }
+  }
+
   te::Schedule sch;
   Array<te::Tensor> old_tensors;
   std::tie(sch, old_tensors) = ApplySteps(transform_steps);
-  return ComputeDAG(sch);
+  ComputeDAG dag(sch);
+  if (replay_cache != nullptr) {
+    replay_cache->InsertDAG(key, dag);
+  }
+  return dag;
 }
 
 TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
@@ -23,14 +23,42 @@
  */
 
 #include <tvm/auto_scheduler/cost_model.h>
+#include <tvm/auto_scheduler/feature.h>
+#include <tvm/auto_scheduler/measure_record.h>
+#include <tvm/support/parallel_for.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_set>
+#include <utility>
 
 namespace tvm {
 namespace auto_scheduler {
 
 TVM_REGISTER_OBJECT_TYPE(CostModelNode);
 TVM_REGISTER_OBJECT_TYPE(RandomModelNode);
+TVM_REGISTER_OBJECT_TYPE(GBDTModelNode);
 TVM_REGISTER_OBJECT_TYPE(PythonBasedModelNode);
 
+void CostModelNode::UpdateFromFile(const String& log_file, const Array<String>& workload_keys) {
+  RecordReader reader = RecordReader(log_file);
+  const auto& res = reader->ReadLines(-1);
+  std::unordered_set<std::string> keys(workload_keys.begin(), workload_keys.end());
+  Array<MeasureInput> inputs;
+  Array<MeasureResult> results;
+  for (size_t i = 0; i < res.first.size(); ++i) {
+    if (keys.empty() || keys.count(res.first[i]->task->workload_key)) {
+      inputs.push_back(res.first[i]);
+      results.push_back(res.second[i]);
+    }
+  }
+  if (!inputs.empty()) {
+    Update(inputs, results);
+  }
+}
+
 RandomModel::RandomModel() {
   ObjectPtr<RandomModelNode> node = make_object<RandomModelNode>();
   const auto* f = runtime::Registry::Get("auto_scheduler.cost_model.random_fill_float");
@@ -48,6 +76,255 @@ void RandomModelNode::Predict(const SearchTask& task, const Array<State>& states
   (*random_number_func)(states.size(), static_cast<void*>(scores->data()));
 }
 
+GBDTModel::GBDTModel(int n_trees, int max_depth, double learning_rate, int num_warmup_sample) {
+  ICHECK_GT(n_trees, 0);
+  ICHECK_GT(max_depth, 0);
+  auto node = make_object<GBDTModelNode>();
+  node->n_trees = n_trees;
+  node->max_depth = max_depth;
+  node->learning_rate = learning_rate;
+  node->reg_lambda = 1.0f;
+  node->min_child_weight = 1e-3f;
+  node->num_warmup_sample = num_warmup_sample;
+  node->max_n_bufs = 5;
+  data_ = std::move(node);
+}
+
+void GBDTModelNode::Update(const Array<MeasureInput>& inputs,
+                           const Array<MeasureResult>& results) {
+  std::vector<std::vector<float>> features;
+  std::vector<float> throughputs;
+  std::vector<int> task_ids;
+  GetPerStoreFeaturesFromMeasurePairs(inputs, results, 0, max_n_bufs, &features, &throughputs,
+                                      &task_ids);
+  for (size_t i = 0; i < features.size(); ++i) {
+    features_.push_back(std::move(features[i]));
+    throughputs_.push_back(throughputs[i]);
+  }
+  // Retrain from scratch on all the measured samples, the same as the python XGBModel.
+  Fit(features_, throughputs_);
+}
+
+void GBDTModelNode::Predict(const SearchTask& task, const Array<State>& states,
+                            std::vector<float>* scores) {
+  std::vector<std::vector<float>> features;
+  GetPerStoreFeaturesFromStates(states, task, 0, max_n_bufs, &features);
+
+  if (!trees_.empty() && features_.size() > static_cast<size_t>(num_warmup_sample)) {
+    PredictFeatures(features, scores);
+    return;
+  }
+
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  scores->resize(states.size());
+  for (size_t i = 0; i < states.size(); ++i) {
+    bool valid = !features[i].empty() && features[i][0] > 0;
+    (*scores)[i] = valid ? dist(rng_) : -std::numeric_limits<float>::infinity();
+  }
+}
+
+void GBDTModelNode::Fit(const std::vector<std::vector<float>>& features,
+                        const std::vector<float>& throughputs) {
+  ICHECK_EQ(features.size(), throughputs.size());
+  constexpr size_t kMaxBins = 64;
+
+  // Unpack the per-store rows of all the valid states.
+  std::vector<const float*> rows;
+  std::vector<int> row_state;
+  size_t row_length = 0;
+  for (size_t i = 0; i < features.size(); ++i) {
+    const std::vector<float>& fea = features[i];
+    if (fea.empty() || fea[0] <= 0 || throughputs[i] <= 0) {
+      continue;
+    }
+    size_t n_rows = static_cast<size_t>(fea[0]);
+    size_t length = (fea.size() - 1) / n_rows;
+    ICHECK_EQ(n_rows * length + 1, fea.size()) << "Malformed per-store features";
+    if (row_length == 0) {
+      row_length = length;
+    }
+    ICHECK_EQ(row_length, length) << "Inconsistent per-store feature length";
+    for (size_t j = 0; j < n_rows; ++j) {
+      rows.push_back(fea.data() + 1 + j * length);
+      row_state.push_back(i);
+    }
+  }
+  trees_.clear();
+  row_length_ = row_length;
+  if (rows.empty()) {
+    return;
+  }
+  size_t n_rows = rows.size();
+
+  // Quantize every feature into at most kMaxBins bins. A row falls into bin b when its value is
+  // larger than cuts[b - 1] and not larger than cuts[b].
+  std::vector<std::vector<float>> cuts(row_length);
+  std::vector<uint8_t> bins(n_rows * row_length);
+  support::parallel_for(0, row_length, [&](int f) {
+    std::vector<float> values(n_rows);
+    for (size_t r = 0; r < n_rows; ++r) {
+      values[r] = rows[r][f];
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    std::vector<float>& cut = cuts[f];
+    if (values.size() <= kMaxBins) {
+      cut.assign(values.begin(), values.end() - 1);
+    } else {
+      for (size_t b = 1; b < kMaxBins; ++b) {
+        float value = values[b * values.size() / kMaxBins];
+        if (cut.empty() || cut.back() < value) {
+          cut.push_back(value);
+        }
+      }
+    }
+    for (size_t r = 0; r < n_rows; ++r) {
+      bins[r * row_length + f] = std::lower_bound(cut.begin(), cut.end(), rows[r][f]) - cut.begin();
+    }
+  });
+
+  // Boost on the pack-sum square error: the prediction of a state is the sum over its rows, so
+  // every row of a state shares the gradient of that state. States are weighted by throughput
+  // to focus the model on the good ones.
+  std::vector<float> row_pred(n_rows, 0.0f);
+  std::vector<float> state_pred(features.size());
+  std::vector<float> grad(n_rows);
+  std::vector<float> hess(n_rows);
+  std::vector<int> all_rows(n_rows);
+  for (size_t r = 0; r < n_rows; ++r) {
+    all_rows[r] = r;
+  }
+
+  for (int t = 0; t < n_trees; ++t) {
+    std::fill(state_pred.begin(), state_pred.end(), 0.0f);
+    for (size_t r = 0; r < n_rows; ++r) {
+      state_pred[row_state[r]] += row_pred[r];
+    }
+    for (size_t r = 0; r < n_rows; ++r) {
+      float y = throughputs[row_state[r]];
+      grad[r] = (state_pred[row_state[r]] - y) * y;
+      hess[r] = y;
+    }
+
+    std::vector<TreeNode> tree;
+    // Grow the tree depth first. Every leaf also adds its value to the rows it holds.
+    std::function<int(std::vector<int>, int)> grow = [&](std::vector<int> node_rows, int depth) {
+      double sum_g = 0, sum_h = 0;
+      for (int r : node_rows) {
+        sum_g += grad[r];
+        sum_h += hess[r];
+      }
+      int id = tree.size();
+      tree.push_back(TreeNode{-1, 0.0f, -1, -1, 0.0f});
+
+      int best_feature = -1;
+      size_t best_bin = 0;
+      double best_gain = 1e-6;
+      if (depth < max_depth && node_rows.size() > 1) {
+        std::vector<double> gains(row_length, 0.0);
+        std::vector<size_t> split_bins(row_length, 0);
+        auto find_split = [&](int f) {
+          size_t n_bins = cuts[f].size() + 1;
+          std::vector<double> hist_g(n_bins, 0.0), hist_h(n_bins, 0.0);
+          for (int r : node_rows) {
+            uint8_t b = bins[r * row_length + f];
+            hist_g[b] += grad[r];
+            hist_h[b] += hess[r];
+          }
+          double parent = sum_g * sum_g / (sum_h + reg_lambda);
+          double left_g = 0, left_h = 0;
+          for (size_t b = 0; b + 1 < n_bins; ++b) {
+            left_g += hist_g[b];
+            left_h += hist_h[b];
+            double right_g = sum_g - left_g, right_h = sum_h - left_h;
+            if (left_h < min_child_weight || right_h < min_child_weight) {
+              continue;
+            }
+            double gain = left_g * left_g / (left_h + reg_lambda) +
+                          right_g * right_g / (right_h + reg_lambda) - parent;
+            if (gain > gains[f]) {
+              gains[f] = gain;
+              split_bins[f] = b;
+            }
+          }
+        };
+        // Only pay for the thread pool when the histogram pass is big enough.
+        if (node_rows.size() * row_length >= (1 << 16)) {
+          support::parallel_for(0, row_length, find_split);
+        } else {
+          for (size_t f = 0; f < row_length; ++f) {
+            find_split(f);
+          }
+        }
+        for (size_t f = 0; f < row_length; ++f) {
+          if (gains[f] > best_gain) {
+            best_gain = gains[f];
+            best_feature = f;
+            best_bin = split_bins[f];
+          }
+        }
+      }
+
+      if (best_feature < 0) {
+        float value = -learning_rate * sum_g / (sum_h + reg_lambda);
+        tree[id].value = value;
+        for (int r : node_rows) {
+          row_pred[r] += value;
+        }
+        return id;
+      }
+
+      std::vector<int> left_rows, right_rows;
+      for (int r : node_rows) {
+        if (bins[r * row_length + best_feature] <= best_bin) {
+          left_rows.push_back(r);
+        } else {
+          right_rows.push_back(r);
+        }
+      }
+      node_rows.clear();
+      node_rows.shrink_to_fit();
+      int left = grow(std::move(left_rows), depth + 1);
+      int right = grow(std::move(right_rows), depth + 1);
+      tree[id] = TreeNode{best_feature, cuts[best_feature][best_bin], left, right, 0.0f};
+      return id;
+    };
+    grow(all_rows, 0);
+    trees_.push_back(std::move(tree));
+  }
+}
+
+void GBDTModelNode::PredictFeatures(const std::vector<std::vector<float>>& features,
+                                    std::vector<float>* scores) const {
+  scores->resize(features.size());
+  for (size_t i = 0; i < features.size(); ++i) {
+    const std::vector<float>& fea = features[i];
+    if (fea.empty() || fea[0] <= 0) {
+      (*scores)[i] = -std::numeric_limits<float>::infinity();
+      continue;
+    }
+    if (trees_.empty()) {
+      (*scores)[i] = 0.0f;
+      continue;
+    }
+    size_t n_rows = static_cast<size_t>(fea[0]);
+    ICHECK_EQ(n_rows * row_length_ + 1, fea.size())
+        << "The features do not match the ones the model was trained on";
+    float score = 0.0f;
+    for (size_t j = 0; j < n_rows; ++j) {
+      const float* row = fea.data() + 1 + j * row_length_;
+      for (const std::vector<TreeNode>& tree : trees_) {
+        int id = 0;
+        while (tree[id].left >= 0) {
+          id = row[tree[id].feature] <= tree[id].threshold ? tree[id].left : tree[id].right;
+        }
+        score += tree[id].value;
+      }
+    }
+    (*scores)[i] = score;
+  }
+}
+
 PythonBasedModel::PythonBasedModel(PackedFunc update_func, PackedFunc predict_func,
                                    PackedFunc predict_stage_func) {
   auto node = make_object<PythonBasedModelNode>();
@@ -147,12 +424,22 @@ void PythonBasedModelNode::PredictStages(const SearchTask& task, const Array<Sta
 
 TVM_REGISTER_GLOBAL("auto_scheduler.RandomModel").set_body_typed([]() { return RandomModel(); });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.GBDTModel")
+    .set_body_typed([](int n_trees, int max_depth, double learning_rate, int num_warmup_sample) {
+      return GBDTModel(n_trees, max_depth, learning_rate, num_warmup_sample);
+    });
+
 TVM_REGISTER_GLOBAL("auto_scheduler.PythonBasedModel")
     .set_body_typed([](PackedFunc update_func, PackedFunc predict_func,
                        PackedFunc predict_stage_func) {
       return PythonBasedModel(update_func, predict_func, predict_stage_func);
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.CostModelUpdateFromFile")
+    .set_body_typed([](CostModel model, String log_file, Optional<Array<String>> workload_keys) {
+      model->UpdateFromFile(log_file, workload_keys.value_or(Array<String>()));
+    });
+
 TVM_REGISTER_GLOBAL("auto_scheduler.CostModelUpdate")
     .set_body_typed([](CostModel model, Array<MeasureInput> inputs, Array<MeasureResult> results) {
       model->Update(inputs, results);
@@ -22,6 +22,7 @@
  * \brief Feature extraction for the cost model
  */
 
+#include <dmlc/json.h>
 #include <tvm/arith/analyzer.h>
 #include <tvm/auto_scheduler/feature.h>
 #include <tvm/auto_scheduler/measure.h>
@@ -37,10 +38,16 @@
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
+#include <mutex>
 #include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "../runtime/texture.h"
 #include "search_policy/utils.h"
 #include "utils.h"
 
@@ -108,6 +115,11 @@ struct BufferAccessFeature {
   float lines_d_reuse_ct;         // lines / reuse_ct
   float unique_lines_d_reuse_ct;  // unique_lines / reuse_ct
   float stride;                   // The stride in access
+  float is_texture;               // Whether the buffer is held in a texture
+  float texture_width;            // The texels touched per image row by a thread
+  float texture_height;           // The image rows touched by a thread
+  float texture_vec_width;        // The channels of a texel touched by the innermost loop
+  float texture_row_reuse_dis;    // The inner iterations before the image row changes
 };
 
 // Feature set of a BufferStore statement
@@ -167,6 +179,8 @@ struct FeatureSet {
   float outer_prod;            // The product of lengths of outer loops
   float num_loops;             // The number of outer loops
   float auto_unroll_max_step;  // The value of pragma "auto_unroll_max_step"
+
+  // Group 6: Texture related features (per buffer, stored in access_feas)
 };
 
 // Return whether a var is in an expr
@@ -578,7 +592,8 @@ std::tuple<ReuseType, float, float, float> ComputeReuse(
 // Extract features for every BufferStore statement
 class PerStoreFeatureExtractor : public StmtExprVisitor {
  public:
-  explicit PerStoreFeatureExtractor(int cache_line_size) : cache_line_size_(cache_line_size) {}
+  explicit PerStoreFeatureExtractor(int cache_line_size, bool texture_features = false)
+      : cache_line_size_(cache_line_size), texture_features_(texture_features) {}
 
   void VisitStmt_(const AttrStmtNode* node) final {
     if (node->attr_key == tir::attr::thread_extent || node->attr_key == tir::attr::virtual_thread) {
@@ -627,6 +642,11 @@ class PerStoreFeatureExtractor : public StmtExprVisitor {
       outer_loop_prod_ /= extent;
 
       *plen = extent_before;
+    } else if (node->attr_key == tir::attr::realize_scope) {
+      if (const auto* scope = node->value.as<StringImmNode>()) {
+        realize_scopes_[node->node.get()] = scope->value;
+      }
+      StmtExprVisitor::VisitStmt_(node);
     } else if (node->attr_key == "pragma_auto_unroll_max_step") {
       int value = GetIntImm(node->value);
 
@@ -792,13 +812,34 @@ class PerStoreFeatureExtractor : public StmtExprVisitor {
                        math_op_counter.float_cmp + math_op_counter.float_math_func +
                        math_op_counter.float_other_func;
 
+    // The regions of the loops inside the innermost thread binding, which are touched by
+    // a single thread, and the regions of the innermost loop, for the texture features
+    int thread_level = 0;
+    for (size_t i = 0; i < for_loop_stack_.size(); ++i) {
+      if (for_loop_stack_[i]->kind == ForKind::kParallel) thread_level = i + 1;
+    }
+    BufferMap<std::vector<int>> thread_regions, inner_regions;
+    for (const auto& x : buf_extractor.buf_accesses) {
+      thread_regions[x.first] = std::vector<int>(x.first->shape.size(), 1);
+      inner_regions[x.first] = std::vector<int>(x.first->shape.size(), 1);
+    }
+
     std::vector<int> tmp_region;
-    for (int i = static_cast<int>(for_loop_stack_.size()) - 1; i >= 0; i--) {
+    int innermost = static_cast<int>(for_loop_stack_.size()) - 1;
+    for (int i = innermost; i >= 0; i--) {
       const ForNode* p_for = for_loop_stack_[i];
 
       ana_.Bind(p_for->loop_var,
                 Range::FromMinExtent(for_loop_stack_[i]->min, for_loop_stack_[i]->extent), true);
 
+      if (texture_features_ && (i == thread_level || i == innermost)) {
+        for (const auto& x : buf_extractor.buf_accesses) {
+          ComputeRegion(x.second.indices, &ana_, &tmp_region);
+          if (i == thread_level) thread_regions[x.first] = tmp_region;
+          if (i == innermost) inner_regions[x.first] = tmp_region;
+        }
+      }
+
       // Note, here we do overwrite.
       // So if there are multiple BufferStoreNode, the last one will overwrite the first few.
       // e.g. The update part in gemm will overwrite the init part.
@@ -915,11 +956,55 @@ class PerStoreFeatureExtractor : public StmtExprVisitor {
         acc_fea.lines_d_reuse_ct = lines * 2;
         acc_fea.unique_lines_d_reuse_ct = unique_lines * 2;
       }
+
+      ExtractTextureFeature(t, acc, thread_regions[t], inner_regions[t], &acc_fea);
     }
 
     fea.access_feas = acc_feas;
   }
 
+  // Extract texture related features of a buffer access (group 6)
+  void ExtractTextureFeature(const Buffer& buffer, const BufferAccess& acc,
+                             const std::vector<int>& thread_region,
+                             const std::vector<int>& inner_region, BufferAccessFeature* acc_fea) {
+    acc_fea->is_texture = 0.0f;
+    acc_fea->texture_width = 0.0f;
+    acc_fea->texture_height = 0.0f;
+    acc_fea->texture_vec_width = 0.0f;
+    acc_fea->texture_row_reuse_dis = 0.0f;
+    if (!texture_features_) return;
+
+    std::string scope = GetStorageScope(buffer);
+    size_t ndim = buffer->shape.size();
+    if (!runtime::IsTextureStorage(scope) || ndim < 2 || thread_region.size() != ndim) {
+      return;
+    }
+    // Images are indexed by (row, texel), the innermost axis holding the RGBA channels
+    size_t axis = runtime::DefaultTextureLayoutSeparator(ndim, scope);
+    acc_fea->is_texture = 1.0f;
+    acc_fea->texture_width = 1.0f;
+    acc_fea->texture_height = 1.0f;
+    for (size_t i = 0; i + 1 < ndim; ++i) {
+      (i < axis ? acc_fea->texture_height : acc_fea->texture_width) *= thread_region[i];
+    }
+    acc_fea->texture_vec_width = inner_region.back();
+
+    // The accesses stay in one image row over the inner loops not used by the row indices
+    float reuse_dis = 1.0f;
+    for (int i = static_cast<int>(for_loop_stack_.size()) - 1; i >= 0; i--) {
+      const Var& var = for_loop_stack_[i]->loop_var;
+      bool moves_row = false;
+      for (const auto& indices : acc.indices) {
+        for (size_t j = 0; j < axis && j < indices.size(); ++j) {
+          moves_row = moves_row || VarInExpr(var, indices[j]);
+        }
+      }
+      if (moves_row) break;
+      reuse_dis *= GetLoopExtent(for_loop_stack_[i]);
+    }
+    acc_fea->texture_row_reuse_dis = reuse_dis;
+  }
+
   // Extract arithmetic intensity related feature (group 3)
   void ExtractArithmeticIntensityFeature(const BufferStoreNode* node, double cur_compute_ops,
                                          const std::vector<float>& compute_ops_list,
@@ -983,6 +1068,15 @@ class PerStoreFeatureExtractor : public StmtExprVisitor {
   BufferMap<FeatureSet> buffer_features;
 
  private:
+  // Get the storage scope of a buffer, from the realize_scope attribute if it has one
+  std::string GetStorageScope(const Buffer& buffer) const {
+    auto it = realize_scopes_.find(buffer.get());
+    return it != realize_scopes_.end() ? it->second : std::string(buffer->scope);
+  }
+
+  // The storage scopes given by realize_scope attributes
+  std::unordered_map<const Object*, std::string> realize_scopes_;
+
   // The shared arithmetic analyzer
   Analyzer ana_;
 
@@ -1015,14 +1109,16 @@ class PerStoreFeatureExtractor : public StmtExprVisitor {
 
   // The default cache line size in bytes
   const int cache_line_size_ = 64;
+  // Whether the texture related features are extracted
+  const bool texture_features_ = false;
 };
 
 // shifted log to incorporate the property that slog(0) = 0
 inline float slog(float x) { return x < 0 ? -std::log2(-x + 1) : std::log2(x + 1); }
 
 void GetPerStoreFeature(const Stmt& stmt, int cache_line_size, int max_n_bufs,
-                        std::vector<float>* ret) {
-  PerStoreFeatureExtractor extractor(cache_line_size);
+                        std::vector<float>* ret, bool texture_features) {
+  PerStoreFeatureExtractor extractor(cache_line_size, texture_features);
   extractor(stmt);
 
   ret->push_back(extractor.buffer_features.size());
@@ -1154,10 +1250,30 @@ void GetPerStoreFeature(const Stmt& stmt, int cache_line_size, int max_n_bufs,
     ret->push_back(slog(fea_set.outer_prod));
     ret->push_back(slog(fea_set.num_loops));
     ret->push_back(slog(fea_set.auto_unroll_max_step));
+
+    if (!texture_features) continue;
+
+    /***** Group 6: Texture related features *****/
+    // Use the order of the buffers in group 2
+    for (int idx : buf_order) {
+      const auto& acc_fea = fea_set.access_feas[idx];
+      ret->push_back(acc_fea.is_texture);
+      ret->push_back(slog(acc_fea.texture_width));
+      ret->push_back(slog(acc_fea.texture_height));
+      ret->push_back(slog(acc_fea.texture_vec_width));
+      ret->push_back(slog(acc_fea.texture_row_reuse_dis));
+    }
+    // - fill padding
+    for (int i = 0; i < max_n_bufs - n_bufs; ++i) {
+      for (int j = 0; j < 5; ++j) {
+        ret->push_back(0.0f);
+      }
+    }
   }
 }
 
-void GetPerStoreFeatureName(int max_n_bufs, std::vector<std::string>* ret) {
+void GetPerStoreFeatureName(int max_n_bufs, std::vector<std::string>* ret,
+                            bool texture_features) {
   /***** Group 1: Computation related features *****/
   ret->push_back(("float_mad"));
   ret->push_back(("float_addsub"));
@@ -1260,10 +1376,102 @@ void GetPerStoreFeatureName(int max_n_bufs, std::vector<std::string>* ret) {
   ret->push_back(("num_loops"));
   ret->push_back(("auto_unroll_max_step"));
   // section total : 3
+
+  if (!texture_features) return;
+
+  /***** Group 6: Texture related features *****/
+  for (size_t i = 0; i < static_cast<size_t>(max_n_bufs); ++i) {
+    std::string prefix = "B" + std::to_string(i) + ".";
+    ret->push_back((prefix + "is_texture"));
+    ret->push_back((prefix + "texture_width"));
+    ret->push_back((prefix + "texture_height"));
+    ret->push_back((prefix + "texture_vec_width"));
+    ret->push_back((prefix + "texture_row_reuse_dis"));
+  }
+  // section total : max_n_bufs * 5
 }
 
+/*!
+ * \brief The features of the states extracted recently.
+ *  The evolutionary search scores the states it keeps again in every generation, and the
+ *  measured states again when the cost model is updated, so the features of a state are
+ *  looked up before lowering it. The oldest entries are evicted past the capacity.
+ */
+class FeatureCache {
+ public:
+  static FeatureCache* Global() {
+    static FeatureCache* inst = new FeatureCache();
+    return inst;
+  }
+
+  /*!
+   * \brief Get the key of a state in a task.
+   * \return The key, holding the task and the transform steps of the state.
+   */
+  static std::string GetKey(const SearchTask& task, const State& state, int max_n_bufs) {
+    std::ostringstream os;
+    os << task->workload_key << ";" << task->target->str() << ";"
+       << task->hardware_params->cache_line_bytes << ";" << max_n_bufs << ";";
+    dmlc::JSONWriter writer(&os);
+    writer.BeginArray(false);
+    for (const auto& step : state->transform_steps) {
+      writer.WriteArraySeperator();
+      writer.BeginArray(false);
+      step->WriteToRecord(&writer);
+      writer.EndArray();
+    }
+    writer.EndArray();
+    return os.str();
+  }
+
+  bool Get(const std::string& key, std::vector<float>* feature) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    *feature = it->second;
+    return true;
+  }
+
+  void Set(const std::string& key, const std::vector<float>& feature) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!entries_.emplace(key, feature).second) return;
+    order_.push_back(key);
+    while (order_.size() > kCapacity) {
+      entries_.erase(order_.front());
+      order_.pop_front();
+    }
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    order_.clear();
+  }
+
+ private:
+  /*! \brief The number of states whose features are kept. */
+  static constexpr size_t kCapacity = 16384;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<float>> entries_;
+  /*! \brief The keys in insertion order. */
+  std::deque<std::string> order_;
+};
+
+void ExtractPerStoreFeatures(const SearchTask& task, const State& state, int max_n_bufs,
+                             std::vector<float>* feature, std::atomic<int>* error_ct);
+
 void GetPerStoreFeaturesWorkerFunc(const SearchTask& task, const State& state, int max_n_bufs,
                                    std::vector<float>* feature, std::atomic<int>* error_ct) {
+  std::string key = FeatureCache::GetKey(task, state, max_n_bufs);
+  if (FeatureCache::Global()->Get(key, feature)) return;
+  ExtractPerStoreFeatures(task, state, max_n_bufs, feature, error_ct);
+  // A state which fails to lower fails again, its empty features are cached as well
+  FeatureCache::Global()->Set(key, *feature);
+}
+
+void ExtractPerStoreFeatures(const SearchTask& task, const State& state, int max_n_bufs,
+                             std::vector<float>* feature, std::atomic<int>* error_ct) {
   te::Schedule sch;
   Array<te::Tensor> tensors;
 
@@ -1326,13 +1534,19 @@ void GetPerStoreFeaturesWorkerFunc(const SearchTask& task, const State& state, i
     const auto& it = mod->functions.find(global_var);
     ICHECK(it != mod->functions.end());
     const auto& prim_func = (*it).second.as<PrimFuncNode>();
+    // The texture features are only appended for the targets asking for them, the feature
+    // vectors of the other targets keep their length
+    bool texture_features = task->target->GetAttr<Bool>("texture_features", Bool(false)).value();
     GetPerStoreFeature(prim_func->body, task->hardware_params->cache_line_bytes, max_n_bufs,
-                       feature);
+                       feature, texture_features);
   } catch (dmlc::Error& e) {
     (*error_ct)++;
   }
 }
 
+// The number of threads extracting features
+int NumFeatureThreads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
 void GetPerStoreFeaturesFromStates(const Array<State>& states, const SearchTask& task,
                                    int skip_first_n_feature_extraction, int max_n_bufs,
                                    std::vector<std::vector<float>>* features) {
@@ -1341,11 +1555,12 @@ void GetPerStoreFeaturesFromStates(const Array<State>& states, const SearchTask&
 
   std::atomic<int> error_ct(0);
 
-  support::parallel_for(skip_first_n_feature_extraction, states.size(),
-                        [&task, &states, &max_n_bufs, &features, &error_ct](int i) {
-                          GetPerStoreFeaturesWorkerFunc(task, states[i], max_n_bufs,
-                                                        &(*features)[i], &error_ct);
-                        });
+  // The cost of lowering varies a lot between states, so they are fetched dynamically
+  support::parallel_for_dynamic(
+      skip_first_n_feature_extraction, states.size(), NumFeatureThreads(),
+      [&task, &states, &max_n_bufs, &features, &error_ct](int thread_id, int i) {
+        GetPerStoreFeaturesWorkerFunc(task, states[i], max_n_bufs, &(*features)[i], &error_ct);
+      });
 }
 
 void GetPerStoreFeaturesFromStates(const Array<State>& states, const std::vector<SearchTask>& tasks,
@@ -1356,11 +1571,11 @@ void GetPerStoreFeaturesFromStates(const Array<State>& states, const std::vector
 
   std::atomic<int> error_ct(0);
 
-  support::parallel_for(skip_first_n_feature_extraction, states.size(),
-                        [&tasks, &states, &max_n_bufs, &features, &error_ct](int i) {
-                          GetPerStoreFeaturesWorkerFunc(tasks[i], states[i], max_n_bufs,
-                                                        &(*features)[i], &error_ct);
-                        });
+  support::parallel_for_dynamic(
+      skip_first_n_feature_extraction, states.size(), NumFeatureThreads(),
+      [&tasks, &states, &max_n_bufs, &features, &error_ct](int thread_id, int i) {
+        GetPerStoreFeaturesWorkerFunc(tasks[i], states[i], max_n_bufs, &(*features)[i], &error_ct);
+      });
 }
 
 void GetPerStoreFeaturesFromFile(const std::string& filename, int max_lines, int max_n_bufs,
@@ -1634,12 +1849,17 @@ TVM_REGISTER_GLOBAL("auto_scheduler.GetPerStoreFeaturesFromStates")
                                std::move(task_ids), &byte_data);
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.ClearFeatureCache").set_body_typed([]() {
+  FeatureCache::Global()->Clear();
+});
+
 TVM_REGISTER_GLOBAL("auto_scheduler.GetPerStoreFeatureNames")
     .set_body([](TVMArgs args, TVMRetValue* ret) {
       int max_n_bufs = args[0];
+      bool texture_features = args.size() > 1 ? args[1] : false;
       std::vector<std::string> names;
 
-      GetPerStoreFeatureName(max_n_bufs, &names);
+      GetPerStoreFeatureName(max_n_bufs, &names, texture_features);
 
       Array<String> arr;
       for (const auto& x : names) {
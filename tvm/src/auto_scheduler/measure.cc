@@ -26,6 +26,7 @@
 #include <tvm/runtime/registry.h>
 
 #include <algorithm>
+#include <future>
 
 #include "search_policy/empty_policy.h"
 #include "search_policy/sketch_policy.h"
@@ -45,6 +46,7 @@ TVM_REGISTER_OBJECT_TYPE(ProgramMeasurerNode);
 TVM_REGISTER_OBJECT_TYPE(LocalBuilderNode);
 TVM_REGISTER_OBJECT_TYPE(LocalRunnerNode);
 TVM_REGISTER_OBJECT_TYPE(RPCRunnerNode);
+TVM_REGISTER_OBJECT_TYPE(MultiDeviceRunnerNode);
 
 static const char* ErrorNoToStr[] = {
     "NoError",
@@ -186,6 +188,204 @@ Array<MeasureResult> RPCRunnerNode::Run(const Array<MeasureInput>& inputs,
   return Array<MeasureResult>();
 }
 
+/********** MultiDeviceRunner **********/
+MultiDeviceRunner::MultiDeviceRunner(Array<ProgramRunner> runners, double outlier_threshold,
+                                     int quarantine_rounds) {
+  ICHECK(!runners.empty()) << "MultiDeviceRunner needs at least one device runner";
+  auto node = make_object<MultiDeviceRunnerNode>();
+  const ProgramRunnerNode* first = runners[0].operator->();
+  node->timeout = first->timeout;
+  node->number = first->number;
+  node->repeat = first->repeat;
+  node->min_repeat_ms = first->min_repeat_ms;
+  node->cooldown_interval = first->cooldown_interval;
+  node->enable_cpu_cache_flush = first->enable_cpu_cache_flush;
+  node->runners = std::move(runners);
+  node->outlier_threshold = outlier_threshold;
+  node->quarantine_rounds = quarantine_rounds;
+  data_ = std::move(node);
+}
+
+Array<MeasureResult> MultiDeviceRunnerNode::Run(const Array<MeasureInput>& inputs,
+                                                const Array<BuildResult>& build_results,
+                                                int verbose) {
+  ICHECK_EQ(inputs.size(), build_results.size());
+  size_t n_devices = runners.size();
+  if (quarantine_.size() != n_devices) {
+    quarantine_.assign(n_devices, 0);
+    speed_factors_.assign(n_devices, 1.0);
+  }
+
+  std::vector<size_t> active;
+  for (size_t d = 0; d < n_devices; ++d) {
+    if (quarantine_[d] > 0) {
+      quarantine_[d]--;
+    } else {
+      active.push_back(d);
+    }
+  }
+  if (active.empty()) {
+    StdCout(verbose) << "MultiDeviceRunner: All devices are quarantined, using all of them"
+                     << std::endl;
+    for (size_t d = 0; d < n_devices; ++d) {
+      quarantine_[d] = 0;
+      active.push_back(d);
+    }
+  }
+  size_t n_active = active.size();
+
+  // The reference program is the first one that built successfully. It is measured on every
+  // device so their speeds can be compared.
+  int reference = -1;
+  for (size_t i = 0; i < build_results.size(); ++i) {
+    if (build_results[i]->error_no == static_cast<int>(MeasureErrorNO::kNoError)) {
+      reference = i;
+      break;
+    }
+  }
+
+  // Shard the batch round robin
+  std::vector<std::vector<int>> shards(n_active);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    shards[i % n_active].push_back(i);
+  }
+  size_t reference_owner = reference >= 0 ? reference % n_active : 0;
+  if (reference >= 0 && n_active > 1) {
+    for (size_t k = 0; k < n_active; ++k) {
+      if (k != reference_owner) {
+        shards[k].push_back(reference);
+      }
+    }
+  }
+
+  auto run_shard = [this, &inputs, &build_results, verbose](size_t device,
+                                                            const std::vector<int>& shard) {
+    Array<MeasureInput> shard_inputs;
+    Array<BuildResult> shard_builds;
+    for (int i : shard) {
+      shard_inputs.push_back(inputs[i]);
+      shard_builds.push_back(build_results[i]);
+    }
+    Array<MeasureResult> res = runners[device]->Run(shard_inputs, shard_builds, verbose);
+    ICHECK_EQ(res.size(), shard.size());
+    return res;
+  };
+
+  // Measure all the shards concurrently
+  std::vector<std::future<Array<MeasureResult>>> futures;
+  for (size_t k = 0; k < n_active; ++k) {
+    if (!shards[k].empty()) {
+      futures.push_back(std::async(std::launch::async, run_shard, active[k], shards[k]));
+    } else {
+      futures.emplace_back();
+    }
+  }
+  std::vector<Array<MeasureResult>> shard_results(n_active);
+  std::vector<bool> failed(n_active, false);
+  for (size_t k = 0; k < n_active; ++k) {
+    if (!futures[k].valid()) {
+      continue;
+    }
+    try {
+      shard_results[k] = futures[k].get();
+    } catch (std::exception& e) {
+      StdCout(verbose) << "MultiDeviceRunner: Device " << active[k] << " failed: " << e.what()
+                       << std::endl;
+      failed[k] = true;
+    }
+  }
+
+  // Compare the reference timing of every device to the median one
+  if (reference >= 0 && n_active > 1) {
+    std::vector<double> ref_costs(n_active, -1.0);
+    std::vector<double> valid_costs;
+    for (size_t k = 0; k < n_active; ++k) {
+      if (failed[k] || shard_results[k].empty()) {
+        continue;
+      }
+      size_t j = std::find(shards[k].begin(), shards[k].end(), reference) - shards[k].begin();
+      const MeasureResult& res = shard_results[k][j];
+      if (res->error_no == static_cast<int>(MeasureErrorNO::kNoError)) {
+        ref_costs[k] = FloatArrayMean(res->costs);
+        valid_costs.push_back(ref_costs[k]);
+      }
+    }
+    if (valid_costs.size() > 1) {
+      std::nth_element(valid_costs.begin(), valid_costs.begin() + valid_costs.size() / 2,
+                       valid_costs.end());
+      double median = valid_costs[valid_costs.size() / 2];
+      for (size_t k = 0; k < n_active; ++k) {
+        if (ref_costs[k] > 0 && median > 0) {
+          speed_factors_[active[k]] = ref_costs[k] / median;
+        }
+      }
+    }
+  }
+
+  // Quarantine the failed and the too slow devices
+  int healthy = -1;
+  for (size_t k = 0; k < n_active; ++k) {
+    size_t d = active[k];
+    if (failed[k] || speed_factors_[d] > outlier_threshold) {
+      StdCout(verbose) << "MultiDeviceRunner: Quarantine device " << d << " for "
+                       << quarantine_rounds << " batches (speed factor " << speed_factors_[d]
+                       << (failed[k] ? ", failed)" : ")") << std::endl;
+      quarantine_[d] = quarantine_rounds;
+    } else if (healthy < 0) {
+      healthy = k;
+    }
+  }
+
+  // Gather the results in the original order, normalized to the speed of the median device
+  Array<MeasureResult> results(inputs.size(), MeasureResult());
+  for (size_t k = 0; k < n_active; ++k) {
+    std::vector<int> shard;
+    for (int i : shards[k]) {
+      if (i != reference || k == reference_owner) {
+        shard.push_back(i);
+      }
+    }
+    if (shard.empty()) {
+      continue;
+    }
+    Array<MeasureResult> res = shard_results[k];
+    double factor = speed_factors_[active[k]];
+    if (failed[k]) {
+      // Retry the shard of a failed device once on a healthy one
+      std::string error_msg = "No healthy device is left";
+      if (healthy >= 0) {
+        factor = speed_factors_[active[healthy]];
+        try {
+          res = run_shard(active[healthy], shard);
+        } catch (std::exception& e) {
+          error_msg = e.what();
+        }
+      }
+      if (res.size() != shard.size()) {
+        res = Array<MeasureResult>();
+        for (size_t j = 0; j < shard.size(); ++j) {
+          res.push_back(MeasureResult(Array<PrimExpr>{FloatImm(DataType::Float(64), 1e10)},
+                                      static_cast<int>(MeasureErrorNO::kRuntimeDeviceError),
+                                      error_msg, 0.0, 0.0));
+        }
+      }
+    }
+    for (size_t j = 0; j < shard.size(); ++j) {
+      MeasureResult result = res[j];
+      if (result->error_no == static_cast<int>(MeasureErrorNO::kNoError) && factor != 1.0) {
+        Array<PrimExpr> costs;
+        for (const auto& cost : result->costs) {
+          costs.push_back(FloatImm(DataType::Float(64), Downcast<FloatImm>(cost)->value / factor));
+        }
+        result = MeasureResult(costs, result->error_no, result->error_msg, result->all_cost,
+                               result->timestamp);
+      }
+      results.Set(shard[j], result);
+    }
+  }
+  return results;
+}
+
 /********** MeasureCallback **********/
 PythonBasedMeasureCallback::PythonBasedMeasureCallback(PackedFunc callback_func) {
   auto node = make_object<PythonBasedMeasureCallbackNode>();
@@ -246,13 +446,35 @@ Array<MeasureResult> ProgramMeasurerNode::Measure(const SearchTask& task,
 
   StdCout(verbose) << "Get " << inputs.size() << " programs to measure:" << std::endl;
 
+  // A remote runner keeps the host idle while it measures, so build the next batch meanwhile.
+  // A local runner shares the host with the builder, overlapping them would disturb the timing.
+  bool overlap_build =
+      runner->IsInstance<RPCRunnerNode>() || runner->IsInstance<MultiDeviceRunnerNode>();
+  std::future<Array<BuildResult>> next_build;
+  auto get_batch = [&inputs, batch_size](size_t i) {
+    return Array<MeasureInput>(inputs.begin() + i,
+                               inputs.begin() + std::min(i + batch_size, inputs.size()));
+  };
+
   for (size_t i = 0; i < inputs.size(); i += batch_size) {
-    Array<MeasureInput> input_batch(inputs.begin() + i,
-                                    inputs.begin() + std::min(i + batch_size, inputs.size()));
+    Array<MeasureInput> input_batch = get_batch(i);
     Array<MeasureResult> result_batch;
 
     // build and run
-    SilentMeasure(task, input_batch, &result_batch);
+    if (overlap_build) {
+      Array<BuildResult> build_batch =
+          next_build.valid() ? next_build.get() : builder->Build(input_batch, verbose);
+      if (i + batch_size < inputs.size()) {
+        next_build = std::async(std::launch::async,
+                                [builder = builder, next_batch = get_batch(i + batch_size),
+                                 build_verbose = verbose]() {
+                                  return builder->Build(next_batch, build_verbose);
+                                });
+      }
+      result_batch = runner->Run(input_batch, build_batch, verbose);
+    } else {
+      SilentMeasure(task, input_batch, &result_batch);
+    }
 
     // update current best state according to the new measure result
     for (size_t j = 0; j < input_batch.size(); ++j) {
@@ -422,5 +644,11 @@ TVM_REGISTER_GLOBAL("auto_scheduler.RPCRunner")
                        min_repeat_ms, cooldown_interval, enable_cpu_cache_flush);
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.MultiDeviceRunner")
+    .set_body_typed([](Array<ProgramRunner> runners, double outlier_threshold,
+                       int quarantine_rounds) {
+      return MultiDeviceRunner(runners, outlier_threshold, quarantine_rounds);
+    });
+
 }  // namespace auto_scheduler
 }  // namespace tvm
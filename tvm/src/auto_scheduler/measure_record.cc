@@ -29,6 +29,7 @@
 #include <tvm/runtime/registry.h>
 
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -305,6 +306,8 @@ namespace auto_scheduler {
 
 TVM_REGISTER_OBJECT_TYPE(RecordToFileNode);
 TVM_REGISTER_OBJECT_TYPE(RecordReaderNode);
+TVM_REGISTER_OBJECT_TYPE(RecordStoreNode);
+TVM_REGISTER_OBJECT_TYPE(RecordToStoreNode);
 
 RecordToFile::RecordToFile(String filename) {
   auto node = make_object<RecordToFileNode>();
@@ -399,6 +402,244 @@ std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordReaderNode::ReadLines
   return std::make_pair(inputs, results);
 }
 
+/********** Record store **********/
+
+/*! \brief The magic number at the beginning of every record of a record store. */
+constexpr uint64_t kRecordStoreMagic = 0x54564D5245434F52;  // "TVMRECOR"
+/*! \brief The magic number at the beginning of the index file of a record store. */
+constexpr uint64_t kRecordIndexMagic = 0x54564D5245434958;  // "TVMRECIX"
+
+template <typename T>
+static void WritePOD(std::ostream* os, const T& value) {
+  os->write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool ReadPOD(std::istream* is, T* value) {
+  return static_cast<bool>(is->read(reinterpret_cast<char*>(value), sizeof(T)));
+}
+
+static void WriteBytes(std::ostream* os, const std::string& str) {
+  WritePOD(os, static_cast<uint64_t>(str.size()));
+  os->write(str.data(), str.size());
+}
+
+static bool ReadBytes(std::istream* is, std::string* str) {
+  uint64_t size;
+  if (!ReadPOD(is, &size)) return false;
+  str->resize(size);
+  return size == 0 || static_cast<bool>(is->read(&(*str)[0], size));
+}
+
+/*! \brief The index key of a workload on a target. */
+static std::string RecordStoreKey(const String& workload_key, const Target& target) {
+  return std::string(workload_key) + "\n" + std::string(target->str());
+}
+
+/*! \brief The mean cost of a result, infinite for the failed measurements. */
+static double RecordStoreCost(const MeasureResultNode& res) {
+  if (res.error_no != static_cast<int>(MeasureErrorNO::kNoError) || res.costs.empty()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  double sum = 0;
+  for (const auto& x : res.costs) {
+    sum += Downcast<FloatImm>(x)->value;
+  }
+  return sum / res.costs.size();
+}
+
+/*!
+ * \brief Read the record at the current position of a record file.
+ * \return Whether a whole record was read, false at the end of the file.
+ */
+static bool ReadStoreRecord(std::istream* is, std::string* key, double* cost,
+                            std::string* record) {
+  uint64_t magic;
+  if (!ReadPOD(is, &magic)) return false;
+  ICHECK_EQ(magic, kRecordStoreMagic) << "Invalid record in the record store";
+  return ReadBytes(is, key) && ReadPOD(is, cost) && ReadBytes(is, record);
+}
+
+static void WriteStoreRecord(std::ostream* os, const std::string& key, double cost,
+                             const std::string& record) {
+  WritePOD(os, kRecordStoreMagic);
+  WriteBytes(os, key);
+  WritePOD(os, cost);
+  WriteBytes(os, record);
+}
+
+RecordStore::RecordStore(String filename) {
+  auto node = make_object<RecordStoreNode>();
+  node->filename = std::move(filename);
+  node->Load();
+  data_ = std::move(node);
+}
+
+void RecordStoreNode::Load() {
+  index_.clear();
+  indexed_size_ = 0;
+  std::ifstream fs(std::string(filename) + ".index", std::ios::binary);
+  uint64_t magic, size, num;
+  if (fs && ReadPOD(&fs, &magic) && magic == kRecordIndexMagic && ReadPOD(&fs, &size) &&
+      ReadPOD(&fs, &num)) {
+    std::string key;
+    IndexEntry entry;
+    for (uint64_t i = 0; i < num; ++i) {
+      if (!ReadBytes(&fs, &key) || !ReadPOD(&fs, &entry.offset) || !ReadPOD(&fs, &entry.cost)) {
+        LOG(WARNING) << "Truncated index of the record store " << filename << ", rebuilding it";
+        index_.clear();
+        size = 0;
+        break;
+      }
+      index_[key] = entry;
+    }
+    indexed_size_ = size;
+  }
+  std::ifstream data(filename, std::ios::binary | std::ios::ate);
+  uint64_t data_size = data ? static_cast<uint64_t>(data.tellg()) : 0;
+  if (data_size < indexed_size_) {
+    // The file was replaced since the index was written.
+    index_.clear();
+    indexed_size_ = 0;
+  }
+  if (data_size > indexed_size_) {
+    Scan(indexed_size_);
+    SaveIndex();
+  }
+}
+
+void RecordStoreNode::Scan(uint64_t begin) {
+  std::ifstream fs(filename, std::ios::binary | std::ios::ate);
+  if (!fs) return;
+  uint64_t size = static_cast<uint64_t>(fs.tellg());
+  fs.seekg(begin);
+  std::string key, record;
+  double cost;
+  uint64_t offset = begin;
+  while (ReadStoreRecord(&fs, &key, &cost, &record)) {
+    UpdateIndex(key, offset, cost);
+    offset = static_cast<uint64_t>(fs.tellg());
+  }
+  indexed_size_ = offset;
+  if (offset != size) {
+    LOG(WARNING) << "Truncated record at offset " << offset << " of the record store "
+                 << filename;
+  }
+}
+
+uint64_t RecordStoreNode::BeginAppend(std::ofstream* fs) {
+  // Index the records appended by others since the last write.
+  Scan(indexed_size_);
+  fs->open(filename, std::ios::binary | std::ios::app);
+  ICHECK(!fs->fail()) << "Cannot open the record store " << filename;
+  fs->seekp(0, std::ios::end);
+  uint64_t size = static_cast<uint64_t>(fs->tellp());
+  ICHECK_EQ(size, indexed_size_) << "The record store " << filename
+                                 << " ends with a truncated record, remove the bytes after "
+                                 << indexed_size_ << " to append to it";
+  return size;
+}
+
+void RecordStoreNode::UpdateIndex(const std::string& key, uint64_t offset, double cost) {
+  if (cost == std::numeric_limits<double>::infinity()) return;
+  auto it = index_.find(key);
+  if (it == index_.end() || cost < it->second.cost) {
+    index_[key] = {offset, cost};
+  }
+}
+
+void RecordStoreNode::SaveIndex() const {
+  std::string path = std::string(filename) + ".index";
+  std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+  if (fs.fail()) {
+    LOG(WARNING) << "Cannot write the index of the record store " << path;
+    return;
+  }
+  WritePOD(&fs, kRecordIndexMagic);
+  WritePOD(&fs, indexed_size_);
+  WritePOD(&fs, static_cast<uint64_t>(index_.size()));
+  for (const auto& kv : index_) {
+    WriteBytes(&fs, kv.first);
+    WritePOD(&fs, kv.second.offset);
+    WritePOD(&fs, kv.second.cost);
+  }
+}
+
+void RecordStoreNode::Append(const Array<MeasureInput>& inputs,
+                             const Array<MeasureResult>& results) {
+  ICHECK_EQ(inputs.size(), results.size());
+  std::ofstream fs;
+  BeginAppend(&fs);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    std::ostringstream record;
+    WriteMeasureRecords(&record, {inputs[i]}, {results[i]});
+    const SearchTask& task = inputs[i]->task;
+    std::string key = RecordStoreKey(task->workload_key, task->target);
+    double cost = RecordStoreCost(*results[i].get());
+    uint64_t offset = static_cast<uint64_t>(fs.tellp());
+    WriteStoreRecord(&fs, key, cost, record.str());
+    UpdateIndex(key, offset, cost);
+  }
+  indexed_size_ = static_cast<uint64_t>(fs.tellp());
+  fs.close();
+  SaveIndex();
+}
+
+void RecordStoreNode::Merge(const String& other_filename) {
+  std::ifstream is(other_filename, std::ios::binary);
+  ICHECK(!is.fail()) << "Cannot open the record store " << other_filename;
+  std::ofstream fs;
+  BeginAppend(&fs);
+  std::string key, record;
+  double cost;
+  while (ReadStoreRecord(&is, &key, &cost, &record)) {
+    uint64_t offset = static_cast<uint64_t>(fs.tellp());
+    WriteStoreRecord(&fs, key, cost, record);
+    UpdateIndex(key, offset, cost);
+  }
+  indexed_size_ = static_cast<uint64_t>(fs.tellp());
+  fs.close();
+  SaveIndex();
+}
+
+void RecordStoreNode::ImportLog(const String& log_filename) {
+  RecordReader reader(log_filename);
+  ICHECK(reader->infile.is_open()) << "Cannot open the log file " << log_filename;
+  // Append in batches to bound the memory of large logs.
+  constexpr int kBatchSize = 4096;
+  while (true) {
+    auto batch = reader->ReadLines(kBatchSize);
+    if (batch.first.empty()) break;
+    Append(batch.first, batch.second);
+  }
+}
+
+bool RecordStoreNode::QueryBest(const String& workload_key, const Target& target,
+                                MeasureInputNode* inp, MeasureResultNode* res) {
+  auto it = index_.find(RecordStoreKey(workload_key, target));
+  if (it == index_.end()) return false;
+  std::ifstream fs(filename, std::ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open the record store " << filename;
+  fs.seekg(it->second.offset);
+  std::string key, record, log_version;
+  double cost;
+  ICHECK(ReadStoreRecord(&fs, &key, &cost, &record))
+      << "Invalid index of the record store " << filename;
+  ReadMeasureRecord(record, inp, res, &log_version);
+  return true;
+}
+
+RecordToStore::RecordToStore(String filename) {
+  auto node = make_object<RecordToStoreNode>();
+  node->store = RecordStore(std::move(filename));
+  data_ = std::move(node);
+}
+
+void RecordToStoreNode::Callback(const SearchPolicy& policy, const Array<MeasureInput>& inputs,
+                                 const Array<MeasureResult>& results) {
+  store->Append(inputs, results);
+}
+
 TVM_REGISTER_GLOBAL("auto_scheduler.RecordToFile").set_body_typed([](const String& filename) {
   return RecordToFile(filename);
 });
@@ -440,6 +681,35 @@ TVM_REGISTER_GLOBAL("auto_scheduler.WriteMeasureRecords")
       return String(ss.str());
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStore").set_body_typed([](const String& filename) {
+  return RecordStore(filename);
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreAppend")
+    .set_body_typed([](RecordStore store, Array<MeasureInput> in, Array<MeasureResult> res) {
+      store->Append(in, res);
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreMerge")
+    .set_body_typed([](RecordStore store, String other_filename) { store->Merge(other_filename); });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreImportLog")
+    .set_body_typed([](RecordStore store, String log_filename) { store->ImportLog(log_filename); });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordStoreQueryBest")
+    .set_body_typed([](RecordStore store, String workload_key, Target target) {
+      auto inp = make_object<MeasureInputNode>();
+      auto res = make_object<MeasureResultNode>();
+      if (store->QueryBest(workload_key, target, inp.get(), res.get())) {
+        return Array<ObjectRef>{ObjectRef(inp), ObjectRef(res)};
+      }
+      return Array<ObjectRef>();
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordToStore").set_body_typed([](const String& filename) {
+  return RecordToStore(filename);
+});
+
 TVM_REGISTER_GLOBAL("auto_scheduler.SaveRecords")
     .set_body_typed([](String filename, Array<MeasureInput> in, Array<MeasureResult> res) {
       std::ofstream ofs(filename, std::ofstream::app);
@@ -26,6 +26,10 @@
 #include <tvm/auto_scheduler/search_policy.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
 #include "utils.h"
 
 namespace tvm {
@@ -34,6 +38,25 @@ namespace auto_scheduler {
 TVM_REGISTER_OBJECT_TYPE(SearchCallbackNode);
 TVM_REGISTER_OBJECT_TYPE(SearchPolicyNode);
 TVM_REGISTER_OBJECT_TYPE(PreloadMeasuredStatesNode);
+TVM_REGISTER_OBJECT_TYPE(PreloadSimilarStatesNode);
+
+/*!
+ * \brief Get a key describing the structure of a compute DAG. Two DAGs with the same key have the
+ * same stages and iterators, so the transform steps of one can be replayed on the other.
+ */
+static std::string GetDAGStructureKey(const ComputeDAG& dag) {
+  std::ostringstream os;
+  for (const auto& op : dag->ops) {
+    if (const auto* pop = op.as<te::PlaceholderOpNode>()) {
+      os << "P" << pop->shape.size() << ";";
+    } else if (const auto* cop = op.as<te::ComputeOpNode>()) {
+      os << cop->name << "(" << cop->axis.size() << "," << cop->reduce_axis.size() << ");";
+    } else {
+      os << op->GetTypeKey() << ";";
+    }
+  }
+  return os.str();
+}
 
 void SearchPolicyNode::PreloadMeasuredStates(const String& log_file) {
   RecordReader reader = RecordReader(log_file);
@@ -81,6 +104,95 @@ void SearchPolicyNode::PreloadMeasuredStates(const String& log_file) {
   }
 }
 
+void SearchPolicyNode::PreloadSimilarStates(const String& log_file, int max_states) {
+  const auto* workload_key_to_tensors =
+      tvm::runtime::Registry::Get("auto_scheduler.workload_key_to_tensors");
+  if (workload_key_to_tensors == nullptr) {
+    StdCout(verbose) << "SearchPolicy: Cannot rebuild the workloads of " << log_file
+                     << ", no similar states are loaded" << std::endl;
+    return;
+  }
+
+  RecordReader reader = RecordReader(log_file);
+  const auto& res = reader->ReadLines(-1);
+  const std::string target_key = search_task->target->kind->name;
+  const std::string structure_key = GetDAGStructureKey(search_task->compute_dag);
+
+  // workload_key -> whether its DAG has the same structure as the current one
+  std::unordered_map<std::string, bool> similar;
+  // workload_key -> the min cost of the workload, to normalize the throughputs
+  std::unordered_map<std::string, double> min_costs;
+  std::vector<size_t> candidates;
+  size_t n_similar = 0;
+  for (size_t i = 0; i < res.first.size(); i++) {
+    const auto& inp = res.first[i];
+    const auto& workload_key = inp->task->workload_key;
+    if (res.second[i]->error_no != 0 || workload_key == search_task->workload_key ||
+        inp->task->target->kind->name != target_key) {
+      continue;
+    }
+    auto it = similar.find(workload_key);
+    if (it == similar.end()) {
+      bool is_similar = false;
+      try {
+        Array<te::Tensor> tensors = (*workload_key_to_tensors)(workload_key);
+        is_similar = GetDAGStructureKey(ComputeDAG(tensors)) == structure_key;
+      } catch (std::exception& e) {
+        // The workload is not registered in this process
+      }
+      it = similar.emplace(workload_key, is_similar).first;
+      n_similar += is_similar;
+      if (is_similar) similar_workload_keys_.push_back(workload_key);
+    }
+    if (!it->second) {
+      continue;
+    }
+    double cost = FloatArrayMean(res.second[i]->costs);
+    auto min_it = min_costs.find(workload_key);
+    if (min_it == min_costs.end()) {
+      min_costs.emplace(workload_key, cost);
+    } else {
+      min_it->second = std::min(min_it->second, cost);
+    }
+    candidates.push_back(i);
+  }
+
+  // Keep the best states of every similar workload
+  std::vector<float> normalized_throughputs;
+  for (size_t i : candidates) {
+    normalized_throughputs.push_back(min_costs.at(res.first[i]->task->workload_key) /
+                                     FloatArrayMean(res.second[i]->costs));
+  }
+  std::vector<int> indices = Argsort(normalized_throughputs);
+  size_t n_loaded = 0;
+  for (size_t k = 0; k < indices.size() && n_loaded < static_cast<size_t>(max_states); k++) {
+    const auto& inp = res.first[candidates[indices[k]]];
+    State state = search_task->compute_dag->init_state;
+    try {
+      auto pstate = state.CopyOnWrite();
+      pstate->transform_steps = inp->state->transform_steps;
+      for (const auto& step : pstate->transform_steps) {
+        StepApplyToState(step, &state, search_task->compute_dag);
+      }
+      state = search_task->compute_dag.InferBound(state);
+    } catch (dmlc::Error& e) {
+      // The steps do not fit the shapes of the current workload
+      continue;
+    }
+    const auto& state_str = state.ToStr();
+    if (measured_states_set_.count(state_str)) {
+      continue;
+    }
+    similar_states_vector_.push_back(std::move(state));
+    similar_states_throughputs_.push_back(normalized_throughputs[indices[k]]);
+    n_loaded++;
+  }
+
+  StdCout(verbose) << "SearchPolicy: Loaded " << n_loaded << " states of " << n_similar
+                   << " similar workloads from " << log_file << " for "
+                   << search_task->workload_key << std::endl;
+}
+
 void SearchPolicyNode::RunCallbacks(const Array<SearchCallback>& callbacks) {
   for (const auto& callback : callbacks) {
     callback->Callback(this);
@@ -97,6 +209,17 @@ void PreloadMeasuredStatesNode::Callback(SearchPolicyNode* policy) {
   policy->PreloadMeasuredStates(filename);
 }
 
+PreloadSimilarStates::PreloadSimilarStates(String filename, int max_states) {
+  auto node = make_object<PreloadSimilarStatesNode>();
+  node->filename = std::move(filename);
+  node->max_states = max_states;
+  data_ = std::move(node);
+}
+
+void PreloadSimilarStatesNode::Callback(SearchPolicyNode* policy) {
+  policy->PreloadSimilarStates(filename, max_states);
+}
+
 TVM_REGISTER_GLOBAL("auto_scheduler.SearchPolicyRunCallbacks")
     .set_body_typed([](SearchPolicy policy, Optional<Array<SearchCallback>> callbacks) {
       if (callbacks) {
@@ -119,5 +242,10 @@ TVM_REGISTER_GLOBAL("auto_scheduler.PreloadMeasuredStates").set_body_typed([](St
   return PreloadMeasuredStates(filename);
 });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.PreloadSimilarStates")
+    .set_body_typed([](String filename, int max_states) {
+      return PreloadSimilarStates(filename, max_states);
+    });
+
 }  // namespace auto_scheduler
 }  // namespace tvm
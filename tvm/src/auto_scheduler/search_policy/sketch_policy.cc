@@ -30,6 +30,7 @@
 #include <tvm/support/parallel_for.h>
 
 #include <algorithm>
+#include <future>
 #include <iomanip>
 #include <limits>
 #include <memory>
@@ -52,6 +53,7 @@ static RuleAlwaysInline rule_always_inline;
 static RuleMultiLevelTiling rule_multi_level_tiling;
 static RuleMultiLevelTilingWithFusion rule_multi_level_tiling_with_fusion;
 static RuleAddCacheRead rule_add_cache_read_stage;
+static RuleAddTextureCacheRead rule_add_texture_cache_read_stage;
 static RuleAddCacheWrite rule_add_cache_write_stage;
 static RuleAddRfactor rule_add_rfactor;
 static RuleCrossThreadReduction rule_cross_thread_reduction;
@@ -65,6 +67,7 @@ static InitParallel init_parallel;
 static InitUnroll init_unroll;
 static InitVectorization init_vectorization;
 static InitThreadBind init_thread_bind;
+static InitBuildOptions init_build_options;
 
 /********** Sketch policy **********/
 TVM_REGISTER_NODE_TYPE(SketchPolicyNode);
@@ -86,6 +89,8 @@ SketchPolicy::SketchPolicy(SearchTask task, CostModel program_cost_model,
     // Candidates:
     // - auto_scheduler.PreloadMeasuredStates: Load already measured states to
     //   `measured_states_set_`, `measured_states_vector_` and `measured_states_throughputs_`.
+    // - auto_scheduler.PreloadSimilarStates: Load the good states of similar workloads to
+    //   `similar_states_vector_` and pre-train `program_cost_model` on their records.
     // - auto_scheduler.PreloadCustomSketchRule: Add user custom sketch rules to `sketch_rules`,
     //   these rules will be processed prior to the default rules.
     node->RunCallbacks(init_search_callbacks.value());
@@ -126,6 +131,9 @@ SketchPolicy::SketchPolicy(SearchTask task, CostModel program_cost_model,
       node->sketch_rules.push_back(&rule_multi_level_tiling);
       node->sketch_rules.push_back(&rule_skip_stage);
     } else {
+      if (node->search_task->target->GetAttr<String>("device", "") == "adreno") {
+        node->sketch_rules.push_back(&rule_add_texture_cache_read_stage);
+      }
       node->sketch_rules.push_back(&rule_add_cache_read_stage);
       node->sketch_rules.push_back(&rule_special_compute_location_gpu);
       node->sketch_rules.push_back(&rule_always_inline);
@@ -146,9 +154,18 @@ SketchPolicy::SketchPolicy(SearchTask task, CostModel program_cost_model,
       node->init_rules.push_back(&init_vectorization);
     }
 
+    bool tune_build_options = node->search_task->target->kind->name == "opencl" &&
+                              node->params.count(SketchParamKey::build_options);
+    if (tune_build_options) {
+      node->init_rules.push_back(&init_build_options);
+    }
+
     // Mutation Rules for Evolutionary Search
     node->mutation_rules.push_back(std::make_shared<MutateTileSize>(0.90));
     node->mutation_rules.push_back(std::make_shared<MutateAutoUnroll>(0.10));
+    if (tune_build_options) {
+      node->mutation_rules.push_back(std::make_shared<MutateBuildOptions>(0.05));
+    }
   } else {
     LOG(FATAL) << "No default sketch rules for target: " << task->target;
   }
@@ -176,6 +193,41 @@ State SketchPolicyNode::Search(int n_trials, int early_stopping, int num_measure
     Array<State> best_states, random_states;
     Array<MeasureInput> inputs;
     Array<MeasureResult> results;
+
+    // When pipelined, the candidates of a round are measured in the background while the next
+    // round is searched with the cost model trained one round earlier.
+    bool pipeline = params.count(SketchParamKey::pipeline_measure) &&
+                    GetIntParam(params, SketchParamKey::pipeline_measure);
+    std::future<Array<MeasureResult>> pending_results;
+    Array<MeasureInput> pending_inputs;
+
+    // Book keep a finished measurement round. Returns whether to stop early.
+    auto finish_round = [&](Array<MeasureInput> round_inputs, Array<MeasureResult> round_results) {
+      inputs = std::move(round_inputs);
+      results = std::move(round_results);
+      ct += inputs.size();
+
+      // Check if reach the early stopping condition
+      if (ct - measurer->best_ct[search_task->workload_key] > early_stopping &&
+          measurer->has_valid.count(search_task->workload_key)) {
+        StdCout(verbose) << "Stop early since no performance improvement in the last "
+                         << early_stopping << " measurements trials.\n";
+        return true;
+      }
+
+      // Update measured states throughputs. These states will join the EvolutionarySearch in later
+      // search rounds.
+      for (const auto& res : results) {
+        measured_states_throughputs_.push_back(1.0 / FloatArrayMean(res->costs));
+      }
+      return false;
+    };
+    auto wait_pending = [&]() {
+      Array<MeasureInput> round_inputs = std::move(pending_inputs);
+      pending_inputs = Array<MeasureInput>();
+      return finish_round(std::move(round_inputs), pending_results.get());
+    };
+
     while (ct < n_trials) {
       if (!inputs.empty()) {
         auto t_begin = std::chrono::high_resolution_clock::now();
@@ -183,10 +235,19 @@ State SketchPolicyNode::Search(int n_trials, int early_stopping, int num_measure
         // Retrain the cost model before the next search round
         PrintTitle("Train cost model", verbose);
         program_cost_model->Update(inputs, results);
+        inputs = Array<MeasureInput>();
 
         PrintTimeElapsed(t_begin, "training", verbose);
       }
 
+      if (pending_results.valid() && ct + static_cast<int>(pending_inputs.size()) >= n_trials) {
+        // The trials are used up, only the measurement in flight is left
+        if (wait_pending()) {
+          break;
+        }
+        continue;
+      }
+
       // Search one round to get promising states
       PrintTitle("Search", verbose);
       best_states = SearchOneRound(num_random * 3, &random_states);
@@ -197,11 +258,19 @@ State SketchPolicyNode::Search(int n_trials, int early_stopping, int num_measure
 
       // Pick `num_measure_per_iter` states to measure, check hash to remove already measured state
       // Also pick some random states to do eps-greedy
-      inputs = PickStatesWithEpsGreedy(best_states, random_states, n_trials - ct);
+      Array<MeasureInput> new_inputs = PickStatesWithEpsGreedy(
+          best_states, random_states, n_trials - ct - static_cast<int>(pending_inputs.size()));
 
       // Currently it's hard to detect if all of the search space has been traversed
       // Stop if no extra valid states found in several retries
-      if (inputs.empty()) {
+      if (new_inputs.empty()) {
+        if (pending_results.valid()) {
+          // The measurement in flight may still guide the next round
+          if (wait_pending()) {
+            break;
+          }
+          continue;
+        }
         if (empty_retry_count-- > 0) {
           continue;
         } else {
@@ -216,23 +285,25 @@ State SketchPolicyNode::Search(int n_trials, int early_stopping, int num_measure
 
       // Measure candidate states
       PrintTitle("Measure", verbose);
-      results = measurer->Measure(search_task, GetRef<SearchPolicy>(this), inputs);
-      ct += inputs.size();
-
-      // Check if reach the early stopping condition
-      if (ct - measurer->best_ct[search_task->workload_key] > early_stopping &&
-          measurer->has_valid.count(search_task->workload_key)) {
-        StdCout(verbose) << "Stop early since no performance improvement in the last "
-                         << early_stopping << " measurements trials.\n";
-        break;
-      }
-
-      // Update measured states throughputs. These states will join the EvolutionarySearch in later
-      // search rounds.
-      for (const auto& res : results) {
-        measured_states_throughputs_.push_back(1.0 / FloatArrayMean(res->costs));
+      if (pipeline) {
+        if (pending_results.valid() && wait_pending()) {
+          break;
+        }
+        pending_inputs = new_inputs;
+        pending_results = std::async(std::launch::async, [this, measurer, new_inputs]() {
+          return measurer->Measure(search_task, GetRef<SearchPolicy>(this), new_inputs);
+        });
+      } else {
+        Array<MeasureResult> new_results =
+            measurer->Measure(search_task, GetRef<SearchPolicy>(this), new_inputs);
+        if (finish_round(std::move(new_inputs), std::move(new_results))) {
+          break;
+        }
       }
     }
+    if (pending_results.valid()) {
+      wait_pending();
+    }
     PrintTitle("Done", verbose);
 
     return measurer->best_state[search_task->workload_key];
@@ -281,14 +352,27 @@ std::pair<Array<MeasureInput>, Array<MeasureResult>> SketchPolicyNode::ContinueS
   return std::make_pair(std::move(inputs), std::move(results));
 }
 
+void SketchPolicyNode::PreloadSimilarStates(const String& log_file, int max_states) {
+  SearchPolicyNode::PreloadSimilarStates(log_file, max_states);
+  // The records of similar workloads are useful training data for the cost model, the ones of
+  // unrelated workloads would only skew it
+  Array<String> workload_keys = similar_workload_keys_;
+  workload_keys.push_back(search_task->workload_key);
+  program_cost_model->UpdateFromFile(log_file, workload_keys);
+}
+
 Array<State> SketchPolicyNode::SearchOneRound(int num_random_states, Array<State>* random_states) {
   // Get parameters
   int population = GetIntParam(params, SketchParamKey::EvolutionarySearch::population);
-  int num_use_measured = std::min(
-      static_cast<int>(measured_states_vector_.size()),
-      static_cast<int>(
-          GetDoubleParam(params, SketchParamKey::SampleInitPopulation::use_measured_ratio) *
-          population));
+  int num_use_total = static_cast<int>(
+      GetDoubleParam(params, SketchParamKey::SampleInitPopulation::use_measured_ratio) *
+      population);
+  // Only the states whose measurement has finished have a throughput yet
+  int num_use_measured =
+      std::min(static_cast<int>(measured_states_throughputs_.size()), num_use_total);
+  // States transferred from similar workloads fill the slots own measurements do not use yet
+  int num_use_similar =
+      std::min(static_cast<int>(similar_states_vector_.size()), num_use_total - num_use_measured);
 
   // 1. Generate sketches
   if (sketch_cache_.empty()) {
@@ -304,6 +388,10 @@ Array<State> SketchPolicyNode::SearchOneRound(int num_random_states, Array<State
   for (int i = 0; i < num_use_measured; i++) {
     init_population.push_back(measured_states_vector_[indices[i]]);
   }
+  indices = Argsort(similar_states_throughputs_);
+  for (int i = 0; i < num_use_similar; i++) {
+    init_population.push_back(similar_states_vector_[indices[i]]);
+  }
   // Sample some random states for eps-greedy
   if (num_random_states > 0 && random_states != nullptr) {
     *random_states = RandomSampleStates(init_population, &rand_gen, num_random_states);
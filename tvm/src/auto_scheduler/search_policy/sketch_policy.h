@@ -55,6 +55,11 @@ struct SketchParamKey {
   static constexpr const char* eps_greedy = "eps_greedy";
   /*! \brief Retry several times if SearchOneRound gets no valid state. */
   static constexpr const char* empty_retry_count = "retry_search_one_round_on_empty";
+  /*!
+   * \brief Optional. Search the next round while the current one is being measured, with a cost
+   * model that lags one round behind.
+   */
+  static constexpr const char* pipeline_measure = "pipeline_measure";
 
   struct SampleInitPopulation {
     /*! \brief The minimal size of valid population in the initial sampling. */
@@ -85,6 +90,11 @@ struct SketchParamKey {
   static constexpr const char* max_vectorize_size = "max_vectorize_size";
   /*! \brief Whether disable compute location changing. */
   static constexpr const char* disable_change_compute_location = "disable_change_compute_location";
+  /*!
+   * \brief Optional. The candidate build options of OpenCL kernels, separated by ';', an empty
+   * candidate for the default build.
+   */
+  static constexpr const char* build_options = "build_options";
 };
 
 class SketchPolicy;
@@ -117,6 +127,14 @@ class SketchPolicyNode : public SearchPolicyNode {
   std::pair<Array<MeasureInput>, Array<MeasureResult>> ContinueSearchOneRound(
       int num_measure, ProgramMeasurer measurer) final;
 
+  /*!
+   * \brief Preload the states of similar workloads, and pre-train the cost model on the records
+   * of the log file of these and the current workload.
+   * \param log_file The name of the record log file.
+   * \param max_states The maximum number of transferred states to keep.
+   */
+  void PreloadSimilarStates(const String& log_file, int max_states) final;
+
   /*!
    * \brief Generate sketches.
    * \return The generated sketches(states).
@@ -26,10 +26,12 @@
 #include "sketch_policy_rules.h"
 
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "../../runtime/texture.h"
 #include "sketch_policy.h"
 
 namespace tvm {
@@ -207,6 +209,87 @@ std::vector<std::pair<State, int>> RuleAddCacheRead::Apply(const SketchPolicyNod
   return {std::make_pair(tmp_s, stage_id)};
 }
 
+/********** RuleAddTextureCacheRead **********/
+
+/*!
+ * \brief Select the texture layout convention to cache a placeholder in.
+ * \return The first convention whose image fits the target, or an empty string if none does.
+ */
+static std::string SelectTextureScope(const SearchTask& task, const Array<PrimExpr>& shape) {
+  // The innermost axis is held by the RGBA channels of the texels
+  if (shape.size() < 2) return "";
+  const auto* channel = shape.back().as<IntImmNode>();
+  if (channel == nullptr || channel->value != 4) return "";
+  std::vector<int64_t> extents;
+  for (const PrimExpr& extent : shape) {
+    const auto* imm = extent.as<IntImmNode>();
+    if (imm == nullptr) return "";
+    extents.push_back(imm->value);
+  }
+  int64_t limit = task->target->GetAttr<Integer>("texture_spatial_limit").value_or(16384)->value;
+  for (const std::string& scope : {"texture", "texture:weight", "texture:nhwc"}) {
+    size_t axis = runtime::DefaultTextureLayoutSeparator(extents.size(), scope);
+    if (axis >= extents.size() - 1) continue;
+    auto texture = runtime::ApplyTexture2DFlattening<int64_t>(extents, extents.size(), axis);
+    if (texture.width <= limit && texture.height <= limit) return scope;
+  }
+  return "";
+}
+
+SketchGenerationRule::ConditionKind RuleAddTextureCacheRead::MeetCondition(
+    const SketchPolicyNode& policy, const State& state, int stage_id) const {
+  const SearchTask& task = policy.search_task;
+  const Stage& stage = state->stages[stage_id];
+
+  // Only the inputs of the task are read through textures, from global memory
+  const auto* op = stage->op.as<te::PlaceholderOpNode>();
+  if (op == nullptr || !(op->dtype.is_float() && (op->dtype.bits() == 16 ||
+                                                  op->dtype.bits() == 32))) {
+    return ConditionKind::kSkip;
+  }
+  if (SelectTextureScope(task, op->shape).empty()) {
+    return ConditionKind::kSkip;
+  }
+
+  // Only cache the inputs of stages which are multi-level tiled, whose reuse of the
+  // cached input pays for the extra kernel
+  const std::set<int>& consumers = GetConsumers(task, state, stage_id);
+  if (consumers.empty()) {
+    return ConditionKind::kSkip;
+  }
+  for (int consumer : consumers) {
+    if (!NeedsMultilevelTiling(task, state, consumer) || HasCrossThreadReduction(state, consumer)) {
+      return ConditionKind::kSkip;
+    }
+    const std::set<int>& producers = GetDirectProducers(task, state, consumer);
+    if (producers.find(stage_id) == producers.end()) {
+      return ConditionKind::kSkip;
+    }
+  }
+
+  // The sketches without the texture stage are kept for the search to compare against
+  return ConditionKind::kApply;
+}
+
+std::vector<std::pair<State, int>> RuleAddTextureCacheRead::Apply(const SketchPolicyNode& policy,
+                                                                  const State& state,
+                                                                  int stage_id) const {
+  const SearchTask& task = policy.search_task;
+  const auto* op = state->stages[stage_id]->op.as<te::PlaceholderOpNode>();
+  std::string scope = SelectTextureScope(task, op->shape);
+  const std::set<int>& consumers = GetConsumers(task, state, stage_id);
+  State tmp_s = state;
+
+  // The texture stage is a kernel of its own writing one texel per vectorized iteration,
+  // its outer iterators are bound to threads by InitThreadBind.
+  Array<Integer> readers;
+  for (int consumer : consumers) readers.push_back(consumer);
+  int added_stage_id = tmp_s.cache_read(stage_id, scope, readers, task->compute_dag);
+  tmp_s.vectorize(added_stage_id, tmp_s->stages[added_stage_id]->iters.back());
+
+  return {std::make_pair(std::move(tmp_s), stage_id)};
+}
+
 /********** RuleAddCacheWrite **********/
 
 SketchGenerationRule::ConditionKind RuleAddCacheWrite::MeetCondition(const SketchPolicyNode& policy,
@@ -693,6 +776,42 @@ PopulationGenerationRule::ResultKind InitUnroll::Apply(SketchPolicyNode* policy,
   return ResultKind::kValid;
 }
 
+/*! \brief The candidate build options of the policy, each a string of flags. */
+static std::vector<std::string> GetBuildOptionsCandidates(const SketchPolicyNode* policy) {
+  std::vector<std::string> candidates;
+  if (!policy->params.count(SketchParamKey::build_options)) {
+    return candidates;
+  }
+  std::istringstream is(GetStringParam(policy->params, SketchParamKey::build_options));
+  for (std::string option; std::getline(is, option, ';');) {
+    candidates.push_back(option);
+  }
+  if (candidates.empty()) {
+    candidates.push_back("");
+  }
+  return candidates;
+}
+
+PopulationGenerationRule::ResultKind InitBuildOptions::Apply(SketchPolicyNode* policy,
+                                                             State* state,
+                                                             std::mt19937* rand_gen) const {
+  std::vector<std::string> candidates = GetBuildOptionsCandidates(policy);
+  if (candidates.empty()) {
+    return ResultKind::kValid;
+  }
+  for (size_t stage_id = 0; stage_id < (*state)->stages.size(); ++stage_id) {
+    const Stage& stage = (*state)->stages[stage_id];
+    // Every stage at the root is a kernel of its own
+    if (stage->compute_at != ComputeAtKind::kRoot || stage->op_type == StageKind::kPlaceholder ||
+        stage->iters.empty()) {
+      continue;
+    }
+    const std::string& value = candidates[(*rand_gen)() % candidates.size()];
+    state->pragma(stage_id, stage->iters[0], std::string("build_options") + "$" + value);
+  }
+  return ResultKind::kValid;
+}
+
 PopulationGenerationRule::ResultKind InitVectorization::Apply(SketchPolicyNode* policy,
                                                               State* state,
                                                               std::mt19937* rand_gen) const {
@@ -1052,6 +1171,32 @@ PopulationGenerationRule::ResultKind MutateAutoUnroll::Apply(SketchPolicyNode* p
   return ResultKind::kValid;
 }
 
+PopulationGenerationRule::ResultKind MutateBuildOptions::Apply(SketchPolicyNode* policy,
+                                                               State* state,
+                                                               std::mt19937* rand_gen) const {
+  std::vector<int> pragma_steps;
+  for (size_t i = 0; i < (*state)->transform_steps.size(); ++i) {
+    if (auto ps = (*state)->transform_steps[i].as<PragmaStepNode>()) {
+      if (StrStartsWith(ps->pragma_type, "build_options")) {
+        pragma_steps.push_back(i);
+      }
+    }
+  }
+  std::vector<std::string> candidates = GetBuildOptionsCandidates(policy);
+  if (pragma_steps.empty() || candidates.size() < 2) {
+    return ResultKind::kInvalid;
+  }
+
+  auto step_id = pragma_steps[(*rand_gen)() % pragma_steps.size()];
+  auto ps = (*state)->transform_steps[step_id].as<PragmaStepNode>();
+  ICHECK(ps);
+  const std::string& value = candidates[(*rand_gen)() % candidates.size()];
+  StateNode* pstate = state->CopyOnWrite();
+  pstate->transform_steps.Set(
+      step_id, PragmaStep(ps->stage_id, ps->iter_id, std::string("build_options") + "$" + value));
+  return ResultKind::kValid;
+}
+
 PopulationGenerationRule::ResultKind MutateComputeLocation::Apply(SketchPolicyNode* policy,
                                                                   State* state,
                                                                   std::mt19937* rand_gen) const {
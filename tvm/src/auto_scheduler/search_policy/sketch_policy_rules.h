@@ -114,6 +114,10 @@ DEFINE_SKETCH_GENERATION_RULE(RuleMultiLevelTilingWithFusion);
  * Currently only support 1 to 1 match cache read. */
 DEFINE_SKETCH_GENERATION_RULE(RuleAddCacheRead);
 
+/*! \brief The rule that caches placeholders read by multi-level tiled stages in textures, with
+ * the innermost axis of extent 4 vectorized into the RGBA channels. Used for Adreno GPUs. */
+DEFINE_SKETCH_GENERATION_RULE(RuleAddTextureCacheRead);
+
 /*! \brief The rule that adds a cache write stage. */
 DEFINE_SKETCH_GENERATION_RULE(RuleAddCacheWrite);
 
@@ -202,6 +206,9 @@ DEFINE_INIT_POPULATION_RULE(InitVectorization);
 /*! \brief The rule that annotates thread binding for GPU. */
 DEFINE_INIT_POPULATION_RULE(InitThreadBind);
 
+/*! \brief The rule that annotates the kernels with one of the candidate build options. */
+DEFINE_INIT_POPULATION_RULE(InitBuildOptions);
+
 /********** Mutation **********/
 
 /*! \brief The base class for mutation rules used in the evolutionary search. */
@@ -239,6 +246,9 @@ DEFINE_MUTATE_POPULATION_RULE(MutateComputeLocation);
 /*! \brief The rule that mutates the value of a randomly selected auto unroll pragma step. */
 DEFINE_MUTATE_POPULATION_RULE(MutateAutoUnroll);
 
+/*! \brief The rule that mutates the value of a randomly selected build options pragma step. */
+DEFINE_MUTATE_POPULATION_RULE(MutateBuildOptions);
+
 }  // namespace auto_scheduler
 }  // namespace tvm
 
@@ -0,0 +1,203 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file auto_scheduler/task_scheduler.cc
+ * \brief The task scheduler that allocates the measurement trials of several tasks.
+ */
+
+#include <tvm/auto_scheduler/task_scheduler.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include "search_policy/utils.h"
+#include "utils.h"
+
+namespace tvm {
+namespace auto_scheduler {
+
+TVM_REGISTER_OBJECT_TYPE(TaskSchedulerNode);
+
+/*! \brief The cost of a task without any valid measurement. */
+static constexpr double kInvalidCost = 1e10;
+
+TaskScheduler::TaskScheduler(Array<SearchTask> tasks, std::vector<double> task_weights,
+                             Array<SearchPolicy> search_policies) {
+  ICHECK_EQ(tasks.size(), task_weights.size());
+  ICHECK_EQ(tasks.size(), search_policies.size());
+  auto node = make_object<TaskSchedulerNode>();
+  node->tasks = std::move(tasks);
+  node->task_weights = std::move(task_weights);
+  node->search_policies = std::move(search_policies);
+  node->best_costs.assign(node->tasks.size(), kInvalidCost);
+  node->task_cts.assign(node->tasks.size(), 0);
+  data_ = std::move(node);
+}
+
+bool TaskSchedulerNode::TuneTaskOneRound(size_t task_id, int num_measures,
+                                         ProgramMeasurer measurer) {
+  Array<MeasureInput> inputs;
+  Array<MeasureResult> results;
+  std::tie(inputs, results) =
+      search_policies[task_id]->ContinueSearchOneRound(num_measures, measurer);
+
+  prev_best_costs_[task_id] = best_costs[task_id];
+  last_round_cts_[task_id] = inputs.size();
+  task_cts[task_id] += inputs.size();
+  for (const auto& res : results) {
+    if (res->error_no == static_cast<int>(MeasureErrorNO::kNoError)) {
+      double cost = FloatArrayMean(res->costs);
+      if (cost < best_costs[task_id]) {
+        best_costs[task_id] = cost;
+        best_cts_[task_id] = task_cts[task_id];
+      }
+    }
+  }
+  return !inputs.empty();
+}
+
+void TaskSchedulerNode::Tune(int n_trials, int num_measures_per_round, ProgramMeasurer measurer,
+                             double time_budget_s, int early_stopping, double min_latency_share,
+                             int verbose) {
+  using Clock = std::chrono::steady_clock;
+  auto t_begin = Clock::now();
+  auto elapsed_s = [&t_begin]() {
+    return std::chrono::duration<double>(Clock::now() - t_begin).count();
+  };
+  size_t n_tasks = tasks.size();
+  early_stopping = early_stopping < 0 ? std::numeric_limits<int>::max() >> 1 : early_stopping;
+
+  prev_best_costs_.assign(n_tasks, kInvalidCost);
+  last_round_cts_.assign(n_tasks, 0);
+  best_cts_.assign(n_tasks, 0);
+  done_.assign(n_tasks, false);
+  measurer->Reset();
+
+  int total_ct = 0;
+  auto out_of_budget = [&]() {
+    return total_ct >= n_trials || (time_budget_s > 0 && elapsed_s() >= time_budget_s);
+  };
+
+  // Measure every task once so that all the tasks have an estimated cost
+  PrintTitle("Task scheduler warm up", verbose);
+  for (size_t i = 0; i < n_tasks && !out_of_budget(); ++i) {
+    done_[i] = !TuneTaskOneRound(i, num_measures_per_round, measurer);
+    total_ct += last_round_cts_[i];
+  }
+
+  while (!out_of_budget()) {
+    // Only the tasks with a valid schedule contribute a meaningful latency
+    double latency = 0.0;
+    int n_valid = 0;
+    for (size_t i = 0; i < n_tasks; ++i) {
+      if (best_costs[i] < kInvalidCost) {
+        latency += task_weights[i] * best_costs[i];
+        ++n_valid;
+      }
+    }
+
+    // Pick the task with the largest expected latency gain per trial
+    int best_task = -1;
+    double best_gain = -1.0;
+    for (size_t i = 0; i < n_tasks; ++i) {
+      if (done_[i]) {
+        continue;
+      }
+      bool valid = best_costs[i] < kInvalidCost;
+      if (valid && n_valid >= 2 && task_weights[i] * best_costs[i] < min_latency_share * latency) {
+        StdCout(verbose) << "TaskScheduler: Stop task " << i << ", it takes less than "
+                         << min_latency_share * 100 << "% of the latency" << std::endl;
+        done_[i] = true;
+        continue;
+      }
+      if (task_cts[i] - best_cts_[i] > early_stopping) {
+        StdCout(verbose) << "TaskScheduler: Stop task " << i << ", no improvement in the last "
+                         << early_stopping << " trials" << std::endl;
+        done_[i] = true;
+        continue;
+      }
+      double gain;
+      if (!valid) {
+        // A task without any valid schedule dominates the latency
+        gain = std::numeric_limits<double>::max();
+      } else {
+        double progress = 0.0;
+        if (prev_best_costs_[i] < kInvalidCost && last_round_cts_[i] > 0) {
+          progress = (prev_best_costs_[i] - best_costs[i]) / last_round_cts_[i];
+        }
+        double optimistic = best_costs[i] / std::max(task_cts[i], 1);
+        gain = task_weights[i] * std::max(progress, optimistic);
+      }
+      if (gain > best_gain) {
+        best_gain = gain;
+        best_task = i;
+      }
+    }
+    if (best_task < 0) {
+      StdCout(verbose) << "TaskScheduler: All tasks are done" << std::endl;
+      break;
+    }
+
+    int num_measures = std::min(num_measures_per_round, n_trials - total_ct);
+    done_[best_task] = !TuneTaskOneRound(best_task, num_measures, measurer);
+    total_ct += last_round_cts_[best_task];
+
+    StdCout(verbose) << "TaskScheduler: Trials: " << total_ct << "\tTask: " << best_task
+                     << "\tEstimated latency: " << std::fixed << std::setprecision(3)
+                     << latency * 1e3 << " ms\tElapsed: " << elapsed_s() << " s" << std::endl;
+  }
+
+  PrintTitle("Task scheduler done", verbose);
+}
+
+TVM_REGISTER_GLOBAL("auto_scheduler.TaskScheduler")
+    .set_body_typed([](Array<SearchTask> tasks, Array<FloatImm> task_weights,
+                       Array<SearchPolicy> search_policies) {
+      std::vector<double> weights;
+      for (const auto& w : task_weights) {
+        weights.push_back(w->value);
+      }
+      return TaskScheduler(tasks, weights, search_policies);
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.TaskSchedulerTune")
+    .set_body_typed([](TaskScheduler scheduler, int n_trials, int num_measures_per_round,
+                       ProgramMeasurer measurer, double time_budget_s, int early_stopping,
+                       double min_latency_share, int verbose) {
+      scheduler->Tune(n_trials, num_measures_per_round, measurer, time_budget_s, early_stopping,
+                      min_latency_share, verbose);
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.TaskSchedulerGetBestCosts")
+    .set_body_typed([](TaskScheduler scheduler) {
+      Array<FloatImm> costs;
+      for (double cost : scheduler->best_costs) {
+        costs.push_back(FloatImm(DataType::Float(64), cost));
+      }
+      return costs;
+    });
+
+}  // namespace auto_scheduler
+}  // namespace tvm
@@ -679,6 +679,8 @@ void PragmaStepNode::ApplyToState(State* state) const {
     ICHECK_LT(pos, pragma_type.size()) << "max step value not found.";
     stage.CopyOnWrite()->attrs.auto_unroll_max_step = atoi(pragma_type.c_str() + pos + 1);
     pstate->stages.Set(stage_id, std::move(stage));
+  } else if (StrStartsWith(pragma_type, "build_options")) {
+    // Only read by the device code generation
   } else {
     LOG(FATAL) << "Unsupported pragma: " << pragma_type;
   }
@@ -701,6 +703,14 @@ void PragmaStepNode::ApplyToSchedule(Array<te::Stage>* stages,
       stage.pragma(axes[iter_id], "auto_unroll_max_step", value);
       stage.pragma(axes[iter_id], "unroll_explicit", true);
     }
+  } else if (StrStartsWith(pragma_type, "build_options")) {
+    std::string type = pragma_type;
+    size_t pos = type.find('$');
+    ICHECK_NE(pos, std::string::npos) << "build options value not found.";
+    std::string value = type.substr(pos + 1);
+    if (!value.empty() && iter_id < static_cast<int>(axes.size())) {
+      stage.pragma(axes[iter_id], "build_options", tir::StringImm(value));
+    }
   } else {
     ICHECK_LT(iter_id, axes.size());
     stage.pragma(axes[iter_id], pragma_type);
@@ -729,6 +739,16 @@ String PragmaStepNode::PrintAsPythonAPI(Array<te::Stage>* stages,
     ss << "s[" << op_name << "].pragma("
        << CleanName((*stage_to_axes)[stage][iter_id]->var->name_hint, op_name)
        << ", \"unroll_explicit\", True)\n";
+  } else if (StrStartsWith(pragma_type, "build_options")) {
+    std::string type = pragma_type;
+    size_t pos = type.find('$');
+    ICHECK_NE(pos, std::string::npos) << "build options value not found.";
+    std::string value = type.substr(pos + 1);
+    if (!value.empty()) {
+      ss << "s[" << op_name << "].pragma("
+         << CleanName((*stage_to_axes)[stage][iter_id]->var->name_hint, op_name)
+         << ", \"build_options\", tvm.tir.StringImm(\"" << value << "\"))\n";
+    }
   } else {
     ss << "s[" << op_name << "].pragma("
        << CleanName((*stage_to_axes)[stage][iter_id]->var->name_hint, op_name) << ", \""
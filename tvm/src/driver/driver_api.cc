@@ -26,6 +26,7 @@
 #include <tvm/ir/transform.h>
 #include <tvm/runtime/container.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 #include <tvm/target/codegen.h>
 #include <tvm/te/operation.h>
 #include <tvm/tir/analysis.h>
@@ -34,6 +35,9 @@
 #include <algorithm>
 #include <mutex>
 #include <stack>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace tvm {
 
@@ -44,6 +48,7 @@ TVM_REGISTER_PASS_CONFIG_OPTION("tir.instrument_bound_checkers", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.disable_assert", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.disable_vectorize", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.add_lower_pass", Array<Array<ObjectRef>>);
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.build_threads", Integer);
 
 using runtime::PackedFunc;
 using runtime::TVMArgs;
@@ -169,6 +174,11 @@ IRModule lower(te::Schedule sch, const Array<te::Tensor>& args, const std::strin
   pass_list.push_back(tir::transform::LoopPartition());
   pass_list.push_back(tir::transform::VectorizeLoop(!disable_vectorize));
   pass_list.push_back(tir::transform::InjectVirtualThread());
+  // The VTCM copies call the Hexagon device runtime, they are only lowered for Hexagon.
+  Target target = Target::Current(true);
+  if (target.defined() && target->kind->name == "hexagon") {
+    pass_list.push_back(tir::transform::InjectVTCMCopy());
+  }
   pass_list.push_back(tir::transform::InjectDoubleBuffer());
   pass_list.push_back(tir::transform::StorageRewrite());
   pass_list.push_back(tir::transform::UnrollLoop());
@@ -198,6 +208,8 @@ std::pair<IRModule, IRModule> SplitDevHostFuncs(IRModule mod_mixed, const Target
   mixed_pass_list.push_back(tir::transform::ThreadSync("warp"));
   mixed_pass_list.push_back(tir::transform::InferFragment());
   mixed_pass_list.push_back(tir::transform::LowerThreadAllreduce());
+  mixed_pass_list.push_back(tir::transform::RemoveDeadTextureStore());
+  mixed_pass_list.push_back(tir::transform::NarrowDeviceIndex());
   mixed_pass_list.push_back(tir::transform::MakePackedAPI(0));
   mixed_pass_list.push_back(tir::transform::SplitHostDevice());
   auto opt_mixed = transform::Sequential(mixed_pass_list);
@@ -275,23 +287,49 @@ runtime::Module build(const Map<Target, IRModule>& inputs, const Target& target_
 
   ICHECK(mhost_all.defined()) << "The host module must be defined";
 
+  std::vector<std::pair<Target, IRModule>> target_mods;
   for (const auto& it : inputs) {
     if (it.second.defined()) {
-      auto pair = SplitDevHostFuncs(it.second, it.first, target_host_val, pass_ctx);
-      auto& mhost = pair.first;
-      auto& mdevice = pair.second;
-
-      ICHECK(mhost.defined()) << "The split host module must be defined";
-
-      ICHECK(mhost_all.defined()) << "The host module must be defined";
-
-      mhost_all->Update(mhost);
-
-      if (mdevice->functions.size() != 0) {
-        device_modules.push_back(codegen::Build(mdevice, it.first));
-      }
+      target_mods.emplace_back(it.first, it.second);
     }
   }
+  std::vector<IRModule> host_mods(target_mods.size());
+  device_modules.resize(target_mods.size());
+  auto build_target = [&](int i) {
+    auto pair = SplitDevHostFuncs(target_mods[i].second, target_mods[i].first, target_host_val,
+                                  pass_ctx);
+    auto& mhost = pair.first;
+    auto& mdevice = pair.second;
+
+    ICHECK(mhost.defined()) << "The split host module must be defined";
+    host_mods[i] = mhost;
+
+    if (mdevice->functions.size() != 0) {
+      device_modules[i] = codegen::Build(mdevice, target_mods[i].first);
+    }
+  };
+  // The targets are independent until their host functions are merged, so their device code can
+  // be generated in parallel.
+  int num_threads = pass_ctx->GetConfig<Integer>("tir.build_threads", Integer(1)).value()->value;
+  if (num_threads != 1 && target_mods.size() > 1) {
+    if (num_threads <= 0) {
+      num_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    support::parallel_for_dynamic(0, target_mods.size(), num_threads, [&](int thread_id, int i) {
+      // The pass context is thread local.
+      With<transform::PassContext> pass_ctx_scope(pass_ctx);
+      build_target(i);
+    });
+  } else {
+    for (size_t i = 0; i < target_mods.size(); ++i) {
+      build_target(i);
+    }
+  }
+  // Merge in the order of the targets, so that the result does not depend on the threads.
+  for (const IRModule& mhost : host_mods) {
+    ICHECK(mhost_all.defined()) << "The host module must be defined";
+    mhost_all->Update(mhost);
+  }
 
   runtime::Module mhost = codegen::Build(mhost_all, target_host_val);
   // Import all modules
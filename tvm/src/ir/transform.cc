@@ -30,6 +30,7 @@
 
 #include <chrono>
 #include <iomanip>
+#include <memory>
 #include <stack>
 #include <unordered_set>
 
@@ -239,9 +240,21 @@ PassProfile* PassProfile::Current() {
   }
 }
 
+TVM_REGISTER_PASS_CONFIG_OPTION("ir.object_pool", Bool);
+
+/*!
+ * \brief Enter an ObjectPool scope for the duration of a pass when ir.object_pool is set, so
+ *  that the transient IR nodes of the pass recycle their memory.
+ */
+static std::unique_ptr<runtime::ObjectPoolScope> PassObjectPoolScope(const PassContext& pass_ctx) {
+  if (!pass_ctx->GetConfig<Bool>("ir.object_pool", Bool(false)).value()) return nullptr;
+  return std::make_unique<runtime::ObjectPoolScope>();
+}
+
 IRModule Pass::operator()(IRModule mod) const {
   const PassNode* node = operator->();
   ICHECK(node != nullptr);
+  auto pool_scope = PassObjectPoolScope(PassContext::Current());
   PassProfile::EnterPass(node->Info()->name);
   auto ret = node->operator()(std::move(mod));
   PassProfile::ExitPass();
@@ -251,6 +264,7 @@ IRModule Pass::operator()(IRModule mod) const {
 IRModule Pass::operator()(IRModule mod, const PassContext& pass_ctx) const {
   const PassNode* node = operator->();
   ICHECK(node != nullptr);
+  auto pool_scope = PassObjectPoolScope(pass_ctx);
   PassProfile::EnterPass(node->Info()->name);
   auto ret = node->operator()(std::move(mod), pass_ctx);
   PassProfile::ExitPass();
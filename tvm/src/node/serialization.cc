@@ -557,12 +557,12 @@ ObjectRef LoadJSON(std::string json_str) {
   std::vector<runtime::NDArray> tensors;
   {
     // load in tensors
+    std::string bytes;
     for (const std::string& blob : jgraph.b64ndarrays) {
-      dmlc::MemoryStringStream mstrm(const_cast<std::string*>(&blob));
-      support::Base64InStream b64strm(&mstrm);
-      b64strm.InitPosition();
+      support::Base64Decode(blob.data(), blob.size(), &bytes);
+      dmlc::MemoryFixedSizeStream mstrm(&bytes[0], bytes.size());
       runtime::NDArray temp;
-      ICHECK(temp.Load(&b64strm));
+      ICHECK(temp.Load(&mstrm));
       tensors.emplace_back(std::move(temp));
     }
   }
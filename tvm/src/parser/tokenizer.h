@@ -28,6 +28,7 @@
 #include <tvm/runtime/container.h>
 #include <tvm/runtime/object.h>
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <unordered_map>
@@ -294,11 +295,17 @@ struct Tokenizer {
 
       // Metadata can only appear at the bottom of a file and goes to EOF.
       if (attribute == "metadata") {
-        std::stringstream metadata;
-        while (More()) {
-          metadata << Next();
+        // The section can be very large, copy it at once instead of character by character.
+        std::string metadata(this->source.data() + this->pos, this->source.size() - this->pos);
+        this->pos = this->source.size();
+        size_t last_newline = metadata.rfind('\n');
+        if (last_newline == std::string::npos) {
+          this->col += static_cast<int>(metadata.size());
+        } else {
+          this->line += static_cast<int>(std::count(metadata.begin(), metadata.end(), '\n'));
+          this->col = static_cast<int>(metadata.size() - last_newline);
         }
-        ObjectRef metadata_map = tvm::LoadJSON(metadata.str());
+        ObjectRef metadata_map = tvm::LoadJSON(metadata);
         auto span = SpanFrom(line, column);
         return Token(span, TokenType::kMetadata, metadata_map);
       }
@@ -90,6 +90,14 @@ struct GraphCodegen {
     return ret;
   }
 
+  Map<String, ObjectRef> GetAOTPlan() {
+    return CallFunc<Map<String, ObjectRef>>("get_aot_plan", nullptr);
+  }
+
+  Array<Integer> GetStorageSizes() {
+    return CallFunc<Array<Integer>>("get_storage_sizes", nullptr);
+  }
+
   std::unordered_map<std::string, int64_t> GetParamIds() {
     std::unordered_map<std::string, int64_t> ret;
     auto names = CallFunc<Array<runtime::String>>("list_params_name", nullptr);
@@ -311,6 +319,23 @@ class RelayBuildModule : public runtime::ModuleNode {
     if (targets.size() == 1) {
       pass_seqs.push_back(transform::InferType());
       pass_seqs.push_back(transform::AlterOpLayout());
+      pass_seqs.push_back(transform::InferType());
+      if (PassContext::Current()
+              ->GetConfig<Bool>("relay.backend.propagate_layout_transform", Bool(false))
+              .value()) {
+        pass_seqs.push_back(transform::PropagateLayoutTransform());
+      }
+      // Texture convolutions are combined again once they are in their packed layouts, when
+      // the module is placed on an Adreno OpenCL device.
+      bool texture_target = false;
+      for (const auto& kv : targets) {
+        texture_target |= kv.first->value == kDLOpenCL && kv.second->kind->name == "opencl" &&
+                          kv.second->GetAttr<String>("device").value_or("") == "adreno";
+      }
+      if (texture_target) {
+        pass_seqs.push_back(transform::InferType());
+        pass_seqs.push_back(transform::CombineParallelConv2D(3));
+      }
     }
 
     // Fast math optimizations.
@@ -334,11 +359,22 @@ class RelayBuildModule : public runtime::ModuleNode {
           pass_ctx->GetConfig("relay.fallback_device_type", Integer(static_cast<int>(kDLCPU)));
       auto fallback_dev = opt_fallback_dev.value();
       ICHECK_GT(fallback_dev->value, 0U);
+      // Split the quantized part of the model off to its own device.
+      Optional<Integer> quantized_dev = pass_ctx->GetConfig<Integer>("relay.quantized_device_type");
+      if (quantized_dev.defined()) {
+        relay_module = transform::AnnotateDeviceByDType(quantized_dev.value()->value, 0)(
+            transform::InferType()(relay_module));
+      }
       relay_module = RunDeviceAnnotationPass(relay_module, fallback_dev->value);
     }
 
-    // Fuse the operations if it is needed.
-    relay_module = transform::FuseOps()(relay_module);
+    // Fuse the operations if it is needed. The fusion policy of a single target is applied.
+    if (targets.size() == 1) {
+      With<Target> tctx((*targets.begin()).second);
+      relay_module = transform::FuseOps()(relay_module);
+    } else {
+      relay_module = transform::FuseOps()(relay_module);
+    }
 
     // Do layout rewrite for auto-scheduler.
     if (backend::IsAutoSchedulerEnabled() && targets.size() == 1) {
@@ -503,6 +539,51 @@ class RelayBuildModule : public runtime::ModuleNode {
           GlobalVar(::tvm::runtime::symbol::tvm_lookup_linked_param), prim);
     }
 
+    // The ahead-of-time executor calls the fused functions directly on the linked params and
+    // the static arena.
+    bool aot = target_host->GetAttr<String>("executor").value_or("graph") == "aot";
+    if (aot) {
+      CHECK_EQ(target_host->kind->name, "c")
+          << "The aot executor is only supported by the c target";
+      CHECK(target_host->GetAttr<Bool>("link-params").value_or(Bool(false)))
+          << "The aot executor needs -link-params";
+    }
+
+    // Generate a placeholder function that carries the static memory plan, the storage ids
+    // served by linked params are left out of the arena.
+    if (aot || target_host->GetAttr<Bool>("link-storage").value_or(Bool(false))) {
+      CHECK_EQ(target_host->kind->name, "c") << "link-storage is only supported by the c target";
+      Array<Integer> sizes = graph_codegen_->GetStorageSizes();
+      if (target_host->GetAttr<Bool>("link-params").value_or(Bool(false))) {
+        for (const auto& kv : graph_codegen_->GetParamIds()) {
+          sizes.Set(kv.second, Integer(0));
+        }
+      }
+      Map<String, ObjectRef> dict;
+      dict.Set(tvm::tir::attr::kStorageArena, sizes);
+      dict.Set(tvm::attr::kGlobalSymbol, String(::tvm::runtime::symbol::tvm_lookup_storage_arena));
+      DictAttrs attrs{dict};
+      auto prim = tir::PrimFunc(Array<tir::Var>(), tir::SeqStmt(Array<tir::Stmt>()), VoidType(),
+                                Map<tir::Var, tir::Buffer>(), attrs);
+      if (lowered_funcs.find(target_host->str()) == lowered_funcs.end()) {
+        lowered_funcs.Set(target_host->str(), IRModule(Map<GlobalVar, BaseFunc>({})));
+      }
+      lowered_funcs[target_host->str()]->Add(
+          GlobalVar(::tvm::runtime::symbol::tvm_lookup_storage_arena), prim);
+    }
+
+    // Generate a placeholder for the entry function of the ahead-of-time executor.
+    if (aot) {
+      Map<String, ObjectRef> dict;
+      dict.Set(tvm::tir::attr::kAOTPlan, graph_codegen_->GetAOTPlan());
+      dict.Set(tvm::attr::kGlobalSymbol, String(::tvm::runtime::symbol::tvm_run_aot));
+      DictAttrs attrs{dict};
+      auto prim = tir::PrimFunc(Array<tir::Var>(), tir::SeqStmt(Array<tir::Stmt>()), VoidType(),
+                                Map<tir::Var, tir::Buffer>(), attrs);
+      lowered_funcs[target_host->str()]->Add(
+          GlobalVar(::tvm::runtime::symbol::tvm_run_aot), prim);
+    }
+
     // When there is no lowered_funcs due to reasons such as optimization.
     if (lowered_funcs.size() == 0) {
       if (target_host.defined() && target_host->kind->name == "llvm") {
@@ -25,6 +25,7 @@
 
 #include <tvm/driver/driver_api.h>
 #include <tvm/ir/type_functor.h>
+#include <tvm/node/serialization.h>
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/attrs/device_copy.h>
 #include <tvm/relay/expr.h>
@@ -33,18 +34,28 @@
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/runtime/container.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule.h>
 #include <tvm/te/schedule_pass.h>
 #include <tvm/topi/tags.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <functional>
+#include <iomanip>
+#include <iterator>
 #include <limits>
 #include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "../../support/utils.h"
 #include "../transforms/pass_utils.h"
 #include "utils.h"
 
@@ -631,6 +642,77 @@ class CompileEngineImpl : public CompileEngineNode {
     return value->packed_func;
   }
 
+  void LowerParallel(const Array<CCacheKey>& keys, const Array<Array<tir::Buffer>>& buffers,
+                     int num_threads) final {
+    ICHECK_EQ(keys.size(), buffers.size());
+    // Without the cache, every function is lowered again by Lower anyway.
+    if (backend::IsCompileEngineCacheDisabled()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    struct Task {
+      CCacheKey key;
+      Array<tir::Buffer> buffers;
+      CCacheValue value;
+      std::string persistent_path;
+      Map<String, ObjectRef> entry;
+      std::string base_name;
+      ObjectPtr<CachedFuncNode> cache_node;
+    };
+    // The pass context and the target are thread local, enter them in every worker.
+    transform::PassContext pass_ctx = transform::PassContext::Current();
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const CCacheKey& key = keys[i];
+      if (cache_.count(key) || key->source_func->GetAttr<String>(attr::kCompiler).defined() ||
+          IsDeviceCopy(key->source_func)) {
+        continue;
+      }
+      Task task;
+      task.key = key;
+      task.buffers = buffers[i];
+      task.value = CCacheValue(make_object<CCacheValueNode>());
+      // The first Lower of the key counts as the first use, the same as without prelowering.
+      task.value->use_count = -1;
+      task.persistent_path = PersistentCachePath(key, buffers[i], pass_ctx);
+      cache_[key] = task.value;
+      tasks.push_back(std::move(task));
+    }
+    if (num_threads <= 0) {
+      num_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    support::parallel_for_dynamic(0, tasks.size(), num_threads, [&](int thread_id, int i) {
+      With<transform::PassContext> pass_ctx_scope(pass_ctx);
+      With<Target> target_scope(tasks[i].key->target);
+      tasks[i].entry = ReadPersistent(tasks[i].persistent_path, tasks[i].key, pass_ctx);
+      if (tasks[i].entry.empty()) {
+        auto cfunc = CreateSchedule(tasks[i].key->source_func, tasks[i].key->target);
+        tasks[i].cache_node = make_object<CachedFuncNode>(*(cfunc.operator->()));
+      }
+    });
+    // Name the functions in the order of the keys, so that the names do not depend on how the
+    // functions were scheduled on the threads.
+    std::vector<Task*> to_lower;
+    for (Task& task : tasks) {
+      if (!task.entry.empty()) {
+        task.value->cached_func = RestorePersistent(task.entry, task.key);
+      } else {
+        task.base_name = task.cache_node->func_name;
+        task.cache_node->func_name = GetUniqueName(task.base_name);
+        to_lower.push_back(&task);
+      }
+    }
+    support::parallel_for_dynamic(0, to_lower.size(), num_threads, [&](int thread_id, int i) {
+      Task* task = to_lower[i];
+      With<transform::PassContext> pass_ctx_scope(pass_ctx);
+      With<Target> target_scope(task->key->target);
+      LowerSchedule(task->key, task->buffers, task->cache_node.get());
+      task->value->cached_func = CachedFunc(task->cache_node);
+      if (!task->persistent_path.empty()) {
+        SavePersistent(task->persistent_path, task->key, task->base_name,
+                       task->value->cached_func, pass_ctx);
+      }
+    });
+  }
+
   CachedFunc LowerShapeFunc(const CCacheKey& key) final {
     return LowerShapeFuncInternal(key)->cached_func;
   }
@@ -746,19 +828,46 @@ class CompileEngineImpl : public CompileEngineNode {
     With<Target> target_scope(key->target);
 
     ICHECK(!value->cached_func.defined());
+    transform::PassContext pass_ctx = transform::PassContext::Current();
+    std::string persistent_path = PersistentCachePath(key, buffers, pass_ctx);
+    Map<String, ObjectRef> entry = ReadPersistent(persistent_path, key, pass_ctx);
+    if (!entry.empty()) {
+      value->cached_func = RestorePersistent(entry, key);
+      return value;
+    }
     auto cfunc = CreateSchedule(key->source_func, key->target);
     auto cache_node = make_object<CachedFuncNode>(*(cfunc.operator->()));
 
     // Skip lowering for device copy node.
-    const Expr body = (key->source_func)->body;
-    if (const CallNode* call_node = body.as<CallNode>()) {
-      if (call_node->attrs.as<DeviceCopyAttrs>()) {
-        value->cached_func = CachedFunc(cache_node);
-        return value;
-      }
+    if (IsDeviceCopy(key->source_func)) {
+      value->cached_func = CachedFunc(cache_node);
+      return value;
     }
 
+    std::string base_name = cache_node->func_name;
     cache_node->func_name = GetUniqueName(cache_node->func_name);
+    LowerSchedule(key, buffers, cache_node.get());
+    value->cached_func = CachedFunc(cache_node);
+    if (!persistent_path.empty()) {
+      SavePersistent(persistent_path, key, base_name, value->cached_func, pass_ctx);
+    }
+    return value;
+  }
+  /*! \brief Whether a primitive function is a device copy, which is never lowered. */
+  static bool IsDeviceCopy(const Function& func) {
+    if (const CallNode* call_node = func->body.as<CallNode>()) {
+      return call_node->attrs.as<DeviceCopyAttrs>() != nullptr;
+    }
+    return false;
+  }
+  /*!
+   * \brief Lower the schedule of a function whose name is already unique.
+   * \param key The key of the function.
+   * \param buffers The buffers to bind the inputs and outputs to, empty for none.
+   * \param cache_node The scheduled function, its lowered functions are set in place.
+   */
+  static void LowerSchedule(const CCacheKey& key, const Array<tir::Buffer>& buffers,
+                            CachedFuncNode* cache_node) {
     // NOTE: array will copy on write.
     Array<te::Tensor> all_args = cache_node->inputs;
     for (te::Tensor arg : cache_node->outputs) {
@@ -776,16 +885,130 @@ class CompileEngineImpl : public CompileEngineNode {
 
     // lower the function
     if (const auto* f = runtime::Registry::Get("relay.backend.lower")) {
-      cache_node->funcs = (*f)(cfunc->schedule, all_args, cache_node->func_name, key->source_func, binds);
+      cache_node->funcs =
+          (*f)(cache_node->schedule, all_args, cache_node->func_name, key->source_func, binds);
     } else {
       using tvm::transform::PassContext;
       With<PassContext> fresh_pass_ctx_scope(PassContext::Create());
 
       std::unordered_map<te::Tensor, tir::Buffer> binds;
-      cache_node->funcs = tvm::lower(cfunc->schedule, all_args, cache_node->func_name, binds);
+      cache_node->funcs = tvm::lower(cache_node->schedule, all_args, cache_node->func_name, binds);
     }
-    value->cached_func = CachedFunc(cache_node);
-    return value;
+  }
+  /*!
+   * \brief Get the options of a pass context which change how functions are lowered, they are
+   *  part of the key of the persistent cache.
+   */
+  static Map<String, ObjectRef> PersistentPassOptions(const transform::PassContext& pass_ctx) {
+    Map<String, ObjectRef> config = pass_ctx->config;
+    // Moving the cache does not change its entries.
+    config.erase("relay.backend.compile_cache_dir");
+    Map<String, ObjectRef> options;
+    options.Set("opt_level", Integer(pass_ctx->opt_level));
+    options.Set("required_pass", pass_ctx->required_pass);
+    options.Set("disabled_pass", pass_ctx->disabled_pass);
+    options.Set("config", config);
+    return options;
+  }
+  /*!
+   * \brief Get the file of a function in the persistent cache.
+   *  The entry is keyed by the structural hash of the primitive function, the target, the
+   *  options of the pass context including the cache salt (e.g. a digest of the tuning logs)
+   *  and the TVM version.
+   * \param key The key of the function.
+   * \param buffers The buffers to bind the inputs and outputs to, empty for none.
+   * \param pass_ctx The pass context the function is lowered under.
+   * \return The path of the entry, empty when the function is not persistently cached.
+   */
+  static std::string PersistentCachePath(const CCacheKey& key, const Array<tir::Buffer>& buffers,
+                                         const transform::PassContext& pass_ctx) {
+    std::string dir = backend::GetCompileCacheDir(pass_ctx);
+    // Functions lowered against given buffers and device copies are not cached.
+    if (dir.empty() || !buffers.empty() || IsDeviceCopy(key->source_func)) return "";
+    uint64_t hash = tvm::StructuralHash()(key->source_func);
+    hash = support::HashCombine(hash, std::string(key->target->str()));
+    hash = support::HashCombine(hash, tvm::StructuralHash()(PersistentPassOptions(pass_ctx)));
+    hash = support::HashCombine(hash, std::string(TVM_VERSION));
+    std::ostringstream os;
+    os << dir << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".json";
+    return os.str();
+  }
+  /*!
+   * \brief Read the entry of a function in the persistent cache.
+   * \param path The path of the entry, empty when the function is not persistently cached.
+   * \param key The key of the function.
+   * \param pass_ctx The pass context the function is lowered under.
+   * \return The entry, empty when there is no valid entry for the key.
+   */
+  static Map<String, ObjectRef> ReadPersistent(const std::string& path, const CCacheKey& key,
+                                               const transform::PassContext& pass_ctx) {
+    if (path.empty()) return {};
+    std::ifstream is(path);
+    if (!is) return {};
+    std::string json((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    Map<String, ObjectRef> entry;
+    try {
+      entry = Downcast<Map<String, ObjectRef>>(LoadJSON(json));
+    } catch (const dmlc::Error& e) {
+      LOG(WARNING) << "Ignore the invalid compile cache entry " << path << ": " << e.what();
+      return {};
+    }
+    // The entries written before the whole cached function was kept are stale.
+    if (!entry.count("cached_func") || !entry.count("pass_options")) return {};
+    // Guard against hash collisions.
+    if (Downcast<String>(entry["target"]) != key->target->str() ||
+        !tvm::StructuralEqual()(entry["pass_options"], PersistentPassOptions(pass_ctx)) ||
+        !tvm::StructuralEqual()(entry["source_func"], key->source_func)) {
+      return {};
+    }
+    return entry;
+  }
+  /*!
+   * \brief Restore a lowered function from its entry in the persistent cache.
+   *  The function gets a unique name in the current build.
+   * \return The cached function.
+   */
+  CachedFunc RestorePersistent(const Map<String, ObjectRef>& entry, const CCacheKey& key) {
+    CachedFunc cached = Downcast<CachedFunc>(entry["cached_func"]);
+    auto cache_node = make_object<CachedFuncNode>(*cached.operator->());
+    cache_node->target = key->target;
+    cache_node->func_name = GetUniqueName(Downcast<String>(entry["base_name"]));
+    cache_node->funcs = IRModule(Map<GlobalVar, BaseFunc>({}));
+    // The unique name of the function may differ from the one of the build that cached it.
+    for (const auto& kv : cached->funcs->functions) {
+      if (kv.first->name_hint != cached->func_name) {
+        cache_node->funcs->Add(kv.first, kv.second);
+      } else if (const auto* prim_func = kv.second.as<tir::PrimFuncNode>()) {
+        cache_node->funcs->Add(GlobalVar(cache_node->func_name),
+                               WithAttr(GetRef<tir::PrimFunc>(prim_func), tvm::attr::kGlobalSymbol,
+                                        String(cache_node->func_name)));
+      } else {
+        cache_node->funcs->Add(GlobalVar(cache_node->func_name), kv.second);
+      }
+    }
+    return CachedFunc(cache_node);
+  }
+  /*!
+   * \brief Store a lowered function in the persistent cache, with its tensors and schedule.
+   *  The entry is written to a temporary file first so that concurrent builds never observe a
+   *  partially written entry.
+   */
+  static void SavePersistent(const std::string& path, const CCacheKey& key,
+                             const std::string& base_name, const CachedFunc& cfunc,
+                             const transform::PassContext& pass_ctx) {
+    Map<String, ObjectRef> entry;
+    entry.Set("source_func", key->source_func);
+    entry.Set("target", String(key->target->str()));
+    entry.Set("pass_options", PersistentPassOptions(pass_ctx));
+    entry.Set("base_name", String(base_name));
+    entry.Set("cached_func", cfunc);
+    std::string tmp_path = path + "." + std::to_string(std::random_device()()) + ".tmp";
+    std::ofstream os(tmp_path);
+    os << SaveJSON(entry);
+    os.close();
+    if (os.good() && std::rename(tmp_path.c_str(), path.c_str()) == 0) return;
+    std::remove(tmp_path.c_str());
+    LOG(WARNING) << "Cannot write the compile cache entry " << path;
   }
   // implement lowered shape func
   CCacheValue LowerShapeFuncInternal(const CCacheKey& key) {
@@ -868,6 +1091,9 @@ CompileEngine& CompileEngine::Global() {
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.use_auto_scheduler", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.disable_compile_engine_cache", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.compile_cache_dir", String);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.compile_cache_salt", String);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.lowering_threads", Integer);
 
 TVM_REGISTER_GLOBAL("relay.backend._make_LoweredOutput")
     .set_body_typed([](tvm::Array<te::Tensor> outputs, OpImplementation impl) {
@@ -201,6 +201,10 @@ class CompileEngineNode : public Object {
   virtual ~CompileEngineNode() {}
   /*!
    * \brief Get lowered result.
+   *
+   *  When the pass context sets "relay.backend.compile_cache_dir", the lowered functions are
+   *  also kept in that directory across builds, keyed by the function, the target and the
+   *  options of the pass context.
    * \param key The key to the cached function.
    * \return The result.
    */
@@ -211,6 +215,16 @@ class CompileEngineNode : public Object {
    * \return The result.
    */
   virtual PackedFunc JIT(const CCacheKey& key, const Array<tir::Buffer>& buffers = {}) = 0;
+  /*!
+   * \brief Lower several functions at once, spreading their scheduling and lowering over threads.
+   *  The results are put into the cache, where the following calls of Lower find them. The
+   *  functions are named in the order of the keys, the same as when lowering them one by one.
+   * \param keys The keys to the functions, in the order they would be lowered.
+   * \param buffers The buffers to bind the inputs and outputs of every function to.
+   * \param num_threads The number of threads, non-positive to use all the cores.
+   */
+  virtual void LowerParallel(const Array<CCacheKey>& keys, const Array<Array<tir::Buffer>>& buffers,
+                             int num_threads) = 0;
   /*!
    * \brief Lower the shape function.
    * \param key The key to the cached function.
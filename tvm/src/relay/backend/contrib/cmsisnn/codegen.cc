@@ -0,0 +1,513 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relay/backend/contrib/cmsisnn/codegen.cc
+ * \brief Offload the int8 convolutions and dense layers of QNN graphs to CMSIS-NN.
+ *
+ * relay.ext.cmsisnn.partition_for_cmsisnn groups every qnn.conv2d and qnn.dense with its
+ * bias_add, requantize and clip into a composite function, and partitions them for the
+ * "cmsisnn" compiler. The codegen emits C calling the s8 kernels of CMSIS-NN, which use the
+ * Helium (MVE) or the DSP extension of the core the library is built for. The weights, the
+ * requantization parameters and the scratch buffers of the kernels are static, so they are
+ * placed at link time next to the static memory plan of the graph.
+ */
+#include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/attrs/transform.h>
+#include <tvm/relay/dataflow_pattern.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/qnn/attrs.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/tir/op.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../utils.h"
+#include "../codegen_c/codegen_c.h"
+
+namespace tvm {
+namespace relay {
+
+namespace transform {
+Pass MergeComposite(const Array<runtime::String>& pattern_names, const Array<DFPattern>& patterns,
+                    const std::vector<PackedFunc>& checks);
+Pass AnnotateTarget(const Array<runtime::String>& targets, bool include_non_call_ops);
+}  // namespace transform
+
+namespace contrib {
+namespace cmsisnn {
+
+/*! \brief An int8 layer offloaded to CMSIS-NN, read from the body of a composite function. */
+struct Layer {
+  enum Kind { kConv2D, kDepthwiseConv2D, kDense };
+  Kind kind{kConv2D};
+  /*! \brief The qnn.conv2d or qnn.dense call. */
+  const CallNode* op{nullptr};
+  /*! \brief The int32 bias, nullptr without bias_add. */
+  const ConstantNode* bias{nullptr};
+  /*! \brief The input and output shapes, NHWC for convolutions and [batch, units] for dense. */
+  std::vector<int> input_shape;
+  std::vector<int> output_shape;
+  /*! \brief The kernel height and width of convolutions. */
+  int kernel_h{1};
+  int kernel_w{1};
+  /*! \brief The strides and the top and left padding of convolutions. */
+  int stride_h{1};
+  int stride_w{1};
+  int pad_h{0};
+  int pad_w{0};
+  int32_t input_zero_point{0};
+  int32_t output_zero_point{0};
+  /*! \brief The scale from the int32 accumulator to the output, for every output channel. */
+  std::vector<double> scales;
+  /*! \brief The clip of the output. */
+  int32_t activation_min{-128};
+  int32_t activation_max{127};
+};
+
+/*! \brief The call of the op `name` in `expr`, nullptr if it is not one. */
+const CallNode* AsOpCall(const Expr& expr, const char* name) {
+  const auto* call = expr.as<CallNode>();
+  if (call == nullptr || !call->op.same_as(Op::Get(name))) return nullptr;
+  return call;
+}
+
+/*! \brief Read the values of a float32 or int32 constant. */
+bool ConstantValues(const Expr& expr, std::vector<double>* values) {
+  const auto* constant = expr.as<ConstantNode>();
+  if (constant == nullptr) return false;
+  const runtime::NDArray& data = constant->data;
+  int64_t size = 1;
+  for (int64_t dim : data.Shape()) {
+    size *= dim;
+  }
+  values->clear();
+  for (int64_t i = 0; i < size; ++i) {
+    if (data.DataType() == DataType::Float(32)) {
+      values->push_back(static_cast<const float*>(data->data)[i]);
+    } else if (data.DataType() == DataType::Int(32)) {
+      values->push_back(static_cast<const int32_t*>(data->data)[i]);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*! \brief Whether `expr` is a constant whose values are all zero. */
+bool IsZeroConstant(const Expr& expr) {
+  std::vector<double> values;
+  return ConstantValues(expr, &values) &&
+         std::all_of(values.begin(), values.end(), [](double v) { return v == 0; });
+}
+
+/*! \brief Whether `axis` is the innermost axis of a tensor of rank `ndim`. */
+bool IsChannelAxis(int axis, size_t ndim) {
+  return axis == -1 || axis == static_cast<int>(ndim) - 1;
+}
+
+/*! \brief Read the convolution attributes of a qnn.conv2d into `layer`. */
+bool GetConv2D(const CallNode* op, Layer* layer) {
+  const auto* attrs = op->attrs.as<Conv2DAttrs>();
+  if (attrs->data_layout != "NHWC" || layer->input_shape.size() != 4) return false;
+  for (const PrimExpr& dilation : attrs->dilation) {
+    const int64_t* value = tir::as_const_int(dilation);
+    if (value == nullptr || *value != 1) return false;
+  }
+  const auto* weight = op->args[1].as<ConstantNode>();
+  std::vector<int64_t> shape = weight->data.Shape();
+  if (attrs->groups == 1 && (attrs->kernel_layout == "OHWI" || attrs->kernel_layout == "HWIO")) {
+    layer->kind = Layer::kConv2D;
+  } else if (attrs->groups == layer->input_shape[3] && attrs->kernel_layout == "HWOI") {
+    layer->kind = Layer::kDepthwiseConv2D;
+  } else {
+    return false;
+  }
+  std::string layout = attrs->kernel_layout;
+  layer->kernel_h = shape[layout.find('H')];
+  layer->kernel_w = shape[layout.find('W')];
+
+  std::vector<int> values;
+  for (const Array<PrimExpr>& array : {attrs->strides, attrs->padding}) {
+    for (const PrimExpr& value : array) {
+      const int64_t* v = tir::as_const_int(value);
+      if (v == nullptr) return false;
+      values.push_back(*v);
+    }
+  }
+  if (attrs->strides.size() != 2 || attrs->padding.empty()) return false;
+  layer->stride_h = values[0];
+  layer->stride_w = values[1];
+  // The padding is given as (all), (top/bottom, left/right) or (top, left, bottom, right),
+  // the bottom and right padding follow from the output shape.
+  layer->pad_h = values[2];
+  layer->pad_w = attrs->padding.size() == 1 ? values[2] : values[3];
+  return true;
+}
+
+/*!
+ * \brief Read a layer from the root of a composite function, clip(requantize(bias_add(op))).
+ * \return Whether CMSIS-NN supports the layer.
+ */
+bool GetLayer(const Expr& root, Layer* layer) {
+  Expr expr = root;
+  if (const auto* clip = AsOpCall(expr, "clip")) {
+    const auto* attrs = clip->attrs.as<ClipAttrs>();
+    layer->activation_min = static_cast<int32_t>(std::max(attrs->a_min, -128.0));
+    layer->activation_max = static_cast<int32_t>(std::min(attrs->a_max, 127.0));
+    expr = clip->args[0];
+  }
+  const auto* requantize = AsOpCall(expr, "qnn.requantize");
+  if (requantize == nullptr) return false;
+  const auto* rq_attrs = requantize->attrs.as<qnn::RequantizeAttrs>();
+  std::vector<double> input_scales, output_scales, output_zero_points;
+  if (rq_attrs->out_dtype != DataType::Int(8) ||
+      !ConstantValues(requantize->args[1], &input_scales) ||
+      !IsZeroConstant(requantize->args[2]) ||
+      !ConstantValues(requantize->args[3], &output_scales) ||
+      !ConstantValues(requantize->args[4], &output_zero_points) || output_scales.size() != 1 ||
+      output_zero_points.size() != 1) {
+    return false;
+  }
+  layer->output_zero_point = output_zero_points[0];
+  expr = requantize->args[0];
+  if (const auto* bias_add = AsOpCall(expr, "nn.bias_add")) {
+    layer->bias = bias_add->args[1].as<ConstantNode>();
+    if (layer->bias == nullptr || layer->bias->data.DataType() != DataType::Int(32)) return false;
+    expr = bias_add->args[0];
+  }
+
+  // The qnn ops take the data, the weight, their zero points and their scales.
+  const CallNode* op = AsOpCall(expr, "qnn.conv2d");
+  if (op == nullptr) op = AsOpCall(expr, "qnn.dense");
+  if (op == nullptr) return false;
+  layer->op = op;
+  const auto* input_type = op->args[0]->checked_type().as<TensorTypeNode>();
+  const auto* weight = op->args[1].as<ConstantNode>();
+  std::vector<double> input_zero_points;
+  if (input_type == nullptr || input_type->dtype != DataType::Int(8) || weight == nullptr ||
+      weight->data.DataType() != DataType::Int(8) ||
+      !ConstantValues(op->args[2], &input_zero_points) || input_zero_points.size() != 1 ||
+      !IsZeroConstant(op->args[3])) {
+    return false;
+  }
+  layer->input_zero_point = input_zero_points[0];
+  layer->input_shape = backend::GetShape(op->args[0]->checked_type());
+  layer->output_shape = backend::GetShape(requantize->checked_type());
+  for (int dim : layer->input_shape) {
+    if (dim <= 0) return false;
+  }
+  if (op->op.same_as(Op::Get("qnn.conv2d"))) {
+    if (!GetConv2D(op, layer)) return false;
+  } else {
+    if (layer->input_shape.size() != 2 || weight->data->ndim != 2) return false;
+    layer->kind = Layer::kDense;
+  }
+  size_t ndim = layer->output_shape.size();
+  if (layer->bias != nullptr &&
+      !IsChannelAxis(AsOpCall(requantize->args[0], "nn.bias_add")->attrs.as<BiasAddAttrs>()->axis,
+                     ndim)) {
+    return false;
+  }
+
+  // Convolutions requantize per output channel, dense layers per tensor.
+  size_t channels = layer->output_shape.back();
+  if (input_scales.size() != 1 &&
+      (layer->kind == Layer::kDense || input_scales.size() != channels ||
+       !IsChannelAxis(rq_attrs->axis, ndim))) {
+    return false;
+  }
+  layer->scales.clear();
+  for (size_t c = 0; c < channels; ++c) {
+    layer->scales.push_back(input_scales[input_scales.size() == 1 ? 0 : c] / output_scales[0]);
+  }
+  return true;
+}
+
+/*!
+ * \brief Split a positive real multiplier into a Q31 fixed point multiplier and a shift, the
+ *  requantization parameters of CMSIS-NN.
+ */
+void QuantizeMultiplier(double multiplier, int32_t* fixed, int32_t* shift) {
+  if (multiplier == 0) {
+    *fixed = 0;
+    *shift = 0;
+    return;
+  }
+  int exponent;
+  double fraction = std::frexp(multiplier, &exponent);
+  int64_t q = static_cast<int64_t>(std::round(fraction * (1LL << 31)));
+  if (q == (1LL << 31)) {
+    q /= 2;
+    ++exponent;
+  }
+  if (exponent < -31) {
+    q = 0;
+    exponent = 0;
+  }
+  *fixed = static_cast<int32_t>(q);
+  *shift = exponent;
+}
+
+/*! \brief The weights of a layer in the layout of CMSIS-NN, OHWI for convolutions. */
+std::vector<int8_t> GetFilter(const Layer& layer) {
+  const runtime::NDArray& weight = layer.op->args[1].as<ConstantNode>()->data;
+  const auto* data = static_cast<const int8_t*>(weight->data);
+  std::vector<int64_t> shape = weight.Shape();
+  int64_t size = 1;
+  for (int64_t dim : shape) {
+    size *= dim;
+  }
+  // Depthwise HWOI weights already are the [1, H, W, C * M] filter of CMSIS-NN, and dense
+  // weights the [units, depth] one.
+  if (layer.kind != Layer::kConv2D) return std::vector<int8_t>(data, data + size);
+  const std::string ohwi = "OHWI";
+  std::string layout = layer.op->attrs.as<Conv2DAttrs>()->kernel_layout;
+  int64_t dims[4], strides[4];
+  int64_t stride = 1;
+  for (int i = 3; i >= 0; --i) {
+    size_t axis = ohwi.find(layout[i]);
+    dims[axis] = shape[i];
+    strides[axis] = stride;
+    stride *= shape[i];
+  }
+  std::vector<int8_t> filter;
+  filter.reserve(size);
+  for (int64_t o = 0; o < dims[0]; ++o) {
+    for (int64_t h = 0; h < dims[1]; ++h) {
+      for (int64_t w = 0; w < dims[2]; ++w) {
+        for (int64_t i = 0; i < dims[3]; ++i) {
+          filter.push_back(
+              data[o * strides[0] + h * strides[1] + w * strides[2] + i * strides[3]]);
+        }
+      }
+    }
+  }
+  return filter;
+}
+
+/*!
+ * \brief The size in bytes of the scratch buffer of the kernel of a layer, the largest of its
+ *  DSP and MVE variants, see the *_get_buffer_size functions of CMSIS-NN.
+ */
+int64_t ScratchSize(const Layer& layer) {
+  int64_t window = static_cast<int64_t>(layer.kernel_h) * layer.kernel_w;
+  int64_t in_channels = layer.input_shape.back();
+  switch (layer.kind) {
+    case Layer::kConv2D:
+      // Two im2col columns of int16, or four of int8 with MVE.
+      return 4 * in_channels * window;
+    case Layer::kDepthwiseConv2D:
+      // One im2col column of int16, or four blocks of 124 int8 channels with MVE.
+      return std::max<int64_t>(2 * in_channels * window, 4 * 124 * window);
+    default:
+      return 0;
+  }
+}
+
+/*! \brief Emit a C source module calling CMSIS-NN for a partitioned function. */
+class CodegenCMSISNN : public CodegenCBase {
+ public:
+  runtime::Module CreateModule(const Function& func) {
+    std::string symbol = backend::GetExtSymbol(func);
+    const auto* call = func->body.as<CallNode>();
+    const FunctionNode* composite = call ? call->op.as<FunctionNode>() : nullptr;
+    ICHECK(composite && composite->GetAttr<String>(attr::kComposite).defined())
+        << "cmsisnn: expect a call of a composite function, use partition_for_cmsisnn";
+    ICHECK_EQ(func->params.size(), 1U) << "cmsisnn: expect a single input";
+    Layer layer;
+    ICHECK(GetLayer(composite->body, &layer)) << "cmsisnn: unsupported layer " << symbol;
+
+    code_stream_ << "#include <stdint.h>\n"
+                 << "#include <tvm/runtime/c_runtime_api.h>\n"
+                 << "#include <tvm/runtime/c_backend_api.h>\n"
+                 << "#include <arm_nnfunctions.h>\n\n";
+    int channels = layer.output_shape.back();
+    PrintArray("static const int8_t", symbol + "_filter", GetFilter(layer));
+    std::vector<int32_t> bias(channels, 0);
+    if (layer.bias != nullptr) {
+      const auto* data = static_cast<const int32_t*>(layer.bias->data->data);
+      bias.assign(data, data + channels);
+    }
+    PrintArray("static const int32_t", symbol + "_bias", bias);
+    std::vector<int32_t> multipliers, shifts;
+    for (double scale : layer.scales) {
+      int32_t multiplier, shift;
+      QuantizeMultiplier(scale, &multiplier, &shift);
+      multipliers.push_back(multiplier);
+      shifts.push_back(shift);
+    }
+    if (layer.kind != Layer::kDense) {
+      PrintArray("static const int32_t", symbol + "_multiplier", multipliers);
+      PrintArray("static const int32_t", symbol + "_shift", shifts);
+    }
+    int64_t scratch_size = ScratchSize(layer);
+    if (scratch_size > 0) {
+      code_stream_ << "static int16_t " << symbol << "_scratch[" << (scratch_size + 1) / 2
+                   << "];\n\n";
+    }
+
+    PrintRuntimeFunctionHeader(symbol);
+    EnterScope();
+    PrintArgToData(0);
+    PrintRetToData(1);
+    PrintLine("cmsis_nn_context ctx;");
+    if (scratch_size > 0) {
+      PrintLine("ctx.buf = " + symbol + "_scratch;");
+      PrintLine("ctx.size = " + std::to_string(scratch_size) + ";");
+    } else {
+      PrintLine("ctx.buf = NULL;");
+      PrintLine("ctx.size = 0;");
+    }
+    const std::vector<int>& in = layer.input_shape;
+    const std::vector<int>& out = layer.output_shape;
+    std::string kernel;
+    std::string params;
+    if (layer.kind == Layer::kDense) {
+      kernel = "arm_fully_connected_s8";
+      params = "fc_params";
+      PrintLine("cmsis_nn_fc_params fc_params;");
+      PrintLine("fc_params.filter_offset = 0;");
+      PrintLine("cmsis_nn_per_tensor_quant_params quant_params;");
+      PrintLine("quant_params.multiplier = " + std::to_string(multipliers[0]) + ";");
+      PrintLine("quant_params.shift = " + std::to_string(shifts[0]) + ";");
+      PrintDims("input_dims", {in[0], 1, 1, in[1]});
+      PrintDims("filter_dims", {in[1], 1, 1, out[1]});
+      PrintDims("output_dims", {out[0], 1, 1, out[1]});
+    } else {
+      if (layer.kind == Layer::kConv2D) {
+        kernel = "arm_convolve_wrapper_s8";
+        params = "conv_params";
+        PrintLine("cmsis_nn_conv_params conv_params;");
+        PrintDims("filter_dims", {out[3], layer.kernel_h, layer.kernel_w, in[3]});
+      } else {
+        kernel = "arm_depthwise_conv_wrapper_s8";
+        params = "dw_conv_params";
+        PrintLine("cmsis_nn_dw_conv_params dw_conv_params;");
+        PrintLine("dw_conv_params.ch_mult = " + std::to_string(out[3] / in[3]) + ";");
+        PrintDims("filter_dims", {1, layer.kernel_h, layer.kernel_w, out[3]});
+      }
+      PrintLine(params + ".stride.h = " + std::to_string(layer.stride_h) + ";");
+      PrintLine(params + ".stride.w = " + std::to_string(layer.stride_w) + ";");
+      PrintLine(params + ".padding.h = " + std::to_string(layer.pad_h) + ";");
+      PrintLine(params + ".padding.w = " + std::to_string(layer.pad_w) + ";");
+      PrintLine(params + ".dilation.h = 1;");
+      PrintLine(params + ".dilation.w = 1;");
+      PrintLine("cmsis_nn_per_channel_quant_params quant_params;");
+      PrintLine("quant_params.multiplier = (int32_t*)" + symbol + "_multiplier;");
+      PrintLine("quant_params.shift = (int32_t*)" + symbol + "_shift;");
+      PrintDims("input_dims", {in[0], in[1], in[2], in[3]});
+      PrintDims("output_dims", {out[0], out[1], out[2], out[3]});
+    }
+    PrintLine(params + ".input_offset = " + std::to_string(-layer.input_zero_point) + ";");
+    PrintLine(params + ".output_offset = " + std::to_string(layer.output_zero_point) + ";");
+    PrintLine(params + ".activation.min = " + std::to_string(layer.activation_min) + ";");
+    PrintLine(params + ".activation.max = " + std::to_string(layer.activation_max) + ";");
+    PrintDims("bias_dims", {1, 1, 1, channels});
+    PrintLine("arm_status status = " + kernel + "(&ctx, &" + params +
+              ", &quant_params, &input_dims, "
+              "(const q7_t*)((const char*)arg0->data + arg0->byte_offset), &filter_dims, " +
+              symbol + "_filter, &bias_dims, " + symbol +
+              "_bias, &output_dims, (q7_t*)((char*)ret1->data + ret1->byte_offset));");
+    PrintLine("return status == ARM_MATH_SUCCESS ? 0 : -1;");
+    ExitScope();
+    code_stream_ << "}\n"
+                 << "#ifdef __cplusplus\n"
+                 << "}\n"
+                 << "#endif\n";
+
+    const auto* pf = runtime::Registry::Get("runtime.CSourceModuleCreate");
+    ICHECK(pf != nullptr) << "Cannot find csource module to create the external runtime module";
+    return (*pf)(code_stream_.str(), "c", Array<String>{symbol}, Array<String>());
+  }
+
+ private:
+  void PrintLine(const std::string& line) {
+    PrintIndents();
+    code_stream_ << line << "\n";
+  }
+
+  void PrintDims(const std::string& name, const std::vector<int>& dims) {
+    PrintLine("cmsis_nn_dims " + name + " = {" + std::to_string(dims[0]) + ", " +
+              std::to_string(dims[1]) + ", " + std::to_string(dims[2]) + ", " +
+              std::to_string(dims[3]) + "};");
+  }
+
+  template <typename T>
+  void PrintArray(const std::string& decl, const std::string& name, const std::vector<T>& values) {
+    code_stream_ << decl << " " << name << "[" << std::max<size_t>(values.size(), 1) << "] = {";
+    for (size_t i = 0; i < values.size(); ++i) {
+      code_stream_ << (i % 16 == 0 ? "\n    " : " ") << static_cast<int64_t>(values[i]) << ",";
+    }
+    code_stream_ << "\n};\n\n";
+  }
+};
+
+runtime::Module CMSISNNCompiler(const ObjectRef& ref) {
+  ICHECK(ref->IsInstance<FunctionNode>()) << "cmsisnn: expect a Relay function";
+  CodegenCMSISNN codegen;
+  return codegen.CreateModule(Downcast<Function>(ref));
+}
+
+TVM_REGISTER_GLOBAL("relay.ext.cmsisnn").set_body_typed(CMSISNNCompiler);
+
+// The weights and the requantization parameters are emitted into the C source.
+TVM_REGISTER_GLOBAL("relay.ext.cmsisnn.constant_updater")
+    .set_body_typed([](Expr expr, std::string symbol) { return Map<String, runtime::NDArray>(); });
+
+/*!
+ * \brief Partition the int8 convolutions and dense layers supported by CMSIS-NN. The graph
+ *  must be type checked, with its params bound as constants.
+ */
+transform::Pass PartitionForCMSISNN() {
+  auto layer = [](const std::string& op) {
+    DFPattern call = IsOp(op)({IsWildcard(), IsConstant(), IsConstant(), IsConstant(),
+                               IsConstant(), IsConstant()});
+    DFPattern with_bias = IsOp("nn.bias_add")({call, IsConstant()}) || call;
+    DFPattern requantize = IsOp("qnn.requantize")(
+        {with_bias, IsConstant(), IsConstant(), IsConstant(), IsConstant()});
+    return IsOp("clip")({requantize}) || requantize;
+  };
+  PackedFunc check = PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+    Expr root = args[0];
+    Layer layer;
+    *rv = GetLayer(root, &layer);
+  });
+  Array<runtime::String> names = {"cmsisnn.qnn_conv2d", "cmsisnn.qnn_dense"};
+  Array<DFPattern> patterns = {layer("qnn.conv2d"), layer("qnn.dense")};
+  return transform::Sequential(
+      {transform::InferType(), transform::MergeComposite(names, patterns, {check, check}),
+       transform::AnnotateTarget({"cmsisnn"}, false), transform::PartitionGraph(),
+       transform::InferType()},
+      "PartitionForCMSISNN");
+}
+
+TVM_REGISTER_GLOBAL("relay.ext.cmsisnn.partition_for_cmsisnn")
+    .set_body_typed(PartitionForCMSISNN);
+
+}  // namespace cmsisnn
+}  // namespace contrib
+}  // namespace relay
+}  // namespace tvm
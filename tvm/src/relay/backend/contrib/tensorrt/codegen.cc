@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "../../utils.h"
@@ -46,6 +47,8 @@ struct TensorRTCompilerConfigNode : public tvm::AttrsNode<TensorRTCompilerConfig
   bool use_implicit_batch;
   size_t max_workspace_size;
   bool remove_no_mac_subgraphs;
+  bool build_engine_at_compile_time;
+  Array<Integer> batch_profiles;
 
   TVM_DECLARE_ATTRS(TensorRTCompilerConfigNode, "ext.attrs.TensorRTCompilerConfigNode") {
     TVM_ATTR_FIELD(tensorrt_version)
@@ -54,6 +57,16 @@ struct TensorRTCompilerConfigNode : public tvm::AttrsNode<TensorRTCompilerConfig
     TVM_ATTR_FIELD(use_implicit_batch).set_default(true);
     TVM_ATTR_FIELD(max_workspace_size).set_default(size_t(1) << 30);
     TVM_ATTR_FIELD(remove_no_mac_subgraphs).set_default(false);
+    TVM_ATTR_FIELD(build_engine_at_compile_time)
+        .describe(
+            "Build the TensorRT engine during relay.build and embed it in the module binary. "
+            "Requires a GPU matching the deployment one.")
+        .set_default(false);
+    TVM_ATTR_FIELD(batch_profiles)
+        .describe(
+            "Upper bounds of the batch size ranges that share one engine, e.g. [8, 32] for the "
+            "optimization profiles [1, 8] and [9, 32]. Empty to build one engine per batch size.")
+        .set_default(Array<Integer>());
   }
 };
 
@@ -191,6 +204,13 @@ class TensorRTJSONSerializer : public backend::contrib::JSONSerializer {
     node->SetAttr("tensorrt_version", tensorrt_version_attr);
     node->SetAttr("use_implicit_batch", use_implicit_batch_attr);
     node->SetAttr("max_workspace_size", max_workspace_size_attr);
+    std::vector<std::string> batch_profiles;
+    for (const auto& bound : cfg.value()->batch_profiles) {
+      batch_profiles.push_back(std::to_string(bound->value));
+    }
+    std::vector<dmlc::any> batch_profiles_attr;
+    batch_profiles_attr.emplace_back(batch_profiles);
+    node->SetAttr("batch_profiles", batch_profiles_attr);
   }
 };
 
@@ -211,6 +231,22 @@ runtime::Module TensorRTCompiler(const ObjectRef& ref) {
   const auto* pf = runtime::Registry::Get("runtime.tensorrt_runtime_create");
   ICHECK(pf != nullptr) << "Cannot find TensorRT runtime module create function.";
   runtime::Module lib = (*pf)(func_name, graph_json, param_names);
+
+  auto cfg = transform::PassContext::Current()->GetConfig<TensorRTCompilerConfig>(
+      "relay.ext.tensorrt.options");
+  if (cfg.defined() && cfg.value()->build_engine_at_compile_time) {
+    // Bind the constants the same way the metadata module does at load time, then build the
+    // engine so that SaveToBinary serializes it with the module.
+    std::unordered_map<std::string, runtime::NDArray> params;
+    backend::ConstantUpdater(func_name, &params).VisitExpr(func);
+    Array<runtime::NDArray> consts;
+    for (const auto& name : param_names) {
+      ICHECK(params.count(name)) << "Cannot find the constant " << name;
+      consts.push_back(params.at(name));
+    }
+    lib.GetFunction("__init_" + func_name)(consts);
+    lib.GetFunction("build_engine")();
+  }
   return lib;
 }
 
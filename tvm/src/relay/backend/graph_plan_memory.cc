@@ -22,14 +22,27 @@
  * \brief Memory index assignment pass for executing
  *   the program in the graph runtime.
  */
+#include <dmlc/json.h>
+#include <tvm/ir/transform.h>
 #include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/transform.h>
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op_attr_types.h>
 #include <tvm/tir/op.h>
 #include <tvm/target/target.h>
 
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
 #include "../../support/arena.h"
 #include "../../runtime/texture.h"
+#include "token_allocator.h"
+#include "utils.h"
 
 namespace tvm {
 namespace relay {
@@ -38,22 +51,6 @@ using TargetsMap = Map<Integer, Target>;
 using Texture2DShape = runtime::Texture2DShape<int64_t>;
 constexpr auto Is2DStorage = runtime::IsTextureStorage;
 
-struct StorageToken {
-  /*! \brief Reference counter */
-  int ref_counter{0};
-  /*! \brief number of bytes */
-  size_t max_bytes{0};
-  /*! \brief The corresponding tensor type node. */
-  const TensorTypeNode* ttype{nullptr};
-  /*! \brief virtual device index that corresponds to the device_type in
-   * DLContext. */
-  int device_type{0};
-  /*! \brief The storage id */
-  int64_t storage_id{-1};
-  /*! \brief The storage scope */
-  std::string storage_scope{"global"};
-};
-
 class StorageAllocaBaseVisitor : public ExprVisitor {
  public:
   // run the visitor on a function.
@@ -131,13 +128,7 @@ class StorageAllocaBaseVisitor : public ExprVisitor {
   virtual void CreateToken(const ExprNode* op, bool can_realloc) = 0;
 };
 
-/*!
- * \brief Collect the target specific tensor storage info for each expression's output.
- * \param expr The expression.
- * \param expr The device id map which can be used to infer device specific storage scope availability.
- * \param expr The target mapping from device id to target.
- * \return The device based storage mapping.
- */
+namespace backend {
 Map<Expr, Array<String>> CollectStorageInfo(const Expr& expr, const Map<Expr, Integer>& dev_map, const TargetsMap& target_map) {
   auto less = [](Integer i, Integer j) {
     auto i_imm = i.as<tir::IntImmNode>();
@@ -163,6 +154,7 @@ Map<Expr, Array<String>> CollectStorageInfo(const Expr& expr, const Map<Expr, In
   }
   return storage_info;
 }
+}  // namespace backend
 
 class StorageAllocaInit : protected StorageAllocaBaseVisitor {
  public:
@@ -172,7 +164,7 @@ class StorageAllocaInit : protected StorageAllocaBaseVisitor {
   std::unordered_map<const ExprNode*, std::vector<StorageToken*> > GetInitTokenMap(
       const Function& func, const TargetsMap& targets) {
     node_device_map_ = CollectDeviceInfo(func);
-    node_storage_map_ = CollectStorageInfo(func, node_device_map_, targets);
+    node_storage_map_ = backend::CollectStorageInfo(func, node_device_map_, targets);
     this->Run(func);
     return std::move(token_map_);
   }
@@ -242,10 +234,38 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   // Run storage allocation for a function.
   Map<Expr, runtime::ADT> Plan(const Function& func, const TargetsMap& targets) {
     prototype_ = StorageAllocaInit(&arena_).GetInitTokenMap(func, targets);
+    for (const auto& kv : targets) {
+      // Without device annotations, as in the build for a single target, the tokens have no
+      // device type and follow the options of that target.
+      std::vector<int> device_types{static_cast<int>(kv.first->value)};
+      if (targets.size() == 1) device_types.push_back(0);
+      for (int device_type : device_types) {
+        if (auto limit = kv.second->GetAttr<Integer>("texture_spatial_limit")) {
+          allocator_.SetTextureSpatialLimit(device_type, limit.value()->value);
+        }
+        if (kv.second->GetAttr<Bool>("texture_inplace", Bool(false)).value()) {
+          inplace_devices_.insert(device_type);
+        }
+        if (kv.second->GetAttr<Bool>("texture_concat", Bool(false)).value()) {
+          concat_devices_.insert(device_type);
+        }
+      }
+    }
+    if (!concat_devices_.empty()) this->FindTextureConcats(func);
+    // The greedy by size planner assigns the flat storage once the lifetimes of all the
+    // tensors are known, so the visit gives every flat tensor a storage of its own.
+    String planner = transform::PassContext::Current()
+                         ->GetConfig<String>("relay.backend.graph_memory_planner", String("token"))
+                         .value();
+    ICHECK(planner == "token" || planner == "greedy_by_size")
+        << "Unknown graph memory planner " << planner << ", expected token or greedy_by_size";
+    allocator_.SetDeferFlatReuse(planner == "greedy_by_size");
     this->Run(func);
+    if (planner == "greedy_by_size") this->PlanFlatStorageBySize();
 
-    // The value of smap contains two integer arrays where the first array
-    // contains the planned storage ids and the second holds the device types.
+    // The value of smap contains the planned storage ids, the device types and the storage
+    // scopes. When inputs of concatenations are planned into rows of their output texture,
+    // it also holds their first row, -1 for the other tensors.
     Map<Expr, runtime::ADT> smap;
     int num_annotated_nodes = 0;
     int num_nodes = 0;
@@ -254,6 +274,7 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
       std::vector<Integer> storage_ids;
       std::vector<Integer> device_types;
       std::vector<String> storage_scopes;
+      std::vector<Integer> row_offsets;
       for (StorageToken* tok : kv.second) {
         if (tok->device_type) {
           num_annotated_nodes++;
@@ -262,9 +283,12 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
         storage_ids.push_back(tok->storage_id);
         device_types.push_back(tok->device_type);
         storage_scopes.push_back(tok->storage_scope);
+        auto slice = slices_.find(tok);
+        row_offsets.push_back(slice != slices_.end() ? static_cast<int>(slice->second.row) : -1);
       }
       std::vector<ObjectRef> fields{
         Array<Integer>{storage_ids}, Array<Integer>{device_types}, Array<String>{storage_scopes}};
+      if (!slices_.empty()) fields.push_back(Array<Integer>{row_offsets});
       smap.Set(GetRef<Expr>(kv.first), runtime::ADT::Tuple(fields));
     }
     // Either all or none of the nodes should be annotated.
@@ -276,6 +300,100 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
     return smap;
   }
 
+  /*!
+   * \brief Plan a function and report the planned storage.
+   *
+   *  The nodes are numbered in execution order from 1, step 0 holding the inputs,
+   *  parameters and constants. Each storage id reports its size in bytes, the bytes of
+   *  the largest tensor placed in it, its 2-D extent for texture storage, and the
+   *  inclusive steps it is live over with the node which opened each of them. The
+   *  report also has the bytes live at each step and the storage live at the peak.
+   */
+  Map<String, ObjectRef> PlanStats(const Function& func, const TargetsMap& targets) {
+    this->Plan(func, targets);
+    int64_t buffer_bytes = 0, texture_bytes = 0, requested_bytes = 0;
+    std::map<int64_t, int64_t> sizes;
+    Array<ObjectRef> storage;
+    for (auto& kv : stats_) {
+      StorageStats& st = kv.second;
+      if (st.live) st.lifetimes.back().second = step_;
+      Map<String, ObjectRef> info;
+      info.Set("storage_id", Integer(kv.first));
+      info.Set("device_type", Integer(st.token->device_type));
+      info.Set("scope", String(st.token->storage_scope));
+      int64_t bytes = static_cast<int64_t>(st.token->max_bytes);
+      if (TokenAllocator::Is2DStorage(st.token)) {
+        Texture2DShape extent = allocator_.GetTexture2DExtent(st.token);
+        const DataType& dtype = st.token->ttype->dtype;
+        bytes = extent.width * extent.height * extent.depth * extent.channel *
+                ((dtype.bits() + 7) / 8);
+        info.Set("width", Integer(extent.width));
+        info.Set("height", Integer(extent.height));
+        info.Set("channel", Integer(extent.channel));
+        info.Set("depth", Integer(extent.depth));
+        texture_bytes += bytes;
+      } else {
+        buffer_bytes += bytes;
+      }
+      sizes[kv.first] = bytes;
+      requested_bytes += st.requested_bytes;
+      info.Set("bytes", Bytes(bytes));
+      info.Set("requested_bytes", Bytes(st.requested_bytes));
+      Array<ObjectRef> lifetimes;
+      for (const auto& life : st.lifetimes) {
+        lifetimes.push_back(Array<Integer>{Integer(life.first), Integer(life.second)});
+      }
+      info.Set("lifetimes", lifetimes);
+      Array<String> producers;
+      for (const std::string& producer : st.producers) producers.push_back(producer);
+      info.Set("producers", producers);
+      storage.push_back(info);
+    }
+    // The bytes live at each step, and the storage live at the first step reaching the peak
+    std::vector<int64_t> live_bytes(step_ + 1, 0);
+    for (const auto& kv : stats_) {
+      for (const auto& life : kv.second.lifetimes) {
+        for (int64_t step = life.first; step <= life.second; ++step) {
+          live_bytes[step] += sizes[kv.first];
+        }
+      }
+    }
+    int64_t peak_step = std::max_element(live_bytes.begin(), live_bytes.end()) - live_bytes.begin();
+    Array<Integer> peak_storage_ids;
+    for (const auto& kv : stats_) {
+      for (const auto& life : kv.second.lifetimes) {
+        if (life.first <= peak_step && peak_step <= life.second) {
+          peak_storage_ids.push_back(Integer(kv.first));
+          break;
+        }
+      }
+    }
+    Array<String> step_names;
+    Array<IntImm> live;
+    for (int64_t step = 0; step <= step_; ++step) {
+      step_names.push_back(step_names_[step]);
+      live.push_back(Bytes(live_bytes[step]));
+    }
+    int64_t total_bytes = buffer_bytes + texture_bytes;
+    Map<String, ObjectRef> stats;
+    stats.Set("storage", storage);
+    stats.Set("num_steps", Integer(step_));
+    stats.Set("step_names", step_names);
+    stats.Set("live_bytes", live);
+    stats.Set("peak_bytes", Bytes(live_bytes[peak_step]));
+    stats.Set("peak_step", Integer(peak_step));
+    stats.Set("peak_node", String(step_names_[peak_step]));
+    stats.Set("peak_storage_ids", peak_storage_ids);
+    stats.Set("buffer_bytes", Bytes(buffer_bytes));
+    stats.Set("texture_bytes", Bytes(texture_bytes));
+    stats.Set("total_bytes", Bytes(total_bytes));
+    // The share of the planned bytes no tensor needs, as storage is sized for its largest
+    double fragmentation =
+        total_bytes > 0 ? 1.0 - static_cast<double>(requested_bytes) / total_bytes : 0.0;
+    stats.Set("fragmentation", FloatImm(DataType::Float(64), fragmentation));
+    return stats;
+  }
+
  protected:
   using StorageAllocaBaseVisitor::VisitExpr_;
   // override create token by getting token as prototype requirements.
@@ -285,9 +403,9 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
     ICHECK(it != prototype_.end());
     std::vector<StorageToken*> tokens;
     for (StorageToken* tok : it->second) {
-      // TODO(csullivan): Remove the check on global which
-      // prevents memory reuse for texture memory
-      if (can_realloc && tok->storage_scope == "global") {
+      size_t requested_bytes = TokenAllocator::Is2DStorage(tok) ? allocator_.GetTexture2DBytes(tok)
+                                                                : allocator_.GetMemorySize(tok);
+      if (can_realloc) {
         tokens.push_back(allocator_.Request(tok));
       } else {
         // Allocate a new token,
@@ -295,8 +413,10 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
         allocated_tok->device_type = tok->device_type;
         // ensure it never get de-allocated.
         allocated_tok->ref_counter += 1;
+        fixed_tokens_.insert(allocated_tok);
         tokens.push_back(allocated_tok);
       }
+      this->Track(tokens.back(), requested_bytes, can_realloc ? step_names_.back() : "input");
     }
     token_map_[op] = tokens;
   }
@@ -309,130 +429,352 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
         args.push_back(tok);
       }
     }
-    // create token for the call node.
-    CreateToken(op, true);
+    ++step_;
+    step_names_.push_back(GetNodeName(op));
+    // create token for the call node, write into the rows of the concatenation it is an input
+    // of, or write in place of an input it is the last use of.
+    if (!CreateConcatToken(op) && !CreateInplaceToken(op)) {
+      CreateToken(op, true);
+    }
     // check if there is orphaned output that can be released immediately.
     for (StorageToken* tok : token_map_.at(op)) {
-      allocator_.CheckForRelease(tok);
+      this->Release(tok);
     }
     for (StorageToken* tok : args) {
       tok->ref_counter -= 1;
-      allocator_.CheckForRelease(tok);
+      this->Release(tok);
     }
   }
 
  private:
-  class TokenAllocator1D {
-  public:
-    /*!
-     * \brief Request a storage token for a given prototype.
-     * \param prototype. The prototype storage token.
-     * \return The result token.
-     */
-    StorageToken* Request(StorageToken* prototype) {
-      // calculate the size;
-      size_t size = GetMemorySize(prototype);
-      // search memory block in [size / match_range_, size * match_range_)
-      if (match_range_ == 0) {
-        return nullptr;
-      }
-      auto begin = free_.lower_bound(size / match_range_);
-      auto mid = free_.lower_bound(size);
-      auto end = free_.upper_bound(size * match_range_);
-      // search for memory blocks larger than requested
-      for (auto it = mid; it != end; ++it) {
-        StorageToken* tok = it->second;
-        if (tok->device_type != prototype->device_type) continue;
-        ICHECK_EQ(tok->ref_counter, 0);
-        // Use exect matching strategy
-        tok->max_bytes = std::max(size, tok->max_bytes);
-        tok->ref_counter = prototype->ref_counter;
-        // find a exact match, erase from map and return
-        free_.erase(it);
-        return tok;
+  /*! \brief The planned use of a storage id, for PlanStats. */
+  struct StorageStats {
+    /*! \brief The token of the storage. */
+    StorageToken* token{nullptr};
+    /*! \brief The bytes of the largest tensor placed in the storage. */
+    int64_t requested_bytes{0};
+    /*! \brief The inclusive steps the storage is live over. */
+    std::vector<std::pair<int64_t, int64_t>> lifetimes;
+    /*! \brief The node opening each lifetime. */
+    std::vector<std::string> producers;
+    /*! \brief Whether the last lifetime is still open. */
+    bool live{false};
+  };
+
+  /*!
+   * \brief Record that a tensor is placed in the storage of a token.
+   * \param tok The token.
+   * \param requested_bytes The bytes of the tensor.
+   * \param producer The node producing the tensor.
+   */
+  void Track(StorageToken* tok, size_t requested_bytes, const std::string& producer) {
+    StorageStats& st = stats_[tok->storage_id];
+    st.token = tok;
+    st.requested_bytes = std::max(st.requested_bytes, static_cast<int64_t>(requested_bytes));
+    if (!st.live) {
+      st.lifetimes.emplace_back(step_, step_);
+      st.producers.push_back(producer);
+      st.live = true;
+    }
+  }
+  /*!
+   * \brief Release a token if it is no longer referenced.
+   * \param tok The token.
+   */
+  void Release(StorageToken* tok) {
+    // The rows of a concatenation are released with it, once none of them is still read
+    auto slice = slices_.find(tok);
+    if (slice != slices_.end()) {
+      if (tok->ref_counter == 0 && !slice->second.released) {
+        slice->second.released = true;
+        slice->second.parent->ref_counter -= 1;
+        this->Release(slice->second.parent);
       }
-      // then search for memory blocks smaller than requested space
-      for (auto it = mid; it != begin;) {
-        --it;
-        StorageToken* tok = it->second;
-        if (tok->device_type != prototype->device_type) continue;
-        ICHECK_EQ(tok->ref_counter, 0);
-        // Use exect matching strategy
-        tok->max_bytes = std::max(size, tok->max_bytes);
-        tok->ref_counter = prototype->ref_counter;
-        // erase from map and return
-        free_.erase(it);
-        return tok;
+      return;
+    }
+    allocator_.CheckForRelease(tok);
+    if (tok->ref_counter != 0) return;
+    StorageStats& st = stats_[tok->storage_id];
+    if (st.live) {
+      st.lifetimes.back().second = step_;
+      st.live = false;
+    }
+  }
+  /*!
+   * \brief Assign the storage of the flat tensors from their lifetimes, like the greedy by
+   *  size strategy of TFLite. The tensors are taken from the largest, and each is placed in
+   *  the smallest storage of its device and scope that no tensor living at the same time is
+   *  placed in, or in a new storage. Unlike the token allocator, which reuses the free
+   *  storage in execution order, this sees the whole graph, so the large tensors get the
+   *  storage first and the small ones fill the gaps between them. The storage ids are then
+   *  renumbered from 0.
+   */
+  void PlanFlatStorageBySize() {
+    struct Tensor {
+      StorageToken* tok;
+      int64_t begin;
+      int64_t end;
+    };
+    std::vector<Tensor> tensors;
+    std::unordered_set<StorageToken*> visited;
+    for (const auto& kv : token_map_) {
+      for (StorageToken* tok : kv.second) {
+        // Parameters, inputs and constants keep the storage they are loaded in
+        if (!visited.insert(tok).second || TokenAllocator::Is2DStorage(tok) ||
+            fixed_tokens_.count(tok) || slices_.count(tok)) {
+          continue;
+        }
+        const StorageStats& st = stats_.at(tok->storage_id);
+        int64_t end = st.live ? step_ : st.lifetimes.back().second;
+        tensors.push_back({tok, st.lifetimes.front().first, end});
       }
-      return nullptr;
     }
-    /*!
-     * \brief Alloacte a storage token by consuming prototype
-     * \param prototype The prototype token.
-     * \param size The size of memory being requested.
-     */
-    StorageToken* Alloc(StorageToken* prototype, int64_t storage_id) {
-      size_t size = GetMemorySize(prototype);
-      prototype->max_bytes = size;
-      prototype->storage_id = storage_id;
-      data_.push_back(prototype);
-      return prototype;
+    // Largest first, then in allocation order, so that the plan is deterministic
+    std::sort(tensors.begin(), tensors.end(), [](const Tensor& a, const Tensor& b) {
+      if (a.tok->max_bytes != b.tok->max_bytes) return a.tok->max_bytes > b.tok->max_bytes;
+      return a.tok->storage_id < b.tok->storage_id;
+    });
+    struct Storage {
+      StorageToken* tok;
+      std::vector<std::pair<int64_t, int64_t>> lifetimes;
+    };
+    std::vector<Storage> storage;
+    for (const Tensor& tensor : tensors) {
+      int64_t best = -1;
+      for (size_t i = 0; i < storage.size(); ++i) {
+        const Storage& cand = storage[i];
+        if (cand.tok->device_type != tensor.tok->device_type ||
+            cand.tok->storage_scope != tensor.tok->storage_scope ||
+            (best >= 0 && cand.tok->max_bytes >= storage[best].tok->max_bytes)) {
+          continue;
+        }
+        bool overlap = std::any_of(cand.lifetimes.begin(), cand.lifetimes.end(),
+                                   [&tensor](const std::pair<int64_t, int64_t>& life) {
+                                     return life.first <= tensor.end && tensor.begin <= life.second;
+                                   });
+        if (!overlap) best = static_cast<int64_t>(i);
+      }
+      if (best < 0) {
+        storage.push_back({tensor.tok, {}});
+        best = static_cast<int64_t>(storage.size()) - 1;
+      } else {
+        // Every storage is at least as large as the tensors placed after its first one
+        StorageToken* dst = storage[best].tok;
+        StorageStats st = std::move(stats_.at(tensor.tok->storage_id));
+        stats_.erase(tensor.tok->storage_id);
+        StorageStats& merged = stats_.at(dst->storage_id);
+        merged.requested_bytes = std::max(merged.requested_bytes, st.requested_bytes);
+        merged.lifetimes.insert(merged.lifetimes.end(), st.lifetimes.begin(), st.lifetimes.end());
+        merged.producers.insert(merged.producers.end(), st.producers.begin(), st.producers.end());
+        merged.live |= st.live;
+        tensor.tok->storage_id = dst->storage_id;
+      }
+      storage[best].lifetimes.emplace_back(tensor.begin, tensor.end);
     }
-    /*!
-     * \brief Check if we can release token.
-     * \param tok The token to be released.
-     */
-    void CheckForRelease(StorageToken* tok) {
-      ICHECK_GE(tok->storage_id, 0);
-      ICHECK_GE(tok->ref_counter, 0);
-      if (tok->ref_counter == 0) {
-        free_.insert({tok->max_bytes, tok});
+    // Keep the lifetimes of each storage in order, the open one last
+    for (auto& kv : stats_) {
+      StorageStats& st = kv.second;
+      std::vector<size_t> order(st.lifetimes.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&st](size_t a, size_t b) {
+        return st.lifetimes[a].first < st.lifetimes[b].first;
+      });
+      std::vector<std::pair<int64_t, int64_t>> lifetimes;
+      std::vector<std::string> producers;
+      for (size_t i : order) {
+        lifetimes.push_back(st.lifetimes[i]);
+        producers.push_back(st.producers[i]);
       }
+      st.lifetimes = std::move(lifetimes);
+      st.producers = std::move(producers);
     }
-    /*!
-     * \return totoal number of bytes allocated
-     */
-    size_t TotalAllocBytes() const {
-      size_t total = 0;
-      for (const auto* p : data_) {
-        total += p->max_bytes;
+    // Renumber the storage ids left from 0
+    std::map<int64_t, int64_t> ids;
+    for (const auto& kv : stats_) ids.emplace(kv.first, static_cast<int64_t>(ids.size()));
+    visited.clear();
+    for (const auto& kv : token_map_) {
+      for (StorageToken* tok : kv.second) {
+        if (!visited.insert(tok).second) continue;
+        tok->storage_id = ids.at(tok->storage_id);
       }
-      return total;
     }
-    /*!
-     * \brief ceil(size/word_size) to get number of words.
-     * \param size The original size.
-     * \param word_size The element size.
-     */
-    static size_t DivRoundUp(size_t size, size_t word_size) {
-      return (size + word_size - 1) / word_size;
+    std::map<int64_t, StorageStats> stats;
+    for (auto& kv : stats_) stats.emplace(ids.at(kv.first), std::move(kv.second));
+    stats_ = std::move(stats);
+    allocator_.RenumberTextures(ids);
+  }
+  /*!
+   * \brief Let an elementwise texture primitive write its output into the texture of an input
+   *  with the same type that dies at the call, on the devices allowing in place textures.
+   *  Every work item of such a kernel reads the texels of the input before writing the same
+   *  texels of the output, so the output overwrites nothing that is still read.
+   * \param op The call node.
+   * \return Whether the output token was created.
+   */
+  bool CreateInplaceToken(const CallNode* op) {
+    auto it = prototype_.find(op);
+    if (it == prototype_.end() || it->second.size() != 1) return false;
+    StorageToken* proto = it->second[0];
+    if (!TokenAllocator::Is2DStorage(proto) || !inplace_devices_.count(proto->device_type) ||
+        !IsElemwisePrimitive(op->op)) {
+      return false;
     }
-    /*!
-     * \brief Get the memory requirement.
-     * \param prototype The prototype token.
-     * \return The required memory size.
-     */
-    size_t GetMemorySize(StorageToken* prototype) {
-      const TensorTypeNode* ttype = prototype->ttype;
-      ICHECK(ttype != nullptr);
-      size_t size = 1;
-      for (IndexExpr dim : ttype->shape) {
-        const int64_t* pval = tir::as_const_int(dim);
-        ICHECK(pval != nullptr) << "Cannot allocate memory symbolic tensor shape " << ttype->shape;
-        ICHECK_GE(*pval, 0) << "Cannot allocate memory for tensor with negative shape" << *pval;
-        size *= static_cast<size_t>(pval[0]);
+    for (const Expr& arg : op->args) {
+      auto tok_it = token_map_.find(arg.operator->());
+      if (tok_it == token_map_.end() || tok_it->second.size() != 1) continue;
+      StorageToken* tok = tok_it->second[0];
+      // The call must hold the last reference, parameters and constants are never released.
+      // The rows of a concatenation belong to its output, which may still be read.
+      if (tok->ref_counter != 1 || slices_.count(tok) ||
+          tok->storage_scope != proto->storage_scope || tok->device_type != proto->device_type ||
+          !StructuralEqual()(arg->checked_type(), op->checked_type())) {
+        continue;
       }
-      size *= DivRoundUp(ttype->dtype.bits() * ttype->dtype.lanes(), 8);
-      return size;
+      tok->ref_counter += proto->ref_counter;
+      this->Track(tok, allocator_.GetTexture2DBytes(proto), step_names_.back());
+      token_map_[op] = {tok};
+      return true;
     }
-  private:
-    // scale used for rough match
-    const size_t match_range_{16};
-    // free list of storage entry
-    std::multimap<size_t, StorageToken*> free_;
-    // all the storage resources available
-    std::vector<StorageToken*> data_;
-  };
+    return false;
+  }
+  /*!
+   * \brief Find the concatenations of textures whose inputs can be written straight into row
+   *  ranges of the output texture, on the devices allowing it. Such a concatenation takes the
+   *  primitive function outputs of one texture scope and type, along an axis flattened into
+   *  rows behind unit axes only, so that every input is a contiguous range of rows.
+   * \param func The function to plan.
+   */
+  void FindTextureConcats(const Function& func) {
+    static const Op& concat_op = Op::Get("concatenate");
+    std::unordered_set<const ExprNode*> claimed;
+    PostOrderVisit(func->body, [&](const Expr& expr) {
+      const auto* call = expr.as<CallNode>();
+      const auto* callee = call != nullptr ? call->op.as<FunctionNode>() : nullptr;
+      if (callee == nullptr || !callee->HasNonzeroAttr(attr::kPrimitive)) return;
+      const auto* body = callee->body.as<CallNode>();
+      if (body == nullptr || body->op != concat_op) return;
+      const auto* fields = body->args[0].as<TupleNode>();
+      if (fields == nullptr || fields->fields.size() != call->args.size()) return;
+      for (size_t i = 0; i < call->args.size(); ++i) {
+        if (fields->fields[i].get() != callee->params[i].get()) return;
+      }
+      auto it = prototype_.find(call);
+      if (it == prototype_.end() || it->second.size() != 1) return;
+      StorageToken* proto = it->second[0];
+      const std::string& scope = proto->storage_scope;
+      if (!concat_devices_.count(proto->device_type) || !TokenAllocator::Is2DStorage(proto) ||
+          runtime::IsTextureArrayStorage(scope) || scope == "texture:weight") {
+        return;
+      }
+      const Array<PrimExpr>& shape = proto->ttype->shape;
+      int rank = static_cast<int>(shape.size());
+      int axis = body->attrs.as<ConcatenateAttrs>()->axis;
+      if (axis < 0) axis += rank;
+      int separator = static_cast<int>(runtime::DefaultTextureLayoutSeparator(rank, scope));
+      if (axis >= separator) return;
+      int64_t rows = 1;
+      for (int i = 0; i < separator; ++i) {
+        if (i < axis && !tir::is_one(shape[i])) return;
+        if (i > axis) rows *= *tir::as_const_int(shape[i]);
+      }
+      std::vector<std::pair<const ExprNode*, int64_t>> inputs;
+      int64_t offset = 0;
+      for (const Expr& arg : call->args) {
+        const auto* producer = arg.as<CallNode>();
+        auto pit = prototype_.find(arg.operator->());
+        if (producer == nullptr || !producer->op.as<FunctionNode>() || claimed.count(producer) ||
+            concat_rows_.count(producer) || pit == prototype_.end() || pit->second.size() != 1 ||
+            pit->second[0]->storage_scope != scope ||
+            pit->second[0]->device_type != proto->device_type ||
+            pit->second[0]->ttype->dtype != proto->ttype->dtype) {
+          return;
+        }
+        for (const auto& input : inputs) {
+          if (input.first == producer) return;
+        }
+        inputs.emplace_back(producer, offset * rows);
+        offset += *tir::as_const_int(pit->second[0]->ttype->shape[axis]);
+      }
+      for (const auto& input : inputs) {
+        claimed.insert(input.first);
+        concat_rows_[input.first] = {call, input.second};
+      }
+      concat_rows_[call] = {nullptr, 0};
+    });
+  }
+  /*!
+   * \brief Create the token of a concatenation planned by FindTextureConcats, or of one of its
+   *  inputs as the rows of the output texture. The output is allocated with its first input,
+   *  and held until every row is released.
+   * \param op The call node.
+   * \return Whether the token was created.
+   */
+  bool CreateConcatToken(const CallNode* op) {
+    auto it = concat_rows_.find(op);
+    if (it == concat_rows_.end()) return false;
+    const CallNode* concat = it->second.first == nullptr ? op : it->second.first;
+    StorageToken*& parent = concat_tokens_[concat];
+    if (parent == nullptr) {
+      StorageToken* proto = prototype_.at(concat)[0];
+      parent = allocator_.Request(proto);
+      this->Track(parent, allocator_.GetTexture2DBytes(proto), GetNodeName(concat));
+    }
+    if (concat == op) {
+      token_map_[op] = {parent};
+      return true;
+    }
+    StorageToken* slice = arena_.make<StorageToken>();
+    *slice = *prototype_.at(op)[0];
+    slice->storage_id = parent->storage_id;
+    slices_[slice] = {parent, it->second.second, false};
+    parent->ref_counter += 1;
+    token_map_[op] = {slice};
+    return true;
+  }
+  /*!
+   * \brief Whether a callee is a primitive function of elementwise and broadcast operators.
+   * \param callee The callee.
+   */
+  static bool IsElemwisePrimitive(const Expr& callee) {
+    const auto* func = callee.as<FunctionNode>();
+    if (func == nullptr || !func->HasNonzeroAttr(attr::kPrimitive)) return false;
+    static auto fpattern = Op::GetAttrMap<TOpPattern>("TOpPattern");
+    bool elemwise = true;
+    PostOrderVisit(func->body, [&elemwise](const Expr& expr) {
+      if (const auto* call = expr.as<CallNode>()) {
+        const auto* node = call->op.as<OpNode>();
+        if (node == nullptr || fpattern.get(GetRef<Op>(node), kOpaque) > kBroadcast) {
+          elemwise = false;
+        }
+      } else if (expr.as<TupleNode>() || expr.as<TupleGetItemNode>()) {
+        elemwise = false;
+      }
+    });
+    return elemwise;
+  }
+  /*! \brief A byte count in the report, which may exceed 32 bits. */
+  static IntImm Bytes(int64_t value) { return IntImm(DataType::Int(64), value); }
+  /*!
+   * \brief Get the name of a node in the report, following the fused function naming.
+   * \param op The call node.
+   * \return The name.
+   */
+  static std::string GetNodeName(const CallNode* op) {
+    if (const auto* node = op->op.as<OpNode>()) return node->name;
+    if (const auto* node = op->op.as<GlobalVarNode>()) return node->name_hint;
+    std::ostringstream os;
+    os << "fused";
+    PostOrderVisit(op->op, [&os](const Expr& expr) {
+      if (const auto* call = expr.as<CallNode>()) {
+        if (const auto* node = call->op.as<OpNode>()) {
+          std::string name = node->name;
+          std::replace(name.begin(), name.end(), '.', '_');
+          os << "_" << name;
+        }
+      }
+    });
+    return os.str();
+  }
 
   class TokenAllocator2D {
   public:
@@ -450,13 +792,22 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
       MemBlock best_mem, new_mem;
       for (int64_t free_id : free_list_) {
         MemBlock& cached = blocks_[free_id];
-        // Can only reuse texture 2d blocks of the same type
-        if (cached.token_->ttype->dtype != prototype->ttype->dtype) {
+        // Can only reuse texture 2d blocks of the same type, device and layout convention,
+        // and texture arrays with as many images
+        if (cached.token_->ttype->dtype != prototype->ttype->dtype ||
+            cached.token_->device_type != prototype->device_type ||
+            cached.token_->storage_scope != prototype->storage_scope ||
+            GetSize2D(cached.token_).depth != shape.depth) {
           continue;
         }
         int64_t cached_size = cached.x_ * cached.y_;
         new_mem.x_ = std::max(cached.x_, shape.width);
         new_mem.y_ = std::max(cached.y_, shape.height);
+        // Blocks cannot grow beyond the image size supported by the device
+        auto it = spatial_limits_.find(prototype->device_type);
+        if (it != spatial_limits_.end() && (new_mem.x_ > it->second || new_mem.y_ > it->second)) {
+          continue;
+        }
         int64_t expanded_size = new_mem.x_ * new_mem.y_;
         int64_t added_size = expanded_size - cached_size;
         int64_t wasted_size = expanded_size - requested_size;
@@ -510,18 +861,47 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
     /*!
      * \brief Get the texture 2d size requirement
      * \param prototype The prototype token.
-     * \return The required texture 2d memory size in (width, height, channel).
+     * \return The required texture 2d memory size in (width, height, channel, depth).
      */
     Texture2DShape GetSize2D(StorageToken* prototype) {
       const TensorTypeNode* ttype = prototype->ttype;
       ICHECK(ttype != nullptr);
-      size_t axis = runtime::DefaultTextureLayoutSeparator(ttype->shape.size(), prototype->storage_scope);
       struct Shape {
         const Array<PrimExpr>& shape;
         int64_t operator[](size_t i) const { return *tir::as_const_int(shape[i]); }
       };
-      return runtime::ApplyTexture2DFlattening<int64_t>(Shape{ttype->shape}, ttype->shape.size(), axis);
+      return runtime::ApplyTextureFlattening<int64_t>(Shape{ttype->shape}, ttype->shape.size(),
+                                                      prototype->storage_scope);
     }
+    /*!
+     * \brief Set the maximum texture width and height of a device.
+     * \param device_type The device type.
+     * \param limit The maximum extent of either image axis.
+     */
+    void SetSpatialLimit(int device_type, int64_t limit) { spatial_limits_[device_type] = limit; }
+    /*!
+     * \brief Move the blocks to new storage ids.
+     * \param ids The new id of every storage id.
+     */
+    void Renumber(const std::map<int64_t, int64_t>& ids) {
+      std::unordered_map<int64_t, MemBlock> blocks;
+      for (const auto& kv : blocks_) blocks[ids.at(kv.first)] = kv.second;
+      std::unordered_set<int64_t> free_list;
+      for (int64_t id : free_list_) free_list.insert(ids.at(id));
+      blocks_ = std::move(blocks);
+      free_list_ = std::move(free_list);
+    }
+    /*!
+     * \brief Get the texture 2d extent of an allocated token, grown to fit the tensors reusing it.
+     * \param tok The token.
+     * \return The extent in (width, height, channel).
+     */
+    Texture2DShape GetExtent(StorageToken* tok) {
+      const MemBlock& block = blocks_.at(tok->storage_id);
+      Texture2DShape size = GetSize2D(tok);
+      return {block.x_, block.y_, size.channel, size.depth};
+    }
+
   private:
     struct MemBlock {
       StorageToken* token_;
@@ -531,6 +911,7 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
 
     std::unordered_map<int64_t, MemBlock> blocks_;
     std::unordered_set<int64_t> free_list_;
+    std::unordered_map<int, int64_t> spatial_limits_;
   };
 
   class TokenAllocator {
@@ -539,16 +920,36 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
       return Is2DStorage(proto) ? token_2d_.Alloc(proto, storage_ids_++) : token_1d_.Alloc(proto, storage_ids_++);
     }
     StorageToken* Request(StorageToken* proto) {
-      StorageToken* token = Is2DStorage(proto) ? token_2d_.Request(proto) : token_1d_.Request(proto);
+      StorageToken* token = Is2DStorage(proto) ? token_2d_.Request(proto)
+                            : defer_1d_        ? nullptr
+                                               : token_1d_.Request(proto);
       return token ? token : this->Alloc(proto);
     }
+    /*!
+     * \brief Give every flat request a storage of its own, to be assigned by a planner
+     *  seeing the lifetimes of all the tensors.
+     * \param defer Whether to defer the reuse of flat storage.
+     */
+    void SetDeferFlatReuse(bool defer) { defer_1d_ = defer; }
+    void RenumberTextures(const std::map<int64_t, int64_t>& ids) { token_2d_.Renumber(ids); }
     void CheckForRelease(StorageToken* tok) {
       return Is2DStorage(tok) ? token_2d_.CheckForRelease(tok) : token_1d_.CheckForRelease(tok);
     }
     static bool Is2DStorage(StorageToken* tok) { return relay::Is2DStorage(tok->storage_scope); }
+    void SetTextureSpatialLimit(int device_type, int64_t limit) {
+      token_2d_.SetSpatialLimit(device_type, limit);
+    }
+    size_t GetMemorySize(StorageToken* proto) { return token_1d_.GetMemorySize(proto); }
+    Texture2DShape GetTexture2DExtent(StorageToken* tok) { return token_2d_.GetExtent(tok); }
+    size_t GetTexture2DBytes(StorageToken* proto) {
+      Texture2DShape shape = token_2d_.GetSize2D(proto);
+      return shape.width * shape.height * shape.depth * shape.channel *
+             ((proto->ttype->dtype.bits() + 7) / 8);
+    }
 
   private:
     int64_t storage_ids_{0};
+    bool defer_1d_{false};
     TokenAllocator1D token_1d_;
     TokenAllocator2D token_2d_;
   };
@@ -559,6 +960,36 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   std::unordered_map<const ExprNode*, std::vector<StorageToken*> > prototype_;
   /*! \brief token allocator for optimizing 1d and 2d token alloc requests */
   TokenAllocator allocator_;
+  /*! \brief The planned use of each storage id. */
+  std::map<int64_t, StorageStats> stats_;
+  /*! \brief The tokens of the inputs, parameters and constants, which are never released. */
+  std::unordered_set<StorageToken*> fixed_tokens_;
+  /*! \brief The device types whose elementwise primitives may write textures in place. */
+  std::unordered_set<int> inplace_devices_;
+  /*! \brief The rows of a concatenation written by one of its inputs. */
+  struct Slice {
+    /*! \brief The token of the concatenation. */
+    StorageToken* parent;
+    /*! \brief The first row of the input in the texture of the concatenation. */
+    int64_t row;
+    /*! \brief Whether the rows are no longer read. */
+    bool released;
+  };
+  /*! \brief The device types whose concatenations of textures may alias their inputs. */
+  std::unordered_set<int> concat_devices_;
+  /*!
+   * \brief The concatenation and first row of every input written into the rows of one, and
+   *  a null call for the concatenations themselves.
+   */
+  std::unordered_map<const ExprNode*, std::pair<const CallNode*, int64_t>> concat_rows_;
+  /*! \brief The output token of each concatenation, once its first input is allocated. */
+  std::unordered_map<const CallNode*, StorageToken*> concat_tokens_;
+  /*! \brief The tokens of the inputs written into the rows of a concatenation. */
+  std::unordered_map<StorageToken*, Slice> slices_;
+  /*! \brief The number of call nodes visited. */
+  int64_t step_{0};
+  /*! \brief The name of the node of each step. */
+  std::vector<std::string> step_names_{"input"};
 };
 
 Map<Expr, runtime::ADT> GraphPlanMemory(const Function& func, const TargetsMap& targets) {
@@ -566,6 +997,48 @@ Map<Expr, runtime::ADT> GraphPlanMemory(const Function& func, const TargetsMap&
 }
 
 TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemory").set_body_typed(GraphPlanMemory);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.graph_memory_planner", String);
+
+Map<String, ObjectRef> GraphPlanMemoryStats(const Function& func, const TargetsMap& targets) {
+  return StorageAllocator().PlanStats(func, targets);
+}
+
+/*! \brief A report of GraphPlanMemoryStats, saved as JSON. */
+struct PlanStatsJSON {
+  ObjectRef value;
+
+  void Save(dmlc::JSONWriter* writer) const {
+    if (const auto* imm = value.as<IntImmNode>()) {
+      writer->WriteNumber(imm->value);
+    } else if (const auto* imm = value.as<FloatImmNode>()) {
+      writer->WriteNumber(imm->value);
+    } else if (const auto* str = value.as<runtime::StringObj>()) {
+      writer->WriteString(str->data);
+    } else if (const auto* arr = value.as<ArrayNode>()) {
+      writer->BeginArray(false);
+      for (const ObjectRef& item : *arr) {
+        writer->WriteArrayItem(PlanStatsJSON{item});
+      }
+      writer->EndArray();
+    } else {
+      writer->BeginObject(false);
+      for (const auto& kv : Downcast<Map<String, ObjectRef>>(value)) {
+        writer->WriteObjectKeyValue(std::string(kv.first), PlanStatsJSON{kv.second});
+      }
+      writer->EndObject();
+    }
+  }
+};
+
+TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemoryStats").set_body_typed(GraphPlanMemoryStats);
+
+TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemoryStatsJSON")
+    .set_body_typed([](const Function& func, const TargetsMap& targets) {
+      std::ostringstream os;
+      dmlc::JSONWriter writer(&os);
+      writer.Write(PlanStatsJSON{GraphPlanMemoryStats(func, targets)});
+      return os.str();
+    });
 
 }  // namespace relay
 }  // namespace tvm
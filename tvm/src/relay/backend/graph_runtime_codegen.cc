@@ -24,14 +24,19 @@
 
 #include <dmlc/any.h>
 #include <dmlc/json.h>
+#include <tvm/auto_scheduler/compute_dag.h>
 #include <tvm/ir/module.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/runtime/device_api.h>
 
+#include <algorithm>
+#include <functional>
 #include <list>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "../../runtime/texture.h"
 #include "compile_engine.h"
 #include "utils.h"
 
@@ -57,6 +62,8 @@ struct LoweredOutput {
   Map<String, IRModule> lowered_funcs;
   Array<tvm::runtime::Module> external_mods;
   std::unordered_map<std::string, std::pair<int, const tvm::runtime::NDArray>> params;
+  /*! \brief The size in bytes of every storage id of the memory plan. */
+  std::vector<int64_t> storage_sizes;
 };
 
 /*! \brief Node types */
@@ -82,6 +89,9 @@ class GraphNodeRef {
 
   inline void Load(dmlc::JSONReader* reader) { LOG(FATAL) << "Not implemented."; }
 
+  int ident() const { return ident_; }
+  int index() const { return index_; }
+
  protected:
   int ident_;
   int index_{0};
@@ -197,6 +207,10 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
       auto node_ptr = GraphInputNode::make_node_ptr(param->name_hint(), GraphAttrs());
       var_map_[param.get()] = AddNode(node_ptr, param);
     }
+    int lowering_threads = backend::GetLoweringThreads();
+    if (lowering_threads != 1) {
+      PrelowerPrimitiveFunctions(func, lowering_threads);
+    }
     heads_ = VisitExpr(func->body);
     std::ostringstream os;
     dmlc::JSONWriter writer(&os);
@@ -209,6 +223,7 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
           param.first,
           std::make_pair(static_cast<int>(param_storage_ids_[param.first]), param.second)));
     }
+    ret.storage_sizes = storage_sizes_;
 
     for (auto& kv : lowered_funcs_) {
       if (ret.lowered_funcs.count(kv.first) == 0) {
@@ -250,12 +265,13 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
     size_t count = storage_device_map_.count(expr);
     ICHECK_GT(count, 0) << "Expr is not existing in storage plan";
     auto storage_device_info = storage_device_map_[expr];
-    ICHECK_EQ(storage_device_info.size(), 3);
+    ICHECK(storage_device_info.size() == 3 || storage_device_info.size() == 4);
     // storage
     std::vector<int64_t> storage_info;
     for (auto& v : Downcast<IntegerArray>(storage_device_info[0])) {
       storage_info.push_back(v->value);
     }
+    RecordStorageSizes(checked_type, storage_info);
     node->attrs_["storage_id"] = std::move(storage_info);
     // storage scope
     std::vector<std::string> storage_scope;
@@ -263,6 +279,14 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
       storage_scope.push_back(std::string(v));
     }
     node->attrs_["storage_scope"] = std::move(storage_scope);
+    // first row of the outputs written into the texture of a concatenation
+    if (storage_device_info.size() == 4) {
+      std::vector<int64_t> row_offsets;
+      for (auto& v : Downcast<IntegerArray>(storage_device_info[3])) {
+        row_offsets.push_back(v->value);
+      }
+      node->attrs_["texture_row_offset"] = std::move(row_offsets);
+    }
     // type
     std::vector<int64_t> device_types;
     for (auto& v : Downcast<IntegerArray>(storage_device_info[1])) {
@@ -314,6 +338,108 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
     return {GraphNodeRef(node_id, 0)};
   }
 
+  /*!
+   * \brief Get the plan of the ahead-of-time executor, see tir::attr::kAOTPlan.
+   *
+   * \return The plan
+   */
+  Map<String, ObjectRef> GetAOTPlan() {
+    Array<Integer> entry_storage_ids;
+    Array<Array<Integer>> entry_shapes;
+    Array<String> entry_dtypes;
+    std::vector<int> node_row_ptr{0};
+    for (const auto& node : nodes_) {
+      const auto& shape_vec = dmlc::get<ShapeVector>(node->attrs_["shape"]);
+      const auto& storage_id = dmlc::get<std::vector<int64_t>>(node->attrs_["storage_id"]);
+      const auto& dtype_vec = dmlc::get<std::vector<std::string>>(node->attrs_["dtype"]);
+      for (int i = 0; i < node->num_outputs_; ++i) {
+        entry_storage_ids.push_back(Integer(static_cast<int>(storage_id[i])));
+        Array<Integer> shape;
+        for (int64_t dim : shape_vec[i]) {
+          shape.push_back(Integer(static_cast<int>(dim)));
+        }
+        entry_shapes.push_back(shape);
+        entry_dtypes.push_back(dtype_vec[i]);
+      }
+      node_row_ptr.push_back(node_row_ptr.back() + node->num_outputs_);
+    }
+    auto entry_id = [&node_row_ptr](const GraphNodeRef& ref) {
+      return Integer(node_row_ptr[ref.ident()] + ref.index());
+    };
+
+    Array<Integer> input_entries;
+    Array<String> call_funcs;
+    Array<Array<Integer>> call_args;
+    for (size_t nid = 0; nid < nodes_.size(); ++nid) {
+      if (nodes_[nid]->Type() == kGraphInputNode) {
+        if (params_.count(nodes_[nid]->name_) == 0) {
+          input_entries.push_back(Integer(node_row_ptr[nid]));
+        }
+        continue;
+      }
+      auto op_node = std::dynamic_pointer_cast<GraphOpNode>(nodes_[nid]);
+      // The outputs of a nop share the storage of its input.
+      if (op_node->op_name_ == "__nop") continue;
+      ICHECK_NE(op_node->op_name_, "__copy")
+          << "The ahead-of-time executor does not support heterogeneous execution";
+      Array<Integer> args;
+      for (const auto& ref : op_node->inputs_) {
+        args.push_back(entry_id(ref));
+      }
+      for (int i = 0; i < op_node->num_outputs_; ++i) {
+        args.push_back(Integer(node_row_ptr[nid] + i));
+      }
+      call_funcs.push_back(op_node->op_name_);
+      call_args.push_back(args);
+    }
+    Array<Integer> output_entries;
+    for (const auto& ref : heads_) {
+      output_entries.push_back(entry_id(ref));
+    }
+    std::vector<String> storage_params(storage_sizes_.size(), String(""));
+    for (const auto& kv : param_storage_ids_) {
+      storage_params[kv.second] = kv.first;
+    }
+
+    Map<String, ObjectRef> plan;
+    plan.Set("entry_storage_ids", entry_storage_ids);
+    plan.Set("entry_shapes", entry_shapes);
+    plan.Set("entry_dtypes", entry_dtypes);
+    plan.Set("storage_params", Array<String>(storage_params));
+    plan.Set("input_entries", input_entries);
+    plan.Set("output_entries", output_entries);
+    plan.Set("call_funcs", call_funcs);
+    plan.Set("call_args", call_args);
+    return plan;
+  }
+
+  /*!
+   * \brief Grow the sizes of the storage ids holding the outputs of a node.
+   *
+   * \param checked_type The type of the node
+   * \param storage_ids The storage id of every output of the node
+   */
+  void RecordStorageSizes(const Type& checked_type, const std::vector<int64_t>& storage_ids) {
+    std::vector<const TensorTypeNode*> tensor_types;
+    if (const auto* tuple_type = checked_type.as<TupleTypeNode>()) {
+      for (const Type& field : tuple_type->fields) {
+        tensor_types.push_back(field.as<TensorTypeNode>());
+      }
+    } else {
+      tensor_types.push_back(checked_type.as<TensorTypeNode>());
+    }
+    for (size_t i = 0; i < tensor_types.size() && i < storage_ids.size(); ++i) {
+      if (tensor_types[i] == nullptr || storage_ids[i] < 0) continue;
+      int64_t size = (tensor_types[i]->dtype.bits() * tensor_types[i]->dtype.lanes() + 7) / 8;
+      for (int64_t dim : _ShapeToJSON(tensor_types[i]->shape)) {
+        size *= dim;
+      }
+      size_t sid = static_cast<size_t>(storage_ids[i]);
+      if (sid >= storage_sizes_.size()) storage_sizes_.resize(sid + 1, 0);
+      storage_sizes_[sid] = std::max(storage_sizes_[sid], size);
+    }
+  }
+
   std::vector<GraphNodeRef> VisitExpr_(const VarNode* op) override {
     Expr expr = GetRef<Expr>(op);
     return var_map_[expr.get()];
@@ -343,7 +469,8 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
   }
 
   std::vector<GraphNodeRef> GraphAddCallNode(const CallNode* op, const std::string& op_name,
-                                             const std::string& func_name) {
+                                             const std::string& func_name,
+                                             const GraphAttrs& op_attrs = GraphAttrs()) {
     std::vector<GraphNodeRef> inputs;
     for (auto arg : op->args) {
       auto res = VisitExpr(arg);
@@ -351,12 +478,11 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
         inputs.push_back(nr);
       }
     }
-    auto node = GraphOpNode::make_node_ptr(op_name, GraphAttrs(), func_name, inputs, GraphAttrs());
+    auto node = GraphOpNode::make_node_ptr(op_name, GraphAttrs(), func_name, inputs, op_attrs);
     return AddNode(node, GetRef<Expr>(op));
   }
 
   std::vector<GraphNodeRef> VisitExpr_(const CallNode* op) override {
-    Expr expr = GetRef<Expr>(op);
     Function func;
     if (op->op.as<OpNode>()) {
       LOG(FATAL) << "Operators should be transformed away; try applying"
@@ -375,17 +501,66 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
 
     auto pf0 = GetPackedFunc("relay.backend._make_CCacheKey");
     auto pf1 = GetPackedFunc("relay.backend._CompileEngineLower");
-    Target target;
     // Handle external function
     if (func->GetAttr<String>(attr::kCompiler).defined()) {
-      target = Target("ext_dev");
-      CCacheKey key = (*pf0)(func, target);
+      CCacheKey key = (*pf0)(func, Target("ext_dev"));
       CachedFunc ext_func = (*pf1)(compile_engine_, key);
       ICHECK(ext_func.defined()) << "External function is not defined.";
       UpdateConstants(func, &params_);
       return GraphAddCallNode(op, ext_func->func_name, ext_func->func_name);
     }
 
+    Array<tir::Buffer> buffers;
+    CCacheKey key = GetCCacheKey(op, func, &buffers);
+    const Target& target = key->target;
+    CachedFunc lowered_func = (*pf1)(compile_engine_, key, buffers);
+    if (!lowered_funcs_.count(target->str())) {
+      lowered_funcs_[target->str()] = IRModule(Map<GlobalVar, BaseFunc>({}));
+    }
+    lowered_funcs_[target->str()]->Update(lowered_func->funcs);
+    return GraphAddCallNode(op, _GetUniqueName(lowered_func->func_name), lowered_func->func_name,
+                            GetCostAttrs(lowered_func));
+  }
+
+  /*!
+   * \brief Get the static cost estimates of a lowered function, which the debug runtime uses to
+   *  report the achieved FLOP/s and bandwidth of every node.
+   * \param lowered_func The lowered function.
+   * \return The "flop_ct" and "bytes" attributes, bytes counts every input and output once.
+   *  Estimates which are not known statically are left out.
+   */
+  GraphAttrs GetCostAttrs(const CachedFunc& lowered_func) {
+    GraphAttrs attrs;
+    double flop_ct = auto_scheduler::EstimateFlop(lowered_func->outputs);
+    if (flop_ct >= 0) {
+      attrs["flop_ct"] = std::to_string(static_cast<int64_t>(flop_ct));
+    }
+    int64_t bytes = 0;
+    for (const auto& tensors : {lowered_func->inputs, lowered_func->outputs}) {
+      for (const te::Tensor& tensor : tensors) {
+        int64_t size = (tensor->dtype.bits() * tensor->dtype.lanes() + 7) / 8;
+        for (const PrimExpr& dim : tensor->shape) {
+          const auto* extent = dim.as<IntImmNode>();
+          if (extent == nullptr) return attrs;
+          size *= extent->value;
+        }
+        bytes += size;
+      }
+    }
+    attrs["bytes"] = std::to_string(bytes);
+    return attrs;
+  }
+
+  /*!
+   * \brief Get the cache key of a call to a primitive function, which is not external.
+   * \param op The call.
+   * \param func The called primitive function.
+   * \param buffers The buffers to bind the inputs and outputs of the function to.
+   * \return The cache key.
+   */
+  CCacheKey GetCCacheKey(const CallNode* op, const Function& func, Array<tir::Buffer>* buffers) {
+    Expr expr = GetRef<Expr>(op);
+    Target target;
     ICHECK_GE(storage_device_map_.count(expr), 0);
     auto& device_type = storage_device_map_[expr][1];
     auto call_dev_type = Downcast<IntegerArray>(device_type)[0]->value;
@@ -408,22 +583,56 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
       target = targets_[call_dev_type];
     }
 
-    Array<tir::Buffer> buffers;
     std::string ftarget_prefix = "relay.backend." + target->kind->name;
     if (Optional<String> t_device = target->GetAttr<String>("device")) {
       ftarget_prefix += ("." + t_device.value());
     }
     if (const auto* f = runtime::Registry::Get(ftarget_prefix + "._CollectBufferBinds")) {
-      buffers = (*f)(GetRef<Call>(op), storage_device_map_);
+      *buffers = (*f)(GetRef<Call>(op), storage_device_map_);
     }
+    auto pf0 = GetPackedFunc("relay.backend._make_CCacheKey");
+    return (*pf0)(func, target, *buffers);
+  }
 
-    CCacheKey key = (*pf0)(func, target, buffers);
-    CachedFunc lowered_func = (*pf1)(compile_engine_, key, buffers);
-    if (!lowered_funcs_.count(target->str())) {
-      lowered_funcs_[target->str()] = IRModule(Map<GlobalVar, BaseFunc>({}));
-    }
-    lowered_funcs_[target->str()]->Update(lowered_func->funcs);
-    return GraphAddCallNode(op, _GetUniqueName(lowered_func->func_name), lowered_func->func_name);
+  /*!
+   * \brief Lower all the primitive functions called in a graph over several threads before
+   *  visiting it. The calls are collected in the order the visitor lowers them, so that the
+   *  functions get the same names as when they are lowered one by one.
+   * \param func The graph.
+   * \param num_threads The number of threads, non-positive to use all the cores.
+   */
+  void PrelowerPrimitiveFunctions(const Function& func, int num_threads) {
+    Array<CCacheKey> keys;
+    Array<Array<tir::Buffer>> buffers;
+    std::function<void(const Expr&)> collect;
+    std::unordered_set<const Object*> visited;
+    // The calls are lowered before their arguments, and bindings before the let body.
+    collect = [&](const Expr& expr) {
+      if (!visited.insert(expr.get()).second) return;
+      if (const auto* call = expr.as<CallNode>()) {
+        const auto* callee = call->op.as<FunctionNode>();
+        if (callee && callee->HasNonzeroAttr(attr::kPrimitive) &&
+            !callee->GetAttr<String>(attr::kCompiler).defined()) {
+          Array<tir::Buffer> call_buffers;
+          keys.push_back(GetCCacheKey(call, GetRef<Function>(callee), &call_buffers));
+          buffers.push_back(call_buffers);
+        }
+        for (const Expr& arg : call->args) collect(arg);
+      } else if (const auto* let = expr.as<LetNode>()) {
+        collect(let->value);
+        collect(let->body);
+      } else if (const auto* tuple = expr.as<TupleNode>()) {
+        for (const Expr& field : tuple->fields) collect(field);
+      } else if (const auto* get_item = expr.as<TupleGetItemNode>()) {
+        collect(get_item->tuple);
+      } else if (const auto* if_node = expr.as<IfNode>()) {
+        collect(if_node->cond);
+        collect(if_node->true_branch);
+        collect(if_node->false_branch);
+      }
+    };
+    collect(func->body);
+    compile_engine_->LowerParallel(keys, buffers, num_threads);
   }
 
   std::vector<GraphNodeRef> VisitExpr_(const LetNode* op) override {
@@ -491,6 +700,8 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
     std::vector<std::string> storage_scopes;
     std::vector<size_t> device_types;
     std::vector<std::string> dltypes;
+    std::vector<int64_t> row_offsets;
+    bool has_row_offsets = false;
     std::vector<size_t> node_row_ptr{0};
     for (auto node : nodes_) {
       const auto& shape_vec = dmlc::get<ShapeVector>(node->attrs_["shape"]);
@@ -509,6 +720,13 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
         const auto& dev_types = dmlc::get<std::vector<int64_t>>(node->attrs_["device_index"]);
         device_types.insert(device_types.end(), dev_types.begin(), dev_types.end());
       }
+      if (node->attrs_.count("texture_row_offset")) {
+        const auto& rows = dmlc::get<std::vector<int64_t>>(node->attrs_["texture_row_offset"]);
+        row_offsets.insert(row_offsets.end(), rows.begin(), rows.end());
+        has_row_offsets |= std::any_of(rows.begin(), rows.end(), [](int64_t r) { return r >= 0; });
+      } else {
+        row_offsets.insert(row_offsets.end(), node->num_outputs_, -1);
+      }
       node_row_ptr.push_back(num_entry);
     }
     writer->BeginObject();
@@ -528,6 +746,27 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
     }
     attrs["dltype"].emplace_back(std::string("list_str"));
     attrs["dltype"].emplace_back(dltypes);
+    if (has_row_offsets) {
+      attrs["texture_row_offset"].emplace_back(std::string("list_int"));
+      attrs["texture_row_offset"].emplace_back(row_offsets);
+    }
+    // float32 textures store half float texels, the kernels still compute in float32 as the
+    // image reads and writes convert the texels
+    String texture_storage = transform::PassContext::Current()->GetConfig<String>(
+        "relay.backend.texture_storage_dtype", String("")).value();
+    if (texture_storage == "float16") {
+      std::vector<std::string> storage_dltypes = dltypes;
+      for (size_t i = 0; i < storage_dltypes.size(); ++i) {
+        if (runtime::IsTextureStorage(storage_scopes[i]) && dltypes[i] == "float32") {
+          storage_dltypes[i] = "float16";
+        }
+      }
+      attrs["storage_dltype"].emplace_back(std::string("list_str"));
+      attrs["storage_dltype"].emplace_back(storage_dltypes);
+    } else {
+      ICHECK(texture_storage.empty() || texture_storage == "float32")
+          << "Unsupported texture storage dtype " << texture_storage;
+    }
     writer->WriteObjectKeyValue("attrs", attrs);
     writer->WriteObjectKeyValue("node_row_ptr", node_row_ptr);
     writer->EndObject();
@@ -568,6 +807,8 @@ class GraphRuntimeCodegen : public backend::MemoizedExprTranslator<std::vector<G
    */
   std::unordered_map<std::string, runtime::NDArray> params_;
   std::unordered_map<std::string, int64_t> param_storage_ids_;
+  /*! \brief The size in bytes of every storage id. */
+  std::vector<int64_t> storage_sizes_;
   /*! \brief plan memory of device result */
   Map<Expr, runtime::ADT> storage_device_map_;
   /*! \brief lowered funcs */
@@ -621,6 +862,18 @@ class GraphRuntimeCodegenModule : public runtime::ModuleNode {
         CHECK(it != this->output_.params.end()) << "no such parameter " << key;
         *rv = (*it).second.first;
       });
+    } else if (name == "get_aot_plan") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->codegen_->GetAOTPlan();
+      });
+    } else if (name == "get_storage_sizes") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        Array<Integer> ret;
+        for (int64_t size : this->output_.storage_sizes) {
+          ret.push_back(IntImm(DataType::Int(64), size));
+        }
+        *rv = ret;
+      });
     } else if (name == "get_irmodule") {
       return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         *rv = this->output_.lowered_funcs;
@@ -649,6 +902,8 @@ runtime::Module CreateGraphCodegenMod() {
 TVM_REGISTER_GLOBAL("relay.build_module._GraphRuntimeCodegen")
     .set_body([](TVMArgs args, TVMRetValue* rv) { *rv = CreateGraphCodegenMod(); });
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.texture_storage_dtype", String);
+
 }  // namespace backend
 }  // namespace relay
 }  // namespace tvm
@@ -38,14 +38,14 @@ namespace relay {
 
 using namespace runtime;
 
-TVM_REGISTER_GLOBAL("tvm.relay._save_param_dict")
-    .set_body_typed([](const Map<String, NDArray>& params) {
-      std::string s = ::tvm::runtime::SaveParams(params);
-      // copy return array so it is owned by the ret value
-      TVMRetValue rv;
-      rv = TVMByteArray{s.data(), s.size()};
-      return rv;
-    });
+TVM_REGISTER_GLOBAL("tvm.relay._save_param_dict").set_body([](TVMArgs args, TVMRetValue* rv) {
+  Map<String, NDArray> params = args[0];
+  // The data of the arrays can be aligned, e.g. to pages, for the files to be mapped
+  size_t alignment = args.size() > 1 ? static_cast<size_t>(args[1].operator int64_t()) : 0;
+  std::string s = ::tvm::runtime::SaveParams(params, alignment);
+  // copy return array so it is owned by the ret value
+  *rv = TVMByteArray{s.data(), s.size()};
+});
 TVM_REGISTER_GLOBAL("tvm.relay._load_param_dict").set_body_typed([](const String& s) {
   return ::tvm::runtime::LoadParams(s);
 });
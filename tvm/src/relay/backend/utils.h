@@ -303,6 +303,26 @@ inline bool IsAutoSchedulerEnabled() {
       .value();
 }
 
+/*!
+ * \brief Return the number of threads lowering the primitive functions of a graph in the pass
+ *  context. 1 lowers them one by one, non-positive uses all the cores.
+ */
+inline int GetLoweringThreads() {
+  return transform::PassContext::Current()
+      ->GetConfig<Integer>("relay.backend.lowering_threads", Integer(1))
+      .value()
+      ->value;
+}
+
+/*!
+ * \brief Return the directory of the persistent compile cache in a pass context.
+ * \param pass_ctx The pass context the functions are lowered under.
+ * \return The directory, empty when the persistent cache is disabled.
+ */
+inline std::string GetCompileCacheDir(const transform::PassContext& pass_ctx) {
+  return pass_ctx->GetConfig<String>("relay.backend.compile_cache_dir", String("")).value();
+}
+
 /*!
  * \brief Return whether the compile engine cache is disabled in the pass context.
  */
@@ -312,6 +332,17 @@ inline bool IsCompileEngineCacheDisabled() {
       .value();
 }
 
+/*!
+ * \brief Collect the target specific tensor storage scopes of each expression's outputs.
+ * \param expr The expression.
+ * \param dev_map The device type of each expression.
+ * \param target_map The target of each device type.
+ * \return The storage scopes of each expression's outputs, from the
+ *  relay.backend.<target>._CollectStorageInfo hook when the target registers one.
+ */
+Map<Expr, Array<String>> CollectStorageInfo(const Expr& expr, const Map<Expr, Integer>& dev_map,
+                                            const Map<Integer, Target>& target_map);
+
 }  // namespace backend
 }  // namespace relay
 }  // namespace tvm
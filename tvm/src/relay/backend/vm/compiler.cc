@@ -37,6 +37,7 @@
 #include <tvm/support/logging.h>
 #include <tvm/te/operation.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -57,6 +58,7 @@ namespace transform {
 
 Pass LambdaLift();
 Pass InlinePrimitives();
+Pass StaticMemoryPlan();
 
 Pass MemoryPlan() {
   auto f = tvm::runtime::Registry::Get("relay.transform.MemoryPlan");
@@ -382,6 +384,7 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
     while ((let = let_binding.as<LetNode>())) {
       VisitExpr(let->value);
       var_register_map_.insert({let->var, this->last_register_});
+      RecordStorageScope(let->var, let->value);
       let_binding = let->body;
     }
 
@@ -463,6 +466,7 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
       op_index = context_->cached_funcs.size();
       context_->cached_funcs.push_back(cfunc);
       context_->seen_funcs[pfunc] = op_index;
+      context_->shape_funcs.push_back(op_index);
     } else {
       op_index = context_->seen_funcs[pfunc];
     }
@@ -535,8 +539,10 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
       }
     }
 
-    CCacheKey key(func, target);
-    auto cfunc = engine_->Lower(key);
+    Array<tir::Buffer> buffers =
+        CollectBufferBinds(func, target, input_tuple->fields, output_tuple->fields);
+    CCacheKey key(func, target, buffers);
+    auto cfunc = engine_->Lower(key, buffers);
 
     auto op_index = -1;
     if (func->GetAttr<String>(attr::kCompiler).defined()) {
@@ -641,8 +647,9 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
                      device_type = expr_device_map_[GetRef<Call>(call_node)].device_type;
                    }
 
+                   Index memory_scope = GetMemoryScopeIndex(alloc_attrs->scope);
                    Emit(Instruction::AllocStorage(size_register, alignment, dtype, device_type,
-                                                  NewRegister()));
+                                                  memory_scope, NewRegister()));
                  })
           .Match("vm.shape_func",
                  [this](const Array<Expr>& args, const Attrs& attrs, const Array<Type>& type_arg) {
@@ -826,6 +833,99 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
     CompileTreeNode(decision_tree);
   }
 
+  /*! \brief Get the index of a memory scope in the executable, adding it if it is new. */
+  Index GetMemoryScopeIndex(const std::string& scope) {
+    auto& scopes = context_->memory_scopes;
+    auto it = std::find(scopes.begin(), scopes.end(), scope);
+    if (it != scopes.end()) return it - scopes.begin();
+    scopes.push_back(scope);
+    return scopes.size() - 1;
+  }
+
+  /*! \brief The storage scope of the tensor or storage held by a variable. */
+  std::string GetStorageScope(const Expr& expr) const {
+    const auto* var = expr.as<VarNode>();
+    if (var == nullptr) return "global";
+    auto it = var_scope_.find(GetRef<Var>(var));
+    return it == var_scope_.end() ? "global" : it->second;
+  }
+
+  /*!
+   * \brief Track the storage scope through alloc_storage, alloc_tensor and variable
+   * rebinding, so the primitive functions they are passed to can bind matching buffers.
+   */
+  void RecordStorageScope(const Var& var, const Expr& value) {
+    static const Op& alloc_storage_op = Op::Get("memory.alloc_storage");
+    static const Op& alloc_tensor_op = Op::Get("memory.alloc_tensor");
+    std::string scope = "global";
+    if (const auto* call = value.as<CallNode>()) {
+      if (call->op == alloc_storage_op) {
+        scope = call->attrs.as<AllocStorageAttrs>()->scope;
+      } else if (call->op == alloc_tensor_op && call->args[0].as<VarNode>()) {
+        scope = GetStorageScope(call->args[0]);
+      }
+    } else if (value.as<VarNode>()) {
+      scope = GetStorageScope(value);
+    }
+    if (scope != "global") {
+      var_scope_[var] = scope;
+    }
+  }
+
+  /*!
+   * \brief Collect the buffers a primitive function has to be lowered with when any of
+   * its arguments lives in a non-global storage scope, using the same target hook as the
+   * graph runtime codegen. Returns no buffers when all arguments are global.
+   */
+  Array<tir::Buffer> CollectBufferBinds(const Function& func, const Target& target,
+                                        const Array<Expr>& inputs, const Array<Expr>& outputs) {
+    auto is_scoped = [this](const Expr& expr) { return GetStorageScope(expr) != "global"; };
+    if (!std::any_of(inputs.begin(), inputs.end(), is_scoped) &&
+        !std::any_of(outputs.begin(), outputs.end(), is_scoped)) {
+      return {};
+    }
+
+    std::string ftarget_prefix = "relay.backend." + target->kind->name;
+    if (Optional<String> t_device = target->GetAttr<String>("device")) {
+      ftarget_prefix += ("." + t_device.value());
+    }
+    const auto* fbinds = runtime::Registry::Get(ftarget_prefix + "._CollectBufferBinds");
+    ICHECK(fbinds) << "Storage scopes are not supported by target " << target->str();
+
+    // Regroup the flattened inputs by parameter and give each its storage scope.
+    Map<Expr, runtime::ADT> storage_map;
+    auto add_storage_info = [&storage_map](const Expr& expr, const Array<String>& scopes) {
+      storage_map.Set(expr, runtime::ADT::Tuple({Array<Integer>{}, Array<Integer>{}, scopes}));
+    };
+    Array<Expr> args;
+    size_t field = 0;
+    for (const auto& param : func->params) {
+      if (const auto* tuple_type = param->checked_type().as<TupleTypeNode>()) {
+        size_t num_fields = tuple_type->fields.size();
+        ICHECK_LE(field + num_fields, inputs.size());
+        Array<Expr> fields(inputs.begin() + field, inputs.begin() + field + num_fields);
+        field += num_fields;
+        args.push_back(Tuple(fields));
+        add_storage_info(args.back(), {});
+      } else {
+        ICHECK_LT(field, inputs.size());
+        args.push_back(inputs[field++]);
+        add_storage_info(args.back(), {GetStorageScope(args.back())});
+      }
+    }
+    ICHECK_EQ(field, inputs.size()) << "internal error: invoke_tvm_op inputs do not match "
+                                    << "the parameters of the primitive function";
+
+    Call call(func, args);
+    call->checked_type_ = Downcast<FuncType>(func->checked_type())->ret_type;
+    Array<String> out_scopes;
+    for (const auto& output : outputs) {
+      out_scopes.push_back(GetStorageScope(output));
+    }
+    add_storage_info(call, out_scopes);
+    return (*fbinds)(call, storage_map);
+  }
+
  protected:
   /*! \brief Store the expression a variable points to. */
   std::unordered_map<Var, Expr, ObjectPtrHash, ObjectPtrEqual> expr_map_;
@@ -835,6 +935,8 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
   std::vector<std::string> params_;
   /*! \brief Map from var to register number. */
   std::unordered_map<Var, RegName, ObjectPtrHash, ObjectPtrEqual> var_register_map_;
+  /*! \brief Map from var to its storage scope, for vars not in the global scope. */
+  std::unordered_map<Var, std::string, ObjectPtrHash, ObjectPtrEqual> var_scope_;
   /*! \brief Last used register number. */
   size_t last_register_;
   /*! \brief Total number of virtual registers allocated. */
@@ -946,6 +1048,9 @@ void VMCompiler::Lower(IRModule mod, const TargetsMap& targets, const tvm::Targe
     exec_->const_device_type.push_back(i);
   }
 
+  exec_->memory_scopes = context_.memory_scopes;
+  exec_->shape_funcs = context_.shape_funcs;
+
   // update global function map
   for (auto gv : context_.global_map) {
     exec_->global_map.insert({gv.first->name_hint, gv.second});
@@ -975,11 +1080,9 @@ transform::Sequential MemoryOpt(tvm::Target host_target, TargetsMap targets) {
   // Fuse the shape functions.
   pass_seqs.push_back(transform::FuseOps());
 
-  // TODO(mbrookhart, jroesch, masahi): this pass is very slow, and is
-  // incomplete to provide memory resuse optimizations. Disable it until we can
-  // rewrite it in C++ and complete it.
-  // // Perform memory planning in order to coalesce/reduce allocations.
-  // pass_seqs.push_back(transform::MemoryPlan());
+  // Coalesce the statically sized allocations of each block into an arena, when
+  // relay.vm.static_memory_plan is set.
+  pass_seqs.push_back(transform::StaticMemoryPlan());
 
   // Compute away constant computation introduced by coalescing allocations.
   pass_seqs.push_back(transform::FoldConstant());
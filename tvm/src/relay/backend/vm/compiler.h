@@ -79,8 +79,12 @@ struct VMCompilerContext {
   std::vector<NDArray> constants;
   // Device type for constants
   std::vector<Index> const_device_type;
+  // Memory scopes referenced by storage allocations
+  std::vector<std::string> memory_scopes;
   // List of cached functions
   std::vector<CachedFunc> cached_funcs;
+  // Indices of the cached functions that are shape functions
+  std::vector<Index> shape_funcs;
   // The functions that have been lowered.
   std::unordered_map<tir::PrimFunc, size_t, ObjectPtrHash, ObjectPtrEqual> seen_funcs;
 };
@@ -0,0 +1,364 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relay/backend/vm/static_memory_plan.cc
+ * \brief Coalesce the statically sized storage of a function into one arena.
+ *
+ *  After ManifestAlloc every tensor gets its own memory.alloc_storage. Within a
+ *  block of let bindings, the storage with a constant size which only backs
+ *  tensors passed to kernels is given a liveness interval. The intervals are fed
+ *  to the token allocator of the graph memory planner, and the resulting tokens
+ *  are laid out in one arena per device which the tensors are allocated from at
+ *  constant offsets.
+ */
+
+#include <tvm/relay/attrs/memory.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/transform.h>
+#include <tvm/support/logging.h>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../op/memory/memory.h"
+#include "../../transforms/pattern_utils.h"
+#include "../token_allocator.h"
+
+namespace tvm {
+namespace relay {
+namespace vm {
+
+/*! \brief The constant value of an int64 scalar, if expr is one. */
+static bool GetConstantInt(const Expr& expr, int64_t* value) {
+  const auto* constant = expr.as<ConstantNode>();
+  if (constant == nullptr || constant->data->ndim != 0) return false;
+  DLDataType dtype = constant->data->dtype;
+  if (dtype.code != kDLInt || dtype.bits != 64 || dtype.lanes != 1) return false;
+  *value = reinterpret_cast<const int64_t*>(constant->data->data)[0];
+  return true;
+}
+
+/*! \brief Tensors can only be placed at an offset in memory addressed by pointers. */
+static bool SupportsOffset(int device_type) {
+  return device_type == kDLCPU || device_type == kDLGPU || device_type == kDLCPUPinned ||
+         device_type == kDLROCM;
+}
+
+class StaticMemoryPlanner : public ExprMutator {
+ public:
+  Expr VisitExpr_(const FunctionNode* fn) final {
+    if (fn->HasNonzeroAttr(attr::kPrimitive)) return GetRef<Expr>(fn);
+    return ExprMutator::VisitExpr_(fn);
+  }
+
+  Expr VisitExpr_(const LetNode* ln) final {
+    // Plan the inner blocks first, then the bindings of this one.
+    std::vector<std::pair<Var, Expr>> bindings;
+    Expr body = GetRef<Expr>(ln);
+    while (const auto* let = body.as<LetNode>()) {
+      bindings.emplace_back(let->var, this->VisitExpr(let->value));
+      body = let->body;
+    }
+    body = this->VisitExpr(body);
+    bindings = Plan(bindings, body);
+    for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+      body = Let(it->first, it->second, body);
+    }
+    return body;
+  }
+
+ private:
+  /*! \brief A storage allocation which may move into an arena. */
+  struct Allocation {
+    size_t def{0};
+    size_t last_use{0};
+    int64_t size{0};
+    int64_t alignment{0};
+    const AllocStorageAttrs* attrs{nullptr};
+    bool escapes{false};
+    int64_t offset{0};
+  };
+
+  /*! \brief Mark the storage behind every variable used in expr as escaping. */
+  class EscapeMarker : public ExprVisitor {
+   public:
+    explicit EscapeMarker(StaticMemoryPlanner* planner) : planner_(planner) {}
+    void VisitExpr_(const VarNode* vn) final {
+      for (const VarNode* storage : planner_->StoragesOf(vn)) {
+        planner_->allocs_[storage].escapes = true;
+      }
+    }
+    void VisitExpr_(const FunctionNode* fn) final {
+      if (!fn->HasNonzeroAttr(attr::kPrimitive)) ExprVisitor::VisitExpr_(fn);
+    }
+
+   private:
+    StaticMemoryPlanner* planner_;
+  };
+
+  std::vector<const VarNode*> StoragesOf(const VarNode* var) const {
+    auto it = storages_.find(var);
+    return it == storages_.end() ? std::vector<const VarNode*>{} : it->second;
+  }
+
+  void Use(const Expr& expr, size_t index) {
+    const auto* var = expr.as<VarNode>();
+    if (var == nullptr) {
+      EscapeMarker(this).VisitExpr(expr);
+      return;
+    }
+    for (const VarNode* storage : StoragesOf(var)) {
+      auto& alloc = allocs_[storage];
+      alloc.last_use = std::max(alloc.last_use, index);
+    }
+  }
+
+  void UseFields(const Expr& tuple, size_t index) {
+    if (const auto* tn = tuple.as<TupleNode>()) {
+      for (const auto& field : tn->fields) Use(field, index);
+    } else {
+      EscapeMarker(this).VisitExpr(tuple);
+    }
+  }
+
+  /*! \brief Find the allocations of a block and how long the memory behind them is used. */
+  void Analyze(const std::vector<std::pair<Var, Expr>>& bindings, const Expr& body) {
+    static const Op& alloc_storage_op = Op::Get("memory.alloc_storage");
+    static const Op& alloc_tensor_op = Op::Get("memory.alloc_tensor");
+    static const Op& invoke_tvm_op = Op::Get("vm.invoke_tvm_op");
+    static const Op& shape_func_op = Op::Get("vm.shape_func");
+    static const Op& shape_of_op = Op::Get("vm.shape_of");
+    static const Op& reshape_tensor_op = Op::Get("vm.reshape_tensor");
+    static const Op& device_copy_op = Op::Get("device_copy");
+
+    for (size_t i = 0; i < bindings.size(); ++i) {
+      const VarNode* var = bindings[i].first.get();
+      const Expr& value = bindings[i].second;
+      const auto* call = value.as<CallNode>();
+      if (call != nullptr && call->op == alloc_storage_op) {
+        Allocation alloc;
+        alloc.def = alloc.last_use = i;
+        alloc.attrs = call->attrs.as<AllocStorageAttrs>();
+        alloc.escapes = !GetConstantInt(call->args[0], &alloc.size) ||
+                        !GetConstantInt(call->args[1], &alloc.alignment) ||
+                        alloc.attrs->scope != "global" ||
+                        !SupportsOffset(alloc.attrs->device_type);
+        allocs_[var] = alloc;
+        storages_[var] = {var};
+        EscapeMarker(this).VisitExpr(call->args[0]);
+      } else if (call != nullptr && call->op == alloc_tensor_op) {
+        // The storage itself may only be used here, at a constant offset
+        int64_t offset;
+        const auto* storage = call->args[0].as<VarNode>();
+        if (storage == nullptr || !allocs_.count(storage) ||
+            !GetConstantInt(call->args[1], &offset)) {
+          EscapeMarker(this).VisitExpr(call->args[0]);
+        } else {
+          Use(call->args[0], i);
+          storages_[var] = {storage};
+        }
+        EscapeMarker(this).VisitExpr(call->args[2]);
+      } else if (call != nullptr && (call->op == invoke_tvm_op || call->op == shape_func_op)) {
+        UseFields(call->args[1], i);
+        UseFields(call->args[2], i);
+        // The result gives access to the outputs
+        if (const auto* outputs = call->args[2].as<TupleNode>()) {
+          for (const auto& output : outputs->fields) {
+            if (const auto* out = output.as<VarNode>()) {
+              auto storages = StoragesOf(out);
+              storages_[var].insert(storages_[var].end(), storages.begin(), storages.end());
+            }
+          }
+        }
+      } else if (call != nullptr && (call->op == shape_of_op || call->op == device_copy_op)) {
+        Use(call->args[0], i);
+      } else if (call != nullptr && call->op == reshape_tensor_op) {
+        // The reshaped tensor aliases the memory of its input
+        Use(call->args[0], i);
+        if (const auto* input = call->args[0].as<VarNode>()) storages_[var] = StoragesOf(input);
+        EscapeMarker(this).VisitExpr(call->args[1]);
+      } else if (const auto* alias = value.as<VarNode>()) {
+        Use(value, i);
+        storages_[var] = StoragesOf(alias);
+      } else {
+        EscapeMarker(this).VisitExpr(value);
+      }
+    }
+    // Whatever the block evaluates to outlives it
+    EscapeMarker(this).VisitExpr(body);
+  }
+
+  std::vector<std::pair<Var, Expr>> Plan(const std::vector<std::pair<Var, Expr>>& bindings,
+                                         const Expr& body) {
+    allocs_.clear();
+    storages_.clear();
+    Analyze(bindings, body);
+
+    // The allocations of each device in the order they are defined
+    std::map<std::pair<int, int>, std::vector<const VarNode*>> groups;
+    for (size_t i = 0; i < bindings.size(); ++i) {
+      auto it = allocs_.find(bindings[i].first.get());
+      if (it != allocs_.end() && !it->second.escapes) {
+        const auto* attrs = it->second.attrs;
+        groups[{attrs->device_type, attrs->device_id}].push_back(it->first);
+      }
+    }
+
+    std::unordered_map<size_t, std::pair<Var, Expr>> replaced;
+    std::unordered_set<size_t> removed;
+    std::unordered_map<const VarNode*, Var> arena_of;
+    for (const auto& kv : groups) {
+      const auto& members = kv.second;
+      if (members.size() < 2) continue;
+      Var arena = AssignOffsets(members, &replaced);
+      for (const VarNode* member : members) {
+        arena_of[member] = arena;
+        if (allocs_[member].def != allocs_[members[0]].def) removed.insert(allocs_[member].def);
+      }
+    }
+    if (arena_of.empty()) return bindings;
+
+    static const Op& alloc_tensor_op = Op::Get("memory.alloc_tensor");
+    std::vector<std::pair<Var, Expr>> planned;
+    for (size_t i = 0; i < bindings.size(); ++i) {
+      if (removed.count(i)) continue;
+      auto it = replaced.find(i);
+      if (it != replaced.end()) {
+        planned.push_back(it->second);
+        continue;
+      }
+      const auto* call = bindings[i].second.as<CallNode>();
+      if (call != nullptr && call->op == alloc_tensor_op) {
+        const auto* storage = call->args[0].as<VarNode>();
+        auto ait = storage ? arena_of.find(storage) : arena_of.end();
+        if (ait != arena_of.end()) {
+          int64_t offset;
+          ICHECK(GetConstantInt(call->args[1], &offset));
+          offset += allocs_[storage].offset;
+          Expr value = Call(call->op,
+                            {ait->second, MakeConstantScalar(DataType::Int(64), offset),
+                             call->args[2]},
+                            call->attrs, call->type_args);
+          planned.emplace_back(bindings[i].first, value);
+          continue;
+        }
+      }
+      planned.push_back(bindings[i]);
+    }
+    return planned;
+  }
+
+  /*!
+   * \brief Reuse storage between allocations whose lifetimes do not overlap, lay the
+   *  storage out in an arena and bind the arena in place of the first allocation.
+   */
+  Var AssignOffsets(const std::vector<const VarNode*>& members,
+                    std::unordered_map<size_t, std::pair<Var, Expr>>* replaced) {
+    std::vector<StorageToken> prototypes(members.size());
+    std::vector<StorageToken*> tokens;
+    std::unordered_map<StorageToken*, int64_t> token_alignment;
+    std::unordered_map<const VarNode*, StorageToken*> token_of;
+    TokenAllocator1D allocator;
+    // Members are in definition order, so walking them releases storage in time
+    std::multimap<size_t, StorageToken*> live;
+    for (size_t i = 0; i < members.size(); ++i) {
+      const Allocation& alloc = allocs_[members[i]];
+      while (!live.empty() && live.begin()->first < alloc.def) {
+        StorageToken* tok = live.begin()->second;
+        live.erase(live.begin());
+        tok->ref_counter -= 1;
+        allocator.CheckForRelease(tok);
+      }
+      StorageToken* prototype = &prototypes[i];
+      prototype->ref_counter = 1;
+      prototype->max_bytes = static_cast<size_t>(alloc.size);
+      prototype->device_type = alloc.attrs->device_type;
+      StorageToken* tok = allocator.Request(prototype);
+      if (tok == nullptr) {
+        tok = allocator.Alloc(prototype, static_cast<int64_t>(tokens.size()));
+        tokens.push_back(tok);
+      }
+      token_alignment[tok] = std::max(token_alignment[tok], alloc.alignment);
+      token_of[members[i]] = tok;
+      live.insert({alloc.last_use, tok});
+    }
+
+    int64_t total = 0;
+    int64_t alignment = 1;
+    std::unordered_map<StorageToken*, int64_t> token_offset;
+    for (StorageToken* tok : tokens) {
+      int64_t align = std::max<int64_t>(token_alignment[tok], 1);
+      total = (total + align - 1) / align * align;
+      token_offset[tok] = total;
+      total += static_cast<int64_t>(tok->max_bytes);
+      alignment = std::max(alignment, align);
+    }
+    DataType dtype = allocs_[members[0]].attrs->dtype;
+    for (const VarNode* member : members) {
+      allocs_[member].offset = token_offset[token_of[member]];
+      if (allocs_[member].attrs->dtype != dtype) dtype = DataType::UInt(8);
+    }
+    DLOG(INFO) << "Coalesce " << members.size() << " allocations into " << tokens.size()
+               << " blocks of a " << total << " B arena";
+
+    const auto* attrs = allocs_[members[0]].attrs;
+    TVMContext ctx;
+    ctx.device_type = static_cast<DLDeviceType>(attrs->device_type);
+    ctx.device_id = attrs->device_id;
+    Var arena("arena", Type(nullptr));
+    Expr value = AllocStorage(MakeConstantScalar(DataType::Int(64), total),
+                              MakeConstantScalar(DataType::Int(64), alignment), ctx, dtype);
+    (*replaced)[allocs_[members[0]].def] = {arena, value};
+    return arena;
+  }
+
+  /*! \brief The allocations of the block being planned. */
+  std::unordered_map<const VarNode*, Allocation> allocs_;
+  /*! \brief The storage each variable of the block gives access to. */
+  std::unordered_map<const VarNode*, std::vector<const VarNode*>> storages_;
+};
+
+}  // namespace vm
+
+namespace transform {
+
+// Whether the VM compiler coalesces the static allocations, off by default
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.vm.static_memory_plan", Bool);
+
+Pass StaticMemoryPlan() {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        if (!pc->GetConfig<Bool>("relay.vm.static_memory_plan", Bool(false)).value()) return f;
+        return Downcast<Function>(vm::StaticMemoryPlanner().Mutate(f));
+      };
+  return CreateFunctionPass(pass_func, 0, "StaticMemoryPlan", {});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.StaticMemoryPlan").set_body_typed(StaticMemoryPlan);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
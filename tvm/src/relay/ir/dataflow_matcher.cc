@@ -40,7 +40,13 @@ class DominatorMatcher;
 
 class DFPatternMatcher : public DFPatternFunctor<bool(const DFPattern&, const Expr&)> {
  public:
-  explicit DFPatternMatcher(const Expr& root_expr) : expr_graph_(CreateIndexedGraph(root_expr)) {}
+  /*!
+   * \param root_expr The expression the matches are in.
+   * \param types_inferred Whether the types of root_expr were just inferred, so that the checked
+   *  types of its nodes are up to date.
+   */
+  explicit DFPatternMatcher(const Expr& root_expr, bool types_inferred = false)
+      : expr_graph_(CreateIndexedGraph(root_expr)), types_inferred_(types_inferred) {}
   bool Match(const DFPattern& pattern, const Expr& expr);
   Map<DFPattern, Array<Expr>> GetMemo() { return Map<DFPattern, Array<Expr>>(memo_); }
   const IndexedGraph<Expr> expr_graph_;
@@ -67,10 +73,14 @@ class DFPatternMatcher : public DFPatternFunctor<bool(const DFPattern&, const Ex
   void ClearMap(size_t watermark);
   bool MatchesPath(const DominatorPatternNode* op, const Expr& expr);
   bool DominatesParent(const DominatorPatternNode* op, const Expr& expr);
+  Type GetType(const Expr& expr);
 
   std::unordered_map<DFPattern, Array<Expr>, ObjectPtrHash, ObjectPtrEqual> memo_;
+  /*! \brief The types inferred for the expressions, kept across the matches. */
+  std::unordered_map<Expr, Type, ObjectPtrHash, ObjectPtrEqual> type_memo_;
   std::vector<DFPattern> matched_nodes_;
   bool memoize_ = true;
+  bool types_inferred_ = false;
 };
 
 bool DFPatternMatcher::Match(const DFPattern& pattern, const Expr& expr) {
@@ -478,13 +488,27 @@ Expr InferTypeWithModule(const Expr& expr, const IRModule& m) {
   return ret;
 }
 
+Type DFPatternMatcher::GetType(const Expr& expr) {
+  // A checked type may be stale, e.g. kept by a copy-on-write of a call whose arguments changed,
+  // so it is only used when the caller inferred the types of the graph. Otherwise the type of a
+  // node is inferred once, inferring it copies the graph above it into a new module.
+  if (types_inferred_ && expr->checked_type_.defined()) {
+    return expr->checked_type_;
+  }
+  auto it = type_memo_.find(expr);
+  if (it == type_memo_.end()) {
+    it = type_memo_.emplace(expr, InferType(expr).as<ExprNode>()->checked_type()).first;
+  }
+  return it->second;
+}
+
 bool DFPatternMatcher::VisitDFPattern_(const TypePatternNode* op, const Expr& expr) {
-  auto expr_type = InferType(expr).as<ExprNode>()->checked_type();
+  auto expr_type = GetType(expr);
   return (StructuralEqual()(op->type, expr_type)) && VisitDFPattern(op->pattern, expr);
 }
 
 bool DFPatternMatcher::VisitDFPattern_(const ShapePatternNode* op, const Expr& expr) {
-  auto expr_type = InferType(expr).as<ExprNode>()->checked_type();
+  auto expr_type = GetType(expr);
   if (const TensorTypeNode* tensor_type = expr_type.as<TensorTypeNode>()) {
     return (StructuralEqual()(op->shape, tensor_type->shape)) && VisitDFPattern(op->pattern, expr);
   }
@@ -492,7 +516,7 @@ bool DFPatternMatcher::VisitDFPattern_(const ShapePatternNode* op, const Expr& e
 }
 
 bool DFPatternMatcher::VisitDFPattern_(const DataTypePatternNode* op, const Expr& expr) {
-  auto expr_type = InferType(expr).as<ExprNode>()->checked_type();
+  auto expr_type = GetType(expr);
   if (const TensorTypeNode* tensor_type = expr_type.as<TensorTypeNode>()) {
     return (StructuralEqual()(op->dtype, tensor_type->dtype)) && VisitDFPattern(op->pattern, expr);
   }
@@ -524,6 +548,100 @@ bool MatchPattern(DFPattern pattern, Expr expr) {
 
 TVM_REGISTER_GLOBAL("relay.dataflow_pattern.match").set_body_typed(MatchPattern);
 
+ExprNodeIndex::ExprNodeIndex(const Expr& expr) {
+  PostOrderVisit(expr, [this](const Expr& node) {
+    if (const auto* call = node.as<CallNode>()) {
+      if (call->op.as<OpNode>()) {
+        call_ops.insert(call->op.get());
+      } else {
+        has_other_calls = true;
+      }
+    } else {
+      node_types.insert(node->type_index());
+    }
+  });
+}
+
+PatternRootFilter::PatternRootFilter(const DFPattern& pattern) { Collect(pattern); }
+
+void PatternRootFilter::Collect(const DFPattern& pattern) {
+  if (const auto* op = pattern.as<AltPatternNode>()) {
+    Collect(op->left);
+    Collect(op->right);
+  } else if (const auto* op = pattern.as<AttrPatternNode>()) {
+    Collect(op->pattern);
+  } else if (const auto* op = pattern.as<TypePatternNode>()) {
+    Collect(op->pattern);
+  } else if (const auto* op = pattern.as<ShapePatternNode>()) {
+    Collect(op->pattern);
+  } else if (const auto* op = pattern.as<DataTypePatternNode>()) {
+    Collect(op->pattern);
+  } else if (const auto* op = pattern.as<DominatorPatternNode>()) {
+    Collect(op->child);
+  } else if (const auto* op = pattern.as<CallPatternNode>()) {
+    if (!CollectOps(op->op)) any_call_ = true;
+  } else if (const auto* op = pattern.as<ExprPatternNode>()) {
+    if (op->expr.as<CallNode>()) {
+      any_call_ = true;
+    } else {
+      node_types_.insert(op->expr->type_index());
+    }
+  } else if (pattern.as<VarPatternNode>()) {
+    node_types_.insert(VarNode::RuntimeTypeIndex());
+  } else if (pattern.as<ConstantPatternNode>()) {
+    node_types_.insert(ConstantNode::RuntimeTypeIndex());
+  } else if (pattern.as<FunctionPatternNode>()) {
+    node_types_.insert(FunctionNode::RuntimeTypeIndex());
+  } else if (pattern.as<TuplePatternNode>()) {
+    node_types_.insert(TupleNode::RuntimeTypeIndex());
+  } else if (pattern.as<TupleGetItemPatternNode>()) {
+    node_types_.insert(TupleGetItemNode::RuntimeTypeIndex());
+  } else if (pattern.as<IfPatternNode>()) {
+    node_types_.insert(IfNode::RuntimeTypeIndex());
+  } else if (pattern.as<LetPatternNode>()) {
+    node_types_.insert(LetNode::RuntimeTypeIndex());
+  } else {
+    any_ = true;
+  }
+}
+
+bool PatternRootFilter::CollectOps(const DFPattern& op) {
+  if (const auto* alt = op.as<AltPatternNode>()) {
+    return CollectOps(alt->left) && CollectOps(alt->right);
+  }
+  const auto* expr_pattern = op.as<ExprPatternNode>();
+  const auto* op_node = expr_pattern != nullptr ? expr_pattern->expr.as<OpNode>() : nullptr;
+  if (op_node == nullptr) return false;
+  ops_.insert(op_node);
+  // The matcher also matches a divide pattern with a multiply call and the other way
+  // around, see the call pattern visitor.
+  if (op_node->name == "divide" || op_node->name == "multiply") {
+    ops_.insert(Op::Get("divide").get());
+    ops_.insert(Op::Get("multiply").get());
+  }
+  return true;
+}
+
+bool PatternRootFilter::MayMatch(const Expr& expr) const {
+  if (any_) return true;
+  if (const auto* call = expr.as<CallNode>()) {
+    return any_call_ || ops_.count(call->op.get());
+  }
+  return node_types_.count(expr->type_index());
+}
+
+bool PatternRootFilter::MayMatchAny(const ExprNodeIndex& index) const {
+  if (any_) return true;
+  if (any_call_ && (index.has_other_calls || !index.call_ops.empty())) return true;
+  for (const Object* op : ops_) {
+    if (index.call_ops.count(op)) return true;
+  }
+  for (uint32_t type_index : node_types_) {
+    if (index.node_types.count(type_index)) return true;
+  }
+  return false;
+}
+
 /*!
  * \brief PatternGrouper does pre-rewriting pattern matching and analysis
  *
@@ -549,16 +667,21 @@ class PatternGrouper {
   const std::unordered_map<Expr, int, ObjectPtrHash, ObjectPtrEqual>& GetGIDAssignments() {
     return gid_assignments_;
   }
-  /*! \brief Group expressions that match the pattern */
-  const std::unordered_map<int, Group>& GroupMatches(const DFPattern& pattern, const Expr& pre) {
+  /*! \brief Group expressions that match the pattern, the checked types of pre are used when
+   * types_inferred is set */
+  const std::unordered_map<int, Group>& GroupMatches(const DFPattern& pattern, const Expr& pre,
+                                                     bool types_inferred = false) {
     groups_.clear();
     gid_assignments_.clear();
 
     pattern_ = pattern;
     pattern_graph_ = CreateIndexedGraph(pattern_);
-    auto matcher = DFPatternMatcher(pre);
+    auto matcher = DFPatternMatcher(pre, types_inferred);
     matcher_ = &matcher;
+    PatternRootFilter root_filter(pattern_);
+    root_filter_ = &root_filter;
     this->VisitExprs();
+    root_filter_ = nullptr;
     return this->groups_;
   }
 
@@ -584,7 +707,9 @@ class PatternGrouper {
                            [&pre_partitioned](const Expr& expr) { pre_partitioned.insert(expr); });
           }
         }
-        if (pre_partitioned.count(current) == 0 && matcher_->Match(pattern_, current)) {
+        // Only the nodes the root of the pattern may match are given to the matcher
+        if (pre_partitioned.count(current) == 0 && root_filter_->MayMatch(current) &&
+            matcher_->Match(pattern_, current)) {
           CreateGroup(current);
         }
       }
@@ -793,6 +918,7 @@ class PatternGrouper {
   std::unordered_map<int, Group> groups_;
   std::unordered_map<Expr, int, ObjectPtrHash, ObjectPtrEqual> gid_assignments_;
   DFPatternMatcher* matcher_ = nullptr;
+  const PatternRootFilter* root_filter_ = nullptr;
   IndexedGraph<DFPattern> pattern_graph_;
   int gid_ = 0;
   int graph_number_ = 0;
@@ -842,7 +968,7 @@ class PatternRewriter : protected MixedModeMutator {
           post = InferTypeWithModule(post, mod_);
         }
         auto grouper = PatternGrouper();
-        groups_ = grouper.GroupMatches(callback_->pattern, post);
+        groups_ = grouper.GroupMatches(callback_->pattern, post, callback_->require_type);
         gid_assignments_ = grouper.GetGIDAssignments();
         memo_.clear();
         post = this->VisitExpr(post);
@@ -897,9 +1023,9 @@ TVM_REGISTER_GLOBAL("relay.dataflow_pattern.rewrite").set_body_typed(RewritePatt
 class PatternPartitioner : protected MixedModeMutator {
  public:
   Expr Partition(const DFPattern& pattern, const Expr& pre, const Map<String, ObjectRef>& attrs,
-                 PackedFunc check) {
+                 PackedFunc check, bool types_inferred) {
     auto grouper = PatternGrouper();
-    groups_ = grouper.GroupMatches(pattern, pre);
+    groups_ = grouper.GroupMatches(pattern, pre, types_inferred);
     gid_assignments_ = grouper.GetGIDAssignments();
     attrs_ = attrs;
     check_ = check;
@@ -937,8 +1063,8 @@ class PatternPartitioner : protected MixedModeMutator {
 };
 
 Expr PartitionPattern(DFPattern pattern, Expr expr, Map<String, ObjectRef> attrs,
-                      PackedFunc check) {
-  return PatternPartitioner().Partition(pattern, expr, attrs, check);
+                      PackedFunc check, bool types_inferred) {
+  return PatternPartitioner().Partition(pattern, expr, attrs, check, types_inferred);
 }
 
 TVM_REGISTER_GLOBAL("relay.dataflow_pattern.partition")
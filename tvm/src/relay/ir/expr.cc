@@ -22,6 +22,7 @@
  * \brief The expression AST nodes of Relay.
  */
 #include <tvm/ir/module.h>
+#include <tvm/node/structural_hash.h>
 #include <tvm/relay/expr.h>
 
 namespace tvm {
@@ -37,6 +38,15 @@ Constant::Constant(runtime::NDArray data, Span span) {
   data_ = std::move(n);
 }
 
+size_t ConstantNode::DataHash() const {
+  size_t hash = data_hash_.load(std::memory_order_relaxed);
+  if (hash == 0) {
+    hash = tvm::StructuralHash()(data);
+    data_hash_.store(hash, std::memory_order_relaxed);
+  }
+  return hash;
+}
+
 TVM_REGISTER_NODE_TYPE(ConstantNode);
 
 TVM_REGISTER_GLOBAL("relay.ir.Constant").set_body_typed([](runtime::NDArray data) {
@@ -21,16 +21,22 @@
  * \file relay/ir/transform.cc
  * \brief Relay specific transformation passes.
  */
-#include <dmlc/thread_local.h>
 #include <tvm/node/repr_printer.h>
 #include <tvm/relay/transform.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
+
+#include <utility>
+#include <vector>
 
 namespace tvm {
 namespace relay {
 namespace transform {
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relay.fallback_device_type", IntImm);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.quantized_device_type", IntImm);
+// Run function passes on this many functions at once, the passes must be thread safe.
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.FunctionPass.num_threads", Integer);
 
 class FunctionPass;
 
@@ -144,11 +150,27 @@ IRModule FunctionPassNode::operator()(IRModule mod, const PassContext& pass_ctx)
     // only picks up relay::Function
     if (auto* n = it.second.as<FunctionNode>()) {
       Function func = GetRef<Function>(n);
-      auto updated_func = SkipFunction(func) ? func : pass_func(func, updated_mod, pass_ctx);
-      updates.push_back({it.first, updated_func});
+      if (SkipFunction(func)) continue;
+      updates.push_back({it.first, func});
     }
   }
 
+  int num_threads =
+      pass_ctx->GetConfig<Integer>("relay.FunctionPass.num_threads", Integer(1)).value();
+  auto run = [this, &updates, &updated_mod, &pass_ctx](int i) {
+    updates[i].second = pass_func(updates[i].second, updated_mod, pass_ctx);
+  };
+  if (num_threads > 1 && updates.size() > 1) {
+    // The pass functions look up the PassContext of their thread, enter it on each worker.
+    support::parallel_for_dynamic(0, static_cast<int>(updates.size()), num_threads,
+                                  [&run, &pass_ctx](int thread_id, int i) {
+                                    With<PassContext> ctx_scope(pass_ctx);
+                                    run(i);
+                                  });
+  } else {
+    for (size_t i = 0; i < updates.size(); ++i) run(i);
+  }
+
   for (const auto& pair : updates) {
     updated_mod->Add(pair.first, pair.second, true);
   }
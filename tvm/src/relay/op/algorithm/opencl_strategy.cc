@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_strategy.cc
+ * \brief The OpenCL strategies of sort, argsort and topk.
+ *
+ *  They extend the GPU strategies with the OpenCL sort of the runtime, at a higher priority,
+ *  for the key and index types it supports.
+ */
+#include <tvm/relay/attrs/algorithm.h>
+#include <tvm/topi/contrib/opencl.h>
+#include <tvm/topi/generic/extern.h>
+
+#include "../op_common.h"
+
+namespace tvm {
+namespace relay {
+
+/*! \brief The priority of the OpenCL sort over the GPU implementations. */
+static constexpr int kOpenCLSortPriority = 15;
+
+static te::Schedule ScheduleOpenCLSort(const Attrs& attrs, const Array<te::Tensor>& outs,
+                                       const Target& target) {
+  return topi::generic::schedule_extern(target, outs);
+}
+
+TVM_REGISTER_GENERIC_FUNC(sort_strategy)
+    .register_func({"opencl"}, PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      OpStrategy strategy = GPUFallbackStrategy("sort_strategy", args);
+      Array<te::Tensor> inputs = args[1];
+      if (topi::contrib::opencl_sort_supported(inputs[0]->dtype, DataType::Int(32))) {
+        strategy.AddImplementation(
+            [](const Attrs& attrs, const Array<te::Tensor>& inputs, const Type& out_type) {
+              const auto* param = attrs.as<ArgsortAttrs>();
+              return Array<te::Tensor>{
+                  topi::contrib::opencl_sort(inputs[0], param->axis, param->is_ascend)};
+            },
+            ScheduleOpenCLSort, "sort.opencl", kOpenCLSortPriority);
+      }
+      *rv = strategy;
+    }));
+
+TVM_REGISTER_GENERIC_FUNC(argsort_strategy)
+    .register_func({"opencl"}, PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      OpStrategy strategy = GPUFallbackStrategy("argsort_strategy", args);
+      Attrs attrs = args[0];
+      Array<te::Tensor> inputs = args[1];
+      const auto* param = attrs.as<ArgsortAttrs>();
+      if (topi::contrib::opencl_sort_supported(inputs[0]->dtype, param->dtype)) {
+        strategy.AddImplementation(
+            [](const Attrs& attrs, const Array<te::Tensor>& inputs, const Type& out_type) {
+              const auto* param = attrs.as<ArgsortAttrs>();
+              return Array<te::Tensor>{topi::contrib::opencl_argsort(
+                  inputs[0], param->axis, param->is_ascend, param->dtype)};
+            },
+            ScheduleOpenCLSort, "argsort.opencl", kOpenCLSortPriority);
+      }
+      *rv = strategy;
+    }));
+
+TVM_REGISTER_GENERIC_FUNC(topk_strategy)
+    .register_func({"opencl"}, PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      OpStrategy strategy = GPUFallbackStrategy("topk_strategy", args);
+      Attrs attrs = args[0];
+      Array<te::Tensor> inputs = args[1];
+      const auto* param = attrs.as<TopKAttrs>();
+      // A dynamic k is an input of dyn.topk, the OpenCL sort takes it as an attribute
+      if (param->k.defined() &&
+          topi::contrib::opencl_sort_supported(inputs[0]->dtype, param->dtype)) {
+        strategy.AddImplementation(
+            [](const Attrs& attrs, const Array<te::Tensor>& inputs, const Type& out_type) {
+              const auto* param = attrs.as<TopKAttrs>();
+              return topi::contrib::opencl_topk(inputs[0], param->k.value()->value, param->axis,
+                                                param->ret_type, param->is_ascend, param->dtype);
+            },
+            ScheduleOpenCLSort, "topk.opencl", kOpenCLSortPriority);
+      }
+      *rv = strategy;
+    }));
+
+}  // namespace relay
+}  // namespace tvm
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file yuv_to_rgb.cc
+ * \brief YUV to RGB conversion of camera frames
+ */
+#include <tvm/relay/attrs/image.h>
+#include <tvm/relay/op.h>
+#include <tvm/relay/op_strategy.h>
+#include <tvm/target/generic_func.h>
+#include <tvm/topi/cuda/injective.h>
+#include <tvm/topi/generic/injective.h>
+#include <tvm/topi/image/yuv_to_rgb.h>
+
+#include "../op_common.h"
+
+namespace tvm {
+namespace relay {
+
+TVM_REGISTER_NODE_TYPE(YUVToRGBAttrs);
+
+bool YUVToRGBRel(const Array<Type>& types, int num_inputs, const Attrs& attrs,
+                 const TypeReporter& reporter) {
+  ICHECK_EQ(types.size(), 2);
+  const auto* data = types[0].as<TensorTypeNode>();
+  if (data == nullptr) return false;
+  const auto* param = attrs.as<YUVToRGBAttrs>();
+  ICHECK(param != nullptr);
+  ICHECK(data->shape.size() == 3U && data->dtype == DataType::UInt(8))
+      << "yuv_to_rgb expects uint8 frames of shape (batch, height * 3 / 2, width)";
+  ICHECK(param->format == "NV21" || param->format == "NV12")
+      << "Unsupported YUV format " << param->format;
+  ICHECK(param->mean.size() == 3 && param->stddev.size() == 3)
+      << "yuv_to_rgb expects the mean and standard deviation of three channels";
+  for (const FloatImm& stddev : param->stddev) {
+    ICHECK_NE(stddev->value, 0.0) << "yuv_to_rgb expects non-zero standard deviations";
+  }
+  ICHECK(!param->size.defined() || param->size.size() == 2) << "size should be (H, W)";
+
+  IndexExpr height = indexdiv(data->shape[1] * 2, 3);
+  IndexExpr width = data->shape[2];
+  if (param->size.defined() && !param->size.empty()) {
+    height = param->size[0];
+    width = param->size[1];
+  }
+  Array<IndexExpr> oshape;
+  if (param->layout == "NCHW") {
+    oshape = {data->shape[0], 3, height, width};
+  } else if (param->layout == "NHWC") {
+    oshape = {data->shape[0], height, width, 3};
+  } else if (param->layout == "NCHW4c") {
+    oshape = {data->shape[0], 1, height, width, 4};
+  } else {
+    LOG(FATAL) << "Unsupported layout " << param->layout;
+  }
+  reporter->Assign(types[1], TensorType(oshape, param->out_dtype));
+  return true;
+}
+
+Expr MakeYUVToRGB(Expr data, Array<IndexExpr> size, String format, String layout,
+                  Array<FloatImm> mean, Array<FloatImm> stddev, DataType out_dtype) {
+  auto attrs = make_object<YUVToRGBAttrs>();
+  attrs->size = std::move(size);
+  attrs->format = std::move(format);
+  attrs->layout = std::move(layout);
+  attrs->mean = std::move(mean);
+  attrs->stddev = std::move(stddev);
+  attrs->out_dtype = out_dtype;
+  static const Op& op = Op::Get("image.yuv_to_rgb");
+  return Call(op, {data}, Attrs(attrs), {});
+}
+
+TVM_REGISTER_GLOBAL("relay.op.image._make.yuv_to_rgb").set_body_typed(MakeYUVToRGB);
+
+Array<te::Tensor> YUVToRGBCompute(const Attrs& attrs, const Array<te::Tensor>& inputs,
+                                  const Type& out_type) {
+  const auto* param = attrs.as<YUVToRGBAttrs>();
+  ICHECK(param != nullptr);
+  Array<PrimExpr> size = param->size.defined() ? param->size : Array<PrimExpr>();
+  return Array<te::Tensor>{topi::image::yuv_to_rgb(inputs[0], size, param->format, param->layout,
+                                                   param->mean, param->stddev, param->out_dtype)};
+}
+
+/*!
+ * \brief The strategy of an injective op, scheduled by `fschedule`.
+ * \param fschedule The injective schedule of the target.
+ */
+static PackedFunc YUVToRGBStrategy(te::Schedule (*fschedule)(const Target&,
+                                                             const Array<te::Tensor>&)) {
+  return PackedFunc([fschedule](TVMArgs args, TVMRetValue* rv) {
+    OpStrategy strategy(make_object<OpStrategyNode>());
+    strategy.AddImplementation(
+        YUVToRGBCompute,
+        [fschedule](const Attrs& attrs, const Array<te::Tensor>& outs, const Target& target) {
+          return fschedule(target, outs);
+        },
+        "yuv_to_rgb.injective", 10);
+    *rv = strategy;
+  });
+}
+
+TVM_REGISTER_GENERIC_FUNC(yuv_to_rgb_strategy)
+    .set_default(YUVToRGBStrategy(topi::generic::schedule_injective))
+    .register_func({"gpu"}, YUVToRGBStrategy(topi::cuda::schedule_injective));
+
+RELAY_REGISTER_OP("image.yuv_to_rgb")
+    .describe(R"code(Convert semi-planar YUV 4:2:0 camera frames to normalized RGB images.
+
+The frame is scaled to the output size by nearest sampling and converted with the
+BT.601 full range coefficients, then every channel is normalized as
+(rgb / 255 - mean[c]) / stddev[c]. The op is injective, so that the input stage of the
+first convolution computes it, and with NCHW4c outputs the Adreno fusion policy fuses it
+into a texture convolution.
+
+- **data**: uint8 frames of shape (batch, height * 3 / 2, width), the luma rows followed
+            by the rows of interleaved chroma, V then U for NV21 and U then V for NV12.
+
+- **out**: the images of shape
+           (batch, 3, out_height, out_width) for NCHW
+           (batch, out_height, out_width, 3) for NHWC
+           (batch, 1, out_height, out_width, 4) for NCHW4c, the fourth channel is zero
+
+)code" TVM_ADD_FILELINE)
+    .set_attrs_type<YUVToRGBAttrs>()
+    .set_num_inputs(1)
+    .add_argument("data", "Tensor", "The camera frames.")
+    .set_support_level(5)
+    .add_type_rel("YUVToRGB", YUVToRGBRel)
+    .set_attr<TOpPattern>("TOpPattern", kInjective)
+    .set_attr<FTVMCompute>("FTVMCompute", YUVToRGBCompute)
+    .set_attr<FTVMStrategy>("FTVMStrategy", GenericFunc::Get("yuv_to_rgb_strategy"));
+
+}  // namespace relay
+}  // namespace tvm
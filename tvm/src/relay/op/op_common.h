@@ -28,6 +28,8 @@
 #include <tvm/relay/expr.h>
 #include <tvm/relay/op.h>
 #include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/op_strategy.h>
+#include <tvm/target/generic_func.h>
 
 #include <string>
 #include <unordered_map>
@@ -192,6 +194,24 @@ inline void GetPaddingDepthHeightWidth(const Array<IndexExpr>& padding, IndexExp
   }
 }
 
+/*!
+ * \brief Call the implementation of the generic strategy `name` for the "gpu" key, or its
+ *  default, so that a specialization for a more specific key extends the GPU strategy.
+ * \param name The name of the generic strategy.
+ * \param args The arguments of the strategy: attrs, inputs, out_type and target.
+ * \return The strategy, empty when nothing is registered.
+ */
+inline OpStrategy GPUFallbackStrategy(const std::string& name, const runtime::TVMArgs& args) {
+  GenericFunc generic = GenericFunc::Get(name);
+  auto it = generic->dispatch_dict_.find("gpu");
+  runtime::PackedFunc fallback =
+      it != generic->dispatch_dict_.end() ? it->second : generic->generic_func_;
+  if (fallback == nullptr) return OpStrategy(make_object<OpStrategyNode>());
+  runtime::TVMRetValue rv;
+  fallback.CallPacked(args, &rv);
+  return rv;
+}
+
 }  // namespace relay
 }  // namespace tvm
 
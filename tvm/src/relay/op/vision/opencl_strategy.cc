@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_strategy.cc
+ * \brief The OpenCL strategies of get_valid_counts and non_max_suppression.
+ *
+ *  They extend the GPU strategies with the OpenCL kernels of the runtime, at a higher priority,
+ *  for float32 boxes.
+ */
+#include <tvm/relay/attrs/vision.h>
+#include <tvm/topi/contrib/opencl.h>
+#include <tvm/topi/generic/extern.h>
+
+#include "../op_common.h"
+
+namespace tvm {
+namespace relay {
+
+/*! \brief The priority of the OpenCL kernels over the GPU implementations. */
+static constexpr int kOpenCLNMSPriority = 15;
+
+static te::Schedule ScheduleOpenCLNMS(const Attrs& attrs, const Array<te::Tensor>& outs,
+                                      const Target& target) {
+  return topi::generic::schedule_extern(target, outs);
+}
+
+TVM_REGISTER_GENERIC_FUNC(get_valid_counts_strategy)
+    .register_func({"opencl"}, PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      OpStrategy strategy = GPUFallbackStrategy("get_valid_counts_strategy", args);
+      Array<te::Tensor> inputs = args[1];
+      if (inputs[0]->dtype == DataType::Float(32) && inputs[1]->dtype == DataType::Float(32)) {
+        strategy.AddImplementation(
+            [](const Attrs& attrs, const Array<te::Tensor>& inputs, const Type& out_type) {
+              const auto* param = attrs.as<GetValidCountsAttrs>();
+              return topi::contrib::opencl_get_valid_counts(inputs[0], inputs[1],
+                                                            param->id_index, param->score_index);
+            },
+            ScheduleOpenCLNMS, "get_valid_counts.opencl", kOpenCLNMSPriority);
+      }
+      *rv = strategy;
+    }));
+
+TVM_REGISTER_GENERIC_FUNC(nms_strategy)
+    .register_func({"opencl"}, PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      OpStrategy strategy = GPUFallbackStrategy("nms_strategy", args);
+      Attrs attrs = args[0];
+      Array<te::Tensor> inputs = args[1];
+      const auto* param = attrs.as<NonMaximumSuppressionAttrs>();
+      // The kernel does not give the kept indices, and reads the thresholds as int32 and float32
+      if (!param->return_indices && inputs[0]->dtype == DataType::Float(32) &&
+          inputs[3]->dtype == DataType::Int(32) && inputs[4]->dtype == DataType::Float(32)) {
+        strategy.AddImplementation(
+            [](const Attrs& attrs, const Array<te::Tensor>& inputs, const Type& out_type) {
+              const auto* param = attrs.as<NonMaximumSuppressionAttrs>();
+              return Array<te::Tensor>{topi::contrib::opencl_non_max_suppression(
+                  inputs[0], inputs[1], inputs[3], inputs[4], param->force_suppress,
+                  param->top_k, param->coord_start, param->score_index, param->id_index,
+                  param->invalid_to_bottom)};
+            },
+            ScheduleOpenCLNMS, "non_max_suppression.opencl", kOpenCLNMSPriority);
+      }
+      *rv = strategy;
+    }));
+
+}  // namespace relay
+}  // namespace tvm
@@ -665,7 +665,11 @@ Expr QnnConv2DCanonicalize(const Attrs& attrs, const Array<Expr>& new_args,
   ICHECK_EQ(param->dilation.size(), 2) << "qnn.conv2d only supports 2D dilation";
   auto dilation_h = get_const_int(param->dilation[0]);
   auto dilation_w = get_const_int(param->dilation[1]);
-  if ((kernel_zero_point_int != 0 && (dilation_h != 1 || dilation_w != 1)) ||
+  // On texture targets the terms would be separate kernels through buffers, and the explicit
+  // pad with the zero point another one. The shifted operands of the simpler lowering are
+  // computed by the input stage of a single texture convolution instead, the zero padding of
+  // the shifted data being that of the quantized data padded with its zero point.
+  if (IsTextureTarget() || (kernel_zero_point_int != 0 && (dilation_h != 1 || dilation_w != 1)) ||
       (param->groups != 1 && !is_depthwise(param))) {
     return Conv2DFallBack(data, weight, input_zero_point, kernel_zero_point, param);
   } else if (is_depthwise(param)) {
@@ -25,6 +25,7 @@
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/relay/qnn/attrs.h>
+#include <tvm/relay/transform.h>
 
 #include "../../transforms/infer_layout_utils.h"
 #include "../../transforms/pattern_utils.h"
@@ -129,10 +130,65 @@ Array<Array<Layout>> RequantizeInferCorrectLayout(const Attrs& attrs,
  *       4) Add the output zero point.
  *       5) Cast to the out_dtype.
  */
+// Lower requantize to float multiplies on texture targets, whose results can differ from the
+// fixed point lowering by one step for the ties and beyond 2^24.
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.qnn.texture_float_requantize", Bool);
+
+/*
+ * \brief Lower requantize to float multiplies, for texture targets.
+ * \note The int64 fixed point multiplication is emulated on GPUs, while the float multiply
+ *       fuses into the epilogue of the texture kernel producing the input. The accumulators of
+ *       quantized convolutions are exact in float32 up to 2^24, and the error beyond is far
+ *       below the output step. Ties are rounded away from zero for both rounding modes.
+ */
+static Expr RequantizeLowerFloat(const Expr& input_tensor, const Expr& input_scale,
+                                 const Expr& input_zero_point, const Expr& output_scale,
+                                 const Expr& output_zero_point, const RequantizeAttrs* param,
+                                 const Array<IndexExpr>& input_shape, const DataType& out_dtype) {
+  auto tensor = Cast(input_tensor, DataType::Int(32));
+  auto zero_scalar = MakeConstantScalar(DataType::Int(32), 0);
+  if (!IsEqualScalar(input_zero_point, zero_scalar)) {
+    tensor = Subtract(tensor, Cast(input_zero_point, DataType::Int(32)));
+  }
+  auto scaled = Cast(tensor, DataType::Float(32));
+  float output_scale_float = GetScalarFromConstant<float>(output_scale);
+  if (IsConstScalar(input_scale)) {
+    if (!IsEqualScalar(input_scale, output_scale)) {
+      float multiplier = GetScalarFromConstant<float>(input_scale) / output_scale_float;
+      scaled = Multiply(scaled, MakeConstantScalar(DataType::Float(32), multiplier));
+    }
+  } else {
+    std::vector<float> multipliers;
+    for (float input_axis_scale : GetFloatVectorFromConstant(input_scale)) {
+      multipliers.push_back(input_axis_scale / output_scale_float);
+    }
+    int axis = param->axis;
+    axis = (axis == -1) ? input_shape.size() - 1 : axis;
+    auto multiplier_expr = MakeConstantTensor(
+        DataType::Float(32), {static_cast<int64_t>(multipliers.size())}, multipliers);
+    scaled = Multiply(scaled, ExpandBiasToMatchAxis(multiplier_expr, input_shape.size(), {axis}));
+  }
+  scaled = Round(scaled);
+  if (!IsEqualScalar(output_zero_point, zero_scalar)) {
+    scaled = Add(scaled, Cast(output_zero_point, DataType::Float(32)));
+  }
+  if (out_dtype == DataType::Int(32)) {
+    return Cast(scaled, out_dtype);
+  }
+  return Cast(Clip(scaled, GetQmin(out_dtype), GetQmax(out_dtype)), out_dtype);
+}
+
 Expr RequantizeLower(const Expr& input_tensor, const Expr& input_scale,
                      const Expr& input_zero_point, const Expr& output_scale,
                      const Expr& output_zero_point, const RequantizeAttrs* param,
                      const Array<IndexExpr>& input_shape, const DataType& out_dtype) {
+  bool float_requantize = transform::PassContext::Current()
+                              ->GetConfig<Bool>("relay.qnn.texture_float_requantize", Bool(false))
+                              .value();
+  if (float_requantize && IsTextureTarget()) {
+    return RequantizeLowerFloat(input_tensor, input_scale, input_zero_point, output_scale,
+                                output_zero_point, param, input_shape, out_dtype);
+  }
   auto tensor = Cast(input_tensor, DataType::Int(32));
   // 1) Subtract the input_zero_point
   auto zero_scalar = MakeConstantScalar(DataType::Int(32), 0);
@@ -24,12 +24,21 @@
 
 #include "utils.h"
 
+#include <tvm/target/target.h>
+
 #include "../transforms/pattern_utils.h"
 
 namespace tvm {
 namespace relay {
 namespace qnn {
 
+bool IsTextureTarget() {
+  Target target = Target::Current(true);
+  if (!target.defined() || target->kind->device_type != kDLOpenCL) return false;
+  Optional<String> device = target->GetAttr<String>("device");
+  return device.defined() && device.value() == "adreno";
+}
+
 std::pair<int32_t, int32_t> GetFixedPointMultiplierShift(double double_multiplier) {
   int32_t significand, exponent;
   if (double_multiplier == 0.) {
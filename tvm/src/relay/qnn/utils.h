@@ -91,6 +91,14 @@ static inline int32_t GetQmax(const DataType& dtype) {
  */
 std::pair<int32_t, int32_t> GetFixedPointMultiplierShift(double double_multiplier);
 
+/*
+ * \brief Whether the current target keeps quantized activations in textures, i.e. OpenCL on
+ *  Adreno. Its QNN ops are lowered to one convolution of the shifted operands, and with
+ *  relay.qnn.texture_float_requantize their requantization to float multiplies, which fuse
+ *  into the texture kernel of the convolution.
+ */
+bool IsTextureTarget();
+
 Expr RequantizeLower(const Expr& input_tensor, const Expr& input_scale,
                      const Expr& input_zero_point, const Expr& output_scale,
                      const Expr& output_zero_point, const RequantizeAttrs* param,
@@ -125,6 +125,7 @@ TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
       p->stream << "calibrate_mode=" << op->calibrate_mode << ", ";
       p->stream << "global_scale=" << op->global_scale << ", ";
       p->stream << "weight_scale=" << op->weight_scale << ", ";
+      p->stream << "weight_per_channel=" << op->weight_per_channel << ", ";
       p->stream << "skip_conv_layers==" << op->skip_conv_layers << ", ";
       p->stream << "do_simulation==" << op->do_simulation << ", ";
       p->stream << "round_for_shift==" << op->round_for_shift << ", ";
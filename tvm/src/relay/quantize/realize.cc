@@ -29,6 +29,11 @@
 #include <tvm/relay/attrs/annotation.h>
 #include <tvm/relay/transform.h>
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
 #include "../qnn/utils.h"
 #include "../transforms/pattern_utils.h"
 #include "./quantize.h"
@@ -203,6 +208,101 @@ Expr FoldConstantOpt(const Expr& expr) {
 RELAY_REGISTER_OP("relay.op.annotation.simulated_quantize")
     .set_attr<FForwardRewrite>("FQRealizeRewrite", QuantizeRealize);
 
+/*!
+ * \brief Quantize a constant convolution weight with one scale per output channel.
+ * \param weight The simulated quantize of the weight.
+ * \param kernel_layout The layout of the weight.
+ * \return The weight in the quantized domain and the scale of every output channel, the scales
+ *  are empty when the weight cannot be quantized per channel.
+ */
+std::pair<Expr, std::vector<float>> QuantizeWeightPerChannel(const Expr& weight,
+                                                             const Layout& kernel_layout) {
+  static const Op& simulated_quantize = Op::Get("relay.op.annotation.simulated_quantize");
+  const QConfig& cfg = QConfig::Current();
+  const auto* sq = weight.as<CallNode>();
+  if (sq == nullptr || !sq->op.same_as(simulated_quantize) ||
+      sq->attrs.as<SimulatedQuantizeAttrs>()->kind != kQWeight) {
+    return {};
+  }
+  const auto* data = sq->args[0].as<ConstantNode>();
+  if (data == nullptr || data->data->ctx.device_type != kDLCPU ||
+      DataType(data->data->dtype) != DataType::Float(32) || !sq->args[1].as<ConstantNode>() ||
+      !sq->args[2].as<ConstantNode>() || !sq->args[3].as<ConstantNode>()) {
+    return {};
+  }
+  float dom_scale = GetScalarFromConstant<float>(sq->args[1]);
+  float clip_min = GetScalarFromConstant<float>(sq->args[2]);
+  float clip_max = GetScalarFromConstant<float>(sq->args[3]);
+
+  // The output channel of an element, the packed output channels follow their block.
+  std::vector<int64_t> shape = data->data.Shape();
+  int o_axis = kernel_layout.IndexOf(LayoutAxis::Get('O'));
+  int sub_axis = kernel_layout.IndexOf(LayoutAxis::Get('o'));
+  if (o_axis < 0 || static_cast<size_t>(kernel_layout.ndim()) != shape.size()) return {};
+  std::vector<int64_t> strides(shape.size(), 1);
+  for (int i = static_cast<int>(shape.size()) - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * shape[i + 1];
+  }
+  int64_t factor = sub_axis < 0 ? 1 : shape[sub_axis];
+  auto channel_of = [&](int64_t i) {
+    int64_t c = (i / strides[o_axis]) % shape[o_axis] * factor;
+    return sub_axis < 0 ? c : c + (i / strides[sub_axis]) % factor;
+  };
+
+  int64_t size = strides[0] * shape[0];
+  const float* values = static_cast<const float*>(data->data->data);
+  std::vector<float> max_abs(shape[o_axis] * factor, 0.f);
+  for (int64_t i = 0; i < size; ++i) {
+    float& m = max_abs[channel_of(i)];
+    m = std::max(m, std::abs(values[i]));
+  }
+  // Follow the weight_scale mode of the per tensor scales, a zero channel keeps the tensor scale.
+  std::vector<float> scales(max_abs.size(), dom_scale);
+  for (size_t c = 0; c < max_abs.size(); ++c) {
+    if (max_abs[c] == 0.f) continue;
+    float range = cfg->weight_scale == "power2" ? std::pow(2.f, std::ceil(std::log2(max_abs[c])))
+                                                : max_abs[c];
+    scales[c] = range / clip_max;
+  }
+
+  runtime::NDArray quantized = runtime::NDArray::Empty(shape, data->data->dtype, data->data->ctx);
+  float* qvalues = static_cast<float*>(quantized->data);
+  for (int64_t i = 0; i < size; ++i) {
+    float q = std::round(values[i] / scales[channel_of(i)]);
+    qvalues[i] = std::min(std::max(q, clip_min), clip_max);
+  }
+  return {Constant(quantized), scales};
+}
+
+/*!
+ * \brief Bring the per output channel domains of a convolution back to a single scale.
+ *  Every channel is multiplied by scale / max_scale <= 1 in Q31 fixed point, which cannot
+ *  overflow the int32 accumulators.
+ * \return The rescaled data in the domain of lhs_scale * max_scale.
+ */
+Expr RescaleChannels(Expr data, float lhs_scale, const std::vector<float>& scales,
+                     const Layout& out_layout, size_t ndim, DataType dtype) {
+  float max_scale = *std::max_element(scales.begin(), scales.end());
+  int c_axis = out_layout.IndexOf(LayoutAxis::Get('C'));
+  int sub_axis = out_layout.IndexOf(LayoutAxis::Get('c'));
+  int64_t factor = sub_axis < 0 ? 1 : out_layout.FactorOf(LayoutAxis::Get('C'));
+  std::vector<int64_t> shape(ndim, 1);
+  shape[c_axis] = static_cast<int64_t>(scales.size()) / factor;
+  if (sub_axis >= 0) shape[sub_axis] = factor;
+
+  runtime::NDArray multipliers =
+      runtime::NDArray::Empty(shape, DataType::Int(64), {kDLCPU, 0});
+  int64_t* mvalues = static_cast<int64_t*>(multipliers->data);
+  for (size_t c = 0; c < scales.size(); ++c) {
+    mvalues[c] = static_cast<int64_t>(std::round(scales[c] / max_scale * (1LL << 31)));
+  }
+  data = Multiply(Cast(data, DataType::Int(64)), Constant(multipliers));
+  data = Add(data, MakeConstantScalar(DataType::Int(64), 1LL << 30));
+  data = RightShift(data, MakeConstantScalar(DataType::Int(64), 31));
+  return QRealizeIntExpr(Cast(data, dtype), MakeConstantScalar(DataType::Float(32),
+                                                               lhs_scale * max_scale), dtype);
+}
+
 Expr Conv2dRealize(const Call& ref_call, const Array<Expr>& new_args, const ObjectRef& ctx) {
   const QConfig& cfg = QConfig::Current();
   ICHECK_EQ(new_args.size(), 2);
@@ -218,15 +318,34 @@ Expr Conv2dRealize(const Call& ref_call, const Array<Expr>& new_args, const Obje
   if (lhs->dtype != cfg->dtype_input) {
     ldata = Cast(ldata, cfg->dtype_input);
   }
-  Expr rdata = Cast(rhs->data, cfg->dtype_weight);
 
   const auto ref_attrs = ref_call->attrs.as<Conv2DAttrs>();
+  Layout out_layout(ref_attrs->out_layout == "" ? ref_attrs->data_layout : ref_attrs->out_layout);
+  // Quantize constant weights per output channel, when the output channels of the weight and
+  // of the output are packed alike.
+  Expr rdata = rhs->data;
+  std::vector<float> channel_scales;
+  if (cfg->weight_per_channel && lhs->dom_scale.as<ConstantNode>()) {
+    Layout kernel_layout(ref_attrs->kernel_layout);
+    if (kernel_layout.FactorOf(LayoutAxis::Get('O')) ==
+        out_layout.FactorOf(LayoutAxis::Get('C'))) {
+      std::tie(rdata, channel_scales) = QuantizeWeightPerChannel(ref_call->args[1], kernel_layout);
+    }
+    if (channel_scales.empty()) rdata = rhs->data;
+  }
+  rdata = Cast(rdata, cfg->dtype_weight);
+
   auto attrs = make_object<Conv2DAttrs>();
   *attrs = *ref_attrs;
   DataType out_dtype = cfg->dtype_activation;
   attrs->out_dtype = out_dtype;
 
   Expr ret = Call(ref_call->op, {ldata, rdata}, Attrs(attrs), ref_call->type_args);
+  if (!channel_scales.empty()) {
+    size_t ndim = ref_call->type_as<TensorTypeNode>()->shape.size();
+    return RescaleChannels(ret, GetScalarFromConstant<float>(lhs->dom_scale), channel_scales,
+                           out_layout, ndim, out_dtype);
+  }
   Expr mul = Multiply(lhs->dom_scale, rhs->dom_scale);
   Expr dom_scale = FoldConstantOpt(mul);
   return QRealizeIntExpr(ret, dom_scale, out_dtype);
@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file annotate_checkpoints.cc
+ * \brief Choose the checkpoints of the reverse mode gradient by a recompute policy.
+ *
+ * The gradient pass keeps the forward value of every binding alive for the backward pass,
+ * except inside annotation.checkpoint, whose content is computed without keeping its
+ * intermediates and recomputed when the backward pass reaches it. The policies wrap
+ * segments of the top level let bindings of a function in checkpoints.
+ */
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/transform.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tvm {
+namespace relay {
+
+/*!
+ * \brief Whether a binding may be recomputed, and whether it is cheap to.
+ * \param value The bound value.
+ * \param cheap Set to whether the value is an injective computation.
+ * \return Whether the value may be in a checkpoint.
+ */
+static bool IsRecomputable(const Expr& value, bool* cheap) {
+  static const Op& checkpoint = Op::Get("annotation.checkpoint");
+  static const auto& fpattern = Op::GetAttrMap<TOpPattern>("TOpPattern");
+  static const auto& fstateful = Op::GetAttrMap<TOpIsStateful>("TOpIsStateful");
+  *cheap = true;
+  if (value.as<TupleNode>() || value.as<TupleGetItemNode>() || value.as<VarNode>()) {
+    return true;
+  }
+  const auto* call = value.as<CallNode>();
+  if (call == nullptr) return false;
+  const auto* op = call->op.as<OpNode>();
+  if (op == nullptr || GetRef<Op>(op) == checkpoint) return false;
+  Op op_ref = GetRef<Op>(op);
+  if (fstateful.get(op_ref, false)) return false;
+  *cheap = fpattern.get(op_ref, kOpaque) <= kInjective;
+  return true;
+}
+
+Expr AnnotateCheckpoints(const Expr& e, const String& policy) {
+  ICHECK(policy == "sqrt" || policy == "cheap") << "Unknown recompute policy " << policy;
+  const auto* func = e.as<FunctionNode>();
+  ICHECK(func) << "AnnotateCheckpoints expects a function";
+  if (func->HasNonzeroAttr(attr::kPrimitive)) return e;
+  Function anf = Downcast<Function>(transform::ToANormalForm(e));
+
+  std::vector<std::pair<Var, Expr>> bindings;
+  Expr body = anf->body;
+  while (const auto* let = body.as<LetNode>()) {
+    bindings.emplace_back(let->var, let->value);
+    body = let->body;
+  }
+  size_t n = bindings.size();
+  // The last binding using each binding, n for the body
+  std::unordered_map<const VarNode*, size_t> index;
+  for (size_t i = 0; i < n; ++i) index[bindings[i].first.get()] = i;
+  std::vector<size_t> last_use(n, 0);
+  auto use = [&](const Expr& expr, size_t at) {
+    for (const Var& v : FreeVars(expr)) {
+      auto it = index.find(v.get());
+      if (it != index.end()) last_use[it->second] = std::max(last_use[it->second], at);
+    }
+  };
+  for (size_t i = 0; i < n; ++i) use(bindings[i].second, i);
+  use(body, n);
+
+  std::vector<bool> recomputable(n), cheap(n);
+  size_t num_recomputable = 0;
+  for (size_t i = 0; i < n; ++i) {
+    bool is_cheap;
+    recomputable[i] = IsRecomputable(bindings[i].second, &is_cheap);
+    cheap[i] = is_cheap;
+    num_recomputable += recomputable[i];
+  }
+  size_t target = std::max<size_t>(
+      2, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_recomputable)))));
+
+  // The segments [begin, end], which only their last binding outlives
+  std::vector<std::pair<size_t, size_t>> segments;
+  size_t begin = 0;
+  while (begin < n) {
+    size_t run_end = begin;
+    while (run_end < n && recomputable[run_end] && (policy == "sqrt" || cheap[run_end])) {
+      ++run_end;
+    }
+    size_t last_valid = begin;
+    size_t live_until = 0;
+    for (size_t end = begin + 1; end < run_end; ++end) {
+      live_until = std::max(live_until, last_use[end - 1]);
+      if (live_until > end) continue;
+      last_valid = end;
+      if (policy == "sqrt" && end - begin + 1 >= target) break;
+    }
+    if (last_valid > begin) segments.emplace_back(begin, last_valid);
+    begin = last_valid + 1;
+  }
+  if (segments.empty()) return std::move(anf);
+
+  static const Op& checkpoint = Op::Get("annotation.checkpoint");
+  Expr result = body;
+  size_t seg = segments.size();
+  for (size_t i = n; i-- > 0;) {
+    if (seg > 0 && segments[seg - 1].second == i) {
+      const auto& segment = segments[--seg];
+      Expr inner = bindings[segment.second].second;
+      for (size_t j = segment.second; j-- > segment.first;) {
+        inner = Let(bindings[j].first, bindings[j].second, inner);
+      }
+      result = Let(bindings[i].first, Call(checkpoint, {inner}, Attrs(), {}), result);
+      i = segment.first;
+      continue;
+    }
+    result = Let(bindings[i].first, bindings[i].second, result);
+  }
+  return Function(anf->params, result, anf->ret_type, anf->type_params, anf->attrs);
+}
+
+namespace transform {
+
+Pass AnnotateCheckpoints(String policy) {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        return Downcast<Function>(relay::AnnotateCheckpoints(f, policy));
+      };
+  return CreateFunctionPass(pass_func, 1, "AnnotateCheckpoints", {"InferType"});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.AnnotateCheckpoints").set_body_typed(AnnotateCheckpoints);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
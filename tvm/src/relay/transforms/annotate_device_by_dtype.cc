@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file annotate_device_by_dtype.cc
+ * \brief Place the quantized and the float parts of a model on different devices.
+ *
+ * On SoCs with a DSP next to the GPU, e.g. Hexagon and Adreno on Snapdragon, the integer
+ * kernels run best on the DSP and the float16 ones on the GPU. The operators are annotated
+ * with on_device by their data types, RewriteAnnotatedOps then inserts the device copies
+ * between the two parts.
+ */
+#include <tvm/relay/attrs/annotation.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op.h>
+#include <tvm/relay/transform.h>
+
+#include <unordered_set>
+#include <utility>
+
+namespace tvm {
+namespace relay {
+
+class DeviceByDTypeAnnotator : public ExprRewriter {
+ public:
+  DeviceByDTypeAnnotator(int quantized_device, int float_device,
+                         std::unordered_set<const Object*> annotated)
+      : quantized_device_(quantized_device),
+        float_device_(float_device),
+        annotated_(std::move(annotated)),
+        on_device_op_(Op::Get("on_device")),
+        device_copy_op_(Op::Get("device_copy")) {}
+
+  Expr Rewrite_(const CallNode* pre, const Expr& post) override {
+    if (!pre->op.as<OpNode>() || pre->op == on_device_op_ || pre->op == device_copy_op_ ||
+        annotated_.count(pre)) {
+      return post;
+    }
+    int device = 0;
+    if (IsQuantized(pre)) {
+      quantized_.insert(pre);
+      device = quantized_device_;
+    } else if (HasDType(pre->checked_type(), [](DataType t) { return t.is_float16(); })) {
+      device = float_device_;
+    }
+    if (device <= 0) return post;
+    auto attrs = make_object<OnDeviceAttrs>();
+    attrs->device_type = device;
+    return Call(on_device_op_, {post}, Attrs(attrs), {});
+  }
+
+ private:
+  /*!
+   * \brief Whether a call belongs to the quantized part: it reads or produces 8 bit integers,
+   *  or it is an integer op on the output of the quantized part, e.g. a bias add or a
+   *  requantization between two quantized convolutions.
+   */
+  bool IsQuantized(const CallNode* call) const {
+    auto is_int8 = [](DataType t) { return (t.is_int() || t.is_uint()) && t.bits() == 8; };
+    if (HasDType(call->checked_type(), is_int8)) return true;
+    bool int_result = HasDType(call->checked_type(), [](DataType t) { return t.is_int(); });
+    for (const Expr& arg : call->args) {
+      if (HasDType(arg->checked_type(), is_int8)) return true;
+      if (int_result && quantized_.count(arg.get())) return true;
+    }
+    return false;
+  }
+
+  template <typename F>
+  static bool HasDType(const Type& type, F pred) {
+    if (const auto* ttype = type.as<TensorTypeNode>()) {
+      return pred(ttype->dtype);
+    }
+    if (const auto* tuple = type.as<TupleTypeNode>()) {
+      for (const Type& field : tuple->fields) {
+        if (HasDType(field, pred)) return true;
+      }
+    }
+    return false;
+  }
+
+  // The device of the integer kernels
+  int quantized_device_;
+  // The device of the float16 kernels, 0 to leave them to the fallback device
+  int float_device_;
+  // The calls annotated by the user, which keep their device
+  std::unordered_set<const Object*> annotated_;
+  // The calls placed on the quantized device, as pre-rewrite nodes
+  std::unordered_set<const Object*> quantized_;
+  // Cache the following ops. They will be used in the passes repeatedly for
+  // operator equivalence checking so that the registry lookup overhead can be
+  // reduced.
+  const Op& on_device_op_;
+  const Op& device_copy_op_;
+};
+
+Expr AnnotateDeviceByDType(const Expr& e, int quantized_device, int float_device) {
+  // the arguments of the existing annotations keep their device
+  std::unordered_set<const Object*> annotated;
+  static const Op& on_device_op = Op::Get("on_device");
+  PostOrderVisit(e, [&annotated](const Expr& expr) {
+    const auto* call = expr.as<CallNode>();
+    if (call != nullptr && call->op == on_device_op) {
+      annotated.insert(call->args[0].get());
+    }
+  });
+  auto rewriter = DeviceByDTypeAnnotator(quantized_device, float_device, std::move(annotated));
+  // The quantized part of the rewriter needs the post order, so that the producers of a call
+  // are classified before it.
+  return PostOrderRewrite(e, &rewriter);
+}
+
+namespace transform {
+
+Pass AnnotateDeviceByDType(int quantized_device, int float_device) {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        return Downcast<Function>(AnnotateDeviceByDType(f, quantized_device, float_device));
+      };
+  return CreateFunctionPass(pass_func, 1, "AnnotateDeviceByDType", {"InferType"});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.AnnotateDeviceByDType").set_body_typed(AnnotateDeviceByDType);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
@@ -29,23 +29,53 @@
  *    and in the graph runtime when doing runtime dataspace
  *    allocations.
  *
+ *    With the texture_concat target attribute, concatenations of NCHW4c
+ *    tensors produce textures too.
+ *
+ *    Texture scope is only assigned to tensors whose image extents fit
+ *    the target's texture_spatial_limit, and a cost model registered as
+ *    relay.backend.opencl.adreno._TextureScopeCost can veto texture
+ *    outputs of a primitive which are estimated to be slower.
+ *
  *  - CollectBufferBinds returns an array of tir::Buffer given
  *    the storage info yielded from CollectStogrageInfo. These
  *    buffers are bound to tensors created by the compile engine
  *    and are used as binds when calling tvm::lower/build.
  *
+ *  - FusionPolicy is the target fusion policy consulted by FuseOps.
+ *    It refuses to extend a group whose anchor produces textures when
+ *    the extended group would write an output which cannot be stored in
+ *    a texture, e.g. a reshape, while the current output can.
+ *
+ *  - ProducerFusionPolicy lets FuseOps fuse a nearest or bilinear resize
+ *    into the texture convolution reading it, whose input stage then
+ *    samples the texture before the resize instead of an upsampled copy.
+ *    The zero point shift of quantized data is fused the same way, so that
+ *    quantized convolutions read their int8 textures.
+ *    The NCHW4c conversion of camera frames by image.yuv_to_rgb is fused
+ *    too, so the first convolution reads the frame itself. The policy only
+ *    fuses when relay.backend.texture_fuse_conv_input is set, i.e. when the
+ *    convolution schedules inline these producers into their data stage.
+ *
  */
 
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/transform.h>
 #include <tvm/tir/expr.h>
+#include <tvm/relay/attrs/image.h>
 #include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/attrs/transform.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
 
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "../../runtime/texture.h"
+
 namespace tvm {
 namespace relay {
 namespace {
@@ -60,15 +90,6 @@ class StorageInfo : private ExprVisitor{
     StorageInfo storage_info(dev_map, target_map);
     storage_info.Visit(expr);
     storage_info.LegalizeProducerStorage();
-    // TODO(csullivan): The below can be removed if either of the following are true:
-    //   * Function outputs are persistent (can_realloc = False)
-    //   * Runtime support is added for passing tensor shape through CopyFromTo API
-    //     so that image pitch can be determined allowing the correct read to be
-    //     enqueued from a texture pool.
-    // For now we force write to global for the outputs of the function over which
-    // memory planning will be performed. This should incur only a trivial change
-    // in performance.
-    storage_info.ForceGlobalOutputStorage(expr);
     Map<Expr, Array<String>> storage_map;
     for (auto& kv : storage_info.storage_scope_) {
       std::vector<String> storage_scopes;
@@ -78,6 +99,102 @@ class StorageInfo : private ExprVisitor{
     return storage_map;
   }
 
+  /*!
+   * \brief Count the conversions between textures and buffers done by the kernel of a fused
+   *  group which writes the given output: an anchor producing textures has to convert its
+   *  result to a buffer when the output of the group cannot be stored in a texture.
+   * \param anchor The anchor op of the group.
+   * \param output The output of the group.
+   * \param target The target of the group.
+   * \return The number of conversions.
+   */
+  static int CountOutputConversions(const Expr& anchor, const Expr& output, const Target& target) {
+    StorageInfo storage_info({}, Map<Integer, Target>({{Integer(0), target}}));
+    const auto* call = anchor.as<CallNode>();
+    if (call == nullptr || !storage_info.SupportsTextureStorage(call)) return 0;
+    // Outputs which are not tensors, e.g. tuples, are left to the default fusion rules.
+    const auto* ttype = output->checked_type_.as<TensorTypeNode>();
+    if (ttype == nullptr) return 0;
+    if (ttype->shape.size() > 2 && HasTexelInnerDim(ttype) && IsTextureDataType(ttype->dtype) &&
+        !storage_info.SelectTextureScope(output, ttype, "texture").empty()) {
+      return 0;
+    }
+    return 1;
+  }
+
+  /*!
+   * \brief Whether a call is a nearest or bilinear resize of an NCHW4c tensor, which a texture
+   *  convolution can compute in its input stage, each texel read at the computed coordinates.
+   */
+  static bool IsTextureResize(const CallNode* call) {
+    static const Op& resize_op = Op::Get("image.resize");
+    static const Op& upsampling_op = Op::Get("nn.upsampling");
+    if (call->op == resize_op) {
+      const auto* attrs = call->attrs.as<ResizeAttrs>();
+      return attrs->layout == "NCHW4c" &&
+             (attrs->method == "nearest_neighbor" || attrs->method == "bilinear");
+    } else if (call->op == upsampling_op) {
+      const auto* attrs = call->attrs.as<UpSamplingAttrs>();
+      return attrs->layout == "NCHW4c" &&
+             (attrs->method == "nearest_neighbor" || attrs->method == "bilinear");
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Whether a call shifts quantized data by its zero point for a convolution, i.e. a
+   *  cast of 8 bit integers to int16 followed by the subtraction of a constant.
+   */
+  static bool IsZeroPointShift(const CallNode* call) {
+    static const Op& cast_op = Op::Get("cast");
+    static const Op& subtract_op = Op::Get("subtract");
+    if (call->op == subtract_op) {
+      const auto* cast = call->args[0].as<CallNode>();
+      return cast != nullptr && cast->op == cast_op && IsZeroPointShift(cast) &&
+             call->args[1].as<ConstantNode>() != nullptr;
+    } else if (call->op == cast_op) {
+      const auto* from = call->args[0]->checked_type().as<TensorTypeNode>();
+      return from != nullptr && (from->dtype.is_int() || from->dtype.is_uint()) &&
+             from->dtype.bits() == 8 && call->attrs.as<CastAttrs>()->dtype == DataType::Int(16);
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Whether a call is the NCHW4c conversion of a camera frame, which a texture convolution
+   *  computes in its input stage from the bytes of the frame.
+   */
+  static bool IsTextureYUVToRGB(const CallNode* call) {
+    static const Op& yuv_to_rgb_op = Op::Get("image.yuv_to_rgb");
+    return call->op == yuv_to_rgb_op && call->attrs.as<YUVToRGBAttrs>()->layout == "NCHW4c";
+  }
+
+  /*!
+   * \brief Whether a call computes the data of a texture convolution, which the input stage of
+   *  the convolution computes as it reads its input texture.
+   */
+  static bool IsConvInputStage(const CallNode* call) {
+    return IsTextureResize(call) || IsZeroPointShift(call) || IsTextureYUVToRGB(call);
+  }
+
+  /*!
+   * \brief Whether a producer can be fused into a convolution reading its output as data, so
+   *  that the resized or shifted tensor is never written.
+   * \param producer The producer.
+   * \param anchor The convolution.
+   * \param target The target of the group.
+   */
+  static bool CanFuseProducer(const Expr& producer, const Expr& anchor, const Target& target) {
+    StorageInfo storage_info({}, Map<Integer, Target>({{Integer(0), target}}));
+    const auto* call = anchor.as<CallNode>();
+    const auto* input = producer.as<CallNode>();
+    if (call == nullptr || input == nullptr || !call->attrs.as<Conv2DAttrs>() ||
+        !storage_info.SupportsTextureStorage(call) || call->args[0].get() != input) {
+      return false;
+    }
+    return IsConvInputStage(input);
+  }
+
  private:
   void Visit(const Expr& expr) {
     // Pre-order traversal to enable upward propagation
@@ -100,42 +217,81 @@ class StorageInfo : private ExprVisitor{
     ApplyConsumerScopeToInputs(cn, "weight");
   }
 
+  void VisitExpr_(const LetNode* op) final {
+    // In A-normal form producers are consumed through their let bound variables
+    let_bindings_[op->var.get()] = op->value.get();
+    ExprVisitor::VisitExpr_(op);
+  }
+
   void VisitExpr_(const CallNode* call) final {
     // Check the contents of this primitive function
     if (DeviceSupportsTextureStorage(GetRef<Expr>(call))) {
       if (const auto* fn = call->op.as<FunctionNode>()) {
         if (fn->HasNonzeroAttr(attr::kPrimitive)) {
           primitive_supports_texture_ = false;
+          primitive_reads_nhwc_ = false;
           Visit(call->op);
           if (primitive_supports_texture_) {
-            if (call->checked_type().as<TensorTypeNode>()) {
-              storage_scope_[call].push_back("texture");
+            if (const auto* ttype = call->checked_type().as<TensorTypeNode>()) {
+              std::string scope = SelectTextureScope(call, ttype, "texture");
+              if (HasTextureDataType(call->checked_type()) && !scope.empty() &&
+                  PreferTexture(call, {scope})) {
+                storage_scope_[call].push_back(scope);
+              }
             } else {
               const auto* tuple_type = call->type_as<TupleTypeNode>();
               ICHECK(tuple_type);
-              // TODO(csullivan): Add support for mixed output storage scope.
-              // In current adreno storage planner all outputs of a
-              // primitive function are assumed to be of the same storage
-              // type. This should be easy to extend in the future.
-              for (size_t i = 0; i < tuple_type->fields.size(); i++) {
-                storage_scope_[call].push_back("texture");
+              // Each output is assigned its own scope, fields which cannot be
+              // stored as a texture remain in global memory.
+              std::vector<std::string> scopes;
+              bool any_texture = false;
+              for (const auto& field : tuple_type->fields) {
+                const auto* ttype = field.as<TensorTypeNode>();
+                std::string scope;
+                if (ttype && ttype->shape.size() > 2 && HasTexelInnerDim(ttype) &&
+                    HasTextureDataType(field)) {
+                  scope = SelectTextureScope(call, ttype, "texture");
+                }
+                scopes.push_back(scope.empty() ? "global" : scope);
+                any_texture |= !scope.empty();
+              }
+              if (any_texture && PreferTexture(call, scopes)) {
+                storage_scope_[call] = scopes;
               }
             }
           }
-          // Add consumer storage scope information for call arguments
-          for (auto& arg : call->args) {
-            if (storage_scope_.count(call)) {
-              ICHECK(!HasMixedStorageOutputs(call)) << "Mixed output storage scopes are not currently supported";
-              consumer_storage_scopes_[arg.operator->()].push_back(storage_scope_[call][0]);
-            } else {
-              consumer_storage_scopes_[arg.operator->()].push_back("global");
+          // Add consumer storage scope information for call arguments, a primitive
+          // with any texture output reads its inputs from textures when possible
+          std::string consumer_scope = "global";
+          if (storage_scope_.count(call)) {
+            for (const auto& scope : storage_scope_[call]) {
+              if (runtime::IsTextureStorage(scope)) consumer_scope = "texture";
             }
           }
+          for (auto& arg : call->args) {
+            const ExprNode* producer = Resolve(arg.operator->());
+            consumer_storage_scopes_[producer].push_back(consumer_scope);
+            consumer_reads_nhwc_[producer].push_back(primitive_reads_nhwc_);
+          }
         }
       }
     }
 
-    primitive_supports_texture_ = SupportsTextureStorage(call);
+    // The producers fused into a convolution are computed by its texture input stage
+    if (!conv_input_stages_.count(call)) {
+      primitive_supports_texture_ = SupportsTextureStorage(call);
+    }
+    if (const auto* attrs = call->attrs.as<Conv2DAttrs>()) {
+      primitive_reads_nhwc_ |= attrs->data_layout == "NHWC" && SupportsTextureStorage(call);
+    }
+    // The data producer of a texture convolution is part of its input stage, and so are the
+    // producers of that stage, e.g. the cast of a zero point shift. The consumers are visited
+    // before their producers.
+    if (!call->args.empty() && (conv_input_stages_.count(call) ||
+                                (call->attrs.as<Conv2DAttrs>() && SupportsTextureStorage(call)))) {
+      const auto* input = call->args[0].as<CallNode>();
+      if (input != nullptr && IsConvInputStage(input)) conv_input_stages_.insert(input);
+    }
 
     for (auto& arg : call->args) {
       Visit(arg);
@@ -151,24 +307,31 @@ class StorageInfo : private ExprVisitor{
 
       bool expr_is_rgba_vectorizable = false;
       if (const auto* ttype = expr->checked_type().as<TensorTypeNode>()) {
-        if (ttype->shape.size() == 5) {
-          auto inner_dim = ttype->shape.back().as<IntImmNode>();
-          if (inner_dim && inner_dim->value == 4) {
-            expr_is_rgba_vectorizable = true;
-          }
+        if (ttype->shape.size() == 5 && IsTextureDataType(ttype->dtype)) {
+          expr_is_rgba_vectorizable = HasTexelInnerDim(ttype);
+        } else if (scope_suffix == "weight" && ttype->shape.size() >= 2 &&
+                   IsTextureDataType(ttype->dtype)) {
+          // Weights rewritten to the tile structure of the auto-scheduler have any rank, the
+          // layout rewrite packs their innermost axis into RGBA texels
+          const auto* inner_dim = ttype->shape.back().as<IntImmNode>();
+          expr_is_rgba_vectorizable = inner_dim && inner_dim->value == 4;
         }
       }
 
       // Only propagate texture scope from consumers to input expr if
-      // the input shape of the input expr is rgba vectorizable.
+      // the input shape of the input expr is vectorizable into texels.
       if (consumer_scope == "texture") {
+        std::string scope = consumer_scope;
+        // Apply any provided storage scope suffix before assignment
+        if (!scope_suffix.empty()) {
+          scope += (":" + scope_suffix);
+        }
         if (expr_is_rgba_vectorizable) {
-          std::string scope = consumer_scope;
-          // Apply any provided storage scope suffix before assignment
-          if (!scope_suffix.empty()) {
-            scope += (":" + scope_suffix);
+          scope = SelectTextureScope(GetRef<Expr>(expr), expr->checked_type().as<TensorTypeNode>(),
+                                     scope);
+          if (!scope.empty()) {
+            storage_scope_[expr].push_back(scope);
           }
-          storage_scope_[expr].push_back(scope);
         }
       } else {
         storage_scope_[expr].push_back(consumer_scope);
@@ -180,51 +343,52 @@ class StorageInfo : private ExprVisitor{
     for (auto& kv : consumer_storage_scopes_) {
       const ExprNode* producer = kv.first;
       std::string legal_scope = GetConsumerScope(kv.second);
-      if (storage_scope_.count(producer)) {
-        ICHECK(!HasMixedStorageOutputs(producer)) << "Mixed output storage scopes are not currently supported";
-        if (storage_scope_[producer][0].find(legal_scope) == std::string::npos) {
-          for (size_t i = 0; i < storage_scope_[producer].size(); i++) {
-            // Only support uniform storage scope accross all outputs for now
-            storage_scope_[producer][i] = legal_scope;
-          }
+      if (const auto* tuple_get_item = GetRef<Expr>(producer).as<TupleGetItemNode>()) {
+        // Only the consumed field of a tuple output is legalized
+        auto it = storage_scope_.find(Resolve(tuple_get_item->tuple.operator->()));
+        if (it != storage_scope_.end()) {
+          LegalizeScope(&it->second[tuple_get_item->index], legal_scope);
+        }
+      } else if (storage_scope_.count(producer)) {
+        for (auto& scope : storage_scope_[producer]) {
+          LegalizeScope(&scope, legal_scope);
         }
       }
     }
   }
 
-  void ForceGlobalOutputStorage(const Expr& expr) {
-    // Mark function outputs as global scope
-    if (const auto* func = expr.as<FunctionNode>()) {
-      if (auto* tuple = func->body.as<TupleNode>()) {
-        for (auto& field : tuple->fields) {
-          if (storage_scope_.count(field.operator->())) {
-            for (size_t i = 0; i < storage_scope_[field.operator->()].size(); i++) {
-              storage_scope_[field.operator->()][i] = "global";
-            }
-          }
-        }
-      } else {
-        if (storage_scope_.count(func->body.operator->())) {
-          for (size_t i = 0; i < storage_scope_[func->body.operator->()].size(); i++) {
-            storage_scope_[func->body.operator->()][i] = "global";
-          }
-        }
-      }
+  /*! \brief Follow let bound variables to the expression which produces their value */
+  const ExprNode* Resolve(const ExprNode* expr) const {
+    while (expr->IsInstance<VarNode>()) {
+      auto it = let_bindings_.find(static_cast<const VarNode*>(expr));
+      if (it == let_bindings_.end()) break;
+      expr = it->second;
     }
+    return expr;
   }
 
-  bool DeviceSupportsTextureStorage(const Expr& expr) {
+  static void LegalizeScope(std::string* scope, const std::string& legal_scope) {
+    // Outputs read from global memory by any consumer are demoted,
+    // outputs which were not assigned a texture are never promoted
+    if (legal_scope == "global") {
+      *scope = legal_scope;
+    }
+  }
+
+  Target GetTarget(const Expr& expr) {
     Target target;
-    Integer dev_id{-1};
     if (device_ids_.count(expr) && targets_.count(device_ids_[expr])) {
-      dev_id = device_ids_[expr];
-      target = targets_[dev_id];
+      target = targets_[device_ids_[expr]];
     } else if (targets_.size() == 1) {
-      const auto& kv = targets_.begin();
-      dev_id = (*kv).first;
-      target = (*kv).second;
+      target = (*targets_.begin()).second;
     }
-    ICHECK(dev_id->value != -1) << "Error inferring target device, device mapping and targets do not match";
+    return target;
+  }
+
+  bool DeviceSupportsTextureStorage(const Expr& expr) {
+    Target target = GetTarget(expr);
+    ICHECK(target.defined())
+        << "Error inferring target device, device mapping and targets do not match";
     Optional<String> t_device = target->GetAttr<String>("device");
     // Currently only `target = opencl --device=adreno` supports texture storage
     if (target->kind->device_type == kDLOpenCL && t_device.defined()) {
@@ -233,6 +397,86 @@ class StorageInfo : private ExprVisitor{
     return false;
   }
 
+  /*!
+   * \brief Whether the image holding the tensor with the given scope fits
+   *  within the texture_spatial_limit of the target.
+   */
+  bool FitsTexture(const Expr& expr, const TensorTypeNode* ttype, const std::string& scope) {
+    std::vector<int64_t> shape;
+    for (const auto& dim : ttype->shape) {
+      const auto* pval = dim.as<IntImmNode>();
+      if (pval == nullptr) return false;
+      shape.push_back(pval->value);
+    }
+    int64_t limit = 16384;
+    Target target = GetTarget(expr);
+    if (target.defined()) {
+      limit = target->GetAttr<Integer>("texture_spatial_limit").value_or(Integer(limit))->value;
+    }
+    // OpenCL guarantees image arrays of at least 2048 images
+    int64_t array_limit = 2048;
+    if (target.defined()) {
+      array_limit =
+          target->GetAttr<Integer>("texture_array_limit").value_or(Integer(array_limit))->value;
+    }
+    auto texture = runtime::ApplyTextureFlattening<int64_t>(shape, shape.size(), scope);
+    return texture.width <= limit && texture.height <= limit && texture.depth <= array_limit;
+  }
+
+  /*!
+   * \brief Select the texture layout convention of a tensor.
+   *
+   *  When the image of the preferred convention exceeds the spatial limit the tensor is
+   *  flattened around another axis instead: the conventions only differ in the axis
+   *  separating the image rows from its columns. As a last resort a tensor with batches is
+   *  held in an image array with one image per batch, which divides the image height.
+   *  Only constants fall back to the weight convention and only tensors which all consumers
+   *  read with NHWC convolutions to the NHWC one, the kernels of other consumers index their
+   *  images with the default convention.
+   *
+   * \return The first convention whose image fits, or an empty string if none does.
+   */
+  std::string SelectTextureScope(const Expr& expr, const TensorTypeNode* ttype,
+                                 const std::string& preferred) {
+    for (const std::string& scope :
+         {preferred, std::string("texture"), std::string("texture:nhwc"),
+          std::string("texture:weight"), std::string("texture:array")}) {
+      // An image array needs an axis for the images next to the rows and columns of the image
+      if (runtime::IsTextureArrayStorage(scope) && ttype->shape.size() < 4) continue;
+      if (scope == "texture:weight" && !expr.as<ConstantNode>()) continue;
+      if (scope == "texture:nhwc" && !ReadByNHWCConsumers(expr)) continue;
+      size_t axis = runtime::DefaultTextureLayoutSeparator(ttype->shape.size(), scope);
+      if (axis < ttype->shape.size() && FitsTexture(expr, ttype, scope)) {
+        return scope;
+      }
+    }
+    return "";
+  }
+
+  /*! \brief Whether the tensor is only read by primitives anchored on NHWC convolutions */
+  bool ReadByNHWCConsumers(const Expr& expr) const {
+    auto it = consumer_reads_nhwc_.find(Resolve(expr.operator->()));
+    if (it == consumer_reads_nhwc_.end() || it->second.empty()) return false;
+    return std::all_of(it->second.begin(), it->second.end(), [](bool nhwc) { return nhwc; });
+  }
+
+  /*!
+   * \brief Decide whether a primitive should produce the given texture outputs.
+   *  A cost model registered as relay.backend.opencl.adreno._TextureScopeCost
+   *  estimates the latency of the call for a list of output scopes, e.g. from
+   *  tuning logs; texture is kept unless it is estimated slower than global memory.
+   */
+  bool PreferTexture(const CallNode* call, const std::vector<std::string>& scopes) {
+    const PackedFunc* fcost =
+        runtime::Registry::Get("relay.backend.opencl.adreno._TextureScopeCost");
+    if (fcost == nullptr) return true;
+    Array<String> texture_scopes(scopes.begin(), scopes.end());
+    Array<String> global_scopes(std::vector<String>(scopes.size(), "global"));
+    double texture_cost = (*fcost)(GetRef<Call>(call), texture_scopes);
+    double global_cost = (*fcost)(GetRef<Call>(call), global_scopes);
+    return texture_cost <= global_cost;
+  }
+
   std::string GetConsumerScope(const std::vector<std::string>& consumer_scopes) const {
     if (!consumer_scopes.size()) { return "global"; }
     std::string ref_scope = consumer_scopes[0];
@@ -244,14 +488,35 @@ class StorageInfo : private ExprVisitor{
     return ref_scope;
   }
 
-  bool HasMixedStorageOutputs(const ExprNode* expr) {
-    if (storage_scope_.count(expr)) {
-      std::string ref_scope = storage_scope_[expr][0];
-      for (std::string& scope : storage_scope_[expr]) {
-        if (scope != ref_scope) {
-          return true;
-        }
+  /*!
+   * \brief Whether image2d has a channel type for the data type: float, half and
+   *  8, 16 or 32 bit integers as produced by lowered QNN primitives.
+   */
+  static bool IsTextureDataType(DataType dtype) {
+    if (dtype.is_float()) {
+      return dtype.bits() == 16 || dtype.bits() == 32;
+    }
+    if (dtype.is_int() || dtype.is_uint()) {
+      return dtype.bits() == 8 || dtype.bits() == 16 || dtype.bits() == 32;
+    }
+    return false;
+  }
+
+  /*! \brief Whether the innermost axis maps onto the R, RG or RGBA channels of a texel */
+  static bool HasTexelInnerDim(const TensorTypeNode* ttype) {
+    auto inner_dim = ttype->shape.back().as<IntImmNode>();
+    return inner_dim && (inner_dim->value == 1 || inner_dim->value == 2 || inner_dim->value == 4);
+  }
+
+  bool HasTextureDataType(const Type& type) const {
+    if (const auto* ttype = type.as<TensorTypeNode>()) {
+      return IsTextureDataType(ttype->dtype);
+    }
+    if (const auto* tuple_type = type.as<TupleTypeNode>()) {
+      for (const auto& field : tuple_type->fields) {
+        if (!HasTextureDataType(field)) return false;
       }
+      return true;
     }
     return false;
   }
@@ -259,6 +524,7 @@ class StorageInfo : private ExprVisitor{
   bool SupportsTextureStorage(const CallNode* call) const {
     bool supports_texture_storage = false;
     if (auto attrs = call->attrs.as<Conv2DAttrs>()) {
+      // Depthwise convolutions take the same layouts, their weights [C/4, 1, KH, KW, 4]
       if (attrs->data_layout == "NCHW4c" && attrs->kernel_layout == "OIHW4o") {
         supports_texture_storage = true;
       } else if (attrs->data_layout == "NHWC" && attrs->kernel_layout == "HWIO") {
@@ -276,11 +542,25 @@ class StorageInfo : private ExprVisitor{
       if (attrs->layout == "NCHW4c") {
         supports_texture_storage = true;
       }
+    } else if (call->attrs.as<ConcatenateAttrs>()) {
+      // With texture_concat the memory planner writes the inputs straight into the rows of
+      // the output texture, which the concatenation of NCHW4c textures then produces
+      const auto* ttype = call->checked_type().as<TensorTypeNode>();
+      supports_texture_storage = ConcatenatesTextures() && ttype != nullptr &&
+                                 ttype->shape.size() == 5 && HasTexelInnerDim(ttype);
     }
 
     return supports_texture_storage;
   }
 
+  /*! \brief Whether a target lets the inputs of concatenations alias their output texture. */
+  bool ConcatenatesTextures() const {
+    for (const auto& kv : targets_) {
+      if (kv.second->GetAttr<Bool>("texture_concat", Bool(false)).value()) return true;
+    }
+    return false;
+  }
+
   /*! \brief expr device mapping */
   Map<Expr, Integer> device_ids_;
   /*! \brief device id to target mapping  */
@@ -288,10 +568,19 @@ class StorageInfo : private ExprVisitor{
   /*! \brief Temporary state for marking whether a visited function
    *         primitive supports texture storage scope */
   bool primitive_supports_texture_ = false;
+  /*! \brief Temporary state for marking whether a visited function
+   *         primitive contains an NHWC texture convolution */
+  bool primitive_reads_nhwc_ = false;
   /*! \brief expr storage scope mapping for each output  */
   std::unordered_map<const ExprNode*, std::vector<std::string>> storage_scope_;
   /*! \brief output storage scopes used by consumers of expr key  */
   std::unordered_map<const ExprNode*, std::vector<std::string>> consumer_storage_scopes_;
+  /*! \brief whether each consumer of expr key is an NHWC convolution, as consumer scopes */
+  std::unordered_map<const ExprNode*, std::vector<bool>> consumer_reads_nhwc_;
+  /*! \brief the values of let bound variables */
+  std::unordered_map<const VarNode*, const ExprNode*> let_bindings_;
+  /*! \brief the producers computed by the input stage of the texture convolution they feed */
+  std::unordered_set<const CallNode*> conv_input_stages_;
 };
 
 String GetStorageScope(const Expr& expr, const Map<Expr, runtime::ADT>& storage_map, size_t output_index) {
@@ -367,9 +656,38 @@ Map<Expr, Array<String>> CollectTextureStorage(const Expr& expr,
   return StorageInfo::GetStorageMap(expr, dev_map, target_map);
 }
 
+bool TextureFusionPolicy(const Expr& anchor, const Expr& src, const Expr& sink) {
+  Target target = Target::Current(true);
+  ICHECK(target.defined()) << "The fusion policy is only applied under a target";
+  return StorageInfo::CountOutputConversions(anchor, sink, target) <=
+         StorageInfo::CountOutputConversions(anchor, src, target);
+}
+
+// Set when the texture convolution schedules inline the producers fused into their data stage.
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.texture_fuse_conv_input", Bool);
+
+bool TextureProducerFusionPolicy(const Expr& producer, const Expr& anchor) {
+  Target target = Target::Current(true);
+  ICHECK(target.defined()) << "The fusion policy is only applied under a target";
+  // A schedule which does not inline the fused producer would write the whole intermediate
+  // from every work item of the convolution.
+  if (!transform::PassContext::Current()
+           ->GetConfig<Bool>("relay.backend.texture_fuse_conv_input", Bool(false))
+           .value()) {
+    return false;
+  }
+  return StorageInfo::CanFuseProducer(producer, anchor, target);
+}
+
 TVM_REGISTER_GLOBAL("relay.backend.opencl.adreno._CollectStorageInfo").set_body_typed(CollectTextureStorage);
 
 TVM_REGISTER_GLOBAL("relay.backend.opencl.adreno._CollectBufferBinds").set_body_typed(CollectBufferBinds);
 
+TVM_REGISTER_GLOBAL("relay.backend.opencl.adreno._FusionPolicy")
+    .set_body_typed(TextureFusionPolicy);
+
+TVM_REGISTER_GLOBAL("relay.backend.opencl.adreno._ProducerFusionPolicy")
+    .set_body_typed(TextureProducerFusionPolicy);
+
 }  // namespace relay
 }  // namespace tvm
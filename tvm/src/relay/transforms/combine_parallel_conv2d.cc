@@ -30,6 +30,14 @@
  *
  * This prevents launching multiple kernels in networks with multiple
  * convolution branches, such as Inception block.
+ *
+ * Channel packed layouts, e.g. NCHW4c with OIHW4o weights, are combined along
+ * the outer channel axis, so every branch is a block of whole packed channels
+ * of the combined output. When compiling for Adreno texture storage, convolutions
+ * in unpacked layouts are only combined if their output channels are a multiple
+ * of the texel width. The slices of the branches then stay on texel boundaries
+ * once AlterOpLayout packs the combined convolution, and are fused into the
+ * consumers of every branch instead of being materialized.
  */
 
 #include <tvm/relay/analysis.h>
@@ -38,6 +46,7 @@
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/relay/transform.h>
+#include <tvm/target/target.h>
 
 #include <unordered_map>
 #include <unordered_set>
@@ -52,10 +61,18 @@ namespace relay {
 class ParallelConv2DCombiner : public ParallelOpCombiner {
  public:
   explicit ParallelConv2DCombiner(uint64_t min_num_branches)
-      : ParallelOpCombiner("nn.conv2d", min_num_branches) {}
+      : ParallelOpCombiner("nn.conv2d", min_num_branches), channel_block_(GetChannelBlock()) {}
 
  protected:
-  bool IsSupportedOp(const CallNode* n) { return n->attrs.as<Conv2DAttrs>()->groups == 1; }
+  bool IsSupportedOp(const CallNode* n) {
+    const auto* attrs = n->attrs.as<Conv2DAttrs>();
+    if (attrs->groups != 1) return false;
+    // Keep the branches of unpacked convolutions aligned to the channel block they are packed to.
+    if (channel_block_ > 1 && !Layout(attrs->kernel_layout).Contains(LayoutAxis::Get('o'))) {
+      return GetConv2DSuperChannelsDim(n) % channel_block_ == 0;
+    }
+    return true;
+  }
 
   bool CanOpsBeCombined(const CallNode* a, const CallNode* b) {
     StructuralEqual eq;
@@ -186,6 +203,18 @@ class ParallelConv2DCombiner : public ParallelOpCombiner {
  private:
   /* \brief index of channel dimension */
   size_t channel_pos_;
+  /* \brief the number of channels packed together by the target, 1 if they are not packed */
+  int64_t channel_block_;
+
+  static int64_t GetChannelBlock() {
+    // Texture storage packs 4 channels in the RGBA components of a texel.
+    Target target = Target::Current(true);
+    if (target.defined() && target->kind->name == "opencl" &&
+        target->GetAttr<String>("device").value_or("") == "adreno") {
+      return 4;
+    }
+    return 1;
+  }
 
   std::tuple<Expr, IndexExpr> TransformWeight(const Group& branches) {
     int64_t num_filters = 0;  // number of filters of the transformed weight
@@ -196,9 +225,14 @@ class ParallelConv2DCombiner : public ParallelOpCombiner {
       auto channels = GetConv2DSuperChannelsDim(conv2d);
       num_filters += channels;
     }
-    auto index =
-        branches[0][0]->attrs.as<Conv2DAttrs>()->kernel_layout.operator std::string().find('O');
+    const auto& kernel_layout = branches[0][0]->attrs.as<Conv2DAttrs>()->kernel_layout;
+    auto index = kernel_layout.operator std::string().find('O');
     ICHECK_NE(index, std::string::npos);
+    // The channels attribute counts the output channels of all the packed blocks.
+    int32_t factor = Layout(kernel_layout).FactorOf(LayoutAxis::Get('O'));
+    if (factor > 0) {
+      num_filters *= factor;
+    }
     return std::make_tuple(MakeConcatenate(Tuple(weights), index),
                            tir::make_const(DataType::Int(32), num_filters));
   }
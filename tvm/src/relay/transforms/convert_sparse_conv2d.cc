@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ *
+ * \file convert_sparse_conv2d.cc
+ *
+ * \brief Mutate 1x1 conv2d operators in NHWC layout to sparse dense operators.
+ *
+ * A 1x1 convolution with unit strides and no padding is a dense layer on the pixels:
+ * the NHWC input is reshaped to (N * H * W, C), multiplied by the transposed (O, C)
+ * weight matrix in BSR format, and reshaped back to (N, H, W, O). The converted layers
+ * only read the non-zero blocks of pruned weights. Convolutions in other layouts can be
+ * converted to NHWC with ConvertLayout beforehand.
+ */
+#include <tvm/ir/expr.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/transform.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pattern_utils.h"
+
+namespace tvm {
+namespace relay {
+
+/*! \brief Whether a conv2d is a 1x1 NHWC convolution which can be computed as a sparse dense */
+static bool IsSparseConvertibleConv2D(const CallNode* call) {
+  const auto* attrs = call->attrs.as<Conv2DAttrs>();
+  ICHECK(attrs);
+  auto is_one = [](const PrimExpr& e) { return tir::is_const_int(e, 1); };
+  auto is_zero = [](const PrimExpr& e) { return tir::is_const_int(e, 0); };
+  if (attrs->data_layout != "NHWC" || (attrs->out_layout != "" && attrs->out_layout != "NHWC") ||
+      attrs->groups != 1 || !call->args[1].as<VarNode>()) {
+    return false;
+  }
+  if (attrs->kernel_size.defined() &&
+      !std::all_of(attrs->kernel_size.begin(), attrs->kernel_size.end(), is_one)) {
+    return false;
+  }
+  const auto* data = call->args[0]->checked_type_.as<TensorTypeNode>();
+  const auto* weight = call->args[1]->checked_type_.as<TensorTypeNode>();
+  if (data == nullptr || weight == nullptr ||
+      (!attrs->out_dtype.is_void() && attrs->out_dtype != data->dtype)) {
+    return false;
+  }
+  Layout kernel_layout(attrs->kernel_layout);
+  int h_axis = kernel_layout.IndexOf(LayoutAxis::Get('H'));
+  int w_axis = kernel_layout.IndexOf(LayoutAxis::Get('W'));
+  if (h_axis < 0 || w_axis < 0 || !is_one(weight->shape[h_axis]) ||
+      !is_one(weight->shape[w_axis])) {
+    return false;
+  }
+  return std::all_of(attrs->strides.begin(), attrs->strides.end(), is_one) &&
+         std::all_of(attrs->dilation.begin(), attrs->dilation.end(), is_one) &&
+         std::all_of(attrs->padding.begin(), attrs->padding.end(), is_zero);
+}
+
+// Search the weight names of the convertible conv2d ops from Expr
+class Conv2dOpWeightVisitor : private ExprVisitor {
+ public:
+  Conv2dOpWeightVisitor() : conv2d_op_(Op::Get("nn.conv2d")) {}
+
+  Array<String> Search(const Expr& expr) {
+    VisitExpr(expr);
+    return memo_;
+  }
+
+ private:
+  void VisitExpr_(const CallNode* n) final {
+    if (n->op == conv2d_op_ && IsSparseConvertibleConv2D(n)) {
+      memo_.push_back(n->args[1].as<VarNode>()->name_hint());
+    }
+    for (const auto& arg : n->args) {
+      VisitExpr(arg);
+    }
+  }
+  // Cache op
+  const Op& conv2d_op_;
+
+  Array<String> memo_;
+};  // SearchConv2dOpWeight
+
+Array<String> SearchConv2dOpWeight(const Expr& e) { return Conv2dOpWeightVisitor().Search(e); }
+
+TVM_REGISTER_GLOBAL("relay.analysis.search_conv2d_op_weight").set_body_typed(SearchConv2dOpWeight);
+
+// Mutate 1x1 ```nn.conv2d``` to ```nn.sparse_dense```
+class Conv2dToSparseDenseMutator : public ExprRewriter {
+ public:
+  Conv2dToSparseDenseMutator(const Array<ObjectRef>& weight_name,
+                             const Array<Array<PrimExpr> >& weight_shape)
+      : conv2d_op_(Op::Get("nn.conv2d")), sparse_dense_op_(Op::Get("nn.sparse_dense")) {
+    ICHECK_EQ(weight_name.size(), weight_shape.size());
+    for (size_t i = 0; i < weight_name.size(); ++i) {
+      ICHECK(weight_name[i]->IsInstance<runtime::StringObj>());
+      std::string k = weight_name[i].as<runtime::StringObj>()->data;
+      const auto& ws = weight_shape[i];
+      ICHECK_EQ(ws.size(), 5) << "Expected the BSR shapes (blocks, bs_r, bs_c, indices, indptr)";
+      std::vector<int> v(ws.size());
+      for (size_t j = 0; j < ws.size(); ++j) {
+        v[j] = ws[j].as<IntImmNode>()->value;
+      }
+      target_weights_.emplace(k, v);
+    }
+  }
+
+  Expr Rewrite_(const CallNode* pre, const Expr& post) override {
+    if (pre->op != conv2d_op_ || !IsSparseConvertibleConv2D(pre)) {
+      return post;
+    }
+    const auto& prefix = pre->args[1].as<VarNode>()->name_hint();
+    if (!target_weights_.count(prefix)) {
+      return post;
+    }
+    const auto& ws = target_weights_.at(prefix);
+    const auto* ttype = pre->checked_type().as<TensorTypeNode>();
+    const auto* data_type = pre->args[0]->checked_type().as<TensorTypeNode>();
+    Array<Integer> out_shape;
+    for (const auto& dim : ttype->shape) {
+      const auto* imm = dim.as<IntImmNode>();
+      if (imm == nullptr) return post;
+      out_shape.push_back(imm->value);
+    }
+    const auto* in_channels = data_type->shape[3].as<IntImmNode>();
+    if (in_channels == nullptr) return post;
+
+    auto ws_data_type = relay::TensorType({ws.at(0), ws.at(1), ws.at(2)}, data_type->dtype);
+    auto ws_indices_type = relay::TensorType({ws.at(3)}, DataType::Int(32));
+    auto ws_indptr_type = relay::TensorType({ws.at(4)}, DataType::Int(32));
+    Var weight_data(prefix + ".data", ws_data_type);
+    Var weight_indices(prefix + ".indices", ws_indices_type);
+    Var weight_indptr(prefix + ".indptr", ws_indptr_type);
+    auto attrs = make_object<SparseDenseAttrs>();
+
+    const auto data = post.as<CallNode>()->args[0];
+    Expr pixels = Reshape(data, {Integer(-1), Integer(in_channels->value)});
+    Expr dense = Call(sparse_dense_op_, {pixels, weight_data, weight_indices, weight_indptr},
+                      Attrs(attrs));
+    return Reshape(dense, out_shape);
+  }
+
+ private:
+  // Cached op
+  const Op& conv2d_op_;
+  const Op& sparse_dense_op_;
+  std::unordered_map<std::string, std::vector<int> > target_weights_;
+};  // class Conv2dToSparseDenseMutator
+
+Expr Conv2dToSparse(const Expr& e, const Array<ObjectRef>& weight_name,
+                    const Array<Array<PrimExpr> >& weight_shape) {
+  auto rewriter = Conv2dToSparseDenseMutator(weight_name, weight_shape);
+  return PostOrderRewrite(e, &rewriter);
+}
+
+namespace transform {
+
+Pass Conv2dToSparse(const Array<ObjectRef>& weight_name,
+                    const Array<Array<PrimExpr> >& weight_shape) {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        // Remove FreeVar warnings
+        auto f0 = Downcast<Function>(Conv2dToSparse(f, weight_name, weight_shape));
+        Array<Var> sparse_params = FreeVars(f0);
+        auto f1 = Function(sparse_params, f0->body, f0->ret_type, f0->type_params, f0->attrs);
+        Array<Var> params = FreeVars(f1);
+        for (const auto& var : sparse_params) {
+          params.push_back(var);
+        }
+        return Function(params, f1->body, f1->ret_type, f1->type_params, f1->attrs);
+      };
+  return CreateFunctionPass(pass_func, 4, "Conv2dToSparse",
+                            {"InferType", "DeadCodeElimination"});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.Conv2dToSparse").set_body_typed(Conv2dToSparse);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
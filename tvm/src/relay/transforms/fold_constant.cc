@@ -31,6 +31,10 @@
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/object.h>
 
+#include <unordered_map>
+#include <vector>
+
+#include "../backend/compile_engine.h"
 #include "pattern_utils.h"
 
 namespace tvm {
@@ -199,10 +203,23 @@ class ConstantFolder : public MixedModeMutator {
   }
 
  private:
+  /*! \brief A compiled op evaluating calls with the same signature */
+  struct OpEvaluator {
+    /*! \brief The kernel, nullptr if the calls need the interpreter */
+    PackedFunc packed_func;
+    /*! \brief The output types of the kernel */
+    Array<Type> out_types;
+    /*! \brief Whether the op returns a tuple */
+    bool tuple_output{false};
+  };
+
   // Internal constant checker
   ConstantChecker checker_;
   // Module
   IRModule module_;
+  // The compiled ops indexed by the signature of the calls, i.e. a function calling the op with
+  // the same attributes on parameters of the types of the constant arguments
+  std::unordered_map<Function, OpEvaluator, StructuralHash, StructuralEqual> op_evaluators_;
 
   // Cache the following ops for equivalence checking in this pass.
   const Op& device_copy_op_;
@@ -228,8 +245,122 @@ class ConstantFolder : public MixedModeMutator {
       return Expr();
     }
   }
+  /*!
+   * \brief Evaluate a call to an op whose arguments are all constants with a compiled kernel,
+   *  which is shared by all the calls with the same signature. This avoids creating a module
+   *  and an interpreter for every folded call.
+   * \return The folded value, undefined if the call has to be evaluated by the interpreter.
+   */
+  Optional<Expr> EvaluateOpCall(const Expr& expr) {
+    static auto fstrategy = Op::GetAttrMap<FTVMStrategy>("FTVMStrategy");
+    const auto* call = expr.as<CallNode>();
+    // Ops without a strategy, e.g. annotations, are handled by the interpreter.
+    if (call == nullptr || !call->op.as<OpNode>() || !fstrategy.count(Downcast<Op>(call->op))) {
+      return NullOpt;
+    }
+    // Flatten the constant arguments, tuple arguments are passed field by field.
+    std::vector<runtime::NDArray> inputs;
+    Array<Var> params;
+    auto add_constant = [&inputs](const Expr& arg) {
+      const auto* constant = arg.as<ConstantNode>();
+      if (constant == nullptr || constant->data->ctx.device_type != kDLCPU) return false;
+      inputs.push_back(constant->data);
+      return true;
+    };
+    for (const Expr& arg : call->args) {
+      if (const auto* tuple = arg.as<TupleNode>()) {
+        Array<Type> fields;
+        for (const Expr& field : tuple->fields) {
+          if (!add_constant(field)) return NullOpt;
+          fields.push_back(field.as<ConstantNode>()->tensor_type());
+        }
+        params.push_back(Var("p" + std::to_string(params.size()), TupleType(fields)));
+      } else {
+        if (!add_constant(arg)) return NullOpt;
+        params.push_back(
+            Var("p" + std::to_string(params.size()), arg.as<ConstantNode>()->tensor_type()));
+      }
+    }
+    Function signature(params, Call(call->op, Array<Expr>(params.begin(), params.end()),
+                                    call->attrs, call->type_args),
+                       Type(), {});
+    auto it = op_evaluators_.find(signature);
+    if (it == op_evaluators_.end()) {
+      it = op_evaluators_.emplace(signature, CompileOpEvaluator(signature)).first;
+    }
+    const OpEvaluator& evaluator = it->second;
+    if (evaluator.packed_func == nullptr) return NullOpt;
+
+    DLContext ctx;
+    ctx.device_type = kDLCPU;
+    ctx.device_id = 0;
+    size_t num_args = inputs.size() + evaluator.out_types.size();
+    std::vector<TVMValue> values(num_args);
+    std::vector<int> codes(num_args);
+    runtime::TVMArgsSetter setter(values.data(), codes.data());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      setter(i, inputs[i]);
+    }
+    std::vector<runtime::NDArray> outputs;
+    for (const Type& out_type : evaluator.out_types) {
+      const auto* ttype = out_type.as<TensorTypeNode>();
+      std::vector<int64_t> shape;
+      for (const auto& dim : ttype->shape) {
+        shape.push_back(Downcast<IntImm>(dim)->value);
+      }
+      outputs.push_back(runtime::NDArray::Empty(shape, ttype->dtype, ctx));
+      setter(inputs.size() + outputs.size() - 1, outputs.back());
+    }
+    TVMRetValue rv;
+    evaluator.packed_func.CallPacked(TVMArgs(values.data(), codes.data(), num_args), &rv);
+    if (!evaluator.tuple_output) {
+      return Expr(Constant(outputs[0]));
+    }
+    Array<Expr> fields;
+    for (const auto& output : outputs) {
+      fields.push_back(Constant(output));
+    }
+    return Expr(Tuple(fields));
+  }
+
+  /*!
+   * \brief Compile the kernel of an op signature.
+   * \return The evaluator, without kernel when the output shape is not static.
+   */
+  OpEvaluator CompileOpEvaluator(const Function& signature) {
+    OpEvaluator evaluator;
+    auto mod = IRModule({}, module_->type_definitions, module_->Imports());
+    mod->Add(GlobalVar("main"), signature);
+    mod = transform::InferType()(mod);
+    Function func = Downcast<Function>(mod->Lookup("main"));
+    Array<Type> out_types;
+    if (const auto* tuple_type = func->body->checked_type().as<TupleTypeNode>()) {
+      out_types = tuple_type->fields;
+      evaluator.tuple_output = true;
+    } else {
+      out_types.push_back(func->body->checked_type());
+    }
+    for (const Type& out_type : out_types) {
+      const auto* ttype = out_type.as<TensorTypeNode>();
+      if (ttype == nullptr) return evaluator;
+      for (const auto& dim : ttype->shape) {
+        if (!dim->IsInstance<IntImmNode>()) return evaluator;
+      }
+    }
+    func = WithAttr(std::move(func), attr::kPrimitive, Integer(1));
+    // use a fresh build context in case we are already in a build context.
+    using tvm::transform::PassContext;
+    With<PassContext> fresh_build_ctx(PassContext::Create());
+    evaluator.packed_func = CompileEngine::Global()->JIT(CCacheKey(func, Target("llvm")));
+    evaluator.out_types = out_types;
+    return evaluator;
+  }
+
   // Constant evaluate an expression.
   Expr ConstEvaluate(Expr expr) {
+    if (Optional<Expr> value = EvaluateOpCall(expr)) {
+      return value.value();
+    }
     std::vector<transform::Pass> passes = {transform::FuseOps(0), transform::ToANormalForm(),
                                            transform::InferType()};
     Function func;
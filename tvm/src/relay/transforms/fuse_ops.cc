@@ -28,6 +28,8 @@
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
 #include <tvm/tir/op.h>
 
 #include "../../support/arena.h"
@@ -75,6 +77,18 @@ namespace relay {
       will still run correctly.
   - CommitFuse: mark all the nodes between source and post-dominator as the same group.
   - We use an Union-Find data structure to manage the groups.
+
+  A target can register a fusion policy as relay.backend.<target kind>[.<device>]._FusionPolicy,
+  which is asked before a group with an anchor op (e.g. conv2d) is extended to a post-dominator.
+  It receives the anchor, the current output of the group and the output of the extended group,
+  and can refuse fusions whose output is more expensive for the target, e.g. an output which
+  would be stored in global memory instead of a texture.
+
+  A target can also register relay.backend.<target kind>[.<device>]._ProducerFusionPolicy to
+  fuse an elementwise, broadcast or injective producer into the anchor op reading it, which is
+  not done by default. It
+  receives the producer and the anchor, e.g. a resize and the conv2d whose input stage can read
+  the texture before the resize, so that the upsampled tensor is never written.
 */
 using support::LinkedList;
 using support::LinkNode;
@@ -507,8 +521,14 @@ DominatorTree DominatorTree::PostDom(support::Arena* arena, const IndexedForward
  */
 class GraphPartitioner {
  public:
-  explicit GraphPartitioner(support::Arena* arena, int opt_level, size_t max_fuse_depth)
-      : arena_(arena), opt_level_(opt_level), max_fuse_depth_(max_fuse_depth) {}
+  explicit GraphPartitioner(support::Arena* arena, int opt_level, size_t max_fuse_depth,
+                            const PackedFunc* fuse_policy = nullptr,
+                            const PackedFunc* producer_policy = nullptr)
+      : arena_(arena),
+        opt_level_(opt_level),
+        max_fuse_depth_(max_fuse_depth),
+        fuse_policy_(fuse_policy),
+        producer_policy_(producer_policy) {}
   /*!
    * \brief Group as a union find data structure.
    */
@@ -562,6 +582,10 @@ class GraphPartitioner {
   int opt_level_;
   /*! \brief The maximum number of operations in one fused function */
   size_t max_fuse_depth_;
+  /*! \brief The fusion policy of the target, nullptr if there is none */
+  const PackedFunc* fuse_policy_;
+  /*! \brief The producer fusion policy of the target, nullptr if there is none */
+  const PackedFunc* producer_policy_;
   /*! \brief The internal groups. */
   std::vector<Group*> groups_;
   /*! \brief internal field used for deduplication */
@@ -656,6 +680,38 @@ class GraphPartitioner {
     CommitFuse_(src, sink, target);
   }
 
+  /*!
+   * \brief Ask the fusion policy of the target whether the group of src can be extended to sink.
+   *  Only groups with an anchor op are checked, the output of the group moves from src to sink.
+   */
+  bool PolicyAllowsFuse(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink) {
+    if (fuse_policy_ == nullptr) return true;
+    const tvm::Object* anchor_ref = groups_[src->index]->FindRoot()->anchor_ref;
+    if (anchor_ref == nullptr || src->ref == nullptr || sink->ref == nullptr) return true;
+    TVMRetValue allow = (*fuse_policy_)(GetRef<ObjectRef>(anchor_ref),
+                                        GetRef<ObjectRef>(src->ref), GetRef<ObjectRef>(sink->ref));
+    // A policy returning None has no opinion, the fusion is done as without a policy
+    return allow.type_code() == kTVMNullptr || static_cast<bool>(allow);
+  }
+
+  /*!
+   * \brief Ask the producer fusion policy of the target whether a node can be fused into the
+   *  anchor op which is its only consumer.
+   */
+  bool PolicyAllowsProducerFuse(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink) {
+    if (producer_policy_ == nullptr || src->ref == nullptr || sink->ref == nullptr) return false;
+    if (src->outputs.head == nullptr || src->outputs.head->next != nullptr ||
+        src->outputs.head->value.node != sink) {
+      return false;
+    }
+    Group* sink_group = groups_[sink->index]->FindRoot();
+    if (sink_group->anchor_ref != sink->ref) return false;
+    TVMRetValue allow =
+        (*producer_policy_)(GetRef<ObjectRef>(src->ref), GetRef<ObjectRef>(sink->ref));
+    // A policy returning None has no opinion, producers are not fused without a policy
+    return allow.type_code() != kTVMNullptr && static_cast<bool>(allow);
+  }
+
   size_t CountNodesUptoSink_(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink) {
     if (src == sink || visited_.count(src)) return 0;
     visited_.insert(src);
@@ -729,7 +785,8 @@ class GraphPartitioner {
           auto fcond = [](OpPatternKind kind, bool is_sink) { return kind <= kInjective; };
           // dom_root_group can also be tuple, as in inception layers
           // CheckPath is needed to avoid fusing two intermediate tuples
-          if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+          if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+              PolicyAllowsFuse(graph_node, dom_node->parent->gnode)) {
             CommitFuse(graph_node, dom_node->parent->gnode);
           }
         }
@@ -752,7 +809,8 @@ class GraphPartitioner {
           ICHECK(dom_node->parent->gnode != nullptr);
           // The fuse can be executed if all the intermediate ops are still broadcast.
           auto fcond = [](OpPatternKind kind, bool is_sink) { return kind <= kBroadcast; };
-          if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+          if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+              PolicyAllowsFuse(graph_node, dom_node->parent->gnode)) {
             CommitFuse(graph_node, dom_node->parent->gnode);
           }
         }
@@ -772,9 +830,13 @@ class GraphPartitioner {
                       kind == kOutEWiseFusable);
             }
           };
-          if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+          if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+              PolicyAllowsFuse(graph_node, dom_node->parent->gnode)) {
             CommitFuse(graph_node, dom_node->parent->gnode);
           }
+        } else if (phase == 1 && PolicyAllowsProducerFuse(graph_node, dom_node->parent->gnode)) {
+          // Producers are fused into anchor ops once these have fused their outputs
+          CommitFuse(graph_node, dom_node->parent->gnode);
         }
       } else if (group_node->pattern == kInjective || group_node->pattern == kTuple) {
         // defer injective fusion to second phase.
@@ -782,7 +844,11 @@ class GraphPartitioner {
         if (phase != 1) continue;
         // Check if all path are injective.
         auto fcond = [](OpPatternKind kind, bool is_sink) { return kind <= kInjective; };
-        if (CheckPath(graph_node, dom_node->parent->gnode, fcond)) {
+        if (CheckPath(graph_node, dom_node->parent->gnode, fcond) &&
+            PolicyAllowsFuse(graph_node, dom_node->parent->gnode)) {
+          CommitFuse(graph_node, dom_node->parent->gnode);
+        } else if (group_node->pattern == kInjective &&
+                   PolicyAllowsProducerFuse(graph_node, dom_node->parent->gnode)) {
           CommitFuse(graph_node, dom_node->parent->gnode);
         }
       } else {
@@ -809,10 +875,14 @@ std::vector<GraphPartitioner::Group*> GraphPartitioner::Partition(
 class FuseMutator : private MixedModeMutator {
  public:
   // Run the transform
-  Expr Transform(const Expr& body, int fuse_opt_level, size_t max_fuse_depth) {
+  Expr Transform(const Expr& body, int fuse_opt_level, size_t max_fuse_depth,
+                 const PackedFunc* fuse_policy = nullptr,
+                 const PackedFunc* producer_policy = nullptr) {
     // setup the group map.
     auto graph = IndexedForwardGraph::Create(&arena_, body);
-    auto groups = GraphPartitioner(&arena_, fuse_opt_level, max_fuse_depth).Partition(graph);
+    auto groups = GraphPartitioner(&arena_, fuse_opt_level, max_fuse_depth, fuse_policy,
+                                   producer_policy)
+                      .Partition(graph);
     for (size_t nid = 0; nid < graph.post_dfs_order.size(); ++nid) {
       ICHECK(graph.post_dfs_order[nid]->ref != nullptr);
       gmap_[graph.post_dfs_order[nid]->ref] = groups[nid];
@@ -991,8 +1061,25 @@ class FuseMutator : private MixedModeMutator {
   }
 };
 
+/*!
+ * \brief Get a fusion policy registered for the current target.
+ * \param name The name of the policy, e.g. _FusionPolicy.
+ * \return The policy, nullptr if there is no current target or it has no policy.
+ */
+static const PackedFunc* GetFusionPolicy(const std::string& name) {
+  Target target = Target::Current(true);
+  if (!target.defined()) return nullptr;
+  std::string fpolicy_name = "relay.backend." + target->kind->name;
+  if (Optional<String> t_device = target->GetAttr<String>("device")) {
+    fpolicy_name += ("." + t_device.value());
+  }
+  return runtime::Registry::Get(fpolicy_name + "." + name);
+}
+
 Expr FuseOps(const Expr& expr, int fuse_opt_level, size_t max_fuse_depth, const IRModule& module) {
-  return FuseMutator().Transform(expr, fuse_opt_level, max_fuse_depth);
+  return FuseMutator().Transform(expr, fuse_opt_level, max_fuse_depth,
+                                 GetFusionPolicy("_FusionPolicy"),
+                                 GetFusionPolicy("_ProducerFusionPolicy"));
 }
 
 namespace transform {
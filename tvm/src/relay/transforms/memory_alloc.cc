@@ -36,11 +36,15 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "../backend/compile_engine.h"
+#include "../backend/utils.h"
 #include "../op/memory/memory.h"
 #include "../op/vm/vm.h"
 #include "let_list.h"
@@ -99,10 +103,87 @@ bool IsReshapeOnly(const Expr& expr) {
   return check.reshape_only;
 }
 
+/*!
+ * \brief Find the outputs of primitive calls which are used other than as tensor
+ *  arguments of primitive calls in the same function, e.g. returned, put into an
+ *  ADT or captured by a closure. Such outputs are read by code which does not know
+ *  their storage scope and are kept in global memory.
+ */
+class StorageScopeEscapes : public ExprVisitor {
+ public:
+  explicit StorageScopeEscapes(const Function& func) { this->VisitExpr(func->body); }
+
+  /*! \brief Whether the output `index` of a primitive call escapes. */
+  bool Escapes(const CallNode* call, int index) const {
+    auto it = bound_vars_.find(call);
+    if (it == bound_vars_.end() || escaped_.count(it->second)) return true;
+    auto pit = projections_.find({it->second, index});
+    if (pit != projections_.end()) {
+      for (const VarNode* var : pit->second) {
+        if (escaped_.count(var)) return true;
+      }
+    }
+    return false;
+  }
+
+  void VisitExpr_(const LetNode* ln) final {
+    Expr body = GetRef<Expr>(ln);
+    while (const auto* let = body.as<LetNode>()) {
+      if (const auto* call = let->value.as<CallNode>()) {
+        bound_vars_[call] = let->var.get();
+      }
+      // Projections of a tuple escape through their own variables
+      const auto* get = let->value.as<TupleGetItemNode>();
+      if (get && get->tuple.as<VarNode>()) {
+        projections_[{get->tuple.as<VarNode>(), get->index}].push_back(let->var.get());
+      } else {
+        this->VisitExpr(let->value);
+      }
+      body = let->body;
+    }
+    this->VisitExpr(body);
+  }
+
+  void VisitExpr_(const CallNode* cn) final {
+    const auto* fn = cn->op.as<FunctionNode>();
+    if (fn && fn->HasNonzeroAttr(attr::kPrimitive) && !in_closure_) {
+      for (const auto& arg : cn->args) {
+        if (!arg.as<VarNode>() || !arg->checked_type_.as<TensorTypeNode>()) {
+          this->VisitExpr(arg);
+        }
+      }
+      return;
+    }
+    ExprVisitor::VisitExpr_(cn);
+  }
+
+  void VisitExpr_(const FunctionNode* fn) final {
+    if (fn->HasNonzeroAttr(attr::kPrimitive)) return;
+    bool in_closure = in_closure_;
+    in_closure_ = true;
+    ExprVisitor::VisitExpr_(fn);
+    in_closure_ = in_closure;
+  }
+
+  void VisitExpr_(const VarNode* vn) final { escaped_.insert(vn); }
+
+ private:
+  bool in_closure_{false};
+  std::unordered_map<const CallNode*, const VarNode*> bound_vars_;
+  std::map<std::pair<const VarNode*, int>, std::vector<const VarNode*>> projections_;
+  std::unordered_set<const VarNode*> escaped_;
+};
+
 class DialectRewriter : public ExprMutator {
  public:
-  DialectRewriter(const Target& target_host, const AnalysisResultMap& context_analysis_map)
-      : target_host_(target_host), context_analysis_map_(context_analysis_map) {}
+  DialectRewriter(const Target& target_host, const AnalysisResultMap& context_analysis_map,
+                  const Map<Integer, Target>& targets,
+                  const Map<Expr, Array<String>>& storage_scopes, const Function& func)
+      : target_host_(target_host),
+        context_analysis_map_(context_analysis_map),
+        targets_(targets),
+        storage_scopes_(storage_scopes),
+        escapes_(func) {}
 
   // Get the context of an expression.
   TVMContext GetContext(const Expr& expr) const {
@@ -163,6 +244,11 @@ class DialectRewriter : public ExprMutator {
       Type ret_type = cn->checked_type_;
       std::vector<TensorType> out_types = FlattenTupleType(ret_type);
 
+      std::vector<String> out_scopes;
+      for (size_t i = 0; i < out_types.size(); ++i) {
+        out_scopes.push_back(GetStorageScope(cn, i));
+      }
+
       // Handle fused op that only contains reshape op
       if (IsReshapeOnly(cn->op)) {
         Function func = Downcast<Function>(cn->op);
@@ -184,13 +270,14 @@ class DialectRewriter : public ExprMutator {
         return DeviceCopy(new_args[0], copy_attr->src_dev_type, copy_attr->dst_dev_type);
       } else if (IsDynamic(ret_type)) {
         Function func = Downcast<Function>(cn->op);
-        return DynamicInvoke(&scope, func, ins, new_args, out_types, ret_type);
+        return DynamicInvoke(&scope, func, ins, new_args, out_types, out_scopes, ret_type);
       } else {
         // Handle the static case
         Array<Expr> outs;
         for (size_t i = 0; i < out_types.size(); ++i) {
           TVMContext ctx = GetContext(GetRef<Call>(cn));
-          auto out = MakeStaticAllocation(&scope, out_types[i], ctx, std::to_string(i));
+          auto out =
+              MakeStaticAllocation(&scope, out_types[i], ctx, std::to_string(i), out_scopes[i]);
           outs.push_back(out);
         }
         Tuple output(outs);
@@ -210,6 +297,20 @@ class DialectRewriter : public ExprMutator {
     return ExprMutator::Mutate(relay::DeviceCopy(inp, src_ctx, dst_ctx));
   }
 
+  // Get the storage scope of an output of a primitive call.
+  String GetStorageScope(const CallNode* call, size_t index) const {
+    auto it = storage_scopes_.find(GetRef<Call>(call));
+    if (it == storage_scopes_.end() || index >= (*it).second.size()) return "global";
+    // Scopes only apply to the devices of the targets which assigned them
+    int device_type = GetContext(GetRef<Call>(call)).device_type;
+    bool has_target = false;
+    for (const auto& kv : targets_) {
+      has_target |= kv.first->value == device_type;
+    }
+    if (!has_target || escapes_.Escapes(call, static_cast<int>(index))) return "global";
+    return (*it).second[index];
+  }
+
   // Check if a call invokes a primitive function.
   bool IsPrimitive(const CallNode* call) const {
     if (const auto* fn = call->op.as<FunctionNode>()) {
@@ -263,7 +364,7 @@ class DialectRewriter : public ExprMutator {
 
   // Allocate a tensor with a statically known shape.
   Var MakeStaticAllocation(LetList* scope, const TensorType& type, TVMContext ctx,
-                           String name_hint) {
+                           String name_hint, String storage_scope = "global") {
     std::vector<int64_t> int_shape;
     for (auto it : type->shape) {
       const auto* imm = it.as<IntImmNode>();
@@ -275,7 +376,7 @@ class DialectRewriter : public ExprMutator {
     Expr alignment = ComputeAlignment(type->dtype);
     // Run type inference later to get the correct type.
     Var var("storage_" + name_hint, Type(nullptr));
-    Expr value = AllocStorage(size, alignment, ctx, type->dtype);
+    Expr value = AllocStorage(size, alignment, ctx, type->dtype, storage_scope);
     auto sto = scope->Push(var, value);
 
     // TODO(@jroesch): There is a bug with typing based on the constant shape.
@@ -352,7 +453,7 @@ class DialectRewriter : public ExprMutator {
   // Generate the code for invoking a TVM op with a dynamic shape.
   Expr DynamicInvoke(LetList* scope, const Function& func, const Tuple& ins,
                      const std::vector<Expr>& new_args, const std::vector<TensorType>& out_types,
-                     const Type& ret_type) {
+                     const std::vector<String>& out_scopes, const Type& ret_type) {
     auto out_shapes = EmitShapeFunc(scope, func, new_args);
     std::vector<Var> storages;
     auto func_ctx = GetContext(func);
@@ -363,7 +464,7 @@ class DialectRewriter : public ExprMutator {
       auto size = ComputeStorageInRelay(out_shape, out_type);
       auto alignment = ComputeAlignment(out_type->dtype);
       Var sto_var("storage_" + std::to_string(i), Type(nullptr));
-      auto val = AllocStorage(size, alignment, func_ctx, out_type->dtype);
+      auto val = AllocStorage(size, alignment, func_ctx, out_type->dtype, out_scopes[i]);
       storages.push_back(scope->Push(sto_var, val));
     }
 
@@ -406,6 +507,9 @@ class DialectRewriter : public ExprMutator {
  private:
   Target target_host_;
   AnalysisResultMap context_analysis_map_;
+  Map<Integer, Target> targets_;
+  Map<Expr, Array<String>> storage_scopes_;
+  StorageScopeEscapes escapes_;
   std::vector<LetList> scopes_;
 
   runtime::DataType compute_dtype_ = runtime::DataType::Int(64);
@@ -438,12 +542,18 @@ Pass ManifestAlloc(Target target_host, Map<tvm::Integer, tvm::Target> targets) {
           fallback_ctx.device_id = 0;
         }
         auto ca = ContextAnalysis(mod, fallback_ctx);
+        Map<Expr, Integer> dev_map;
+        for (const auto& kv : ca) {
+          dev_map.Set(kv.first, Integer(static_cast<int>(kv.second.device_type)));
+        }
 
         auto glob_funcs = mod->functions;
         for (const auto& it : glob_funcs) {
           if (auto* func_node = it.second.as<FunctionNode>()) {
             auto func = GetRef<Function>(func_node);
-            auto rewriter = DialectRewriter(target_host, ca);
+            // Target specific storage scopes of the outputs, e.g. textures
+            auto storage_scopes = backend::CollectStorageInfo(func, dev_map, targets);
+            auto rewriter = DialectRewriter(target_host, ca, targets, storage_scopes, func);
             auto updated_func = rewriter.Rewrite(func);
 
             mod->Update(it.first, updated_func);
@@ -28,15 +28,28 @@
  * This pass only introduces annotations to indicate the regions.
  * partition_graph must subsequently be called to lift these regions out
  * as external functions.
+ *
+ * When "relay.MergeCompilerRegions.cost_aware" is set, merged regions that
+ * are not expected to beat native TVM once the boundary copies are paid
+ * for are handed back to the "default" target, so partition_graph leaves
+ * their operators in the host graph. A codegen can supply its own estimate
+ * (or a measurement) through "relay.ext.<compiler>.region_cost", which is
+ * given the region outputs and the boundary size in bytes and returns
+ * [external_cost, native_cost] with the copies included; otherwise
+ * a region is kept only if its arithmetic intensity over the boundary
+ * reaches "relay.MergeCompilerRegions.min_flops_per_byte".
  */
 
 #include <tvm/ir/error.h>
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/attrs/annotation.h>
+#include <tvm/relay/attrs/nn.h>
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -49,6 +62,139 @@ namespace tvm {
 namespace relay {
 namespace merge_compiler_region {
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.MergeCompilerRegions.cost_aware", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.MergeCompilerRegions.min_flops_per_byte", Integer);
+
+/*! \brief Default arithmetic intensity a region needs to be worth offloading. */
+constexpr int64_t kDefaultMinFlopsPerByte = 16;
+
+/*! \brief Number of bytes of a tensor-typed expression, 0 if unknown. */
+int64_t TensorBytes(const Type& type) {
+  int64_t bytes = 0;
+  if (const auto* tt = type.as<TensorTypeNode>()) {
+    bytes = (tt->dtype.bits() * tt->dtype.lanes() + 7) / 8;
+    for (const auto& dim : tt->shape) {
+      const auto* extent = dim.as<IntImmNode>();
+      if (extent == nullptr) return 0;
+      bytes *= extent->value;
+    }
+  } else if (const auto* tuple = type.as<TupleTypeNode>()) {
+    for (const auto& field : tuple->fields) {
+      bytes += TensorBytes(field);
+    }
+  }
+  return bytes;
+}
+
+int64_t ExprBytes(const Expr& expr) {
+  return expr->checked_type_.defined() ? TensorBytes(expr->checked_type()) : 0;
+}
+
+/*! \brief Product of a static shape, -1 if any extent is dynamic. */
+int64_t ShapeProduct(const Array<PrimExpr>& shape) {
+  int64_t prod = 1;
+  for (const auto& dim : shape) {
+    const auto* extent = dim.as<IntImmNode>();
+    if (extent == nullptr) return -1;
+    prod *= extent->value;
+  }
+  return prod;
+}
+
+/*!
+ * \brief Rough FLOP count of a call. The reduction extent is accounted for
+ * on convolutions and matrix multiplies, everything else is charged one
+ * operation per output element.
+ */
+int64_t EstimateFlops(const CallNode* call) {
+  if (!call->checked_type_.defined()) return 0;
+  const auto* out_type = call->checked_type().as<TensorTypeNode>();
+  int64_t out_elems = out_type ? ShapeProduct(out_type->shape) : -1;
+  if (out_elems < 0) return 0;
+  if (call->args.size() < 2 || !call->args[1]->checked_type_.defined()) return out_elems;
+  const auto* weight = call->args[1]->checked_type().as<TensorTypeNode>();
+  int64_t weight_elems = weight ? ShapeProduct(weight->shape) : -1;
+  if (weight_elems <= 0) return out_elems;
+
+  std::string kernel_layout;
+  if (const auto* attrs = call->attrs.as<Conv1DAttrs>()) {
+    kernel_layout = attrs->kernel_layout;
+  } else if (const auto* attrs = call->attrs.as<Conv2DAttrs>()) {
+    kernel_layout = attrs->kernel_layout;
+  } else if (const auto* attrs = call->attrs.as<Conv3DAttrs>()) {
+    kernel_layout = attrs->kernel_layout;
+  } else if (call->attrs.as<DenseAttrs>() || call->attrs.as<BatchMatmulAttrs>()) {
+    // The contracted axis is the innermost axis of the second operand.
+    const auto* k = weight->shape.back().as<IntImmNode>();
+    return 2 * out_elems * k->value;
+  } else {
+    return out_elems;
+  }
+  // Every output element of a convolution reduces over the kernel of one
+  // output channel.
+  size_t o_axis = kernel_layout.find('O');
+  if (o_axis == std::string::npos || o_axis >= weight->shape.size()) return out_elems;
+  int64_t out_channels = weight->shape[o_axis].as<IntImmNode>()->value;
+  return 2 * out_elems * (weight_elems / std::max<int64_t>(out_channels, 1));
+}
+
+/*!
+ * \brief Decide which merged regions are worth offloading.
+ *
+ * The boundary of a region is the data entering through its begin
+ * annotations and leaving through its end annotations; all of it is copied
+ * between the host graph and the external runtime on every run.
+ */
+class RegionProfitability {
+ public:
+  explicit RegionProfitability(int64_t min_flops_per_byte)
+      : min_flops_per_byte_(min_flops_per_byte) {}
+
+  bool IsProfitable(const AnnotatedRegion& region) const {
+    if (region->GetTarget() == "default") return true;
+
+    int64_t boundary_bytes = 0;
+    for (const auto& in : region->GetInputs()) {
+      // Constants are handed to the external codegen once at build time.
+      auto arg = Downcast<Call>(in)->args[0];
+      if (!arg->IsInstance<ConstantNode>()) boundary_bytes += ExprBytes(arg);
+    }
+    Array<Expr> outputs;
+    for (const auto& out : region->GetOutputs()) {
+      auto end = Downcast<Call>(out);
+      boundary_bytes += ExprBytes(end->args[0]);
+      outputs.push_back(end->args[0]);
+    }
+
+    // Ask the codegen first, it may know (or measure) its real latency.
+    std::string hook = "relay.ext." + region->GetTarget() + ".region_cost";
+    if (const auto* fcost = runtime::Registry::Get(hook)) {
+      Array<FloatImm> cost = (*fcost)(outputs, Integer(boundary_bytes));
+      ICHECK_EQ(cost.size(), 2U) << hook << " must return [external_cost, native_cost]";
+      DLOG(INFO) << "Region " << region->GetID() << " (" << region->GetTarget()
+                 << "): external " << cost[0]->value << " vs native " << cost[1]->value;
+      return cost[0]->value < cost[1]->value;
+    }
+
+    int64_t flops = 0;
+    for (const auto& node : region->GetNodes()) {
+      const auto* call = node.as<CallNode>();
+      if (call == nullptr || call->op == CompilerBeginOp() || call->op == CompilerEndOp()) {
+        continue;
+      }
+      flops += EstimateFlops(call);
+    }
+    DLOG(INFO) << "Region " << region->GetID() << " (" << region->GetTarget() << "): " << flops
+               << " flops over " << boundary_bytes << " boundary bytes";
+    // Without type information there is nothing to base the decision on.
+    if (boundary_bytes == 0) return true;
+    return flops >= min_flops_per_byte_ * boundary_bytes;
+  }
+
+ private:
+  int64_t min_flops_per_byte_;
+};
+
 class RegionMerger : public MixedModeVisitor {
  public:
   explicit RegionMerger(AnnotatedRegionSet regions) : regions_(regions) {}
@@ -137,7 +283,9 @@ class RegionMerger : public MixedModeVisitor {
 
 class MergeAnnotations : public ExprRewriter {
  public:
-  explicit MergeAnnotations(AnnotatedRegionSet regions) : regions_(regions) {}
+  explicit MergeAnnotations(AnnotatedRegionSet regions,
+                            std::unordered_set<int> dropped_regions = {})
+      : regions_(regions), dropped_regions_(dropped_regions) {}
 
   Expr Rewrite_(const CallNode* call, const Expr& post) final {
     // Merge annotations which are now internal to a region.
@@ -154,14 +302,28 @@ class MergeAnnotations : public ExprRewriter {
         }
       }
     }
+    // Hand the boundary of an unprofitable region back to the default target.
+    if ((call->op == CompilerBeginOp() || call->op == CompilerEndOp()) &&
+        !dropped_regions_.empty()) {
+      auto region = regions_->GetRegion(GetRef<Call>(call));
+      if (region.defined() && dropped_regions_.count(region->GetID())) {
+        auto post_call = Downcast<Call>(post);
+        auto attrs = make_object<CompilerAttrs>();
+        attrs->compiler = "default";
+        return Call(post_call->op, post_call->args, Attrs(attrs), post_call->type_args,
+                    post_call->span);
+      }
+    }
     return post;
   }
 
  private:
   AnnotatedRegionSet regions_;
+  std::unordered_set<int> dropped_regions_;
 };
 
-Expr MergeCompilerRegions(const Expr& expr) {
+Expr MergeCompilerRegions(const Expr& expr, bool cost_aware = false,
+                          int64_t min_flops_per_byte = kDefaultMinFlopsPerByte) {
   // Create regions using the annotations.
   AnnotatedRegionSet regions = AnnotatedRegionSet::Create(expr, CompilerBeginOp(), CompilerEndOp());
 
@@ -169,8 +331,20 @@ Expr MergeCompilerRegions(const Expr& expr) {
   RegionMerger merger(regions);
   merger.VisitExpr(expr);
 
+  // Only the merged regions are costed, a small region may pay off once
+  // it is fused with its neighbours.
+  std::unordered_set<int> dropped_regions;
+  if (cost_aware) {
+    RegionProfitability profitability(min_flops_per_byte);
+    for (const auto& region : regions) {
+      if (!profitability.IsProfitable(region)) {
+        dropped_regions.insert(region->GetID());
+      }
+    }
+  }
+
   // Remove annotations that are not in the region boundaries.
-  MergeAnnotations merge_anno(regions);
+  MergeAnnotations merge_anno(regions, dropped_regions);
   return PostOrderRewrite(expr, &merge_anno);
 }
 
@@ -181,7 +355,13 @@ namespace transform {
 Pass MergeCompilerRegions() {
   runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> part_func =
       [=](Function f, IRModule m, PassContext pc) {
-        return Downcast<Function>(merge_compiler_region::MergeCompilerRegions(f));
+        bool cost_aware =
+            pc->GetConfig<Bool>("relay.MergeCompilerRegions.cost_aware", Bool(false)).value();
+        auto min_flops_per_byte =
+            pc->GetConfig("relay.MergeCompilerRegions.min_flops_per_byte",
+                          Integer(merge_compiler_region::kDefaultMinFlopsPerByte));
+        return Downcast<Function>(
+            merge_compiler_region::MergeCompilerRegions(f, cost_aware, min_flops_per_byte.value()));
       };
   auto merged = CreateFunctionPass(part_func, 0, "MergeCompilerRegions", {});
   return Sequential({merged, InferType()});
@@ -47,13 +47,21 @@ Expr MergeComposite(const Function& func, const Array<runtime::String>& pattern_
                     const Array<DFPattern>& patterns, const std::vector<PackedFunc>& checks,
                     const IRModule& m) {
   ICHECK_EQ(pattern_names.size(), patterns.size());
-  Function merged_func = func;
+  if (patterns.empty()) return func;
+  // The types are inferred once up front and again only when a pattern merged nodes, so the
+  // matcher can use the checked types. The patterns whose root matches no node of the function
+  // are skipped without building the graphs of the matcher.
+  Function merged_func = InferType(func, m);
+  ExprNodeIndex index(merged_func);
   // merge the patterns one-by-one in order
   for (size_t i = 0; i < patterns.size(); i++) {
+    if (!PatternRootFilter(patterns[i]).MayMatchAny(index)) continue;
     Map<String, ObjectRef> attrs;
     attrs.Set("Composite", pattern_names[i]);
-    merged_func = Downcast<Function>(PartitionPattern(patterns[i], merged_func, attrs, checks[i]));
-    merged_func = InferType(merged_func, m);
+    Expr partitioned = PartitionPattern(patterns[i], merged_func, attrs, checks[i], true);
+    if (partitioned.same_as(merged_func)) continue;
+    merged_func = InferType(Downcast<Function>(partitioned), m);
+    index = ExprNodeIndex(merged_func);
   }
   return std::move(merged_func);
 }
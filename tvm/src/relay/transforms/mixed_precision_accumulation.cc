@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mixed_precision_accumulation.cc
+ * \brief Select the accumulation type of the float16 convolutions and dense layers.
+ *
+ * Accumulating in float16 is faster, but the rounding error grows with the number of
+ * products summed up for an output. Layers with a long reduction accumulate in float32
+ * and cast their result back to float16, the others explicitly accumulate in float16.
+ */
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op.h>
+#include <tvm/relay/transform.h>
+
+#include <string>
+
+#include "pattern_utils.h"
+
+namespace tvm {
+namespace relay {
+
+class MixedPrecisionAccumulationMutator : public ExprRewriter {
+ public:
+  MixedPrecisionAccumulationMutator(int64_t max_fp16_reduction, PackedFunc policy)
+      : max_fp16_reduction_(max_fp16_reduction),
+        policy_(policy),
+        conv2d_op_(Op::Get("nn.conv2d")),
+        conv2d_nchwc_op_(Op::Get("nn.contrib_conv2d_NCHWc")),
+        dense_op_(Op::Get("nn.dense")) {}
+
+  Expr Rewrite_(const CallNode* pre, const Expr& post) override {
+    DataType out_dtype;
+    int64_t reduction = -1;
+    if (pre->op == conv2d_op_ || pre->op == conv2d_nchwc_op_) {
+      const auto* attrs = pre->attrs.as<Conv2DAttrs>();
+      out_dtype = attrs->out_dtype;
+      std::string layout = attrs->kernel_layout;
+      reduction = ReductionLength(pre->args[1], [&layout](size_t i) {
+        return i < layout.size() && (layout[i] == 'O' || layout[i] == 'o');
+      });
+    } else if (pre->op == dense_op_) {
+      out_dtype = pre->attrs.as<DenseAttrs>()->out_dtype;
+      // The weight is [units, reduction]
+      reduction = ReductionLength(pre->args[1], [](size_t i) { return i == 0; });
+    } else {
+      return post;
+    }
+    const auto* in_type = pre->args[0]->checked_type().as<TensorTypeNode>();
+    if (in_type == nullptr || !in_type->dtype.is_float16() ||
+        !(out_dtype.is_void() || out_dtype.is_float16())) {
+      return post;
+    }
+
+    bool fp32 = false;
+    std::string choice;
+    if (policy_ != nullptr) {
+      // A policy returning None has no opinion on the layer, like an empty string
+      TVMRetValue ret = policy_(GetRef<Call>(pre), reduction);
+      if (ret.type_code() != kTVMNullptr) choice = ret.operator std::string();
+    }
+    if (choice == "float32") {
+      fp32 = true;
+    } else if (choice.empty()) {
+      // Without a known reduction length the layer keeps its accumulation type
+      if (reduction < 0) return post;
+      fp32 = reduction > max_fp16_reduction_;
+    } else {
+      ICHECK_EQ(choice, "float16") << "The accumulation policy returned " << choice << " for "
+                                   << pre->op << ", expected float16, float32 or an empty string";
+    }
+
+    const auto* call = post.as<CallNode>();
+    DataType acc_dtype = fp32 ? DataType::Float(32) : DataType::Float(16);
+    Attrs attrs;
+    if (const auto* conv = call->attrs.as<Conv2DAttrs>()) {
+      auto n = make_object<Conv2DAttrs>(*conv);
+      n->out_dtype = acc_dtype;
+      attrs = Attrs(n);
+    } else {
+      auto n = make_object<DenseAttrs>(*call->attrs.as<DenseAttrs>());
+      n->out_dtype = acc_dtype;
+      attrs = Attrs(n);
+    }
+    Expr new_call = Call(call->op, call->args, attrs, call->type_args, call->span);
+    return fp32 ? Cast(new_call, DataType::Float(16)) : new_call;
+  }
+
+ private:
+  /*!
+   * \brief The number of products summed up for one output, -1 when unknown.
+   * \param weight The weight of the layer.
+   * \param is_output Whether an axis of the weight is an output axis.
+   */
+  template <typename F>
+  static int64_t ReductionLength(const Expr& weight, F is_output) {
+    const auto* ttype = weight->checked_type().as<TensorTypeNode>();
+    if (ttype == nullptr) return -1;
+    int64_t length = 1;
+    for (size_t i = 0; i < ttype->shape.size(); ++i) {
+      const auto* dim = ttype->shape[i].as<IntImmNode>();
+      if (dim == nullptr) return -1;
+      if (!is_output(i)) length *= dim->value;
+    }
+    return length;
+  }
+
+  // The longest reduction accumulated in float16 without a policy decision
+  int64_t max_fp16_reduction_;
+  // The user policy, returning the accumulation type of a layer or an empty string
+  PackedFunc policy_;
+  // Cache the following ops. They will be used in the passes repeatedly for
+  // operator equivalence checking so that the registry lookup overhead can be
+  // reduced.
+  const Op& conv2d_op_;
+  const Op& conv2d_nchwc_op_;
+  const Op& dense_op_;
+};
+
+Expr MixedPrecisionAccumulation(const Expr& e, int64_t max_fp16_reduction, PackedFunc policy) {
+  auto rewriter = MixedPrecisionAccumulationMutator(max_fp16_reduction, policy);
+  return PostOrderRewrite(e, &rewriter);
+}
+
+namespace transform {
+
+Pass MixedPrecisionAccumulation(int64_t max_fp16_reduction, PackedFunc policy) {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        return Downcast<Function>(MixedPrecisionAccumulation(f, max_fp16_reduction, policy));
+      };
+  return CreateFunctionPass(pass_func, 3, "MixedPrecisionAccumulation", {"InferType"});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.MixedPrecisionAccumulation")
+    .set_body_typed(MixedPrecisionAccumulation);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
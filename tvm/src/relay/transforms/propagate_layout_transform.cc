@@ -0,0 +1,324 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file propagate_layout_transform.cc
+ * \brief Push layout transforms through layout agnostic ops and cancel them.
+ *
+ * AlterOpLayout and ConvertLayout transform the layout at every boundary between an op with
+ * a packed layout, e.g. NCHW4c, and an op keeping the original layout. Ops which do not care
+ * about the layout between two transforms can as well run in the packed layout:
+ *
+ *   layout_transform(relu(layout_transform(x, NCHW4c, NCHW)), NCHW, NCHW4c)
+ *
+ * becomes relu(x). Transforms are sunk from the inputs to the output of elementwise and
+ * broadcast ops without layout dependent attributes, of concatenations along an axis which is
+ * not packed and of 2D pooling and resizing, whose layout attribute is updated. Back-to-back
+ * transforms are merged or cancelled. A transform is only sunk out of an input used once, so
+ * that the number of transforms never grows.
+ */
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/image.h>
+#include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/attrs/transform.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op.h>
+#include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/transform.h>
+#include <tvm/tir/data_layout.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "pattern_utils.h"
+
+namespace tvm {
+namespace relay {
+
+/*! \brief Count the uses of every expression in a dataflow graph. */
+class UseCounter : private ExprVisitor {
+ public:
+  static std::unordered_map<const Object*, int> Count(const Expr& expr) {
+    UseCounter counter;
+    counter.VisitExpr(expr);
+    return std::move(counter.uses_);
+  }
+
+ private:
+  void VisitExpr(const Expr& expr) final {
+    uses_[expr.get()]++;
+    ExprVisitor::VisitExpr(expr);
+  }
+
+  std::unordered_map<const Object*, int> uses_;
+};
+
+class LayoutTransformPropagator : public ExprRewriter {
+ public:
+  explicit LayoutTransformPropagator(const Expr& expr)
+      : uses_(UseCounter::Count(expr)),
+        layout_transform_op_(Op::Get("layout_transform")),
+        concatenate_op_(Op::Get("concatenate")),
+        max_pool2d_op_(Op::Get("nn.max_pool2d")),
+        avg_pool2d_op_(Op::Get("nn.avg_pool2d")),
+        global_max_pool2d_op_(Op::Get("nn.global_max_pool2d")),
+        global_avg_pool2d_op_(Op::Get("nn.global_avg_pool2d")),
+        resize_op_(Op::Get("image.resize")) {}
+
+  Expr Rewrite_(const CallNode* pre, const Expr& post) override {
+    const auto* call = post.as<CallNode>();
+    if (call == nullptr) return post;
+    if (pre->op == layout_transform_op_) return MergeTransforms(call);
+    if (pre->op == concatenate_op_) return SinkThroughConcatenate(pre, call);
+    if (pre->op == max_pool2d_op_ || pre->op == avg_pool2d_op_ ||
+        pre->op == global_max_pool2d_op_ || pre->op == global_avg_pool2d_op_ ||
+        pre->op == resize_op_) {
+      return SinkThroughSpatialOp(pre, call);
+    }
+    return SinkThroughElemwise(pre, call);
+  }
+
+ private:
+  /*! \brief The source and destination layout of a transform. */
+  struct Transform {
+    std::string src_layout;
+    std::string dst_layout;
+  };
+
+  /*!
+   * \brief Get the layouts of a transform which can be sunk out of an input.
+   * \param pre The input before the rewrite.
+   * \param post The input after the rewrite.
+   * \return Whether the input is a layout transform used at most once.
+   */
+  bool GetSinkableTransform(const Expr& pre, const Expr& post, Transform* transform) const {
+    const auto* call = post.as<CallNode>();
+    if (call == nullptr || call->op != layout_transform_op_) return false;
+    auto it = uses_.find(pre.get());
+    if (it == uses_.end() || it->second > 1) return false;
+    const auto* attrs = call->attrs.as<LayoutTransformAttrs>();
+    transform->src_layout = attrs->src_layout;
+    transform->dst_layout = attrs->dst_layout;
+    return true;
+  }
+
+  /*! \brief layout_transform(layout_transform(x, A, B), B, C) -> layout_transform(x, A, C) */
+  Expr MergeTransforms(const CallNode* call) const {
+    const auto* inner = call->args[0].as<CallNode>();
+    if (inner == nullptr || inner->op != layout_transform_op_) return GetRef<Call>(call);
+    const auto* attrs = call->attrs.as<LayoutTransformAttrs>();
+    const auto* inner_attrs = inner->attrs.as<LayoutTransformAttrs>();
+    if (inner_attrs->dst_layout != attrs->src_layout) return GetRef<Call>(call);
+    if (inner_attrs->src_layout == attrs->dst_layout) return inner->args[0];
+    return MakeLayoutTransform(inner->args[0], inner_attrs->src_layout, attrs->dst_layout);
+  }
+
+  /*! \brief Whether the attributes of an op depend on the layout of its inputs. */
+  static bool HasLayoutDependentAttrs(const Attrs& attrs) {
+    if (!attrs.defined()) return false;
+    const auto* base_attrs = attrs.as<BaseAttrsNode>();
+    if (base_attrs == nullptr) return false;
+    for (const auto& field : base_attrs->ListFieldInfo()) {
+      std::string name = field->name;
+      if (name.find("axis") != std::string::npos || name.find("layout") != std::string::npos) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*!
+   * \brief op(layout_transform(x, A, B), layout_transform(y, A, B)) ->
+   *  layout_transform(op(x, y), A, B) for elementwise ops whose tensor inputs all have the type
+   *  of the output. Scalars are kept and constants are transformed back to A.
+   */
+  Expr SinkThroughElemwise(const CallNode* pre, const CallNode* call) const {
+    static auto fpattern = Op::GetAttrMap<TOpPattern>("TOpPattern");
+    const auto* op = pre->op.as<OpNode>();
+    if (op == nullptr || !fpattern.count(GetRef<Op>(op)) ||
+        fpattern[GetRef<Op>(op)] > kBroadcast || HasLayoutDependentAttrs(pre->attrs)) {
+      return GetRef<Call>(call);
+    }
+    const auto* out_type = pre->checked_type().as<TensorTypeNode>();
+    if (out_type == nullptr || out_type->shape.empty()) return GetRef<Call>(call);
+
+    Transform transform;
+    bool found = false;
+    for (size_t i = 0; i < pre->args.size(); ++i) {
+      Transform arg_transform;
+      if (!GetSinkableTransform(pre->args[i], call->args[i], &arg_transform)) continue;
+      if (found && (arg_transform.src_layout != transform.src_layout ||
+                    arg_transform.dst_layout != transform.dst_layout)) {
+        return GetRef<Call>(call);
+      }
+      transform = arg_transform;
+      found = true;
+    }
+    if (!found) return GetRef<Call>(call);
+
+    Array<Expr> new_args;
+    for (size_t i = 0; i < pre->args.size(); ++i) {
+      const auto* arg_type = pre->args[i]->checked_type().as<TensorTypeNode>();
+      if (arg_type == nullptr) return GetRef<Call>(call);
+      bool is_scalar = arg_type->shape.empty();
+      if (!is_scalar && !StructuralEqual()(GetRef<Type>(arg_type), GetRef<Type>(out_type))) {
+        return GetRef<Call>(call);
+      }
+      Transform arg_transform;
+      if (GetSinkableTransform(pre->args[i], call->args[i], &arg_transform)) {
+        new_args.push_back(call->args[i].as<CallNode>()->args[0]);
+      } else if (is_scalar) {
+        new_args.push_back(call->args[i]);
+      } else if (call->args[i]->IsInstance<ConstantNode>()) {
+        // Folded by FoldConstant afterwards.
+        new_args.push_back(
+            MakeLayoutTransform(call->args[i], transform.dst_layout, transform.src_layout));
+      } else {
+        return GetRef<Call>(call);
+      }
+    }
+    Call new_call(call->op, new_args, call->attrs, call->type_args, call->span);
+    return MakeLayoutTransform(new_call, transform.src_layout, transform.dst_layout);
+  }
+
+  /*!
+   * \brief concatenate((layout_transform(x, A, B), ...), axis) ->
+   *  layout_transform(concatenate((x, ...), axis in A), A, B) when the axis is packed in
+   *  neither of the layouts.
+   */
+  Expr SinkThroughConcatenate(const CallNode* pre, const CallNode* call) const {
+    const auto* pre_tuple = pre->args[0].as<TupleNode>();
+    const auto* tuple = call->args[0].as<TupleNode>();
+    if (pre_tuple == nullptr || tuple == nullptr || tuple->fields.empty()) {
+      return GetRef<Call>(call);
+    }
+    Transform transform;
+    Array<Expr> fields;
+    for (size_t i = 0; i < tuple->fields.size(); ++i) {
+      Transform field_transform;
+      if (!GetSinkableTransform(pre_tuple->fields[i], tuple->fields[i], &field_transform) ||
+          (i > 0 && (field_transform.src_layout != transform.src_layout ||
+                     field_transform.dst_layout != transform.dst_layout))) {
+        return GetRef<Call>(call);
+      }
+      transform = field_transform;
+      fields.push_back(tuple->fields[i].as<CallNode>()->args[0]);
+    }
+    Layout src_layout(transform.src_layout);
+    Layout dst_layout(transform.dst_layout);
+    const auto* attrs = call->attrs.as<ConcatenateAttrs>();
+    int axis = attrs->axis;
+    if (axis < 0) axis += static_cast<int>(dst_layout.ndim());
+    if (axis < 0 || axis >= static_cast<int>(dst_layout.ndim())) return GetRef<Call>(call);
+    const LayoutAxis& layout_axis = dst_layout[axis];
+    if (!layout_axis.IsPrimal() || dst_layout.Contains(layout_axis.ToSubordinate()) ||
+        !src_layout.Contains(layout_axis) || src_layout.Contains(layout_axis.ToSubordinate())) {
+      return GetRef<Call>(call);
+    }
+    Expr concat = MakeConcatenate(Tuple(fields), src_layout.IndexOf(layout_axis));
+    return MakeLayoutTransform(concat, transform.src_layout, transform.dst_layout);
+  }
+
+  /*!
+   * \brief pool(layout_transform(x, A, B), layout=B) ->
+   *  layout_transform(pool(x, layout=A), A, B) when the height and width are packed in neither
+   *  of the layouts, the same for resize.
+   */
+  Expr SinkThroughSpatialOp(const CallNode* pre, const CallNode* call) const {
+    Transform transform;
+    if (!GetSinkableTransform(pre->args[0], call->args[0], &transform)) return GetRef<Call>(call);
+    Layout src_layout(transform.src_layout);
+    Layout dst_layout(transform.dst_layout);
+    for (char name : {'H', 'W'}) {
+      const LayoutAxis& spatial_axis = LayoutAxis::Get(name);
+      for (const Layout& layout : {src_layout, dst_layout}) {
+        if (!layout.Contains(spatial_axis) || layout.Contains(spatial_axis.ToSubordinate())) {
+          return GetRef<Call>(call);
+        }
+      }
+    }
+    Attrs new_attrs;
+    if (const auto* attrs = call->attrs.as<MaxPool2DAttrs>()) {
+      new_attrs = WithLayout(attrs, transform);
+    } else if (const auto* attrs = call->attrs.as<AvgPool2DAttrs>()) {
+      new_attrs = WithLayout(attrs, transform);
+    } else if (const auto* attrs = call->attrs.as<GlobalPool2DAttrs>()) {
+      new_attrs = WithLayout(attrs, transform);
+    } else if (const auto* attrs = call->attrs.as<ResizeAttrs>()) {
+      new_attrs = WithLayout(attrs, transform);
+    }
+    if (!new_attrs.defined()) return GetRef<Call>(call);
+    Array<Expr> new_args = call->args;
+    new_args.Set(0, call->args[0].as<CallNode>()->args[0]);
+    Call new_call(call->op, new_args, new_attrs, call->type_args, call->span);
+    return MakeLayoutTransform(new_call, transform.src_layout, transform.dst_layout);
+  }
+
+  /*!
+   * \brief Copy the attributes of a spatial op in the destination layout of a transform with
+   *  the source layout.
+   * \return The new attributes, undefined if the op is not in the destination layout.
+   */
+  template <typename T>
+  static Attrs WithLayout(const T* attrs, const Transform& transform) {
+    if (std::string(attrs->layout) != transform.dst_layout) return Attrs();
+    auto new_attrs = make_object<T>(*attrs);
+    new_attrs->layout = transform.src_layout;
+    return Attrs(new_attrs);
+  }
+
+  /*! \brief The number of uses of every expression before the rewrite */
+  std::unordered_map<const Object*, int> uses_;
+  // Cache the following ops. They will be used in the passes repeatedly for
+  // operator equivalence checking so that the registry lookup overhead can be
+  // reduced.
+  const Op& layout_transform_op_;
+  const Op& concatenate_op_;
+  const Op& max_pool2d_op_;
+  const Op& avg_pool2d_op_;
+  const Op& global_max_pool2d_op_;
+  const Op& global_avg_pool2d_op_;
+  const Op& resize_op_;
+};
+
+Expr PropagateLayoutTransform(const Expr& expr) {
+  auto rewriter = LayoutTransformPropagator(expr);
+  return PostOrderRewrite(expr, &rewriter);
+}
+
+namespace transform {
+
+// Whether the build runs PropagateLayoutTransform after AlterOpLayout, off by default
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.propagate_layout_transform", Bool);
+
+Pass PropagateLayoutTransform() {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        return Downcast<Function>(PropagateLayoutTransform(f));
+      };
+  return CreateFunctionPass(pass_func, 3, "PropagateLayoutTransform", {"InferType"});
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.PropagateLayoutTransform")
+    .set_body_typed(PropagateLayoutTransform);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
@@ -45,12 +45,16 @@
 #include <tvm/relay/pattern_functor.h>
 #include <tvm/relay/transform.h>
 
+#include <unordered_set>
+
 #include "../analysis/type_solver.h"
 #include "pass_utils.h"
 
 namespace tvm {
 namespace relay {
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.InferType.incremental", Bool);
+
 // Necessary deferred relation for TupleGetItem
 struct TupleGetItemAttrs : public tvm::AttrsNode<TupleGetItemAttrs> {
   int index;
@@ -87,10 +91,101 @@ struct ResolvedTypeInfo {
   Array<Type> type_args = Array<Type>(ObjectPtr<Object>(nullptr));
 };
 
+using ExprSet = std::unordered_set<Expr, ObjectPtrHash, ObjectPtrEqual>;
+
+/*!
+ * \brief Find the dataflow subgraphs whose checked types can be kept from the last inference.
+ *
+ * Passes build the expressions they rewrite without a checked type, so a subgraph in which every
+ * node still carries a checked type was left untouched since it was inferred. Only the subgraphs
+ * of op calls, tuples, projections, constants and annotated variables with static tensor types
+ * are kept: their types only depend on the subgraph itself, while unification could still refine
+ * dynamic shapes or the types of function calls.
+ */
+class TypedSubgraphFinder : public MixedModeVisitor {
+ public:
+  static ExprSet Find(const Expr& expr) {
+    TypedSubgraphFinder finder;
+    finder.VisitExpr(expr);
+    return std::move(finder.typed_);
+  }
+
+ private:
+  using MixedModeVisitor::VisitExpr_;
+
+  static bool IsStatic(const Type& type) {
+    if (const auto* ttype = type.as<TensorTypeNode>()) {
+      for (const auto& dim : ttype->shape) {
+        if (!dim->IsInstance<IntImmNode>()) return false;
+      }
+      return true;
+    }
+    if (const auto* tuple_type = type.as<TupleTypeNode>()) {
+      for (const auto& field : tuple_type->fields) {
+        if (!IsStatic(field)) return false;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  void VisitExpr_(const VarNode* op) final {
+    if (op->type_annotation.defined() && IsStatic(op->type_annotation) &&
+        IsStatic(op->checked_type_)) {
+      typed_.insert(GetRef<Expr>(op));
+    }
+  }
+
+  void VisitExpr_(const ConstantNode* op) final {
+    if (op->checked_type_.defined()) typed_.insert(GetRef<Expr>(op));
+  }
+
+  void VisitExpr_(const CallNode* op) final {
+    ExprVisitor::VisitExpr_(op);
+    if (!op->op.as<OpNode>() || !IsStatic(op->checked_type_)) return;
+    for (const auto& arg : op->args) {
+      if (!typed_.count(arg)) return;
+    }
+    typed_.insert(GetRef<Expr>(op));
+  }
+
+  void VisitExpr_(const TupleNode* op) final {
+    ExprVisitor::VisitExpr_(op);
+    if (!IsStatic(op->checked_type_)) return;
+    for (const auto& field : op->fields) {
+      if (!typed_.count(field)) return;
+    }
+    typed_.insert(GetRef<Expr>(op));
+  }
+
+  void VisitExpr_(const TupleGetItemNode* op) final {
+    ExprVisitor::VisitExpr_(op);
+    if (IsStatic(op->checked_type_) && typed_.count(op->tuple)) {
+      typed_.insert(GetRef<Expr>(op));
+    }
+  }
+
+  void VisitExpr_(const LetNode* op) final {
+    auto pre_visit = [this](const LetNode* op) {
+      this->VisitExpr(op->var);
+      this->VisitExpr(op->value);
+    };
+    auto post_visit = [this](const LetNode* op) {
+      this->VisitExpr(op->body);
+      this->visit_counter_[op] += 1;
+    };
+    ExpandANormalForm(op, pre_visit, post_visit);
+  }
+
+  ExprSet typed_;
+};
+
 //
 // The inference algorithm can roughly be divided into three stages:
 // - Populate the constraints by visiting the expression (TypeInferencer.GetType)
 //   - solver.AddConstraint and solver.Unify are called to populate the necessary constraints
+//   - in incremental mode, the subgraphs found by TypedSubgraphFinder are not visited again,
+//     their checked types are used as they are
 // - Solve the constraints (solver_.Solve)
 // - Recreate expression with the resolved checked_type (Resolver.VisitExpr)
 //
@@ -99,8 +194,8 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
  public:
   // constructors
 
-  explicit TypeInferencer(IRModule mod, DiagnosticContext diag_ctx)
-      : mod_(mod), diag_ctx(diag_ctx), solver_(GlobalVar(), diag_ctx) {
+  explicit TypeInferencer(IRModule mod, DiagnosticContext diag_ctx, bool incremental = false)
+      : mod_(mod), diag_ctx(diag_ctx), solver_(GlobalVar(), diag_ctx), incremental_(incremental) {
     ICHECK(mod.defined()) << "Module must not be null in the type inferencer.";
   }
 
@@ -125,6 +220,8 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
 
   // The solver used by the inferencer.
   TypeSolver solver_;
+  // Whether to keep the checked types of the subgraphs untouched since the last inference.
+  bool incremental_;
   // relation function
   TypeRelationFn tuple_getitem_rel_;
   TypeRelationFn make_tuple_rel_;
@@ -588,8 +685,16 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
 class TypeInferencer::Resolver : public MixedModeMutator, PatternMutator {
  public:
   Resolver(const std::unordered_map<Expr, ResolvedTypeInfo, ObjectPtrHash, ObjectPtrEqual>& tmap,
-           TypeSolver* solver)
-      : tmap_(tmap), solver_(solver) {}
+           TypeSolver* solver, const ExprSet& typed)
+      : tmap_(tmap), solver_(solver) {
+    // The typed subgraphs are kept as they are.
+    for (const Expr& expr : typed) {
+      memo_[expr] = expr;
+      if (const auto* var = expr.as<VarNode>()) {
+        vmap_[GetRef<Var>(var)] = GetRef<Var>(var);
+      }
+    }
+  }
 
   using MixedModeMutator::VisitExpr_;
 
@@ -742,6 +847,16 @@ Expr TypeInferencer::Infer(GlobalVar var, Function function) {
   // Set the current function being type checked.
   this->current_func_ = var;
 
+  // Step 0: Reuse the checked types of the subgraphs untouched since the last inference.
+  ExprSet typed;
+  if (incremental_) {
+    typed = TypedSubgraphFinder::Find(function);
+    for (const Expr& expr : typed) {
+      memo_[expr] = expr->checked_type_;
+      type_map_[expr].checked_type = expr->checked_type_;
+    }
+  }
+
   // Step 1: Populate the constraints.
   GetType(function);
 
@@ -749,7 +864,7 @@ Expr TypeInferencer::Infer(GlobalVar var, Function function) {
   Solve();
 
   // Step 3: Attach resolved types to checked_type field.
-  auto resolved_expr = Resolver(type_map_, &solver_).VisitExpr(function);
+  auto resolved_expr = Resolver(type_map_, &solver_, typed).VisitExpr(function);
 
   if (!WellFormed(resolved_expr, this->diag_ctx)) {
     this->diag_ctx.Emit(Diagnostic::Bug(function->span)
@@ -821,6 +936,8 @@ Pass InferType() {
             IRModule(mod->functions, mod->type_definitions, mod->Imports(), mod->source_map);
 
         pass_ctx->diag_ctx = DiagnosticContext::Default(updated_mod);
+        bool incremental =
+            pass_ctx->GetConfig<Bool>("relay.InferType.incremental", Bool(false)).value();
 
         // Add all the type annotations to the functions in the model.
         AddGlobalTypes(mod);
@@ -843,7 +960,7 @@ Pass InferType() {
 
             // TODO(@jroesch): we should be able to move the type inferencer outside
             // of this function but it seems to be more stateful then I expect.
-            auto inferencer = TypeInferencer(mod, pass_ctx->diag_ctx.value());
+            auto inferencer = TypeInferencer(mod, pass_ctx->diag_ctx.value(), incremental);
             auto updated_func = inferencer.Infer(it.first, func);
 
             pass_ctx->diag_ctx.value().Render();
@@ -24,6 +24,14 @@
 #include <builtin_fp16.h>
 #include <tvm/runtime/c_runtime_api.h>
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define TVM_FP16_USE_NEON 1
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TVM_FP16_USE_F16C 1
+#endif
+
 extern "C" {
 
 // disable under msvc
@@ -49,3 +57,78 @@ TVM_DLL float __gnu_h2f_ieee(uint16_t a) {
 
 #endif
 }
+
+namespace {
+
+#if TVM_FP16_USE_NEON
+// fcvtn/fcvtl are part of the base ARMv8-A SIMD instructions.
+int64_t ConvertFloat32ToFloat16Simd(const float* src, uint16_t* dst, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+  return i;
+}
+
+int64_t ConvertFloat16ToFloat32Simd(const uint16_t* src, float* dst, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+  }
+  return i;
+}
+#elif TVM_FP16_USE_F16C
+// Compiled for F16C whatever the flags of the build, and only called when the CPU has it.
+__attribute__((target("avx,f16c"))) int64_t ConvertFloat32ToFloat16F16C(const float* src,
+                                                                        uint16_t* dst, int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+  }
+  return i;
+}
+
+__attribute__((target("avx,f16c"))) int64_t ConvertFloat16ToFloat32F16C(const uint16_t* src,
+                                                                        float* dst, int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  return i;
+}
+
+bool HasF16C() {
+  static bool has_f16c = __builtin_cpu_supports("f16c");
+  return has_f16c;
+}
+
+int64_t ConvertFloat32ToFloat16Simd(const float* src, uint16_t* dst, int64_t n) {
+  return HasF16C() ? ConvertFloat32ToFloat16F16C(src, dst, n) : 0;
+}
+
+int64_t ConvertFloat16ToFloat32Simd(const uint16_t* src, float* dst, int64_t n) {
+  return HasF16C() ? ConvertFloat16ToFloat32F16C(src, dst, n) : 0;
+}
+#else
+int64_t ConvertFloat32ToFloat16Simd(const float* src, uint16_t* dst, int64_t n) { return 0; }
+
+int64_t ConvertFloat16ToFloat32Simd(const uint16_t* src, float* dst, int64_t n) { return 0; }
+#endif
+
+}  // namespace
+
+// The SIMD paths round to nearest even like the scalar ones, so the results do not depend on
+// the host.
+void TVMConvertFloat32ToFloat16(const float* src, uint16_t* dst, int64_t n) {
+  for (int64_t i = ConvertFloat32ToFloat16Simd(src, dst, n); i < n; ++i) {
+    dst[i] = __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(src[i]);
+  }
+}
+
+void TVMConvertFloat16ToFloat32(const uint16_t* src, float* dst, int64_t n) {
+  for (int64_t i = ConvertFloat16ToFloat32Simd(src, dst, n); i < n; ++i) {
+    dst[i] = __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(src[i]);
+  }
+}
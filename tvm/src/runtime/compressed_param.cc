@@ -0,0 +1,241 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file compressed_param.cc
+ * \brief Compression and decompression of the parameters.
+ */
+#include "compressed_param.h"
+
+#include <builtin_fp16.h>
+#include <tvm/runtime/data_type.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace tvm {
+namespace runtime {
+
+namespace {
+bool IsDecompressedType(DLDataType dtype) {
+  return dtype.code == kDLFloat && (dtype.bits == 32 || dtype.bits == 16) && dtype.lanes == 1;
+}
+
+CompressionScheme GetCompressionScheme(const std::string& name) {
+  if (name == "float16") return CompressionScheme::kFloat16;
+  if (name == "int8") return CompressionScheme::kInt8;
+  if (name == "int4") return CompressionScheme::kInt4;
+  LOG(FATAL) << "Unknown parameter compression scheme " << name
+             << ", expected float16, int8 or int4";
+  return CompressionScheme::kFloat16;
+}
+
+size_t GetCompressedDataBytes(CompressionScheme scheme, int64_t num_elements) {
+  switch (scheme) {
+    case CompressionScheme::kFloat16:
+      return num_elements * sizeof(uint16_t);
+    case CompressionScheme::kInt8:
+      return num_elements;
+    case CompressionScheme::kInt4:
+      return (num_elements + 1) / 2;
+  }
+  return 0;
+}
+
+// The elements of a float32 or float16 array as floats.
+std::vector<float> ReadFloats(const DLTensor* t, int64_t num_elements) {
+  std::vector<float> values(num_elements);
+  const char* data = static_cast<const char*>(t->data) + t->byte_offset;
+  if (t->dtype.bits == 32) {
+    std::memcpy(values.data(), data, num_elements * sizeof(float));
+  } else {
+    const uint16_t* half = reinterpret_cast<const uint16_t*>(data);
+    for (int64_t i = 0; i < num_elements; ++i) {
+      values[i] = __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(half[i]);
+    }
+  }
+  return values;
+}
+
+// Decompress an element on the host, the kernels of the devices do the same.
+float DecompressElement(const CompressedParam& p, const char* base, int64_t i) {
+  const char* data = base + p.data_offset;
+  if (p.header->scheme == CompressionScheme::kFloat16) {
+    uint16_t half;
+    std::memcpy(&half, data + i * sizeof(uint16_t), sizeof(half));
+    return __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(half);
+  }
+  float scale;
+  std::memcpy(&scale, base + p.scales_offset + (i / p.header->block_size) * sizeof(float),
+              sizeof(scale));
+  if (p.header->scheme == CompressionScheme::kInt8) {
+    return static_cast<float>(static_cast<int8_t>(data[i])) * scale;
+  }
+  uint8_t byte = static_cast<uint8_t>(data[i / 2]);
+  int q = (i & 1) ? (byte >> 4) : (byte & 15);
+  return static_cast<float>((q ^ 8) - 8) * scale;
+}
+}  // namespace
+
+bool IsCompressedParam(const NDArray& arr) {
+  const DLTensor* t = arr.operator->();
+  if (t->ctx.device_type != kDLCPU || t->ndim != 1 || t->dtype.code != kDLUInt ||
+      t->dtype.bits != 8 || t->dtype.lanes != 1 ||
+      t->shape[0] < static_cast<int64_t>(sizeof(CompressedParamHeader))) {
+    return false;
+  }
+  uint64_t magic;
+  std::memcpy(&magic, static_cast<const char*>(t->data) + t->byte_offset, sizeof(magic));
+  return magic == kTVMCompressedParamMagic;
+}
+
+CompressedParam ParseCompressedParam(const NDArray& arr) {
+  ICHECK(IsCompressedParam(arr)) << "Not a compressed parameter";
+  const DLTensor* t = arr.operator->();
+  const char* base = static_cast<const char*>(t->data) + t->byte_offset;
+  size_t nbytes = static_cast<size_t>(t->shape[0]);
+  CompressedParam p;
+  p.header = reinterpret_cast<const CompressedParamHeader*>(base);
+  const CompressedParamHeader& h = *p.header;
+  ICHECK(h.scheme == CompressionScheme::kFloat16 || h.scheme == CompressionScheme::kInt8 ||
+         h.scheme == CompressionScheme::kInt4)
+      << "Unknown parameter compression scheme " << static_cast<int>(h.scheme);
+  ICHECK(IsDecompressedType(h.dtype)) << "Invalid compressed parameter type";
+  ICHECK(h.ndim >= 0 && h.block_size > 0) << "Invalid compressed parameter";
+  size_t offset = sizeof(CompressedParamHeader) + sizeof(int64_t) * h.ndim;
+  ICHECK_LE(offset, nbytes) << "Invalid compressed parameter";
+  p.shape.resize(h.ndim);
+  std::memcpy(p.shape.data(), base + sizeof(CompressedParamHeader), sizeof(int64_t) * h.ndim);
+  p.num_elements = 1;
+  for (int64_t dim : p.shape) p.num_elements *= dim;
+  p.num_blocks = h.scheme == CompressionScheme::kFloat16
+                     ? 0
+                     : (p.num_elements + h.block_size - 1) / h.block_size;
+  p.scales_offset = offset;
+  p.data_offset = offset + p.num_blocks * sizeof(float);
+  ICHECK_EQ(nbytes, p.data_offset + GetCompressedDataBytes(h.scheme, p.num_elements))
+      << "Invalid compressed parameter";
+  return p;
+}
+
+NDArray CompressParam(const NDArray& arr, const std::string& scheme, int block_size) {
+  ICHECK(IsDecompressedType(arr->dtype)) << "Only float32 and float16 parameters can be compressed";
+  ICHECK(arr.IsContiguous()) << "Only contiguous parameters can be compressed";
+  ICHECK_GT(block_size, 0);
+  NDArray host = arr->ctx.device_type == kDLCPU ? arr : arr.CopyTo({kDLCPU, 0});
+  CompressedParamHeader h;
+  h.magic = kTVMCompressedParamMagic;
+  h.scheme = GetCompressionScheme(scheme);
+  h.block_size = h.scheme == CompressionScheme::kFloat16 ? 1 : block_size;
+  h.dtype = arr->dtype;
+  h.ndim = arr->ndim;
+  int64_t num_elements = 1;
+  for (int i = 0; i < arr->ndim; ++i) num_elements *= arr->shape[i];
+  int64_t num_blocks = h.scheme == CompressionScheme::kFloat16
+                           ? 0
+                           : (num_elements + block_size - 1) / block_size;
+  size_t scales_offset = sizeof(CompressedParamHeader) + sizeof(int64_t) * h.ndim;
+  size_t data_offset = scales_offset + num_blocks * sizeof(float);
+  size_t nbytes = data_offset + GetCompressedDataBytes(h.scheme, num_elements);
+
+  NDArray out = NDArray::Empty({static_cast<int64_t>(nbytes)}, {kDLUInt, 8, 1}, {kDLCPU, 0});
+  char* base = static_cast<char*>(out->data);
+  std::memset(base, 0, nbytes);
+  std::memcpy(base, &h, sizeof(h));
+  std::memcpy(base + sizeof(h), arr->shape, sizeof(int64_t) * h.ndim);
+  std::vector<float> values = ReadFloats(host.operator->(), num_elements);
+  char* data = base + data_offset;
+  if (h.scheme == CompressionScheme::kFloat16) {
+    for (int64_t i = 0; i < num_elements; ++i) {
+      uint16_t half = __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(values[i]);
+      std::memcpy(data + i * sizeof(uint16_t), &half, sizeof(half));
+    }
+    return out;
+  }
+  // Symmetric quantization, the largest magnitude of a block maps to the largest level.
+  int max_level = h.scheme == CompressionScheme::kInt8 ? 127 : 7;
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t begin = b * block_size, end = std::min(begin + block_size, num_elements);
+    float max_abs = 0.0f;
+    for (int64_t i = begin; i < end; ++i) max_abs = std::max(max_abs, std::fabs(values[i]));
+    float scale = max_abs / max_level;
+    std::memcpy(base + scales_offset + b * sizeof(float), &scale, sizeof(scale));
+    for (int64_t i = begin; i < end; ++i) {
+      int q = scale == 0.0f ? 0 : static_cast<int>(std::lround(values[i] / scale));
+      q = std::min(std::max(q, -max_level), max_level);
+      if (h.scheme == CompressionScheme::kInt8) {
+        data[i] = static_cast<char>(q);
+      } else {
+        data[i / 2] |= static_cast<char>((q & 15) << ((i & 1) * 4));
+      }
+    }
+  }
+  return out;
+}
+
+void DecompressParam(const NDArray& arr, NDArray dst) {
+  CompressedParam p = ParseCompressedParam(arr);
+  ICHECK(TypeEqual(dst->dtype, p.header->dtype))
+      << "The compressed parameter is of type " << DLDataType2String(p.header->dtype)
+      << ", expected " << DLDataType2String(dst->dtype);
+  ICHECK(p.shape == std::vector<int64_t>(dst->shape, dst->shape + dst->ndim))
+      << "The shape of the compressed parameter does not match";
+  // Devices decompress on their side, so that only the compressed bytes are uploaded.
+  std::string name = std::string("device_api.") + DeviceName(dst->ctx.device_type) +
+                     ".decompress_param";
+  if (const PackedFunc* f = Registry::Get(name)) {
+    (*f)(arr, dst);
+    return;
+  }
+  NDArray host = NDArray::Empty(p.shape, dst->dtype, {kDLCPU, 0});
+  const char* base = static_cast<const char*>(arr->data) + arr->byte_offset;
+  if (dst->dtype.bits == 32) {
+    float* out = static_cast<float*>(host->data);
+    for (int64_t i = 0; i < p.num_elements; ++i) out[i] = DecompressElement(p, base, i);
+  } else {
+    uint16_t* out = static_cast<uint16_t*>(host->data);
+    for (int64_t i = 0; i < p.num_elements; ++i) {
+      out[i] = __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(
+          DecompressElement(p, base, i));
+    }
+  }
+  dst.CopyFrom(host);
+}
+
+// Compress the float parameters of a parameter dict, before it is saved.
+TVM_REGISTER_GLOBAL("runtime.CompressParams")
+    .set_body_typed([](Map<String, NDArray> params, String scheme, int block_size) {
+      Map<String, NDArray> compressed;
+      for (const auto& kv : params) {
+        DLDataType dtype = kv.second->dtype;
+        bool skip = !IsDecompressedType(dtype) || (scheme == "float16" && dtype.bits == 16);
+        compressed.Set(kv.first, skip ? kv.second : CompressParam(kv.second, scheme, block_size));
+      }
+      return compressed;
+    });
+
+TVM_REGISTER_GLOBAL("runtime.DecompressParam").set_body_typed([](NDArray arr, NDArray dst) {
+  DecompressParam(arr, dst);
+});
+
+}  // namespace runtime
+}  // namespace tvm
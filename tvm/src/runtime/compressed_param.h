@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file compressed_param.h
+ * \brief Parameters stored compressed in the parameter files and decompressed when loaded.
+ *
+ *  A compressed parameter is a one dimensional uint8 array in the parameter list, holding a
+ *  CompressedParamHeader, the shape of the parameter, the scale of each block for the
+ *  quantized schemes and the compressed elements. It is decompressed into the array of the
+ *  parameter by the runtimes loading the list, on the device of the array when the device
+ *  registers "device_api.<device>.decompress_param", e.g. straight into the texture of a
+ *  weight, and on the host otherwise.
+ */
+#ifndef TVM_RUNTIME_COMPRESSED_PARAM_H_
+#define TVM_RUNTIME_COMPRESSED_PARAM_H_
+
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/ndarray.h>
+
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief The magic of a compressed parameter. */
+constexpr uint64_t kTVMCompressedParamMagic = 0x3E1A5C0F7DC9B2A1;
+
+/*! \brief The compression schemes of the parameters. */
+enum class CompressionScheme : int32_t {
+  /*! \brief Every element stored as a half float. */
+  kFloat16 = 0,
+  /*! \brief Symmetric int8 quantization, with a float scale per block of elements. */
+  kInt8 = 1,
+  /*! \brief Symmetric int4 quantization, two elements per byte, with a float scale per block. */
+  kInt4 = 2,
+};
+
+/*!
+ * \brief The header of a compressed parameter, followed by the int64 shape of the parameter,
+ *  the float scale of each block for the quantized schemes, then the compressed elements.
+ *  The scales and the elements are 4 bytes aligned.
+ */
+struct CompressedParamHeader {
+  uint64_t magic;
+  CompressionScheme scheme;
+  /*! \brief The number of elements sharing a scale. */
+  int32_t block_size;
+  /*! \brief The type of the decompressed parameter, float32 or float16. */
+  DLDataType dtype;
+  int32_t ndim;
+};
+
+/*!
+ * \brief The layout of a compressed parameter.
+ */
+struct CompressedParam {
+  const CompressedParamHeader* header;
+  std::vector<int64_t> shape;
+  int64_t num_elements;
+  int64_t num_blocks;
+  /*! \brief The byte offsets of the scales and of the elements in the array. */
+  size_t scales_offset;
+  size_t data_offset;
+};
+
+/*!
+ * \brief Whether an array of a parameter list holds a compressed parameter.
+ * \param arr The array.
+ */
+bool IsCompressedParam(const NDArray& arr);
+
+/*!
+ * \brief Parse the layout of a compressed parameter.
+ * \param arr The compressed parameter, in host memory.
+ * \return The layout, pointing into the array.
+ */
+CompressedParam ParseCompressedParam(const NDArray& arr);
+
+/*!
+ * \brief Compress a float32 or float16 parameter.
+ * \param arr The parameter.
+ * \param scheme The name of the scheme, "float16", "int8" or "int4".
+ * \param block_size The number of elements sharing a scale in the quantized schemes.
+ * \return The compressed parameter, in host memory.
+ */
+NDArray CompressParam(const NDArray& arr, const std::string& scheme, int block_size);
+
+/*!
+ * \brief Decompress a parameter into an array, e.g. a parameter of a graph.
+ * \param arr The compressed parameter, in host memory.
+ * \param dst The array, of the shape and type of the decompressed parameter.
+ */
+void DecompressParam(const NDArray& arr, NDArray dst);
+
+/*!
+ * \brief Set a parameter of a graph from an array of a parameter list.
+ * \param arr The array, decompressed if it is a compressed parameter.
+ * \param dst The array of the parameter.
+ */
+inline void SetParamFrom(const NDArray& arr, NDArray dst) {
+  if (IsCompressedParam(arr)) {
+    DecompressParam(arr, dst);
+  } else {
+    dst.CopyFrom(arr);
+  }
+}
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_RUNTIME_COMPRESSED_PARAM_H_
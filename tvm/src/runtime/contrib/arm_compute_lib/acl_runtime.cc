@@ -37,6 +37,20 @@
 #include <arm_compute/runtime/NEON/functions/NEFullyConnectedLayer.h>
 #include <arm_compute/runtime/NEON/functions/NEPoolingLayer.h>
 #include <arm_compute/runtime/NEON/functions/NEReshapeLayer.h>
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+#include <arm_compute/runtime/CL/CLBufferAllocator.h>
+#include <arm_compute/runtime/CL/CLScheduler.h>
+#include <arm_compute/runtime/CL/functions/CLConvolutionLayer.h>
+#include <arm_compute/runtime/CL/functions/CLDepthwiseConvolutionLayer.h>
+#include <arm_compute/runtime/CL/functions/CLElementwiseOperations.h>
+#include <arm_compute/runtime/CL/functions/CLFullyConnectedLayer.h>
+#include <arm_compute/runtime/CL/functions/CLPoolingLayer.h>
+#include <arm_compute/runtime/CL/functions/CLReshapeLayer.h>
+
+#include <mutex>
+
+#include "../../opencl/opencl_common.h"
+#endif
 
 #include "acl_allocator.h"
 #include "acl_utils.h"
@@ -48,6 +62,92 @@ namespace contrib {
 
 using namespace tvm::runtime::json;
 
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB
+/*! \brief The NEON functions of acl, running on the CPU over host memory. */
+struct ACLNEFunctions {
+  using Tensor = arm_compute::Tensor;
+  using ConvolutionLayer = arm_compute::NEConvolutionLayer;
+  using DepthwiseConvolutionLayer = arm_compute::NEDepthwiseConvolutionLayer;
+  using FullyConnectedLayer = arm_compute::NEFullyConnectedLayer;
+  using PoolingLayer = arm_compute::NEPoolingLayer;
+  using ReshapeLayer = arm_compute::NEReshapeLayer;
+  using ElementwiseMax = arm_compute::NEElementwiseMax;
+  using ArithmeticAddition = arm_compute::NEArithmeticAddition;
+
+  static Tensor MakeTensor(const JSONGraphNode& node, void* data, const DLTensor* scale,
+                           const DLTensor* offset) {
+    return MakeACLTensor(node, data, scale, offset);
+  }
+
+  static void ImportMemory(Tensor* tensor, const DLTensor* data) {
+    CheckACLError(tensor->allocator()->import_memory(data->data));
+  }
+
+  static std::shared_ptr<arm_compute::MemoryManagerOnDemand> MakeMemoryManager() {
+    return MakeACLMemoryManager();
+  }
+};
+
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+/*!
+ * \brief The OpenCL functions of acl. They run on the context and the queue of the OpenCL
+ * device API, and wrap its cl_mem buffers, so that they are ordered with the TVM kernels
+ * without any copy through the host.
+ */
+struct ACLCLFunctions {
+  using Tensor = arm_compute::CLTensor;
+  using ConvolutionLayer = arm_compute::CLConvolutionLayer;
+  using DepthwiseConvolutionLayer = arm_compute::CLDepthwiseConvolutionLayer;
+  using FullyConnectedLayer = arm_compute::CLFullyConnectedLayer;
+  using PoolingLayer = arm_compute::CLPoolingLayer;
+  using ReshapeLayer = arm_compute::CLReshapeLayer;
+  using ElementwiseMax = arm_compute::CLElementwiseMax;
+  using ArithmeticAddition = arm_compute::CLArithmeticAddition;
+
+  static Tensor MakeTensor(const JSONGraphNode& node, void* data, const DLTensor* scale,
+                           const DLTensor* offset) {
+    return MakeACLCLTensor(node, data, scale, offset);
+  }
+
+  static void ImportMemory(Tensor* tensor, const DLTensor* data) {
+    ICHECK_EQ(data->byte_offset, 0)
+        << "Arm Compute Library OpenCL functions cannot wrap a buffer at an offset";
+    ::cl::Buffer buffer(static_cast<cl_mem>(data->data), true);
+    CheckACLError(tensor->allocator()->import_memory(buffer));
+  }
+
+  static std::shared_ptr<arm_compute::MemoryManagerOnDemand> MakeMemoryManager() {
+    return MakeACLCLMemoryManager();
+  }
+
+  /*!
+   * \brief Point the acl scheduler at the context and the queue of the device. The scheduler
+   * is global to acl, hence all the modules share one OpenCL device.
+   */
+  static void InitScheduler(const TVMContext& ctx) {
+    static std::mutex mutex;
+    static int device_id = -1;
+    std::lock_guard<std::mutex> lock(mutex);
+    runtime::cl::OpenCLWorkspace* workspace = runtime::cl::OpenCLWorkspace::Global();
+    runtime::cl::OpenCLWorkspace::QueueRef queue_ref = workspace->GetQueue(ctx);
+    cl_command_queue queue = queue_ref;
+    arm_compute::CLScheduler& scheduler = arm_compute::CLScheduler::get();
+    if (device_id < 0) {
+      scheduler.init(::cl::Context(workspace->context, true), ::cl::CommandQueue(queue, true),
+                     ::cl::Device(workspace->devices[ctx.device_id], true));
+      device_id = ctx.device_id;
+    }
+    ICHECK_EQ(device_id, ctx.device_id)
+        << "Arm Compute Library OpenCL functions already run on OpenCL device " << device_id;
+    // The queue is recreated when profiling is switched on or off.
+    if (scheduler.queue().get() != queue) {
+      scheduler.set_queue(::cl::CommandQueue(queue, true));
+    }
+  }
+};
+#endif
+#endif
+
 class ACLRuntime : public JSONRuntimeBase {
  public:
   /*!
@@ -84,40 +184,86 @@ class ACLRuntime : public JSONRuntimeBase {
 
 #ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB
   /*!
-   * \brief Unpack inputs and outputs and run inference on a given layer.
-   *
-   * \param args Access inputs and outputs.
-   * \param function The layer to execute inference on.
-   * \return Status of inference.
+   * \brief Unpack inputs and outputs and run inference on a given layer. The layer runs the
+   * OpenCL functions of acl when the outputs are on an OpenCL device, the NEON ones otherwise.
    */
   void Run() override {
+    const DLTensor* output = data_entry_[EntryID(outputs_[0])];
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+    if (output->ctx.device_type == kDLOpenCL) {
+      ACLCLFunctions::InitScheduler(output->ctx);
+      if (!cl_layer_.function) {
+        BuildLayer(&cl_layer_, &cl_allocator_);
+      }
+      RunLayer(&cl_layer_);
+      return;
+    }
+#endif
+    ICHECK_EQ(output->ctx.device_type, kDLCPU)
+        << "Arm Compute Library runtime cannot run on device type " << output->ctx.device_type;
+    if (!layer_.function) {
+      BuildLayer(&layer_, &allocator_);
+    }
+    RunLayer(&layer_);
+  }
+
+ private:
+  /*!
+   * \brief Build the NEON layer up front, unless the device of the layer is only known once it
+   * runs.
+   */
+  void BuildEngine() {
+#ifndef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+    BuildLayer(&layer_, &allocator_);
+#endif
+  }
+
+  /*!
+   * \brief ACL objects we cache in order to avoid needing to construct
+   * a new layer each time.
+   */
+  template <typename F>
+  struct CachedLayer {
+    std::shared_ptr<arm_compute::IFunction> function;
+    std::vector<typename F::Tensor> inputs;
+    std::vector<typename F::Tensor> outputs;
+  };
+
+  /*!
+   * \brief Import the memory of the inputs and outputs into a layer and run it.
+   *
+   * \param layer The layer to run.
+   */
+  template <typename F>
+  void RunLayer(CachedLayer<F>* layer) {
     for (size_t i = 0; i < input_nodes_.size(); ++i) {
       auto nid = input_nodes_[i];
       uint32_t eid = EntryID(nid, 0);
       if (nodes_[nid].GetOpType() == "input") {
-        void* data = data_entry_[eid]->data;
-        CheckACLError(layer_.inputs[i].allocator()->import_memory(data));
+        F::ImportMemory(&layer->inputs[i], data_entry_[eid]);
       }
     }
 
     for (size_t i = 0; i < outputs_.size(); ++i) {
       uint32_t eid = EntryID(outputs_[i]);
-      void* data = data_entry_[eid]->data;
-      CheckACLError(layer_.outputs[i].allocator()->import_memory(data));
+      F::ImportMemory(&layer->outputs[i], data_entry_[eid]);
     }
 
-    this->layer_.function->run();
+    layer->function->run();
   }
 
- private:
   /*!
    * \brief Build ACL layer from JSON representation and cache.
    *
    * \note For the time being only one layer or operator is supported
    * per engine.
+   *
+   * \param layer The layer to build.
+   * \param allocator The allocator of the auxiliary memory of the layer.
    */
-  void BuildEngine() {
-    std::shared_ptr<arm_compute::MemoryManagerOnDemand> mm = MakeACLMemoryManager();
+  template <typename F>
+  void BuildLayer(CachedLayer<F>* layer, arm_compute::IAllocator* allocator) {
+    std::shared_ptr<arm_compute::MemoryManagerOnDemand> mm = F::MakeMemoryManager();
     int num_pools = 0;
     bool found_kernel_node = false;
     for (size_t nid = 0; nid < nodes_.size(); ++nid) {
@@ -130,44 +276,34 @@ class ACLRuntime : public JSONRuntimeBase {
         found_kernel_node = true;
         auto op_name = node.GetOpName();
         if ("nn.conv2d" == op_name || "qnn.conv2d" == op_name) {
-          CreateConvolution2DLayer(&layer_, node, mm);
+          CreateConvolution2DLayer(layer, node, mm);
           num_pools++;
         } else if ("nn.depthwise_conv2d" == op_name || "qnn.depthwise_conv2d" == op_name) {
-          CreateDepthwiseConvolution2DLayer(&layer_, node, mm);
+          CreateDepthwiseConvolution2DLayer(layer, node, mm);
           num_pools++;
         } else if ("nn.dense" == op_name || "qnn.dense" == op_name) {
-          CreateFullyConnectedLayer(&layer_, node, mm);
+          CreateFullyConnectedLayer(layer, node, mm);
           num_pools++;
         } else if ("nn.max_pool2d" == op_name || "nn.avg_pool2d" == op_name ||
                    "nn.l2_pool2d" == op_name) {
-          CreatePoolingLayer(&layer_, node);
+          CreatePoolingLayer(layer, node);
         } else if ("nn.global_max_pool2d" == op_name || "nn.global_avg_pool2d" == op_name) {
-          CreateGlobalPoolingLayer(&layer_, node);
+          CreateGlobalPoolingLayer(layer, node);
         } else if ("reshape" == op_name) {
-          CreateReshapeLayer(&layer_, node);
+          CreateReshapeLayer(layer, node);
         } else if ("maximum" == op_name) {
-          CreateMaximumLayer(&layer_, node);
+          CreateMaximumLayer(layer, node);
         } else if ("add" == op_name || "qnn.add" == op_name) {
-          CreateAddLayer(&layer_, node);
+          CreateAddLayer(layer, node);
         } else {
           LOG(FATAL) << "Unsupported op: " << op_name;
         }
       }
     }
-    this->layer_.function->prepare();
-    if (num_pools > 0) mm->populate(this->allocator_, num_pools);
+    layer->function->prepare();
+    if (num_pools > 0) mm->populate(*allocator, num_pools);
   }
 
-  /*!
-   * \brief ACL objects we cache in order to avoid needing to construct
-   * a new layer each time.
-   */
-  struct CachedLayer {
-    std::shared_ptr<arm_compute::IFunction> function;
-    std::vector<arm_compute::Tensor> inputs;
-    std::vector<arm_compute::Tensor> outputs;
-  };
-
   /*!
    * \brief Create an ACL tensor given the JSON representation. If scale
    * and offset are given, then create a quantized ACL tensor.
@@ -177,15 +313,16 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param offset (optional) The offset of the tensor as an input.
    * \return ACL Tensor.
    */
-  arm_compute::Tensor MakeACLTensorFromJSONEntry(const JSONGraphNodeEntry& tensor,
-                                                 JSONGraphNodeEntry* scale = nullptr,
-                                                 JSONGraphNodeEntry* offset = nullptr) {
+  template <typename F>
+  typename F::Tensor MakeACLTensorFromJSONEntry(const JSONGraphNodeEntry& tensor,
+                                                JSONGraphNodeEntry* scale = nullptr,
+                                                JSONGraphNodeEntry* offset = nullptr) {
     JSONGraphNode node = nodes_[tensor.id_];
     void* node_data = nullptr;
     if (node.GetOpType() == "const") {
       node_data = data_entry_[EntryID(tensor)]->data;
     }
-    return MakeACLTensorFromJSONNode(node, scale, offset, node_data);
+    return MakeACLTensorFromJSONNode<F>(node, scale, offset, node_data);
   }
 
   /*!
@@ -198,17 +335,18 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param data (optional) Constant data of input node.
    * \return ACL Tensor.
    */
-  arm_compute::Tensor MakeACLTensorFromJSONNode(const JSONGraphNode& node,
-                                                JSONGraphNodeEntry* scale = nullptr,
-                                                JSONGraphNodeEntry* offset = nullptr,
-                                                void* data = nullptr) {
+  template <typename F>
+  typename F::Tensor MakeACLTensorFromJSONNode(const JSONGraphNode& node,
+                                               JSONGraphNodeEntry* scale = nullptr,
+                                               JSONGraphNodeEntry* offset = nullptr,
+                                               void* data = nullptr) {
     const DLTensor* scale_data = nullptr;
     const DLTensor* offset_data = nullptr;
     if (scale && offset) {
       scale_data = data_entry_[EntryID(*scale)];
       offset_data = data_entry_[EntryID(*offset)];
     }
-    return MakeACLTensor(node, data, scale_data, offset_data);
+    return F::MakeTensor(node, data, scale_data, offset_data);
   }
 
   /*!
@@ -218,7 +356,8 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param node The JSON representation of the operator.
    * \param mm The ACL conv2d layer can request auxiliary memory from TVM.
    */
-  void CreateConvolution2DLayer(CachedLayer* layer, const JSONGraphNode& node,
+  template <typename F>
+  void CreateConvolution2DLayer(CachedLayer<F>* layer, const JSONGraphNode& node,
                                 const std::shared_ptr<arm_compute::MemoryManagerOnDemand>& mm) {
     std::vector<std::string> padding = node.GetAttr<std::vector<std::string>>("padding");
     std::vector<std::string> strides = node.GetAttr<std::vector<std::string>>("strides");
@@ -226,7 +365,7 @@ class ACLRuntime : public JSONRuntimeBase {
     arm_compute::PadStrideInfo pad_stride_info = MakeACLPadStride(padding, strides);
 
     int groups = std::stoi(node.GetAttr<std::vector<std::string>>("groups")[0]);
-    ICHECK(groups == 1) << "Arm Compute Library NEON convolution only supports group size of 1.";
+    ICHECK(groups == 1) << "Arm Compute Library convolution only supports group size of 1.";
 
     arm_compute::ActivationLayerInfo act_info;
     if (node.HasAttr("activation_type")) {
@@ -244,24 +383,24 @@ class ACLRuntime : public JSONRuntimeBase {
       ICHECK(num_inputs >= 8U && num_inputs <= 9U)
           << "Quantized convolution requires 9 inputs with a bias, 8 inputs without.";
       has_bias = num_inputs == 9;
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[0], &inputs[4], &inputs[2]));
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[1], &inputs[5], &inputs[3]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[0], &inputs[4], &inputs[2]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[1], &inputs[5], &inputs[3]));
       if (has_bias) {
-        layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[6]));
+        layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[6]));
       }
       layer->outputs.push_back(
-          MakeACLTensorFromJSONNode(node, &inputs[6 + has_bias], &inputs[7 + has_bias]));
+          MakeACLTensorFromJSONNode<F>(node, &inputs[6 + has_bias], &inputs[7 + has_bias]));
     } else {
       ICHECK(num_inputs >= 2U && num_inputs <= 3U)
           << "Convolution requires 3 inputs with a bias, 2 inputs without.";
       has_bias = num_inputs == 3;
       for (const auto& i : inputs) {
-        layer->inputs.push_back(MakeACLTensorFromJSONEntry(i));
+        layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(i));
       }
-      layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
+      layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
     }
 
-    auto function = std::make_shared<arm_compute::NEConvolutionLayer>(mm);
+    auto function = std::make_shared<typename F::ConvolutionLayer>(mm);
     function->configure(&layer->inputs[0], &layer->inputs[1],
                         has_bias ? &layer->inputs[2] : nullptr, &layer->outputs[0], pad_stride_info,
                         arm_compute::WeightsInfo(), dilation_2d, act_info);
@@ -275,8 +414,9 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param node The JSON representation of the operator.
    * \param mm The ACL conv2d layer can request auxiliary memory from TVM.
    */
+  template <typename F>
   void CreateDepthwiseConvolution2DLayer(
-      CachedLayer* layer, const JSONGraphNode& node,
+      CachedLayer<F>* layer, const JSONGraphNode& node,
       const std::shared_ptr<arm_compute::MemoryManagerOnDemand>& mm) {
     std::vector<std::string> padding = node.GetAttr<std::vector<std::string>>("padding");
     std::vector<std::string> strides = node.GetAttr<std::vector<std::string>>("strides");
@@ -299,27 +439,27 @@ class ACLRuntime : public JSONRuntimeBase {
       ICHECK(num_inputs >= 8U && num_inputs <= 9U)
           << "Quantized convolution requires 9 inputs with a bias, 8 inputs without.";
       has_bias = num_inputs == 9;
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[0], &inputs[4], &inputs[2]));
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[1], &inputs[5], &inputs[3]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[0], &inputs[4], &inputs[2]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[1], &inputs[5], &inputs[3]));
       if (has_bias) {
-        layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[6]));
+        layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[6]));
       }
       layer->outputs.push_back(
-          MakeACLTensorFromJSONNode(node, &inputs[6 + has_bias], &inputs[7 + has_bias]));
+          MakeACLTensorFromJSONNode<F>(node, &inputs[6 + has_bias], &inputs[7 + has_bias]));
     } else {
       ICHECK(num_inputs >= 2U && num_inputs <= 3U)
           << "Convolution requires 3 inputs with a bias, 2 inputs without.";
       has_bias = num_inputs == 3;
       for (const auto& i : inputs) {
-        layer->inputs.push_back(MakeACLTensorFromJSONEntry(i));
+        layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(i));
       }
-      layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
+      layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
     }
 
     // Depth multiplier is the final dimension in acl weights tensor (IWH*M*)
     int depth_multiplier = layer->inputs[1].info()->tensor_shape()[3];
 
-    auto function = std::make_shared<arm_compute::NEDepthwiseConvolutionLayer>(mm);
+    auto function = std::make_shared<typename F::DepthwiseConvolutionLayer>(mm);
     function->configure(&layer->inputs[0], &layer->inputs[1],
                         has_bias ? &layer->inputs[2] : nullptr, &layer->outputs[0], pad_stride_info,
                         depth_multiplier, act_info, dilation_2d);
@@ -333,7 +473,8 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param node The JSON representation of the operator.
    * \param mm The ACL fully connected layer can request auxiliary memory from TVM.
    */
-  void CreateFullyConnectedLayer(CachedLayer* layer, const JSONGraphNode& node,
+  template <typename F>
+  void CreateFullyConnectedLayer(CachedLayer<F>* layer, const JSONGraphNode& node,
                                  const std::shared_ptr<arm_compute::MemoryManagerOnDemand>& mm) {
     arm_compute::FullyConnectedLayerInfo fc_info;
     fc_info.set_weights_trained_layout(arm_compute::DataLayout::NHWC);
@@ -347,24 +488,24 @@ class ACLRuntime : public JSONRuntimeBase {
           << "Quantized fully connected (dense) layer requires 9 inputs with a bias, 8 inputs "
              "without.";
       has_bias = num_inputs == 9;
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[0], &inputs[4], &inputs[2]));
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[1], &inputs[5], &inputs[3]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[0], &inputs[4], &inputs[2]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[1], &inputs[5], &inputs[3]));
       if (has_bias) {
-        layer->inputs.push_back(MakeACLTensorFromJSONEntry(inputs[6]));
+        layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(inputs[6]));
       }
       layer->outputs.push_back(
-          MakeACLTensorFromJSONNode(node, &inputs[6 + has_bias], &inputs[7 + has_bias]));
+          MakeACLTensorFromJSONNode<F>(node, &inputs[6 + has_bias], &inputs[7 + has_bias]));
     } else {
       ICHECK(num_inputs >= 2U && num_inputs <= 3U)
           << "Fully connected (dense) layer requires 3 inputs with a bias, 2 inputs without.";
       has_bias = num_inputs == 3;
       for (const auto& i : inputs) {
-        layer->inputs.push_back(MakeACLTensorFromJSONEntry(i));
+        layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(i));
       }
-      layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
+      layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
     }
 
-    auto function = std::make_shared<arm_compute::NEFullyConnectedLayer>(mm);
+    auto function = std::make_shared<typename F::FullyConnectedLayer>(mm);
     function->configure(&layer->inputs[0], &layer->inputs[1],
                         has_bias ? &layer->inputs[2] : nullptr, &layer->outputs[0], fc_info);
     layer->function = function;
@@ -378,7 +519,8 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param layer The ACL layer to build. Containing inputs, outputs and the ACL function.
    * \param node The JSON representation of the operator.
    */
-  void CreatePoolingLayer(CachedLayer* layer, const JSONGraphNode& node) {
+  template <typename F>
+  void CreatePoolingLayer(CachedLayer<F>* layer, const JSONGraphNode& node) {
     std::vector<std::string> padding = node.GetAttr<std::vector<std::string>>("padding");
     std::vector<std::string> strides = node.GetAttr<std::vector<std::string>>("strides");
     bool ceil_mode = std::stoi(node.GetAttr<std::vector<std::string>>("ceil_mode")[0]);
@@ -412,10 +554,10 @@ class ACLRuntime : public JSONRuntimeBase {
         arm_compute::PoolingLayerInfo(pool_type, arm_compute::Size2D(pool_size_h, pool_size_w),
                                       arm_compute::DataLayout::NHWC, pad_stride_info, exclude_pad);
 
-    layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[0]));
-    layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
+    layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[0]));
+    layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
 
-    auto function = std::make_shared<arm_compute::NEPoolingLayer>();
+    auto function = std::make_shared<typename F::PoolingLayer>();
     function->configure(&layer->inputs[0], &layer->outputs[0], pool_info);
     layer->function = function;
   }
@@ -428,7 +570,8 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param layer The ACL layer to build. Containing inputs, outputs and the ACL function.
    * \param node The JSON representation of the operator.
    */
-  void CreateGlobalPoolingLayer(CachedLayer* layer, const JSONGraphNode& node) {
+  template <typename F>
+  void CreateGlobalPoolingLayer(CachedLayer<F>* layer, const JSONGraphNode& node) {
     arm_compute::PoolingType pool_type;
     if (node.GetOpName() == "nn.global_max_pool2d") {
       pool_type = arm_compute::PoolingType::MAX;
@@ -441,10 +584,10 @@ class ACLRuntime : public JSONRuntimeBase {
     arm_compute::PoolingLayerInfo pool_info =
         arm_compute::PoolingLayerInfo(pool_type, arm_compute::DataLayout::NHWC);
 
-    layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[0]));
-    layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
+    layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[0]));
+    layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
 
-    auto function = std::make_shared<arm_compute::NEPoolingLayer>();
+    auto function = std::make_shared<typename F::PoolingLayer>();
     function->configure(&layer->inputs[0], &layer->outputs[0], pool_info);
     layer->function = function;
   }
@@ -455,10 +598,11 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param layer The ACL layer to build. Containing inputs, outputs and the ACL function.
    * \param node The JSON representation of the operator.
    */
-  void CreateReshapeLayer(CachedLayer* layer, const JSONGraphNode& node) {
-    layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[0]));
-    layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
-    auto function = std::make_shared<arm_compute::NEReshapeLayer>();
+  template <typename F>
+  void CreateReshapeLayer(CachedLayer<F>* layer, const JSONGraphNode& node) {
+    layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[0]));
+    layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
+    auto function = std::make_shared<typename F::ReshapeLayer>();
     function->configure(&layer->inputs[0], &layer->outputs[0]);
     layer->function = function;
   }
@@ -469,11 +613,12 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param layer The ACL layer to build. Containing inputs, outputs and the ACL function.
    * \param node The JSON representation of the operator.
    */
-  void CreateMaximumLayer(CachedLayer* layer, const JSONGraphNode& node) {
-    layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[0]));
-    layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[1]));
-    layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
-    auto function = std::make_shared<arm_compute::NEElementwiseMax>();
+  template <typename F>
+  void CreateMaximumLayer(CachedLayer<F>* layer, const JSONGraphNode& node) {
+    layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[0]));
+    layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[1]));
+    layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
+    auto function = std::make_shared<typename F::ElementwiseMax>();
     function->configure(&layer->inputs[0], &layer->inputs[1], &layer->outputs[0]);
     layer->function = function;
   }
@@ -483,24 +628,25 @@ class ACLRuntime : public JSONRuntimeBase {
    * \param layer The ACL layer to build. Containing inputs, outputs and the ACL function.
    * \param node  The JSON representation of the operator.
    */
-  void CreateAddLayer(CachedLayer* layer, const JSONGraphNode& node) {
+  template <typename F>
+  void CreateAddLayer(CachedLayer<F>* layer, const JSONGraphNode& node) {
     auto op_name = node.GetOpName();
     if ("add" == op_name) {
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[0]));
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[1]));
-      layer->outputs.push_back(MakeACLTensorFromJSONNode(node));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[0]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(node.GetInputs()[1]));
+      layer->outputs.push_back(MakeACLTensorFromJSONNode<F>(node));
     } else if ("qnn.add" == op_name) {
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[0], &node.GetInputs()[2],
-                                                         &node.GetInputs()[3]));
-      layer->inputs.push_back(MakeACLTensorFromJSONEntry(node.GetInputs()[1], &node.GetInputs()[4],
-                                                         &node.GetInputs()[5]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(
+          node.GetInputs()[0], &node.GetInputs()[2], &node.GetInputs()[3]));
+      layer->inputs.push_back(MakeACLTensorFromJSONEntry<F>(
+          node.GetInputs()[1], &node.GetInputs()[4], &node.GetInputs()[5]));
       layer->outputs.push_back(
-          MakeACLTensorFromJSONNode(node, &node.GetInputs()[6], &node.GetInputs()[7]));
+          MakeACLTensorFromJSONNode<F>(node, &node.GetInputs()[6], &node.GetInputs()[7]));
     } else {
       throw std::runtime_error("Unsupported form of add op: " + op_name);
     }
 
-    auto f = std::make_shared<arm_compute::NEArithmeticAddition>();
+    auto f = std::make_shared<typename F::ArithmeticAddition>();
 
     // SATURATE is used as add_QASYMM8_QASYMM8_QASYMM8 always saturates result
     f->configure(&layer->inputs[0], &layer->inputs[1], &layer->outputs[0],
@@ -514,7 +660,13 @@ class ACLRuntime : public JSONRuntimeBase {
    * \brief The network layers represented by acl functions.
    * \note Currently only supports a single layer.
    */
-  CachedLayer layer_;
+  CachedLayer<ACLNEFunctions> layer_;
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+  /*! \brief The auxiliary memory of the OpenCL functions, buffers of the shared context. */
+  arm_compute::CLBufferAllocator cl_allocator_;
+  /*! \brief The layer represented by acl OpenCL functions, built on its first run. */
+  CachedLayer<ACLCLFunctions> cl_layer_;
+#endif
 #else
   void Run() override {
     LOG(FATAL) << "Cannot call run on Arm Compute Library module without runtime enabled. "
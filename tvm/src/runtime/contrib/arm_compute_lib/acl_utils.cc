@@ -24,10 +24,13 @@
 
 #include "acl_utils.h"
 
+#include <arm_compute/runtime/BlobLifetimeManager.h>
 #include <arm_compute/runtime/OffsetLifetimeManager.h>
 #include <arm_compute/runtime/PoolManager.h>
 #include <tvm/runtime/data_type.h>
 
+#include <cstring>
+
 namespace tvm {
 namespace runtime {
 namespace contrib {
@@ -53,6 +56,33 @@ arm_compute::Tensor MakeACLTensor(const JSONGraphNode& tensor_rep, void* data,
   return tensor;
 }
 
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+arm_compute::CLTensor MakeACLCLTensor(const JSONGraphNode& tensor_rep, const void* data,
+                                      const DLTensor* scale, const DLTensor* offset) {
+  arm_compute::CLTensor tensor;
+  std::vector<int64_t> shape = tensor_rep.GetOpShape()[0];
+  DLDataType dtype = tensor_rep.GetOpDataType()[0];
+  arm_compute::TensorInfo info = MakeACLTensorInfo(shape, dtype, scale, offset);
+  info.set_is_resizable(false);
+  tensor.allocator()->init(info);
+  if (data != nullptr) {
+    // Constants live in host memory, they are copied once into a buffer of the context.
+    tensor.allocator()->allocate();
+    tensor.map(true);
+    memcpy(tensor.buffer(), data, info.total_size());
+    tensor.unmap();
+  }
+  return tensor;
+}
+
+std::shared_ptr<arm_compute::MemoryManagerOnDemand> MakeACLCLMemoryManager() {
+  // OpenCL buffers cannot be offset into, every blob of the pool is a separate buffer.
+  auto lifetime_mgr = std::make_shared<arm_compute::BlobLifetimeManager>();
+  auto pool_mgr = std::make_shared<arm_compute::PoolManager>();
+  return std::make_shared<arm_compute::MemoryManagerOnDemand>(lifetime_mgr, pool_mgr);
+}
+#endif
+
 arm_compute::TensorInfo MakeACLTensorInfo(const std::vector<int64_t>& shape,
                                           const DLDataType& dtype, const DLTensor* scale,
                                           const DLTensor* offset) {
@@ -28,6 +28,9 @@
 #include <arm_compute/core/Types.h>
 #include <arm_compute/runtime/MemoryManagerOnDemand.h>
 #include <arm_compute/runtime/Tensor.h>
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+#include <arm_compute/runtime/CL/CLTensor.h>
+#endif
 
 #include <memory>
 #include <string>
@@ -66,6 +69,30 @@ arm_compute::Tensor MakeACLTensor(const JSONGraphNode& tensor_rep, void* data =
                                   const DLTensor* scale = nullptr,
                                   const DLTensor* offset = nullptr);
 
+#ifdef TVM_GRAPH_RUNTIME_ARM_COMPUTE_LIB_CL
+/*!
+ * \brief Make an acl OpenCL tensor from JSON tensor representation. The OpenCL scheduler of
+ * acl must be initialized.
+ *
+ * \param tensor_rep A JSON tensor representation.
+ * \param data (optional) Host data copied into a buffer of the tensor, for constants.
+ * \param scale (optional) The quantization scale.
+ * \param offset (optional) The quantization offset.
+ * \return arm_compute::CLTensor.
+ */
+arm_compute::CLTensor MakeACLCLTensor(const JSONGraphNode& tensor_rep, const void* data = nullptr,
+                                      const DLTensor* scale = nullptr,
+                                      const DLTensor* offset = nullptr);
+
+/*!
+ * \brief Create a memory manager for use with an OpenCL layer that
+ * requires working memory.
+ *
+ * \return reference counted memory manager.
+ */
+std::shared_ptr<arm_compute::MemoryManagerOnDemand> MakeACLCLMemoryManager();
+#endif
+
 /*!
  * \brief Make an acl tensor info object from JSON tensor
  * representation.
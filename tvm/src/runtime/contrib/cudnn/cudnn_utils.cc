@@ -108,7 +108,13 @@ CuDNNThreadEntry::~CuDNNThreadEntry() { CUDNN_CALL(cudnnDestroy(handle)); }
 
 typedef dmlc::ThreadLocalStore<CuDNNThreadEntry> CuDNNThreadStore;
 
-CuDNNThreadEntry* CuDNNThreadEntry::ThreadLocal() { return CuDNNThreadStore::Get(); }
+CuDNNThreadEntry* CuDNNThreadEntry::ThreadLocal() {
+  // Follow the stream set by TVMSetStream, e.g. the one the graph runtime issues the node on.
+  auto stream = runtime::CUDAThreadEntry::ThreadLocal()->stream;
+  CuDNNThreadEntry* retval = CuDNNThreadStore::Get();
+  CUDNN_CALL(cudnnSetStream(retval->handle, stream));
+  return retval;
+}
 
 // ConvEntry
 
@@ -27,6 +27,9 @@
 
 #include <cstddef>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../json/json_node.h"
@@ -52,6 +55,7 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
   const char* type_key() const { return "dnnl_json"; }
 
   void Init(const Array<NDArray>& consts) override {
+    PlanScratch();
     BuildEngine();
 
     ICHECK_EQ(consts.size(), const_idx_.size())
@@ -59,17 +63,31 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
 
     // Setup constants entries for weights.
     SetupConstants(consts);
+
+    // The constants are copied, and reordered to the layouts the primitives chose, only once.
+    for (size_t i = 0; i < input_nodes_.size(); ++i) {
+      if (nodes_[input_nodes_[i]].GetOpType() == "const") {
+        CopyInputToDNNLMemory(EntryID(input_nodes_[i], 0));
+      }
+    }
+    for (size_t i = 0; i < const_reorders_.size(); ++i) {
+      const_reorders_[i].first.execute(stream_, const_reorders_[i].second);
+    }
+    stream_.wait();
   }
 
   void Run() override {
-    // Fill in the input buffers.
+    // Point the intermediates at the scratch arena, which is allocated on the first run.
+    for (auto& it : scratch_mem_) {
+      const DLTensor* tensor = data_entry_[it.first];
+      it.second.set_data_handle(static_cast<char*>(tensor->data) + tensor->byte_offset);
+    }
+
+    // Fill in the input buffers, the constants are already in place.
     for (size_t i = 0; i < input_nodes_.size(); ++i) {
-      auto eid = EntryID(input_nodes_[i], 0);
-      // TODO(@comaniac): Support other data lengths.
-      size_t offset_in_bytes = entry_out_mem_[eid].second * 4;
-      size_t buffer_size = GetDataSize(*data_entry_[eid]);
-      write_to_dnnl_memory(data_entry_[eid]->data, entry_out_mem_[eid].first, buffer_size,
-                           offset_in_bytes);
+      if (nodes_[input_nodes_[i]].GetOpType() == "input") {
+        CopyInputToDNNLMemory(EntryID(input_nodes_[i], 0));
+      }
     }
 
     // Invoke the engine through intepreting the stream.
@@ -89,6 +107,15 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
   }
 
  private:
+  // Copy the content of an input or constant entry to its DNNL memory.
+  void CopyInputToDNNLMemory(uint32_t eid) {
+    // TODO(@comaniac): Support other data lengths.
+    size_t offset_in_bytes = entry_out_mem_[eid].second * 4;
+    size_t buffer_size = GetDataSize(*data_entry_[eid]);
+    write_to_dnnl_memory(data_entry_[eid]->data, entry_out_mem_[eid].first, buffer_size,
+                         offset_in_bytes);
+  }
+
   // Build up the engine based on the input graph.
   void BuildEngine() {
     engine_ = dnnl::engine(dnnl::engine::kind::cpu, 0);
@@ -119,6 +146,48 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
         }
       }
     }
+
+    // The outputs are read in their plain layout.
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      auto eid = EntryID(outputs_[i]);
+      auto shape = nodes_[outputs_[i].id_].GetOpShape()[outputs_[i].index_];
+      auto plain_md = GenDNNLMemDescByShape(shape, dt::f32);
+      if (entry_out_mem_[eid].first.get_desc() != plain_md) {
+        dnnl::memory plain_mem = GetMemoryInLayout(outputs_[i], plain_md);
+        entry_out_mem_[eid] = {plain_mem, 0};
+      }
+    }
+  }
+
+  // Get the layout of an entry: the one of its memory when a primitive already produced it,
+  // otherwise the plain layout the inputs and constants are given in.
+  dnnl::memory::desc GetLayout(const JSONGraphNodeEntry& entry) {
+    auto eid = EntryID(entry);
+    if (entry_out_mem_.count(eid)) return entry_out_mem_[eid].first.get_desc();
+    return GenDNNLMemDescByShape(nodes_[entry.id_].GetOpShape()[entry.index_], dt::f32);
+  }
+
+  // Get the memory of an entry in the given layout. The inputs and constants not bound yet are
+  // bound in their plain layout. When the layouts differ a reorder is added to the network, or
+  // run once at Init for the constants, and shared by all the consumers of the layout.
+  dnnl::memory GetMemoryInLayout(const JSONGraphNodeEntry& entry, const dnnl::memory::desc& md) {
+    auto eid = EntryID(entry);
+    dnnl::memory src = BindDNNLMemory(entry, GetLayout(entry));
+    if (src.get_desc() == md) return src;
+    for (const auto& it : reordered_mem_) {
+      if (std::get<0>(it) == eid && std::get<1>(it) == md) return std::get<2>(it);
+    }
+    ICHECK_EQ(entry_out_mem_[eid].second, 0) << "Cannot reorder a memory shared by entries";
+    dnnl::memory dst(md, engine_);
+    std::unordered_map<int, dnnl::memory> args{{DNNL_ARG_FROM, src}, {DNNL_ARG_TO, dst}};
+    if (nodes_[entry.id_].GetOpType() == "const") {
+      const_reorders_.emplace_back(dnnl::reorder(src, dst), args);
+    } else {
+      net_.push_back(dnnl::reorder(src, dst));
+      net_args_.push_back(args);
+    }
+    reordered_mem_.emplace_back(eid, md, dst);
+    return dst;
   }
 
   // Bind a JSON graph node entry to a DNNL memory.
@@ -126,6 +195,14 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
                               size_t offset = 0) {
     auto eid = EntryID(entry);
     if (entry_out_mem_.count(eid) == 0) {
+      // The intermediates are only read by the primitives of this engine, whatever their
+      // layout they can take the planned scratch entry when they fit in it.
+      if (scratch_offset_[eid] >= 0 && offset == 0 &&
+          mem_desc.get_size() <= GetDataSize(scratch_tensors_[eid])) {
+        dnnl::memory mem(mem_desc, engine_, DNNL_MEMORY_NONE);
+        scratch_mem_.emplace_back(eid, mem);
+        return BindDNNLMemory(entry, mem, offset);
+      }
       return BindDNNLMemory(entry, dnnl::memory(mem_desc, engine_), offset);
     }
     return entry_out_mem_[eid].first;
@@ -188,11 +265,12 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     dnnl::memory::dims padding_dims_l = {PH_L, PW_L};
     dnnl::memory::dims padding_dims_r = {PH_R, PW_R};
 
-    // Memory descriptions.
+    // Memory descriptions. The primitive picks the layouts, usually blocked ones, which are kept
+    // between the primitives and only reordered where a consumer needs another one.
     auto conv_src_md = dnnl::memory::desc(src_dims, dt::f32, tag::any);
     auto conv_weights_md = dnnl::memory::desc(weights_dims, dt::f32, tag::any);
-    auto conv_bias_md = dnnl::memory::desc(bias_dims, dt::f32, tag::any);
-    auto conv_dst_md = dnnl::memory::desc(dst_dims, dt::f32, tag::nchw);
+    auto conv_bias_md = dnnl::memory::desc(bias_dims, dt::f32, tag::x);
+    auto conv_dst_md = dnnl::memory::desc(dst_dims, dt::f32, tag::any);
 
     // Covn2d description.
     auto conv_desc = dnnl::convolution_forward::desc(
@@ -209,18 +287,18 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
 
     auto conv2d_prim_desc = dnnl::convolution_forward::primitive_desc(conv_desc, attr, engine_);
 
-    // Push to the network.
-    auto conv = dnnl::convolution_forward(conv2d_prim_desc);
-    net_.push_back(conv);
-
     // Data memory.
     ICHECK_EQ(node.GetAttr<std::vector<std::string>>("data_layout")[0], "NCHW");
-    auto conv2d_src_memory = BindDNNLMemory(data_entry, {src_dims, dt::f32, tag::nchw});
+    auto conv2d_src_memory = GetMemoryInLayout(data_entry, conv2d_prim_desc.src_desc());
 
-    // Weight memory.
+    // Weight memory, given in the plain layout and reordered once.
     ICHECK_EQ(node.GetAttr<std::vector<std::string>>("kernel_layout")[0], "OIHW");
-    auto conv2d_weights_memory = BindDNNLMemory(
-        weight_entry, {weights_dims, dt::f32, (groups > 1) ? tag::goihw : tag::oihw});
+    if (entry_out_mem_.count(EntryID(weight_entry)) == 0) {
+      BindDNNLMemory(weight_entry,
+                     {weights_dims, dt::f32, (groups > 1) ? tag::goihw : tag::oihw});
+    }
+    auto conv2d_weights_memory =
+        GetMemoryInLayout(weight_entry, conv2d_prim_desc.weights_desc());
 
     // Bias memory.
     auto conv2d_bias_memory = dnnl::memory({bias_dims, dt::f32, tag::x}, engine_);
@@ -236,7 +314,8 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     JSONGraphNodeEntry out_entry(nid, 0);
     auto conv2d_dst_memory = BindDNNLMemory(out_entry, conv2d_prim_desc.dst_desc());
 
-    // Bind memory buffers.
+    // Push to the network, after the reorders of its inputs.
+    net_.push_back(dnnl::convolution_forward(conv2d_prim_desc));
     net_args_.push_back({{DNNL_ARG_SRC, conv2d_src_memory},
                          {DNNL_ARG_WEIGHTS, conv2d_weights_memory},
                          {DNNL_ARG_BIAS, conv2d_bias_memory},
@@ -264,7 +343,7 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
 
     // Memory descriptions.
     auto data_md = dnnl::memory::desc({data_dims, dt::f32, tag::nc});
-    auto weight_md = dnnl::memory::desc({weight_dims, dt::f32, tag::nc});
+    auto weight_md = dnnl::memory::desc({weight_dims, dt::f32, tag::any});
     auto bias_md = dnnl::memory::desc({bias_dims, dt::f32, tag::x});
     auto dst_md = dnnl::memory::desc({out_dims, dt::f32, tag::nc});
 
@@ -273,18 +352,16 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
                                                         weight_md, bias_md, dst_md);
     auto dense_prim_desc = dnnl::inner_product_forward::primitive_desc(dense_desc, engine_);
 
-    auto dense = dnnl::inner_product_forward(dense_prim_desc);
-    net_.push_back(dense);
-
-    // Memories.
-    auto data_memory = BindDNNLMemory(data_entry, data_md);
-    auto weight_memory = BindDNNLMemory(weight_entry, weight_md);
+    // Memories, the weights are reordered once to the layout of the primitive.
+    auto data_memory = GetMemoryInLayout(data_entry, data_md);
+    auto weight_memory = GetMemoryInLayout(weight_entry, dense_prim_desc.weights_desc());
     auto bias_memory = dnnl::memory(bias_md, engine_);
     float bias[OC] = {0};
     write_to_dnnl_memory(bias, bias_memory, OC * sizeof(float));
     JSONGraphNodeEntry out_entry(nid, 0);
     auto dst_memory = BindDNNLMemory(out_entry, dense_prim_desc.dst_desc());
 
+    net_.push_back(dnnl::inner_product_forward(dense_prim_desc));
     net_args_.push_back({{DNNL_ARG_SRC, data_memory},
                          {DNNL_ARG_WEIGHTS, weight_memory},
                          {DNNL_ARG_BIAS, bias_memory},
@@ -303,19 +380,17 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     dnnl::memory::dim IC = data_shape[1];
     float epsilon = std::stof(node.GetAttr<std::vector<std::string>>("epsilon")[0]);
 
-    // Memory description.
-    dnnl::memory::desc data_md = GenDNNLMemDescByShape(data_shape, dt::f32);
+    // Memory description, in the layout of the producer.
+    dnnl::memory::desc data_md = GetLayout(data_entry);
 
     // BN description.
     auto bn_desc = dnnl::batch_normalization_forward::desc(
         dnnl::prop_kind::forward_inference, data_md, epsilon,
         dnnl::normalization_flags::use_global_stats | dnnl::normalization_flags::use_scale_shift);
     auto bn_prim_desc = dnnl::batch_normalization_forward::primitive_desc(bn_desc, engine_);
-    auto bn = dnnl::batch_normalization_forward(bn_prim_desc);
-    net_.push_back(bn);
 
     // Memories.
-    auto data_memory = BindDNNLMemory(data_entry, data_md);
+    auto data_memory = GetMemoryInLayout(data_entry, data_md);
     JSONGraphNodeEntry out_entry(nid, 0);
     auto out_memory = BindDNNLMemory(out_entry, data_md);
     auto mean_memory = BindDNNLMemory(mean_entry, bn_prim_desc.mean_desc());
@@ -326,6 +401,7 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     auto weight_memory = BindDNNLMemory(gamma_entry, bn_prim_desc.weights_desc(), 0);
     BindDNNLMemory(beta_entry, weight_memory, IC);
 
+    net_.push_back(dnnl::batch_normalization_forward(bn_prim_desc));
     net_args_.push_back({{DNNL_ARG_SRC, data_memory},
                          {DNNL_ARG_DST, out_memory},
                          {DNNL_ARG_SCALE_SHIFT, weight_memory},
@@ -337,22 +413,19 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     auto node = nodes_[nid];
 
     auto data_entry = node.GetInputs()[0];
-    dnnl::memory::dims shape = nodes_[data_entry.id_].GetOpShape()[data_entry.index_];
-    auto data_md = dnnl::memory::desc{{shape}, dt::f32, tag::abcd};
+    // Element-wise, in the layout of the producer.
+    auto data_md = GetLayout(data_entry);
 
     auto relu_desc = dnnl::eltwise_forward::desc(dnnl::prop_kind::forward_inference,
                                                  dnnl::algorithm::eltwise_relu, data_md, 0);
     auto relu_prim_desc = dnnl::eltwise_forward::primitive_desc(relu_desc, engine_);
     ICHECK(data_md == relu_prim_desc.dst_desc());
 
-    auto relu = dnnl::eltwise_forward(relu_prim_desc);
-    net_.push_back(relu);
-
-    auto data_memory = BindDNNLMemory(data_entry, data_md);
-    auto out_md = dnnl::memory::desc(shape, dt::f32, tag::abcd);
+    auto data_memory = GetMemoryInLayout(data_entry, data_md);
     JSONGraphNodeEntry out_entry(nid, 0);
-    auto out_memory = BindDNNLMemory(out_entry, out_md);
+    auto out_memory = BindDNNLMemory(out_entry, data_md);
 
+    net_.push_back(dnnl::eltwise_forward(relu_prim_desc));
     net_args_.push_back({{DNNL_ARG_SRC, data_memory}, {DNNL_ARG_DST, out_memory}});
   }
 
@@ -364,14 +437,14 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     std::vector<dnnl::memory::desc> data_mds;
     std::vector<dnnl::memory> data_memories;
 
+    // Both inputs in the layout of the first one.
     ICHECK_EQ(node.GetInputs().size(), 2U);
+    dnnl::memory::desc data_md = GetLayout(node.GetInputs()[0]);
     for (auto entry : node.GetInputs()) {
       auto data_shape = nodes_[entry.id_].GetOpShape()[entry.index_];
-      dnnl::memory::desc data_md = GenDNNLMemDescByShape(data_shape, dt::f32);
-
       data_dims.push_back(data_shape);
       data_mds.push_back(data_md);
-      data_memories.push_back(BindDNNLMemory(entry, data_md));
+      data_memories.push_back(GetMemoryInLayout(entry, data_md));
     }
     ICHECK(data_dims[0] == data_dims[1]);
     auto out_md = data_mds[0];
@@ -381,9 +454,8 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
     auto add_desc =
         dnnl::binary::desc(dnnl::algorithm::binary_add, data_mds[0], data_mds[1], out_md);
     auto add_prim_desc = dnnl::binary::primitive_desc(add_desc, engine_);
-    auto add = dnnl::binary(add_prim_desc);
-    net_.push_back(add);
 
+    net_.push_back(dnnl::binary(add_prim_desc));
     net_args_.push_back({{DNNL_ARG_SRC_0, data_memories[0]},
                          {DNNL_ARG_SRC_1, data_memories[1]},
                          {DNNL_ARG_DST, out_memory}});
@@ -408,6 +480,9 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
   inline dnnl::memory::desc GenDNNLMemDescByShape(const dnnl::memory::dims& shape, dt dtype) {
     dnnl::memory::desc data_md;
     switch (shape.size()) {
+      case 1:
+        data_md = dnnl::memory::desc({shape, dtype, tag::a});
+        break;
       case 2:
         data_md = dnnl::memory::desc({shape, dtype, tag::ab});
         break;
@@ -437,6 +512,12 @@ class DNNLJSONRuntime : public JSONRuntimeBase {
   std::vector<std::unordered_map<int, dnnl::memory>> net_args_;
   /* The entry ID to its corresponding output memory. */
   std::unordered_map<uint32_t, std::pair<dnnl::memory, size_t>> entry_out_mem_;
+  /* The memory of the intermediates placed in the scratch arena, by entry ID. */
+  std::vector<std::pair<uint32_t, dnnl::memory>> scratch_mem_;
+  /* The entries reordered to another layout, with the layout and the reordered memory. */
+  std::vector<std::tuple<uint32_t, dnnl::memory::desc, dnnl::memory>> reordered_mem_;
+  /* The reorders of the constants, run once at Init. */
+  std::vector<std::pair<dnnl::primitive, std::unordered_map<int, dnnl::memory>>> const_reorders_;
 };
 
 runtime::Module DNNLJSONRuntimeCreate(String symbol_name, String graph_json,
@@ -29,8 +29,10 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 
+#include "ethosn_device.h"
 #include "ethosn_driver_library/Buffer.hpp"
 #include "ethosn_support_library/Support.hpp"
 
@@ -72,17 +74,12 @@ bool WaitForInference(dl::Inference* inference, int timeout) {
   return true;
 }
 
-template <typename T>
-void CopyOutput(dl::Buffer* source_buffers[], std::vector<DLTensor*>* outputs) {
-  for (DLTensor* tensor : *outputs) {
-    dl::Buffer* source_buffer = source_buffers[0];
-    uint8_t* source_buffer_data = source_buffer->GetMappedBuffer();
-    size_t size = source_buffer->GetSize();
-    T* dest_pointer = static_cast<T*>(tensor->data);
-    std::copy_backward(source_buffer_data, source_buffer_data + size, dest_pointer + size);
-    source_buffers++;
-  }
-}
+struct InferenceState {
+  /*! \brief The network loaded in the driver. */
+  std::unique_ptr<dl::Network> npu;
+  /*! \brief The buffers the NPU writes the outputs to. */
+  std::vector<std::shared_ptr<dl::Buffer> > ofm;
+};
 
 void CreateBuffers(std::vector<std::shared_ptr<dl::Buffer> >* fm,
                    const std::vector<DLTensor*>& tensors) {
@@ -96,8 +93,8 @@ void CreateBuffers(std::vector<std::shared_ptr<dl::Buffer> >* fm,
 }
 
 bool Inference(tvm::runtime::TVMArgs args, sl::CompiledNetwork* network,
-               const std::vector<uint32_t>& input_order,
-               const std::vector<uint32_t>& output_order) {
+               const std::vector<uint32_t>& input_order, const std::vector<uint32_t>& output_order,
+               std::shared_ptr<InferenceState>* state) {
   // Unpack parameters
   uint8_t argc = 0;
   std::vector<DLTensor*> inputs(input_order.size());
@@ -110,14 +107,24 @@ bool Inference(tvm::runtime::TVMArgs args, sl::CompiledNetwork* network,
     outputs[output_order[i]] = args[argc++];
   }
 
+  // Load the network in the driver and allocate the output buffers once, the NPU overwrites
+  // them so they need no initial content.
+  if (*state == nullptr) {
+    auto new_state = std::make_shared<InferenceState>();
+    new_state->npu = std::make_unique<dl::Network>(*network);
+    for (DLTensor* tensor : outputs) {
+      auto data_size = static_cast<uint32_t>(GetDataSize(*tensor));
+      new_state->ofm.push_back(std::make_shared<dl::Buffer>(data_size, dl::DataFormat::NHWC));
+    }
+    *state = new_state;
+  }
+  auto& ofm = (*state)->ofm;
+  ICHECK_EQ(ofm.size(), outputs.size());
+
   // Set up input buffers
   std::vector<std::shared_ptr<dl::Buffer> > ifm(inputs.size());
   CreateBuffers(&ifm, inputs);
 
-  // Set up output buffers
-  std::vector<std::shared_ptr<dl::Buffer> > ofm(outputs.size());
-  CreateBuffers(&ofm, outputs);
-
   // Raw pointers for the inference
   dl::Buffer* ifm_raw[inputs.size()];
   for (size_t i = 0; i < inputs.size(); i++) {
@@ -128,35 +135,19 @@ bool Inference(tvm::runtime::TVMArgs args, sl::CompiledNetwork* network,
     ofm_raw[i] = ofm[i].get();
   }
 
-  auto npu = std::make_unique<dl::Network>(*network);
-
   // Execute the inference.
   std::unique_ptr<dl::Inference> result(
-      npu->ScheduleInference(ifm_raw, sizeof(ifm_raw) / sizeof(ifm_raw[0]), ofm_raw,
-                             sizeof(ofm_raw) / sizeof(ofm_raw[0])));
+      (*state)->npu->ScheduleInference(ifm_raw, sizeof(ifm_raw) / sizeof(ifm_raw[0]), ofm_raw,
+                                       sizeof(ofm_raw) / sizeof(ofm_raw[0])));
   bool inferenceCompleted = WaitForInference(result.get(), 60);
   if (inferenceCompleted) {
-    switch ((outputs)[0]->dtype.bits) {
-      case 8: {
-        dl::Buffer** ofms = &ofm_raw[0];
-        for (DLTensor* tensor : outputs) {
-          uint8_t* source_buffer_data = (*ofms++)->GetMappedBuffer();
-          uint8_t* dest_pointer = static_cast<uint8_t*>(tensor->data);
-          if (source_buffer_data != dest_pointer) {
-            CopyOutput<uint8_t>(ofm_raw, &outputs);
-            break;
-          }
-        }
-        break;
+    // One copy of the bytes per output, whatever the dtype
+    for (size_t i = 0; i < outputs.size(); i++) {
+      const uint8_t* source_buffer_data = ofm[i]->GetMappedBuffer();
+      uint8_t* dest_pointer = static_cast<uint8_t*>(outputs[i]->data);
+      if (source_buffer_data != dest_pointer) {
+        std::memcpy(dest_pointer, source_buffer_data, ofm[i]->GetSize());
       }
-      case 16:
-        CopyOutput<uint16_t>(ofm_raw, &outputs);
-        break;
-      case 32:
-        CopyOutput<uint32_t>(ofm_raw, &outputs);
-        break;
-      default:
-        break;
     }
   }
 
@@ -195,10 +186,12 @@ TVM_REGISTER_GLOBAL("relay.ethos-n.test.infra.inference_result")
       }
     });
 
+struct InferenceState {};
+
 // Allow the ethos-n support code to be tested without a device
 bool Inference(tvm::runtime::TVMArgs args, sl::CompiledNetwork* network,
-               const std::vector<uint32_t>& input_order,
-               const std::vector<uint32_t>& output_order) {
+               const std::vector<uint32_t>& input_order, const std::vector<uint32_t>& output_order,
+               std::shared_ptr<InferenceState>* state) {
   std::vector<DLTensor*> outputs;
   for (int argc = network->GetInputBufferInfos().size(); argc < args.size(); argc++) {
     outputs.push_back(args[argc]);
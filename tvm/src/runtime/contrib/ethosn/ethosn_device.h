@@ -24,6 +24,9 @@
 #ifndef TVM_RUNTIME_CONTRIB_ETHOSN_ETHOSN_DEVICE_H_
 #define TVM_RUNTIME_CONTRIB_ETHOSN_ETHOSN_DEVICE_H_
 
+#include <tvm/runtime/packed_func.h>
+
+#include <memory>
 #include <vector>
 
 #include "ethosn_support_library/Support.hpp"
@@ -34,8 +37,21 @@ namespace ethosn {
 
 namespace sl = ::ethosn::support_library;
 
+/*! \brief The network loaded in the driver and its output buffers, kept across inferences. */
+struct InferenceState;
+
+/*!
+ * \brief Run an inference of a compiled network on the NPU.
+ * \param args The input and output tensors.
+ * \param network The compiled network.
+ * \param input_order The position of each network input in the arguments.
+ * \param output_order The position of each network output in the arguments.
+ * \param state The driver state of the network, created by the first inference.
+ * \return Whether the inference completed.
+ */
 bool Inference(tvm::runtime::TVMArgs args, sl::CompiledNetwork* network,
-               const std::vector<uint32_t>& input_order, const std::vector<uint32_t>& output_order);
+               const std::vector<uint32_t>& input_order, const std::vector<uint32_t>& output_order,
+               std::shared_ptr<InferenceState>* state);
 
 }  // namespace ethosn
 }  // namespace runtime
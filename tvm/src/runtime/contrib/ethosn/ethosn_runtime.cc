@@ -62,8 +62,8 @@ PackedFunc EthosnModule::GetFunction(const std::string& name,
                                      const ObjectPtr<Object>& sptr_to_self) {
   if (network_map_.find(name) != network_map_.end()) {
     return PackedFunc([sptr_to_self, this, name](TVMArgs args, TVMRetValue* rv) {
-      *rv = Inference(args, network_map_[name].cmm.get(), network_map_[name].inputs,
-                      network_map_[name].outputs);
+      auto& network = network_map_[name];
+      *rv = Inference(args, network.cmm.get(), network.inputs, network.outputs, &network.state);
     });
   } else {
     return PackedFunc();
@@ -32,6 +32,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "ethosn_device.h"
 #include "ethosn_support_library/Support.hpp"
 
 namespace tvm {
@@ -45,6 +46,8 @@ struct OrderedCompiledNetwork {
   std::string name;
   std::vector<uint32_t> inputs;
   std::vector<uint32_t> outputs;
+  /*! \brief The driver state reused by the inferences, see Inference. */
+  std::shared_ptr<InferenceState> state;
 };
 
 class EthosnModule : public ModuleNode {
@@ -26,10 +26,13 @@
 #define TVM_RUNTIME_CONTRIB_JSON_JSON_RUNTIME_H_
 
 #include <tvm/runtime/container.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/ndarray.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <map>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -82,6 +85,7 @@ class JSONRuntimeBase : public ModuleNode {
 
         // Bind argument tensors to data entries.
         this->SetInputOutputBuffers(args);
+        this->SetScratchBuffers();
         // Execute the subgraph.
         this->Run();
       });
@@ -169,6 +173,108 @@ class JSONRuntimeBase : public ModuleNode {
     }
   }
 
+  /*!
+   * \brief Plan the intermediate entries of the subgraph into a scratch arena, reusing the
+   * memory of the entries that are no longer read. Backends call it before building their
+   * engine to take the intermediates from the arena rather than allocating their own, they
+   * find them in data_entry_ when running.
+   *
+   * The arena is owned by this runtime and released with it, it is allocated on the device of
+   * the outputs on the first run.
+   */
+  void PlanScratch() {
+    // The last node reading each entry. The heads are read by the caller of the subgraph.
+    std::vector<uint32_t> last_use(NumEntries(), 0);
+    for (uint32_t nid = 0; nid < nodes_.size(); ++nid) {
+      for (const JSONGraphNodeEntry& e : nodes_[nid].inputs_) {
+        last_use[EntryID(e)] = nid;
+      }
+    }
+    std::vector<bool> external(NumEntries(), false);
+    for (uint32_t nid : input_nodes_) {
+      for (uint32_t i = 0; i < nodes_[nid].GetNumOutput(); ++i) {
+        external[EntryID(nid, i)] = true;
+      }
+    }
+    for (const JSONGraphNodeEntry& e : outputs_) {
+      external[EntryID(e)] = true;
+    }
+
+    // First fit of the entries into blocks of the arena, a block is freed once the last node
+    // reading its entry ran.
+    scratch_offset_.assign(NumEntries(), -1);
+    scratch_size_bytes_ = 0;
+    // The free blocks as size -> offset, the used ones as last use -> (size, offset).
+    std::multimap<size_t, size_t> free_blocks;
+    std::multimap<uint32_t, std::pair<size_t, size_t>> live_blocks;
+    for (uint32_t nid = 0; nid < nodes_.size(); ++nid) {
+      while (!live_blocks.empty() && live_blocks.begin()->first < nid) {
+        free_blocks.insert(live_blocks.begin()->second);
+        live_blocks.erase(live_blocks.begin());
+      }
+      const JSONGraphNode& node = nodes_[nid];
+      if (node.op_type_ != "kernel") continue;
+      for (uint32_t i = 0; i < node.GetNumOutput(); ++i) {
+        uint32_t eid = EntryID(nid, i);
+        if (external[eid]) continue;
+        size_t size = (node.dtype_[i].bits * node.dtype_[i].lanes + 7) / 8;
+        for (int64_t dim : node.shape_[i]) {
+          size *= dim;
+        }
+        size = (size + kAllocAlignment - 1) / kAllocAlignment * kAllocAlignment;
+        auto it = free_blocks.lower_bound(size);
+        std::pair<size_t, size_t> block;
+        if (it != free_blocks.end()) {
+          block = *it;
+          free_blocks.erase(it);
+        } else {
+          block = {size, scratch_size_bytes_};
+          scratch_size_bytes_ += size;
+        }
+        scratch_offset_[eid] = block.second;
+        // An entry that is never read is still written by its node.
+        live_blocks.emplace(std::max(last_use[eid], nid), block);
+      }
+    }
+
+    scratch_tensors_.resize(NumEntries());
+    for (uint32_t nid = 0; nid < nodes_.size(); ++nid) {
+      for (uint32_t i = 0; i < nodes_[nid].GetNumOutput(); ++i) {
+        uint32_t eid = EntryID(nid, i);
+        if (scratch_offset_[eid] < 0) continue;
+        DLTensor& tensor = scratch_tensors_[eid];
+        tensor.data = nullptr;
+        tensor.ndim = static_cast<int>(nodes_[nid].shape_[i].size());
+        tensor.dtype = nodes_[nid].dtype_[i];
+        tensor.shape = nodes_[nid].shape_[i].data();
+        tensor.strides = nullptr;
+        tensor.byte_offset = 0;
+      }
+    }
+  }
+
+  /*!
+   * \brief Bind the planned intermediate entries into the scratch arena, allocating it on the
+   * device of the outputs when it does not live there yet.
+   */
+  void SetScratchBuffers() {
+    if (scratch_size_bytes_ == 0) return;
+    TVMContext ctx = data_entry_[EntryID(outputs_[0])]->ctx;
+    if (!scratch_arena_.defined() || scratch_arena_->ctx.device_type != ctx.device_type ||
+        scratch_arena_->ctx.device_id != ctx.device_id) {
+      scratch_arena_ = NDArray();
+      scratch_arena_ =
+          NDArray::Empty({static_cast<int64_t>(scratch_size_bytes_)}, DataType::UInt(8), ctx);
+    }
+    for (size_t eid = 0; eid < scratch_offset_.size(); ++eid) {
+      if (scratch_offset_[eid] < 0) continue;
+      scratch_tensors_[eid].data = scratch_arena_->data;
+      scratch_tensors_[eid].ctx = ctx;
+      scratch_tensors_[eid].byte_offset = scratch_offset_[eid];
+      data_entry_[eid] = &scratch_tensors_[eid];
+    }
+  }
+
   /*!
    * \brief Load the graph and record the entries for inputs and constants.
    *
@@ -268,6 +374,14 @@ class JSONRuntimeBase : public ModuleNode {
   std::vector<uint32_t> input_var_eid_;
   /*! \brief input const node index. */
   std::vector<uint32_t> const_idx_;
+  /*! \brief The byte offset of every entry in the scratch arena, -1 when it is not in it. */
+  std::vector<int64_t> scratch_offset_;
+  /*! \brief The size of the scratch arena this subgraph needs, 0 without PlanScratch(). */
+  size_t scratch_size_bytes_{0};
+  /*! \brief The tensors of the entries in the scratch arena. */
+  std::vector<DLTensor> scratch_tensors_;
+  /*! \brief The scratch arena, allocated on the first run. */
+  NDArray scratch_arena_;
   /*! \brief Indicate if the engine has been initialized. */
   bool initialized_{false};
 };
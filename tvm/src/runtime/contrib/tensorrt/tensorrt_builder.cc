@@ -40,12 +40,13 @@ namespace contrib {
 TensorRTBuilder::TensorRTBuilder(TensorRTLogger* logger,
                                  const std::vector<const DLTensor*>& data_entry,
                                  size_t max_workspace_size, bool use_implicit_batch, bool use_fp16,
-                                 int batch_size)
+                                 int batch_size, const std::vector<int>& batch_profiles)
     : data_entry_(data_entry),
       max_workspace_size_(max_workspace_size),
       use_implicit_batch_(use_implicit_batch),
       use_fp16_(use_fp16),
-      batch_size_(batch_size) {
+      batch_size_(batch_size),
+      batch_profiles_(batch_profiles) {
   // Create TRT builder and network.
   builder_ = nvinfer1::createInferBuilder(*logger);
 #if TRT_VERSION_GE(6, 0, 1)
@@ -78,6 +79,9 @@ void TensorRTBuilder::AddInput(int nid, uint32_t entry_id, const JSONGraphNode&
     // Remove batch dim when not in explicit batch mode.
     if (use_implicit_batch_ && shape.size() > 1) {
       shape.erase(shape.begin());
+    } else if (!use_implicit_batch_ && !batch_profiles_.empty()) {
+      // The optimization profiles give the range of the batch dim.
+      shape[0] = -1;
     }
     nvinfer1::Dims dims = VectorToTrtDims(shape);
     ICHECK(TypeMatch(dtypes[i], kDLFloat, 32)) << "Only FP32 inputs are supported.";
@@ -159,7 +163,7 @@ TensorRTEngineAndContext TensorRTBuilder::BuildEngine() {
     config_->setFlag(nvinfer1::BuilderFlag::kFP16);
   }
   // Add profiles.
-  if (!use_implicit_batch_) {
+  if (!use_implicit_batch_ && batch_profiles_.empty()) {
     auto profile = builder_->createOptimizationProfile();
     for (int i = 0; i < network_->getNbInputs(); ++i) {
       auto name = network_->getInput(i)->getName();
@@ -169,12 +173,36 @@ TensorRTEngineAndContext TensorRTBuilder::BuildEngine() {
       profile->setDimensions(name, nvinfer1::OptProfileSelector::kMAX, dims);
     }
     config_->addOptimizationProfile(profile);
+  } else if (!use_implicit_batch_) {
+    // One profile per batch range, each tuned for the largest batch of its range.
+    int min_batch = 1;
+    for (int max_batch : batch_profiles_) {
+      auto profile = builder_->createOptimizationProfile();
+      for (int i = 0; i < network_->getNbInputs(); ++i) {
+        auto name = network_->getInput(i)->getName();
+        auto min_dims = network_->getInput(i)->getDimensions();
+        auto max_dims = min_dims;
+        min_dims.d[0] = min_batch;
+        max_dims.d[0] = max_batch;
+        profile->setDimensions(name, nvinfer1::OptProfileSelector::kMIN, min_dims);
+        profile->setDimensions(name, nvinfer1::OptProfileSelector::kOPT, max_dims);
+        profile->setDimensions(name, nvinfer1::OptProfileSelector::kMAX, max_dims);
+      }
+      config_->addOptimizationProfile(profile);
+      min_batch = max_batch + 1;
+    }
   }
   nvinfer1::ICudaEngine* engine = builder_->buildEngineWithConfig(*network_, *config_);
 #else
   nvinfer1::ICudaEngine* engine = builder_->buildCudaEngine(*network_);
 #endif
+#if TRT_VERSION_GE(6, 0, 1)
+  ICHECK_EQ(engine->getNbBindings(),
+            (network_input_names_.size() + network_output_names_.size()) *
+                engine->getNbOptimizationProfiles());
+#else
   ICHECK_EQ(engine->getNbBindings(), network_input_names_.size() + network_output_names_.size());
+#endif
   nvinfer1::IExecutionContext* context = engine->createExecutionContext();
   CleanUp();
 
@@ -248,7 +276,9 @@ void TensorRTBuilder::CleanUp() {
 void TensorRTBuilder::AllocateDeviceBuffer(nvinfer1::ICudaEngine* engine, const std::string& name,
                                            std::vector<runtime::NDArray>* device_buffers) {
   const uint32_t entry_id = entry_id_map_[name];
-  if (data_entry_[entry_id]->ctx.device_type != kDLGPU) {
+  // Entries are not bound yet when the engine is built at compile time, the runtime allocates
+  // their buffers at the first run instead.
+  if (data_entry_[entry_id] != nullptr && data_entry_[entry_id]->ctx.device_type != kDLGPU) {
     const int binding_index = engine->getBindingIndex(name.c_str());
     ICHECK_NE(binding_index, -1);
     std::vector<int64_t> shape(data_entry_[entry_id]->shape,
@@ -72,10 +72,13 @@ class TensorRTBuilder {
    * \param use_implicit_batch Whether to use implicit batch mode (default)
    * \param use_fp16 Whether to use implicit batch mode (default)
    * \param batch_size If use_implicit_batch,
+   * \param batch_profiles The upper bounds of the batch size ranges of the optimization
+   * profiles in explicit batch mode, e.g. {8, 32} for [1, 8] and [9, 32]. The engine then has a
+   * dynamic batch dimension. Empty to build for batch_size only.
    */
   TensorRTBuilder(TensorRTLogger* logger, const std::vector<const DLTensor*>& data_entry,
                   size_t max_workspace_size, bool use_implicit_batch, bool use_fp16,
-                  int batch_size);
+                  int batch_size, const std::vector<int>& batch_profiles = {});
 
   /*!
    * \brief Add TensorRT input(s) for input node in network definition.
@@ -164,6 +167,9 @@ class TensorRTBuilder {
   /*! \brief Batch size to optimize for. */
   int batch_size_;
 
+  /*! \brief The upper bounds of the batch size ranges of the optimization profiles. */
+  std::vector<int> batch_profiles_;
+
   /*! \brief Input names. */
   std::vector<std::string> network_input_names_;
 
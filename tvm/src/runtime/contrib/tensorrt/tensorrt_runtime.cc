@@ -26,13 +26,18 @@
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
 #include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "../../file_utils.h"
 #include "../json/json_node.h"
 #include "../json/json_runtime.h"
 
 #ifdef TVM_GRAPH_RUNTIME_TENSORRT
+#include "../../cuda/cuda_common.h"
 #include "NvInfer.h"
 #include "tensorrt_builder.h"
 #endif
@@ -50,6 +55,23 @@ struct PairHash {
 
 using namespace tvm::runtime::json;
 
+/*!
+ * \brief Marks the engine table after the JSON module in the module binary. The binaries saved
+ *  before the table end with the JSON module.
+ */
+constexpr uint64_t kTensorRTEnginesMagic = 0x54525445ED6E1E5EULL;
+
+/*! \brief A TensorRT engine serialized in the module binary. */
+struct SerializedEngine {
+  /*! \brief The batch size the engine was built for. */
+  int batch_size;
+  /*! \brief The serialized TensorRT plan. */
+  std::string plan;
+  /*! \brief The names of the input and output bindings of the engine. */
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+};
+
 class TensorRTRuntime : public JSONRuntimeBase {
  public:
   /*!
@@ -73,6 +95,60 @@ class TensorRTRuntime : public JSONRuntimeBase {
    */
   const char* type_key() const override { return "tensorrt"; }
 
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) override {
+    if (name == "build_engine") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        ICHECK(this->initialized_) << "The module has not been initialized";
+        this->BuildEngineAheadOfTime();
+      });
+    }
+    return JSONRuntimeBase::GetFunction(name, sptr_to_self);
+  }
+
+  /*!
+   * \brief Save the module and the TensorRT engines built so far, so that loading it does not
+   * need to build them again.
+   *
+   * \param stream The stream to save the binary.
+   */
+  void SaveToBinary(dmlc::Stream* stream) override {
+    JSONRuntimeBase::SaveToBinary(stream);
+    SaveEnginesToBinary(stream);
+  }
+
+  /*!
+   * \brief Load the module, keeping the serialized engines until Init deserializes them.
+   *
+   * \param strm The stream to load the binary from.
+   * \return The loaded module.
+   */
+  static Module LoadFromBinary(void* strm) {
+    Module mod = JSONRuntimeBase::LoadFromBinary<TensorRTRuntime>(strm);
+    auto* n = static_cast<TensorRTRuntime*>(mod.operator->());
+    dmlc::Stream* stream = static_cast<dmlc::Stream*>(strm);
+    // Older binaries have no engine table, the stream ends or the next module follows.
+    auto* seek_stream = dynamic_cast<dmlc::SeekStream*>(stream);
+    size_t start = seek_stream != nullptr ? seek_stream->Tell() : 0;
+    uint64_t magic;
+    if (!stream->Read(&magic)) return mod;
+    if (magic != kTensorRTEnginesMagic) {
+      ICHECK(seek_stream != nullptr) << "Loading the TensorRT engines failed, invalid magic";
+      seek_stream->Seek(start);
+      return mod;
+    }
+    uint64_t num_engines;
+    ICHECK(stream->Read(&num_engines)) << "Loading the number of TensorRT engines failed";
+    for (uint64_t i = 0; i < num_engines; ++i) {
+      SerializedEngine engine;
+      ICHECK(stream->Read(&engine.batch_size)) << "Loading TensorRT engine failed";
+      ICHECK(stream->Read(&engine.plan)) << "Loading TensorRT engine failed";
+      ICHECK(stream->Read(&engine.inputs)) << "Loading TensorRT engine failed";
+      ICHECK(stream->Read(&engine.outputs)) << "Loading TensorRT engine failed";
+      n->serialized_engines_.push_back(std::move(engine));
+    }
+    return mod;
+  }
+
   /*!
    * \brief Initialize runtime. Create TensorRT layer from JSON
    * representation.
@@ -83,8 +159,11 @@ class TensorRTRuntime : public JSONRuntimeBase {
     ICHECK_EQ(consts.size(), const_idx_.size())
         << "The number of input constants must match the number of required.";
     LoadGlobalAttributes();
+    DeserializeEngines();
     if (GetCachedEnginesFromDisk()) return;
     SetupConstants(consts);
+    // The shape of the profile engine is known up front, build it before the first run.
+    if (!batch_profiles_.empty()) BuildEngineAheadOfTime();
   }
 
   void LoadGlobalAttributes() {
@@ -103,6 +182,12 @@ class TensorRTRuntime : public JSONRuntimeBase {
           max_workspace_size_ =
               std::stoul(nodes_[i].GetAttr<std::vector<std::string>>("max_workspace_size")[0]);
         }
+        if (nodes_[i].HasAttr("batch_profiles")) {
+          for (const auto& bound : nodes_[i].GetAttr<std::vector<std::string>>("batch_profiles")) {
+            batch_profiles_.push_back(std::stoi(bound));
+          }
+          std::sort(batch_profiles_.begin(), batch_profiles_.end());
+        }
         return;
       }
     }
@@ -114,10 +199,41 @@ class TensorRTRuntime : public JSONRuntimeBase {
     BuildEngine();
     batch_size_ = data_entry_[input_var_eid_[0]]->shape[0];
     if (batch_size_ == 0) return;
-    auto& engine_and_context = trt_engine_cache_.at(std::make_pair(symbol_name_, batch_size_));
+    const int engine_batch_size = GetEngineBatchSize(batch_size_);
+    auto& engine_and_context =
+        trt_engine_cache_.at(std::make_pair(symbol_name_, engine_batch_size));
     auto engine = engine_and_context.engine;
     auto context = engine_and_context.context;
     auto& device_buffers = engine_and_context.device_buffers;
+    // Engines loaded from the module binary or the cache dir allocate their buffers here. The
+    // buffers hold the largest batch of the engine and are viewed with the current one.
+    device_buffers.resize(engine->getNbBindings());
+    auto device_buffer = [&device_buffers, engine_batch_size](int binding_index,
+                                                              const DLTensor* tensor) {
+      std::vector<int64_t> shape(tensor->shape, tensor->shape + tensor->ndim);
+      if (!device_buffers[binding_index].defined() ||
+          device_buffers[binding_index]->shape[0] < engine_batch_size) {
+        std::vector<int64_t> max_shape = shape;
+        max_shape[0] = std::max<int64_t>(shape[0], engine_batch_size);
+        device_buffers[binding_index] = NDArray::Empty(max_shape, tensor->dtype, {kDLGPU, 0});
+      }
+      return device_buffers[binding_index].CreateView(shape, tensor->dtype);
+    };
+    // Select the profile of the batch size. Every profile has its own set of bindings.
+    int profile_offset = 0;
+#if TRT_VERSION_GE(6, 0, 1)
+    const bool dynamic_batch = !use_implicit_batch_ && IsProfileEngine(engine_batch_size);
+    if (dynamic_batch) {
+      const int profile = static_cast<int>(
+          std::lower_bound(batch_profiles_.begin(), batch_profiles_.end(), batch_size_) -
+          batch_profiles_.begin());
+      if (context->getOptimizationProfile() != profile) {
+        ICHECK(context->setOptimizationProfile(profile))
+            << "Cannot select TensorRT optimization profile " << profile;
+      }
+      profile_offset = profile * (engine->getNbBindings() / engine->getNbOptimizationProfiles());
+    }
+#endif
     std::vector<void*> bindings(engine->getNbBindings(), nullptr);
     for (size_t i = 0; i < input_nodes_.size(); ++i) {
       auto nid = input_nodes_[i];
@@ -127,10 +243,18 @@ class TensorRTRuntime : public JSONRuntimeBase {
           const std::string name = nodes_[nid].GetOpName() + "_" + std::to_string(j);
           int binding_index = engine->getBindingIndex(name.c_str());
           ICHECK_NE(binding_index, -1);
+          binding_index += profile_offset;
+#if TRT_VERSION_GE(6, 0, 1)
+          if (dynamic_batch) {
+            std::vector<int64_t> shape(data_entry_[eid]->shape,
+                                       data_entry_[eid]->shape + data_entry_[eid]->ndim);
+            ICHECK(context->setBindingDimensions(binding_index, VectorToTrtDims(shape)));
+          }
+#endif
           if (data_entry_[eid]->ctx.device_type == kDLGPU) {
             bindings[binding_index] = data_entry_[eid]->data;
           } else {
-            device_buffers[binding_index].CopyFrom(data_entry_[eid]);
+            device_buffer(binding_index, data_entry_[eid]).CopyFrom(data_entry_[eid]);
             bindings[binding_index] = device_buffers[binding_index]->data;
           }
         }
@@ -142,21 +266,27 @@ class TensorRTRuntime : public JSONRuntimeBase {
       const std::string& name = engine_and_context.outputs[i];
       int binding_index = engine->getBindingIndex(name.c_str());
       ICHECK_NE(binding_index, -1);
+      binding_index += profile_offset;
       if (data_entry_[eid]->ctx.device_type == kDLGPU) {
         bindings[binding_index] = data_entry_[eid]->data;
       } else {
-        bindings[binding_index] = device_buffers[binding_index]->data;
+        bindings[binding_index] = device_buffer(binding_index, data_entry_[eid])->data;
       }
     }
 
+    // Enqueue on the stream set by TVMSetStream, so that the graph runtime can overlap the
+    // engine with the kernels on its other streams.
+    cudaStream_t stream = CUDAThreadEntry::ThreadLocal()->stream;
 #if TRT_VERSION_GE(6, 0, 1)
     if (use_implicit_batch_) {
-      ICHECK(context->execute(batch_size_, bindings.data())) << "Running TensorRT failed.";
+      ICHECK(context->enqueue(batch_size_, bindings.data(), stream, nullptr))
+          << "Running TensorRT failed.";
     } else {
-      ICHECK(context->executeV2(bindings.data())) << "Running TensorRT failed.";
+      ICHECK(context->enqueueV2(bindings.data(), stream, nullptr)) << "Running TensorRT failed.";
     }
 #else
-    ICHECK(context->execute(batch_size_, bindings.data())) << "Running TensorRT failed.";
+    ICHECK(context->enqueue(batch_size_, bindings.data(), stream, nullptr))
+        << "Running TensorRT failed.";
 #endif
 
     // Copy outputs from GPU buffers if needed.
@@ -165,6 +295,7 @@ class TensorRTRuntime : public JSONRuntimeBase {
       const std::string& name = engine_and_context.outputs[i];
       int binding_index = engine->getBindingIndex(name.c_str());
       ICHECK_NE(binding_index, -1);
+      binding_index += profile_offset;
       if (data_entry_[eid]->ctx.device_type != kDLGPU) {
         device_buffers[binding_index].CopyTo(const_cast<DLTensor*>(data_entry_[eid]));
       }
@@ -178,12 +309,52 @@ class TensorRTRuntime : public JSONRuntimeBase {
    */
   void BuildEngine() {
     batch_size_ = data_entry_[input_var_eid_[0]]->shape[0];
-    if (trt_engine_cache_.count(std::make_pair(symbol_name_, batch_size_))) return;
+    const int engine_batch_size = GetEngineBatchSize(batch_size_);
+    if (trt_engine_cache_.count(std::make_pair(symbol_name_, engine_batch_size))) return;
+    BuildEngineForBatchSize(engine_batch_size);
+  }
+
+  /*!
+   * \brief Get the batch size of the engine that runs a batch. All the batches covered by the
+   * optimization profiles share the engine built for the largest one.
+   */
+  int GetEngineBatchSize(int batch_size) const {
+    if (!batch_profiles_.empty() && batch_size <= batch_profiles_.back()) {
+      return batch_profiles_.back();
+    }
+    return batch_size;
+  }
+
+  /*! \brief Whether the engine of a batch size is the one built with the profiles. */
+  bool IsProfileEngine(int engine_batch_size) const {
+    return !batch_profiles_.empty() && engine_batch_size == batch_profiles_.back();
+  }
+
+  /*!
+   * \brief Build the TensorRT engine for the batch size of the graph inputs, or the one of the
+   * optimization profiles, before any input is bound. Used to build the engine at compile time.
+   */
+  void BuildEngineAheadOfTime() {
+    int batch_size = 0;
+    for (size_t i = 0; i < input_nodes_.size(); ++i) {
+      auto nid = input_nodes_[i];
+      if (nodes_[nid].GetOpType() == "input") {
+        batch_size = GetEngineBatchSize(nodes_[nid].GetOpShape()[0][0]);
+        break;
+      }
+    }
+    if (trt_engine_cache_.count(std::make_pair(symbol_name_, batch_size))) return;
+    BuildEngineForBatchSize(batch_size);
+  }
+
+  /*! \brief Build the TensorRT engine for a batch size and cache it. */
+  void BuildEngineForBatchSize(int batch_size) {
     DLOG(INFO) << "Building new TensorRT engine for subgraph " << symbol_name_
-               << " with batch size " << batch_size_;
+               << " with batch size " << batch_size;
     const bool use_fp16 = dmlc::GetEnv("TVM_TENSORRT_USE_FP16", false);
     TensorRTBuilder builder(&logger_, data_entry_, max_workspace_size_, use_implicit_batch_,
-                            use_fp16, batch_size_);
+                            use_fp16, batch_size,
+                            IsProfileEngine(batch_size) ? batch_profiles_ : std::vector<int>());
 
     // Add inputs and constants.
     for (size_t i = 0; i < input_nodes_.size(); ++i) {
@@ -212,10 +383,10 @@ class TensorRTRuntime : public JSONRuntimeBase {
     }
 
     // Build engine.
-    trt_engine_cache_[std::make_pair(symbol_name_, batch_size_)] = builder.BuildEngine();
+    trt_engine_cache_[std::make_pair(symbol_name_, batch_size)] = builder.BuildEngine();
     DLOG(INFO) << "Finished building TensorRT engine for subgraph " << symbol_name_
-               << " with batch size " << batch_size_;
-    CacheEngineToDisk();
+               << " with batch size " << batch_size;
+    CacheEngineToDisk(batch_size);
   }
 
   /*! \brief If TVM_TENSORRT_CACHE_DIR is set, will check that directory for
@@ -250,7 +421,7 @@ class TensorRTRuntime : public JSONRuntimeBase {
     helper.DeclareField("inputs", &engine_and_context.inputs);
     helper.DeclareField("outputs", &engine_and_context.outputs);
     helper.ReadAllFields(&reader);
-    const int batch_size = 1;
+    const int batch_size = GetEngineBatchSize(1);
     trt_engine_cache_[std::make_pair(symbol_name_, batch_size)] = engine_and_context;
     return true;
   }
@@ -258,8 +429,7 @@ class TensorRTRuntime : public JSONRuntimeBase {
   /*! \brief If TVM_TENSORRT_CACHE_DIR is set, will save the engine to that
    * directory so it can be loaded later.
    */
-  void CacheEngineToDisk() {
-    batch_size_ = data_entry_[input_var_eid_[0]]->shape[0];
+  void CacheEngineToDisk(int batch_size) {
     std::string cache_dir = dmlc::GetEnv("TVM_TENSORRT_CACHE_DIR", std::string(""));
     if (cache_dir.empty()) return;
     std::string key = GetSubgraphKey();
@@ -267,7 +437,7 @@ class TensorRTRuntime : public JSONRuntimeBase {
     DLOG(INFO) << "Caching TensorRT engine to " << path;
     // Serialize engine to disk
     nvinfer1::IHostMemory* serialized_engine =
-        trt_engine_cache_[std::make_pair(symbol_name_, batch_size_)].engine->serialize();
+        trt_engine_cache_[std::make_pair(symbol_name_, batch_size)].engine->serialize();
     SaveBinaryToFile(path, std::string(static_cast<const char*>(serialized_engine->data()),
                                        serialized_engine->size()));
     serialized_engine->destroy();
@@ -276,14 +446,49 @@ class TensorRTRuntime : public JSONRuntimeBase {
     dmlc::JSONWriter writer(&os);
     writer.BeginObject();
     writer.WriteObjectKeyValue("inputs",
-                               trt_engine_cache_[std::make_pair(symbol_name_, batch_size_)].inputs);
+                               trt_engine_cache_[std::make_pair(symbol_name_, batch_size)].inputs);
     writer.WriteObjectKeyValue(
-        "outputs", trt_engine_cache_[std::make_pair(symbol_name_, batch_size_)].outputs);
+        "outputs", trt_engine_cache_[std::make_pair(symbol_name_, batch_size)].outputs);
     writer.EndObject();
     std::string meta_path = cache_dir + "/" + key + ".meta";
     SaveBinaryToFile(meta_path, os.str());
   }
 
+  /*! \brief Write the number of built engines, then the plan and bindings of each. */
+  void SaveEnginesToBinary(dmlc::Stream* stream) {
+    std::vector<SerializedEngine> engines = serialized_engines_;
+    for (const auto& it : trt_engine_cache_) {
+      if (it.first.first != symbol_name_) continue;
+      nvinfer1::IHostMemory* plan = it.second.engine->serialize();
+      engines.push_back({it.first.second,
+                         std::string(static_cast<const char*>(plan->data()), plan->size()),
+                         it.second.inputs, it.second.outputs});
+      plan->destroy();
+    }
+    WriteEngines(stream, engines);
+  }
+
+  /*! \brief Deserialize the engines loaded with the module into trt_engine_cache_. */
+  void DeserializeEngines() {
+    if (serialized_engines_.empty()) return;
+    nvinfer1::IRuntime* runtime = nvinfer1::createInferRuntime(logger_);
+    for (const auto& serialized : serialized_engines_) {
+      DLOG(INFO) << "Loading embedded TensorRT engine for subgraph " << symbol_name_
+                 << " with batch size " << serialized.batch_size;
+      TensorRTEngineAndContext engine_and_context;
+      engine_and_context.engine =
+          runtime->deserializeCudaEngine(serialized.plan.data(), serialized.plan.size(), nullptr);
+      ICHECK(engine_and_context.engine != nullptr)
+          << "Cannot deserialize the TensorRT engine of " << symbol_name_
+          << ", it may have been built for another GPU or TensorRT version";
+      engine_and_context.context = engine_and_context.engine->createExecutionContext();
+      engine_and_context.inputs = serialized.inputs;
+      engine_and_context.outputs = serialized.outputs;
+      trt_engine_cache_[std::make_pair(symbol_name_, serialized.batch_size)] = engine_and_context;
+    }
+    serialized_engines_.clear();
+  }
+
   std::string GetSubgraphKey() {
     // Using this key will only allow a single model per TVM_TENSORRT_CACHE_DIR directory. We could
     // instead use a hash of graph_json and all weights to allow many models in the same directory,
@@ -325,14 +530,43 @@ class TensorRTRuntime : public JSONRuntimeBase {
                  << "Please build with USE_TENSORRT_RUNTIME.";
   }
 
+  void BuildEngineAheadOfTime() {
+    LOG(FATAL) << "TensorRT runtime is not enabled. "
+               << "Please build with USE_TENSORRT_RUNTIME.";
+  }
+
+  void SaveEnginesToBinary(dmlc::Stream* stream) { WriteEngines(stream, serialized_engines_); }
+
+  void DeserializeEngines() {}
+
   bool GetCachedEnginesFromDisk() { return false; }
 
-  void CacheEngineToDisk() {}
+  void CacheEngineToDisk(int batch_size) {}
 #endif
 
+  static void WriteEngines(dmlc::Stream* stream, const std::vector<SerializedEngine>& engines) {
+    stream->Write(kTensorRTEnginesMagic);
+    stream->Write(static_cast<uint64_t>(engines.size()));
+    for (const auto& engine : engines) {
+      stream->Write(engine.batch_size);
+      stream->Write(engine.plan);
+      stream->Write(engine.inputs);
+      stream->Write(engine.outputs);
+    }
+  }
+
   bool use_implicit_batch_;
 
   size_t max_workspace_size_;
+
+  /*!
+   * \brief The sorted upper bounds of the batch size ranges of the optimization profiles, all
+   * covered by one engine. Empty to build one engine per batch size.
+   */
+  std::vector<int> batch_profiles_;
+
+  /*! \brief The engines loaded with the module and not deserialized yet. */
+  std::vector<SerializedEngine> serialized_engines_;
 };
 
 runtime::Module TensorRTRuntimeCreate(const String& symbol_name, const String& graph_json,
@@ -344,7 +578,7 @@ runtime::Module TensorRTRuntimeCreate(const String& symbol_name, const String& g
 TVM_REGISTER_GLOBAL("runtime.tensorrt_runtime_create").set_body_typed(TensorRTRuntimeCreate);
 
 TVM_REGISTER_GLOBAL("runtime.module.loadbinary_tensorrt")
-    .set_body_typed(JSONRuntimeBase::LoadFromBinary<TensorRTRuntime>);
+    .set_body_typed(TensorRTRuntime::LoadFromBinary);
 
 }  // namespace contrib
 }  // namespace runtime
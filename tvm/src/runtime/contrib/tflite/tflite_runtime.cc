@@ -27,51 +27,23 @@
 #include <tensorflow/lite/model.h>
 #include <tvm/runtime/registry.h>
 
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace tvm {
 namespace runtime {
 
-#define TVM_DTYPE_DISPATCH(type, DType, ...)    \
-  if (type == DataType::Float(64)) {            \
-    typedef double DType;                       \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::Float(32)) {     \
-    typedef float DType;                        \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::Float(16)) {     \
-    typedef uint16_t DType;                     \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::Int(64)) {       \
-    typedef int64_t DType;                      \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::Int(32)) {       \
-    typedef int32_t DType;                      \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::Int(16)) {       \
-    typedef int16_t DType;                      \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::Int(8)) {        \
-    typedef int8_t DType;                       \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::UInt(64)) {      \
-    typedef uint64_t DType;                     \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::UInt(32)) {      \
-    typedef uint32_t DType;                     \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::UInt(16)) {      \
-    typedef uint16_t DType;                     \
-    { __VA_ARGS__ }                             \
-  } else if (type == DataType::UInt(8)) {       \
-    typedef uint8_t DType;                      \
-    { __VA_ARGS__ }                             \
-  } else {                                      \
-    LOG(FATAL) << "unknown data type " << type; \
-  }
+// The alignment TFLite requires from custom allocations, tflite::kDefaultTensorAlignment
+constexpr size_t kTFLiteTensorAlignment = 64;
 
 DataType TfLiteDType2TVMDType(TfLiteType dtype) {
   switch (dtype) {
     case kTfLiteFloat32:
       return DataType::Float(32);
+    case kTfLiteFloat64:
+      return DataType::Float(64);
     case kTfLiteInt32:
       return DataType::Int(32);
     case kTfLiteInt64:
@@ -110,22 +82,70 @@ void TFLiteRuntime::Init(const std::string& tflite_model_bytes, TVMContext ctx)
   ctx_ = ctx;
 }
 
-void TFLiteRuntime::Invoke() { interpreter_->Invoke(); }
-
-void TFLiteRuntime::SetInput(int index, DLTensor* data_in) {
-  DataType dtype(data_in->dtype);
-  TVM_DTYPE_DISPATCH(dtype, DType, {
-    DType* dest = interpreter_->typed_input_tensor<DType>(index);
-    DType* src = static_cast<DType*>(data_in->data);
-    ICHECK(data_in->strides == NULL);
-    int64_t size = 1;
-    for (int64_t i = 0; i < data_in->ndim; ++i) {
-      size *= data_in->shape[i];
+void TFLiteRuntime::Invoke() {
+  if (allocations_dirty_) {
+    // The custom allocations take effect when the tensors are allocated, which may move the
+    // other inputs, their data set so far is carried over
+    std::vector<std::pair<int, std::string>> inputs;
+    for (int tensor_index : interpreter_->inputs()) {
+      if (custom_allocations_.count(tensor_index)) continue;
+      const TfLiteTensor* input = interpreter_->tensor(tensor_index);
+      inputs.emplace_back(tensor_index, std::string(input->data.raw, input->bytes));
     }
-    for (int64_t i = 0; i < size; ++i) {
-      dest[i] = src[i];
+    CHECK_TFLITE_STATUS(interpreter_->AllocateTensors()) << "Failed to allocate tensors.";
+    for (const auto& input : inputs) {
+      TfLiteTensor* tensor = interpreter_->tensor(input.first);
+      std::memcpy(tensor->data.raw, input.second.data(), input.second.size());
     }
-  });
+    allocations_dirty_ = false;
+  }
+  CHECK_TFLITE_STATUS(interpreter_->Invoke()) << "Failed to invoke the interpreter.";
+}
+
+void TFLiteRuntime::SetInput(int index, DLTensor* data_in) {
+  ICHECK(data_in->strides == NULL);
+  TfLiteTensor* input = interpreter_->tensor(interpreter_->inputs()[index]);
+  ICHECK(DataType(data_in->dtype) == TfLiteDType2TVMDType(input->type))
+      << "The dtype of input " << index << " does not match the model";
+  size_t bytes = GetDataSize(*data_in);
+  ICHECK_EQ(bytes, input->bytes) << "The size of input " << index << " does not match the model";
+  if (data_in->ctx.device_type == kDLCPU) {
+    const char* data = static_cast<const char*>(data_in->data) + data_in->byte_offset;
+    // The input may be the zero copy buffer of the tensor
+    if (data == input->data.raw) return;
+    std::memcpy(input->data.raw, data, bytes);
+  } else {
+    ICHECK_EQ(TVMArrayCopyToBytes(data_in, input->data.raw, bytes), 0) << TVMGetLastError();
+  }
+}
+
+void TFLiteRuntime::SetInputZeroCopy(int index, DLTensor* data_ref) {
+  SetCustomAllocation(interpreter_->inputs()[index], data_ref);
+}
+
+void TFLiteRuntime::SetOutputZeroCopy(int index, DLTensor* data_ref) {
+  SetCustomAllocation(interpreter_->outputs()[index], data_ref);
+}
+
+void TFLiteRuntime::SetCustomAllocation(int tensor_index, DLTensor* data_ref) {
+  TfLiteTensor* tensor = interpreter_->tensor(tensor_index);
+  ICHECK_EQ(data_ref->ctx.device_type, kDLCPU) << "Zero copy tensors must be on the CPU";
+  ICHECK(data_ref->strides == NULL);
+  ICHECK(DataType(data_ref->dtype) == TfLiteDType2TVMDType(tensor->type))
+      << "The dtype of " << tensor->name << " does not match the model";
+  size_t bytes = GetDataSize(*data_ref);
+  ICHECK_EQ(bytes, tensor->bytes) << "The size of " << tensor->name << " does not match";
+  void* data = static_cast<char*>(data_ref->data) + data_ref->byte_offset;
+  ICHECK_EQ(reinterpret_cast<uintptr_t>(data) % kTFLiteTensorAlignment, 0)
+      << "Zero copy tensors must be aligned to " << kTFLiteTensorAlignment << " bytes";
+  auto it = custom_allocations_.find(tensor_index);
+  if (it != custom_allocations_.end() && it->second == data) return;
+  CHECK_TFLITE_STATUS(interpreter_->SetCustomAllocationForTensor(tensor_index, {data, bytes}))
+      << "Failed to share the buffer of " << tensor->name;
+  custom_allocations_[tensor_index] = data;
+  // The shapes are fixed, so the tensors are only allocated again when the interpreter leaves
+  // the allocation to the next AllocateTensors
+  if (tensor->data.raw != data) allocations_dirty_ = true;
 }
 
 void TFLiteRuntime::SetNumThreads(int num_threads) { interpreter_->SetNumThreads(num_threads); }
@@ -134,20 +154,12 @@ NDArray TFLiteRuntime::GetOutput(int index) const {
   TfLiteTensor* output = interpreter_->tensor(interpreter_->outputs()[index]);
   DataType dtype = TfLiteDType2TVMDType(output->type);
   TfLiteIntArray* dims = output->dims;
-  int64_t size = 1;
   std::vector<int64_t> shape;
   for (int i = 0; i < dims->size; ++i) {
     shape.push_back(dims->data[i]);
-    size *= dims->data[i];
   }
   NDArray ret = NDArray::Empty(shape, dtype, ctx_);
-  TVM_DTYPE_DISPATCH(dtype, DType, {
-    DType* dest = static_cast<DType*>(ret->data);
-    DType* src = interpreter_->typed_output_tensor<DType>(index);
-    for (int64_t i = 0; i < size; ++i) {
-      dest[i] = src[i];
-    }
-  });
+  ret.CopyFromBytes(output->data.raw, output->bytes);
   return ret;
 }
 
@@ -160,6 +172,18 @@ PackedFunc TFLiteRuntime::GetFunction(const std::string& name,
       ICHECK_GE(in_idx, 0);
       this->SetInput(in_idx, args[1]);
     });
+  } else if (name == "set_input_zero_copy") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int in_idx = args[0];
+      ICHECK_GE(in_idx, 0);
+      this->SetInputZeroCopy(in_idx, args[1]);
+    });
+  } else if (name == "set_output_zero_copy") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int out_idx = args[0];
+      ICHECK_GE(out_idx, 0);
+      this->SetOutputZeroCopy(out_idx, args[1]);
+    });
   } else if (name == "get_output") {
     return PackedFunc(
         [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetOutput(args[0]); });
@@ -32,6 +32,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace tvm {
@@ -79,6 +80,20 @@ class TFLiteRuntime : public ModuleNode {
    * \param data_in The input data.
    */
   void SetInput(int index, DLTensor* data_in);
+  /*!
+   * \brief Let the interpreter read the index-th input from a TVM tensor in place, until
+   * another tensor is set. The tensor must be on the CPU, compact and aligned for TFLite.
+   * \param index The input index.
+   * \param data_ref The input tensor.
+   */
+  void SetInputZeroCopy(int index, DLTensor* data_ref);
+  /*!
+   * \brief Let the interpreter write the index-th output to a TVM tensor in place, until
+   * another tensor is set. The tensor must be on the CPU, compact and aligned for TFLite.
+   * \param index The output index.
+   * \param data_ref The output tensor.
+   */
+  void SetOutputZeroCopy(int index, DLTensor* data_ref);
   /*!
    * \brief Return NDArray for given input index.
    * \param index The input index.
@@ -105,6 +120,14 @@ class TFLiteRuntime : public ModuleNode {
   std::unique_ptr<tflite::Interpreter> interpreter_;
   // TVM context
   TVMContext ctx_;
+
+ private:
+  /*! \brief Make a TVM tensor the buffer of an interpreter tensor. */
+  void SetCustomAllocation(int tensor_index, DLTensor* data_ref);
+  // The buffers bound with SetInputZeroCopy and SetOutputZeroCopy, by tensor index
+  std::unordered_map<int, void*> custom_allocations_;
+  // Whether a custom allocation waits for the tensors to be allocated again
+  bool allocations_dirty_{false};
 };
 
 }  // namespace runtime
@@ -28,6 +28,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "memory_stats.h"
 #include "workspace_pool.h"
 
 #ifdef __ANDROID__
@@ -58,10 +59,12 @@ class CPUDeviceAPI final : public DeviceAPI {
     int ret = posix_memalign(&ptr, alignment, nbytes);
     if (ret != 0) throw std::bad_alloc();
 #endif
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kGlobal, ptr, nbytes);
     return ptr;
   }
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    MemoryStats::Global()->Free(ctx, MemoryKind::kGlobal, ptr);
 #if _MSC_VER
     _aligned_free(ptr);
 #else
@@ -100,6 +100,8 @@ void TVMGraphRuntimeNode_LoadAttrs(TVMGraphRuntimeNode* node, JSONReader* reader
     } else if (!strcmp(key, "flatten_data")) {
       param->flatten_data = strtoul(value, 0, 10);
       bitmask |= 8;
+    } else if (!strcmp(key, "flop_ct") || !strcmp(key, "bytes")) {
+      // cost estimates are only used by the debug runtime
     } else {
       fprintf(stderr, "do not support key %s", key);
     }
@@ -848,6 +850,12 @@ int TVMGraphRuntime_LoadParams(TVMGraphRuntime* runtime, const char* param_blob,
       }
       runtime->data_entry[eid].dl_tensor.data = 0;
     }
+    if (reserved != 0) {
+      // Skip the padding aligning the data of the array
+      uint64_t padding;
+      memcpy(&padding, bptr, sizeof(padding));
+      bptr += sizeof(padding) + padding;
+    }
     status |= TVMNDArray_Load(&(runtime->data_entry[eid]), &bptr);
 #if TVM_CRT_DEBUG
     TVMNDArray* entry = &(runtime->data_entry[eid]);
@@ -911,6 +919,8 @@ int TVMGraphRuntime_GetOutput(TVMGraphRuntime* runtime, const int32_t idx, DLTen
 int TVMGraphRuntime_SetupStorage(TVMGraphRuntime* runtime) {
   TVMPackedFunc lookup_linked_param;
   int lookup_linked_param_valid;
+  TVMPackedFunc lookup_storage_arena;
+  int lookup_storage_arena_valid;
   uint32_t idx;
 
   {
@@ -921,6 +931,19 @@ int TVMGraphRuntime_SetupStorage(TVMGraphRuntime* runtime) {
     lookup_linked_param_valid =
         (TVMPackedFunc_InitModuleFunc(&lookup_linked_param, runtime->module_handle,
                                       "_lookup_linked_param", &temp_args) == 0);
+    // Modules built with -link-storage carry the static memory plan of the graph, the storage
+    // entries are then bound into its arena instead of being allocated.
+    lookup_storage_arena_valid =
+        (TVMPackedFunc_InitModuleFunc(&lookup_storage_arena, runtime->module_handle,
+                                      "_lookup_storage_arena", &temp_args) == 0);
+  }
+  // The arena is static, another runtime of the same module may hold it already. This runtime
+  // then allocates its storage entries.
+  if (lookup_storage_arena_valid) {
+    lookup_storage_arena.args.values[0].v_int64 = TVM_CRT_STORAGE_ARENA_ACQUIRE;
+    CHECK_EQ(lookup_storage_arena.Call(&lookup_storage_arena), 0, "lookup_storage_arena");
+    lookup_storage_arena_valid = lookup_storage_arena.ret_value.tcodes[0] != kTVMNullptr;
+    runtime->owns_storage_arena = lookup_storage_arena_valid;
   }
 
   // Grab saved optimization plan from graph.
@@ -994,6 +1017,26 @@ int TVMGraphRuntime_SetupStorage(TVMGraphRuntime* runtime) {
         did_find_linked_param = 1;
       }
     }
+    if (did_find_linked_param == 0 && lookup_storage_arena_valid) {
+      lookup_storage_arena.args.values[0].v_int64 = idx;
+      CHECK_EQ(lookup_storage_arena.Call(&lookup_storage_arena), 0, "lookup_storage_arena");
+
+      void* arena_data = lookup_storage_arena.ret_value.tcodes[0] == kTVMNullptr
+                             ? NULL
+                             : lookup_storage_arena.ret_value.values[0].v_handle;
+      if (arena_data != NULL) {
+        runtime->storage_pool[runtime->storage_pool_count].is_linked_param = 1;
+        DLTensor* tensor = &runtime->storage_pool[runtime->storage_pool_count].array.dl_tensor;
+        tensor->data = arena_data;
+        tensor->ctx = ctx;
+        tensor->ndim = attrs->ndim[pit.entry_id];
+        tensor->shape = attrs->shape + pit.entry_id * TVM_CRT_MAX_NDIM;
+        tensor->dtype = vtype[pit.entry_id];
+        tensor->strides = NULL;
+        tensor->byte_offset = 0;
+        did_find_linked_param = 1;
+      }
+    }
     if (did_find_linked_param == 0) {
       DLDataType dtype = {kDLFloat, 32, 1};
       int64_t shape[TVM_CRT_MAX_NDIM] = {
@@ -1225,6 +1268,23 @@ int TVMGraphRuntime_Release(TVMGraphRuntime** pptr) {
       }
     }
   }
+  if (runtime->owns_storage_arena) {
+    TVMPackedFunc lookup_storage_arena;
+    TVMArgs temp_args;
+    temp_args.values[0].v_int64 = TVM_CRT_STORAGE_ARENA_RELEASE;
+    temp_args.tcodes[0] = kTVMArgInt;
+    temp_args.values_count = 1;
+    status = TVMPackedFunc_InitModuleFunc(&lookup_storage_arena, runtime->module_handle,
+                                          "_lookup_storage_arena", &temp_args);
+    if (status != 0) {
+      return status;
+    }
+    status = lookup_storage_arena.Call(&lookup_storage_arena);
+    if (status != 0) {
+      return status;
+    }
+    runtime->owns_storage_arena = 0;
+  }
   for (idx = 0; idx < runtime->data_entry_count; ++idx) {
     status = TVMPlatformMemoryFree(runtime->data_entry[idx].dl_tensor.shape, ctx);
     if (status != 0) {
@@ -47,6 +47,8 @@ typedef struct TVMGraphRuntimeNodeEntry {
 
 // Storage entry.
 typedef struct TVMGraphRuntimeStorageEntry {
+  // Whether the data is owned by the module, a linked param or an entry of the static arena,
+  // and is not released with the runtime.
   uint8_t is_linked_param;
   TVMNDArray array;
 } TVMGraphRuntimeStorageEntry;
@@ -102,8 +104,15 @@ typedef struct TVMGraphRuntime {
   /*! \brief Operator on each node. */
   TVMPackedFunc* op_execs;
   uint32_t op_execs_count;
+  /*! \brief Whether the storage entries are bound into the static arena of the module. */
+  uint8_t owns_storage_arena;
 } TVMGraphRuntime;
 
+// The storage_ids acquiring and releasing the static arena of _lookup_storage_arena, they match
+// tvm::runtime::kStorageArenaAcquire and kStorageArenaRelease.
+#define TVM_CRT_STORAGE_ARENA_ACQUIRE (-1)
+#define TVM_CRT_STORAGE_ARENA_RELEASE (-2)
+
 typedef DLTensor* DLTensorPtr;
 
 // private functions
@@ -22,7 +22,6 @@
  * \brief Framing for RPC.
  */
 
-#include <checksum.h>
 #include <string.h>
 #include <tvm/runtime/crt/logging.h>
 #include <tvm/runtime/crt/rpc_common/framing.h>
@@ -45,10 +44,48 @@ namespace tvm {
 namespace runtime {
 namespace micro_rpc {
 
+/*! \brief The CRC-CCITT (polynomial 0x1021) of every byte value, see libcrc's crc_tabccitt. */
+static const uint16_t kCrc16Table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
+};
+
 uint16_t crc16_compute(const uint8_t* data, size_t data_size_bytes, uint16_t* previous_crc) {
+  // The lookup is inlined rather than calling libcrc's update_crc_ccitt() for every byte, the
+  // CRC covers every byte on the wire.
   uint16_t crc = (previous_crc != nullptr ? *previous_crc : 0xffff);
   for (size_t i = 0; i < data_size_bytes; ++i) {
-    crc = update_crc_ccitt(crc, data[i]);
+    crc = static_cast<uint16_t>(crc << 8) ^ kCrc16Table[((crc >> 8) ^ data[i]) & 0xff];
   }
 
   return crc;
@@ -131,42 +168,57 @@ tvm_crt_error_t Unframer::ConsumeInput(uint8_t* buffer, size_t buffer_size_bytes
                                        size_t* bytes_filled, bool update_crc) {
   CHECK(*bytes_filled < buffer_size_bytes);
   tvm_crt_error_t to_return = kTvmErrorNoError;
-  size_t i;
-  for (i = 0; i < input_size_bytes_; ++i) {
-    uint8_t c = input_[i];
-    if (saw_escape_start_) {
-      saw_escape_start_ = false;
-      if (c == to_integral(Escape::kPacketStart)) {
-        // When the start packet sequence is seen, abort unframing the current packet. Since the
-        // escape byte has already been parsed, update the CRC include only the escape byte. This
-        // readies the unframer to consume the kPacketStart byte on the next Write() call.
-        uint8_t escape_start = to_integral(Escape::kEscapeStart);
-        crc_ = crc16_compute(&escape_start, 1, nullptr);
-        to_return = kTvmErrorFramingShortPacket;
-        saw_escape_start_ = true;
-
-        break;
-      } else if (c == to_integral(Escape::kEscapeNop)) {
-        continue;
-      } else if (c == to_integral(Escape::kEscapeStart)) {
-        // do nothing (allow character to be printed)
-      } else {
-        // Invalid escape sequence.
-        to_return = kTvmErrorFramingInvalidEscape;
-        i++;
+  size_t i = 0;
+  while (i < input_size_bytes_) {
+    if (!saw_escape_start_) {
+      // Copy the run of bytes up to the next escape at once.
+      size_t run = input_size_bytes_ - i;
+      if (run > buffer_size_bytes - *bytes_filled) {
+        run = buffer_size_bytes - *bytes_filled;
+      }
+      const void* escape = memchr(&input_[i], to_integral(Escape::kEscapeStart), run);
+      if (escape != nullptr) {
+        run = static_cast<const uint8_t*>(escape) - &input_[i];
+      }
+      memcpy(&buffer[*bytes_filled], &input_[i], run);
+      *bytes_filled += run;
+      i += run;
+      if (*bytes_filled == buffer_size_bytes || i == input_size_bytes_) {
         break;
       }
-    } else if (c == to_integral(Escape::kEscapeStart)) {
+
       saw_escape_start_ = true;
+      i++;
       continue;
-    } else {
-      saw_escape_start_ = false;
     }
 
+    uint8_t c = input_[i];
+    saw_escape_start_ = false;
+    if (c == to_integral(Escape::kPacketStart)) {
+      // When the start packet sequence is seen, abort unframing the current packet. Since the
+      // escape byte has already been parsed, update the CRC include only the escape byte. This
+      // readies the unframer to consume the kPacketStart byte on the next Write() call.
+      uint8_t escape_start = to_integral(Escape::kEscapeStart);
+      crc_ = crc16_compute(&escape_start, 1, nullptr);
+      to_return = kTvmErrorFramingShortPacket;
+      saw_escape_start_ = true;
+
+      break;
+    } else if (c == to_integral(Escape::kEscapeNop)) {
+      i++;
+      continue;
+    } else if (c != to_integral(Escape::kEscapeStart)) {
+      // Invalid escape sequence.
+      to_return = kTvmErrorFramingInvalidEscape;
+      i++;
+      break;
+    }
+
+    // An escaped kEscapeStart is a literal byte.
     buffer[*bytes_filled] = c;
     (*bytes_filled)++;
+    i++;
     if (*bytes_filled == buffer_size_bytes) {
-      i++;
       break;
     }
   }
@@ -338,41 +390,61 @@ tvm_crt_error_t Framer::StartPacket(size_t payload_size_bytes) {
 
 tvm_crt_error_t Framer::WriteAndCrc(const uint8_t* data, size_t data_size_bytes, bool escape,
                                     bool update_crc) {
+  // Short runs and escapes are gathered in a stack buffer, long runs without an escape byte are
+  // written straight from data to save the copy. Both keep the number of transport writes low.
+  uint8_t buffer[kMaxStackBufferSizeBytes];
+  size_t buffer_ptr = 0;
+  auto write = [this, update_crc](const uint8_t* bytes, size_t size_bytes) {
+    size_t bytes_consumed;
+    tvm_crt_error_t to_return = stream_->WriteAll(bytes, size_bytes, &bytes_consumed);
+    if (to_return == kTvmErrorNoError && update_crc) {
+      crc_ = crc16_compute(bytes, size_bytes, &crc_);
+    }
+    return to_return;
+  };
+
   while (data_size_bytes > 0) {
-    uint8_t buffer[kMaxStackBufferSizeBytes];
-    size_t buffer_ptr = 0;
-    size_t i;
-    for (i = 0; i < data_size_bytes && buffer_ptr != kMaxStackBufferSizeBytes; ++i) {
-      uint8_t c = data[i];
-      if (!escape || c != to_integral(Escape::kEscapeStart)) {
-        buffer[buffer_ptr] = c;
-        buffer_ptr++;
-        continue;
+    size_t run = data_size_bytes;
+    if (escape) {
+      const void* escape_start = memchr(data, to_integral(Escape::kEscapeStart), data_size_bytes);
+      if (escape_start != nullptr) {
+        run = static_cast<const uint8_t*>(escape_start) - data;
       }
+    }
 
-      if (buffer_ptr == kMaxStackBufferSizeBytes - 1) {
-        break;
+    // An escape adds 2 bytes after the run.
+    size_t escaped_size_bytes = run + (run < data_size_bytes ? 2 : 0);
+    if (buffer_ptr > 0 && buffer_ptr + escaped_size_bytes > kMaxStackBufferSizeBytes) {
+      tvm_crt_error_t to_return = write(buffer, buffer_ptr);
+      if (to_return != kTvmErrorNoError) {
+        return to_return;
       }
-
-      buffer[buffer_ptr] = to_integral(Escape::kEscapeStart);
-      buffer_ptr++;
-
-      buffer[buffer_ptr] = to_integral(Escape::kEscapeStart);
-      buffer_ptr++;
+      buffer_ptr = 0;
     }
 
-    size_t bytes_consumed;
-    tvm_crt_error_t to_return = stream_->WriteAll(buffer, buffer_ptr, &bytes_consumed);
-    if (to_return != kTvmErrorNoError) {
-      return to_return;
+    if (escaped_size_bytes > kMaxStackBufferSizeBytes) {
+      tvm_crt_error_t to_return = write(data, run);
+      if (to_return != kTvmErrorNoError) {
+        return to_return;
+      }
+    } else {
+      memcpy(&buffer[buffer_ptr], data, run);
+      buffer_ptr += run;
     }
 
-    if (update_crc) {
-      crc_ = crc16_compute(buffer, buffer_ptr, &crc_);
+    data += run;
+    data_size_bytes -= run;
+    if (data_size_bytes > 0) {
+      buffer[buffer_ptr] = to_integral(Escape::kEscapeStart);
+      buffer[buffer_ptr + 1] = to_integral(Escape::kEscapeStart);
+      buffer_ptr += 2;
+      data++;
+      data_size_bytes--;
     }
+  }
 
-    data_size_bytes -= i;
-    data += i;
+  if (buffer_ptr > 0) {
+    return write(buffer, buffer_ptr);
   }
 
   return kTvmErrorNoError;
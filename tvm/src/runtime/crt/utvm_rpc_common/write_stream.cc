@@ -29,7 +29,7 @@ namespace micro_rpc {
 
 WriteStream::~WriteStream() {}
 
-tvm_crt_error_t WriteStream::WriteAll(uint8_t* data, size_t data_size_bytes,
+tvm_crt_error_t WriteStream::WriteAll(const uint8_t* data, size_t data_size_bytes,
                                       size_t* bytes_consumed) {
   *bytes_consumed = 0;
   while (data_size_bytes > 0) {
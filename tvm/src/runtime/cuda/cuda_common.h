@@ -28,6 +28,7 @@
 #include <tvm/runtime/packed_func.h>
 
 #include <string>
+#include <vector>
 
 #include "../workspace_pool.h"
 
@@ -58,6 +59,11 @@ class CUDAThreadEntry {
   cudaStream_t stream{nullptr};
   /*! \brief thread local pool*/
   WorkspacePool pool;
+  /*!
+   * \brief The workspaces allocated while capturing a CUDA graph, outside of the pool and
+   *  kept until the graph is released, nullptr when not capturing.
+   */
+  std::vector<void*>* capture_workspaces{nullptr};
   /*! \brief constructor */
   CUDAThreadEntry();
   // get the threadlocal workspace
@@ -28,8 +28,10 @@
 #include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
 #include <cstring>
 
+#include "../memory_stats.h"
 #include "cuda_common.h"
 
 namespace tvm {
@@ -116,10 +118,12 @@ class CUDADeviceAPI final : public DeviceAPI {
       CUDA_CALL(cudaSetDevice(ctx.device_id));
       CUDA_CALL(cudaMalloc(&ret, nbytes));
     }
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kGlobal, ret, nbytes);
     return ret;
   }
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    MemoryStats::Global()->Free(ctx, MemoryKind::kGlobal, ptr);
     if (ctx.device_type == kDLCPUPinned) {
       CUDA_CALL(cudaFreeHost(ptr));
     } else {
@@ -203,11 +207,24 @@ class CUDADeviceAPI final : public DeviceAPI {
   }
 
   void* AllocWorkspace(TVMContext ctx, size_t size, DLDataType type_hint) final {
-    return CUDAThreadEntry::ThreadLocal()->pool.AllocWorkspace(ctx, size);
+    CUDAThreadEntry* entry = CUDAThreadEntry::ThreadLocal();
+    if (entry->capture_workspaces != nullptr) {
+      // The replays of a captured graph use the workspaces of the capture
+      void* ptr = AllocDataSpace(ctx, size, kTempAllocaAlignment, type_hint);
+      entry->capture_workspaces->push_back(ptr);
+      return ptr;
+    }
+    return entry->pool.AllocWorkspace(ctx, size);
   }
 
   void FreeWorkspace(TVMContext ctx, void* data) final {
-    CUDAThreadEntry::ThreadLocal()->pool.FreeWorkspace(ctx, data);
+    CUDAThreadEntry* entry = CUDAThreadEntry::ThreadLocal();
+    if (entry->capture_workspaces != nullptr &&
+        std::find(entry->capture_workspaces->begin(), entry->capture_workspaces->end(), data) !=
+            entry->capture_workspaces->end()) {
+      return;
+    }
+    entry->pool.FreeWorkspace(ctx, data);
   }
 
   static CUDADeviceAPI* Global() {
@@ -239,6 +256,11 @@ TVM_REGISTER_GLOBAL("device_api.gpu").set_body([](TVMArgs args, TVMRetValue* rv)
   *rv = static_cast<void*>(ptr);
 });
 
+// The stream the calling thread launches on, null for the default stream.
+TVM_REGISTER_GLOBAL("device_api.gpu.GetStream").set_body_typed([]() {
+  return static_cast<void*>(CUDAThreadEntry::ThreadLocal()->stream);
+});
+
 TVM_REGISTER_GLOBAL("device_api.cpu_pinned").set_body([](TVMArgs args, TVMRetValue* rv) {
   DeviceAPI* ptr = CUDADeviceAPI::Global();
   *rv = static_cast<void*>(ptr);
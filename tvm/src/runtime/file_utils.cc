@@ -30,8 +30,16 @@
 
 #include <fstream>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace tvm {
 namespace runtime {
 
@@ -165,19 +173,11 @@ Map<String, NDArray> LoadParams(const std::string& param_blob) {
 }
 Map<String, NDArray> LoadParams(dmlc::Stream* strm) {
   Map<String, NDArray> params;
-  uint64_t header, reserved;
-  ICHECK(strm->Read(&header)) << "Invalid parameters file format";
-  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
-  ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
-
-  std::vector<std::string> names;
-  ICHECK(strm->Read(&names)) << "Invalid parameters file format";
-  uint64_t sz;
-  strm->Read(&sz);
-  size_t size = static_cast<size_t>(sz);
-  ICHECK(size == names.size()) << "Invalid parameters file format";
-  for (size_t i = 0; i < size; ++i) {
+  uint64_t reserved;
+  std::vector<std::string> names = ReadParamListHeader(strm, &reserved);
+  for (size_t i = 0; i < names.size(); ++i) {
     // The data_entry is allocated on device, NDArray.load always load the array into CPU.
+    SkipParamPadding(strm, reserved);
     NDArray temp;
     temp.Load(strm);
     params.Set(names[i], temp);
@@ -185,7 +185,122 @@ Map<String, NDArray> LoadParams(dmlc::Stream* strm) {
   return params;
 }
 
-void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params) {
+std::vector<std::string> ReadParamListHeader(dmlc::Stream* strm, uint64_t* reserved) {
+  uint64_t header;
+  ICHECK(strm->Read(&header)) << "Invalid parameters file format";
+  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
+  ICHECK(strm->Read(reserved)) << "Invalid parameters file format";
+  std::vector<std::string> names;
+  ICHECK(strm->Read(&names)) << "Invalid parameters file format";
+  uint64_t sz;
+  ICHECK(strm->Read(&sz)) << "Invalid parameters file format";
+  ICHECK(static_cast<size_t>(sz) == names.size()) << "Invalid parameters file format";
+  return names;
+}
+
+int64_t ReadDLTensorHeader(dmlc::Stream* strm, DLDataType* dtype, std::vector<int64_t>* shape) {
+  uint64_t header, reserved;
+  DLContext ctx;
+  int ndim;
+  ICHECK(strm->Read(&header) && header == kTVMNDArrayMagic) << "Invalid DLTensor file format";
+  ICHECK(strm->Read(&reserved) && strm->Read(&ctx) && strm->Read(&ndim) && strm->Read(dtype))
+      << "Invalid DLTensor file format";
+  shape->resize(ndim);
+  if (ndim != 0) {
+    ICHECK(strm->ReadArray(shape->data(), ndim)) << "Invalid DLTensor file format";
+  }
+  int64_t data_byte_size;
+  ICHECK(strm->Read(&data_byte_size)) << "Invalid DLTensor file format";
+  return data_byte_size;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (addr != nullptr) munmap(addr, size);
+#endif
+}
+
+std::shared_ptr<MappedFile> MapFile(const std::string& path) {
+  auto file = std::make_shared<MappedFile>();
+#ifdef _WIN32
+  LOG(FATAL) << "Mapping files is not supported on Windows";
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  ICHECK_GE(fd, 0) << "Cannot open file " << path;
+  struct stat st;
+  ICHECK_EQ(fstat(fd, &st), 0) << "Cannot stat file " << path;
+  file->size = static_cast<size_t>(st.st_size);
+  void* addr = mmap(nullptr, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  ICHECK(addr != MAP_FAILED) << "Cannot map file " << path;
+  file->addr = addr;
+#endif
+  return file;
+}
+
+namespace {
+void MappedNDArrayDeleter(Object* obj) {
+  auto* ptr = static_cast<NDArray::Container*>(obj);
+  delete static_cast<std::shared_ptr<MappedFile>*>(ptr->manager_ctx);
+  delete ptr;
+}
+}  // namespace
+
+NDArray ViewMappedData(const std::shared_ptr<MappedFile>& file, void* data,
+                       std::vector<int64_t> shape, DLDataType dtype, DLContext ctx) {
+  NDArray::Container* container = new NDArray::Container(data, std::move(shape), dtype, ctx);
+  container->manager_ctx = new std::shared_ptr<MappedFile>(file);
+  container->SetDeleter(MappedNDArrayDeleter);
+  return NDArray(GetObjectPtr<Object>(container));
+}
+
+void SkipParamPadding(dmlc::Stream* strm, uint64_t reserved) {
+  if (reserved == 0) return;
+  uint64_t padding;
+  ICHECK(strm->Read(&padding)) << "Invalid parameters file format";
+  ICHECK_LT(padding, reserved) << "Invalid parameters file format";
+  std::vector<char> skipped(padding);
+  ICHECK_EQ(strm->Read(skipped.data(), padding), padding) << "Invalid parameters file format";
+}
+
+namespace {
+/*! \brief A stream counting the bytes written to another stream. */
+class CountingStream : public dmlc::Stream {
+ public:
+  explicit CountingStream(dmlc::Stream* strm) : strm_(strm) {}
+  size_t Read(void* ptr, size_t size) final {
+    LOG(FATAL) << "CountingStream is write only";
+    return 0;
+  }
+  void Write(const void* ptr, size_t size) final {
+    strm_->Write(ptr, size);
+    bytes_ += size;
+  }
+  size_t bytes() const { return bytes_; }
+
+ private:
+  dmlc::Stream* strm_;
+  size_t bytes_{0};
+};
+}  // namespace
+
+size_t SaveParamPadding(dmlc::Stream* strm, size_t offset, const DLTensor* array,
+                        uint64_t alignment) {
+  // Bytes written by SaveDLTensor before the data
+  size_t array_header = sizeof(uint64_t) * 2 + sizeof(DLContext) + sizeof(int) +
+                        sizeof(DLDataType) + sizeof(int64_t) * array->ndim + sizeof(int64_t);
+  size_t data_offset = offset + sizeof(uint64_t) + array_header;
+  uint64_t padding = (alignment - data_offset % alignment) % alignment;
+  strm->Write(padding);
+  std::vector<char> zeros(padding, 0);
+  strm->Write(zeros.data(), zeros.size());
+  return sizeof(uint64_t) + padding;
+}
+
+void SaveParams(dmlc::Stream* fo, const Map<String, NDArray>& params, size_t alignment) {
+  ICHECK_EQ(alignment & (alignment - 1), 0) << "The alignment must be a power of two";
+  CountingStream counting(fo);
+  dmlc::Stream* strm = &counting;
   std::vector<std::string> names;
   std::vector<const DLTensor*> arrays;
   for (auto& p : params) {
@@ -193,7 +308,9 @@ void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params) {
     arrays.push_back(p.second.operator->());
   }
 
-  uint64_t header = kTVMNDArrayListMagic, reserved = 0;
+  // The reserved word holds the alignment of the data of the arrays, each array
+  // is then preceded by its padding, as a length and as many zero bytes.
+  uint64_t header = kTVMNDArrayListMagic, reserved = alignment > 1 ? alignment : 0;
   strm->Write(header);
   strm->Write(reserved);
   strm->Write(names);
@@ -201,16 +318,19 @@ void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params) {
     uint64_t sz = static_cast<uint64_t>(arrays.size());
     strm->Write(sz);
     for (size_t i = 0; i < sz; ++i) {
+      if (reserved != 0) {
+        SaveParamPadding(strm, counting.bytes(), arrays[i], reserved);
+      }
       tvm::runtime::SaveDLTensor(strm, arrays[i]);
     }
   }
 }
 
-std::string SaveParams(const Map<String, NDArray>& params) {
+std::string SaveParams(const Map<String, NDArray>& params, size_t alignment) {
   std::string bytes;
   dmlc::MemoryStringStream strm(&bytes);
   dmlc::Stream* fo = &strm;
-  SaveParams(fo, params);
+  SaveParams(fo, params, alignment);
   return bytes;
 }
 
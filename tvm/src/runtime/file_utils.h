@@ -25,9 +25,12 @@
 #define TVM_RUNTIME_FILE_UTILS_H_
 
 #include <tvm/runtime/container.h>
+#include <tvm/runtime/ndarray.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "meta_data.h"
 
@@ -111,15 +114,78 @@ Map<String, NDArray> LoadParams(dmlc::Stream* strm);
 /*!
  * \brief Serialize parameters to a byte array.
  * \param params Parameters to save.
+ * \param alignment If greater than one, the data of each array is padded to an offset
+ *  which is a multiple of it, so that a mapped file can be used in place.
  * \return String containing binary parameter data.
  */
-std::string SaveParams(const Map<String, NDArray>& params);
+std::string SaveParams(const Map<String, NDArray>& params, size_t alignment = 0);
 /*!
  * \brief Serialize parameters to a stream.
  * \param strm Stream to write to.
  * \param params Parameters to save.
+ * \param alignment If greater than one, the data of each array is padded to an offset
+ *  from the start of the stream which is a multiple of it.
  */
-void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params);
+void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params, size_t alignment = 0);
+/*!
+ * \brief Skip the padding in front of an array of a parameter list.
+ * \param strm The stream positioned at the array.
+ * \param reserved The reserved word of the list, the alignment of padded lists.
+ */
+void SkipParamPadding(dmlc::Stream* strm, uint64_t reserved);
+/*!
+ * \brief Write the padding in front of an array, so that the data written by SaveDLTensor
+ *  after it starts at an offset which is a multiple of the alignment.
+ * \param strm The stream to write to.
+ * \param offset The offset of the stream from the start of the serialized bytes.
+ * \param array The array that is saved after the padding.
+ * \param alignment The alignment of the data.
+ * \return The number of bytes written.
+ */
+size_t SaveParamPadding(dmlc::Stream* strm, size_t offset, const DLTensor* array,
+                        uint64_t alignment);
+/*!
+ * \brief Read the header of a parameter list, as written by SaveParams, up to its arrays.
+ * \param strm The stream positioned at the list.
+ * \param reserved The reserved word of the list, the alignment of padded lists.
+ * \return The names of the parameters, the arrays follow in the same order.
+ */
+std::vector<std::string> ReadParamListHeader(dmlc::Stream* strm, uint64_t* reserved);
+/*!
+ * \brief Read the header of an array, as written by SaveDLTensor, up to its data.
+ * \param strm The stream positioned at the array.
+ * \param dtype The data type of the array.
+ * \param shape The shape of the array.
+ * \return The size of the data in bytes.
+ */
+int64_t ReadDLTensorHeader(dmlc::Stream* strm, DLDataType* dtype, std::vector<int64_t>* shape);
+/*!
+ * \brief A private mapping of a file, unmapped with the last array viewing it.
+ *  Writes to the mapping are copied on write, they never reach the file.
+ */
+struct MappedFile {
+  void* addr{nullptr};
+  size_t size{0};
+  ~MappedFile();
+};
+/*!
+ * \brief Map a file in memory, its pages are only read when they are accessed.
+ * \param path The path of the file.
+ * \return The mapping.
+ * \note Not supported on Windows.
+ */
+std::shared_ptr<MappedFile> MapFile(const std::string& path);
+/*!
+ * \brief Create an array on the data of a mapped file, the array keeps the file mapped.
+ * \param file The mapped file.
+ * \param data The data of the array inside the mapping.
+ * \param shape The shape of the array.
+ * \param dtype The data type of the array.
+ * \param ctx The host context of the array.
+ * \return The array.
+ */
+NDArray ViewMappedData(const std::shared_ptr<MappedFile>& file, void* data,
+                       std::vector<int64_t> shape, DLDataType dtype, DLContext ctx);
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_FILE_UTILS_H_
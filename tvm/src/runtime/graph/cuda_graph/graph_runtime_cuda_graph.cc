@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_runtime_cuda_graph.cc
+ * \brief A graph runtime replaying the kernels of a run captured in a CUDA graph.
+ *
+ *  capture records the kernels of one run, in order on a stream of the runtime, into a CUDA
+ *  graph, and run then launches the graph instead of every kernel. The graph holds the data
+ *  pointers of the run it captured: run captures again when the storage of the inputs or
+ *  outputs changed since, e.g. after set_input_zero_copy, or after set_input on a shared
+ *  parameter. The workspaces of the kernels are allocated outside of the workspace pool
+ *  during the capture, and held until the graph is released.
+ *
+ *  Only graphs whose nodes all run on one GPU, with no host ops or copies, can be captured.
+ */
+#include <cuda_runtime.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <vector>
+
+#include "../../cuda/cuda_common.h"
+#include "../graph_runtime.h"
+
+namespace tvm {
+namespace runtime {
+
+class GraphRuntimeCudaGraph : public GraphRuntime {
+ public:
+  ~GraphRuntimeCudaGraph() {
+    ReleaseCapture();
+    if (stream_ != nullptr) {
+      cudaStreamDestroy(stream_);
+    }
+  }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name == "capture") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Capture(); });
+    } else if (name == "release_capture") {
+      return PackedFunc(
+          [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->ReleaseCapture(); });
+    } else if (name == "run") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        if (exec_ == nullptr) {
+          this->Run();
+          return;
+        }
+        if (DataPointers() != captured_ptrs_) this->Capture();
+        CUDA_CALL(cudaGraphLaunch(exec_, stream_));
+      });
+    }
+    return GraphRuntime::GetFunction(name, sptr_to_self);
+  }
+
+  /*! \brief Capture the kernels of a run, replacing the graph captured before. */
+  void Capture() {
+    for (const TVMContext& ctx : ctxs_) {
+      ICHECK(ctx.device_type == kDLGPU && ctx.device_id == ctxs_[0].device_id)
+          << "Only graphs on one CUDA device can be captured";
+    }
+    TVMContext ctx = ctxs_[0];
+    CUDA_CALL(cudaSetDevice(ctx.device_id));
+    // A blocking stream, so that the copies of set_input and get_output stay in order with it
+    if (stream_ == nullptr) CUDA_CALL(cudaStreamCreate(&stream_));
+    // The kernels launch on the stream of the thread
+    cudaStream_t prev = CUDAThreadEntry::ThreadLocal()->stream;
+    CUDAThreadEntry::ThreadLocal()->stream = stream_;
+    std::vector<void*> workspaces;
+    CUDAThreadEntry::ThreadLocal()->capture_workspaces = &workspaces;
+    // Relaxed, so that the workspaces can be allocated while capturing
+    CUDA_CALL(cudaStreamBeginCapture(stream_, cudaStreamCaptureModeRelaxed));
+    cudaGraph_t graph = nullptr;
+    try {
+      for (size_t i = 0; i < op_execs_.size(); ++i) {
+        if (!op_execs_[i]) continue;
+        this->WaitForParams(i);
+        op_execs_[i]();
+      }
+    } catch (...) {
+      cudaStreamEndCapture(stream_, &graph);
+      if (graph != nullptr) cudaGraphDestroy(graph);
+      CUDAThreadEntry::ThreadLocal()->stream = prev;
+      CUDAThreadEntry::ThreadLocal()->capture_workspaces = nullptr;
+      FreeWorkspaces(workspaces);
+      throw;
+    }
+    cudaError_t status = cudaStreamEndCapture(stream_, &graph);
+    CUDAThreadEntry::ThreadLocal()->stream = prev;
+    CUDAThreadEntry::ThreadLocal()->capture_workspaces = nullptr;
+    if (status != cudaSuccess) FreeWorkspaces(workspaces);
+    ICHECK_EQ(status, cudaSuccess) << "The run could not be captured, a node may not run on "
+                                   << "the captured stream: " << cudaGetErrorString(status);
+    ReleaseCapture();
+    status = cudaGraphInstantiate(&exec_, graph, nullptr, nullptr, 0);
+    cudaGraphDestroy(graph);
+    if (status != cudaSuccess) FreeWorkspaces(workspaces);
+    ICHECK_EQ(status, cudaSuccess) << "CUDA: " << cudaGetErrorString(status);
+    captured_ptrs_ = DataPointers();
+    workspaces_ = std::move(workspaces);
+  }
+
+  /*! \brief Release the captured graph, run then launches the kernels again. */
+  void ReleaseCapture() {
+    if (exec_ != nullptr) {
+      // A replay may still use the workspaces
+      CUDA_CALL(cudaStreamSynchronize(stream_));
+      cudaGraphExecDestroy(exec_);
+      exec_ = nullptr;
+    }
+    FreeWorkspaces(workspaces_);
+    captured_ptrs_.clear();
+  }
+
+ private:
+  /*! \brief Free the workspaces allocated during a capture. */
+  void FreeWorkspaces(std::vector<void*>& workspaces) {
+    for (void* ptr : workspaces) {
+      DeviceAPI::Get(ctxs_[0])->FreeDataSpace(ctxs_[0], ptr);
+    }
+    workspaces.clear();
+  }
+
+  /*! \brief The data pointers of the entries, and of the op arguments of the inputs. */
+  std::vector<void*> DataPointers() const {
+    std::vector<void*> ptrs;
+    ptrs.reserve(data_entry_.size());
+    for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+      ptrs.push_back(data_entry_[eid].defined() ? data_entry_[eid]->data : nullptr);
+      if (eid < input_dltensors_.size() && !input_dltensors_[eid].empty()) {
+        ptrs.push_back(input_dltensors_[eid][0]->data);
+      }
+    }
+    return ptrs;
+  }
+
+  /*! \brief The stream the graph is captured on and launched on. */
+  cudaStream_t stream_{nullptr};
+  /*! \brief The captured graph, nullptr when there is none. */
+  cudaGraphExec_t exec_{nullptr};
+  /*! \brief The data pointers the graph was captured with. */
+  std::vector<void*> captured_ptrs_;
+  /*! \brief The workspaces the captured kernels use, freed with the graph. */
+  std::vector<void*> workspaces_;
+};
+
+// The arguments are those of tvm.graph_runtime.create.
+TVM_REGISTER_GLOBAL("tvm.graph_runtime_cuda_graph.create")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      ICHECK_GE(args.num_args, 4) << "The expected number of arguments for "
+                                     "graph_runtime_cuda_graph.create is at least 4, but it has "
+                                  << args.num_args;
+      PackedFunc lookup_linked_param_func;
+      int ctx_start_arg = 2;
+      if (args[2].type_code() == kTVMPackedFuncHandle) {
+        lookup_linked_param_func = args[2];
+        ctx_start_arg++;
+      }
+      auto exec = make_object<GraphRuntimeCudaGraph>();
+      exec->Init(args[0], args[1], GetAllContext(args, ctx_start_arg), lookup_linked_param_func);
+      *rv = Module(exec);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
@@ -26,7 +26,9 @@
 #include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
 #include <chrono>
+#include <iomanip>
 #include <sstream>
 
 #include "../graph_runtime.h"
@@ -57,6 +59,97 @@ class GraphRuntimeDebug : public GraphRuntime {
    *         iteration only, because returning a long string over rpc can be expensive.
    */
   std::string RunIndividual(int number, int repeat, int min_repeat_ms) {
+    std::vector<double> time_sec_per_op = TimeOps(number, repeat, min_repeat_ms);
+    std::ostringstream os;
+    for (size_t index = 0; index < time_sec_per_op.size(); index++) {
+      os << time_sec_per_op[index] << ",";
+    }
+    return os.str();
+  }
+
+  /*!
+   * \brief Run each operation in the graph like RunIndividual, and report the achieved FLOP/s
+   *  and bandwidth of every op from the static "flop_ct" and "bytes" estimates of the graph.
+   *
+   *  The ops are sorted by time, the most expensive first. An op is reported as memory bound
+   *  when its arithmetic intensity is below the ridge point of the roofline given by the best
+   *  FLOP/s and bandwidth achieved by any op of the graph.
+   *
+   * \param number The number of times to run every op for taking average.
+   * \param repeat The number of times to repeat the measurement.
+   * \param min_repeat_ms The minimum duration of one `repeat` in milliseconds.
+   * \return The report as a table.
+   */
+  std::string RunRoofline(int number, int repeat, int min_repeat_ms) {
+    std::vector<double> time_sec_per_op = TimeOps(number, repeat, min_repeat_ms);
+    std::vector<size_t> ops;
+    double total_sec = 0, total_flop = 0, total_bytes = 0, peak_flops = 0, peak_bw = 0;
+    for (size_t index = 0; index < time_sec_per_op.size(); ++index) {
+      if (!op_execs_[index] || time_sec_per_op[index] <= 0) continue;
+      const TVMOpParam& param = nodes_[index].param;
+      double sec = time_sec_per_op[index];
+      ops.push_back(index);
+      total_sec += sec;
+      if (param.flop_ct >= 0) {
+        total_flop += param.flop_ct;
+        peak_flops = std::max(peak_flops, param.flop_ct / sec);
+      }
+      if (param.bytes >= 0) {
+        total_bytes += param.bytes;
+        peak_bw = std::max(peak_bw, param.bytes / sec);
+      }
+    }
+    std::sort(ops.begin(), ops.end(), [&time_sec_per_op](size_t a, size_t b) {
+      return time_sec_per_op[a] > time_sec_per_op[b];
+    });
+    double ridge = peak_bw > 0 ? peak_flops / peak_bw : 0;
+
+    std::ostringstream os;
+    os << std::left << std::setw(48) << "Node" << std::right << std::setw(12) << "Time(us)"
+       << std::setw(10) << "Time(%)" << std::setw(12) << "GFLOP/s" << std::setw(10) << "GB/s"
+       << std::setw(10) << "FLOP/B" << "  Bound\n";
+    os << std::fixed << std::setprecision(2);
+    for (size_t index : ops) {
+      const TVMOpParam& param = nodes_[index].param;
+      double sec = time_sec_per_op[index];
+      os << std::left << std::setw(48) << GetNodeName(index) << std::right << std::setw(12)
+         << sec * 1e6 << std::setw(10) << sec / total_sec * 100;
+      os << std::setw(12);
+      if (param.flop_ct >= 0) {
+        os << param.flop_ct / sec / 1e9;
+      } else {
+        os << "-";
+      }
+      os << std::setw(10);
+      if (param.bytes >= 0) {
+        os << param.bytes / sec / 1e9;
+      } else {
+        os << "-";
+      }
+      os << std::setw(10);
+      if (param.flop_ct >= 0 && param.bytes > 0) {
+        double intensity = param.flop_ct / param.bytes;
+        os << intensity << "  " << (intensity < ridge ? "memory" : "compute");
+      } else {
+        os << "-";
+      }
+      os << "\n";
+    }
+    os << "Total: " << total_sec * 1e6 << " us, " << total_flop / total_sec / 1e9 << " GFLOP/s, "
+       << total_bytes / total_sec / 1e9 << " GB/s\n";
+    os << "Best achieved: " << peak_flops / 1e9 << " GFLOP/s, " << peak_bw / 1e9
+       << " GB/s, ridge point " << ridge << " FLOP/B\n";
+    return os.str();
+  }
+
+ private:
+  /*!
+   * \brief Time each operation in the graph.
+   * \return The elapsed time per op of the last iteration in seconds.
+   */
+  std::vector<double> TimeOps(int number, int repeat, int min_repeat_ms) {
+    // The ops are run on their own below, which does not wait for their parameters
+    this->WaitForParamUpload();
     // warmup run
     GraphRuntime::Run();
     std::string tkey = module_->type_key();
@@ -111,11 +204,65 @@ class GraphRuntimeDebug : public GraphRuntime {
         }
       }
     }
+    return time_sec_per_op;
+  }
 
+ public:
+
+  /*!
+   * \brief Run the graph once and record a timeline of the launched kernels.
+   *
+   *  Every kernel is labelled with the name of the graph node that launched it. Only the
+   *  devices registering "profiling.trace_start.<device>" support tracing.
+   *
+   * \return The timeline in the Chrome trace event JSON format.
+   */
+  std::string RunTrace() {
+    this->WaitForParamUpload();
+    // warmup run
+    GraphRuntime::Run();
+    std::vector<TVMContext> traced;
+    for (const TVMContext& ctx : ctxs_) {
+      std::string name = DeviceName(ctx.device_type);
+      if (Registry::Get("profiling.trace_start." + name) == nullptr) continue;
+      bool seen = std::any_of(traced.begin(), traced.end(), [&ctx](const TVMContext& c) {
+        return c.device_type == ctx.device_type && c.device_id == ctx.device_id;
+      });
+      if (!seen) traced.push_back(ctx);
+    }
+    ICHECK(!traced.empty()) << "None of the graph devices supports kernel tracing";
+    for (const TVMContext& ctx : traced) {
+      (*Registry::Get("profiling.trace_start." + std::string(DeviceName(ctx.device_type))))(ctx);
+    }
+    for (size_t index = 0; index < op_execs_.size(); ++index) {
+      if (!op_execs_[index]) continue;
+      for (const TVMContext& ctx : traced) {
+        const PackedFunc* flabel =
+            Registry::Get("profiling.trace_label." + std::string(DeviceName(ctx.device_type)));
+        if (flabel != nullptr) (*flabel)(String(GetNodeName(index)));
+      }
+      op_execs_[index]();
+    }
+    for (const TVMContext& ctx : traced) {
+      const PackedFunc* flabel =
+          Registry::Get("profiling.trace_label." + std::string(DeviceName(ctx.device_type)));
+      if (flabel != nullptr) (*flabel)(String(""));
+    }
     std::ostringstream os;
-    for (size_t index = 0; index < time_sec_per_op.size(); index++) {
-      os << time_sec_per_op[index] << ",";
+    os << "{\"traceEvents\": [";
+    bool first = true;
+    for (const TVMContext& ctx : traced) {
+      std::string events =
+          (*Registry::Get("profiling.trace_stop." + std::string(DeviceName(ctx.device_type))))(ctx);
+      // each device returns a JSON array, splice its elements into the combined list
+      size_t begin = events.find('[') + 1, end = events.rfind(']');
+      std::string body = events.substr(begin, end - begin);
+      if (body.find_first_not_of(" \n") == std::string::npos) continue;
+      if (!first) os << ",";
+      os << body;
+      first = false;
     }
+    os << "\n]}";
     return os.str();
   }
 
@@ -221,6 +368,7 @@ class GraphRuntimeDebug : public GraphRuntime {
     ICHECK_LT(static_cast<size_t>(index), op_execs_.size());
     uint32_t eid = index;
 
+    this->WaitForParamUpload();
     for (size_t i = 0; i < op_execs_.size(); ++i) {
       if (op_execs_[i]) op_execs_[i]();
       if (static_cast<int>(i) == index) break;
@@ -260,6 +408,19 @@ PackedFunc GraphRuntimeDebug::GetFunction(const std::string& name,
       ICHECK_GE(min_repeat_ms, 0);
       *rv = this->RunIndividual(number, repeat, min_repeat_ms);
     });
+  } else if (name == "run_roofline") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int number = args[0];
+      int repeat = args[1];
+      int min_repeat_ms = args[2];
+      ICHECK_GT(number, 0);
+      ICHECK_GT(repeat, 0);
+      ICHECK_GE(min_repeat_ms, 0);
+      *rv = this->RunRoofline(number, repeat, min_repeat_ms);
+    });
+  } else if (name == "run_trace") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->RunTrace(); });
   } else {
     return GraphRuntime::GetFunction(name, sptr_to_self);
   }
@@ -28,17 +28,27 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/serializer.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <algorithm>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <numeric>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../compressed_param.h"
 #include "../file_utils.h"
+#include "../library_module.h"
 #include "../texture.h"
 
 namespace tvm {
@@ -50,15 +60,660 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
   return align;
 }
 constexpr auto Is2DStorage = IsTextureStorage;
+
+/*!
+ * \brief Place blocks in one arena, so that the blocks living at the same time do not overlap.
+ * \param sizes The size of each block in bytes.
+ * \param live The first and last node using each block.
+ * \param offsets The offset of each block in the arena, aligned to kAllocAlignment.
+ * \return The size of the arena.
+ */
+inline int64_t PlanArena(const std::vector<int64_t>& sizes,
+                         const std::vector<std::pair<uint32_t, uint32_t>>& live,
+                         std::vector<int64_t>* offsets) {
+  std::vector<int64_t> aligned;
+  for (int64_t size : sizes) {
+    aligned.push_back((size + kAllocAlignment - 1) / kAllocAlignment * kAllocAlignment);
+  }
+  // The largest blocks are placed first, each at the lowest offset clear of the placed
+  // blocks living at the same time.
+  std::vector<size_t> order(sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&aligned](size_t a, size_t b) { return aligned[a] > aligned[b]; });
+  offsets->assign(sizes.size(), 0);
+  int64_t total = 0;
+  std::vector<size_t> placed;
+  for (size_t i : order) {
+    std::vector<std::pair<int64_t, int64_t>> taken;
+    for (size_t j : placed) {
+      if (live[j].first <= live[i].second && live[i].first <= live[j].second) {
+        taken.emplace_back((*offsets)[j], (*offsets)[j] + aligned[j]);
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    int64_t offset = 0;
+    for (const auto& range : taken) {
+      if (range.first - offset >= aligned[i]) break;
+      offset = std::max(offset, range.second);
+    }
+    (*offsets)[i] = offset;
+    total = std::max(total, offset + aligned[i]);
+    placed.push_back(i);
+  }
+  return total;
+}
+
+inline void ArenaViewDeleter(Object* obj) {
+  auto* ptr = static_cast<NDArray::Container*>(obj);
+  delete static_cast<NDArray*>(ptr->manager_ctx);
+  delete ptr;
+}
+
+/*! \brief View the bytes of a host arena at an offset as an array, keeping the arena alive. */
+inline NDArray ViewArena(const NDArray& arena, int64_t offset, std::vector<int64_t> shape,
+                         DLDataType dtype) {
+  void* data = static_cast<char*>(arena->data) + offset;
+  auto* container = new NDArray::Container(data, std::move(shape), dtype, arena->ctx);
+  container->manager_ctx = new NDArray(arena);
+  container->SetDeleter(ArenaViewDeleter);
+  return NDArray(GetObjectPtr<Object>(container));
+}
 }  // namespace details
 
 /*!
- * \brief Run all the operations one by one.
+ * \brief Run all the operations one by one, or concurrently when workers are set up.
  */
 void GraphRuntime::Run() {
+  threading::ThreadPoolScope pool_scope(thread_pool_);
+  if (!perf_hint_.empty()) set_perf_hint_(perf_hint_);
+  if (!workers_.empty()) {
+    this->RunConcurrently();
+    return;
+  }
+  // The texture scratch of the kernels is handed out as planned by the first run, the plan of
+  // an enclosing run on this thread is restored at the end
+  void* outer_plan = nullptr;
+  if (texture_plan_ != nullptr) outer_plan = begin_texture_plan_(texture_plan_);
+  try {
+    this->RunOps();
+  } catch (...) {
+    if (texture_plan_ != nullptr) end_texture_plan_(outer_plan);
+    throw;
+  }
+  if (texture_plan_ != nullptr) end_texture_plan_(outer_plan);
+}
+
+void GraphRuntime::RunOps() {
+  // At most one of the run modes is set, see CheckRunMode. The arenas of the bounded memory
+  // are planned for the node order, the storage dependencies do not hold.
+  if (bounded_memory_) {
+    this->RunBounded();
+    return;
+  }
+  if (op_sampler_ != nullptr && op_sampler_->BeginRun()) {
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (!op_execs_[i]) continue;
+      this->WaitForParams(i);
+      op_sampler_->StartOp(i, data_entry_[entry_id(i, 0)]->ctx);
+      op_execs_[i]();
+      op_sampler_->StopOp();
+    }
+    return;
+  }
+  if (ooo_stream_ != nullptr) {
+    this->RunOutOfOrder();
+    return;
+  }
+  if (!hinted_streams_.empty()) {
+    this->RunOnHintedStreams();
+    return;
+  }
+  if (!op_streams_.empty()) {
+    this->RunOnStreams();
+    return;
+  }
   // setup the array and requirements.
   for (size_t i = 0; i < op_execs_.size(); ++i) {
-    if (op_execs_[i]) op_execs_[i]();
+    if (!op_execs_[i]) continue;
+    this->WaitForParams(i);
+    op_execs_[i]();
+  }
+}
+
+void GraphRuntime::RunBounded() {
+  for (size_t i = 0; i < op_execs_.size(); ++i) {
+    if (!streamed_params_.empty()) {
+      for (const auto& param : streamed_params_[i]) {
+        NDArray value = param_source_(param.second);
+        ICHECK(value.defined()) << "The parameter source has no parameter " << param.second;
+        SetParamFrom(value, data_entry_[param.first]);
+      }
+    }
+    if (!op_execs_[i]) continue;
+    op_execs_[i]();
+  }
+}
+
+std::string GraphRuntime::GetRunMode() const {
+  if (!workers_.empty()) return "worker threads";
+  if (bounded_memory_) return "bounded memory";
+  if (!op_streams_.empty()) return "GPU streams";
+  if (!hinted_streams_.empty()) return "queue hints";
+  if (ooo_stream_ != nullptr) return "out-of-order queue";
+  return "";
+}
+
+void GraphRuntime::CheckRunMode(const std::string& mode) const {
+  std::string active = this->GetRunMode();
+  ICHECK(active.empty() || active == mode)
+      << "The graph cannot run with " << mode << ", it already runs with " << active;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> GraphRuntime::GetEntryLiveness() const {
+  uint32_t num_nodes = static_cast<uint32_t>(nodes_.size());
+  std::vector<uint32_t> exec_at(num_nodes);
+  std::iota(exec_at.begin(), exec_at.end(), 0);
+  for (uint32_t nid = 0; nid < op_batched_.size(); ++nid) {
+    for (uint32_t member : op_batched_[nid]) exec_at[member] = nid;
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> live(num_node_entries(), {num_nodes, 0});
+  auto use = [&live](uint32_t eid, uint32_t nid) {
+    live[eid].first = std::min(live[eid].first, nid);
+    live[eid].second = std::max(live[eid].second, nid);
+  };
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type == "null") continue;
+    for (const auto& e : inode.inputs) use(this->entry_id(e), exec_at[nid]);
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      use(this->entry_id(nid, index), exec_at[nid]);
+    }
+  }
+  return live;
+}
+
+void GraphRuntime::SetParamSource(PackedFunc fetch, const Array<String>& names) {
+  this->StartParamLoad();
+  this->CheckRunMode("bounded memory");
+  std::vector<std::pair<uint32_t, uint32_t>> entry_live = this->GetEntryLiveness();
+  std::vector<uint32_t> eids;
+  std::vector<std::string> param_names;
+  std::vector<int64_t> sizes;
+  std::vector<std::pair<uint32_t, uint32_t>> live;
+  for (const String& name : names) {
+    int in_idx = GetInputIndex(name);
+    ICHECK_GE(in_idx, 0) << "Cannot find parameter " << name << " among the graph inputs";
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    const DLTensor* entry = data_entry_[eid].operator->();
+    ICHECK(entry->ctx.device_type == kDLCPU && !details::Is2DStorage(attrs_.storage_scope[eid]))
+        << "Only parameters in host memory are streamed, " << name << " is not";
+    if (entry_live[eid].first > entry_live[eid].second) continue;
+    eids.push_back(eid);
+    param_names.push_back(name);
+    sizes.push_back(static_cast<int64_t>(GetDataSize(*entry)));
+    live.push_back(entry_live[eid]);
+  }
+  std::vector<int64_t> offsets;
+  int64_t total = details::PlanArena(sizes, live, &offsets);
+  NDArray arena = NDArray::Empty({total}, DLDataType{kDLUInt, 8, 1}, TVMContext{kDLCPU, 0});
+  streamed_params_.assign(nodes_.size(), {});
+  for (size_t i = 0; i < eids.size(); ++i) {
+    uint32_t eid = eids[i];
+    const DLTensor* entry = data_entry_[eid].operator->();
+    std::vector<int64_t> shape(entry->shape, entry->shape + entry->ndim);
+    data_entry_[eid] = details::ViewArena(arena, offsets[i], shape, entry->dtype);
+    data_alignment_[eid] = details::GetDataAlignment(*data_entry_[eid].operator->());
+    // Parameters have storage of their own, which is no longer needed
+    storage_pool_[attrs_.storage_id[eid]] = NDArray();
+    shared_param_eids_.erase(eid);
+    param_eids_.insert(eid);
+    streamed_params_[live[i].first].emplace_back(eid, param_names[i]);
+  }
+  param_source_ = fetch;
+  bounded_memory_ = true;
+  this->SetupOpExecs();
+}
+
+int64_t GraphRuntime::SetMemoryBudget(int64_t max_bytes) {
+  this->WaitForParamUpload();
+  this->CheckRunMode("bounded memory");
+  uint32_t num_nodes = static_cast<uint32_t>(nodes_.size());
+  std::vector<std::pair<uint32_t, uint32_t>> entry_live = this->GetEntryLiveness();
+  // The storage of the entries written by nodes and on the host only, the inputs, the params
+  // and the storage shared with other runtimes stay where they are.
+  std::vector<bool> movable(storage_pool_.size(), true);
+  std::vector<std::pair<uint32_t, uint32_t>> sid_live(storage_pool_.size(), {num_nodes, 0});
+  for (uint32_t nid : input_nodes_) movable[attrs_.storage_id[this->entry_id(nid, 0)]] = false;
+  for (uint32_t eid : param_eids_) movable[attrs_.storage_id[eid]] = false;
+  for (const auto& kv : shared_storage_) movable[kv.first] = false;
+  for (const auto& kv : texture_row_views_) movable[kv.first] = false;
+  for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+    uint32_t sid = static_cast<uint32_t>(attrs_.storage_id[eid]);
+    const NDArray& storage = storage_pool_[sid];
+    if (!storage.defined() || storage->ctx.device_type != kDLCPU ||
+        details::Is2DStorage(attrs_.storage_scope[eid])) {
+      movable[sid] = false;
+    }
+    sid_live[sid].first = std::min(sid_live[sid].first, entry_live[eid].first);
+    sid_live[sid].second = std::max(sid_live[sid].second, entry_live[eid].second);
+  }
+  // The outputs are read after the run
+  for (const auto& e : outputs_) sid_live[attrs_.storage_id[this->entry_id(e)]].second = num_nodes;
+  std::vector<uint32_t> sids;
+  std::vector<int64_t> sizes;
+  std::vector<std::pair<uint32_t, uint32_t>> live;
+  for (uint32_t sid = 0; sid < storage_pool_.size(); ++sid) {
+    if (!movable[sid] || sid_live[sid].first > sid_live[sid].second) continue;
+    sids.push_back(sid);
+    sizes.push_back(static_cast<int64_t>(GetDataSize(*storage_pool_[sid].operator->())));
+    live.push_back(sid_live[sid]);
+  }
+  std::vector<int64_t> offsets;
+  int64_t total = details::PlanArena(sizes, live, &offsets);
+  ICHECK_LE(total, max_bytes) << "The intermediates need an arena of " << total
+                              << " bytes, over the budget of " << max_bytes << " bytes";
+  NDArray arena = NDArray::Empty({total}, DLDataType{kDLUInt, 8, 1}, TVMContext{kDLCPU, 0});
+  std::unordered_set<uint32_t> moved(sids.begin(), sids.end());
+  for (size_t i = 0; i < sids.size(); ++i) {
+    const DLTensor* storage = storage_pool_[sids[i]].operator->();
+    std::vector<int64_t> shape(storage->shape, storage->shape + storage->ndim);
+    storage_pool_[sids[i]] = details::ViewArena(arena, offsets[i], shape, storage->dtype);
+  }
+  for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+    uint32_t sid = static_cast<uint32_t>(attrs_.storage_id[eid]);
+    if (!moved.count(sid)) continue;
+    data_entry_[eid] = storage_pool_[sid].CreateView(attrs_.shape[eid], data_entry_[eid]->dtype);
+    data_alignment_[eid] = details::GetDataAlignment(*data_entry_[eid].operator->());
+  }
+  bounded_memory_ = true;
+  this->SetupOpExecs();
+  return total;
+}
+
+void GraphRuntime::SetOpSampling(int sample_every) {
+  ICHECK_GE(sample_every, 0);
+  op_sampler_.reset(sample_every > 0 ? new OpSampler(sample_every, nodes_.size()) : nullptr);
+}
+
+std::string GraphRuntime::GetOpSamples() const {
+  if (op_sampler_ == nullptr) return "";
+  return op_sampler_->Report([this](uint32_t nid) { return GetNodeName(nid); });
+}
+
+void GraphRuntime::SetQueueHints(const std::string& priority, const std::string& throttle) {
+  this->ReleaseHintedStreams();
+  if (priority.empty() && throttle.empty()) return;
+  this->CheckRunMode("queue hints");
+  const PackedFunc* create = Registry::Get("device_api.opencl.CreateHintedStream");
+  for (const TVMContext& ctx : ctxs_) {
+    if (ctx.device_type != kDLOpenCL) continue;
+    ICHECK(create != nullptr) << "The queue hints need the OpenCL runtime";
+    void* stream = (*create)(ctx.device_id, priority, throttle);
+    hinted_streams_.emplace_back(ctx, stream);
+  }
+  if (hinted_streams_.empty()) {
+    LOG(WARNING) << "The queue hints are ignored, the graph does not run on OpenCL";
+    return;
+  }
+  hinted_copies_.assign(nodes_.size(), false);
+  for (size_t nid = 0; nid < nodes_.size(); ++nid) {
+    const auto& inode = nodes_[nid];
+    hinted_copies_[nid] = inode.op_type == "tvm_op" && inode.param.func_name == "__copy";
+  }
+}
+
+void GraphRuntime::SetPerfHint(const std::string& hint) {
+  perf_hint_ = hint;
+  if (hint.empty()) return;
+  const PackedFunc* set_perf_hint = Registry::Get("device_api.opencl.set_perf_hint");
+  ICHECK(set_perf_hint != nullptr) << "The performance hint needs the OpenCL runtime";
+  set_perf_hint_ = *set_perf_hint;
+  set_perf_hint_(hint);
+}
+
+void GraphRuntime::ReleaseHintedStreams() {
+  for (const auto& entry : hinted_streams_) {
+    DeviceAPI::Get(entry.first)->FreeStream(entry.first, entry.second);
+  }
+  hinted_streams_.clear();
+  hinted_copies_.clear();
+}
+
+void GraphRuntime::RunOnHintedStreams() {
+  // Order the commands of one queue of each device after the ones issued on the other
+  auto sync = [this](bool to_default) {
+    for (const auto& entry : hinted_streams_) {
+      TVMStreamHandle src = to_default ? entry.second : nullptr;
+      TVMStreamHandle dst = to_default ? nullptr : entry.second;
+      DeviceAPI::Get(entry.first)->SyncStreamFromTo(entry.first, src, dst);
+    }
+  };
+  auto set_streams = [this](bool hinted) {
+    for (const auto& entry : hinted_streams_) {
+      DeviceAPI::Get(entry.first)->SetStream(entry.first, hinted ? entry.second : nullptr);
+    }
+  };
+  // The inputs are set, and the outputs read, on the default queues
+  sync(false);
+  set_streams(true);
+  try {
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (!op_execs_[i]) continue;
+      this->WaitForParams(i);
+      if (hinted_copies_[i]) sync(true);
+      op_execs_[i]();
+      if (hinted_copies_[i]) sync(false);
+    }
+  } catch (...) {
+    set_streams(false);
+    throw;
+  }
+  set_streams(false);
+  sync(true);
+}
+
+void GraphRuntime::SetOutOfOrder(bool enable) {
+  if (ooo_stream_ != nullptr) {
+    DeviceAPI::Get(ooo_ctx_)->FreeStream(ooo_ctx_, ooo_stream_);
+    ooo_stream_ = nullptr;
+    this->SetupOutOfOrderWaits();
+  }
+  if (!enable) return;
+  this->CheckRunMode("out-of-order queue");
+  auto cl = std::find_if(ctxs_.begin(), ctxs_.end(),
+                         [](const TVMContext& ctx) { return ctx.device_type == kDLOpenCL; });
+  if (cl == ctxs_.end()) {
+    LOG(WARNING) << "The graph does not run on OpenCL, it runs in order";
+    return;
+  }
+  const PackedFunc* create = Registry::Get("device_api.opencl.CreateOutOfOrderStream");
+  ICHECK(create != nullptr) << "The out-of-order queue needs the OpenCL runtime";
+  void* stream = (*create)(cl->device_id);
+  if (stream == nullptr) {
+    LOG(WARNING) << "The OpenCL device does not support out-of-order queues, the graph runs "
+                 << "in order";
+    return;
+  }
+  ooo_ctx_ = *cl;
+  ooo_stream_ = stream;
+  ooo_begin_ = *Registry::Get("device_api.opencl.BeginNodes");
+  ooo_set_node_ = *Registry::Get("device_api.opencl.SetNode");
+  ooo_end_ = *Registry::Get("device_api.opencl.EndNodes");
+  this->SetupOutOfOrderWaits();
+}
+
+void GraphRuntime::SetupOutOfOrderWaits() {
+  ooo_waits_.clear();
+  ooo_barriers_.clear();
+  if (ooo_stream_ == nullptr) return;
+  uint32_t num_nodes = this->GetNumOfNodes();
+  std::vector<std::vector<uint32_t>> op_preds(num_nodes);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (uint32_t succ : op_succs_[nid]) op_preds[succ].push_back(nid);
+  }
+  std::vector<bool> on_queue(num_nodes, false);
+  ooo_barriers_.assign(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (!op_execs_[nid]) continue;
+    const auto& inode = nodes_[nid];
+    TVMContext ctx = data_entry_[this->entry_id(nid, 0)]->ctx;
+    if ((inode.op_type == "tvm_op" && inode.param.func_name == "__copy") ||
+        !op_batched_[nid].empty()) {
+      ooo_barriers_[nid] = true;
+    } else {
+      on_queue[nid] =
+          ctx.device_type == ooo_ctx_.device_type && ctx.device_id == ooo_ctx_.device_id;
+    }
+  }
+  // The barriers order the nodes after all the ones before them, and a wait already waited
+  // for by another wait is pruned to keep the event wait lists short.
+  ooo_waits_.assign(num_nodes, {});
+  int64_t last_barrier = -1;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (ooo_barriers_[nid]) last_barrier = nid;
+    if (!on_queue[nid]) continue;
+    std::vector<uint32_t> waits;
+    std::unordered_set<uint32_t> implied;
+    for (uint32_t pred : op_preds[nid]) {
+      if (!on_queue[pred] || static_cast<int64_t>(pred) < last_barrier) continue;
+      waits.push_back(pred);
+      implied.insert(op_preds[pred].begin(), op_preds[pred].end());
+    }
+    for (uint32_t pred : waits) {
+      if (!implied.count(pred)) ooo_waits_[nid].push_back(pred);
+    }
+  }
+}
+
+void GraphRuntime::RunOutOfOrder() {
+  DeviceAPI* device = DeviceAPI::Get(ooo_ctx_);
+  // The inputs are set, and the outputs read, on the default queue
+  device->SyncStreamFromTo(ooo_ctx_, nullptr, ooo_stream_);
+  device->SetStream(ooo_ctx_, ooo_stream_);
+  ooo_begin_(static_cast<int>(op_execs_.size()));
+  try {
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (!op_execs_[i]) continue;
+      this->WaitForParams(i);
+      if (ooo_barriers_[i]) {
+        device->SyncStreamFromTo(ooo_ctx_, ooo_stream_, nullptr);
+        op_execs_[i]();
+        device->SyncStreamFromTo(ooo_ctx_, nullptr, ooo_stream_);
+        continue;
+      }
+      auto& waits = ooo_waits_[i];
+      ooo_set_node_(static_cast<int>(i), static_cast<void*>(waits.data()),
+                    static_cast<int>(waits.size()));
+      op_execs_[i]();
+    }
+  } catch (...) {
+    ooo_end_();
+    device->SetStream(ooo_ctx_, nullptr);
+    throw;
+  }
+  ooo_end_();
+  device->SetStream(ooo_ctx_, nullptr);
+  device->SyncStreamFromTo(ooo_ctx_, ooo_stream_, nullptr);
+}
+
+void GraphRuntime::RunOnStreams() {
+  DeviceAPI* device = DeviceAPI::Get(stream_ctx_);
+  try {
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (!op_execs_[i]) continue;
+      this->WaitForParams(i);
+      for (TVMStreamHandle producer : op_stream_waits_[i]) {
+        device->SyncStreamFromTo(stream_ctx_, producer, op_streams_[i]);
+      }
+      device->SetStream(stream_ctx_, op_streams_[i]);
+      op_execs_[i]();
+    }
+  } catch (...) {
+    device->SetStream(stream_ctx_, nullptr);
+    throw;
+  }
+  device->SetStream(stream_ctx_, nullptr);
+  // The outputs are read on the default stream
+  for (TVMStreamHandle stream : streams_) {
+    device->SyncStreamFromTo(stream_ctx_, stream, nullptr);
+  }
+}
+
+GraphRuntime::~GraphRuntime() {
+  if (param_loader_.joinable()) param_loader_.join();
+  this->ReleasePipeline();
+  {
+    std::lock_guard<std::mutex> lock(run_mu_);
+    stop_workers_ = true;
+  }
+  ready_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  for (const auto& entry : copy_streams_) {
+    DeviceAPI::Get(entry.first)->FreeStream(entry.first, entry.second);
+  }
+  for (TVMStreamHandle stream : streams_) {
+    DeviceAPI::Get(stream_ctx_)->FreeStream(stream_ctx_, stream);
+  }
+  this->ReleaseHintedStreams();
+  if (ooo_stream_ != nullptr) DeviceAPI::Get(ooo_ctx_)->FreeStream(ooo_ctx_, ooo_stream_);
+  if (texture_plan_ != nullptr) {
+    (*Registry::Get("device_api.opencl.FreeTextureWorkspacePlan"))(texture_plan_);
+  }
+  if (is_worker_) {
+    std::lock_guard<std::mutex> lock(worker_group_->mu);
+    auto& workers = worker_group_->workers;
+    workers.erase(std::remove(workers.begin(), workers.end(), this), workers.end());
+  }
+  if (shared_param_release_ != nullptr) {
+    // Drop the parameters before the hook, so it sees they are no longer used
+    op_execs_.clear();
+    input_dltensors_.clear();
+    data_entry_.clear();
+    storage_pool_.clear();
+    shared_storage_.clear();
+    shared_param_release_();
+  }
+}
+
+void GraphRuntime::StartWorkers() {
+  // "auto" sizes the workers by the width of the graph
+  static int num_threads = [] {
+    const char* val = getenv("TVM_GRAPH_RUNTIME_NUM_THREADS");
+    if (val == nullptr) return 0;
+    return std::string(val) == "auto" ? -1 : atoi(val);
+  }();
+  if (num_threads == 0 || num_threads == 1 || !workers_.empty()) return;
+  // Concurrency only pays off when a node can overlap another
+  size_t num_ops = std::count_if(op_execs_.begin(), op_execs_.end(),
+                                 [](const std::function<void()>& f) { return bool(f); });
+  if (num_ops < 2) return;
+  // TVM_NUM_THREADS may ask for more threads than there are cores, the pools below pin one
+  // thread per core and are never given more cores than the machine has.
+  int max_concurrency = threading::MaxConcurrency();
+  int num_cores = static_cast<int>(std::thread::hardware_concurrency());
+  if (num_cores > 0) max_concurrency = std::min(max_concurrency, num_cores);
+  // More workers than cores would only contend with the thread pools of the others
+  int num_workers = std::min(num_threads, max_concurrency);
+  if (num_threads < 0) {
+    // The nodes are in topological order, the width of the graph is the largest number of
+    // nodes at the same depth.
+    std::vector<uint32_t> depth(op_execs_.size(), 0);
+    std::unordered_map<uint32_t, int> width;
+    int max_width = 0;
+    for (uint32_t nid = 0; nid < op_execs_.size(); ++nid) {
+      if (!op_execs_[nid]) continue;
+      max_width = std::max(max_width, ++width[depth[nid]]);
+      for (uint32_t succ : op_succs_[nid]) {
+        depth[succ] = std::max(depth[succ], depth[nid] + 1);
+      }
+    }
+    num_workers = std::min(max_width, max_concurrency);
+  }
+  if (num_workers <= 1) return;
+  this->CheckRunMode("worker threads");
+  // Split the cores between the workers for the nodes running side by side, while a node
+  // running alone gets all of them. Both are overridden by set_thread_pool.
+  int cores_per_worker = std::max(max_concurrency / num_workers, 1);
+  std::vector<unsigned int> all_cores;
+  for (int i = 0; i < max_concurrency; ++i) {
+    all_cores.push_back(i);
+  }
+  wide_pool_ = threading::CreateThreadPool(all_cores);
+  for (int i = 0; i < num_workers; ++i) {
+    std::vector<unsigned int> cores;
+    for (int j = 0; j < cores_per_worker; ++j) {
+      cores.push_back((i * cores_per_worker + j) % max_concurrency);
+    }
+    worker_pools_.push_back(threading::CreateThreadPool(cores));
+  }
+  // The OpenCL stream is per thread, the workers launch on the one of the caller of Run
+  if (const PackedFunc* get_stream = Registry::Get("device_api.opencl.GetStream")) {
+    get_stream_ = *get_stream;
+  }
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this, i]() { this->WorkerLoop(i); });
+  }
+}
+
+void GraphRuntime::RunConcurrently() {
+  std::unique_lock<std::mutex> lock(run_mu_);
+  run_streams_.clear();
+  if (get_stream_ != nullptr) {
+    for (const TVMContext& ctx : ctxs_) {
+      if (ctx.device_type == kDLOpenCL) {
+        void* stream = get_stream_();
+        run_streams_.emplace_back(ctx, stream);
+      }
+    }
+  }
+  pending_deps_ = op_num_deps_;
+  num_pending_ = 0;
+  run_error_ = nullptr;
+  for (uint32_t nid = 0; nid < op_execs_.size(); ++nid) {
+    if (!op_execs_[nid]) continue;
+    ++num_pending_;
+    if (pending_deps_[nid] == 0) ready_.push(nid);
+  }
+  ready_cv_.notify_all();
+  done_cv_.wait(lock, [this]() {
+    return num_pending_ == 0 || (run_error_ != nullptr && num_running_ == 0);
+  });
+  ready_ = decltype(ready_)();
+  if (run_error_ != nullptr) {
+    std::exception_ptr error = run_error_;
+    run_error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void GraphRuntime::WorkerLoop(int worker_id) {
+  std::unique_lock<std::mutex> lock(run_mu_);
+  while (true) {
+    ready_cv_.wait(lock, [this]() { return stop_workers_ || !ready_.empty(); });
+    if (stop_workers_) return;
+    // Take the earliest node in the graph order, which keeps the run close to the serial one
+    uint32_t nid = ready_.top();
+    ready_.pop();
+    bool alone = num_running_ == 0 && ready_.empty();
+    ++num_running_;
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      threading::ThreadPoolScope pool_scope(
+          thread_pool_.defined() ? thread_pool_ : alone ? wide_pool_ : worker_pools_[worker_id]);
+      // run_streams_ is only set while no node runs
+      for (const auto& entry : run_streams_) {
+        DeviceAPI::Get(entry.first)->SetStream(entry.first, entry.second);
+      }
+      this->WaitForParams(nid);
+      op_execs_[nid]();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    for (const auto& entry : run_streams_) {
+      DeviceAPI::Get(entry.first)->SetStream(entry.first, nullptr);
+    }
+    lock.lock();
+    --num_running_;
+    if (error != nullptr && run_error_ == nullptr) {
+      run_error_ = error;
+      ready_ = decltype(ready_)();
+    }
+    if (run_error_ != nullptr) {
+      if (num_running_ == 0) done_cv_.notify_all();
+      continue;
+    }
+    --num_pending_;
+    for (uint32_t succ : op_succs_[nid]) {
+      if (--pending_deps_[succ] == 0) {
+        ready_.push(succ);
+        ready_cv_.notify_one();
+      }
+    }
+    if (num_pending_ == 0) done_cv_.notify_all();
   }
 }
 /*!
@@ -71,7 +726,8 @@ void GraphRuntime::Run() {
  * \param lookup_linked_param_func Linked parameter lookup function.
  */
 void GraphRuntime::Init(const std::string& graph_json, tvm::runtime::Module module,
-                        const std::vector<TVMContext>& ctxs, PackedFunc lookup_linked_param_func) {
+                        const std::vector<TVMContext>& ctxs, PackedFunc lookup_linked_param_func,
+                        const SharedParamFunc& shared_params) {
   std::istringstream is(graph_json);
   dmlc::JSONReader reader(&is);
   this->Load(&reader);
@@ -82,13 +738,38 @@ void GraphRuntime::Init(const std::string& graph_json, tvm::runtime::Module modu
     lookup_linked_param_ = PackedFunc(
         [this](TVMArgs args, TVMRetValue* rv) { this->DefaultLookupLinkedParam(args, rv); });
   }
+  if (shared_params != nullptr) this->BindSharedParams(shared_params);
   this->SetupStorage();
   this->SetupOpExecs();
+  this->StartWorkers();
+  // TVM_GRAPH_RUNTIME_TEXTURE_PLAN=1 plans the texture scratch of the kernels once per graph,
+  // otherwise it is left to the pool
+  const char* texture_plan = getenv("TVM_GRAPH_RUNTIME_TEXTURE_PLAN");
+  bool on_opencl = std::any_of(ctxs_.begin(), ctxs_.end(), [](const TVMContext& ctx) {
+    return ctx.device_type == kDLOpenCL;
+  });
+  if (on_opencl && texture_plan_ == nullptr && texture_plan != nullptr &&
+      atoi(texture_plan) != 0) {
+    const PackedFunc* create = Registry::Get("device_api.opencl.CreateTextureWorkspacePlan");
+    const PackedFunc* begin = Registry::Get("device_api.opencl.BeginTextureWorkspacePlan");
+    const PackedFunc* end = Registry::Get("device_api.opencl.EndTextureWorkspacePlan");
+    if (create != nullptr && begin != nullptr && end != nullptr) {
+      texture_plan_ = (*create)();
+      begin_texture_plan_ = *begin;
+      end_texture_plan_ = *end;
+    }
+  }
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     const uint32_t nid = input_nodes_[i];
     std::string& name = nodes_[nid].name;
     input_map_[name] = i;
   }
+  if (const char* sample_every = getenv("TVM_GRAPH_RUNTIME_OP_SAMPLING")) {
+    this->SetOpSampling(atoi(sample_every));
+  }
+  if (const char* out_of_order = getenv("TVM_GRAPH_RUNTIME_OUT_OF_ORDER")) {
+    this->SetOutOfOrder(atoi(out_of_order) != 0);
+  }
 }
 /*!
  * \brief Get the input index given the name of input.
@@ -102,6 +783,14 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
   }
   return -1;
 }
+
+int GraphRuntime::GetInputIndex(const char* name) {
+  auto it = input_map_.find(name);
+  if (it != input_map_.end()) {
+    return it->second;
+  }
+  return -1;
+}
 /*!
  * \brief set index-th input to the graph.
  * \param index The input index.
@@ -110,8 +799,34 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
 void GraphRuntime::SetInput(int index, DLTensor* data_in) {
   ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
+  if (param_eids_.count(eid)) this->WaitForParamUpload();
+  this->DetachSharedParam(eid);
   data_entry_[eid].CopyFrom(data_in);
 }
+/*!
+ * \brief set index-th input to the graph asynchronously on a device stream.
+ * \param index The input index.
+ * \param data_in The input data.
+ * \param stream The stream to enqueue the copy to.
+ */
+void GraphRuntime::SetInputAsync(int index, DLTensor* data_in, TVMStreamHandle stream) {
+  ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  uint32_t eid = this->entry_id(input_nodes_[index], 0);
+  if (param_eids_.count(eid)) this->WaitForParamUpload();
+  this->DetachSharedParam(eid);
+  DLTensor* to = const_cast<DLTensor*>(data_entry_[eid].operator->());
+  TVMContext ctx = to->ctx;
+  if (stream == nullptr || ctx.device_type == kDLCPU) {
+    data_entry_[eid].CopyFrom(data_in);
+    return;
+  }
+  DeviceAPI* device = DeviceAPI::Get(ctx);
+  // Do not overwrite the input before previously enqueued consumers have read it.
+  device->SyncStreamFromTo(ctx, nullptr, stream);
+  NDArray::CopyFromTo(data_in, to, stream);
+  // Order the next execution after the upload without blocking the host.
+  device->SyncStreamFromTo(ctx, stream, nullptr);
+}
 /*!
  * \brief set index-th input to the graph without copying the data.
  * \param index The input index.
@@ -120,12 +835,14 @@ void GraphRuntime::SetInput(int index, DLTensor* data_in) {
 void GraphRuntime::SetInputZeroCopy(int index, DLTensor* data_ref) {
   ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
+  if (param_eids_.count(eid)) this->WaitForParamUpload();
   const DLTensor* old_t = data_entry_[eid].operator->();
 
   // check the consistency of input
   ICHECK_EQ(data_alignment_[eid], details::GetDataAlignment(*data_ref));
   ICHECK_EQ(reinterpret_cast<size_t>(data_ref->data) % kAllocAlignment, 0);
   ICHECK_EQ(old_t->ndim, static_cast<size_t>(data_ref->ndim));
+  ICHECK(TypeEqual(old_t->dtype, data_ref->dtype));
   ICHECK_EQ(old_t->ctx.device_type, data_ref->ctx.device_type);
   ICHECK_EQ(old_t->ctx.device_id, data_ref->ctx.device_id);
   for (auto i = 0; i < data_ref->ndim; ++i) {
@@ -149,6 +866,14 @@ int GraphRuntime::NumOutputs() const { return outputs_.size(); }
  * \return The number of inputs to the graph.
  */
 int GraphRuntime::NumInputs() const { return input_nodes_.size(); }
+/*!
+ * \brief Whether an input still uses a parameter shared at Init in place.
+ * \param index The input index.
+ */
+bool GraphRuntime::IsSharedInput(int index) const {
+  ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  return shared_param_eids_.count(this->entry_id(input_nodes_[index], 0)) != 0;
+}
 /*!
  * \brief Return NDArray for given input index.
  * \param index The input index.
@@ -200,32 +925,237 @@ void GraphRuntime::LoadParams(const std::string& param_blob) {
 }
 
 void GraphRuntime::LoadParams(dmlc::Stream* strm) {
-  Map<String, NDArray> params = ::tvm::runtime::LoadParams(strm);
-  for (auto& p : params) {
-    uint32_t eid = this->entry_id(input_nodes_[GetInputIndex(p.first)], 0);
-    data_entry_[eid].CopyFrom(p.second);
+  this->StartParamLoad();
+  // Parameters are uploaded one at a time as they are read so only a single host copy is
+  // alive. Texture scoped parameters are serialized in the row-major order of their image,
+  // the payload is written into the image as is. Compressed parameters are decompressed on
+  // the device of the parameter when it supports it.
+  uint64_t reserved;
+  std::vector<std::string> names = ReadParamListHeader(strm, &reserved);
+  for (size_t i = 0; i < names.size(); ++i) {
+    SkipParamPadding(strm, reserved);
+    NDArray temp;
+    temp.Load(strm);
+    int in_idx = GetInputIndex(names[i]);
+    ICHECK_GE(in_idx, 0) << "Cannot find parameter " << names[i] << " among the graph inputs";
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    this->DetachSharedParam(eid);
+    SetParamFrom(temp, data_entry_[eid]);
+    param_eids_.insert(eid);
   }
 }
 
+void GraphRuntime::LoadParamsMapped(const std::string& path) {
+  this->StartParamLoad();
+#ifdef _WIN32
+  std::string param_blob;
+  LoadBinaryFromFile(path, &param_blob);
+  this->LoadParams(param_blob);
+#else
+  std::shared_ptr<MappedFile> file = MapFile(path);
+
+  dmlc::MemoryFixedSizeStream strm(file->addr, file->size);
+  uint64_t reserved;
+  std::vector<std::string> names = ReadParamListHeader(&strm, &reserved);
+  for (size_t i = 0; i < names.size(); ++i) {
+    int in_idx = GetInputIndex(names[i]);
+    ICHECK_GE(in_idx, 0) << "Cannot find parameter " << names[i] << " among the graph inputs";
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    param_eids_.insert(eid);
+    SkipParamPadding(&strm, reserved);
+    size_t begin = strm.Tell();
+    DLDataType dtype;
+    std::vector<int64_t> shape;
+    int64_t data_byte_size = ReadDLTensorHeader(&strm, &dtype, &shape);
+    size_t data_offset = strm.Tell();
+    ICHECK_LE(data_offset + data_byte_size, file->size) << "Invalid DLTensor file format";
+    void* data = static_cast<char*>(file->addr) + data_offset;
+
+    // Arrays in host memory, aligned in the file and stored in native byte order are
+    // used in place. Other arrays in native byte order are uploaded straight from the
+    // mapped pages, which are dropped afterwards, so no host copy of them is made.
+    const DLTensor* entry = data_entry_[eid].operator->();
+    int sid = attrs_.storage_id[eid];
+    bool native = DMLC_IO_NO_ENDIAN_SWAP && TypeEqual(dtype, entry->dtype) &&
+                  shape == std::vector<int64_t>(entry->shape, entry->shape + entry->ndim);
+    if (!native) {
+      strm.Seek(begin);
+      NDArray temp;
+      temp.Load(&strm);
+      SetParamFrom(temp, data_entry_[eid]);
+      continue;
+    }
+    strm.Seek(data_offset + data_byte_size);
+    bool in_place = entry->ctx.device_type == kDLCPU &&
+                    !details::Is2DStorage(attrs_.storage_scope[eid]) &&
+                    reinterpret_cast<uintptr_t>(data) % kAllocAlignment == 0;
+    if (!in_place) {
+      this->DetachSharedParam(eid);
+      data_entry_[eid].CopyFromBytes(data, data_byte_size);
+      size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      size_t page_begin = data_offset / page * page;
+      madvise(static_cast<char*>(file->addr) + page_begin,
+              data_offset + data_byte_size - page_begin, MADV_DONTNEED);
+      continue;
+    }
+    shared_param_eids_.erase(eid);
+    data_entry_[eid] = ViewMappedData(file, data, shape, dtype, entry->ctx);
+    data_alignment_[eid] = details::GetDataAlignment(*data_entry_[eid].operator->());
+    // Parameters have storage of their own, which is no longer needed
+    storage_pool_[sid] = NDArray();
+  }
+  this->SetupOpExecs();
+#endif
+}
+
+void GraphRuntime::LoadParamsAsync(std::string param_blob) {
+  this->StartParamLoad();
+  auto blob = std::make_shared<std::string>(std::move(param_blob));
+  dmlc::MemoryStringStream strm(blob.get());
+  uint64_t reserved;
+  std::vector<std::string> names = ReadParamListHeader(&strm, &reserved);
+  // Find the arrays in the blob, and the first node reading each of them
+  std::vector<uint32_t> first_use(this->num_node_entries(), nodes_.size());
+  for (uint32_t nid = 0; nid < nodes_.size(); ++nid) {
+    for (const auto& e : nodes_[nid].inputs) {
+      uint32_t eid = this->entry_id(e);
+      first_use[eid] = std::min(first_use[eid], nid);
+    }
+  }
+  std::vector<std::pair<uint32_t, size_t>> arrays;
+  for (size_t i = 0; i < names.size(); ++i) {
+    int in_idx = GetInputIndex(names[i]);
+    ICHECK_GE(in_idx, 0) << "Cannot find parameter " << names[i] << " among the graph inputs";
+    SkipParamPadding(&strm, reserved);
+    arrays.emplace_back(this->entry_id(input_nodes_[in_idx], 0), strm.Tell());
+    DLDataType dtype;
+    std::vector<int64_t> shape;
+    int64_t data_byte_size = ReadDLTensorHeader(&strm, &dtype, &shape);
+    ICHECK_LE(strm.Tell() + data_byte_size, blob->size()) << "Invalid DLTensor file format";
+    strm.Seek(strm.Tell() + data_byte_size);
+  }
+  std::stable_sort(arrays.begin(), arrays.end(), [&first_use](const auto& a, const auto& b) {
+    return first_use[a.first] < first_use[b.first];
+  });
+
+  {
+    std::lock_guard<std::mutex> lock(param_mu_);
+    for (const auto& array : arrays) {
+      this->DetachSharedParam(array.first);
+      pending_params_.insert(array.first);
+      param_eids_.insert(array.first);
+    }
+    num_pending_params_ = pending_params_.size();
+  }
+  param_loader_ = std::thread([this, blob, arrays]() {
+    dmlc::MemoryStringStream strm(blob.get());
+    for (const auto& array : arrays) {
+      std::string error;
+      try {
+        strm.Seek(array.second);
+        NDArray temp;
+        temp.Load(&strm);
+        SetParamFrom(temp, data_entry_[array.first]);
+      } catch (const std::exception& e) {
+        error = e.what();
+      }
+      {
+        std::lock_guard<std::mutex> lock(param_mu_);
+        if (error.empty()) {
+          pending_params_.erase(array.first);
+          --num_pending_params_;
+        } else {
+          param_error_ = error;
+        }
+      }
+      param_cv_.notify_all();
+      if (!error.empty()) return;
+    }
+  });
+}
+
+void GraphRuntime::WaitForParams(uint32_t nid) {
+  if (num_pending_params_ == 0) return;
+  std::unique_lock<std::mutex> lock(param_mu_);
+  std::vector<uint32_t> covered = op_batched_[nid];
+  covered.push_back(nid);
+  for (uint32_t member : covered) {
+    for (const auto& e : nodes_[member].inputs) {
+      uint32_t eid = this->entry_id(e);
+      param_cv_.wait(lock, [this, eid]() {
+        return !param_error_.empty() || pending_params_.count(eid) == 0;
+      });
+      ICHECK(param_error_.empty()) << "Failed to upload the parameters: " << param_error_;
+    }
+  }
+}
+
+void GraphRuntime::WaitForParamUpload() {
+  if (param_loader_.joinable()) param_loader_.join();
+  ICHECK(param_error_.empty()) << "Failed to upload the parameters: " << param_error_;
+}
+
+void GraphRuntime::StartParamLoad() {
+  if (param_loader_.joinable()) param_loader_.join();
+  // The new load supersedes a failed upload, the parameters it did not reach keep the content
+  // they had before it
+  std::lock_guard<std::mutex> lock(param_mu_);
+  param_error_.clear();
+  pending_params_.clear();
+  num_pending_params_ = 0;
+}
+
+ObjectPtr<GraphRuntime> GraphRuntime::CreateWorker() {
+  this->WaitForParamUpload();
+  auto worker = make_object<GraphRuntime>();
+  worker->nodes_ = nodes_;
+  worker->input_nodes_ = input_nodes_;
+  worker->input_map_ = input_map_;
+  worker->node_row_ptr_ = node_row_ptr_;
+  worker->outputs_ = outputs_;
+  worker->attrs_ = attrs_;
+  worker->module_ = module_;
+  worker->ctxs_ = ctxs_;
+  GraphRuntime* self = worker.get();
+  worker->module_lookup_linked_param_valid_ = false;
+  worker->lookup_linked_param_ = PackedFunc(
+      [self](TVMArgs args, TVMRetValue* rv) { self->DefaultLookupLinkedParam(args, rv); });
+  // Parameters are read only, so only the storage of the activations is per worker
+  for (uint32_t eid : param_eids_) {
+    worker->shared_storage_[attrs_.storage_id[eid]] = data_entry_[eid];
+  }
+  worker->param_eids_ = param_eids_;
+  // A write on the worker must not reach this runtime or the other workers
+  worker->shared_param_eids_ = param_eids_;
+  worker->shared_param_release_ = shared_param_release_;
+  worker->SetupStorage();
+  worker->SetupOpExecs();
+  worker->StartWorkers();
+  if (worker_group_ == nullptr) worker_group_ = std::make_shared<WorkerGroup>();
+  worker->worker_group_ = worker_group_;
+  worker->is_worker_ = true;
+  {
+    std::lock_guard<std::mutex> lock(worker_group_->mu);
+    worker_group_->workers.push_back(self);
+  }
+  return worker;
+}
+
 void GraphRuntime::ShareParams(const GraphRuntime& other, dmlc::Stream* strm) {
-  uint64_t header, reserved;
-  ICHECK(strm->Read(&header)) << "Invalid parameters file format";
-  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
-  ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
-  std::vector<std::string> names;
-  ICHECK(strm->Read(&names)) << "Invalid parameters file format";
-  uint64_t sz;
-  strm->Read(&sz);
-  size_t size = static_cast<size_t>(sz);
-  ICHECK(size == names.size()) << "Invalid parameters file format";
-  for (size_t i = 0; i < size; ++i) {
+  uint64_t reserved;
+  std::vector<std::string> names = ReadParamListHeader(strm, &reserved);
+  for (size_t i = 0; i < names.size(); ++i) {
     int in_idx = GetInputIndex(names[i]);
     if (in_idx < 0) continue;
     uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
     ICHECK_LT(eid, data_entry_.size());
     ICHECK_EQ(data_entry_[eid].use_count(), 1);
-    data_entry_[eid] = other.GetInput(GetInputIndex(names[i]));
+    NDArray param = other.GetInput(GetInputIndex(names[i]));
+    TVMContext ctx = data_entry_[eid]->ctx;
+    if (param->ctx.device_id != ctx.device_id) param = ViewOnDevice(param, ctx);
+    data_entry_[eid] = param;
     ICHECK_GT(data_entry_[eid].use_count(), 1);
+    param_eids_.insert(eid);
     const DLTensor* tmp = data_entry_[eid].operator->();
     data_alignment_[eid] = details::GetDataAlignment(*tmp);
   }
@@ -238,6 +1168,24 @@ void GraphRuntime::LinkedNDArrayDeleter(Object* container) {
   delete static_cast<NDArray::Container*>(container);
 }
 
+void GraphRuntime::DeviceViewDeleter(Object* container) {
+  auto* ptr = static_cast<NDArray::Container*>(container);
+  delete static_cast<NDArray*>(ptr->manager_ctx);
+  delete ptr;
+}
+
+NDArray GraphRuntime::ViewOnDevice(const NDArray& arr, TVMContext ctx) {
+  ICHECK(arr->ctx.device_type == kDLOpenCL && ctx.device_type == kDLOpenCL)
+      << "Only the devices of the OpenCL context share their buffers, cannot view an array of "
+      << arr->ctx << " on " << ctx;
+  std::vector<int64_t> shape(arr->shape, arr->shape + arr->ndim);
+  auto* container = new NDArray::Container(arr->data, shape, arr->dtype, ctx);
+  container->dl_tensor.byte_offset = arr->byte_offset;
+  container->manager_ctx = new NDArray(arr);
+  container->SetDeleter(GraphRuntime::DeviceViewDeleter);
+  return NDArray(GetObjectPtr<Object>(container));
+}
+
 void GraphRuntime::DefaultLookupLinkedParam(TVMArgs args, TVMRetValue* rv) {
   Module mod = args[0];
   int64_t storage_id = args[1];
@@ -263,18 +1211,87 @@ void GraphRuntime::DefaultLookupLinkedParam(TVMArgs args, TVMRetValue* rv) {
   std::vector<int64_t> shape_vec{template_tensor->shape,
                                  template_tensor->shape + template_tensor->ndim};
 
+  // The data lives in the constant section of the library, i.e. in host memory. Parameters of
+  // other devices are uploaded from there by SetupStorage.
+  if (ctx.device_type != kDLCPU) {
+    ctx = TVMContext{kDLCPU, 0};
+  }
   std::unique_ptr<NDArray::Container> container{new NDArray::Container(
       static_cast<void*>(opaque_handle), shape_vec, template_tensor->dtype, ctx)};
   container->SetDeleter(GraphRuntime::LinkedNDArrayDeleter);
   *rv = NDArray(GetObjectPtr<Object>(container.release()));
 }
 
+void GraphRuntime::BindSharedParams(const SharedParamFunc& shared_params) {
+  for (uint32_t nid : input_nodes_) {
+    uint32_t eid = this->entry_id(nid, 0);
+    // Textures are laid out by their storage, so only the flat parameters are shared
+    if (details::Is2DStorage(attrs_.storage_scope[eid])) continue;
+    int device_type = static_cast<int>(ctxs_[0].device_type);
+    if (!attrs_.device_index.empty()) device_type = attrs_.device_index[eid];
+    auto cit = std::find_if(ctxs_.begin(), ctxs_.end(), [device_type](const TVMContext& c) {
+      return static_cast<int>(c.device_type) == device_type;
+    });
+    NDArray param = shared_params(nodes_[nid].name, cit == ctxs_.end() ? ctxs_[0] : *cit);
+    if (!param.defined()) continue;
+    const DLTensor* t = param.operator->();
+    const std::vector<int64_t>& shape = attrs_.shape[eid];
+    if (static_cast<size_t>(t->ndim) != shape.size() ||
+        !std::equal(shape.begin(), shape.end(), t->shape) ||
+        !TypeEqual(t->dtype, String2DLDataType(attrs_.dltype[eid]))) {
+      continue;
+    }
+    shared_storage_[attrs_.storage_id[eid]] = param;
+    shared_param_eids_.insert(eid);
+    param_eids_.insert(eid);
+  }
+}
+
+void GraphRuntime::DetachSharedParam(uint32_t eid, bool copy_content) {
+  if (shared_param_eids_.erase(eid) == 0) return;
+  NDArray prev = data_entry_[eid];
+  const DLTensor* t = prev.operator->();
+  NDArray owned = NDArray::Empty(std::vector<int64_t>(t->shape, t->shape + t->ndim), t->dtype,
+                                 t->ctx);
+  if (copy_content) owned.CopyFrom(prev);
+  for (DLTensor* arg : input_dltensors_[eid]) {
+    arg->data = owned->data;
+  }
+  storage_pool_[attrs_.storage_id[eid]] = owned;
+  data_entry_[eid] = owned;
+  if (worker_group_ != nullptr && !is_worker_) {
+    std::lock_guard<std::mutex> lock(worker_group_->mu);
+    for (GraphRuntime* worker : worker_group_->workers) {
+      worker->RebindParam(eid, prev, owned);
+    }
+  }
+  prev = NDArray();
+  if (shared_param_release_ != nullptr) shared_param_release_();
+}
+
+void GraphRuntime::RebindParam(uint32_t eid, const NDArray& prev, const NDArray& array) {
+  // The worker wrote its own copy of the parameter
+  if (data_entry_[eid]->data != prev->data) return;
+  for (DLTensor* arg : input_dltensors_[eid]) {
+    arg->data = array->data;
+  }
+  uint32_t sid = attrs_.storage_id[eid];
+  storage_pool_[sid] = array;
+  shared_storage_[sid] = array;
+  data_entry_[eid] = array;
+}
+
 void GraphRuntime::SetupStorage() {
   // Grab saved optimization plan from graph.
   std::vector<DLDataType> vtype;
   for (const std::string& s_type : attrs_.dltype) {
     vtype.push_back(tvm::runtime::String2DLDataType(s_type));
   }
+  // Textures may store their texels at a lower precision than the kernels compute with
+  std::vector<DLDataType> storage_vtype = vtype;
+  for (size_t i = 0; i < attrs_.storage_dltype.size(); ++i) {
+    storage_vtype[i] = tvm::runtime::String2DLDataType(attrs_.storage_dltype[i]);
+  }
 
   // Size and device type of each storage pool entry.
   std::vector<PoolEntry> pool_entry;
@@ -296,9 +1313,12 @@ void GraphRuntime::SetupStorage() {
     } else {
       ICHECK(pool_entry[sid].device_type == -1 || pool_entry[sid].device_type == device_type)
           << "The same pool entry cannot be assigned to multiple devices";
+      ICHECK(pool_entry[sid].device_type == -1 || pool_entry[sid].scope == storage_scope)
+          << "The same pool entry cannot be assigned to multiple storage scopes, "
+          << pool_entry[sid].scope << " != " << storage_scope;
     }
     TVMRetValue lookup_rv;
-    {
+    if (!shared_storage_.count(sid)) {
       std::vector<int64_t> shape_vec{attrs_.shape[i].begin(), attrs_.shape[i].end()};
       DLTensor template_tensor{nullptr,  TVMContext{kDLCPU, 0}, static_cast<int>(shape_vec.size()),
                                vtype[i], shape_vec.data(),      nullptr,
@@ -324,35 +1344,112 @@ void GraphRuntime::SetupStorage() {
       pool_entry[sid].shape[0] = std::max(pool_entry[sid].shape[0], bytes);
       pool_entry[sid].dtype = DLDataType{kDLFloat, 32, 1};
     } else {
-      if (pool_entry[sid].shape.size() == 1) {
-        pool_entry[sid].shape.resize(3, 0);
+      // Pooled textures are allocated with the shape (height, width, channel), and texture
+      // arrays with the shape (depth, height, width, channel)
+      bool is_array = IsTextureArrayStorage(storage_scope);
+      std::vector<int64_t>& pool_shape = pool_entry[sid].shape;
+      if (pool_shape.size() == 1) {
+        pool_shape.resize(is_array ? 4 : 3, 0);
       }
-      size_t axis = runtime::DefaultTextureLayoutSeparator(attrs_.shape[i].size(), storage_scope);
-      auto shape = ApplyTexture2DFlattening<int64_t>(attrs_.shape[i], attrs_.shape[i].size(), axis);
-      pool_entry[sid].shape[0] = std::max(pool_entry[sid].shape[0], shape.height);
-      pool_entry[sid].shape[1] = std::max(pool_entry[sid].shape[1], shape.width);
-      CHECK(pool_entry[sid].shape[2] == 0 || pool_entry[sid].shape[2] == shape.channel)
-        << pool_entry[sid].shape[2] << " != " << shape.channel
+      auto shape = ApplyTextureFlattening<int64_t>(attrs_.shape[i], attrs_.shape[i].size(),
+                                                   storage_scope);
+      size_t first = 0;
+      if (is_array) {
+        CHECK(pool_shape[0] == 0 || pool_shape[0] == shape.depth)
+          << pool_shape[0] << " != " << shape.depth
+          << ", texture array depth must be consistent within a storage pool";
+        pool_shape[0] = shape.depth;
+        first = 1;
+      }
+      pool_shape[first] = std::max(pool_shape[first], shape.height);
+      pool_shape[first + 1] = std::max(pool_shape[first + 1], shape.width);
+      CHECK(pool_shape[first + 2] == 0 || pool_shape[first + 2] == shape.channel)
+        << pool_shape[first + 2] << " != " << shape.channel
         << ",  texture channel length must be consistent within a storage pool";
-      pool_entry[sid].shape[2] = shape.channel;
-      CHECK(pool_entry[sid].dtype.bits == 0 || TypeEqual(pool_entry[sid].dtype, t))
-        << DLDataType2String(pool_entry[sid].dtype) << " != " << DLDataType2String(t)
+      pool_shape[first + 2] = shape.channel;
+      DLDataType texel = storage_vtype[i];
+      CHECK(pool_entry[sid].dtype.bits == 0 || TypeEqual(pool_entry[sid].dtype, texel))
+        << DLDataType2String(pool_entry[sid].dtype) << " != " << DLDataType2String(texel)
         << ", pool entry for 2d texure allocations must be of the same type;"
         << " downstream error from memory planner likely";
-      pool_entry[sid].dtype = t;
+      pool_entry[sid].dtype = texel;
     }
   }
 
-  // Allocate the space.
-  for (const auto& pit : pool_entry) {
-    // This for loop is very fast since there are usually only a couple of
+  auto get_ctx = [this](const PoolEntry& pit) {
+    // This lookup is very fast since there are usually only a couple of
     // devices available on the same hardware.
     const auto& cit = std::find_if(ctxs_.begin(), ctxs_.end(), [&pit](const TVMContext& c) {
       return pit.device_type == static_cast<int>(c.device_type);
     });
-    TVMContext ctx = cit == ctxs_.end() ? ctxs_[0] : *cit;
-    if (pit.linked_param.defined()) {
+    return cit == ctxs_.end() ? ctxs_[0] : *cit;
+  };
+  // Linked parameters are used in place when they are already on the device of their entry,
+  // otherwise they are uploaded into storage allocated as usual, e.g. into pre-shaped textures.
+  auto linked_in_place = [&get_ctx](const PoolEntry& pit) {
+    return pit.linked_param.defined() &&
+           pit.linked_param->ctx.device_type == get_ctx(pit).device_type;
+  };
+
+  // Texture entries on devices which can create images over buffers are carved
+  // out of one buffer arena per device, sized by device_api.<device>.TextureViewSize.
+  std::vector<int64_t> arena_offset(pool_entry.size(), -1);
+  std::unordered_map<int, std::pair<TVMContext, int64_t>> arena_size;
+  // Arenas shared with other runtimes are overwritten by them, they only hold intermediates
+  std::unordered_set<uint32_t> input_sids;
+  if (texture_arenas_ != nullptr) {
+    for (uint32_t nid : input_nodes_) {
+      input_sids.insert(static_cast<uint32_t>(attrs_.storage_id[this->entry_id(nid, 0)]));
+    }
+  }
+  for (size_t sid = 0; sid < pool_entry.size(); ++sid) {
+    const PoolEntry& pit = pool_entry[sid];
+    // Images over buffers are two dimensional, texture arrays are allocated on their own
+    if (linked_in_place(pit) || shared_storage_.count(sid) || !details::Is2DStorage(pit.scope) ||
+        IsTextureArrayStorage(pit.scope) || input_sids.count(sid)) {
+      continue;
+    }
+    TVMContext ctx = get_ctx(pit);
+    std::string fname = std::string("device_api.") + DeviceName(ctx.device_type);
+    const PackedFunc* fsize = Registry::Get(fname + ".TextureViewSize");
+    if (fsize == nullptr) continue;
+    int64_t bytes = (*fsize)(ctx, pit.shape[0], pit.shape[1], pit.shape[2], pit.dtype);
+    if (bytes <= 0) continue;
+    auto& arena = arena_size.emplace(pit.device_type, std::make_pair(ctx, 0)).first->second;
+    arena_offset[sid] = arena.second;
+    arena.second += bytes;
+  }
+  std::unordered_map<int, NDArray> arenas;
+  for (const auto& kv : arena_size) {
+    if (texture_arenas_ != nullptr) {
+      NDArray& shared = (*texture_arenas_)[kv.first];
+      if (!shared.defined() || shared->shape[0] < kv.second.second) {
+        shared = NDArray::Empty({kv.second.second}, DLDataType{kDLUInt, 8, 1}, kv.second.first);
+      }
+      arenas[kv.first] = shared;
+    } else {
+      arenas[kv.first] =
+          NDArray::Empty({kv.second.second}, DLDataType{kDLUInt, 8, 1}, kv.second.first);
+    }
+  }
+
+  // Allocate the space.
+  for (size_t sid = 0; sid < pool_entry.size(); ++sid) {
+    const PoolEntry& pit = pool_entry[sid];
+    TVMContext ctx = get_ctx(pit);
+    auto shared = shared_storage_.find(sid);
+    if (shared != shared_storage_.end()) {
+      storage_pool_.push_back(shared->second);
+    } else if (linked_in_place(pit)) {
       storage_pool_.push_back(pit.linked_param);
+    } else if (arena_offset[sid] >= 0) {
+      const PackedFunc* fview = Registry::Get(std::string("device_api.") +
+                                              DeviceName(ctx.device_type) + ".TextureView");
+      ICHECK(fview != nullptr) << "Device " << DeviceName(ctx.device_type)
+                               << " sizes texture views but cannot create them";
+      NDArray view = (*fview)(arenas[pit.device_type], arena_offset[sid], pit.shape[0],
+                              pit.shape[1], pit.shape[2], pit.dtype, String(pit.scope));
+      storage_pool_.push_back(view);
     } else {
       std::vector<int64_t> shape = pit.shape;
       if (shape.size() == 1) {
@@ -363,6 +1460,41 @@ void GraphRuntime::SetupStorage() {
     }
   }
 
+  // The inputs of a concatenation planned into rows of its output texture view those rows
+  // when the device can create textures over them. Otherwise all the inputs of the
+  // concatenation get textures of their own, and its kernel copies them.
+  std::unordered_map<uint32_t, NDArray> row_views;
+  std::unordered_set<uint32_t> failed_sids;
+  for (size_t i = 0; i < attrs_.texture_row_offset.size(); ++i) {
+    if (attrs_.texture_row_offset[i] < 0) continue;
+    uint32_t sid = static_cast<uint32_t>(attrs_.storage_id[i]);
+    const PoolEntry& pit = pool_entry[sid];
+    TVMContext ctx = get_ctx(pit);
+    const PackedFunc* fslice = Registry::Get(std::string("device_api.") +
+                                             DeviceName(ctx.device_type) + ".TextureViewSlice");
+    auto shape = ApplyTextureFlattening<int64_t>(attrs_.shape[i], attrs_.shape[i].size(),
+                                                 pit.scope);
+    NDArray view;
+    if (arena_offset[sid] >= 0 && fslice != nullptr) {
+      view = (*fslice)(arenas[pit.device_type], arena_offset[sid], attrs_.texture_row_offset[i],
+                       shape.height, pit.shape[1], pit.shape[2], pit.dtype, String(pit.scope));
+    }
+    if (!view.defined()) failed_sids.insert(sid);
+    row_views[i] = view;
+  }
+  for (auto& kv : row_views) {
+    uint32_t sid = static_cast<uint32_t>(attrs_.storage_id[kv.first]);
+    if (failed_sids.count(sid)) {
+      const PoolEntry& pit = pool_entry[sid];
+      auto shape = ApplyTextureFlattening<int64_t>(attrs_.shape[kv.first],
+                                                   attrs_.shape[kv.first].size(), pit.scope);
+      kv.second = NDArray::Empty({shape.height, shape.width, shape.channel}, pit.dtype,
+                                 get_ctx(pit), Optional<String>(String(pit.scope)));
+    } else {
+      texture_row_views_[sid].insert(kv.first);
+    }
+  }
+
   // Assign the pooled entries. A unified memory pool is used to simplifiy
   // memory assignment for each node entry. The allocated memory on each device
   // is mapped to this pool.
@@ -371,16 +1503,33 @@ void GraphRuntime::SetupStorage() {
   for (size_t i = 0; i < data_entry_.size(); ++i) {
     int storage_id = attrs_.storage_id[i];
     ICHECK_LT(static_cast<size_t>(storage_id), storage_pool_.size());
-    data_entry_[i] = storage_pool_[storage_id].CreateView(attrs_.shape[i], vtype[i]);
+    auto row_view = row_views.find(i);
+    NDArray storage =
+        row_view != row_views.end() ? row_view->second : storage_pool_[storage_id];
+    if (!TypeEqual(storage_vtype[i], vtype[i]) && details::Is2DStorage(attrs_.storage_scope[i])) {
+      // The view computes in its own dtype over the texels of the storage type
+      data_entry_[i] = details::ViewArena(storage, 0, attrs_.shape[i], vtype[i]);
+    } else {
+      data_entry_[i] = storage.CreateView(attrs_.shape[i], vtype[i]);
+    }
+    if (pool_entry[storage_id].linked_param.defined()) param_eids_.insert(i);
 
     const DLTensor* tmp = data_entry_[i].operator->();
     data_alignment_[i] = details::GetDataAlignment(*tmp);
   }
+  // Upload the linked parameters of the other devices straight from the library.
+  for (size_t sid = 0; sid < pool_entry.size(); ++sid) {
+    const PoolEntry& pit = pool_entry[sid];
+    if (pit.linked_param.defined() && !linked_in_place(pit)) {
+      data_entry_[pit.param_data_entry].CopyFrom(pit.linked_param);
+    }
+  }
 }
 
 void GraphRuntime::SetupOpExecs() {
   op_execs_.resize(this->GetNumOfNodes());
-  input_dltensors_.resize(num_node_entries());
+  // The arguments of the previous setup are released
+  input_dltensors_.assign(num_node_entries(), {});
   std::unordered_set<uint32_t> input_node_eids;
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     uint32_t nid = input_nodes_[i];
@@ -388,6 +1537,7 @@ void GraphRuntime::SetupOpExecs() {
   }
 
   // setup the array and requirements.
+  std::vector<std::shared_ptr<OpArgs>> node_args(this->GetNumOfNodes());
   for (uint32_t nid = 0; nid < this->GetNumOfNodes(); ++nid) {
     const auto& inode = nodes_[nid];
     if (inode.op_type == "null") continue;
@@ -404,6 +1554,15 @@ void GraphRuntime::SetupOpExecs() {
 
     std::shared_ptr<OpArgs> op_args = nullptr;
     std::tie(op_execs_[nid], op_args) = CreateTVMOp(inode.param, args, inode.inputs.size());
+    // A concatenation whose inputs were all written into the rows of its output has no work
+    auto row_views = texture_row_views_.find(attrs_.storage_id[this->entry_id(nid, 0)]);
+    if (row_views != texture_row_views_.end() && inode.param.num_outputs == 1 &&
+        !inode.inputs.empty() &&
+        std::all_of(inode.inputs.begin(), inode.inputs.end(), [&](const NodeEntry& e) {
+          return row_views->second.count(this->entry_id(e)) != 0;
+        })) {
+      op_execs_[nid] = []() {};
+    }
 
     for (size_t i = 0; i < inode.inputs.size(); i++) {
       uint32_t eid = this->entry_id(inode.inputs[i]);
@@ -412,6 +1571,295 @@ void GraphRuntime::SetupOpExecs() {
         input_dltensors_[eid].push_back(static_cast<DLTensor*>(op_args->arg_values[i].v_handle));
       }
     }
+    node_args[nid] = op_args;
+  }
+  this->SetupDeviceCopies(node_args);
+  this->SetupOpDependencies();
+  this->SetupStreams();
+  this->SetupOutOfOrderWaits();
+}
+
+void GraphRuntime::SetupDeviceCopies(const std::vector<std::shared_ptr<OpArgs>>& node_args) {
+  op_batched_.assign(this->GetNumOfNodes(), {});
+  // TVM_GRAPH_RUNTIME_BATCH_COPIES=1 batches the copies, otherwise each copy runs on the
+  // stream of the caller as it comes
+  const char* batch_copies = getenv("TVM_GRAPH_RUNTIME_BATCH_COPIES");
+  if (batch_copies == nullptr || atoi(batch_copies) == 0) return;
+  // The device side of a copy between the host and a device supporting streams
+  auto crossing = [this, &node_args](uint32_t nid, TVMContext* dev, bool* upload) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type != "tvm_op" || inode.param.func_name != "__copy") return false;
+    const DLTensor* from = static_cast<DLTensor*>(node_args[nid]->arg_values[0].v_handle);
+    const DLTensor* to = static_cast<DLTensor*>(node_args[nid]->arg_values[1].v_handle);
+    if ((from->ctx.device_type == kDLCPU) == (to->ctx.device_type == kDLCPU)) return false;
+    *upload = from->ctx.device_type == kDLCPU;
+    *dev = *upload ? to->ctx : from->ctx;
+    return dev->device_type == kDLGPU || dev->device_type == kDLOpenCL ||
+           dev->device_type == kDLROCM;
+  };
+  uint32_t num_nodes = this->GetNumOfNodes();
+  uint32_t nid = 0;
+  while (nid < num_nodes) {
+    TVMContext dev;
+    bool upload;
+    if (!crossing(nid, &dev, &upload)) {
+      ++nid;
+      continue;
+    }
+    // Crossings following each other in the same direction are batched behind a single
+    // synchronization, issued by the last of them.
+    std::vector<uint32_t> batch{nid};
+    for (++nid; nid < num_nodes; ++nid) {
+      if (nodes_[nid].op_type == "null") continue;
+      TVMContext next_dev;
+      bool next_upload;
+      if (!crossing(nid, &next_dev, &next_upload) || next_upload != upload ||
+          next_dev.device_type != dev.device_type || next_dev.device_id != dev.device_id) {
+        break;
+      }
+      batch.push_back(nid);
+    }
+    std::vector<std::shared_ptr<OpArgs>> copies;
+    for (uint32_t member : batch) {
+      copies.push_back(node_args[member]);
+      op_execs_[member] = nullptr;
+    }
+    op_batched_[batch.back()].assign(batch.begin(), batch.end() - 1);
+
+    // The copies are issued on a copy stream ordered after the work queued so far on the
+    // stream of the calling thread, which is the one set by a worker, the hinted queues or
+    // the streams of the nodes. The host then waits for the copies and their producers
+    // only, not for kernels queued concurrently by other workers.
+    TVMStreamHandle stream = this->GetCopyStream(dev);
+    PackedFunc get_stream;
+    std::string get_stream_name = std::string("device_api.") + DeviceName(dev.device_type);
+    if (const PackedFunc* f = Registry::Get(get_stream_name + ".GetStream")) get_stream = *f;
+    op_execs_[batch.back()] = [copies, dev, stream, upload, get_stream]() {
+      DeviceAPI* device = DeviceAPI::Get(dev);
+      TVMStreamHandle current = nullptr;
+      if (get_stream != nullptr) current = get_stream();
+      device->SyncStreamFromTo(dev, current, stream);
+      for (const auto& args : copies) {
+        DLTensor* from = static_cast<DLTensor*>(args->arg_values[0].v_handle);
+        DLTensor* to = static_cast<DLTensor*>(args->arg_values[1].v_handle);
+        TVM_CCALL(TVMArrayCopyFromTo(from, to, stream));
+      }
+      if (upload) device->SyncStreamFromTo(dev, stream, current);
+      // The host storage may be reused as soon as the copy returns
+      device->StreamSync(dev, stream);
+    };
+  }
+}
+
+TVMStreamHandle GraphRuntime::GetCopyStream(TVMContext ctx) {
+  for (const auto& entry : copy_streams_) {
+    if (entry.first.device_type == ctx.device_type && entry.first.device_id == ctx.device_id) {
+      return entry.second;
+    }
+  }
+  TVMStreamHandle stream = DeviceAPI::Get(ctx)->CreateStream(ctx);
+  copy_streams_.emplace_back(ctx, stream);
+  return stream;
+}
+
+void GraphRuntime::InitPipeline(int depth) {
+  ICHECK_GE(depth, 1) << "The pipeline needs at least one slot";
+  this->ReleasePipeline();
+  std::vector<uint32_t> input_eids, output_eids;
+  for (uint32_t nid : input_nodes_) input_eids.push_back(entry_id(nid, 0));
+  for (const auto& e : outputs_) output_eids.push_back(entry_id(e));
+  ICHECK(!input_eids.empty() || !output_eids.empty());
+  pipeline_ctx_ = data_entry_[input_eids.empty() ? output_eids[0] : input_eids[0]]->ctx;
+  auto check_entry = [this](uint32_t eid) {
+    const DLTensor* t = data_entry_[eid].operator->();
+    ICHECK(t->ctx.device_type == pipeline_ctx_.device_type &&
+           t->ctx.device_id == pipeline_ctx_.device_id)
+        << "The inputs and outputs of a pipelined graph must be on one device";
+    ICHECK(attrs_.storage_scope.empty() || !details::Is2DStorage(attrs_.storage_scope[eid]))
+        << "The inputs and outputs of a pipelined graph must be in flat memory";
+    return std::vector<int64_t>(t->shape, t->shape + t->ndim);
+  };
+  TVMContext cpu_ctx{kDLCPU, 0};
+  bool has_streams = pipeline_ctx_.device_type != kDLCPU;
+  DeviceAPI* device = DeviceAPI::Get(pipeline_ctx_);
+  pipeline_.resize(depth);
+  for (auto& slot : pipeline_) {
+    for (uint32_t eid : input_eids) {
+      DLDataType dtype = data_entry_[eid]->dtype;
+      slot.host_inputs.push_back(NDArray::Empty(check_entry(eid), dtype, cpu_ctx));
+      slot.device_inputs.push_back(NDArray::Empty(check_entry(eid), dtype, pipeline_ctx_));
+    }
+    for (uint32_t eid : output_eids) {
+      DLDataType dtype = data_entry_[eid]->dtype;
+      slot.device_outputs.push_back(NDArray::Empty(check_entry(eid), dtype, pipeline_ctx_));
+      slot.host_outputs.push_back(NDArray::Empty(check_entry(eid), dtype, cpu_ctx));
+    }
+    if (has_streams) {
+      slot.upload = device->CreateStream(pipeline_ctx_);
+      slot.download = device->CreateStream(pipeline_ctx_);
+    }
+  }
+}
+
+void GraphRuntime::ReleasePipeline() {
+  for (auto& slot : pipeline_) {
+    if (slot.pending) this->Wait(slot.frame);
+  }
+  for (auto& slot : pipeline_) {
+    DeviceAPI* device = DeviceAPI::Get(pipeline_ctx_);
+    if (slot.upload != nullptr) device->FreeStream(pipeline_ctx_, slot.upload);
+    if (slot.download != nullptr) device->FreeStream(pipeline_ctx_, slot.download);
+  }
+  pipeline_.clear();
+}
+
+int64_t GraphRuntime::RunAsync(const std::vector<DLTensor*>& inputs) {
+  ICHECK(!pipeline_.empty()) << "init_pipeline must be called before run_async";
+  ICHECK_EQ(inputs.size(), input_nodes_.size());
+  int64_t frame = next_frame_++;
+  PipelineSlot& slot = pipeline_[frame % pipeline_.size()];
+  // The ring is full, retire the frame which used the slot before
+  if (slot.pending) this->Wait(slot.frame);
+  slot.frame = frame;
+
+  DeviceAPI* device = DeviceAPI::Get(pipeline_ctx_);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    slot.host_inputs[i].CopyFrom(inputs[i]);
+    NDArray::CopyFromTo(slot.host_inputs[i].operator->(),
+                        const_cast<DLTensor*>(slot.device_inputs[i].operator->()), slot.upload);
+  }
+  // The compute of this frame waits for its upload only, not for other transfers
+  if (slot.upload != nullptr) device->SyncStreamFromTo(pipeline_ctx_, slot.upload, nullptr);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    uint32_t eid = entry_id(input_nodes_[i], 0);
+    NDArray::CopyFromTo(slot.device_inputs[i].operator->(),
+                        const_cast<DLTensor*>(data_entry_[eid].operator->()), nullptr);
+  }
+  this->Run();
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    uint32_t eid = entry_id(outputs_[i]);
+    NDArray::CopyFromTo(data_entry_[eid].operator->(),
+                        const_cast<DLTensor*>(slot.device_outputs[i].operator->()), nullptr);
+  }
+  if (slot.download != nullptr) device->SyncStreamFromTo(pipeline_ctx_, nullptr, slot.download);
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    NDArray::CopyFromTo(slot.device_outputs[i].operator->(),
+                        const_cast<DLTensor*>(slot.host_outputs[i].operator->()), slot.download);
+  }
+  slot.pending = slot.download != nullptr;
+  return frame;
+}
+
+void GraphRuntime::Wait(int64_t frame) {
+  ICHECK(!pipeline_.empty()) << "init_pipeline must be called before wait";
+  ICHECK(frame >= 0 && frame < next_frame_) << "Frame " << frame << " was not submitted";
+  PipelineSlot& slot = pipeline_[frame % pipeline_.size()];
+  ICHECK_EQ(slot.frame, frame) << "The slot of frame " << frame << " has been reused";
+  if (!slot.pending) return;
+  DeviceAPI::Get(pipeline_ctx_)->StreamSync(pipeline_ctx_, slot.download);
+  slot.pending = false;
+}
+
+NDArray GraphRuntime::GetPipelineOutput(int64_t frame, int index) {
+  ICHECK_LT(static_cast<size_t>(index), outputs_.size());
+  this->Wait(frame);
+  return pipeline_[frame % pipeline_.size()].host_outputs[index];
+}
+
+void GraphRuntime::SetupOpDependencies() {
+  uint32_t num_nodes = this->GetNumOfNodes();
+  op_succs_.assign(num_nodes, {});
+  op_num_deps_.assign(num_nodes, 0);
+  std::vector<std::unordered_set<uint32_t>> deps(num_nodes);
+  auto add_dep = [&](uint32_t from, uint32_t to) {
+    if (from != to && deps[to].insert(from).second) op_succs_[from].push_back(to);
+  };
+  // Storage is shared between entries by the memory planner assuming the serial order
+  std::unordered_map<int, uint32_t> last_writer;
+  std::unordered_map<int, std::vector<uint32_t>> readers;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (!op_execs_[nid]) continue;
+    // A batch of copies reads and writes the entries of all the nodes it stands for
+    std::vector<uint32_t> covered = op_batched_[nid];
+    covered.push_back(nid);
+    for (uint32_t member : covered) {
+      for (const auto& e : nodes_[member].inputs) {
+        int sid = attrs_.storage_id[this->entry_id(e)];
+        auto it = last_writer.find(sid);
+        if (it != last_writer.end()) add_dep(it->second, nid);
+        readers[sid].push_back(nid);
+      }
+    }
+    for (uint32_t member : covered) {
+      for (uint32_t index = 0; index < nodes_[member].param.num_outputs; ++index) {
+        int sid = attrs_.storage_id[this->entry_id(member, index)];
+        auto it = last_writer.find(sid);
+        if (it != last_writer.end()) add_dep(it->second, nid);
+        for (uint32_t reader : readers[sid]) add_dep(reader, nid);
+        readers[sid].clear();
+        last_writer[sid] = nid;
+      }
+    }
+    op_num_deps_[nid] = static_cast<uint32_t>(deps[nid].size());
+  }
+}
+
+void GraphRuntime::SetupStreams() {
+  op_streams_.clear();
+  op_stream_waits_.clear();
+  const char* val = getenv("TVM_GRAPH_RUNTIME_NUM_STREAMS");
+  int num_streams = val == nullptr ? 0 : atoi(val);
+  if (num_streams <= 1) return;
+  auto gpu = std::find_if(ctxs_.begin(), ctxs_.end(),
+                          [](const TVMContext& ctx) { return ctx.device_type == kDLGPU; });
+  if (gpu == ctxs_.end()) return;
+  this->CheckRunMode("GPU streams");
+  if (streams_.empty()) {
+    stream_ctx_ = *gpu;
+    for (int i = 0; i < num_streams; ++i) {
+      streams_.push_back(DeviceAPI::Get(stream_ctx_)->CreateStream(stream_ctx_));
+    }
+  }
+  uint32_t num_nodes = this->GetNumOfNodes();
+  std::vector<std::vector<uint32_t>> op_preds(num_nodes);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (uint32_t succ : op_succs_[nid]) op_preds[succ].push_back(nid);
+  }
+  // A node continues the stream of its first producer which was not continued yet, so that
+  // chains stay on one stream and the independent branches spread over the others. The nodes
+  // off the device, and the copies which order themselves, stay on the default stream, which
+  // the streams synchronize with.
+  op_streams_.assign(num_nodes, nullptr);
+  op_stream_waits_.assign(num_nodes, {});
+  std::vector<bool> continued(num_nodes, false);
+  size_t next_stream = 0;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (!op_execs_[nid]) continue;
+    const auto& inode = nodes_[nid];
+    TVMContext ctx = data_entry_[this->entry_id(nid, 0)]->ctx;
+    if (inode.param.func_name == "__copy" || ctx.device_type != stream_ctx_.device_type ||
+        ctx.device_id != stream_ctx_.device_id) {
+      continue;
+    }
+    TVMStreamHandle stream = nullptr;
+    for (uint32_t pred : op_preds[nid]) {
+      if (op_streams_[pred] != nullptr && !continued[pred]) {
+        stream = op_streams_[pred];
+        continued[pred] = true;
+        break;
+      }
+    }
+    if (stream == nullptr) stream = streams_[next_stream++ % streams_.size()];
+    op_streams_[nid] = stream;
+    // Wait for the producers, and the readers of the storage overwritten, on other streams
+    auto& waits = op_stream_waits_[nid];
+    for (uint32_t pred : op_preds[nid]) {
+      TVMStreamHandle producer = op_streams_[pred];
+      if (producer != nullptr && producer != stream &&
+          std::find(waits.begin(), waits.end(), producer) == waits.end()) {
+        waits.push_back(producer);
+      }
+    }
   }
 }
 
@@ -440,6 +1888,22 @@ std::pair<std::function<void()>, std::shared_ptr<GraphRuntime::OpArgs> > GraphRu
   if (param.func_name == "__nop") {
     return {[]() {}, arg_ptr};
   } else if (param.func_name == "__copy") {
+    const DLTensor& from = arg_ptr->args[0];
+    const DLTensor& to = arg_ptr->args[1];
+    if (from.ctx.device_type != to.ctx.device_type && from.ctx.device_type != kDLCPU &&
+        to.ctx.device_type != kDLCPU) {
+      // Two different accelerators, e.g. Hexagon and OpenCL, copy through a host buffer.
+      NDArray staging = NDArray::Empty(std::vector<int64_t>(from.shape, from.shape + from.ndim),
+                                       from.dtype, TVMContext{kDLCPU, 0});
+      auto fexec = [arg_ptr, staging]() {
+        DLTensor* from = static_cast<DLTensor*>(arg_ptr->arg_values[0].v_handle);
+        DLTensor* to = static_cast<DLTensor*>(arg_ptr->arg_values[1].v_handle);
+        DLTensor* host = const_cast<DLTensor*>(staging.operator->());
+        TVM_CCALL(TVMArrayCopyFromTo(from, host, nullptr));
+        TVM_CCALL(TVMArrayCopyFromTo(host, to, nullptr));
+      };
+      return {fexec, arg_ptr};
+    }
     // Perform cross device data copy.
     // Directly copy data from the input to the output.
     auto fexec = [arg_ptr]() {
@@ -455,6 +1919,32 @@ std::pair<std::function<void()>, std::shared_ptr<GraphRuntime::OpArgs> > GraphRu
   tvm::runtime::PackedFunc pf = module_.GetFunction(param.func_name, true);
   ICHECK(pf != nullptr) << "no such function in module: " << param.func_name;
 
+  // The arguments of the op only change through SetInputZeroCopy, which checks them against
+  // the graph. When the module has an entry without the argument checks, the first call goes
+  // through the checked function to validate the arguments and the next ones call the raw
+  // unchecked entry directly.
+  TVMBackendPackedCFunc unchecked =
+      GetLibraryPackedCFunc(module_, param.func_name + symbol::tvm_unchecked_entry_suffix);
+  if (unchecked != nullptr) {
+    auto fexec = [arg_ptr, pf, unchecked, validated = false]() mutable {
+      if (!validated) {
+        TVMRetValue rv;
+        TVMArgs targs(arg_ptr->arg_values.data(), arg_ptr->arg_tcodes.data(),
+                      static_cast<int>(arg_ptr->arg_values.size()));
+        pf.CallPacked(targs, &rv);
+        validated = true;
+        return;
+      }
+      TVMValue ret_value;
+      int ret_type_code = kTVMNullptr;
+      int ret = (*unchecked)(arg_ptr->arg_values.data(), arg_ptr->arg_tcodes.data(),
+                             static_cast<int>(arg_ptr->arg_values.size()), &ret_value,
+                             &ret_type_code, nullptr);
+      ICHECK_EQ(ret, 0) << TVMGetLastError();
+    };
+    return {fexec, arg_ptr};
+  }
+
   auto fexec = [arg_ptr, pf]() {
     TVMRetValue rv;
     TVMArgs targs(arg_ptr->arg_values.data(), arg_ptr->arg_tcodes.data(),
@@ -464,26 +1954,39 @@ std::pair<std::function<void()>, std::shared_ptr<GraphRuntime::OpArgs> > GraphRu
   return {fexec, arg_ptr};
 }
 
+/*!
+ * \brief The input index of a name or an index argument, the names are looked up in place.
+ * \param runtime The graph runtime.
+ * \param arg The argument.
+ * \return The index of input, -1 for an unknown name.
+ */
+static int ArgInputIndex(GraphRuntime* runtime, const TVMArgValue& arg) {
+  if (arg.type_code() == kTVMStr) {
+    return runtime->GetInputIndex(arg.value().v_str);
+  } else if (String::CanConvertFrom(arg)) {
+    return runtime->GetInputIndex(arg.operator String().c_str());
+  }
+  return arg;
+}
+
 PackedFunc GraphRuntime::GetFunction(const std::string& name,
                                      const ObjectPtr<Object>& sptr_to_self) {
   // Return member functions during query.
   if (name == "set_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
-      if (String::CanConvertFrom(args[0])) {
-        int in_idx = this->GetInputIndex(args[0].operator String());
-        if (in_idx >= 0) this->SetInput(in_idx, args[1]);
-      } else {
-        this->SetInput(args[0], args[1]);
-      }
+      int in_idx = ArgInputIndex(this, args[0]);
+      if (in_idx >= 0) this->SetInput(in_idx, args[1]);
+    });
+  } else if (name == "set_input_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      TVMStreamHandle stream = args[2];
+      int in_idx = ArgInputIndex(this, args[0]);
+      if (in_idx >= 0) this->SetInputAsync(in_idx, args[1], stream);
     });
   } else if (name == "set_input_zero_copy") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
-      if (String::CanConvertFrom(args[0])) {
-        int in_idx = this->GetInputIndex(args[0].operator String());
-        if (in_idx >= 0) this->SetInputZeroCopy(in_idx, args[1]);
-      } else {
-        this->SetInputZeroCopy(args[0], args[1]);
-      }
+      int in_idx = ArgInputIndex(this, args[0]);
+      if (in_idx >= 0) this->SetInputZeroCopy(in_idx, args[1]);
     });
   } else if (name == "get_output") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
@@ -495,13 +1998,13 @@ PackedFunc GraphRuntime::GetFunction(const std::string& name,
     });
   } else if (name == "get_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
-      int in_idx = 0;
-      if (String::CanConvertFrom(args[0])) {
-        in_idx = this->GetInputIndex(args[0].operator String());
-      } else {
-        in_idx = args[0];
-      }
+      int in_idx = ArgInputIndex(this, args[0]);
       if (in_idx >= 0) {
+        uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+        // A parameter is read once uploaded, and the caller may write through the array, so
+        // a shared parameter is copied first
+        if (param_eids_.count(eid)) this->WaitForParamUpload();
+        this->DetachSharedParam(eid, true);
         *rv = this->GetInput(in_idx);
       }
     });
@@ -513,10 +2016,69 @@ PackedFunc GraphRuntime::GetFunction(const std::string& name,
         [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumInputs(); });
   } else if (name == "run") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Run(); });
+  } else if (name == "set_op_sampling") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->SetOpSampling(args[0]); });
+  } else if (name == "get_op_samples") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetOpSamples(); });
+  } else if (name == "set_queue_hints") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string throttle = args.num_args > 1 ? args[1].operator std::string() : "";
+      this->SetQueueHints(args[0], throttle);
+    });
+  } else if (name == "set_perf_hint") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->SetPerfHint(args[0]); });
+  } else if (name == "set_out_of_order") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->SetOutOfOrder(args[0]); });
+  } else if (name == "set_thread_pool") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->thread_pool_ = args[0].operator ObjectRef();
+    });
   } else if (name == "load_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       this->LoadParams(args[0].operator std::string());
     });
+  } else if (name == "load_params_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->LoadParamsAsync(args[0].operator std::string());
+    });
+  } else if (name == "load_params_mapped") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->LoadParamsMapped(args[0].operator std::string());
+    });
+  } else if (name == "set_param_source") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetParamSource(args[0], args[1].operator Array<String>());
+    });
+  } else if (name == "set_memory_budget") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = this->SetMemoryBudget(args[0]);
+    });
+  } else if (name == "create_worker") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = Module(this->CreateWorker());
+    });
+  } else if (name == "init_pipeline") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->InitPipeline(args[0]); });
+  } else if (name == "run_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::vector<DLTensor*> inputs;
+      for (int i = 0; i < args.num_args; ++i) {
+        inputs.push_back(args[i]);
+      }
+      *rv = this->RunAsync(inputs);
+    });
+  } else if (name == "wait") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Wait(args[0]); });
+  } else if (name == "get_pipeline_output") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = this->GetPipelineOutput(args[0], args[1]);
+    });
   } else if (name == "share_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       const auto& module = args[0].operator Module();
@@ -28,15 +28,27 @@
 #include <dlpack/dlpack.h>
 #include <dmlc/json.h>
 #include <dmlc/memory_io.h>
+#include <tvm/runtime/container.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "op_sampler.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -53,6 +65,10 @@ struct TVMOpParam {
   uint32_t num_inputs;
   uint32_t num_outputs;
   uint32_t flatten_data;
+  /*! \brief The static estimate of the float operations of the op, -1 when unknown. */
+  double flop_ct{-1};
+  /*! \brief The static estimate of the bytes the op reads and writes, -1 when unknown. */
+  double bytes{-1};
 };
 
 /*!
@@ -82,8 +98,83 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \return The type key of the executor.
    */
   const char* type_key() const final { return "GraphRuntime"; }
+  /*!
+   * \brief Execute the graph.
+   *
+   *  With TVM_GRAPH_RUNTIME_NUM_THREADS set above 1 the nodes run on that many
+   *  worker threads as soon as the nodes producing their inputs, and the nodes
+   *  which used their planned storage before, have been run. Device kernels are
+   *  still ordered by the device queue, so this overlaps the host side of
+   *  independent branches, e.g. CPU fallback ops with GPU work.
+   *
+   *  With TVM_GRAPH_RUNTIME_NUM_THREADS=auto the number of workers is the width of
+   *  the graph, within the number of cores. The CPU kernels of a node launch on a
+   *  pool of the worker's share of the cores, or on all the cores when no other
+   *  node is running or ready.
+   *
+   *  The worker threads, the bounded memory, the GPU streams, the queue hints and the
+   *  out-of-order queue are run modes of their own, setting a second one fails.
+   */
   void Run();
 
+  /*!
+   * \brief Time the ops of one in every sample_every runs with device timers and keep
+   *  their histograms, see OpSampler. Not to be called while the graph runs.
+   *
+   *  Only the runs on the caller are sampled, not the concurrent runs or the runs with
+   *  bounded memory. A sampled run issues the ops in order on the default streams and
+   *  queues. TVM_GRAPH_RUNTIME_OP_SAMPLING sets the period at Init.
+   * \param sample_every The sampling period, 0 to stop sampling.
+   */
+  void SetOpSampling(int sample_every);
+  /*!
+   * \brief Get the op histograms as JSON, may be called while the graph runs.
+   * \return The report, empty when the ops are not sampled.
+   */
+  std::string GetOpSamples() const;
+  /*!
+   * \brief Run the kernels of the graph on the OpenCL devices on queues created with the
+   *  scheduling hints of cl_khr_priority_hints and cl_khr_throttle_hints, so that a latency
+   *  critical model is scheduled ahead of the background models sharing the GPU. Not to be
+   *  called while the graph runs.
+   *
+   *  The hints are a run mode, see Run. The sampled runs, see SetOpSampling, stay on the
+   *  default queues which the device timers read.
+   * \param priority The queue priority, "high", "medium", "low" or "" for none.
+   * \param throttle The queue power throttling, "high", "medium", "low" or "" for none.
+   *  With neither hint the graph runs on the default queues again.
+   */
+  void SetQueueHints(const std::string& priority, const std::string& throttle);
+  /*!
+   * \brief Set the performance level of the GPU clocks of the OpenCL context for the runs of
+   *  the graph, with cl_qcom_perf_hint. The level is context wide, every run of the graph sets
+   *  it again, so the graphs sharing the GPU each run at their own level.
+   * \param hint The performance level, "high", "medium", "low" or "" to leave it as is.
+   */
+  void SetPerfHint(const std::string& hint);
+  /*!
+   * \brief Run the kernels of the graph on an out-of-order queue of its OpenCL device, so that
+   *  the kernels of independent branches run concurrently. Every kernel waits for the events
+   *  of the nodes it depends on, see SetupOutOfOrderWaits. Not to be called while the graph
+   *  runs.
+   *
+   *  The copies stay on the default queue, ordered between two barriers of the out-of-order
+   *  one. The workspaces freed by the kernels are only reused after the run. As the queue
+   *  hints, it is a run mode of its own, and TVM_GRAPH_RUNTIME_OUT_OF_ORDER=1 enables it at
+   *  Init.
+   * \param enable Whether to run out of order, the graph runs in order when the device does
+   *  not support out-of-order queues.
+   */
+  void SetOutOfOrder(bool enable);
+
+  ~GraphRuntime();
+
+  /*!
+   * \brief The source of the parameters shared in place between runtimes, it returns the
+   *  array of a parameter name readable by a context, or an undefined array to not share it.
+   */
+  using SharedParamFunc = std::function<NDArray(const std::string& name, TVMContext ctx)>;
+
   /*!
    * \brief Initialize the graph executor with graph and context.
    * \param graph_json The execution graph.
@@ -94,10 +185,43 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \param lookup_linked_param_func If given, a PackedFunc invoked to lookup linked parameters
    *  by storage_id. If not given, linked parameters are looked-up using an internal implementation,
    *  which is not compatible with RPCModules.
+   * \param shared_params If given, the source of the flat parameters used in place as their
+   *  storage. They are copied on write, the first write to one of them allocates storage of
+   *  this runtime for it.
    */
 
   void Init(const std::string& graph_json, tvm::runtime::Module module,
-            const std::vector<TVMContext>& ctxs, const PackedFunc lookup_linked_param_func);
+            const std::vector<TVMContext>& ctxs, const PackedFunc lookup_linked_param_func,
+            const SharedParamFunc& shared_params = nullptr);
+
+  /*!
+   * \brief Whether an input still uses a parameter shared at Init in place.
+   * \param index The input index.
+   * \return Whether the input is shared.
+   */
+  bool IsSharedInput(int index) const;
+
+  /*!
+   * \brief Set the hook called when this runtime stops using some parameters shared at Init,
+   *  i.e. when it writes its own copy of one or is destroyed.
+   * \param release The hook, it may be called from any thread.
+   */
+  void SetSharedParamRelease(std::function<void()> release) {
+    shared_param_release_ = std::move(release);
+  }
+
+  /*!
+   * \brief Carve the intermediate textures out of arenas shared with other runtimes which
+   *  never run at the same time, e.g. the shape buckets of one model. Called before Init.
+   *
+   *  An arena smaller than the textures of this runtime is replaced by a larger one, so the
+   *  runtime with the largest textures is initialized first. The inputs and parameters keep
+   *  storage of their own.
+   * \param arenas The arenas by device type.
+   */
+  void ShareTextureArenas(std::shared_ptr<std::unordered_map<int, NDArray>> arenas) {
+    texture_arenas_ = std::move(arenas);
+  }
 
   /*!
    * \brief Get the input index given the name of input.
@@ -105,6 +229,12 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \return The index of input.
    */
   int GetInputIndex(const std::string& name);
+  /*!
+   * \brief Get the input index given the name of input, without building a string.
+   * \param name The name of the input.
+   * \return The index of input.
+   */
+  int GetInputIndex(const char* name);
 
   /*!
    * \brief set index-th input to the graph.
@@ -112,6 +242,18 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \param data_in The input data.
    */
   void SetInput(int index, DLTensor* data_in);
+  /*!
+   * \brief set index-th input to the graph asynchronously on a device stream.
+   *
+   *  The copy is ordered after the work already enqueued on the default stream and
+   *  the next Run is ordered after the copy on the device, so the host does not block
+   *  and can prepare the following input while the device executes.
+   *  data_in must remain valid until the copy completes.
+   * \param index The input index.
+   * \param data_in The input data.
+   * \param stream The stream to enqueue the copy to.
+   */
+  void SetInputAsync(int index, DLTensor* data_in, TVMStreamHandle stream);
   /*!
    * \brief set index-th input to the graph without copying the data
    * \param index The input index.
@@ -160,14 +302,99 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \param param_blob A binary blob of parameter.
    */
   void LoadParams(const std::string& param_blob);
+  /*!
+   * \brief Load parameters from parameter blob in the background.
+   *
+   *  The parameters are uploaded in the order of the nodes reading them, and runs wait
+   *  for the parameters of each node right before executing it, so the first run
+   *  overlaps with the upload instead of following it. Reading or writing a parameter waits
+   *  for the whole upload. A failed upload fails the runs and these accesses until the
+   *  parameters are loaded again.
+   * \param param_blob A binary blob of parameter.
+   */
+  void LoadParamsAsync(std::string param_blob);
+  /*!
+   * \brief Stream parameters from a source while running, instead of keeping them resident.
+   *
+   *  Each parameter is fetched right before the first node reading it, into a host arena
+   *  where the parameters living at the same time do not overlap, so the arena holds only
+   *  a few layers at once. The parameters are fetched again on every run.
+   * \param fetch The source, a function returning the NDArray of a parameter name, e.g.
+   *  unsealing it from the storage of an enclave.
+   * \param names The names of the streamed parameters.
+   */
+  void SetParamSource(PackedFunc fetch, const Array<String>& names);
+  /*!
+   * \brief Pack the host storage of the intermediates into one arena of at most max_bytes.
+   *
+   *  The storage planned for intermediates not used at the same time shares the bytes of the
+   *  arena, and the nodes then run in order on the caller.
+   * \param max_bytes The largest size of the arena, the call fails if it does not fit.
+   * \return The size of the arena.
+   */
+  int64_t SetMemoryBudget(int64_t max_bytes);
 
   /*!
    * \brief Share parameters from pre-existing GraphRuntime instance.
+   *
+   *  The instances may run on different devices of the OpenCL context, which all
+   *  access its buffers, so that the parameters are uploaded once for all of them.
    * \param other A GraphRuntime instance, previously with |LoadParams| called with the
    * identical input |param_blob|.
    * \param strm The input stream.
    */
   void ShareParams(const GraphRuntime& other, dmlc::Stream* strm);
+  /*!
+   * \brief Load parameters from a file mapped into memory.
+   *
+   *  Parameters of the host which are aligned in the file are used in place,
+   *  without their own storage, other parameters are copied as by LoadParams.
+   * \param path The path of the parameter file.
+   */
+  void LoadParamsMapped(const std::string& path);
+  /*!
+   * \brief Create a runtime executing the same graph with the parameters of this one.
+   *
+   *  The worker shares the parameters, which must not be changed while it runs, and
+   *  only allocates the storage of the activations planned for the graph, so N
+   *  workers serving requests from N threads do not hold N copies of the weights.
+   *  A parameter later set on this runtime is seen by its workers, one set on a worker
+   *  is copied on write and only seen by that worker.
+   * \return The worker.
+   */
+  ObjectPtr<GraphRuntime> CreateWorker();
+
+  /*!
+   * \brief Set up pipelined execution of consecutive frames.
+   *
+   *  Each of the depth slots holds its own copy of the graph inputs and outputs,
+   *  on the device and on the host, and an upload and a download stream. The
+   *  upload of a frame and the download of the previous one then overlap with
+   *  the compute in between, which stays on the default stream. The inputs and
+   *  outputs must live in flat memory of a single device.
+   * \param depth The number of frames which can be in flight, e.g. 2 or 3.
+   */
+  void InitPipeline(int depth);
+  /*!
+   * \brief Submit a frame to the pipeline without waiting for its results.
+   *
+   *  The inputs are staged on the host before this returns, so they can be reused
+   *  right away. When all slots are in flight the oldest frame is waited for first.
+   * \param inputs The inputs of the graph, in the order of the input nodes.
+   * \return The id of the frame.
+   */
+  int64_t RunAsync(const std::vector<DLTensor*>& inputs);
+  /*!
+   * \brief Wait until the outputs of a frame are on the host.
+   * \param frame The id of the frame, its slot must not have been reused yet.
+   */
+  void Wait(int64_t frame);
+  /*!
+   * \brief Get a host output of a frame, valid until its slot is reused.
+   * \param frame The id of the frame, which is waited for.
+   * \param index The output index.
+   */
+  NDArray GetPipelineOutput(int64_t frame, int index);
 
   /*!
    * \brief Get total number of nodes.
@@ -241,6 +468,10 @@ class TVM_DLL GraphRuntime : public ModuleNode {
         } else if (key == "flatten_data") {
           param->flatten_data = strtoul(value.c_str(), nullptr, 10);
           bitmask |= 8;
+        } else if (key == "flop_ct") {
+          param->flop_ct = strtod(value.c_str(), nullptr);
+        } else if (key == "bytes") {
+          param->bytes = strtod(value.c_str(), nullptr);
         }
       }
       ICHECK_EQ(bitmask, 1 | 2 | 4 | 8) << "invalid format";
@@ -278,6 +509,10 @@ class TVM_DLL GraphRuntime : public ModuleNode {
     std::vector<std::string> dltype;
     std::vector<std::string> storage_scope;
     std::vector<std::vector<int64_t>> shape;
+    // The first row of the entries written into the texture of a concatenation, -1 otherwise
+    std::vector<int64_t> texture_row_offset;
+    // The data type of the texels of texture entries, when it differs from the compute dtype
+    std::vector<std::string> storage_dltype;
     // The graph attribute fields.
     void Load(dmlc::JSONReader* reader) {
       reader->BeginObject();
@@ -328,6 +563,22 @@ class TVM_DLL GraphRuntime : public ModuleNode {
           ICHECK(reader->NextArrayItem());
           reader->Read(&device_index);
           ICHECK(!reader->NextArrayItem());
+        } else if (key == "texture_row_offset") {
+          reader->BeginArray();
+          ICHECK(reader->NextArrayItem());
+          reader->Read(&type);
+          ICHECK_EQ(type, "list_int");
+          ICHECK(reader->NextArrayItem());
+          reader->Read(&texture_row_offset);
+          ICHECK(!reader->NextArrayItem());
+        } else if (key == "storage_dltype") {
+          reader->BeginArray();
+          ICHECK(reader->NextArrayItem());
+          reader->Read(&type);
+          ICHECK_EQ(type, "list_str");
+          ICHECK(reader->NextArrayItem());
+          reader->Read(&storage_dltype);
+          ICHECK(!reader->NextArrayItem());
         } else {
           reader->BeginArray();
           ICHECK(reader->NextArrayItem());
@@ -382,10 +633,115 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   void DefaultLookupLinkedParam(TVMArgs args, TVMRetValue* rv);
   /*! \brief Delete NDArray::Container with linked (i.e. static) data. */
   static void LinkedNDArrayDeleter(Object* container);
+  /*! \brief Delete NDArray::Container viewing the array held by its manager_ctx. */
+  static void DeviceViewDeleter(Object* container);
+  /*!
+   * \brief View an array on another device of the same OpenCL context.
+   * \param arr The array.
+   * \param ctx The device of the view.
+   * \return The view, which keeps the array alive.
+   */
+  static NDArray ViewOnDevice(const NDArray& arr, TVMContext ctx);
+  /*!
+   * \brief Use the shared parameters as the storage of their entries, before SetupStorage.
+   * \param shared_params The source of the shared parameters.
+   */
+  void BindSharedParams(const SharedParamFunc& shared_params);
+  /*!
+   * \brief Give a shared parameter storage of its own before it is written. The workers of
+   *  this runtime switch to the new storage too.
+   * \param eid The entry id of the parameter, nothing is done when it is not shared.
+   * \param copy_content Whether to copy the content, false when the whole parameter is
+   *  about to be overwritten.
+   */
+  void DetachSharedParam(uint32_t eid, bool copy_content = false);
+  /*!
+   * \brief Replace the storage of a parameter this worker shares with its parent runtime.
+   * \param eid The entry id of the parameter.
+   * \param prev The storage the parameter used, nothing is done when it is no longer shared.
+   * \param array The new storage.
+   */
+  void RebindParam(uint32_t eid, const NDArray& prev, const NDArray& array);
   /*! \brief Setup the temporal storage */
   void SetupStorage();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  /*!
+   * \brief Setup the order the executors must respect when run concurrently: the
+   *  producer of each input comes first, and a node overwriting a planned storage
+   *  comes after the nodes which used its previous content.
+   */
+  void SetupOpDependencies();
+  /*!
+   * \brief Issue the copies between the host and a device on a copy stream, batching
+   *  the copies which follow each other in the same direction, when
+   *  TVM_GRAPH_RUNTIME_BATCH_COPIES is set.
+   * \param node_args The arguments of the executor of each node.
+   */
+  void SetupDeviceCopies(const std::vector<std::shared_ptr<OpArgs>>& node_args);
+  /*!
+   * \brief Get the stream of a device for the copies to and from the host.
+   * \param ctx The device.
+   * \return The stream.
+   */
+  TVMStreamHandle GetCopyStream(TVMContext ctx);
+  /*!
+   * \brief Spread the nodes on the GPU over TVM_GRAPH_RUNTIME_NUM_STREAMS streams, so that
+   *  independent branches run concurrently, and record the streams each node waits for.
+   */
+  void SetupStreams();
+  /*! \brief Start the worker threads running the executors, if requested. */
+  void StartWorkers();
+  /*!
+   * \brief Wait until the parameters read by a node are uploaded.
+   * \param nid The node.
+   */
+  void WaitForParams(uint32_t nid);
+  /*! \brief Wait until the upload started by LoadParamsAsync is done. */
+  void WaitForParamUpload();
+  /*! \brief Wait for the upload started by LoadParamsAsync and drop its error, before a load. */
+  void StartParamLoad();
+  /*!
+   * \brief Get the run mode set, see Run.
+   * \return The name of the mode, empty when the nodes run in order on the caller.
+   */
+  std::string GetRunMode() const;
+  /*!
+   * \brief Check that no run mode other than the given one is set.
+   * \param mode The name of the mode about to be set, as given by GetRunMode.
+   */
+  void CheckRunMode(const std::string& mode) const;
+  /*! \brief Run the executors in order on the caller. */
+  void RunOps();
+  /*! \brief Run the executors in order, fetching the streamed parameters before them. */
+  void RunBounded();
+  /*!
+   * \brief Get the first and last node executing with each entry, a copy batched behind
+   *  another one runs with the last copy of the batch.
+   * \return The pair of nodes of each entry, (num nodes, 0) for unused entries.
+   */
+  std::vector<std::pair<uint32_t, uint32_t>> GetEntryLiveness() const;
+  /*! \brief Issue the executors in order on their streams, see SetupStreams. */
+  void RunOnStreams();
+  /*! \brief Issue the executors in order on the hinted queues, see SetQueueHints. */
+  void RunOnHintedStreams();
+  /*! \brief Release the hinted queues after the work queued on them. */
+  void ReleaseHintedStreams();
+  /*!
+   * \brief Record the nodes each kernel node waits for on the out-of-order queue: its
+   *  producers and the readers of the storage it overwrites, on the queue and after the last
+   *  copy before it, less the ones another wait depends on already.
+   */
+  void SetupOutOfOrderWaits();
+  /*! \brief Issue the executors in order on the out-of-order queue, see SetOutOfOrder. */
+  void RunOutOfOrder();
+  /*! \brief Run the executors on the worker threads. */
+  void RunConcurrently();
+  /*!
+   * \brief The loop of a worker thread.
+   * \param worker_id The index of the worker.
+   */
+  void WorkerLoop(int worker_id);
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -405,8 +761,8 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   std::vector<Node> nodes_;
   /*! \brief The argument nodes. */
   std::vector<uint32_t> input_nodes_;
-  /*! \brief Map of input names to input indices. */
-  std::unordered_map<std::string, uint32_t> input_map_;
+  /*! \brief Map of input names to input indices, searchable by C strings. */
+  std::map<std::string, uint32_t, std::less<>> input_map_;
   /*! \brief Used for quick node input DLTensor* lookup given an input eid. */
   std::vector<std::vector<DLTensor*>> input_dltensors_;
   /*! \brief Used for quick entry indexing. */
@@ -421,12 +777,139 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   std::vector<TVMContext> ctxs_;
   /*! \brief Common storage pool for all devices. */
   std::vector<NDArray> storage_pool_;
+  /*! \brief Storage taken from another runtime instead of allocated, by storage id. */
+  std::unordered_map<uint32_t, NDArray> shared_storage_;
+  /*! \brief The texture arenas shared with other runtimes, nullptr if they are owned. */
+  std::shared_ptr<std::unordered_map<int, NDArray>> texture_arenas_;
+  /*! \brief The entries holding parameters. */
+  std::unordered_set<uint32_t> param_eids_;
+  /*! \brief The parameter entries using arrays shared at Init, until they are written. */
+  std::unordered_set<uint32_t> shared_param_eids_;
+  /*! \brief Called when some arrays shared at Init are no longer used, may be empty. */
+  std::function<void()> shared_param_release_;
+  /*! \brief The workers created from one runtime, which share its parameters. */
+  struct WorkerGroup {
+    /*! \brief The live workers. */
+    std::vector<GraphRuntime*> workers;
+    /*! \brief Guards workers, they are created and destroyed from several threads. */
+    std::mutex mu;
+  };
+  /*! \brief The workers of this runtime, or the group of this worker. */
+  std::shared_ptr<WorkerGroup> worker_group_;
+  /*! \brief Whether this runtime is a worker of another, a member of worker_group_. */
+  bool is_worker_{false};
+  /*! \brief The thread uploading the parameters given to LoadParamsAsync. */
+  std::thread param_loader_;
+  /*! \brief Protects pending_params_ and param_error_. */
+  std::mutex param_mu_;
+  /*! \brief Notified when a parameter is uploaded. */
+  std::condition_variable param_cv_;
+  /*! \brief The entries of the parameters not uploaded yet. */
+  std::unordered_set<uint32_t> pending_params_;
+  /*! \brief The size of pending_params_, checked without the lock. */
+  std::atomic<size_t> num_pending_params_{0};
+  /*! \brief The error of a failed upload. */
+  std::string param_error_;
+  /*! \brief Whether the storage or the parameters are bounded, see RunBounded. */
+  bool bounded_memory_{false};
+  /*! \brief The source of the streamed parameters. */
+  PackedFunc param_source_;
+  /*! \brief The streamed parameters fetched before each node, by entry and name. */
+  std::vector<std::vector<std::pair<uint32_t, std::string>>> streamed_params_;
   /*! \brief Data entry of each node. */
   std::vector<NDArray> data_entry_;
+  /*! \brief The entries viewing rows of the texture of a concatenation, by storage id. */
+  std::unordered_map<uint32_t, std::unordered_set<uint32_t>> texture_row_views_;
   /*! \brief Data alignment of each node. */
   std::vector<size_t> data_alignment_;
   /*! \brief Operator on each node. */
   std::vector<std::function<void()>> op_execs_;
+  /*! \brief The sampling profiler of the ops, null when not sampling. */
+  std::unique_ptr<OpSampler> op_sampler_;
+  /*! \brief The buffers and streams of a frame in flight in the pipeline. */
+  struct PipelineSlot {
+    std::vector<NDArray> host_inputs;
+    std::vector<NDArray> device_inputs;
+    std::vector<NDArray> device_outputs;
+    std::vector<NDArray> host_outputs;
+    TVMStreamHandle upload{nullptr};
+    TVMStreamHandle download{nullptr};
+    /*! \brief The frame which last used the slot, -1 if none. */
+    int64_t frame{-1};
+    /*! \brief Whether the download of the frame may still be in flight. */
+    bool pending{false};
+  };
+  /*! \brief Release the streams of the pipeline after draining it. */
+  void ReleasePipeline();
+  /*! \brief The pipeline slots, empty when not pipelining. */
+  std::vector<PipelineSlot> pipeline_;
+  /*! \brief The device holding the inputs and outputs of the pipeline. */
+  TVMContext pipeline_ctx_;
+  /*! \brief The id of the next frame submitted to the pipeline. */
+  int64_t next_frame_{0};
+  /*! \brief Nodes to run after each node when running concurrently. */
+  std::vector<std::vector<uint32_t>> op_succs_;
+  /*! \brief The nodes whose copies are issued by the executor of each node. */
+  std::vector<std::vector<uint32_t>> op_batched_;
+  /*! \brief The copy stream of each device. */
+  std::vector<std::pair<TVMContext, TVMStreamHandle>> copy_streams_;
+  /*! \brief Number of nodes to run before each node when running concurrently. */
+  std::vector<uint32_t> op_num_deps_;
+  /*! \brief The GPU the streams are on. */
+  TVMContext stream_ctx_;
+  /*! \brief The streams the nodes are spread over, see SetupStreams. */
+  std::vector<TVMStreamHandle> streams_;
+  /*! \brief The stream of each node, empty when all the nodes run on the default stream. */
+  std::vector<TVMStreamHandle> op_streams_;
+  /*! \brief The streams each node waits for before it is issued. */
+  std::vector<std::vector<TVMStreamHandle>> op_stream_waits_;
+  /*! \brief The hinted queue of each OpenCL device, see SetQueueHints. */
+  std::vector<std::pair<TVMContext, TVMStreamHandle>> hinted_streams_;
+  /*! \brief Whether each node is a copy, issued on the default queues between the hinted ones. */
+  std::vector<bool> hinted_copies_;
+  /*! \brief The OpenCL device of the out-of-order queue. */
+  TVMContext ooo_ctx_;
+  /*! \brief The out-of-order queue, null when the graph runs in order. */
+  TVMStreamHandle ooo_stream_{nullptr};
+  /*! \brief The nodes each node waits for on the out-of-order queue. */
+  std::vector<std::vector<uint32_t>> ooo_waits_;
+  /*! \brief Whether each node is a copy, issued on the default queue between two barriers. */
+  std::vector<bool> ooo_barriers_;
+  /*! \brief The functions of the OpenCL runtime tracking the nodes issued. */
+  PackedFunc ooo_begin_;
+  PackedFunc ooo_set_node_;
+  PackedFunc ooo_end_;
+  /*! \brief The thread pool the operators launch on, undefined for the default one. */
+  ObjectRef thread_pool_;
+  /*! \brief The thread pool of each worker thread, on its share of the cores. */
+  std::vector<ObjectRef> worker_pools_;
+  /*! \brief The thread pool on all the cores, for a node running alone. */
+  ObjectRef wide_pool_;
+  /*! \brief Worker threads, empty when the nodes run in order on the caller. */
+  std::vector<std::thread> workers_;
+  /*! \brief State of the concurrent run, guarded by run_mu_. */
+  std::mutex run_mu_;
+  std::condition_variable ready_cv_;
+  std::condition_variable done_cv_;
+  std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready_;
+  std::vector<uint32_t> pending_deps_;
+  size_t num_pending_{0};
+  size_t num_running_{0};
+  std::exception_ptr run_error_;
+  bool stop_workers_{false};
+  /*! \brief The streams of the caller of the concurrent run, which the workers launch on. */
+  std::vector<std::pair<TVMContext, TVMStreamHandle>> run_streams_;
+  /*! \brief Get the OpenCL stream of the calling thread, undefined without OpenCL. */
+  PackedFunc get_stream_;
+  /*! \brief The texture scratch plan of the OpenCL kernels, null when not planned. */
+  void* texture_plan_{nullptr};
+  /*! \brief Start and end a run of the texture scratch plan, undefined without a plan. */
+  PackedFunc begin_texture_plan_;
+  PackedFunc end_texture_plan_;
+  /*! \brief The performance level of the GPU clocks for the runs, see SetPerfHint. */
+  std::string perf_hint_;
+  /*! \brief Set the performance level of the OpenCL context, undefined without a level. */
+  PackedFunc set_perf_hint_;
   /*! \brief Linked parameter lookup function. */
   PackedFunc lookup_linked_param_;
   /*! \brief Module's _lookup_linked_param function, used by DefaultLookupLinkedParam. */
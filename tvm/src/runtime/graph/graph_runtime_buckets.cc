@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file graph_runtime_buckets.cc
+ * \brief A graph runtime over the shape buckets of one model, e.g. the input resolutions of a
+ *  camera pipeline, each compiled with static shapes.
+ *
+ *  The buckets are loaded once and share their parameters and the arenas their intermediate
+ *  textures are carved from, sized for the largest bucket. Setting an input whose shape is
+ *  the one of another bucket switches to that bucket, the other functions are those of the
+ *  GraphRuntime of the current bucket.
+ */
+#include <dmlc/memory_io.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "graph_runtime.h"
+
+namespace tvm {
+namespace runtime {
+
+class GraphRuntimeBuckets : public ModuleNode {
+ public:
+  /*!
+   * \brief Create the runtimes of the buckets.
+   * \param graph_jsons The graphs of the buckets, the largest first.
+   * \param modules The library holding the kernels of all the buckets, or one per bucket.
+   * \param ctxs The contexts of the host and the devices.
+   */
+  void Init(const Array<String>& graph_jsons, const std::vector<Module>& modules,
+            const std::vector<TVMContext>& ctxs) {
+    ICHECK(!graph_jsons.empty()) << "Expect at least one shape bucket";
+    ICHECK(modules.size() == 1 || modules.size() == graph_jsons.size())
+        << "Expect one library, or one per shape bucket";
+    auto arenas = std::make_shared<std::unordered_map<int, NDArray>>();
+    for (size_t i = 0; i < graph_jsons.size(); ++i) {
+      std::unordered_map<int, NDArray> before = *arenas;
+      auto bucket = make_object<GraphRuntime>();
+      bucket->ShareTextureArenas(arenas);
+      bucket->Init(graph_jsons[i], modules[modules.size() == 1 ? 0 : i], ctxs, PackedFunc());
+      for (const auto& kv : before) {
+        if (!kv.second.same_as(arenas->at(kv.first))) {
+          LOG(WARNING) << "Shape bucket " << i << " needs larger textures than the buckets "
+                       << "before it, list the largest bucket first to share one arena";
+        }
+      }
+      buckets_.push_back(bucket);
+    }
+  }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name == "select_bucket") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        int index = args[0];
+        ICHECK(index >= 0 && index < static_cast<int>(buckets_.size()))
+            << "Shape bucket " << index << " out of range";
+        current_ = index;
+      });
+    } else if (name == "get_bucket") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = current_; });
+    } else if (name == "get_num_buckets") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = static_cast<int>(buckets_.size());
+      });
+    } else if (name == "load_params") {
+      // The other buckets take the parameters uploaded for the first one
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        std::string param_blob = args[0];
+        buckets_[0]->LoadParams(param_blob);
+        for (size_t i = 1; i < buckets_.size(); ++i) {
+          dmlc::MemoryStringStream strm(&param_blob);
+          buckets_[i]->ShareParams(*buckets_[0], &strm);
+        }
+      });
+    }
+    std::vector<PackedFunc> funcs;
+    for (const auto& bucket : buckets_) {
+      funcs.push_back(bucket->GetFunction(name, bucket));
+    }
+    if (funcs[0] == nullptr) return PackedFunc();
+    bool sets_input = name == "set_input" || name == "set_input_async" ||
+                      name == "set_input_zero_copy";
+    return PackedFunc([sptr_to_self, this, funcs, sets_input](TVMArgs args, TVMRetValue* rv) {
+      if (sets_input) this->SelectBucket(args);
+      funcs[current_].CallPacked(args, rv);
+    });
+  }
+
+  const char* type_key() const final { return "GraphRuntimeBuckets"; }
+
+ private:
+  /*!
+   * \brief Switch to the bucket of an input, given the arguments of set_input.
+   *  The current bucket is kept when it takes the shape of the input.
+   */
+  void SelectBucket(const TVMArgs& args) {
+    const DLTensor* data = args[1];
+    auto input_index = [&args](GraphRuntime* bucket) {
+      return String::CanConvertFrom(args[0]) ? bucket->GetInputIndex(args[0].operator String())
+                                             : args[0].operator int();
+    };
+    auto takes = [&](GraphRuntime* bucket) {
+      int index = input_index(bucket);
+      if (index < 0) return false;
+      NDArray input = bucket->GetInput(index);
+      return input->ndim == data->ndim &&
+             std::equal(data->shape, data->shape + data->ndim, input->shape);
+    };
+    if (takes(buckets_[current_].get())) return;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      if (takes(buckets_[i].get())) {
+        current_ = static_cast<int>(i);
+        return;
+      }
+    }
+    std::ostringstream os;
+    for (int i = 0; i < data->ndim; ++i) os << (i ? ", " : "") << data->shape[i];
+    LOG(FATAL) << "No shape bucket takes an input of shape (" << os.str() << ")";
+  }
+
+  /*! \brief The runtimes of the buckets. */
+  std::vector<ObjectPtr<GraphRuntime>> buckets_;
+  /*! \brief The bucket run by the forwarded functions. */
+  int current_{0};
+};
+
+// The arguments are the graphs of the buckets, the library or the libraries of one bucket each,
+// and the device type and id of each context, as for tvm.graph_runtime.create.
+TVM_REGISTER_GLOBAL("tvm.graph_runtime.create_buckets")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      ICHECK_GE(args.num_args, 4) << "The expected number of arguments for "
+                                     "graph_runtime.create_buckets is at least 4, but it has "
+                                  << args.num_args;
+      std::vector<Module> modules;
+      if (args[1].type_code() == kTVMModuleHandle) {
+        modules.push_back(args[1]);
+      } else {
+        for (const Module& m : args[1].operator Array<Module>()) modules.push_back(m);
+      }
+      auto exec = make_object<GraphRuntimeBuckets>();
+      exec->Init(args[0].operator Array<String>(), modules, GetAllContext(args, 2));
+      *rv = Module(exec);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
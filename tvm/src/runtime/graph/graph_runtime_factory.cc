@@ -97,12 +97,49 @@ void GraphRuntimeFactory::SaveToBinary(dmlc::Stream* stream) {
 
 Module GraphRuntimeFactory::RuntimeCreate(const std::vector<TVMContext>& ctxs) {
   auto exec = make_object<GraphRuntime>();
-  exec->Init(this->graph_json_, this->imports_[0], ctxs, PackedFunc());
-  // set params
+  exec->Init(this->graph_json_, this->imports_[0], ctxs, PackedFunc(),
+             [this](const std::string& name, TVMContext ctx) {
+               return this->GetResidentParam(name, ctx);
+             });
+  // Drop the uploads of the runtimes which are gone or wrote their own copy
+  std::shared_ptr<ResidentParams> resident = resident_;
+  exec->SetSharedParamRelease([resident]() { resident->ReleaseUnused(); });
+  // set the params which could not be shared, e.g. the textures
   SetParams(exec.get(), this->params_);
   return Module(exec);
 }
 
+NDArray GraphRuntimeFactory::GetResidentParam(const std::string& name, TVMContext ctx) {
+  auto it = params_.find(name);
+  if (it == params_.end()) return NDArray();
+  const NDArray& param = it->second;
+  // The params already on the context are used as they are
+  if (param->ctx.device_type == ctx.device_type && param->ctx.device_id == ctx.device_id &&
+      param->byte_offset == 0 && param.IsContiguous()) {
+    return param;
+  }
+  std::lock_guard<std::mutex> lock(resident_->mu);
+  auto& resident = resident_->arrays[{static_cast<int>(ctx.device_type), ctx.device_id}];
+  auto rit = resident.find(name);
+  if (rit != resident.end()) return rit->second;
+  NDArray array = NDArray::Empty(param.Shape(), param->dtype, ctx);
+  array.CopyFrom(param);
+  resident[name] = array;
+  return array;
+}
+
+void GraphRuntimeFactory::ResidentParams::ReleaseUnused() {
+  std::lock_guard<std::mutex> lock(mu);
+  for (auto ctx_it = arrays.begin(); ctx_it != arrays.end();) {
+    auto& resident = ctx_it->second;
+    for (auto it = resident.begin(); it != resident.end();) {
+      // Only held here, the runtimes using it are gone or have written their own copy
+      it = it->second.use_count() == 1 ? resident.erase(it) : std::next(it);
+    }
+    ctx_it = resident.empty() ? arrays.erase(ctx_it) : std::next(ctx_it);
+  }
+}
+
 Module GraphRuntimeFactory::DebugRuntimeCreate(const std::vector<TVMContext>& ctxs) {
   const PackedFunc* pf = tvm::runtime::Registry::Get("tvm.graph_runtime_debug.create");
   ICHECK(pf != nullptr) << "Cannot find function tvm.graph_runtime_debug.create in registry. "
@@ -32,9 +32,13 @@
 
 #include <algorithm>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "./graph_runtime.h"
@@ -75,6 +79,10 @@ class TVM_DLL GraphRuntimeFactory : public runtime::ModuleNode {
 
   /*!
    * \brief Create a specific runtime module
+   *
+   *  The runtimes created on a context share the copy of the params resident on it,
+   *  which is uploaded once and kept while one of them uses it. A runtime writing one
+   *  of them, e.g. through set_input or load_params, gets storage of its own for it.
    * \param ctxs The context of the host and devices where graph nodes will be
    *  executed on.
    * \return created runtime module
@@ -110,7 +118,7 @@ class TVM_DLL GraphRuntimeFactory : public runtime::ModuleNode {
               });
     for (const auto& key : keys) {
       int in_idx = graph_runtime->GetInputIndex(key);
-      if (in_idx >= 0) {
+      if (in_idx >= 0 && !graph_runtime->IsSharedInput(in_idx)) {
         graph_runtime->SetInput(in_idx, const_cast<DLTensor*>(value[key].operator->()));
       }
     }
@@ -123,6 +131,26 @@ class TVM_DLL GraphRuntimeFactory : public runtime::ModuleNode {
   std::unordered_map<std::string, tvm::runtime::NDArray> params_;
   /*! \brief module name */
   std::string module_name_;
+
+ private:
+  /*!
+   * \brief Get the copy of a param resident on a context, uploading it on first use.
+   * \param name The name of the param.
+   * \param ctx The context.
+   * \return The resident param, undefined when the graph has no such param.
+   */
+  NDArray GetResidentParam(const std::string& name, TVMContext ctx);
+  /*! \brief The params uploaded to the contexts, outlives the factory with its runtimes. */
+  struct ResidentParams {
+    /*! \brief The params resident on each context, by device type and id. */
+    std::map<std::pair<int, int>, std::unordered_map<std::string, NDArray>> arrays;
+    /*! \brief Guards arrays, runtimes are created and destroyed from several threads. */
+    std::mutex mu;
+    /*! \brief Release the resident params which no runtime uses anymore. */
+    void ReleaseUnused();
+  };
+  /*! \brief The resident params, shared with the release hook of each runtime. */
+  std::shared_ptr<ResidentParams> resident_ = std::make_shared<ResidentParams>();
 };
 
 }  // namespace runtime
@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_runtime_replicas.cc
+ * \brief A graph runtime running replicas of one model on the devices of the OpenCL context,
+ *  e.g. the GPUs of a server, each on a share of the batches.
+ *
+ *  The devices of the OpenCL context all access its buffers, so the parameters are uploaded
+ *  once and the replicas read them in place. Every replica enqueues its kernels on the queue
+ *  of its device, the runs issued one after the other from one thread overlap on the devices.
+ *  The functions which are not the ones of the replicas are those of the GraphRuntime of the
+ *  current replica.
+ */
+#include <dmlc/memory_io.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <vector>
+
+#include "graph_runtime.h"
+
+namespace tvm {
+namespace runtime {
+
+class GraphRuntimeReplicas : public ModuleNode {
+ public:
+  /*!
+   * \brief Create a replica of the graph on every OpenCL device.
+   * \param graph_json The graph.
+   * \param module The library holding the kernels.
+   * \param ctxs The contexts of the host and the OpenCL devices.
+   */
+  void Init(const std::string& graph_json, const Module& module,
+            const std::vector<TVMContext>& ctxs) {
+    std::vector<TVMContext> devices;
+    for (const TVMContext& ctx : ctxs) {
+      if (ctx.device_type == kDLOpenCL) devices.push_back(ctx);
+    }
+    ICHECK(!devices.empty()) << "Expect at least one OpenCL device to replicate the graph on";
+    for (const TVMContext& device : devices) {
+      // The replica takes the place of the first OpenCL context, the others are left out
+      std::vector<TVMContext> replica_ctxs;
+      bool placed = false;
+      for (const TVMContext& ctx : ctxs) {
+        if (ctx.device_type != kDLOpenCL) {
+          replica_ctxs.push_back(ctx);
+        } else if (!placed) {
+          replica_ctxs.push_back(device);
+          placed = true;
+        }
+      }
+      auto replica = make_object<GraphRuntime>();
+      replica->Init(graph_json, module, replica_ctxs, PackedFunc());
+      replicas_.push_back(replica);
+    }
+  }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name == "select_replica") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        int index = args[0];
+        ICHECK(index >= 0 && index < static_cast<int>(replicas_.size()))
+            << "Replica " << index << " out of range";
+        current_ = index;
+      });
+    } else if (name == "get_replica") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = current_; });
+    } else if (name == "get_num_replicas") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = static_cast<int>(replicas_.size());
+      });
+    } else if (name == "load_params") {
+      // The other replicas read the parameters uploaded for the first one
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        std::string param_blob = args[0];
+        replicas_[0]->LoadParams(param_blob);
+        for (size_t i = 1; i < replicas_.size(); ++i) {
+          dmlc::MemoryStringStream strm(&param_blob);
+          replicas_[i]->ShareParams(*replicas_[0], &strm);
+        }
+      });
+    } else if (name == "run_all") {
+      // Only the enqueueing is serialized, the replicas run concurrently on their devices
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        for (const auto& replica : replicas_) replica->Run();
+      });
+    }
+    std::vector<PackedFunc> funcs;
+    for (const auto& replica : replicas_) {
+      funcs.push_back(replica->GetFunction(name, replica));
+    }
+    if (funcs[0] == nullptr) return PackedFunc();
+    return PackedFunc([sptr_to_self, this, funcs](TVMArgs args, TVMRetValue* rv) {
+      funcs[current_].CallPacked(args, rv);
+    });
+  }
+
+  const char* type_key() const final { return "GraphRuntimeReplicas"; }
+
+ private:
+  /*! \brief The runtimes of the replicas, one per OpenCL device. */
+  std::vector<ObjectPtr<GraphRuntime>> replicas_;
+  /*! \brief The replica run by the forwarded functions. */
+  int current_{0};
+};
+
+// The arguments are the graph, the library and the device type and id of each context, as for
+// tvm.graph_runtime.create, with one context for every OpenCL device to run a replica on.
+TVM_REGISTER_GLOBAL("tvm.graph_runtime.create_replicas")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      ICHECK_GE(args.num_args, 4) << "The expected number of arguments for "
+                                     "graph_runtime.create_replicas is at least 4, but it has "
+                                  << args.num_args;
+      auto exec = make_object<GraphRuntimeReplicas>();
+      exec->Init(args[0], args[1], GetAllContext(args, 2));
+      *rv = Module(exec);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
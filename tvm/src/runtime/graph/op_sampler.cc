@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file op_sampler.cc
+ * \brief Sampling profiler of the ops of a graph.
+ */
+#include "op_sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "../../support/str_escape.h"
+
+namespace tvm {
+namespace runtime {
+
+OpSampler::OpSampler(int sample_every, size_t num_nodes)
+    : sample_every_(sample_every), ops_(new OpStats[num_nodes]), num_nodes_(num_nodes) {
+  ICHECK_GT(sample_every, 0);
+}
+
+bool OpSampler::BeginRun() {
+  if (!pending_.empty()) this->Collect();
+  // The first runs build the kernels, the first sample is the run sample_every
+  return ++num_runs_ % sample_every_ == 0;
+}
+
+void OpSampler::StartOp(uint32_t nid, TVMContext ctx) {
+  pending_.emplace_back(nid, Timer::Start(ctx));
+}
+
+void OpSampler::StopOp() { pending_.back().second->Stop(); }
+
+void OpSampler::Collect() {
+  uint64_t total = 0;
+  for (auto& kv : pending_) {
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(kv.second->SyncAndGetElapsedNanos(), 0));
+    OpStats& op = ops_[kv.first];
+    uint64_t count = op.count.load(std::memory_order_relaxed);
+    uint64_t min_ns = op.min_ns.load(std::memory_order_relaxed);
+    op.min_ns.store(count == 0 ? ns : std::min(min_ns, ns), std::memory_order_relaxed);
+    op.max_ns.store(std::max(op.max_ns.load(std::memory_order_relaxed), ns),
+                    std::memory_order_relaxed);
+    op.total_ns.fetch_add(ns, std::memory_order_relaxed);
+    op.buckets[Bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    // The count goes last, a reader seeing it sees the time of the sample
+    op.count.store(count + 1, std::memory_order_release);
+    total += ns;
+  }
+  pending_.clear();
+  uint64_t sample = num_samples_.load(std::memory_order_relaxed);
+  ring_[sample % kRingSize].store(total, std::memory_order_relaxed);
+  num_samples_.store(sample + 1, std::memory_order_release);
+}
+
+int OpSampler::Bucket(uint64_t ns) {
+  double us = static_cast<double>(ns) / 1e3;
+  if (us < 1.0) return 0;
+  int bucket = 1 + static_cast<int>(std::floor(std::log2(us) * kBucketsPerOctave));
+  return std::min(bucket, kNumBuckets - 1);
+}
+
+double OpSampler::BucketLimit(int bucket) {
+  return std::exp2(static_cast<double>(bucket) / kBucketsPerOctave);
+}
+
+std::string OpSampler::Report(const std::function<std::string(uint32_t)>& node_name) const {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  uint64_t num_samples = num_samples_.load(std::memory_order_acquire);
+  os << "{\"sample_every\": " << sample_every_ << ", \"samples\": " << num_samples
+     << ", \"ops\": [";
+  bool first = true;
+  for (size_t nid = 0; nid < num_nodes_; ++nid) {
+    const OpStats& op = ops_[nid];
+    uint64_t count = op.count.load(std::memory_order_acquire);
+    if (count == 0) continue;
+    std::string name = node_name(static_cast<uint32_t>(nid));
+    double max_us = op.max_ns.load(std::memory_order_relaxed) / 1e3;
+    os << (first ? "" : ",") << "\n  {\"name\": \""
+       << support::StrEscape(name.data(), name.length()) << "\", \"count\": " << count
+       << ", \"mean_us\": " << op.total_ns.load(std::memory_order_relaxed) / 1e3 / count
+       << ", \"min_us\": " << op.min_ns.load(std::memory_order_relaxed) / 1e3
+       << ", \"max_us\": " << max_us;
+    // The percentiles are the upper bounds of the buckets holding them, capped by the max
+    uint64_t hist[kNumBuckets];
+    uint64_t hist_count = 0;
+    for (int b = 0; b < kNumBuckets; ++b) {
+      hist[b] = op.buckets[b].load(std::memory_order_relaxed);
+      hist_count += hist[b];
+    }
+    for (int p : {50, 90, 99}) {
+      uint64_t rank = (hist_count * p + 99) / 100;
+      uint64_t seen = 0;
+      int b = 0;
+      for (; b < kNumBuckets - 1; ++b) {
+        seen += hist[b];
+        if (seen >= rank) break;
+      }
+      os << ", \"p" << p << "_us\": " << std::min(BucketLimit(b), max_us);
+    }
+    os << "}";
+    first = false;
+  }
+  os << "\n], \"recent_total_us\": [";
+  uint64_t begin = num_samples > kRingSize ? num_samples - kRingSize : 0;
+  for (uint64_t i = begin; i < num_samples; ++i) {
+    os << (i == begin ? "" : ", ") << ring_[i % kRingSize].load(std::memory_order_relaxed) / 1e3;
+  }
+  os << "]}";
+  return os.str();
+}
+
+}  // namespace runtime
+}  // namespace tvm
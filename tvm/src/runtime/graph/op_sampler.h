@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file op_sampler.h
+ * \brief Sampling profiler of the ops of a graph, cheap enough to stay on in production.
+ */
+#ifndef TVM_RUNTIME_GRAPH_OP_SAMPLER_H_
+#define TVM_RUNTIME_GRAPH_OP_SAMPLER_H_
+
+#include <tvm/runtime/profiling.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Histograms of the device time of every op over one in every N runs of a graph.
+ *
+ *  The ops of a sampled run are timed with the device timers of Timer::Start, OpenCL or CUDA
+ *  events on the GPUs, without synchronizing between the ops. The timers are read when the
+ *  next run starts, so that the sampled run does not wait for the device either.
+ *
+ *  The thread running the graph is the only writer. The counters are relaxed atomics, so the
+ *  report can be read from any thread while the graph runs, without locking.
+ */
+class OpSampler {
+ public:
+  /*! \brief The histogram buckets per power of two microseconds. */
+  static constexpr int kBucketsPerOctave = 4;
+  /*! \brief The number of buckets, the last one holds the times above 2^20 us. */
+  static constexpr int kNumBuckets = 1 + 20 * kBucketsPerOctave;
+  /*! \brief The number of sampled runs whose total op time is kept. */
+  static constexpr size_t kRingSize = 64;
+  /*!
+   * \brief Create the sampler of a graph.
+   * \param sample_every Sample one in every sample_every runs.
+   * \param num_nodes The number of nodes of the graph.
+   */
+  OpSampler(int sample_every, size_t num_nodes);
+  /*!
+   * \brief Start a run, reading the timers of the previous sampled run.
+   * \return Whether the ops of the run are timed.
+   */
+  bool BeginRun();
+  /*!
+   * \brief Start timing an op of a sampled run.
+   * \param nid The node of the op.
+   * \param ctx The device the op runs on.
+   */
+  void StartOp(uint32_t nid, TVMContext ctx);
+  /*! \brief Stop timing the op started last. */
+  void StopOp();
+  /*!
+   * \brief Get the report as JSON, the histograms are summarized by their percentiles.
+   * \param node_name The name of a node.
+   */
+  std::string Report(const std::function<std::string(uint32_t)>& node_name) const;
+
+ private:
+  /*! \brief The accumulated times of an op. */
+  struct OpStats {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> min_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> buckets[kNumBuckets]{};
+  };
+  /*! \brief Read the timers of the last sampled run into the histograms. */
+  void Collect();
+  /*! \brief The bucket of a time. */
+  static int Bucket(uint64_t ns);
+  /*! \brief The upper bound of a bucket in microseconds. */
+  static double BucketLimit(int bucket);
+
+  int sample_every_;
+  /*! \brief The number of runs started, only touched by the writer. */
+  uint64_t num_runs_{0};
+  std::unique_ptr<OpStats[]> ops_;
+  size_t num_nodes_;
+  /*! \brief The timers of the last sampled run, by node. */
+  std::vector<std::pair<uint32_t, Timer>> pending_;
+  /*! \brief The total op time of the last sampled runs, in nanoseconds. */
+  std::atomic<uint64_t> ring_[kRingSize]{};
+  /*! \brief The number of sampled runs collected. */
+  std::atomic<uint64_t> num_samples_{0};
+};
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_RUNTIME_GRAPH_OP_SAMPLER_H_
@@ -68,6 +68,7 @@ inline void* HexagonDeviceAPI::AllocDataSpace(TVMContext ctx, size_t nbytes, siz
 
 inline void HexagonDeviceAPI::FreeDataSpace(TVMContext ctx, void* ptr) {
   ICHECK(hexagon::Device::ValidateDeviceId(ctx.device_id));
+  hexagon::FlushCallBatch();
   hexagon::Device::Global()->Free(ptr);
 }
 
@@ -77,6 +78,8 @@ inline void HexagonDeviceAPI::CopyDataFromTo(const void* from, size_t from_offse
                                              DLDataType type_hint, TVMStreamHandle stream) {
   const char* src = static_cast<const char*>(from) + from_offset;
   char* dst = static_cast<char*>(to) + to_offset;
+  // The copy must see the results of the recorded kernel launches.
+  hexagon::FlushCallBatch();
 
   auto Is32bit = [](const void* p) {
     return p == reinterpret_cast<const void*>(uint32_t(uintptr_t(p)));
@@ -108,7 +111,9 @@ inline void HexagonDeviceAPI::CopyDataFromTo(const void* from, size_t from_offse
   }
 }
 
-inline void HexagonDeviceAPI::StreamSync(TVMContext ctx, TVMStreamHandle stream) {}
+inline void HexagonDeviceAPI::StreamSync(TVMContext ctx, TVMStreamHandle stream) {
+  hexagon::FlushCallBatch();
+}
 
 inline void* HexagonDeviceAPI::AllocWorkspace(TVMContext ctx, size_t nbytes, DLDataType type_hint) {
   ICHECK(hexagon::Device::ValidateDeviceId(ctx.device_id));
@@ -121,6 +126,7 @@ inline void* HexagonDeviceAPI::AllocWorkspace(TVMContext ctx, size_t nbytes, DLD
 
 inline void HexagonDeviceAPI::FreeWorkspace(TVMContext ctx, void* ptr) {
   ICHECK(hexagon::Device::ValidateDeviceId(ctx.device_id));
+  hexagon::FlushCallBatch();
   DeviceAPI::FreeWorkspace(ctx, ptr);
 }
 
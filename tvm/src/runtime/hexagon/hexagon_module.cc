@@ -25,7 +25,12 @@
 #include <tvm/runtime/registry.h>
 #include <tvm/support/logging.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -187,6 +192,212 @@ void ArgLayout::Push(uint32_t* v, unsigned t_size, unsigned t_align) {
   }
 }
 
+/*!
+ * \brief Layout of the DLTensor structure on Hexagon.
+ *
+ *  DLTensor:                       Size  offset
+ *    data              void*          4       0
+ *    ctx.device_type   enum           1       4
+ *    <pad>                            3       5
+ *    ctx.device_id     int            4       8
+ *    ndim              int            4      12
+ *    dtype.code        uint8_t        1      16
+ *    dtype.bits        uint8_t        1      17
+ *    dtype.lanes       uint16_t       2      18
+ *    shape             int64_t*       4      20
+ *    strides           int64_t*       4      24
+ *    <pad>                            4      28
+ *    byte_offset       uint64_t       8      32
+ *    .. end ................................ 40
+ */
+struct __attribute__((packed)) HexagonDLTensor {
+  uint32_t data;
+  uint8_t ctx_device_type;
+  uint8_t pad0[3];  // MUST BE ZERO!
+  int32_t ctx_device_id;
+  int32_t ndim;
+  uint8_t dtype_code;
+  uint8_t dtype_bits;
+  uint16_t dtype_lanes;
+  uint32_t shape;
+  uint32_t strides;
+  uint8_t pad1[4];
+  uint64_t byte_offset;
+};
+
+static_assert(sizeof(HexagonDLTensor) == 40, "HexagonDLTensor should be 40 bytes");
+
+/*!
+ * \brief The size of the remote copy of a DLTensor: the structure followed by the
+ *  shape and the strides, ndim elements of size sizeof(uint64_t) each.
+ */
+static uint32_t RemoteTensorSize(const DLTensor* t) {
+  uint32_t size_s = 8 * t->ndim;
+  return sizeof(HexagonDLTensor) + (t->strides ? 2 * size_s : size_s);
+}
+
+/*!
+ * \brief Write the remote copy of a DLTensor to host memory.
+ * \param t       The tensor.
+ * \param remote  The address of the copy on the device, used for the shape and the strides.
+ * \param dst     The host memory of RemoteTensorSize(t) bytes.
+ */
+static void PackRemoteTensor(const DLTensor* t, uint32_t remote, char* dst) {
+  constexpr uint32_t size_ht = sizeof(HexagonDLTensor);
+  int ndim = t->ndim;
+  HexagonDLTensor local;
+  local.data = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(t->data));
+  local.ctx_device_type = uint8_t(t->ctx.device_type);
+  local.pad0[0] = local.pad0[1] = local.pad0[2] = 0;
+  local.ctx_device_id = t->ctx.device_id;
+  local.ndim = t->ndim;
+  local.dtype_code = t->dtype.code;
+  local.dtype_bits = t->dtype.bits;
+  local.dtype_lanes = t->dtype.lanes;
+  local.shape = remote + size_ht;
+  local.strides = t->strides ? remote + size_ht + 8 * ndim : 0u;
+  local.pad1[0] = local.pad1[1] = local.pad1[2] = local.pad1[3] = 0;
+  local.byte_offset = t->byte_offset;
+  std::memcpy(dst, &local, size_ht);
+
+  uint64_t* local_ss = reinterpret_cast<uint64_t*>(dst + size_ht);
+  for (int i = 0; i != ndim; ++i) local_ss[i] = t->shape[i];
+  if (t->strides) {
+    for (int i = 0; i != ndim; ++i) local_ss[ndim + i] = t->strides[i];
+  }
+}
+
+/*!
+ * \brief A batch of kernel launches, run with one FastRPC call.
+ *
+ * Every Device::Call is a FastRPC round trip, and a packed C call adds the allocations of its
+ * arguments and of its remote DLTensors to it. For graphs of many small operators this
+ * dominates the run time. The launches are therefore only recorded: the arguments of the
+ * packed C calls go to a host payload, and the launches to msg_call records, the format read
+ * by the launcher of the device. Flush copies the payload and the records to a persistent
+ * device arena and runs all the launches with a single call to tvm_hexagon_run_batch, the batch
+ * runner of the device. The pointers into the payload are kept as offsets until then, and are
+ * relocated to the arena on the flush. The device API flushes the batch before the host can
+ * observe the memory of the kernels: on copies, frees and StreamSync. A failed launch is
+ * reported by the flush.
+ *
+ * When the device has no batch runner, e.g. the simulator, or TVM_HEXAGON_BATCH_CALLS=0 is
+ * set, e.g. for profiling, the launches stay immediate.
+ */
+class CallBatch {
+ public:
+  static CallBatch* Global() {
+    static CallBatch* inst = new CallBatch();
+    return inst;
+  }
+
+  /*! \brief Run the recorded launches. */
+  void Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FlushLocked();
+  }
+
+  /*! \brief The mutex to hold while recording a launch. */
+  std::mutex& mutex() { return mutex_; }
+  /*! \brief Whether the launches are recorded, the mutex must be held. */
+  bool Recording() {
+    if (!initialized_) {
+      initialized_ = true;
+      const char* batch_calls = getenv("TVM_HEXAGON_BATCH_CALLS");
+      if (batch_calls == nullptr || std::string(batch_calls) != "0") {
+        device_ = Device::Global();
+        runner_ = device_->Resolve("tvm_hexagon_run_batch");
+      }
+    }
+    return runner_ != nullptr;
+  }
+
+  /*!
+   * \brief Reserve zeroed space in the payload.
+   * \return The offset of the space in the payload.
+   */
+  uint32_t Reserve(uint32_t size, uint32_t align) {
+    uint32_t offset = (payload_.size() + align - 1) / align * align;
+    payload_.resize(offset + size, 0);
+    return offset;
+  }
+  /*! \brief The host memory of the payload at an offset, valid until the next Reserve. */
+  char* At(uint32_t offset) { return payload_.data() + offset; }
+  /*! \brief Mark a 32-bit payload word as an offset to relocate to the arena. */
+  void Relocate(uint32_t offset) { payload_relocs_.push_back(offset); }
+
+  /*!
+   * \brief Record a launch.
+   * \param func     Address (local to the device) of the function to call.
+   * \param layout   The arguments of the call.
+   * \param relocs   The indices of the scalar arguments that are payload offsets.
+   */
+  void AddCall(void* func, const ArgLayout& layout, const std::vector<unsigned>& relocs) {
+    uint32_t start = records_.size();
+    records_.push_back(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(func)));
+    records_.push_back(layout.Scalar.size());
+    records_.push_back(layout.Stack.size());
+    records_.insert(records_.end(), layout.Scalar.begin(), layout.Scalar.end());
+    records_.insert(records_.end(), layout.Stack.begin(), layout.Stack.end());
+    for (unsigned i : relocs) record_relocs_.push_back(start + 3 + i);
+    ++num_calls_;
+  }
+
+ private:
+  CallBatch() = default;
+
+  void FlushLocked() {
+    if (num_calls_ == 0) return;
+    uint32_t records_offset = Reserve(records_.size() * sizeof(uint32_t), 8);
+    uint32_t total = payload_.size();
+    if (total > arena_size_) {
+      if (arena_ != nullptr) device_->Free(arena_);
+      arena_size_ = std::max(total, 2 * arena_size_);
+      arena_ = device_->Alloc(arena_size_, 8);
+      ICHECK(arena_ != nullptr) << "Cannot allocate " << arena_size_ << " bytes for a call batch";
+    }
+    uint32_t base = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arena_));
+    for (uint32_t offset : payload_relocs_) {
+      uint32_t v;
+      std::memcpy(&v, At(offset), sizeof(v));
+      v += base;
+      std::memcpy(At(offset), &v, sizeof(v));
+    }
+    for (uint32_t i : record_relocs_) records_[i] += base;
+    std::memcpy(At(records_offset), records_.data(), records_.size() * sizeof(uint32_t));
+    device_->CopyHostToDevice(arena_, payload_.data(), total);
+    uint32_t scalar[2] = {base + records_offset, num_calls_};
+    payload_.clear();
+    payload_relocs_.clear();
+    records_.clear();
+    record_relocs_.clear();
+    num_calls_ = 0;
+    // Throws when a launch of the batch failed
+    device_->Call(runner_, scalar, 2, nullptr, 0);
+  }
+
+  std::mutex mutex_;
+  /*! \brief Whether the batch runner was looked up. */
+  bool initialized_{false};
+  std::shared_ptr<Device> device_;
+  /*! \brief The batch runner of the device, nullptr when there is none. */
+  void* runner_{nullptr};
+  /*! \brief The host payload: values, codes and remote DLTensors of the packed C calls. */
+  std::vector<char> payload_;
+  /*! \brief The offsets of the payload words that are payload offsets. */
+  std::vector<uint32_t> payload_relocs_;
+  /*! \brief The msg_call records of the launches. */
+  std::vector<uint32_t> records_;
+  /*! \brief The indices of the record words that are payload offsets. */
+  std::vector<uint32_t> record_relocs_;
+  uint32_t num_calls_{0};
+  /*! \brief The device memory the payload and the records are copied to. */
+  void* arena_{nullptr};
+  uint32_t arena_size_{0};
+};
+
+void FlushCallBatch() { CallBatch::Global()->Flush(); }
+
 }  // namespace hexagon
 
 class HexagonModuleNode final : public runtime::ModuleNode {
@@ -248,6 +459,7 @@ class HexagonModuleNode final : public runtime::ModuleNode {
 
  private:
   void CallRemotePackedCABI(void* func_ptr, const TVMArgs& args, TVMRetValue* rv) const;
+  bool RecordRemotePackedCABI(void* func_ptr, const TVMArgs& args) const;
   void CallRemoteDirect(void* func_ptr, const TVMArgs& args, TVMRetValue* rv) const;
   void RemapArgs(const TVMArgs& args,
                  std::vector<TVMValue>& values,              // NOLINT(*)
@@ -270,6 +482,7 @@ class HexagonModuleNode final : public runtime::ModuleNode {
 
 void HexagonModuleNode::CallRemotePackedCABI(void* func_ptr, const TVMArgs& args,
                                              TVMRetValue* rv) const {
+  if (RecordRemotePackedCABI(func_ptr, args)) return;
   // Remap all arguments, creating remote DLTensors.
   std::vector<TVMValue> values;
   std::vector<int> codes;
@@ -322,9 +535,58 @@ void HexagonModuleNode::CallRemotePackedCABI(void* func_ptr, const TVMArgs& args
   hexagon_device_->Free(remote);
 }
 
+bool HexagonModuleNode::RecordRemotePackedCABI(void* func_ptr, const TVMArgs& args) const {
+  hexagon::CallBatch* batch = hexagon::CallBatch::Global();
+  std::lock_guard<std::mutex> lock(batch->mutex());
+  if (!batch->Recording()) return false;
+
+  // The same layout as in CallRemotePackedCABI, but in the payload of the batch.
+  int num_args = args.size();
+  int values_size = num_args * sizeof(TVMValue);
+  int codes_size = num_args * sizeof(int);
+  uint32_t values = batch->Reserve(values_size + sizeof(TVMValue) + codes_size + sizeof(int), 8);
+  uint32_t ret_value = values + values_size;
+  uint32_t codes = ret_value + sizeof(TVMValue);
+  uint32_t ret_code = codes + codes_size;
+
+  for (int i = 0; i != num_args; ++i) {
+    int tc = args.type_codes[i];
+    TVMValue v = args.values[i];
+    if (tc == kTVMNDArrayHandle || tc == kTVMDLTensorHandle) {
+      const DLTensor* t = static_cast<DLTensor*>(args[i]);
+      ICHECK_EQ(static_cast<int>(t->ctx.device_type), kDLHexagon);
+      uint32_t remote = batch->Reserve(hexagon::RemoteTensorSize(t), 8);
+      hexagon::PackRemoteTensor(t, remote, batch->At(remote));
+      batch->Relocate(remote + offsetof(hexagon::HexagonDLTensor, shape));
+      if (t->strides) batch->Relocate(remote + offsetof(hexagon::HexagonDLTensor, strides));
+      v.v_int64 = remote;
+      batch->Relocate(values + i * sizeof(TVMValue));
+    }
+    std::memcpy(batch->At(values + i * sizeof(TVMValue)), &v, sizeof(TVMValue));
+    std::memcpy(batch->At(codes + i * sizeof(int)), &tc, sizeof(int));
+  }
+
+  hexagon::ArgLayout as;
+  as.Push(static_cast<int>(values));
+  as.Push(static_cast<int>(codes));
+  as.Push(num_args);
+  as.Push(static_cast<int>(ret_value));
+  as.Push(static_cast<int>(ret_code));
+  batch->AddCall(func_ptr, as, {0, 1, 3, 4});
+  return true;
+}
+
 void HexagonModuleNode::CallRemoteDirect(void* func_ptr, const TVMArgs& args,
                                          TVMRetValue* rv) const {
   hexagon::ArgLayout as = BuildArgLayout(args);
+  {
+    hexagon::CallBatch* batch = hexagon::CallBatch::Global();
+    std::lock_guard<std::mutex> lock(batch->mutex());
+    if (batch->Recording()) {
+      batch->AddCall(func_ptr, as, {});
+      return;
+    }
+  }
   hexagon_device_->Call(func_ptr, as.Scalar.data(), as.Scalar.size(), as.Stack.data(),
                         as.Stack.size());
 }
@@ -397,72 +659,12 @@ void HexagonModuleNode::RemapArgs(const TVMArgs& args, std::vector<TVMValue>& va
 }
 
 void* HexagonModuleNode::CreateRemoteTensor(const DLTensor* t) const {
-  /*
-    Layout of the DLTensor structure on Hexagon.
-
-    DLTensor:                       Size  offset
-      data              void*          4       0
-      ctx.device_type   enum           1       4
-      <pad>                            3       5
-      ctx.device_id     int            4       8
-      ndim              int            4      12
-      dtype.code        uint8_t        1      16
-      dtype.bits        uint8_t        1      17
-      dtype.lanes       uint16_t       2      18
-      shape             int64_t*       4      20
-      strides           int64_t*       4      24
-      <pad>                            4      28
-      byte_offset       uint64_t       8      32
-      .. end ................................ 40
-  */
-  struct __attribute__((packed)) HexagonDLTensor {
-    uint32_t data;
-    uint8_t ctx_device_type;
-    uint8_t pad0[3];  // MUST BE ZERO!
-    int32_t ctx_device_id;
-    int32_t ndim;
-    uint8_t dtype_code;
-    uint8_t dtype_bits;
-    uint16_t dtype_lanes;
-    uint32_t shape;
-    uint32_t strides;
-    uint8_t pad1[4];
-    uint64_t byte_offset;
-  };
-
-  constexpr uint32_t size_ht = sizeof(HexagonDLTensor);
-  static_assert(size_ht == 40, "HexagonDLTensor should be 40 bytes");
-
-  // Shape and strides will contain ndim elements of size sizeof(uint64_t)
-  // each. Allocate them after the main structure.
-  int ndim = t->ndim;
-  uint32_t size_s = 8 * ndim;  // sizeof(uint64_t)*ndim
-  uint32_t size_ss = t->strides ? 2 * size_s : size_s;
-  void* remote = hexagon_device_->Alloc(size_ht + size_ss, 8);
+  uint32_t size = hexagon::RemoteTensorSize(t);
+  void* remote = hexagon_device_->Alloc(size, 8);
+  std::vector<char> local(size);
   uint32_t remote_as_int = reinterpret_cast<uintptr_t>(remote);
-  void* remote_ss = reinterpret_cast<void*>(remote_as_int + size_ht);
-
-  HexagonDLTensor local;
-  local.data = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(t->data));
-  local.ctx_device_type = uint8_t(t->ctx.device_type);
-  local.pad0[0] = local.pad0[1] = local.pad0[2] = 0;
-  local.ctx_device_id = t->ctx.device_id;
-  local.ndim = t->ndim;
-  local.dtype_code = t->dtype.code;
-  local.dtype_bits = t->dtype.bits;
-  local.dtype_lanes = t->dtype.lanes;
-  local.shape = remote_as_int + size_ht;
-  local.strides = t->strides ? remote_as_int + size_ht + size_s : 0u;
-  local.byte_offset = t->byte_offset;
-
-  std::vector<uint64_t> local_ss(size_ss / 8);
-  for (int i = 0; i != ndim; ++i) local_ss[i] = t->shape[i];
-  if (t->strides) {
-    for (int i = 0; i != ndim; ++i) local_ss[ndim + i] = t->strides[i];
-  }
-
-  hexagon_device_->CopyHostToDevice(remote, &local, sizeof local);
-  hexagon_device_->CopyHostToDevice(remote_ss, local_ss.data(), size_ss);
+  hexagon::PackRemoteTensor(t, remote_as_int, local.data());
+  hexagon_device_->CopyHostToDevice(remote, local.data(), size);
   return remote;
 }
 
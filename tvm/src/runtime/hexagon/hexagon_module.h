@@ -136,6 +136,8 @@ class Device {
    *                passed on the stack. This array includes dummy values
    *                for padding.
    * \param st_num  Number of values in the "stack" array.
+   *
+   * Throws when the device reports a failure of the call.
    */
   virtual void Call(void* func, uint32_t* scalar, unsigned sc_num, uint32_t* stack,
                     unsigned st_num) = 0;
@@ -149,6 +151,12 @@ class Device {
   }
 };
 
+/*!
+ * \brief Run the kernel launches recorded by an open batch, see CallBatch in hexagon_module.cc.
+ *  This must happen before the host reads or releases the memory used by the kernels.
+ */
+void FlushCallBatch();
+
 }  // namespace hexagon
 
 }  // namespace runtime
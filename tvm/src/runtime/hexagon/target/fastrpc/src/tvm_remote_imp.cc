@@ -19,6 +19,9 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <mutex>
 
 #define FARF_ERROR 1
 #include "AEEStdErr.h"
@@ -46,6 +49,8 @@ static int HAP_query_avail_VTCM(unsigned* avail_block_size, unsigned* max_page_s
 #define MAX_GATHER_SCATTER_SZ (64 * 1024)
 #define MIN_VTCM_SZ (64 * 1024)
 
+static void ReleaseVTCMArena();
+
 /*!
  *  \brief Open a domain channel.
  *
@@ -80,6 +85,7 @@ int tvm_remote_open(const char* uri, remote_handle64* handle_ptr) {
 int tvm_remote_close(remote_handle64 handle) {
   FARF(ALWAYS, "%s", __func__);
   if (handle) free(reinterpret_cast<void*>(static_cast<uintptr_t>(handle)));
+  ReleaseVTCMArena();
   int rc = tvm_remote_nd_close();
   if (rc != AEE_SUCCESS) {
     FARF(ERROR, "%s: tvm_remote_nd_close failed rc=%08x", __func__, rc);
@@ -242,3 +248,120 @@ int tvm_remote_free_vtcm(remote_handle64 handle, unsigned dsp_va) {
   }
   return rc;
 }
+
+/*!
+ *  \brief The VTCM arena of the kernels, requested on the first VTCM allocation and released
+ *  when the domain channel is closed.
+ *
+ *  The allocations of a kernel are nested, so they are stacked in the arena. Kernels may run
+ *  on several threads, whose allocations are not nested in each other, so the arena is used
+ *  by one thread at a time: the thread holding live allocations in it.
+ */
+struct VTCMArena {
+  char* base{nullptr};
+  unsigned size{0};
+  /*! \brief The end of the live allocations. */
+  unsigned top{0};
+  /*! \brief The number of live allocations. */
+  unsigned depth{0};
+  /*! \brief The thread of the live allocations. */
+  qurt_thread_t owner{0};
+};
+static VTCMArena vtcm_arena;
+static std::mutex vtcm_arena_mutex;
+
+/*!
+ *  \brief Release the VTCM arena, if it has no live allocations.
+ */
+static void ReleaseVTCMArena() {
+  std::lock_guard<std::mutex> lock(vtcm_arena_mutex);
+  if (vtcm_arena.base == nullptr || vtcm_arena.depth != 0) return;
+  int rc = HAP_release_VTCM(vtcm_arena.base);
+  if (rc != AEE_SUCCESS) {
+    FARF(ERROR, "%s: error freeing VTCM, rc=%08x", __func__, rc);
+  }
+  vtcm_arena = VTCMArena();
+}
+
+/*!
+ *  \brief Allocate VTCM memory for a kernel.
+ *
+ *  The memory is stacked in one arena of the largest available VTCM page. When VTCM is
+ *  exhausted, or used by another thread, the memory comes from DDR instead.
+ *
+ *  \param nbytes  The size of the allocation.
+ *
+ *  \return The allocated memory, aligned to the HVX vector length.
+ */
+extern "C" void* TVMBackendAllocVTCM(unsigned nbytes) {
+  const unsigned align = 128;
+  unsigned size = (nbytes + align - 1) / align * align;
+  {
+    std::lock_guard<std::mutex> lock(vtcm_arena_mutex);
+    qurt_thread_t self = qurt_thread_get_id();
+    if (vtcm_arena.base == nullptr) {
+      unsigned avail_block_size, max_page_size, num_pages;
+      if (HAP_query_avail_VTCM(&avail_block_size, &max_page_size, &num_pages) == AEE_SUCCESS &&
+          max_page_size >= MIN_VTCM_SZ) {
+        vtcm_arena.base =
+            static_cast<char*>(HAP_request_VTCM(max_page_size, /*single_page_flag=*/1));
+        vtcm_arena.size = vtcm_arena.base != nullptr ? max_page_size : 0;
+      }
+    }
+    if ((vtcm_arena.depth == 0 || vtcm_arena.owner == self) &&
+        vtcm_arena.top + size <= vtcm_arena.size) {
+      void* ptr = vtcm_arena.base + vtcm_arena.top;
+      vtcm_arena.top += size;
+      vtcm_arena.owner = self;
+      ++vtcm_arena.depth;
+      return ptr;
+    }
+  }
+  FARF(HIGH, "%s: VTCM not available, allocating %u bytes in DDR", __func__, nbytes);
+  return memalign(align, size);
+}
+
+/*!
+ *  \brief Free VTCM memory allocated by TVMBackendAllocVTCM.
+ *
+ *  \param ptr  The memory to free, the last live VTCM allocation of the thread or DDR memory.
+ *
+ *  \return 0 on success.
+ */
+extern "C" int TVMBackendFreeVTCM(void* ptr) {
+  char* p = static_cast<char*>(ptr);
+  {
+    std::lock_guard<std::mutex> lock(vtcm_arena_mutex);
+    if (vtcm_arena.base != nullptr && p >= vtcm_arena.base &&
+        p < vtcm_arena.base + vtcm_arena.size) {
+      vtcm_arena.top = static_cast<unsigned>(p - vtcm_arena.base);
+      --vtcm_arena.depth;
+      return AEE_SUCCESS;
+    }
+  }
+  free(ptr);
+  return AEE_SUCCESS;
+}
+
+/*!
+ *  \brief Copy a 2D region, e.g. a tile between DDR and VTCM.
+ *
+ *  \param dst         The destination.
+ *  \param src         The source.
+ *  \param width       The number of bytes of a row.
+ *  \param height      The number of rows.
+ *  \param dst_stride  The distance in bytes between two rows of the destination.
+ *  \param src_stride  The distance in bytes between two rows of the source.
+ *
+ *  \return 0 on success.
+ */
+extern "C" int TVMBackendHexagonDMACopy2D(void* dst, const void* src, unsigned width,
+                                          unsigned height, unsigned dst_stride,
+                                          unsigned src_stride) {
+  char* d = static_cast<char*>(dst);
+  const char* s = static_cast<const char*>(src);
+  for (unsigned i = 0; i < height; ++i) {
+    memcpy(d + i * dst_stride, s + i * src_stride, width);
+  }
+  return AEE_SUCCESS;
+}
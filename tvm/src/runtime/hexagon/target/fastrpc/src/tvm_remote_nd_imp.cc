@@ -21,6 +21,7 @@
 #include <dlfcn.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <vector>
 
@@ -111,6 +112,31 @@ __attribute__((naked)) uint32_t launcher(volatile msg_call* mc, uint64_t* pcc) {
       "{ dealloc_return           } // implicit-use r1:0              \n");
 }
 
+/*!
+ *  \brief Run a batch of kernel launches.
+ *
+ *  \param records    The msg_call records of the launches, one after the other.
+ *  \param num_calls  The number of records.
+ *
+ *  \return 0 on success, or the first non-zero result of a launch.
+ *
+ * The host calls this function through tvm_remote_nd_kernel like any
+ * kernel, so that the FastRPC round trip is paid once for the whole batch.
+ * See CallBatch in hexagon_module.cc.
+ */
+extern "C" int tvm_hexagon_run_batch(const uint32_t* records, int num_calls) {
+  uint64_t pcycles = 0;
+  for (int i = 0; i != num_calls; ++i) {
+    auto* mc = reinterpret_cast<volatile msg_call*>(const_cast<uint32_t*>(records));
+    if (int result = launcher(mc, &pcycles)) {
+      FARF(ERROR, "%s: launch %d of %d failed: %d", __func__, i, num_calls, result);
+      return result;
+    }
+    records += 3 + mc->scalar_num + mc->stack_num;
+  }
+  return AEE_SUCCESS;
+}
+
 extern "C" {
 #pragma weak __wrap_pthread_create
 int __wrap_pthread_create(pthread_t* restrict thread, const pthread_attr_t* restrict attr,
@@ -207,6 +233,11 @@ int tvm_remote_nd_load_library(const char* soname, int soname_len,
 int tvm_remote_nd_get_symbol(tvm_remote_nd_handle_t lib, const char* name, int name_len,
                              tvm_remote_nd_handle_t* sym_ptr) {
   FARF(ALWAYS, "%s: name=%s", __func__, name);
+  // The batch runner lives in this library rather than in the loaded one.
+  if (strcmp(name, "tvm_hexagon_run_batch") == 0) {
+    *sym_ptr = reinterpret_cast<tvm_remote_nd_handle_t>(&tvm_hexagon_run_batch);
+    return AEE_SUCCESS;
+  }
   if (void* p = dlsym(reinterpret_cast<void*>(lib), name)) {
     *sym_ptr = reinterpret_cast<tvm_remote_nd_handle_t>(p);
     return AEE_SUCCESS;
@@ -463,10 +463,8 @@ void HexagonTarget::Call(void* func, uint32_t* scalar, unsigned scalar_num, uint
   auto stack_octet = std::unique_ptr<tvm_remote_buffer[]>(new tvm_remote_buffer[stack_num]);
   TVM_LOGD_HT("scalars=%p, stack=%p", scalar, stack);
 
-  if (scalar_octet == nullptr || stack_octet == nullptr) {
-    TVM_LOGE_HT("mem alloc failed for scalar/stack octets");
-    return;
-  }
+  ICHECK(scalar_octet != nullptr && stack_octet != nullptr)
+      << "mem alloc failed for scalar/stack octets";
   std::memset(scalar_octet.get(), 0, scalar_num * sizeof(tvm_remote_buffer));
   std::memset(stack_octet.get(), 0, stack_num * sizeof(tvm_remote_buffer));
 
@@ -506,12 +504,10 @@ void HexagonTarget::Call(void* func, uint32_t* scalar, unsigned scalar_num, uint
       scalar_octet.get(), scalar_num, scalar_octet.get(), scalar_num, stack_octet.get(), stack_num,
       stack_octet.get(), stack_num, &pcycles, &execution_time_usec);
 
-  if (rc != AEE_SUCCESS) {
-    TVM_LOGE_HT("failed to run kernel on CDSP rc=0x%x", rc);
-  } else {
-    TVM_LOGD_HT("kernel execution: %llu pcycles, %llu usec, scalar_num=%d", pcycles,
-                execution_time_usec, scalar_num);
-  }
+  // The result of the kernel, or of the first failed launch of a batch, is returned as rc.
+  ICHECK_EQ(rc, AEE_SUCCESS) << "failed to run kernel on CDSP rc=0x" << std::hex << rc;
+  TVM_LOGD_HT("kernel execution: %llu pcycles, %llu usec, scalar_num=%d", pcycles,
+              execution_time_usec, scalar_num);
 }
 
 }  // namespace hexagon
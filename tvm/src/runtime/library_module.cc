@@ -27,6 +27,7 @@
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/registry.h>
 
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -56,6 +57,8 @@ class LibraryModuleNode final : public ModuleNode {
     return WrapPackedFunc(faddr, sptr_to_self);
   }
 
+  void* GetSymbol(const std::string& name) const { return lib_->GetSymbol(name.c_str()); }
+
  private:
   ObjectPtr<Library> lib_;
 };
@@ -82,6 +85,19 @@ PackedFunc WrapPackedFunc(TVMBackendPackedCFunc faddr, const ObjectPtr<Object>&
   });
 }
 
+TVMBackendPackedCFunc GetLibraryPackedCFunc(const Module& mod, const std::string& name) {
+  if (!std::strcmp(mod->type_key(), "library")) {
+    const auto* lib_mod = static_cast<const LibraryModuleNode*>(mod.operator->());
+    if (void* faddr = lib_mod->GetSymbol(name)) {
+      return reinterpret_cast<TVMBackendPackedCFunc>(faddr);
+    }
+  }
+  for (const Module& import : mod->imports()) {
+    if (TVMBackendPackedCFunc faddr = GetLibraryPackedCFunc(import, name)) return faddr;
+  }
+  return nullptr;
+}
+
 void InitContextFunctions(std::function<void*(const char*)> fgetsymbol) {
 #define TVM_INIT_CONTEXT_FUNC(FuncName)                                                \
   if (auto* fp = reinterpret_cast<decltype(&FuncName)*>(fgetsymbol("__" #FuncName))) { \
@@ -29,6 +29,7 @@
 #include <tvm/runtime/module.h>
 
 #include <functional>
+#include <string>
 
 namespace tvm {
 namespace runtime {
@@ -60,6 +61,16 @@ class Library : public Object {
  */
 PackedFunc WrapPackedFunc(TVMBackendPackedCFunc faddr, const ObjectPtr<Object>& mptr);
 
+/*!
+ * \brief Look up the raw address of a packed function in the library modules of a module and
+ *  its imports, so that hot callers can invoke it without going through a PackedFunc.
+ * \param mod The module.
+ * \param name The symbol of the function.
+ * \return The function, nullptr when no library module contains it.
+ * \note The module must be kept alive while the function is used.
+ */
+TVMBackendPackedCFunc GetLibraryPackedCFunc(const Module& mod, const std::string& name);
+
 /*!
  * \brief Utility to initialize conext function symbols during startup
  * \param fgetsymbol A symbol lookup function.
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file memory_stats.cc
+ * \brief Accounting of the memory held by the runtime.
+ */
+#include "memory_stats.h"
+
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace tvm {
+namespace runtime {
+
+MemoryStats* MemoryStats::Global() {
+  // Never destroyed, the pools of other static and thread local objects free into it at exit
+  static MemoryStats* inst = [] {
+    MemoryStats* stats = new MemoryStats();
+    const char* val = getenv("TVM_MEMORY_STATS");
+    stats->SetEnabled(val != nullptr && atoi(val) != 0);
+    return stats;
+  }();
+  return inst;
+}
+
+void MemoryStats::SetEnabled(bool enabled) { enabled_.store(enabled); }
+
+void MemoryStats::Alloc(TVMContext ctx, MemoryKind kind, const void* ptr, size_t nbytes) {
+  if (ptr == nullptr || !enabled_.load(std::memory_order_relaxed)) return;
+  int k = static_cast<int>(kind);
+  std::lock_guard<std::mutex> lock(mutex_);
+  recorded_.store(true, std::memory_order_relaxed);
+  DeviceStats& stats = devices_[{static_cast<int>(ctx.device_type), ctx.device_id}];
+  if (!stats.live[k].emplace(ptr, nbytes).second) return;
+  Counter& counter = stats.counters[k];
+  counter.current += nbytes;
+  counter.peak = std::max(counter.peak, counter.current);
+  ++counter.num_allocs;
+  ++counter.num_live;
+}
+
+void MemoryStats::Free(TVMContext ctx, MemoryKind kind, const void* ptr) {
+  if (!recorded_.load(std::memory_order_relaxed)) return;
+  int k = static_cast<int>(kind);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto dit = devices_.find({static_cast<int>(ctx.device_type), ctx.device_id});
+  if (dit == devices_.end()) return;
+  auto it = dit->second.live[k].find(ptr);
+  if (it == dit->second.live[k].end()) return;
+  Counter& counter = dit->second.counters[k];
+  counter.current -= it->second;
+  --counter.num_live;
+  dit->second.live[k].erase(it);
+}
+
+MemoryStats::Counter MemoryStats::Get(TVMContext ctx, MemoryKind kind) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = devices_.find({static_cast<int>(ctx.device_type), ctx.device_id});
+  if (it == devices_.end()) return Counter();
+  return it->second.counters[static_cast<int>(kind)];
+}
+
+void MemoryStats::ResetPeak(TVMContext ctx) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = devices_.find({static_cast<int>(ctx.device_type), ctx.device_id});
+  if (it == devices_.end()) return;
+  for (Counter& counter : it->second.counters) {
+    counter.peak = counter.current;
+  }
+}
+
+// Read a counter (current, peak, num_allocs or num_live) of a memory kind (global, texture,
+// workspace, texture_pool or vm_allocator) on a device.
+TVM_REGISTER_GLOBAL("runtime.MemoryStat")
+    .set_body_typed([](int device_type, int device_id, String kind, String counter) {
+      TVMContext ctx;
+      ctx.device_type = static_cast<DLDeviceType>(device_type);
+      ctx.device_id = device_id;
+      int k = 0;
+      for (; k < kNumMemoryKinds; ++k) {
+        if (kind == MemoryKindName(static_cast<MemoryKind>(k))) break;
+      }
+      ICHECK_LT(k, kNumMemoryKinds) << "Unknown memory kind " << kind;
+      MemoryStats::Counter stats = MemoryStats::Global()->Get(ctx, static_cast<MemoryKind>(k));
+      size_t value = 0;
+      if (counter == "current") {
+        value = stats.current;
+      } else if (counter == "peak") {
+        value = stats.peak;
+      } else if (counter == "num_allocs") {
+        value = stats.num_allocs;
+      } else if (counter == "num_live") {
+        value = stats.num_live;
+      } else {
+        LOG(FATAL) << "Unknown memory counter " << counter;
+      }
+      return static_cast<int64_t>(value);
+    });
+
+TVM_REGISTER_GLOBAL("runtime.MemoryStatEnable").set_body_typed([](bool enabled) {
+  MemoryStats::Global()->SetEnabled(enabled);
+});
+
+TVM_REGISTER_GLOBAL("runtime.MemoryStatResetPeak")
+    .set_body_typed([](int device_type, int device_id) {
+      TVMContext ctx;
+      ctx.device_type = static_cast<DLDeviceType>(device_type);
+      ctx.device_id = device_id;
+      MemoryStats::Global()->ResetPeak(ctx);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file memory_stats.h
+ * \brief Accounting of the memory held by the runtime, per device and per allocator.
+ */
+#ifndef TVM_RUNTIME_MEMORY_STATS_H_
+#define TVM_RUNTIME_MEMORY_STATS_H_
+
+#include <tvm/runtime/device_api.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief The allocators which account for their memory.
+ *
+ *  The device APIs record their data spaces as kGlobal or kTexture. The pools record the
+ *  blocks they hold from the device API under their own kind, a block held by a pool is
+ *  thus also counted by the device API kind of its memory.
+ */
+enum class MemoryKind : int {
+  /*! \brief Buffers allocated by a device API */
+  kGlobal = 0,
+  /*! \brief Textures allocated by a device API */
+  kTexture = 1,
+  /*! \brief Pages held by the workspace pools */
+  kWorkspace = 2,
+  /*! \brief Textures held by the texture pools */
+  kTexturePool = 3,
+  /*! \brief Buffers held by the VM allocators */
+  kVMAllocator = 4,
+};
+
+/*! \brief The number of memory kinds. */
+constexpr int kNumMemoryKinds = 5;
+
+/*!
+ * \brief The name of a memory kind, as used by the runtime.MemoryStat registry function.
+ * \param kind The memory kind.
+ */
+inline const char* MemoryKindName(MemoryKind kind) {
+  switch (kind) {
+    case MemoryKind::kGlobal:
+      return "global";
+    case MemoryKind::kTexture:
+      return "texture";
+    case MemoryKind::kWorkspace:
+      return "workspace";
+    case MemoryKind::kTexturePool:
+      return "texture_pool";
+    case MemoryKind::kVMAllocator:
+      return "vm_allocator";
+  }
+  return "unknown";
+}
+
+/*!
+ * \brief The memory counters of the runtime, shared by all the threads.
+ *
+ *  The accounting is off unless TVM_MEMORY_STATS is set or it is enabled with
+ *  runtime.MemoryStatEnable, the allocations then only pay for a relaxed load.
+ */
+class TVM_DLL MemoryStats {
+ public:
+  /*! \brief The counters of one memory kind on one device. */
+  struct Counter {
+    /*! \brief Bytes currently held */
+    size_t current{0};
+    /*! \brief Highest current value since the last reset */
+    size_t peak{0};
+    /*! \brief Allocations recorded since the start */
+    size_t num_allocs{0};
+    /*! \brief Allocations not freed yet */
+    size_t num_live{0};
+  };
+  /*! \brief The process wide accounting. */
+  static MemoryStats* Global();
+  /*!
+   * \brief Start or stop recording the allocations. The allocations recorded so far are still
+   *  accounted for when they are freed.
+   * \param enabled Whether the allocations are recorded.
+   */
+  void SetEnabled(bool enabled);
+  /*! \brief Whether the allocations are recorded. */
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  /*!
+   * \brief Record an allocation.
+   * \param ctx The device of the memory.
+   * \param kind The allocator of the memory.
+   * \param ptr The allocated handle, the key of the matching Free.
+   * \param nbytes The size of the allocation.
+   */
+  void Alloc(TVMContext ctx, MemoryKind kind, const void* ptr, size_t nbytes);
+  /*!
+   * \brief Record the release of an allocation, a handle which was not recorded is ignored.
+   * \param ctx The device of the memory.
+   * \param kind The allocator of the memory.
+   * \param ptr The released handle.
+   */
+  void Free(TVMContext ctx, MemoryKind kind, const void* ptr);
+  /*!
+   * \brief Get the counters of a memory kind on a device.
+   * \param ctx The device.
+   * \param kind The memory kind.
+   */
+  Counter Get(TVMContext ctx, MemoryKind kind) const;
+  /*!
+   * \brief Reset the peaks of a device to the bytes currently held.
+   * \param ctx The device.
+   */
+  void ResetPeak(TVMContext ctx);
+
+ private:
+  /*! \brief The accounting of one device. */
+  struct DeviceStats {
+    Counter counters[kNumMemoryKinds];
+    std::unordered_map<const void*, size_t> live[kNumMemoryKinds];
+  };
+  /*! \brief Whether the allocations are recorded */
+  std::atomic<bool> enabled_{false};
+  /*! \brief Whether any allocation was recorded, the frees are ignored until then */
+  std::atomic<bool> recorded_{false};
+  mutable std::mutex mutex_;
+  std::map<std::pair<int, int>, DeviceStats> devices_;
+};
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_RUNTIME_MEMORY_STATS_H_
@@ -28,6 +28,7 @@
 #import <Metal/MTLBuffer.h>
 #import <Metal/MTLCommandBuffer.h>
 #import <Metal/MTLCommandQueue.h>
+#import <Metal/MTLComputeCommandEncoder.h>
 #import <Metal/MTLDevice.h>
 #import <Metal/MTLLibrary.h>
 #include <tvm/runtime/c_runtime_api.h>
@@ -35,9 +36,11 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/support/logging.h>
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "../workspace_pool.h"
@@ -45,6 +48,23 @@
 namespace tvm {
 namespace runtime {
 namespace metal {
+/*!
+ * \brief The launches on a device, encoded into one command buffer until a flush.
+ *
+ *  The launches share one concurrent compute encoder, with memory barriers only before the
+ *  dispatches that use a buffer of the dispatches since the last barrier.
+ */
+struct MetalStream {
+  /*! \brief The pending command buffer, nil when there is none. */
+  id<MTLCommandBuffer> cb{nil};
+  /*! \brief The open compute encoder of cb, nil when a blit ended it. */
+  id<MTLComputeCommandEncoder> encoder{nil};
+  /*! \brief The buffers used by the dispatches since the last barrier. */
+  std::unordered_set<const void*> used;
+  /*! \brief The number of dispatches encoded into cb. */
+  int num_dispatch{0};
+};
+
 /*!
  * \brief Process global Metal workspace.
  */
@@ -60,6 +80,8 @@ class MetalWorkspace final : public DeviceAPI {
   bool initialized_{false};
   // the mutex for initialization
   std::mutex mutex;
+  // Whether launches are batched into a pending command buffer, set by TVM_METAL_BATCH_LAUNCHES.
+  bool batch_launches{false};
   // Destructor
   ~MetalWorkspace();
   // Get command queue for given context.
@@ -87,6 +109,21 @@ class MetalWorkspace final : public DeviceAPI {
   void StreamSync(TVMContext ctx, TVMStreamHandle stream) final;
   void* AllocWorkspace(TVMContext ctx, size_t size, DLDataType type_hint) final;
   void FreeWorkspace(TVMContext ctx, void* data) final;
+  /*!
+   * \brief Encode a dispatch. When batching, the dispatch goes into the pending command buffer
+   *  of the device, shared by all the threads so that launches stay in their issue order.
+   * \param ctx The context.
+   * \param buffers The MTLBuffer handles used by the dispatch.
+   * \param num_buffers The number of buffers.
+   * \param encode Encodes the dispatch, called with the pending lock held.
+   */
+  void Launch(TVMContext ctx, const TVMValue* buffers, size_t num_buffers,
+              const std::function<void(id<MTLComputeCommandEncoder>)>& encode);
+  /*!
+   * \brief Commit the pending command buffer of ctx, if any.
+   * \param ctx The context.
+   */
+  void Flush(TVMContext ctx);
   // get the global workspace
   static MetalWorkspace* Global();
 
@@ -94,6 +131,16 @@ class MetalWorkspace final : public DeviceAPI {
   void CopyDataFromTo(const void* from, size_t from_size, void* to, size_t to_size, size_t size,
                       TVMContext ctx_from, TVMContext ctx_to, DLDataType type_hint,
                       TVMStreamHandle stream) final;
+
+ private:
+  // The pending stream of ctx, with pending_mu_ held.
+  MetalStream* GetPendingStream(TVMContext ctx);
+  // Commit the pending stream of ctx, with pending_mu_ held.
+  void FlushLocked(TVMContext ctx);
+  // The pending launches of each device
+  std::vector<MetalStream> pending_;
+  // Guards pending_, launches from any thread are encoded into the same command buffer
+  std::mutex pending_mu_;
 };
 
 /*! \brief Thread local workspace */
@@ -23,6 +23,9 @@
  */
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/registry.h>
+
+#include <cstdlib>
+
 #include "metal_common.h"
 
 namespace tvm {
@@ -123,6 +126,8 @@ void MetalWorkspace::Init() {
   std::lock_guard<std::mutex> lock(this->mutex);
   if (initialized_) return;
   initialized_ = true;
+  const char* batch = getenv("TVM_METAL_BATCH_LAUNCHES");
+  batch_launches = batch != nullptr && atoi(batch) != 0;
   if (devices.size() != 0) return;
 #if TARGET_OS_IPHONE
   // on iPhone
@@ -163,7 +168,22 @@ void* MetalWorkspace::AllocDataSpace(TVMContext ctx, size_t nbytes, size_t align
   return (void*)(CFBridgingRetain(buf));
 }
 
+/*! \brief The dispatches after which a pending command buffer is committed, so that the
+ *  GPU starts on large graphs while the following launches are encoded. */
+static constexpr int kMetalMaxBatchedDispatch = 256;
+
+static void EndCompute(MetalStream* s) {
+  if (s->encoder != nil) {
+    [s->encoder endEncoding];
+    [s->encoder release];
+    s->encoder = nil;
+  }
+  s->used.clear();
+}
+
 void MetalWorkspace::FreeDataSpace(TVMContext ctx, void* ptr) {
+  // The pending launches may still use the buffer
+  Flush(ctx);
   // MTLBuffer PurgeableState should be set to empty before manual
   // release in order to prevent memory leak
   [(id<MTLBuffer>)ptr setPurgeableState:MTLPurgeableStateEmpty];
@@ -179,21 +199,39 @@ void MetalWorkspace::CopyDataFromTo(const void* from, size_t from_offset, void*
   ICHECK(stream == nullptr);
   TVMContext ctx = ctx_from;
   if (ctx_from.device_type == kDLCPU) ctx = ctx_to;
-  id<MTLCommandQueue> queue = GetCommandQueue(ctx);
-  id<MTLCommandBuffer> cb = [queue commandBuffer];
   int from_dev_type = static_cast<int>(ctx_from.device_type);
   int to_dev_type = static_cast<int>(ctx_to.device_type);
 
   if (from_dev_type == kDLMetal && to_dev_type == kDLMetal) {
     ICHECK_EQ(ctx_from.device_id, ctx_to.device_id) << "Metal disallow cross device copy.";
+    std::unique_lock<std::mutex> lock(pending_mu_, std::defer_lock);
+    id<MTLCommandBuffer> cb = nil;
+    if (batch_launches) {
+      // Device copies stay in the pending command buffer, ordered by the hazard tracking of Metal
+      lock.lock();
+      MetalStream* s = GetPendingStream(ctx);
+      EndCompute(s);
+      if (s->cb == nil) {
+        s->cb = [[GetCommandQueue(ctx) commandBuffer] retain];
+      }
+      cb = s->cb;
+    } else {
+      cb = [GetCommandQueue(ctx) commandBuffer];
+    }
     id<MTLBlitCommandEncoder> encoder = [cb blitCommandEncoder];
     [encoder copyFromBuffer:(__bridge id<MTLBuffer>)(from)
                sourceOffset:from_offset
                    toBuffer:(__bridge id<MTLBuffer>)(to)destinationOffset:to_offset
                        size:size];
     [encoder endEncoding];
-    [cb commit];
-  } else if (from_dev_type == kDLMetal && to_dev_type == kDLCPU) {
+    if (!batch_launches) [cb commit];
+    return;
+  }
+  // The host copies wait for a command buffer after the pending one
+  Flush(ctx);
+  id<MTLCommandQueue> queue = GetCommandQueue(ctx);
+  id<MTLCommandBuffer> cb = [queue commandBuffer];
+  if (from_dev_type == kDLMetal && to_dev_type == kDLCPU) {
     // copy to a local buffer before get into global buffer.
     id<MTLBuffer> from_buf = (__bridge id<MTLBuffer>)(from);
     if (from_buf.storageMode != MTLStorageModeShared) {
@@ -238,6 +276,7 @@ void MetalWorkspace::CopyDataFromTo(const void* from, size_t from_offset, void*
 
 void MetalWorkspace::StreamSync(TVMContext ctx, TVMStreamHandle stream) {
   ICHECK(stream == nullptr);
+  Flush(ctx);
   // commit an empty command buffer and wait until it completes.
   id<MTLCommandQueue> queue = GetCommandQueue(ctx);
   id<MTLCommandBuffer> cb = [queue commandBuffer];
@@ -277,6 +316,72 @@ id<MTLBuffer> MetalThreadEntry::GetTempBuffer(TVMContext ctx, size_t size) {
   return temp_buffer_[ctx.device_id];
 }
 
+MetalStream* MetalWorkspace::GetPendingStream(TVMContext ctx) {
+  if (pending_.size() <= static_cast<size_t>(ctx.device_id)) {
+    pending_.resize(ctx.device_id + 1);
+  }
+  return &pending_[ctx.device_id];
+}
+
+void MetalWorkspace::Launch(TVMContext ctx, const TVMValue* buffers, size_t num_buffers,
+                            const std::function<void(id<MTLComputeCommandEncoder>)>& encode) {
+  if (!batch_launches) {
+    id<MTLCommandBuffer> cb = [GetCommandQueue(ctx) commandBuffer];
+    id<MTLComputeCommandEncoder> encoder = [cb computeCommandEncoder];
+    encode(encoder);
+    [encoder endEncoding];
+    [cb commit];
+    return;
+  }
+  std::lock_guard<std::mutex> lock(pending_mu_);
+  MetalStream* s = GetPendingStream(ctx);
+  if (s->num_dispatch >= kMetalMaxBatchedDispatch) FlushLocked(ctx);
+  if (s->cb == nil) {
+    s->cb = [[GetCommandQueue(ctx) commandBuffer] retain];
+  }
+  if (s->encoder == nil) {
+    if (@available(macOS 10.14, iOS 12.0, *)) {
+      s->encoder =
+          [[s->cb computeCommandEncoderWithDispatchType:MTLDispatchTypeConcurrent] retain];
+    } else {
+      // The dispatches of a serial encoder need no barriers
+      s->encoder = [[s->cb computeCommandEncoder] retain];
+    }
+  }
+  bool dependent = false;
+  for (size_t i = 0; i < num_buffers && !dependent; ++i) {
+    dependent = s->used.count(buffers[i].v_handle) != 0;
+  }
+  if (dependent) {
+    if (@available(macOS 10.14, iOS 12.0, *)) {
+      [s->encoder memoryBarrierWithScope:MTLBarrierScopeBuffers];
+    }
+    s->used.clear();
+  }
+  for (size_t i = 0; i < num_buffers; ++i) {
+    s->used.insert(buffers[i].v_handle);
+  }
+  ++s->num_dispatch;
+  encode(s->encoder);
+}
+
+void MetalWorkspace::Flush(TVMContext ctx) {
+  if (!batch_launches) return;
+  std::lock_guard<std::mutex> lock(pending_mu_);
+  FlushLocked(ctx);
+}
+
+void MetalWorkspace::FlushLocked(TVMContext ctx) {
+  MetalStream* s = GetPendingStream(ctx);
+  EndCompute(s);
+  if (s->cb != nil) {
+    [s->cb commit];
+    [s->cb release];
+    s->cb = nil;
+  }
+  s->num_dispatch = 0;
+}
+
 typedef dmlc::ThreadLocalStore<MetalThreadEntry> MetalThreadStore;
 
 MetalThreadEntry* MetalThreadEntry::ThreadLocal() { return MetalThreadStore::Get(); }
@@ -199,25 +199,26 @@ class MetalWrappedFunc {
       scache_[device_id] = m_->GetPipelineState(device_id, func_name_);
     }
     ThreadWorkLoad wl = thread_axis_cfg_.Extract(args);
-    id<MTLCommandQueue> queue = w_->GetCommandQueue(t->context);
-    id<MTLCommandBuffer> cb = [queue commandBuffer];
-    id<MTLComputeCommandEncoder> encoder = [cb computeCommandEncoder];
-    [encoder setComputePipelineState:scache_[device_id]];
-    for (size_t i = 0; i < num_buffer_args_; ++i) {
-      void* buf = args[static_cast<int>(i)];
-      [encoder setBuffer:(__bridge id<MTLBuffer>)(buf) offset:0 atIndex:i];
-    }
-    if (num_pack_args_ != 0) {
-      [encoder setBytes:pack_args
-                 length:num_pack_args_ * sizeof(ArgUnion64)
-                atIndex:num_buffer_args_];
-    }
-    // launch
-    MTLSize dimGrid = MTLSizeMake(wl.grid_dim(0), wl.grid_dim(1), wl.grid_dim(2));
-    MTLSize dimBlock = MTLSizeMake(wl.block_dim(0), wl.block_dim(1), wl.block_dim(2));
-    [encoder dispatchThreadgroups:dimGrid threadsPerThreadgroup:dimBlock];
-    [encoder endEncoding];
-    [cb commit];
+    id<MTLComputePipelineState> state = scache_[device_id];
+    // With TVM_METAL_BATCH_LAUNCHES the launch is batched until a copy or a sync
+    w_->Launch(t->context, args.values, num_buffer_args_,
+               [&](id<MTLComputeCommandEncoder> encoder) {
+                 [encoder setComputePipelineState:state];
+                 for (size_t i = 0; i < num_buffer_args_; ++i) {
+                   void* buf = args[static_cast<int>(i)];
+                   [encoder setBuffer:(__bridge id<MTLBuffer>)(buf) offset:0 atIndex:i];
+                 }
+                 if (num_pack_args_ != 0) {
+                   [encoder setBytes:pack_args
+                              length:num_pack_args_ * sizeof(ArgUnion64)
+                             atIndex:num_buffer_args_];
+                 }
+                 // launch
+                 MTLSize dimGrid = MTLSizeMake(wl.grid_dim(0), wl.grid_dim(1), wl.grid_dim(2));
+                 MTLSize dimBlock =
+                     MTLSizeMake(wl.block_dim(0), wl.block_dim(1), wl.block_dim(2));
+                 [encoder dispatchThreadgroups:dimGrid threadsPerThreadgroup:dimBlock];
+               });
   }
 
  private:
@@ -112,7 +112,12 @@ class MicroTransportChannel : public RPCChannel {
         message_buffer_{nullptr} {}
 
  private:
-  static constexpr const size_t kReceiveBufferSizeBytes = 128;
+  /*!
+   * \brief The most bytes requested from frecv_ at once. Every call goes through the transport,
+   *  so this is large enough to read a whole burst of a fast link in one call; the unframer keeps
+   *  the bytes past the end of a message in pending_chunk_.
+   */
+  static constexpr const size_t kReceiveBufferSizeBytes = 4096;
 
   /*
    * \brief Receive data until either pf() returns true or a timeout occurs.
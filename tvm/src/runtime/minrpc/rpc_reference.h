@@ -28,7 +28,7 @@ namespace tvm {
 namespace runtime {
 
 /*! \brief The current RPC procotol version. */
-constexpr const char* kRPCProtocolVer = "0.8.0";
+constexpr const char* kRPCProtocolVer = "0.8.1";
 
 /*! \brief The RPC code */
 enum class RPCCode : int {
@@ -52,6 +52,7 @@ enum class RPCCode : int {
   kDevStreamSync,
   kCopyAmongRemote,
   kDevAllocDataWithScope,
+  kDevHashData,
 };
 
 /*!
@@ -110,6 +111,8 @@ inline const char* RPCCodeToString(RPCCode code) {
       return "kCopyAmongRemote";
     case RPCCode::kDevAllocDataWithScope:
       return "kDevAllocDataWithScope";
+    case RPCCode::kDevHashData:
+      return "kDevHashData";
     default:
       return "";
   }
@@ -123,7 +123,10 @@ struct NDArray::Internal {
   }
   // Local create function which allocates tensor metadata
   // but does not allocate space for the data.
-  static NDArray Create(std::vector<int64_t> shape, DLDataType dtype, DLContext ctx) {
+  static NDArray Create(const std::vector<int64_t>& shape, DLDataType dtype, DLContext ctx) {
+    return Create(shape.data(), static_cast<int>(shape.size()), dtype, ctx);
+  }
+  static NDArray Create(const int64_t* shape, int ndim, DLDataType dtype, DLContext ctx) {
     VerifyDataType(dtype);
 
     // critical zone: construct header
@@ -133,9 +136,7 @@ struct NDArray::Internal {
     // RAII now in effect
     NDArray ret(GetObjectPtr<Object>(data));
     // setup shape
-    data->shape_ = std::move(shape);
-    data->dl_tensor.shape = dmlc::BeginPtr(data->shape_);
-    data->dl_tensor.ndim = static_cast<int>(data->shape_.size());
+    data->SetShape(shape, ndim);
     // setup dtype
     data->dl_tensor.dtype = dtype;
     // setup ctx
@@ -206,9 +207,7 @@ NDArray NDArray::FromDLPack(DLManagedTensor* tensor) {
   data->manager_ctx = tensor;
   data->dl_tensor = tensor->dl_tensor;
   // update shape_
-  data->shape_.resize(data->dl_tensor.ndim);
-  data->shape_.assign(data->dl_tensor.shape, data->dl_tensor.shape + data->dl_tensor.ndim);
-  data->dl_tensor.shape = data->shape_.data();
+  data->SetShape(tensor->dl_tensor.shape, tensor->dl_tensor.ndim);
   return NDArray(GetObjectPtr<Object>(data));
 }
 
@@ -241,7 +240,10 @@ void NDArray::CopyFromTo(const DLTensor* from, DLTensor* to, TVMStreamHandle str
   DeviceAPI::Get(ctx)->CopyDataFromTo(const_cast<DLTensor*>(from), to, stream);
 }
 
-std::vector<int64_t> NDArray::Shape() const { return get_mutable()->shape_; }
+std::vector<int64_t> NDArray::Shape() const {
+  const DLTensor& t = get_mutable()->dl_tensor;
+  return std::vector<int64_t>(t.shape, t.shape + t.ndim);
+}
 runtime::DataType NDArray::DataType() const {
   return runtime::DataType(get_mutable()->dl_tensor.dtype);
 }
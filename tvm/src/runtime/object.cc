@@ -20,10 +20,12 @@
  * \file src/runtime/object.cc
  * \brief Object type management system.
  */
+#include <tvm/runtime/memory.h>
 #include <tvm/runtime/object.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/support/logging.h>
 
+#include <cstddef>
 #include <iostream>
 #include <mutex>
 #include <string>
@@ -217,6 +219,76 @@ uint32_t Object::TypeKey2Index(const std::string& key) {
   return TypeContext::Global()->TypeKey2Index(key);
 }
 
+/*! \brief The free lists of the ObjectPool of one thread, it only exists within a scope. */
+class ObjectPoolThreadLocalEntry {
+ public:
+  ~ObjectPoolThreadLocalEntry() {
+    for (auto& free_list : free_lists) {
+      for (void* ptr : free_list) ::operator delete(ptr);
+    }
+  }
+
+  /*!
+   * \brief The entry of the current thread, nullptr outside of a scope.
+   * \note A plain pointer, which has no destructor, so that objects freed while the thread
+   *  local variables are destroyed do not touch a destroyed entry.
+   */
+  static thread_local ObjectPoolThreadLocalEntry* current;
+
+  // The size classes are multiples of the alignment of operator new
+  static constexpr size_t kGranularity = alignof(std::max_align_t);
+  static constexpr size_t kNumSizeClasses = ObjectPool::kMaxObjectSize / kGranularity;
+  // Cap of the cached blocks of one size class
+  static constexpr size_t kMaxFreeBlocks = 1 << 16;
+
+  static size_t SizeClass(size_t size) { return (size - 1) / kGranularity; }
+
+  int depth{0};
+  std::vector<void*> free_lists[kNumSizeClasses];
+};
+
+thread_local ObjectPoolThreadLocalEntry* ObjectPoolThreadLocalEntry::current = nullptr;
+
+void* ObjectPool::Allocate(size_t size) {
+  using Entry = ObjectPoolThreadLocalEntry;
+  size_t cls = Entry::SizeClass(size);
+  Entry* entry = Entry::current;
+  if (entry != nullptr && !entry->free_lists[cls].empty()) {
+    void* ptr = entry->free_lists[cls].back();
+    entry->free_lists[cls].pop_back();
+    return ptr;
+  }
+  return ::operator new((cls + 1) * Entry::kGranularity);
+}
+
+void ObjectPool::Free(void* ptr, size_t size) {
+  using Entry = ObjectPoolThreadLocalEntry;
+  size_t cls = Entry::SizeClass(size);
+  Entry* entry = Entry::current;
+  if (entry != nullptr && entry->free_lists[cls].size() < Entry::kMaxFreeBlocks) {
+    entry->free_lists[cls].push_back(ptr);
+  } else {
+    ::operator delete(ptr);
+  }
+}
+
+void ObjectPool::EnterScope() {
+  auto*& entry = ObjectPoolThreadLocalEntry::current;
+  if (entry == nullptr) entry = new ObjectPoolThreadLocalEntry();
+  ++entry->depth;
+}
+
+void ObjectPool::ExitScope() {
+  auto*& entry = ObjectPoolThreadLocalEntry::current;
+  ICHECK(entry != nullptr) << "ObjectPool::ExitScope without a matching EnterScope";
+  if (--entry->depth == 0) {
+    // Reset first, the blocks are freed without caching them again
+    ObjectPoolThreadLocalEntry* released = entry;
+    entry = nullptr;
+    delete released;
+  }
+}
+
 TVM_REGISTER_GLOBAL("runtime.ObjectPtrHash").set_body_typed([](ObjectRef obj) {
   return static_cast<int64_t>(ObjectPtrHash()(obj));
 });
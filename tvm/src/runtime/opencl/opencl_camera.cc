@@ -0,0 +1,325 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_camera.cc
+ * \brief Zero-copy camera input: Android graphic buffers imported as OpenCL buffers, and a
+ *  kernel converting their YUV 4:2:0 frames to the normalized RGB input of a model.
+ *
+ *  The conversion writes straight into the input of a graph runtime, a flat float32 tensor in
+ *  NCHW or NHWC layout or a texture of shape (1, 1, H, W, 4), so that a frame does not go
+ *  through the host before the model runs.
+ */
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "opencl_common.h"
+#include "opencl_module.h"
+
+/* The host pointers of cl_qcom_ext_host_ptr, cl_qcom_android_native_buffer_host_ptr and
+ * cl_qcom_android_ahardwarebuffer_host_ptr, for the headers which predate them.
+ */
+#ifndef CL_MEM_EXT_HOST_PTR_QCOM
+#define CL_MEM_EXT_HOST_PTR_QCOM (1 << 29)
+#define CL_MEM_HOST_UNCACHED_QCOM 0x40A4
+#define CL_MEM_HOST_WRITEBACK_QCOM 0x40A5
+typedef struct _cl_mem_ext_host_ptr {
+  cl_uint allocation_type;
+  cl_uint host_cache_policy;
+} cl_mem_ext_host_ptr;
+#endif
+#ifndef CL_MEM_ANDROID_NATIVE_BUFFER_HOST_PTR_QCOM
+#define CL_MEM_ANDROID_NATIVE_BUFFER_HOST_PTR_QCOM 0x40C6
+typedef struct _cl_mem_android_native_buffer_host_ptr {
+  cl_mem_ext_host_ptr ext_host_ptr;
+  void* anb_ptr;
+} cl_mem_android_native_buffer_host_ptr;
+#endif
+#ifndef CL_MEM_ANDROID_AHARDWAREBUFFER_HOST_PTR_QCOM
+#define CL_MEM_ANDROID_AHARDWAREBUFFER_HOST_PTR_QCOM 0x4119
+typedef struct _cl_mem_ahardwarebuffer_host_ptr {
+  cl_mem_ext_host_ptr ext_host_ptr;
+  void* ahb_ptr;
+} cl_mem_ahardwarebuffer_host_ptr;
+#endif
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief The work group size of the conversion, per dimension. */
+static constexpr int kCameraGroupSize = 16;
+
+// Sample the source pixel of an output pixel, nearest after the rotation and the scaling of
+// the frame to the output, and convert it to normalized RGB with the BT.601 full range
+// coefficients of the Android camera.
+static const char* kYUVHelperSource = R"CLC(
+inline float3 tvm_ocl_yuv_sample(__global const uchar* yuv, int src_w, int src_h, int y_offset,
+                                 int y_stride, int u_offset, int v_offset, int uv_stride,
+                                 int uv_pixel_stride, int rotation, int x, int y, int dst_w,
+                                 int dst_h, float3 scale, float3 bias) {
+  int rot_w = (rotation == 90 || rotation == 270) ? src_h : src_w;
+  int rot_h = (rotation == 90 || rotation == 270) ? src_w : src_h;
+  int u = min((int)((x + 0.5f) * rot_w / dst_w), rot_w - 1);
+  int v = min((int)((y + 0.5f) * rot_h / dst_h), rot_h - 1);
+  int sx = u, sy = v;
+  if (rotation == 90) {
+    sx = v;
+    sy = src_h - 1 - u;
+  } else if (rotation == 180) {
+    sx = src_w - 1 - u;
+    sy = src_h - 1 - v;
+  } else if (rotation == 270) {
+    sx = src_w - 1 - v;
+    sy = u;
+  }
+  float luma = yuv[y_offset + sy * y_stride + sx];
+  int uv = (sy >> 1) * uv_stride + (sx >> 1) * uv_pixel_stride;
+  float cb = (float)yuv[u_offset + uv] - 128.0f;
+  float cr = (float)yuv[v_offset + uv] - 128.0f;
+  float3 rgb = (float3)(luma + 1.402f * cr, luma - 0.344136f * cb - 0.714136f * cr,
+                        luma + 1.772f * cb);
+  return clamp(rgb, 0.0f, 255.0f) * scale + bias;
+}
+)CLC";
+
+static const char* kYUVToBufferSource = R"CLC(
+__kernel void tvm_ocl_yuv_to_rgb_buffer(__global const uchar* yuv, __global float* out,
+                                        int src_w, int src_h, int y_offset, int y_stride,
+                                        int u_offset, int v_offset, int uv_stride,
+                                        int uv_pixel_stride, int rotation, int dst_w, int dst_h,
+                                        int nhwc, float scale_r, float scale_g, float scale_b,
+                                        float bias_r, float bias_g, float bias_b) {
+  int x = get_global_id(0);
+  int y = get_global_id(1);
+  if (x >= dst_w || y >= dst_h) return;
+  float3 rgb = tvm_ocl_yuv_sample(yuv, src_w, src_h, y_offset, y_stride, u_offset, v_offset,
+                                  uv_stride, uv_pixel_stride, rotation, x, y, dst_w, dst_h,
+                                  (float3)(scale_r, scale_g, scale_b),
+                                  (float3)(bias_r, bias_g, bias_b));
+  if (nhwc) {
+    vstore3(rgb, y * dst_w + x, out);
+  } else {
+    size_t plane = (size_t)dst_w * dst_h;
+    size_t i = (size_t)y * dst_w + x;
+    out[i] = rgb.x;
+    out[plane + i] = rgb.y;
+    out[2 * plane + i] = rgb.z;
+  }
+}
+)CLC";
+
+static const char* kYUVToTextureSource = R"CLC(
+__kernel void tvm_ocl_yuv_to_rgb_texture(__global const uchar* yuv, __write_only image2d_t out,
+                                         int src_w, int src_h, int y_offset, int y_stride,
+                                         int u_offset, int v_offset, int uv_stride,
+                                         int uv_pixel_stride, int rotation, int dst_w, int dst_h,
+                                         int nhwc, float scale_r, float scale_g, float scale_b,
+                                         float bias_r, float bias_g, float bias_b) {
+  int x = get_global_id(0);
+  int y = get_global_id(1);
+  if (x >= dst_w || y >= dst_h) return;
+  float3 rgb = tvm_ocl_yuv_sample(yuv, src_w, src_h, y_offset, y_stride, u_offset, v_offset,
+                                  uv_stride, uv_pixel_stride, rotation, x, y, dst_w, dst_h,
+                                  (float3)(scale_r, scale_g, scale_b),
+                                  (float3)(bias_r, bias_g, bias_b));
+  write_imagef(out, (int2)(x, y), (float4)(rgb, 0.0f));
+}
+)CLC";
+
+/*! \brief The OpenCL module of the conversion kernels, built on first use. */
+static Module GetCameraModule() {
+  static Module mod = []() {
+    DLDataType handle{kTVMOpaqueHandle, 64, 1};
+    DLDataType f32{kDLFloat, 32, 1};
+    DLDataType i32{kDLInt, 32, 1};
+    std::vector<DLDataType> arg_types{handle, handle};
+    arg_types.insert(arg_types.end(), 12, i32);
+    arg_types.insert(arg_types.end(), 6, f32);
+    std::vector<std::string> tags{"blockIdx.x", "blockIdx.y", "threadIdx.x", "threadIdx.y"};
+    std::unordered_map<std::string, FunctionInfo> fmap;
+    std::string source;
+    for (const auto& kernel : {std::make_pair("tvm_ocl_yuv_to_rgb_buffer", kYUVToBufferSource),
+                               std::make_pair("tvm_ocl_yuv_to_rgb_texture", kYUVToTextureSource)}) {
+      fmap[kernel.first] = {kernel.first, arg_types, tags};
+      // The module builds every kernel as its own program from its delimited source
+      source += std::string("// Function: ") + kernel.first + "\n" + kYUVHelperSource +
+                kernel.second;
+    }
+    return OpenCLModuleCreate(source, "cl", fmap, source);
+  }();
+  return mod;
+}
+
+/*! \brief Release an imported buffer, the graphic buffer stays with its owner. */
+static void ImportedBufferDeleter(Object* obj) {
+  auto* ptr = static_cast<NDArray::Container*>(obj);
+  auto* mptr = static_cast<cl::OpenCLBuffer*>(ptr->dl_tensor.data);
+  cl::OpenCLWorkspace* w = cl::OpenCLWorkspace::Global();
+  // The memory object may still be read by the queue
+  OPENCL_CALL(clFinish(w->GetQueue(ptr->dl_tensor.ctx)));
+  OPENCL_CALL(clReleaseMemObject(mptr->buffer));
+  w->mem_free_epoch.fetch_add(1);
+  delete mptr;
+  delete ptr;
+}
+
+/*!
+ * \brief Import an Android graphic buffer as a flat OpenCL buffer without copying it.
+ *
+ *  The GPU reads the memory the camera writes, through the Qualcomm host pointer
+ *  extensions. The graphic buffer must outlive the array. Frames are recycled by the image
+ *  reader, importing each of its buffers once and keeping the arrays avoids an import per frame.
+ * \param device_id The OpenCL device.
+ * \param handle The AHardwareBuffer, or the ANativeWindowBuffer for the native kind.
+ * \param size The size of the buffer in bytes.
+ * \param kind "ahardwarebuffer" or "native_buffer".
+ * \return An uint8 array of the bytes of the buffer.
+ */
+NDArray OpenCLImportAndroidBuffer(int device_id, int64_t handle, int64_t size, String kind) {
+  cl::OpenCLWorkspace* w = cl::OpenCLWorkspace::Global();
+  w->Init();
+  ICHECK(w->context != nullptr) << "No OpenCL device";
+  ICHECK(device_id >= 0 && static_cast<size_t>(device_id) < w->devices.size())
+      << "Invalid OpenCL device " << device_id;
+  ICHECK(handle != 0 && size > 0) << "Invalid graphic buffer";
+  void* buffer = reinterpret_cast<void*>(static_cast<intptr_t>(handle));
+  std::string extensions = cl::GetDeviceInfo(w->devices[device_id], CL_DEVICE_EXTENSIONS);
+  cl_mem_ext_host_ptr ext_host_ptr{0, CL_MEM_HOST_UNCACHED_QCOM};
+  cl_mem_ahardwarebuffer_host_ptr ahb_host_ptr;
+  cl_mem_android_native_buffer_host_ptr anb_host_ptr;
+  void* host_ptr = nullptr;
+  if (kind == "ahardwarebuffer") {
+    ICHECK(extensions.find("cl_qcom_android_ahardwarebuffer_host_ptr") != std::string::npos)
+        << "The OpenCL device cannot import AHardwareBuffers";
+    ext_host_ptr.allocation_type = CL_MEM_ANDROID_AHARDWAREBUFFER_HOST_PTR_QCOM;
+    ahb_host_ptr = {ext_host_ptr, buffer};
+    host_ptr = &ahb_host_ptr;
+  } else if (kind == "native_buffer") {
+    ICHECK(extensions.find("cl_qcom_android_native_buffer_host_ptr") != std::string::npos)
+        << "The OpenCL device cannot import native buffers";
+    ext_host_ptr.allocation_type = CL_MEM_ANDROID_NATIVE_BUFFER_HOST_PTR_QCOM;
+    anb_host_ptr = {ext_host_ptr, buffer};
+    host_ptr = &anb_host_ptr;
+  } else {
+    LOG(FATAL) << "Unsupported graphic buffer kind: " << kind;
+  }
+  cl_int err_code;
+  auto* mptr = new cl::OpenCLBuffer();
+  mptr->buffer = clCreateBuffer(w->context,
+                                CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR | CL_MEM_EXT_HOST_PTR_QCOM,
+                                static_cast<size_t>(size), host_ptr, &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  TVMContext ctx{kDLOpenCL, device_id};
+  auto* container = new NDArray::Container(mptr, {size}, DLDataType{kDLUInt, 8, 1}, ctx);
+  container->SetDeleter(ImportedBufferDeleter);
+  return NDArray(GetObjectPtr<Object>(container));
+}
+
+/*!
+ * \brief Convert a YUV 4:2:0 frame to the normalized RGB input of a model.
+ *
+ *  The frame is rotated clockwise and scaled to the input, sampling the nearest pixel, and
+ *  every channel c is written as (rgb / 255 - mean[c]) / stddev[c].
+ * \param yuv The uint8 OpenCL buffer of the frame, e.g. an imported graphic buffer.
+ * \param out The input, of shape (1, 3, H, W) or (1, H, W, 3) in float32, or a texture of
+ *  shape (1, 1, H, W, 4) whose last channel is zeroed.
+ * \param planes The width and height of the frame, the offset and row stride of the Y plane,
+ *  the offsets of the U and V planes and their row and pixel strides, as in the planes of
+ *  android.media.Image.
+ * \param rotation The clockwise rotation, 0, 90, 180 or 270.
+ * \param mean The means of the channels.
+ * \param stddev The standard deviations of the channels.
+ */
+static void OpenCLYUVToRGB(DLTensor* yuv, DLTensor* out, const std::vector<int>& planes,
+                           int rotation, const double* mean, const double* stddev) {
+  ICHECK_EQ(yuv->ctx.device_type, kDLOpenCL) << "The frame should be an OpenCL buffer";
+  ICHECK_EQ(out->ctx.device_type, kDLOpenCL) << "The input should be on the OpenCL device";
+  ICHECK(yuv->dtype.code == kDLUInt && yuv->dtype.bits == 8) << "The frame should be uint8";
+  ICHECK_EQ(yuv->byte_offset, 0) << "The frame should not have a byte offset";
+  ICHECK_EQ(out->byte_offset, 0) << "The input should not have a byte offset";
+  ICHECK(rotation == 0 || rotation == 90 || rotation == 180 || rotation == 270)
+      << "Unsupported rotation " << rotation;
+  const auto* buf = static_cast<const cl::OpenCLBuffer*>(out->data);
+  bool texture = buf->layout != cl::OpenCLBuffer::MemoryLayout::kGlobalRowMajor &&
+                 buf->layout != cl::OpenCLBuffer::MemoryLayout::kGlobalHostVisible;
+  int dst_w = 0, dst_h = 0, nhwc = 0;
+  if (texture) {
+    ICHECK(buf->layout == cl::OpenCLBuffer::MemoryLayout::kTexture2DActivation &&
+           out->ndim == 5 && out->shape[0] == 1 && out->shape[1] == 1 && out->shape[4] == 4)
+        << "A texture input should be of shape (1, 1, H, W, 4)";
+    dst_h = static_cast<int>(out->shape[2]);
+    dst_w = static_cast<int>(out->shape[3]);
+  } else {
+    ICHECK(out->dtype.code == kDLFloat && out->dtype.bits == 32 && out->dtype.lanes == 1)
+        << "A buffer input should be float32";
+    ICHECK(out->strides == nullptr) << "The input should be compact";
+    ICHECK(out->ndim == 4 && out->shape[0] == 1 && (out->shape[1] == 3 || out->shape[3] == 3))
+        << "A buffer input should be of shape (1, 3, H, W) or (1, H, W, 3)";
+    nhwc = out->shape[1] != 3;
+    dst_h = static_cast<int>(out->shape[nhwc ? 1 : 2]);
+    dst_w = static_cast<int>(out->shape[nhwc ? 2 : 3]);
+  }
+  int src_w = planes[0], src_h = planes[1];
+  ICHECK(src_w > 0 && src_h > 0 && dst_w > 0 && dst_h > 0) << "Empty frame or input";
+  int64_t frame_end = std::max<int64_t>(
+      planes[2] + static_cast<int64_t>(src_h - 1) * planes[3] + src_w,
+      std::max(planes[4], planes[5]) + static_cast<int64_t>((src_h - 1) / 2) * planes[6] +
+          static_cast<int64_t>((src_w - 1) / 2) * planes[7] + 1);
+  ICHECK_LE(frame_end, yuv->shape[0]) << "The planes exceed the frame buffer";
+
+  PackedFunc f = GetCameraModule().GetFunction(texture ? "tvm_ocl_yuv_to_rgb_texture"
+                                                       : "tvm_ocl_yuv_to_rgb_buffer");
+  double scale[3], bias[3];
+  for (int c = 0; c < 3; ++c) {
+    scale[c] = 1.0 / (255.0 * stddev[c]);
+    bias[c] = -mean[c] / stddev[c];
+  }
+  int groups_x = (dst_w + kCameraGroupSize - 1) / kCameraGroupSize;
+  int groups_y = (dst_h + kCameraGroupSize - 1) / kCameraGroupSize;
+  f(yuv->data, out->data, src_w, src_h, planes[2], planes[3], planes[4], planes[5], planes[6],
+    planes[7], rotation, dst_w, dst_h, nhwc, scale[0], scale[1], scale[2], bias[0], bias[1],
+    bias[2], groups_x, groups_y, kCameraGroupSize, kCameraGroupSize);
+}
+
+TVM_REGISTER_GLOBAL("device_api.opencl.ImportAndroidBuffer")
+    .set_body_typed(OpenCLImportAndroidBuffer);
+
+// yuv_to_rgb(yuv, out, width, height, y_offset, y_row_stride, u_offset, v_offset,
+//            uv_row_stride, uv_pixel_stride, rotation, mean_r, mean_g, mean_b,
+//            std_r, std_g, std_b)
+TVM_REGISTER_GLOBAL("tvm.contrib.opencl.yuv_to_rgb").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ICHECK_EQ(args.num_args, 17) << "yuv_to_rgb expects 17 arguments, but it has "
+                               << args.num_args;
+  std::vector<int> planes;
+  for (int i = 2; i < 10; ++i) {
+    planes.push_back(args[i]);
+  }
+  double mean[3] = {args[11], args[12], args[13]};
+  double stddev[3] = {args[14], args[15], args[16]};
+  OpenCLYUVToRGB(args[0], args[1], planes, args[10], mean, stddev);
+});
+
+}  // namespace runtime
+}  // namespace tvm
@@ -45,10 +45,40 @@
 #include <CL/opencl.h>
 #endif
 
+/* The queue hints of cl_khr_priority_hints and cl_khr_throttle_hints, and the context hints of
+ * cl_qcom_perf_hint and cl_qcom_priority_hint, for the headers which predate them.
+ */
+#ifndef CL_QUEUE_PRIORITY_KHR
+#define CL_QUEUE_PRIORITY_KHR 0x1096
+#define CL_QUEUE_PRIORITY_HIGH_KHR (1 << 0)
+#define CL_QUEUE_PRIORITY_MED_KHR (1 << 1)
+#define CL_QUEUE_PRIORITY_LOW_KHR (1 << 2)
+#endif
+#ifndef CL_QUEUE_THROTTLE_KHR
+#define CL_QUEUE_THROTTLE_KHR 0x1097
+#define CL_QUEUE_THROTTLE_HIGH_KHR (1 << 0)
+#define CL_QUEUE_THROTTLE_MED_KHR (1 << 1)
+#define CL_QUEUE_THROTTLE_LOW_KHR (1 << 2)
+#endif
+#ifndef CL_CONTEXT_PERF_HINT_QCOM
+#define CL_CONTEXT_PERF_HINT_QCOM 0x40C2
+#define CL_PERF_HINT_HIGH_QCOM 0x40C3
+#define CL_PERF_HINT_NORMAL_QCOM 0x40C4
+#define CL_PERF_HINT_LOW_QCOM 0x40C5
+#endif
+#ifndef CL_CONTEXT_PRIORITY_HINT_QCOM
+#define CL_CONTEXT_PRIORITY_HINT_QCOM 0x40C9
+#define CL_PRIORITY_HINT_HIGH_QCOM 0x40CA
+#define CL_PRIORITY_HINT_NORMAL_QCOM 0x40CB
+#define CL_PRIORITY_HINT_LOW_QCOM 0x40CC
+#endif
+
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../file_utils.h"
@@ -186,6 +216,39 @@ inline cl_channel_type DTypeToOpenCLChannelType(DLDataType data_type) {
   return CL_FLOAT;
 }
 
+/*!
+ * \brief Get the image channel order holding the given number of channels per texel.
+ * \param channel The number of channels, 1, 2 or 4.
+ */
+inline cl_channel_order ChannelCountToOpenCLChannelOrder(size_t channel) {
+  switch (channel) {
+    case 1:
+      return CL_R;
+    case 2:
+      return CL_RG;
+    case 4:
+      return CL_RGBA;
+    default:
+      LOG(FATAL) << "Texture must have 1, 2 or 4 channels per texel, got " << channel;
+  }
+  return CL_RGBA;
+}
+
+/*!
+ * \brief Get the high-water mark of the free textures cached by a texture pool,
+ *  set in megabytes by TVM_OPENCL_TEXTURE_POOL_LIMIT_MB.
+ * \return The limit in bytes, 0 when unlimited.
+ */
+size_t GetTexturePoolLimit();
+
+/*!
+ * \brief Query a string valued device property.
+ * \param pid The device id.
+ * \param param_name The property to query.
+ * \return The property value.
+ */
+std::string GetDeviceInfo(cl_device_id pid, cl_device_info param_name);
+
 /*!
  * \brief Protected OpenCL call
  * \param func Expression to call.
@@ -220,8 +283,45 @@ class OpenCLWorkspace : public DeviceAPI {
   std::string device_type;
   // the devices
   std::vector<cl_device_id> devices;
-  // the queues
-  std::vector<cl_command_queue> queues;
+  // The default queue of a device, and whether it records kernel events for profiling
+  struct DefaultQueue {
+    cl_command_queue queue{nullptr};
+    bool profiling{false};
+    ~DefaultQueue() {
+      if (queue != nullptr) clReleaseCommandQueue(queue);
+    }
+  };
+  // A reference to the default queue of a device, which keeps the queue alive after it is
+  // replaced by EnableQueueProfiling, until the commands are issued through the reference
+  class QueueRef {
+   public:
+    explicit QueueRef(std::shared_ptr<const DefaultQueue> state) : state_(std::move(state)) {}
+    explicit QueueRef(cl_command_queue stream) : stream_(stream) {}
+    operator cl_command_queue() const { return state_ != nullptr ? state_->queue : stream_; }
+    // Whether kernel events are recorded, false for a stream other than the default queue
+    bool profiling() const { return state_ != nullptr && state_->profiling; }
+
+   private:
+    std::shared_ptr<const DefaultQueue> state_;
+    cl_command_queue stream_{nullptr};
+  };
+  // The default queue of each device, replaced as a whole and read with std::atomic_load
+  std::vector<std::shared_ptr<const DefaultQueue>> queues;
+  // The largest image2d and number of images of an image2d_array of a device, and the
+  // alignments of the images created over regions of a buffer
+  struct ImageLimits {
+    size_t width{0};
+    size_t height{0};
+    size_t array_size{0};
+    // Whether images can be created over buffers, with cl_khr_image2d_from_buffer
+    bool from_buffer{false};
+    // Alignment in texels of the row pitch of an image created over a buffer
+    size_t pitch_alignment{1};
+    // Alignment in bytes of the origin of a sub-buffer
+    size_t base_alignment{1};
+  };
+  // The image limits of each device, queried once at initialization
+  std::vector<ImageLimits> image_limits;
   // Number of registered kernels
   // Used to register kernel into the workspace.
   size_t num_registered_kernels{0};
@@ -229,27 +329,124 @@ class OpenCLWorkspace : public DeviceAPI {
   size_t timestamp{0};
   // Ids that are freed by kernels.
   std::vector<size_t> free_kernel_ids;
-  // the mutex for initialization
+  // Events of the kernels launched on each device while profiling is enabled
+  std::vector<std::vector<cl_event>> events;
+  // Number of live timers on each device, recorded events are released once none remain
+  std::vector<size_t> num_active_timers;
+  // Number of timers and traces that need profiling on the queue of each device
+  std::vector<size_t> num_profiling_users;
+  // Whether profiling was enabled on the queue of each device before its first user
+  std::vector<bool> profiling_before_users;
+  // The cl_qcom_perf_hint of the context, 0 when the driver picks the clocks
+  cl_uint perf_hint{0};
+  // A kernel launch recorded while tracing
+  struct TraceEntry {
+    std::string label;
+    std::string kernel;
+    int device_id;
+    cl_event event;
+  };
+  // Whether the kernel launches of each device are recorded into the trace
+  std::vector<bool> tracing;
+  // Kernel launches recorded since the trace started
+  std::vector<TraceEntry> trace_entries;
+  // Mutex protecting the recorded events and trace entries
+  std::mutex profiling_mu;
+  // Pools shared by all threads, used instead of the thread-local
+  // ones when TVM_OPENCL_SHARED_POOL is set
+  std::unique_ptr<WorkspacePool> shared_pool;
+  std::unique_ptr<TexturePool> shared_texture_pool;
+  // Mutex protecting the shared pools
+  std::mutex shared_pool_mu;
+  // the mutex for initialization, the kernel table and the default queues
   std::mutex mu;
+  // Bumped whenever a memory object is released, a new one may reuse its handle
+  std::atomic<uint64_t> mem_free_epoch{0};
   // destructor
   ~OpenCLWorkspace() {
     if (context != nullptr) {
       OPENCL_CALL(clReleaseContext(context));
     }
   }
+  // Complete the event of the current node when it launched no kernel
+  void FinishNode();
   // Initialzie the device.
   void Init(const std::string& type_key, const std::string& device_type,
             const std::string& platform_name = "");
   virtual void Init() { Init("opencl", "gpu"); }
   // Check whether the context is OpenCL or not.
   virtual bool IsOpenCLDevice(TVMContext ctx) { return ctx.device_type == kDLOpenCL; }
-  // get the queue of the context
-  cl_command_queue GetQueue(TVMContext ctx) {
+  // get the queue of the context, with whether it records kernel events, in one lookup
+  QueueRef GetQueue(TVMContext ctx) {
     ICHECK(IsOpenCLDevice(ctx));
     this->Init();
     ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < queues.size())
         << "Invalid OpenCL device_id=" << ctx.device_id;
-    return queues[ctx.device_id];
+    return QueueRef(std::atomic_load(&queues[ctx.device_id]));
+  }
+  // Whether kernel events are recorded for profiling on the device
+  bool IsProfiling(TVMContext ctx) { return GetQueue(ctx).profiling(); }
+  // Recreate the default queue of the device with or without CL_QUEUE_PROFILING_ENABLE
+  void EnableQueueProfiling(TVMContext ctx, bool enable);
+  // Enable profiling on the queue of the device for a timer or a trace
+  void RetainQueueProfiling(TVMContext ctx);
+  // Restore the profiling state of the queue from before its first user once the last one is done
+  void ReleaseQueueProfiling(TVMContext ctx);
+  /*!
+   * \brief Create a stream with the scheduling hints of cl_khr_priority_hints and
+   *  cl_khr_throttle_hints, so that the kernels of a latency critical model are scheduled
+   *  ahead of the ones of the models sharing the device.
+   *
+   *  The hints the device or the platform does not support are dropped.
+   * \param ctx The device of the stream.
+   * \param priority The priority of the queue, "high", "medium", "low" or "" for none.
+   * \param throttle The power throttling of the queue, "high", "medium", "low" or "" for none.
+   * \return The stream, to be released with FreeStream.
+   */
+  TVMStreamHandle CreateHintedStream(TVMContext ctx, const std::string& priority,
+                                     const std::string& throttle);
+  /*!
+   * \brief Set the performance level of the GPU clocks of the context with cl_qcom_perf_hint,
+   *  so that short latency critical runs are not left at the low clocks the driver picks for
+   *  bursty loads, and background runs save power. Dropped when the devices do not support it.
+   * \param hint The performance level, "high", "medium" or "low".
+   */
+  void SetPerfHint(const std::string& hint);
+  /*!
+   * \brief Create an out-of-order queue, on which the kernels issued between BeginNodes and
+   *  EndNodes are ordered by the dependencies of their nodes only.
+   * \param ctx The device of the queue.
+   * \return The stream, null when the device does not support out-of-order execution.
+   */
+  TVMStreamHandle CreateOutOfOrderStream(TVMContext ctx);
+  /*!
+   * \brief Start tracking the dependencies of the nodes of a graph issued by the calling
+   *  thread. The workspaces freed until EndNodes are only reused after it.
+   * \param num_nodes The number of nodes of the graph.
+   */
+  void BeginNodes(size_t num_nodes);
+  /*!
+   * \brief Set the node whose kernels the calling thread launches next.
+   * \param node The node.
+   * \param waits The nodes it depends on, other than the ones the queue orders it after.
+   * \param num_waits The number of nodes it depends on.
+   */
+  void SetNode(int node, const uint32_t* waits, size_t num_waits);
+  /*! \brief Stop tracking the dependencies of the nodes issued by the calling thread. */
+  void EndNodes();
+  // Record the event of a kernel launch for the active timers and the trace
+  void RecordKernelEvent(TVMContext ctx, const std::string& label, const std::string& kernel,
+                         cl_event event);
+  // Get the events recorded for the device
+  std::vector<cl_event>& GetEventQueue(TVMContext ctx) {
+    ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < events.size())
+        << "Invalid OpenCL device_id=" << ctx.device_id;
+    return events[ctx.device_id];
+  }
+  // get the queue commands are enqueued to, a null stream maps to the default queue
+  QueueRef GetQueue(TVMContext ctx, TVMStreamHandle stream) {
+    if (stream != nullptr) return QueueRef(static_cast<cl_command_queue>(stream));
+    return GetQueue(ctx);
   }
   // override device API
   void SetDevice(TVMContext ctx) final;
@@ -258,13 +455,24 @@ class OpenCLWorkspace : public DeviceAPI {
   void* AllocDataSpace(TVMContext ctx, int ndim, const int64_t* shape, DLDataType dtype,
                        Optional<String> mem_scope = NullOpt) final;
   void FreeDataSpace(TVMContext ctx, void* ptr) final;
+  void CopyDataFromTo(DLTensor* from, DLTensor* to, TVMStreamHandle stream) final;
+  TVMStreamHandle CreateStream(TVMContext ctx) final;
+  void FreeStream(TVMContext ctx, TVMStreamHandle stream) final;
   void StreamSync(TVMContext ctx, TVMStreamHandle stream) final;
+  void SetStream(TVMContext ctx, TVMStreamHandle stream) final;
+  void SyncStreamFromTo(TVMContext ctx, TVMStreamHandle event_src,
+                        TVMStreamHandle event_dst) final;
   void* AllocWorkspace(TVMContext ctx, size_t size, DLDataType type_hint) final;
   void FreeWorkspace(TVMContext ctx, void* data) final;
 
   // Texture (image2d_t) alloca APIs
-  cl_mem AllocTexture(TVMContext ctx, size_t width, size_t height, DLDataType type_hint);
-  void* AllocTextureWorkspace(TVMContext ctx, size_t width, size_t height, DLDataType type_hint);
+  cl_mem AllocTexture(TVMContext ctx, size_t width, size_t height, size_t channel,
+                      DLDataType type_hint);
+  // Texture array (image2d_array_t) allocation, one image of width x height per layer
+  cl_mem AllocTextureArray(TVMContext ctx, size_t width, size_t height, size_t depth,
+                           size_t channel, DLDataType type_hint);
+  void* AllocTextureWorkspace(TVMContext ctx, size_t width, size_t height, size_t channel,
+                              DLDataType type_hint);
   void FreeTextureWorkspace(TVMContext ctx, void* data);
 
   /*!
@@ -281,6 +489,45 @@ class OpenCLWorkspace : public DeviceAPI {
                       TVMStreamHandle stream) final;
 };
 
+/*! \brief A kernel launch recorded while capturing, replayed without going through PackedFunc */
+struct RecordedLaunch {
+  // The context the kernel was launched on.
+  TVMContext ctx;
+  // The kernel id and version in the thread-local kernel table.
+  size_t kernel_id;
+  size_t version;
+  // The kernel handle.
+  cl_kernel kernel;
+  // The name of the kernel.
+  std::string func_name;
+  // Size and value of each kernel argument.
+  std::vector<size_t> arg_size;
+  std::vector<uint64_t> arg_values;
+  // Launch geometry, global sizes followed by local sizes.
+  cl_uint work_dim;
+  size_t work_size[6];
+  // The module owning the kernel.
+  ObjectPtr<Object> module;
+};
+
+/*!
+ * \brief The dependencies of the nodes of a graph run on an out-of-order queue. The kernels
+ *  of a node wait for the events of the nodes it depends on, instead of all the commands
+ *  enqueued before them.
+ */
+struct NodeDependencies {
+  // The event completing each node of the run, null until the node is issued.
+  std::vector<cl_event> node_events;
+  // The node whose kernels are launched, -1 before the first node.
+  int node{-1};
+  // The nodes the current node waits for.
+  std::vector<uint32_t> waits;
+  // The workspaces freed during the run, which concurrent kernels may still use.
+  std::vector<std::pair<TVMContext, void*>> deferred_frees;
+  // The event wait list of a launch.
+  std::vector<cl_event> wait_list;
+};
+
 /*! \brief Thread local workspace */
 class OpenCLThreadEntry {
  public:
@@ -290,18 +537,41 @@ class OpenCLThreadEntry {
     cl_kernel kernel{nullptr};
     // timestamp used to recognize stale kernel
     size_t version{0};
+    // values last bound to the kernel arguments, unchanged arguments are not set again
+    std::vector<uint64_t> arg_values;
+    // mem_free_epoch of the workspace when arg_values were bound
+    uint64_t arg_epoch{0};
+    // thread extents of the last launch
+    std::vector<int64_t> extents;
+    // launch geometry derived from the extents, global sizes followed by local sizes
+    size_t work_size[6];
+    // whether the kernel computes the same for any local size, -1 until queried
+    int any_local_size{-1};
+    // the local size picked by the local size search for the extents, 0 until picked
+    size_t searched_local_size{0};
   };
   /*! \brief The current context */
   TVMContext context;
+  /*! \brief The current stream, kernels are launched on the default queue when null */
+  TVMStreamHandle stream{nullptr};
+  /*! \brief Label attached to the kernels launched by this thread while tracing */
+  std::string trace_label;
+  /*! \brief The launches recorded by this thread, only set while capturing */
+  std::unique_ptr<std::vector<RecordedLaunch>> capture;
+  /*! \brief The dependencies of the graph nodes issued by this thread, only set while tracked */
+  std::unique_ptr<NodeDependencies> deps;
   /*! \brief The thread-local kernel table */
   std::vector<KTEntry> kernel_table;
   /*! \brief workspace pool */
   WorkspacePool pool;
   /*! \brief texture pool */
   TexturePool texture_pool;
+  /*! \brief The texture scratch plan of the graph run by this thread, consulted before the pool */
+  TextureWorkspacePlan* texture_plan{nullptr};
   // constructor
   OpenCLThreadEntry(DLDeviceType device_type, DeviceAPI* device)
     : pool(device_type, device), texture_pool(device_type, device) {
+    texture_pool.SetMaxFreeBytes(GetTexturePoolLimit());
     context.device_id = 0;
     context.device_type = device_type;
   }
@@ -315,16 +585,21 @@ class OpenCLThreadEntry {
 struct OpenCLBuffer {
   enum class MemoryLayout {
     kGlobalRowMajor,
+    kGlobalHostVisible,
     kTexture2DActivation,
     kTexture2DWeight,
     kTexture2DNHWC,
+    kTexture2DArray,
     kUndefined,
   };
   OpenCLBuffer() = default;
   OpenCLBuffer(Optional<String> scope) : layout(MemoryLayoutFromScope(scope)) {}
   static MemoryLayout MemoryLayoutFromScope(Optional<String> mem_scope);
+  static String ScopeFromMemoryLayout(MemoryLayout layout);
   cl_mem buffer{nullptr};
   MemoryLayout layout{MemoryLayout::kGlobalRowMajor};
+  // Host address of a mapped host visible buffer, null when not mapped
+  void* host_ptr{nullptr};
 };
 }  // namespace cl
 
@@ -357,13 +632,50 @@ class OpenCLModuleNode : public ModuleNode {
   void SaveToFile(const std::string& file_name, const std::string& format) final;
   void SaveToBinary(dmlc::Stream* stream) final;
   std::string GetSource(const std::string& format) final;
-  // Initialize the programs
-  void Init();
+  /*!
+   * \brief Initialize the programs.
+   * \param kernels The source of each kernel of a "cl" module, split from the module data
+   *  when empty.
+   * \param release_sources Whether to release the source of a kernel once its programs are
+   *  built on every device, when TVM_OPENCL_RELEASE_SOURCE=1. get_source and saving the
+   *  module then fail.
+   */
+  void Init(std::unordered_map<std::string, std::string> kernels = {},
+            bool release_sources = false);
   // install a new kernel to thread local entry
   cl_kernel InstallKernel(cl::OpenCLWorkspace* w, cl::OpenCLThreadEntry* t,
                           const std::string& func_name, const KTRefEntry& e);
+  /*!
+   * \brief Get the program of a kernel for a device, creating and building it if needed.
+   * \note Must be called with build_lock_ held.
+   */
+  cl_program GetOrBuildProgram(cl::OpenCLWorkspace* w, int device_id,
+                               const std::string& func_name);
+  /*!
+   * \brief Build the programs of all kernels for all devices ahead of the first call.
+   *  Programs are compiled concurrently on a pool of host threads. Enabled at module
+   *  load by setting TVM_OPENCL_EAGER_BUILD=1.
+   */
+  void BuildAllPrograms();
+  /*!
+   * \brief Serialize the program binaries of all kernels built for a device.
+   * \param device_id The device to build and collect the programs for.
+   * \return The serialized map from kernel name to program binary.
+   */
+  std::string GetPreCompiledPrograms(int device_id);
+  /*!
+   * \brief Set program binaries to be used instead of building from source.
+   * \param bytes The serialized map produced by GetPreCompiledPrograms.
+   */
+  void SetPreCompiledPrograms(const std::string& bytes);
 
  private:
+  // build a created program for the device with the options, fatal on build errors.
+  void BuildProgram(cl_program program, cl_device_id dev, const std::string& options);
+  // release the source of a kernel if enabled and its programs are built on every device.
+  // Must be called with build_lock_ held.
+  void ReleaseSourceIfBuilt(const std::string& func_name);
+
   // The workspace, need to keep reference to use it in destructor.
   // In case of static destruction order problem.
   cl::OpenCLWorkspace* workspace_;
@@ -383,8 +695,15 @@ class OpenCLModuleNode : public ModuleNode {
   std::unordered_map<std::string, KTRefEntry> kid_map_;
   // kernels build so far.
   std::vector<cl_kernel> kernels_;
-  // parsed kernel data
+  // The source of each kernel, the only copy of the source of a "cl" module, empty once
+  // released.
   std::unordered_map<std::string, std::string> parsed_kernels_;
+  // whether the source of a kernel is released once its programs are built.
+  bool release_sources_{false};
+  // build options of the kernels which have some, from their source
+  std::unordered_map<std::string, std::string> build_options_;
+  // prebuilt program binaries of each kernel, embedded in the module when set
+  std::unordered_map<std::string, std::string> prebuilt_programs_;
 };
 
 inline cl_mem_object_type GetMemObjectType(const void* mem_ptr) {
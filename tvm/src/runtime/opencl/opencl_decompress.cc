@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_decompress.cc
+ * \brief Decompression of the compressed parameters on the OpenCL devices.
+ *
+ *  Only the compressed bytes are uploaded, a kernel expands them into a buffer of the
+ *  parameter, which is then copied into its texture when the parameter is texture backed.
+ */
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+#include "../compressed_param.h"
+#include "opencl_common.h"
+#include "opencl_module.h"
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief The work group size of the decompression kernels. */
+static constexpr int kDecompressGroupSize = 256;
+
+// The kernel of one output type, after the definitions of KERNEL, OUT_T and STORE.
+static const char* kDecompressKernelSource = R"CLC(
+__kernel void KERNEL(__global const uchar* param, __global OUT_T* out, int scheme,
+                     int block_size, int scales_offset, int data_offset, int n) {
+  int i = get_global_id(0);
+  if (i >= n) return;
+  __global const uchar* data = param + data_offset;
+  float v;
+  if (scheme == 0) {
+    v = vload_half(i, (__global const half*)data);
+  } else {
+    float scale = ((__global const float*)(param + scales_offset))[i / block_size];
+    if (scheme == 1) {
+      v = (float)((__global const char*)data)[i] * scale;
+    } else {
+      uchar b = data[i >> 1];
+      int q = (i & 1) ? (b >> 4) : (b & 15);
+      v = (float)((q ^ 8) - 8) * scale;
+    }
+  }
+  STORE(v, i, out);
+}
+)CLC";
+
+/*! \brief The OpenCL module of the decompression kernels, built on first use. */
+static Module GetDecompressModule() {
+  static Module mod = []() {
+    DLDataType handle{kTVMOpaqueHandle, 64, 1};
+    DLDataType i32{kDLInt, 32, 1};
+    std::unordered_map<std::string, FunctionInfo> fmap;
+    std::string source;
+    for (int bits : {32, 16}) {
+      std::string name = "tvm_ocl_decompress_f" + std::to_string(bits);
+      fmap[name] = {name, {handle, handle, i32, i32, i32, i32, i32}, {"blockIdx.x", "threadIdx.x"}};
+      // The module builds every kernel as its own program from its delimited source
+      source += "// Function: " + name + "\n";
+      source += "#define KERNEL " + name + "\n";
+      if (bits == 32) {
+        source += "#define OUT_T float\n#define STORE(v, i, out) out[i] = v\n";
+      } else {
+        source += "#define OUT_T half\n#define STORE(v, i, out) vstore_half(v, i, out)\n";
+      }
+      source += kDecompressKernelSource;
+    }
+    return OpenCLModuleCreate(source, "cl", fmap, source);
+  }();
+  return mod;
+}
+
+TVM_REGISTER_GLOBAL("device_api.opencl.decompress_param")
+    .set_body_typed([](NDArray arr, NDArray dst) {
+      CompressedParam p = ParseCompressedParam(arr);
+      ICHECK_LE(arr->shape[0], std::numeric_limits<int32_t>::max())
+          << "The compressed parameter is too large for the OpenCL decompression";
+      if (p.num_elements == 0) return;
+      TVMContext ctx = dst->ctx;
+      NDArray param = NDArray::Empty({arr->shape[0]}, arr->dtype, ctx);
+      param.CopyFrom(arr);
+      // Kernels write into flat buffers, textures are filled by a copy from one.
+      auto* dst_buf = static_cast<cl::OpenCLBuffer*>(dst->data);
+      bool in_place = dst->byte_offset == 0 && dst.IsContiguous() &&
+                      GetMemObjectType(dst_buf->buffer) == CL_MEM_OBJECT_BUFFER;
+      NDArray out = in_place ? dst : NDArray::Empty(p.shape, dst->dtype, ctx);
+      int num_groups =
+          static_cast<int>((p.num_elements + kDecompressGroupSize - 1) / kDecompressGroupSize);
+      PackedFunc f = GetDecompressModule().GetFunction(
+          "tvm_ocl_decompress_f" + std::to_string(dst->dtype.bits));
+      f(param->data, out->data, static_cast<int>(p.header->scheme), p.header->block_size,
+        static_cast<int>(p.scales_offset), static_cast<int>(p.data_offset),
+        static_cast<int>(p.num_elements), num_groups, kDecompressGroupSize);
+      if (!in_place) dst.CopyFrom(out);
+      DeviceAPI::Get(ctx)->StreamSync(ctx, nullptr);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
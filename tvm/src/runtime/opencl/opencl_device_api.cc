@@ -20,9 +20,20 @@
 /*!
  * \file opencl_device_api.cc
  */
+#include <builtin_fp16.h>
 #include <dmlc/thread_local.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "../../support/str_escape.h"
+#include "../memory_stats.h"
 #include "opencl_common.h"
 
 namespace tvm {
@@ -35,9 +46,13 @@ std::tuple<size_t, size_t> GetImageInfo(const void* mem_ptr, size_t* origin, siz
   size_t width, height;
   OPENCL_CALL(clGetImageInfo(mem, CL_IMAGE_WIDTH, sizeof(width), &width, NULL));
   OPENCL_CALL(clGetImageInfo(mem, CL_IMAGE_HEIGHT, sizeof(height), &height, NULL));
-  // Current support is for image2d only
+  // The images of a texture array are addressed as the slices of the region
   size_t depth = 1;
-  // OPENCL_CALL(clGetImageInfo(mem, CL_IMAGE_DEPTH, sizeof(depth), &depth, NULL));
+  cl_mem_object_type type;
+  OPENCL_CALL(clGetMemObjectInfo(mem, CL_MEM_TYPE, sizeof(type), &type, NULL));
+  if (type == CL_MEM_OBJECT_IMAGE2D_ARRAY) {
+    OPENCL_CALL(clGetImageInfo(mem, CL_IMAGE_ARRAY_SIZE, sizeof(depth), &depth, NULL));
+  }
   region[0] = width;
   region[1] = height;
   region[2] = depth;
@@ -47,22 +62,222 @@ std::tuple<size_t, size_t> GetImageInfo(const void* mem_ptr, size_t* origin, siz
   // return row_pitch == slice_pitch == 0
   return std::make_tuple(0 , 0);
 }
+
+/*!
+ * \brief Compute the image region covered by a tensor view. Textures allocated
+ *  from a pool (or reused by the memory planner) can be larger than the view, in
+ *  which case only the sub-region described by the logical shape is transferred.
+ */
+void GetTextureRegion(const DLTensor* tensor, size_t* origin, size_t* region) {
+  const auto* buf = static_cast<const OpenCLBuffer*>(tensor->data);
+  ICHECK_EQ(tensor->byte_offset, 0) << "Offset views of texture memory are not supported";
+  String scope = OpenCLBuffer::ScopeFromMemoryLayout(buf->layout);
+  auto texture = ApplyTextureFlattening<int64_t>(tensor->shape, tensor->ndim, scope);
+  size_t width, height, depth = 1;
+  OPENCL_CALL(clGetImageInfo(buf->buffer, CL_IMAGE_WIDTH, sizeof(width), &width, NULL));
+  OPENCL_CALL(clGetImageInfo(buf->buffer, CL_IMAGE_HEIGHT, sizeof(height), &height, NULL));
+  if (buf->layout == OpenCLBuffer::MemoryLayout::kTexture2DArray) {
+    OPENCL_CALL(clGetImageInfo(buf->buffer, CL_IMAGE_ARRAY_SIZE, sizeof(depth), &depth, NULL));
+  }
+  ICHECK(static_cast<size_t>(texture.width) <= width &&
+         static_cast<size_t>(texture.height) <= height &&
+         static_cast<size_t>(texture.depth) <= depth)
+      << "Tensor view of shape (" << texture.depth << ", " << texture.height << ", "
+      << texture.width << ") exceeds the underlying image of shape (" << depth << ", " << height
+      << ", " << width << ")";
+  region[0] = texture.width;
+  region[1] = texture.height;
+  region[2] = texture.depth;
+  origin[0] = 0;
+  origin[1] = 0;
+  origin[2] = 0;
+}
+
+/*! \brief The bytes of the densely packed texels of an image region. */
+size_t RegionBytes(cl_mem image, const size_t* region) {
+  size_t texel_bytes;
+  OPENCL_CALL(clGetImageInfo(image, CL_IMAGE_ELEMENT_SIZE, sizeof(texel_bytes), &texel_bytes,
+                             NULL));
+  return region[0] * region[1] * region[2] * texel_bytes;
+}
+
+/*!
+ * \brief Copy between buffers and images of the context on the device. The texels of an image
+ *  region are read and written densely packed in row-major order, which is the order of the
+ *  flattened tensor, so images of different widths and formats are copied through a buffer.
+ * \param context The context of the memory objects.
+ * \param queue The queue of the copy.
+ * \param from The source buffer or image.
+ * \param from_offset The byte offset in a source buffer.
+ * \param from_region The copied region of a source image, nullptr for a buffer.
+ * \param to The destination buffer or image.
+ * \param to_offset The byte offset in a destination buffer.
+ * \param to_region The copied region of a destination image, nullptr for a buffer.
+ * \param nbytes The bytes copied.
+ */
+void EnqueueDeviceCopy(cl_context context, cl_command_queue queue, cl_mem from,
+                       size_t from_offset, const size_t* from_region, cl_mem to, size_t to_offset,
+                       const size_t* to_region, size_t nbytes) {
+  const size_t origin[3] = {0, 0, 0};
+  if (from_region != nullptr) {
+    ICHECK_EQ(RegionBytes(from, from_region), nbytes)
+        << "The source image region does not hold the copied bytes densely";
+  }
+  if (to_region != nullptr) {
+    ICHECK_EQ(RegionBytes(to, to_region), nbytes)
+        << "The destination image region does not hold the copied bytes densely";
+  }
+  if (from_region == nullptr && to_region == nullptr) {
+    OPENCL_CALL(clEnqueueCopyBuffer(queue, from, to, from_offset, to_offset, nbytes, 0, nullptr,
+                                    nullptr));
+  } else if (to_region == nullptr) {
+    OPENCL_CALL(clEnqueueCopyImageToBuffer(queue, from, to, origin, from_region, to_offset, 0,
+                                           nullptr, nullptr));
+  } else if (from_region == nullptr) {
+    OPENCL_CALL(clEnqueueCopyBufferToImage(queue, from, to, from_offset, origin, to_region, 0,
+                                           nullptr, nullptr));
+  } else if (std::equal(from_region, from_region + 3, to_region) &&
+             GetMemObjectType(from) == GetMemObjectType(to)) {
+    OPENCL_CALL(clEnqueueCopyImage(queue, from, to, origin, origin, from_region, 0, nullptr,
+                                   nullptr));
+  } else {
+    // The staging buffer is released once the queued copies using it are done
+    cl_int err_code;
+    cl_mem staging = clCreateBuffer(context, CL_MEM_READ_WRITE, nbytes, nullptr, &err_code);
+    OPENCL_CHECK_ERROR(err_code);
+    OPENCL_CALL(clEnqueueCopyImageToBuffer(queue, from, staging, origin, from_region, 0, 0,
+                                           nullptr, nullptr));
+    OPENCL_CALL(clEnqueueCopyBufferToImage(queue, staging, to, 0, origin, to_region, 0, nullptr,
+                                           nullptr));
+    OPENCL_CALL(clReleaseMemObject(staging));
+  }
+}
+
+bool IsTextureBacked(const DLTensor* tensor) {
+  const auto* buf = static_cast<const OpenCLBuffer*>(tensor->data);
+  return buf->layout != OpenCLBuffer::MemoryLayout::kGlobalRowMajor &&
+         buf->layout != OpenCLBuffer::MemoryLayout::kGlobalHostVisible;
+}
+
+/*!
+ * \brief Whether a float32 tensor is stored in a half float texture. The kernels read and write
+ *  float32 texels with read_imagef and write_imagef, the copies convert the host data.
+ */
+bool IsHalfStoredFloat(const DLTensor* tensor) {
+  if (DataType(tensor->dtype) != DataType::Float(32)) return false;
+  const auto* buf = static_cast<const OpenCLBuffer*>(tensor->data);
+  cl_image_format format;
+  OPENCL_CALL(clGetImageInfo(buf->buffer, CL_IMAGE_FORMAT, sizeof(format), &format, NULL));
+  return format.image_channel_data_type == CL_HALF_FLOAT;
+}
+
+// Whether the threads share one workspace and texture pool per device
+bool UseSharedPool() {
+  static bool shared = [] {
+    const char* val = getenv("TVM_OPENCL_SHARED_POOL");
+    return val != nullptr && atoi(val) != 0;
+  }();
+  return shared;
+}
+
+// Whether texture storage of a graph may be carved out of one buffer arena
+bool UseTextureArena() {
+  static bool arena = [] {
+    const char* val = getenv("TVM_OPENCL_TEXTURE_ARENA");
+    return val != nullptr && atoi(val) != 0;
+  }();
+  return arena;
+}
+
+// Row pitch in bytes of an image created over a buffer of the device with the given limits
+size_t TextureViewRowPitch(const OpenCLWorkspace::ImageLimits& limits, size_t width,
+                           size_t channel, DLDataType dtype) {
+  size_t align = limits.pitch_alignment;
+  return (width + align - 1) / align * align * channel * ((dtype.bits + 7) / 8);
+}
+
+// The value of a scheduling hint named "high", "medium" or "low"
+cl_uint HintValue(const std::string& hint, cl_uint high, cl_uint medium, cl_uint low) {
+  if (hint == "high") return high;
+  if (hint == "medium") return medium;
+  if (hint == "low") return low;
+  LOG(FATAL) << "Unknown OpenCL scheduling hint " << hint << ", expected high, medium or low";
+  return 0;
+}
+
+// The cl_qcom_perf_hint of the context set by TVM_OPENCL_PERF_HINT, 0 when unset
+cl_uint GetPerfHint() {
+  const char* val = getenv("TVM_OPENCL_PERF_HINT");
+  if (val == nullptr || val[0] == '\0') return 0;
+  return HintValue(val, CL_PERF_HINT_HIGH_QCOM, CL_PERF_HINT_NORMAL_QCOM, CL_PERF_HINT_LOW_QCOM);
+}
+
+// The cl_qcom_priority_hint of the context set by TVM_OPENCL_PRIORITY_HINT, 0 when unset
+cl_uint GetContextPriorityHint() {
+  const char* val = getenv("TVM_OPENCL_PRIORITY_HINT");
+  if (val == nullptr || val[0] == '\0') return 0;
+  return HintValue(val, CL_PRIORITY_HINT_HIGH_QCOM, CL_PRIORITY_HINT_NORMAL_QCOM,
+                   CL_PRIORITY_HINT_LOW_QCOM);
+}
+
+// Whether all the devices support an extension
+bool HasExtension(const std::vector<cl_device_id>& devices, const std::string& extension) {
+  for (cl_device_id device : devices) {
+    if (cl::GetDeviceInfo(device, CL_DEVICE_EXTENSIONS).find(extension) == std::string::npos) {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+size_t GetTexturePoolLimit() {
+  static size_t limit = [] {
+    const char* val = getenv("TVM_OPENCL_TEXTURE_POOL_LIMIT_MB");
+    return val != nullptr ? static_cast<size_t>(atol(val)) << 20 : 0;
+  }();
+  return limit;
 }
 
 OpenCLBuffer::MemoryLayout OpenCLBuffer::MemoryLayoutFromScope(Optional<String> mem_scope) {
   if (!mem_scope.defined()) {
     return OpenCLBuffer::MemoryLayout::kGlobalRowMajor;
+  } else if (mem_scope.value() == "global:host") {
+    return OpenCLBuffer::MemoryLayout::kGlobalHostVisible;
   } else if (mem_scope.value() == "texture") {
     return OpenCLBuffer::MemoryLayout::kTexture2DActivation;
   } else if (mem_scope.value() == "texture:weight") {
     return OpenCLBuffer::MemoryLayout::kTexture2DWeight;
   } else if (mem_scope.value() == "texture:nhwc") {
     return OpenCLBuffer::MemoryLayout::kTexture2DNHWC;
+  } else if (mem_scope.value() == "texture:array") {
+    return OpenCLBuffer::MemoryLayout::kTexture2DArray;
   }
   LOG(FATAL) << "No memory layout defined for memory of scope: " << mem_scope.value();
   return OpenCLBuffer::MemoryLayout::kUndefined;
 }
 
+String OpenCLBuffer::ScopeFromMemoryLayout(MemoryLayout layout) {
+  switch (layout) {
+    case OpenCLBuffer::MemoryLayout::kGlobalRowMajor:
+      return "global";
+    case OpenCLBuffer::MemoryLayout::kGlobalHostVisible:
+      return "global:host";
+    case OpenCLBuffer::MemoryLayout::kTexture2DActivation:
+      return "texture";
+    case OpenCLBuffer::MemoryLayout::kTexture2DWeight:
+      return "texture:weight";
+    case OpenCLBuffer::MemoryLayout::kTexture2DNHWC:
+      return "texture:nhwc";
+    case OpenCLBuffer::MemoryLayout::kTexture2DArray:
+      return "texture:array";
+    default:
+      LOG(FATAL) << "No scope corresponding to the provided memory layout: "
+                 << static_cast<int>(layout);
+  }
+  return "";
+}
+
 OpenCLThreadEntry* OpenCLWorkspace::GetThreadEntry() { return OpenCLThreadEntry::ThreadLocal(); }
 
 OpenCLWorkspace* OpenCLWorkspace::Global() {
@@ -159,6 +374,7 @@ void* OpenCLWorkspace::AllocDataSpace(TVMContext ctx, size_t size, size_t alignm
   mptr->buffer = clCreateBuffer(this->context, CL_MEM_READ_WRITE, size, nullptr, &err_code);
   mptr->layout = OpenCLBuffer::MemoryLayout::kGlobalRowMajor;
   OPENCL_CHECK_ERROR(err_code);
+  MemoryStats::Global()->Alloc(ctx, MemoryKind::kGlobal, mptr, size);
   return mptr;
 }
 
@@ -167,6 +383,23 @@ void* OpenCLWorkspace::AllocDataSpace(TVMContext ctx, int ndim, const int64_t* s
   if (!mem_scope.defined() || mem_scope.value() == "global") {
     return DeviceAPI::AllocDataSpace(ctx, ndim, shape, dtype, mem_scope);
   }
+  if (mem_scope.value() == "global:host") {
+    // Buffer backed by host accessible memory, the host reads and writes it in place
+    // through runtime.opencl.MapBuffer instead of copying.
+    this->Init();
+    ICHECK(context != nullptr) << "No OpenCL device";
+    size_t size = (dtype.bits * dtype.lanes + 7) / 8;
+    for (int i = 0; i < ndim; ++i) {
+      size *= static_cast<size_t>(shape[i]);
+    }
+    cl_int err_code;
+    OpenCLBuffer* mptr = new OpenCLBuffer(mem_scope);
+    mptr->buffer = clCreateBuffer(this->context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size,
+                                  nullptr, &err_code);
+    OPENCL_CHECK_ERROR(err_code);
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kGlobal, mptr, size);
+    return mptr;
+  }
   ICHECK(IsTextureStorage(std::string(mem_scope.value())))
     << "Device does not support allocate data space with "
     << "specified memory scope: " << mem_scope.value();
@@ -175,9 +408,16 @@ void* OpenCLWorkspace::AllocDataSpace(TVMContext ctx, int ndim, const int64_t* s
                    << "provided shape is rank " << ndim;
 
   OpenCLBuffer* mptr = new OpenCLBuffer(mem_scope);
-  size_t axis = DefaultTextureLayoutSeparator(ndim, mem_scope.value());
-  auto texture = ApplyTexture2DFlattening<int64_t>(shape, ndim, axis);
-  mptr->buffer = AllocTexture(ctx, texture.width, texture.height, dtype);
+  auto texture = ApplyTextureFlattening<int64_t>(shape, ndim, mem_scope.value());
+  if (IsTextureArrayStorage(mem_scope.value())) {
+    mptr->buffer = AllocTextureArray(ctx, texture.width, texture.height, texture.depth,
+                                     texture.channel, dtype);
+  } else {
+    mptr->buffer = AllocTexture(ctx, texture.width, texture.height, texture.channel, dtype);
+  }
+  int64_t texels = texture.width * texture.height * texture.depth;
+  size_t nbytes = static_cast<size_t>(texels * texture.channel) * ((dtype.bits + 7) / 8);
+  MemoryStats::Global()->Alloc(ctx, MemoryKind::kTexture, mptr, nbytes);
   return mptr;
 }
 
@@ -187,16 +427,32 @@ void OpenCLWorkspace::FreeDataSpace(TVMContext ctx, void* ptr) {
   OPENCL_CALL(clFinish(this->GetQueue(ctx)));
 
   OpenCLBuffer* mptr = static_cast<OpenCLBuffer*>(ptr);
+  // Views are not recorded, their frees are ignored
+  bool global = mptr->layout == OpenCLBuffer::MemoryLayout::kGlobalRowMajor ||
+                mptr->layout == OpenCLBuffer::MemoryLayout::kGlobalHostVisible;
+  MemoryStats::Global()->Free(ctx, global ? MemoryKind::kGlobal : MemoryKind::kTexture, mptr);
+  if (mptr->host_ptr != nullptr) {
+    OPENCL_CALL(clEnqueueUnmapMemObject(this->GetQueue(ctx), mptr->buffer, mptr->host_ptr, 0,
+                                        nullptr, nullptr));
+    OPENCL_CALL(clFinish(this->GetQueue(ctx)));
+  }
   OPENCL_CALL(clReleaseMemObject(mptr->buffer));
+  mem_free_epoch.fetch_add(1);
   delete mptr;
 }
 
-cl_mem OpenCLWorkspace::AllocTexture(TVMContext ctx, size_t width, size_t height, DLDataType type_hint) {
+cl_mem OpenCLWorkspace::AllocTexture(TVMContext ctx, size_t width, size_t height, size_t channel,
+                                     DLDataType type_hint) {
   this->Init();
   ICHECK(context != nullptr) << "No OpenCL device";
   cl_int err_code;
+  const ImageLimits& limits = this->image_limits[ctx.device_id];
+  ICHECK(width <= limits.width && height <= limits.height)
+      << "Texture of " << width << "x" << height << " exceeds the " << limits.width << "x"
+      << limits.height
+      << " image2d limit of the device, lower texture_spatial_limit of the target";
   cl_channel_type cl_type = DTypeToOpenCLChannelType(type_hint);
-  cl_image_format format = { CL_RGBA, cl_type };
+  cl_image_format format = { ChannelCountToOpenCLChannelOrder(channel), cl_type };
   cl_image_desc descriptor = { CL_MEM_OBJECT_IMAGE2D, width, height, 0, 0, 0, 0, 0, 0 };
   cl_mem mptr = clCreateImage(
     this->context,
@@ -209,87 +465,273 @@ cl_mem OpenCLWorkspace::AllocTexture(TVMContext ctx, size_t width, size_t height
   return mptr;
 }
 
-void* OpenCLWorkspace::AllocTextureWorkspace(TVMContext ctx, size_t width, size_t height, DLDataType type_hint) {
-  return GetThreadEntry()->texture_pool.AllocTexture(ctx, width, height, type_hint);
+cl_mem OpenCLWorkspace::AllocTextureArray(TVMContext ctx, size_t width, size_t height,
+                                          size_t depth, size_t channel, DLDataType type_hint) {
+  this->Init();
+  ICHECK(context != nullptr) << "No OpenCL device";
+  cl_int err_code;
+  const ImageLimits& limits = this->image_limits[ctx.device_id];
+  ICHECK(width <= limits.width && height <= limits.height && depth <= limits.array_size)
+      << "Texture array of " << depth << " images of " << width << "x" << height
+      << " exceeds the " << limits.array_size << " images of " << limits.width << "x"
+      << limits.height << " image2d_array limit of the device";
+  cl_channel_type cl_type = DTypeToOpenCLChannelType(type_hint);
+  cl_image_format format = {ChannelCountToOpenCLChannelOrder(channel), cl_type};
+  cl_image_desc descriptor = {CL_MEM_OBJECT_IMAGE2D_ARRAY, width, height, 0, depth, 0, 0, 0, 0};
+  cl_mem mptr = clCreateImage(this->context, CL_MEM_READ_WRITE, &format, &descriptor, nullptr,
+                              &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  return mptr;
+}
+
+void* OpenCLWorkspace::AllocTextureWorkspace(TVMContext ctx, size_t width, size_t height,
+                                             size_t channel, DLDataType type_hint) {
+  if (TextureWorkspacePlan* plan = GetThreadEntry()->texture_plan) {
+    void* data = plan->AllocTexture(ctx, width, height, channel, type_hint);
+    if (data != nullptr) return data;
+  }
+  if (UseSharedPool()) {
+    std::lock_guard<std::mutex> lock(shared_pool_mu);
+    if (shared_texture_pool == nullptr) {
+      shared_texture_pool.reset(new TexturePool(kDLOpenCL, this));
+      shared_texture_pool->SetMaxFreeBytes(GetTexturePoolLimit());
+    }
+    return shared_texture_pool->AllocTexture(ctx, width, height, channel, type_hint);
+  }
+  return GetThreadEntry()->texture_pool.AllocTexture(ctx, width, height, channel, type_hint);
 }
 
 void OpenCLWorkspace::FreeTextureWorkspace(TVMContext ctx, void* ptr) {
+  TextureWorkspacePlan* plan = GetThreadEntry()->texture_plan;
+  if (plan != nullptr && plan->FreeTexture(ptr)) return;
+  if (UseSharedPool()) {
+    std::lock_guard<std::mutex> lock(shared_pool_mu);
+    shared_texture_pool->FreeTexture(ctx, ptr);
+    return;
+  }
   GetThreadEntry()->texture_pool.FreeTexture(ctx, ptr);
 }
 
+void OpenCLWorkspace::CopyDataFromTo(DLTensor* from, DLTensor* to, TVMStreamHandle stream) {
+  ICHECK(GetThreadEntry()->capture == nullptr) << "Copies cannot be captured for replay";
+  bool from_texture = IsOpenCLDevice(from->ctx) && IsTextureBacked(from);
+  bool to_texture = IsOpenCLDevice(to->ctx) && IsTextureBacked(to);
+  if (!from_texture && !to_texture) {
+    // flat buffers go through the byte copy path
+    DeviceAPI::CopyDataFromTo(from, to, stream);
+    return;
+  }
+  size_t nbytes = GetDataSize(*from);
+  ICHECK_EQ(nbytes, GetDataSize(*to));
+  ICHECK(IsContiguous(*from) && IsContiguous(*to))
+      << "CopyDataFromTo only support contiguous array for now";
+  this->Init();
+  bool from_half = from_texture && IsHalfStoredFloat(from);
+  bool to_half = to_texture && IsHalfStoredFloat(to);
+  if (IsOpenCLDevice(from->ctx) && IsOpenCLDevice(to->ctx) && from_half != to_half) {
+    // float32 buffers and textures are converted from and to half float on the host
+    NDArray host = NDArray::Empty(std::vector<int64_t>(from->shape, from->shape + from->ndim),
+                                  from->dtype, {kDLCPU, 0});
+    this->CopyDataFromTo(from, const_cast<DLTensor*>(host.operator->()), stream);
+    this->StreamSync(from->ctx, stream);
+    this->CopyDataFromTo(const_cast<DLTensor*>(host.operator->()), to, stream);
+    this->StreamSync(to->ctx, stream);
+    return;
+  }
+  if (IsOpenCLDevice(from->ctx) && IsOpenCLDevice(to->ctx)) {
+    // The regions of the tensor views, as the textures may be larger than them
+    size_t from_region[3], to_region[3], origin[3];
+    if (from_texture) GetTextureRegion(from, origin, from_region);
+    if (to_texture) GetTextureRegion(to, origin, to_region);
+    const auto* from_buf = static_cast<const OpenCLBuffer*>(from->data);
+    auto* to_buf = static_cast<OpenCLBuffer*>(to->data);
+    EnqueueDeviceCopy(this->context, this->GetQueue(to->ctx, stream), from_buf->buffer,
+                      from->byte_offset, from_texture ? from_region : nullptr, to_buf->buffer,
+                      to->byte_offset, to_texture ? to_region : nullptr,
+                      from_half ? nbytes / 2 : nbytes);
+    return;
+  }
+  // The host side is densely packed, so row and slice pitch are left as zero
+  // for the runtime to derive them from the region of the tensor view.
+  size_t origin[3], region[3];
+  if (from_texture) {
+    ICHECK_EQ(to->ctx.device_type, kDLCPU) << "Expect copy from texture to host memory";
+    const auto* from_buf = static_cast<const OpenCLBuffer*>(from->data);
+    GetTextureRegion(from, origin, region);
+    QueueRef queue = this->GetQueue(from->ctx, stream);
+    float* host = reinterpret_cast<float*>(static_cast<char*>(to->data) + to->byte_offset);
+    if (from_half) {
+      std::vector<uint16_t> half(nbytes / sizeof(float));
+      OPENCL_CALL(clEnqueueReadImage(queue, from_buf->buffer, CL_TRUE, origin, region, 0, 0,
+                                     half.data(), 0, nullptr, nullptr));
+      for (size_t i = 0; i < half.size(); ++i) {
+        host[i] = __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(half[i]);
+      }
+      return;
+    }
+    OPENCL_CALL(clEnqueueReadImage(queue, from_buf->buffer, CL_FALSE, origin, region, 0, 0,
+                                   static_cast<char*>(to->data) + to->byte_offset, 0, nullptr,
+                                   nullptr));
+    if (stream == nullptr) OPENCL_CALL(clFinish(queue));
+  } else {
+    ICHECK_EQ(from->ctx.device_type, kDLCPU) << "Expect copy from host memory to texture";
+    auto* to_buf = static_cast<OpenCLBuffer*>(to->data);
+    GetTextureRegion(to, origin, region);
+    QueueRef queue = this->GetQueue(to->ctx, stream);
+    if (to_half) {
+      const float* host =
+          reinterpret_cast<const float*>(static_cast<const char*>(from->data) + from->byte_offset);
+      std::vector<uint16_t> half(nbytes / sizeof(float));
+      for (size_t i = 0; i < half.size(); ++i) {
+        half[i] = __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(host[i]);
+      }
+      OPENCL_CALL(clEnqueueWriteImage(queue, to_buf->buffer, CL_TRUE, origin, region, 0, 0,
+                                      half.data(), 0, nullptr, nullptr));
+      return;
+    }
+    OPENCL_CALL(clEnqueueWriteImage(queue, to_buf->buffer, CL_FALSE, origin, region, 0, 0,
+                                    static_cast<const char*>(from->data) + from->byte_offset, 0,
+                                    nullptr, nullptr));
+    if (stream == nullptr) OPENCL_CALL(clFinish(queue));
+  }
+}
+
 void OpenCLWorkspace::CopyDataFromTo(const void* from, size_t from_offset, void* to,
                                      size_t to_offset, size_t size, TVMContext ctx_from,
                                      TVMContext ctx_to, DLDataType type_hint,
                                      TVMStreamHandle stream) {
   this->Init();
-  ICHECK(stream == nullptr);
+  ICHECK(GetThreadEntry()->capture == nullptr) << "Copies cannot be captured for replay";
+  // Copies on a user provided stream are left in flight, the caller is expected
+  // to synchronize the stream before the host memory is reused.
   if (IsOpenCLDevice(ctx_from) && IsOpenCLDevice(ctx_to)) {
     const auto* from_buf = static_cast<const OpenCLBuffer*>(from);
     auto* to_buf = static_cast<OpenCLBuffer*>(to);
-    OPENCL_CALL(clEnqueueCopyBuffer(this->GetQueue(ctx_to), from_buf->buffer, to_buf->buffer,
-                                    from_offset, to_offset, size, 0, nullptr, nullptr));
+    // Without the tensor shapes the full images are copied
+    size_t from_region[3], to_region[3], origin[3];
+    bool from_image = GetMemObjectType(from_buf->buffer) != CL_MEM_OBJECT_BUFFER;
+    bool to_image = GetMemObjectType(to_buf->buffer) != CL_MEM_OBJECT_BUFFER;
+    if (from_image) GetImageInfo(from_buf->buffer, origin, from_region);
+    if (to_image) GetImageInfo(to_buf->buffer, origin, to_region);
+    EnqueueDeviceCopy(this->context, this->GetQueue(ctx_to, stream), from_buf->buffer,
+                      from_offset, from_image ? from_region : nullptr, to_buf->buffer, to_offset,
+                      to_image ? to_region : nullptr, size);
   } else if (IsOpenCLDevice(ctx_from) && ctx_to.device_type == kDLCPU) {
     const auto* from_buf = static_cast<const OpenCLBuffer*>(from);
     cl_mem_object_type from_type = GetMemObjectType(from_buf->buffer);
     switch (from_type) {
     case CL_MEM_OBJECT_BUFFER:
-      OPENCL_CALL(clEnqueueReadBuffer(this->GetQueue(ctx_from), from_buf->buffer, CL_FALSE,
-                                      from_offset, size, static_cast<char*>(to) + to_offset, 0,
-                                      nullptr, nullptr));
+      OPENCL_CALL(clEnqueueReadBuffer(this->GetQueue(ctx_from, stream), from_buf->buffer,
+                                      CL_FALSE, from_offset, size,
+                                      static_cast<char*>(to) + to_offset, 0, nullptr, nullptr));
       break;
     case CL_MEM_OBJECT_IMAGE2D:
+    case CL_MEM_OBJECT_IMAGE2D_ARRAY:
       size_t origin[3], region[3];
       size_t row_pitch, slice_pitch;
       std::tie(row_pitch, slice_pitch) = GetImageInfo(from_buf->buffer, origin, region);
-      // TODO(csullivan): Support calculating row_pitch correctly in the case of reuse.
-      // Note that when utilizing texture pools for memory reuse, the allocated image
-      // size can be larger than the size to be read.
-      OPENCL_CALL(clEnqueueReadImage(this->GetQueue(ctx_from), from_buf->buffer, CL_FALSE, origin,
-                                     region, row_pitch, slice_pitch,
+      // Without the tensor shape the full image is read, copies of pooled
+      // texture views are made pitch aware by the DLTensor overload above.
+      OPENCL_CALL(clEnqueueReadImage(this->GetQueue(ctx_from, stream), from_buf->buffer,
+                                     CL_FALSE, origin, region, row_pitch, slice_pitch,
                                      static_cast<char*>(to) + to_offset, 0, nullptr, nullptr));
       break;
     default:
       LOG(FATAL) << "Device storage transfer from cl_mem_object_type: " << from_type
                  << " to host memory is not yet supported";
     }
-    OPENCL_CALL(clFinish(this->GetQueue(ctx_from)));
+    if (stream == nullptr) OPENCL_CALL(clFinish(this->GetQueue(ctx_from)));
   } else if (ctx_from.device_type == kDLCPU && IsOpenCLDevice(ctx_to)) {
     auto* to_buf = static_cast<OpenCLBuffer*>(to);
     cl_mem_object_type to_type = GetMemObjectType(to_buf->buffer);
     switch (to_type) {
     case CL_MEM_OBJECT_BUFFER:
-      OPENCL_CALL(clEnqueueWriteBuffer(this->GetQueue(ctx_to), to_buf->buffer, CL_FALSE, to_offset,
-                                       size, static_cast<const char*>(from) + from_offset, 0,
-                                       nullptr, nullptr));
+      OPENCL_CALL(clEnqueueWriteBuffer(this->GetQueue(ctx_to, stream), to_buf->buffer, CL_FALSE,
+                                       to_offset, size,
+                                       static_cast<const char*>(from) + from_offset, 0, nullptr,
+                                       nullptr));
       break;
     case CL_MEM_OBJECT_IMAGE2D:
+    case CL_MEM_OBJECT_IMAGE2D_ARRAY:
       size_t origin[3], region[3];
       size_t row_pitch, slice_pitch;
       std::tie(row_pitch, slice_pitch) = GetImageInfo(to_buf->buffer, origin, region);
       OPENCL_CALL(clEnqueueWriteImage(
-          this->GetQueue(ctx_to), to_buf->buffer, CL_FALSE, origin, region, row_pitch, slice_pitch,
-          static_cast<const char*>(from) + from_offset, 0, nullptr, nullptr));
+          this->GetQueue(ctx_to, stream), to_buf->buffer, CL_FALSE, origin, region, row_pitch,
+          slice_pitch, static_cast<const char*>(from) + from_offset, 0, nullptr, nullptr));
       break;
     default:
       LOG(FATAL) << "Device storage transfer from host memory to cl_mem_object_type: " << to_type
                  << " is not yet supported";
     }
-    OPENCL_CALL(clFinish(this->GetQueue(ctx_to)));
+    if (stream == nullptr) OPENCL_CALL(clFinish(this->GetQueue(ctx_to)));
   } else {
     LOG(FATAL) << "Expect copy from/to OpenCL or between OpenCL";
   }
 }
 
+TVMStreamHandle OpenCLWorkspace::CreateStream(TVMContext ctx) {
+  this->Init();
+  ICHECK(IsOpenCLDevice(ctx));
+  ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < devices.size())
+      << "Invalid OpenCL device_id=" << ctx.device_id;
+  cl_int err_code;
+  cl_command_queue queue =
+      clCreateCommandQueue(this->context, devices[ctx.device_id], 0, &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  return static_cast<TVMStreamHandle>(queue);
+}
+
+void OpenCLWorkspace::FreeStream(TVMContext ctx, TVMStreamHandle stream) {
+  ICHECK(stream != nullptr) << "Cannot free the default stream";
+  cl_command_queue queue = static_cast<cl_command_queue>(stream);
+  OPENCL_CALL(clFinish(queue));
+  OPENCL_CALL(clReleaseCommandQueue(queue));
+}
+
 void OpenCLWorkspace::StreamSync(TVMContext ctx, TVMStreamHandle stream) {
-  ICHECK(stream == nullptr);
-  OPENCL_CALL(clFinish(this->GetQueue(ctx)));
+  OPENCL_CALL(clFinish(this->GetQueue(ctx, stream)));
+}
+
+void OpenCLWorkspace::SetStream(TVMContext ctx, TVMStreamHandle stream) {
+  GetThreadEntry()->stream = stream;
+}
+
+void OpenCLWorkspace::SyncStreamFromTo(TVMContext ctx, TVMStreamHandle event_src,
+                                       TVMStreamHandle event_dst) {
+  QueueRef src_queue = this->GetQueue(ctx, event_src);
+  QueueRef dst_queue = this->GetQueue(ctx, event_dst);
+  if (static_cast<cl_command_queue>(src_queue) == dst_queue) return;
+  // Make dst wait on the commands enqueued to src so far without blocking the host.
+  cl_event evt;
+  OPENCL_CALL(clEnqueueMarkerWithWaitList(src_queue, 0, nullptr, &evt));
+  OPENCL_CALL(clEnqueueBarrierWithWaitList(dst_queue, 1, &evt, nullptr));
+  OPENCL_CALL(clReleaseEvent(evt));
+  OPENCL_CALL(clFlush(src_queue));
 }
 
 void* OpenCLWorkspace::AllocWorkspace(TVMContext ctx, size_t size, DLDataType type_hint) {
+  if (UseSharedPool()) {
+    std::lock_guard<std::mutex> lock(shared_pool_mu);
+    if (shared_pool == nullptr) {
+      shared_pool.reset(new WorkspacePool(kDLOpenCL, this));
+    }
+    return shared_pool->AllocWorkspace(ctx, size);
+  }
   return GetThreadEntry()->pool.AllocWorkspace(ctx, size);
 }
 
 void OpenCLWorkspace::FreeWorkspace(TVMContext ctx, void* data) {
+  // The kernels of other nodes on an out-of-order queue may run before the ones using it
+  if (NodeDependencies* deps = GetThreadEntry()->deps.get()) {
+    deps->deferred_frees.emplace_back(ctx, data);
+    return;
+  }
+  if (UseSharedPool()) {
+    std::lock_guard<std::mutex> lock(shared_pool_mu);
+    shared_pool->FreeWorkspace(ctx, data);
+    return;
+  }
   GetThreadEntry()->pool.FreeWorkspace(ctx, data);
 }
 
@@ -380,19 +822,578 @@ void OpenCLWorkspace::Init(const std::string& type_key, const std::string& devic
     LOG(WARNING) << "No OpenCL device";
     return;
   }
+  // The context wide performance level and priority of the Adreno GPUs
+  std::vector<cl_context_properties> props;
+  if (cl_uint perf_hint = GetPerfHint()) {
+    if (HasExtension(this->devices, "cl_qcom_perf_hint")) {
+      props.insert(props.end(), {CL_CONTEXT_PERF_HINT_QCOM,
+                                 static_cast<cl_context_properties>(perf_hint)});
+      this->perf_hint = perf_hint;
+    } else {
+      LOG(WARNING) << "TVM_OPENCL_PERF_HINT is ignored, the devices do not support "
+                   << "cl_qcom_perf_hint";
+    }
+  }
+  if (cl_uint priority_hint = GetContextPriorityHint()) {
+    if (HasExtension(this->devices, "cl_qcom_priority_hint")) {
+      props.insert(props.end(), {CL_CONTEXT_PRIORITY_HINT_QCOM,
+                                 static_cast<cl_context_properties>(priority_hint)});
+    } else {
+      LOG(WARNING) << "TVM_OPENCL_PRIORITY_HINT is ignored, the devices do not support "
+                   << "cl_qcom_priority_hint";
+    }
+  }
+  if (!props.empty()) {
+    props.insert(props.begin(), {CL_CONTEXT_PLATFORM,
+                                 reinterpret_cast<cl_context_properties>(this->platform_id)});
+    props.push_back(0);
+  }
   cl_int err_code;
-  this->context = clCreateContext(nullptr, this->devices.size(), &(this->devices[0]), nullptr,
-                                  nullptr, &err_code);
+  this->context = clCreateContext(props.empty() ? nullptr : props.data(), this->devices.size(),
+                                  &(this->devices[0]), nullptr, nullptr, &err_code);
   OPENCL_CHECK_ERROR(err_code);
   ICHECK_EQ(this->queues.size(), 0U);
   for (size_t i = 0; i < this->devices.size(); ++i) {
     cl_device_id did = this->devices[i];
-    this->queues.push_back(clCreateCommandQueue(this->context, did, 0, &err_code));
+    auto queue = std::make_shared<DefaultQueue>();
+    queue->queue = clCreateCommandQueue(this->context, did, 0, &err_code);
     OPENCL_CHECK_ERROR(err_code);
+    this->queues.push_back(queue);
+    ImageLimits limits;
+    OPENCL_CALL(clGetDeviceInfo(did, CL_DEVICE_IMAGE2D_MAX_WIDTH, sizeof(size_t), &limits.width,
+                                nullptr));
+    OPENCL_CALL(clGetDeviceInfo(did, CL_DEVICE_IMAGE2D_MAX_HEIGHT, sizeof(size_t),
+                                &limits.height, nullptr));
+    // Image arrays were introduced by OpenCL 1.2, older devices keep an array size of 0
+    if (clGetDeviceInfo(did, CL_DEVICE_IMAGE_MAX_ARRAY_SIZE, sizeof(size_t), &limits.array_size,
+                        nullptr) != CL_SUCCESS) {
+      limits.array_size = 0;
+    }
+    limits.from_buffer = GetDeviceInfo(did, CL_DEVICE_EXTENSIONS)
+                             .find("cl_khr_image2d_from_buffer") != std::string::npos;
+    if (limits.from_buffer) {
+      cl_uint pitch_align = 0;
+      OPENCL_CALL(clGetDeviceInfo(did, CL_DEVICE_IMAGE_PITCH_ALIGNMENT, sizeof(cl_uint),
+                                  &pitch_align, nullptr));
+      limits.pitch_alignment = std::max<size_t>(pitch_align, 1);
+    }
+    cl_uint base_align = 0;
+    OPENCL_CALL(clGetDeviceInfo(did, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint), &base_align,
+                                nullptr));
+    // The base address alignment is given in bits
+    limits.base_alignment = std::max<size_t>(base_align / 8, 1);
+    this->image_limits.push_back(limits);
   }
+  this->events.resize(this->devices.size());
+  this->num_active_timers.resize(this->devices.size(), 0);
+  this->num_profiling_users.resize(this->devices.size(), 0);
+  this->profiling_before_users.resize(this->devices.size(), false);
+  this->tracing.resize(this->devices.size(), false);
   initialized_ = true;
 }
 
+void OpenCLWorkspace::EnableQueueProfiling(TVMContext ctx, bool enable) {
+  ICHECK(IsOpenCLDevice(ctx));
+  this->Init();
+  ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < queues.size())
+      << "Invalid OpenCL device_id=" << ctx.device_id;
+  // Serializes the swaps, the launches read the queue with GetQueue without a lock and keep
+  // the queue they got alive until their commands are issued
+  std::lock_guard<std::mutex> lock(this->mu);
+  std::shared_ptr<const DefaultQueue> prev = std::atomic_load(&queues[ctx.device_id]);
+  if (prev->profiling == enable) return;
+  OPENCL_CALL(clFinish(prev->queue));
+  cl_command_queue_properties prop = enable ? CL_QUEUE_PROFILING_ENABLE : 0;
+  cl_int err_code;
+  auto queue = std::make_shared<DefaultQueue>();
+  queue->queue = clCreateCommandQueue(this->context, devices[ctx.device_id], prop, &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  queue->profiling = enable;
+  std::atomic_store(&queues[ctx.device_id], std::shared_ptr<const DefaultQueue>(queue));
+}
+
+void OpenCLWorkspace::RetainQueueProfiling(TVMContext ctx) {
+  this->Init();
+  std::lock_guard<std::mutex> lock(profiling_mu);
+  if (num_profiling_users[ctx.device_id]++ == 0) {
+    profiling_before_users[ctx.device_id] = IsProfiling(ctx);
+    EnableQueueProfiling(ctx, true);
+  }
+}
+
+void OpenCLWorkspace::ReleaseQueueProfiling(TVMContext ctx) {
+  std::lock_guard<std::mutex> lock(profiling_mu);
+  ICHECK_GT(num_profiling_users[ctx.device_id], 0U);
+  if (--num_profiling_users[ctx.device_id] == 0) {
+    EnableQueueProfiling(ctx, profiling_before_users[ctx.device_id]);
+  }
+}
+
+TVMStreamHandle OpenCLWorkspace::CreateOutOfOrderStream(TVMContext ctx) {
+  this->Init();
+  ICHECK(IsOpenCLDevice(ctx));
+  ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < devices.size())
+      << "Invalid OpenCL device_id=" << ctx.device_id;
+  cl_device_id device = devices[ctx.device_id];
+  cl_command_queue_properties supported = 0;
+  OPENCL_CALL(clGetDeviceInfo(device, CL_DEVICE_QUEUE_PROPERTIES, sizeof(supported), &supported,
+                              nullptr));
+  if (!(supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) return nullptr;
+  cl_int err_code;
+  cl_command_queue queue = clCreateCommandQueue(this->context, device,
+                                                CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  return static_cast<TVMStreamHandle>(queue);
+}
+
+void OpenCLWorkspace::BeginNodes(size_t num_nodes) {
+  OpenCLThreadEntry* t = GetThreadEntry();
+  ICHECK(t->deps == nullptr) << "The nodes of a graph are already tracked on this thread";
+  t->deps.reset(new NodeDependencies());
+  t->deps->node_events.assign(num_nodes, nullptr);
+}
+
+void OpenCLWorkspace::FinishNode() {
+  OpenCLThreadEntry* t = GetThreadEntry();
+  NodeDependencies* deps = t->deps.get();
+  if (deps->node < 0 || deps->node_events[deps->node] != nullptr || deps->waits.empty()) return;
+  // A node without kernels completes with the nodes it waits for, which its successors inherit
+  deps->wait_list.clear();
+  for (uint32_t pred : deps->waits) {
+    if (deps->node_events[pred] != nullptr) deps->wait_list.push_back(deps->node_events[pred]);
+  }
+  if (deps->wait_list.empty()) return;
+  OPENCL_CALL(clEnqueueMarkerWithWaitList(GetQueue(t->context, t->stream),
+                                          static_cast<cl_uint>(deps->wait_list.size()),
+                                          deps->wait_list.data(), &deps->node_events[deps->node]));
+}
+
+void OpenCLWorkspace::SetNode(int node, const uint32_t* waits, size_t num_waits) {
+  NodeDependencies* deps = GetThreadEntry()->deps.get();
+  ICHECK(deps != nullptr) << "BeginNodes must be called before SetNode";
+  ICHECK(node >= 0 && static_cast<size_t>(node) < deps->node_events.size())
+      << "Node " << node << " out of range";
+  this->FinishNode();
+  deps->node = node;
+  deps->waits.assign(waits, waits + num_waits);
+}
+
+void OpenCLWorkspace::EndNodes() {
+  OpenCLThreadEntry* t = GetThreadEntry();
+  if (t->deps == nullptr) return;
+  this->FinishNode();
+  std::unique_ptr<NodeDependencies> deps = std::move(t->deps);
+  for (cl_event event : deps->node_events) {
+    if (event != nullptr) OPENCL_CALL(clReleaseEvent(event));
+  }
+  // The commands enqueued after the run are ordered after it by the caller
+  for (auto it = deps->deferred_frees.rbegin(); it != deps->deferred_frees.rend(); ++it) {
+    this->FreeWorkspace(it->first, it->second);
+  }
+}
+
+TVMStreamHandle OpenCLWorkspace::CreateHintedStream(TVMContext ctx, const std::string& priority,
+                                                    const std::string& throttle) {
+  this->Init();
+  ICHECK(IsOpenCLDevice(ctx));
+  ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < devices.size())
+      << "Invalid OpenCL device_id=" << ctx.device_id;
+  cl_device_id device = devices[ctx.device_id];
+  cl_uint priority_hint = 0;
+  cl_uint throttle_hint = 0;
+  if (!priority.empty()) {
+    priority_hint = HintValue(priority, CL_QUEUE_PRIORITY_HIGH_KHR, CL_QUEUE_PRIORITY_MED_KHR,
+                              CL_QUEUE_PRIORITY_LOW_KHR);
+    if (!HasExtension({device}, "cl_khr_priority_hints")) {
+      LOG(WARNING) << "The queue priority is dropped, the device does not support "
+                   << "cl_khr_priority_hints";
+      priority_hint = 0;
+    }
+  }
+  if (!throttle.empty()) {
+    throttle_hint = HintValue(throttle, CL_QUEUE_THROTTLE_HIGH_KHR, CL_QUEUE_THROTTLE_MED_KHR,
+                              CL_QUEUE_THROTTLE_LOW_KHR);
+    if (!HasExtension({device}, "cl_khr_throttle_hints")) {
+      LOG(WARNING) << "The queue throttling is dropped, the device does not support "
+                   << "cl_khr_throttle_hints";
+      throttle_hint = 0;
+    }
+  }
+  if (priority_hint == 0 && throttle_hint == 0) return this->CreateStream(ctx);
+#ifdef CL_VERSION_2_0
+  // The queue properties beyond the 1.2 bitfield need clCreateCommandQueueWithProperties
+  if (cl::GetPlatformInfo(platform_id, CL_PLATFORM_VERSION).compare(0, 9, "OpenCL 1.") != 0) {
+    std::vector<cl_queue_properties> props;
+    if (priority_hint != 0) props.insert(props.end(), {CL_QUEUE_PRIORITY_KHR, priority_hint});
+    if (throttle_hint != 0) props.insert(props.end(), {CL_QUEUE_THROTTLE_KHR, throttle_hint});
+    props.push_back(0);
+    cl_int err_code;
+    cl_command_queue queue =
+        clCreateCommandQueueWithProperties(this->context, device, props.data(), &err_code);
+    OPENCL_CHECK_ERROR(err_code);
+    return static_cast<TVMStreamHandle>(queue);
+  }
+#endif
+  LOG(WARNING) << "The queue hints are dropped, they need OpenCL 2.0";
+  return this->CreateStream(ctx);
+}
+
+void OpenCLWorkspace::SetPerfHint(const std::string& hint) {
+  this->Init();
+  cl_uint value =
+      HintValue(hint, CL_PERF_HINT_HIGH_QCOM, CL_PERF_HINT_NORMAL_QCOM, CL_PERF_HINT_LOW_QCOM);
+  std::lock_guard<std::mutex> lock(this->mu);
+  if (context == nullptr || value == perf_hint) return;
+  if (!HasExtension(devices, "cl_qcom_perf_hint")) {
+    LOG(WARNING) << "The performance hint is dropped, the devices do not support "
+                 << "cl_qcom_perf_hint";
+    return;
+  }
+  // The entry point of the extension is only found through the platform
+  using FSetPerfHint = cl_int (*)(cl_context, cl_uint);
+  static auto set_perf_hint = reinterpret_cast<FSetPerfHint>(
+      clGetExtensionFunctionAddressForPlatform(platform_id, "clSetPerfHintQCOM"));
+  if (set_perf_hint == nullptr) {
+    LOG(WARNING) << "The performance hint is dropped, clSetPerfHintQCOM is not found";
+    return;
+  }
+  OPENCL_CALL(set_perf_hint(context, value));
+  perf_hint = value;
+}
+
+void OpenCLWorkspace::RecordKernelEvent(TVMContext ctx, const std::string& label,
+                                        const std::string& kernel, cl_event event) {
+  std::lock_guard<std::mutex> lock(profiling_mu);
+  bool retained = false;
+  if (num_active_timers[ctx.device_id] > 0) {
+    GetEventQueue(ctx).push_back(event);
+    retained = true;
+  }
+  if (tracing[ctx.device_id]) {
+    if (retained) OPENCL_CALL(clRetainEvent(event));
+    trace_entries.push_back({label, kernel, ctx.device_id, event});
+    retained = true;
+  }
+  if (!retained) OPENCL_CALL(clReleaseEvent(event));
+}
+
+/*!
+ * \brief Timer measuring the device time of the kernels launched between Start and Stop.
+ *  Kernel events are recorded with CL_QUEUE_PROFILING_ENABLE, so host side overheads
+ *  such as clFinish and kernel argument setup are excluded.
+ */
+class OpenCLTimerNode : public TimerNode {
+ public:
+  virtual void Start() {
+    OpenCLWorkspace* w = OpenCLWorkspace::Global();
+    if (!profiling_) {
+      w->RetainQueueProfiling(ctx_);
+      profiling_ = true;
+    }
+    std::lock_guard<std::mutex> lock(w->profiling_mu);
+    std::vector<cl_event>& events = w->GetEventQueue(ctx_);
+    if (w->num_active_timers[ctx_.device_id]++ == 0) {
+      ReleaseEvents(&events);
+    }
+    begin_ = events.size();
+  }
+  virtual void Stop() {
+    OpenCLWorkspace* w = OpenCLWorkspace::Global();
+    {
+      std::lock_guard<std::mutex> lock(w->profiling_mu);
+      end_ = w->GetEventQueue(ctx_).size();
+    }
+    // The recorded events keep their timestamps once the queue is recreated
+    if (profiling_) {
+      w->ReleaseQueueProfiling(ctx_);
+      profiling_ = false;
+    }
+  }
+  virtual int64_t SyncAndGetElapsedNanos() {
+    OpenCLWorkspace* w = OpenCLWorkspace::Global();
+    OPENCL_CALL(clFinish(w->GetQueue(ctx_)));
+    std::lock_guard<std::mutex> lock(w->profiling_mu);
+    std::vector<cl_event>& events = w->GetEventQueue(ctx_);
+    int64_t duration = 0;
+    for (size_t i = begin_; i < end_ && i < events.size(); ++i) {
+      cl_ulong start, end;
+      OPENCL_CALL(clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong),
+                                          &start, nullptr));
+      OPENCL_CALL(clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong),
+                                          &end, nullptr));
+      duration += static_cast<int64_t>(end - start);
+    }
+    return duration;
+  }
+  virtual ~OpenCLTimerNode() {
+    OpenCLWorkspace* w = OpenCLWorkspace::Global();
+    if (profiling_) w->ReleaseQueueProfiling(ctx_);
+    std::lock_guard<std::mutex> lock(w->profiling_mu);
+    if (--w->num_active_timers[ctx_.device_id] == 0) {
+      ReleaseEvents(&w->GetEventQueue(ctx_));
+    }
+  }
+
+  explicit OpenCLTimerNode(TVMContext ctx) : ctx_(ctx) {}
+  static constexpr const char* _type_key = "OpenCLTimerNode";
+  TVM_DECLARE_FINAL_OBJECT_INFO(OpenCLTimerNode, TimerNode);
+
+ private:
+  static void ReleaseEvents(std::vector<cl_event>* events) {
+    for (cl_event evt : *events) {
+      OPENCL_CALL(clReleaseEvent(evt));
+    }
+    events->clear();
+  }
+
+  TVMContext ctx_;
+  size_t begin_{0};
+  size_t end_{0};
+  // Whether the timer holds the profiling of the queue, between Start and Stop
+  bool profiling_{false};
+};
+
+TVM_REGISTER_OBJECT_TYPE(OpenCLTimerNode);
+
+/*!
+ * \brief Map a host visible buffer into the host address space.
+ *  Kernels may not use the buffer until it is unmapped again.
+ * \param arr The array allocated with the "global:host" memory scope.
+ * \return The host address of the array data.
+ */
+void* OpenCLMapBuffer(NDArray arr) {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  ICHECK(w->IsOpenCLDevice(arr->ctx)) << "Expect an OpenCL array";
+  auto* buf = static_cast<OpenCLBuffer*>(arr->data);
+  ICHECK(buf->layout == OpenCLBuffer::MemoryLayout::kGlobalHostVisible)
+      << "Only arrays allocated with the global:host memory scope can be mapped";
+  if (buf->host_ptr == nullptr) {
+    // Map the whole allocation, the mapping is shared by every view of the buffer whatever
+    // its byte_offset.
+    cl_int err_code;
+    size_t size = 0;
+    OPENCL_CALL(clGetMemObjectInfo(buf->buffer, CL_MEM_SIZE, sizeof(size), &size, nullptr));
+    buf->host_ptr =
+        clEnqueueMapBuffer(w->GetQueue(arr->ctx), buf->buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
+                           0, size, 0, nullptr, nullptr, &err_code);
+    OPENCL_CHECK_ERROR(err_code);
+  }
+  return static_cast<char*>(buf->host_ptr) + arr->byte_offset;
+}
+
+/*!
+ * \brief Hand a mapped host visible buffer back to the device.
+ * \param arr The array previously mapped with runtime.opencl.MapBuffer.
+ */
+void OpenCLUnmapBuffer(NDArray arr) {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  auto* buf = static_cast<OpenCLBuffer*>(arr->data);
+  ICHECK(buf->host_ptr != nullptr) << "The array is not mapped";
+  OPENCL_CALL(clEnqueueUnmapMemObject(w->GetQueue(arr->ctx), buf->buffer, buf->host_ptr, 0,
+                                      nullptr, nullptr));
+  buf->host_ptr = nullptr;
+}
+
+TVM_REGISTER_GLOBAL("runtime.opencl.MapBuffer").set_body_typed(OpenCLMapBuffer);
+
+TVM_REGISTER_GLOBAL("runtime.opencl.UnmapBuffer").set_body_typed(OpenCLUnmapBuffer);
+
+/*!
+ * \brief Bytes of buffer memory needed to back a texture view.
+ * \return 0 when texture views are disabled or unsupported by the device,
+ *  in which case the texture is allocated as a standalone image.
+ */
+int64_t OpenCLTextureViewSize(TVMContext ctx, int64_t height, int64_t width, int64_t channel,
+                              DLDataType dtype) {
+  if (!UseTextureArena()) return 0;
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  w->Init();
+  if (static_cast<size_t>(ctx.device_id) >= w->devices.size()) return 0;
+  const OpenCLWorkspace::ImageLimits& limits = w->image_limits[ctx.device_id];
+  if (!limits.from_buffer) return 0;
+  // Sub-buffer origins must be aligned to the base address alignment.
+  size_t align = limits.base_alignment;
+  size_t bytes = TextureViewRowPitch(limits, width, channel, dtype) * height;
+  return static_cast<int64_t>((bytes + align - 1) / align * align);
+}
+
+// The view holds a reference to the arena it was carved from.
+void TextureViewDeleter(Object* obj) {
+  auto* ptr = static_cast<NDArray::Container*>(obj);
+  OpenCLWorkspace::Global()->FreeDataSpace(ptr->dl_tensor.ctx, ptr->dl_tensor.data);
+  delete static_cast<NDArray*>(ptr->manager_ctx);
+  delete ptr;
+}
+
+/*!
+ * \brief Create a texture over a region of a buffer arena.
+ * \param arena The flat buffer the texture is carved out of.
+ * \param offset Byte offset of the region, sized by OpenCLTextureViewSize.
+ * \return A texture of shape (height, width, channel) sharing memory with the arena.
+ */
+NDArray OpenCLTextureView(NDArray arena, int64_t offset, int64_t height, int64_t width,
+                          int64_t channel, DLDataType dtype, String scope) {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  TVMContext ctx = arena->ctx;
+  ICHECK(w->IsOpenCLDevice(ctx)) << "Expect an OpenCL arena";
+  auto* base = static_cast<OpenCLBuffer*>(arena->data);
+  ICHECK(base->layout == OpenCLBuffer::MemoryLayout::kGlobalRowMajor)
+      << "Texture views can only be created over plain buffers";
+  size_t row_pitch = TextureViewRowPitch(w->image_limits[ctx.device_id], width, channel, dtype);
+  ICHECK_LE(static_cast<size_t>(offset) + row_pitch * height, GetDataSize(*arena.operator->()))
+      << "Texture view exceeds the arena";
+
+  cl_int err_code;
+  cl_buffer_region region = {static_cast<size_t>(offset), row_pitch * height};
+  cl_mem sub = clCreateSubBuffer(base->buffer, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION,
+                                 &region, &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  cl_image_format format = {ChannelCountToOpenCLChannelOrder(channel),
+                            DTypeToOpenCLChannelType(dtype)};
+  cl_image_desc descriptor = {CL_MEM_OBJECT_IMAGE2D, static_cast<size_t>(width),
+                              static_cast<size_t>(height), 0, 0, row_pitch, 0, 0, 0};
+  descriptor.buffer = sub;
+  OpenCLBuffer* mptr = new OpenCLBuffer(scope);
+  mptr->buffer = clCreateImage(w->context, CL_MEM_READ_WRITE, &format, &descriptor, nullptr,
+                               &err_code);
+  OPENCL_CHECK_ERROR(err_code);
+  // The image keeps the sub-buffer alive.
+  OPENCL_CALL(clReleaseMemObject(sub));
+
+  auto* view = new NDArray::Container(mptr, {height, width, channel}, dtype, ctx);
+  view->SetDeleter(TextureViewDeleter);
+  view->manager_ctx = new NDArray(arena);
+  return NDArray(GetObjectPtr<Object>(view));
+}
+
+/*!
+ * \brief Create a texture over rows of a texture view, e.g. an input of a concatenation written
+ *  straight into the output.
+ * \param offset Byte offset of the texture view holding the rows.
+ * \param row The first row, of the width of the texture view.
+ * \return A texture of shape (height, width, channel) sharing memory with the rows, undefined
+ *  when the rows do not start at an alignment of sub-buffer origins.
+ */
+NDArray OpenCLTextureViewSlice(NDArray arena, int64_t offset, int64_t row, int64_t height,
+                               int64_t width, int64_t channel, DLDataType dtype, String scope) {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  const OpenCLWorkspace::ImageLimits& limits = w->image_limits[arena->ctx.device_id];
+  size_t origin = offset + TextureViewRowPitch(limits, width, channel, dtype) * row;
+  if (origin % limits.base_alignment != 0) return NDArray();
+  return OpenCLTextureView(arena, origin, height, width, channel, dtype, scope);
+}
+
+TVM_REGISTER_GLOBAL("device_api.opencl.TextureViewSize").set_body_typed(OpenCLTextureViewSize);
+
+TVM_REGISTER_GLOBAL("device_api.opencl.TextureView").set_body_typed(OpenCLTextureView);
+
+TVM_REGISTER_GLOBAL("device_api.opencl.TextureViewSlice").set_body_typed(OpenCLTextureViewSlice);
+
+/*!
+ * \brief Start recording a timeline of the kernels launched on the device.
+ * \param ctx The device context to trace.
+ */
+void OpenCLTraceStart(TVMContext ctx) {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  w->Init();
+  ICHECK(ctx.device_id >= 0 && static_cast<size_t>(ctx.device_id) < w->tracing.size())
+      << "Invalid OpenCL device_id=" << ctx.device_id;
+  bool restart;
+  {
+    std::lock_guard<std::mutex> lock(w->profiling_mu);
+    restart = w->tracing[ctx.device_id];
+  }
+  if (!restart) w->RetainQueueProfiling(ctx);
+  std::lock_guard<std::mutex> lock(w->profiling_mu);
+  // Drop the entries of an earlier trace of the device, the other devices keep theirs
+  auto& entries = w->trace_entries;
+  auto it = std::remove_if(entries.begin(), entries.end(), [&ctx](const auto& entry) {
+    if (entry.device_id != ctx.device_id) return false;
+    OPENCL_CALL(clReleaseEvent(entry.event));
+    return true;
+  });
+  entries.erase(it, entries.end());
+  w->tracing[ctx.device_id] = true;
+}
+
+/*!
+ * \brief Stop tracing and collect the recorded kernel timeline.
+ * \return JSON array of Chrome trace events, one complete event per kernel launch spanning
+ *  COMMAND_START to COMMAND_END. The queued and submit timestamps are kept in the args
+ *  to expose driver submission gaps. Timestamps are in microseconds relative to the first
+ *  queued kernel.
+ */
+std::string OpenCLTraceStop(TVMContext ctx) {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  // Only the traced kernels need to complete, they are on the default queue of the device
+  OPENCL_CALL(clFinish(w->GetQueue(ctx)));
+  // The kernels launched from now on are not labelled by the traced node
+  w->GetThreadEntry()->trace_label.clear();
+  std::vector<OpenCLWorkspace::TraceEntry> entries;
+  bool traced;
+  {
+    std::lock_guard<std::mutex> lock(w->profiling_mu);
+    traced = w->tracing[ctx.device_id];
+    w->tracing[ctx.device_id] = false;
+    auto& all = w->trace_entries;
+    auto it = std::stable_partition(all.begin(), all.end(), [&ctx](const auto& entry) {
+      return entry.device_id != ctx.device_id;
+    });
+    entries.assign(it, all.end());
+    all.erase(it, all.end());
+  }
+  if (traced) w->ReleaseQueueProfiling(ctx);
+  struct Timestamps {
+    cl_ulong queued, submit, start, end;
+  };
+  std::vector<Timestamps> stamps(entries.size());
+  cl_ulong base = std::numeric_limits<cl_ulong>::max();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    cl_event evt = entries[i].event;
+    Timestamps& ts = stamps[i];
+    OPENCL_CALL(clGetEventProfilingInfo(evt, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong),
+                                        &ts.queued, nullptr));
+    OPENCL_CALL(clGetEventProfilingInfo(evt, CL_PROFILING_COMMAND_SUBMIT, sizeof(cl_ulong),
+                                        &ts.submit, nullptr));
+    OPENCL_CALL(clGetEventProfilingInfo(evt, CL_PROFILING_COMMAND_START, sizeof(cl_ulong),
+                                        &ts.start, nullptr));
+    OPENCL_CALL(clGetEventProfilingInfo(evt, CL_PROFILING_COMMAND_END, sizeof(cl_ulong),
+                                        &ts.end, nullptr));
+    base = std::min(base, ts.queued);
+  }
+  auto us = [&base](cl_ulong ns) { return static_cast<double>(ns - base) / 1e3; };
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3) << "[";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto& entry = entries[i];
+    const Timestamps& ts = stamps[i];
+    std::string label = entry.label.empty() ? entry.kernel : entry.label;
+    if (i != 0) os << ",";
+    os << "\n  {\"name\": \"" << support::StrEscape(label.data(), label.length())
+       << "\", \"cat\": \"kernel\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << entry.device_id
+       << ", \"ts\": " << us(ts.start) << ", \"dur\": " << (ts.end - ts.start) / 1e3
+       << ", \"args\": {\"kernel\": \""
+       << support::StrEscape(entry.kernel.data(), entry.kernel.length())
+       << "\", \"queued\": " << us(ts.queued) << ", \"submit\": " << us(ts.submit)
+       << ", \"submit_to_start\": " << (ts.start - ts.submit) / 1e3 << "}}";
+    OPENCL_CALL(clReleaseEvent(entry.event));
+  }
+  os << "\n]";
+  return os.str();
+}
+
+TVM_REGISTER_GLOBAL("profiling.trace_start.opencl").set_body_typed(OpenCLTraceStart);
+
+TVM_REGISTER_GLOBAL("profiling.trace_stop.opencl").set_body_typed(OpenCLTraceStop);
+
+TVM_REGISTER_GLOBAL("profiling.trace_label.opencl").set_body_typed([](String label) {
+  OpenCLWorkspace::Global()->GetThreadEntry()->trace_label = label;
+});
+
+TVM_REGISTER_GLOBAL("profiling.timer.opencl").set_body_typed([](TVMContext ctx) {
+  return Timer(make_object<OpenCLTimerNode>(ctx));
+});
+
 
 TVM_REGISTER_GLOBAL("device_api.opencl.AllocTexture").set_body([](TVMArgs args, TVMRetValue* rv) {
   int device_type = args[0];
@@ -401,6 +1402,11 @@ TVM_REGISTER_GLOBAL("device_api.opencl.AllocTexture").set_body([](TVMArgs args,
   int height = args[3];
   int dtype_code_hint = args[4];
   int dtype_bits_hint = args[5];
+  // Channels per texel, RGBA when not provided by the caller
+  int channel = 4;
+  if (args.num_args > 6) {
+    channel = args[6];
+  }
   TVMContext ctx;
   ctx.device_type = static_cast<DLDeviceType>(device_type);
   ctx.device_id = device_id;
@@ -414,6 +1420,7 @@ TVM_REGISTER_GLOBAL("device_api.opencl.AllocTexture").set_body([](TVMArgs args,
   *rv = ptr->AllocTextureWorkspace(ctx,
                              static_cast<size_t>(width),
                              static_cast<size_t>(height),
+                             static_cast<size_t>(channel),
                              type_hint);
 });
 
@@ -429,6 +1436,126 @@ TVM_REGISTER_GLOBAL("device_api.opencl.FreeTexture").set_body([](TVMArgs args, T
   *rv = static_cast<int32_t>(0);
 });
 
+// The texture scratch plans of static graphs, see TextureWorkspacePlan. A plan is set on the
+// thread running the graph for the duration of each run. With the shared pool, the textures of
+// a plan are taken from it and go back to it once the plan is released.
+TVM_REGISTER_GLOBAL("device_api.opencl.CreateTextureWorkspacePlan").set_body_typed([]() {
+  OpenCLWorkspace* w = OpenCLWorkspace::Global();
+  if (!UseSharedPool()) return static_cast<void*>(new TextureWorkspacePlan(w));
+  {
+    std::lock_guard<std::mutex> lock(w->shared_pool_mu);
+    if (w->shared_texture_pool == nullptr) {
+      w->shared_texture_pool.reset(new TexturePool(kDLOpenCL, w));
+      w->shared_texture_pool->SetMaxFreeBytes(GetTexturePoolLimit());
+    }
+  }
+  return static_cast<void*>(
+      new TextureWorkspacePlan(w, w->shared_texture_pool.get(), &w->shared_pool_mu));
+});
+
+TVM_REGISTER_GLOBAL("device_api.opencl.FreeTextureWorkspacePlan").set_body_typed([](void* plan) {
+  delete static_cast<TextureWorkspacePlan*>(plan);
+});
+
+// Start a run of a plan on the calling thread, returning the plan of the enclosing run
+TVM_REGISTER_GLOBAL("device_api.opencl.BeginTextureWorkspacePlan").set_body_typed([](void* plan) {
+  OpenCLThreadEntry* t = OpenCLThreadEntry::ThreadLocal();
+  void* prev = t->texture_plan;
+  t->texture_plan = static_cast<TextureWorkspacePlan*>(plan);
+  t->texture_plan->BeginRun();
+  return prev;
+});
+
+// End the run of the plan of the calling thread, and restore the plan of the enclosing run
+TVM_REGISTER_GLOBAL("device_api.opencl.EndTextureWorkspacePlan").set_body_typed([](void* prev) {
+  OpenCLThreadEntry* t = OpenCLThreadEntry::ThreadLocal();
+  if (t->texture_plan != nullptr) t->texture_plan->EndRun();
+  t->texture_plan = static_cast<TextureWorkspacePlan*>(prev);
+});
+
+// A new stream of an OpenCL device whose queue runs the commands out of order.
+TVM_REGISTER_GLOBAL("device_api.opencl.CreateOutOfOrderStream").set_body_typed([](int device_id) {
+  TVMContext ctx;
+  ctx.device_type = kDLOpenCL;
+  ctx.device_id = device_id;
+  return static_cast<void*>(OpenCLWorkspace::Global()->CreateOutOfOrderStream(ctx));
+});
+
+// The stream the calling thread launches on, null for the default queue.
+TVM_REGISTER_GLOBAL("device_api.opencl.GetStream").set_body_typed([]() {
+  return static_cast<void*>(OpenCLWorkspace::Global()->GetThreadEntry()->stream);
+});
+
+TVM_REGISTER_GLOBAL("device_api.opencl.BeginNodes").set_body_typed([](int num_nodes) {
+  OpenCLWorkspace::Global()->BeginNodes(num_nodes);
+});
+
+// The arguments are the node, and a pointer to the uint32_t ids of the nodes it waits for and
+// their number, valid for the duration of the call.
+TVM_REGISTER_GLOBAL("device_api.opencl.SetNode").set_body([](TVMArgs args, TVMRetValue* rv) {
+  int node = args[0];
+  void* waits = args[1];
+  int num_waits = args[2];
+  OpenCLWorkspace::Global()->SetNode(node, static_cast<const uint32_t*>(waits), num_waits);
+});
+
+TVM_REGISTER_GLOBAL("device_api.opencl.EndNodes").set_body_typed([]() {
+  OpenCLWorkspace::Global()->EndNodes();
+});
+
+TVM_REGISTER_GLOBAL("device_api.opencl.CreateHintedStream")
+    .set_body_typed([](int device_id, String priority, String throttle) {
+      TVMContext ctx;
+      ctx.device_type = kDLOpenCL;
+      ctx.device_id = device_id;
+      return static_cast<void*>(
+          OpenCLWorkspace::Global()->CreateHintedStream(ctx, priority, throttle));
+    });
+
+// Whether kernel events are recorded for profiling on the default queue of an OpenCL device.
+TVM_REGISTER_GLOBAL("device_api.opencl.IsProfiling").set_body_typed([](int device_id) {
+  TVMContext ctx;
+  ctx.device_type = kDLOpenCL;
+  ctx.device_id = device_id;
+  return OpenCLWorkspace::Global()->IsProfiling(ctx);
+});
+
+TVM_REGISTER_GLOBAL("device_api.opencl.set_perf_hint").set_body_typed([](String hint) {
+  OpenCLWorkspace::Global()->SetPerfHint(hint);
+});
+
+// Read an allocation counter (hits, grows, misses, bytes_wasted or releases) of the
+// texture pool used by the calling thread on an OpenCL device.
+TVM_REGISTER_GLOBAL("device_api.opencl.TexturePoolStats")
+    .set_body_typed([](int device_id, String counter) {
+      TVMContext ctx;
+      ctx.device_type = kDLOpenCL;
+      ctx.device_id = device_id;
+      OpenCLWorkspace* w = OpenCLWorkspace::Global();
+      TexturePool::Stats stats;
+      if (UseSharedPool()) {
+        std::lock_guard<std::mutex> lock(w->shared_pool_mu);
+        if (w->shared_texture_pool != nullptr) stats = w->shared_texture_pool->GetStats(ctx);
+      } else {
+        stats = w->GetThreadEntry()->texture_pool.GetStats(ctx);
+      }
+      size_t value = 0;
+      if (counter == "hits") {
+        value = stats.hits;
+      } else if (counter == "grows") {
+        value = stats.grows;
+      } else if (counter == "misses") {
+        value = stats.misses;
+      } else if (counter == "bytes_wasted") {
+        value = stats.bytes_wasted;
+      } else if (counter == "releases") {
+        value = stats.releases;
+      } else {
+        LOG(FATAL) << "Unknown texture pool counter " << counter;
+      }
+      return static_cast<int64_t>(value);
+    });
+
 TVM_REGISTER_GLOBAL("device_api.opencl").set_body([](TVMArgs args, TVMRetValue* rv) {
   DeviceAPI* ptr = OpenCLWorkspace::Global();
   *rv = static_cast<void*>(ptr);
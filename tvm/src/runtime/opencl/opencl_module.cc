@@ -25,8 +25,23 @@
 #include <dmlc/memory_io.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../source_utils.h"
@@ -35,6 +50,380 @@
 namespace tvm {
 namespace runtime {
 
+namespace {
+// Suffix of the serialized format when prebuilt program binaries are embedded.
+constexpr const char* kPrebuiltFormatSuffix = ":prebuilt";
+// Suffix of the serialized format when the "cl" source is stored as a table of kernel sources.
+constexpr const char* kSplitFormatSuffix = ":split";
+// The delimiter of the kernels in the "cl" source.
+constexpr const char* kKernelDelimiter = "// Function: ";
+
+// The kernel names in a deterministic order, to serialize or rebuild the source.
+std::vector<std::string> SortedKernelNames(
+    const std::unordered_map<std::string, std::string>& kernels) {
+  std::vector<std::string> names;
+  names.reserve(kernels.size());
+  for (const auto& kv : kernels) {
+    names.push_back(kv.first);
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+/*!
+ * \brief Process wide pool compiling OpenCL programs, shared by every module so that loading
+ *  several modules does not start one set of compiler threads each.
+ *  The size is TVM_OPENCL_BUILD_THREADS, by default the number of cores capped to 4.
+ */
+class ProgramBuildPool {
+ public:
+  // Leaked on purpose, the workers may still wait on the queue at exit.
+  static ProgramBuildPool* Global() {
+    static ProgramBuildPool* inst = new ProgramBuildPool();
+    return inst;
+  }
+
+  // Run the tasks on the pool and wait until all of them finished, rethrowing the first error.
+  void Run(const std::vector<std::function<void()>>& tasks) {
+    struct Batch {
+      std::mutex mu;
+      std::condition_variable cv;
+      size_t remaining;
+      std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = tasks.size();
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      for (const auto& task : tasks) {
+        queue_.emplace_back([batch, task]() {
+          std::exception_ptr error;
+          try {
+            task();
+          } catch (...) {
+            error = std::current_exception();
+          }
+          std::lock_guard<std::mutex> lock(batch->mu);
+          if (error && !batch->error) batch->error = error;
+          if (--batch->remaining == 0) batch->cv.notify_all();
+        });
+      }
+      while (workers_ < max_workers_ && workers_ < queue_.size()) {
+        std::thread(&ProgramBuildPool::WorkerLoop, this).detach();
+        ++workers_;
+      }
+    }
+    cv_.notify_all();
+    std::unique_lock<std::mutex> lock(batch->mu);
+    batch->cv.wait(lock, [&batch]() { return batch->remaining == 0; });
+    if (batch->error) std::rethrow_exception(batch->error);
+  }
+
+ private:
+  ProgramBuildPool() {
+    const char* num_threads = getenv("TVM_OPENCL_BUILD_THREADS");
+    max_workers_ = num_threads != nullptr
+                       ? static_cast<size_t>(std::max(1, atoi(num_threads)))
+                       : std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), 4);
+  }
+
+  void WorkerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this]() { return !queue_.empty(); });
+        task = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> queue_;
+  size_t workers_{0};
+  size_t max_workers_{1};
+};
+
+// Strip a suffix of the serialized format, returning whether it was there.
+bool StripFormatSuffix(std::string* fmt, const std::string& suffix) {
+  if (fmt->size() < suffix.size() ||
+      fmt->compare(fmt->size() - suffix.size(), suffix.size(), suffix) != 0) {
+    return false;
+  }
+  fmt->resize(fmt->size() - suffix.size());
+  return true;
+}
+
+/*!
+ * \brief Get the directory of the persistent program binary cache.
+ * \return The cache directory, empty when the cache is disabled.
+ */
+std::string GetProgramCacheDir() {
+  const char* val = getenv("TVM_OPENCL_PROGRAM_CACHE_DIR");
+  return val != nullptr ? std::string(val) : std::string();
+}
+
+// The cache key covers the kernel source, device and driver so stale binaries are never used.
+std::string GetProgramCacheKey(const std::string& source, cl_device_id dev) {
+  std::ostringstream os;
+  os << cl::GetDeviceInfo(dev, CL_DEVICE_NAME) << "|" << cl::GetDeviceInfo(dev, CL_DRIVER_VERSION)
+     << "|" << source;
+  return os.str();
+}
+
+std::string GetProgramCachePath(const std::string& dir, const std::string& key) {
+  std::ostringstream os;
+  os << dir << "/" << std::hex << std::hash<std::string>()(key) << ".clbin";
+  return os.str();
+}
+
+bool LoadCachedProgram(const std::string& path, const std::string& key, std::string* binary) {
+  std::ifstream fs(path, std::ios::in | std::ios::binary);
+  if (fs.fail()) return false;
+  std::string bytes;
+  LoadBinaryFromFile(path, &bytes);
+  dmlc::MemoryStringStream strm(&bytes);
+  std::string cached_key;
+  // guard against hash collisions by checking the full key.
+  if (!strm.Read(&cached_key) || cached_key != key) return false;
+  return strm.Read(binary);
+}
+
+void SaveCachedProgram(const std::string& path, const std::string& key,
+                       const std::string& binary) {
+  std::string bytes;
+  dmlc::MemoryStringStream strm(&bytes);
+  strm.Write(key);
+  strm.Write(binary);
+  std::ofstream fs(path, std::ios::out | std::ios::binary);
+  if (fs.fail()) {
+    LOG(WARNING) << "Cannot write OpenCL program cache entry " << path;
+    return;
+  }
+  fs.write(&bytes[0], bytes.length());
+}
+
+std::string GetProgramBinary(cl_program program) {
+  size_t size;
+  OPENCL_CALL(clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr));
+  std::string binary(size, '\0');
+  unsigned char* ptr = reinterpret_cast<unsigned char*>(&binary[0]);
+  OPENCL_CALL(clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(ptr), &ptr, nullptr));
+  return binary;
+}
+
+// Returns nullptr when the binary can not be used on the device.
+cl_program CreateAndBuildFromBinary(cl_context context, cl_device_id dev,
+                                    const std::string& binary, const std::string& options) {
+  const unsigned char* s = reinterpret_cast<const unsigned char*>(binary.data());
+  size_t len = binary.length();
+  cl_int status, err;
+  cl_program program = clCreateProgramWithBinary(context, 1, &dev, &len, &s, &status, &err);
+  if (err != CL_SUCCESS || status != CL_SUCCESS) {
+    if (program != nullptr) OPENCL_CALL(clReleaseProgram(program));
+    return nullptr;
+  }
+  const char* opts = options.empty() ? nullptr : options.c_str();
+  if (clBuildProgram(program, 1, &dev, opts, nullptr, nullptr) != CL_SUCCESS) {
+    OPENCL_CALL(clReleaseProgram(program));
+    return nullptr;
+  }
+  return program;
+}
+
+/*!
+ * \brief The search of the local sizes of the kernels which compute the same for any local
+ *  size, those compiled with a work_group_size_hint instead of a reqd_work_group_size. Only
+ *  the kernels built for a target with the local_size_search option are compiled so.
+ *
+ *  With TVM_OPENCL_LOCAL_SIZE_SEARCH=N, the first launches of such a kernel with a global size
+ *  try N times each local size dividing it, from the preferred work-group size multiple of the
+ *  kernel to its maximum work-group size, and the fastest is used after. The launches are still
+ *  the ones of the model, timed on the host between two clFinish. The picked local sizes are
+ *  kept in a file per device in TVM_OPENCL_PROGRAM_CACHE_DIR when it is set.
+ */
+class LocalSizeSearch {
+ public:
+  static LocalSizeSearch* Global() {
+    static LocalSizeSearch* inst = new LocalSizeSearch();
+    return inst;
+  }
+  /*! \brief The number of timed launches of each local size, 0 when not searching. */
+  static int NumTrials() {
+    static int trials = [] {
+      const char* val = getenv("TVM_OPENCL_LOCAL_SIZE_SEARCH");
+      return val != nullptr ? std::max(atoi(val), 0) : 0;
+    }();
+    return trials;
+  }
+  /*! \brief Whether a kernel may be launched with any local size. */
+  static bool AnyLocalSize(cl_kernel kernel) {
+    size_t size = 0;
+    if (clGetKernelInfo(kernel, CL_KERNEL_ATTRIBUTES, 0, nullptr, &size) != CL_SUCCESS) {
+      return false;
+    }
+    std::string attrs(size, '\0');
+    OPENCL_CALL(clGetKernelInfo(kernel, CL_KERNEL_ATTRIBUTES, size, &attrs[0], nullptr));
+    return attrs.find("work_group_size_hint") != std::string::npos;
+  }
+  /*!
+   * \brief Get the local size of the next launch of a one dimensional kernel.
+   * \param w The workspace.
+   * \param device_id The device of the launch.
+   * \param kernel The kernel.
+   * \param func_name The name of the kernel.
+   * \param global_size The global size of the launch.
+   * \param compiled The local size the kernel was compiled for.
+   * \param timed Set when the launch is to be timed and reported.
+   * \return The local size, final when the launch is not timed.
+   */
+  size_t Next(cl::OpenCLWorkspace* w, int device_id, cl_kernel kernel,
+              const std::string& func_name, size_t global_size, size_t compiled, bool* timed) {
+    std::lock_guard<std::mutex> lock(mu_);
+    Search& search = this->GetSearch(w, device_id, func_name, global_size);
+    *timed = false;
+    if (search.best != 0) return search.best;
+    if (search.candidates.empty()) {
+      cl_device_id dev = w->devices[device_id];
+      size_t max_size = 0, multiple = 1, max_items[3];
+      OPENCL_CALL(clGetKernelWorkGroupInfo(kernel, dev, CL_KERNEL_WORK_GROUP_SIZE,
+                                           sizeof(max_size), &max_size, nullptr));
+      OPENCL_CALL(clGetKernelWorkGroupInfo(kernel, dev,
+                                           CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                                           sizeof(multiple), &multiple, nullptr));
+      OPENCL_CALL(clGetDeviceInfo(dev, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(max_items), max_items,
+                                  nullptr));
+      max_size = std::min(max_size, max_items[0]);
+      search.candidates.push_back(compiled);
+      for (size_t size = std::max<size_t>(multiple, 1); size <= max_size; size *= 2) {
+        if (size != compiled && global_size % size == 0) search.candidates.push_back(size);
+      }
+      search.times.assign(search.candidates.size(), std::numeric_limits<double>::max());
+      if (search.candidates.size() == 1 || compiled > max_size) {
+        search.best = compiled;
+        return compiled;
+      }
+    }
+    *timed = true;
+    return search.candidates[std::min(search.next / NumTrials(), search.candidates.size() - 1)];
+  }
+  /*!
+   * \brief Report the time of a launch returned timed by Next.
+   * \param local_size The local size of the launch.
+   * \param seconds The time of the launch.
+   */
+  void Report(cl::OpenCLWorkspace* w, int device_id, const std::string& func_name,
+              size_t global_size, size_t local_size, double seconds) {
+    std::lock_guard<std::mutex> lock(mu_);
+    Search& search = this->GetSearch(w, device_id, func_name, global_size);
+    if (search.best != 0) return;
+    for (size_t i = 0; i < search.candidates.size(); ++i) {
+      if (search.candidates[i] == local_size) search.times[i] = std::min(search.times[i], seconds);
+    }
+    if (++search.next < search.candidates.size() * NumTrials()) return;
+    size_t best = std::min_element(search.times.begin(), search.times.end()) - search.times.begin();
+    search.best = search.candidates[best];
+    const std::string& path = cache_paths_[device_id];
+    if (!path.empty()) {
+      std::ofstream fs(path, std::ios::out | std::ios::app);
+      fs << func_name << " " << global_size << " " << search.best << "\n";
+    }
+  }
+
+ private:
+  /*! \brief The search of a kernel and a global size. */
+  struct Search {
+    // The local sizes tried, the compiled one first.
+    std::vector<size_t> candidates;
+    // The fastest time of each local size.
+    std::vector<double> times;
+    // The number of launches reported.
+    size_t next{0};
+    // The local size picked, 0 until then.
+    size_t best{0};
+  };
+
+  Search& GetSearch(cl::OpenCLWorkspace* w, int device_id, const std::string& func_name,
+                    size_t global_size) {
+    if (searches_.size() <= static_cast<size_t>(device_id)) {
+      searches_.resize(device_id + 1);
+      cache_paths_.resize(device_id + 1);
+      loaded_.resize(device_id + 1, false);
+    }
+    if (!loaded_[device_id]) {
+      loaded_[device_id] = true;
+      this->LoadCache(w, device_id);
+    }
+    return searches_[device_id][func_name + "|" + std::to_string(global_size)];
+  }
+
+  void LoadCache(cl::OpenCLWorkspace* w, int device_id) {
+    std::string dir = GetProgramCacheDir();
+    if (dir.empty()) return;
+    cl_device_id dev = w->devices[device_id];
+    std::string key = cl::GetDeviceInfo(dev, CL_DEVICE_NAME) + "|" +
+                      cl::GetDeviceInfo(dev, CL_DRIVER_VERSION);
+    std::ostringstream os;
+    os << dir << "/local_sizes_" << std::hex << std::hash<std::string>()(key) << ".txt";
+    cache_paths_[device_id] = os.str();
+    std::ifstream fs(cache_paths_[device_id]);
+    std::string func_name;
+    size_t global_size, local_size;
+    while (fs >> func_name >> global_size >> local_size) {
+      searches_[device_id][func_name + "|" + std::to_string(global_size)].best = local_size;
+    }
+  }
+
+  std::mutex mu_;
+  // The searches of each device, by kernel name and global size.
+  std::vector<std::unordered_map<std::string, Search>> searches_;
+  // The file keeping the local sizes picked on each device, empty when not kept.
+  std::vector<std::string> cache_paths_;
+  // Whether the local sizes kept for each device were loaded.
+  std::vector<bool> loaded_;
+};
+
+/*!
+ * \brief Enqueue a kernel on the queue of the calling thread. While the thread issues the
+ *  nodes of a graph on an out-of-order queue, the kernel waits for the nodes the current node
+ *  depends on and for the kernel launched before it by that node.
+ */
+void EnqueueKernel(cl::OpenCLWorkspace* w, cl::OpenCLThreadEntry* t, TVMContext ctx,
+                   cl_kernel kernel, cl_uint work_dim, const size_t* work_size,
+                   const std::string& func_name) {
+  cl::OpenCLWorkspace::QueueRef queue = w->GetQueue(ctx, t->stream);
+  cl::NodeDependencies* deps = t->deps.get();
+  if (deps != nullptr && deps->node >= 0) {
+    deps->wait_list.clear();
+    for (uint32_t pred : deps->waits) {
+      if (deps->node_events[pred] != nullptr) deps->wait_list.push_back(deps->node_events[pred]);
+    }
+    cl_event& last = deps->node_events[deps->node];
+    if (last != nullptr) deps->wait_list.push_back(last);
+    cl_event event;
+    OPENCL_CALL(clEnqueueNDRangeKernel(
+        queue, kernel, work_dim, nullptr, work_size, work_size + 3,
+        static_cast<cl_uint>(deps->wait_list.size()),
+        deps->wait_list.empty() ? nullptr : deps->wait_list.data(), &event));
+    if (last != nullptr) OPENCL_CALL(clReleaseEvent(last));
+    last = event;
+    return;
+  }
+  // The queue and its profiling state come from one lookup, the events are recorded for the
+  // queue the kernel is launched on even when profiling is switched meanwhile
+  bool record = queue.profiling();
+  cl_event event = nullptr;
+  OPENCL_CALL(clEnqueueNDRangeKernel(queue, kernel, work_dim, nullptr, work_size,
+                                     work_size + 3, 0, nullptr, record ? &event : nullptr));
+  if (record) {
+    w->RecordKernelEvent(ctx, t->trace_label, func_name, event);
+  }
+}
+}  // namespace
+
 class OpenCLWrappedFunc {
  public:
   // initialize the OpenCL function.
@@ -57,25 +446,96 @@ class OpenCLWrappedFunc {
     if (entry_.kernel_id >= t->kernel_table.size()) {
       t->kernel_table.resize(entry_.kernel_id + 1);
     }
-    const auto& e = t->kernel_table[entry_.kernel_id];
+    auto& e = t->kernel_table[entry_.kernel_id];
     cl_kernel kernel = e.kernel;
     if (kernel == nullptr || e.version != entry_.version) {
       kernel = m_->InstallKernel(w_, t, func_name_, entry_);
+      // a new kernel object has no arguments bound yet
+      e.arg_values.clear();
+      e.extents.clear();
+      e.any_local_size = -1;
     }
-    // setup arguments.
+    // setup arguments, skipping the ones still bound from the previous call.
+    // A freed buffer's handle may be reused by a new buffer, so nothing counts as
+    // bound once a memory object was released.
+    uint64_t epoch = w_->mem_free_epoch.load();
+    bool bound = e.arg_values.size() == arg_size_.size() && e.arg_epoch == epoch;
+    e.arg_values.resize(arg_size_.size());
+    e.arg_epoch = epoch;
     for (cl_uint i = 0; i < arg_size_.size(); ++i) {
       auto* arg = static_cast<cl::OpenCLBuffer*>(void_args[i]);
+      if (arg_size_[i] <= sizeof(uint64_t)) {
+        uint64_t value = 0;
+        std::memcpy(&value, arg->buffer, arg_size_[i]);
+        if (bound && e.arg_values[i] == value) continue;
+        e.arg_values[i] = value;
+      }
       OPENCL_CALL(clSetKernelArg(kernel, i, arg_size_[i], arg->buffer));
     }
-    cl_command_queue queue = w_->GetQueue(t->context);
-    ThreadWorkLoad wl = thread_axis_cfg_.Extract(args);
+    // the launch geometry is only recomputed when the thread extents change.
     cl_uint work_dim = static_cast<cl_uint>(thread_axis_cfg_.work_dim());
-    for (cl_uint i = 0; i < work_dim; ++i) {
-      wl.work_size[i] *= wl.work_size[i + 3];
+    size_t num_extents = static_cast<size_t>(args.num_args) - arg_size_.size();
+    const TVMValue* extents = args.values + arg_size_.size();
+    if (e.extents.size() != num_extents ||
+        !std::equal(e.extents.begin(), e.extents.end(), extents,
+                    [](int64_t a, const TVMValue& b) { return a == b.v_int64; })) {
+      e.extents.resize(num_extents);
+      for (size_t i = 0; i < num_extents; ++i) {
+        e.extents[i] = extents[i].v_int64;
+      }
+      ThreadWorkLoad wl = thread_axis_cfg_.Extract(args);
+      for (cl_uint i = 0; i < work_dim; ++i) {
+        wl.work_size[i] *= wl.work_size[i + 3];
+      }
+      std::copy(wl.work_size, wl.work_size + 6, e.work_size);
+      e.searched_local_size = 0;
+    }
+    size_t work_size[6];
+    std::copy(e.work_size, e.work_size + 6, work_size);
+    bool timed = false;
+    if (work_dim == 1 && LocalSizeSearch::NumTrials() > 0) {
+      if (e.any_local_size < 0) e.any_local_size = LocalSizeSearch::AnyLocalSize(kernel);
+      if (e.searched_local_size != 0) {
+        work_size[3] = e.searched_local_size;
+      } else if (e.any_local_size) {
+        work_size[3] = LocalSizeSearch::Global()->Next(w_, t->context.device_id, kernel,
+                                                       func_name_, work_size[0], e.work_size[3],
+                                                       &timed);
+        if (!timed) e.searched_local_size = work_size[3];
+      }
+    }
+    if (t->capture != nullptr) {
+      cl::RecordedLaunch launch;
+      launch.ctx = t->context;
+      launch.kernel_id = entry_.kernel_id;
+      launch.version = entry_.version;
+      launch.kernel = kernel;
+      launch.func_name = func_name_;
+      launch.arg_size = arg_size_;
+      launch.arg_values = e.arg_values;
+      for (size_t size : arg_size_) {
+        ICHECK_LE(size, sizeof(uint64_t)) << "Cannot capture " << func_name_ << ", argument of "
+                                          << size << " bytes";
+      }
+      launch.work_dim = work_dim;
+      std::copy(work_size, work_size + 6, launch.work_size);
+      launch.module = sptr_;
+      t->capture->push_back(std::move(launch));
     }
     // launch kernel
-    OPENCL_CALL(clEnqueueNDRangeKernel(queue, kernel, work_dim, nullptr, wl.work_size,
-                                       wl.work_size + 3, 0, nullptr, nullptr));
+    if (!timed) {
+      EnqueueKernel(w_, t, t->context, kernel, work_dim, work_size, func_name_);
+      return;
+    }
+    cl::OpenCLWorkspace::QueueRef queue = w_->GetQueue(t->context, t->stream);
+    OPENCL_CALL(clFinish(queue));
+    auto start = std::chrono::steady_clock::now();
+    EnqueueKernel(w_, t, t->context, kernel, work_dim, work_size, func_name_);
+    OPENCL_CALL(clFinish(queue));
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LocalSizeSearch::Global()->Report(w_, t->context.device_id, func_name_, work_size[0],
+                                      work_size[3], seconds);
   }
 
  private:
@@ -95,6 +555,53 @@ class OpenCLWrappedFunc {
   ThreadAxisConfig thread_axis_cfg_;
 };
 
+/*!
+ * \brief Replay the captured launches on the calling thread.
+ *
+ *  The kernels are enqueued directly from the recorded arguments and launch geometry,
+ *  which must still be valid: the captured buffers may not be freed or replaced.
+ *
+ * \param launches The captured launches.
+ */
+void ReplayLaunches(const std::vector<cl::RecordedLaunch>& launches) {
+  cl::OpenCLWorkspace* w = cl::OpenCLWorkspace::Global();
+  cl::OpenCLThreadEntry* t = w->GetThreadEntry();
+  for (const cl::RecordedLaunch& launch : launches) {
+    ICHECK(launch.kernel_id < t->kernel_table.size() &&
+           t->kernel_table[launch.kernel_id].kernel == launch.kernel &&
+           t->kernel_table[launch.kernel_id].version == launch.version)
+        << "Captured launches must be replayed on the capturing thread";
+    auto& e = t->kernel_table[launch.kernel_id];
+    // keep the argument cache of the kernel entry in sync with what is bound
+    uint64_t epoch = w->mem_free_epoch.load();
+    bool bound = e.arg_values.size() == launch.arg_values.size() && e.arg_epoch == epoch;
+    e.arg_values.resize(launch.arg_values.size());
+    e.arg_epoch = epoch;
+    for (cl_uint i = 0; i < launch.arg_values.size(); ++i) {
+      if (bound && e.arg_values[i] == launch.arg_values[i]) continue;
+      e.arg_values[i] = launch.arg_values[i];
+      OPENCL_CALL(clSetKernelArg(launch.kernel, i, launch.arg_size[i], &launch.arg_values[i]));
+    }
+    EnqueueKernel(w, t, launch.ctx, launch.kernel, launch.work_dim, launch.work_size,
+                  launch.func_name);
+  }
+}
+
+// Start recording the OpenCL kernels launched by the calling thread, they are still executed.
+TVM_REGISTER_GLOBAL("runtime.opencl.BeginCapture").set_body_typed([]() {
+  cl::OpenCLThreadEntry* t = cl::OpenCLWorkspace::Global()->GetThreadEntry();
+  ICHECK(t->capture == nullptr) << "A capture is already in progress on this thread";
+  t->capture.reset(new std::vector<cl::RecordedLaunch>());
+});
+
+// Stop recording and return a function replaying the recorded launches.
+TVM_REGISTER_GLOBAL("runtime.opencl.EndCapture").set_body_typed([]() {
+  cl::OpenCLThreadEntry* t = cl::OpenCLWorkspace::Global()->GetThreadEntry();
+  ICHECK(t->capture != nullptr) << "No capture in progress on this thread";
+  std::shared_ptr<std::vector<cl::RecordedLaunch>> launches(t->capture.release());
+  return PackedFunc([launches](TVMArgs args, TVMRetValue* rv) { ReplayLaunches(*launches); });
+});
+
 OpenCLModuleNode::~OpenCLModuleNode() {
   {
     // free the kernel ids in global table.
@@ -125,6 +632,20 @@ PackedFunc OpenCLModuleNode::GetFunction(const std::string& name,
                                          const ObjectPtr<Object>& sptr_to_self) {
   ICHECK_EQ(sptr_to_self.get(), this);
   ICHECK_NE(name, symbol::tvm_module_main) << "Device function do not have main";
+  if (name == "opencl.GetPreCompiledPrograms") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int device_id = args.num_args > 0 ? args[0].operator int() : 0;
+      std::string bytes = this->GetPreCompiledPrograms(device_id);
+      *rv = TVMByteArray{bytes.data(), bytes.size()};
+    });
+  } else if (name == "opencl.BuildAllPrograms") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->BuildAllPrograms(); });
+  } else if (name == "opencl.SetPreCompiledPrograms") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetPreCompiledPrograms(args[0]);
+    });
+  }
   auto it = fmap_.find(name);
   if (it == fmap_.end()) return PackedFunc();
   const FunctionInfo& info = it->second;
@@ -152,25 +673,61 @@ void OpenCLModuleNode::SaveToFile(const std::string& file_name, const std::strin
   ICHECK_EQ(fmt, fmt_) << "Can only save to format=" << fmt_;
   std::string meta_file = GetMetaFilePath(file_name);
   SaveMetaDataToFile(meta_file, fmap_);
-  SaveBinaryToFile(file_name, data_);
+  SaveBinaryToFile(file_name, GetSource(fmt_));
 }
 
 void OpenCLModuleNode::SaveToBinary(dmlc::Stream* stream) {
-  stream->Write(fmt_);
+  // TVM_OPENCL_SAVE_SPLIT=1 saves the "cl" source as a table of kernel sources, which loads
+  // without parsing the whole source, but only in runtimes which know the format.
+  const char* save_split = getenv("TVM_OPENCL_SAVE_SPLIT");
+  bool split = fmt_ == "cl" && save_split != nullptr && atoi(save_split) != 0;
+  std::string fmt = fmt_;
+  if (split) fmt += kSplitFormatSuffix;
+  if (!prebuilt_programs_.empty()) fmt += kPrebuiltFormatSuffix;
+  stream->Write(fmt);
   stream->Write(fmap_);
-  stream->Write(data_);
+  if (split) {
+    std::lock_guard<std::mutex> lock(build_lock_);
+    std::vector<std::string> names = SortedKernelNames(parsed_kernels_);
+    std::vector<std::string> sources;
+    sources.reserve(names.size());
+    for (const std::string& name : names) {
+      const std::string& source = parsed_kernels_.at(name);
+      ICHECK(!source.empty()) << "The source of " << name << " was released once built, "
+                              << "unset TVM_OPENCL_RELEASE_SOURCE to save the module";
+      sources.push_back(source);
+    }
+    stream->Write(names);
+    stream->Write(sources);
+  } else {
+    stream->Write(fmt_ == "cl" ? GetSource(fmt_) : data_);
+  }
+  if (!prebuilt_programs_.empty()) {
+    std::string prebuilt;
+    dmlc::MemoryStringStream strm(&prebuilt);
+    strm.Write(prebuilt_programs_);
+    stream->Write(prebuilt);
+  }
 }
 
 std::string OpenCLModuleNode::GetSource(const std::string& format) {
-  if (format == fmt_) return data_;
-  if (fmt_ == "cl") {
-    return data_;
-  } else {
-    return source_;
+  if (fmt_ != "cl") {
+    return format == fmt_ ? data_ : source_;
+  }
+  // The source is only kept split into kernels, join them back.
+  std::lock_guard<std::mutex> lock(build_lock_);
+  std::ostringstream os;
+  for (const std::string& name : SortedKernelNames(parsed_kernels_)) {
+    const std::string& source = parsed_kernels_.at(name);
+    ICHECK(!source.empty()) << "The source of " << name << " was released once built, "
+                            << "unset TVM_OPENCL_RELEASE_SOURCE to keep it";
+    os << kKernelDelimiter << name << "\n" << source;
   }
+  return os.str();
 }
 
-void OpenCLModuleNode::Init() {
+void OpenCLModuleNode::Init(std::unordered_map<std::string, std::string> kernels,
+                            bool release_sources) {
   workspace_ = GetGlobalWorkspace();
   workspace_->Init();
   // initialize the kernel id, need to lock global table.
@@ -189,7 +746,17 @@ void OpenCLModuleNode::Init() {
   }
 
   // split into source artifacts for each kernel
-  parsed_kernels_ = SplitKernels(GetSource("cl"));
+  if (fmt_ == "cl") {
+    // The split kernels are the only copy of the source kept.
+    parsed_kernels_ =
+        kernels.empty() ? SplitKernels(std::move(data_), kKernelDelimiter) : std::move(kernels);
+    std::string().swap(data_);
+    std::string().swap(source_);
+    const char* release_source = getenv("TVM_OPENCL_RELEASE_SOURCE");
+    release_sources_ = release_sources && release_source != nullptr && atoi(release_source) != 0;
+  } else {
+    parsed_kernels_ = SplitKernels(source_, kKernelDelimiter);
+  }
   ICHECK(!parsed_kernels_.empty()) << "The OpenCL module expects a kernel delimited "
                                    << "source from code generation, but no kernel "
                                    << "delimiter was found.";
@@ -198,51 +765,98 @@ void OpenCLModuleNode::Init() {
   // zero initialize cl_program pointers for each device kernel
   for (auto& kv : parsed_kernels_) {
     programs_.insert({kv.first, std::vector<cl_program>(workspace_->devices.size(), nullptr)});
+    // The build options line stays in the source, so that it is part of the program cache key.
+    const std::string& source = kv.second;
+    size_t prefix_len = std::strlen(kOpenCLBuildOptionsPrefix);
+    if (source.compare(0, prefix_len, kOpenCLBuildOptionsPrefix) == 0) {
+      size_t end = source.find('\n');
+      build_options_[kv.first] = source.substr(prefix_len, end - prefix_len);
+    }
+  }
+  // Optionally move the build cost of all kernels out of the first call.
+  const char* eager_build = getenv("TVM_OPENCL_EAGER_BUILD");
+  if (eager_build != nullptr && atoi(eager_build) != 0) {
+    BuildAllPrograms();
   }
 }
 
-cl_kernel OpenCLModuleNode::InstallKernel(cl::OpenCLWorkspace* w, cl::OpenCLThreadEntry* t,
-                                          const std::string& func_name, const KTRefEntry& e) {
-  std::lock_guard<std::mutex> lock(build_lock_);
-  int device_id = t->context.device_id;
-
-  if (programs_[func_name][device_id] == nullptr) {
-    // create program
-    if (fmt_ == "cl") {
-      const char* s = parsed_kernels_[func_name].c_str();
-      size_t len = parsed_kernels_[func_name].length();
-      cl_int err;
-      programs_[func_name][device_id] = clCreateProgramWithSource(w->context, 1, &s, &len, &err);
-      OPENCL_CHECK_ERROR(err);
-    } else if (fmt_ == "xclbin" || fmt_ == "awsxclbin" || fmt_ == "aocx") {
-      const unsigned char* s = (const unsigned char*)data_.c_str();
-      size_t len = data_.length();
-      cl_int err;
-      cl_device_id dev = w->devices[device_id];
-      programs_[func_name][device_id] =
-          clCreateProgramWithBinary(w->context, 1, &dev, &len, &s, NULL, &err);
-      OPENCL_CHECK_ERROR(err);
-    } else {
-      LOG(FATAL) << "Unknown OpenCL format " << fmt_;
+cl_program OpenCLModuleNode::GetOrBuildProgram(cl::OpenCLWorkspace* w, int device_id,
+                                               const std::string& func_name) {
+  // Only use non-mutating lookups, programs of different kernels can be built concurrently.
+  cl_program& program = programs_.at(func_name)[device_id];
+  if (program != nullptr) return program;
+  const std::string& source = parsed_kernels_.at(func_name);
+  auto opt_it = build_options_.find(func_name);
+  std::string options = opt_it != build_options_.end() ? opt_it->second : "";
+  cl_device_id dev = w->devices[device_id];
+  // create program
+  if (fmt_ == "cl") {
+    // Prefer binaries embedded in the module, then the persistent program cache.
+    auto it = prebuilt_programs_.find(func_name);
+    if (it != prebuilt_programs_.end()) {
+      program = CreateAndBuildFromBinary(w->context, dev, it->second, options);
+      if (program != nullptr) return program;
+      LOG(WARNING) << "Prebuilt program of " << func_name << " is invalid for device=" << dev
+                   << ", building from source";
+    }
+    std::string cache_dir = GetProgramCacheDir();
+    std::string cache_key, cache_path;
+    if (!cache_dir.empty()) {
+      cache_key = GetProgramCacheKey(source, dev);
+      cache_path = GetProgramCachePath(cache_dir, cache_key);
+      std::string binary;
+      if (LoadCachedProgram(cache_path, cache_key, &binary)) {
+        program = CreateAndBuildFromBinary(w->context, dev, binary, options);
+        if (program != nullptr) return program;
+      }
     }
-    // build program
+    const char* s = source.c_str();
+    size_t len = source.length();
     cl_int err;
-    cl_device_id dev = w->devices[device_id];
-    err = clBuildProgram(programs_[func_name][device_id], 1, &dev, nullptr, nullptr, nullptr);
-    if (err != CL_SUCCESS) {
-      size_t len;
-      std::string log;
-      clGetProgramBuildInfo(programs_[func_name][device_id], dev, CL_PROGRAM_BUILD_LOG, 0, nullptr,
-                            &len);
-      log.resize(len);
-      clGetProgramBuildInfo(programs_[func_name][device_id], dev, CL_PROGRAM_BUILD_LOG, len,
-                            &log[0], nullptr);
-      LOG(FATAL) << "OpenCL build error for device=" << dev << "\n" << log;
+    program = clCreateProgramWithSource(w->context, 1, &s, &len, &err);
+    OPENCL_CHECK_ERROR(err);
+    if (!cache_dir.empty()) {
+      BuildProgram(program, dev, options);
+      SaveCachedProgram(cache_path, cache_key, GetProgramBinary(program));
+      return program;
     }
+  } else if (fmt_ == "xclbin" || fmt_ == "awsxclbin" || fmt_ == "aocx") {
+    const unsigned char* s = (const unsigned char*)data_.c_str();
+    size_t len = data_.length();
+    cl_int err;
+    program = clCreateProgramWithBinary(w->context, 1, &dev, &len, &s, NULL, &err);
+    OPENCL_CHECK_ERROR(err);
+  } else {
+    LOG(FATAL) << "Unknown OpenCL format " << fmt_;
   }
+  BuildProgram(program, dev, options);
+  return program;
+}
+
+void OpenCLModuleNode::BuildProgram(cl_program program, cl_device_id dev,
+                                    const std::string& options) {
+  const char* opts = options.empty() ? nullptr : options.c_str();
+  cl_int err = clBuildProgram(program, 1, &dev, opts, nullptr, nullptr);
+  if (err != CL_SUCCESS) {
+    size_t len;
+    std::string log;
+    clGetProgramBuildInfo(program, dev, CL_PROGRAM_BUILD_LOG, 0, nullptr, &len);
+    log.resize(len);
+    clGetProgramBuildInfo(program, dev, CL_PROGRAM_BUILD_LOG, len, &log[0], nullptr);
+    LOG(FATAL) << "OpenCL build error for device=" << dev
+               << (options.empty() ? "" : " with options " + options) << "\n" << log;
+  }
+}
+
+cl_kernel OpenCLModuleNode::InstallKernel(cl::OpenCLWorkspace* w, cl::OpenCLThreadEntry* t,
+                                          const std::string& func_name, const KTRefEntry& e) {
+  std::lock_guard<std::mutex> lock(build_lock_);
+  int device_id = t->context.device_id;
+  cl_program program = GetOrBuildProgram(w, device_id, func_name);
+  ReleaseSourceIfBuilt(func_name);
   // build kernel
   cl_int err;
-  cl_kernel kernel = clCreateKernel(programs_[func_name][device_id], func_name.c_str(), &err);
+  cl_kernel kernel = clCreateKernel(program, func_name.c_str(), &err);
   OPENCL_CHECK_ERROR(err);
   t->kernel_table[e.kernel_id].kernel = kernel;
   t->kernel_table[e.kernel_id].version = e.version;
@@ -250,6 +864,62 @@ cl_kernel OpenCLModuleNode::InstallKernel(cl::OpenCLWorkspace* w, cl::OpenCLThre
   return kernel;
 }
 
+void OpenCLModuleNode::BuildAllPrograms() {
+  std::lock_guard<std::mutex> lock(build_lock_);
+  std::vector<std::pair<std::string, int>> tasks;
+  for (const auto& kv : parsed_kernels_) {
+    for (size_t device_id = 0; device_id < workspace_->devices.size(); ++device_id) {
+      if (programs_.at(kv.first)[device_id] == nullptr) {
+        tasks.emplace_back(kv.first, static_cast<int>(device_id));
+      }
+    }
+  }
+  if (tasks.empty()) return;
+  // The driver compiler is the bottleneck, compile independent programs concurrently.
+  std::vector<std::function<void()>> builds;
+  for (const auto& task : tasks) {
+    builds.emplace_back(
+        [this, task]() { GetOrBuildProgram(workspace_, task.second, task.first); });
+  }
+  // surfaces build errors on the calling thread
+  ProgramBuildPool::Global()->Run(builds);
+  for (const auto& task : tasks) {
+    ReleaseSourceIfBuilt(task.first);
+  }
+}
+
+void OpenCLModuleNode::ReleaseSourceIfBuilt(const std::string& func_name) {
+  if (!release_sources_) return;
+  const std::vector<cl_program>& programs = programs_.at(func_name);
+  if (std::any_of(programs.begin(), programs.end(), [](cl_program p) { return p == nullptr; })) {
+    return;
+  }
+  // Only the value is replaced, programs of other kernels may be built concurrently.
+  std::string().swap(parsed_kernels_.at(func_name));
+}
+
+std::string OpenCLModuleNode::GetPreCompiledPrograms(int device_id) {
+  ICHECK_EQ(fmt_, "cl") << "Only OpenCL source modules can be precompiled";
+  std::lock_guard<std::mutex> lock(build_lock_);
+  std::unordered_map<std::string, std::string> binaries;
+  for (const auto& kv : parsed_kernels_) {
+    binaries[kv.first] = GetProgramBinary(GetOrBuildProgram(workspace_, device_id, kv.first));
+  }
+  std::string bytes;
+  dmlc::MemoryStringStream strm(&bytes);
+  strm.Write(binaries);
+  return bytes;
+}
+
+void OpenCLModuleNode::SetPreCompiledPrograms(const std::string& bytes) {
+  std::string data = bytes;
+  dmlc::MemoryStringStream strm(&data);
+  std::unordered_map<std::string, std::string> binaries;
+  ICHECK(strm.Read(&binaries)) << "Invalid precompiled OpenCL programs";
+  std::lock_guard<std::mutex> lock(build_lock_);
+  prebuilt_programs_ = std::move(binaries);
+}
+
 Module OpenCLModuleCreate(std::string data, std::string fmt,
                           std::unordered_map<std::string, FunctionInfo> fmap, std::string source) {
   auto n = make_object<OpenCLModuleNode>(data, fmt, fmap, source);
@@ -265,7 +935,9 @@ Module OpenCLModuleLoadFile(const std::string& file_name, const std::string& for
   std::string meta_file = GetMetaFilePath(file_name);
   LoadBinaryFromFile(file_name, &data);
   LoadMetaDataFromFile(meta_file, &fmap);
-  return OpenCLModuleCreate(data, fmt, fmap, std::string());
+  auto n = make_object<OpenCLModuleNode>(std::move(data), fmt, fmap, std::string());
+  n->Init({}, true);
+  return Module(n);
 }
 
 Module OpenCLModuleLoadBinary(void* strm) {
@@ -275,8 +947,27 @@ Module OpenCLModuleLoadBinary(void* strm) {
   std::string fmt;
   stream->Read(&fmt);
   stream->Read(&fmap);
-  stream->Read(&data);
-  return OpenCLModuleCreate(data, fmt, fmap, std::string());
+  bool has_prebuilt = StripFormatSuffix(&fmt, kPrebuiltFormatSuffix);
+  std::unordered_map<std::string, std::string> kernels;
+  if (StripFormatSuffix(&fmt, kSplitFormatSuffix)) {
+    std::vector<std::string> names, sources;
+    ICHECK(stream->Read(&names) && stream->Read(&sources) && names.size() == sources.size())
+        << "Invalid OpenCL kernel table";
+    for (size_t i = 0; i < names.size(); ++i) {
+      kernels.emplace(std::move(names[i]), std::move(sources[i]));
+    }
+  } else {
+    stream->Read(&data);
+  }
+  auto n = make_object<OpenCLModuleNode>(std::move(data), fmt, fmap, std::string());
+  // The shipped binaries must be in place before Init, which may build eagerly.
+  if (has_prebuilt) {
+    std::string prebuilt;
+    ICHECK(stream->Read(&prebuilt)) << "Invalid precompiled OpenCL programs";
+    n->SetPreCompiledPrograms(prebuilt);
+  }
+  n->Init(std::move(kernels), true);
+  return Module(n);
 }
 
 TVM_REGISTER_GLOBAL("runtime.module.loadfile_cl").set_body_typed(OpenCLModuleLoadFile);
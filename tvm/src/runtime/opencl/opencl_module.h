@@ -35,6 +35,12 @@
 
 namespace tvm {
 namespace runtime {
+/*!
+ * \brief The comment line after the "// Function: " delimiter of a kernel source which carries
+ *  the options to build the program of the kernel with.
+ */
+constexpr const char* kOpenCLBuildOptionsPrefix = "// Build options: ";
+
 /*!
  * \brief create a opencl module for GPU devices from data.
  *
@@ -0,0 +1,339 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_nms.cc
+ * \brief OpenCL kernels of get_valid_counts and non_max_suppression, used as extern functions
+ *  by the OpenCL strategies so that the detection post-processing stays on the GPU.
+ *
+ *  Every batch is processed by one work group. The compaction uses a scan in local memory and
+ *  the boxes are sorted by a bitonic sort in global memory, synchronized within the group, so
+ *  no atomics are needed.
+ */
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "opencl_common.h"
+#include "opencl_module.h"
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief The work group size of the kernels, a multiple of the Adreno wave size. */
+static constexpr int kNMSGroupSize = 256;
+
+// The helpers shared by the kernels, WG is kNMSGroupSize.
+static const char* kNMSHelperSource = R"CLC(
+#define WG 256
+
+// Exclusive scan of the flags of a chunk of WG rows, returns the offset of the row of this
+// work item and stores the total of the chunk in *total.
+inline int tvm_ocl_nms_scan(__local int* scan, int flag, int* total) {
+  int t = get_local_id(0);
+  scan[t] = flag;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  for (int off = 1; off < WG; off <<= 1) {
+    int v = t >= off ? scan[t - off] : 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    scan[t] += v;
+    barrier(CLK_LOCAL_MEM_FENCE);
+  }
+  *total = scan[WG - 1];
+  int ret = scan[t] - flag;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  return ret;
+}
+
+inline void tvm_ocl_nms_fill(__global float* row, int elem_length) {
+  for (int k = 0; k < elem_length; ++k) row[k] = -1.0f;
+}
+
+inline float tvm_ocl_nms_iou(__global const float* a, __global const float* b) {
+  float w = fmax(0.0f, fmin(a[2], b[2]) - fmax(a[0], b[0]));
+  float h = fmax(0.0f, fmin(a[3], b[3]) - fmax(a[1], b[1]));
+  float inter = w * h;
+  float area_a = (a[2] - a[0]) * (a[3] - a[1]);
+  float area_b = (b[2] - b[0]) * (b[3] - b[1]);
+  float u = area_a + area_b - inter;
+  return u <= 0.0f ? 0.0f : inter / u;
+}
+)CLC";
+
+static const char* kGetValidCountsSource = R"CLC(
+
+__kernel void tvm_ocl_get_valid_counts(__global const float* data, __global int* valid_count,
+                                       __global float* out, __global int* out_indices,
+                                       __global const float* score_threshold, int num_anchors,
+                                       int elem_length, int id_index, int score_index) {
+  __local int scan[WG];
+  float threshold = score_threshold[0];
+  int b = get_group_id(0);
+  int t = get_local_id(0);
+  __global const float* in = data + (size_t)b * num_anchors * elem_length;
+  __global float* o = out + (size_t)b * num_anchors * elem_length;
+  __global int* oi = out_indices + (size_t)b * num_anchors;
+  int base = 0;
+  for (int start = 0; start < num_anchors; start += WG) {
+    int i = start + t;
+    int valid = 0;
+    if (i < num_anchors) {
+      __global const float* row = in + (size_t)i * elem_length;
+      valid = row[score_index] > threshold && (id_index < 0 || row[id_index] >= 0.0f);
+    }
+    int total;
+    int pos = base + tvm_ocl_nms_scan(scan, valid, &total);
+    if (valid) {
+      for (int k = 0; k < elem_length; ++k) {
+        o[(size_t)pos * elem_length + k] = in[(size_t)i * elem_length + k];
+      }
+      oi[pos] = i;
+    }
+    base += total;
+  }
+  for (int i = base + t; i < num_anchors; i += WG) {
+    tvm_ocl_nms_fill(o + (size_t)i * elem_length, elem_length);
+    oi[i] = -1;
+  }
+  if (t == 0) valid_count[b] = base;
+}
+)CLC";
+
+static const char* kNonMaxSuppressionSource = R"CLC(
+__kernel void tvm_ocl_non_max_suppression(
+    __global const float* data, __global const int* valid_count, __global float* out,
+    __global float* keys, __global int* order, int num_anchors, int elem_length, int padded,
+    __global const int* max_output_size_buf, __global const float* iou_threshold_buf,
+    int force_suppress, int top_k, int coord_start, int score_index, int id_index,
+    int invalid_to_bottom) {
+  __local int scan[WG];
+  int max_output_size = max_output_size_buf[0];
+  float iou_threshold = iou_threshold_buf[0];
+  int b = get_group_id(0);
+  int t = get_local_id(0);
+  __global const float* in = data + (size_t)b * num_anchors * elem_length;
+  __global float* o = out + (size_t)b * num_anchors * elem_length;
+  __global float* k = keys + (size_t)b * padded;
+  __global int* ord = order + (size_t)b * padded;
+  int n = min(max(valid_count[b], 0), num_anchors);
+
+  // Sort the valid boxes by descending score, ties by index.
+  for (int i = t; i < padded; i += WG) {
+    k[i] = i < n ? in[(size_t)i * elem_length + score_index] : -INFINITY;
+    ord[i] = i;
+  }
+  barrier(CLK_GLOBAL_MEM_FENCE);
+  for (int size = 2; size <= padded; size <<= 1) {
+    for (int stride = size >> 1; stride > 0; stride >>= 1) {
+      for (int i = t; i < padded / 2; i += WG) {
+        int lo = 2 * i - (i & (stride - 1));
+        int hi = lo + stride;
+        float klo = k[lo], khi = k[hi];
+        int olo = ord[lo], ohi = ord[hi];
+        bool lo_first = klo > khi || (klo == khi && olo < ohi);
+        bool desc = (lo & size) == 0;
+        if (lo_first != desc) {
+          k[lo] = khi;
+          k[hi] = klo;
+          ord[lo] = ohi;
+          ord[hi] = olo;
+        }
+      }
+      barrier(CLK_GLOBAL_MEM_FENCE);
+    }
+  }
+
+  int nkeep = (top_k > 0 && top_k < n) ? top_k : n;
+  for (int i = t; i < num_anchors; i += WG) {
+    __global float* row = o + (size_t)i * elem_length;
+    if (i < nkeep) {
+      __global const float* src = in + (size_t)ord[i] * elem_length;
+      for (int e = 0; e < elem_length; ++e) row[e] = src[e];
+    } else {
+      tvm_ocl_nms_fill(row, elem_length);
+    }
+  }
+  barrier(CLK_GLOBAL_MEM_FENCE);
+
+  // Greedy suppression, box i is final once the boxes before it are processed.
+  int num_kept = 0;
+  for (int i = 0; i < nkeep; ++i) {
+    __global float* row_i = o + (size_t)i * elem_length;
+    if (row_i[score_index] <= 0.0f) continue;
+    if (max_output_size > 0 && num_kept >= max_output_size) {
+      barrier(CLK_GLOBAL_MEM_FENCE);
+      if (t == 0) {
+        row_i[score_index] = -1.0f;
+        if (id_index >= 0) row_i[id_index] = -1.0f;
+      }
+      barrier(CLK_GLOBAL_MEM_FENCE);
+      continue;
+    }
+    ++num_kept;
+    for (int j = i + 1 + t; j < nkeep; j += WG) {
+      __global float* row_j = o + (size_t)j * elem_length;
+      if (row_j[score_index] <= 0.0f) continue;
+      if (!force_suppress && id_index >= 0 && row_i[id_index] != row_j[id_index]) continue;
+      if (tvm_ocl_nms_iou(row_i + coord_start, row_j + coord_start) >= iou_threshold) {
+        row_j[score_index] = -1.0f;
+        if (id_index >= 0) row_j[id_index] = -1.0f;
+      }
+    }
+    barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+
+  if (!invalid_to_bottom) return;
+  // Move the kept boxes to the top, their rows are still the rows of the sorted input.
+  for (int i = t; i < padded; i += WG) {
+    k[i] = (i < nkeep && o[(size_t)i * elem_length + score_index] > 0.0f) ? 1.0f : 0.0f;
+  }
+  barrier(CLK_GLOBAL_MEM_FENCE);
+  int base = 0;
+  for (int start = 0; start < nkeep; start += WG) {
+    int i = start + t;
+    int kept = i < nkeep && k[i] > 0.0f;
+    int total;
+    int pos = base + tvm_ocl_nms_scan(scan, kept, &total);
+    if (kept) {
+      __global const float* src = in + (size_t)ord[i] * elem_length;
+      for (int e = 0; e < elem_length; ++e) o[(size_t)pos * elem_length + e] = src[e];
+    }
+    base += total;
+  }
+  barrier(CLK_GLOBAL_MEM_FENCE);
+  for (int i = base + t; i < nkeep; i += WG) {
+    tvm_ocl_nms_fill(o + (size_t)i * elem_length, elem_length);
+  }
+}
+)CLC";
+
+/*! \brief The OpenCL module of the NMS kernels, built on first use. */
+static Module GetNMSModule() {
+  static Module mod = []() {
+    DLDataType handle{kTVMOpaqueHandle, 64, 1};
+    DLDataType i32{kDLInt, 32, 1};
+    std::vector<std::string> tags{"blockIdx.x", "threadIdx.x"};
+    std::unordered_map<std::string, FunctionInfo> fmap;
+    fmap["tvm_ocl_get_valid_counts"] = {"tvm_ocl_get_valid_counts",
+                                        {handle, handle, handle, handle, handle, i32, i32, i32,
+                                         i32},
+                                        tags};
+    fmap["tvm_ocl_non_max_suppression"] = {"tvm_ocl_non_max_suppression",
+                                           {handle, handle, handle, handle, handle, i32, i32, i32,
+                                            handle, handle, i32, i32, i32, i32, i32, i32},
+                                           tags};
+    // The module builds every kernel as its own program from its delimited source
+    std::string source;
+    source += std::string("// Function: tvm_ocl_get_valid_counts\n") + kNMSHelperSource +
+              kGetValidCountsSource;
+    source += std::string("// Function: tvm_ocl_non_max_suppression\n") + kNMSHelperSource +
+              kNonMaxSuppressionSource;
+    return OpenCLModuleCreate(source, "cl", fmap, source);
+  }();
+  return mod;
+}
+
+/*!
+ * \brief The device buffer of a scalar argument, given as a tensor or as the data handle of one
+ *  by the extern calls, which cannot pack 0-d buffers.
+ */
+static void* ScalarBuffer(const TVMArgValue& arg) {
+  if (arg.type_code() == kTVMOpaqueHandle) return arg;
+  DLTensor* tensor = arg;
+  ICHECK_EQ(tensor->ctx.device_type, kDLOpenCL) << "The scalar should be an OpenCL tensor";
+  return tensor->data;
+}
+
+static void CheckNMSTensor(const DLTensor* t, int ndim, DLDataType dtype, const char* name) {
+  ICHECK_EQ(t->ndim, ndim) << name << " should be " << ndim << "-D";
+  ICHECK(t->dtype.code == dtype.code && t->dtype.bits == dtype.bits && t->dtype.lanes == 1)
+      << "Unsupported dtype of " << name;
+  ICHECK_EQ(t->byte_offset, 0) << name << " should not have a byte offset";
+  ICHECK(t->strides == nullptr) << name << " should be compact";
+}
+
+// get_valid_counts(data, score_threshold, id_index, score_index, valid_count, out, out_indices),
+// score_threshold is a float32 scalar on the device.
+TVM_REGISTER_GLOBAL("tvm.contrib.opencl.get_valid_counts")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      DLTensor* data = args[0];
+      void* score_threshold = ScalarBuffer(args[1]);
+      int id_index = args[2];
+      int score_index = args[3];
+      DLTensor* valid_count = args[4];
+      DLTensor* out = args[5];
+      DLTensor* out_indices = args[6];
+      CheckNMSTensor(data, 3, {kDLFloat, 32, 1}, "data");
+      CheckNMSTensor(valid_count, 1, {kDLInt, 32, 1}, "valid_count");
+      CheckNMSTensor(out, 3, {kDLFloat, 32, 1}, "out");
+      CheckNMSTensor(out_indices, 2, {kDLInt, 32, 1}, "out_indices");
+      int batch = static_cast<int>(data->shape[0]);
+      int num_anchors = static_cast<int>(data->shape[1]);
+      int elem_length = static_cast<int>(data->shape[2]);
+      PackedFunc f = GetNMSModule().GetFunction("tvm_ocl_get_valid_counts");
+      f(data->data, valid_count->data, out->data, out_indices->data, score_threshold,
+        num_anchors, elem_length, id_index, score_index, batch, kNMSGroupSize);
+    });
+
+// non_max_suppression(data, valid_count, max_output_size, iou_threshold, force_suppress, top_k,
+//                     coord_start, score_index, id_index, invalid_to_bottom, out),
+// max_output_size and iou_threshold are int32 and float32 scalars on the device.
+TVM_REGISTER_GLOBAL("tvm.contrib.opencl.non_max_suppression")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      DLTensor* data = args[0];
+      DLTensor* valid_count = args[1];
+      void* max_output_size = ScalarBuffer(args[2]);
+      void* iou_threshold = ScalarBuffer(args[3]);
+      bool force_suppress = args[4];
+      int top_k = args[5];
+      int coord_start = args[6];
+      int score_index = args[7];
+      int id_index = args[8];
+      bool invalid_to_bottom = args[9];
+      DLTensor* out = args[10];
+      CheckNMSTensor(data, 3, {kDLFloat, 32, 1}, "data");
+      CheckNMSTensor(valid_count, 1, {kDLInt, 32, 1}, "valid_count");
+      CheckNMSTensor(out, 3, {kDLFloat, 32, 1}, "out");
+      int batch = static_cast<int>(data->shape[0]);
+      int num_anchors = static_cast<int>(data->shape[1]);
+      int elem_length = static_cast<int>(data->shape[2]);
+      ICHECK_LE(coord_start + 4, elem_length);
+      int padded = 1;
+      while (padded < num_anchors) padded <<= 1;
+      // The sort keys and the sorted order of every batch
+      DeviceAPI* api = DeviceAPI::Get(data->ctx);
+      size_t bytes = static_cast<size_t>(batch) * padded * sizeof(float);
+      void* keys = api->AllocWorkspace(data->ctx, bytes, {kDLFloat, 32, 1});
+      void* order = api->AllocWorkspace(data->ctx, bytes, {kDLInt, 32, 1});
+      PackedFunc f = GetNMSModule().GetFunction("tvm_ocl_non_max_suppression");
+      f(data->data, valid_count->data, out->data, keys, order, num_anchors, elem_length, padded,
+        max_output_size, iou_threshold, static_cast<int>(force_suppress), top_k, coord_start,
+        score_index, id_index, static_cast<int>(invalid_to_bottom), batch, kNMSGroupSize);
+      // The next allocation can hand the workspace to a kernel that an out of order queue runs
+      // before this one, it goes back to the pool once the suppression completed.
+      api->StreamSync(data->ctx, cl::OpenCLThreadEntry::ThreadLocal()->stream);
+      api->FreeWorkspace(data->ctx, order);
+      api->FreeWorkspace(data->ctx, keys);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,272 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_sort.cc
+ * \brief OpenCL sort, argsort and topk, with the signatures of tvm.contrib.sort, used as extern
+ *  functions by the OpenCL strategies so that the sorts do not go through the host.
+ *
+ *  Every row along the sorted axis is sorted by one work group with a stable bitonic sort, in
+ *  local memory when the row fits and in a global workspace otherwise.
+ */
+#include <tvm/runtime/data_type.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "opencl_common.h"
+#include "opencl_module.h"
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief The work group size of the sort kernels. */
+static constexpr int kSortGroupSize = 256;
+/*! \brief The longest padded row sorted in local memory, a power of two. */
+static constexpr int kSortLocalSize = 2048;
+
+// The kernel of one (KEY_T, IDX_T) pair, after the definitions of KERNEL, KEY_T, IDX_T,
+// KEY_MIN and KEY_MAX. The first k sorted elements of every row are written to values and indices.
+static const char* kSortKernelSource = R"CLC(
+#define WG 256
+#define LOCAL_SIZE 2048
+
+#define SORT_BEFORE(ka, ia, kb, ib) \
+  (is_ascend ? ((ka) < (kb) || ((ka) == (kb) && (ia) < (ib))) \
+             : ((ka) > (kb) || ((ka) == (kb) && (ia) < (ib))))
+
+#define BITONIC_SORT(K, I, FENCE)                                   \
+  for (int size = 2; size <= padded; size <<= 1) {                 \
+    for (int stride = size >> 1; stride > 0; stride >>= 1) {       \
+      for (int i = t; i < padded / 2; i += WG) {                   \
+        int lo = 2 * i - (i & (stride - 1));                       \
+        int hi = lo + stride;                                      \
+        KEY_T klo = K[lo], khi = K[hi];                            \
+        int ilo = I[lo], ihi = I[hi];                              \
+        bool ordered = SORT_BEFORE(klo, ilo, khi, ihi);            \
+        if (ordered != ((lo & size) == 0)) {                       \
+          K[lo] = khi;                                             \
+          K[hi] = klo;                                             \
+          I[lo] = ihi;                                             \
+          I[hi] = ilo;                                             \
+        }                                                          \
+      }                                                            \
+      barrier(FENCE);                                              \
+    }                                                              \
+  }
+
+__kernel void KERNEL(__global const KEY_T* input, __global KEY_T* values,
+                     __global IDX_T* indices, __global KEY_T* ws_keys, __global int* ws_idx,
+                     int axis_len, int inner, int padded, int k, int is_ascend) {
+  __local KEY_T lkeys[LOCAL_SIZE];
+  __local int lidx[LOCAL_SIZE];
+  int r = get_group_id(0);
+  int t = get_local_id(0);
+  size_t o = r / inner;
+  size_t in_base = o * axis_len * inner + r % inner;
+  size_t out_base = o * k * inner + r % inner;
+  // The padding sorts after every element
+  KEY_T pad = is_ascend ? KEY_MAX : KEY_MIN;
+  if (padded <= LOCAL_SIZE) {
+    for (int i = t; i < padded; i += WG) {
+      lkeys[i] = i < axis_len ? input[in_base + (size_t)i * inner] : pad;
+      lidx[i] = i;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    BITONIC_SORT(lkeys, lidx, CLK_LOCAL_MEM_FENCE)
+    for (int i = t; i < k; i += WG) {
+      if (values) values[out_base + (size_t)i * inner] = lkeys[i];
+      if (indices) indices[out_base + (size_t)i * inner] = (IDX_T)lidx[i];
+    }
+  } else {
+    __global KEY_T* gkeys = ws_keys + (size_t)r * padded;
+    __global int* gidx = ws_idx + (size_t)r * padded;
+    for (int i = t; i < padded; i += WG) {
+      gkeys[i] = i < axis_len ? input[in_base + (size_t)i * inner] : pad;
+      gidx[i] = i;
+    }
+    barrier(CLK_GLOBAL_MEM_FENCE);
+    BITONIC_SORT(gkeys, gidx, CLK_GLOBAL_MEM_FENCE)
+    for (int i = t; i < k; i += WG) {
+      if (values) values[out_base + (size_t)i * inner] = gkeys[i];
+      if (indices) indices[out_base + (size_t)i * inner] = (IDX_T)gidx[i];
+    }
+  }
+}
+)CLC";
+
+/*! \brief The kernel name of a key and an index type, empty when they are not supported. */
+static std::string SortKernelName(DLDataType key, DLDataType idx) {
+  std::string name = "tvm_ocl_sort_";
+  if (key.code == kDLFloat && key.bits == 32) {
+    name += "f32";
+  } else if (key.code == kDLInt && key.bits == 32) {
+    name += "i32";
+  } else {
+    return "";
+  }
+  if (idx.code == kDLInt && idx.bits == 32) {
+    return name + "_i32";
+  } else if (idx.code == kDLInt && idx.bits == 64) {
+    return name + "_i64";
+  } else if (idx.code == kDLFloat && idx.bits == 32) {
+    return name + "_f32";
+  }
+  return "";
+}
+
+/*! \brief The OpenCL module of the sort kernels, built on first use. */
+static Module GetSortModule() {
+  static Module mod = []() {
+    struct Type {
+      DLDataType dtype;
+      const char* cl_type;
+      const char* min_value;
+      const char* max_value;
+    };
+    std::vector<Type> keys{{{kDLFloat, 32, 1}, "float", "-INFINITY", "INFINITY"},
+                           {{kDLInt, 32, 1}, "int", "INT_MIN", "INT_MAX"}};
+    std::vector<Type> idxs{{{kDLInt, 32, 1}, "int", "", ""},
+                           {{kDLInt, 64, 1}, "long", "", ""},
+                           {{kDLFloat, 32, 1}, "float", "", ""}};
+    DLDataType handle{kTVMOpaqueHandle, 64, 1};
+    DLDataType i32{kDLInt, 32, 1};
+    std::unordered_map<std::string, FunctionInfo> fmap;
+    std::string source;
+    for (const Type& key : keys) {
+      for (const Type& idx : idxs) {
+        std::string name = SortKernelName(key.dtype, idx.dtype);
+        fmap[name] = {name,
+                      {handle, handle, handle, handle, handle, i32, i32, i32, i32, i32},
+                      {"blockIdx.x", "threadIdx.x"}};
+        // The module builds every kernel as its own program from its delimited source
+        source += "// Function: " + name + "\n";
+        source += "#define KERNEL " + name + "\n";
+        source += std::string("#define KEY_T ") + key.cl_type + "\n";
+        source += std::string("#define KEY_MIN ") + key.min_value + "\n";
+        source += std::string("#define KEY_MAX ") + key.max_value + "\n";
+        source += std::string("#define IDX_T ") + idx.cl_type + "\n";
+        source += kSortKernelSource;
+      }
+    }
+    return OpenCLModuleCreate(source, "cl", fmap, source);
+  }();
+  return mod;
+}
+
+/*!
+ * \brief Sort every row of the input along an axis and write the first k elements of each.
+ * \param input The input tensor.
+ * \param values The sorted values, or nullptr.
+ * \param indices The indices of the sorted values in the input, or nullptr.
+ * \param k The number of elements written per row, non-positive for the whole row.
+ * \param axis The sorted axis.
+ * \param is_ascend Whether to sort in ascending order.
+ */
+static void OpenCLSort(DLTensor* input, DLTensor* values, DLTensor* indices, int k, int axis,
+                       bool is_ascend) {
+  if (axis < 0) axis += input->ndim;
+  ICHECK(axis >= 0 && axis < input->ndim) << "Axis out of boundary for input ndim " << input->ndim;
+  for (const DLTensor* t : {input, values, indices}) {
+    if (t == nullptr) continue;
+    ICHECK_EQ(t->ctx.device_type, kDLOpenCL) << "The OpenCL sort expects OpenCL tensors";
+    ICHECK_EQ(t->byte_offset, 0) << "The OpenCL sort does not support byte offsets";
+    ICHECK(t->strides == nullptr) << "The OpenCL sort expects compact tensors";
+  }
+  ICHECK(values == nullptr || TypeEqual(values->dtype, input->dtype));
+  DLDataType idx_dtype = indices != nullptr ? indices->dtype : DLDataType{kDLInt, 32, 1};
+  std::string name = SortKernelName(input->dtype, idx_dtype);
+  ICHECK(!name.empty()) << "The OpenCL sort does not support input dtype "
+                        << DLDataType2String(input->dtype) << " with index dtype "
+                        << DLDataType2String(idx_dtype);
+
+  int64_t outer = 1, inner = 1;
+  for (int i = 0; i < axis; ++i) outer *= input->shape[i];
+  for (int i = axis + 1; i < input->ndim; ++i) inner *= input->shape[i];
+  int axis_len = static_cast<int>(input->shape[axis]);
+  if (k < 1 || k > axis_len) k = axis_len;
+  int64_t rows = outer * inner;
+  if (rows == 0 || axis_len == 0) return;
+  int padded = 1;
+  while (padded < axis_len) padded <<= 1;
+
+  DeviceAPI* api = DeviceAPI::Get(input->ctx);
+  void* ws_keys = nullptr;
+  void* ws_idx = nullptr;
+  if (padded > kSortLocalSize) {
+    size_t bytes = static_cast<size_t>(rows) * padded * 4;
+    ws_keys = api->AllocWorkspace(input->ctx, bytes, input->dtype);
+    ws_idx = api->AllocWorkspace(input->ctx, bytes, DLDataType{kDLInt, 32, 1});
+  }
+  PackedFunc f = GetSortModule().GetFunction(name);
+  f(input->data, values != nullptr ? values->data : nullptr,
+    indices != nullptr ? indices->data : nullptr, ws_keys, ws_idx, axis_len,
+    static_cast<int>(inner), padded, k, static_cast<int>(is_ascend), static_cast<int>(rows),
+    kSortGroupSize);
+  // The next allocation can hand the workspace to a kernel that an out of order queue runs
+  // before this one, it goes back to the pool once the sort completed.
+  if (ws_keys != nullptr) {
+    api->StreamSync(input->ctx, cl::OpenCLThreadEntry::ThreadLocal()->stream);
+    api->FreeWorkspace(input->ctx, ws_idx);
+    api->FreeWorkspace(input->ctx, ws_keys);
+  }
+}
+
+TVM_REGISTER_GLOBAL("tvm.contrib.opencl.argsort").set_body([](TVMArgs args, TVMRetValue* ret) {
+  DLTensor* input = args[0];
+  DLTensor* output = args[1];
+  int32_t axis = args[2];
+  bool is_ascend = args[3];
+  OpenCLSort(input, nullptr, output, 0, axis, is_ascend);
+});
+
+TVM_REGISTER_GLOBAL("tvm.contrib.opencl.sort").set_body([](TVMArgs args, TVMRetValue* ret) {
+  DLTensor* input = args[0];
+  DLTensor* output = args[1];
+  int32_t axis = args[2];
+  bool is_ascend = args[3];
+  OpenCLSort(input, output, nullptr, 0, axis, is_ascend);
+});
+
+TVM_REGISTER_GLOBAL("tvm.contrib.opencl.topk").set_body([](TVMArgs args, TVMRetValue* ret) {
+  DLTensor* input = args[0];
+  DLTensor* values_out = nullptr;
+  DLTensor* indices_out = nullptr;
+  int k = args[args.num_args - 4];
+  int axis = args[args.num_args - 3];
+  std::string ret_type = args[args.num_args - 2];
+  bool is_ascend = args[args.num_args - 1];
+  if (ret_type == "both") {
+    values_out = args[1];
+    indices_out = args[2];
+  } else if (ret_type == "values") {
+    values_out = args[1];
+  } else if (ret_type == "indices") {
+    indices_out = args[1];
+  } else {
+    LOG(FATAL) << "Unsupported ret type: " << ret_type;
+  }
+  OpenCLSort(input, values_out, indices_out, k, axis, is_ascend);
+});
+
+}  // namespace runtime
+}  // namespace tvm
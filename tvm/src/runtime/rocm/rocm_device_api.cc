@@ -29,6 +29,7 @@
 #include <tvm/runtime/registry.h>
 #include <tvm/support/logging.h>
 
+#include "../memory_stats.h"
 #include "rocm_common.h"
 
 namespace tvm {
@@ -126,10 +127,12 @@ class ROCMDeviceAPI final : public DeviceAPI {
     ICHECK_EQ(256 % alignment, 0U) << "ROCM space is aligned at 256 bytes";
     void* ret;
     ROCM_CALL(hipMalloc(&ret, nbytes));
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kGlobal, ret, nbytes);
     return ret;
   }
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    MemoryStats::Global()->Free(ctx, MemoryKind::kGlobal, ptr);
     ROCM_CALL(hipSetDevice(ctx.device_id));
     ROCM_CALL(hipFree(ptr));
   }
@@ -202,6 +205,11 @@ TVM_REGISTER_GLOBAL("device_api.rocm").set_body([](TVMArgs args, TVMRetValue* rv
   *rv = static_cast<void*>(ptr);
 });
 
+// The stream the calling thread launches on, null for the default stream.
+TVM_REGISTER_GLOBAL("device_api.rocm.GetStream").set_body_typed([]() {
+  return static_cast<void*>(ROCMThreadEntry::ThreadLocal()->stream);
+});
+
 class ROCMTimerNode : public TimerNode {
  public:
   virtual void Start() {
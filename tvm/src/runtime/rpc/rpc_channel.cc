@@ -22,6 +22,7 @@
  */
 #include "rpc_channel.h"
 
+#include <algorithm>
 #include <string>
 
 namespace tvm {
@@ -49,5 +50,122 @@ size_t CallbackChannel::Recv(void* data, size_t size) {
   return bytes->length();
 }
 
+/*!
+ * \brief The channel of one stream of an RPCMultiplexer.
+ */
+class MultiplexedChannel final : public RPCChannel {
+ public:
+  MultiplexedChannel(std::shared_ptr<RPCMultiplexer> mux, int32_t stream_id)
+      : mux_(std::move(mux)), stream_id_(stream_id) {}
+
+  size_t Send(const void* data, size_t size) final { return mux_->Send(stream_id_, data, size); }
+
+  size_t Recv(void* data, size_t size) final { return mux_->Recv(stream_id_, data, size); }
+
+ private:
+  std::shared_ptr<RPCMultiplexer> mux_;
+  int32_t stream_id_;
+};
+
+/*! \brief The maximum payload of one frame, so that large copies interleave with other streams. */
+static constexpr size_t kMaxFrameBytes = 1 << 20;
+
+std::unique_ptr<RPCChannel> RPCMultiplexer::OpenStream(int32_t stream_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queues_[stream_id];
+  }
+  return std::unique_ptr<RPCChannel>(new MultiplexedChannel(shared_from_this(), stream_id));
+}
+
+int32_t RPCMultiplexer::AcceptStream() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (new_streams_.empty()) {
+    if (closed_) return -1;
+    if (reading_) {
+      cv_.wait(lock);
+    } else {
+      ReadFrame(&lock);
+    }
+  }
+  int32_t stream_id = new_streams_.front();
+  new_streams_.pop_front();
+  return stream_id;
+}
+
+size_t RPCMultiplexer::Send(int32_t stream_id, const void* data, size_t size) {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  uint32_t nbytes = static_cast<uint32_t>(std::min(size, kMaxFrameBytes));
+  const void* parts[] = {&stream_id, &nbytes, data};
+  const size_t sizes[] = {sizeof(stream_id), sizeof(nbytes), nbytes};
+  for (int i = 0; i < 3; ++i) {
+    const char* ptr = static_cast<const char*>(parts[i]);
+    for (size_t sent = 0; sent < sizes[i];) {
+      size_t n = channel_->Send(ptr + sent, sizes[i] - sent);
+      ICHECK_NE(n, 0U) << "RPCMultiplexer: the underlying channel is closed";
+      sent += n;
+    }
+  }
+  return nbytes;
+}
+
+size_t RPCMultiplexer::Recv(int32_t stream_id, void* data, size_t size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    support::RingBuffer& queue = queues_[stream_id];
+    if (queue.bytes_available() != 0) {
+      size_t nbytes = std::min(size, queue.bytes_available());
+      queue.Read(data, nbytes);
+      return nbytes;
+    }
+    if (closed_) return 0;
+    if (reading_) {
+      cv_.wait(lock);
+    } else {
+      ReadFrame(&lock);
+    }
+  }
+}
+
+void RPCMultiplexer::ReadFrame(std::unique_lock<std::mutex>* lock) {
+  reading_ = true;
+  lock->unlock();
+  int32_t stream_id;
+  uint32_t nbytes;
+  std::string payload;
+  bool success = false;
+  try {
+    success = RecvAll(&stream_id, sizeof(stream_id)) && RecvAll(&nbytes, sizeof(nbytes));
+    if (success) {
+      payload.resize(nbytes);
+      success = RecvAll(&payload[0], nbytes);
+    }
+  } catch (const dmlc::Error& e) {
+    // treat a broken underlying channel as closed, so that no stream waits forever.
+    success = false;
+  }
+  lock->lock();
+  reading_ = false;
+  if (success) {
+    if (queues_.count(stream_id) == 0) {
+      new_streams_.push_back(stream_id);
+    }
+    queues_[stream_id].Write(payload.data(), payload.size());
+  } else {
+    closed_ = true;
+  }
+  cv_.notify_all();
+}
+
+bool RPCMultiplexer::RecvAll(void* data, size_t size) {
+  char* ptr = static_cast<char*>(data);
+  for (size_t received = 0; received < size;) {
+    size_t n = channel_->Recv(ptr + received, size - received);
+    if (n == 0) return false;
+    received += n;
+  }
+  return true;
+}
+
 }  // namespace runtime
 }  // namespace tvm
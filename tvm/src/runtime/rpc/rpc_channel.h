@@ -26,8 +26,15 @@
 
 #include <tvm/runtime/packed_func.h>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
+#include "../../support/ring_buffer.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -94,6 +101,77 @@ class CallbackChannel final : public RPCChannel {
   PackedFunc frecv_;
 };
 
+/*!
+ * \brief Multiplexes the channels of several RPC sessions over one underlying channel, so that
+ *  the calls and copies of different sessions can be in flight at the same time on a single
+ *  connection, e.g. the upload of the next tuning candidate during the timing of the current one.
+ *
+ *  Every frame on the underlying channel carries the id of its stream and its size. Each stream
+ *  keeps the request/response order of its own session. Whoever waits for data reads the next
+ *  frame from the underlying channel and queues it for its stream.
+ */
+class RPCMultiplexer : public std::enable_shared_from_this<RPCMultiplexer> {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param channel The underlying channel.
+   */
+  explicit RPCMultiplexer(std::unique_ptr<RPCChannel> channel) : channel_(std::move(channel)) {}
+  /*!
+   * \brief Open the channel of a stream.
+   * \param stream_id The id of the stream, chosen by the client.
+   * \return The channel.
+   */
+  std::unique_ptr<RPCChannel> OpenStream(int32_t stream_id);
+  /*!
+   * \brief Wait for the first frame of a stream that was not opened yet, used by servers.
+   * \return The id of the new stream, -1 when the underlying channel is closed.
+   */
+  int32_t AcceptStream();
+  /*!
+   * \brief Send data as one frame of a stream.
+   * \param stream_id The id of the stream.
+   * \param data The data pointer.
+   * \param size The size of the data.
+   * \return The actual bytes sent.
+   */
+  size_t Send(int32_t stream_id, const void* data, size_t size);
+  /*!
+   * \brief Recv data of a stream.
+   * \param stream_id The id of the stream.
+   * \param data The data pointer.
+   * \param size The size of the data.
+   * \return The actual bytes received, 0 when the underlying channel is closed.
+   */
+  size_t Recv(int32_t stream_id, void* data, size_t size);
+
+ private:
+  /*!
+   * \brief Read the next frame from the underlying channel into the queue of its stream.
+   * \param lock The lock of mutex_, released during the read.
+   */
+  void ReadFrame(std::unique_lock<std::mutex>* lock);
+  /*! \brief Read exactly size bytes from the underlying channel. */
+  bool RecvAll(void* data, size_t size);
+
+  /*! \brief The underlying channel. */
+  std::unique_ptr<RPCChannel> channel_;
+  /*! \brief Serializes the frames sent to the underlying channel. */
+  std::mutex send_mutex_;
+  /*! \brief Protects the stream queues and the reader state. */
+  std::mutex mutex_;
+  /*! \brief Notified when a frame was read. */
+  std::condition_variable cv_;
+  /*! \brief Whether a thread is reading a frame from the underlying channel. */
+  bool reading_{false};
+  /*! \brief Whether the underlying channel is closed. */
+  bool closed_{false};
+  /*! \brief The received bytes of every known stream. */
+  std::unordered_map<int32_t, support::RingBuffer> queues_;
+  /*! \brief The streams seen but not accepted yet. */
+  std::deque<int32_t> new_streams_;
+};
+
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_RPC_RPC_CHANNEL_H_
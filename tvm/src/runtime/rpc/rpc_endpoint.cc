@@ -33,6 +33,8 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -46,6 +48,37 @@
 namespace tvm {
 namespace runtime {
 
+/*! \brief Copies larger than this are streamed in chunks of this size. */
+static constexpr uint64_t kRPCCopyChunkBytes = 4UL << 20;
+/*!
+ * \brief Uploads larger than this are skipped when the remote already holds the same data,
+ *  with TVM_RPC_SKIP_UNCHANGED_UPLOADS=1.
+ */
+static constexpr uint64_t kRPCHashMinBytes = 1UL << 20;
+
+/*!
+ * \brief Hash the content of a tensor, computed by both sides of an endpoint to detect uploads
+ *  of data the remote already holds, e.g. the params set again on every session of a tuning run.
+ * \param data The data pointer.
+ * \param nbytes The number of bytes.
+ * \return The hash value.
+ */
+uint64_t RPCHashBytes(const void* data, uint64_t nbytes) {
+  const char* ptr = static_cast<const char*>(data);
+  uint64_t hash = 0xcbf29ce484222325ULL ^ nbytes;
+  uint64_t i = 0;
+  for (; i + sizeof(uint64_t) <= nbytes; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, ptr + i, sizeof(word));
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 32;
+  }
+  for (; i < nbytes; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(ptr[i])) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
 /*!
  * Event-driven state-machine based handlers for RPCEndpoint.
  *
@@ -447,6 +480,28 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
       }
       this->ReturnVoid();
       this->SwitchToState(kRecvPacketNumBytes);
+    } else if (!sess->IsAsync()) {
+      // The whole packet is buffered at this point, and a synchronous session is done with the
+      // source once the copy returns, so copy straight out of the receive buffer instead of
+      // staging the payload in the arena first.
+      char* dptr = this->PeekBytes(data_bytes);
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        dmlc::ByteSwap(dptr, elem_bytes, data_bytes / elem_bytes);
+      }
+      std::string error;
+      try {
+        sess->CopyToRemote(dptr, arr, data_bytes);
+      } catch (const std::runtime_error& e) {
+        error = e.what();
+      }
+      this->SkipBytes(data_bytes);
+
+      if (error.empty()) {
+        this->ReturnVoid();
+      } else {
+        this->ReturnException(error.c_str());
+      }
+      this->SwitchToState(kRecvPacketNumBytes);
     } else {
       char* temp_data = this->ArenaAlloc<char>(data_bytes);
       this->ReadArray(temp_data, data_bytes);
@@ -604,6 +659,17 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     pending_request_bytes_ -= size;
     return size;
   }
+  // Get the next bytes of the packet in place, they are consumed by SkipBytes.
+  char* PeekBytes(size_t size) {
+    ICHECK_LE(size, pending_request_bytes_);
+    return reader_->Peek(size);
+  }
+  // Consume bytes of the packet without copying them out, update pending_request_bytes_
+  void SkipBytes(size_t size) {
+    ICHECK_LE(size, pending_request_bytes_);
+    reader_->Skip(size);
+    pending_request_bytes_ -= size;
+  }
   // wriite the data to the channel.
   void Write(const void* data, size_t size) final { writer_->Write(data, size); }
   // Number of pending bytes requests
@@ -661,6 +727,9 @@ void RPCEndpoint::Init() {
   // Event handler
   handler_ = std::make_shared<EventHandler>(&reader_, &writer_, name_, &remote_key_, flush_writer);
 
+  const char* skip_unchanged = getenv("TVM_RPC_SKIP_UNCHANGED_UPLOADS");
+  remote_hash_data_ = skip_unchanged != nullptr && atoi(skip_unchanged) != 0;
+
   // Quick function to for syscall remote.
   syscall_remote_ = PackedFunc([this](TVMArgs all_args, TVMRetValue* rv) {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -798,34 +867,23 @@ void RPCEndpoint::CallFunc(RPCSession::PackedFuncHandle h, const TVMValue* arg_v
   ICHECK(code == RPCCode::kReturn) << "code=" << static_cast<int>(code);
 }
 
-void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes) {
-  std::lock_guard<std::mutex> lock(mutex_);
+void RPCEndpoint::WriteCopyToRemote(const char* from_bytes, DLTensor* to, uint64_t nbytes) {
   RPCCode code = RPCCode::kCopyToRemote;
-
-  uint64_t num_data_bytes = static_cast<uint64_t>(GetDataSize(*to));
-  ICHECK_EQ(nbytes, num_data_bytes);
-
   uint64_t to_data = reinterpret_cast<uint64_t>(to->data);
   uint64_t shape_bytes = to->ndim * sizeof(int64_t);
   uint64_t packet_nbytes = sizeof(code) + sizeof(to_data) + sizeof(to->ctx) + sizeof(to->ndim) +
                            sizeof(to->dtype) + sizeof(to->byte_offset) + shape_bytes +
-                           sizeof(nbytes) + num_data_bytes;
+                           sizeof(nbytes) + nbytes;
 
   handler_->Write(packet_nbytes);
   handler_->Write(code);
   RPCReference::SendDLTensor(handler_, to);
   handler_->Write(nbytes);
-  handler_->WriteArray(reinterpret_cast<char*>(from_bytes), nbytes);
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+  handler_->WriteArray(from_bytes, nbytes);
 }
 
-void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes) {
-  std::lock_guard<std::mutex> lock(mutex_);
+void RPCEndpoint::WriteCopyFromRemote(DLTensor* from, uint64_t nbytes) {
   RPCCode code = RPCCode::kCopyFromRemote;
-
-  uint64_t num_data_bytes = static_cast<uint64_t>(GetDataSize(*from));
-  CHECK_EQ(nbytes, num_data_bytes);
-
   uint64_t from_data = reinterpret_cast<uint64_t>(from->data);
   uint64_t shape_bytes = from->ndim * sizeof(int64_t);
   uint64_t packet_nbytes = sizeof(code) + sizeof(from_data) + sizeof(from->ctx) +
@@ -836,10 +894,135 @@ void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes
   handler_->Write(code);
   RPCReference::SendDLTensor(handler_, from);
   handler_->Write(nbytes);
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
+}
 
-  handler_->ReadArray(reinterpret_cast<char*>(to_bytes), nbytes);
-  handler_->FinishCopyAck();
+bool RPCEndpoint::RemoteHoldsData(const void* from_bytes, DLTensor* to, uint64_t nbytes) {
+  if (!remote_hash_data_) return false;
+  uint64_t local_hash = RPCHashBytes(from_bytes, nbytes);
+  int64_t remote_hash;
+  try {
+    remote_hash = SysCallRemote(RPCCode::kDevHashData, to);
+  } catch (const dmlc::Error& e) {
+    // The remote cannot hash its data, e.g. it is a proxy or a minrpc server.
+    remote_hash_data_ = false;
+    return false;
+  }
+  if (static_cast<uint64_t>(remote_hash) != local_hash) return false;
+  // The hash only rules out changes, a match is confirmed on the bytes themselves. The
+  // download avoids the write of the remote copy, e.g. into textures.
+  std::vector<char> remote_bytes(nbytes);
+  CopyFromRemote(to, remote_bytes.data(), nbytes);
+  return std::memcmp(remote_bytes.data(), from_bytes, nbytes) == 0;
+}
+
+void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes) {
+  uint64_t num_data_bytes = static_cast<uint64_t>(GetDataSize(*to));
+  ICHECK_EQ(nbytes, num_data_bytes);
+
+  if (nbytes >= kRPCHashMinBytes && RemoteHoldsData(from_bytes, to, nbytes)) return;
+
+  if (nbytes <= kRPCCopyChunkBytes || to->dtype.bits * to->dtype.lanes % 8 != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteCopyToRemote(static_cast<const char*>(from_bytes), to, nbytes);
+    ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+  } else if (to->ctx.device_type == kDLCPU) {
+    CopyChunksToRemote(static_cast<const char*>(from_bytes), *to, nbytes);
+  } else {
+    // Device memory such as textures cannot be viewed by chunks, stream into a cpu staging
+    // buffer of the remote instead and copy it to the device in one go.
+    TVMContext cpu_ctx{kDLCPU, 0};
+    DLTensor staging = *to;
+    staging.data = SysCallRemote(RPCCode::kDevAllocData, cpu_ctx, nbytes, kAllocAlignment,
+                                 to->dtype);
+    staging.ctx = cpu_ctx;
+    staging.strides = nullptr;
+    staging.byte_offset = 0;
+    CopyChunksToRemote(static_cast<const char*>(from_bytes), staging, nbytes);
+    SysCallRemote(RPCCode::kCopyAmongRemote, &staging, to, nullptr);
+    SysCallRemote(RPCCode::kDevStreamSync, to->ctx, nullptr);
+    SysCallRemote(RPCCode::kDevFreeData, cpu_ctx, staging.data);
+  }
+}
+
+void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes) {
+  uint64_t num_data_bytes = static_cast<uint64_t>(GetDataSize(*from));
+  CHECK_EQ(nbytes, num_data_bytes);
+
+  if (nbytes <= kRPCCopyChunkBytes || from->dtype.bits * from->dtype.lanes % 8 != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteCopyFromRemote(from, nbytes);
+    ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
+    handler_->ReadArray(reinterpret_cast<char*>(to_bytes), nbytes);
+    handler_->FinishCopyAck();
+  } else if (from->ctx.device_type == kDLCPU) {
+    CopyChunksFromRemote(*from, static_cast<char*>(to_bytes), nbytes);
+  } else {
+    TVMContext cpu_ctx{kDLCPU, 0};
+    DLTensor staging = *from;
+    staging.data = SysCallRemote(RPCCode::kDevAllocData, cpu_ctx, nbytes, kAllocAlignment,
+                                 from->dtype);
+    staging.ctx = cpu_ctx;
+    staging.strides = nullptr;
+    staging.byte_offset = 0;
+    SysCallRemote(RPCCode::kCopyAmongRemote, from, &staging, nullptr);
+    SysCallRemote(RPCCode::kDevStreamSync, from->ctx, nullptr);
+    CopyChunksFromRemote(staging, static_cast<char*>(to_bytes), nbytes);
+    SysCallRemote(RPCCode::kDevFreeData, cpu_ctx, staging.data);
+  }
+}
+
+void RPCEndpoint::CopyChunksToRemote(const char* from_bytes, const DLTensor& to,
+                                     uint64_t nbytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t elem_bytes = to.dtype.bits * to.dtype.lanes / 8;
+  uint64_t chunk_bytes = kRPCCopyChunkBytes / elem_bytes * elem_bytes;
+  // Every chunk is sent as a flat view of the remote cpu memory.
+  int64_t chunk_shape;
+  DLTensor chunk = to;
+  chunk.ndim = 1;
+  chunk.shape = &chunk_shape;
+  chunk.strides = nullptr;
+  for (uint64_t offset = 0; offset < nbytes; offset += chunk_bytes) {
+    uint64_t size = std::min(chunk_bytes, nbytes - offset);
+    chunk_shape = static_cast<int64_t>(size / elem_bytes);
+    chunk.byte_offset = to.byte_offset + offset;
+    WriteCopyToRemote(from_bytes + offset, &chunk, size);
+    // Only wait for the ack of the previous chunk once the current one is queued, so that
+    // the remote copies a chunk while the next one is on the wire.
+    if (offset != 0) {
+      ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+    }
+  }
+  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+}
+
+void RPCEndpoint::CopyChunksFromRemote(const DLTensor& from, char* to_bytes, uint64_t nbytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t elem_bytes = from.dtype.bits * from.dtype.lanes / 8;
+  uint64_t chunk_bytes = kRPCCopyChunkBytes / elem_bytes * elem_bytes;
+  int64_t chunk_shape;
+  DLTensor chunk = from;
+  chunk.ndim = 1;
+  chunk.shape = &chunk_shape;
+  chunk.strides = nullptr;
+  auto fread_ack = [this, to_bytes](uint64_t offset, uint64_t size) {
+    ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
+    handler_->ReadArray(to_bytes + offset, size);
+    handler_->FinishCopyAck();
+  };
+  uint64_t prev_offset = 0, prev_size = 0;
+  for (uint64_t offset = 0; offset < nbytes; offset += chunk_bytes) {
+    uint64_t size = std::min(chunk_bytes, nbytes - offset);
+    chunk_shape = static_cast<int64_t>(size / elem_bytes);
+    chunk.byte_offset = from.byte_offset + offset;
+    WriteCopyFromRemote(&chunk, size);
+    // Request the next chunk before reading the current one, so that the remote reads it
+    // while the current one is on the wire.
+    if (offset != 0) fread_ack(prev_offset, prev_size);
+    prev_offset = offset;
+    prev_size = size;
+  }
+  fread_ack(prev_offset, prev_size);
 }
 
 // SysCallEventHandler functions
@@ -921,6 +1104,20 @@ void RPCCopyAmongRemote(RPCSession* handler, TVMArgs args, TVMRetValue* rv) {
   handler->GetDeviceAPI(ctx)->CopyDataFromTo(from, to, stream);
 }
 
+void RPCDevHashData(RPCSession* handler, TVMArgs args, TVMRetValue* rv) {
+  DLTensor* arr = args[0];
+  ICHECK(handler->IsLocalSession()) << "HashData is only supported by local sessions";
+  uint64_t nbytes = GetDataSize(*arr);
+  if (arr->ctx.device_type == kDLCPU) {
+    *rv = static_cast<int64_t>(
+        RPCHashBytes(static_cast<char*>(arr->data) + arr->byte_offset, nbytes));
+  } else {
+    std::vector<char> temp(nbytes);
+    handler->CopyFromRemote(arr, temp.data(), nbytes);
+    *rv = static_cast<int64_t>(RPCHashBytes(temp.data(), nbytes));
+  }
+}
+
 void RPCEndpoint::EventHandler::HandleSyscall(RPCCode code) {
   // Event handler sit at clean state at this point.
   switch (code) {
@@ -952,6 +1149,9 @@ void RPCEndpoint::EventHandler::HandleSyscall(RPCCode code) {
     case RPCCode::kCopyAmongRemote:
       SysCallHandler(RPCCopyAmongRemote);
       break;
+    case RPCCode::kDevHashData:
+      SysCallHandler(RPCDevHashData);
+      break;
     default:
       LOG(FATAL) << "Unknown event " << static_cast<int>(code);
   }
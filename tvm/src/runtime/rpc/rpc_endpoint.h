@@ -47,6 +47,8 @@ const int kRPCTrackerMagic = 0x2f271;
 const int kRPCSuccess = kRPCMagic + 0;
 // cannot found matched key in server
 const int kRPCMismatch = kRPCMagic + 2;
+// first bytes sent by a client to multiplex several sessions over the connection
+const uint64_t kRPCMultiplexMagic = 0xff271ff271ff271ULL;
 
 /*! \brief Enumeration code for the RPC tracker */
 enum class TrackerCode : int {
@@ -127,6 +129,7 @@ class RPCEndpoint {
                 const int* arg_type_codes, int num_args, RPCSession::FEncodeReturn encode_return);
   /*!
    * \brief Copy bytes into remote array content.
+   *  Large copies are streamed in chunks, and skipped when the remote already holds the data.
    * \param from The source host data.
    * \param from_offset The byte offeset in the from.
    * \param to The target array.
@@ -137,7 +140,7 @@ class RPCEndpoint {
    */
   void CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes);
   /*!
-   * \brief Copy bytes from remote array content.
+   * \brief Copy bytes from remote array content. Large copies are streamed in chunks.
    * \param from The source host data.
    * \param from_offset The byte offeset in the from.
    * \param to The target array.
@@ -172,6 +175,16 @@ class RPCEndpoint {
   // Handle events until receives a return
   // Also flushes channels so that the function advances.
   RPCCode HandleUntilReturnEvent(bool client_mode, RPCSession::FEncodeReturn setreturn);
+  // Write a copy to remote packet without waiting for its return.
+  void WriteCopyToRemote(const char* from_bytes, DLTensor* to, uint64_t nbytes);
+  // Write a copy from remote packet without waiting for its ack.
+  void WriteCopyFromRemote(DLTensor* from, uint64_t nbytes);
+  // Stream a copy into remote cpu memory by chunks, keeping one chunk in flight.
+  void CopyChunksToRemote(const char* from_bytes, const DLTensor& to, uint64_t nbytes);
+  // Stream a copy from remote cpu memory by chunks, keeping one chunk in flight.
+  void CopyChunksFromRemote(const DLTensor& from, char* to_bytes, uint64_t nbytes);
+  // Whether the remote array already holds the given bytes.
+  bool RemoteHoldsData(const void* from_bytes, DLTensor* to, uint64_t nbytes);
   // Initalization
   void Init();
   // Shutdown
@@ -190,6 +203,9 @@ class RPCEndpoint {
   std::string name_;
   // The remote key
   std::string remote_key_;
+  // Whether to skip the uploads of data the remote already holds, set by
+  // TVM_RPC_SKIP_UNCHANGED_UPLOADS=1 and cleared when the remote cannot hash its data.
+  bool remote_hash_data_{false};
 };
 
 /*!
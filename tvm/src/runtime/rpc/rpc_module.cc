@@ -26,8 +26,15 @@
 #include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <limits>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
 #if defined(_M_X64) || defined(__x86_64__)
 #include <immintrin.h>
 #endif
@@ -207,6 +214,27 @@ class RPCModuleNode final : public ModuleNode {
     }
   }
 
+  PackedFunc GetAdaptiveTimeEvaluator(const std::string& name, TVMContext ctx, int number,
+                                      int min_repeat, int max_repeat, int min_repeat_ms,
+                                      double max_rel_ci, double cooldown_ms,
+                                      const std::string& f_preproc_name) {
+    InitRemoteFunc(&remote_get_adaptive_time_evaluator_, "runtime.RPCAdaptiveTimeEvaluator");
+    // Remove session mask because we pass ctx by parts.
+    ICHECK_EQ(GetRPCSessionIndex(ctx), sess_->table_index())
+        << "ValueError: Need to pass the matched remote context to "
+        << "RPCModule.GetAdaptiveTimeEvaluator";
+    ctx = RemoveRPCSessionMask(ctx);
+
+    Optional<Module> mod;
+    if (module_handle_ != nullptr) {
+      mod = GetRef<Module>(this);
+    }
+    return remote_get_adaptive_time_evaluator_(mod, name, static_cast<int>(ctx.device_type),
+                                               ctx.device_id, number, min_repeat, max_repeat,
+                                               min_repeat_ms, max_rel_ci, cooldown_ms,
+                                               f_preproc_name);
+  }
+
   Module LoadModule(std::string name) {
     InitRemoteFunc(&remote_load_module_, "tvm.rpc.server.load_module");
     return remote_load_module_(name);
@@ -243,6 +271,10 @@ class RPCModuleNode final : public ModuleNode {
   // remote function to get time evaluator
   TypedPackedFunc<PackedFunc(Optional<Module>, std::string, int, int, int, int, int, std::string)>
       remote_get_time_evaluator_;
+  // remote function to get adaptive time evaluator
+  TypedPackedFunc<PackedFunc(Optional<Module>, std::string, int, int, int, int, int, int, double,
+                             double, std::string)>
+      remote_get_adaptive_time_evaluator_;
   // remote function getter for modules.
   TypedPackedFunc<PackedFunc(Module, std::string, bool)> remote_mod_get_function_;
   // remote function getter for load module
@@ -342,6 +374,34 @@ inline void CPUCacheFlush(int begin_index, const TVMArgs& args) {
   }
 }
 
+/*!
+ * \brief Time one repeat of pf, growing number until the repeat lasts min_repeat_ms.
+ * \return The average cost of one run in seconds.
+ */
+static double TimeOneRepeat(const PackedFunc& pf, TVMContext ctx, const TVMArgs& args,
+                            int* number, int min_repeat_ms) {
+  TVMRetValue temp;
+  double duration_ms = 0.0;
+
+  do {
+    if (duration_ms > 0.0) {
+      *number = static_cast<int>(std::max((min_repeat_ms / (duration_ms / *number) + 1),
+                                          *number * 1.618));  // 1.618 is chosen by random
+    }
+
+    Timer t = Timer::Start(ctx);
+    // start timing
+    for (int i = 0; i < *number; ++i) {
+      pf.CallPacked(args, &temp);
+    }
+    t->Stop();
+    int64_t t_nanos = t->SyncAndGetElapsedNanos();
+    duration_ms = t_nanos / 1e6;
+  } while (duration_ms < min_repeat_ms);
+
+  return duration_ms / 1e3 / *number;
+}
+
 PackedFunc WrapTimeEvaluator(PackedFunc pf, TVMContext ctx, int number, int repeat,
                              int min_repeat_ms, PackedFunc f_preproc) {
   ICHECK(pf != nullptr);
@@ -365,26 +425,60 @@ PackedFunc WrapTimeEvaluator(PackedFunc pf, TVMContext ctx, int number, int repe
       if (f_preproc != nullptr) {
         f_preproc.CallPacked(args, &temp);
       }
-      double duration_ms = 0.0;
+      double speed = TimeOneRepeat(pf, ctx, args, &number, min_repeat_ms);
+      os.write(reinterpret_cast<char*>(&speed), sizeof(speed));
+    }
 
-      do {
-        if (duration_ms > 0.0) {
-          number = static_cast<int>(std::max((min_repeat_ms / (duration_ms / number) + 1),
-                                             number * 1.618));  // 1.618 is chosen by random
-        }
+    std::string blob = os.str();
+    TVMByteArray arr;
+    arr.size = blob.length();
+    arr.data = blob.data();
+    // return the time.
+    *rv = arr;
+  };
+  return PackedFunc(ftimer);
+}
 
-        Timer t = Timer::Start(ctx);
-        // start timing
-        for (int i = 0; i < number; ++i) {
-          pf.CallPacked(args, &temp);
-        }
-        t->Stop();
-        int64_t t_nanos = t->SyncAndGetElapsedNanos();
-        duration_ms = t_nanos / 1e6;
-      } while (duration_ms < min_repeat_ms);
+PackedFunc WrapAdaptiveTimeEvaluator(PackedFunc pf, TVMContext ctx, int number, int min_repeat,
+                                     int max_repeat, int min_repeat_ms, double max_rel_ci,
+                                     double cooldown_ms, PackedFunc f_preproc) {
+  ICHECK(pf != nullptr);
+  ICHECK_GE(min_repeat, 2) << "At least two repeats are needed to estimate the variance";
+  ICHECK_GE(max_repeat, min_repeat);
+
+  auto ftimer = [pf, ctx, number, min_repeat, max_repeat, min_repeat_ms, max_rel_ci, cooldown_ms,
+                 f_preproc](TVMArgs args, TVMRetValue* rv) mutable {
+    TVMRetValue temp;
+    std::ostringstream os;
+    // skip first time call, to activate lazy compilation components.
+    pf.CallPacked(args, &temp);
 
-      double speed = duration_ms / 1e3 / number;
+    DeviceAPI::Get(ctx)->StreamSync(ctx, nullptr);
+
+    double sum = 0.0, sum_sq = 0.0;
+    for (int i = 0; i < max_repeat; ++i) {
+      if (i > 0 && cooldown_ms > 0) {
+        // Let the SoC cool down so that later repeats are not throttled by the earlier ones
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(cooldown_ms));
+      }
+      if (f_preproc != nullptr) {
+        f_preproc.CallPacked(args, &temp);
+      }
+      double speed = TimeOneRepeat(pf, ctx, args, &number, min_repeat_ms);
       os.write(reinterpret_cast<char*>(&speed), sizeof(speed));
+
+      sum += speed;
+      sum_sq += speed * speed;
+      int n = i + 1;
+      if (n >= min_repeat) {
+        double mean = sum / n;
+        double var = std::max(0.0, (sum_sq - n * mean * mean) / (n - 1));
+        // Half width of the 95% confidence interval of the mean, relative to the mean
+        double rel_ci = 1.96 * std::sqrt(var / n) / mean;
+        if (rel_ci <= max_rel_ci) {
+          break;
+        }
+      }
     }
 
     std::string blob = os.str();
@@ -434,6 +528,96 @@ TVM_REGISTER_GLOBAL("runtime.RPCTimeEvaluator")
       }
     });
 
+TVM_REGISTER_GLOBAL("runtime.RPCAdaptiveTimeEvaluator")
+    .set_body_typed([](Optional<Module> opt_mod, std::string name, int device_type, int device_id,
+                       int number, int min_repeat, int max_repeat, int min_repeat_ms,
+                       double max_rel_ci, double cooldown_ms, std::string f_preproc_name) {
+      TVMContext ctx;
+      ctx.device_type = static_cast<DLDeviceType>(device_type);
+      ctx.device_id = device_id;
+      if (opt_mod.defined() && opt_mod.value()->type_key() == std::string("rpc")) {
+        return static_cast<RPCModuleNode*>(opt_mod.value().operator->())
+            ->GetAdaptiveTimeEvaluator(name, ctx, number, min_repeat, max_repeat, min_repeat_ms,
+                                       max_rel_ci, cooldown_ms, f_preproc_name);
+      }
+      PackedFunc f_preproc;
+      if (!f_preproc_name.empty()) {
+        auto* pf_preproc = runtime::Registry::Get(f_preproc_name);
+        ICHECK(pf_preproc != nullptr)
+            << "Cannot find " << f_preproc_name << " in the global function";
+        f_preproc = *pf_preproc;
+      }
+      PackedFunc pf;
+      if (opt_mod.defined()) {
+        pf = opt_mod.value().GetFunction(name, false);
+      } else {
+        auto* f = runtime::Registry::Get(name);
+        ICHECK(f != nullptr) << "Cannot find " << name << " in the global function";
+        pf = *f;
+      }
+      return WrapAdaptiveTimeEvaluator(pf, ctx, number, min_repeat, max_repeat, min_repeat_ms,
+                                       max_rel_ci, cooldown_ms, f_preproc);
+    });
+
+// Time a batch of candidate modules in one call, so that the client pays one round trip for
+// all of them instead of the upload, load, get function and timing round trips of each one.
+//
+// Arguments: a comma separated list of module files in the work path, the function name,
+// device_type, device_id, number, repeat, min_repeat_ms and f_preproc_name, followed by the
+// arguments of the function which are shared by all the candidates.
+// Returns the costs of all the candidates one after another, `repeat` doubles per candidate,
+// NaN for the candidates that failed to load or run.
+TVM_REGISTER_GLOBAL("runtime.RPCTimeEvaluatorBatch").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ICHECK_GE(args.size(), 8);
+  std::string file_names = args[0];
+  std::string name = args[1];
+  TVMContext ctx;
+  ctx.device_type = static_cast<DLDeviceType>(args[2].operator int());
+  ctx.device_id = args[3];
+  int number = args[4];
+  int repeat = args[5];
+  int min_repeat_ms = args[6];
+  std::string f_preproc_name = args[7];
+  TVMArgs func_args(args.values + 8, args.type_codes + 8, args.size() - 8);
+
+  const auto* fload = runtime::Registry::Get("tvm.rpc.server.load_module");
+  ICHECK(fload != nullptr) << "Cannot find tvm.rpc.server.load_module in the global function";
+  PackedFunc f_preproc;
+  if (!f_preproc_name.empty()) {
+    auto* pf_preproc = runtime::Registry::Get(f_preproc_name);
+    ICHECK(pf_preproc != nullptr) << "Cannot find " << f_preproc_name << " in the global function";
+    f_preproc = *pf_preproc;
+  }
+
+  std::ostringstream os;
+  std::istringstream is(file_names);
+  std::string file_name;
+  while (std::getline(is, file_name, ',')) {
+    if (file_name.empty()) continue;
+    try {
+      Module m = (*fload)(file_name);
+      PackedFunc ftimer = WrapTimeEvaluator(m.GetFunction(name, false), ctx, number, repeat,
+                                            min_repeat_ms, f_preproc);
+      TVMRetValue ret;
+      ftimer.CallPacked(func_args, &ret);
+      std::string blob = ret;
+      os.write(blob.data(), blob.size());
+    } catch (const dmlc::Error& e) {
+      LOG(WARNING) << "Failed to time " << file_name << ": " << e.what();
+      double cost = std::numeric_limits<double>::quiet_NaN();
+      for (int i = 0; i < repeat; ++i) {
+        os.write(reinterpret_cast<char*>(&cost), sizeof(cost));
+      }
+    }
+  }
+
+  std::string blob = os.str();
+  TVMByteArray arr;
+  arr.size = blob.length();
+  arr.data = blob.data();
+  *rv = arr;
+});
+
 TVM_REGISTER_GLOBAL("cache_flush_cpu_non_first_arg").set_body([](TVMArgs args, TVMRetValue* rv) {
   CPUCacheFlush(1, args);
 });
@@ -305,6 +305,27 @@ struct RemoteSpace {
 PackedFunc WrapTimeEvaluator(PackedFunc f, TVMContext ctx, int number, int repeat,
                              int min_repeat_ms, PackedFunc f_preproc = nullptr);
 
+/*!
+ * \brief Wrap a timer function that keeps repeating the measurement until the timings are
+ *  stable, for devices whose speed drifts, e.g. phones that throttle as the SoC heats up.
+ * \param f The function argument.
+ * \param ctx The context.
+ * \param number The number of times to run this function for taking average, adjusted as in
+ *        WrapTimeEvaluator to meet min_repeat_ms.
+ * \param min_repeat The minimum number of repeats, at least 2.
+ * \param max_repeat The maximum number of repeats.
+ * \param min_repeat_ms The minimum duration of one `repeat` in milliseconds.
+ * \param max_rel_ci Stop repeating once the half width of the 95% confidence interval of the
+ *        mean cost falls below this fraction of the mean.
+ * \param cooldown_ms The idle time between two repeats in milliseconds.
+ * \param f_preproc The function to be executed before every repeat.
+ * \return f_timer A timer function. It returns one cost per executed repeat, in the same format as
+ *         WrapTimeEvaluator, so the spread of the costs shows how stable the measurement was.
+ */
+PackedFunc WrapAdaptiveTimeEvaluator(PackedFunc f, TVMContext ctx, int number, int min_repeat,
+                                     int max_repeat, int min_repeat_ms, double max_rel_ci,
+                                     double cooldown_ms, PackedFunc f_preproc = nullptr);
+
 /*!
  * \brief Create a Global RPC module that refers to the session.
  * \param sess The RPC session of the global module.
@@ -25,6 +25,9 @@
 #include <tvm/runtime/registry.h>
 
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "../../support/socket.h"
 #include "rpc_endpoint.h"
@@ -65,8 +68,8 @@ class SockChannel final : public RPCChannel {
   support::TCPSocket sock_;
 };
 
-std::shared_ptr<RPCEndpoint> RPCConnect(std::string url, int port, std::string key,
-                                        TVMArgs init_seq) {
+support::TCPSocket RPCConnectSocket(const std::string& url, int port, const std::string& key,
+                                    std::string* remote_key) {
   support::TCPSocket sock;
   support::SockAddr addr(url.c_str(), port);
   sock.Create(addr.ss_family());
@@ -92,25 +95,92 @@ std::shared_ptr<RPCEndpoint> RPCConnect(std::string url, int port, std::string k
     LOG(FATAL) << "URL " << url << ":" << port << " is not TVM RPC server";
   }
   ICHECK_EQ(sock.RecvAll(&keylen, sizeof(keylen)), sizeof(keylen));
-  std::string remote_key;
   if (keylen != 0) {
-    remote_key.resize(keylen);
-    ICHECK_EQ(sock.RecvAll(&remote_key[0], keylen), keylen);
+    remote_key->resize(keylen);
+    ICHECK_EQ(sock.RecvAll(&(*remote_key)[0], keylen), keylen);
   }
+  return sock;
+}
+
+std::shared_ptr<RPCEndpoint> RPCConnect(std::string url, int port, std::string key,
+                                        TVMArgs init_seq) {
+  std::string remote_key;
+  support::TCPSocket sock = RPCConnectSocket(url, port, key, &remote_key);
   auto endpt =
       RPCEndpoint::Create(std::unique_ptr<SockChannel>(new SockChannel(sock)), key, remote_key);
   endpt->InitRemoteSession(init_seq);
   return endpt;
 }
 
+/*!
+ * \brief Connect several sessions multiplexed over a single connection.
+ * \param url The url of the server.
+ * \param port The port of the server.
+ * \param key The key of the connection.
+ * \param num_sessions The number of sessions.
+ * \param init_seq The initialization sequence of every session.
+ * \return The session modules, whose calls and copies can be in flight at the same time.
+ */
+Array<Module> RPCClientConnectMultiplexed(std::string url, int port, std::string key,
+                                          int num_sessions, TVMArgs init_seq) {
+  std::string remote_key;
+  support::TCPSocket sock = RPCConnectSocket(url, port, "client:" + key, &remote_key);
+  uint64_t magic = kRPCMultiplexMagic;
+  ICHECK_EQ(sock.SendAll(&magic, sizeof(magic)), sizeof(magic));
+  auto mux = std::make_shared<RPCMultiplexer>(
+      std::unique_ptr<SockChannel>(new SockChannel(sock)));
+  Array<Module> sessions;
+  for (int i = 0; i < num_sessions; ++i) {
+    auto endpt = RPCEndpoint::Create(mux->OpenStream(i), "client:" + key, remote_key);
+    endpt->InitRemoteSession(init_seq);
+    sessions.push_back(CreateRPCSessionModule(CreateClientSession(endpt)));
+  }
+  return sessions;
+}
+
 Module RPCClientConnect(std::string url, int port, std::string key, TVMArgs init_seq) {
   auto endpt = RPCConnect(url, port, "client:" + key, init_seq);
   return CreateRPCSessionModule(CreateClientSession(endpt));
 }
 
+/*!
+ * \brief Serve every session multiplexed over a connection in its own thread.
+ * \param sock The socket of the connection.
+ */
+void RPCMultiplexedServerLoop(support::TCPSocket sock) {
+  auto mux = std::make_shared<RPCMultiplexer>(
+      std::unique_ptr<SockChannel>(new SockChannel(sock)));
+  std::vector<std::thread> threads;
+  for (int32_t stream_id = mux->AcceptStream(); stream_id >= 0;
+       stream_id = mux->AcceptStream()) {
+    threads.emplace_back([mux, stream_id]() {
+      try {
+        RPCEndpoint::Create(mux->OpenStream(stream_id), "MultiplexedServerLoop", "")
+            ->ServerLoop();
+      } catch (const dmlc::Error& e) {
+        LOG(WARNING) << "Session " << stream_id << " of the connection failed: " << e.what();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 // TVM_DLL needed for MSVC
 TVM_DLL void RPCServerLoop(int sockfd) {
   support::TCPSocket sock(static_cast<support::TCPSocket::SockType>(sockfd));
+  // A multiplexed connection starts with a magic that is never a valid packet size.
+  uint64_t magic = 0;
+  ssize_t npeek;
+  do {
+    npeek = sock.Recv(&magic, sizeof(magic), MSG_PEEK);
+  } while (npeek > 0 && static_cast<size_t>(npeek) < sizeof(magic));
+  if (static_cast<size_t>(npeek) == sizeof(magic) && magic == kRPCMultiplexMagic) {
+    ICHECK_EQ(sock.RecvAll(&magic, sizeof(magic)), sizeof(magic));
+    RPCMultiplexedServerLoop(sock);
+    return;
+  }
   RPCEndpoint::Create(std::unique_ptr<SockChannel>(new SockChannel(sock)), "SockServerLoop", "")
       ->ServerLoop();
 }
@@ -129,6 +199,15 @@ TVM_REGISTER_GLOBAL("rpc.Connect").set_body([](TVMArgs args, TVMRetValue* rv) {
                          TVMArgs(args.values + 3, args.type_codes + 3, args.size() - 3));
 });
 
+TVM_REGISTER_GLOBAL("rpc.ConnectMultiplexed").set_body([](TVMArgs args, TVMRetValue* rv) {
+  std::string url = args[0];
+  int port = args[1];
+  std::string key = args[2];
+  int num_sessions = args[3];
+  *rv = RPCClientConnectMultiplexed(url, port, key, num_sessions,
+                                    TVMArgs(args.values + 4, args.type_codes + 4, args.size() - 4));
+});
+
 TVM_REGISTER_GLOBAL("rpc.ServerLoop").set_body([](TVMArgs args, TVMRetValue* rv) {
   if (args[0].type_code() == kDLInt) {
     RPCServerLoop(args[0]);
@@ -27,6 +27,9 @@
 #include <tvm/runtime/device_api.h>
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace tvm {
@@ -38,6 +41,8 @@ struct Texture2DShape {
   T width;
   T height;
   T channel;
+  /*! \brief The number of images of a texture array, 1 for a single image */
+  T depth{1};
 };
 
 /*!
@@ -52,8 +57,10 @@ inline size_t DefaultTextureLayoutSeparator(size_t shape_rank, std::string conve
   // e.g. [O,I,H,W,c] -> Texture2d[O, I*H*W, c]
   // Texture nhwc:
   // e.g. [N,H,W,C] -> Texture2d[N*H, W*C, c]
+  // Texture array:
+  // e.g. [N,C,H,W,c] -> Texture2dArray[N][C*H, W, c]
   size_t separator = 0;
-  if (convention == "texture"){
+  if (convention == "texture" || convention == "texture:array") {
     separator = shape_rank - 2;
   } else if (convention == "texture:weight") {
     separator = 1;
@@ -89,8 +96,76 @@ inline bool IsTextureStorage(std::string scope) {
   return scope.find("texture") != std::string::npos;
 }
 
+/*! \brief Whether the scope stores the leading axis as the images of a texture array */
+inline bool IsTextureArrayStorage(const std::string& scope) { return scope == "texture:array"; }
+
+/*!
+ * \param shape Nd shape
+ * \param rank Number of dimensions N of the Nd shape
+ * \param axis The axis separator that splits the axes after the leading one into two sets
+ * \return Width, height and depth of the texture array, one image per index of the leading axis
+ */
+template <typename T, typename S>
+Texture2DShape<T> ApplyTextureArrayFlattening(const S& shape, size_t rank, size_t axis) {
+  ICHECK(axis > 0 && axis < rank)
+      << "Texture arrays need at least one axis besides the leading one flattened into rows";
+  Texture2DShape<T> texture{1, 1, shape[rank - 1], shape[0]};
+  for (size_t i = 1; i < rank - 1; i++) {
+    if (i < axis) {
+      texture.height *= shape[i];
+    } else {
+      texture.width *= shape[i];
+    }
+  }
+  return texture;
+}
+
+/*!
+ * \param shape Nd shape
+ * \param rank Number of dimensions N of the Nd shape
+ * \param scope The texture storage scope
+ * \return The flattened shape of the image, or of the texture array for texture array scopes
+ */
+template <typename T, typename S>
+Texture2DShape<T> ApplyTextureFlattening(const S& shape, size_t rank, const std::string& scope) {
+  size_t axis = DefaultTextureLayoutSeparator(rank, scope);
+  if (IsTextureArrayStorage(scope)) {
+    return ApplyTextureArrayFlattening<T>(shape, rank, axis);
+  }
+  return ApplyTexture2DFlattening<T>(shape, rank, axis);
+}
+
+/*!
+ * \brief Whether a tensor can be viewed in a texture allocated for another tensor.
+ * \param alloc_shape The Nd shape the texture was allocated for.
+ * \param shape The Nd shape of the tensor to view.
+ * \param scope The texture scope of both.
+ * \return True when the flattened tensor fits within the flattened allocation.
+ */
+inline bool TextureFitsShape(const std::vector<int64_t>& alloc_shape,
+                             const std::vector<int64_t>& shape, const std::string& scope) {
+  if (alloc_shape.size() < 2 || shape.size() < 2) return false;
+  auto alloc = ApplyTextureFlattening<int64_t>(alloc_shape, alloc_shape.size(), scope);
+  auto view = ApplyTextureFlattening<int64_t>(shape, shape.size(), scope);
+  return view.channel == alloc.channel && view.width <= alloc.width &&
+         view.height <= alloc.height && view.depth == alloc.depth;
+}
+
 class TVM_DLL TexturePool {
  public:
+  /*! \brief Allocation counters of a device pool */
+  struct Stats {
+    /*! \brief Requests served by a free block without reallocation */
+    size_t hits{0};
+    /*! \brief Requests served by reallocating a free block at a larger size */
+    size_t grows{0};
+    /*! \brief Requests served by a new allocation */
+    size_t misses{0};
+    /*! \brief Total bytes of the handed out blocks left unused by the requests */
+    size_t bytes_wasted{0};
+    /*! \brief Freed blocks released because the pool reached its high-water mark */
+    size_t releases{0};
+  };
   /*!
    * \brief Create pool with specific device type and device.
    * \param device_type The device type.
@@ -104,8 +179,10 @@ class TVM_DLL TexturePool {
    * \param ctx The context of allocation.
    * \param width The width of the 2d texture to be allocated.
    * \param height The height of the 2d texture to be allocated.
+   * \param channel The number of channels per texel.
    */
-  void* AllocTexture(TVMContext ctx, size_t width, size_t height, DLDataType type_hint);
+  void* AllocTexture(TVMContext ctx, size_t width, size_t height, size_t channel,
+                     DLDataType type_hint);
   /*!
    * \brief Free temporal texture in backend execution.
    *
@@ -113,6 +190,16 @@ class TVM_DLL TexturePool {
    * \param ptr The pointer to be freed.
    */
   void FreeTexture(TVMContext ctx, void* ptr);
+  /*!
+   * \brief Get the allocation counters of a device.
+   * \param ctx The context of the pool.
+   */
+  Stats GetStats(TVMContext ctx) const;
+  /*!
+   * \brief Set the high-water mark of the free textures kept for reuse on each device.
+   * \param max_free_bytes The maximum number of bytes, 0 keeps every freed texture.
+   */
+  void SetMaxFreeBytes(size_t max_free_bytes) { max_free_bytes_ = max_free_bytes; }
 
  private:
   class Pool;
@@ -122,6 +209,89 @@ class TVM_DLL TexturePool {
   DLDeviceType device_type_;
   /*! \brief The device API */
   DeviceAPI* device_;
+  /*! \brief high-water mark of the free textures, 0 when unlimited */
+  size_t max_free_bytes_{0};
+};
+
+/*!
+ * \brief The texture scratch of the kernels of a static graph.
+ *
+ *  The requests of the first run are served by textures of the plan, reusing the textures
+ *  freed so far, and recorded. The next runs are handed the same textures in the same order,
+ *  without going through a texture pool. When the runs stop following the first one, the
+ *  textures are released at the end of the run and the pool serves the requests from then on.
+ */
+class TVM_DLL TextureWorkspacePlan {
+ public:
+  /*!
+   * \brief Create an empty plan.
+   * \param device_api The device API of the textures.
+   * \param pool The pool the textures of the plan are taken from and returned to, when null
+   *  they are allocated from the device.
+   * \param pool_mu The mutex guarding the pool when it is shared between threads, or null.
+   */
+  explicit TextureWorkspacePlan(DeviceAPI* device_api, TexturePool* pool = nullptr,
+                                std::mutex* pool_mu = nullptr)
+      : device_(device_api), pool_(pool), pool_mu_(pool_mu) {}
+  /*! \brief destructor, releasing the textures of the plan */
+  ~TextureWorkspacePlan() { Release(); }
+  /*! \brief Start a run, which replays the recorded requests once the first run is done. */
+  void BeginRun() { next_ = 0; }
+  /*! \brief End a run, the requests of the first one are recorded. */
+  void EndRun() {
+    recording_ = false;
+    if (!valid_) Release();
+  }
+  /*!
+   * \brief Get the texture of the next request of the run.
+   * \param ctx The context of allocation.
+   * \param width The width of the 2d texture.
+   * \param height The height of the 2d texture.
+   * \param channel The number of channels per texel.
+   * \param type_hint The data type of the texels.
+   * \return The texture, nullptr when the requests differ from the first run and are left to
+   *  the pool from then on.
+   */
+  void* AllocTexture(TVMContext ctx, size_t width, size_t height, size_t channel,
+                     DLDataType type_hint);
+  /*!
+   * \brief Free a texture handed out by the plan.
+   * \param ptr The texture.
+   * \return Whether the texture belongs to the plan, otherwise it is left to the pool.
+   */
+  bool FreeTexture(void* ptr);
+
+ private:
+  struct Entry {
+    TVMContext ctx;
+    size_t width;
+    size_t height;
+    size_t channel;
+    DLDataType type;
+    void* data;
+  };
+  /*! \brief Release the textures of the plan to the pool or the device. */
+  void Release();
+  /*! \brief The device API */
+  DeviceAPI* device_;
+  /*! \brief The pool of the textures, null when they come from the device */
+  TexturePool* pool_;
+  /*! \brief The mutex of the pool, null when the pool is not shared */
+  std::mutex* pool_mu_;
+  /*! \brief The textures of the plan */
+  std::vector<Entry> textures_;
+  /*! \brief The textures of the plan free while recording */
+  std::vector<Entry> free_;
+  /*! \brief The data of the textures of the plan */
+  std::unordered_set<void*> owned_;
+  /*! \brief The requests of the first run with the textures serving them, in order */
+  std::vector<Entry> requests_;
+  /*! \brief The next replayed request */
+  size_t next_{0};
+  /*! \brief Whether the first run is recorded */
+  bool recording_{true};
+  /*! \brief Whether the runs still follow the recorded requests */
+  bool valid_{true};
 };
 
 }  // namespace runtime
@@ -0,0 +1,291 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file texture_pool.h
+ * \brief Texture pool utility.
+ */
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "memory_stats.h"
+#include "texture.h"
+
+namespace tvm {
+namespace runtime {
+
+class TexturePool::Pool {
+ public:
+  Pool() = default;
+  void* Alloc(TVMContext ctx, DeviceAPI* device, size_t width, size_t height, size_t channel,
+              DLDataType type_hint) {
+    // Only blocks of the same data type and channel count can be reused
+    auto& bucket = free_[BucketKey(channel, type_hint)];
+    size_t area = width * height;
+    // Best fit: blocks are ordered by area, the first one covering both
+    // extents wastes the least texels.
+    for (auto it = bucket.lower_bound(area); it != bucket.end(); ++it) {
+      if (it->second.x >= width && it->second.y >= height) {
+        Entry e = it->second;
+        bucket.erase(it);
+        free_bytes_ -= Bytes(e);
+        ++stats_.hits;
+        return Use(e, area);
+      }
+    }
+    // Otherwise grow the free block requiring the least additional area,
+    // unless that adds more than allocating the request on its own.
+    auto best = bucket.end();
+    size_t min_added_area = std::numeric_limits<size_t>::max();
+    for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+      const Entry& block = it->second;
+      size_t added_area =
+          std::max(block.x, width) * std::max(block.y, height) - block.x * block.y;
+      if (added_area < min_added_area) {
+        min_added_area = added_area;
+        best = it;
+      }
+    }
+    Entry e;
+    if (best != bucket.end() && min_added_area <= area) {
+      e.x = std::max(best->second.x, width);
+      e.y = std::max(best->second.y, height);
+      FreeBlock(ctx, device, best->second.data);
+      free_bytes_ -= Bytes(best->second);
+      bucket.erase(best);
+      ++stats_.grows;
+    } else {
+      e.x = width;
+      e.y = height;
+      ++stats_.misses;
+    }
+    e.channel = channel;
+    e.type = type_hint;
+    std::vector<int64_t> shape{int64_t(e.y), int64_t(e.x), int64_t(channel)};
+    e.data = device->AllocDataSpace(ctx, shape.size(), shape.data(), type_hint,
+                                    Optional<String>("texture"));
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kTexturePool, e.data, Bytes(e));
+    return Use(e, area);
+  }
+
+  void Free(TVMContext ctx, DeviceAPI* device, void* data, size_t max_free_bytes) {
+    Entry e;
+    if (allocated_.back().data == data) {
+      // quick path, last allocated.
+      e = allocated_.back();
+      allocated_.pop_back();
+    } else {
+      int index = static_cast<int>(allocated_.size()) - 2;
+      for (; index >= 0 && allocated_[index].data != data; --index) {
+      }
+      ICHECK_GE(index, 0) << "Attempt to free texture that has not been allocated";
+      e = allocated_[index];
+      allocated_.erase(allocated_.begin() + index);
+    }
+    // Blocks which would take the cached free textures past the limit are released
+    if (max_free_bytes != 0 && free_bytes_ + Bytes(e) > max_free_bytes) {
+      FreeBlock(ctx, device, e.data);
+      ++stats_.releases;
+      return;
+    }
+    free_bytes_ += Bytes(e);
+    free_[BucketKey(e.channel, e.type)].insert({e.x * e.y, e});
+  }
+
+  // Release all resources immediately
+  void Release(TVMContext ctx, DeviceAPI* device) {
+    for (auto& e : allocated_) {
+      FreeBlock(ctx, device, e.data);
+    }
+    for (auto& kv : free_) {
+      for (auto& block : kv.second) {
+        FreeBlock(ctx, device, block.second.data);
+      }
+    }
+    allocated_.clear();
+    free_.clear();
+    free_bytes_ = 0;
+  }
+
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  struct Entry {
+    void* data;
+    size_t x;
+    size_t y;
+    size_t channel;
+    DLDataType type;
+  };
+  static uint64_t BucketKey(size_t channel, DLDataType type) {
+    return (static_cast<uint64_t>(type.code) << 16) | (static_cast<uint64_t>(type.bits) << 8) |
+           static_cast<uint64_t>(channel);
+  }
+  static size_t TexelBytes(const Entry& e) {
+    return e.channel * ((e.type.bits * e.type.lanes + 7) / 8);
+  }
+  static size_t Bytes(const Entry& e) { return e.x * e.y * TexelBytes(e); }
+  // Return a block to the device
+  static void FreeBlock(TVMContext ctx, DeviceAPI* device, void* data) {
+    MemoryStats::Global()->Free(ctx, MemoryKind::kTexturePool, data);
+    device->FreeDataSpace(ctx, data);
+  }
+  // Hand out a block for a request of the given area
+  void* Use(const Entry& e, size_t area) {
+    stats_.bytes_wasted += (e.x * e.y - area) * TexelBytes(e);
+    allocated_.push_back(e);
+    return e.data;
+  }
+  /*! \brief free blocks of each data type and channel count, ordered by area */
+  std::unordered_map<uint64_t, std::multimap<size_t, Entry>> free_;
+  std::vector<Entry> allocated_;
+  /*! \brief total bytes of the free blocks */
+  size_t free_bytes_{0};
+  Stats stats_;
+};
+
+TexturePool::TexturePool(DLDeviceType device_type, DeviceAPI* device)
+    : device_type_(device_type), device_(device) {}
+
+TexturePool::~TexturePool() {
+  for (size_t i = 0; i < array_.size(); ++i) {
+    if (array_[i] != nullptr) {
+      TVMContext ctx;
+      ctx.device_type = device_type_;
+      ctx.device_id = static_cast<int>(i);
+      array_[i]->Release(ctx, device_);
+      delete array_[i];
+    }
+  }
+}
+
+void* TexturePool::AllocTexture(TVMContext ctx, size_t width, size_t height, size_t channel,
+                                DLDataType type_hint) {
+  if (static_cast<size_t>(ctx.device_id) >= array_.size()) {
+    array_.resize(ctx.device_id + 1, nullptr);
+  }
+  if (array_[ctx.device_id] == nullptr) {
+    array_[ctx.device_id] = new Pool();
+  }
+  return array_[ctx.device_id]->Alloc(ctx, device_, width, height, channel, type_hint);
+}
+
+TexturePool::Stats TexturePool::GetStats(TVMContext ctx) const {
+  if (static_cast<size_t>(ctx.device_id) >= array_.size() || array_[ctx.device_id] == nullptr) {
+    return Stats();
+  }
+  return array_[ctx.device_id]->GetStats();
+}
+
+void TexturePool::FreeTexture(TVMContext ctx, void* ptr) {
+  ICHECK(static_cast<size_t>(ctx.device_id) < array_.size() && array_[ctx.device_id] != nullptr)
+    << "Attempt to free texture from null texture pool";
+  array_[ctx.device_id]->Free(ctx, device_, ptr, max_free_bytes_);
+}
+
+void TextureWorkspacePlan::Release() {
+  std::unique_lock<std::mutex> lock;
+  if (pool_mu_ != nullptr) lock = std::unique_lock<std::mutex>(*pool_mu_);
+  for (const Entry& e : textures_) {
+    if (pool_ != nullptr) {
+      pool_->FreeTexture(e.ctx, e.data);
+    } else {
+      MemoryStats::Global()->Free(e.ctx, MemoryKind::kTexturePool, e.data);
+      device_->FreeDataSpace(e.ctx, e.data);
+    }
+  }
+  textures_.clear();
+  free_.clear();
+  owned_.clear();
+  requests_.clear();
+}
+
+void* TextureWorkspacePlan::AllocTexture(TVMContext ctx, size_t width, size_t height,
+                                         size_t channel, DLDataType type_hint) {
+  auto matches = [&](const Entry& e) {
+    return e.ctx.device_type == ctx.device_type && e.ctx.device_id == ctx.device_id &&
+           e.channel == channel && e.type.code == type_hint.code &&
+           e.type.bits == type_hint.bits && e.type.lanes == type_hint.lanes;
+  };
+  if (!recording_) {
+    if (!valid_) return nullptr;
+    if (next_ < requests_.size()) {
+      const Entry& request = requests_[next_];
+      if (matches(request) && request.width == width && request.height == height) {
+        ++next_;
+        return request.data;
+      }
+    }
+    LOG(WARNING) << "The texture requests of the graph differ from its first run, "
+                 << "the texture pool serves them from now on";
+    valid_ = false;
+    return nullptr;
+  }
+  // The smallest free texture of the plan covering the request, or a new one
+  auto best = free_.end();
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    if (matches(*it) && it->width >= width && it->height >= height &&
+        (best == free_.end() || it->width * it->height < best->width * best->height)) {
+      best = it;
+    }
+  }
+  Entry texture;
+  if (best != free_.end()) {
+    texture = *best;
+    free_.erase(best);
+  } else {
+    void* data;
+    if (pool_ != nullptr) {
+      std::unique_lock<std::mutex> lock;
+      if (pool_mu_ != nullptr) lock = std::unique_lock<std::mutex>(*pool_mu_);
+      data = pool_->AllocTexture(ctx, width, height, channel, type_hint);
+    } else {
+      std::vector<int64_t> shape{int64_t(height), int64_t(width), int64_t(channel)};
+      data = device_->AllocDataSpace(ctx, shape.size(), shape.data(), type_hint,
+                                     Optional<String>("texture"));
+      MemoryStats::Global()->Alloc(ctx, MemoryKind::kTexturePool, data,
+                                   width * height * channel * ((type_hint.bits + 7) / 8));
+    }
+    texture = {ctx, width, height, channel, type_hint, data};
+    textures_.push_back(texture);
+    owned_.insert(data);
+  }
+  Entry request = texture;
+  request.width = width;
+  request.height = height;
+  requests_.push_back(request);
+  return texture.data;
+}
+
+bool TextureWorkspacePlan::FreeTexture(void* ptr) {
+  if (!owned_.count(ptr)) return false;
+  if (recording_) {
+    for (const Entry& e : textures_) {
+      if (e.data == ptr) free_.push_back(e);
+    }
+  }
+  return true;
+}
+
+}  // namespace runtime
+}  // namespace tvm
@@ -33,6 +33,7 @@
 #endif
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
 #include <memory>
@@ -58,10 +59,43 @@ uint32_t GetSpinCount() {
   return atoi(val);
 }
 
+/*!
+ * \brief Get the number of tasks per worker of the work stealing mode, 0 when it is disabled.
+ *  The mode is enabled by setting TVM_THREAD_POOL_WORK_STEALING to the number of tasks.
+ */
+int GetTasksPerWorker() {
+  const char* val = getenv("TVM_THREAD_POOL_WORK_STEALING");
+  if (!val) {
+    return 0;
+  }
+  return std::max(atoi(val), 0);
+}
+
+/*!
+ * \brief Get the average idle time between two launches above which the workers sleep right
+ *  away instead of spinning, from TVM_THREAD_POOL_MAX_SPIN_IDLE_US. 0, the default, always
+ *  spins.
+ */
+int64_t GetMaxSpinIdleNs() {
+  const char* val = getenv("TVM_THREAD_POOL_MAX_SPIN_IDLE_US");
+  if (!val) {
+    return 0;
+  }
+  return std::max<int64_t>(atoll(val), 0) * 1000;
+}
+
 }  // namespace
 
 // stride in the page, fit to cache line.
 constexpr int kSyncStride = 64 / sizeof(std::atomic<int>);
+// maximum number of nested launches the workers can help at the same time.
+constexpr int kMaxNestedLaunches = 64;
+// number of tasks per worker of the weighted mode, fine enough to express the speed ratios.
+constexpr int kWeightedTasksPerWorker = 8;
+// number of launches between two calibrations of the weights of the weighted mode.
+constexpr int kWeightRecalibrateInterval = 32;
+
+class ThreadPool;
 
 /*!
  * \brief Thread local main environment.
@@ -71,6 +105,7 @@ class ParallelLauncher {
   // Reset the the task request.
   void Init(FTVMParallelLambda flambda, void* cdata, int num_task, bool need_sync) {
     num_pending_.store(num_task);
+    this->dynamic = false;
     this->cdata = cdata;
     this->flambda = flambda;
     this->env.num_task = num_task;
@@ -92,6 +127,58 @@ class ParallelLauncher {
       this->env.sync_handle = nullptr;
     }
   }
+  /*!
+   * \brief Reset the task request of a work stealing launch.
+   *  The task ids are split in contiguous ranges, one per participant. A participant runs its
+   *  own range from the front, then steals from the back of the ranges of the others.
+   *  Barriers are not supported, as the tasks do not all run at the same time.
+   *  When weights are given, the ranges are sized in proportion to the weights.
+   */
+  void InitDynamic(FTVMParallelLambda flambda, void* cdata, int num_task, int num_participants,
+                   const double* weights = nullptr) {
+    this->Init(flambda, cdata, num_task, false);
+    this->dynamic = true;
+    if (num_ranges_ == 0) {
+      // never reallocated in practice, as lagging participants may still read the ranges.
+      num_ranges_ = std::max(num_participants, threading::MaxConcurrency());
+      ranges_.reset(new TaskRange[num_ranges_]);
+    }
+    ICHECK_LE(num_participants, num_ranges_);
+    double total = num_participants;
+    if (weights != nullptr) {
+      total = 0;
+      for (int i = 0; i < num_participants; ++i) total += weights[i];
+    }
+    // publish the ranges last, the tasks are taken by the participants as soon as they appear.
+    double prefix = 0;
+    for (int i = 0; i < num_ranges_; ++i) {
+      uint64_t begin = 0, end = 0;
+      if (i < num_participants) {
+        begin = static_cast<uint64_t>(num_task * prefix / total + 0.5);
+        prefix += weights != nullptr ? weights[i] : 1.0;
+        end = i + 1 == num_participants ? num_task
+                                        : static_cast<uint64_t>(num_task * prefix / total + 0.5);
+      }
+      ranges_[i].range.store(begin << 32 | end, std::memory_order_release);
+    }
+  }
+  // Run the tasks of a work stealing launch until none is left, return the number of tasks run.
+  int RunDynamic(int participant_id) {
+    int self = participant_id % num_ranges_;
+    int task_id, num_run = 0;
+    for (int i = 0; i < num_ranges_; ++i) {
+      TaskRange& range = ranges_[(self + i) % num_ranges_];
+      while (i == 0 ? range.PopFront(&task_id) : range.PopBack(&task_id)) {
+        if ((*flambda)(task_id, &env, cdata) == 0) {
+          SignalJobFinish();
+        } else {
+          SignalJobError(task_id);
+        }
+        ++num_run;
+      }
+    }
+    return num_run;
+  }
   ~ParallelLauncher() { delete[] sync_counter_; }
   // Wait n jobs to finish
   int WaitForJobs() {
@@ -117,6 +204,8 @@ class ParallelLauncher {
   }
   // Signal that one job has finished.
   void SignalJobFinish() { num_pending_.fetch_sub(1); }
+  // The number of jobs not finished yet.
+  int32_t NumPending() const { return num_pending_.load(); }
   // Get thread local version of the store.
   static ParallelLauncher* ThreadLocal() { return dmlc::ThreadLocalStore<ParallelLauncher>::Get(); }
   // The parallel lambda
@@ -128,8 +217,50 @@ class ParallelLauncher {
   // Whether this thread is worker of the pool.
   // used to prevent recursive launch.
   bool is_worker{false};
+  // The pool of the worker, nullptr for the other threads.
+  ThreadPool* pool{nullptr};
+  // The pool bound to the thread with a ThreadPoolScope, nullptr when there is none.
+  ThreadPool* bound_pool{nullptr};
+  // The id of the thread among the participants of a work stealing launch.
+  int participant_id{0};
+  // Whether the launcher is used for a work stealing launch.
+  bool dynamic{false};
+  // Whether this launcher is in the middle of a launch.
+  bool in_use{false};
+  // The number of threads helping with a nested work stealing launch.
+  std::atomic<int> helpers{0};
 
  private:
+  /*! \brief The range [begin, end) of task ids of a participant, packed as begin << 32 | end. */
+  struct TaskRange {
+    std::atomic<uint64_t> range{0};
+    char pad[kL1CacheBytes - sizeof(std::atomic<uint64_t>)];
+
+    bool PopFront(int* task_id) {
+      uint64_t r = range.load(std::memory_order_acquire);
+      while ((r >> 32) < (r & 0xffffffffU)) {
+        if (range.compare_exchange_weak(r, r + (1ULL << 32), std::memory_order_acq_rel)) {
+          *task_id = static_cast<int>(r >> 32);
+          return true;
+        }
+      }
+      return false;
+    }
+    bool PopBack(int* task_id) {
+      uint64_t r = range.load(std::memory_order_acquire);
+      while ((r >> 32) < (r & 0xffffffffU)) {
+        if (range.compare_exchange_weak(r, r - 1, std::memory_order_acq_rel)) {
+          *task_id = static_cast<int>((r & 0xffffffffU) - 1);
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+  // The task ranges of a work stealing launch.
+  std::unique_ptr<TaskRange[]> ranges_;
+  // The number of task ranges.
+  int num_ranges_{0};
   // The pending jobs.
   std::atomic<int32_t> num_pending_;
   // Whether error has been countered.
@@ -171,13 +302,15 @@ class SpscTaskQueue {
    * \brief Pop a task out of the queue and condition wait if no tasks.
    * \param output The pointer to the task to be dequeued.
    * \param spin_count The number of iterations to spin before sleep.
+   * \param stop_spin When given, the spinning stops as soon as it is set.
    * \return Whether pop is successful (true) or we need to exit now (false).
    */
-  bool Pop(Task* output, uint32_t spin_count) {
+  bool Pop(Task* output, uint32_t spin_count, const std::atomic<bool>* stop_spin = nullptr) {
     // Busy wait a bit when the queue is empty.
     // If a new task comes to the queue quickly, this wait avoid the worker from sleeping.
     // The default spin count is set by following the typical omp convention
     for (uint32_t i = 0; i < spin_count && pending_.load() == 0; ++i) {
+      if (stop_spin != nullptr && stop_spin->load(std::memory_order_relaxed)) break;
       tvm::runtime::threading::Yield();
     }
     if (pending_.fetch_sub(1) == 0) {
@@ -258,10 +391,105 @@ class SpscTaskQueue {
 class ThreadPool {
  public:
   ThreadPool() : num_workers_(tvm::runtime::threading::MaxConcurrency()) {
+    this->Setup();
+    num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, exclude_worker0_);
+  }
+  // An isolated pool, with one worker pinned to every core.
+  explicit ThreadPool(const std::vector<unsigned int>& cores)
+      : num_workers_(static_cast<int>(cores.size())), isolated_(true) {
+    ICHECK(!cores.empty()) << "A thread pool needs at least one core";
+    this->Setup();
+    num_workers_used_ = threads_->ConfigureCores(cores, exclude_worker0_);
+  }
+  ~ThreadPool() {
+    for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
+      q->SignalForKill();
+    }
+    threads_.reset();
+  }
+  int Launch(FTVMParallelLambda flambda, void* cdata, int num_task, int need_sync) {
+    bool nested = ParallelLauncher::ThreadLocal()->is_worker;
+    std::unique_lock<std::mutex> lock(launch_mu_, std::defer_lock);
+    if (isolated_ && !nested) {
+      // an isolated pool can be bound to several threads at once
+      lock.lock();
+    }
+    bool adaptive = !nested && max_spin_idle_ns_ != 0;
+    if (adaptive && last_launch_end_ns_ != 0) {
+      // learn the idle time between launches, with an exponential moving average.
+      int64_t idle = NowNs() - last_launch_end_ns_;
+      int64_t avg = avg_idle_ns_.load(std::memory_order_relaxed);
+      avg_idle_ns_.store(avg == 0 ? idle : (avg * 3 + idle) / 4, std::memory_order_relaxed);
+    }
+    int res;
+    if (tasks_per_worker_ != 0 || weighted_) {
+      res = LaunchDynamic(flambda, cdata, num_task);
+    } else {
+      res = LaunchStatic(flambda, cdata, num_task, need_sync);
+    }
+    if (adaptive) {
+      last_launch_end_ns_ = NowNs();
+    }
+    return res;
+  }
+
+  /*!
+   * \brief Put the workers to sleep, e.g. around a section bound by another device. Waiting
+   *  workers stop spinning and block until the next launch, which still works as usual.
+   */
+  void Sleep() { sleeping_.store(true); }
+
+  /*!
+   * \brief Wake the workers up after Sleep. The workers are brought out of their blocking wait
+   *  with an empty launch, so they are spinning when the next CPU section starts.
+   */
+  void Wake() {
+    sleeping_.store(false);
+    avg_idle_ns_.store(0, std::memory_order_relaxed);
+    last_launch_end_ns_ = 0;
+    Launch([](int, TVMParallelGroupEnv*, void*) { return 0; }, nullptr, 0, 0);
+  }
+
+  static ThreadPool* ThreadLocal() { return dmlc::ThreadLocalStore<ThreadPool>::Get(); }
+
+  // The pool to launch on: the pool of the worker inside a worker, else the bound pool if any,
+  // else the thread local one.
+  static ThreadPool* Current() {
+    ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
+    if (launcher->pool != nullptr) return launcher->pool;
+    if (launcher->bound_pool != nullptr) return launcher->bound_pool;
+    return ThreadLocal();
+  }
+
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
+    // this will also reset the affinity of the ThreadGroup
+    // may use less than the MaxConcurrency number of workers
+    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_);
+    // if MaxConcurrency restricted the number of workers (e.g., due to
+    // hyperthreading), respect the restriction
+    num_workers_used_ = std::min(num_workers_, num_workers_used_);
+    weighted_ = mode == threading::ThreadGroup::kWeighted;
+    launch_count_ = 0;
+    weights_.assign(num_workers_, 1.0);
+    for (int i = 0; i < num_workers_; ++i) {
+      stats_[i].Reset();
+    }
+  }
+
+ private:
+  // Create the queues and the worker threads.
+  void Setup() {
     for (int i = 0; i < num_workers_; ++i) {
       // The SpscTaskQueue only hosts ONE item at a time
       queues_.emplace_back(std::unique_ptr<SpscTaskQueue>(new SpscTaskQueue()));
     }
+    for (int i = 0; i < kMaxNestedLaunches; ++i) {
+      nested_[i].store(nullptr);
+    }
+    tasks_per_worker_ = GetTasksPerWorker();
+    max_spin_idle_ns_ = GetMaxSpinIdleNs();
+    stats_.reset(new WorkerStat[num_workers_]);
+    weights_.assign(num_workers_, 1.0);
     const char* exclude_worker0 = getenv("TVM_EXCLUDE_WORKER0");
     if (exclude_worker0 && atoi(exclude_worker0) == 0) {
       exclude_worker0_ = false;
@@ -270,15 +498,25 @@ class ThreadPool {
         new tvm::runtime::threading::ThreadGroup(
             num_workers_, [this](int worker_id) { this->RunWorker(worker_id); },
             exclude_worker0_ /* include_main_thread */));
-    num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, exclude_worker0_);
   }
-  ~ThreadPool() {
-    for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
-      q->SignalForKill();
+
+  static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // The number of iterations a worker spins before it blocks on its queue.
+  uint32_t SpinCount(uint32_t spin_count) const {
+    if (sleeping_.load(std::memory_order_relaxed) ||
+        (max_spin_idle_ns_ != 0 &&
+         avg_idle_ns_.load(std::memory_order_relaxed) > max_spin_idle_ns_)) {
+      return 0;
     }
-    threads_.reset();
+    return spin_count;
   }
-  int Launch(FTVMParallelLambda flambda, void* cdata, int num_task, int need_sync) {
+
+  int LaunchStatic(FTVMParallelLambda flambda, void* cdata, int num_task, int need_sync) {
     ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
     ICHECK(!launcher->is_worker)
         << "Cannot launch parallel job inside worker, consider fuse then parallel";
@@ -311,29 +549,155 @@ class ThreadPool {
     return res;
   }
 
-  static ThreadPool* ThreadLocal() { return dmlc::ThreadLocalStore<ThreadPool>::Get(); }
+  /*!
+   * \brief Launch with work stealing.
+   *  The launch is over-decomposed into tasks_per_worker_ tasks per worker, which the threads
+   *  steal from each other. A launch from inside a worker is published in nested_, where the
+   *  workers done with the enclosing launch find it and help. A launch from a thread whose
+   *  launcher is already in use runs serially.
+   *  In the weighted mode, the initial ranges follow the measured throughput of the workers.
+   */
+  int LaunchDynamic(FTVMParallelLambda flambda, void* cdata, int num_task) {
+    ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
+    if (launcher->in_use) {
+      TVMParallelGroupEnv env;
+      env.num_task = 1;
+      env.sync_handle = nullptr;
+      return (*flambda)(0, &env, cdata);
+    }
+    bool weighted = weighted_ && !launcher->is_worker;
+    if (num_task == 0) {
+      int tasks_per_worker = tasks_per_worker_ != 0 ? tasks_per_worker_ : kWeightedTasksPerWorker;
+      num_task = num_workers_used_ * tasks_per_worker;
+    }
+    launcher->in_use = true;
+    launcher->InitDynamic(flambda, cdata, num_task, num_workers_used_,
+                          weighted ? weights_.data() : nullptr);
+    int self = launcher->participant_id;
+    int slot = -1;
+    if (!launcher->is_worker) {
+      SpscTaskQueue::Task tsk;
+      tsk.launcher = launcher;
+      // The task id of a dynamic launch tells the workers whether it is weighted.
+      tsk.task_id = weighted;
+      for (int i = exclude_worker0_; i < num_workers_used_; ++i) {
+        queues_[i]->Push(tsk);
+      }
+    } else {
+      for (int i = 0; i < kMaxNestedLaunches && slot < 0; ++i) {
+        ParallelLauncher* expected = nullptr;
+        if (nested_[i].compare_exchange_strong(expected, launcher)) {
+          slot = i;
+        }
+      }
+    }
+    if (weighted && exclude_worker0_) {
+      RunWeighted(launcher, self);
+    } else {
+      launcher->RunDynamic(self);
+    }
+    while (launcher->NumPending() != 0) {
+      HelpNested(self);
+      tvm::runtime::threading::Yield();
+    }
+    if (weighted && ++launch_count_ % kWeightRecalibrateInterval == 0) {
+      Recalibrate();
+    }
+    if (slot >= 0) {
+      // once unpublished, wait for the helpers that still hold the launcher.
+      nested_[slot].store(nullptr);
+      while (launcher->helpers.load() != 0) {
+        tvm::runtime::threading::Yield();
+      }
+    }
+    int res = launcher->WaitForJobs();
+    launcher->in_use = false;
+    return res;
+  }
 
-  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
-    // this will also reset the affinity of the ThreadGroup
-    // may use less than the MaxConcurrency number of workers
-    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_);
-    // if MaxConcurrency restricted the number of workers (e.g., due to
-    // hyperthreading), respect the restriction
-    num_workers_used_ = std::min(num_workers_, num_workers_used_);
+  // Run the tasks of a weighted launch, and record the throughput of the participant.
+  void RunWeighted(ParallelLauncher* launcher, int participant_id) {
+    auto begin = std::chrono::steady_clock::now();
+    int num_run = launcher->RunDynamic(participant_id);
+    auto end = std::chrono::steady_clock::now();
+    if (num_run != 0) {
+      WorkerStat& stat = stats_[participant_id];
+      stat.num_task.fetch_add(num_run, std::memory_order_relaxed);
+      stat.nanoseconds.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(),
+          std::memory_order_relaxed);
+    }
+  }
+
+  /*!
+   * \brief Update the weights of the weighted mode, from the throughput of every worker since
+   *  the last calibration. Workers without measurement keep their weight.
+   */
+  void Recalibrate() {
+    std::vector<double> rates(num_workers_used_, 0.0);
+    double sum_rate = 0, sum_weight = 0;
+    int num_measured = 0;
+    for (int i = 0; i < num_workers_used_; ++i) {
+      int64_t num_task = stats_[i].num_task.load(std::memory_order_relaxed);
+      int64_t nanoseconds = stats_[i].nanoseconds.load(std::memory_order_relaxed);
+      if (num_task != 0 && nanoseconds != 0) {
+        rates[i] = static_cast<double>(num_task) / nanoseconds;
+        sum_rate += rates[i];
+        sum_weight += weights_[i];
+        ++num_measured;
+      }
+      stats_[i].Reset();
+    }
+    if (num_measured == 0) return;
+    // keep the total weight of the measured workers, so the others keep their share.
+    for (int i = 0; i < num_workers_used_; ++i) {
+      if (rates[i] != 0) {
+        weights_[i] = std::max(rates[i] / sum_rate * sum_weight, 1e-3);
+      }
+    }
+  }
+
+  // Help with the tasks of the published nested launches.
+  void HelpNested(int participant_id) {
+    for (int i = 0; i < kMaxNestedLaunches; ++i) {
+      ParallelLauncher* launcher = nested_[i].load(std::memory_order_acquire);
+      if (launcher == nullptr) continue;
+      launcher->helpers.fetch_add(1);
+      // the launch may have been unpublished before the helper registered.
+      if (nested_[i].load() == launcher) {
+        launcher->RunDynamic(participant_id);
+      }
+      launcher->helpers.fetch_sub(1);
+    }
   }
 
- private:
   // Internal worker function.
   void RunWorker(int worker_id) {
     SpscTaskQueue* queue = queues_[worker_id].get();
     SpscTaskQueue::Task task;
     ParallelLauncher::ThreadLocal()->is_worker = true;
+    ParallelLauncher::ThreadLocal()->pool = this;
+    ParallelLauncher::ThreadLocal()->participant_id = worker_id;
     // Initialize the spin count (from envvar TVM_THREAD_POOL_SPIN_COUNT) on
     // the global first use of the ThreadPool.
     // TODO(tulloch): should we make this configurable via standard APIs?
     static size_t spin_count = GetSpinCount();
-    while (queue->Pop(&task, spin_count)) {
+    // spin only when the launches come close to each other, and not while the pool sleeps.
+    while (queue->Pop(&task, SpinCount(spin_count), &sleeping_)) {
       ICHECK(task.launcher != nullptr);
+      if (task.launcher->dynamic) {
+        if (task.task_id != 0) {
+          RunWeighted(task.launcher, worker_id);
+        } else {
+          task.launcher->RunDynamic(worker_id);
+        }
+        // help with the nested launches until the enclosing launch is done.
+        while (task.launcher->NumPending() != 0) {
+          HelpNested(worker_id);
+          tvm::runtime::threading::Yield();
+        }
+        continue;
+      }
       TVMParallelGroupEnv* penv = &(task.launcher->env);
       void* cdata = task.launcher->cdata;
       if ((*task.launcher->flambda)(task.task_id, penv, cdata) == 0) {
@@ -346,12 +710,104 @@ class ThreadPool {
   int num_workers_;
   // number of workers used (can be restricted with affinity pref)
   int num_workers_used_;
+  // whether the pool was created with CreateThreadPool rather than as a thread local one
+  bool isolated_{false};
+  // serializes the launches on an isolated pool
+  std::mutex launch_mu_;
   // if or not to exclude worker 0 and use main to run task 0
   bool exclude_worker0_{true};
+  // number of tasks per worker of the work stealing mode, 0 when disabled
+  int tasks_per_worker_{0};
+  // the published nested launches of the work stealing mode
+  std::atomic<ParallelLauncher*> nested_[kMaxNestedLaunches];
+  // the tasks run by a worker and the time it took, since the last calibration
+  struct WorkerStat {
+    std::atomic<int64_t> num_task{0};
+    std::atomic<int64_t> nanoseconds{0};
+    char pad[kL1CacheBytes - 2 * sizeof(std::atomic<int64_t>)];
+
+    void Reset() {
+      num_task.store(0, std::memory_order_relaxed);
+      nanoseconds.store(0, std::memory_order_relaxed);
+    }
+  };
+  // whether to use all the workers with splits weighted by their throughput
+  bool weighted_{false};
+  // the number of weighted launches since the last configuration
+  int64_t launch_count_{0};
+  // the statistics of every worker
+  std::unique_ptr<WorkerStat[]> stats_;
+  // the relative speed of every worker in the weighted mode
+  std::vector<double> weights_;
+  // whether the pool was put to sleep
+  std::atomic<bool> sleeping_{false};
+  // the average idle time between two launches in nanoseconds
+  std::atomic<int64_t> avg_idle_ns_{0};
+  // the end time of the last launch in nanoseconds, 0 before the first one
+  int64_t last_launch_end_ns_{0};
+  // the average idle time above which the workers do not spin, 0 when they always spin
+  int64_t max_spin_idle_ns_;
   std::vector<std::unique_ptr<SpscTaskQueue> > queues_;
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
 };
 
+/*! \brief An isolated thread pool, created by threading::CreateThreadPool. */
+class ThreadPoolObj : public Object {
+ public:
+  explicit ThreadPoolObj(const std::vector<unsigned int>& cores) : pool(cores) {}
+
+  ThreadPool pool;
+
+  static constexpr const char* _type_key = "runtime.ThreadPool";
+  TVM_DECLARE_FINAL_OBJECT_INFO(ThreadPoolObj, Object);
+};
+
+TVM_REGISTER_OBJECT_TYPE(ThreadPoolObj);
+
+namespace threading {
+
+ObjectRef CreateThreadPool(const std::vector<unsigned int>& cores) {
+  return ObjectRef(make_object<ThreadPoolObj>(cores));
+}
+
+ThreadPoolScope::ThreadPoolScope(const ObjectRef& pool) {
+  ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
+  prev_ = launcher->bound_pool;
+  if (pool.defined()) {
+    const auto* obj = pool.as<ThreadPoolObj>();
+    ICHECK(obj != nullptr) << "Expect a thread pool, but get " << pool->GetTypeKey();
+    launcher->bound_pool = const_cast<ThreadPool*>(&obj->pool);
+  }
+}
+
+ThreadPoolScope::~ThreadPoolScope() {
+  ParallelLauncher::ThreadLocal()->bound_pool = static_cast<ThreadPool*>(prev_);
+}
+
+}  // namespace threading
+
+// Parse a list of cores such as "0,1,4-7".
+static std::vector<unsigned int> ParseCores(const std::string& spec) {
+  std::vector<unsigned int> cores;
+  std::istringstream is(spec);
+  std::string item;
+  while (std::getline(is, item, ',')) {
+    if (item.empty()) continue;
+    size_t dash = item.find('-');
+    unsigned int begin = std::stoul(item.substr(0, dash));
+    unsigned int end = dash == std::string::npos ? begin : std::stoul(item.substr(dash + 1));
+    ICHECK_LE(begin, end) << "Invalid core range " << item;
+    for (unsigned int core = begin; core <= end; ++core) {
+      cores.push_back(core);
+    }
+  }
+  return cores;
+}
+
+TVM_REGISTER_GLOBAL("runtime.ThreadPoolCreate").set_body_typed([](std::string cores) {
+  return threading::CreateThreadPool(ParseCores(cores));
+});
+
 TVM_REGISTER_GLOBAL("runtime.config_threadpool").set_body([](TVMArgs args, TVMRetValue* rv) {
   threading::ThreadGroup::AffinityMode mode =
       static_cast<threading::ThreadGroup::AffinityMode>(static_cast<int>(args[0]));
@@ -359,6 +815,14 @@ TVM_REGISTER_GLOBAL("runtime.config_threadpool").set_body([](TVMArgs args, TVMRe
   ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads);
 });
 
+TVM_REGISTER_GLOBAL("runtime.threadpool_sleep").set_body_typed([]() {
+  ThreadPool::ThreadLocal()->Sleep();
+});
+
+TVM_REGISTER_GLOBAL("runtime.threadpool_wake").set_body_typed([]() {
+  ThreadPool::ThreadLocal()->Wake();
+});
+
 }  // namespace runtime
 }  // namespace tvm
 
@@ -373,7 +837,7 @@ int TVMBackendParallelLaunch(FTVMParallelLambda flambda, void* cdata, int num_ta
     return 0;
   } else {
 #if !TVM_THREADPOOL_USE_OPENMP
-    int res = tvm::runtime::ThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
+    int res = tvm::runtime::ThreadPool::Current()->Launch(flambda, cdata, num_task, 1);
     return res;
 #else
     if (num_task == 0) num_task = num_workers;
@@ -395,6 +859,9 @@ int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
 #else
   using tvm::runtime::kSyncStride;
   int num_task = penv->num_task;
+  ICHECK(penv->sync_handle != nullptr)
+      << "Parallel barrier is not supported by the work stealing thread pool, "
+      << "unset TVM_THREAD_POOL_WORK_STEALING";
   std::atomic<int>* sync_counter = reinterpret_cast<std::atomic<int>*>(penv->sync_handle);
   int old_counter = sync_counter[task_id * kSyncStride].fetch_add(1, std::memory_order_release);
   for (int i = 0; i < num_task; ++i) {
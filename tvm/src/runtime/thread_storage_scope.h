@@ -59,6 +59,8 @@ enum class StorageRank {
   kWMMAAccumulator = 6,
   /*! \brief global scope texture memory */
   kTexture = 7,
+  /*! \brief Hexagon vector tightly coupled memory */
+  kVtcm = 8,
 };
 
 /*!
@@ -110,6 +112,8 @@ struct StorageScope {
         return "wmma.accumulator" + tag;
       case StorageRank::kTexture:
         return "texture" + tag;
+      case StorageRank::kVtcm:
+        return "vtcm" + tag;
       default:
         LOG(FATAL) << "unknown storage scope";
         return "";
@@ -146,6 +150,9 @@ struct StorageScope {
     } else if (s.compare(0, 7, "texture") == 0) {
       r.rank = StorageRank::kTexture;
       r.tag = s.substr(7, std::string::npos);
+    } else if (s.compare(0, 4, "vtcm") == 0) {
+      r.rank = StorageRank::kVtcm;
+      r.tag = s.substr(4, std::string::npos);
     } else {
       LOG(FATAL) << "unknown storage scope " << s;
     }
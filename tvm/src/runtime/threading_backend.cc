@@ -67,7 +67,7 @@ class ThreadGroup::Impl {
     } else if (mode == kBig) {
       num_workers_used = big_count_;
     } else {
-      // use default
+      // use default, kWeighted also uses all the cores
       num_workers_used = threading::MaxConcurrency();
     }
     // if a specific number was given, use that
@@ -218,6 +218,27 @@ class ThreadGroup::Impl {
     }
   }
 
+ public:
+  // defined after SetAffinity, which provides the cpu_set_t fallback of older Android NDKs.
+  int ConfigureCores(const std::vector<unsigned int>& cores, bool exclude_worker0) {
+    ICHECK_GE(cores.size(), static_cast<size_t>(num_workers_))
+        << "Requested fewer cores than workers.";
+#if defined(__linux__) || defined(__ANDROID__)
+    for (unsigned i = 0; i < threads_.size(); ++i) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(cores[i + exclude_worker0], &cpuset);
+#if defined(__ANDROID__)
+      sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#else
+      pthread_setaffinity_np(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#endif
+    }
+#endif
+    return num_workers_;
+  }
+
+ private:
   int num_workers_;
   std::vector<std::thread> threads_;
   std::vector<unsigned int> sorted_order_;
@@ -235,6 +256,10 @@ int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0
   return impl_->Configure(mode, nthreads, exclude_worker0);
 }
 
+int ThreadGroup::ConfigureCores(const std::vector<unsigned int>& cores, bool exclude_worker0) {
+  return impl_->ConfigureCores(cores, exclude_worker0);
+}
+
 void Yield() { std::this_thread::yield(); }
 
 int MaxConcurrency() {
@@ -0,0 +1,344 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file runtime/binned_allocator.h
+ * \brief Best-fit allocator which carves buffers out of large device chunks.
+ *
+ *  Free blocks are indexed by size and a request takes the smallest block which
+ *  holds it, splitting off the remainder. Freed blocks are merged with their free
+ *  neighbours, and chunks left entirely free are released in least recently used
+ *  order once the reserved memory exceeds the limit.
+ */
+#ifndef TVM_RUNTIME_VM_BINNED_ALLOCATOR_H_
+#define TVM_RUNTIME_VM_BINNED_ALLOCATOR_H_
+
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/vm/memory_manager.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "pooled_allocator.h"
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+class BinnedAllocator final : public Allocator {
+ public:
+  /*! \brief Granularity of the blocks, offsets into a chunk are multiples of it. */
+  static constexpr size_t kBlockAlignment = 256;
+  /*! \brief Minimum size of the chunks requested from the device. */
+  static constexpr size_t kDefaultChunkSize = 2 << 20;
+
+  /*! \brief Counters describing the state of the allocator. */
+  struct Stats {
+    /*! \brief Bytes held from the device, including the cached free blocks. */
+    size_t reserved{0};
+    /*! \brief Bytes handed out and not yet freed. */
+    size_t in_use{0};
+    /*! \brief The high water mark of in_use. */
+    size_t peak_in_use{0};
+    /*! \brief Number of chunks held from the device. */
+    size_t num_chunks{0};
+    /*! \brief Number of allocations served. */
+    size_t num_allocs{0};
+    /*! \brief Number of allocations served from a cached block. */
+    size_t num_reuses{0};
+    /*! \brief Number of chunks released to keep under the limit. */
+    size_t num_trims{0};
+  };
+
+  /*!
+   * \brief Create the allocator.
+   * \param ctx The context to allocate on.
+   * \param limit The bytes the allocator may reserve before it releases free chunks,
+   *  0 for no limit. Memory in use is never released, so the limit can be exceeded.
+   * \param chunk_size The minimum size of the chunks requested from the device.
+   */
+  explicit BinnedAllocator(TVMContext ctx, size_t limit = GetDefaultLimit(),
+                           size_t chunk_size = kDefaultChunkSize)
+      : Allocator(kBinned),
+        limit_(limit),
+        chunk_size_(RoundUp(chunk_size)),
+        can_split_(CanSplit(ctx)),
+        used_memory_(0),
+        scoped_pool_(ctx),
+        ctx_(ctx) {}
+
+  ~BinnedAllocator() { ReleaseAll(); }
+
+  Buffer Alloc(size_t nbytes, size_t alignment, DLDataType type_hint) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t size = RoundUp(std::max<size_t>(nbytes, 1));
+    // Blocks past the start of a chunk are only aligned to kBlockAlignment
+    Block* block = alignment <= kBlockAlignment ? FindBestFit(size) : nullptr;
+    if (block != nullptr) {
+      ++stats_.num_reuses;
+    } else {
+      block = NewChunk(size, alignment, type_hint);
+    }
+    Split(block, size);
+    block->free = false;
+    Chunk* chunk = block->chunk;
+    if (chunk->idle) {
+      idle_chunks_.erase(chunk->idle_pos);
+      chunk->idle = false;
+    }
+
+    Buffer buf;
+    buf.ctx = ctx_;
+    buf.size = block->size;
+    buf.data = static_cast<uint8_t*>(chunk->data) + block->offset;
+    used_blocks_[buf.data] = block;
+    ++stats_.num_allocs;
+    stats_.in_use += block->size;
+    stats_.peak_in_use = std::max(stats_.peak_in_use, stats_.in_use);
+    DLOG(INFO) << "allocate " << buf.size << " B, in use " << stats_.in_use << " B, reserved "
+               << stats_.reserved << " B";
+    return buf;
+  }
+
+  Buffer Alloc(const std::vector<int64_t>& shape, DLDataType type_hint,
+               const std::string& mem_scope) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t allocated = 0;
+    Buffer buf = scoped_pool_.Alloc(shape, type_hint, mem_scope, &allocated);
+    stats_.reserved += allocated;
+    used_memory_.store(stats_.reserved, std::memory_order_relaxed);
+    return buf;
+  }
+
+  void Free(const Buffer& buffer) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!buffer.scope.empty()) {
+      scoped_pool_.Free(buffer);
+      return;
+    }
+    auto it = used_blocks_.find(buffer.data);
+    ICHECK(it != used_blocks_.end()) << "The buffer was not allocated by this allocator";
+    Block* block = it->second;
+    used_blocks_.erase(it);
+    stats_.in_use -= block->size;
+    block->free = true;
+    block = Coalesce(block);
+    free_blocks_.insert({block->size, block});
+    if (block->prev == nullptr && block->next == nullptr) {
+      Chunk* chunk = block->chunk;
+      chunk->idle = true;
+      chunk->idle_pos = idle_chunks_.insert(idle_chunks_.end(), chunk);
+      if (limit_ != 0 && stats_.reserved > limit_) {
+        Trim(limit_);
+      }
+    }
+    DLOG(INFO) << "reclaim buffer " << buffer.size;
+  }
+
+  size_t UsedMemory() const override { return used_memory_.load(std::memory_order_relaxed); }
+
+  /*! \brief Get the counters of the allocator. */
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return stats_;
+  }
+
+ private:
+  struct Chunk;
+  /*! \brief A contiguous part of a chunk, linked to its neighbours in address order. */
+  struct Block {
+    Chunk* chunk;
+    size_t offset;
+    size_t size;
+    bool free{true};
+    Block* prev{nullptr};
+    Block* next{nullptr};
+  };
+  /*! \brief A region allocated from the device, split into blocks. */
+  struct Chunk {
+    void* data;
+    size_t size;
+    Block* head;
+    /*! \brief Whether all of the chunk is free, and its position in the LRU list if so. */
+    bool idle{false};
+    std::list<Chunk*>::iterator idle_pos;
+  };
+
+  static size_t GetDefaultLimit() {
+    static size_t limit = [] {
+      const char* val = getenv("TVM_VM_ALLOCATOR_LIMIT_MB");
+      return val != nullptr ? static_cast<size_t>(atol(val)) << 20 : 0;
+    }();
+    return limit;
+  }
+
+  // Only address arithmetic on device pointers yields a valid sub buffer, not on handles
+  static bool CanSplit(TVMContext ctx) {
+    return ctx.device_type == kDLCPU || ctx.device_type == kDLGPU ||
+           ctx.device_type == kDLCPUPinned || ctx.device_type == kDLROCM;
+  }
+
+  static size_t RoundUp(size_t size) {
+    return (size + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+  }
+
+  Block* FindBestFit(size_t size) {
+    auto it = free_blocks_.lower_bound({size, nullptr});
+    if (it == free_blocks_.end()) return nullptr;
+    // A block which cannot be split must not waste more than the request itself
+    if (!can_split_ && it->first > 2 * size) return nullptr;
+    Block* block = it->second;
+    free_blocks_.erase(it);
+    return block;
+  }
+
+  /*! \brief Allocate a chunk from the device and return its only block, not indexed. */
+  Block* NewChunk(size_t size, size_t alignment, DLDataType type_hint) {
+    size_t chunk_size = can_split_ ? std::max(size, chunk_size_) : size;
+    if (limit_ != 0 && stats_.reserved + chunk_size > limit_) {
+      Trim(limit_ > chunk_size ? limit_ - chunk_size : 0);
+      if (stats_.reserved + chunk_size > limit_) chunk_size = size;
+    }
+    alignment = std::max(alignment, kBlockAlignment);
+    void* data = nullptr;
+    try {
+      data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, chunk_size, alignment, type_hint);
+    } catch (const dmlc::Error& e) {
+      // Out of device memory, retry after giving back everything which is cached
+      DLOG(INFO) << "allocation of " << chunk_size << " B failed, release free chunks";
+      Trim(0);
+      chunk_size = size;
+      data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, chunk_size, alignment, type_hint);
+    }
+    MemoryStats::Global()->Alloc(ctx_, MemoryKind::kVMAllocator, data, chunk_size);
+    Chunk* chunk = new Chunk();
+    chunk->data = data;
+    chunk->size = chunk_size;
+    chunk->head = new Block{chunk, 0, chunk_size};
+    chunks_.insert(chunk);
+    stats_.reserved += chunk_size;
+    ++stats_.num_chunks;
+    used_memory_.store(stats_.reserved, std::memory_order_relaxed);
+    return chunk->head;
+  }
+
+  /*! \brief Shrink a block to size, indexing the rest as a free block. */
+  void Split(Block* block, size_t size) {
+    if (!can_split_ || block->size - size < kBlockAlignment) return;
+    Block* rest = new Block{block->chunk, block->offset + size, block->size - size};
+    rest->prev = block;
+    rest->next = block->next;
+    if (block->next != nullptr) block->next->prev = rest;
+    block->next = rest;
+    block->size = size;
+    free_blocks_.insert({rest->size, rest});
+  }
+
+  /*! \brief Merge a freed block with its free neighbours and return the merged block. */
+  Block* Coalesce(Block* block) {
+    Block* next = block->next;
+    if (next != nullptr && next->free) {
+      free_blocks_.erase({next->size, next});
+      block->size += next->size;
+      block->next = next->next;
+      if (next->next != nullptr) next->next->prev = block;
+      delete next;
+    }
+    Block* prev = block->prev;
+    if (prev != nullptr && prev->free) {
+      free_blocks_.erase({prev->size, prev});
+      prev->size += block->size;
+      prev->next = block->next;
+      if (block->next != nullptr) block->next->prev = prev;
+      delete block;
+      block = prev;
+    }
+    return block;
+  }
+
+  /*! \brief Release the least recently used free chunks until at most target bytes stay. */
+  void Trim(size_t target) {
+    while (stats_.reserved > target && !idle_chunks_.empty()) {
+      Chunk* chunk = idle_chunks_.front();
+      idle_chunks_.pop_front();
+      free_blocks_.erase({chunk->head->size, chunk->head});
+      ReleaseChunk(chunk);
+      ++stats_.num_trims;
+    }
+  }
+
+  void ReleaseChunk(Chunk* chunk) {
+    for (Block* block = chunk->head; block != nullptr;) {
+      Block* next = block->next;
+      delete block;
+      block = next;
+    }
+    MemoryStats::Global()->Free(ctx_, MemoryKind::kVMAllocator, chunk->data);
+    DeviceAPI::Get(ctx_)->FreeDataSpace(ctx_, chunk->data);
+    stats_.reserved -= chunk->size;
+    --stats_.num_chunks;
+    used_memory_.store(stats_.reserved, std::memory_order_relaxed);
+    chunks_.erase(chunk);
+    delete chunk;
+  }
+
+  void ReleaseAll() {
+    std::lock_guard<std::mutex> lock(mu_);
+    while (!chunks_.empty()) {
+      ReleaseChunk(*chunks_.begin());
+    }
+    free_blocks_.clear();
+    used_blocks_.clear();
+    idle_chunks_.clear();
+    stats_.reserved -= scoped_pool_.ReleaseAll();
+    used_memory_ = 0;
+    DLOG(INFO) << "release all buffers";
+  }
+
+ private:
+  size_t limit_;
+  size_t chunk_size_;
+  bool can_split_;
+  Stats stats_;
+  std::atomic<size_t> used_memory_;
+  /*! \brief Free blocks ordered by size, the first one not smaller than a request fits best. */
+  std::set<std::pair<size_t, Block*> > free_blocks_;
+  std::unordered_map<void*, Block*> used_blocks_;
+  std::unordered_set<Chunk*> chunks_;
+  /*! \brief Chunks which are entirely free, least recently freed first. */
+  std::list<Chunk*> idle_chunks_;
+  ScopedBufferPool scoped_pool_;
+  std::mutex mu_;
+  TVMContext ctx_;
+};
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_VM_BINNED_ALLOCATOR_H_
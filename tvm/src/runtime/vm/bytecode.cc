@@ -338,7 +338,7 @@ Instruction Instruction::AllocTensorReg(RegName storage, RegName offset, RegName
 }
 
 Instruction Instruction::AllocStorage(RegName size, Index alignment, DLDataType dtype_hint,
-                                      Index device_type, RegName dst) {
+                                      Index device_type, Index memory_scope, RegName dst) {
   Instruction instr;
   instr.op = Opcode::AllocStorage;
   instr.dst = dst;
@@ -346,6 +346,7 @@ Instruction Instruction::AllocStorage(RegName size, Index alignment, DLDataType
   instr.alloc_storage.alignment = alignment;
   instr.alloc_storage.dtype_hint = dtype_hint;
   instr.alloc_storage.device_type = device_type;
+  instr.alloc_storage.memory_scope = memory_scope;
   return instr;
 }
 
@@ -609,7 +610,7 @@ void InstructionPrint(std::ostream& os, const Instruction& instr) {
       os << "alloc_storage $" << instr.dst << " $" << instr.alloc_storage.allocation_size << " "
          << instr.alloc_storage.alignment << " "
          << DLDataType2String(instr.alloc_storage.dtype_hint) << " "
-         << instr.alloc_storage.device_type;
+         << instr.alloc_storage.device_type << " " << instr.alloc_storage.memory_scope;
       break;
     }
     case Opcode::ShapeOf: {
@@ -24,6 +24,7 @@
 
 #include <dmlc/memory_io.h>
 #include <tvm/runtime/c_runtime_api.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/executable.h>
 #include <tvm/runtime/vm/vm.h>
@@ -37,6 +38,7 @@
 #include <utility>
 #include <vector>
 
+#include "../file_utils.h"
 #include "serialize_utils.h"
 
 namespace tvm {
@@ -50,7 +52,8 @@ namespace vm {
 // Helper to serialize a vm instruction.
 VMInstructionSerializer SerializeInstruction(const Instruction& instr);
 // Helper to deserialize a serialized vm instruction.
-Instruction DeserializeInstruction(const VMInstructionSerializer& instr);
+Instruction DeserializeInstruction(const VMInstructionSerializer& instr,
+                                   uint64_t format_version);
 
 PackedFunc Executable::GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) {
   if (name == "get_lib") {
@@ -189,12 +192,22 @@ std::string Executable::Stats() const {
   if (!prim_ops.empty()) oss.seekp(-2, oss.cur);
   oss << "]" << std::endl;
 
+  // Get the memory scopes of the storage allocations.
+  oss << "  Memory scopes (#" << memory_scopes.size() << "): [";
+  for (const auto& it : memory_scopes) {
+    oss << it << ", ";
+  }
+  if (!memory_scopes.empty()) oss.seekp(-2, oss.cur);
+  oss << "]" << std::endl;
+
   return oss.str();
 }
 
 void SaveHeader(dmlc::Stream* strm) {
-  uint64_t header = kTVMVMBytecodeMagic;
+  uint64_t header = kTVMVMBytecodeMagicVersioned;
   strm->Write(header);
+  uint64_t format_version = kTVMVMFormatVersion;
+  strm->Write(format_version);
   std::string version = TVM_VERSION;
   strm->Write(version);
 }
@@ -216,6 +229,12 @@ TVMByteArray Executable::Save() {
   // Primitive names.
   SavePrimitiveOpNames(&strm);
 
+  // Memory scopes.
+  SaveMemoryScopes(&strm);
+
+  // Shape functions.
+  SaveShapeFuncs(&strm);
+
   // Code section.
   SaveCodeSection(&strm);
 
@@ -240,14 +259,18 @@ void Executable::SaveGlobalSection(dmlc::Stream* strm) {
   strm->Write(glbs);
 }
 
-void Executable::SaveConstantSection(dmlc::Stream* strm) {
+void Executable::SaveConstantSection(dmlc::SeekStream* strm) {
   std::vector<DLTensor*> arrays;
   for (const auto& obj : this->constants) {
     const auto cell = Downcast<runtime::NDArray>(obj);
     arrays.push_back(const_cast<DLTensor*>(cell.operator->()));
   }
   strm->Write(static_cast<uint64_t>(this->constants.size()));
+  // The data of each constant is padded to the alignment, as in a padded parameter list.
+  uint64_t alignment = kAllocAlignment;
+  strm->Write(alignment);
   for (const auto& it : arrays) {
+    SaveParamPadding(strm, strm->Tell(), it, alignment);
     runtime::SaveDLTensor(strm, it);
   }
 
@@ -267,6 +290,10 @@ void Executable::SavePrimitiveOpNames(dmlc::Stream* strm) {
   strm->Write(primitive_names);
 }
 
+void Executable::SaveMemoryScopes(dmlc::Stream* strm) { strm->Write(this->memory_scopes); }
+
+void Executable::SaveShapeFuncs(dmlc::Stream* strm) { strm->Write(this->shape_funcs); }
+
 // Serialize a virtual machine instruction. It creates a list that contains the
 // hash, opcode, and all fields of an instruction.
 //
@@ -356,6 +383,7 @@ VMInstructionSerializer SerializeInstruction(const Instruction& instr) {
       fields.push_back(dtype.bits);
       fields.push_back(dtype.lanes);
       fields.push_back(instr.alloc_storage.device_type);
+      fields.push_back(instr.alloc_storage.memory_scope);
       fields.push_back(instr.dst);
       break;
     }
@@ -463,40 +491,71 @@ void Executable::SaveCodeSection(dmlc::Stream* strm) {
   }
 }
 
-void LoadHeader(dmlc::Stream* strm) {
+uint64_t LoadHeader(dmlc::Stream* strm) {
   // Check header.
   uint64_t header;
   STREAM_CHECK(strm->Read(&header), "header");
-  STREAM_CHECK(header == kTVMVMBytecodeMagic, "header");
+  STREAM_CHECK(header == kTVMVMBytecodeMagic || header == kTVMVMBytecodeMagicVersioned,
+               "header");
+
+  // Check the format version, the sections added since a version are only read from its files.
+  uint64_t format_version = 0;
+  if (header == kTVMVMBytecodeMagicVersioned) {
+    STREAM_CHECK(strm->Read(&format_version), "format version");
+    STREAM_CHECK(format_version <= kTVMVMFormatVersion, "format version");
+  }
 
   // Check version.
   std::string version;
   STREAM_CHECK(strm->Read(&version), "version");
   STREAM_CHECK(version == TVM_VERSION, "version");
+  return format_version;
 }
 
 runtime::Module Executable::Load(const std::string& code, const runtime::Module lib) {
   auto exec = make_object<Executable>();
   exec->lib = lib;
-  exec->code_ = code;
-  dmlc::MemoryStringStream strm(&exec->code_);
+  dmlc::MemoryFixedSizeStream strm(const_cast<char*>(code.data()), code.size());
+  exec->LoadSections(&strm, nullptr);
+  return runtime::Module(exec);
+}
 
+runtime::Module Executable::LoadFromFile(const std::string& path, const runtime::Module lib) {
+#ifdef _WIN32
+  std::string code;
+  LoadBinaryFromFile(path, &code);
+  return Load(code, lib);
+#else
+  auto exec = make_object<Executable>();
+  exec->lib = lib;
+  std::shared_ptr<MappedFile> file = MapFile(path);
+  dmlc::MemoryFixedSizeStream strm(file->addr, file->size);
+  exec->LoadSections(&strm, file);
+  return runtime::Module(exec);
+#endif
+}
+
+void Executable::LoadSections(dmlc::SeekStream* strm, const std::shared_ptr<MappedFile>& file) {
   // Load header.
-  LoadHeader(&strm);
+  format_version_ = LoadHeader(strm);
 
   // Global section.
-  exec->LoadGlobalSection(&strm);
+  LoadGlobalSection(strm);
 
   // Constant section.
-  exec->LoadConstantSection(&strm);
+  LoadConstantSection(strm, file);
 
   // Primitive names that will be invoked by `InvokePacked` instructions.
-  exec->LoadPrimitiveOpNames(&strm);
+  LoadPrimitiveOpNames(strm);
 
-  // Code section.
-  exec->LoadCodeSection(&strm);
+  // Memory scopes referred to by `AllocStorage` instructions.
+  LoadMemoryScopes(strm);
 
-  return runtime::Module(exec);
+  // Packed functions whose results can be cached by their inputs.
+  LoadShapeFuncs(strm);
+
+  // Code section.
+  LoadCodeSection(strm);
 }
 
 void Executable::LoadGlobalSection(dmlc::Stream* strm) {
@@ -507,14 +566,40 @@ void Executable::LoadGlobalSection(dmlc::Stream* strm) {
   }
 }
 
-void Executable::LoadConstantSection(dmlc::Stream* strm) {
+void Executable::LoadConstantSection(dmlc::SeekStream* strm,
+                                     const std::shared_ptr<MappedFile>& file) {
   uint64_t sz;
   // Load the number of constants.
   STREAM_CHECK(strm->Read(&sz, sizeof(sz)), "constant");
+  // The constants of the files before format version 1 are not padded.
+  uint64_t alignment = 0;
+  if (format_version_ >= 1) {
+    STREAM_CHECK(strm->Read(&alignment), "constant");
+  }
 
   size_t size = static_cast<size_t>(sz);
-  // Load each of the constants.
+  // Load each of the constants. The aligned constants of a mapped file, in native
+  // byte order, view their data in the mapping, the others are copied.
   for (size_t i = 0; i < size; i++) {
+    SkipParamPadding(strm, alignment);
+    if (file != nullptr && DMLC_IO_NO_ENDIAN_SWAP) {
+      DLDataType dtype;
+      std::vector<int64_t> shape;
+      int64_t data_byte_size = ReadDLTensorHeader(strm, &dtype, &shape);
+      size_t data_offset = strm->Tell();
+      STREAM_CHECK(data_offset + static_cast<size_t>(data_byte_size) <= file->size, "constant");
+      void* data = static_cast<char*>(file->addr) + data_offset;
+      strm->Seek(data_offset + data_byte_size);
+      DLContext cpu_ctx{kDLCPU, 0};
+      if (reinterpret_cast<uintptr_t>(data) % kAllocAlignment == 0) {
+        this->constants.push_back(ViewMappedData(file, data, shape, dtype, cpu_ctx));
+      } else {
+        runtime::NDArray constant = runtime::NDArray::Empty(shape, dtype, cpu_ctx);
+        constant.CopyFromBytes(data, data_byte_size);
+        this->constants.push_back(constant);
+      }
+      continue;
+    }
     runtime::NDArray constant;
     STREAM_CHECK(constant.Load(strm), "constant");
     this->constants.push_back(constant);
@@ -535,6 +620,21 @@ void Executable::LoadPrimitiveOpNames(dmlc::Stream* strm) {
   }
 }
 
+void Executable::LoadMemoryScopes(dmlc::Stream* strm) {
+  // All the storage of the files before format version 1 is global.
+  if (format_version_ < 1) {
+    this->memory_scopes = {"global"};
+    return;
+  }
+  STREAM_CHECK(strm->Read(&this->memory_scopes), "memory scope");
+}
+
+void Executable::LoadShapeFuncs(dmlc::Stream* strm) {
+  // The results of no packed function are cached before format version 1.
+  if (format_version_ < 1) return;
+  STREAM_CHECK(strm->Read(&this->shape_funcs), "shape function");
+}
+
 // Extract the `cnt` number of fields started at `start` from the list
 // `instr_fields`.
 inline std::vector<Index> ExtractFields(const std::vector<Index>& instr_fields, Index start,
@@ -547,7 +647,8 @@ inline std::vector<Index> ExtractFields(const std::vector<Index>& instr_fields,
   return ret;
 }
 
-Instruction DeserializeInstruction(const VMInstructionSerializer& instr) {
+Instruction DeserializeInstruction(const VMInstructionSerializer& instr,
+                                   uint64_t format_version) {
   Opcode opcode = static_cast<Opcode>(instr.opcode);
   switch (opcode) {
     case Opcode::Move: {
@@ -638,8 +739,9 @@ Instruction DeserializeInstruction(const VMInstructionSerializer& instr) {
       return Instruction::AllocClosure(clo_index, num_freevar, free_vars, dst);
     }
     case Opcode::AllocStorage: {
-      // Number of fields = 7
-      DCHECK_GE(instr.fields.size(), 7U);
+      // Number of fields = 8, or 7 without the memory scope before format version 1
+      bool has_scope = format_version >= 1;
+      DCHECK_GE(instr.fields.size(), has_scope ? 8U : 7U);
       Index allocation_size = instr.fields[0];
       Index alignment = instr.fields[1];
 
@@ -649,9 +751,11 @@ Instruction DeserializeInstruction(const VMInstructionSerializer& instr) {
       dtype.lanes = instr.fields[4];
 
       Index device_type = instr.fields[5];
-      RegName dst = instr.fields[6];
+      Index memory_scope = has_scope ? instr.fields[6] : 0;
+      RegName dst = instr.fields[has_scope ? 7 : 6];
 
-      return Instruction::AllocStorage(allocation_size, alignment, dtype, device_type, dst);
+      return Instruction::AllocStorage(allocation_size, alignment, dtype, device_type,
+                                       memory_scope, dst);
     }
     case Opcode::If: {
       // Number of fields = 4
@@ -752,7 +856,7 @@ void Executable::LoadCodeSection(dmlc::Stream* strm) {
       VMInstructionSerializer instr;
       std::vector<Index> instr_fields;
       STREAM_CHECK(instr.Load(strm), "code/instruction");
-      instructions.push_back(DeserializeInstruction(instr));
+      instructions.push_back(DeserializeInstruction(instr, format_version_));
     }
 
     // Create the VM function.
@@ -815,6 +919,11 @@ TVM_REGISTER_GLOBAL("runtime.Load_Executable")
       return Executable::Load(code, lib);
     });
 
+TVM_REGISTER_GLOBAL("runtime.Load_ExecutableFromFile")
+    .set_body_typed([](std::string path, runtime::Module lib) {
+      return Executable::LoadFromFile(path, lib);
+    });
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
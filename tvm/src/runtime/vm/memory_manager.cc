@@ -21,11 +21,15 @@
  * \file tvm/runtime/vm/memory_manager.cc
  * \brief Allocate and manage memory for the runtime.
  */
+#include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
 #include <memory>
+#include <string>
 #include <utility>
 
+#include "../texture.h"
+#include "binned_allocator.h"
 #include "naive_allocator.h"
 #include "pooled_allocator.h"
 
@@ -79,6 +83,22 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
 NDArray StorageObj::AllocNDArray(size_t offset, std::vector<int64_t> shape, DLDataType dtype) {
   VerifyDataType(dtype);
 
+  if (!this->buffer.scope.empty()) {
+    ICHECK_EQ(offset, 0U) << "Arrays in " << this->buffer.scope << " storage cannot be offset";
+    if (this->buffer.data == nullptr) {
+      this->buffer =
+          MemoryManager::GetAllocator(this->buffer.ctx)->Alloc(shape, dtype, this->buffer.scope);
+    } else {
+      ICHECK(TypeEqual(this->buffer.dtype, dtype))
+          << "Arrays in " << this->buffer.scope << " storage must keep the element type "
+          << DLDataType2String(this->buffer.dtype) << ", got " << DLDataType2String(dtype);
+      ICHECK(IsTextureStorage(this->buffer.scope) ? TextureFitsShape(this->buffer.shape, shape,
+                                                                      this->buffer.scope)
+                                                   : this->buffer.shape == shape)
+          << "Array does not fit the " << this->buffer.scope << " storage it is allocated from";
+    }
+  }
+
   // crtical zone: allocate header, cannot throw
   NDArray::Container* container = new NDArray::Container(nullptr, shape, dtype, this->buffer.ctx);
 
@@ -102,7 +122,7 @@ NDArray StorageObj::AllocNDArray(size_t offset, std::vector<int64_t> shape, DLDa
   NDArray ret(GetObjectPtr<Object>(container));
   // RAII in effect, now run the check.
 
-  ICHECK(offset + needed_size <= this->buffer.size)
+  ICHECK(!this->buffer.scope.empty() || offset + needed_size <= this->buffer.size)
       << "storage allocation failure, attempted to allocate " << needed_size << " at offset "
       << offset << " in region that is " << this->buffer.size << "bytes";
 
@@ -134,6 +154,12 @@ Allocator* MemoryManager::GetOrCreateAllocator(TVMContext ctx, AllocatorType typ
         alloc.reset(new PooledAllocator(ctx));
         break;
       }
+      case kBinned: {
+        DLOG(INFO) << "New binned allocator for " << DeviceName(ctx.device_type) << "("
+                   << ctx.device_id << ")";
+        alloc.reset(new BinnedAllocator(ctx));
+        break;
+      }
       default:
         LOG(FATAL) << "Unknown allocator type: " << type;
     }
@@ -174,6 +200,27 @@ NDArray Allocator::Empty(std::vector<int64_t> shape, DLDataType dtype, DLContext
   return NDArray(GetObjectPtr<Object>(container));
 }
 
+TVM_REGISTER_GLOBAL("runtime.vm.AllocatorStat")
+    .set_body_typed([](int device_type, int device_id, std::string name) -> int64_t {
+      TVMContext ctx;
+      ctx.device_type = static_cast<DLDeviceType>(device_type);
+      ctx.device_id = device_id;
+      Allocator* alloc = MemoryManager::GetAllocator(ctx);
+      if (name == "used_memory") return alloc->UsedMemory();
+      auto* binned = dynamic_cast<BinnedAllocator*>(alloc);
+      ICHECK(binned) << "Allocator statistic " << name << " is only kept by the binned allocator";
+      BinnedAllocator::Stats stats = binned->GetStats();
+      if (name == "reserved") return stats.reserved;
+      if (name == "in_use") return stats.in_use;
+      if (name == "peak_in_use") return stats.peak_in_use;
+      if (name == "num_chunks") return stats.num_chunks;
+      if (name == "num_allocs") return stats.num_allocs;
+      if (name == "num_reuses") return stats.num_reuses;
+      if (name == "num_trims") return stats.num_trims;
+      LOG(FATAL) << "Unknown allocator statistic " << name;
+      return 0;
+    });
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
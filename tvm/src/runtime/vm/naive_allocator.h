@@ -27,6 +27,10 @@
 #include <tvm/runtime/vm/memory_manager.h>
 
 #include <atomic>
+#include <string>
+#include <vector>
+
+#include "../memory_stats.h"
 
 namespace tvm {
 namespace runtime {
@@ -41,12 +45,34 @@ class NaiveAllocator final : public Allocator {
     buf.ctx = ctx_;
     buf.size = nbytes;
     buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, nbytes, alignment, type_hint);
+    MemoryStats::Global()->Alloc(ctx_, MemoryKind::kVMAllocator, buf.data, buf.size);
     used_memory_.fetch_add(nbytes, std::memory_order_relaxed);
     DLOG(INFO) << "allocate " << nbytes << " B, used memory " << used_memory_ << " B";
     return buf;
   }
 
+  Buffer Alloc(const std::vector<int64_t>& shape, DLDataType type_hint,
+               const std::string& mem_scope) override {
+    Buffer buf;
+    buf.ctx = ctx_;
+    buf.scope = mem_scope;
+    buf.shape = shape;
+    buf.dtype = type_hint;
+    buf.size = (type_hint.bits * type_hint.lanes + 7) / 8;
+    for (int64_t dim : shape) {
+      buf.size *= static_cast<size_t>(dim);
+    }
+    buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, static_cast<int>(shape.size()),
+                                                    shape.data(), type_hint, String(mem_scope));
+    MemoryStats::Global()->Alloc(ctx_, MemoryKind::kVMAllocator, buf.data, buf.size);
+    used_memory_.fetch_add(buf.size, std::memory_order_relaxed);
+    DLOG(INFO) << "allocate " << buf.size << " B in " << mem_scope << ", used memory "
+               << used_memory_ << " B";
+    return buf;
+  }
+
   void Free(const Buffer& buffer) override {
+    MemoryStats::Global()->Free(buffer.ctx, MemoryKind::kVMAllocator, buffer.data);
     DeviceAPI::Get(ctx_)->FreeDataSpace(buffer.ctx, buffer.data);
     used_memory_.fetch_sub(buffer.size, std::memory_order_relaxed);
     DLOG(INFO) << "free " << buffer.size << " B, used memory " << used_memory_ << " B";
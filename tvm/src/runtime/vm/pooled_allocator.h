@@ -27,20 +27,118 @@
 #include <tvm/runtime/vm/memory_manager.h>
 
 #include <atomic>
+#include <map>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "../memory_stats.h"
+#include "../texture.h"
+
 namespace tvm {
 namespace runtime {
 namespace vm {
 
+/*!
+ * \brief Free list of buffers in memory scopes which are not flat, e.g. textures.
+ *  The caller is responsible for the locking.
+ */
+class ScopedBufferPool {
+ public:
+  explicit ScopedBufferPool(TVMContext ctx) : ctx_(ctx) {}
+
+  /*!
+   * \brief Reuse the smallest free buffer of the scope which can hold the tensor, or
+   *  allocate a new one. A texture holds any tensor whose flattened extents are within
+   *  its own.
+   * \param allocated Set to the number of bytes newly allocated from the device.
+   */
+  Buffer Alloc(const std::vector<int64_t>& shape, DLDataType type_hint,
+               const std::string& mem_scope, size_t* allocated) {
+    *allocated = 0;
+    auto& pool = pool_[mem_scope];
+    bool texture = IsTextureStorage(mem_scope);
+    int64_t capacity = Capacity(shape, mem_scope);
+    // The buffers are ordered by capacity, the first one which fits is the smallest, and
+    // the ones with a smaller capacity are never visited.
+    for (auto it = pool.lower_bound(capacity); it != pool.end(); ++it) {
+      if (!texture && it->first != capacity) break;
+      const Buffer& buf = it->second;
+      bool fits = texture ? TextureFitsShape(buf.shape, shape, mem_scope) : buf.shape == shape;
+      if (fits && TypeEqual(buf.dtype, type_hint)) {
+        Buffer ret = buf;
+        pool.erase(it);
+        return ret;
+      }
+    }
+    Buffer buf;
+    buf.ctx = ctx_;
+    buf.scope = mem_scope;
+    buf.shape = shape;
+    buf.dtype = type_hint;
+    buf.size = (type_hint.bits * type_hint.lanes + 7) / 8;
+    for (int64_t dim : shape) {
+      buf.size *= static_cast<size_t>(dim);
+    }
+    buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, static_cast<int>(shape.size()),
+                                                    shape.data(), type_hint, String(mem_scope));
+    MemoryStats::Global()->Alloc(ctx_, MemoryKind::kVMAllocator, buf.data, buf.size);
+    *allocated = buf.size;
+    DLOG(INFO) << "allocate " << buf.size << " B in " << mem_scope;
+    return buf;
+  }
+
+  void Free(const Buffer& buffer) {
+    pool_[buffer.scope].emplace(Capacity(buffer.shape, buffer.scope), buffer);
+    DLOG(INFO) << "reclaim " << buffer.scope << " buffer " << buffer.size;
+  }
+
+  /*! \brief Release all the free buffers, returning the number of bytes released. */
+  size_t ReleaseAll() {
+    size_t released = 0;
+    for (auto const& it : pool_) {
+      for (auto const& kv : it.second) {
+        const Buffer& buf = kv.second;
+        MemoryStats::Global()->Free(buf.ctx, MemoryKind::kVMAllocator, buf.data);
+        DeviceAPI::Get(buf.ctx)->FreeDataSpace(buf.ctx, buf.data);
+        released += buf.size;
+      }
+    }
+    pool_.clear();
+    return released;
+  }
+
+ private:
+  /*!
+   * \brief The number of elements of the flattened extents of a buffer, no tensor with more
+   *  elements fits in it.
+   */
+  static int64_t Capacity(const std::vector<int64_t>& shape, const std::string& scope) {
+    if (IsTextureStorage(scope) && shape.size() >= 2) {
+      auto texture = ApplyTextureFlattening<int64_t>(shape, shape.size(), scope);
+      return texture.width * texture.height * texture.channel * texture.depth;
+    }
+    int64_t capacity = 1;
+    for (int64_t dim : shape) capacity *= dim;
+    return capacity;
+  }
+
+  /*! \brief The free buffers of each scope, by their capacity. */
+  std::unordered_map<std::string, std::multimap<int64_t, Buffer> > pool_;
+  TVMContext ctx_;
+};
+
 class PooledAllocator final : public Allocator {
  public:
   static constexpr size_t kDefaultPageSize = 4096;
 
   explicit PooledAllocator(TVMContext ctx, size_t page_size = kDefaultPageSize)
-      : Allocator(kPooled), page_size_(page_size), used_memory_(0), ctx_(ctx) {}
+      : Allocator(kPooled),
+        page_size_(page_size),
+        used_memory_(0),
+        scoped_pool_(ctx),
+        ctx_(ctx) {}
 
   ~PooledAllocator() { ReleaseAll(); }
 
@@ -58,13 +156,27 @@ class PooledAllocator final : public Allocator {
     buf.ctx = ctx_;
     buf.size = size;
     buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, size, alignment, type_hint);
+    MemoryStats::Global()->Alloc(ctx_, MemoryKind::kVMAllocator, buf.data, size);
     used_memory_.fetch_add(size, std::memory_order_relaxed);
     DLOG(INFO) << "allocate " << size << " B, used memory " << used_memory_ << " B";
     return buf;
   }
 
+  Buffer Alloc(const std::vector<int64_t>& shape, DLDataType type_hint,
+               const std::string& mem_scope) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t allocated = 0;
+    Buffer buf = scoped_pool_.Alloc(shape, type_hint, mem_scope, &allocated);
+    used_memory_.fetch_add(allocated, std::memory_order_relaxed);
+    return buf;
+  }
+
   void Free(const Buffer& buffer) override {
     std::lock_guard<std::mutex> lock(mu_);
+    if (!buffer.scope.empty()) {
+      scoped_pool_.Free(buffer);
+      return;
+    }
     if (memory_pool_.find(buffer.size) == memory_pool_.end()) {
       memory_pool_.emplace(buffer.size, std::vector<Buffer>{});
     }
@@ -80,10 +192,12 @@ class PooledAllocator final : public Allocator {
     for (auto const& it : memory_pool_) {
       auto const& pool = it.second;
       for (auto const& buf : pool) {
+        MemoryStats::Global()->Free(buf.ctx, MemoryKind::kVMAllocator, buf.data);
         DeviceAPI::Get(buf.ctx)->FreeDataSpace(buf.ctx, buf.data);
       }
     }
     memory_pool_.clear();
+    scoped_pool_.ReleaseAll();
     used_memory_ = 0;
     DLOG(INFO) << "release all buffers";
   }
@@ -92,6 +206,7 @@ class PooledAllocator final : public Allocator {
   size_t page_size_;
   std::atomic<size_t> used_memory_;
   std::unordered_map<size_t, std::vector<Buffer> > memory_pool_;
+  ScopedBufferPool scoped_pool_;
   std::mutex mu_;
   TVMContext ctx_;
 };
@@ -40,6 +40,22 @@ namespace vm {
 /*! \brief The magic number for the serialized VM bytecode file  */
 constexpr uint64_t kTVMVMBytecodeMagic = 0xD225DE2F4214151D;
 
+/*!
+ * \brief The magic number for the serialized VM bytecode file with a format version after it.
+ *  The files with kTVMVMBytecodeMagic have the format version 0.
+ */
+constexpr uint64_t kTVMVMBytecodeMagicVersioned = 0xD225DE2F4214151E;
+
+/*!
+ * \brief The format version of the saved VM bytecode files.
+ *
+ *  0: the format of the files with kTVMVMBytecodeMagic.
+ *  1: the constants are padded to an alignment saved before them, the memory scope and
+ *     the shape function tables follow the primitive names, and `AllocStorage` saves the
+ *     index of its memory scope.
+ */
+constexpr uint64_t kTVMVMFormatVersion = 1;
+
 template <typename T>
 static inline uint64_t VectorHash(uint64_t key, const std::vector<T>& values) {
   for (const auto& it : values) {
@@ -26,6 +26,7 @@
 #include <tvm/runtime/container.h>
 #include <tvm/runtime/memory.h>
 #include <tvm/runtime/object.h>
+#include <tvm/runtime/threading_backend.h>
 #include <tvm/runtime/vm/vm.h>
 #include <tvm/support/logging.h>
 
@@ -148,29 +149,37 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       }
       this->Init(contexts, alloc_types);
     });
+  } else if (name == "set_thread_pool") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->thread_pool_ = args[0].operator ObjectRef();
+    });
   } else if (name == "set_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       ICHECK(exec_) << "The executable is not created yet.";
       std::string func_name = args[0];
-      auto gvit = exec_->global_map.find(func_name);
-      ICHECK(gvit != exec_->global_map.end()) << "Cannot find function " << func_name;
-      auto func_index = gvit->second;
-      const auto& vm_func = exec_->functions[func_index];
-      const auto& param_names = vm_func.params;
-      ICHECK_EQ(args.size() - 1, param_names.size())
-          << "The number of provided parameters doesn't match the number of arguments";
-      ICHECK_EQ(param_names.size(), vm_func.params_device_type.size())
-          << "The number of provided parameters doesn't match the number of assigned devices";
-      std::vector<ObjectRef> func_args(param_names.size());
-      for (int i = 1; i < args.size(); ++i) {
-        Index device_type = vm_func.params_device_type[i - 1];
-        DLContext ctx = GetContext(device_type);
-        ObjectRef obj = CopyTo(args[i], ctx);
-        func_args[i - 1] = obj;
-      }
+      std::vector<ObjectRef> func_args = GetInputs(GetVMFunction(func_name), args, 1);
       inputs_.erase(func_name);
       inputs_.emplace(func_name, func_args);
     });
+  } else if (name == "run") {
+    // Run a function on the given inputs. Calls from different threads run at once,
+    // each on its own execution context.
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      ICHECK(exec_) << "The executable is not created yet.";
+      std::string func_name = args[0];
+      ObjectPtr<VirtualMachine> context = AcquireContext();
+      const VMFunction& vm_func = context->GetVMFunction(func_name);
+      *rv = context->Invoke(vm_func, context->GetInputs(vm_func, args, 1));
+      // A context that threw in the middle of a call is dropped with its frames
+      ReleaseContext(std::move(context));
+    });
+  } else if (name == "fork") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      ICHECK(exec_) << "The executable is not created yet.";
+      ObjectPtr<VirtualMachine> context = Fork();
+      context->parent_ = ObjectRef(sptr_to_self);
+      *rv = runtime::Module(context);
+    });
   } else {
     LOG(FATAL) << "Unknown packed function: " << name;
     return PackedFunc([sptr_to_self, name](TVMArgs args, TVMRetValue* rv) {});
@@ -186,6 +195,60 @@ inline TVMContext VirtualMachine::GetContext(Index device_type) const {
   return ctx;
 }
 
+const VMFunction& VirtualMachine::GetVMFunction(const std::string& func_name) const {
+  auto gvit = exec_->global_map.find(func_name);
+  ICHECK(gvit != exec_->global_map.end()) << "Cannot find function " << func_name;
+  return exec_->functions[gvit->second];
+}
+
+std::vector<ObjectRef> VirtualMachine::GetInputs(const VMFunction& vm_func, const TVMArgs& args,
+                                                 int offset) const {
+  const auto& param_names = vm_func.params;
+  ICHECK_EQ(args.size() - offset, param_names.size())
+      << "The number of provided parameters doesn't match the number of arguments";
+  ICHECK_EQ(param_names.size(), vm_func.params_device_type.size())
+      << "The number of provided parameters doesn't match the number of assigned devices";
+  std::vector<ObjectRef> func_args(param_names.size());
+  for (int i = offset; i < args.size(); ++i) {
+    Index device_type = vm_func.params_device_type[i - offset];
+    DLContext ctx = GetContext(device_type);
+    ObjectRef obj = CopyTo(args[i], ctx);
+    func_args[i - offset] = obj;
+  }
+  return func_args;
+}
+
+ObjectPtr<VirtualMachine> VirtualMachine::Fork() const {
+  ICHECK(exec_) << "The executable is not created yet.";
+  auto context = make_object<VirtualMachine>();
+  context->exec_ = exec_;
+  context->exec_ref_ = exec_ref_;
+  context->packed_funcs_ = packed_funcs_;
+  context->is_shape_func_ = is_shape_func_;
+  context->ctxs_ = ctxs_;
+  context->allocators_ = allocators_;
+  context->const_pool_ = const_pool_;
+  context->thread_pool_ = thread_pool_;
+  return context;
+}
+
+ObjectPtr<VirtualMachine> VirtualMachine::AcquireContext() {
+  {
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    if (!idle_contexts_.empty()) {
+      ObjectPtr<VirtualMachine> context = std::move(idle_contexts_.back());
+      idle_contexts_.pop_back();
+      return context;
+    }
+  }
+  return Fork();
+}
+
+void VirtualMachine::ReleaseContext(ObjectPtr<VirtualMachine> context) {
+  std::lock_guard<std::mutex> lock(context_mutex_);
+  idle_contexts_.push_back(std::move(context));
+}
+
 void VirtualMachine::PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func) {
   auto frame = VMFrame(ret_pc, func_index_, arg_count, code_, vm_func.register_file_size);
   frames_.push_back(frame);
@@ -218,6 +281,7 @@ void VirtualMachine::InvokeGlobal(const VMFunction& func, const std::vector<Obje
 ObjectRef VirtualMachine::Invoke(const VMFunction& func, const std::vector<ObjectRef>& args) {
   DLOG(INFO) << "Executing Function: " << std::endl << func;
 
+  threading::ThreadPoolScope pool_scope(thread_pool_);
   InvokeGlobal(func, args);
   RunLoop();
   return return_register_;
@@ -243,25 +307,23 @@ void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func, In
     }
   }
 
-  std::vector<TVMValue> values(arity);
-  std::vector<int> codes(arity);
-  runtime::TVMArgsSetter setter(values.data(), codes.data());
+  packed_values_.resize(arity);
+  packed_codes_.resize(arity);
+  runtime::TVMArgsSetter setter(packed_values_.data(), packed_codes_.data());
   int idx = 0;
   bool is_empty_output = false;
   for (Index i = 0; i < arg_count; i++) {
     if (const auto* dt_cell = args[i].as<ADTObj>()) {
       for (size_t fi = 0; fi < dt_cell->size; ++fi) {
-        auto obj = (*dt_cell)[fi];
-        auto nd_array = Downcast<NDArray>(obj);
-        setter(idx++, nd_array);
+        setter(idx++, Downcast<NDArray>((*dt_cell)[fi]));
       }
     } else {
       auto nd_array = Downcast<NDArray>(args[i]);
       // We can safely skip CallPacked if there is only one
       // output and it is empty.
       if (i == arg_count - 1 && output_size == 1) {
-        for (const auto& dim : nd_array.Shape()) {
-          if (!dim) {
+        for (int d = 0; d < nd_array->ndim; ++d) {
+          if (!nd_array->shape[d]) {
             is_empty_output = true;
             break;
           }
@@ -273,13 +335,64 @@ void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func, In
 
   if (!is_empty_output) {
     TVMRetValue rv;
-    func.CallPacked(TVMArgs(values.data(), codes.data(), arity), &rv);
+    func.CallPacked(TVMArgs(packed_values_.data(), packed_codes_.data(), arity), &rv);
+  }
+}
+
+/*! \brief The largest total size of the inputs of a shape function whose result is cached. */
+static constexpr size_t kMaxShapeFuncCacheInputBytes = 4096;
+
+void VirtualMachine::InvokeShapeFunc(const Instruction& instr, const PackedFunc& func,
+                                     const std::vector<ObjectRef>& args) {
+  Index num_inputs = instr.arity - instr.output_size;
+  // The key is the content of the inputs, which are host tensors of shapes or small data
+  std::string key;
+  bool cacheable = true;
+  for (Index i = 0; i < instr.arity; ++i) {
+    const auto* array = args[i].as<NDArray::Container>();
+    if (array == nullptr || array->dl_tensor.ctx.device_type != kDLCPU ||
+        !IsContiguous(array->dl_tensor)) {
+      cacheable = false;
+      break;
+    }
+    if (i >= num_inputs) continue;
+    const DLTensor& tensor = array->dl_tensor;
+    size_t nbytes = GetDataSize(tensor);
+    if (key.size() + nbytes > kMaxShapeFuncCacheInputBytes) {
+      cacheable = false;
+      break;
+    }
+    key.append(reinterpret_cast<const char*>(&tensor.dtype), sizeof(tensor.dtype));
+    key.append(reinterpret_cast<const char*>(&tensor.ndim), sizeof(tensor.ndim));
+    key.append(reinterpret_cast<const char*>(tensor.shape), sizeof(int64_t) * tensor.ndim);
+    key.append(static_cast<const char*>(tensor.data) + tensor.byte_offset, nbytes);
+  }
+  if (!cacheable) {
+    InvokePacked(instr.packed_index, func, instr.arity, instr.output_size, args);
+    return;
+  }
+
+  ShapeFuncCacheEntry& entry = shape_func_cache_[&instr];
+  if (entry.inputs == key && !entry.outputs.empty()) {
+    for (Index i = 0; i < instr.output_size; ++i) {
+      Downcast<NDArray>(args[num_inputs + i]).CopyFrom(entry.outputs[i]);
+    }
+    return;
+  }
+  InvokePacked(instr.packed_index, func, instr.arity, instr.output_size, args);
+  entry.inputs = std::move(key);
+  entry.outputs.clear();
+  for (Index i = 0; i < instr.output_size; ++i) {
+    NDArray output = Downcast<NDArray>(args[num_inputs + i]);
+    entry.outputs.push_back(output.CopyTo({kDLCPU, 0}));
   }
 }
 
 void VirtualMachine::LoadExecutable(const Executable* exec) {
   ICHECK(exec) << "The executable is not created yet.";
   exec_ = exec;
+  exec_ref_ = ObjectRef(GetObjectPtr<Object>(const_cast<Executable*>(exec)));
+  const_pool_ = std::make_shared<VMConstantPool>(exec->constants.size());
 
   runtime::Module lib = exec_->lib;
   // Get the list of packed functions.
@@ -299,6 +412,12 @@ void VirtualMachine::LoadExecutable(const Executable* exec) {
   for (size_t i = 0; i < packed_funcs_.size(); ++i) {
     ICHECK(packed_funcs_[i] != nullptr) << "Packed function " << i << " is not initialized";
   }
+  is_shape_func_.assign(packed_funcs_.size(), false);
+  for (Index index : exec_->shape_funcs) {
+    ICHECK_LT(static_cast<size_t>(index), is_shape_func_.size());
+    is_shape_func_[index] = true;
+  }
+  shape_func_cache_.clear();
 }
 
 void VirtualMachine::Init(const std::vector<TVMContext>& ctxs,
@@ -321,34 +440,44 @@ inline void VirtualMachine::WriteRegister(Index r, const ObjectRef& val) {
   frames_.back().register_file[r] = val;
 }
 
-inline ObjectRef VirtualMachine::ReadRegister(Index r) const {
+inline const ObjectRef& VirtualMachine::ReadRegister(Index r) const {
   return frames_.back().register_file[r];
 }
 
 inline int64_t VirtualMachine::LoadScalarInt(Index r) const {
   int64_t result = 0;
   const auto& obj = ReadRegister(r);
-  NDArray array = Downcast<NDArray>(CopyTo(obj, {kDLCPU, 0}));
+  // Scalars are almost always on the host already, read them without copying
+  NDArray host_array;
+  const DLTensor* array;
+  const auto* container = obj.as<NDArray::Container>();
+  if (container != nullptr && container->dl_tensor.ctx.device_type == kDLCPU) {
+    array = &container->dl_tensor;
+  } else {
+    host_array = Downcast<NDArray>(CopyTo(obj, {kDLCPU, 0}));
+    array = host_array.operator->();
+  }
+  const void* data = static_cast<const char*>(array->data) + array->byte_offset;
 
   switch (array->dtype.bits) {
     case 1: {
-      result = reinterpret_cast<bool*>(array->data)[0];
+      result = static_cast<const bool*>(data)[0];
       break;
     }
     case 8: {
-      result = reinterpret_cast<int8_t*>(array->data)[0];
+      result = static_cast<const int8_t*>(data)[0];
       break;
     }
     case 16: {
-      result = reinterpret_cast<int16_t*>(array->data)[0];
+      result = static_cast<const int16_t*>(data)[0];
       break;
     }
     case 32: {
-      result = reinterpret_cast<int32_t*>(array->data)[0];
+      result = static_cast<const int32_t*>(data)[0];
       break;
     }
     case 64: {
-      result = reinterpret_cast<int64_t*>(array->data)[0];
+      result = static_cast<const int64_t*>(data)[0];
       break;
     }
     default:
@@ -369,9 +498,9 @@ void VirtualMachine::RunLoop() {
 
     switch (instr.op) {
       case Opcode::Move: {
-        ObjectRef from_obj;
-        from_obj = ReadRegister(instr.from);
-        WriteRegister(instr.dst, from_obj);
+        if (instr.from != instr.dst) {
+          WriteRegister(instr.dst, ReadRegister(instr.from));
+        }
         pc_++;
         goto main_loop;
       }
@@ -379,19 +508,21 @@ void VirtualMachine::RunLoop() {
         throw std::runtime_error("VM encountered fatal error");
       }
       case Opcode::LoadConst: {
-        auto constant_obj = exec_->constants[instr.const_index];
         // We cache the allocated object in the constant pool. To measure, the
         // first iteration will set the pool up. The other iterations will
-        // directly reuse the allocated objects.
-        if (const_pool_.size() <= static_cast<size_t>(instr.const_index)) {
-          const_pool_.resize(instr.const_index + 1);
-        }
-
-        if (!const_pool_[instr.const_index].defined()) {
-          TVMContext ctx = GetContext(exec_->const_device_type[instr.const_index]);
-          const_pool_[instr.const_index] = CopyTo(constant_obj, ctx);
+        // directly reuse the allocated objects. The pool is shared by the
+        // execution contexts, only the first load of a constant takes the lock.
+        VMConstantPool* pool = const_pool_.get();
+        if (!pool->loaded[instr.const_index].load(std::memory_order_acquire)) {
+          std::lock_guard<std::mutex> lock(pool->mutex);
+          if (!pool->loaded[instr.const_index].load(std::memory_order_relaxed)) {
+            auto constant_obj = exec_->constants[instr.const_index];
+            TVMContext ctx = GetContext(exec_->const_device_type[instr.const_index]);
+            pool->objects[instr.const_index] = CopyTo(constant_obj, ctx);
+            pool->loaded[instr.const_index].store(true, std::memory_order_release);
+          }
         }
-        WriteRegister(instr.dst, const_pool_[instr.const_index]);
+        WriteRegister(instr.dst, pool->objects[instr.const_index]);
         pc_++;
         goto main_loop;
       }
@@ -413,19 +544,24 @@ void VirtualMachine::RunLoop() {
       }
       case Opcode::InvokePacked: {
         DLOG(INFO) << "InvokedPacked " << instr.packed_index << " arity=" << instr.arity;
-        ICHECK_LE(instr.packed_index, packed_funcs_.size());
+        ICHECK_LT(instr.packed_index, packed_funcs_.size());
         const auto& func = packed_funcs_[instr.packed_index];
         const auto& arity = instr.arity;
-        std::vector<ObjectRef> args;
+        packed_args_.clear();
         for (Index i = 0; i < arity; ++i) {
           DLOG(INFO) << "arg" << i << " $" << instr.packed_args[i];
-          auto arg = ReadRegister(instr.packed_args[i]);
-          args.push_back(arg);
+          packed_args_.push_back(ReadRegister(instr.packed_args[i]));
         }
 
         // We no longer need to write the registers back, we write directly
         // through the registers mutably.
-        InvokePacked(instr.packed_index, func, arity, instr.output_size, args);
+        if (is_shape_func_[instr.packed_index]) {
+          InvokeShapeFunc(instr, func, packed_args_);
+        } else {
+          InvokePacked(instr.packed_index, func, arity, instr.output_size, packed_args_);
+        }
+        // Do not keep the arguments alive until the next call
+        packed_args_.clear();
         pc_++;
         goto main_loop;
       }
@@ -445,10 +581,9 @@ void VirtualMachine::RunLoop() {
         goto main_loop;
       }
       case Opcode::GetField: {
-        auto object = ReadRegister(instr.object);
-        const auto& tuple = Downcast<ADT>(object);
-        auto field = tuple[instr.field_index];
-        WriteRegister(instr.dst, field);
+        const auto* tuple = ReadRegister(instr.object).as<ADTObj>();
+        ICHECK(tuple != nullptr) << "GetField expects an ADT";
+        WriteRegister(instr.dst, (*tuple)[instr.field_index]);
         pc_++;
         goto main_loop;
       }
@@ -533,9 +668,14 @@ void VirtualMachine::RunLoop() {
         auto size = LoadScalarInt(instr.alloc_storage.allocation_size);
         auto alignment = instr.alloc_storage.alignment;
 
+        ICHECK_LT(static_cast<size_t>(instr.alloc_storage.memory_scope),
+                  exec_->memory_scopes.size());
+        const std::string& scope = exec_->memory_scopes[instr.alloc_storage.memory_scope];
+
         DLOG(INFO) << "AllocStorage: allocation_size=" << size << ", alignment=" << alignment
                    << ", dtype_hint=" << DLDataType2String(instr.alloc_storage.dtype_hint)
-                   << ", device_type=" << instr.alloc_storage.device_type;
+                   << ", device_type=" << instr.alloc_storage.device_type
+                   << ", memory_scope=" << scope;
 
         auto storage_obj = SimpleObjAllocator().make_object<StorageObj>();
         auto dev_type = instr.alloc_storage.device_type;
@@ -543,7 +683,15 @@ void VirtualMachine::RunLoop() {
             << "Memory allocator for device " << dev_type << " has not been initialized";
         auto* alloc = allocators_[dev_type];
         ICHECK(alloc) << "Did you forget to init the VirtualMachine with contexts?";
-        storage_obj->buffer = alloc->Alloc(size, alignment, instr.alloc_storage.dtype_hint);
+        if (scope == "global") {
+          storage_obj->buffer = alloc->Alloc(size, alignment, instr.alloc_storage.dtype_hint);
+        } else {
+          // The layout of scoped memory depends on the shape of the tensor, which
+          // is only known once the first tensor is allocated from the storage.
+          storage_obj->buffer.ctx = GetContext(dev_type);
+          storage_obj->buffer.size = size;
+          storage_obj->buffer.scope = scope;
+        }
         Storage storage(storage_obj);
         WriteRegister(instr.dst, storage);
         pc_++;
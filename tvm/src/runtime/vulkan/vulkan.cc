@@ -23,11 +23,16 @@
 #include <tvm/runtime/registry.h>
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <cstring>
+#include <string>
 
 #include "../file_utils.h"
+#include "../memory_stats.h"
 #include "../pack_args.h"
+#include "../texture.h"
 #include "../thread_storage_scope.h"
 #include "../workspace_pool.h"
 #include "vulkan_common.h"
@@ -57,38 +62,58 @@ class VulkanThreadEntry {
     // The destruction need to be manually called
     // to ensure the destruction order.
 
+    texture_pool.reset();
     pool.reset();
     streams_.clear();
     for (const auto& kv : staging_buffers_) {
-      if (!kv.second) {
-        continue;
-      }
-      auto& buf = *(kv.second);
-      if (buf.host_addr != nullptr) {
-        vkUnmapMemory(buf.device, buf.memory);
-      }
-      if (buf.memory != VK_NULL_HANDLE) {
-        vkFreeMemory(buf.device, buf.memory, nullptr);
-      }
-      if (buf.buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(buf.device, buf.buffer, nullptr);
+      for (const auto& buf : kv.second) {
+        ReleaseStagingBuffer(buf.get());
       }
     }
   }
 
   TVMContext ctx;
+  // The device whose kernels are captured, -1 when not capturing.
+  int capture_device{-1};
   std::unique_ptr<WorkspacePool> pool;
+  std::unique_ptr<TexturePool> texture_pool;
   VulkanStream* Stream(size_t device_id);
+  /*!
+   * \brief Get a staging buffer of at least `size` bytes from the ring of the device, not used
+   *  by an unfinished submission. Set its submission after recording a copy through it.
+   */
   VulkanStagingBuffer* StagingBuffer(int device_id, size_t size);
 
  private:
+  static void ReleaseStagingBuffer(VulkanStagingBuffer* buf);
+
   std::unordered_map<size_t, std::unique_ptr<VulkanStream>> streams_;
-  std::unordered_map<size_t, std::unique_ptr<VulkanStagingBuffer>> staging_buffers_;
+  // The staging ring of every device.
+  std::unordered_map<size_t, std::vector<std::unique_ptr<VulkanStagingBuffer>>> staging_buffers_;
 };
 
+/*! \brief The number of staging buffers per device, the uploads in flight at once. */
+static constexpr const size_t kVulkanStagingRingSize = 4;
+
 struct VulkanBuffer {
   VkBuffer buffer{VK_NULL_HANDLE};
   VkDeviceMemory memory{VK_NULL_HANDLE};
+  // The persistent mapping of the memory on host mapped devices, nullptr otherwise.
+  void* host_addr{nullptr};
+  // The storage image and its view backing a texture scope, in place of the buffer.
+  VkImage image{VK_NULL_HANDLE};
+  VkImageView view{VK_NULL_HANDLE};
+  // The texture scope the image was allocated for, and its extent.
+  std::string scope;
+  uint32_t width{0};
+  uint32_t height{0};
+  uint32_t layers{1};
+};
+
+// The descriptor of a kernel argument, a storage buffer or a storage image.
+union VulkanDescriptorInfo {
+  VkDescriptorBufferInfo buffer;
+  VkDescriptorImageInfo image;
 };
 
 struct VulkanPipeline {
@@ -100,8 +125,108 @@ struct VulkanPipeline {
   VkPipelineLayout pipeline_layout{VK_NULL_HANDLE};
   VkPipeline pipeline{VK_NULL_HANDLE};
   VkDescriptorUpdateTemplateKHR descriptor_update_template{VK_NULL_HANDLE};
+  // The buffer arguments bound as storage images, bit i for the i-th buffer argument.
+  uint32_t image_args{0};
+  bool IsImageArg(size_t i) const { return i < 32 && ((image_args >> i) & 1U); }
 };
 
+/*!
+ * \brief The format of the storage images backing the texture scopes.
+ * \param dtype The element type of the texture.
+ * \param channel The number of channels per texel, 1, 2 or 4.
+ */
+VkFormat GetTextureFormat(DLDataType dtype, size_t channel) {
+  ICHECK(channel == 1 || channel == 2 || channel == 4)
+      << "Vulkan textures have 1, 2 or 4 channels, got " << channel;
+  size_t index = channel == 4 ? 2 : channel - 1;
+  static const VkFormat kFloat16[] = {VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT,
+                                      VK_FORMAT_R16G16B16A16_SFLOAT};
+  static const VkFormat kFloat32[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+                                      VK_FORMAT_R32G32B32A32_SFLOAT};
+  static const VkFormat kInt8[] = {VK_FORMAT_R8_SINT, VK_FORMAT_R8G8_SINT,
+                                   VK_FORMAT_R8G8B8A8_SINT};
+  static const VkFormat kInt16[] = {VK_FORMAT_R16_SINT, VK_FORMAT_R16G16_SINT,
+                                    VK_FORMAT_R16G16B16A16_SINT};
+  static const VkFormat kInt32[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT,
+                                    VK_FORMAT_R32G32B32A32_SINT};
+  static const VkFormat kUInt8[] = {VK_FORMAT_R8_UINT, VK_FORMAT_R8G8_UINT,
+                                    VK_FORMAT_R8G8B8A8_UINT};
+  static const VkFormat kUInt16[] = {VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT,
+                                     VK_FORMAT_R16G16B16A16_UINT};
+  static const VkFormat kUInt32[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT,
+                                     VK_FORMAT_R32G32B32A32_UINT};
+  const VkFormat* formats = nullptr;
+  if (dtype.code == kDLFloat) {
+    formats = dtype.bits == 16 ? kFloat16 : dtype.bits == 32 ? kFloat32 : nullptr;
+  } else if (dtype.code == kDLInt) {
+    formats = dtype.bits == 8 ? kInt8 : dtype.bits == 16 ? kInt16 : dtype.bits == 32 ? kInt32
+                                                                                      : nullptr;
+  } else if (dtype.code == kDLUInt) {
+    formats = dtype.bits == 8 ? kUInt8 : dtype.bits == 16 ? kUInt16 : dtype.bits == 32 ? kUInt32
+                                                                                        : nullptr;
+  }
+  ICHECK(formats != nullptr && dtype.lanes == 1)
+      << "Unsupported texture type " << DLDataType2String(dtype)
+      << ", currently only float, half and up to 32 bit integers are supported";
+  return formats[index];
+}
+
+// Make the host writes to a staging buffer visible to the device.
+void FlushStaging(const VulkanContext& vctx, const VulkanStagingBuffer* temp) {
+  if (vctx.coherent_staging) return;
+  VkMappedMemoryRange mrange;
+  mrange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  mrange.pNext = nullptr;
+  mrange.memory = temp->memory;
+  mrange.offset = 0;
+  mrange.size = VK_WHOLE_SIZE;
+  VULKAN_CALL(vkFlushMappedMemoryRanges(vctx.device, 1, &mrange));
+}
+
+// Make the device writes to a staging buffer visible to the host.
+void InvalidateStaging(const VulkanContext& vctx, const VulkanStagingBuffer* temp) {
+  if (vctx.coherent_staging) return;
+  VkMappedMemoryRange mrange;
+  mrange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  mrange.pNext = nullptr;
+  mrange.memory = temp->memory;
+  mrange.offset = 0;
+  mrange.size = VK_WHOLE_SIZE;
+  VULKAN_CALL(vkInvalidateMappedMemoryRanges(vctx.device, 1, &mrange));
+}
+
+// Whether an allocation is a storage image.
+bool IsImage(const void* ptr) {
+  return static_cast<const VulkanBuffer*>(ptr)->image != VK_NULL_HANDLE;
+}
+
+/*!
+ * \brief The region of the image covered by a tensor view, tightly packed on the buffer side.
+ *  Textures allocated by the texture pool can be larger than the tensors viewing them.
+ */
+VkBufferImageCopy GetTextureRegion(const DLTensor* tensor) {
+  const auto* buf = static_cast<const VulkanBuffer*>(tensor->data);
+  ICHECK_EQ(tensor->byte_offset, 0) << "Offset views of texture memory are not supported";
+  auto texture = ApplyTextureFlattening<int64_t>(tensor->shape, tensor->ndim, buf->scope);
+  ICHECK(texture.width <= buf->width && texture.height <= buf->height &&
+         texture.depth <= buf->layers)
+      << "Tensor view of shape (" << texture.depth << ", " << texture.height << ", "
+      << texture.width << ") exceeds the underlying image of shape (" << buf->layers << ", "
+      << buf->height << ", " << buf->width << ")";
+  VkBufferImageCopy region;
+  region.bufferOffset = 0;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = static_cast<uint32_t>(texture.depth);
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {static_cast<uint32_t>(texture.width),
+                        static_cast<uint32_t>(texture.height), 1};
+  return region;
+}
+
 typedef dmlc::ThreadLocalStore<VulkanThreadEntry> VulkanThreadStore;
 
 class VulkanDeviceAPI final : public DeviceAPI {
@@ -184,21 +309,46 @@ class VulkanDeviceAPI final : public DeviceAPI {
     VulkanBuffer* pbuf = new VulkanBuffer();
     pbuf->memory = memory;
     pbuf->buffer = buffer;
+    if (vctx.host_mapped_compute) {
+      VULKAN_CALL(vkMapMemory(vctx.device, memory, 0, VK_WHOLE_SIZE, 0, &(pbuf->host_addr)));
+    }
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kGlobal, pbuf, nbytes);
     return pbuf;
   }
 
+  void* AllocDataSpace(TVMContext ctx, int ndim, const int64_t* shape, DLDataType dtype,
+                       Optional<String> mem_scope = NullOpt) final;
+
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
     // Before releasing the vkBuffer, call sync to
     // finish all the vulkan commands that reference the buffer.
     StreamSync(ctx, nullptr);
+    MemoryStats::Global()->Free(ctx, MemoryKind::kGlobal, ptr);
 
     const auto& vctx = context(ctx.device_id);
     auto* pbuf = static_cast<VulkanBuffer*>(ptr);
-    vkDestroyBuffer(vctx.device, pbuf->buffer, nullptr);
+    if (pbuf->image != VK_NULL_HANDLE) {
+      vkDestroyImageView(vctx.device, pbuf->view, nullptr);
+      vkDestroyImage(vctx.device, pbuf->image, nullptr);
+    } else {
+      vkDestroyBuffer(vctx.device, pbuf->buffer, nullptr);
+    }
+    if (pbuf->host_addr != nullptr) {
+      vkUnmapMemory(vctx.device, pbuf->memory);
+    }
     vkFreeMemory(vctx.device, pbuf->memory, nullptr);
     delete pbuf;
   }
 
+  // Copies between textures and host or buffer memory, the other copies go through the
+  // byte copy below.
+  void CopyDataFromTo(DLTensor* from, DLTensor* to, TVMStreamHandle stream) final;
+
+  // Allocate and free the textures of a kernel through the texture pool of the thread.
+  void* AllocTextureWorkspace(TVMContext ctx, size_t width, size_t height, size_t channel,
+                              DLDataType type_hint);
+  void FreeTextureWorkspace(TVMContext ctx, void* ptr);
+
  protected:
   void CopyDataFromTo(const void* from, size_t from_offset, void* to, size_t to_offset, size_t size,
                       TVMContext ctx_from, TVMContext ctx_to, DLDataType type_hint,
@@ -208,6 +358,9 @@ class VulkanDeviceAPI final : public DeviceAPI {
     if (ctx_from.device_type == kDLCPU) {
       ctx = ctx_to;
     }
+    ICHECK(!(ctx_from.device_type == kDLVulkan && IsImage(from)) &&
+           !(ctx_to.device_type == kDLVulkan && IsImage(to)))
+        << "Copies of texture memory need the shape of the tensor";
 
     int from_dev_type = static_cast<int>(ctx_from.device_type);
     int to_dev_type = static_cast<int>(ctx_to.device_type);
@@ -241,67 +394,65 @@ class VulkanDeviceAPI final : public DeviceAPI {
     } else if (from_dev_type == kDLVulkan && to_dev_type == kDLCPU) {
       const auto* from_buf = static_cast<const VulkanBuffer*>(from);
       const auto& vctx = context(ctx_from.device_id);
-      auto* temp = VulkanThreadEntry::ThreadLocal()->StagingBuffer(ctx_from.device_id, size);
-      VulkanThreadEntry::ThreadLocal()
-          ->Stream(ctx_from.device_id)
-          ->Launch([&](VulkanStreamState* state) {
-            VkBufferCopy copy_info;
-            copy_info.srcOffset = from_offset;
-            copy_info.dstOffset = 0;
-            copy_info.size = size;
-            vkCmdCopyBuffer(state->cmd_buffer_, from_buf->buffer, temp->buffer, 1, &copy_info);
-          });
-      VulkanThreadEntry::ThreadLocal()->Stream(ctx_from.device_id)->Synchronize();
-      if (!vctx.coherent_staging) {
-        VkMappedMemoryRange mrange;
-        mrange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mrange.pNext = nullptr;
-        mrange.memory = temp->memory;
-        mrange.offset = 0;
-        mrange.size = VK_WHOLE_SIZE;  // size;
-        VULKAN_CALL(vkInvalidateMappedMemoryRanges(vctx.device, 1, &mrange));
+      VulkanThreadEntry* t = VulkanThreadEntry::ThreadLocal();
+      VulkanStream* s = t->Stream(ctx_from.device_id);
+      if (from_buf->host_addr != nullptr) {
+        // Host mapped memory is read in place once the work writing it finished.
+        s->Flush();
+        memcpy(static_cast<char*>(to) + to_offset,
+               static_cast<const char*>(from_buf->host_addr) + from_offset, size);
+        return;
       }
+      VulkanStagingBuffer* temp = t->StagingBuffer(ctx_from.device_id, size);
+      VkBuffer src = from_buf->buffer, dst = temp->buffer;
+      s->Launch([=](VulkanStreamState* state) {
+        VkBufferCopy copy_info;
+        copy_info.srcOffset = from_offset;
+        copy_info.dstOffset = 0;
+        copy_info.size = size;
+        vkCmdCopyBuffer(state->cmd_buffer_, src, dst, 1, &copy_info);
+      });
+      s->Synchronize();
+      InvalidateStaging(vctx, temp);
       memcpy(static_cast<char*>(to) + to_offset, static_cast<char*>(temp->host_addr), size);
     } else if (from_dev_type == kDLCPU && to_dev_type == kDLVulkan) {
       const auto& vctx = context(ctx_to.device_id);
       const auto* to_buf = static_cast<const VulkanBuffer*>(to);
-      VulkanStagingBuffer* temp =
-          VulkanThreadEntry::ThreadLocal()->StagingBuffer(ctx_to.device_id, size);
+      VulkanThreadEntry* t = VulkanThreadEntry::ThreadLocal();
+      VulkanStream* s = t->Stream(ctx_to.device_id);
+      if (to_buf->host_addr != nullptr) {
+        // Host mapped memory is written in place once the work using it finished.
+        s->Flush();
+        memcpy(static_cast<char*>(to_buf->host_addr) + to_offset,
+               static_cast<const char*>(from) + from_offset, size);
+        return;
+      }
+      VulkanStagingBuffer* temp = t->StagingBuffer(ctx_to.device_id, size);
       memcpy(temp->host_addr, static_cast<const char*>(from) + from_offset, size);
       // host side flush if access is not coherent.
       // so writes from CPU is visible to GPU
-      if (!vctx.coherent_staging) {
-        VkMappedMemoryRange mrange;
-        mrange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mrange.pNext = nullptr;
-        mrange.memory = temp->memory;
-        mrange.offset = 0;
-        mrange.size = VK_WHOLE_SIZE;  // size;
-        VULKAN_CALL(vkFlushMappedMemoryRanges(vctx.device, 1, &mrange));
-      }
-
-      VulkanThreadEntry::ThreadLocal()
-          ->Stream(ctx_from.device_id)
-          ->Launch([&](VulkanStreamState* state) {
-            // 0: barrier(host->transfer)
-            VkMemoryBarrier barrier_info;
-            barrier_info.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-            barrier_info.pNext = nullptr;
-            barrier_info.srcAccessMask = 0;
-            barrier_info.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            vkCmdPipelineBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_HOST_BIT,
-                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier_info, 0, nullptr, 0,
-                                 nullptr);
-            // 1: copy
-            VkBufferCopy copy_info;
-            copy_info.srcOffset = 0;
-            copy_info.dstOffset = to_offset;
-            copy_info.size = size;
-            vkCmdCopyBuffer(state->cmd_buffer_, temp->buffer, to_buf->buffer, 1, &copy_info);
-          });
-      // TODO(tulloch): should we instead make the staging buffer a property of the
-      // Stream? This would allow us to elide synchronizations here.
-      VulkanThreadEntry::ThreadLocal()->Stream(ctx_from.device_id)->Synchronize();
+      FlushStaging(vctx, temp);
+      VkBuffer src = temp->buffer, dst = to_buf->buffer;
+      s->Launch([=](VulkanStreamState* state) {
+        // 0: barrier(host->transfer)
+        RecordMemoryBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        // 1: copy
+        VkBufferCopy copy_info;
+        copy_info.srcOffset = 0;
+        copy_info.dstOffset = to_offset;
+        copy_info.size = size;
+        vkCmdCopyBuffer(state->cmd_buffer_, src, dst, 1, &copy_info);
+        // 2: barrier(transfer->compute|transfer)
+        RecordMemoryBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            VK_ACCESS_TRANSFER_WRITE_BIT,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                            VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+                                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+      });
+      // The upload runs behind the work launched before it without blocking the host, its
+      // staging buffer is reused once the submission finished.
+      temp->submission = s->Submit();
     } else {
       LOG(FATAL) << "Expect copy from/to Vulkan or between Vulkan"
                  << ", from=" << from_dev_type << ", to=" << to_dev_type;
@@ -354,6 +505,11 @@ class VulkanDeviceAPI final : public DeviceAPI {
   }
 
  private:
+  // Allocate a storage image of `layers` images of width x height texels, kept in the
+  // general layout for both kernel accesses and copies.
+  VulkanBuffer* AllocImage(TVMContext ctx, size_t width, size_t height, size_t layers,
+                           size_t channel, DLDataType dtype, bool arrayed);
+
   VkInstance instance_{nullptr};
   // The physical devices, have 1 to 1 mapping to devices
   std::vector<VulkanContext> context_;
@@ -557,7 +713,19 @@ VulkanDeviceAPI::VulkanDeviceAPI() {
     device_create_info.ppEnabledLayerNames = nullptr;
     device_create_info.enabledExtensionCount = extensions.size();
     device_create_info.ppEnabledExtensionNames = extensions.data();
-    device_create_info.pEnabledFeatures = nullptr;
+    // Storage images without a declared format back the texture scopes, the channel count
+    // of a texture is only known to the runtime.
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(phy_dev, &supported_features);
+    VkPhysicalDeviceFeatures enabled_features;
+    std::memset(&enabled_features, 0, sizeof(enabled_features));
+    ctx.storage_image_without_format = supported_features.shaderStorageImageReadWithoutFormat &&
+                                       supported_features.shaderStorageImageWriteWithoutFormat;
+    if (ctx.storage_image_without_format) {
+      enabled_features.shaderStorageImageReadWithoutFormat = VK_TRUE;
+      enabled_features.shaderStorageImageWriteWithoutFormat = VK_TRUE;
+    }
+    device_create_info.pEnabledFeatures = &enabled_features;
     VULKAN_CALL(vkCreateDevice(phy_dev, &device_create_info, nullptr, &(ctx.device)));
     ctx.queue_mutex.reset(new std::mutex());
     vkGetDeviceQueue(ctx.device, queue_family_index, 0, &(ctx.queue));
@@ -629,6 +797,35 @@ VulkanDeviceAPI::VulkanDeviceAPI() {
       }
     }
     ICHECK_GE(win_rank, 0) << "Cannot find suitable local memory on device.";
+
+    // On unified memory devices (integrated GPUs) the largest device local heap is also host
+    // coherent. Compute buffers are then allocated from it and mapped, so that copies from and
+    // to the host skip the staging buffer. TVM_VULKAN_HOST_MAPPED=0 disables this.
+    const char* host_mapped = getenv("TVM_VULKAN_HOST_MAPPED");
+    if (host_mapped == nullptr || std::string(host_mapped) != "0") {
+      constexpr VkMemoryPropertyFlags kHostMapped = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+      VkDeviceSize local_heap_size = 0;
+      for (uint32_t k = 0; k < prop.memoryHeapCount; ++k) {
+        if (prop.memoryHeaps[k].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+          local_heap_size = std::max(local_heap_size, prop.memoryHeaps[k].size);
+        }
+      }
+      win_rank = -1;
+      for (uint32_t k = 0; k < prop.memoryTypeCount; ++k) {
+        VkMemoryType ty = prop.memoryTypes[k];
+        if ((ty.propertyFlags & kHostMapped) != kHostMapped) continue;
+        if (!(req_compute.memoryTypeBits & (1 << k))) continue;
+        if (prop.memoryHeaps[ty.heapIndex].size < local_heap_size) continue;
+        int rank = (ty.propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+        if (rank > win_rank) {
+          win_rank = rank;
+          ctx.compute_mtype_index = k;
+          ctx.host_mapped_compute = true;
+        }
+      }
+    }
     auto has_extension = [&extensions](const char* query) {
       return std::any_of(extensions.begin(), extensions.end(),
                          [&](const char* extension) { return std::strcmp(query, extension) == 0; });
@@ -701,6 +898,232 @@ std::vector<uint32_t> VulkanDeviceAPI::GetComputeQueueFamilies(VkPhysicalDevice
   return result;
 }
 
+void* VulkanDeviceAPI::AllocDataSpace(TVMContext ctx, int ndim, const int64_t* shape,
+                                      DLDataType dtype, Optional<String> mem_scope) {
+  if (!mem_scope.defined() || mem_scope.value() == "global") {
+    return DeviceAPI::AllocDataSpace(ctx, ndim, shape, dtype, mem_scope);
+  }
+  std::string scope = mem_scope.value();
+  ICHECK(IsTextureStorage(scope)) << "Device does not support allocate data space with "
+                                  << "specified memory scope: " << scope;
+  ICHECK(ndim > 2) << "Shape for texture allocation must be at least rank 3; "
+                   << "provided shape is rank " << ndim;
+  auto texture = ApplyTextureFlattening<int64_t>(shape, ndim, scope);
+  VulkanBuffer* pbuf = AllocImage(ctx, texture.width, texture.height, texture.depth,
+                                  texture.channel, dtype, IsTextureArrayStorage(scope));
+  pbuf->scope = scope;
+  return pbuf;
+}
+
+VulkanBuffer* VulkanDeviceAPI::AllocImage(TVMContext ctx, size_t width, size_t height,
+                                          size_t layers, size_t channel, DLDataType dtype,
+                                          bool arrayed) {
+  const auto& vctx = context(ctx.device_id);
+  ICHECK(vctx.storage_image_without_format)
+      << "Vulkan textures need the shaderStorageImageReadWithoutFormat and "
+      << "shaderStorageImageWriteWithoutFormat features, not supported by the device";
+  const auto& limits = vctx.phy_device_prop.limits;
+  ICHECK(width <= limits.maxImageDimension2D && height <= limits.maxImageDimension2D &&
+         layers <= limits.maxImageArrayLayers)
+      << "Texture of " << layers << " images of " << width << "x" << height
+      << " exceeds the limits of the device, lower texture_spatial_limit of the target";
+  VkFormat format = GetTextureFormat(dtype, channel);
+  VkFormatProperties format_prop;
+  vkGetPhysicalDeviceFormatProperties(vctx.phy_device, format, &format_prop);
+  ICHECK(format_prop.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+      << "The device does not support storage images of " << channel << " channels of "
+      << DLDataType2String(dtype);
+
+  VkImageCreateInfo info;
+  info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  info.pNext = nullptr;
+  info.flags = 0;
+  info.imageType = VK_IMAGE_TYPE_2D;
+  info.format = format;
+  info.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+  info.mipLevels = 1;
+  info.arrayLayers = static_cast<uint32_t>(layers);
+  info.samples = VK_SAMPLE_COUNT_1_BIT;
+  info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+               VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  info.queueFamilyIndexCount = 1;
+  info.pQueueFamilyIndices = &(vctx.queue_family_index);
+  info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  VkImage image;
+  VULKAN_CALL(vkCreateImage(vctx.device, &info, nullptr, &image));
+
+  // Optimal tiling images can need other memory types than buffers, keep to the device
+  // local ones.
+  VkMemoryRequirements req;
+  vkGetImageMemoryRequirements(vctx.device, image, &req);
+  uint32_t mtype_index = vctx.compute_mtype_index;
+  if (!(req.memoryTypeBits & (1 << mtype_index))) {
+    VkPhysicalDeviceMemoryProperties prop;
+    vkGetPhysicalDeviceMemoryProperties(vctx.phy_device, &prop);
+    mtype_index = prop.memoryTypeCount;
+    for (uint32_t k = 0; k < prop.memoryTypeCount; ++k) {
+      if ((req.memoryTypeBits & (1 << k)) &&
+          (prop.memoryTypes[k].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+        mtype_index = k;
+        break;
+      }
+    }
+    ICHECK_LT(mtype_index, prop.memoryTypeCount) << "Cannot find suitable image memory on device.";
+  }
+  VkMemoryAllocateInfo minfo;
+  minfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  minfo.pNext = nullptr;
+  minfo.allocationSize = req.size;
+  minfo.memoryTypeIndex = mtype_index;
+  VkDeviceMemory memory;
+  VULKAN_CALL(vkAllocateMemory(vctx.device, &minfo, nullptr, &memory));
+  VULKAN_CALL(vkBindImageMemory(vctx.device, image, memory, 0));
+
+  VkImageSubresourceRange range;
+  range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  range.baseMipLevel = 0;
+  range.levelCount = 1;
+  range.baseArrayLayer = 0;
+  range.layerCount = static_cast<uint32_t>(layers);
+
+  VkImageViewCreateInfo view_info;
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.pNext = nullptr;
+  view_info.flags = 0;
+  view_info.image = image;
+  view_info.viewType = arrayed ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = format;
+  view_info.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                          VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+  view_info.subresourceRange = range;
+  VkImageView view;
+  VULKAN_CALL(vkCreateImageView(vctx.device, &view_info, nullptr, &view));
+
+  // The image may be used from the stream of another thread, the transition is completed before
+  // the allocation returns so that no stream sees it in the undefined layout.
+  VulkanStream* stream = VulkanThreadEntry::ThreadLocal()->Stream(ctx.device_id);
+  stream->Launch([=](VulkanStreamState* state) {
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+                            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    vkCmdPipelineBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+  });
+  stream->Synchronize();
+
+  VulkanBuffer* pbuf = new VulkanBuffer();
+  pbuf->memory = memory;
+  pbuf->image = image;
+  pbuf->view = view;
+  pbuf->width = static_cast<uint32_t>(width);
+  pbuf->height = static_cast<uint32_t>(height);
+  pbuf->layers = static_cast<uint32_t>(layers);
+  return pbuf;
+}
+
+void VulkanDeviceAPI::CopyDataFromTo(DLTensor* from, DLTensor* to, TVMStreamHandle stream) {
+  bool from_image = from->ctx.device_type == kDLVulkan && IsImage(from->data);
+  bool to_image = to->ctx.device_type == kDLVulkan && IsImage(to->data);
+  if (!from_image && !to_image) {
+    DeviceAPI::CopyDataFromTo(from, to, stream);
+    return;
+  }
+  ICHECK(stream == nullptr);
+  size_t nbytes = GetDataSize(*from);
+  ICHECK_EQ(nbytes, GetDataSize(*to));
+  ICHECK(IsContiguous(*from) && IsContiguous(*to))
+      << "CopyDataFromTo only support contiguous array for now";
+  VulkanThreadEntry* t = VulkanThreadEntry::ThreadLocal();
+  if (from->ctx.device_type == kDLVulkan && to->ctx.device_type == kDLVulkan) {
+    ICHECK_EQ(from->ctx.device_id, to->ctx.device_id) << "Vulkan disallow cross device copy.";
+    const auto* from_buf = static_cast<const VulkanBuffer*>(from->data);
+    const auto* to_buf = static_cast<const VulkanBuffer*>(to->data);
+    VkBufferImageCopy region = GetTextureRegion(from_image ? from : to);
+    region.bufferOffset = from_image ? to->byte_offset : from->byte_offset;
+    VkImageSubresourceLayers dst_subresource =
+        to_image ? GetTextureRegion(to).imageSubresource : region.imageSubresource;
+    t->Stream(from->ctx.device_id)->Launch([=](VulkanStreamState* state) {
+      if (from_image && to_image) {
+        VkImageCopy copy_info;
+        copy_info.srcSubresource = region.imageSubresource;
+        copy_info.srcOffset = region.imageOffset;
+        copy_info.dstSubresource = dst_subresource;
+        copy_info.dstOffset = region.imageOffset;
+        copy_info.extent = region.imageExtent;
+        vkCmdCopyImage(state->cmd_buffer_, from_buf->image, VK_IMAGE_LAYOUT_GENERAL,
+                       to_buf->image, VK_IMAGE_LAYOUT_GENERAL, 1, &copy_info);
+      } else if (from_image) {
+        vkCmdCopyImageToBuffer(state->cmd_buffer_, from_buf->image, VK_IMAGE_LAYOUT_GENERAL,
+                               to_buf->buffer, 1, &region);
+      } else {
+        vkCmdCopyBufferToImage(state->cmd_buffer_, from_buf->buffer, to_buf->image,
+                               VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+      }
+      RecordMemoryBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+                              VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    });
+  } else if (from_image && to->ctx.device_type == kDLCPU) {
+    const auto& vctx = context(from->ctx.device_id);
+    const auto* from_buf = static_cast<const VulkanBuffer*>(from->data);
+    VkBufferImageCopy region = GetTextureRegion(from);
+    VulkanStagingBuffer* temp = t->StagingBuffer(from->ctx.device_id, nbytes);
+    VkBuffer dst = temp->buffer;
+    t->Stream(from->ctx.device_id)->Launch([=](VulkanStreamState* state) {
+      vkCmdCopyImageToBuffer(state->cmd_buffer_, from_buf->image, VK_IMAGE_LAYOUT_GENERAL, dst,
+                             1, &region);
+    });
+    t->Stream(from->ctx.device_id)->Synchronize();
+    InvalidateStaging(vctx, temp);
+    memcpy(static_cast<char*>(to->data) + to->byte_offset, temp->host_addr, nbytes);
+  } else if (from->ctx.device_type == kDLCPU && to_image) {
+    const auto& vctx = context(to->ctx.device_id);
+    const auto* to_buf = static_cast<const VulkanBuffer*>(to->data);
+    VkBufferImageCopy region = GetTextureRegion(to);
+    VulkanStagingBuffer* temp = t->StagingBuffer(to->ctx.device_id, nbytes);
+    memcpy(temp->host_addr, static_cast<const char*>(from->data) + from->byte_offset, nbytes);
+    FlushStaging(vctx, temp);
+    VkBuffer src = temp->buffer;
+    VulkanStream* s = t->Stream(to->ctx.device_id);
+    s->Launch([=](VulkanStreamState* state) {
+      RecordMemoryBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+      vkCmdCopyBufferToImage(state->cmd_buffer_, src, to_buf->image, VK_IMAGE_LAYOUT_GENERAL, 1,
+                             &region);
+      RecordMemoryBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    });
+    temp->submission = s->Submit();
+  } else {
+    LOG(FATAL) << "Expect copy from/to Vulkan or between Vulkan";
+  }
+}
+
+void* VulkanDeviceAPI::AllocTextureWorkspace(TVMContext ctx, size_t width, size_t height,
+                                             size_t channel, DLDataType type_hint) {
+  return VulkanThreadEntry::ThreadLocal()->texture_pool->AllocTexture(ctx, width, height, channel,
+                                                                      type_hint);
+}
+
+void VulkanDeviceAPI::FreeTextureWorkspace(TVMContext ctx, void* ptr) {
+  VulkanThreadEntry::ThreadLocal()->texture_pool->FreeTexture(ctx, ptr);
+}
+
 // namespace vulkan
 class VulkanModuleNode;
 
@@ -807,17 +1230,23 @@ class VulkanModuleNode final : public runtime::ModuleNode {
     }
     std::vector<VkDescriptorSetLayoutBinding> arg_binding;
     std::vector<VkDescriptorUpdateTemplateEntryKHR> arg_template;
-    uint32_t num_pod = 0, num_buffer = 0;
+    uint32_t num_pod = 0, num_buffer = 0, num_image = 0;
+    pe->image_args = smap_.at(func_name).flag;
 
     {
       auto fit = fmap_.find(func_name);
       ICHECK(fit != fmap_.end());
       for (DLDataType arg_type : fit->second.arg_types) {
         if (arg_type.code == kTVMOpaqueHandle) {
+          VkDescriptorType descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+          if (pe->IsImageArg(num_buffer)) {
+            descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            ++num_image;
+          }
           {
             VkDescriptorSetLayoutBinding bd;
             bd.binding = num_buffer;
-            bd.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bd.descriptorType = descriptor_type;
             bd.descriptorCount = 1;
             bd.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
             bd.pImmutableSamplers = nullptr;
@@ -828,9 +1257,9 @@ class VulkanModuleNode final : public runtime::ModuleNode {
             tpl.dstBinding = num_buffer;
             tpl.dstArrayElement = 0;
             tpl.descriptorCount = 1;
-            tpl.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            tpl.offset = num_buffer * sizeof(VkDescriptorBufferInfo);
-            tpl.stride = sizeof(VkDescriptorBufferInfo);
+            tpl.descriptorType = descriptor_type;
+            tpl.offset = num_buffer * sizeof(VulkanDescriptorInfo);
+            tpl.stride = sizeof(VulkanDescriptorInfo);
             arg_template.push_back(tpl);
           }
           ++num_buffer;
@@ -855,16 +1284,24 @@ class VulkanModuleNode final : public runtime::ModuleNode {
     }
 
     {
-      VkDescriptorPoolSize pool_size;
-      pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-      pool_size.descriptorCount = arg_binding.size();
+      std::vector<VkDescriptorPoolSize> pool_sizes(1);
+      pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      pool_sizes[0].descriptorCount = arg_binding.size() - num_image;
+      if (num_image != 0) {
+        VkDescriptorPoolSize image_pool_size;
+        image_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        image_pool_size.descriptorCount = num_image;
+        // Pool sizes cannot be empty, unless the kernel has no buffer arguments at all.
+        if (pool_sizes[0].descriptorCount == 0) pool_sizes.clear();
+        pool_sizes.push_back(image_pool_size);
+      }
       VkDescriptorPoolCreateInfo descrip_pool_cinfo;
       descrip_pool_cinfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
       descrip_pool_cinfo.pNext = nullptr;
       descrip_pool_cinfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
       descrip_pool_cinfo.maxSets = 1;
-      descrip_pool_cinfo.poolSizeCount = 1;
-      descrip_pool_cinfo.pPoolSizes = &pool_size;
+      descrip_pool_cinfo.poolSizeCount = pool_sizes.size();
+      descrip_pool_cinfo.pPoolSizes = pool_sizes.data();
       VULKAN_CALL(vkCreateDescriptorPool(vctx.device, &descrip_pool_cinfo, nullptr,
                                          &(pe->descriptor_pool)));
     }
@@ -987,32 +1424,56 @@ Module VulkanModuleCreate(std::unordered_map<std::string, VulkanShader> smap,
 
 VulkanThreadEntry* VulkanThreadEntry::ThreadLocal() { return VulkanThreadStore::Get(); }
 
+void VulkanThreadEntry::ReleaseStagingBuffer(VulkanStagingBuffer* buf) {
+  if (buf->host_addr != nullptr) {
+    vkUnmapMemory(buf->device, buf->memory);
+  }
+  if (buf->memory != VK_NULL_HANDLE) {
+    vkFreeMemory(buf->device, buf->memory, nullptr);
+  }
+  if (buf->buffer != VK_NULL_HANDLE) {
+    vkDestroyBuffer(buf->device, buf->buffer, nullptr);
+  }
+  buf->host_addr = nullptr;
+  buf->memory = VK_NULL_HANDLE;
+  buf->buffer = VK_NULL_HANDLE;
+  buf->size = 0;
+}
+
 VulkanStagingBuffer* VulkanThreadEntry::StagingBuffer(int device_id, size_t size) {
-  if (!staging_buffers_[device_id]) {
-    staging_buffers_[device_id] = std::unique_ptr<VulkanStagingBuffer>(new VulkanStagingBuffer());
+  auto& ring = staging_buffers_[device_id];
+  VulkanStream* stream = Stream(device_id);
+  // Prefer the smallest finished buffer that fits, then growing a finished buffer once the
+  // ring is full. Without a finished buffer, wait for the oldest upload.
+  VulkanStagingBuffer* best = nullptr;
+  VulkanStagingBuffer* largest = nullptr;
+  VulkanStagingBuffer* oldest = nullptr;
+  for (const auto& buf : ring) {
+    if (oldest == nullptr || buf->submission < oldest->submission) oldest = buf.get();
+    if (!stream->IsComplete(buf->submission)) continue;
+    if (buf->size >= size && (best == nullptr || buf->size < best->size)) best = buf.get();
+    if (largest == nullptr || buf->size > largest->size) largest = buf.get();
   }
-  auto& buf = *(staging_buffers_[device_id]);
-  if (buf.device != nullptr && buf.size < size) {
-    // free previous buffer
-    if (buf.host_addr != nullptr) {
-      vkUnmapMemory(buf.device, buf.memory);
-    }
-    if (buf.memory != VK_NULL_HANDLE) {
-      vkFreeMemory(buf.device, buf.memory, nullptr);
-    }
-    if (buf.buffer != VK_NULL_HANDLE) {
-      vkDestroyBuffer(buf.device, buf.buffer, nullptr);
+  if (best == nullptr && ring.size() < kVulkanStagingRingSize) {
+    ring.emplace_back(new VulkanStagingBuffer());
+    best = ring.back().get();
+  }
+  if (best == nullptr) {
+    if (largest == nullptr) {
+      stream->Wait(oldest->submission);
+      largest = oldest;
     }
-    buf.host_addr = nullptr;
-    buf.memory = VK_NULL_HANDLE;
-    buf.buffer = VK_NULL_HANDLE;
+    best = largest;
+  }
+  if (best->size < size) {
+    // Grow geometrically, so that uploads of increasing sizes do not reallocate every time.
+    ReleaseStagingBuffer(best);
+    size = std::max(size, 2 * best->size);
   }
   const auto& vctx = VulkanDeviceAPI::Global()->context(device_id);
 
-  if (buf.device == nullptr) {
-    buf.device = vctx.device;
-  }
-  if (buf.memory == VK_NULL_HANDLE) {
+  best->device = vctx.device;
+  if (best->memory == VK_NULL_HANDLE) {
     // allocate the stagging buffer memory if necessary
     VkBufferCreateInfo info;
     info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1023,24 +1484,25 @@ VulkanStagingBuffer* VulkanThreadEntry::StagingBuffer(int device_id, size_t size
     info.pQueueFamilyIndices = &(vctx.queue_family_index);
     info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    VULKAN_CALL(vkCreateBuffer(vctx.device, &info, nullptr, &(buf.buffer)));
+    VULKAN_CALL(vkCreateBuffer(vctx.device, &info, nullptr, &(best->buffer)));
     VkMemoryAllocateInfo minfo;
     minfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     minfo.pNext = nullptr;
     minfo.allocationSize = size;
     minfo.memoryTypeIndex = vctx.staging_mtype_index;
-    VULKAN_CALL(vkAllocateMemory(vctx.device, &minfo, nullptr, &(buf.memory)));
-    VULKAN_CALL(vkBindBufferMemory(vctx.device, (buf.buffer), buf.memory, 0));
-    VULKAN_CALL(vkMapMemory(vctx.device, buf.memory, 0, size, 0, &(buf.host_addr)));
-    buf.size = size;
+    VULKAN_CALL(vkAllocateMemory(vctx.device, &minfo, nullptr, &(best->memory)));
+    VULKAN_CALL(vkBindBufferMemory(vctx.device, (best->buffer), best->memory, 0));
+    VULKAN_CALL(vkMapMemory(vctx.device, best->memory, 0, size, 0, &(best->host_addr)));
+    best->size = size;
   }
-  memset(buf.host_addr, 0, size);
-  return &buf;
+  return best;
 }
 
 VulkanThreadEntry::VulkanThreadEntry()
     : pool(std::make_unique<WorkspacePool>(static_cast<DLDeviceType>(kDLVulkan),
-                                           VulkanDeviceAPI::Global())) {
+                                           VulkanDeviceAPI::Global())),
+      texture_pool(std::make_unique<TexturePool>(static_cast<DLDeviceType>(kDLVulkan),
+                                                 VulkanDeviceAPI::Global())) {
   ctx.device_id = 0;
   ctx.device_type = static_cast<DLDeviceType>(kDLVulkan);
 }
@@ -1063,19 +1525,36 @@ void VulkanWrappedFunc::operator()(TVMArgs args, TVMRetValue* rv,
   }
   const auto& pipeline = scache_[device_id];
   ThreadWorkLoad wl = thread_axis_cfg_.Extract(args);
-  std::vector<VkDescriptorBufferInfo> descriptor_buffers;
+  std::vector<VulkanDescriptorInfo> descriptor_buffers;
   descriptor_buffers.resize(num_buffer_args_);
+  // The device allocations of the arguments, identifying the dependencies between kernels
+  std::vector<const void*> buffers(num_buffer_args_);
   for (size_t i = 0; i < num_buffer_args_; ++i) {
     void* buf = args[static_cast<int>(i)];
-    VkDescriptorBufferInfo binfo;
-    binfo.buffer = static_cast<VulkanBuffer*>(buf)->buffer;
-    binfo.offset = 0;
-    binfo.range = VK_WHOLE_SIZE;
-    descriptor_buffers[i] = binfo;
+    const auto* pbuf = static_cast<const VulkanBuffer*>(buf);
+    bool is_image = pbuf->image != VK_NULL_HANDLE;
+    ICHECK_EQ(is_image, pipeline->IsImageArg(i))
+        << "Buffer argument " << i << " of " << func_name_ << " is bound as a "
+        << (pipeline->IsImageArg(i) ? "texture" : "buffer") << ", got a "
+        << (is_image ? "texture" : "buffer");
+    if (is_image) {
+      VkDescriptorImageInfo iinfo;
+      iinfo.sampler = VK_NULL_HANDLE;
+      iinfo.imageView = pbuf->view;
+      iinfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+      descriptor_buffers[i].image = iinfo;
+    } else {
+      VkDescriptorBufferInfo binfo;
+      binfo.buffer = pbuf->buffer;
+      binfo.offset = 0;
+      binfo.range = VK_WHOLE_SIZE;
+      descriptor_buffers[i].buffer = binfo;
+    }
+    buffers[i] = pbuf;
   }
   if (vctx.UseImmediate()) {
     // Can safely capture by reference as this lambda is immediately executed on the calling thread.
-    VulkanThreadEntry::ThreadLocal()->Stream(device_id)->Launch([&](VulkanStreamState* state) {
+    auto dispatch = [&](VulkanStreamState* state) {
       vkCmdBindPipeline(state->cmd_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
       ICHECK(pipeline->descriptor_update_template != VK_NULL_HANDLE);
       vctx.descriptor_template_khr_functions->vkCmdPushDescriptorSetWithTemplateKHR(
@@ -1087,15 +1566,21 @@ void VulkanWrappedFunc::operator()(TVMArgs args, TVMRetValue* rv,
                            pack_args);
       }
       vkCmdDispatch(state->cmd_buffer_, wl.grid_dim(0), wl.grid_dim(1), wl.grid_dim(2));
-      VkMemoryBarrier barrier_info;
-      barrier_info.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-      barrier_info.pNext = nullptr;
-      barrier_info.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-      barrier_info.dstAccessMask = (VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
-                                    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
-      vkCmdPipelineBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                           VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
-                           1, &barrier_info, 0, nullptr, 0, nullptr);
+    };
+    VulkanStream* stream = VulkanThreadEntry::ThreadLocal()->Stream(device_id);
+    if (stream->IsCapturing()) {
+      // The push descriptors and constants are recorded into the command buffer, the capture
+      // only places the barriers between dependent kernels.
+      stream->LaunchCaptured(dispatch, buffers);
+      return;
+    }
+    stream->Launch([&](VulkanStreamState* state) {
+      dispatch(state);
+      RecordMemoryBarrier(state->cmd_buffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+                              VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
     });
     return;
   }
@@ -1112,9 +1597,15 @@ void VulkanWrappedFunc::operator()(TVMArgs args, TVMRetValue* rv,
       write_descriptor_sets[i].dstBinding = i;
       write_descriptor_sets[i].dstArrayElement = 0;
       write_descriptor_sets[i].descriptorCount = 1;
-      write_descriptor_sets[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
       write_descriptor_sets[i].pImageInfo = 0;
-      write_descriptor_sets[i].pBufferInfo = &(descriptor_buffers[i]);
+      write_descriptor_sets[i].pBufferInfo = 0;
+      if (pipeline->IsImageArg(i)) {
+        write_descriptor_sets[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        write_descriptor_sets[i].pImageInfo = &(descriptor_buffers[i].image);
+      } else {
+        write_descriptor_sets[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write_descriptor_sets[i].pBufferInfo = &(descriptor_buffers[i].buffer);
+      }
       write_descriptor_sets[i].pTexelBufferView = 0;
     }
     vkUpdateDescriptorSets(vctx.device, write_descriptor_sets.size(), write_descriptor_sets.data(),
@@ -1143,10 +1634,7 @@ void VulkanWrappedFunc::operator()(TVMArgs args, TVMRetValue* rv,
   };
   VulkanStreamToken deferred_token;
   deferred_token.descriptor_set_ = pipeline->descriptor_set;
-  deferred_token.buffers_.resize(descriptor_buffers.size());
-  for (size_t i = 0; i < descriptor_buffers.size(); ++i) {
-    deferred_token.buffers_[i] = descriptor_buffers[i].buffer;
-  }
+  deferred_token.buffers_ = buffers;
   VulkanThreadEntry::ThreadLocal()->Stream(device_id)->LaunchDeferred(
       deferred_initializer, deferred_kernel, deferred_token);
 }
@@ -1180,6 +1668,29 @@ Module VulkanModuleLoadBinary(void* strm) {
   return VulkanModuleCreate(smap, fmap, "");
 }
 
+// Start recording the Vulkan kernels launched by the calling thread on its current device into
+// a reusable command buffer. The kernels run when the capture ends.
+TVM_REGISTER_GLOBAL("runtime.vulkan.BeginCapture").set_body_typed([]() {
+  VulkanThreadEntry* t = VulkanThreadEntry::ThreadLocal();
+  ICHECK_LT(t->capture_device, 0) << "A capture is already in progress on this thread";
+  t->capture_device = t->ctx.device_id;
+  t->Stream(t->capture_device)->BeginCapture();
+});
+
+// Stop recording, run the captured kernels once, and return a function resubmitting them.
+TVM_REGISTER_GLOBAL("runtime.vulkan.EndCapture").set_body_typed([]() {
+  VulkanThreadEntry* t = VulkanThreadEntry::ThreadLocal();
+  ICHECK_GE(t->capture_device, 0) << "No capture in progress on this thread";
+  int device_id = t->capture_device;
+  t->capture_device = -1;
+  std::shared_ptr<VulkanCommandGraph> graph = t->Stream(device_id)->EndCapture();
+  return PackedFunc([graph, device_id](TVMArgs args, TVMRetValue* rv) {
+    // The work launched before the replay, e.g. the input copies, must run first.
+    VulkanThreadEntry::ThreadLocal()->Stream(device_id)->Flush();
+    graph->Submit();
+  });
+});
+
 TVM_REGISTER_GLOBAL("runtime.module.loadfile_vulkan").set_body_typed(VulkanModuleLoadFile);
 
 TVM_REGISTER_GLOBAL("runtime.module.loadbinary_vulkan").set_body_typed(VulkanModuleLoadBinary);
@@ -1189,6 +1700,32 @@ TVM_REGISTER_GLOBAL("device_api.vulkan").set_body([](TVMArgs args, TVMRetValue*
   *rv = static_cast<void*>(ptr);
 });
 
+TVM_REGISTER_GLOBAL("device_api.vulkan.AllocTexture").set_body([](TVMArgs args, TVMRetValue* rv) {
+  TVMContext ctx;
+  ctx.device_type = static_cast<DLDeviceType>(static_cast<int>(args[0]));
+  ctx.device_id = args[1];
+  uint64_t width = args[2];
+  uint64_t height = args[3];
+  DLDataType type_hint;
+  type_hint.code = static_cast<decltype(type_hint.code)>(static_cast<int>(args[4]));
+  type_hint.bits = static_cast<decltype(type_hint.bits)>(static_cast<int>(args[5]));
+  type_hint.lanes = 1;
+  // Channels per texel, RGBA when not provided by the caller
+  int channel = args.num_args > 6 ? static_cast<int>(args[6]) : 4;
+  *rv = VulkanDeviceAPI::Global()->AllocTextureWorkspace(
+      ctx, static_cast<size_t>(width), static_cast<size_t>(height), static_cast<size_t>(channel),
+      type_hint);
+});
+
+TVM_REGISTER_GLOBAL("device_api.vulkan.FreeTexture").set_body([](TVMArgs args, TVMRetValue* rv) {
+  TVMContext ctx;
+  ctx.device_type = static_cast<DLDeviceType>(static_cast<int>(args[0]));
+  ctx.device_id = args[1];
+  void* data = args[2];
+  VulkanDeviceAPI::Global()->FreeTextureWorkspace(ctx, data);
+  *rv = static_cast<int32_t>(0);
+});
+
 }  // namespace vulkan
 }  // namespace runtime
 }  // namespace tvm
@@ -111,6 +111,8 @@ struct VulkanStagingBuffer {
   VkDeviceMemory memory{VK_NULL_HANDLE};
   void* host_addr{nullptr};
   size_t size{0};
+  // The last stream submission reading or writing the buffer.
+  uint64_t submission{0};
 };
 
 struct VulkanContext {
@@ -122,12 +124,16 @@ struct VulkanContext {
   uint32_t staging_mtype_index{0};
   // whether staging is coherent
   bool coherent_staging{false};
+  // whether storage images can be accessed without a declared format, needed by textures
+  bool storage_image_without_format{false};
 
   std::unique_ptr<VulkanDescriptorTemplateKHRFunctions> descriptor_template_khr_functions{nullptr};
   std::unique_ptr<VulkanGetBufferMemoryRequirements2Functions>
       get_buffer_memory_requirements_2_functions{nullptr};
   // Memory type index for compute
   uint32_t compute_mtype_index{0};
+  // whether the compute memory is host visible and coherent, and the buffers are mapped
+  bool host_mapped_compute{false};
   // The logical device
   VkDevice device{nullptr};
   // command queue
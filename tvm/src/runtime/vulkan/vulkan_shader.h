@@ -32,7 +32,10 @@ namespace runtime {
 namespace vulkan {
 
 struct VulkanShader {
-  /*! \brief header flag */
+  /*!
+   * \brief header flag, bit i is set when the i-th buffer argument is a texture bound
+   *  as a storage image.
+   */
   uint32_t flag{0};
   /*! \brief Data segment */
   std::vector<uint32_t> data;
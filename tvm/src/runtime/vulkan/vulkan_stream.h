@@ -20,9 +20,13 @@
 #ifndef TVM_RUNTIME_VULKAN_VULKAN_STREAM_H_
 #define TVM_RUNTIME_VULKAN_VULKAN_STREAM_H_
 
+#include <algorithm>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "vulkan_common.h"
@@ -37,20 +41,71 @@ class VulkanStreamState {
   VkFence fence_;
 };
 
-// Used to identify state that should only be used once-per-stream.
-struct VulkanStreamToken {
-  VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
-  std::vector<VkBuffer> buffers_;
-};
+// Record a memory barrier between the given stages into a command buffer.
+inline void RecordMemoryBarrier(VkCommandBuffer cmd_buffer, VkPipelineStageFlags src_stage,
+                                VkAccessFlags src_access, VkPipelineStageFlags dst_stage,
+                                VkAccessFlags dst_access) {
+  VkMemoryBarrier barrier_info;
+  barrier_info.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier_info.pNext = nullptr;
+  barrier_info.srcAccessMask = src_access;
+  barrier_info.dstAccessMask = dst_access;
+  vkCmdPipelineBarrier(cmd_buffer, src_stage, dst_stage, 0, 1, &barrier_info, 0, nullptr, 0,
+                       nullptr);
+}
 
-class VulkanStream {
+// Submit the command buffer of `state`, its fence is signaled when the commands finish.
+inline void SubmitCommands(const VulkanContext* vctx, VulkanStreamState* state) {
+  VkSubmitInfo cb_submit;
+  cb_submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  cb_submit.pNext = nullptr;
+  cb_submit.waitSemaphoreCount = 0;
+  cb_submit.pWaitSemaphores = nullptr;
+  cb_submit.pWaitDstStageMask = 0;
+  cb_submit.commandBufferCount = 1;
+  cb_submit.pCommandBuffers = &(state->cmd_buffer_);
+  cb_submit.signalSemaphoreCount = 0;
+  cb_submit.pSignalSemaphores = nullptr;
+
+  {
+    // Multiple streams (on different threads) use the same VulkanContext
+    // instance, so we need to externally synchronize accesses.
+    std::lock_guard<std::mutex> g(*(vctx->queue_mutex));
+    VULKAN_CALL(vkQueueSubmit(vctx->queue, 1, &cb_submit, state->fence_));
+  }
+}
+
+// Wait for the commands submitted with `state` to finish and reset its fence.
+inline void WaitForCommands(const VulkanContext* vctx, VulkanStreamState* state) {
+  uint64_t timeout = 1UL << 30UL;
+  VkResult res;
+  do {
+    res = vkWaitForFences(vctx->device, 1, &(state->fence_), 0, timeout);
+  } while (res == VK_TIMEOUT);
+  VULKAN_CHECK_ERROR(res);
+  VULKAN_CALL(vkResetFences(vctx->device, 1, &(state->fence_)));
+}
+
+// Submit the command buffer of `state` and wait for it to finish.
+inline void SubmitAndWait(const VulkanContext* vctx, VulkanStreamState* state) {
+  SubmitCommands(vctx, state);
+  WaitForCommands(vctx, state);
+}
+
+/*!
+ * \brief The kernels of a capture, recorded once into a command buffer that is submitted again
+ *  on every replay.
+ *
+ *  The command buffer refers to the buffers and the pipelines of the captured kernels, which
+ *  must stay alive and keep their contents' meaning as long as the graph is replayed.
+ */
+class VulkanCommandGraph {
  public:
-  explicit VulkanStream(const VulkanContext* vctx) : vctx_(vctx), state_(new VulkanStreamState()) {
-    // create command pool
+  explicit VulkanCommandGraph(const VulkanContext* vctx) : vctx_(vctx) {
     VkCommandPoolCreateInfo cmd_pool_cinfo;
     cmd_pool_cinfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmd_pool_cinfo.pNext = nullptr;
-    cmd_pool_cinfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    cmd_pool_cinfo.flags = 0;
     cmd_pool_cinfo.queueFamilyIndex = vctx_->queue_family_index;
     VULKAN_CALL(vkCreateCommandPool(vctx_->device, &cmd_pool_cinfo, nullptr, &cmd_pool_));
 
@@ -60,30 +115,120 @@ class VulkanStream {
     buffer_alloc_info.commandPool = cmd_pool_;
     buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     buffer_alloc_info.commandBufferCount = 1;
-    VULKAN_CALL(
-        vkAllocateCommandBuffers(vctx_->device, &buffer_alloc_info, &(state_->cmd_buffer_)));
+    VULKAN_CALL(vkAllocateCommandBuffers(vctx_->device, &buffer_alloc_info, &(state_.cmd_buffer_)));
 
     VkFenceCreateInfo fence_cinfo;
     fence_cinfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fence_cinfo.pNext = nullptr;
-    fence_cinfo.flags = 0;  // VK_FENCE_CREATE_SIGNALED_BIT;
-    VULKAN_CALL(vkCreateFence(vctx_->device, &fence_cinfo, nullptr, &(state_->fence_)));
+    fence_cinfo.flags = 0;
+    VULKAN_CALL(vkCreateFence(vctx_->device, &fence_cinfo, nullptr, &(state_.fence_)));
 
+    // Without VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, so that it can be resubmitted.
     VkCommandBufferBeginInfo cb_begin;
     cb_begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     cb_begin.pNext = nullptr;
-    cb_begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    cb_begin.flags = 0;
     cb_begin.pInheritanceInfo = 0;
-    VULKAN_CALL(vkBeginCommandBuffer(state_->cmd_buffer_, &cb_begin));
+    VULKAN_CALL(vkBeginCommandBuffer(state_.cmd_buffer_, &cb_begin));
+    // Make the copies submitted before a replay visible to the kernels.
+    RecordMemoryBarrier(state_.cmd_buffer_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+  }
+
+  ~VulkanCommandGraph() {
+    vkDestroyFence(vctx_->device, state_.fence_, nullptr);
+    vkDestroyCommandPool(vctx_->device, cmd_pool_, nullptr);
+  }
+
+  // Record a kernel, after a barrier when it uses a buffer used since the last barrier. The
+  // buffers are identified by their device allocations, buffers and images alike.
+  void Record(const std::function<void(VulkanStreamState*)>& kernel,
+              const std::vector<const void*>& buffers) {
+    ICHECK(!finished_) << "The capture is already finished";
+    // Without the access qualifiers of the arguments, any buffer shared with a kernel
+    // after the last barrier is a dependency. Independent kernels, e.g. the branches of
+    // a graph, are left free to overlap.
+    bool dependent = std::any_of(buffers.begin(), buffers.end(),
+                                 [this](const void* buf) { return used_buffers_.count(buf) != 0; });
+    if (dependent) {
+      RecordMemoryBarrier(state_.cmd_buffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+      used_buffers_.clear();
+    }
+    used_buffers_.insert(buffers.begin(), buffers.end());
+    kernel(&state_);
+    ++num_kernels_;
+  }
+
+  // End the recording.
+  void Finish() {
+    ICHECK(!finished_) << "The capture is already finished";
+    // Make the results visible to the copies submitted after a replay.
+    RecordMemoryBarrier(state_.cmd_buffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+                            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    VULKAN_CALL(vkEndCommandBuffer(state_.cmd_buffer_));
+    used_buffers_.clear();
+    finished_ = true;
+  }
+
+  // Submit the recorded kernels and wait for them to finish.
+  void Submit() {
+    ICHECK(finished_) << "The capture is not finished";
+    if (num_kernels_ != 0) SubmitAndWait(vctx_, &state_);
+  }
+
+ private:
+  const VulkanContext* vctx_;
+  VkCommandPool cmd_pool_;
+  VulkanStreamState state_;
+  // The buffers used by the kernels recorded since the last barrier.
+  std::unordered_set<const void*> used_buffers_;
+  size_t num_kernels_{0};
+  bool finished_{false};
+};
+
+// Used to identify state that should only be used once-per-stream.
+struct VulkanStreamToken {
+  VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+  // The device allocations bound to the descriptor set
+  std::vector<const void*> buffers_;
+};
+
+class VulkanStream {
+ public:
+  explicit VulkanStream(const VulkanContext* vctx) : vctx_(vctx) {
+    // create command pool
+    VkCommandPoolCreateInfo cmd_pool_cinfo;
+    cmd_pool_cinfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmd_pool_cinfo.pNext = nullptr;
+    cmd_pool_cinfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    cmd_pool_cinfo.queueFamilyIndex = vctx_->queue_family_index;
+    VULKAN_CALL(vkCreateCommandPool(vctx_->device, &cmd_pool_cinfo, nullptr, &cmd_pool_));
+    state_ = NewState();
   }
 
   ~VulkanStream() {
+    for (auto& s : in_flight_) {
+      WaitForCommands(vctx_, s.second.get());
+      free_states_.push_back(std::move(s.second));
+    }
     vkDestroyFence(vctx_->device, state_->fence_, nullptr);
+    for (const auto& s : free_states_) {
+      vkDestroyFence(vctx_->device, s->fence_, nullptr);
+    }
     vkDestroyCommandPool(vctx_->device, cmd_pool_, nullptr);
   }
 
   // Launch the kernel on the current stream.
   void Launch(const std::function<void(VulkanStreamState*)>& kernel) {
+    ICHECK(capture_ == nullptr) << "Copies cannot be captured for replay";
+    pending_ = true;
     if (vctx_->UseImmediate()) {
       kernel(state_.get());
     } else {
@@ -96,6 +241,8 @@ class VulkanStream {
                       const std::function<void(VulkanStreamState*)>& deferred_kernel,
                       const VulkanStreamToken& deferred_token) {
     ICHECK(!vctx_->UseImmediate());
+    ICHECK(capture_ == nullptr) << "Capturing Vulkan kernels needs VK_KHR_push_descriptor";
+    pending_ = true;
 
     // It is invalid to schedule this instance on the current stream if we already
     // have a matching descriptor set and a non-matching buffer set.
@@ -124,6 +271,48 @@ class VulkanStream {
     deferred_tokens_[deferred_token.descriptor_set_].push_back(deferred_token);
   }
 
+  // Submit the work launched on the stream without waiting for it, and start a new command
+  // buffer. Returns the number of the submission, see IsComplete. Deferred mode rewrites the
+  // descriptor sets of pending kernels on every launch, so it waits for the submission.
+  uint64_t Submit() {
+    if (!vctx_->UseImmediate()) {
+      Synchronize();
+      return num_submitted_;
+    }
+    VULKAN_CALL(vkEndCommandBuffer(state_->cmd_buffer_));
+    SubmitCommands(vctx_, state_.get());
+    in_flight_.emplace_back(++num_submitted_, std::move(state_));
+    if (!free_states_.empty()) {
+      state_ = std::move(free_states_.back());
+      free_states_.pop_back();
+      BeginCommands(state_.get());
+    } else {
+      state_ = NewState();
+    }
+    // Flush waits for the submission.
+    pending_ = true;
+    return num_submitted_;
+  }
+
+  // Whether the given submission finished, without waiting.
+  bool IsComplete(uint64_t submission) {
+    while (!in_flight_.empty() && in_flight_.front().first <= submission) {
+      VkResult res = vkGetFenceStatus(vctx_->device, in_flight_.front().second->fence_);
+      if (res == VK_NOT_READY) return false;
+      VULKAN_CHECK_ERROR(res);
+      Retire();
+    }
+    return true;
+  }
+
+  // Wait for the given submission to finish.
+  void Wait(uint64_t submission) {
+    while (!in_flight_.empty() && in_flight_.front().first <= submission) {
+      WaitForCommands(vctx_, in_flight_.front().second.get());
+      Retire();
+    }
+  }
+
   // Synchronize the current stream `state_` with respect to the host.
   void Synchronize() {
     if (!vctx_->UseImmediate()) {
@@ -138,49 +327,109 @@ class VulkanStream {
     }
 
     VULKAN_CALL(vkEndCommandBuffer(state_->cmd_buffer_));
-    VkSubmitInfo cb_submit;
-    cb_submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    cb_submit.pNext = nullptr;
-    cb_submit.waitSemaphoreCount = 0;
-    cb_submit.pWaitSemaphores = nullptr;
-    cb_submit.pWaitDstStageMask = 0;
-    cb_submit.commandBufferCount = 1;
-    cb_submit.pCommandBuffers = &(state_->cmd_buffer_);
-    cb_submit.signalSemaphoreCount = 0;
-    cb_submit.pSignalSemaphores = nullptr;
-
-    {
-      // Multiple streams (on different threads) use the same VulkanContext
-      // instance, so we need to externally synchronize accesses.
-      std::lock_guard<std::mutex> g(*(vctx_->queue_mutex));
-      VULKAN_CALL(vkQueueSubmit(vctx_->queue, 1, &cb_submit, state_->fence_));
-    }
-    uint64_t timeout = 1UL << 30UL;
-    VkResult res;
-    do {
-      res = vkWaitForFences(vctx_->device, 1, &(state_->fence_), 0, timeout);
-    } while (res == VK_TIMEOUT);
-    VULKAN_CHECK_ERROR(res);
+    SubmitAndWait(vctx_, state_.get());
+    ++num_submitted_;
+    Wait(num_submitted_);
     VULKAN_CALL(vkResetCommandBuffer(state_->cmd_buffer_, 0));
-    VULKAN_CALL(vkResetFences(vctx_->device, 1, &(state_->fence_)));
+    pending_ = false;
 
     // Re-initialize the command buffer
+    BeginCommands(state_.get());
+  }
+
+  // Synchronize the stream when work was launched or submitted since the last
+  // synchronization.
+  void Flush() {
+    if (pending_) Synchronize();
+  }
+
+  // Start recording the kernels launched on this stream into a command graph. The kernels are
+  // not run before EndCapture.
+  void BeginCapture() {
+    ICHECK(capture_ == nullptr) << "A capture is already in progress on this stream";
+    ICHECK(vctx_->UseImmediate()) << "Capturing Vulkan kernels needs VK_KHR_push_descriptor";
+    Flush();
+    capture_ = std::make_shared<VulkanCommandGraph>(vctx_);
+  }
+
+  // Whether the kernels launched on this stream are captured.
+  bool IsCapturing() const { return capture_ != nullptr; }
+
+  // Record a kernel using `buffers` into the capture.
+  void LaunchCaptured(const std::function<void(VulkanStreamState*)>& kernel,
+                      const std::vector<const void*>& buffers) {
+    ICHECK(capture_ != nullptr) << "No capture in progress on this stream";
+    capture_->Record(kernel, buffers);
+  }
+
+  // Stop recording, run the captured kernels once and return them for replay.
+  std::shared_ptr<VulkanCommandGraph> EndCapture() {
+    ICHECK(capture_ != nullptr) << "No capture in progress on this stream";
+    std::shared_ptr<VulkanCommandGraph> graph = std::move(capture_);
+    capture_ = nullptr;
+    graph->Finish();
+    graph->Submit();
+    return graph;
+  }
+
+ private:
+  // Create the command buffer and fence of a submission, and begin recording.
+  std::unique_ptr<VulkanStreamState> NewState() {
+    std::unique_ptr<VulkanStreamState> state(new VulkanStreamState());
+    VkCommandBufferAllocateInfo buffer_alloc_info;
+    buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    buffer_alloc_info.pNext = nullptr;
+    buffer_alloc_info.commandPool = cmd_pool_;
+    buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    buffer_alloc_info.commandBufferCount = 1;
+    VULKAN_CALL(
+        vkAllocateCommandBuffers(vctx_->device, &buffer_alloc_info, &(state->cmd_buffer_)));
+
+    VkFenceCreateInfo fence_cinfo;
+    fence_cinfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_cinfo.pNext = nullptr;
+    fence_cinfo.flags = 0;  // VK_FENCE_CREATE_SIGNALED_BIT;
+    VULKAN_CALL(vkCreateFence(vctx_->device, &fence_cinfo, nullptr, &(state->fence_)));
+    BeginCommands(state.get());
+    return state;
+  }
+
+  void BeginCommands(VulkanStreamState* state) {
     VkCommandBufferBeginInfo cb_begin;
     cb_begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     cb_begin.pNext = nullptr;
     cb_begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     cb_begin.pInheritanceInfo = 0;
-    VULKAN_CALL(vkBeginCommandBuffer(state_->cmd_buffer_, &cb_begin));
+    VULKAN_CALL(vkBeginCommandBuffer(state->cmd_buffer_, &cb_begin));
+  }
+
+  // Recycle the oldest submission once it finished.
+  void Retire() {
+    auto& state = in_flight_.front().second;
+    VULKAN_CALL(vkResetFences(vctx_->device, 1, &(state->fence_)));
+    VULKAN_CALL(vkResetCommandBuffer(state->cmd_buffer_, 0));
+    free_states_.push_back(std::move(state));
+    in_flight_.pop_front();
   }
 
- private:
   const VulkanContext* vctx_;
+  // The command buffer being recorded.
   std::unique_ptr<VulkanStreamState> state_;
+  // The submissions not known to be finished, by submission number, oldest first.
+  std::deque<std::pair<uint64_t, std::unique_ptr<VulkanStreamState>>> in_flight_;
+  // The finished command buffers and fences, reused by the next submissions.
+  std::vector<std::unique_ptr<VulkanStreamState>> free_states_;
+  // The number of submissions so far.
+  uint64_t num_submitted_{0};
   // An index of deferred tokens, allowing us to efficiently detect duplicated
   // deferred_initializer blocks.
   std::unordered_map<VkDescriptorSet, std::vector<VulkanStreamToken>> deferred_tokens_;
   std::vector<std::function<void(VulkanStreamState*)>> deferred_kernels_;
   VkCommandPool cmd_pool_;
+  // Whether work was launched since the last synchronization.
+  bool pending_{false};
+  // The capture in progress, nullptr when not capturing.
+  std::shared_ptr<VulkanCommandGraph> capture_;
 };
 
 }  // namespace vulkan
@@ -25,6 +25,8 @@
 
 #include <memory>
 
+#include "memory_stats.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -48,21 +50,17 @@ class WorkspacePool::Pool {
     nbytes = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize * kWorkspacePageSize;
     if (nbytes == 0) nbytes = kWorkspacePageSize;
     Entry e;
-    DLDataType type;
-    type.code = kDLUInt;
-    type.bits = 8;
-    type.lanes = 1;
     if (free_list_.size() == 2) {
       e = free_list_.back();
       free_list_.pop_back();
       if (e.size < nbytes) {
         // resize the page
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
+        FreePage(ctx, device, e.data);
+        e.data = AllocPage(ctx, device, nbytes);
         e.size = nbytes;
       }
     } else if (free_list_.size() == 1) {
-      e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
+      e.data = AllocPage(ctx, device, nbytes);
       e.size = nbytes;
     } else {
       if (free_list_.back().size >= nbytes) {
@@ -76,8 +74,8 @@ class WorkspacePool::Pool {
         // resize the page
         e = free_list_.back();
         free_list_.pop_back();
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
+        FreePage(ctx, device, e.data);
+        e.data = AllocPage(ctx, device, nbytes);
         e.size = nbytes;
       }
     }
@@ -117,12 +115,27 @@ class WorkspacePool::Pool {
   void Release(TVMContext ctx, DeviceAPI* device) {
     ICHECK_EQ(allocated_.size(), 1);
     for (size_t i = 1; i < free_list_.size(); ++i) {
-      device->FreeDataSpace(ctx, free_list_[i].data);
+      FreePage(ctx, device, free_list_[i].data);
     }
     free_list_.clear();
   }
 
  private:
+  // allocate a page from the device, accounted as workspace memory
+  static void* AllocPage(TVMContext ctx, DeviceAPI* device, size_t nbytes) {
+    DLDataType type;
+    type.code = kDLUInt;
+    type.bits = 8;
+    type.lanes = 1;
+    void* data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
+    MemoryStats::Global()->Alloc(ctx, MemoryKind::kWorkspace, data, nbytes);
+    return data;
+  }
+  // release a page to the device
+  static void FreePage(TVMContext ctx, DeviceAPI* device, void* data) {
+    MemoryStats::Global()->Free(ctx, MemoryKind::kWorkspace, data);
+    device->FreeDataSpace(ctx, data);
+  }
   /*! \brief a single entry in the pool */
   struct Entry {
     void* data;
@@ -24,6 +24,8 @@
 #include <tvm/support/logging.h>
 #include <tvm/support/parallel_for.h>
 
+#include <algorithm>
+#include <atomic>
 #include <future>
 #include <thread>
 #include <utility>
@@ -47,10 +49,11 @@ std::vector<std::vector<int>> rr_partitioner(int begin, int end, int step, int n
   return ret;
 }
 
+static bool GLOBAL_PARALLEL_FOR_FLAG{false};
+static std::mutex M_GLOBAL_PARALLEL_FOR_FLAG;
+
 void parallel_for(int begin, int end, const std::function<void(int)>& f, int step,
                   const PartitionerFuncType partitioner) {
-  static bool GLOBAL_PARALLEL_FOR_FLAG{false};
-  static std::mutex M_GLOBAL_PARALLEL_FOR_FLAG;
   {
     std::unique_lock<std::mutex> l(M_GLOBAL_PARALLEL_FOR_FLAG);
     ICHECK(!GLOBAL_PARALLEL_FOR_FLAG) << "There's another parallel_for running. Maybe you're "
@@ -93,5 +96,51 @@ void parallel_for(int begin, int end, const std::function<void(int)>& f, int ste
   }
 }
 
+void parallel_for_dynamic(int begin, int end, int num_threads,
+                          const std::function<void(int thread_id, int task_id)>& f) {
+  ICHECK_LE(begin, end) << "Infinite loop condition with begin: " << begin << " end: " << end;
+  ICHECK_GE(num_threads, 1) << "parallel_for_dynamic needs at least one thread";
+  if (begin == end) return;
+  {
+    std::unique_lock<std::mutex> l(M_GLOBAL_PARALLEL_FOR_FLAG);
+    ICHECK(!GLOBAL_PARALLEL_FOR_FLAG) << "There's another parallel_for running. Maybe you're "
+                                      << "currently inside another parallel_for loop.";
+    GLOBAL_PARALLEL_FOR_FLAG = true;
+  }
+
+  std::atomic<int> next_task{begin};
+  auto worker = [end, &next_task, &f](int thread_id) {
+    for (int task_id = next_task++; task_id < end; task_id = next_task++) {
+      f(thread_id, task_id);
+    }
+  };
+  num_threads = std::min(num_threads, end - begin);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  std::vector<std::future<void>> res_vec;
+  res_vec.reserve(num_threads);
+  for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
+    std::packaged_task<void(int)> task(worker);
+    res_vec.emplace_back(task.get_future());
+    threads.emplace_back(std::move(task), thread_id);
+  }
+
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+  {
+    std::unique_lock<std::mutex> l(M_GLOBAL_PARALLEL_FOR_FLAG);
+    ICHECK(GLOBAL_PARALLEL_FOR_FLAG);
+    GLOBAL_PARALLEL_FOR_FLAG = false;
+  }
+  try {
+    for (auto&& i : res_vec) {
+      i.get();
+    }
+  } catch (const std::exception& e) {
+    LOG(FATAL) << "Parallel_for error with " << e.what();
+  }
+}
+
 }  // namespace support
 }  // namespace tvm
@@ -102,6 +102,30 @@ class RingBuffer {
     head_ptr_ = (head_ptr_ + size) % ring_.size();
     bytes_available_ -= size;
   }
+  /*!
+   * \brief Get the next bytes of the buffer in place without consuming them, so that large
+   *  payloads can be used without copying them out first. The bytes are moved to the head of
+   *  the ring when they wrap around. The pointer is valid until the buffer is changed.
+   * \param size The number of bytes, must be no larger than this->bytes_available().
+   * \return The pointer to the bytes.
+   */
+  char* Peek(size_t size) {
+    ICHECK_GE(bytes_available_, size);
+    if (head_ptr_ + size > ring_.size()) {
+      std::rotate(ring_.begin(), ring_.begin() + head_ptr_, ring_.end());
+      head_ptr_ = 0;
+    }
+    return &ring_[0] + head_ptr_;
+  }
+  /*!
+   * \brief Consume bytes from the buffer without reading them, e.g. after a Peek.
+   * \param size The number of bytes, must be no larger than this->bytes_available().
+   */
+  void Skip(size_t size) {
+    ICHECK_GE(bytes_available_, size);
+    head_ptr_ = (head_ptr_ + size) % ring_.size();
+    bytes_available_ -= size;
+  }
   /*!
    * \brief Read data from buffer with and put them to non-blocking send function.
    *
@@ -198,6 +198,24 @@ TVM_REGISTER_GLOBAL("tvm.intrin.rule.default.q_multiply_shift")
       }
     });
 
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.default.dp4a")
+    .set_body([](const TVMArgs& args, TVMRetValue* rv) {
+      PrimExpr e = args[0];
+      const tir::CallNode* call = e.as<tir::CallNode>();
+      ICHECK(call != nullptr);
+      ICHECK_EQ(call->args.size(), 3);
+      PrimExpr a = call->args[0];
+      PrimExpr b = call->args[1];
+      ICHECK(a.dtype() == DataType::Int(8, 4) && b.dtype() == DataType::Int(8, 4))
+          << "dp4a expects int8x4 operands, got " << a.dtype() << " and " << b.dtype();
+      PrimExpr ret = call->args[2];
+      for (int i = 0; i < 4; ++i) {
+        ret = ret + cast(call->dtype, tir::Shuffle::ExtractElement(a, i)) *
+                        cast(call->dtype, tir::Shuffle::ExtractElement(b, i));
+      }
+      *rv = ret;
+    });
+
 }  // namespace intrin
 }  // namespace codegen
 }  // namespace tvm
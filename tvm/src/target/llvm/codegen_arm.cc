@@ -26,6 +26,7 @@
 #include <tvm/runtime/registry.h>
 
 #include "codegen_cpu.h"
+#include "llvm_common.h"
 
 namespace tvm {
 namespace codegen {
@@ -37,25 +38,112 @@ class CodeGenARM final : public CodeGenCPU {
   void InitTarget(llvm::TargetMachine* tm) final {
     // set native vector bits.
     native_vector_bits_ = 16 * 8;
+    is_aarch64_ = tm->getTargetTriple().getArch() == llvm::Triple::aarch64;
+    has_dotprod_ = TargetHasFeature(*tm, "dotprod");
+    has_i8mm_ = TargetHasFeature(*tm, "i8mm");
     CodeGenCPU::InitTarget(tm);
   }
   llvm::Value* CreateIntrinsic(const CallNode* op) override;
 
  private:
   PrimExpr ARMPopcount(const CallNode* op);
+  /*!
+   * \brief Emulate sdot/udot, acc[i] += sum_j a[4i+j] * b[4i+j], for targets without dotprod.
+   * \param op The call to the intrinsic.
+   * \param is_signed Whether the int8 operands are signed.
+   */
+  PrimExpr EmulateDotProduct(const CallNode* op, bool is_signed);
+  /*!
+   * \brief Emulate smmla/ummla, the 2x2 int32 acc += the 2x8 a times the transpose of the 2x8
+   *  b, for targets without i8mm.
+   * \param op The call to the intrinsic.
+   * \param is_signed Whether the int8 operands are signed.
+   */
+  PrimExpr EmulateMatrixMultiply(const CallNode* op, bool is_signed);
+
+  // whether the target is 64-bit, where the popcount lowering of 32-bit ARM does not apply
+  bool is_aarch64_{false};
+  // whether the target has the int8 dot product instructions
+  bool has_dotprod_{false};
+  // whether the target has the int8 matrix multiply instructions
+  bool has_i8mm_{false};
 };
 
+namespace {
+// Reinterpret the int8 operand of a dot product with the signedness of the instruction.
+PrimExpr AsInt8(const PrimExpr& e, bool is_signed) {
+  int lanes = e.dtype().lanes();
+  DataType t = is_signed ? DataType::Int(8, lanes) : DataType::UInt(8, lanes);
+  return e.dtype() == t ? e : reinterpret(t, e);
+}
+
+// Shuffle the lanes out of an int8 vector, and widen them to the accumulator type.
+PrimExpr WidenLanes(const PrimExpr& e, const std::vector<int>& lanes, DataType acc_type) {
+  Array<PrimExpr> indices;
+  for (int lane : lanes) {
+    indices.push_back(IntImm(DataType::Int(32), lane));
+  }
+  return tir::Cast(acc_type, tir::Shuffle({e}, indices));
+}
+}  // namespace
+
 llvm::Value* CodeGenARM::CreateIntrinsic(const CallNode* op) {
   if (op->op.same_as(builtin_call_llvm_intrin_) || op->op.same_as(builtin_call_llvm_pure_intrin_)) {
     llvm::Intrinsic::ID id = static_cast<llvm::Intrinsic::ID>(Downcast<IntImm>(op->args[0])->value);
-    if (id == ::llvm::Intrinsic::ctpop) {
+    if (id == ::llvm::Intrinsic::ctpop && !is_aarch64_) {
       PrimExpr e = ARMPopcount(op);
       return CodeGenCPU::CreateIntrinsic(e.as<CallNode>());
     }
+#if TVM_LLVM_VERSION >= 80
+    if (!has_dotprod_ && (id == ::llvm::Intrinsic::aarch64_neon_sdot ||
+                          id == ::llvm::Intrinsic::aarch64_neon_udot)) {
+      return MakeValue(EmulateDotProduct(op, id == ::llvm::Intrinsic::aarch64_neon_sdot));
+    }
+#endif
+#if TVM_LLVM_VERSION >= 110
+    if (!has_i8mm_ && (id == ::llvm::Intrinsic::aarch64_neon_smmla ||
+                       id == ::llvm::Intrinsic::aarch64_neon_ummla)) {
+      return MakeValue(EmulateMatrixMultiply(op, id == ::llvm::Intrinsic::aarch64_neon_smmla));
+    }
+#endif
   }
   return CodeGenCPU::CreateIntrinsic(op);
 }
 
+PrimExpr CodeGenARM::EmulateDotProduct(const CallNode* op, bool is_signed) {
+  ICHECK_EQ(op->args.size(), 5U) << "Expect the accumulator and two int8 vectors";
+  int lanes = op->dtype.lanes();
+  PrimExpr a = AsInt8(op->args[3], is_signed);
+  PrimExpr b = AsInt8(op->args[4], is_signed);
+  ICHECK_EQ(a.dtype().lanes(), lanes * 4);
+  ICHECK_EQ(b.dtype().lanes(), lanes * 4);
+  PrimExpr result = op->args[2];
+  for (int j = 0; j < 4; ++j) {
+    std::vector<int> group;
+    for (int i = 0; i < lanes; ++i) {
+      group.push_back(i * 4 + j);
+    }
+    result = result + WidenLanes(a, group, op->dtype) * WidenLanes(b, group, op->dtype);
+  }
+  return result;
+}
+
+PrimExpr CodeGenARM::EmulateMatrixMultiply(const CallNode* op, bool is_signed) {
+  ICHECK_EQ(op->args.size(), 5U) << "Expect the accumulator and two int8 vectors";
+  ICHECK_EQ(op->dtype.lanes(), 4);
+  PrimExpr a = AsInt8(op->args[3], is_signed);
+  PrimExpr b = AsInt8(op->args[4], is_signed);
+  ICHECK_EQ(a.dtype().lanes(), 16);
+  ICHECK_EQ(b.dtype().lanes(), 16);
+  PrimExpr result = op->args[2];
+  for (int k = 0; k < 8; ++k) {
+    // lane 2 * i + j of the result reads row i of a and row j of b
+    result = result + WidenLanes(a, {k, k, 8 + k, 8 + k}, op->dtype) *
+                          WidenLanes(b, {k, 8 + k, k, 8 + k}, op->dtype);
+  }
+  return result;
+}
+
 PrimExpr CodeGenARM::ARMPopcount(const CallNode* call) {
   using namespace tir;
   const PrimExpr& e = call->args[2];
@@ -130,6 +218,12 @@ TVM_REGISTER_GLOBAL("tvm.codegen.llvm.target_arm")
       *rv = static_cast<void*>(cg);
     });
 
+TVM_REGISTER_GLOBAL("tvm.codegen.llvm.target_aarch64")
+    .set_body([](const TVMArgs& targs, TVMRetValue* rv) {
+      CodeGenLLVM* cg = new CodeGenARM();
+      *rv = static_cast<void*>(cg);
+    });
+
 }  // namespace codegen
 }  // namespace tvm
 #endif  // TVM_LLVM_VERSION
@@ -29,7 +29,9 @@
 
 #include <algorithm>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "../func_registry_generator.h"
 
@@ -246,6 +248,33 @@ std::unique_ptr<llvm::Module> CodeGenCPU::Finish() {
   }
   return CodeGenLLVM::Finish();
 }
+
+void CodeGenCPU::Optimize() {
+  int num_threads = GetLLVMCodegenThreads();
+  size_t num_funcs = 0;
+  for (const llvm::Function& func : *module_) {
+    num_funcs += !func.isDeclaration();
+  }
+  if (num_threads <= 1 || num_funcs < 2) {
+    CodeGenLLVM::Optimize();
+    return;
+  }
+  // Optimize the partitions of the module on their own threads and link them back. Functions
+  // are only inlined within a partition, the kernels rarely call each other.
+  std::vector<std::string> parts = SplitModuleToBitcode(*module_, num_threads);
+  ForEachPartInParallel(parts, *target_machine_,
+                        [this, &parts](size_t i, llvm::Module* module, llvm::TargetMachine* tm) {
+                          this->RunOptimization(module, tm);
+                          parts[i] = WriteBitcode(*module);
+                        });
+  std::unique_ptr<llvm::Module> linked = ParseBitcode(parts[0], ctx_);
+  for (size_t i = 1; i < parts.size(); ++i) {
+    ICHECK(!llvm::Linker::linkModules(*linked, ParseBitcode(parts[i], ctx_)))
+        << "Failed to link the optimized partitions of the module";
+  }
+  linked->setModuleIdentifier(module_->getModuleIdentifier());
+  module_ = std::move(linked);
+}
 llvm::Value* CodeGenCPU::CreateStructRefPtr(DataType t, llvm::Value* buf, llvm::Value* index,
                                             int kind) {
   if (kind < builtin::kArrKindBound_) {
@@ -58,6 +58,11 @@ class CodeGenCPU : public CodeGenLLVM {
 
  protected:
   void AddStartupFunction() final;
+  /*!
+   * \brief Optimize the module, split in partitions that are optimized on separate threads
+   *  when TVM_LLVM_CODEGEN_THREADS asks for more than one thread.
+   */
+  void Optimize() override;
   // meta data
   llvm::MDNode* md_tbaa_ctx_ptr_{nullptr};
   // TVM related data types
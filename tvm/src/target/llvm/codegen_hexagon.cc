@@ -61,6 +61,7 @@ class CodeGenHexagon final : public CodeGenLLVM {
             bool system_lib, bool dynamic_lookup, bool target_c_runtime) final;
 
   void VisitStmt_(const AssertStmtNode* op) override;
+  void VisitStmt_(const AllocateNode* op) override;
 
   llvm::Value* CreateIntrinsic(const CallNode* op) override;
   llvm::Value* CreateCallExtern(Type ret_type, String global_symbol, const Array<PrimExpr>& args,
@@ -500,6 +501,26 @@ void CodeGenHexagon::VisitStmt_(const AssertStmtNode* op) {
   CodeGenLLVM::VisitStmt_(op);
 }
 
+void CodeGenHexagon::VisitStmt_(const AllocateNode* op) {
+  auto it = alloc_storage_info_.find(op->buffer_var.get());
+  if (it == alloc_storage_info_.end() || it->second.scope.rank != runtime::StorageRank::kVtcm) {
+    CodeGenLLVM::VisitStmt_(op);
+    return;
+  }
+  // VTCM comes from the arena of the device runtime, which falls back to DDR when it is full.
+  int32_t constant_size = op->constant_allocation_size();
+  ICHECK_GT(constant_size, 0) << "Can only handle constant size VTCM allocation";
+  int64_t nbytes = static_cast<int64_t>(constant_size) * op->dtype.bytes() * op->dtype.lanes();
+  llvm::Value* buf = CodeGenLLVM::CreateCallExtern(t_void_p_, "TVMBackendAllocVTCM",
+                                                   {ConstInt32(nbytes)});
+  buf = builder_->CreatePointerCast(buf, DTypeToLLVMType(op->dtype)->getPointerTo());
+  ICHECK(!var_map_.count(op->buffer_var.get()));
+  var_map_[op->buffer_var.get()] = buf;
+  this->VisitStmt(op->body);
+  CodeGenLLVM::CreateCallExtern(t_int32_, "TVMBackendFreeVTCM",
+                                {builder_->CreatePointerCast(buf, t_void_p_)});
+}
+
 llvm::Value* CodeGenHexagon::CreateIntrinsic(const CallNode* op) {
   if (op->op.same_as(builtin::tvm_call_packed_lowered())) {
     return CreateCallPacked(op);
@@ -350,14 +350,16 @@ class MPassManager : public llvm::legacy::PassManager {
 
 void CodeGenLLVM::InitPassManagerBuilder(llvm::PassManagerBuilder* builder) {}
 
-void CodeGenLLVM::Optimize() {
+void CodeGenLLVM::Optimize() { RunOptimization(module_.get(), target_machine_); }
+
+void CodeGenLLVM::RunOptimization(llvm::Module* module, llvm::TargetMachine* tm) {
   // pass manager
-  FPassManager fpass(module_.get());
+  FPassManager fpass(module);
   MPassManager mpass;
-  mpass.add(llvm::createTargetTransformInfoWrapperPass(
-      target_machine_ ? target_machine_->getTargetIRAnalysis() : llvm::TargetIRAnalysis()));
-  fpass.add(llvm::createTargetTransformInfoWrapperPass(
-      target_machine_ ? target_machine_->getTargetIRAnalysis() : llvm::TargetIRAnalysis()));
+  mpass.add(llvm::createTargetTransformInfoWrapperPass(tm ? tm->getTargetIRAnalysis()
+                                                          : llvm::TargetIRAnalysis()));
+  fpass.add(llvm::createTargetTransformInfoWrapperPass(tm ? tm->getTargetIRAnalysis()
+                                                          : llvm::TargetIRAnalysis()));
 
   // place optimization pass
   llvm::PassManagerBuilder builder;
@@ -373,18 +375,18 @@ void CodeGenLLVM::Optimize() {
   this->InitPassManagerBuilder(&builder);
 
 #if TVM_LLVM_VERSION >= 50
-  target_machine_->adjustPassManager(builder);
+  tm->adjustPassManager(builder);
 #endif
 
   builder.populateFunctionPassManager(fpass);
   builder.populateModulePassManager(mpass);
 
   fpass.doInitialization();
-  for (auto it = module_->begin(); it != module_->end(); ++it) {
+  for (auto it = module->begin(); it != module->end(); ++it) {
     fpass.run(*it);
   }
   fpass.doFinalization();
-  mpass.run(*module_);
+  mpass.run(*module);
 }
 
 int CodeGenLLVM::NativeVectorBits(const runtime::StorageScope& storage_scope) const {
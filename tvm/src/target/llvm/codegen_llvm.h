@@ -210,6 +210,8 @@ class CodeGenLLVM : public ExprFunctor<llvm::Value*(const PrimExpr&)>,
   virtual void AddStartupFunction() {}
   // apply optimization on the module.
   virtual void Optimize();
+  // run the optimization passes on a module, Optimize runs them on module_.
+  void RunOptimization(llvm::Module* module, llvm::TargetMachine* tm);
   // Get the maximim storage align bits of buffer pointer given storage scope.
   virtual int NativeVectorBits(const runtime::StorageScope& storage_scope) const;
   // Get correct address space depending on the backend
@@ -26,43 +26,11 @@
 #include <tvm/runtime/registry.h>
 
 #include "codegen_cpu.h"
-#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm_common.h"
 
 namespace tvm {
 namespace codegen {
 
-namespace {
-bool TargetHasFeature(const llvm::TargetMachine& tm, const std::string& feature) {
-  // MCSubTargetInfo::checkFeatures was added in LLVM 6.0
-#if TVM_LLVM_VERSION >= 60
-  const auto* MCInfo = tm.getMCSubtargetInfo();
-  return MCInfo->checkFeatures(std::string("+") + feature);
-#else
-  return false;
-  // TODO(tulloch) - enable this block, need to figure out how to reimplement
-  // this given visibility constraints, similar to
-  // https://github.com/rust-lang/rust/pull/31709
-
-  // Copied from
-  // https://github.com/llvm-mirror/llvm/blob/5136df4/lib/MC/MCSubtargetInfo.cpp#L78-L88.
-
-  // auto checkFeatures = [&](const std::string FS) {
-  //   llvm::SubtargetFeatures T(FS);
-  //   llvm::FeatureBitset Set, All;
-  //   for (std::string F : T.getFeatures()) {
-  //     llvm::SubtargetFeatures::ApplyFeatureFlag(Set, F, MCInfo->ProcFeatures);
-  //     if (F[0] == '-') {
-  //       F[0] = '+';
-  //     }
-  //     llvm::SubtargetFeatures::ApplyFeatureFlag(All, F, MCInfo->ProcFeatures);
-  //   }
-  //   return (MCInfo->getFeatureBits() & All) == Set;
-  // };
-  // return checkFeatures(MCInfo, std::string("+") + feature);
-#endif
-}
-}  // namespace
-
 class CodeGenX86_64 final : public CodeGenCPU {
  public:
   llvm::Value* VisitExpr_(const CastNode* op) override;
@@ -109,6 +77,29 @@ llvm::Value* CodeGenX86_64::VisitExpr_(const CastNode* op) {
     }
 #endif
   }
+  // float -> half, with vcvtps2ph rounding to nearest even, instead of one call to
+  // __gnu_f2h_ieee per lane when the target has no native lowering.
+  if (from.is_float() && to.is_float() && from.bits() == 32 && to.bits() == 16) {
+    ICHECK_EQ(from.lanes(), to.lanes());
+    CHECK_NOTNULL(target_machine_);
+    llvm::Type* result_ty = DTypeToLLVMType(DataType::Int(16, from.lanes()));
+    llvm::Value* value = MakeValue(op->value);
+    llvm::Value* rounding = MakeValue(IntImm(DataType::Int(32), 0));
+
+    if (from.lanes() >= 16 && TargetHasFeature(*target_machine_, "avx512f")) {
+      llvm::Value* bits = CallVectorIntrin(
+          ::llvm::Intrinsic::x86_avx512_mask_vcvtps2ph_512, 16, result_ty,
+          {value, rounding,
+           MakeValue(tir::Broadcast(IntImm(DataType::Int(16), 0), from.lanes())),
+           /*mask=*/MakeValue(IntImm(DataType::Int(16), -1))});
+      return builder_->CreateBitCast(bits, DTypeToLLVMType(to));
+    }
+    if (from.lanes() >= 8 && TargetHasFeature(*target_machine_, "f16c")) {
+      llvm::Value* bits =
+          CallVectorIntrin(::llvm::Intrinsic::x86_vcvtps2ph_256, 8, result_ty, {value, rounding});
+      return builder_->CreateBitCast(bits, DTypeToLLVMType(to));
+    }
+  }
 
   return CodeGenCPU::VisitExpr_(op);
 }
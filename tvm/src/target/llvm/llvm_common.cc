@@ -24,12 +24,14 @@
 
 #include "llvm_common.h"
 
+#include <llvm/MC/MCSubtargetInfo.h>
 #include <tvm/support/logging.h>
 #include <tvm/target/target.h>
 
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 namespace tvm {
 namespace codegen {
@@ -167,6 +169,131 @@ std::string LLVMTargetToString(const Target& target) {
   return os.str();
 }
 
+bool TargetHasFeature(const llvm::TargetMachine& tm, const std::string& feature) {
+  // MCSubTargetInfo::checkFeatures was added in LLVM 6.0
+#if TVM_LLVM_VERSION >= 60
+  const auto* MCInfo = tm.getMCSubtargetInfo();
+  return MCInfo->checkFeatures(std::string("+") + feature);
+#else
+  return false;
+  // TODO(tulloch) - enable this block, need to figure out how to reimplement
+  // this given visibility constraints, similar to
+  // https://github.com/rust-lang/rust/pull/31709
+
+  // Copied from
+  // https://github.com/llvm-mirror/llvm/blob/5136df4/lib/MC/MCSubtargetInfo.cpp#L78-L88.
+
+  // auto checkFeatures = [&](const std::string FS) {
+  //   llvm::SubtargetFeatures T(FS);
+  //   llvm::FeatureBitset Set, All;
+  //   for (std::string F : T.getFeatures()) {
+  //     llvm::SubtargetFeatures::ApplyFeatureFlag(Set, F, MCInfo->ProcFeatures);
+  //     if (F[0] == '-') {
+  //       F[0] = '+';
+  //     }
+  //     llvm::SubtargetFeatures::ApplyFeatureFlag(All, F, MCInfo->ProcFeatures);
+  //   }
+  //   return (MCInfo->getFeatureBits() & All) == Set;
+  // };
+  // return checkFeatures(MCInfo, std::string("+") + feature);
+#endif
+}
+
+int GetLLVMCodegenThreads() {
+  const char* val = getenv("TVM_LLVM_CODEGEN_THREADS");
+  if (val == nullptr) return 1;
+  int num_threads = atoi(val);
+  if (num_threads <= 0) {
+    num_threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  }
+  return num_threads;
+}
+
+std::vector<std::string> SplitModuleToBitcode(const llvm::Module& module, int num_parts) {
+#if TVM_LLVM_VERSION <= 60
+  std::unique_ptr<llvm::Module> clone = llvm::CloneModule(&module);
+#else
+  std::unique_ptr<llvm::Module> clone = llvm::CloneModule(module);
+#endif
+  std::vector<std::string> parts;
+  auto add_part = [&parts](std::unique_ptr<llvm::Module> part) {
+    parts.push_back(WriteBitcode(*part));
+  };
+#if TVM_LLVM_VERSION >= 130
+  llvm::SplitModule(*clone, num_parts, add_part, /*PreserveLocals=*/true);
+#else
+  llvm::SplitModule(std::move(clone), num_parts, add_part, /*PreserveLocals=*/true);
+#endif
+  return parts;
+}
+
+void ForEachPartInParallel(
+    const std::vector<std::string>& parts, const llvm::TargetMachine& tm,
+    const std::function<void(size_t, llvm::Module*, llvm::TargetMachine*)>& f) {
+  std::vector<std::string> errors(parts.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      try {
+        llvm::LLVMContext ctx;
+        std::unique_ptr<llvm::Module> module = ParseBitcode(parts[i], &ctx);
+        // a target machine is not meant to be shared between threads
+        std::unique_ptr<llvm::TargetMachine> part_tm(tm.getTarget().createTargetMachine(
+            tm.getTargetTriple().str(), tm.getTargetCPU(), tm.getTargetFeatureString(), tm.Options,
+            tm.getRelocationModel(), tm.getCodeModel(), tm.getOptLevel()));
+        f(i, module.get(), part_tm.get());
+      } catch (const std::exception& e) {
+        errors[i] = e.what();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < errors.size(); ++i) {
+    ICHECK(errors[i].empty()) << "Failed on partition " << i << " of the module: " << errors[i];
+  }
+}
+
+std::unique_ptr<llvm::Module> ParseBitcode(const std::string& bitcode, llvm::LLVMContext* ctx) {
+  llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode.data(), bitcode.size()), "bitcode");
+  llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(buffer, *ctx);
+  if (!module) {
+    LOG(FATAL) << "Cannot parse the bitcode: " << llvm::toString(module.takeError());
+  }
+  return std::move(module.get());
+}
+
+std::string WriteBitcode(const llvm::Module& module) {
+  std::string bitcode;
+  llvm::raw_string_ostream os(bitcode);
+#if TVM_LLVM_VERSION <= 60
+  llvm::WriteBitcodeToFile(&module, os);
+#else
+  llvm::WriteBitcodeToFile(module, os);
+#endif
+  os.flush();
+  return bitcode;
+}
+
+std::string EmitObject(llvm::Module* module, llvm::TargetMachine* tm) {
+  llvm::SmallString<0> object;
+  llvm::raw_svector_ostream dest(object);
+  llvm::legacy::PassManager pass;
+#if TVM_LLVM_VERSION <= 60
+  ICHECK(tm->addPassesToEmitFile(pass, dest, llvm::TargetMachine::CGFT_ObjectFile) == 0)
+      << "Cannot emit target CGFT_ObjectFile";
+#elif TVM_LLVM_VERSION <= 90
+  ICHECK(tm->addPassesToEmitFile(pass, dest, nullptr, llvm::TargetMachine::CGFT_ObjectFile) == 0)
+      << "Cannot emit target CGFT_ObjectFile";
+#else
+  ICHECK(tm->addPassesToEmitFile(pass, dest, nullptr, llvm::CGFT_ObjectFile) == 0)
+      << "Cannot emit target CGFT_ObjectFile";
+#endif
+  pass.run(*module);
+  return std::string(object.data(), object.size());
+}
+
 }  // namespace codegen
 }  // namespace tvm
 #endif  // TVM_LLVM_VERSION
@@ -31,6 +31,7 @@
 #ifdef TVM_LLVM_VERSION
 
 #include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/ExecutionEngine/MCJIT.h>
 #include <llvm/IR/InlineAsm.h>
@@ -40,6 +41,7 @@
 #include <tvm/runtime/container.h>
 #if TVM_LLVM_VERSION >= 100
 #include <llvm/IR/IntrinsicsAMDGPU.h>
+#include <llvm/IR/IntrinsicsAArch64.h>
 #include <llvm/IR/IntrinsicsARM.h>
 #include <llvm/IR/IntrinsicsNVPTX.h>
 #include <llvm/IR/IntrinsicsX86.h>
@@ -62,6 +64,7 @@
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 #include <llvm/Transforms/Utils/ModuleUtils.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 
 #if TVM_LLVM_VERSION >= 100
 #include <llvm/Support/Alignment.h>
@@ -79,9 +82,11 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace tvm {
 
@@ -123,6 +128,63 @@ std::unique_ptr<llvm::TargetMachine> GetLLVMTargetMachine(const Target& target,
  */
 std::string LLVMTargetToString(const Target& target);
 
+/*!
+ * \brief Check whether the target machine has a feature, e.g. "avx512f" or "dotprod".
+ * \param tm The target machine.
+ * \param feature The name of the feature, without the leading "+".
+ * \return Whether the feature is enabled, always false before LLVM 6.0.
+ */
+bool TargetHasFeature(const llvm::TargetMachine& tm, const std::string& feature);
+
+/*!
+ * \brief Get the number of threads to optimize and emit the host modules with, from
+ *  TVM_LLVM_CODEGEN_THREADS, 1 when unset and the number of hardware threads when 0.
+ */
+int GetLLVMCodegenThreads();
+
+/*!
+ * \brief Split a module into partitions of its functions, keeping the functions which share
+ *  a local symbol together.
+ * \param module The module, left unchanged.
+ * \param num_parts The maximum number of partitions.
+ * \return The bitcode of every partition.
+ */
+std::vector<std::string> SplitModuleToBitcode(const llvm::Module& module, int num_parts);
+
+/*!
+ * \brief Run a function on every partition of a module, each on its own thread with its own
+ *  LLVM context and target machine.
+ * \param parts The bitcode of the partitions, from SplitModuleToBitcode.
+ * \param tm The target machine to copy for every thread.
+ * \param f The function, called with the index, the module and the target machine of a part.
+ */
+void ForEachPartInParallel(
+    const std::vector<std::string>& parts, const llvm::TargetMachine& tm,
+    const std::function<void(size_t, llvm::Module*, llvm::TargetMachine*)>& f);
+
+/*!
+ * \brief Parse a module from bitcode.
+ * \param bitcode The bitcode.
+ * \param ctx The context of the module.
+ * \return The module.
+ */
+std::unique_ptr<llvm::Module> ParseBitcode(const std::string& bitcode, llvm::LLVMContext* ctx);
+
+/*!
+ * \brief Write a module to bitcode.
+ * \param module The module.
+ * \return The bitcode.
+ */
+std::string WriteBitcode(const llvm::Module& module);
+
+/*!
+ * \brief Emit the object file of a module.
+ * \param module The module.
+ * \param tm The target machine.
+ * \return The content of the object file.
+ */
+std::string EmitObject(llvm::Module* module, llvm::TargetMachine* tm);
+
 }  // namespace codegen
 }  // namespace tvm
 
@@ -29,6 +29,8 @@
 #include <tvm/target/codegen.h>
 
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include "../../runtime/file_utils.h"
 #include "../../runtime/library_module.h"
@@ -76,6 +78,11 @@ class LLVMModuleNode final : public runtime::ModuleNode {
         target_triple += " -mfloat-abi=soft";
       }
       return PackedFunc([target_triple](TVMArgs args, TVMRetValue* rv) { *rv = target_triple; });
+    } else if (name == "save_objects") {
+      // Emit the module as several object files in parallel, for the export to link them.
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->SaveObjects(args[0]);
+      });
     }
     if (ee_ == nullptr) LazyInitJIT();
 
@@ -95,6 +102,28 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     return WrapPackedFunc(faddr, sptr_to_self);
   }
 
+  /*!
+   * \brief Emit the module as object files, split into TVM_LLVM_CODEGEN_THREADS partitions
+   *  which are emitted on separate threads.
+   * \param prefix The prefix of the file names, the files are named <prefix>_<i>.o.
+   * \return The names of the files.
+   */
+  Array<String> SaveObjects(const std::string& prefix) {
+    ICHECK(tm_);
+    std::vector<std::string> parts = SplitModuleToBitcode(*mptr_, GetLLVMCodegenThreads());
+    ForEachPartInParallel(parts, *tm_,
+                          [&parts](size_t i, llvm::Module* module, llvm::TargetMachine* tm) {
+                            parts[i] = EmitObject(module, tm);
+                          });
+    Array<String> file_names;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      std::string file_name = prefix + "_" + std::to_string(i) + ".o";
+      runtime::SaveBinaryToFile(file_name, parts[i]);
+      file_names.push_back(file_name);
+    }
+    return file_names;
+  }
+
   void SaveToFile(const std::string& file_name, const std::string& format) final {
     std::string fmt = runtime::GetFileFormat(file_name, format);
     std::error_code ecode;
@@ -95,7 +95,7 @@ void CodeGenC::AddFunction(const PrimFunc& f) {
         PrintStorageScope(it->second, stream);
       }
 
-      PrintType(GetType(v), stream);
+      PrintParamType(v, stream);
       // Register handle data type
       // TODO(tvm-team): consider simply keep type info in the
       // type annotation(via a normalizing rewriting).
@@ -348,6 +348,10 @@ void CodeGenC::BindThreadIndex(const IterVar& iv) { LOG(FATAL) << "not implement
 void CodeGenC::PrintStorageSync(const CallNode* op) {  // NOLINT(*)
 }
 
+void CodeGenC::PrintParamType(const Var& v, std::ostream& os) {  // NOLINT(*)
+  PrintType(GetType(v), os);
+}
+
 void CodeGenC::PrintStorageScope(const std::string& scope, std::ostream& os) {  // NOLINT(*)
   ICHECK_EQ(scope, "global");
 }
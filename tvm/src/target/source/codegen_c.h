@@ -196,6 +196,8 @@ class CodeGenC : public ExprFunctor<void(const PrimExpr&, std::ostream&)>,
   virtual void PrintVecElemLoadExpr(DataType t, int i, const std::string& value, std::ostream& os);
   // Print restrict keyword for a given Var if applicable
   virtual void PrintRestrict(const Var& v, std::ostream& os);
+  // Print the type of a handle parameter of the function, after its storage scope
+  virtual void PrintParamType(const Var& v, std::ostream& os);  // NOLINT(*)
 
  protected:
   // Print reference to struct location
@@ -24,10 +24,14 @@
 
 #include <tvm/runtime/container.h>
 #include <tvm/runtime/crt/error_codes.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/module.h>
 #include <tvm/target/codegen.h>
 
+#include <algorithm>
+#include <sstream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "../../support/str_escape.h"
@@ -69,9 +73,24 @@ void CodeGenCHost::LinkParameters(Map<String, LinkedParam> params) {
   ICHECK_EQ(GetUniqueName(tvm::runtime::symbol::tvm_lookup_linked_param),
             tvm::runtime::symbol::tvm_lookup_linked_param)
       << "builtin PackedFunc name already taken: " << tvm::runtime::symbol::tvm_lookup_linked_param;
+  // The arena is static, a runtime acquires it before binding its storage entries so that
+  // other runtimes of the same module allocate theirs instead of aliasing it.
   stream << "    switch (((int64_t*) args)[0]) {\n"
          << "    default:\n"
          << "        out_ret_tcode[0] = " << kTVMNullptr << ";\n"
+         << "        return 0;\n"
+         << "    case " << runtime::kStorageArenaAcquire << ":\n"
+         << "        if (" << arena << "_in_use) {\n"
+         << "            out_ret_tcode[0] = " << kTVMNullptr << ";\n"
+         << "            return 0;\n"
+         << "        }\n"
+         << "        " << arena << "_in_use = 1;\n"
+         << "        ((uint64_t*)out_ret_value)[0] = (uint64_t) (uintptr_t) &" << arena << ";\n"
+         << "        out_ret_tcode[0] = " << kTVMOpaqueHandle << ";\n"
+         << "        return 0;\n"
+         << "    case " << runtime::kStorageArenaRelease << ":\n"
+         << "        " << arena << "_in_use = 0;\n"
+         << "        out_ret_tcode[0] = " << kTVMNullptr << ";\n"
          << "        return 0;\n";
 
   function_names_.push_back(tvm::runtime::symbol::tvm_lookup_linked_param);
@@ -103,6 +122,176 @@ void CodeGenCHost::LinkParameters(Map<String, LinkedParam> params) {
          << "}\n";
 }
 
+void CodeGenCHost::LinkStorageArena(Array<Integer> sizes) {
+  const char* arena = tvm::runtime::symbol::tvm_storage_arena;
+  // The members get the alignment the generated kernels assume for their buffers, so the
+  // storage entries are placed at fixed offsets of one static buffer.
+  decl_stream << "\n"
+              << "#ifdef __cplusplus\n"
+              << "extern \"C\" {\n"
+              << "#endif\n"
+              << "static struct {\n";
+  bool empty = true;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i]->value <= 0) continue;
+    decl_stream << "  uint8_t sid_" << i << "[" << sizes[i]->value << "] __attribute__((aligned("
+                << runtime::kAllocAlignment << ")));\n";
+    empty = false;
+  }
+  if (empty) {
+    decl_stream << "  uint8_t unused;\n";
+  }
+  decl_stream << "} " << arena << ";\n"
+              << "static int " << arena << "_in_use;\n"
+              << "#ifdef __cplusplus\n"
+              << "}  // extern \"C\"\n"
+              << "#endif\n";
+
+  PrintFuncPrefix();
+  stream << " " << tvm::runtime::symbol::tvm_lookup_storage_arena
+         << "(void* args, int* arg_type_ids, int num_args, void* out_ret_value, "
+         << "int* out_ret_tcode, void* resource_handle) {\n";
+  ICHECK_EQ(GetUniqueName(tvm::runtime::symbol::tvm_lookup_storage_arena),
+            tvm::runtime::symbol::tvm_lookup_storage_arena)
+      << "builtin PackedFunc name already taken: "
+      << tvm::runtime::symbol::tvm_lookup_storage_arena;
+  stream << "    switch (((int64_t*) args)[0]) {\n"
+         << "    default:\n"
+         << "        out_ret_tcode[0] = " << kTVMNullptr << ";\n"
+         << "        return 0;\n";
+  function_names_.push_back(tvm::runtime::symbol::tvm_lookup_storage_arena);
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i]->value <= 0) continue;
+    stream << "    case " << i << ":\n"
+           << "        ((uint64_t*)out_ret_value)[0] = (uint64_t) (uintptr_t) " << arena << ".sid_"
+           << i << ";\n"
+           << "        out_ret_tcode[0] = " << kTVMOpaqueHandle << ";\n"
+           << "        return 0;\n";
+  }
+  stream << "    }\n"
+         << "}\n";
+}
+
+void CodeGenCHost::GenerateAOTMain(Map<String, ObjectRef> plan, Array<Integer> sizes) {
+  auto entry_storage_ids = Downcast<Array<Integer>>(plan["entry_storage_ids"]);
+  auto entry_shapes = Downcast<Array<Array<Integer>>>(plan["entry_shapes"]);
+  auto entry_dtypes = Downcast<Array<String>>(plan["entry_dtypes"]);
+  auto storage_params = Downcast<Array<String>>(plan["storage_params"]);
+  auto input_entries = Downcast<Array<Integer>>(plan["input_entries"]);
+  auto output_entries = Downcast<Array<Integer>>(plan["output_entries"]);
+  auto call_funcs = Downcast<Array<String>>(plan["call_funcs"]);
+  auto call_args = Downcast<Array<Array<Integer>>>(plan["call_args"]);
+  const char* entries = "__tvm_aot_entries";
+
+  // The graph entries are static DLTensors over the linked params and the arena.
+  decl_stream << "\n#include <string.h>\n";
+  std::vector<int64_t> entry_bytes;
+  for (size_t eid = 0; eid < entry_shapes.size(); ++eid) {
+    DataType dtype(runtime::String2DLDataType(entry_dtypes[eid]));
+    int64_t bytes = (dtype.bits() * dtype.lanes() + 7) / 8;
+    for (const Integer& dim : entry_shapes[eid]) {
+      bytes *= dim->value;
+    }
+    entry_bytes.push_back(bytes);
+    if (entry_shapes[eid].empty()) continue;
+    decl_stream << "static int64_t __tvm_aot_shape_" << eid << "[] = {";
+    for (size_t i = 0; i < entry_shapes[eid].size(); ++i) {
+      decl_stream << (i == 0 ? "" : ", ") << entry_shapes[eid][i]->value;
+    }
+    decl_stream << "};\n";
+  }
+  decl_stream << "static DLTensor " << entries << "[" << std::max<size_t>(entry_shapes.size(), 1)
+              << "] = {\n";
+  for (size_t eid = 0; eid < entry_shapes.size(); ++eid) {
+    size_t sid = entry_storage_ids[eid]->value;
+    std::ostringstream data;
+    if (sid < storage_params.size() && !storage_params[sid].empty()) {
+      data << "(void*)" << ::tvm::runtime::symbol::tvm_param_prefix << storage_params[sid];
+    } else if (sid < sizes.size() && sizes[sid]->value > 0) {
+      data << "(void*)" << ::tvm::runtime::symbol::tvm_storage_arena << ".sid_" << sid;
+    } else {
+      data << "NULL";
+    }
+    DataType dtype(runtime::String2DLDataType(entry_dtypes[eid]));
+    decl_stream << "    {" << data.str() << ", {kDLCPU, 0}, " << entry_shapes[eid].size() << ", {"
+                << dtype.code() << ", " << dtype.bits() << ", " << dtype.lanes() << "}, ";
+    if (entry_shapes[eid].empty()) {
+      decl_stream << "NULL";
+    } else {
+      decl_stream << "__tvm_aot_shape_" << eid;
+    }
+    decl_stream << ", NULL, 0},\n";
+  }
+  decl_stream << "};\n";
+
+  PrintFuncPrefix();
+  stream << " " << tvm::runtime::symbol::tvm_run_aot
+         << "(void* args, int* arg_type_ids, int num_args, void* out_ret_value, "
+         << "int* out_ret_tcode, void* resource_handle) {\n";
+  ICHECK_EQ(GetUniqueName(tvm::runtime::symbol::tvm_run_aot),
+            tvm::runtime::symbol::tvm_run_aot)
+      << "builtin PackedFunc name already taken: " << tvm::runtime::symbol::tvm_run_aot;
+  function_names_.push_back(tvm::runtime::symbol::tvm_run_aot);
+  size_t max_num_args = 1;
+  for (const auto& args : call_args) {
+    max_num_args = std::max(max_num_args, args.size());
+  }
+  stream << "  TVMValue values[" << max_num_args << "];\n"
+         << "  int tcodes[" << max_num_args << "];\n"
+         << "  TVMValue ret_value;\n"
+         << "  int ret_tcode;\n"
+         << "  if (num_args != " << input_entries.size() + output_entries.size() << ") {\n"
+         << "    return -1;\n"
+         << "  }\n";
+  // The inputs, then the outputs, are given as DLTensors of the graph shapes.
+  auto print_arg_data = [this](size_t i) {
+    stream << "(char*)((DLTensor*)((TVMValue*)args)[" << i << "].v_handle)->data + "
+           << "((DLTensor*)((TVMValue*)args)[" << i << "].v_handle)->byte_offset";
+  };
+  for (size_t i = 0; i < input_entries.size(); ++i) {
+    int64_t eid = input_entries[i]->value;
+    if (entry_bytes[eid] == 0) continue;
+    stream << "  memcpy(" << entries << "[" << eid << "].data, ";
+    print_arg_data(i);
+    stream << ", " << entry_bytes[eid] << ");\n";
+  }
+  // The functions of external codegens, e.g. contrib/cmsisnn, live in other C modules of the
+  // same library and take the arguments of the external C functions.
+  std::unordered_set<std::string> external_funcs;
+  for (const String& func : call_funcs) {
+    if (std::find(function_names_.begin(), function_names_.end(), func) != function_names_.end() ||
+        !external_funcs.insert(func).second) {
+      continue;
+    }
+    decl_stream << "#ifdef __cplusplus\n"
+                << "extern \"C\"\n"
+                << "#endif\n"
+                << "TVM_DLL int32_t " << func << "(TVMValue* args, int* type_code, int num_args, "
+                << "TVMValue* out_value, int* out_type_code);\n";
+  }
+  for (size_t i = 0; i < call_funcs.size(); ++i) {
+    for (size_t j = 0; j < call_args[i].size(); ++j) {
+      stream << "  values[" << j << "].v_handle = &" << entries << "[" << call_args[i][j]->value
+             << "];\n"
+             << "  tcodes[" << j << "] = " << kTVMDLTensorHandle << ";\n";
+    }
+    stream << "  if (" << call_funcs[i] << "(values, tcodes, " << call_args[i].size()
+           << ", &ret_value, &ret_tcode" << (external_funcs.count(call_funcs[i]) ? "" : ", NULL")
+           << ") != 0) {\n"
+           << "    return -1;\n"
+           << "  }\n";
+  }
+  for (size_t i = 0; i < output_entries.size(); ++i) {
+    int64_t eid = output_entries[i]->value;
+    if (entry_bytes[eid] == 0) continue;
+    stream << "  memcpy(";
+    print_arg_data(input_entries.size() + i);
+    stream << ", " << entries << "[" << eid << "].data, " << entry_bytes[eid] << ");\n";
+  }
+  stream << "  return 0;\n"
+         << "}\n";
+}
+
 void CodeGenCHost::PrintFuncPrefix() {  // NOLINT(*)
   stream << "#ifdef __cplusplus\n"
          << "extern \"C\"\n"
@@ -333,7 +522,27 @@ runtime::Module BuildCHost(IRModule mod, Target target) {
   Map<String, LinkedParam> linked_params;
   bool found_linked_params = false;
   bool could_have_linked_params = target->GetAttr<Bool>("link-params").value_or(Bool(false));
+  Array<Integer> storage_sizes;
+  bool found_storage_arena = false;
+  bool aot = target->GetAttr<String>("executor").value_or("graph") == "aot";
+  bool could_have_storage_arena =
+      aot || target->GetAttr<Bool>("link-storage").value_or(Bool(false));
+  Map<String, ObjectRef> aot_plan;
   for (auto kv : mod->functions) {
+    if (aot && kv.first->name_hint == ::tvm::runtime::symbol::tvm_run_aot) {
+      auto plan = kv.second->GetAttr<Map<String, ObjectRef>>(::tvm::tir::attr::kAOTPlan);
+      CHECK(plan.defined()) << "no " << ::tvm::tir::attr::kAOTPlan << " attribute found!";
+      aot_plan = plan.value();
+      continue;
+    }
+    if (could_have_storage_arena &&
+        kv.first->name_hint == ::tvm::runtime::symbol::tvm_lookup_storage_arena) {
+      auto sizes = kv.second->GetAttr<Array<Integer>>(::tvm::tir::attr::kStorageArena);
+      CHECK(sizes.defined()) << "no " << ::tvm::tir::attr::kStorageArena << " attribute found!";
+      storage_sizes = sizes.value();
+      found_storage_arena = true;
+      continue;
+    }
     if (could_have_linked_params &&
         kv.first->name_hint == ::tvm::runtime::symbol::tvm_lookup_linked_param) {
       Map<String, ObjectRef> attrs_dict = Downcast<Map<String, ObjectRef>>(kv.second->attrs->dict);
@@ -355,6 +564,16 @@ runtime::Module BuildCHost(IRModule mod, Target target) {
     cg.LinkParameters(linked_params);
   }
 
+  if (could_have_storage_arena) {
+    ICHECK(found_storage_arena) << "-link-storage given but no memory plan found";
+    cg.LinkStorageArena(storage_sizes);
+  }
+
+  if (aot) {
+    ICHECK(aot_plan.defined()) << "-executor=aot given but no graph found";
+    cg.GenerateAOTMain(aot_plan, storage_sizes);
+  }
+
   if (target->GetAttr<Bool>("system-lib").value_or(Bool(false))) {
     ICHECK_EQ(target->GetAttr<String>("runtime").value_or(""), "c")
         << "c target only supports generating C runtime SystemLibs";
@@ -44,6 +44,21 @@ class CodeGenCHost final : public CodeGenC {
 
   /*! \brief Add linked parameters, if they are present. */
   void LinkParameters(Map<String, LinkedParam> params);
+  /*!
+   * \brief Emit the static memory plan of the graph: a struct holding every storage entry at a
+   *  fixed offset, and the PackedFunc returning the entry of a storage id.
+   * \param sizes The size in bytes of every storage id, 0 for the ids left out of the arena.
+   */
+  void LinkStorageArena(Array<Integer> sizes);
+  /*!
+   * \brief Emit the entry function of the ahead-of-time executor, which copies in the graph
+   *  inputs, calls the fused functions on their static entries and copies out the outputs.
+   *  The functions not in this module are declared as the external C functions of the BYOC
+   *  codegens. The linked params and the storage arena must be emitted before.
+   * \param plan The graph to run, see tir::attr::kAOTPlan.
+   * \param sizes The size in bytes of every storage id, 0 for the ids left out of the arena.
+   */
+  void GenerateAOTMain(Map<String, ObjectRef> plan, Array<Integer> sizes);
 
   void PrintType(DataType t, std::ostream& os) final;  // NOLINT(*)
   void PrintFuncPrefix() final;                        // NOLINT(*)
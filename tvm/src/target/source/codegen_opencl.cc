@@ -22,6 +22,7 @@
  */
 #include "codegen_opencl.h"
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <vector>
@@ -37,29 +38,37 @@ class InferTextureAccess : public StmtExprVisitor {
 public:
   static constexpr const uint8_t read_access = 1;
   static constexpr const uint8_t write_access = 2;
+  static constexpr const uint8_t array_access = 4;
 
   explicit InferTextureAccess() {}
   std::unordered_map<const VarNode*, std::string> Infer(const Stmt& n) {
     StmtExprVisitor::VisitStmt(n);
     std::unordered_map<const VarNode*, std::string> storage_scope_qualifiers;
     for (auto& texture : var_access_map_) {
-      if (texture.second == read_access) {
-        storage_scope_qualifiers.insert({texture.first, "texture_read"});
+      // Image arrays are marked by a texture_array prefix
+      std::string prefix = (texture.second & array_access) ? "texture_array" : "texture";
+      uint8_t access = texture.second & (read_access | write_access);
+      if (access == read_access) {
+        storage_scope_qualifiers.insert({texture.first, prefix + "_read"});
       }
-      else if (texture.second == write_access) {
-        storage_scope_qualifiers.insert({texture.first, "texture_write"});
+      else if (access == write_access) {
+        storage_scope_qualifiers.insert({texture.first, prefix + "_write"});
       }
-      else if (texture.second == (read_access | write_access)) {
-        storage_scope_qualifiers.insert({texture.first, ""});
+      else if (access == (read_access | write_access)) {
+        storage_scope_qualifiers.insert({texture.first, prefix == "texture" ? "" : prefix});
       }
     }
     return storage_scope_qualifiers;
   }
   void VisitExpr_(const CallNode* op) {
-    if (op->op.same_as(builtin::texture2d_load())) {
+    if (op->op.same_as(builtin::texture2d_load()) || op->op.same_as(builtin::texture2d_sample())) {
       var_access_map_[op->args[0].as<VarNode>()] |= read_access;
     } else if (op->op.same_as(builtin::texture2d_store())) {
       var_access_map_[op->args[0].as<VarNode>()] |= write_access;
+    } else if (op->op.same_as(builtin::texture2d_array_load())) {
+      var_access_map_[op->args[0].as<VarNode>()] |= read_access | array_access;
+    } else if (op->op.same_as(builtin::texture2d_array_store())) {
+      var_access_map_[op->args[0].as<VarNode>()] |= write_access | array_access;
     } else {
       StmtExprVisitor::VisitExpr_(op);
     }
@@ -70,12 +79,119 @@ private:
   std::unordered_map<const VarNode*, uint8_t> var_access_map_;
 };
 
+// Find whether a kernel calls sub-group functions, and the extents of its thread indices.
+class KernelUsageFinder : public StmtExprVisitor {
+ public:
+  void VisitStmt_(const AttrStmtNode* op) final {
+    if (op->attr_key == tir::attr::thread_extent) {
+      IterVar iv = Downcast<IterVar>(op->node);
+      runtime::ThreadScope ts = runtime::ThreadScope::Create(iv->thread_tag);
+      if (ts.dim_index != 0) any_local_size = false;
+      if (ts.rank == 1) {
+        const auto* extent = op->value.as<IntImmNode>();
+        int64_t& known = thread_extents[ts.dim_index];
+        if (extent == nullptr || (known != 1 && known != extent->value)) {
+          static_extents = false;
+        } else {
+          known = extent->value;
+        }
+      }
+    } else if (op->attr_key == tir::attr::storage_scope) {
+      // The work-group shares its shared and warp memory
+      std::string scope = Downcast<StringImm>(op->value)->value;
+      if (scope.compare(0, 6, "shared") == 0 || scope == "warp") any_local_size = false;
+    }
+    StmtExprVisitor::VisitStmt_(op);
+  }
+
+  void VisitExpr_(const CallNode* op) final {
+    if (op->op.same_as(builtin::call_pure_extern()) || op->op.same_as(builtin::call_extern())) {
+      const std::string& name = Downcast<StringImm>(op->args[0])->value;
+      if (name.find("sub_group_") != std::string::npos) {
+        uses_sub_groups = true;
+        any_local_size = false;
+      }
+    } else if (op->op.same_as(builtin::tvm_storage_sync()) ||
+               op->op.same_as(builtin::tvm_warp_shuffle()) ||
+               op->op.same_as(builtin::tvm_warp_shuffle_up()) ||
+               op->op.same_as(builtin::tvm_warp_shuffle_down()) ||
+               op->op.same_as(builtin::tvm_warp_activemask())) {
+      any_local_size = false;
+    }
+    StmtExprVisitor::VisitExpr_(op);
+  }
+
+  /*! \brief Whether sub-group functions are called. */
+  bool uses_sub_groups{false};
+  /*!
+   * \brief Whether the kernel computes the same for any local size, when threadIdx.x and
+   *  blockIdx.x are derived from the global id: it is one dimensional, and its threads do not
+   *  synchronize or share memory.
+   */
+  bool any_local_size{true};
+  /*! \brief Whether all the thread extents are constant. */
+  bool static_extents{true};
+  /*! \brief The extents of threadIdx.x, y and z, 1 for the unused ones. */
+  int64_t thread_extents[3] = {1, 1, 1};
+};
 
 CodeGenOpenCL::CodeGenOpenCL() { restrict_keyword_ = "restrict"; }
 
 void CodeGenOpenCL::InitFuncState(const PrimFunc& f) {
   CodeGenC::InitFuncState(f);
   this->SetTextureScope(InferTextureAccess().Infer(f->body));
+  // When the work-group rows are exactly one sub-group, threadIdx.x is the sub-group local id
+  // that the sub-group shuffles are indexed with.
+  bind_sub_group_local_id_ = false;
+  texture_read_write_ = false;
+  func_attributes_.clear();
+  KernelUsageFinder finder;
+  finder(f->body);
+  const int64_t* extents = finder.thread_extents;
+  // With the local_size_search target option, the local size of the kernels which run with
+  // any of them is only a hint, the runtime may search a better one, see
+  // TVM_OPENCL_LOCAL_SIZE_SEARCH. The others keep the local size of their schedule.
+  Optional<Target> func_target = f->GetAttr<Target>(tvm::attr::kTarget);
+  bool local_size_search =
+      func_target && func_target.value()->GetAttr<Bool>("local_size_search", Bool(false)).value();
+  any_local_size_extent_ =
+      local_size_search && finder.static_extents && finder.any_local_size ? extents[0] : 0;
+  if (finder.static_extents) {
+    std::ostringstream os;
+    const char* attr = any_local_size_extent_ ? "work_group_size_hint" : "reqd_work_group_size";
+    os << "__attribute__((" << attr << "(" << extents[0] << ", " << extents[1] << ", "
+       << extents[2] << "))) ";
+    func_attributes_ = os.str();
+  }
+  if (auto target = f->GetAttr<Target>(tvm::attr::kTarget)) {
+    int64_t sub_group_size = target.value()->GetAttr<Integer>("thread_warp_size", 1).value();
+    bind_sub_group_local_id_ =
+        sub_group_size > 1 && finder.uses_sub_groups && extents[0] == sub_group_size;
+    if (finder.static_extents) {
+      // A required work-group size larger than the device supports fails at kernel creation,
+      // report it against the schedule instead.
+      int64_t max_num_threads = target.value()->GetAttr<Integer>("max_num_threads", -1).value();
+      int64_t num_threads = extents[0] * extents[1] * extents[2];
+      ICHECK(max_num_threads < 0 || num_threads <= max_num_threads)
+          << "The work-group of " << f->GetAttr<String>(tvm::attr::kGlobalSymbol).value_or("")
+          << " has " << num_threads << " threads (" << extents[0] << ", " << extents[1] << ", "
+          << extents[2] << "), more than the max_num_threads " << max_num_threads
+          << " of the target";
+    }
+    texture_read_write_ = target.value()->GetAttr<Bool>("texture_inplace", Bool(false)).value();
+    // The sub-group functions were lowered for thread_warp_size lanes, pin the sub-group size
+    // to it. Adreno selects between half and full waves.
+    String device = target.value()->GetAttr<String>("device", "").value();
+    if (finder.uses_sub_groups && sub_group_size > 1) {
+      if (device == "adreno" && (sub_group_size == 64 || sub_group_size == 128)) {
+        func_attributes_ += sub_group_size == 64 ? "TVM_QCOM_REQD_SUB_GROUP_SIZE(\"half\") "
+                                                 : "TVM_QCOM_REQD_SUB_GROUP_SIZE(\"full\") ";
+      } else {
+        func_attributes_ += "TVM_REQD_SUB_GROUP_SIZE(" + std::to_string(sub_group_size) + ") ";
+      }
+      enable_reqd_sub_group_size_ = true;
+    }
+  }
   for (Var arg : f->params) {
     if (arg->type_annotation.as<TextureTypeNode>())
     {
@@ -89,7 +205,7 @@ void CodeGenOpenCL::InitFuncState(const PrimFunc& f) {
   }
 }
 
-void CodeGenOpenCL::PrintFuncPrefix() { stream << "__kernel void"; }
+void CodeGenOpenCL::PrintFuncPrefix() { stream << "__kernel " << func_attributes_ << "void"; }
 
 std::string CodeGenOpenCL::Finish() {
   // inject extension enable pragma for fp16 and fp64
@@ -120,6 +236,103 @@ std::string CodeGenOpenCL::Finish() {
     decl_stream << "#pragma OPENCL EXTENSION cl_khr_global_int32_base_atomics : enable\n"
                    "#pragma OPENCL EXTENSION cl_khr_global_int32_extended_atomics : enable\n\n";
   }
+  // Enable sub-group functions and select the shuffles reported by the device.
+  if (enable_sub_groups_) {
+    decl_stream << "#ifdef cl_khr_subgroups\n"
+                   "#pragma OPENCL EXTENSION cl_khr_subgroups : enable\n"
+                   "#endif\n"
+                   "#if defined(cl_khr_subgroup_shuffle)\n"
+                   "#pragma OPENCL EXTENSION cl_khr_subgroup_shuffle : enable\n"
+                   "#define tvm_sub_group_shuffle(v, lane) sub_group_shuffle(v, lane)\n"
+                   "#elif defined(cl_intel_subgroups)\n"
+                   "#define tvm_sub_group_shuffle(v, lane) intel_sub_group_shuffle(v, lane)\n"
+                   "#else\n"
+                   // Without an indexed shuffle, e.g. with only cl_qcom_subgroup_shuffle, every
+                   // lane is broadcast in turn and each work-item keeps its source lane.
+                   "#define TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(T) \\\n"
+                   "  T __attribute__((overloadable)) \\\n"
+                   "  tvm_sub_group_shuffle(T v, uint lane) { \\\n"
+                   "    T r = v; \\\n"
+                   "    for (uint i = 0; i < get_max_sub_group_size(); ++i) { \\\n"
+                   "      T s = sub_group_broadcast(v, i); \\\n"
+                   "      if (i == lane) r = s; \\\n"
+                   "    } \\\n"
+                   "    return r; \\\n"
+                   "  }\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(int)\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(uint)\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(long)\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(ulong)\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(float)\n"
+                   "#ifdef cl_khr_fp16\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(half)\n"
+                   "#endif\n"
+                   "#ifdef cl_khr_fp64\n"
+                   "TVM_SUB_GROUP_SHUFFLE_BY_BROADCAST(double)\n"
+                   "#endif\n"
+                   "#endif\n"
+                   "#if defined(cl_khr_subgroup_shuffle_relative)\n"
+                   "#pragma OPENCL EXTENSION cl_khr_subgroup_shuffle_relative : enable\n"
+                   "#define tvm_sub_group_shuffle_up(v, d) sub_group_shuffle_up(v, d)\n"
+                   "#define tvm_sub_group_shuffle_down(v, d) sub_group_shuffle_down(v, d)\n"
+                   "#elif defined(cl_qcom_subgroup_shuffle)\n"
+                   "#pragma OPENCL EXTENSION cl_qcom_subgroup_shuffle : enable\n"
+                   "#define tvm_sub_group_shuffle_up(v, d) \\\n"
+                   "  qcom_sub_group_shuffle_up(v, d, \\\n"
+                   "                            CLK_SUB_GROUP_SHUFFLE_WIDTH_WAVE_SIZE_QCOM, v)\n"
+                   "#define tvm_sub_group_shuffle_down(v, d) \\\n"
+                   "  qcom_sub_group_shuffle_down(v, d, \\\n"
+                   "                            CLK_SUB_GROUP_SHUFFLE_WIDTH_WAVE_SIZE_QCOM, v)\n"
+                   "#elif defined(cl_intel_subgroups)\n"
+                   "#define tvm_sub_group_shuffle_up(v, d) intel_sub_group_shuffle_up(v, v, d)\n"
+                   "#define tvm_sub_group_shuffle_down(v, d) \\\n"
+                   "  intel_sub_group_shuffle_down(v, v, d)\n"
+                   "#endif\n\n";
+  }
+  // Select the 4-way int8 dot product reported by the device, and expand the lanes otherwise.
+  if (enable_dot_product_) {
+    decl_stream << "#if defined(cl_khr_integer_dot_product) && \\\n"
+                   "    defined(__opencl_c_integer_dot_product_input_4x8bit)\n"
+                   "#pragma OPENCL EXTENSION cl_khr_integer_dot_product : enable\n"
+                   "#define tvm_dp4a(a, b, c) ((c) + dot(a, b))\n"
+                   "#elif defined(cl_arm_integer_dot_product_accumulate_int8)\n"
+                   "#pragma OPENCL EXTENSION cl_arm_integer_dot_product_accumulate_int8 : enable\n"
+                   "#define tvm_dp4a(a, b, c) arm_dot_acc(a, b, c)\n"
+                   "#else\n"
+                   "#define tvm_dp4a(a, b, c) \\\n"
+                   "  ((c) + (int)(a).x * (b).x + (int)(a).y * (b).y + (int)(a).z * (b).z + \\\n"
+                   "   (int)(a).w * (b).w)\n"
+                   "#endif\n\n";
+  }
+  // Binding one image through a read_only and a write_only parameter is undefined, the
+  // kernels planned in place need read_write images.
+  if (enable_read_write_images_) {
+    decl_stream << "#if !defined(__opencl_c_read_write_images) && \\\n"
+                   "    !(defined(__OPENCL_C_VERSION__) && __OPENCL_C_VERSION__ >= 200 && \\\n"
+                   "      __OPENCL_C_VERSION__ < 300)\n"
+                   "#error \"texture_inplace requires the read_write images of OpenCL C 2.0\"\n"
+                   "#endif\n\n";
+  }
+  // The sub-group functions give wrong results with another sub-group size, so the kernels
+  // fail to build when it cannot be required.
+  if (enable_reqd_sub_group_size_) {
+    decl_stream << "#ifdef cl_qcom_reqd_sub_group_size\n"
+                   "#pragma OPENCL EXTENSION cl_qcom_reqd_sub_group_size : enable\n"
+                   "#define TVM_QCOM_REQD_SUB_GROUP_SIZE(size) \\\n"
+                   "  __attribute__((qcom_reqd_sub_group_size(size)))\n"
+                   "#else\n"
+                   "#define TVM_QCOM_REQD_SUB_GROUP_SIZE(size) \\\n"
+                   "  tvm_cannot_require_sub_group_size_remove_thread_warp_size_from_target\n"
+                   "#endif\n"
+                   "#ifdef cl_intel_required_subgroup_size\n"
+                   "#pragma OPENCL EXTENSION cl_intel_required_subgroup_size : enable\n"
+                   "#define TVM_REQD_SUB_GROUP_SIZE(size) \\\n"
+                   "  __attribute__((intel_reqd_sub_group_size(size)))\n"
+                   "#else\n"
+                   "#define TVM_REQD_SUB_GROUP_SIZE(size) \\\n"
+                   "  tvm_cannot_require_sub_group_size_remove_thread_warp_size_from_target\n"
+                   "#endif\n\n";
+  }
   return CodeGenC::Finish();
 }
 
@@ -127,7 +340,13 @@ void CodeGenOpenCL::BindThreadIndex(const IterVar& iv) {
   ICHECK(!var_idmap_.count(iv->var.get()));
   runtime::ThreadScope ts = runtime::ThreadScope::Create(iv->thread_tag);
   std::ostringstream os;
-  if (ts.rank == 1) {
+  if (ts.rank == 1 && ts.dim_index == 0 && bind_sub_group_local_id_) {
+    os << "get_sub_group_local_id()";
+  } else if (any_local_size_extent_ != 0) {
+    // The kernel is one dimensional, its indices are the ones of the compiled local size
+    os << "(get_global_id(0) " << (ts.rank == 1 ? "%" : "/") << " " << any_local_size_extent_
+       << ")";
+  } else if (ts.rank == 1) {
     os << "get_local_id(" << ts.dim_index << ")";
   } else {
     os << "get_group_id(" << ts.dim_index << ")";
@@ -270,11 +489,32 @@ void CodeGenOpenCL::PrintStorageScope(const std::string& scope, std::ostream& os
     os << "__global ";
   } else if (scope == "shared") {
     os << "__local ";
+  } else if ((scope == "texture_read" || scope == "texture_write") && texture_read_write_) {
+    // The same image may be bound to this parameter and another one of the other access
+    os << "__read_write ";
+    enable_read_write_images_ = true;
   } else if (scope == "texture_read") {
     os << "__read_only ";
   } else if (scope == "texture_write") {
     os << "__write_only ";
+  } else if (scope.rfind("texture_array", 0) == 0) {
+    if (scope == "texture_array_read") {
+      os << "__read_only ";
+    } else if (scope == "texture_array_write") {
+      os << "__write_only ";
+    }
+  }
+}
+
+void CodeGenOpenCL::PrintParamType(const Var& v, std::ostream& os) {  // NOLINT(*)
+  // The texture access inferred for the function marks the image arrays by their scope
+  auto it = alloc_storage_scope_.find(v.get());
+  if (v->type_annotation.as<TextureTypeNode>() && it != alloc_storage_scope_.end() &&
+      it->second.rfind("texture_array", 0) == 0) {
+    os << "image2d_array_t";
+    return;
   }
+  CodeGenC::PrintParamType(v, os);
 }
 
 void CodeGenOpenCL::PrintRestrict(const Var& v, std::ostream& os) {
@@ -303,7 +543,9 @@ std::string CodeGenOpenCL::CastFromTo(std::string value, DataType from, DataType
 
 void CodeGenOpenCL::VisitStmt_(const StoreNode* op) {
   if (auto call = op->value.as<CallNode>()) {
-    if (call->op.same_as(builtin::texture2d_load())) {
+    if (call->op.same_as(builtin::texture2d_load()) ||
+        call->op.same_as(builtin::texture2d_array_load()) ||
+        call->op.same_as(builtin::texture2d_sample())) {
       need_texture_ssa_ = false;
       // If storing a texture load into a buffer, don't use an
       // intermediate local unless the buffer allocation is a
@@ -321,7 +563,9 @@ void CodeGenOpenCL::VisitStmt_(const StoreNode* op) {
 
 void CodeGenOpenCL::VisitExpr_(const CastNode* op, std::ostream& os) {
   if (auto call = op->value.as<CallNode>()) {
-    if (call->op.same_as(builtin::texture2d_load())) {
+    if (call->op.same_as(builtin::texture2d_load()) ||
+        call->op.same_as(builtin::texture2d_array_load()) ||
+        call->op.same_as(builtin::texture2d_sample())) {
       need_texture_ssa_ = false;
     }
   }
@@ -348,56 +592,114 @@ void CodeGenOpenCL::VisitExpr_(const CallNode* op, std::ostream& os) {
     os << " *)" << this->GetVarID(load->buffer_var.get()) << " + ";
     this->PrintExpr(load->index, os);
     os << ')';
-  } else if (op->op.same_as(builtin::texture2d_store())) {
+  } else if (op->op.same_as(builtin::texture2d_store()) ||
+             op->op.same_as(builtin::texture2d_array_store())) {
     auto* texture_type = op->args[0].as<VarNode>()->type_annotation.as<TextureTypeNode>();
     ICHECK(texture_type != nullptr)
         << "builtin::texture2d_store() only supports storing to texture buffers";
     DataType buffer_type = texture_type->element_type.as<PrimTypeNode>()->dtype;
+    // Integer images are written through 32 bit vectors, narrower values are widened first
+    bool widen = false;
     if (buffer_type.is_float16()) {
       os << "write_imageh(";
     }
     else if (buffer_type.is_float()) {
       os << "write_imagef(";
+    } else if (buffer_type.is_int() && buffer_type.bits() <= 32) {
+      os << "write_imagei(";
+      widen = buffer_type.bits() != 32;
+    } else if (buffer_type.is_uint() && buffer_type.bits() <= 32) {
+      os << "write_imageui(";
+      widen = buffer_type.bits() != 32;
     } else {
       LOG(FATAL) << "Unsupported type: " << buffer_type
-                 << ", currently only float and half are supported for image2d OpenCL codegen.";
+                 << ", currently only float, half and up to 32 bit integers are supported for "
+                 << "image2d OpenCL codegen.";
     }
     this->PrintExpr(op->args[0], os);
     os << ", ";
-    os << "(int2)(";
-    this->PrintExpr(op->args[1], os);
+    PrintTexelCoord(op, os);
     os << ", ";
-    this->PrintExpr(op->args[2], os);
-    os << "), ";
-    this->PrintExpr(op->args[3], os);
+    if (widen) {
+      os << "convert_";
+      this->PrintType(buffer_type.with_bits(32).with_lanes(4), os);
+      os << "(";
+    }
+    // R and RG textures take the value replicated to a 4 lane vector, only the
+    // leading channels are stored
+    const PrimExpr& texel = op->args.back();
+    int lanes = texel.dtype().lanes();
+    if (lanes < 4) {
+      std::string value = PrintExpr(texel);
+      os << "((";
+      this->PrintType(texel.dtype().with_lanes(4), os);
+      os << ")(";
+      for (int i = 0; i < 4 / lanes; ++i) {
+        os << (i != 0 ? ", " : "") << value;
+      }
+      os << "))";
+    } else {
+      this->PrintExpr(texel, os);
+    }
+    if (widen) {
+      os << ")";
+    }
     os << ")";
-  } else if (op->op.same_as(builtin::texture2d_load())) {
+  } else if (op->op.same_as(builtin::texture2d_load()) ||
+             op->op.same_as(builtin::texture2d_array_load()) ||
+             op->op.same_as(builtin::texture2d_sample())) {
+    bool sample = op->op.same_as(builtin::texture2d_sample());
     std::stringstream ss;
+    // Integer images are read as 32 bit vectors, narrower values are converted back
+    bool narrow = false;
+    if ((op->dtype.is_int() || op->dtype.is_uint()) && op->dtype.bits() < 32) {
+      narrow = true;
+      ss << "convert_";
+      this->PrintType(op->dtype.with_lanes(4), ss);
+      ss << "(";
+    }
     if (op->dtype.is_float16()) {
       ss << "read_imageh(";
     }
     else if (op->dtype.is_float()) {
       ss << "read_imagef(";
+    } else if (op->dtype.is_int() && op->dtype.bits() <= 32) {
+      ss << "read_imagei(";
+    } else if (op->dtype.is_uint() && op->dtype.bits() <= 32) {
+      ss << "read_imageui(";
     } else {
       LOG(FATAL) << "Unsupported type: " << op->dtype
-                 << ", currently only float and half are supported for image2d OpenCL codegen.";
+                 << ", currently only float, half and up to 32 bit integers are supported for "
+                 << "image2d OpenCL codegen.";
     }
     this->PrintExpr(op->args[0], ss);
     ss << ", ";
-    ss << "CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST, ";
-    ss << "(int2)(";
-    this->PrintExpr(op->args[1], ss);
-    ss << ", ";
-    this->PrintExpr(op->args[2], ss);
-    ss << "))";
+    if (sample) {
+      const auto* flags = op->args[1].as<IntImmNode>();
+      ICHECK(flags) << "The sampler of texture2d_sample must be a constant, got " << op->args[1];
+      ICHECK(!(flags->value & builtin::kSamplerFilterLinear) || op->dtype.is_float())
+          << "Linear filtering is only supported on float and half textures, got " << op->dtype;
+      ss << PrintSampler(flags->value) << ", (float2)(";
+      this->PrintExpr(op->args[2], ss);
+      ss << ", ";
+      this->PrintExpr(op->args[3], ss);
+      ss << ")";
+    } else {
+      ss << PrintSampler(0) << ", ";
+      PrintTexelCoord(op, ss);
+    }
+    ss << ")";
+    if (narrow) {
+      ss << ")";
+    }
 
     // Only use local SSA if texture is not already being stored
     if (need_texture_ssa_)
     {
       std::string rhs = SSAGetID(ss.str(), op->dtype.with_lanes(4));
-      if (op->args.back().as<RampNode>())
+      if (const auto* ramp = op->args.back().as<RampNode>())
       {
-        os << rhs;
+        os << rhs << TexelSwizzle(ramp);
       } else {
         os << "((";
         this->PrintType(op->dtype.with_lanes(1), os);
@@ -407,19 +709,87 @@ void CodeGenOpenCL::VisitExpr_(const CallNode* op, std::ostream& os) {
       }
     } else {
       os << ss.str();
+      if (const auto* ramp = op->args.back().as<RampNode>()) {
+        os << TexelSwizzle(ramp);
+      }
     }
-  } else if (op->op.same_as(builtin_call_extern_)) {
+  } else if (op->op.same_as(builtin_call_extern_) || op->op.same_as(builtin_call_pure_extern_)) {
     auto func = Downcast<StringImm>(op->args[0]);
     // Enable atomics extension if used.
     if (func->value == "atomic_add") {
       enable_atomics_ = true;
     }
+    // Enable sub-group extensions if used.
+    if (func->value.find("sub_group_") != std::string::npos) {
+      enable_sub_groups_ = true;
+    }
+    // Enable integer dot product extensions if used.
+    if (func->value == "tvm_dp4a") {
+      enable_dot_product_ = true;
+    }
     CodeGenC::VisitExpr_(op, os);
   } else {
     CodeGenC::VisitExpr_(op, os);
   }
 }
 
+std::string CodeGenOpenCL::PrintSampler(int flags) {
+  std::ostringstream os;
+  os << ((flags & builtin::kSamplerNormalizedCoords) ? "CLK_NORMALIZED_COORDS_TRUE"
+                                                     : "CLK_NORMALIZED_COORDS_FALSE");
+  os << ((flags & builtin::kSamplerAddressClampToEdge) ? " | CLK_ADDRESS_CLAMP_TO_EDGE"
+                                                       : " | CLK_ADDRESS_CLAMP");
+  os << ((flags & builtin::kSamplerFilterLinear) ? " | CLK_FILTER_LINEAR"
+                                                 : " | CLK_FILTER_NEAREST");
+  return os.str();
+}
+
+void CodeGenOpenCL::PrintTexelCoord(const CallNode* op, std::ostream& os) {  // NOLINT(*)
+  // The arguments are the texture, the coordinates and the channel or the value to store.
+  // Image arrays take the layer as third coordinate, padded to an int4.
+  size_t ncoord = op->args.size() - 2;
+  os << (ncoord == 2 ? "(int2)(" : "(int4)(");
+  for (size_t i = 1; i <= ncoord; ++i) {
+    if (i != 1) os << ", ";
+    this->PrintExpr(op->args[i], os);
+  }
+  if (ncoord == 3) os << ", 0";
+  os << ")";
+}
+
+std::string CodeGenOpenCL::TexelSwizzle(const RampNode* channels) {
+  // A full texel needs no swizzle, partial texels select their channels, e.g. RG textures
+  // are accessed two channels at a time.
+  if (channels->lanes == 4) return "";
+  const auto* base = channels->base.as<IntImmNode>();
+  ICHECK(base && base->value + channels->lanes <= 4)
+      << "Partial texel reads need a constant first channel, got " << channels->base;
+  std::ostringstream os;
+  os << ".s";
+  for (int i = 0; i < channels->lanes; ++i) {
+    os << base->value + i;
+  }
+  return os.str();
+}
+
+void CodeGenOpenCL::VisitExpr_(const ShuffleNode* op, std::ostream& os) {  // NOLINT(*)
+  // Only concatenations are supported, e.g. of the reads of adjacent texels, which are printed
+  // as a vector literal of the concatenated values.
+  for (size_t i = 0; i < op->indices.size(); ++i) {
+    const auto* index = op->indices[i].as<IntImmNode>();
+    ICHECK(index && index->value == static_cast<int64_t>(i))
+        << "Shuffle: only concatenation is supported by OpenCL codegen";
+  }
+  os << "((";
+  PrintType(op->dtype, os);
+  os << ")(";
+  for (size_t i = 0; i < op->vectors.size(); ++i) {
+    if (i != 0) os << ", ";
+    PrintExpr(op->vectors[i], os);
+  }
+  os << "))";
+}
+
 void CodeGenOpenCL::VisitExpr_(const BroadcastNode* op, std::ostream& os) {  // NOLINT(*)
   std::string v = PrintExpr(op->value);
   os << "((";
@@ -477,6 +847,49 @@ void CodeGenOpenCL::SetTextureScope(const std::unordered_map<const VarNode*, std
   }
 }
 
+/*!
+ * \brief The options to build the program of a kernel with, the build-options of its target
+ *  followed by the ones of the build_options pragmas of the kernel.
+ */
+static std::string GetKernelBuildOptions(const PrimFunc& f, const Target& target) {
+  std::vector<std::string> options;
+  Target kernel_target = f->GetAttr<Target>(tvm::attr::kTarget).value_or(target);
+  for (const String& option :
+       kernel_target->GetAttr<Array<String>>("build-options").value_or(Array<String>())) {
+    options.push_back(option);
+  }
+  if (auto pragma = f->GetAttr<String>(tir::attr::kDeviceBuildOptions)) {
+    options.push_back(pragma.value());
+  }
+  // The read_write images of the textures planned in place need OpenCL C 2.0, the compilers
+  // default to 1.2.
+  bool has_texture = std::any_of(f->params.begin(), f->params.end(), [](const tir::Var& v) {
+    return v->type_annotation.as<TextureTypeNode>() != nullptr;
+  });
+  bool has_std = std::any_of(options.begin(), options.end(), [](const std::string& option) {
+    return option.find("-cl-std=") != std::string::npos;
+  });
+  if (has_texture && !has_std &&
+      kernel_target->GetAttr<Bool>("texture_inplace", Bool(false)).value()) {
+    options.push_back("-cl-std=CL2.0");
+  }
+  // The pragmas of the loops inside the kernel, not consumed by SplitHostDevice.
+  tir::PostOrderVisit(f->body, [&options](const ObjectRef& n) {
+    if (const auto* attr = n.as<tir::AttrStmtNode>()) {
+      if (attr->attr_key == tir::attr::pragma_build_options) {
+        if (const auto* value = attr->value.as<tir::StringImmNode>()) {
+          options.push_back(value->value);
+        }
+      }
+    }
+  });
+  std::ostringstream os;
+  for (size_t i = 0; i < options.size(); ++i) {
+    os << (i == 0 ? "" : " ") << options[i];
+  }
+  return os.str();
+}
+
 runtime::Module BuildOpenCL(IRModule mod, Target target) {
   using tvm::runtime::Registry;
   bool output_ssa = false;
@@ -489,6 +902,10 @@ runtime::Module BuildOpenCL(IRModule mod, Target target) {
     CodeGenOpenCL cg;
     cg.Init(output_ssa);
     auto f = Downcast<PrimFunc>(kv.second);
+    std::string build_options = GetKernelBuildOptions(f, target);
+    if (!build_options.empty()) {
+      code << runtime::kOpenCLBuildOptionsPrefix << build_options << std::endl;
+    }
     auto calling_conv = f->GetAttr<Integer>(tvm::attr::kCallingConv);
     ICHECK(calling_conv == CallingConv::kDeviceKernelLaunch)
         << "CodeGenOpenCL: expect calling_conv equals CallingConv::kDeviceKernelLaunch";
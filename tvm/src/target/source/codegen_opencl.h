@@ -43,6 +43,7 @@ class CodeGenOpenCL final : public CodeGenC {
   void PrintFuncPrefix() final;                                              // NOLINT(*)
   void BindThreadIndex(const IterVar& iv) final;                             // NOLINT(*)
   void PrintStorageScope(const std::string& scope, std::ostream& os) final;  // NOLINT(*)
+  void PrintParamType(const Var& v, std::ostream& os) final;                 // NOLINT(*)
   void PrintStorageSync(const CallNode* op) final;                           // NOLINT(*)
   void PrintType(DataType t, std::ostream& os) final;                        // NOLINT(*)
   void PrintType(const Type& type, std::ostream& os) final;                  // NOLINT(*)
@@ -63,6 +64,7 @@ class CodeGenOpenCL final : public CodeGenC {
   void VisitExpr_(const CallNode* op, std::ostream& os) final;       // NOLINT(*)
   void VisitExpr_(const CastNode* op, std::ostream& os) final;       // NOLINT(*)
   void VisitExpr_(const FloatImmNode* op, std::ostream& os) final;   // NOLINT(*)
+  void VisitExpr_(const ShuffleNode* op, std::ostream& os) final;    // NOLINT(*)
   void VisitStmt_(const StoreNode* op) final;                        // NOLINT(*)
 
   // overload min and max to avoid ambiguous call errors
@@ -71,11 +73,35 @@ class CodeGenOpenCL final : public CodeGenC {
 
 
  private:
+  // The swizzle selecting the channels of a texel read
+  std::string TexelSwizzle(const RampNode* channels);
+  // The sampler of a texture read with the given TextureSamplerFlag combination
+  std::string PrintSampler(int flags);
+  // Print the coordinates of a texture load or store, the layer of image arrays included
+  void PrintTexelCoord(const CallNode* op, std::ostream& os);  // NOLINT(*)
+
   // whether enable fp16 and fp64 extension
   bool enable_fp16_{false};
   bool enable_fp64_{false};
   // Whether to enable atomics extension.
   bool enable_atomics_{false};
+  // Whether to enable sub-group extensions.
+  bool enable_sub_groups_{false};
+  // Whether threadIdx.x is bound to the sub-group local id of the current function.
+  bool bind_sub_group_local_id_{false};
+  // Whether the 2-D textures of the current kernel are read_write images, as the graph
+  // planner may bind one image to an input and the output with texture_inplace.
+  bool texture_read_write_{false};
+  // Whether a kernel declares read_write images.
+  bool enable_read_write_images_{false};
+  // Whether a kernel requires the sub-group size its sub-group functions were lowered for.
+  bool enable_reqd_sub_group_size_{false};
+  // Whether to enable integer dot product extensions.
+  bool enable_dot_product_{false};
+  // The attributes of the current kernel, e.g. its required work-group size.
+  std::string func_attributes_;
+  // The threadIdx.x extent of the current kernel when it runs with any local size, else 0.
+  int64_t any_local_size_extent_{0};
   bool need_texture_ssa_{true};
   std::unordered_map<const Object*, int32_t> allocation_size_;
 };
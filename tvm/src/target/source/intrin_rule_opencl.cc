@@ -22,6 +22,9 @@
  * \brief OpenCL intrinsic rules.
  */
 #include <tvm/arith/analyzer.h>
+#include <tvm/tir/op.h>
+
+#include <string>
 
 #include "../intrin_rule.h"
 
@@ -69,21 +72,140 @@ TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.cos").set_body(DispatchPureExtern<Di
 
 TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.cosh").set_body(DispatchPureExtern<Direct>);
 
-// There is no warp shuffle instruction in standard OpenCL
-// When shuffle is used, we assume it is intel's shuffle extension
-static void DispatchIntelShuffle(const TVMArgs& args, TVMRetValue* rv) {
+// The fast-math target option lowers the ops below to the native_* builtins, which run on the
+// special function units of mobile GPUs with an implementation defined accuracy. They are only
+// allowed for the float32 ops that stay accurate over their whole domain, other dtypes fall back
+// to the rules above. native_sin, native_cos, native_tan and native_powr are left out as their
+// error grows far out of [-pi, pi] or with the exponent, and the half_* builtins as they only
+// keep about 11 bits.
+struct NativeFloat32 {
+  std::string operator()(DataType t, std::string name) const {
+    if (t.is_float() && t.bits() == 32) {
+      return "native_" + name;
+    }
+    return "";
+  }
+};
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.exp")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.exp2")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.exp10")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.log")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.log2")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.log10")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.sqrt")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.rsqrt")
+    .set_body(DispatchPureExtern<NativeFloat32>);
+
+// Float32 divisions, native_recip for the reciprocals as in sigmoid and native_divide otherwise
+static void DispatchNativeDivide(const TVMArgs& args, TVMRetValue* rv) {
+  PrimExpr e = args[0];
+  const DivNode* div = e.as<DivNode>();
+  ICHECK(div != nullptr);
+  if (!div->dtype.is_float() || div->dtype.bits() != 32) {
+    *rv = e;
+    return;
+  }
+  PrimExpr a = div->a;
+  if (const auto* bcast = a.as<BroadcastNode>()) a = bcast->value;
+  const auto* one = a.as<FloatImmNode>();
+  if (one != nullptr && one->value == 1.0) {
+    *rv = Call(div->dtype, builtin::call_pure_extern(), {StringImm("native_recip"), div->b});
+  } else {
+    *rv = Call(div->dtype, builtin::call_pure_extern(),
+               {StringImm("native_divide"), div->a, div->b});
+  }
+}
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.fast_math.divide").set_body(DispatchNativeDivide);
+
+// OpenCL exposes warp shuffles through sub-group extensions. The shuffles are lowered to the
+// tvm_sub_group_* helpers, which CodeGenOpenCL maps to the cl_khr_subgroup_shuffle*,
+// cl_qcom_subgroup_shuffle or cl_intel_subgroups builtins reported by the device.
+static const char* SubGroupShuffleName(const Op& op) {
+  if (op.same_as(builtin::tvm_warp_shuffle())) {
+    return "tvm_sub_group_shuffle";
+  } else if (op.same_as(builtin::tvm_warp_shuffle_up())) {
+    return "tvm_sub_group_shuffle_up";
+  } else {
+    ICHECK(op.same_as(builtin::tvm_warp_shuffle_down()));
+    return "tvm_sub_group_shuffle_down";
+  }
+}
+
+static void DispatchSubGroupShuffle(const TVMArgs& args, TVMRetValue* rv) {
   PrimExpr e = args[0];
   const CallNode* call = e.as<CallNode>();
   ICHECK(call != nullptr);
   ICHECK_EQ(call->args.size(), 5);  // mask, value, warp_id, width, warp_size
+  Op op = Downcast<Op>(call->op);
+  PrimExpr lane = call->args[2];
   arith::Analyzer analyzer;
-  ICHECK(analyzer.CanProve(call->args[3] == call->args[4]))
-      << "Intel warp shuffle dose not support width != warp_size";
-  Array<PrimExpr> opencl_args{{StringImm("intel_sub_group_shuffle"), call->args[1], call->args[2]}};
+  if (!analyzer.CanProve(call->args[3] == call->args[4])) {
+    // Sub-group shuffles always span the whole sub-group, shuffles within a narrower width
+    // are only supported with explicit source lanes.
+    ICHECK(op.same_as(builtin::tvm_warp_shuffle()))
+        << "OpenCL relative sub-group shuffles do not support width != warp_size";
+    PrimExpr local_id = Call(DataType::Int(32), builtin::call_pure_extern(),
+                             {StringImm("get_sub_group_local_id")});
+    PrimExpr width = call->args[3];
+    lane = analyzer.Simplify(floordiv(local_id, width) * width + lane);
+  }
+  // A constant source lane is uniform, which only needs the core sub-group broadcast
+  std::string name = op.same_as(builtin::tvm_warp_shuffle()) && lane.as<IntImmNode>()
+                         ? "sub_group_broadcast"
+                         : SubGroupShuffleName(op);
+  Array<PrimExpr> opencl_args{{StringImm(name), call->args[1], lane}};
+  *rv = Call(call->dtype, builtin::call_pure_extern(), opencl_args);
+}
+
+// All the work-items of a sub-group are active when they reach a sub-group function
+static void DispatchSubGroupActiveMask(const TVMArgs& args, TVMRetValue* rv) {
+  Call call = args[0];
+  *rv = make_const(call->dtype, 0xFFFFFFFF);
+}
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.tvm_warp_shuffle").set_body(DispatchSubGroupShuffle);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.tvm_warp_shuffle_up")
+    .set_body(DispatchSubGroupShuffle);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.tvm_warp_shuffle_down")
+    .set_body(DispatchSubGroupShuffle);
+
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.tvm_warp_activemask")
+    .set_body(DispatchSubGroupActiveMask);
+
+// The 4-way int8 dot products are lowered to the tvm_dp4a helper, which CodeGenOpenCL maps to
+// the cl_khr_integer_dot_product or cl_arm_integer_dot_product builtins reported by the device.
+static void DispatchDot4(const TVMArgs& args, TVMRetValue* rv) {
+  PrimExpr e = args[0];
+  const CallNode* call = e.as<CallNode>();
+  ICHECK(call != nullptr);
+  ICHECK_EQ(call->args.size(), 3);
+  ICHECK(call->args[0].dtype() == DataType::Int(8, 4) &&
+         call->args[1].dtype() == DataType::Int(8, 4))
+      << "dp4a expects int8x4 operands, got " << call->args[0].dtype() << " and "
+      << call->args[1].dtype();
+  Array<PrimExpr> opencl_args{{StringImm("tvm_dp4a"), call->args[0], call->args[1], call->args[2]}};
   *rv = Call(call->dtype, builtin::call_pure_extern(), opencl_args);
 }
 
-TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.tvm_warp_shuffle").set_body(DispatchIntelShuffle);
+TVM_REGISTER_GLOBAL("tvm.intrin.rule.opencl.dp4a").set_body(DispatchDot4);
 
 }  // namespace intrin
 }  // namespace codegen
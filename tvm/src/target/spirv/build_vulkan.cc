@@ -92,6 +92,7 @@ runtime::Module BuildSPIRV(IRModule mod, Target target, bool webgpu_restriction)
     VulkanShader shader;
     std::string entry = webgpu_restriction ? "main" : f_name;
     shader.data = cg.BuildFunction(f, entry);
+    shader.flag = cg.image_args();
 
     if (webgpu_restriction) {
       for (auto param : f->params) {
@@ -29,20 +29,53 @@
 #include <tvm/tir/op.h>
 
 #include <string>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
 
 namespace tvm {
 namespace codegen {
 
+// The texture arguments accessed as image arrays.
+static std::unordered_set<const VarNode*> FindTextureArrays(const Stmt& body) {
+  std::unordered_set<const VarNode*> arrays;
+  PostOrderVisit(body, [&arrays](const ObjectRef& node) {
+    const auto* call = node.as<CallNode>();
+    if (call != nullptr && (call->op.same_as(builtin::texture2d_array_load()) ||
+                            call->op.same_as(builtin::texture2d_array_store()))) {
+      arrays.insert(call->args[0].as<VarNode>());
+    }
+  });
+  return arrays;
+}
+
 std::vector<uint32_t> CodeGenSPIRV::BuildFunction(const PrimFunc& f, const std::string& name) {
   this->InitFuncState();
   ICHECK(f->HasNonzeroAttr(tir::attr::kNoAlias)) << "SPIRV only takes restricted memory model";
   std::vector<Var> pod_args;
   uint32_t num_buffer = 0;
+  std::unordered_set<const VarNode*> texture_arrays = FindTextureArrays(f->body);
 
   for (Var arg : f->params) {
     DataType t = arg.dtype();
     if (t.is_handle()) {
-      if (auto* ptr = arg->type_annotation.as<PointerTypeNode>()) {
+      if (auto* texture = arg->type_annotation.as<TextureTypeNode>()) {
+        // Textures are bound as storage images of 32 bit components, narrower element
+        // types are converted on every access.
+        auto* prim = texture->element_type.as<PrimTypeNode>();
+        ICHECK(prim);
+        DataType elem = prim->dtype;
+        ICHECK((elem.is_float() || elem.is_int() || elem.is_uint()) && elem.bits() <= 32)
+            << "Unsupported texture element type " << elem << ", only float, half and up to "
+            << "32 bit integers are supported by SPIR-V storage images";
+        DataType texel = elem.with_bits(32).with_lanes(4);
+        spirv::SType image_type = builder_->GetImageType(builder_->GetSType(texel.element_of()),
+                                                         texture_arrays.count(arg.get()) != 0);
+        var_map_[arg.get()] = builder_->ImageArgument(image_type, 0, num_buffer);
+        texel_type_[arg.get()] = texel;
+        ICHECK_LT(num_buffer, 32U) << "Textures must be among the first 32 buffer arguments";
+        image_args_ |= 1U << num_buffer;
+      } else if (auto* ptr = arg->type_annotation.as<PointerTypeNode>()) {
         auto* prim = ptr->element_type.as<PrimTypeNode>();
         ICHECK(prim);
         DataType value_storage_type = prim->dtype;
@@ -92,6 +125,8 @@ void CodeGenSPIRV::InitFuncState() {
   std::fill(workgroup_size_, workgroup_size_ + 3, 1);
   var_map_.clear();
   storage_info_.clear();
+  texel_type_.clear();
+  image_args_ = 0;
   analyzer_.reset(new arith::Analyzer());
   builder_.reset(new spirv::IRBuilder());
   builder_->InitHeader();
@@ -327,12 +362,102 @@ spirv::Value CodeGenSPIRV::VisitExpr_(const CallNode* op) {
   } else if (op->op.same_as(builtin::popcount())) {
     return builder_->MakeValue(spv::OpBitCount, builder_->GetSType(op->dtype),
                                MakeValue(op->args[0]));
+  } else if (op->op.same_as(builtin::texture2d_load()) ||
+             op->op.same_as(builtin::texture2d_array_load())) {
+    return TextureLoad(op);
+  } else if (op->op.same_as(builtin::texture2d_store()) ||
+             op->op.same_as(builtin::texture2d_array_store())) {
+    TextureStore(op);
+    return spirv::Value();
   } else {
     LOG(FATAL) << "Unresolved call  " << op->op;
     return spirv::Value();
   }
 }
 
+std::pair<spirv::Value, spirv::Value> CodeGenSPIRV::TextureAccess(const CallNode* op) {
+  const VarNode* texture = op->args[0].as<VarNode>();
+  ICHECK(texture != nullptr && texel_type_.count(texture))
+      << "Texture builtins only access the texture arguments of the kernel";
+  spirv::Value ptr = var_map_.at(texture);
+  spirv::SType image_type;
+  image_type.id = ptr.stype.element_type_id;
+  image_type.type = DataType::Handle();
+  spirv::Value image = builder_->MakeValue(spv::OpLoad, image_type, ptr);
+  // The arguments are the texture, the coordinates and the channel or the value to store,
+  // image arrays take the layer as third coordinate.
+  std::vector<spirv::Value> coord;
+  spirv::SType t_int32 = builder_->GetSType(DataType::Int(32));
+  for (size_t i = 1; i + 1 < op->args.size(); ++i) {
+    coord.push_back(builder_->Cast(t_int32, MakeValue(op->args[i])));
+  }
+  return {image, builder_->Concat(coord)};
+}
+
+spirv::Value CodeGenSPIRV::TextureLoad(const CallNode* op) {
+  builder_->AddCapability(spv::CapabilityStorageImageReadWithoutFormat);
+  spirv::Value image, coord;
+  std::tie(image, coord) = TextureAccess(op);
+  DataType texel_type = texel_type_.at(op->args[0].as<VarNode>());
+  spirv::Value texel =
+      builder_->MakeValue(spv::OpImageRead, builder_->GetSType(texel_type), image, coord);
+  // Select the channels of the texel, partial texels need a constant first channel, e.g. the
+  // RG textures accessed two channels at a time.
+  spirv::SType comp_type = builder_->GetSType(texel_type.element_of());
+  const PrimExpr& channel = op->args.back();
+  spirv::Value value;
+  if (const auto* ramp = channel.as<RampNode>()) {
+    const auto* base = ramp->base.as<IntImmNode>();
+    ICHECK(base && is_one(ramp->stride) && base->value + ramp->lanes <= 4)
+        << "Partial texel reads need a constant first channel, got " << ramp->base;
+    if (ramp->lanes == 4) {
+      value = texel;
+    } else {
+      std::vector<spirv::Value> comps;
+      for (int i = 0; i < ramp->lanes; ++i) {
+        uint32_t index = static_cast<uint32_t>(base->value + i);
+        comps.push_back(builder_->MakeValue(spv::OpCompositeExtract, comp_type, texel, index));
+      }
+      value = builder_->Concat(comps);
+    }
+  } else if (const auto* index = channel.as<IntImmNode>()) {
+    value = builder_->MakeValue(spv::OpCompositeExtract, comp_type, texel,
+                                static_cast<uint32_t>(index->value));
+  } else {
+    value = builder_->MakeValue(spv::OpVectorExtractDynamic, comp_type, texel,
+                                MakeValue(channel));
+  }
+  return builder_->Cast(builder_->GetSType(op->dtype), value);
+}
+
+void CodeGenSPIRV::TextureStore(const CallNode* op) {
+  builder_->AddCapability(spv::CapabilityStorageImageWriteWithoutFormat);
+  spirv::Value image, coord;
+  std::tie(image, coord) = TextureAccess(op);
+  DataType texel_type = texel_type_.at(op->args[0].as<VarNode>());
+  // R and RG textures take the value replicated to a 4 lane vector, only the leading
+  // channels are stored.
+  const PrimExpr& value = op->args.back();
+  int lanes = value.dtype().lanes();
+  ICHECK_EQ(4 % lanes, 0) << "Cannot store " << lanes << " channels to a texel";
+  spirv::Value texel =
+      builder_->Cast(builder_->GetSType(texel_type.with_lanes(lanes)), MakeValue(value));
+  if (lanes < 4) {
+    spirv::SType comp_type = builder_->GetSType(texel_type.element_of());
+    std::vector<spirv::Value> comps;
+    for (int i = 0; i < lanes; ++i) {
+      comps.push_back(lanes == 1 ? texel
+                                 : builder_->MakeValue(spv::OpCompositeExtract, comp_type, texel,
+                                                       static_cast<uint32_t>(i)));
+    }
+    for (int i = lanes; i < 4; ++i) {
+      comps.push_back(comps[i % lanes]);
+    }
+    texel = builder_->Concat(comps);
+  }
+  builder_->MakeInst(spv::OpImageWrite, image, coord, texel);
+}
+
 spirv::Value CodeGenSPIRV::VisitExpr_(const RampNode* op) {
   std::vector<spirv::Value> values;
   spirv::Value base = MakeValue(op->base);
@@ -33,6 +33,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../../runtime/thread_storage_scope.h"
@@ -56,6 +57,11 @@ class CodeGenSPIRV : public ExprFunctor<spirv::Value(const PrimExpr&)>,
    * \return The final spirv module.
    */
   virtual std::vector<uint32_t> BuildFunction(const PrimFunc& f, const std::string& name);
+  /*!
+   * \return The buffer arguments of the last built function bound as storage images,
+   *  bit i is set when the i-th buffer argument is a texture.
+   */
+  uint32_t image_args() const { return image_args_; }
   /*!
    * \brief Create Value for expression e
    * \param e The expression to be created value for.
@@ -130,6 +136,12 @@ class CodeGenSPIRV : public ExprFunctor<spirv::Value(const PrimExpr&)>,
   spirv::Value GetThreadIndex(const IterVar& iv, const PrimExpr& extent);
   spirv::Value CreateStorageSync(const CallNode* op);
   void Scalarize(const PrimExpr& e, std::function<void(int i, spirv::Value v)> f);
+  // Lower texture2d_load and texture2d_array_load to a storage image read
+  spirv::Value TextureLoad(const CallNode* op);
+  // Lower texture2d_store and texture2d_array_store to a storage image write
+  void TextureStore(const CallNode* op);
+  // Get the storage image of a texture argument and the texel coordinate of an access
+  std::pair<spirv::Value, spirv::Value> TextureAccess(const CallNode* op);
   // The builder
   std::unique_ptr<spirv::IRBuilder> builder_;
   // Work group size of three
@@ -140,6 +152,10 @@ class CodeGenSPIRV : public ExprFunctor<spirv::Value(const PrimExpr&)>,
   std::unordered_map<const VarNode*, StorageInfo> storage_info_;
   // The definition of local variable.
   std::unordered_map<const VarNode*, spirv::Value> var_map_;
+  // The texel type of the texture arguments, a 4 lane vector of 32 bit components
+  std::unordered_map<const VarNode*, DataType> texel_type_;
+  // The buffer arguments bound as storage images
+  uint32_t image_args_{0};
   // The analyzer.
   std::unique_ptr<arith::Analyzer> analyzer_;
   // deep comparison of PrimExpr
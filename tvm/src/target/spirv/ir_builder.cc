@@ -47,7 +47,7 @@ void IRBuilder::InitHeader() {
   // Schema: reserved
   header_.push_back(0U);
   // shader
-  ib_.Begin(spv::OpCapability).Add(spv::CapabilityShader).Commit(&header_);
+  this->AddCapability(spv::CapabilityShader);
   // memory model
   ib_.Begin(spv::OpMemoryModel)
       .AddSeq(spv::AddressingModelLogical, spv::MemoryModelGLSL450)
@@ -203,6 +203,39 @@ Value IRBuilder::BufferArgument(const SType& value_type, uint32_t descriptor_set
   return val;
 }
 
+SType IRBuilder::GetImageType(const SType& sampled_type, bool arrayed) {
+  auto key = std::make_pair(sampled_type.id, arrayed);
+  auto it = image_type_tbl_.find(key);
+  if (it != image_type_tbl_.end()) {
+    return it->second;
+  }
+  ICHECK_EQ(sampled_type.type.bits(), 32);
+  ICHECK_EQ(sampled_type.type.lanes(), 1);
+  SType t;
+  t.id = id_counter_++;
+  t.type = DataType::Handle();
+  t.element_type_id = sampled_type.id;
+  // Sampled 2 marks a storage image, the format is left to the bound image view.
+  ib_.Begin(spv::OpTypeImage)
+      .AddSeq(t, sampled_type, spv::Dim2D, 0, arrayed ? 1 : 0, 0, 2, spv::ImageFormatUnknown)
+      .Commit(&global_);
+  image_type_tbl_[key] = t;
+  return t;
+}
+
+Value IRBuilder::ImageArgument(const SType& image_type, uint32_t descriptor_set,
+                               uint32_t binding) {
+  SType ptr_type = GetPointerType(image_type, spv::StorageClassUniformConstant);
+  Value val = NewValue(ptr_type, kImagePtr);
+  ib_.Begin(spv::OpVariable)
+      .AddSeq(ptr_type, val, spv::StorageClassUniformConstant)
+      .Commit(&global_);
+
+  this->Decorate(spv::OpDecorate, val, spv::DecorationDescriptorSet, descriptor_set);
+  this->Decorate(spv::OpDecorate, val, spv::DecorationBinding, binding);
+  return val;
+}
+
 Value IRBuilder::DeclarePushConstant(const std::vector<SType>& value_types) {
   ICHECK_EQ(push_const_.id, 0);
   SType struct_type;
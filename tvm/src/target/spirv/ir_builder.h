@@ -30,6 +30,7 @@
 // clang-format off
 #include <algorithm>
 #include <map>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -58,6 +59,7 @@ enum ValueKind {
   kConstant,
   kVectorPtr,
   kStructArrayPtr,
+  kImagePtr,
   kPushConstantPtr,
   kFunction,
   kExtInst
@@ -278,9 +280,18 @@ class IRBuilder {
    */
   Value ExtInstImport(const std::string& name) {
     Value val = NewValue(SType(), kExtInst);
-    ib_.Begin(spv::OpExtInstImport).AddSeq(val, name).Commit(&header_);
+    ib_.Begin(spv::OpExtInstImport).AddSeq(val, name).Commit(&ext_inst_import_);
     return val;
   }
+  /*!
+   * \brief Declare a capability used by the module, once.
+   * \param cap The capability.
+   */
+  void AddCapability(spv::Capability cap) {
+    if (capabilities_.insert(cap).second) {
+      ib_.Begin(spv::OpCapability).Add(cap).Commit(&header_);
+    }
+  }
   /*!
    * \brief Get the final binary built from the builder
    * \return The finalized binary instruction.
@@ -291,6 +302,7 @@ class IRBuilder {
     const int kBoundLoc = 3;
     header_[kBoundLoc] = id_counter_;
     data.insert(data.end(), header_.begin(), header_.end());
+    data.insert(data.end(), ext_inst_import_.begin(), ext_inst_import_.end());
     data.insert(data.end(), entry_.begin(), entry_.end());
     data.insert(data.end(), exec_mode_.begin(), exec_mode_.end());
     data.insert(data.end(), debug_.begin(), debug_.end());
@@ -473,6 +485,22 @@ class IRBuilder {
    * \param The argument type.
    */
   Value BufferArgument(const SType& value_type, uint32_t descriptor_set, uint32_t binding);
+  /*!
+   * \brief Get the type of a 2d storage image without a declared format.
+   * \param sampled_type The scalar type of the texel components, 32 bit float or integer.
+   * \param arrayed Whether it is an image array.
+   * \return The image type.
+   */
+  SType GetImageType(const SType& sampled_type, bool arrayed);
+  /*!
+   * \brief Declare storage image argument of function
+   *
+   * \param image_type The type of the image.
+   * \param descriptor_set The descriptor set we want to use.
+   * \param binding The binding locaiton in descriptor set.
+   * \return The pointer to the image, to be loaded before every access.
+   */
+  Value ImageArgument(const SType& image_type, uint32_t descriptor_set, uint32_t binding);
   /*!
    * \brief Declare POD arguments through push constants.
    *
@@ -581,10 +609,16 @@ class IRBuilder {
   std::map<std::pair<uint32_t, uint32_t>, SType> struct_array_type_tbl_;
   /*! \brief map from value to its pointer type */
   std::map<std::pair<uint32_t, spv::StorageClass>, SType> pointer_type_tbl_;
+  /*! \brief map from sampled type and arrayed flag to the image type */
+  std::map<std::pair<uint32_t, bool>, SType> image_type_tbl_;
+  /*! \brief The declared capabilities */
+  std::set<spv::Capability> capabilities_;
   /*! \brief map from constant int to its value */
   std::map<std::pair<uint32_t, uint64_t>, Value> const_tbl_;
-  /*! \brief Header segment, include import */
+  /*! \brief Header segment, include capabilities */
   std::vector<uint32_t> header_;
+  /*! \brief Extended instruction set import segment */
+  std::vector<uint32_t> ext_inst_import_;
   /*! \brief engtry point segment */
   std::vector<uint32_t> entry_;
   /*! \brief Header segment */
@@ -224,6 +224,8 @@ TVM_REGISTER_TARGET_KIND("llvm", kDLCPU)
 TVM_REGISTER_TARGET_KIND("c", kDLCPU)
     .add_attr_option<Bool>("system-lib")
     .add_attr_option<Bool>("link-params", Bool(false))
+    .add_attr_option<Bool>("link-storage", Bool(false))
+    .add_attr_option<String>("executor", String("graph"))
     .add_attr_option<String>("runtime")
     .add_attr_option<String>("mcpu")
     .add_attr_option<String>("march")
@@ -238,6 +240,8 @@ TVM_REGISTER_TARGET_KIND("cuda", kDLGPU)
     .add_attr_option<Integer>("shared_memory_per_block")
     .add_attr_option<Integer>("registers_per_block")
     .add_attr_option<Integer>("max_threads_per_block")
+    .add_attr_option<Integer>("shared_memory_banks", Integer(32))
+    .add_attr_option<Integer>("shared_memory_bank_bytes", Integer(4))
     .set_default_keys({"cuda", "gpu"});
 
 TVM_REGISTER_TARGET_KIND("nvptx", kDLGPU)
@@ -262,6 +266,17 @@ TVM_REGISTER_TARGET_KIND("opencl", kDLOpenCL)
     .add_attr_option<Bool>("system-lib")
     .add_attr_option<Integer>("max_num_threads", Integer(256))
     .add_attr_option<Integer>("thread_warp_size")
+    .add_attr_option<Integer>("shared_memory_banks", Integer(32))
+    .add_attr_option<Integer>("shared_memory_bank_bytes", Integer(4))
+    .add_attr_option<Integer>("texture_spatial_limit", Integer(16384))
+    .add_attr_option<Integer>("texture_array_limit", Integer(2048))
+    .add_attr_option<Bool>("texture_inplace", Bool(false))
+    .add_attr_option<Bool>("texture_concat", Bool(false))
+    .add_attr_option<Bool>("local_size_search", Bool(false))
+    .add_attr_option<Bool>("texture_features", Bool(false))
+    .add_attr_option<Integer>("index_bits", Integer(64))
+    .add_attr_option<Bool>("fast-math", Bool(false))
+    .add_attr_option<Array<String>>("build-options")
     .set_default_keys({"opencl", "gpu"});
 
 TVM_REGISTER_TARGET_KIND("metal", kDLMetal)
@@ -272,6 +287,7 @@ TVM_REGISTER_TARGET_KIND("metal", kDLMetal)
 TVM_REGISTER_TARGET_KIND("vulkan", kDLVulkan)
     .add_attr_option<Bool>("system-lib")
     .add_attr_option<Integer>("max_num_threads", Integer(256))
+    .add_attr_option<Integer>("index_bits", Integer(64))
     .set_default_keys({"vulkan", "gpu"});
 
 TVM_REGISTER_TARGET_KIND("webgpu", kDLWebGPU)
@@ -24,9 +24,11 @@
 #include <tvm/runtime/registry.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule_pass.h>
+#include <tvm/tir/stmt_functor.h>
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "../../runtime/thread_storage_scope.h"
 #include "graph.h"
@@ -49,8 +51,65 @@ struct GraphContext {
   std::unordered_map<IterVar, IterVar> bind_map;
   /*! \brief map from op to stage */
   std::unordered_map<const Object*, Stage> op2stage_;
+  /*! \brief The variables of the body of every compute op, filled on demand */
+  std::unordered_map<const Object*, std::vector<const VarNode*>> compute_body_vars;
 };
 
+/*!
+ * \brief Collect the variables whose bounds can matter when inferring the consumer domain of a
+ *  compute op: the variables of its body and of its stage, of the attach path and of their
+ *  thread bindings, and transitively the variables in the ranges of those in rmap.
+ *
+ *  The analyzer of a consumer only sees expressions over these variables, so binding the
+ *  others does not change its results, but binding all of rmap for every consumer of every
+ *  stage costs time quadratic in the number of iteration variables of the schedule.
+ */
+std::unordered_set<const VarNode*> ConsumerBoundVars(
+    const ComputeOpNode* op, const Stage& op_stage, GraphContext* ctx,
+    const std::unordered_map<const VarNode*, Range>& var_range) {
+  auto it = ctx->compute_body_vars.find(op);
+  if (it == ctx->compute_body_vars.end()) {
+    std::unordered_set<const VarNode*> vars;
+    for (const PrimExpr& e : op->body) {
+      tir::PostOrderVisit(e, [&vars](const ObjectRef& n) {
+        if (const auto* v = n.as<VarNode>()) vars.insert(v);
+      });
+    }
+    it = ctx->compute_body_vars.emplace(op, std::vector<const VarNode*>(vars.begin(), vars.end()))
+             .first;
+  }
+  std::unordered_set<const VarNode*> ret;
+  std::vector<const VarNode*> stack(it->second.begin(), it->second.end());
+  auto push_iter_var = [&stack, ctx](const IterVar& iv) {
+    stack.push_back(iv->var.get());
+    auto bit = ctx->bind_map.find(iv);
+    if (bit != ctx->bind_map.end()) stack.push_back(bit->second->var.get());
+  };
+  for (const IterVar& iv : op->root_iter_vars()) push_iter_var(iv);
+  for (const IterVar& iv : op_stage->all_iter_vars) push_iter_var(iv);
+  for (const IterVar& iv : ctx->attach_path.at(GetRef<Operation>(op))) push_iter_var(iv);
+  auto push_expr = [&stack](const PrimExpr& e) {
+    tir::PostOrderVisit(e, [&stack](const ObjectRef& n) {
+      if (const auto* v = n.as<VarNode>()) stack.push_back(v);
+    });
+  };
+  for (const IterVar& iv : op->root_iter_vars()) {
+    push_expr(iv->dom->min);
+    push_expr(iv->dom->extent);
+  }
+  while (!stack.empty()) {
+    const VarNode* v = stack.back();
+    stack.pop_back();
+    if (!ret.insert(v).second) continue;
+    auto rit = var_range.find(v);
+    if (rit != var_range.end()) {
+      push_expr(rit->second->min);
+      push_expr(rit->second->extent);
+    }
+  }
+  return ret;
+}
+
 bool NeedRelax(const IterVar& iv, bool found_attach,
                const std::unordered_map<IterVar, IterVar>& bind_map,
                const runtime::StorageScope& scope) {
@@ -87,8 +146,9 @@ StorageScope InferStorageScope(const Stage& stage, const GraphContext& ctx) {
   return s;
 }
 
-void InferRootBound(const Stage& stage, const GraphContext& ctx,
+void InferRootBound(const Stage& stage, GraphContext* ctx_ptr,
                     std::unordered_map<IterVar, Range>* rmap) {
+  const GraphContext& ctx = *ctx_ptr;
   ICHECK_NE(stage->attach_type, kInline) << "call schedule.normalize before scheduleops";
   if (stage->attach_type == kInlinedAlready) return;
   if (stage->is_output) {
@@ -127,6 +187,11 @@ void InferRootBound(const Stage& stage, const GraphContext& ctx,
   //   - For thread index, use the thread scope.
   //
   Array<IterVar> stage_attach = ctx.attach_path.at(stage->op);
+  // The range of the variable of every iter var, rmap is not changed by the consumers.
+  std::unordered_map<const VarNode*, Range> var_range;
+  for (const auto& entry : *rmap) {
+    var_range.emplace(entry.first->var.get(), entry.second);
+  }
   // The parent set.
   for (const Operation& op : consumers) {
     Map<Var, IntSet> relax_set;
@@ -180,8 +245,18 @@ void InferRootBound(const Stage& stage, const GraphContext& ctx,
     // Relax if needed.
     std::unordered_map<const VarNode*, IntSet> dom_map;
     arith::Analyzer analyzer;
-    for (auto entry : *rmap) {
-      analyzer.Bind(entry.first->var, entry.second);
+    if (const auto* compute = op.as<ComputeOpNode>()) {
+      std::unordered_set<const VarNode*> vars =
+          ConsumerBoundVars(compute, op_stage, ctx_ptr, var_range);
+      for (auto entry : *rmap) {
+        if (vars.count(entry.first->var.get())) {
+          analyzer.Bind(entry.first->var, entry.second);
+        }
+      }
+    } else {
+      for (auto entry : *rmap) {
+        analyzer.Bind(entry.first->var, entry.second);
+      }
     }
     for (auto iv : op->root_iter_vars()) {
       Range r;
@@ -229,7 +304,7 @@ Map<IterVar, Range> InferBound(const Schedule& sch) {
   std::unordered_map<IterVar, Range> ret;
   for (size_t i = sch->stages.size(); i != 0; --i) {
     const Stage& stage = sch->stages[i - 1];
-    InferRootBound(stage, ctx, &ret);
+    InferRootBound(stage, &ctx, &ret);
 
     // bind bound of root iter vars.
     for (auto iv : stage->op->root_iter_vars()) {
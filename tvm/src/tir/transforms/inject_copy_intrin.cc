@@ -24,6 +24,7 @@
 #include <tvm/arith/analyzer.h>
 #include <tvm/arith/pattern.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/tir/builtin.h>
 #include <tvm/tir/expr.h>
 #include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
@@ -194,6 +195,62 @@ Pass InjectCopyIntrin(String pragma_key, PackedFunc flower_copy_fromto) {
 
 TVM_REGISTER_GLOBAL("tir.transform.InjectCopyIntrin").set_body_typed(InjectCopyIntrin);
 
+/*!
+ * \brief Lower a copy between DDR and VTCM to row copies of the device runtime, one
+ *  TVMBackendHexagonDMACopy2D call for the two innermost dimensions and loops for the others.
+ */
+static Stmt LowerVTCMCopy(Buffer src, Buffer dst, Array<PrimExpr> pad_before,
+                          Array<PrimExpr> pad_after, PrimExpr pad_value) {
+  for (const PrimExpr& pad : pad_before) {
+    ICHECK(is_zero(pad)) << "VTCM copies cannot pad";
+  }
+  for (const PrimExpr& pad : pad_after) {
+    ICHECK(is_zero(pad)) << "VTCM copies cannot pad";
+  }
+  ICHECK(src->dtype == dst->dtype) << "VTCM copies cannot cast, " << src->dtype << " to "
+                                   << dst->dtype;
+  size_t ndim = src->shape.size();
+  ICHECK(is_one(src->strides[ndim - 1]) && is_one(dst->strides[ndim - 1]))
+      << "VTCM copies need contiguous rows";
+  DataType idx = src->shape[0].dtype();
+  PrimExpr elem_bytes = make_const(idx, src->dtype.bytes() * src->dtype.lanes());
+  PrimExpr one = make_const(idx, 1);
+  PrimExpr height = ndim > 1 ? src->shape[ndim - 2] : one;
+  PrimExpr src_stride = ndim > 1 ? src->strides[ndim - 2] : one;
+  PrimExpr dst_stride = ndim > 1 ? dst->strides[ndim - 2] : one;
+  PrimExpr src_offset = make_zero(idx), dst_offset = make_zero(idx);
+  std::vector<Var> outer;
+  for (size_t i = 0; i + 2 < ndim; ++i) {
+    Var v("i" + std::to_string(i), idx);
+    src_offset = src_offset + v * src->strides[i];
+    dst_offset = dst_offset + v * dst->strides[i];
+    outer.push_back(v);
+  }
+  Stmt body = Evaluate(Call(DataType::Int(32), builtin::call_extern(),
+                            {StringImm("TVMBackendHexagonDMACopy2D"),
+                             dst.access_ptr(2, DataType::Handle(), 1, dst_offset),
+                             src.access_ptr(1, DataType::Handle(), 1, src_offset),
+                             src->shape[ndim - 1] * elem_bytes, height, dst_stride * elem_bytes,
+                             src_stride * elem_bytes}));
+  for (size_t i = outer.size(); i > 0; --i) {
+    body = For(outer[i - 1], make_zero(idx), src->shape[i - 1], ForKind::kSerial, body);
+  }
+  return body;
+}
+
+Pass InjectVTCMCopy() {
+  auto pass_func = [](PrimFunc f, IRModule m, PassContext ctx) {
+    using FLower = Stmt(Buffer, Buffer, Array<PrimExpr>, Array<PrimExpr>, PrimExpr);
+    PackedFunc flower = runtime::TypedPackedFunc<FLower>(LowerVTCMCopy);
+    auto* n = f.CopyOnWrite();
+    n->body = CopyIntrinInjector("vtcm_copy", flower)(std::move(n->body));
+    return f;
+  };
+  return CreatePrimFuncPass(pass_func, 0, "tir.InjectVTCMCopy", {});
+}
+
+TVM_REGISTER_GLOBAL("tir.transform.InjectVTCMCopy").set_body_typed(InjectVTCMCopy);
+
 }  // namespace transform
 
 }  // namespace tir
@@ -22,6 +22,7 @@
  * \file inject_double_buffer.cc
  */
 #include <tvm/runtime/registry.h>
+#include <tvm/tir/builtin.h>
 #include <tvm/tir/op.h>
 #include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
@@ -60,11 +61,28 @@ class DoubleBufferDetector : public StmtExprVisitor {
     }
   }
 
+  void VisitExpr_(const CallNode* op) final {
+    // Texture accesses do not alias the texture
+    if (IsTextureAccess(op)) {
+      for (size_t i = 1; i < op->args.size(); ++i) {
+        this->VisitExpr(op->args[i]);
+      }
+    } else {
+      StmtExprVisitor::VisitExpr_(op);
+    }
+  }
+
   void VisitExpr_(const VarNode* op) final {
     if (touched_.count(op)) {
       touched_.erase(op);
     }
   }
+
+  static bool IsTextureAccess(const CallNode* op) {
+    return (op->op.same_as(builtin::texture2d_load()) ||
+            op->op.same_as(builtin::texture2d_store())) &&
+           op->args[0]->IsInstance<VarNode>();
+  }
   // The set of touched variable.
   std::unordered_set<const VarNode*> touched_;
 };
@@ -135,6 +153,24 @@ class DoubleBufferInjector : public StmtExprMutator {
     }
   }
 
+  Stmt VisitStmt_(const LetStmtNode* op) final {
+    auto it = dbuffer_info_.find(op->var.get());
+    const auto* alloca = op->value.as<CallNode>();
+    if (it == dbuffer_info_.end() || !alloca || !alloca->op.same_as(builtin::texture2d_alloca())) {
+      return StmtExprMutator::VisitStmt_(op);
+    }
+    // The two buffers of a texture are stacked along its height, the coordinates of the rows
+    // of the second one are offset by the height.
+    it->second.stride = alloca->args[1];
+    it->second.texture = true;
+    Stmt body = this->VisitStmt(op->body);
+    ICHECK(it->second.loop != nullptr);
+    Array<PrimExpr> args = {alloca->args[0], alloca->args[1] * 2, alloca->args[2]};
+    loop_allocs_[it->second.loop].emplace_back(
+        LetStmt(op->var, Call(alloca->dtype, alloca->op, args), Evaluate(0)));
+    return body;
+  }
+
   Stmt VisitStmt_(const ForNode* op) final {
     loop_nest_.push_back(op);
     Stmt stmt = StmtExprMutator::VisitStmt_(op);
@@ -209,6 +245,30 @@ class DoubleBufferInjector : public StmtExprMutator {
     }
   }
 
+  PrimExpr VisitExpr_(const CallNode* op) final {
+    if (!DoubleBufferDetector::IsTextureAccess(op)) {
+      return StmtExprMutator::VisitExpr_(op);
+    }
+    auto it = dbuffer_info_.find(op->args[0].as<VarNode>());
+    if (it == dbuffer_info_.end()) {
+      return StmtExprMutator::VisitExpr_(op);
+    }
+    const StorageEntry& e = it->second;
+    ICHECK(e.texture && e.stride.defined());
+    Array<PrimExpr> args = op->args;
+    for (size_t i = 1; i < args.size(); ++i) {
+      args.Set(i, this->VisitExpr(args[i]));
+    }
+    if (op->op.same_as(builtin::texture2d_store())) {
+      ICHECK(in_double_buffer_scope_);
+      args.Set(2, e.switch_write_var * e.stride + args[2]);
+    } else {
+      ICHECK(e.switch_read_var.defined());
+      args.Set(2, e.switch_read_var * e.stride + args[2]);
+    }
+    return Call(op->dtype, op->op, args);
+  }
+
   PrimExpr VisitExpr_(const VarNode* op) final {
     ICHECK(!dbuffer_info_.count(op));
     return GetRef<PrimExpr>(op);
@@ -257,6 +317,8 @@ class DoubleBufferInjector : public StmtExprMutator {
     PrimExpr switch_read_var;
     // The storage scope.
     std::string scope;
+    // Whether the buffer is a texture, whose stride is its height.
+    bool texture{false};
   };
   // Whether split loop
   int32_t split_loop_;
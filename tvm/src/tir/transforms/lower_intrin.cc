@@ -40,9 +40,15 @@ class IntrinInjecter : public tvm::arith::IRMutatorWithAnalyzer {
   using IRMutatorWithAnalyzer::VisitExpr_;
   using IRMutatorWithAnalyzer::VisitStmt_;
 
-  IntrinInjecter(arith::Analyzer* analyzer, std::string target, std::string mtriple = "")
+  IntrinInjecter(arith::Analyzer* analyzer, std::string target, std::string mtriple = "",
+                 bool fast_math = false)
       : IRMutatorWithAnalyzer(analyzer) {
+    // The fast math rules take precedence, and fall back to the others for the dtypes they skip
+    if (fast_math) {
+      patterns_.push_back("tvm.intrin.rule." + target + ".fast_math.");
+    }
     patterns_.push_back("tvm.intrin.rule." + target + ".");
+    fma_ = runtime::Registry::Get(patterns_.back() + "fma");
 
     bool is_llvm_aarch64 = (mtriple.find("aarch64") != std::string::npos);
     if (is_llvm_aarch64) {
@@ -50,7 +56,6 @@ class IntrinInjecter : public tvm::arith::IRMutatorWithAnalyzer {
     }
 
     patterns_.push_back("tvm.intrin.rule.default.");
-    fma_ = runtime::Registry::Get(patterns_[0] + "fma");
     if (target == "stackvm") {
       support_bitwise_op_ = false;
     }
@@ -77,6 +82,14 @@ class IntrinInjecter : public tvm::arith::IRMutatorWithAnalyzer {
     return IRMutatorWithAnalyzer::VisitExpr_(op);
   }
 
+  // Float divisions are dispatched as a "divide" intrinsic, which only fast math rules define
+  PrimExpr VisitExpr_(const DivNode* op) final {
+    PrimExpr ret = IRMutatorWithAnalyzer::VisitExpr_(op);
+    if (!ret.dtype().is_float() || ret.as<DivNode>() == nullptr) return ret;
+    PrimExpr r = ApplyPattern("divide", ret);
+    return r.defined() ? r : ret;
+  }
+
   // We use floordiv for integer analysis,
   // but will need to lower them to native truncdiv instructions
   PrimExpr VisitExpr_(const FloorDivNode* op) final {
@@ -310,8 +323,9 @@ Pass LowerIntrin() {
     ICHECK(target.defined()) << "LowerIntrin: Require the target attribute";
     arith::Analyzer analyzer;
     auto mtriple = target.value()->GetAttr<runtime::String>("mtriple", "");
-    n->body =
-        IntrinInjecter(&analyzer, target.value()->kind->name, mtriple.value())(std::move(n->body));
+    bool fast_math = target.value()->GetAttr<Bool>("fast-math", Bool(false)).value();
+    n->body = IntrinInjecter(&analyzer, target.value()->kind->name, mtriple.value(),
+                             fast_math)(std::move(n->body));
     return f;
   };
   return CreatePrimFuncPass(pass_func, 0, "tir.LowerIntrin", {});
@@ -29,6 +29,7 @@
 #include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
 
+#include <string>
 #include <unordered_set>
 
 #include "../../runtime/thread_storage_scope.h"
@@ -223,10 +224,20 @@ class ThreadAllreduceBuilder final : public StmtExprMutator {
       // relying on a pattern match pass to fix it later.
       PrimExpr index(0);
 
+      // OpenCL sub-groups reduce the common combiners with a single builtin, whose result is
+      // uniform across the sub-group. No shuffle and no broadcast is needed then.
+      std::string sub_group_reduce = SubGroupReduceName(combiner, types);
+
       for (size_t idx = 0; idx < size; ++idx) {
         Type ptr_type = PointerType(PrimType(types[idx]));
         shared_bufs[idx] = Var("red_buf" + std::to_string(idx), ptr_type);
         PrimExpr pred = const_true(types[idx].lanes());
+        if (!sub_group_reduce.empty()) {
+          PrimExpr reduced = Call(types[idx], builtin::call_pure_extern(),
+                                  {StringImm(sub_group_reduce), values[idx]});
+          seq.emplace_back(Store(shared_bufs[idx], reduced, index, pred));
+          continue;
+        }
         seq.emplace_back(Store(shared_bufs[idx], values[idx], index, pred));
 
         // Uses a local variable to store the shuffled data.
@@ -236,77 +247,80 @@ class ThreadAllreduceBuilder final : public StmtExprMutator {
         local_vars.push_back(s);
       }
 
-      // The mask for this reducer, as this reducer may sit inside
-      // a divergent control flow. Here it uses a variable to cache the current
-      // active channels.
-      //
-      DataType mask_dtype = DataType::UInt(32);
-      Var mask_var("mask", PointerType(PrimType(mask_dtype)));
-      {
-        PrimExpr pred = const_true(1);
-        PrimExpr mask = Call(mask_dtype, builtin::tvm_warp_activemask(), {});
-        seq.emplace_back(Store(mask_var, mask, index, pred));
-        // Push allocation with an empty body. Later this will be fixed
-        // when the entire body is ready.
-        auto stmt = Allocate(mask_var, mask_dtype, {PrimExpr(1)}, pred, Evaluate(0));
-        local_vars.push_back(stmt);
-      }
-
-      // Emit reductions within a warp.
-      for (int offset = warp_size_ / 2; offset > 0; offset /= 2) {
-        // Load reduction values, no synchronization needed.
-        Array<PrimExpr> a, b;
-        for (size_t i = 0; i < size; ++i) {
-          Var var = shared_bufs[i];
-          PrimExpr pred = const_true(types[i].lanes());
-          PrimExpr val = Load(types[i], var, index, pred);
-          a.push_back(val);
-
-          // __shfl_*sync calls shall not appear in if_then_else expressions
-          // as this is causing extra divergency. E.g.
-          //
-          // v1 = (v2 < v3) ? v3 : __shfl_sync(mask, v1, 0);
-          //
-          // behaves differently from
-          //
-          // int t = __shfl_sync(mask, v1, 0);
-          // v1 = (v2 < v3) ? v3 : t;
-          //
-          // The former may cause dead lock as there is a divergent
-          // branch with a warp sync call inside.
-          //
-          PrimExpr other = WarpShuffle(builtin::tvm_warp_shuffle_down(), mask_var, val, offset);
-          const AllocateNode* repl = local_vars[i].as<AllocateNode>();
-          Stmt s = Store(repl->buffer_var, other, index, pred);
-          seq.push_back(s);
-
-          PrimExpr load = Load(types[i], repl->buffer_var, index, pred);
-          b.push_back(load);
+      if (sub_group_reduce.empty()) {
+        // The mask for this reducer, as this reducer may sit inside
+        // a divergent control flow. Here it uses a variable to cache the current
+        // active channels.
+        //
+        DataType mask_dtype = DataType::UInt(32);
+        Var mask_var("mask", PointerType(PrimType(mask_dtype)));
+        {
+          PrimExpr pred = const_true(1);
+          PrimExpr mask = Call(mask_dtype, builtin::tvm_warp_activemask(), {});
+          seq.emplace_back(Store(mask_var, mask, index, pred));
+          // Push allocation with an empty body. Later this will be fixed
+          // when the entire body is ready.
+          auto stmt = Allocate(mask_var, mask_dtype, {PrimExpr(1)}, pred, Evaluate(0));
+          local_vars.push_back(stmt);
         }
 
-        // Do reductions.
-        Array<PrimExpr> ret = (*combiner)(a, b);
+        // Emit reductions within a warp.
+        for (int offset = warp_size_ / 2; offset > 0; offset /= 2) {
+          // Load reduction values, no synchronization needed.
+          Array<PrimExpr> a, b;
+          for (size_t i = 0; i < size; ++i) {
+            Var var = shared_bufs[i];
+            PrimExpr pred = const_true(types[i].lanes());
+            PrimExpr val = Load(types[i], var, index, pred);
+            a.push_back(val);
+
+            // __shfl_*sync calls shall not appear in if_then_else expressions
+            // as this is causing extra divergency. E.g.
+            //
+            // v1 = (v2 < v3) ? v3 : __shfl_sync(mask, v1, 0);
+            //
+            // behaves differently from
+            //
+            // int t = __shfl_sync(mask, v1, 0);
+            // v1 = (v2 < v3) ? v3 : t;
+            //
+            // The former may cause dead lock as there is a divergent
+            // branch with a warp sync call inside.
+            //
+            PrimExpr other =
+                WarpShuffle(builtin::tvm_warp_shuffle_down(), mask_var, val, offset);
+            const AllocateNode* repl = local_vars[i].as<AllocateNode>();
+            Stmt s = Store(repl->buffer_var, other, index, pred);
+            seq.push_back(s);
+
+            PrimExpr load = Load(types[i], repl->buffer_var, index, pred);
+            b.push_back(load);
+          }
+
+          // Do reductions.
+          Array<PrimExpr> ret = (*combiner)(a, b);
+
+          // Store the reduction result to itself.
+          std::vector<Stmt> stores(size);
+          for (size_t i = 0; i < size; ++i) {
+            Var var = shared_bufs[i];
+            PrimExpr pred = const_true(types[i].lanes());
+            stores[i] = Store(var, ret[i], index, pred);
+          }
+          seq.push_back(SeqStmt::Flatten(stores));
+        }
 
-        // Store the reduction result to itself.
-        std::vector<Stmt> stores(size);
+        // Broadcast the reduction result from lane 0 to all other lanes.
+        // This avoids to emit predicated stores, as all threads are
+        // uniformmly writting the same result.
+        //
         for (size_t i = 0; i < size; ++i) {
           Var var = shared_bufs[i];
           PrimExpr pred = const_true(types[i].lanes());
-          stores[i] = Store(var, ret[i], index, pred);
+          PrimExpr val = Load(types[i], var, index, pred);
+          PrimExpr splat = WarpShuffle(builtin::tvm_warp_shuffle(), mask_var, val, 0);
+          seq.push_back(Store(var, splat, index, pred));
         }
-        seq.push_back(SeqStmt::Flatten(stores));
-      }
-
-      // Broadcast the reduction result from lane 0 to all other lanes.
-      // This avoids to emit predicated stores, as all threads are
-      // uniformmly writting the same result.
-      //
-      for (size_t i = 0; i < size; ++i) {
-        Var var = shared_bufs[i];
-        PrimExpr pred = const_true(types[i].lanes());
-        PrimExpr val = Load(types[i], var, index, pred);
-        PrimExpr splat = WarpShuffle(builtin::tvm_warp_shuffle(), mask_var, val, 0);
-        seq.push_back(Store(var, splat, index, pred));
       }
 
       // Update existing allocations.
@@ -478,6 +492,29 @@ class ThreadAllreduceBuilder final : public StmtExprMutator {
     return Call(val.dtype(), op, args);
   }
 
+  // Get the OpenCL sub-group builtin that performs a whole warp reduction with the combiner,
+  // or an empty string if the reduction has to be emitted with shuffles.
+  std::string SubGroupReduceName(const CommReducerNode* combiner,
+                                 const std::vector<DataType>& types) const {
+    if (target_->kind->name != "opencl" || combiner->result.size() != 1) return "";
+    // The sub-group reductions are not defined for 8 and 16 bit integers
+    if (types[0].bits() < 32 && !types[0].is_float16()) return "";
+    const Var& lhs = combiner->lhs[0];
+    const Var& rhs = combiner->rhs[0];
+    auto is_operands = [&](const PrimExpr& a, const PrimExpr& b) {
+      return (a.same_as(lhs) && b.same_as(rhs)) || (a.same_as(rhs) && b.same_as(lhs));
+    };
+    const PrimExpr& result = combiner->result[0];
+    if (const auto* op = result.as<AddNode>()) {
+      if (is_operands(op->a, op->b)) return "sub_group_reduce_add";
+    } else if (const auto* op = result.as<MaxNode>()) {
+      if (is_operands(op->a, op->b)) return "sub_group_reduce_max";
+    } else if (const auto* op = result.as<MinNode>()) {
+      if (is_operands(op->a, op->b)) return "sub_group_reduce_min";
+    }
+    return "";
+  }
+
   // Check if this is a reduction on threadIdx.x and its extent matches
   // the warp size.
   //
@@ -485,8 +522,19 @@ class ThreadAllreduceBuilder final : public StmtExprMutator {
   // Note: The ROCm backend will only have warp reductions for now.
   // Also, the warp/wavefront size differs (64 on rocm, 32 on cuda).
   bool is_warp_reduction(const std::vector<DataType>& types) const {
-    // Only cuda target supports warp reductions.
-    if ((target_->kind->name != "cuda") && (target_->kind->name != "rocm")) return false;
+    // Only cuda and rocm targets, and opencl targets declaring their sub-group size as
+    // thread_warp_size, support warp reductions.
+    bool is_opencl = target_->kind->name == "opencl";
+    if ((target_->kind->name != "cuda") && (target_->kind->name != "rocm") &&
+        !(is_opencl && warp_size_ > 1)) {
+      return false;
+    }
+
+    // OpenCL sub-group functions only take scalar operands
+    if (is_opencl && std::any_of(types.begin(), types.end(),
+                                 [](DataType ty) { return ty.is_vector(); })) {
+      return false;
+    }
 
     // rocm only supports 32 bit operands for shuffling at the moment
     if ((target_->kind->name == "rocm") &&
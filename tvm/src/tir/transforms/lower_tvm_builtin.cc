@@ -386,7 +386,8 @@ class BuiltinLower : public StmtExprMutator {
                                 cast(DataType::UInt(64), call->args[0]),
                                 cast(DataType::UInt(64), call->args[1]),
                                 IntImm(DataType::Int(32), dtype.code()),
-                                IntImm(DataType::Int(32), dtype.bits())});
+                                IntImm(DataType::Int(32), dtype.bits()),
+                                cast(DataType::Int(32), call->args[2])});
 
     Stmt alloca = LetStmt(let->var, call_packed, body);
 
@@ -41,6 +41,8 @@
 namespace tvm {
 namespace tir {
 
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.packed_api.unchecked_entry", Bool);
+
 class ReturnRewriter : public StmtMutator {
  public:
   explicit ReturnRewriter(Var ret_var, Var ret_tcode) : ret_var_(ret_var), ret_tcode_(ret_tcode) {}
@@ -106,7 +108,14 @@ inline Stmt MakeAssertEQ(PrimExpr lhs, PrimExpr rhs, std::string msg) {
   return AssertStmt(lhs == rhs, tvm::tir::StringImm(msg), Evaluate(0));
 }
 
-PrimFunc MakePackedAPI(PrimFunc&& func, int num_unpacked_args) {
+/*!
+ * \brief Lower a PrimFunc to the packed function API.
+ * \param func The function.
+ * \param num_unpacked_args The number of arguments kept unpacked.
+ * \param unchecked When not null, also lower a CPU function with packed arguments to an entry
+ *  that skips the checks of the arguments, called by executors that validated them once.
+ */
+PrimFunc MakePackedAPI(PrimFunc&& func, int num_unpacked_args, Optional<PrimFunc>* unchecked) {
   auto global_symbol = func->GetAttr<String>(tvm::attr::kGlobalSymbol);
   ICHECK(global_symbol) << "MakePackedAPI: Expect PrimFunc to have the global_symbol attribute";
 
@@ -243,23 +252,28 @@ PrimFunc MakePackedAPI(PrimFunc&& func, int num_unpacked_args) {
     func = WithAttr(std::move(func), tvm::attr::kCallingConv, Integer(CallingConv::kCPackedFunc));
   }
 
-  Stmt body = RewriteReturn(func_ptr->body, v_out_ret_value, v_out_ret_tcode);
-  body = AttrStmt(make_zero(DataType::Int(32)), attr::compute_scope,
-                  StringImm(name_hint + "_compute_"), body);
+  Stmt compute = RewriteReturn(func_ptr->body, v_out_ret_value, v_out_ret_tcode);
+  bool need_set_device = false;
   // Set device context
   if (vmap.count(device_id.get())) {
     PrimExpr node = StringImm("default");
     seq_check.push_back(AttrStmt(node, attr::device_context_id, device_id, nop));
     seq_check.push_back(AttrStmt(node, attr::device_context_type, device_type, nop));
-
-    if (runtime::DeviceAPI::NeedSetDeviceContext(target_device_type)) {
+    need_set_device = runtime::DeviceAPI::NeedSetDeviceContext(target_device_type);
+  }
+  auto make_body = [&](const std::string& symbol) {
+    Stmt body = AttrStmt(make_zero(DataType::Int(32)), attr::compute_scope,
+                         StringImm(symbol + "_compute_"), compute);
+    if (need_set_device) {
       Stmt set_device =
           Evaluate(Call(DataType::Int(32), builtin::tvm_call_packed(),
                         {StringImm(runtime::symbol::tvm_set_device), device_type, device_id}));
       body = SeqStmt({set_device, body});
     }
-  }
-  func_ptr->body = MergeNest({seq_init, binder.init_nest(), seq_check, binder.asserts()}, body);
+    return body;
+  };
+  func_ptr->body =
+      MergeNest({seq_init, binder.init_nest(), seq_check, binder.asserts()}, make_body(name_hint));
   func_ptr->params = args;
 
   Array<Var> undefined = UndefinedVars(func_ptr->body, func_ptr->params);
@@ -276,6 +290,25 @@ PrimFunc MakePackedAPI(PrimFunc&& func, int num_unpacked_args) {
   func_ptr->checked_type_ = func_ptr->func_type_annotation();
   func_ptr->ret_type = PrimType(DataType::Int(32));
 
+  if (unchecked != nullptr && num_unpacked_args == 0 && target_device_type == kDLCPU) {
+    // The same function without the assertions on the number, the type codes and the
+    // DLTensor fields of the arguments. Only for CPU, a device function would duplicate its
+    // kernels.
+    auto strip_asserts = [](const std::vector<Stmt>& nest) {
+      std::vector<Stmt> ret;
+      for (const Stmt& stmt : nest) {
+        if (!stmt.as<AssertStmtNode>()) ret.push_back(stmt);
+      }
+      return ret;
+    };
+    std::string symbol = name_hint + runtime::symbol::tvm_unchecked_entry_suffix;
+    PrimFunc unchecked_func = func;
+    unchecked_func.CopyOnWrite()->body =
+        MergeNest({strip_asserts(seq_init), binder.init_nest(), strip_asserts(seq_check)},
+                  make_body(symbol));
+    *unchecked = WithAttr(std::move(unchecked_func), tvm::attr::kGlobalSymbol, String(symbol));
+  }
+
   // return the function.
   return std::move(func);
 }
@@ -286,14 +319,22 @@ Pass MakePackedAPI(int num_unpacked_args) {
   auto pass_func = [num_unpacked_args](IRModule m, PassContext ctx) {
     IRModuleNode* mptr = m.CopyOnWrite();
     std::vector<std::pair<GlobalVar, PrimFunc> > updates;
+    bool unchecked_entry =
+        ctx->GetConfig<Bool>("tir.packed_api.unchecked_entry", Bool(false)).value();
 
     for (const auto& kv : mptr->functions) {
       if (auto* n = kv.second.as<PrimFuncNode>()) {
         PrimFunc func = GetRef<PrimFunc>(n);
         if (func->GetAttr<Integer>(tvm::attr::kCallingConv, Integer(CallingConv::kDefault)) ==
             CallingConv::kDefault) {
-          auto updated_func = MakePackedAPI(std::move(func), num_unpacked_args);
+          Optional<PrimFunc> unchecked;
+          auto updated_func = MakePackedAPI(std::move(func), num_unpacked_args,
+                                            unchecked_entry ? &unchecked : nullptr);
           updates.push_back({kv.first, updated_func});
+          if (unchecked) {
+            String symbol = unchecked.value()->GetAttr<String>(tvm::attr::kGlobalSymbol).value();
+            updates.push_back({GlobalVar(symbol), unchecked.value()});
+          }
         }
       }
     }
@@ -23,10 +23,19 @@
  */
 
 #include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/analysis.h>
 #include <tvm/tir/builtin.h>
 #include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
 
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "../../arith/ir_mutator_with_analyzer.h"
 #include "../../arith/ir_visitor_with_analyzer.h"
 
@@ -55,6 +64,15 @@ namespace tir {
 // Algorithm:
 // - Use DataTypeVisitor to determine whether a Var can be narrowed or not.
 // - Use DataTypeRewritter to rewrite the components of an indexing expression.
+//
+// NarrowDeviceIndex applies the same rewrite to the kernels of targets whose
+// `index_bits` attribute asks for narrow indices, with two more assumptions:
+// - Add, Sub and Mul chains that compute a load or store index and are not
+//   known to fit are computed in unsigned target_bits arithmetic, which wraps
+//   modulo 2^target_bits, and cast back to signed at the index. This is exact
+//   because an in bound index fits into target_bits once every buffer does.
+// - The shape vars of the buffers and the launch extents of the kernels fit
+//   into target_bits, which the host asserts before the kernels run.
 
 using arith::Analyzer;
 using arith::ConstIntBound;
@@ -72,7 +90,8 @@ using arith::IRMutatorWithAnalyzer;
 // Otherwise, `var` is not narrowed, that is, `vmap[var] = var.dtype.bits()`
 class DataTypeVisitor final : public StmtExprVisitor {
  public:
-  explicit DataTypeVisitor(int target_bits) : bits_(target_bits), target_bits_(target_bits) {}
+  explicit DataTypeVisitor(int target_bits, bool wrap_index = false)
+      : bits_(target_bits), target_bits_(target_bits), wrap_index_(wrap_index) {}
 
   void VisitExpr(const PrimExpr& e) {
     if (e.dtype().is_int()) {
@@ -83,19 +102,56 @@ class DataTypeVisitor final : public StmtExprVisitor {
       ConstIntBound bound = bound_[e];
       int64_t ubound = Downcast<IntImm>(max_value(DataType::Int(target_bits_)))->value;
       int64_t lbound = Downcast<IntImm>(min_value(DataType::Int(target_bits_)))->value;
-      if (e.dtype().bits() <= target_bits_ ||
+      // The ring ops of an index chain may wrap around, the index itself does not
+      bool ring = in_ring_ && (e.as<AddNode>() || e.as<SubNode>() || e.as<MulNode>());
+      if (e.dtype().bits() <= target_bits_ || ring ||
           (bound->max_value <= ubound && bound->min_value >= lbound)) {
         bits = target_bits_;
       }
+      bool fits = e.dtype().bits() <= target_bits_ ||
+                  (bound->max_value <= ubound && bound->min_value >= lbound);
       int tmp = bits > bits_ ? bits : bits_;
       std::swap(bits_, tmp);
+      std::swap(in_ring_, ring);
       StmtExprVisitor::VisitExpr(e);
+      std::swap(in_ring_, ring);
       std::swap(bits_, tmp);
+      // Signed overflow is undefined, the ring op wraps in unsigned arithmetic, and so does
+      // every ring op of the chain above it
+      if (ring && e.dtype().bits() > target_bits_ && (!fits || WrapsOperand(e))) {
+        wrap.insert(e.get());
+      }
     } else {
+      bool ring = false;
+      std::swap(in_ring_, ring);
       StmtExprVisitor::VisitExpr(e);
+      std::swap(in_ring_, ring);
     }
   }
 
+  /*!
+   * \brief Assume a var defined outside of the visited stmt is in [0, 2^(target_bits - 1)),
+   *  so that it can be narrowed like the vars defined inside.
+   * \param var The var, whose bound is checked by the caller.
+   */
+  void AssumeNarrow(const Var& var) {
+    analyzer_.Bind(var, Range::FromMinExtent(make_zero(var.dtype()), NarrowLimit(var.dtype())));
+    vextent_[var.get()] = var.dtype();
+  }
+
+  void VisitStmt_(const StoreNode* op) {
+    if (!wrap_index_) return StmtExprVisitor::VisitStmt_(op);
+    this->VisitExpr(op->value);
+    VisitIndex(op->index);
+    this->VisitExpr(op->predicate);
+  }
+
+  void VisitExpr_(const LoadNode* op) {
+    if (!wrap_index_) return StmtExprVisitor::VisitExpr_(op);
+    VisitIndex(op->index);
+    this->VisitExpr(op->predicate);
+  }
+
   void VisitStmt_(const ForNode* op) {
     analyzer_.Bind(op->loop_var, Range::FromMinExtent(op->min, op->extent));
     vextent_[op->loop_var.as<VarNode>()] = op->extent.dtype();
@@ -106,7 +162,14 @@ class DataTypeVisitor final : public StmtExprVisitor {
     if (op->attr_key == attr::thread_extent || op->attr_key == attr::virtual_thread) {
       IterVar iv = Downcast<IterVar>(op->node);
       ICHECK_NE(iv->thread_tag.length(), 0U);
-      analyzer_.Bind(iv->var, Range::FromMinExtent(0, op->value));
+      Range dom = Range::FromMinExtent(0, op->value);
+      if (wrap_index_ &&
+          analyzer_.const_int_bound(op->value)->max_value > NarrowLimit(op->value.dtype())) {
+        // The host asserts the launch extents, see NarrowDeviceIndex
+        dom = Range::FromMinExtent(0, make_const(op->value.dtype(),
+                                                 NarrowLimit(op->value.dtype())));
+      }
+      analyzer_.Bind(iv->var, dom);
       vextent_[iv->var.as<VarNode>()] = op->value.dtype();
       StmtExprVisitor::VisitStmt_(op);
     } else {
@@ -169,18 +232,44 @@ class DataTypeVisitor final : public StmtExprVisitor {
 
   // the narrowed datatype of Var and IntImm
   std::unordered_map<const PrimExprNode*, DataType> vmap;
+  // the ring ops of indices that are narrowed without a bound, computed in unsigned arithmetic
+  std::unordered_set<const PrimExprNode*> wrap;
 
  protected:
   // internal analyzer
   arith::Analyzer analyzer_;
 
  private:
+  // the largest extent that the target bits index, also the max value of the narrowed dtype
+  int64_t NarrowLimit(DataType dtype) const {
+    return Downcast<IntImm>(max_value(dtype.with_bits(target_bits_)))->value;
+  }
+
+  bool WrapsOperand(const PrimExpr& e) const {
+    auto wraps = [this](const PrimExpr& x) { return wrap.count(x.get()) != 0; };
+    if (const auto* op = e.as<AddNode>()) return wraps(op->a) || wraps(op->b);
+    if (const auto* op = e.as<SubNode>()) return wraps(op->a) || wraps(op->b);
+    if (const auto* op = e.as<MulNode>()) return wraps(op->a) || wraps(op->b);
+    return false;
+  }
+
+  void VisitIndex(const PrimExpr& index) {
+    bool ring = true;
+    std::swap(in_ring_, ring);
+    this->VisitExpr(index);
+    std::swap(in_ring_, ring);
+  }
+
   // the maximum possible bits, which serves as an init value
   static constexpr const int max_bits_ = 64;
   // the maximum possible bit of the current expression's return dtype
   int bits_;
   // the target bits
   int target_bits_;
+  // whether the ring ops of indices are narrowed without a bound
+  bool wrap_index_;
+  // whether the current expression is in a chain of ring ops computing an index
+  bool in_ring_{false};
   // the extent of vars to be rewritten
   std::unordered_map<const VarNode*, DataType> vextent_;
   // the memorized bound generated by ConstIntBoundAnalyzer
@@ -189,7 +278,17 @@ class DataTypeVisitor final : public StmtExprVisitor {
 
 class DataTypeRewriter : public StmtExprMutator {
  public:
-  explicit DataTypeRewriter(int target_bits) : visitor_(target_bits) {}
+  explicit DataTypeRewriter(int target_bits, bool wrap_index = false)
+      : visitor_(target_bits, wrap_index) {}
+
+  /*!
+   * \brief Narrow the uses of a var defined outside of the rewritten stmt by casts.
+   * \param var The var, which is checked to fit into target_bits by the caller.
+   */
+  void AssumeNarrow(const Var& var) {
+    visitor_.AssumeNarrow(var);
+    outer_vars_.insert(var.get());
+  }
 
   Stmt operator()(Stmt s) {
     visitor_(s);
@@ -207,7 +306,7 @@ class DataTypeRewriter : public StmtExprMutator {
   Stmt VisitStmt_(const StoreNode* op) final {
     PrimExpr value = this->VisitExpr(op->value);
     is_index_ = true;
-    PrimExpr index = this->VisitExpr(op->index);
+    PrimExpr index = SignedIndex(this->VisitExpr(op->index));
     is_index_ = false;
     Stmt s = Store(op->buffer_var, op->value, index, op->predicate);
     return StmtExprMutator::VisitStmt_(s.as<StoreNode>());
@@ -245,6 +344,9 @@ class DataTypeRewriter : public StmtExprMutator {
 
   PrimExpr VisitExpr_(const VarNode* op) final {
     if (visitor_.vmap.find(op) != visitor_.vmap.end()) {
+      if (outer_vars_.count(op)) {
+        return cast(visitor_.vmap[op], GetRef<Var>(op));
+      }
       if (vmap_.find(op) == vmap_.end()) {
         vmap_[op] = Var(op->name_hint, visitor_.vmap[op]);
       }
@@ -255,6 +357,9 @@ class DataTypeRewriter : public StmtExprMutator {
 
   PrimExpr VisitExpr_(const SizeVarNode* op) final {
     if (visitor_.vmap.find(op) != visitor_.vmap.end()) {
+      if (outer_vars_.count(op)) {
+        return cast(visitor_.vmap[op], GetRef<SizeVar>(op));
+      }
       if (vmap_.find(op) == vmap_.end()) {
         vmap_[op] = SizeVar(op->name_hint, visitor_.vmap[op]);
       }
@@ -265,7 +370,7 @@ class DataTypeRewriter : public StmtExprMutator {
 
   PrimExpr VisitExpr_(const LoadNode* op) final {
     is_index_ = true;
-    PrimExpr index = this->VisitExpr(op->index);
+    PrimExpr index = SignedIndex(this->VisitExpr(op->index));
     is_index_ = false;
     PrimExpr e = Load(op->dtype, op->buffer_var, index, op->predicate);
     return StmtExprMutator::VisitExpr_(e.as<LoadNode>());
@@ -309,6 +414,17 @@ class DataTypeRewriter : public StmtExprMutator {
   PrimExpr VisitExpr_(const CallNode* op) final;
 
  private:
+  // the unsigned ring ops wrap, their result is cast back once it is an in bound index
+  static PrimExpr SignedIndex(PrimExpr index) {
+    if (!index.dtype().is_uint()) return index;
+    return cast(DataType::Int(index.dtype().bits(), index.dtype().lanes()), index);
+  }
+
+  static PrimExpr Unsigned(PrimExpr e) {
+    if (e.dtype().is_uint()) return e;
+    return cast(DataType::UInt(e.dtype().bits(), e.dtype().lanes()), e);
+  }
+
   // the internal visitor to deduce the narrowed dtype
   DataTypeVisitor visitor_;
   // a map from Var before rewrite to that after rewrite,
@@ -317,6 +433,8 @@ class DataTypeRewriter : public StmtExprMutator {
   // a map from IterVar before rewrite to that after rewrite,
   // ensures one old IterVar maps to exactly one new IterVar
   std::unordered_map<const IterVarNode*, IterVar> ivmap_;
+  // the vars defined outside of the rewritten stmt, which are narrowed by casts
+  std::unordered_set<const VarNode*> outer_vars_;
   // indicator of LoadNode::index and StoreNode::index
   bool is_index_{false};
   // cached ops
@@ -334,9 +452,22 @@ class DataTypeRewriter : public StmtExprMutator {
     }                                                     \
   }
 
-DEFINE_BIOP_EXPR_MUTATE_WITH_TYPE_MATCH(AddNode, operator+);
-DEFINE_BIOP_EXPR_MUTATE_WITH_TYPE_MATCH(SubNode, operator-);
-DEFINE_BIOP_EXPR_MUTATE_WITH_TYPE_MATCH(MulNode, operator*);
+#define DEFINE_RING_EXPR_MUTATE_WITH_TYPE_MATCH(OP, FUNC) \
+  PrimExpr DataTypeRewriter::VisitExpr_(const OP* op) {   \
+    PrimExpr a = this->VisitExpr(op->a);                  \
+    PrimExpr b = this->VisitExpr(op->b);                  \
+    if (is_index_ && visitor_.wrap.count(op)) {           \
+      return FUNC(Unsigned(a), Unsigned(b));              \
+    } else if (a.same_as(op->a) && b.same_as(op->b)) {    \
+      return GetRef<PrimExpr>(op);                        \
+    } else {                                              \
+      return FUNC(a, b);                                  \
+    }                                                     \
+  }
+
+DEFINE_RING_EXPR_MUTATE_WITH_TYPE_MATCH(AddNode, operator+);
+DEFINE_RING_EXPR_MUTATE_WITH_TYPE_MATCH(SubNode, operator-);
+DEFINE_RING_EXPR_MUTATE_WITH_TYPE_MATCH(MulNode, operator*);
 DEFINE_BIOP_EXPR_MUTATE_WITH_TYPE_MATCH(DivNode, div);
 DEFINE_BIOP_EXPR_MUTATE_WITH_TYPE_MATCH(ModNode, truncmod);
 DEFINE_BIOP_EXPR_MUTATE_WITH_TYPE_MATCH(FloorDivNode, floordiv);
@@ -377,6 +508,114 @@ PrimExpr DataTypeRewriter::VisitExpr_(const CallNode* op) {
 
 Stmt NarrowDataType(Stmt stmt, int target_bits) { return DataTypeRewriter(target_bits)(stmt); }
 
+// Narrow every kernel, that is every outermost thread extent, and assert
+// its launch extents on host when they are not known to fit.
+class DeviceIndexNarrower : public StmtMutator {
+ public:
+  DeviceIndexNarrower(int target_bits, const std::vector<Var>& outer_vars)
+      : target_bits_(target_bits), outer_vars_(outer_vars) {
+    for (const Var& var : outer_vars_) {
+      analyzer_.Bind(var, Range::FromMinExtent(make_zero(var.dtype()), Limit(var.dtype())));
+    }
+  }
+
+  Stmt VisitStmt_(const AttrStmtNode* op) final {
+    if (op->attr_key != attr::thread_extent) return StmtMutator::VisitStmt_(op);
+    Stmt kernel = GetRef<Stmt>(op);
+    std::vector<PrimExpr> extents;
+    PostOrderVisit(kernel, [&extents](const ObjectRef& n) {
+      if (const auto* attr = n.as<AttrStmtNode>()) {
+        if (attr->attr_key == attr::thread_extent) extents.push_back(attr->value);
+      }
+    });
+    DataTypeRewriter rewriter(target_bits_, true);
+    for (const Var& var : outer_vars_) rewriter.AssumeNarrow(var);
+    kernel = rewriter(kernel);
+    for (const PrimExpr& extent : extents) {
+      if (analyzer_.const_int_bound(extent)->max_value > Limit(extent.dtype())) {
+        std::ostringstream os;
+        os << "The launch extent " << extent << " does not fit the " << target_bits_
+           << " bit indices of the kernel";
+        kernel = AssertStmt(extent <= Limit(extent.dtype()), StringImm(os.str()), kernel);
+      }
+    }
+    return kernel;
+  }
+
+ private:
+  PrimExpr Limit(DataType dtype) const { return max_value(dtype.with_bits(target_bits_)); }
+
+  int target_bits_;
+  std::vector<Var> outer_vars_;
+  arith::Analyzer analyzer_;
+};
+
+// Narrow the kernels of a function whose buffers fit into target_bits,
+// asserting on host the element counts that are not known to fit.
+PrimFunc NarrowDeviceIndex(PrimFunc f, int target_bits) {
+  std::vector<Var> outer_vars;
+  std::unordered_set<const VarNode*> outer_set;
+  auto add_outer = [&](const PrimExpr& e) {
+    if (const auto* var = e.as<VarNode>()) {
+      if (var->dtype.is_int() && outer_set.insert(var).second) {
+        outer_vars.push_back(GetRef<Var>(var));
+      }
+    }
+  };
+  // The element counts, with the offsets, of the buffers that the kernels index
+  std::vector<std::pair<std::string, PrimExpr>> counts;
+  for (const auto& kv : f->buffer_map) {
+    // Strided buffers are indexed out of their shape, leave the function to NarrowDataType
+    if (!kv.second->strides.empty()) return f;
+  }
+  for (const auto& kv : f->buffer_map) {
+    const Buffer& buf = kv.second;
+    PrimExpr count = cast(DataType::Int(64), buf->elem_offset);
+    PrimExpr elems = make_const(DataType::Int(64), 1);
+    for (const PrimExpr& dim : buf->shape) {
+      // A zero dim would leave the others unchecked
+      elems = elems * max(cast(DataType::Int(64), dim), make_const(DataType::Int(64), 1));
+      add_outer(dim);
+    }
+    add_outer(buf->elem_offset);
+    counts.emplace_back(buf->name, count + elems);
+  }
+  arith::Analyzer analyzer;
+  PrimExpr limit = max_value(DataType::Int(target_bits));
+  for (const Var& var : outer_vars) {
+    analyzer.Bind(var, Range::FromMinExtent(make_zero(var.dtype()),
+                                            max_value(var.dtype().with_bits(target_bits))));
+  }
+  bool unchecked = false;
+  PostOrderVisit(f->body, [&](const ObjectRef& n) {
+    if (const auto* alloc = n.as<AllocateNode>()) {
+      PrimExpr elems = make_const(DataType::Int(64), 1);
+      for (const PrimExpr& extent : alloc->extents) elems = elems * cast(DataType::Int(64), extent);
+      if (analyzer.CanProve(elems <= limit)) return;
+      // The extents of host allocations are asserted with the buffers
+      bool outer =
+          !ExprUseVar(elems, [&outer_set](const VarNode* v) { return outer_set.count(v) == 0; });
+      if (outer) {
+        counts.emplace_back(alloc->buffer_var->name_hint, elems);
+      } else {
+        unchecked = true;
+      }
+    }
+  });
+  if (unchecked) return f;
+
+  auto* n = f.CopyOnWrite();
+  n->body = DeviceIndexNarrower(target_bits, outer_vars)(std::move(n->body));
+  for (auto it = counts.rbegin(); it != counts.rend(); ++it) {
+    if (analyzer.CanProve(it->second <= limit)) continue;
+    std::ostringstream os;
+    os << it->first << " has more elements than the " << target_bits
+       << " bit indices of the kernels address";
+    n->body = AssertStmt(it->second <= limit, StringImm(os.str()), n->body);
+  }
+  return f;
+}
+
 namespace transform {
 
 Pass NarrowDataType(int target_bits) {
@@ -390,6 +629,21 @@ Pass NarrowDataType(int target_bits) {
 
 TVM_REGISTER_GLOBAL("tir.transform.NarrowDataType").set_body_typed(NarrowDataType);
 
+Pass NarrowDeviceIndex() {
+  auto pass_func = [](PrimFunc f, IRModule m, PassContext ctx) {
+    auto target = f->GetAttr<Target>(tvm::attr::kTarget);
+    if (!target) return f;
+    int index_bits = target.value()->GetAttr<Integer>("index_bits", Integer(64)).value();
+    ICHECK(index_bits == 32 || index_bits == 64)
+        << "index_bits of target " << target.value()->str() << " should be 32 or 64";
+    if (index_bits == 64) return f;
+    return ::tvm::tir::NarrowDeviceIndex(std::move(f), index_bits);
+  };
+  return CreatePrimFuncPass(pass_func, 0, "tir.NarrowDeviceIndex", {});
+}
+
+TVM_REGISTER_GLOBAL("tir.transform.NarrowDeviceIndex").set_body_typed(NarrowDeviceIndex);
+
 }  // namespace transform
 }  // namespace tir
 }  // namespace tvm
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file remove_dead_texture_store.cc
+ * \brief Remove the texture stores no texture load can observe.
+ */
+#include <tvm/runtime/registry.h>
+#include <tvm/tir/analysis.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <unordered_set>
+#include <vector>
+
+namespace tvm {
+namespace tir {
+
+// Find the textures allocated in the function which are never read.
+class UnreadTextureFinder : public StmtExprVisitor {
+ public:
+  void VisitStmt_(const LetStmtNode* op) final {
+    const auto* call = op->value.as<CallNode>();
+    if (call && call->op.same_as(builtin::texture2d_alloca())) {
+      unread.insert(op->var.get());
+    }
+    StmtExprVisitor::VisitStmt_(op);
+  }
+
+  void VisitExpr_(const CallNode* op) final {
+    // Stores only write the texture, any other use may read it
+    if (op->op.same_as(builtin::texture2d_store()) && op->args[0]->IsInstance<VarNode>()) {
+      for (size_t i = 1; i < op->args.size(); ++i) {
+        this->VisitExpr(op->args[i]);
+      }
+      return;
+    }
+    StmtExprVisitor::VisitExpr_(op);
+  }
+
+  void VisitExpr_(const VarNode* op) final { unread.erase(op); }
+
+  /*! \brief The allocated textures only ever stored to. */
+  std::unordered_set<const VarNode*> unread;
+};
+
+/*!
+ * \brief Remove the stores to textures which are never read, together with their allocation,
+ *  and the stores overwritten by a later store to the same texel of the same sequence before
+ *  the texture is read.
+ */
+class DeadTextureStoreRemover : public StmtExprMutator {
+ public:
+  Stmt Remove(Stmt stmt) {
+    UnreadTextureFinder finder;
+    finder(stmt);
+    unread_ = std::move(finder.unread);
+    return this->VisitStmt(std::move(stmt));
+  }
+
+  Stmt VisitStmt_(const LetStmtNode* op) final {
+    if (unread_.count(op->var.get())) {
+      return this->VisitStmt(op->body);
+    }
+    return StmtExprMutator::VisitStmt_(op);
+  }
+
+  Stmt VisitStmt_(const EvaluateNode* op) final {
+    const CallNode* store = AsTextureStore(GetRef<Stmt>(op));
+    if (store && unread_.count(store->args[0].as<VarNode>())) {
+      return Evaluate(0);
+    }
+    return StmtExprMutator::VisitStmt_(op);
+  }
+
+  Stmt VisitStmt_(const SeqStmtNode* op) final {
+    Stmt stmt = StmtExprMutator::VisitStmt_(op);
+    op = stmt.as<SeqStmtNode>();
+    if (op == nullptr) return stmt;
+    std::vector<Stmt> seq(op->seq.begin(), op->seq.end());
+    bool changed = false;
+    for (size_t i = 0; i < seq.size(); ++i) {
+      const CallNode* store = AsTextureStore(seq[i]);
+      if (store == nullptr) continue;
+      Var texture = Downcast<Var>(store->args[0]);
+      // Only stores to other texels of the texture may sit in between, those do not read it
+      for (size_t j = i + 1; j < seq.size(); ++j) {
+        const CallNode* next = AsTextureStore(seq[j]);
+        if (next == nullptr || !next->args[0].same_as(texture) ||
+            ExprUseVar(next->args.back(), texture)) {
+          break;
+        }
+        // Texture stores always write all the channels of the texel
+        if (StructuralEqual()(next->args[1], store->args[1]) &&
+            StructuralEqual()(next->args[2], store->args[2])) {
+          seq[i] = Evaluate(0);
+          changed = true;
+          break;
+        }
+      }
+    }
+    if (!changed) return stmt;
+    return SeqStmt::Flatten(seq);
+  }
+
+ private:
+  static const CallNode* AsTextureStore(const Stmt& stmt) {
+    const auto* eval = stmt.as<EvaluateNode>();
+    const auto* call = eval ? eval->value.as<CallNode>() : nullptr;
+    if (call && call->op.same_as(builtin::texture2d_store()) &&
+        call->args[0]->IsInstance<VarNode>()) {
+      return call;
+    }
+    return nullptr;
+  }
+
+  // The allocated textures only ever stored to
+  std::unordered_set<const VarNode*> unread_;
+};
+
+namespace transform {
+
+Pass RemoveDeadTextureStore() {
+  auto pass_func = [](PrimFunc f, IRModule m, PassContext ctx) {
+    auto* n = f.CopyOnWrite();
+    n->body = DeadTextureStoreRemover().Remove(std::move(n->body));
+    return f;
+  };
+  return CreatePrimFuncPass(pass_func, 0, "tir.RemoveDeadTextureStore", {});
+}
+
+TVM_REGISTER_GLOBAL("tir.transform.RemoveDeadTextureStore").set_body_typed(RemoveDeadTextureStore);
+
+}  // namespace transform
+
+}  // namespace tir
+}  // namespace tvm
@@ -33,6 +33,7 @@
 #include <tvm/tir/transform.h>
 
 #include <unordered_map>
+#include <vector>
 
 namespace tvm {
 namespace tir {
@@ -216,6 +217,15 @@ class HostDeviceSplitter : public StmtMutator {
         op->attr_key == attr::device_scope) {
       return SplitDeviceFunc(GetRef<Stmt>(op));
     }
+    if (op->attr_key == attr::pragma_build_options) {
+      const auto* options = op->value.as<StringImmNode>();
+      ICHECK(options != nullptr) << "The build_options pragma expects a string";
+      // Consumed here and attached to the kernels split from the body.
+      build_options_.push_back(options->value);
+      Stmt body = this->VisitStmt(op->body);
+      build_options_.pop_back();
+      return body;
+    }
     return StmtMutator::VisitStmt_(op);
   }
 
@@ -263,6 +273,14 @@ class HostDeviceSplitter : public StmtMutator {
         WithAttr(std::move(device_func), tvm::attr::kGlobalSymbol, runtime::String(kernel_symbol));
     device_func = WithAttr(std::move(device_func), tir::attr::kNoAlias, Integer(1));
     device_func = WithAttr(std::move(device_func), tvm::attr::kTarget, device_target_);
+    if (!build_options_.empty()) {
+      std::ostringstream options;
+      for (size_t i = 0; i < build_options_.size(); ++i) {
+        options << (i == 0 ? "" : " ") << build_options_[i];
+      }
+      device_func = WithAttr(std::move(device_func), tir::attr::kDeviceBuildOptions,
+                             runtime::String(options.str()));
+    }
     (*device_mod_)->Add(GlobalVar(kernel_symbol), device_func);
 
     // generate calls to the device function
@@ -285,6 +303,8 @@ class HostDeviceSplitter : public StmtMutator {
   std::string name_prefix_;
   // Number of device functions.
   int device_func_counter_{0};
+  // The build options of the enclosing build_options pragmas.
+  std::vector<std::string> build_options_;
   std::unordered_map<const VarNode*, PrimExpr> handle_data_type_;
 };
 
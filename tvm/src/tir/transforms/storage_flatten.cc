@@ -26,8 +26,10 @@
 #include <tvm/arith/analyzer.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
 #include <tvm/target/target_info.h>
 #include <tvm/te/operation.h>
+#include <tvm/tir/analysis.h>
 #include <tvm/tir/buffer.h>
 #include <tvm/tir/builtin.h>
 #include <tvm/tir/expr.h>
@@ -37,6 +39,7 @@
 #include <tvm/tir/transform.h>
 
 #include <unordered_map>
+#include <unordered_set>
 
 #include "../../arith/ir_visitor_with_analyzer.h"
 #include "../../runtime/thread_storage_scope.h"
@@ -50,11 +53,76 @@ using runtime::StorageRank;
 using runtime::StorageScope;
 using runtime::ThreadScope;
 
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.StorageFlatten.pad_shared_banks", Bool);
+
+/*! \brief Shared memory bank layout of the target, used to pad conflicting rows. */
+struct SharedBankInfo {
+  /*! \brief Number of banks, 0 disables padding. */
+  int num_banks{0};
+  /*! \brief Bytes served by one bank per cycle. */
+  int bank_bytes{4};
+};
+
+/*!
+ * \brief Find the shared buffers that consecutive threads walk down a column.
+ *
+ * An access is flagged when threadIdx.x appears in the index of the
+ * second innermost dimension but not in the innermost one: neighbouring
+ * threads then touch addresses one row pitch apart, and every pitch that
+ * shares a factor with the bank count serializes the access.
+ */
+class ColumnAccessDetector : public StmtExprVisitor {
+ public:
+  std::unordered_set<Buffer, ObjectPtrHash, ObjectPtrEqual> Detect(const Stmt& stmt) {
+    this->VisitStmt(stmt);
+    return std::move(column_buffers_);
+  }
+
+  void VisitStmt_(const AttrStmtNode* op) final {
+    if (op->attr_key == attr::thread_extent) {
+      IterVar iv = Downcast<IterVar>(op->node);
+      if (iv->thread_tag == "threadIdx.x") {
+        thread_x_.insert(iv->var.get());
+      }
+    }
+    StmtExprVisitor::VisitStmt_(op);
+  }
+
+  void VisitStmt_(const BufferStoreNode* op) final {
+    Check(op->buffer, op->indices);
+    StmtExprVisitor::VisitStmt_(op);
+  }
+
+  void VisitExpr_(const BufferLoadNode* op) final {
+    Check(op->buffer, op->indices);
+    StmtExprVisitor::VisitExpr_(op);
+  }
+
+ private:
+  void Check(const Buffer& buffer, const Array<PrimExpr>& indices) {
+    if (indices.size() < 2 || thread_x_.empty()) return;
+    auto uses_thread_x = [this](const VarNode* v) { return thread_x_.count(v) != 0; };
+    if (!ExprUseVar(indices[indices.size() - 1], uses_thread_x) &&
+        ExprUseVar(indices[indices.size() - 2], uses_thread_x)) {
+      column_buffers_.insert(buffer);
+    }
+  }
+
+  std::unordered_set<const VarNode*> thread_x_;
+  std::unordered_set<Buffer, ObjectPtrHash, ObjectPtrEqual> column_buffers_;
+};
+
 class StorageFlattener : public StmtExprMutator {
  public:
   explicit StorageFlattener(const Map<Var, Buffer>& extern_buffer_map, int cache_line_size,
-                            bool create_bound_attributes, IRVisitorWithAnalyzer* bound_analyzer)
-      : bound_analyzer_(bound_analyzer), create_bound_attributes_(create_bound_attributes) {
+                            bool create_bound_attributes, IRVisitorWithAnalyzer* bound_analyzer,
+                            SharedBankInfo bank_info = SharedBankInfo(),
+                            std::unordered_set<Buffer, ObjectPtrHash, ObjectPtrEqual>
+                                column_buffers = {})
+      : bound_analyzer_(bound_analyzer),
+        create_bound_attributes_(create_bound_attributes),
+        bank_info_(bank_info),
+        column_buffers_(std::move(column_buffers)) {
     for (auto kv : extern_buffer_map) {
       BufferEntry e;
       e.buffer = kv.second;
@@ -180,6 +248,13 @@ class StorageFlattener : public StmtExprMutator {
               << "Allocation exceed bound of memory tag " << skey.to_string();
         }
       }
+      // An explicit storage_align on the buffer, even with a zero factor,
+      // takes over the layout; otherwise pad the rows of shared buffers
+      // that are read down a column.
+      if (skey.rank == StorageRank::kShared && dim_align_.count(key) == 0 &&
+          column_buffers_.count(key) != 0) {
+        PadSharedRows(key, dtype, shape);
+      }
       Array<PrimExpr> strides;
       if (dim_align_.count(key) != 0 && shape.size() != 0) {
         std::vector<PrimExpr> rstrides;
@@ -433,6 +508,36 @@ class StorageFlattener : public StmtExprMutator {
     return body;
   }
 
+  /*!
+   * \brief Align the row pitch of a buffer to one bank word past a multiple
+   *  of the bank row, so consecutive rows start in different banks.
+   */
+  void PadSharedRows(const Buffer& key, DataType dtype, const Array<PrimExpr>& shape) {
+    int elem_bytes = dtype.bytes() * dtype.lanes();
+    if (bank_info_.num_banks <= 0 || shape.size() < 2 || elem_bytes > bank_info_.bank_bytes ||
+        bank_info_.bank_bytes % elem_bytes != 0) {
+      return;
+    }
+    const auto* row = shape[shape.size() - 1].as<IntImmNode>();
+    if (row == nullptr) return;
+    int64_t pitch_bytes = row->value * elem_bytes;
+    if (pitch_bytes % bank_info_.bank_bytes != 0) return;
+    // Rows only collide when the pitch in words shares a factor with the bank count.
+    int64_t a = pitch_bytes / bank_info_.bank_bytes, b = bank_info_.num_banks;
+    while (b != 0) {
+      int64_t t = a % b;
+      a = b;
+      b = t;
+    }
+    if (a == 1) return;
+
+    int word_elems = bank_info_.bank_bytes / elem_bytes;
+    auto& vinfo = dim_align_[key];
+    vinfo.resize(shape.size());
+    vinfo[shape.size() - 2].align_factor = bank_info_.num_banks * word_elems;
+    vinfo[shape.size() - 2].align_offset = word_elems;
+  }
+
   // The buffer entry in the flatten map
   struct DimAlignInfo {
     int align_factor{0};
@@ -504,15 +609,48 @@ class StorageFlattener : public StmtExprMutator {
   int cache_line_size_;
   // Whether to mark load/store with theirs bounds.
   bool create_bound_attributes_{false};
+  // Shared memory banks of the target.
+  SharedBankInfo bank_info_;
+  // Shared buffers read down a column by consecutive threads.
+  std::unordered_set<Buffer, ObjectPtrHash, ObjectPtrEqual> column_buffers_;
 };
 
-PrimFunc StorageFlatten(PrimFunc func, int cache_line_size, bool create_bound_attributes) {
+/*!
+ * \brief Bank layout of the function's target, taken from the target
+ *  attributes "shared_memory_banks" and "shared_memory_bank_bytes".
+ */
+SharedBankInfo GetSharedBankInfo(const PrimFunc& func) {
+  SharedBankInfo info;
+  Optional<Target> target = func->GetAttr<Target>(tvm::attr::kTarget);
+  if (!target.defined()) target = Target::Current(true);
+  if (!target.defined()) return info;
+  if (auto banks = target.value()->GetAttr<Integer>("shared_memory_banks")) {
+    info.num_banks = banks.value()->value;
+  }
+  if (auto bank_bytes = target.value()->GetAttr<Integer>("shared_memory_bank_bytes")) {
+    info.bank_bytes = bank_bytes.value()->value;
+  }
+  return info;
+}
+
+PrimFunc StorageFlatten(PrimFunc func, int cache_line_size, bool create_bound_attributes,
+                        bool pad_shared_banks = false) {
+  SharedBankInfo bank_info;
+  std::unordered_set<Buffer, ObjectPtrHash, ObjectPtrEqual> column_buffers;
+  if (pad_shared_banks) {
+    bank_info = GetSharedBankInfo(func);
+    if (bank_info.num_banks > 0) {
+      column_buffers = ColumnAccessDetector().Detect(func->body);
+    }
+  }
+
   auto fptr = func.CopyOnWrite();
 
   IRVisitorWithAnalyzer bound_analyzer;
   bound_analyzer(fptr->body);
   fptr->body = StorageFlattener(fptr->buffer_map, cache_line_size, create_bound_attributes,
-                                &bound_analyzer)(std::move(fptr->body));
+                                &bound_analyzer, bank_info,
+                                std::move(column_buffers))(std::move(fptr->body));
   return func;
 }
 
@@ -521,7 +659,10 @@ namespace transform {
 // TODO(tvm-team): consolidate configs to the PassContext
 Pass StorageFlatten(int cache_line_size, bool create_bound_attributes) {
   auto pass_func = [=](PrimFunc f, IRModule m, PassContext ctx) {
-    return StorageFlatten(std::move(f), cache_line_size, create_bound_attributes);
+    bool pad_shared_banks =
+        ctx->GetConfig<Bool>("tir.StorageFlatten.pad_shared_banks", Bool(false)).value();
+    return StorageFlatten(std::move(f), cache_line_size, create_bound_attributes,
+                          pad_shared_banks);
   };
   return CreatePrimFuncPass(pass_func, 0, "tir.StorageFlatten", {});
 }
@@ -807,7 +807,9 @@ class StoragePlanRewriter : public StmtExprMutator {
     // disable reuse of small arrays, they will be lowered to registers in LLVM
     // This rules only apply if we are using non special memory
     if (scope.tag.length() == 0) {
-      if (scope.rank >= StorageRank::kWarp || op->dtype.is_handle()) {
+      // VTCM is scarce, its tiles are shared like global memory
+      if ((scope.rank >= StorageRank::kWarp && scope.rank != StorageRank::kVtcm) ||
+          op->dtype.is_handle()) {
         return NewAlloc(op, attach_scope, scope, const_nbits);
       }
       if (const_nbits > 0 && const_nbits <= 32) {
@@ -865,7 +867,10 @@ class StoragePlanRewriter : public StmtExprMutator {
     // This rules only apply if we are using non special memory
     if (e->scope.tag.length() == 0) {
       // Disable sharing of local memory.
-      if (e->scope.rank >= StorageRank::kWarp || e->allocs[0]->dtype.is_handle()) return;
+      if ((e->scope.rank >= StorageRank::kWarp && e->scope.rank != StorageRank::kVtcm) ||
+          e->allocs[0]->dtype.is_handle()) {
+        return;
+      }
       // disable reuse of small arrays
       if (e->const_nbits > 0 && e->const_nbits <= 32) return;
     }
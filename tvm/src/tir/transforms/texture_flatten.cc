@@ -23,8 +23,10 @@
  */
 
 #include <tvm/arith/analyzer.h>
+#include <tvm/arith/pattern.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
 #include <tvm/target/target_info.h>
 #include <tvm/te/operation.h>
 #include <tvm/tir/analysis.h>
@@ -36,8 +38,13 @@
 #include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
 
-#include <unordered_map>
+#include <algorithm>
+#include <limits>
 #include <stack>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "../../arith/ir_visitor_with_analyzer.h"
 #include "../../runtime/thread_storage_scope.h"
@@ -119,6 +126,70 @@ class TextureFlattener : public TextureLoweringBase {
                             const std::unordered_map<Buffer, Buffer, ObjectPtrHash, ObjectPtrEqual>& extern_buffer_binds_)
     : TextureLoweringBase(extern_buffer_map), buffer_binds_(extern_buffer_binds_) {;}
 
+  Stmt Flatten(Stmt body) {
+    PostOrderVisit(body, [this](const ObjectRef& node) {
+      if (const auto* op = node.as<ForNode>()) {
+        local_vars_.insert(op->loop_var.get());
+      } else if (const auto* op = node.as<LetStmtNode>()) {
+        local_vars_.insert(op->var.get());
+      } else if (const auto* op = node.as<LetNode>()) {
+        local_vars_.insert(op->var.get());
+      } else if (const auto* op = node.as<AttrStmtNode>()) {
+        if (const auto* iv = op->node.as<IterVarNode>()) {
+          local_vars_.insert(iv->var.get());
+        }
+      }
+    });
+    body = this->VisitStmt(body);
+    return WrapHoisted(&top_hoisted_, body);
+  }
+
+  Stmt VisitStmt_(const AttrStmtNode* op) final {
+    // Double buffering applies to the texture that replaces the buffer
+    if (op->attr_key == attr::double_buffer_scope) {
+      if (const auto* buffer = op->node.as<BufferNode>()) {
+        auto it = let_binding_.find(buffer->data);
+        if (it != let_binding_.end()) {
+          return AttrStmt(it->second, op->attr_key, op->value, this->VisitStmt(op->body));
+        }
+      }
+    }
+    const auto* iv = op->node.as<IterVarNode>();
+    if (iv == nullptr) {
+      return TextureLoweringBase::VisitStmt_(op);
+    }
+    hoist_frames_.push_back(HoistFrame{iv->var, false, {}});
+    Stmt stmt = TextureLoweringBase::VisitStmt_(op);
+    std::vector<std::pair<Var, PrimExpr>> hoisted = std::move(hoist_frames_.back().hoisted);
+    hoist_frames_.pop_back();
+    if (hoisted.empty()) return stmt;
+    AttrStmt attr = Downcast<AttrStmt>(stmt);
+    attr.CopyOnWrite()->body = WrapHoisted(&hoisted, attr->body);
+    return std::move(attr);
+  }
+
+  Stmt VisitStmt_(const ForNode* op) final {
+    hoist_frames_.push_back(HoistFrame{op->loop_var, true, {}});
+    Stmt stmt = StmtExprMutator::VisitStmt_(op);
+    std::vector<std::pair<Var, PrimExpr>> hoisted = std::move(hoist_frames_.back().hoisted);
+    hoist_frames_.pop_back();
+    if (hoisted.empty()) return stmt;
+    For loop = Downcast<For>(stmt);
+    loop.CopyOnWrite()->body = WrapHoisted(&hoisted, loop->body);
+    return std::move(loop);
+  }
+
+  Stmt VisitStmt_(const LetStmtNode* op) final {
+    hoist_frames_.push_back(HoistFrame{op->var, false, {}});
+    Stmt stmt = StmtExprMutator::VisitStmt_(op);
+    std::vector<std::pair<Var, PrimExpr>> hoisted = std::move(hoist_frames_.back().hoisted);
+    hoist_frames_.pop_back();
+    if (hoisted.empty()) return stmt;
+    LetStmt let = Downcast<LetStmt>(stmt);
+    let.CopyOnWrite()->body = WrapHoisted(&hoisted, let->body);
+    return std::move(let);
+  }
+
   Stmt VisitStmt_(const BufferRealizeNode* op) final {
     if (extern_buf_.count(op->buffer)) {
       return this->VisitStmt(op->body);
@@ -134,9 +205,10 @@ class TextureFlattener : public TextureLoweringBase {
     std::string storage_scope = GetStorageScope(op->buffer);
     if (IsTextureStorage(storage_scope)) {
       body = this->VisitStmt(op->body);
-      ICHECK(op->bounds.size() >= 3) << "Only 2d RGBA texture is currently supported";
+      ICHECK(op->bounds.size() >= 3) << "Only 2d textures are currently supported";
       int vec_length = static_cast<int>(op->bounds.back()->extent.as<IntImmNode>()->value);
-      ICHECK(vec_length == 4 || vec_length == 1) << "FCD of texture must be vector of length 1 or 4 (RGBA)";
+      ICHECK(vec_length == 1 || vec_length == 2 || vec_length == 4)
+          << "FCD of texture must be vector of length 1, 2 or 4 (R, RG or RGBA)";
 
       struct Shape {
         const Array<Range>& bounds;
@@ -144,7 +216,7 @@ class TextureFlattener : public TextureLoweringBase {
       };
       size_t axis = DefaultTextureLayoutSeparator(op->bounds.size(), storage_scope);
       auto texture = ApplyTexture2DFlattening<PrimExpr>(Shape{op->bounds}, op->bounds.size(), axis);
-      Array<PrimExpr> args = {texture.width, texture.height};
+      Array<PrimExpr> args = {texture.width, texture.height, texture.channel};
       stmt = LetStmt(buffer_var, Call(buffer_var.dtype(), builtin::texture2d_alloca(), args), body);
     }
 
@@ -159,7 +231,9 @@ class TextureFlattener : public TextureLoweringBase {
     if (IsTextureStorage(storage_scope)) {
       Array<PrimExpr> args = GetTextureAccessArgs(op, op->buffer);
       args.push_back(op->value);
-      stmt = Evaluate(Call(args[0]->dtype, builtin::texture2d_store(), args));
+      const Op& store = IsTextureArrayAccess(op, op->buffer) ? builtin::texture2d_array_store()
+                                                              : builtin::texture2d_store();
+      stmt = Evaluate(Call(args[0]->dtype, store, args));
     }
 
     return stmt;
@@ -178,14 +252,125 @@ class TextureFlattener : public TextureLoweringBase {
     if (IsTextureStorage(storage_scope)) {
       Array<PrimExpr> args = GetTextureAccessArgs(op, buffer);
       args.push_back(op->indices.back());
-      expr = Call(op->buffer->dtype, builtin::texture2d_load(), args);
+      const Op& load = IsTextureArrayAccess(op, buffer) ? builtin::texture2d_array_load()
+                                                         : builtin::texture2d_load();
+      expr = Call(op->buffer->dtype, load, args);
     }
 
     return expr;
   }
 
+  PrimExpr VisitExpr_(const CallNode* op) final {
+    if (op->op.same_as(builtin::if_then_else())) {
+      return VisitIfThenElse(op);
+    }
+    // texture2d_sample(buffer[indices], sampler, u, v) samples the image of the buffer at (u, v)
+    // texels from the corner of the texel addressed by the indices, whose center is (0.5, 0.5).
+    const auto* load = op->args.size() == 4 ? op->args[0].as<BufferLoadNode>() : nullptr;
+    if (!op->op.same_as(builtin::texture2d_sample()) || load == nullptr) {
+      return StmtExprMutator::VisitExpr_(op);
+    }
+    PrimExpr expr = StmtExprMutator::VisitExpr_(load);
+    load = expr.as<BufferLoadNode>();
+    auto buffer = load->buffer;
+    if (buffer_binds_.count(load->buffer)) {
+      buffer = buffer_binds_[load->buffer];
+    }
+    ICHECK(IsTextureStorage(GetStorageScope(buffer)) && !IsTextureArrayAccess(load, buffer))
+        << "texture2d_sample needs a buffer held in a 2d texture, got " << buffer->name;
+    const auto* flags = op->args[1].as<IntImmNode>();
+    ICHECK(flags && !(flags->value & builtin::kSamplerNormalizedCoords))
+        << "The coordinates of texture2d_sample on a buffer are offsets in texels";
+    Array<PrimExpr> texel = GetTextureAccessArgs(load, buffer);
+    PrimExpr u = this->VisitExpr(op->args[2]);
+    PrimExpr v = this->VisitExpr(op->args[3]);
+    return Call(op->dtype, op->op,
+                {texel[0], op->args[1], cast(u.dtype(), texel[1]) + u,
+                 cast(v.dtype(), texel[2]) + v, load->indices.back()});
+  }
+
  protected:
 
+  /*!
+   * \brief Lower if_then_else(cond, buffer[indices], 0), e.g. a padded texture load.
+   *
+   *  The texture reads use CLK_ADDRESS_CLAMP, which returns zeros for the texels outside the
+   *  image. When an index alone makes up a texture coordinate, a check that it is not negative
+   *  is left to the sampler and dropped from the condition, so the loads of the left and top
+   *  padding need no branch. Checks against the upper bounds are kept, as the image may be
+   *  larger than the buffer when its texture is shared.
+   */
+  PrimExpr VisitIfThenElse(const CallNode* op) {
+    const auto* load = op->args[1].as<BufferLoadNode>();
+    const auto* fzero = op->args[2].as<FloatImmNode>();
+    if (load == nullptr || !(is_zero(op->args[2]) || (fzero && fzero->value == 0))) {
+      return StmtExprMutator::VisitExpr_(op);
+    }
+    Buffer buffer = buffer_binds_.count(load->buffer) ? buffer_binds_[load->buffer] : load->buffer;
+    std::string scope = GetStorageScope(buffer);
+    if (!IsTextureStorage(scope)) {
+      return StmtExprMutator::VisitExpr_(op);
+    }
+    // The indices making up a texture coordinate alone
+    size_t rank = load->buffer->shape.size();
+    size_t begin = IsTextureArrayAccess(load, buffer) ? 1 : 0;
+    size_t separator = DefaultTextureLayoutSeparator(rank, scope);
+    std::vector<PrimExpr> sole_indices;
+    if (separator == begin + 1) sole_indices.push_back(load->indices[begin]);
+    if (rank - 1 == separator + 1) sole_indices.push_back(load->indices[separator]);
+
+    arith::Analyzer ana;
+    auto is_clamped = [&](const PrimExpr& clause) {
+      // The clause as lhs >= rhs
+      PrimExpr lhs, rhs;
+      if (const auto* ge = clause.as<GENode>()) {
+        lhs = ge->a, rhs = ge->b;
+      } else if (const auto* le = clause.as<LENode>()) {
+        lhs = le->b, rhs = le->a;
+      } else if (const auto* gt = clause.as<GTNode>()) {
+        lhs = gt->a, rhs = gt->b + 1;
+      } else if (const auto* lt = clause.as<LTNode>()) {
+        lhs = lt->b, rhs = lt->a + 1;
+      } else {
+        return false;
+      }
+      if (!lhs.dtype().is_int()) return false;
+      return std::any_of(sole_indices.begin(), sole_indices.end(), [&](const PrimExpr& index) {
+        return ana.CanProve(lhs - rhs - index == 0);
+      });
+    };
+    std::vector<PrimExpr> clauses{op->args[0]}, kept;
+    while (!clauses.empty()) {
+      PrimExpr clause = clauses.back();
+      clauses.pop_back();
+      if (const auto* conj = clause.as<AndNode>()) {
+        clauses.push_back(conj->b);
+        clauses.push_back(conj->a);
+      } else if (!is_clamped(clause)) {
+        kept.push_back(clause);
+      }
+    }
+    PrimExpr value = this->VisitExpr(op->args[1]);
+    if (kept.empty()) {
+      return value;
+    }
+    PrimExpr cond = kept[0];
+    for (size_t i = 1; i < kept.size(); ++i) {
+      cond = cond && kept[i];
+    }
+    return Call(op->dtype, op->op, {this->VisitExpr(cond), value, op->args[2]});
+  }
+
+  /*!
+   * \brief Whether the access goes to an image array. Only external buffers are held in image
+   *  arrays, textures allocated inside the function stack the images of an array scope.
+   */
+  template<typename T>
+  bool IsTextureArrayAccess(const T* op, const Buffer& buffer) {
+    return !let_binding_.count(op->buffer->data) &&
+           runtime::IsTextureArrayStorage(GetStorageScope(buffer));
+  }
+
   template<typename T>
   Array<PrimExpr> GetTextureAccessArgs(const T* op, const Buffer& buffer) {
     Array<PrimExpr> args;
@@ -194,8 +379,10 @@ class TextureFlattener : public TextureLoweringBase {
     } else {
       args.push_back(buffer->data);
     }
+    // The outermost axis of an image array selects the image
+    size_t begin = IsTextureArrayAccess(op, buffer) ? 1 : 0;
     Array<PrimExpr> row_dims, row_indices, col_dims, col_indices;
-    for (size_t i = 0; i < op->buffer->shape.size()-1; i++) {
+    for (size_t i = begin; i < op->buffer->shape.size()-1; i++) {
       if (i < DefaultTextureLayoutSeparator(op->buffer->shape.size(), GetStorageScope(buffer))) {
         col_dims.push_back(op->buffer->shape[i]);
         col_indices.push_back(op->indices[i]);
@@ -206,14 +393,114 @@ class TextureFlattener : public TextureLoweringBase {
     }
     PrimExpr row_offset = SimplifyOffset(row_dims, row_indices);
     PrimExpr col_offset = SimplifyOffset(col_dims, col_indices);
-    args.push_back(row_offset);
-    args.push_back(col_offset);
+    args.push_back(HoistCoordinate(row_offset));
+    args.push_back(HoistCoordinate(col_offset));
+    if (begin) {
+      args.push_back(HoistCoordinate(op->indices[0]));
+    }
     return args;
   }
 
+  /*!
+   * \brief Split a texture coordinate into base + sum(c_i * v_i), where the v_i are the
+   *  enclosing loop variables the coordinate is linear in with constant coefficients c_i.
+   *  The base is bound right inside the innermost scope defining one of its variables, and
+   *  shared by all the coordinates with the same base in that scope. Once the inner loops are
+   *  unrolled, their accesses become the hoisted base plus a constant offset.
+   */
+  PrimExpr HoistCoordinate(const PrimExpr& coord) {
+    arith::Analyzer ana;
+    PrimExpr e = ana.Simplify(coord);
+    bool pure = true;
+    std::unordered_set<const VarNode*> used_vars;
+    PostOrderVisit(e, [&](const ObjectRef& node) {
+      if (const auto* var = node.as<VarNode>()) {
+        used_vars.insert(var);
+      } else if (node.as<LoadNode>() || node.as<BufferLoadNode>() || node.as<CallNode>()) {
+        pure = false;
+      }
+    });
+    if (!pure) return e;
+
+    Array<Var> offset_vars;
+    for (const HoistFrame& frame : hoist_frames_) {
+      if (frame.is_loop && used_vars.count(frame.var.get())) {
+        Array<PrimExpr> coeffs = arith::DetectLinearEquation(e, {frame.var});
+        if (coeffs.size() == 2 && coeffs[0].as<IntImmNode>()) {
+          offset_vars.push_back(frame.var);
+        }
+      }
+    }
+    PrimExpr base = e;
+    PrimExpr offset;
+    if (!offset_vars.empty()) {
+      Array<PrimExpr> coeffs = arith::DetectLinearEquation(e, offset_vars);
+      if (coeffs.empty()) return e;
+      for (size_t i = 0; i < offset_vars.size(); ++i) {
+        const auto* coeff = coeffs[i].as<IntImmNode>();
+        if (coeff == nullptr) return e;
+        if (coeff->value == 0) continue;
+        PrimExpr term = offset_vars[i] * coeffs[i];
+        offset = offset.defined() ? offset + term : term;
+      }
+      base = ana.Simplify(coeffs.back());
+    }
+    if (base.as<VarNode>() || base.as<IntImmNode>()) return e;
+
+    // The innermost scope defining a variable of the base
+    int target = -1;
+    bool bound = true;
+    PostOrderVisit(base, [&](const ObjectRef& node) {
+      const auto* var = node.as<VarNode>();
+      if (var == nullptr || !local_vars_.count(var)) return;
+      int frame = static_cast<int>(hoist_frames_.size()) - 1;
+      while (frame >= 0 && hoist_frames_[frame].var.get() != var) --frame;
+      bound = bound && frame >= 0;
+      target = std::max(target, frame);
+    });
+    if (!bound) return e;
+
+    std::vector<std::pair<Var, PrimExpr>>* hoisted =
+        target < 0 ? &top_hoisted_ : &hoist_frames_[target].hoisted;
+    Var var;
+    for (const auto& kv : *hoisted) {
+      if (StructuralEqual()(kv.second, base)) {
+        var = kv.first;
+        break;
+      }
+    }
+    if (!var.defined()) {
+      var = Var("texture_coord", base.dtype());
+      hoisted->emplace_back(var, base);
+    }
+    return offset.defined() ? var + offset : var;
+  }
+
+  static Stmt WrapHoisted(std::vector<std::pair<Var, PrimExpr>>* hoisted, Stmt body) {
+    for (auto it = hoisted->rbegin(); it != hoisted->rend(); ++it) {
+      body = LetStmt(it->first, it->second, body);
+    }
+    return body;
+  }
+
+  // A scope defining a variable, in which the texture coordinates are hoisted
+  struct HoistFrame {
+    Var var;
+    // Whether the variable is a loop variable
+    bool is_loop;
+    // The coordinates bound at the beginning of the scope
+    std::vector<std::pair<Var, PrimExpr>> hoisted;
+  };
+
   // Let binding
   std::unordered_map<Var, PrimExpr, ObjectPtrHash, ObjectPtrEqual> let_binding_;
   std::unordered_map<Buffer, Buffer, ObjectPtrHash, ObjectPtrEqual> buffer_binds_;
+  // The enclosing scopes of the visited statement
+  std::vector<HoistFrame> hoist_frames_;
+  // The coordinates that only depend on variables defined outside the function body
+  std::vector<std::pair<Var, PrimExpr>> top_hoisted_;
+  // The variables defined inside the function body
+  std::unordered_set<const VarNode*> local_vars_;
 };
 
 
@@ -305,11 +592,245 @@ class ExternalBufferForwarding : public TextureLoweringBase {
 };
 
 
+/*!
+ * \brief Share the textures of stages whose live ranges do not overlap.
+ *
+ *  StorageRewrite only plans 1-D allocations, so each texture2d_alloca would
+ *  otherwise become its own runtime allocation. Liveness is computed over the
+ *  same kind of linear sequence as StorageRewrite: loops, kernel launches and
+ *  other compound statements are atomic, so a texture can only be reused by a
+ *  stage that starts after the last stage touching it. Constant sized textures
+ *  of the same type and channel count are merged into one allocation, grown to
+ *  the largest member, which is hoisted to the top of the function.
+ */
+class TextureStorageRewrite : public StmtExprMutator {
+ public:
+  explicit TextureStorageRewrite(int64_t spatial_limit) : spatial_limit_(spatial_limit) {}
+
+  Stmt Rewrite(Stmt body) {
+    LivenessFinder finder;
+    finder(body);
+    Plan(&finder.allocs);
+    if (remap_.empty()) return body;
+    body = this->VisitStmt(body);
+    for (auto it = hoisted_.rbegin(); it != hoisted_.rend(); ++it) {
+      body = LetStmt(it->first, it->second, body);
+    }
+    return body;
+  }
+
+  Stmt VisitStmt_(const LetStmtNode* op) final {
+    if (removed_.count(op)) {
+      return this->VisitStmt(op->body);
+    }
+    return StmtExprMutator::VisitStmt_(op);
+  }
+
+  PrimExpr VisitExpr_(const VarNode* op) final {
+    auto it = remap_.find(op);
+    if (it != remap_.end()) {
+      return it->second;
+    }
+    return GetRef<PrimExpr>(op);
+  }
+
+ private:
+  struct AllocEntry {
+    const LetStmtNode* let;
+    DataType dtype;
+    int64_t width;
+    int64_t height;
+    int64_t channel;
+    // Whether the texture is only accessed through texture2d_load/store
+    bool shareable{true};
+    size_t first{std::numeric_limits<size_t>::max()};
+    size_t last{0};
+  };
+
+  class LivenessFinder : public StmtExprVisitor {
+   public:
+    void VisitStmt(const Stmt& stmt) final {
+      if (in_unit_ || !IsCompound(stmt)) {
+        if (in_unit_) {
+          StmtExprVisitor::VisitStmt(stmt);
+        } else {
+          in_unit_ = true;
+          StmtExprVisitor::VisitStmt(stmt);
+          in_unit_ = false;
+          ++index_;
+        }
+        return;
+      }
+      StmtExprVisitor::VisitStmt(stmt);
+    }
+
+    void VisitStmt_(const LetStmtNode* op) final {
+      const auto* call = op->value.as<CallNode>();
+      if (!in_unit_ && call && call->op.same_as(builtin::texture2d_alloca())) {
+        arith::Analyzer ana;
+        const auto* width = ana.Simplify(call->args[0]).as<IntImmNode>();
+        const auto* height = ana.Simplify(call->args[1]).as<IntImmNode>();
+        const auto* channel = ana.Simplify(call->args[2]).as<IntImmNode>();
+        const auto* ttype = op->var->type_annotation.as<TextureTypeNode>();
+        const auto* ptype = ttype ? ttype->element_type.as<PrimTypeNode>() : nullptr;
+        AllocEntry entry;
+        entry.let = op;
+        entry.dtype = ptype ? ptype->dtype : DataType::Void();
+        entry.width = width ? width->value : 0;
+        entry.height = height ? height->value : 0;
+        entry.channel = channel ? channel->value : 0;
+        entry.shareable = width && height && channel && ptype;
+        index_of_[op->var.get()] = allocs.size();
+        allocs.push_back(entry);
+        this->VisitStmt(op->body);
+        return;
+      }
+      StmtExprVisitor::VisitStmt_(op);
+    }
+
+    void VisitStmt_(const AttrStmtNode* op) final {
+      // Double buffering resizes the texture later on, it cannot be shared
+      if (op->attr_key == attr::double_buffer_scope) {
+        auto it = index_of_.find(op->node.as<VarNode>());
+        if (it != index_of_.end()) {
+          allocs[it->second].shareable = false;
+        }
+      }
+      StmtExprVisitor::VisitStmt_(op);
+    }
+
+    void VisitExpr_(const CallNode* op) final {
+      if (op->op.same_as(builtin::texture2d_load()) || op->op.same_as(builtin::texture2d_store()) ||
+          op->op.same_as(builtin::texture2d_sample())) {
+        if (const auto* var = op->args[0].as<VarNode>()) {
+          auto it = index_of_.find(var);
+          if (it != index_of_.end()) {
+            AllocEntry& entry = allocs[it->second];
+            entry.first = std::min(entry.first, index_);
+            entry.last = std::max(entry.last, index_);
+          }
+          for (size_t i = 1; i < op->args.size(); ++i) {
+            this->VisitExpr(op->args[i]);
+          }
+          return;
+        }
+      }
+      StmtExprVisitor::VisitExpr_(op);
+    }
+
+    void VisitExpr_(const VarNode* op) final {
+      // Any other use may alias the texture
+      auto it = index_of_.find(op);
+      if (it != index_of_.end()) {
+        allocs[it->second].shareable = false;
+      }
+    }
+
+    std::vector<AllocEntry> allocs;
+
+   private:
+    static bool IsCompound(const Stmt& stmt) {
+      if (const auto* attr = stmt.as<AttrStmtNode>()) {
+        return attr->attr_key != attr::thread_extent && attr->attr_key != attr::virtual_thread;
+      }
+      return stmt->IsInstance<SeqStmtNode>() || stmt->IsInstance<LetStmtNode>() ||
+             stmt->IsInstance<AssertStmtNode>() || stmt->IsInstance<AllocateNode>();
+    }
+
+    bool in_unit_{false};
+    size_t index_{0};
+    std::unordered_map<const VarNode*, size_t> index_of_;
+  };
+
+  struct Slot {
+    const AllocEntry* owner;
+    int64_t width;
+    int64_t height;
+    size_t last;
+    std::vector<const AllocEntry*> members;
+  };
+
+  void Plan(std::vector<AllocEntry>* allocs) {
+    std::vector<const AllocEntry*> order;
+    for (const AllocEntry& entry : *allocs) {
+      if (entry.shareable && entry.first <= entry.last) order.push_back(&entry);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const AllocEntry* a, const AllocEntry* b) {
+      return a->first < b->first;
+    });
+    std::vector<Slot> slots;
+    for (const AllocEntry* entry : order) {
+      // Prefer the free slot wasting the least area, then the one growing the least
+      Slot* best = nullptr;
+      bool best_fits = false;
+      int64_t best_cost = 0;
+      for (Slot& slot : slots) {
+        if (slot.last >= entry->first || slot.owner->dtype != entry->dtype ||
+            slot.owner->channel != entry->channel) {
+          continue;
+        }
+        int64_t width = std::max(slot.width, entry->width);
+        int64_t height = std::max(slot.height, entry->height);
+        if (width > spatial_limit_ || height > spatial_limit_) continue;
+        bool fits = width == slot.width && height == slot.height;
+        int64_t cost = fits ? slot.width * slot.height - entry->width * entry->height
+                            : width * height - slot.width * slot.height;
+        if (best == nullptr || (fits && !best_fits) || (fits == best_fits && cost < best_cost)) {
+          best = &slot;
+          best_fits = fits;
+          best_cost = cost;
+        }
+      }
+      if (best == nullptr) {
+        slots.push_back(Slot{entry, entry->width, entry->height, entry->last, {entry}});
+        continue;
+      }
+      best->width = std::max(best->width, entry->width);
+      best->height = std::max(best->height, entry->height);
+      best->last = entry->last;
+      best->members.push_back(entry);
+    }
+
+    for (const Slot& slot : slots) {
+      if (slot.members.size() < 2) continue;
+      const LetStmtNode* let = slot.owner->let;
+      const auto* call = let->value.as<CallNode>();
+      Array<PrimExpr> args = {make_const(call->args[0].dtype(), slot.width),
+                              make_const(call->args[1].dtype(), slot.height),
+                              make_const(call->args[2].dtype(), slot.owner->channel)};
+      hoisted_.emplace_back(let->var, Call(call->dtype, call->op, args));
+      for (const AllocEntry* member : slot.members) {
+        removed_.insert(member->let);
+        if (member != slot.owner) {
+          remap_[member->let->var.get()] = let->var;
+        }
+      }
+    }
+  }
+
+  // Maximum width and height of a merged texture
+  int64_t spatial_limit_;
+  // Texture variables replaced by the variable of the shared allocation
+  std::unordered_map<const VarNode*, Var> remap_;
+  // Allocations subsumed by a shared allocation
+  std::unordered_set<const LetStmtNode*> removed_;
+  // Shared allocations placed at the top of the function
+  std::vector<std::pair<Var, PrimExpr>> hoisted_;
+};
+
 PrimFunc TextureFlatten(PrimFunc func) {
   auto fptr = func.CopyOnWrite();
   ExternalBufferForwarding forward(fptr->buffer_map);
   fptr->body = forward(std::move(fptr->body));
-  fptr->body = TextureFlattener(fptr->buffer_map, forward.GetForwardedBuffers())(std::move(fptr->body));
+  fptr->body = TextureFlattener(fptr->buffer_map, forward.GetForwardedBuffers())
+                   .Flatten(std::move(fptr->body));
+  int64_t spatial_limit = std::numeric_limits<int64_t>::max();
+  if (auto target = func->GetAttr<Target>(tvm::attr::kTarget)) {
+    if (auto limit = target.value()->GetAttr<Integer>("texture_spatial_limit")) {
+      spatial_limit = limit.value()->value;
+    }
+  }
+  fptr->body = TextureStorageRewrite(spatial_limit).Rewrite(std::move(fptr->body));
   return func;
 }
 
@@ -31,6 +31,7 @@
 #include <tvm/tir/stmt_functor.h>
 #include <tvm/tir/transform.h>
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -265,19 +266,28 @@ class Vectorizer : public StmtMutator, public ExprFunctor<PrimExpr(const PrimExp
   PrimExpr VisitExpr_(const CallNode* op) final {
     if (op->op.same_as(builtin::if_then_else())) {
       return MutateIfThenElseExpr_(op);
-    } else if (op->op.same_as(builtin::texture2d_load())) {
-      int lane = 0;
-      Array<PrimExpr> fcd = MutateArray({op->args.back()}, &lane);
-      auto new_args = op->args;
-      new_args.pop_back();
-      new_args.push_back(fcd[0]);
-      return Call(op->dtype.with_lanes(4), op->op, new_args);
-    } else if (op->op.same_as(builtin::texture2d_store())) {
+    } else if (op->op.same_as(builtin::texture2d_load()) ||
+               op->op.same_as(builtin::texture2d_array_load())) {
+      return MutateTextureLoad_(op);
+    } else if (op->op.same_as(builtin::texture2d_sample())) {
+      return MutateTextureSample_(op);
+    } else if (op->op.same_as(builtin::texture2d_store()) ||
+               op->op.same_as(builtin::texture2d_array_store())) {
+      // A store writes the channels of a single texel
+      Array<PrimExpr> new_args{op->args[0]};
+      for (size_t i = 1; i + 1 < op->args.size(); ++i) {
+        PrimExpr coord = this->VisitExpr(op->args[i]);
+        if (coord.dtype().is_vector()) {
+          need_scalarize_ = true;
+          return GetRef<PrimExpr>(op);
+        }
+        new_args.push_back(coord);
+      }
       int lane = 0;
       // Vectorize the value to store
       Array<PrimExpr> value{op->args.back()};
       Array<PrimExpr> mutated_value = MutateArray(value, &lane);
-      Array<PrimExpr> new_args{op->args[0], op->args[1], op->args[2], mutated_value[0]};
+      new_args.push_back(mutated_value[0]);
       return Call(op->dtype.with_lanes(lane), op->op, new_args);
     }
     auto* op_ptr = op->op.as<OpNode>();
@@ -310,6 +320,99 @@ class Vectorizer : public StmtMutator, public ExprFunctor<PrimExpr(const PrimExp
       }
     }
   }
+  // Texture load, one read returns the up to 4 channels of a texel. The arguments are the
+  // texture, the texel coordinates and the channel.
+  PrimExpr MutateTextureLoad_(const CallNode* op) {
+    Array<PrimExpr> coords(op->args.begin() + 1, op->args.end());
+    size_t nchannel = coords.size() - 1;
+    Array<PrimExpr> new_coords = coords;
+    new_coords.MutateByApply([this](const PrimExpr& e) { return this->VisitExpr(e); });
+    if (new_coords.same_as(coords)) {
+      return GetRef<PrimExpr>(op);
+    }
+    auto with_texture = [op](Array<PrimExpr> args) {
+      args.insert(args.begin(), op->args[0]);
+      return args;
+    };
+    // The channels of a single texel, partial texels need a constant first channel to be
+    // selected with a swizzle.
+    bool scalar_texel = std::none_of(new_coords.begin(), new_coords.end() - 1,
+                                     [](const PrimExpr& e) { return e.dtype().is_vector(); });
+    if (scalar_texel) {
+      const auto* ramp = new_coords[nchannel].as<RampNode>();
+      if (ramp && is_one(ramp->stride) &&
+          (ramp->lanes == 4 || (ramp->lanes < 4 && ramp->base.as<IntImmNode>()))) {
+        return Call(op->dtype.with_lanes(ramp->lanes), op->op, with_texture(new_coords));
+      }
+    }
+    // Otherwise the lanes span several texels, e.g. adjacent columns. Every run of lanes that
+    // reads consecutive channels of the same texel becomes one read, and the reads are
+    // concatenated. This needs the scalar coordinates of every lane, which are only known when
+    // the coordinates do not depend on vectorized let bindings.
+    bool uses_vector_let = std::any_of(coords.begin(), coords.end(), [this](const PrimExpr& e) {
+      return ExprUseVar(e, [this](const VarNode* v) {
+        auto it = let_binding_.find(GetRef<Var>(v));
+        return it != let_binding_.end() && !it->second.same_as(GetRef<Var>(v));
+      });
+    });
+    if (uses_vector_let || var_lanes_ > 16) {
+      need_scalarize_ = true;
+      return GetRef<PrimExpr>(op);
+    }
+    arith::Analyzer analyzer;
+    std::vector<Array<PrimExpr>> lane_coords(var_lanes_);
+    for (int i = 0; i < var_lanes_; ++i) {
+      Map<Var, PrimExpr> vmap;
+      vmap.Set(var_, make_const(var_.dtype(), i));
+      for (const PrimExpr& coord : coords) {
+        lane_coords[i].push_back(analyzer.Simplify(Substitute(coord, vmap)));
+      }
+    }
+    auto same_texel = [&](const Array<PrimExpr>& a, const Array<PrimExpr>& b) {
+      for (size_t i = 0; i < nchannel; ++i) {
+        if (!analyzer.CanProve(a[i] == b[i])) return false;
+      }
+      return true;
+    };
+    Array<PrimExpr> reads;
+    for (int begin = 0; begin < var_lanes_;) {
+      Array<PrimExpr> first = lane_coords[begin];
+      PrimExpr first_channel = first[nchannel];
+      int end = begin + 1;
+      if (first_channel.as<IntImmNode>()) {
+        while (end < var_lanes_ && end - begin < 4 && same_texel(lane_coords[end], first) &&
+               analyzer.CanProve(lane_coords[end][nchannel] == first_channel + (end - begin))) {
+          ++end;
+        }
+      }
+      int lanes = end - begin;
+      first.Set(nchannel, lanes == 1 ? first_channel : Ramp(first_channel, 1, lanes));
+      reads.push_back(Call(op->dtype.with_lanes(lanes), op->op, with_texture(first)));
+      begin = end;
+    }
+    return Shuffle::Concat(reads);
+  }
+  // Texture sample, the channels of one filtered texel are vectorized, the lanes of a
+  // vector of coordinates are sampled one by one.
+  PrimExpr MutateTextureSample_(const CallNode* op) {
+    Array<PrimExpr> new_args = op->args;
+    new_args.MutateByApply([this](const PrimExpr& e) { return this->VisitExpr(e); });
+    if (new_args.same_as(op->args)) {
+      return GetRef<PrimExpr>(op);
+    }
+    bool scalar_texel = std::none_of(new_args.begin() + 1, new_args.end() - 1,
+                                     [](const PrimExpr& e) { return e.dtype().is_vector(); });
+    const auto* ramp = new_args.back().as<RampNode>();
+    if (scalar_texel && ramp && is_one(ramp->stride) &&
+        (ramp->lanes == 4 || (ramp->lanes < 4 && ramp->base.as<IntImmNode>()))) {
+      return Call(op->dtype.with_lanes(ramp->lanes), op->op, new_args);
+    }
+    if (scalar_texel && !new_args.back().dtype().is_vector()) {
+      return Call(op->dtype, op->op, new_args);
+    }
+    need_scalarize_ = true;
+    return GetRef<PrimExpr>(op);
+  }
   // Load
   PrimExpr VisitExpr_(const LoadNode* op) final {
     PrimExpr index = this->VisitExpr(op->index);
@@ -24,11 +24,13 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/topi/nn.h>
+#include <tvm/topi/nn/batch_matmul.h>
 #include <tvm/topi/nn/bias_add.h>
 #include <tvm/topi/nn/bnn.h>
 #include <tvm/topi/nn/dense.h>
 #include <tvm/topi/nn/dilate.h>
 #include <tvm/topi/nn/flatten.h>
+#include <tvm/topi/nn/layer_norm.h>
 #include <tvm/topi/nn/local_response_norm.h>
 #include <tvm/topi/nn/mapping.h>
 #include <tvm/topi/nn/pooling.h>
@@ -65,6 +67,16 @@ TVM_REGISTER_GLOBAL("topi.nn.batch_to_space_nd").set_body([](TVMArgs args, TVMRe
   *rv = batch_to_space_nd(args[0], args[1], args[2], args[3]);
 });
 
+TVM_REGISTER_GLOBAL("topi.nn.depthwise_conv2d_NCHW4c")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      *rv = depthwise_conv2d_NCHW4c(args[0], args[1], args[2], args[3], args[4], args[5], args[6]);
+    });
+
+/* Ops from nn/batch_matmul.h */
+TVM_REGISTER_GLOBAL("topi.nn.batch_matmul").set_body([](TVMArgs args, TVMRetValue* rv) {
+  *rv = nn::batch_matmul(args[0], args[1], args[2]);
+});
+
 /* Ops from nn/dense.h */
 TVM_REGISTER_GLOBAL("topi.nn.dense").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = nn::dense(args[0], args[1], args[2], args[3]);
@@ -110,6 +122,13 @@ TVM_REGISTER_GLOBAL("topi.nn.global_pool").set_body([](TVMArgs args, TVMRetValue
   *rv = nn::global_pool(args[0], static_cast<nn::PoolType>(static_cast<int>(args[1])), args[2]);
 });
 
+TVM_REGISTER_GLOBAL("topi.nn.global_pool_multistage")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      *rv = nn::global_pool_multistage(args[0],
+                                       static_cast<nn::PoolType>(static_cast<int>(args[1])),
+                                       args[2], args[3]);
+    });
+
 TVM_REGISTER_GLOBAL("topi.nn.adaptive_pool").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = nn::adaptive_pool(args[0], args[1], static_cast<nn::PoolType>(static_cast<int>(args[2])),
                           args[3]);
@@ -135,6 +154,10 @@ TVM_REGISTER_GLOBAL("topi.nn.softmax").set_body([](TVMArgs args, TVMRetValue* rv
   *rv = nn::softmax(args[0], args[1]);
 });
 
+TVM_REGISTER_GLOBAL("topi.nn.online_softmax").set_body([](TVMArgs args, TVMRetValue* rv) {
+  *rv = nn::online_softmax(args[0], args[1]);
+});
+
 TVM_REGISTER_GLOBAL("topi.nn.log_softmax").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = nn::log_softmax(args[0]);
 });
@@ -144,6 +167,11 @@ TVM_REGISTER_GLOBAL("topi.nn.lrn").set_body([](TVMArgs args, TVMRetValue* rv) {
                 static_cast<double>(args[4]), static_cast<double>(args[5]));
 });
 
+/* Ops from nn/layer_norm.h */
+TVM_REGISTER_GLOBAL("topi.nn.layer_norm").set_body([](TVMArgs args, TVMRetValue* rv) {
+  *rv = nn::layer_norm(args[0], args[1], args[2], args[3], static_cast<double>(args[4]));
+});
+
 /* Ops from nn/bnn.h */
 TVM_REGISTER_GLOBAL("topi.nn.binarize_pack").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = nn::binarize_pack(args[0], args[1]);
@@ -27,7 +27,10 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/target/generic_func.h>
+#include <tvm/topi/arm_cpu/tensor_intrin.h>
+#include <tvm/topi/cuda/batch_matmul.h>
 #include <tvm/topi/cuda/dense.h>
+#include <tvm/topi/cuda/depthwise_conv2d.h>
 #include <tvm/topi/cuda/injective.h>
 #include <tvm/topi/cuda/normalization.h>
 #include <tvm/topi/cuda/pooling.h>
@@ -79,6 +82,15 @@ TVM_REGISTER_GLOBAL("topi.generic.schedule_injective_from_existing")
       *rv = topi::generic::schedule_injective_from_existing(args[0], args[1]);
     });
 
+/* ARM CPU tensor intrinsics */
+TVM_REGISTER_GLOBAL("topi.arm_cpu.dot_int8_int8_int32").set_body_typed([](bool is_signed) {
+  return topi::arm_cpu::DotInt8Int8Int32(is_signed);
+});
+
+TVM_REGISTER_GLOBAL("topi.arm_cpu.mmla_int8_int8_int32").set_body_typed([](bool is_signed) {
+  return topi::arm_cpu::MMLAInt8Int8Int32(is_signed);
+});
+
 /* x86 schedules */
 TVM_REGISTER_GLOBAL("topi.x86.schedule_binarize_pack").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = topi::x86::schedule_binarize_pack(args[0], args[1]);
@@ -148,6 +160,16 @@ TVM_REGISTER_GLOBAL("topi.cuda.dense_cuda").set_body([](TVMArgs args, TVMRetValu
   *rv = cuda::dense_cuda(args[0], args[1], args[2], args[3], args[4]);
 });
 
+TVM_REGISTER_GLOBAL("topi.cuda.schedule_batch_matmul")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      *rv = topi::cuda::schedule_batch_matmul(args[0], args[1]);
+    });
+
+TVM_REGISTER_GLOBAL("topi.cuda.schedule_depthwise_conv2d_NCHW4c")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      *rv = topi::cuda::schedule_depthwise_conv2d_NCHW4c(args[0], args[1]);
+    });
+
 TVM_REGISTER_GLOBAL("topi.cuda.schedule_dense").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = topi::cuda::schedule_dense(args[0], args[1]);
 });
@@ -169,6 +191,11 @@ TVM_REGISTER_GLOBAL("topi.cuda.schedule_global_pool").set_body([](TVMArgs args,
   *rv = topi::cuda::schedule_global_pool(args[0], args[1]);
 });
 
+TVM_REGISTER_GLOBAL("topi.cuda.schedule_global_pool_multistage")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      *rv = topi::cuda::schedule_global_pool_multistage(args[0], args[1]);
+    });
+
 TVM_REGISTER_GLOBAL("topi.cuda.schedule_reduce").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = topi::cuda::schedule_reduce(args[0], args[1]);
 });
@@ -177,6 +204,15 @@ TVM_REGISTER_GLOBAL("topi.cuda.schedule_softmax").set_body([](TVMArgs args, TVMR
   *rv = topi::cuda::schedule_softmax(args[0], args[1]);
 });
 
+TVM_REGISTER_GLOBAL("topi.cuda.schedule_online_softmax")
+    .set_body([](TVMArgs args, TVMRetValue* rv) {
+      *rv = topi::cuda::schedule_online_softmax(args[0], args[1]);
+    });
+
+TVM_REGISTER_GLOBAL("topi.cuda.schedule_layer_norm").set_body([](TVMArgs args, TVMRetValue* rv) {
+  *rv = topi::cuda::schedule_layer_norm(args[0], args[1]);
+});
+
 TVM_REGISTER_GLOBAL("topi.cuda.schedule_lrn").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = topi::cuda::schedule_lrn(args[0]);
 });
@@ -238,7 +274,8 @@ TVM_REGISTER_GENERIC_FUNC(schedule_dense)
     .register_func({"rocm"}, WrapSchedule(topi::rocm::schedule_dense));
 
 TVM_REGISTER_GENERIC_FUNC(schedule_batch_matmul)
-    .set_default(WrapSchedule(topi::generic::default_schedule));
+    .set_default(WrapSchedule(topi::generic::default_schedule))
+    .register_func({"cuda", "gpu"}, WrapSchedule(topi::cuda::schedule_batch_matmul));
 
 TVM_REGISTER_GENERIC_FUNC(schedule_pool)
     .set_default(WrapSchedule(topi::generic::default_schedule))
@@ -170,6 +170,13 @@ TVM_REGISTER_GLOBAL("topi.einsum").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = einsum(args[0], args[1]);
 });
 
+TVM_REGISTER_GLOBAL("topi.einsum_as_matmul").set_body([](TVMArgs args, TVMRetValue* rv) {
+  Tensor result = einsum_as_matmul(args[0], args[1], args[2]);
+  if (result.defined()) {
+    *rv = result;
+  }
+});
+
 TVM_REGISTER_GLOBAL("topi.strided_slice").set_body([](TVMArgs args, TVMRetValue* rv) {
   *rv = strided_slice(args[0], args[1], args[2], args[3], args[4]);
 });
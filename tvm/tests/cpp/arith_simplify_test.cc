@@ -53,6 +53,61 @@ TEST(Simplify, Mod) {
   auto es = ana.canonical_simplify(mod - x);
   ICHECK(tvm::tir::is_zero(es));
 }
+
+TEST(Simplify, MemoizedPerExpression) {
+  tvm::arith::Analyzer ana;
+  auto x = tvm::te::var("x");
+  auto y = tvm::te::var("x");
+  auto e = ana.Simplify(x + 0);
+  EXPECT_TRUE(e.same_as(x));
+  EXPECT_TRUE(ana.Simplify(x + 0).same_as(e));
+  // A different variable of the same name is another expression
+  EXPECT_TRUE(ana.Simplify(y + 0).same_as(y));
+}
+
+TEST(Simplify, MemoDroppedOnBind) {
+  tvm::arith::Analyzer ana;
+  auto x = tvm::te::var("x");
+  auto e = x + 1;
+  EXPECT_FALSE(tvm::tir::is_const_int(ana.Simplify(e)));
+  ana.Bind(x, 3);
+  EXPECT_TRUE(tvm::tir::is_const_int(ana.Simplify(e), 4));
+}
+
+TEST(Simplify, MemoDroppedOnConstraint) {
+  tvm::arith::Analyzer ana;
+  auto x = tvm::te::var("x");
+  auto e = tvm::min(x, 4);
+  EXPECT_FALSE(ana.Simplify(e).same_as(x));
+  {
+    tvm::With<tvm::arith::ConstraintContext> ctx(&ana, x < 4);
+    EXPECT_TRUE(ana.Simplify(e).same_as(x));
+  }
+  EXPECT_FALSE(ana.Simplify(e).same_as(x));
+}
+
+TEST(Simplify, MemoDroppedOnInvalidate) {
+  tvm::arith::Analyzer ana;
+  auto x = tvm::te::var("x");
+  auto e = tvm::min(x, 4);
+  EXPECT_FALSE(ana.Simplify(e).same_as(x));
+  ana.const_int_bound.Update(x, tvm::arith::ConstIntBound(0, 3));
+  ana.InvalidateSimplifyCache();
+  EXPECT_TRUE(ana.Simplify(e).same_as(x));
+}
+
+TEST(Simplify, MemoNotSharedBetweenAnalyzers) {
+  auto x = tvm::te::var("x");
+  auto e = tvm::min(x, 4);
+  {
+    tvm::arith::Analyzer ana;
+    ana.Bind(x, tvm::Range::FromMinExtent(0, 4));
+    EXPECT_TRUE(ana.Simplify(e).same_as(x));
+  }
+  tvm::arith::Analyzer ana;
+  EXPECT_FALSE(ana.Simplify(e).same_as(x));
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/auto_scheduler/measure.h>
+#include <tvm/auto_scheduler/search_policy.h>
+#include <tvm/auto_scheduler/task_scheduler.h>
+
+#include <utility>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::auto_scheduler;
+
+namespace {
+
+// A search policy measuring one cost per round, failing on negative costs, which is exhausted
+// after the last one
+class ScriptedPolicyNode : public SearchPolicyNode {
+ public:
+  std::vector<double> costs;
+  size_t round{0};
+
+  State Search(int num_measure_trials, int early_stopping, int num_measures_per_round,
+               ProgramMeasurer measurer) final {
+    return State();
+  }
+
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> ContinueSearchOneRound(
+      int num_measure, ProgramMeasurer measurer) final {
+    Array<MeasureInput> inputs;
+    Array<MeasureResult> results;
+    if (round >= costs.size()) return {inputs, results};
+    double cost = costs[round++];
+    int error_no = static_cast<int>(cost < 0 ? MeasureErrorNO::kRunTimeoutError
+                                             : MeasureErrorNO::kNoError);
+    for (int i = 0; i < num_measure; ++i) {
+      inputs.push_back(MeasureInput(SearchTask(), State()));
+      results.push_back(MeasureResult({FloatImm(DataType::Float(64), cost)}, error_no, "", 0, 0));
+    }
+    return {inputs, results};
+  }
+
+  static constexpr const char* _type_key = "test.ScriptedPolicy";
+  TVM_DECLARE_FINAL_OBJECT_INFO(ScriptedPolicyNode, SearchPolicyNode);
+};
+
+SearchPolicy Scripted(std::vector<double> costs) {
+  auto node = make_object<ScriptedPolicyNode>();
+  node->costs = std::move(costs);
+  return SearchPolicy(node);
+}
+
+// Tune the tasks of `policies` one trial per round, without early stopping or time budget
+TaskScheduler Tune(const std::vector<double>& weights, const Array<SearchPolicy>& policies,
+                   int n_trials, int early_stopping, double min_latency_share) {
+  Array<SearchTask> tasks(policies.size(), SearchTask());
+  TaskScheduler scheduler(tasks, weights, policies);
+  ProgramMeasurer measurer(ProgramBuilder(), ProgramRunner(), NullOpt, 0, 0);
+  scheduler->Tune(n_trials, 1, measurer, 0, early_stopping, min_latency_share, 0);
+  return scheduler;
+}
+
+}  // namespace
+
+TEST(TaskScheduler, TrialsFollowWeights) {
+  TaskScheduler scheduler = Tune(
+      {10, 1}, {Scripted(std::vector<double>(20, 1.0)), Scripted(std::vector<double>(20, 1.0))},
+      10, -1, 0);
+  // The heavy task gains more from every trial until it had ten times as many
+  EXPECT_EQ(scheduler->task_cts, std::vector<int>({9, 1}));
+  EXPECT_EQ(scheduler->best_costs, std::vector<double>({1.0, 1.0}));
+}
+
+TEST(TaskScheduler, MinLatencyShare) {
+  // The first task is exhausted after the warm up, the second one is 0.1% of the latency
+  Array<SearchPolicy> policies = {Scripted({1.0}), Scripted(std::vector<double>(20, 0.001))};
+  EXPECT_EQ(Tune({1, 1}, policies, 10, -1, 0.01)->task_cts, std::vector<int>({1, 1}));
+  policies = {Scripted({1.0}), Scripted(std::vector<double>(20, 0.001))};
+  EXPECT_EQ(Tune({1, 1}, policies, 10, -1, 0)->task_cts, std::vector<int>({1, 9}));
+}
+
+TEST(TaskScheduler, EarlyStopping) {
+  TaskScheduler scheduler = Tune({1}, {Scripted(std::vector<double>(20, 1.0))}, 20, 3, 0);
+  // The first trial improves, the next four do not
+  EXPECT_EQ(scheduler->task_cts, std::vector<int>({5}));
+}
+
+TEST(TaskScheduler, InvalidTaskFirst) {
+  // The second task fails twice, its cost neither counts in the latency nor stops the first one
+  TaskScheduler scheduler =
+      Tune({1, 1}, {Scripted(std::vector<double>(20, 1.0)), Scripted({-1, -1, 1.0, 1.0})}, 5,
+           -1, 0.01);
+  EXPECT_EQ(scheduler->task_cts, std::vector<int>({2, 3}));
+  EXPECT_EQ(scheduler->best_costs, std::vector<double>({1.0, 1.0}));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -20,11 +20,26 @@
 #include <dmlc/logging.h>
 #include <gtest/gtest.h>
 #include <tvm/auto_scheduler/compute_dag.h>
+#include <tvm/auto_scheduler/cost_model.h>
+#include <tvm/auto_scheduler/feature.h>
+#include <tvm/auto_scheduler/measure_record.h>
+#include <tvm/auto_scheduler/search_task.h>
 #include <tvm/runtime/container.h>
+#include <tvm/target/target.h>
 #include <tvm/te/operation.h>
+#include <tvm/tir/stmt.h>
 #include <tvm/topi/nn.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../src/auto_scheduler/search_policy/sketch_policy.h"
 
 // Compute declaration for test
 tvm::Array<tvm::te::Tensor> conv2d_nchw_bn_relu_func(int N, int H, int W, int CI, int CO,
@@ -62,8 +77,59 @@ tvm::Array<tvm::te::Tensor> conv2d_nchw_bn_relu_func(int N, int H, int W, int CI
   return {data, kernel, bias, bn_scale, bn_offset, out};
 }
 
+// A matmul C[i, j] = sum_k A[i, k] * B[k, j] whose weight B may be stored in another layout
+tvm::Array<tvm::te::Tensor> matmul_layout_free_func(int M, int N, int K) {
+  using namespace tvm;
+  using namespace tvm::te;
+
+  Tensor A = placeholder({M, K}, DataType::Float(32), "A");
+  Tensor B = placeholder({K, N}, DataType::Float(32), "B");
+  IterVar k = reduce_axis(Range(0, K), "k");
+  Map<String, ObjectRef> attrs{{"layout_free_placeholders", Array<Tensor>{B}}};
+  Tensor C = compute(
+      {M, N}, [&](Var i, Var j) { return sum(A[i][k] * B[k][j], {k}); }, "C", "", attrs);
+  return {A, B, C};
+}
+
 using namespace tvm::auto_scheduler;
 
+// The shape of the weight B of a matmul DAG once its layout is rewritten for a state
+std::vector<int64_t> RewrittenWeightShape(const ComputeDAG& dag, const State& state) {
+  tvm::Array<Step> steps = state->transform_steps;
+  ComputeDAG new_dag = dag.RewriteLayout(&steps, LayoutRewriteOption::RewriteForPreTransformed);
+  for (const auto& op : new_dag->ops) {
+    const auto* placeholder = op.as<tvm::te::PlaceholderOpNode>();
+    if (placeholder == nullptr || placeholder->name != "B") continue;
+    std::vector<int64_t> shape;
+    for (const auto& dim : placeholder->shape) shape.push_back(*tvm::tir::as_const_int(dim));
+    return shape;
+  }
+  return {};
+}
+
+// The names of the stages caching a placeholder in a texture over the sketches of a target
+std::vector<std::string> TextureStagesOfSketches(const ComputeDAG& dag, const std::string& target) {
+  tvm::Target opencl(target);
+  HardwareParams hardware_params(-1, 16, 64, 32768, std::numeric_limits<int>::max(), 256, 1, 1);
+  SearchTask task(dag, "texture_cache_read", opencl, opencl, hardware_params,
+                  LayoutRewriteOption::NoRewrite, {});
+  tvm::Map<tvm::String, tvm::ObjectRef> params{
+      {"sample_init_min_population", tvm::Integer(1)},
+      {"gpu_multi_level_tiling_structure", tvm::String("SSSRRSRS")},
+      {"cpu_multi_level_tiling_structure", tvm::String("SSRSRS")},
+      {"max_innermost_split_factor", tvm::Integer(64)},
+      {"disable_change_compute_location", tvm::Integer(0)}};
+  SketchPolicy policy(task, CostModel(), params, 0, 0, tvm::NullOpt);
+  std::vector<std::string> names;
+  for (const State& sketch : policy->GenerateSketches()) {
+    for (const auto& stage : sketch->stages) {
+      const std::string& name = stage->op->name;
+      if (name.find(".texture") != std::string::npos) names.push_back(name);
+    }
+  }
+  return names;
+}
+
 // Test Access Analyzer
 TEST(ComputeDAG, AccessAnalyzer) {
   const auto& tensors = conv2d_nchw_bn_relu_func(1, 224, 224, 3, 64, 7, 2, 3);
@@ -171,6 +237,264 @@ TEST(ComputeDAG, AccessAnalyzer) {
   }
 }
 
+TEST(ComputeDAG, ReplayCache) {
+  ComputeDAG dag(conv2d_nchw_bn_relu_func(1, 14, 14, 8, 8, 3, 1, 1));
+  // A copy of the DAG without a cache replays every step
+  auto plain_node = tvm::make_object<ComputeDAGNode>(*dag.operator->());
+  plain_node->replay_cache = nullptr;
+  ComputeDAG plain(plain_node);
+  int relu = 10;
+
+  State s1 = dag->init_state;
+  s1.split(relu, s1->stages[relu]->iters[1], {tvm::Integer(2)});
+  // s2 shares the split step of s1 and replays from its cached schedule
+  State s2 = s1;
+  s2.split(relu, s2->stages[relu]->iters[3], {tvm::Integer(7)});
+  for (const State& state : {s1, s2, s1, s2}) {
+    EXPECT_EQ(dag.InferBound(state).ToStr(), plain.InferBound(state).ToStr());
+  }
+
+  // The DAGs are cached by the records of the steps, equal steps of other states hit them
+  ComputeDAG replayed = dag.ReplayAndGetDAG(s2->transform_steps);
+  EXPECT_TRUE(dag.ReplayAndGetDAG(s2->transform_steps).same_as(replayed));
+  State s3 = dag->init_state;
+  s3.split(relu, s3->stages[relu]->iters[1], {tvm::Integer(2)});
+  s3.split(relu, s3->stages[relu]->iters[3], {tvm::Integer(7)});
+  EXPECT_TRUE(dag.ReplayAndGetDAG(s3->transform_steps).same_as(replayed));
+  EXPECT_FALSE(dag.ReplayAndGetDAG(s1->transform_steps).same_as(replayed));
+  EXPECT_FALSE(plain.ReplayAndGetDAG(s2->transform_steps).same_as(replayed));
+}
+
+TEST(CostModel, GBDTModelFit) {
+  using namespace tvm::auto_scheduler;
+  // Every state has two rows of three features; its throughput is the mean of the first feature.
+  auto make_state = [](float a, float b) {
+    return std::vector<float>{2, a, 0.5f, 1.0f - a, b, 0.5f, 1.0f - b};
+  };
+  std::vector<std::vector<float>> features;
+  std::vector<float> throughputs;
+  for (int i = 0; i < 400; ++i) {
+    float a = (i % 20 + 1) / 20.0f, b = (i / 20 % 20 + 1) / 20.0f;
+    features.push_back(make_state(a, b));
+    throughputs.push_back((a + b) / 2);
+  }
+
+  GBDTModel model(32, 4, 0.3, 0);
+  model->Fit(features, throughputs);
+
+  std::vector<float> scores;
+  model->PredictFeatures({make_state(0.1f, 0.1f), make_state(0.5f, 0.5f), make_state(0.9f, 0.9f),
+                          std::vector<float>{}},
+                         &scores);
+  ASSERT_EQ(scores.size(), 4);
+  EXPECT_LT(scores[0], scores[1]);
+  EXPECT_LT(scores[1], scores[2]);
+  EXPECT_NEAR(scores[2], 0.9f, 0.2f);
+  EXPECT_EQ(scores[3], -std::numeric_limits<float>::infinity());
+}
+
+// A cost model recording the workloads of its training records
+class RecordingModelNode : public CostModelNode {
+ public:
+  void Update(const tvm::Array<MeasureInput>& inputs,
+              const tvm::Array<MeasureResult>& results) final {
+    for (const auto& inp : inputs) workload_keys.push_back(inp->task->workload_key);
+  }
+  void Predict(const SearchTask& task, const tvm::Array<State>& states,
+               std::vector<float>* scores) final {}
+
+  std::vector<std::string> workload_keys;
+};
+
+TEST(CostModel, UpdateFromFileFiltersWorkloads) {
+  ComputeDAG dag(conv2d_nchw_bn_relu_func(1, 14, 14, 8, 8, 3, 1, 1));
+  std::string path = std::string(testing::TempDir()) + "auto_scheduler_update_from_file.json";
+  {
+    tvm::Array<MeasureInput> inputs;
+    tvm::Array<MeasureResult> results;
+    for (const char* key : {"similar", "unrelated", "current"}) {
+      SearchTask task(dag, key, tvm::Target("llvm"), tvm::Target(), tvm::NullOpt,
+                      LayoutRewriteOption::NoRewrite, {});
+      inputs.push_back(MeasureInput(task, dag->init_state));
+      results.push_back(MeasureResult({tvm::FloatImm(tvm::DataType::Float(64), 1e-3)}, 0, "",
+                                      1.0, 0));
+    }
+    std::ofstream ofs(path);
+    WriteMeasureRecords(&ofs, inputs, results);
+  }
+  RecordingModelNode model;
+  model.UpdateFromFile(path, {"similar", "current"});
+  EXPECT_EQ(model.workload_keys, (std::vector<std::string>{"similar", "current"}));
+  RecordingModelNode all;
+  all.UpdateFromFile(path, {});
+  EXPECT_EQ(all.workload_keys.size(), 3U);
+  std::remove(path.c_str());
+}
+
+// Measure records of the workload keys `keys` with mean costs `costs`, negative for errors
+std::pair<tvm::Array<MeasureInput>, tvm::Array<MeasureResult>> MakeRecords(
+    const ComputeDAG& dag, const std::vector<std::string>& keys, const std::vector<double>& costs,
+    const tvm::Target& target) {
+  tvm::Array<MeasureInput> inputs;
+  tvm::Array<MeasureResult> results;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    SearchTask task(dag, keys[i], target, tvm::Target(), tvm::NullOpt,
+                    LayoutRewriteOption::NoRewrite, {});
+    inputs.push_back(MeasureInput(task, dag->init_state));
+    double cost = costs[i] < 0 ? -costs[i] : costs[i];
+    results.push_back(MeasureResult({tvm::FloatImm(tvm::DataType::Float(64), cost)},
+                                    costs[i] < 0 ? 1 : 0, "", 1.0, 0));
+  }
+  return {inputs, results};
+}
+
+// The cost of the best record of a key on llvm, -1 when there is none
+double BestCost(RecordStore store, const std::string& key) {
+  auto inp = tvm::make_object<MeasureInputNode>();
+  auto res = tvm::make_object<MeasureResultNode>();
+  if (!store->QueryBest(key, tvm::Target("llvm"), inp.get(), res.get())) return -1;
+  EXPECT_EQ(inp->task->workload_key, key);
+  return res->costs[0].as<tvm::FloatImmNode>()->value;
+}
+
+void RemoveStore(const std::string& path) {
+  std::remove(path.c_str());
+  std::remove((path + ".index").c_str());
+}
+
+TEST(RecordStore, QueryBest) {
+  ComputeDAG dag(conv2d_nchw_bn_relu_func(1, 14, 14, 8, 8, 3, 1, 1));
+  std::string path = std::string(testing::TempDir()) + "auto_scheduler_record_store.bin";
+  RemoveStore(path);
+  RecordStore store(path);
+  // the failed record of "a" is cheaper but not valid
+  auto records = MakeRecords(dag, {"a", "a", "b", "a"}, {3e-3, 1e-3, 2e-3, -1e-4},
+                             tvm::Target("llvm"));
+  store->Append(records.first, records.second);
+  EXPECT_DOUBLE_EQ(BestCost(store, "a"), 1e-3);
+  EXPECT_DOUBLE_EQ(BestCost(store, "b"), 2e-3);
+  EXPECT_EQ(BestCost(store, "c"), -1);
+  // the targets are matched by their string
+  auto inp = tvm::make_object<MeasureInputNode>();
+  auto res = tvm::make_object<MeasureResultNode>();
+  EXPECT_FALSE(store->QueryBest("a", tvm::Target("c"), inp.get(), res.get()));
+
+  // another writer appends after the index was loaded, a new store scans the records
+  RecordStore writer(path);
+  records = MakeRecords(dag, {"a", "c"}, {5e-4, 4e-3}, tvm::Target("llvm"));
+  writer->Append(records.first, records.second);
+  RecordStore reopened(path);
+  EXPECT_DOUBLE_EQ(BestCost(reopened, "a"), 5e-4);
+  EXPECT_DOUBLE_EQ(BestCost(reopened, "c"), 4e-3);
+
+  // an invalid index is rebuilt from the records
+  {
+    std::ofstream index(path + ".index", std::ios::binary | std::ios::trunc);
+    index << "broken";
+  }
+  RecordStore rebuilt(path);
+  EXPECT_DOUBLE_EQ(BestCost(rebuilt, "a"), 5e-4);
+  EXPECT_DOUBLE_EQ(BestCost(rebuilt, "b"), 2e-3);
+  RemoveStore(path);
+}
+
+TEST(RecordStore, MergeAndImportLog) {
+  ComputeDAG dag(conv2d_nchw_bn_relu_func(1, 14, 14, 8, 8, 3, 1, 1));
+  std::string dir = testing::TempDir();
+  std::string path = dir + "auto_scheduler_record_store_main.bin";
+  std::string other_path = dir + "auto_scheduler_record_store_other.bin";
+  std::string log_path = dir + "auto_scheduler_record_store_log.json";
+  RemoveStore(path);
+  RemoveStore(other_path);
+  RecordStore other(other_path);
+  auto records = MakeRecords(dag, {"a", "b"}, {2e-3, 3e-3}, tvm::Target("llvm"));
+  other->Append(records.first, records.second);
+  {
+    std::ofstream ofs(log_path);
+    records = MakeRecords(dag, {"a", "c"}, {1e-3, 6e-3}, tvm::Target("llvm"));
+    WriteMeasureRecords(&ofs, records.first, records.second);
+  }
+  RecordStore store(path);
+  store->Merge(other_path);
+  EXPECT_DOUBLE_EQ(BestCost(store, "a"), 2e-3);
+  store->ImportLog(log_path);
+  EXPECT_DOUBLE_EQ(BestCost(store, "a"), 1e-3);
+  EXPECT_DOUBLE_EQ(BestCost(store, "b"), 3e-3);
+  EXPECT_DOUBLE_EQ(BestCost(RecordStore(path), "c"), 6e-3);
+  RemoveStore(path);
+  RemoveStore(other_path);
+  std::remove(log_path.c_str());
+}
+
+// A loop nest storing to every element of a 3-D buffer of the given scope
+tvm::tir::Stmt StoreLoopNest(const std::string& scope) {
+  using namespace tvm;
+  using namespace tvm::tir;
+  Var ptr("A", PointerType(PrimType(DataType::Float(32))));
+  Buffer buf(ptr, DataType::Float(32), {4, 8, 4}, {}, 0, "A", scope, 0, 0, kDefault);
+  Var i("i"), j("j"), k("k");
+  Stmt body = BufferStore(buf, FloatImm(DataType::Float(32), 1.0), {i, j, k});
+  body = For(k, 0, 4, ForKind::kSerial, body);
+  body = For(j, 0, 8, ForKind::kSerial, body);
+  return For(i, 0, 4, ForKind::kSerial, body);
+}
+
+TEST(Feature, TextureFeaturesBehindFlag) {
+  const int max_n_bufs = 5;
+  std::vector<std::string> names, texture_names;
+  GetPerStoreFeatureName(max_n_bufs, &names);
+  GetPerStoreFeatureName(max_n_bufs, &texture_names, true);
+  EXPECT_EQ(texture_names.size(), names.size() + max_n_bufs * 5);
+
+  std::vector<float> features, texture_features;
+  GetPerStoreFeature(StoreLoopNest("global.texture"), 64, max_n_bufs, &features);
+  GetPerStoreFeature(StoreLoopNest("global.texture"), 64, max_n_bufs, &texture_features, true);
+  // The store count, then the features of the one store
+  ASSERT_EQ(features.size(), names.size() + 1);
+  ASSERT_EQ(texture_features.size(), texture_names.size() + 1);
+  EXPECT_TRUE(std::equal(features.begin(), features.end(), texture_features.begin()));
+  size_t is_texture = std::find(texture_names.begin(), texture_names.end(), "B0.is_texture") -
+                      texture_names.begin();
+  ASSERT_LT(is_texture, texture_names.size());
+  EXPECT_EQ(texture_features[is_texture + 1], 1.0f);
+
+  texture_features.clear();
+  GetPerStoreFeature(StoreLoopNest("global"), 64, max_n_bufs, &texture_features, true);
+  EXPECT_EQ(texture_features[is_texture + 1], 0.0f);
+}
+
+TEST(ComputeDAG, RewriteLayoutForTexture) {
+  ComputeDAG dag(matmul_layout_free_func(4, 16, 8));
+  int matmul = 2;
+  // The tiles of B follow the loops j.0, j.1 and k of the schedule
+  State state = dag->init_state;
+  state.split(matmul, state->stages[matmul]->iters[1], {tvm::Integer(8)});
+  EXPECT_EQ(RewrittenWeightShape(dag, state), std::vector<int64_t>({2, 8, 8}));
+  {
+    // Adreno weights end in a texel of 4 taken out of the innermost tile
+    tvm::With<tvm::Target> target_scope(tvm::Target("opencl -device=adreno"));
+    EXPECT_EQ(RewrittenWeightShape(dag, state), std::vector<int64_t>({2, 8, 2, 4}));
+  }
+  // Without a tile of a multiple of 4 the layout is kept
+  ComputeDAG odd(matmul_layout_free_func(4, 6, 6));
+  tvm::With<tvm::Target> target_scope(tvm::Target("opencl -device=adreno"));
+  EXPECT_EQ(RewrittenWeightShape(odd, odd->init_state), std::vector<int64_t>({6, 6}));
+}
+
+TEST(SketchPolicy, AddTextureCacheRead) {
+  // A has an innermost axis of one texel, B does not and is read from global memory
+  ComputeDAG dag(matmul_layout_free_func(16, 16, 4));
+  std::vector<std::string> names = TextureStagesOfSketches(dag, "opencl -device=adreno");
+  ASSERT_FALSE(names.empty());
+  for (const auto& name : names) EXPECT_EQ(name, "A.texture");
+  // Only Adreno targets cache their inputs in textures
+  EXPECT_TRUE(TextureStagesOfSketches(dag, "opencl").empty());
+  // An image of 4 x 8192 texels does not fit the spatial limit in any layout
+  ComputeDAG wide(matmul_layout_free_func(8192, 16, 4));
+  EXPECT_TRUE(TextureStagesOfSketches(wide, "opencl -device=adreno -texture_spatial_limit=4096")
+                  .empty());
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
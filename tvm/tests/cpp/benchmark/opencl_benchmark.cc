@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file opencl_benchmark.cc
+ * \brief Micro-benchmarks of the OpenCL kernel launch and the host device copies, skipped when
+ *  the runtime is built without OpenCL or no OpenCL device is present.
+ */
+#include <benchmark/benchmark.h>
+#include <dmlc/memory_io.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "../../../src/runtime/meta_data.h"
+
+namespace tvm {
+namespace runtime {
+
+static constexpr TVMContext kOpenCLCtx{kDLOpenCL, 0};
+
+/*! \brief Whether an OpenCL device is available, reported as the error of the state if not. */
+static bool HasOpenCL(benchmark::State& state) {
+  if (Registry::Get("device_api.opencl") == nullptr) {
+    state.SkipWithError("The runtime is built without OpenCL");
+    return false;
+  }
+  TVMRetValue exist;
+  DeviceAPI::Get(kOpenCLCtx)->GetAttr(kOpenCLCtx, kExist, &exist);
+  if (exist.type_code() == kTVMNullptr || !static_cast<int>(exist)) {
+    state.SkipWithError("No OpenCL device");
+    return false;
+  }
+  return true;
+}
+
+/*! \brief A module of one empty kernel, loaded the way a compiled library loads it. */
+static Module EmptyKernelModule() {
+  std::string source =
+      "// Function: tvm_bench_empty\n__kernel void tvm_bench_empty(__global float* a) {}\n";
+  std::unordered_map<std::string, FunctionInfo> fmap;
+  fmap["tvm_bench_empty"] = {
+      "tvm_bench_empty", {DLDataType{kTVMOpaqueHandle, 64, 1}}, {"blockIdx.x", "threadIdx.x"}};
+  std::string blob;
+  dmlc::MemoryStringStream writer(&blob);
+  writer.Write(std::string("cl"));
+  writer.Write(fmap);
+  writer.Write(source);
+  dmlc::MemoryStringStream reader(&blob);
+  const PackedFunc* load = Registry::Get("runtime.module.loadbinary_opencl");
+  ICHECK(load != nullptr);
+  return (*load)(static_cast<void*>(&reader));
+}
+
+static void BM_OpenCLKernelLaunch(benchmark::State& state) {
+  if (!HasOpenCL(state)) return;
+  Module mod = EmptyKernelModule();
+  PackedFunc f = mod.GetFunction("tvm_bench_empty");
+  NDArray arr = NDArray::Empty({1024}, DLDataType{kDLFloat, 32, 1}, kOpenCLCtx);
+  void* data = arr->data;
+  // The first call builds the program
+  f(data, 1, 64);
+  DeviceAPI* api = DeviceAPI::Get(kOpenCLCtx);
+  api->StreamSync(kOpenCLCtx, nullptr);
+  for (auto _ : state) {
+    f(data, 1, 64);
+  }
+  api->StreamSync(kOpenCLCtx, nullptr);
+}
+BENCHMARK(BM_OpenCLKernelLaunch);
+
+static void BM_OpenCLKernelLaunchSync(benchmark::State& state) {
+  if (!HasOpenCL(state)) return;
+  Module mod = EmptyKernelModule();
+  PackedFunc f = mod.GetFunction("tvm_bench_empty");
+  NDArray arr = NDArray::Empty({1024}, DLDataType{kDLFloat, 32, 1}, kOpenCLCtx);
+  void* data = arr->data;
+  f(data, 1, 64);
+  DeviceAPI* api = DeviceAPI::Get(kOpenCLCtx);
+  api->StreamSync(kOpenCLCtx, nullptr);
+  for (auto _ : state) {
+    f(data, 1, 64);
+    api->StreamSync(kOpenCLCtx, nullptr);
+  }
+}
+BENCHMARK(BM_OpenCLKernelLaunchSync);
+
+static void BM_OpenCLCopyToDevice(benchmark::State& state) {
+  if (!HasOpenCL(state)) return;
+  int64_t n = state.range(0);
+  NDArray host = NDArray::Empty({n}, DLDataType{kDLFloat, 32, 1}, {kDLCPU, 0});
+  NDArray dev = NDArray::Empty({n}, DLDataType{kDLFloat, 32, 1}, kOpenCLCtx);
+  for (auto _ : state) {
+    dev.CopyFrom(host);
+    DeviceAPI::Get(kOpenCLCtx)->StreamSync(kOpenCLCtx, nullptr);
+  }
+  state.SetBytesProcessed(state.iterations() * n * 4);
+}
+BENCHMARK(BM_OpenCLCopyToDevice)->Arg(1 << 10)->Arg(1 << 20);
+
+static void BM_OpenCLCopyFromDevice(benchmark::State& state) {
+  if (!HasOpenCL(state)) return;
+  int64_t n = state.range(0);
+  NDArray host = NDArray::Empty({n}, DLDataType{kDLFloat, 32, 1}, {kDLCPU, 0});
+  NDArray dev = NDArray::Empty({n}, DLDataType{kDLFloat, 32, 1}, kOpenCLCtx);
+  for (auto _ : state) {
+    dev.CopyTo(host);
+    DeviceAPI::Get(kOpenCLCtx)->StreamSync(kOpenCLCtx, nullptr);
+  }
+  state.SetBytesProcessed(state.iterations() * n * 4);
+}
+BENCHMARK(BM_OpenCLCopyFromDevice)->Arg(1 << 10)->Arg(1 << 20);
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,209 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file runtime_benchmark.cc
+ * \brief Micro-benchmarks of the runtime hot paths: the PackedFunc calls, the parallel launch,
+ *  the workspace and texture pools and the NDArray views.
+ *
+ *  Run the `cppbench` target with --benchmark_format=json or --benchmark_out=<file> for
+ *  machine readable results.
+ */
+#include <benchmark/benchmark.h>
+#include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "../../../src/runtime/texture.h"
+
+namespace tvm {
+namespace runtime {
+
+static void BM_PackedFuncCallNoArgs(benchmark::State& state) {
+  PackedFunc f([](TVMArgs args, TVMRetValue* rv) {});
+  for (auto _ : state) {
+    f();
+  }
+}
+BENCHMARK(BM_PackedFuncCallNoArgs);
+
+static void BM_PackedFuncCallArgs(benchmark::State& state) {
+  PackedFunc f([](TVMArgs args, TVMRetValue* rv) {
+    int a = args[0];
+    double b = args[1];
+    void* c = args[2];
+    *rv = a + static_cast<int>(b) + (c != nullptr);
+  });
+  int value = 0;
+  for (auto _ : state) {
+    int r = f(1, 2.0, &value);
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(BM_PackedFuncCallArgs);
+
+static void BM_TypedPackedFuncCall(benchmark::State& state) {
+  TypedPackedFunc<int(int, int)> f([](int a, int b) { return a + b; });
+  for (auto _ : state) {
+    int r = f(1, 2);
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(BM_TypedPackedFuncCall);
+
+static void BM_PackedFuncCallNDArray(benchmark::State& state) {
+  PackedFunc f([](TVMArgs args, TVMRetValue* rv) {
+    DLTensor* t = args[0];
+    benchmark::DoNotOptimize(t->data);
+  });
+  NDArray arr = NDArray::Empty({16}, DLDataType{kDLFloat, 32, 1}, {kDLCPU, 0});
+  for (auto _ : state) {
+    f(arr);
+  }
+}
+BENCHMARK(BM_PackedFuncCallNDArray);
+
+static void BM_RegistryGet(benchmark::State& state) {
+  for (auto _ : state) {
+    const PackedFunc* f = Registry::Get("device_api.cpu");
+    benchmark::DoNotOptimize(f);
+  }
+}
+BENCHMARK(BM_RegistryGet);
+
+static int ParallelNoop(int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+  benchmark::DoNotOptimize(task_id);
+  return 0;
+}
+
+static void BM_ParallelLaunch(benchmark::State& state) {
+  int num_task = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    TVMBackendParallelLaunch(ParallelNoop, nullptr, num_task);
+  }
+}
+// 0 launches one task per worker of the thread pool
+BENCHMARK(BM_ParallelLaunch)->Arg(0)->Arg(1)->Arg(4);
+
+static void BM_WorkspaceAllocFree(benchmark::State& state) {
+  uint64_t nbytes = static_cast<uint64_t>(state.range(0));
+  for (auto _ : state) {
+    void* ptr = TVMBackendAllocWorkspace(kDLCPU, 0, nbytes, kDLFloat, 32);
+    benchmark::DoNotOptimize(ptr);
+    TVMBackendFreeWorkspace(kDLCPU, 0, ptr);
+  }
+}
+BENCHMARK(BM_WorkspaceAllocFree)->Arg(256)->Arg(64 << 10)->Arg(16 << 20);
+
+static void BM_WorkspaceAllocFreeNested(benchmark::State& state) {
+  // The allocation pattern of a fused kernel with several intermediate buffers
+  std::vector<void*> ptrs(8);
+  for (auto _ : state) {
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+      ptrs[i] = TVMBackendAllocWorkspace(kDLCPU, 0, (i + 1) << 12, kDLFloat, 32);
+    }
+    for (size_t i = ptrs.size(); i > 0; --i) {
+      TVMBackendFreeWorkspace(kDLCPU, 0, ptrs[i - 1]);
+    }
+  }
+}
+BENCHMARK(BM_WorkspaceAllocFreeNested);
+
+/*! \brief A device API serving textures from the host heap, to measure the pool alone. */
+class HostTextureAPI final : public DeviceAPI {
+ public:
+  void SetDevice(TVMContext ctx) final {}
+  void GetAttr(TVMContext ctx, DeviceAttrKind kind, TVMRetValue* rv) final {}
+  void* AllocDataSpace(TVMContext ctx, size_t nbytes, size_t alignment,
+                       DLDataType type_hint) final {
+    return std::malloc(nbytes);
+  }
+  void* AllocDataSpace(TVMContext ctx, int ndim, const int64_t* shape, DLDataType dtype,
+                       Optional<String> mem_scope) final {
+    size_t nbytes = (dtype.bits * dtype.lanes + 7) / 8;
+    for (int i = 0; i < ndim; ++i) nbytes *= static_cast<size_t>(shape[i]);
+    return std::malloc(nbytes);
+  }
+  void FreeDataSpace(TVMContext ctx, void* ptr) final { std::free(ptr); }
+  void StreamSync(TVMContext ctx, TVMStreamHandle stream) final {}
+
+ protected:
+  void CopyDataFromTo(const void* from, size_t from_offset, void* to, size_t to_offset,
+                      size_t num_bytes, TVMContext ctx_from, TVMContext ctx_to,
+                      DLDataType type_hint, TVMStreamHandle stream) final {}
+};
+
+static void BM_TextureAllocFree(benchmark::State& state) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  TVMContext ctx{kDLCPU, 0};
+  DLDataType dtype{kDLFloat, 16, 1};
+  size_t width = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    void* ptr = pool.AllocTexture(ctx, width, width / 2, 4, dtype);
+    benchmark::DoNotOptimize(ptr);
+    pool.FreeTexture(ctx, ptr);
+  }
+}
+BENCHMARK(BM_TextureAllocFree)->Arg(64)->Arg(1024);
+
+static void BM_TextureAllocFreeMixed(benchmark::State& state) {
+  // The textures of a network with a few distinct shapes, freed out of order
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  TVMContext ctx{kDLCPU, 0};
+  DLDataType dtype{kDLFloat, 16, 1};
+  std::vector<void*> ptrs(6);
+  for (auto _ : state) {
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+      ptrs[i] = pool.AllocTexture(ctx, 56 << (i % 3), 56 << (i / 3), 4, dtype);
+    }
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+      pool.FreeTexture(ctx, ptrs[(i * 5) % ptrs.size()]);
+    }
+  }
+}
+BENCHMARK(BM_TextureAllocFreeMixed);
+
+static void BM_NDArrayCreateView(benchmark::State& state) {
+  NDArray arr = NDArray::Empty({1024, 1024}, DLDataType{kDLFloat, 32, 1}, {kDLCPU, 0});
+  std::vector<int64_t> shape{512, 2048};
+  for (auto _ : state) {
+    NDArray view = arr.CreateView(shape, arr->dtype);
+    benchmark::DoNotOptimize(view->data);
+  }
+}
+BENCHMARK(BM_NDArrayCreateView);
+
+static void BM_NDArrayEmpty(benchmark::State& state) {
+  std::vector<int64_t> shape{static_cast<int64_t>(state.range(0))};
+  for (auto _ : state) {
+    NDArray arr = NDArray::Empty(shape, DLDataType{kDLFloat, 32, 1}, {kDLCPU, 0});
+    benchmark::DoNotOptimize(arr->data);
+  }
+}
+BENCHMARK(BM_NDArrayEmpty)->Arg(256)->Arg(1 << 20);
+
+}  // namespace runtime
+}  // namespace tvm
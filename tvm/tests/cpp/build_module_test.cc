@@ -25,6 +25,7 @@
 #include <tvm/topi/cuda/injective.h>
 
 #include <cmath>
+#include <cstdlib>
 #include <string>
 
 TEST(BuildModule, Basic) {
@@ -200,6 +201,85 @@ TEST(BuildModule, Heterogeneous) {
   }
 }
 
+TEST(BuildModule, IndependentBranchesOnStreams) {
+  /* The add and the sub only share their inputs, with two streams they are issued on
+   * different streams:
+   *
+   *          A    B
+   *          |\  /|
+   *          | \/ |
+   *          | /\ |
+   *    elemwise_add elemwise_sub  (gpu)
+   */
+  using namespace tvm;
+  using namespace tvm::te;
+  if (!tvm::runtime::RuntimeEnabled("cuda")) {
+    LOG(INFO) << "Skip streams test because cuda is not enabled.";
+    return;
+  }
+  auto target_cuda = Target("cuda");
+  const int n = 4;
+  Array<PrimExpr> shape{n};
+  auto A = placeholder(shape, DataType::Float(32), "A");
+  auto B = placeholder(shape, DataType::Float(32), "B");
+  auto elemwise_add = compute(
+      A->shape, [&A, &B](PrimExpr i) { return A[i] + B[i]; }, "elemwise_add");
+  auto elemwise_sub = compute(
+      A->shape, [&A, &B](PrimExpr i) { return A[i] - B[i]; }, "elemwise_sub");
+  With<Target> cuda_scope(target_cuda);
+  auto s1 = topi::cuda::schedule_injective(target_cuda, {elemwise_add});
+  auto s2 = topi::cuda::schedule_injective(target_cuda, {elemwise_sub});
+  std::unordered_map<Tensor, Buffer> binds;
+  auto lowered_add = lower(s1, {A, B, elemwise_add}, "elemwise_add", binds);
+  auto lowered_sub = lower(s2, {A, B, elemwise_sub}, "elemwise_sub", binds);
+  lowered_add->Update(lowered_sub);
+  Map<tvm::Target, IRModule> inputs = {{target_cuda, lowered_add}};
+  auto module = build(inputs, Target("llvm"));
+
+  std::string json = R"({
+    "nodes": [{"op": "null", "name": "A", "inputs": []},
+              {"op": "null", "name": "B", "inputs": []},
+              {"op": "tvm_op", "name": "elemwise_add", "inputs": [[0, 0, 0], [1, 0, 0]],
+               "attrs": {"flatten_data": "0", "func_name": "elemwise_add", "num_inputs": "2",
+                         "num_outputs": "1"}},
+              {"op": "tvm_op", "name": "elemwise_sub", "inputs": [[0, 0, 0], [1, 0, 0]],
+               "attrs": {"flatten_data": "0", "func_name": "elemwise_sub", "num_inputs": "2",
+                         "num_outputs": "1"}}],
+    "arg_nodes": [0, 1],
+    "node_row_ptr": [0, 1, 2, 3, 4],
+    "heads": [[2, 0, 0], [3, 0, 0]],
+    "attrs": {
+      "storage_id": ["list_int", [0, 1, 2, 3]],
+      "shape": ["list_shape", [[4], [4], [4], [4]]],
+      "device_index": ["list_int", [2, 2, 2, 2]],
+      "dltype": ["list_str", ["float32", "float32", "float32", "float32"]]
+    }
+  })";
+  auto a_val = runtime::NDArray::Empty({n}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto b_val = runtime::NDArray::Empty({n}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  for (int i = 0; i < n; i++) {
+    static_cast<float*>(a_val->data)[i] = i;
+    static_cast<float*>(b_val->data)[i] = 2.0 * i;
+  }
+  setenv("TVM_GRAPH_RUNTIME_NUM_STREAMS", "2", 1);
+  runtime::Module mod = (*tvm::runtime::Registry::Get("tvm.graph_runtime.create"))(
+      json, module, static_cast<int>(kDLGPU), 0);
+  unsetenv("TVM_GRAPH_RUNTIME_NUM_STREAMS");
+  // The GPU streams are a run mode of their own
+  EXPECT_ANY_THROW(mod.GetFunction("set_memory_budget")(int64_t(1) << 20));
+  mod.GetFunction("set_input")("A", a_val);
+  mod.GetFunction("set_input")("B", b_val);
+  mod.GetFunction("run")();
+  runtime::NDArray add = mod.GetFunction("get_output")(0);
+  runtime::NDArray sub = mod.GetFunction("get_output")(1);
+  add = add.CopyTo({kDLCPU, 0});
+  sub = sub.CopyTo({kDLCPU, 0});
+  for (int i = 0; i < n; ++i) {
+    EXPECT_FLOAT_EQ(static_cast<float*>(add->data)[i], 3.0f * i);
+    EXPECT_FLOAT_EQ(static_cast<float*>(sub->data)[i], -1.0f * i);
+  }
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
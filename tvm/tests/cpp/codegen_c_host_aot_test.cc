@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/stmt.h>
+
+#include <string>
+
+using namespace tvm;
+
+namespace {
+
+// A placeholder function carrying `value` as its attribute `key`
+tir::PrimFunc Placeholder(const char* symbol, const char* key, const ObjectRef& value) {
+  Map<String, ObjectRef> dict;
+  dict.Set(key, value);
+  dict.Set(tvm::attr::kGlobalSymbol, String(symbol));
+  return tir::PrimFunc(Array<tir::Var>(), tir::SeqStmt(Array<tir::Stmt>()), VoidType(),
+                       Map<tir::Var, tir::Buffer>(), DictAttrs(dict));
+}
+
+/*!
+ * \brief The C source of the ahead-of-time executor of a graph of two float32[4] entries, the
+ *  input in storage id 0 and the output in storage id 1.
+ * \param call_funcs The fused functions called on (input, output).
+ */
+std::string AOTSource(const Array<String>& call_funcs) {
+  Array<Array<Integer>> call_args;
+  for (size_t i = 0; i < call_funcs.size(); ++i) call_args.push_back({0, 1});
+  Map<String, ObjectRef> plan = {
+      {"entry_storage_ids", Array<Integer>{0, 1}},
+      {"entry_shapes", Array<Array<Integer>>{{4}, {4}}},
+      {"entry_dtypes", Array<String>{"float32", "float32"}},
+      {"storage_params", Array<String>{"", ""}},
+      {"input_entries", Array<Integer>{0}},
+      {"output_entries", Array<Integer>{1}},
+      {"call_funcs", call_funcs},
+      {"call_args", call_args}};
+  IRModule mod(
+      {{GlobalVar(runtime::symbol::tvm_lookup_storage_arena),
+        Placeholder(runtime::symbol::tvm_lookup_storage_arena, tir::attr::kStorageArena,
+                    Array<Integer>{16, 16})},
+       {GlobalVar(runtime::symbol::tvm_run_aot),
+        Placeholder(runtime::symbol::tvm_run_aot, tir::attr::kAOTPlan, plan)}});
+  Target target("c -executor=aot -link-params=1");
+  runtime::Module built = (*runtime::Registry::Get("target.build.c"))(mod, target);
+  return built->GetSource("c");
+}
+
+}  // namespace
+
+TEST(AOTExecutor, EntriesOverTheArena) {
+  std::string source = AOTSource({});
+  std::string arena = runtime::symbol::tvm_storage_arena;
+  EXPECT_NE(source.find("static int64_t __tvm_aot_shape_0[] = {4};"), std::string::npos);
+  EXPECT_NE(source.find("{(void*)" + arena + ".sid_0, {kDLCPU, 0}, 1, {2, 32, 1}, "
+                        "__tvm_aot_shape_0, NULL, 0},"),
+            std::string::npos);
+  EXPECT_NE(source.find("{(void*)" + arena + ".sid_1, {kDLCPU, 0}, 1, {2, 32, 1}, "
+                        "__tvm_aot_shape_1, NULL, 0},"),
+            std::string::npos);
+}
+
+TEST(AOTExecutor, CopiesInputsAndOutputs) {
+  std::string source = AOTSource({});
+  EXPECT_NE(source.find(std::string(runtime::symbol::tvm_run_aot) + "(void* args"),
+            std::string::npos);
+  EXPECT_NE(source.find("if (num_args != 2) {"), std::string::npos);
+  size_t copy_in = source.find("memcpy(__tvm_aot_entries[0].data, ");
+  size_t copy_out = source.find(", __tvm_aot_entries[1].data, 16);");
+  ASSERT_NE(copy_in, std::string::npos);
+  ASSERT_NE(copy_out, std::string::npos);
+  EXPECT_LT(copy_in, copy_out);
+}
+
+TEST(AOTExecutor, MissingFusedFunction) {
+  EXPECT_THROW(AOTSource({"fused_add"}), std::exception);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,176 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <functional>
+#include <string>
+
+using namespace tvm;
+using namespace tvm::tir;
+
+namespace {
+
+/*!
+ * \brief Generate the OpenCL source of a kernel.
+ * \param body The body of the kernel of its buffer argument.
+ * \param target The target of the kernel.
+ */
+std::string BuildSource(const std::function<Stmt(const Var&)>& body, const Target& target) {
+  Var a("A", PointerType(PrimType(DataType::Float(32))));
+  PrimFunc f({a}, body(a));
+  f = WithAttr(std::move(f), tvm::attr::kGlobalSymbol, String("kernel0"));
+  f = WithAttr(std::move(f), tvm::attr::kTarget, target);
+  f = WithAttr(std::move(f), tvm::attr::kCallingConv, Integer(CallingConv::kDeviceKernelLaunch));
+  IRModule mod({{GlobalVar("kernel0"), f}});
+  runtime::Module built = (*runtime::Registry::Get("target.build.opencl"))(mod, target);
+  return built->GetSource("cl");
+}
+
+IterVar ThreadAxis(const std::string& tag, int extent) {
+  return IterVar(Range(0, extent), Var(tag), IterVarType::kThreadIndex, tag);
+}
+
+// A one dimensional kernel storing 1 in each of the 16 * 64 elements
+Stmt FillKernel(const Var& a) {
+  IterVar bx = ThreadAxis("blockIdx.x", 16);
+  IterVar tx = ThreadAxis("threadIdx.x", 64);
+  Stmt store = Store(a, FloatImm(DataType::Float(32), 1), bx->var * 64 + tx->var, const_true());
+  return AttrStmt(bx, attr::thread_extent, 16, AttrStmt(tx, attr::thread_extent, 64, store));
+}
+
+}  // namespace
+
+TEST(CodeGenOpenCL, LocalSizeFixedByDefault) {
+  std::string source = BuildSource(FillKernel, Target("opencl"));
+  EXPECT_NE(source.find("reqd_work_group_size(64, 1, 1)"), std::string::npos);
+  EXPECT_NE(source.find("get_local_id(0)"), std::string::npos);
+  EXPECT_EQ(source.find("get_global_id"), std::string::npos);
+}
+
+TEST(CodeGenOpenCL, LocalSizeSearch) {
+  Target target(Map<String, ObjectRef>{{"kind", String("opencl")},
+                                       {"local_size_search", Bool(true)}});
+  std::string source = BuildSource(FillKernel, target);
+  EXPECT_NE(source.find("work_group_size_hint(64, 1, 1)"), std::string::npos);
+  EXPECT_EQ(source.find("reqd_work_group_size"), std::string::npos);
+  EXPECT_NE(source.find("get_global_id(0) % 64"), std::string::npos);
+  EXPECT_NE(source.find("get_global_id(0) / 64"), std::string::npos);
+}
+
+TEST(CodeGenOpenCL, TextureArrayParams) {
+  Var arr("arr", TextureType(PrimType(DataType::Float(32))));
+  Var img("img", TextureType(PrimType(DataType::Float(32))));
+  Var plain("plain", PointerType(PrimType(DataType::Float(32))));
+  PrimExpr value = Broadcast(FloatImm(DataType::Float(32), 1), 4);
+  IterVar bx = ThreadAxis("blockIdx.x", 16);
+  Stmt body = SeqStmt(
+      {Evaluate(Call(DataType::Handle(), builtin::texture2d_array_store(),
+                     {arr, bx->var, 0, 1, value})),
+       Store(plain, FloatImm(DataType::Float(32), 1), bx->var, const_true()),
+       Evaluate(Call(DataType::Handle(), builtin::texture2d_store(), {img, bx->var, 0, value}))});
+  PrimFunc f({arr, plain, img}, AttrStmt(bx, attr::thread_extent, 16, body));
+  Target target("opencl");
+  f = WithAttr(std::move(f), tvm::attr::kGlobalSymbol, String("kernel0"));
+  f = WithAttr(std::move(f), tvm::attr::kTarget, target);
+  f = WithAttr(std::move(f), tvm::attr::kCallingConv, Integer(CallingConv::kDeviceKernelLaunch));
+  IRModule mod({{GlobalVar("kernel0"), f}});
+  runtime::Module built = (*runtime::Registry::Get("target.build.opencl"))(mod, target);
+  std::string source = built->GetSource("cl");
+  // Only the parameter accessed as an array is an image array
+  EXPECT_NE(source.find("__write_only image2d_array_t arr"), std::string::npos);
+  EXPECT_NE(source.find("__write_only image2d_t img"), std::string::npos);
+}
+
+TEST(CodeGenOpenCL, Dp4a) {
+  const auto* lower = runtime::Registry::Get("tvm.intrin.rule.opencl.dp4a");
+  ASSERT_NE(lower, nullptr);
+  PrimExpr lhs = Broadcast(IntImm(DataType::Int(8), 1), 4);
+  PrimExpr rhs = Ramp(IntImm(DataType::Int(8), 1), IntImm(DataType::Int(8), 1), 4);
+  PrimExpr dot = (*lower)(Call(DataType::Int(32), builtin::dp4a(), {lhs, rhs, 5}));
+  std::string source = BuildSource(
+      [&dot](const Var& a) {
+        IterVar bx = ThreadAxis("blockIdx.x", 16);
+        Stmt store = Store(a, cast(DataType::Float(32), dot), bx->var, const_true());
+        return AttrStmt(bx, attr::thread_extent, 16, store);
+      },
+      Target("opencl"));
+  // The helper picks the dot product extension of the device when the source is compiled
+  EXPECT_NE(source.find("tvm_dp4a("), std::string::npos);
+  EXPECT_NE(source.find("#define tvm_dp4a(a, b, c) ((c) + dot(a, b))"), std::string::npos);
+  EXPECT_NE(source.find("arm_dot_acc(a, b, c)"), std::string::npos);
+}
+
+TEST(CodeGenOpenCL, BuildOptions) {
+  EXPECT_EQ(BuildSource(FillKernel, Target("opencl")).find("// Build options:"),
+            std::string::npos);
+  Target target(Map<String, ObjectRef>{{"kind", String("opencl")},
+                                       {"build-options", Array<String>{"-cl-mad-enable"}}});
+  // the options of the target, then those of the pragmas in the kernel
+  std::string source = BuildSource(
+      [](const Var& a) {
+        return AttrStmt(a, attr::pragma_build_options, StringImm("-cl-fast-relaxed-math"),
+                        FillKernel(a));
+      },
+      target);
+  EXPECT_NE(source.find("// Build options: -cl-mad-enable -cl-fast-relaxed-math\n"),
+            std::string::npos);
+}
+
+TEST(SplitHostDevice, BuildOptionsPragma) {
+  Var a("A", PointerType(PrimType(DataType::Float(32))));
+  Stmt body = AttrStmt(a, attr::pragma_build_options, StringImm("-cl-mad-enable"),
+                       AttrStmt(a, attr::pragma_build_options, StringImm("-qcom-accelerate"),
+                                FillKernel(a)));
+  PrimFunc f({a}, body);
+  f = WithAttr(std::move(f), tvm::attr::kGlobalSymbol, String("host"));
+  f = WithAttr(std::move(f), tvm::attr::kTarget, Target("opencl"));
+  IRModule mod = transform::SplitHostDevice()(IRModule({{GlobalVar("host"), f}}));
+  int num_kernels = 0;
+  for (const auto& kv : mod->functions) {
+    auto func = Downcast<PrimFunc>(kv.second);
+    if (kv.first->name_hint == "host") {
+      // the pragmas are consumed
+      PostOrderVisit(func->body, [](const ObjectRef& n) {
+        const auto* attr = n.as<AttrStmtNode>();
+        EXPECT_TRUE(attr == nullptr || attr->attr_key != attr::pragma_build_options);
+      });
+      continue;
+    }
+    ++num_kernels;
+    EXPECT_EQ(func->GetAttr<String>(attr::kDeviceBuildOptions).value_or(""),
+              "-cl-mad-enable -qcom-accelerate");
+  }
+  EXPECT_EQ(num_kernels, 1);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../../src/runtime/compressed_param.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+const DLDataType kFloat32 = {kDLFloat, 32, 1};
+
+NDArray FromVector(const std::vector<float>& values) {
+  NDArray array = NDArray::Empty({static_cast<int64_t>(values.size())}, kFloat32, kCPU);
+  array.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  return array;
+}
+
+std::vector<float> ToVector(const NDArray& array) {
+  std::vector<float> values(array->shape[0]);
+  array.CopyToBytes(values.data(), values.size() * sizeof(float));
+  return values;
+}
+
+// Compress `values` with `scheme` and decompress them back
+std::vector<float> RoundTrip(const std::vector<float>& values, const std::string& scheme,
+                             int block_size) {
+  NDArray compressed = CompressParam(FromVector(values), scheme, block_size);
+  EXPECT_TRUE(IsCompressedParam(compressed));
+  NDArray out = NDArray::Empty({static_cast<int64_t>(values.size())}, kFloat32, kCPU);
+  DecompressParam(compressed, out);
+  return ToVector(out);
+}
+
+}  // namespace
+
+TEST(CompressedParam, Float16) {
+  // halves and powers of two are exact in half floats
+  std::vector<float> values{0.5f, -1.25f, 3.0f, 1024.0f, 0.0f};
+  EXPECT_EQ(RoundTrip(values, "float16", 32), values);
+  NDArray compressed = CompressParam(FromVector(values), "float16", 32);
+  CompressedParam p = ParseCompressedParam(compressed);
+  EXPECT_EQ(p.header->scheme, CompressionScheme::kFloat16);
+  EXPECT_EQ(p.shape, std::vector<int64_t>{5});
+  EXPECT_EQ(p.num_blocks, 0);
+  EXPECT_EQ(compressed->shape[0], static_cast<int64_t>(p.data_offset + 5 * sizeof(uint16_t)));
+}
+
+TEST(CompressedParam, Int8Blocks) {
+  std::vector<float> values{1.0f, -0.5f, 0.1f, -0.2f, 0.0f, 0.0f, 100.0f};
+  std::vector<float> out = RoundTrip(values, "int8", 2);
+  // every block has its own scale, a block of zeros stays zero
+  std::vector<float> max_abs{1.0f, 0.2f, 0.0f, 100.0f};
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_NEAR(out[i], values[i], max_abs[i / 2] / 127 / 2 + 1e-6) << i;
+  }
+  EXPECT_EQ(out[4], 0.0f);
+  EXPECT_EQ(ParseCompressedParam(CompressParam(FromVector(values), "int8", 2)).num_blocks, 4);
+}
+
+TEST(CompressedParam, Int4OddCount) {
+  std::vector<float> values{7.0f, -7.0f, 3.0f, -1.0f, 0.5f};
+  std::vector<float> out = RoundTrip(values, "int4", 8);
+  // one block of scale 1, two elements per byte
+  for (size_t i = 0; i < 4; ++i) EXPECT_EQ(out[i], values[i]) << i;
+  EXPECT_NEAR(out[4], 0.5f, 0.5f);
+  CompressedParam p = ParseCompressedParam(CompressParam(FromVector(values), "int4", 8));
+  EXPECT_EQ(p.num_blocks, 1);
+}
+
+TEST(CompressedParam, DecompressedTypeAndShape) {
+  NDArray compressed = CompressParam(FromVector({0.25f, -2.0f}), "int8", 2);
+  NDArray half = NDArray::Empty({2}, DLDataType{kDLFloat, 16, 1}, kCPU);
+  // the decompressed type must be the type of the compressed parameter
+  EXPECT_ANY_THROW(DecompressParam(compressed, half));
+  NDArray wrong_shape = NDArray::Empty({3}, kFloat32, kCPU);
+  EXPECT_ANY_THROW(DecompressParam(compressed, wrong_shape));
+}
+
+TEST(CompressedParam, NotCompressed) {
+  NDArray bytes = NDArray::Empty({64}, DLDataType{kDLUInt, 8, 1}, kCPU);
+  std::fill_n(static_cast<uint8_t*>(bytes->data), 64, 0);
+  EXPECT_FALSE(IsCompressedParam(bytes));
+  EXPECT_FALSE(IsCompressedParam(FromVector(std::vector<float>(16, 1.0f))));
+  EXPECT_ANY_THROW(CompressParam(bytes, "int8", 2));
+}
+
+TEST(CompressedParam, CompressParams) {
+  NDArray ints = NDArray::Empty({4}, DLDataType{kDLInt, 32, 1}, kCPU);
+  Map<String, NDArray> params{{"w", FromVector({1.0f, 2.0f})}, {"i", ints}};
+  Map<String, NDArray> compressed =
+      (*Registry::Get("runtime.CompressParams"))(params, String("float16"), 32);
+  EXPECT_TRUE(IsCompressedParam(compressed["w"]));
+  // only the float parameters are compressed
+  EXPECT_TRUE(compressed["i"].same_as(ints));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
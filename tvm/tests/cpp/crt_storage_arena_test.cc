@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/stmt.h>
+
+#include <string>
+
+using namespace tvm;
+
+namespace {
+
+// The C source of a module holding the static arena of a memory plan
+std::string ArenaSource(const Array<Integer>& sizes) {
+  Map<String, ObjectRef> dict;
+  dict.Set(tir::attr::kStorageArena, sizes);
+  dict.Set(tvm::attr::kGlobalSymbol, String(runtime::symbol::tvm_lookup_storage_arena));
+  tir::PrimFunc prim(Array<tir::Var>(), tir::SeqStmt(Array<tir::Stmt>()), VoidType(),
+                     Map<tir::Var, tir::Buffer>(), DictAttrs(dict));
+  IRModule mod({{GlobalVar(runtime::symbol::tvm_lookup_storage_arena), prim}});
+  Target target("c -link-storage=1");
+  runtime::Module built = (*runtime::Registry::Get("target.build.c"))(mod, target);
+  return built->GetSource("c");
+}
+
+}  // namespace
+
+TEST(StorageArena, GraphCodegenKeepsLargeSizes) {
+  // A 4GB input is returned as is, its storage id is the only one of the plan
+  relay::Var x("x", relay::TensorType({1024, 1024, 1024}, DataType::Float(32)));
+  IRModule mod = IRModule::FromExpr(relay::Function({x}, x, Type(), {}));
+  mod = relay::transform::InferType()(mod);
+  auto func = Downcast<relay::Function>(mod->Lookup("main"));
+
+  runtime::Module codegen = (*runtime::Registry::Get("relay.build_module._GraphRuntimeCodegen"))();
+  Map<Integer, Target> targets = {{Integer(static_cast<int>(kDLCPU)), Target("c")}};
+  codegen.GetFunction("init")(nullptr, targets);
+  codegen.GetFunction("codegen")(func);
+  Array<Integer> sizes = codegen.GetFunction("get_storage_sizes")();
+  ASSERT_EQ(sizes.size(), 1U);
+  EXPECT_EQ(sizes[0]->value, int64_t{4} << 30);
+}
+
+TEST(StorageArena, LargeMember) {
+  std::string source = ArenaSource({Integer(64), IntImm(DataType::Int(64), int64_t{3} << 30)});
+  EXPECT_NE(source.find("sid_0[64]"), std::string::npos);
+  EXPECT_NE(source.find("sid_1[3221225472]"), std::string::npos);
+}
+
+TEST(StorageArena, AcquiredByOneRuntime) {
+  std::string source = ArenaSource({Integer(64), Integer(0)});
+  // Left out storage ids have no member
+  EXPECT_EQ(source.find("sid_1"), std::string::npos);
+  // The arena is handed out once until it is released
+  std::string arena = runtime::symbol::tvm_storage_arena;
+  EXPECT_NE(source.find("static int " + arena + "_in_use;"), std::string::npos);
+  EXPECT_NE(source.find("case " + std::to_string(runtime::kStorageArenaAcquire) + ":"),
+            std::string::npos);
+  EXPECT_NE(source.find("if (" + arena + "_in_use)"), std::string::npos);
+  EXPECT_NE(source.find("case " + std::to_string(runtime::kStorageArenaRelease) + ":\n        " +
+                        arena + "_in_use = 0;"),
+            std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
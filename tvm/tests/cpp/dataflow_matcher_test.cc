@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/relay/dataflow_matcher.h>
+#include <tvm/relay/dataflow_pattern.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+Var TensorVar(const std::string& name, const std::string& dtype) {
+  return Var(name, TensorType({4}, DataType(runtime::String2DLDataType(dtype))));
+}
+
+Call Add(const Expr& lhs, const Expr& rhs) { return Call(Op::Get("add"), {lhs, rhs}); }
+
+Function Typed(const Function& func) {
+  IRModule mod = transform::InferType()(IRModule::FromExpr(func));
+  return Downcast<Function>(mod->Lookup("main"));
+}
+
+PackedFunc AcceptAll() {
+  return PackedFunc([](runtime::TVMArgs args, runtime::TVMRetValue* rv) { *rv = true; });
+}
+
+}  // namespace
+
+TEST(DFPatternMatcher, RootFilterByOperator) {
+  DFPattern pattern = IsOp("nn.relu")({IsOp("add")({IsWildcard(), IsWildcard()})});
+  PatternRootFilter filter(pattern);
+  Var x = TensorVar("x", "float32");
+  Call add = Add(x, x);
+  Call relu(Op::Get("nn.relu"), {add});
+  EXPECT_TRUE(filter.MayMatch(relu));
+  EXPECT_FALSE(filter.MayMatch(add));
+  EXPECT_FALSE(filter.MayMatch(x));
+  EXPECT_FALSE(filter.MayMatchAny(ExprNodeIndex(Function({x}, add, Type(), {}))));
+  EXPECT_TRUE(filter.MayMatchAny(ExprNodeIndex(Function({x}, relu, Type(), {}))));
+}
+
+TEST(DFPatternMatcher, RootFilterAlternativesAndWildcards) {
+  Var x = TensorVar("x", "float32");
+  PatternRootFilter alt(IsOp("add")({IsWildcard(), IsWildcard()}) || IsVar("x"));
+  EXPECT_TRUE(alt.MayMatch(Add(x, x)));
+  EXPECT_TRUE(alt.MayMatch(x));
+  EXPECT_FALSE(alt.MayMatch(Call(Op::Get("nn.relu"), {x})));
+  // The matcher matches a divide pattern with a multiply call
+  PatternRootFilter divide(IsOp("divide")({IsWildcard(), IsWildcard()}));
+  EXPECT_TRUE(divide.MayMatch(Call(Op::Get("multiply"), {x, x})));
+  EXPECT_TRUE(PatternRootFilter(IsWildcard()).MayMatch(x));
+}
+
+TEST(DFPatternMatcher, StaleCheckedType) {
+  Var x = TensorVar("x", "float32");
+  Var y = TensorVar("y", "float16");
+  Function func = Typed(Function({x}, Add(x, x), Type(), {}));
+  // A copy-on-write of a typed call keeps its checked type, float32, for float16 arguments
+  Call call = Downcast<Call>(func->body);
+  call.CopyOnWrite()->args = {y, y};
+  ASSERT_TRUE(call->checked_type_.defined());
+  EXPECT_TRUE(MatchPattern(IsWildcard().HasDtype("float16"), call));
+  EXPECT_FALSE(MatchPattern(IsWildcard().HasDtype("float32"), call));
+}
+
+TEST(DFPatternMatcher, PartitionTypedAndUntyped) {
+  Var x = TensorVar("x", "float32");
+  Function func({x}, Call(Op::Get("nn.relu"), {Add(x, x)}), Type(), {});
+  DFPattern pattern = IsOp("add")({IsWildcard(), IsWildcard()}).HasDtype("float32");
+  for (bool types_inferred : {false, true}) {
+    Function input = types_inferred ? Typed(func) : func;
+    auto partitioned =
+        Downcast<Function>(PartitionPattern(pattern, input, {}, AcceptAll(), types_inferred));
+    const auto* relu = partitioned->body.as<CallNode>();
+    ASSERT_NE(relu, nullptr);
+    const auto* group = relu->args[0].as<CallNode>();
+    ASSERT_NE(group, nullptr);
+    EXPECT_NE(group->op.as<FunctionNode>(), nullptr);
+  }
+  // The float16 pattern matches nothing
+  DFPattern fp16 = IsOp("add")({IsWildcard(), IsWildcard()}).HasDtype("float16");
+  auto partitioned = Downcast<Function>(PartitionPattern(fp16, func, {}, AcceptAll()));
+  EXPECT_NE(partitioned->body.as<CallNode>()->args[0].as<CallNode>()->op.as<OpNode>(), nullptr);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
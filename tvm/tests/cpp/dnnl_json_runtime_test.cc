@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace tvm::runtime;
+
+namespace {
+
+// The DNNL runtime is only built with USE_DNNL_CODEGEN
+bool HasDNNL() { return Registry::Get("runtime.DNNLJSONRuntimeCreate") != nullptr; }
+
+const DLDataType kFloat32 = {kDLFloat, 32, 1};
+const TVMContext kCPU = {kDLCPU, 0};
+const int64_t kChannels = 8;
+const int64_t kSize = 6;
+
+std::string Conv2DNode(int data, int weight) {
+  return R"({"op": "kernel", "name": "nn.conv2d", "inputs": [[)" + std::to_string(data) +
+         ", 0, 0], [" + std::to_string(weight) + R"(, 0, 0]],
+     "attrs": {"num_inputs": "2", "num_outputs": "1", "strides": [["1", "1"]],
+               "padding": [["1", "1", "1", "1"]], "groups": [["1"]],
+               "data_layout": [["NCHW"]], "kernel_layout": [["OIHW"]],
+               "dtype": [["float32"]], "shape": [[[1, 8, 6, 6]]]}})";
+}
+
+// conv2d(relu(conv2d(x, w1)), w2), the convolutions keeping the layouts DNNL picks in between
+std::string ConvReluConvGraph() {
+  return R"({
+  "nodes": [
+    {"op": "input", "name": "x", "attrs": {"dtype": [["float32"]], "shape": [[[1, 8, 6, 6]]]}},
+    {"op": "const", "name": "w1", "attrs": {"dtype": [["float32"]], "shape": [[[8, 8, 3, 3]]]}},
+    )" + Conv2DNode(0, 1) + R"(,
+    {"op": "kernel", "name": "nn.relu", "inputs": [[2, 0, 0]],
+     "attrs": {"num_inputs": "1", "num_outputs": "1",
+               "dtype": [["float32"]], "shape": [[[1, 8, 6, 6]]]}},
+    {"op": "const", "name": "w2", "attrs": {"dtype": [["float32"]], "shape": [[[8, 8, 3, 3]]]}},
+    )" + Conv2DNode(3, 4) + R"(
+  ],
+  "arg_nodes": [0, 1, 4],
+  "heads": [[5, 0, 0]],
+  "node_row_ptr": [0, 1, 2, 3, 4, 5, 6]
+})";
+}
+
+NDArray Filled(const std::vector<int64_t>& shape, int seed) {
+  NDArray array = NDArray::Empty(shape, kFloat32, kCPU);
+  float* data = static_cast<float*>(array->data);
+  int64_t size = 1;
+  for (int64_t dim : shape) size *= dim;
+  for (int64_t i = 0; i < size; ++i) data[i] = static_cast<float>((i * 7 + seed) % 11 - 5) / 8;
+  return array;
+}
+
+// A padded 3x3 convolution of stride 1 in NCHW and OIHW
+std::vector<float> Conv2D(const std::vector<float>& x, const NDArray& w) {
+  const float* weight = static_cast<const float*>(w->data);
+  std::vector<float> y(kChannels * kSize * kSize, 0.0f);
+  for (int64_t o = 0; o < kChannels; ++o) {
+    for (int64_t h = 0; h < kSize; ++h) {
+      for (int64_t v = 0; v < kSize; ++v) {
+        float sum = 0.0f;
+        for (int64_t i = 0; i < kChannels; ++i) {
+          for (int64_t kh = 0; kh < 3; ++kh) {
+            for (int64_t kw = 0; kw < 3; ++kw) {
+              int64_t ih = h + kh - 1, iw = v + kw - 1;
+              if (ih < 0 || ih >= kSize || iw < 0 || iw >= kSize) continue;
+              float w = weight[((o * kChannels + i) * 3 + kh) * 3 + kw];
+              sum += x[(i * kSize + ih) * kSize + iw] * w;
+            }
+          }
+        }
+        y[(o * kSize + h) * kSize + v] = sum;
+      }
+    }
+  }
+  return y;
+}
+
+}  // namespace
+
+TEST(DNNLJSONRuntime, BlockedLayoutsAcrossRuns) {
+  if (!HasDNNL()) return;
+  Module mod = (*Registry::Get("runtime.DNNLJSONRuntimeCreate"))(
+      String("dnnl_0"), String(ConvReluConvGraph()), Array<String>{"w1", "w2"});
+  NDArray w1 = Filled({kChannels, kChannels, 3, 3}, 1);
+  NDArray w2 = Filled({kChannels, kChannels, 3, 3}, 2);
+  mod.GetFunction("__init_dnnl_0")(Array<NDArray>{w1, w2});
+  PackedFunc run = mod.GetFunction("dnnl_0");
+
+  // The weights are reordered once at Init, every run sees them and only copies its input
+  for (int seed : {3, 4}) {
+    NDArray x = Filled({1, kChannels, kSize, kSize}, seed);
+    NDArray y = NDArray::Empty({1, kChannels, kSize, kSize}, kFloat32, kCPU);
+    run(x, y);
+    const float* x_data = static_cast<const float*>(x->data);
+    std::vector<float> x_plain(x_data, x_data + kChannels * kSize * kSize);
+    std::vector<float> expected = Conv2D(x_plain, w1);
+    for (float& v : expected) v = std::max(v, 0.0f);
+    expected = Conv2D(expected, w2);
+    const float* y_data = static_cast<const float*>(y->data);
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_NEAR(y_data[i], expected[i], 1e-4f) << "at " << i << " of run " << seed;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
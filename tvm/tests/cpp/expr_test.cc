@@ -19,8 +19,13 @@
 
 #include <dmlc/logging.h>
 #include <gtest/gtest.h>
+#include <tvm/node/structural_hash.h>
+#include <tvm/relay/expr.h>
 #include <tvm/te/operation.h>
 
+#include <thread>
+#include <vector>
+
 TEST(Expr, Basic) {
   using namespace tvm;
   using namespace tvm::tir;
@@ -43,6 +48,27 @@ TEST(ExprNodeRef, Basic) {
   ICHECK(GetRef<ObjectRef>(op).same_as(z));
 }
 
+TEST(RelayConstant, DataHash) {
+  using namespace tvm;
+  auto data = runtime::NDArray::Empty({64}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  for (int i = 0; i < 64; ++i) static_cast<float*>(data->data)[i] = i;
+  relay::Constant a(data);
+  std::vector<size_t> hashes(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    threads.emplace_back([&a, &hashes, i]() { hashes[i] = StructuralHash()(a); });
+  }
+  for (auto& thread : threads) thread.join();
+  for (size_t hash : hashes) EXPECT_EQ(hash, hashes[0]);
+  // A constant with a copy of the data hashes the same, one with other data does not
+  relay::Constant b(data.CopyTo({kDLCPU, 0}));
+  EXPECT_EQ(StructuralHash()(b), hashes[0]);
+  EXPECT_EQ(a->DataHash(), b->DataHash());
+  auto other = data.CopyTo({kDLCPU, 0});
+  static_cast<float*>(other->data)[0] = -1;
+  EXPECT_NE(relay::Constant(other)->DataHash(), a->DataHash());
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
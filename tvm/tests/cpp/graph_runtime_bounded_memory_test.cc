@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <map>
+#include <string>
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+const int64_t kSize = 256;
+
+// A kernel adding the single element of its second input to the first one
+class KernelModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final { return "test_kernels"; }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name != "add_w") return PackedFunc();
+    return PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      DLTensor* x = args[0];
+      DLTensor* w = args[1];
+      DLTensor* out = args[2];
+      for (int64_t i = 0; i < x->shape[0]; ++i) {
+        static_cast<float*>(out->data)[i] =
+            static_cast<float*>(x->data)[i] + static_cast<float*>(w->data)[0];
+      }
+    });
+  }
+};
+
+// out = x + w1[0] + w2[0] + w3[0] through a chain of three kernels, each with its own storage
+std::string AddNode(const std::string& name, int input, int param) {
+  return R"({"op": "tvm_op", "name": ")" + name +
+         R"(", "attrs": {"func_name": "add_w", "num_inputs": "2", "num_outputs": "1",
+         "flatten_data": "0"}, "inputs": [[)" +
+         std::to_string(input) + ", 0, 0], [" + std::to_string(param) + ", 0, 0]]}";
+}
+
+std::string ChainGraph() {
+  return R"({"nodes": [{"op": "null", "name": "x", "inputs": []},
+    {"op": "null", "name": "w1", "inputs": []}, {"op": "null", "name": "w2", "inputs": []},
+    {"op": "null", "name": "w3", "inputs": []}, )" +
+         AddNode("add1", 0, 1) + ", " + AddNode("add2", 4, 2) + ", " + AddNode("add3", 5, 3) +
+         R"(], "arg_nodes": [0, 1, 2, 3], "node_row_ptr": [0, 1, 2, 3, 4, 5, 6, 7],
+    "heads": [[6, 0, 0]],
+    "attrs": {"dltype": ["list_str", ["float32", "float32", "float32", "float32", "float32",
+                                      "float32", "float32"]],
+              "storage_id": ["list_int", [0, 1, 2, 3, 4, 5, 6]],
+              "shape": ["list_shape", [[256], [1], [1], [1], [256], [256], [256]]]}})";
+}
+
+NDArray Filled(int64_t size, float value) {
+  NDArray array = NDArray::Empty({size}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  for (int64_t i = 0; i < size; ++i) static_cast<float*>(array->data)[i] = value;
+  return array;
+}
+
+Module CreateRuntime() {
+  const PackedFunc* create = Registry::Get("tvm.graph_runtime.create");
+  ICHECK(create != nullptr);
+  return (*create)(ChainGraph(), Module(make_object<KernelModuleNode>()),
+                   static_cast<int>(kDLCPU), 0);
+}
+
+float RunLast(Module mod, float x) {
+  mod.GetFunction("set_input")("x", Filled(kSize, x));
+  mod.GetFunction("run")();
+  NDArray out = mod.GetFunction("get_output")(0);
+  return static_cast<float*>(out->data)[kSize - 1];
+}
+
+}  // namespace
+
+TEST(GraphRuntimeBoundedMemory, StreamParams) {
+  Module mod = CreateRuntime();
+  std::map<std::string, int> fetches;
+  PackedFunc fetch([&fetches](TVMArgs args, TVMRetValue* rv) {
+    std::string name = args[0];
+    ++fetches[name];
+    *rv = Filled(1, name == "w1" ? 1.0f : name == "w2" ? 10.0f : 100.0f);
+  });
+  mod.GetFunction("set_param_source")(fetch, Array<String>{"w1", "w2", "w3"});
+  EXPECT_EQ(RunLast(mod, 0.5f), 111.5f);
+  EXPECT_EQ(RunLast(mod, 1.5f), 112.5f);
+  // every parameter is fetched once per run, into the bytes the others use when they are dead
+  for (const char* name : {"w1", "w2", "w3"}) EXPECT_EQ(fetches[name], 2);
+  NDArray w1 = mod.GetFunction("get_input")("w1");
+  NDArray w3 = mod.GetFunction("get_input")("w3");
+  EXPECT_EQ(w1->data, w3->data);
+  EXPECT_ANY_THROW(mod.GetFunction("set_param_source")(fetch, Array<String>{"y"}));
+}
+
+TEST(GraphRuntimeBoundedMemory, MemoryBudget) {
+  Module mod = CreateRuntime();
+  mod.GetFunction("set_input")("w1", Filled(1, 1.0f));
+  mod.GetFunction("set_input")("w2", Filled(1, 10.0f));
+  mod.GetFunction("set_input")("w3", Filled(1, 100.0f));
+  // the first and the last intermediates share their bytes, the second is alive with both
+  int64_t bytes = kSize * sizeof(float);
+  EXPECT_ANY_THROW(mod.GetFunction("set_memory_budget")(bytes));
+  int64_t arena = mod.GetFunction("set_memory_budget")(1 << 20);
+  EXPECT_EQ(arena, 2 * bytes);
+  EXPECT_EQ(RunLast(mod, 0.5f), 111.5f);
+  EXPECT_EQ(RunLast(mod, 2.5f), 113.5f);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+
+// A kernel adding the single element of its second input to the first one, of any length
+class KernelModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final { return "test_kernels"; }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name != "add_w") return PackedFunc();
+    return PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      DLTensor* x = args[0];
+      DLTensor* w = args[1];
+      DLTensor* out = args[2];
+      for (int64_t i = 0; i < x->shape[0]; ++i) {
+        static_cast<float*>(out->data)[i] =
+            static_cast<float*>(x->data)[i] + static_cast<float*>(w->data)[0];
+      }
+    });
+  }
+};
+
+// The graph of out = x + w[0] for x of `size` elements
+std::string Graph(int size) {
+  std::string n = std::to_string(size);
+  return R"({"nodes": [{"op": "null", "name": "x", "inputs": []},
+    {"op": "null", "name": "w", "inputs": []},
+    {"op": "tvm_op", "name": "add", "attrs": {"func_name": "add_w", "num_inputs": "2",
+     "num_outputs": "1", "flatten_data": "0"}, "inputs": [[0, 0, 0], [1, 0, 0]]}],
+    "arg_nodes": [0, 1], "node_row_ptr": [0, 1, 2, 3], "heads": [[2, 0, 0]],
+    "attrs": {"dltype": ["list_str", ["float32", "float32", "float32"]],
+              "storage_id": ["list_int", [0, 1, 2]],
+              "shape": ["list_shape", [[)" +
+         n + "], [1], [" + n + "]]]}}";
+}
+
+NDArray Filled(int64_t size, float value) {
+  NDArray array = NDArray::Empty({size}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  for (int64_t i = 0; i < size; ++i) static_cast<float*>(array->data)[i] = value;
+  return array;
+}
+
+// The runtime of the buckets of 8 and 4 elements, with w = 10
+Module CreateBuckets() {
+  const PackedFunc* create = Registry::Get("tvm.graph_runtime.create_buckets");
+  ICHECK(create != nullptr);
+  Module buckets = (*create)(Array<String>{Graph(8), Graph(4)},
+                             Module(make_object<KernelModuleNode>()),
+                             static_cast<int>(kDLCPU), 0);
+  const PackedFunc* save = Registry::Get("runtime.SaveParams");
+  ICHECK(save != nullptr);
+  std::string params = (*save)(Map<String, NDArray>{{"w", Filled(1, 10.0f)}});
+  buckets.GetFunction("load_params")(params);
+  return buckets;
+}
+
+}  // namespace
+
+TEST(GraphRuntimeBuckets, SwitchOnInputShape) {
+  Module buckets = CreateBuckets();
+  EXPECT_EQ(static_cast<int>(buckets.GetFunction("get_num_buckets")()), 2);
+  for (int64_t size : {4, 8, 4}) {
+    buckets.GetFunction("set_input")("x", Filled(size, 1.0f));
+    EXPECT_EQ(static_cast<int>(buckets.GetFunction("get_bucket")()), size == 8 ? 0 : 1);
+    buckets.GetFunction("run")();
+    NDArray out = buckets.GetFunction("get_output")(0);
+    ASSERT_EQ(out->shape[0], size);
+    // the parameters loaded once reach every bucket
+    EXPECT_EQ(static_cast<float*>(out->data)[size - 1], 11.0f);
+  }
+}
+
+TEST(GraphRuntimeBuckets, SelectBucket) {
+  Module buckets = CreateBuckets();
+  buckets.GetFunction("select_bucket")(1);
+  NDArray input = buckets.GetFunction("get_input")("x");
+  EXPECT_EQ(input->shape[0], 4);
+  EXPECT_ANY_THROW(buckets.GetFunction("select_bucket")(2));
+  // no bucket takes 5 elements
+  EXPECT_ANY_THROW(buckets.GetFunction("set_input")("x", Filled(5, 1.0f)));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
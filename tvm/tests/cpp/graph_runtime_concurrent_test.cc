@@ -0,0 +1,223 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/threading_backend.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/runtime/graph/graph_runtime.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+
+// The number of kernels running, and the most that ran at the same time
+std::atomic<int> num_running{0};
+std::atomic<int> max_running{0};
+
+// The number of tasks of the parallel launch of every "wide_" kernel
+std::mutex widths_mu;
+std::map<std::string, int> widths;
+
+// Kernels on float32[4] which sleep before reading their inputs, so that a node started too
+// early overlaps them
+class KernelModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final { return "test_kernels"; }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name.compare(0, 5, "wide_") == 0) {
+      // The kernel after a default parallel launch, which spans the pool the node runs on
+      PackedFunc kernel = GetFunction(name.substr(5), sptr_to_self);
+      return PackedFunc([kernel, name](TVMArgs args, TVMRetValue* rv) {
+        std::atomic<int> num_task{0};
+        TVMBackendParallelLaunch(
+            [](int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+              static_cast<std::atomic<int>*>(cdata)->store(penv->num_task);
+              return 0;
+            },
+            &num_task, 0);
+        {
+          std::lock_guard<std::mutex> lock(widths_mu);
+          widths[name] = num_task.load();
+        }
+        kernel.CallPacked(args, rv);
+      });
+    } else if (name == "add_one") {
+      return Kernel([](TVMArgs args, int i) { return In(args, 0, i) + 1.0f; }, 1);
+    } else if (name == "double") {
+      return Kernel([](TVMArgs args, int i) { return In(args, 0, i) * 2.0f; }, 1);
+    } else if (name == "add") {
+      return Kernel([](TVMArgs args, int i) { return In(args, 0, i) + In(args, 1, i); }, 2);
+    } else if (name == "fail") {
+      return PackedFunc([](TVMArgs args, TVMRetValue* rv) { LOG(FATAL) << "kernel failed"; });
+    }
+    return PackedFunc();
+  }
+
+ private:
+  static float In(TVMArgs args, int arg, int i) {
+    DLTensor* t = args[arg];
+    return static_cast<float*>(t->data)[i];
+  }
+
+  template <typename F>
+  static PackedFunc Kernel(F f, int num_inputs) {
+    return PackedFunc([f, num_inputs](TVMArgs args, TVMRetValue* rv) {
+      int running = ++num_running;
+      int prev = max_running.load();
+      while (prev < running && !max_running.compare_exchange_weak(prev, running)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      DLTensor* out = args[num_inputs];
+      for (int i = 0; i < 4; ++i) static_cast<float*>(out->data)[i] = f(args, i);
+      --num_running;
+    });
+  }
+};
+
+// A graph node of `func_name` reading the first output of the `inputs` nodes
+std::string OpNode(const std::string& name, const std::string& func_name,
+                   const std::vector<int>& inputs) {
+  std::string json = R"({"op": "tvm_op", "name": ")" + name + R"(", "attrs": {"func_name": ")" +
+                     func_name + R"(", "num_inputs": ")" + std::to_string(inputs.size()) +
+                     R"(", "num_outputs": "1", "flatten_data": "0"}, "inputs": [)";
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    json += (i ? ", [" : "[") + std::to_string(inputs[i]) + ", 0, 0]";
+  }
+  return json + "]}";
+}
+
+// A graph of float32[4] nodes with one output each, the last node is the output
+std::string Graph(const std::vector<std::string>& ops, const std::vector<int>& storage_ids) {
+  size_t num_nodes = ops.size() + 1;
+  std::string nodes = R"({"op": "null", "name": "x", "inputs": []})";
+  std::string row_ptr = "0", dltype, storage, shape;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    if (i > 0) nodes += ", " + ops[i - 1];
+    row_ptr += ", " + std::to_string(i + 1);
+    dltype += std::string(i ? ", " : "") + R"("float32")";
+    storage += std::string(i ? ", " : "") + std::to_string(storage_ids[i]);
+    shape += std::string(i ? ", " : "") + "[4]";
+  }
+  return R"({"nodes": [)" + nodes + R"(], "arg_nodes": [0], "node_row_ptr": [)" + row_ptr +
+         R"(], "heads": [[)" + std::to_string(num_nodes - 1) + R"(, 0, 0]], "attrs": {)" +
+         R"("dltype": ["list_str", [)" + dltype + R"(]], "storage_id": ["list_int", [)" + storage +
+         R"(]], "shape": ["list_shape", [)" + shape + "]]}}";
+}
+
+// Run the graph on x filled with `value` and give the first element of the output, on
+// `thread_pool` when it is defined
+float Run(const std::string& graph, float value, ObjectRef thread_pool = ObjectRef()) {
+  auto exec = make_object<GraphRuntime>();
+  exec->Init(graph, Module(make_object<KernelModuleNode>()), {kCPU}, PackedFunc());
+  if (thread_pool.defined()) {
+    exec->GetFunction("set_thread_pool", exec)(thread_pool);
+  }
+  NDArray x = NDArray::Empty({4}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  std::fill_n(static_cast<float*>(x->data), 4, value);
+  exec->SetInput(0, const_cast<DLTensor*>(x.operator->()));
+  exec->Run();
+  return static_cast<float*>(exec->GetOutput(0)->data)[0];
+}
+
+// Whether the runtime starts its workers on this machine
+bool HasWorkers() { return threading::MaxConcurrency() >= 2; }
+
+}  // namespace
+
+TEST(GraphRuntimeConcurrent, IndependentBranches) {
+  max_running = 0;
+  std::string graph = Graph({OpNode("a", "add_one", {0}), OpNode("b", "double", {0}),
+                             OpNode("c", "add", {1, 2})},
+                            {0, 1, 2, 3});
+  EXPECT_EQ(Run(graph, 3.0f), 4.0f + 6.0f);
+  if (HasWorkers()) EXPECT_EQ(max_running.load(), 2);
+}
+
+TEST(GraphRuntimeConcurrent, SharedStorage) {
+  max_running = 0;
+  // d overwrites the storage of a, it must wait for c to read it
+  std::string graph = Graph({OpNode("a", "add_one", {0}), OpNode("c", "double", {1}),
+                             OpNode("d", "double", {0}), OpNode("e", "add", {2, 3})},
+                            {0, 1, 2, 1, 3});
+  EXPECT_EQ(Run(graph, 3.0f), 8.0f + 6.0f);
+  EXPECT_EQ(max_running.load(), 1);
+}
+
+TEST(GraphRuntimeConcurrent, Failure) {
+  std::string graph = Graph({OpNode("a", "fail", {0}), OpNode("b", "double", {0}),
+                             OpNode("c", "add", {1, 2})},
+                            {0, 1, 2, 3});
+  auto exec = make_object<GraphRuntime>();
+  exec->Init(graph, Module(make_object<KernelModuleNode>()), {kCPU}, PackedFunc());
+  // The error reaches the caller, and the next run does not wait on the failed one
+  EXPECT_ANY_THROW(exec->Run());
+  EXPECT_ANY_THROW(exec->Run());
+}
+
+TEST(GraphRuntimeConcurrent, SplitCores) {
+  if (!HasWorkers()) return;
+  int num_cores = std::min(threading::MaxConcurrency(),
+                           static_cast<int>(std::thread::hardware_concurrency()));
+  widths.clear();
+  std::string graph = Graph({OpNode("a", "wide_add_one", {0}), OpNode("b", "wide_double", {0}),
+                             OpNode("c", "wide_add", {1, 2})},
+                            {0, 1, 2, 3});
+  EXPECT_EQ(Run(graph, 3.0f), 4.0f + 6.0f);
+  // The branches side by side get half the cores each, the join alone gets all of them
+  EXPECT_EQ(widths["wide_add_one"], std::max(num_cores / 2, 1));
+  EXPECT_EQ(widths["wide_double"], std::max(num_cores / 2, 1));
+  EXPECT_EQ(widths["wide_add"], num_cores);
+}
+
+TEST(GraphRuntimeConcurrent, BoundThreadPool) {
+  if (!HasWorkers()) return;
+  widths.clear();
+  std::string graph = Graph({OpNode("a", "wide_add_one", {0}), OpNode("b", "wide_double", {0}),
+                             OpNode("c", "wide_add", {1, 2})},
+                            {0, 1, 2, 3});
+  // A pool set on the runtime overrides its split of the cores
+  EXPECT_EQ(Run(graph, 3.0f, threading::CreateThreadPool({0})), 4.0f + 6.0f);
+  EXPECT_EQ(widths["wide_add_one"], 1);
+  EXPECT_EQ(widths["wide_double"], 1);
+  EXPECT_EQ(widths["wide_add"], 1);
+}
+
+int main(int argc, char** argv) {
+  // Read once, when the first runtime starts its workers
+  setenv("TVM_GRAPH_RUNTIME_NUM_THREADS", "2", 1);
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
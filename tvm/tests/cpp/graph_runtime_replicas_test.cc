@@ -0,0 +1,114 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+
+// A kernel adding the single element of its second input to the first one
+class KernelModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final { return "test_kernels"; }
+
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    if (name != "add_w") return PackedFunc();
+    return PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      DLTensor* x = args[0];
+      DLTensor* w = args[1];
+      DLTensor* out = args[2];
+      for (int64_t i = 0; i < x->shape[0]; ++i) {
+        static_cast<float*>(out->data)[i] =
+            static_cast<float*>(x->data)[i] + static_cast<float*>(w->data)[0];
+      }
+    });
+  }
+};
+
+// out = x + w[0] for x of 4 elements, without device_index so that it runs on the host
+const char* kGraph = R"({"nodes": [{"op": "null", "name": "x", "inputs": []},
+  {"op": "null", "name": "w", "inputs": []},
+  {"op": "tvm_op", "name": "add", "attrs": {"func_name": "add_w", "num_inputs": "2",
+   "num_outputs": "1", "flatten_data": "0"}, "inputs": [[0, 0, 0], [1, 0, 0]]}],
+  "arg_nodes": [0, 1], "node_row_ptr": [0, 1, 2, 3], "heads": [[2, 0, 0]],
+  "attrs": {"dltype": ["list_str", ["float32", "float32", "float32"]],
+            "storage_id": ["list_int", [0, 1, 2]],
+            "shape": ["list_shape", [[4], [1], [4]]]}})";
+
+NDArray Filled(int64_t size, float value) {
+  NDArray array = NDArray::Empty({size}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  for (int64_t i = 0; i < size; ++i) static_cast<float*>(array->data)[i] = value;
+  return array;
+}
+
+// The replicas of the graph for OpenCL devices 0 and 1, with w = 10
+Module CreateReplicas() {
+  const PackedFunc* create = Registry::Get("tvm.graph_runtime.create_replicas");
+  ICHECK(create != nullptr);
+  Module replicas = (*create)(std::string(kGraph), Module(make_object<KernelModuleNode>()),
+                              static_cast<int>(kDLCPU), 0, static_cast<int>(kDLOpenCL), 0,
+                              static_cast<int>(kDLOpenCL), 1);
+  const PackedFunc* save = Registry::Get("runtime.SaveParams");
+  ICHECK(save != nullptr);
+  std::string params = (*save)(Map<String, NDArray>{{"w", Filled(1, 10.0f)}});
+  replicas.GetFunction("load_params")(params);
+  return replicas;
+}
+
+}  // namespace
+
+TEST(GraphRuntimeReplicas, ForwardToSelectedReplica) {
+  Module replicas = CreateReplicas();
+  ASSERT_EQ(static_cast<int>(replicas.GetFunction("get_num_replicas")()), 2);
+  for (int i = 0; i < 2; ++i) {
+    replicas.GetFunction("select_replica")(i);
+    EXPECT_EQ(static_cast<int>(replicas.GetFunction("get_replica")()), i);
+    replicas.GetFunction("set_input")("x", Filled(4, static_cast<float>(i)));
+  }
+  replicas.GetFunction("run_all")();
+  for (int i = 0; i < 2; ++i) {
+    replicas.GetFunction("select_replica")(i);
+    NDArray out = replicas.GetFunction("get_output")(0);
+    // the parameters loaded once reach both replicas
+    EXPECT_EQ(static_cast<float*>(out->data)[3], 10.0f + i);
+  }
+  EXPECT_ANY_THROW(replicas.GetFunction("select_replica")(2));
+}
+
+TEST(GraphRuntimeReplicas, NeedOpenCLDevice) {
+  const PackedFunc* create = Registry::Get("tvm.graph_runtime.create_replicas");
+  ASSERT_TRUE(create != nullptr);
+  EXPECT_ANY_THROW((*create)(std::string(kGraph), Module(make_object<KernelModuleNode>()),
+                             static_cast<int>(kDLCPU), 0));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
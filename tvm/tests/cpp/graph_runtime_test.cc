@@ -0,0 +1,425 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../../src/runtime/compressed_param.h"
+#include "../../src/runtime/file_utils.h"
+#include "../../src/runtime/graph/graph_runtime.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+// A graph without kernels, it outputs its parameter "w"
+const char* kParamGraph = R"({
+  "nodes": [{"op": "null", "name": "x", "inputs": []},
+            {"op": "null", "name": "w", "inputs": []}],
+  "arg_nodes": [0, 1],
+  "node_row_ptr": [0, 1, 2],
+  "heads": [[1, 0, 0]],
+  "attrs": {
+    "dltype": ["list_str", ["float32", "float32"]],
+    "storage_id": ["list_int", [0, 1]],
+    "storage_scope": ["list_str", ["global", "global"]],
+    "shape": ["list_shape", [[4], [4]]]
+  }
+})";
+
+// Two uploads following each other, from the inputs "x" and "y" to the outputs on OpenCL
+const char* kUploadGraph = R"({
+  "nodes": [{"op": "null", "name": "x", "inputs": []},
+            {"op": "null", "name": "y", "inputs": []},
+            {"op": "tvm_op", "name": "copy_x", "inputs": [[0, 0, 0]],
+             "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+                       "flatten_data": "0"}},
+            {"op": "tvm_op", "name": "copy_y", "inputs": [[1, 0, 0]],
+             "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+                       "flatten_data": "0"}}],
+  "arg_nodes": [0, 1],
+  "node_row_ptr": [0, 1, 2, 3, 4],
+  "heads": [[2, 0, 0], [3, 0, 0]],
+  "attrs": {
+    "dltype": ["list_str", ["float32", "float32", "float32", "float32"]],
+    "storage_id": ["list_int", [0, 1, 2, 3]],
+    "device_index": ["list_int", [1, 1, 4, 4]],
+    "shape": ["list_shape", [[4], [4], [4], [4]]]
+  }
+})";
+
+// A copy of the input "x" to the output
+const char* kCopyGraph = R"({
+  "nodes": [{"op": "null", "name": "x", "inputs": []},
+            {"op": "tvm_op", "name": "copy", "inputs": [[0, 0, 0]],
+             "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+                       "flatten_data": "0"}}],
+  "arg_nodes": [0],
+  "node_row_ptr": [0, 1, 2],
+  "heads": [[1, 0, 0]],
+  "attrs": {
+    "dltype": ["list_str", ["float32", "float32"]],
+    "storage_id": ["list_int", [0, 1]],
+    "shape": ["list_shape", [[4], [4]]]
+  }
+})";
+
+// The inputs "x" of 2 batches and "y" of `y_batches` held in one storage of image arrays
+std::string ArrayGraph(int y_batches) {
+  return R"({
+  "nodes": [{"op": "null", "name": "x", "inputs": []},
+            {"op": "null", "name": "y", "inputs": []}],
+  "arg_nodes": [0, 1],
+  "node_row_ptr": [0, 1, 2],
+  "heads": [[0, 0, 0]],
+  "attrs": {
+    "dltype": ["list_str", ["float32", "float32"]],
+    "storage_id": ["list_int", [0, 0]],
+    "storage_scope": ["list_str", ["texture:array", "texture:array"]],
+    "shape": ["list_shape", [[2, 1, 2, 2, 4], [)" +
+         std::to_string(y_batches) + R"(, 1, 4, 2, 4]]]
+  }
+})";
+}
+
+const TVMContext kCPU = {kDLCPU, 0};
+const TVMContext kOpenCL = {kDLOpenCL, 0};
+
+bool HasOpenCL() {
+  if (Registry::Get("device_api.opencl") == nullptr) return false;
+  TVMRetValue exist;
+  DeviceAPI::Get(kOpenCL)->GetAttr(kOpenCL, kExist, &exist);
+  return exist.type_code() != kTVMNullptr && static_cast<int>(exist);
+}
+
+NDArray Filled(float value) {
+  NDArray array = NDArray::Empty({4}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  for (int i = 0; i < 4; ++i) static_cast<float*>(array->data)[i] = value;
+  return array;
+}
+
+float First(const NDArray& array) { return static_cast<float*>(array->data)[0]; }
+
+ObjectPtr<GraphRuntime> CreateRuntime(const NDArray& shared_w, int* num_releases) {
+  auto exec = make_object<GraphRuntime>();
+  PackedFunc no_linked_params([](TVMArgs args, TVMRetValue* rv) { *rv = nullptr; });
+  exec->Init(kParamGraph, Module(), {kCPU}, no_linked_params,
+             [shared_w](const std::string& name, TVMContext ctx) {
+               return name == "w" ? shared_w : NDArray();
+             });
+  exec->SetSharedParamRelease([num_releases]() { ++*num_releases; });
+  return exec;
+}
+
+}  // namespace
+
+TEST(GraphRuntime, GetInputCopiesSharedParam) {
+  NDArray shared_w = Filled(1.0f);
+  int num_releases = 0;
+  auto exec = CreateRuntime(shared_w, &num_releases);
+  Module mod(exec);
+  int w_idx = exec->GetInputIndex("w");
+  ASSERT_TRUE(exec->IsSharedInput(w_idx));
+  NDArray w = mod.GetFunction("get_input")("w");
+  static_cast<float*>(w->data)[0] = 2.0f;
+  EXPECT_FALSE(exec->IsSharedInput(w_idx));
+  EXPECT_EQ(First(shared_w), 1.0f);
+  EXPECT_EQ(First(exec->GetInput(w_idx)), 2.0f);
+  EXPECT_EQ(static_cast<float*>(w->data)[1], 1.0f);
+  EXPECT_EQ(num_releases, 1);
+}
+
+TEST(GraphRuntime, InputByNameOrIndex) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(1.0f), &num_releases);
+  Module mod(exec);
+  PackedFunc set_input = mod.GetFunction("set_input");
+  PackedFunc get_input = mod.GetFunction("get_input");
+  set_input("x", Filled(2.0f));
+  EXPECT_EQ(First(get_input(0)), 2.0f);
+  set_input(String("x"), Filled(3.0f));
+  EXPECT_EQ(First(get_input(std::string("x"))), 3.0f);
+  set_input(0, Filled(4.0f));
+  EXPECT_EQ(First(get_input(String("x"))), 4.0f);
+  EXPECT_EQ(exec->GetInputIndex("w"), 1);
+  // an unknown name is ignored by set_input and gives nothing back
+  set_input("y", Filled(5.0f));
+  EXPECT_EQ(get_input("y").type_code(), kTVMNullptr);
+  EXPECT_EQ(exec->GetInputIndex("y"), -1);
+}
+
+TEST(GraphRuntime, StorageDLType) {
+  // the storage types of textures, the global entries keep their dtype
+  std::string graph = kParamGraph;
+  std::string scope = R"("storage_scope": ["list_str", ["global", "global"]],)";
+  graph.replace(graph.find(scope), scope.size(),
+                scope + R"( "storage_dltype": ["list_str", ["float32", "float32"]],)");
+  auto exec = make_object<GraphRuntime>();
+  PackedFunc no_linked_params([](TVMArgs args, TVMRetValue* rv) { *rv = nullptr; });
+  exec->Init(graph, Module(), {kCPU}, no_linked_params);
+  Module mod(exec);
+  mod.GetFunction("set_input")("w", Filled(3.0f));
+  mod.GetFunction("run")();
+  NDArray out = mod.GetFunction("get_output")(0);
+  EXPECT_EQ(First(out), 3.0f);
+}
+
+TEST(GraphRuntime, WorkersFollowSetParams) {
+  NDArray shared_w = Filled(1.0f);
+  int num_releases = 0;
+  auto exec = CreateRuntime(shared_w, &num_releases);
+  int w_idx = exec->GetInputIndex("w");
+  auto worker = exec->CreateWorker();
+  EXPECT_EQ(First(worker->GetInput(w_idx)), 1.0f);
+  // Set on the runtime, the worker sees it
+  NDArray w2 = Filled(2.0f);
+  exec->SetInput(w_idx, const_cast<DLTensor*>(w2.operator->()));
+  EXPECT_EQ(First(shared_w), 1.0f);
+  EXPECT_EQ(First(worker->GetInput(w_idx)), 2.0f);
+  // Set on the worker, only the worker sees it
+  NDArray w3 = Filled(3.0f);
+  worker->SetInput(w_idx, const_cast<DLTensor*>(w3.operator->()));
+  EXPECT_EQ(First(worker->GetInput(w_idx)), 3.0f);
+  EXPECT_EQ(First(exec->GetInput(w_idx)), 2.0f);
+  NDArray w4 = Filled(4.0f);
+  exec->SetInput(w_idx, const_cast<DLTensor*>(w4.operator->()));
+  EXPECT_EQ(First(worker->GetInput(w_idx)), 3.0f);
+}
+
+TEST(GraphRuntime, ReleaseSharedParamsOnDestruction) {
+  NDArray shared_w = Filled(1.0f);
+  int num_releases = 0;
+  {
+    auto exec = CreateRuntime(shared_w, &num_releases);
+    auto worker = exec->CreateWorker();
+    EXPECT_GT(shared_w.use_count(), 1);
+  }
+  EXPECT_EQ(shared_w.use_count(), 1);
+  EXPECT_EQ(num_releases, 2);
+}
+
+TEST(GraphRuntime, OutOfOrderWithoutOpenCL) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(1.0f), &num_releases);
+  Module mod(exec);
+  // Only OpenCL has an out-of-order queue, the graph keeps running in order
+  mod.GetFunction("set_out_of_order")(true);
+  mod.GetFunction("run")();
+  NDArray out = mod.GetFunction("get_output")(0);
+  EXPECT_EQ(First(out), 1.0f);
+  mod.GetFunction("set_out_of_order")(false);
+}
+
+TEST(GraphRuntime, RunModesExclusive) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(1.0f), &num_releases);
+  Module mod(exec);
+  mod.GetFunction("set_memory_budget")(int64_t(1) << 20);
+  // The bounded memory runs the nodes in order on the caller, the queues cannot take them
+  EXPECT_ANY_THROW(mod.GetFunction("set_queue_hints")("high", ""));
+  EXPECT_ANY_THROW(mod.GetFunction("set_out_of_order")(true));
+  // Disabling a mode not set, or setting the same mode again, is fine
+  mod.GetFunction("set_queue_hints")("", "");
+  mod.GetFunction("set_out_of_order")(false);
+  mod.GetFunction("set_memory_budget")(int64_t(1) << 20);
+  mod.GetFunction("run")();
+  NDArray out = mod.GetFunction("get_output")(0);
+  EXPECT_EQ(First(out), 1.0f);
+}
+
+TEST(GraphRuntime, PerfHint) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(1.0f), &num_releases);
+  Module mod(exec);
+  PackedFunc set_perf_hint = mod.GetFunction("set_perf_hint");
+  // No level leaves the clocks as they are, on any device
+  set_perf_hint("");
+  mod.GetFunction("run")();
+  if (Registry::Get("device_api.opencl.set_perf_hint") == nullptr) {
+    EXPECT_ANY_THROW(set_perf_hint("high"));
+    return;
+  }
+  EXPECT_ANY_THROW(set_perf_hint("turbo"));
+  // The level is set again by every run, devices without cl_qcom_perf_hint drop it
+  set_perf_hint("low");
+  mod.GetFunction("run")();
+  NDArray out = mod.GetFunction("get_output")(0);
+  EXPECT_EQ(First(out), 1.0f);
+}
+
+TEST(GraphRuntime, LoadCompressedParams) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(0.0f), &num_releases);
+  Module mod(exec);
+  std::string blob = SaveParams({{"w", CompressParam(Filled(1.5f), "float16", 1)}});
+  mod.GetFunction("load_params")(TVMByteArray{blob.data(), blob.size()});
+  NDArray w = exec->GetInput(exec->GetInputIndex("w"));
+  EXPECT_EQ(w->dtype.bits, 32);
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(static_cast<float*>(w->data)[i], 1.5f);
+}
+
+TEST(GraphRuntime, LoadParamsAsync) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(0.0f), &num_releases);
+  Module mod(exec);
+  std::string blob = SaveParams({{"w", Filled(1.0f)}});
+  mod.GetFunction("load_params_async")(TVMByteArray{blob.data(), blob.size()});
+  // Reading the parameter waits for its upload
+  NDArray w = mod.GetFunction("get_input")("w");
+  EXPECT_EQ(First(w), 1.0f);
+  mod.GetFunction("run")();
+  NDArray out = mod.GetFunction("get_output")(0);
+  EXPECT_EQ(First(out), 1.0f);
+}
+
+TEST(GraphRuntime, LoadParamsAsyncError) {
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(0.0f), &num_releases);
+  Module mod(exec);
+  PackedFunc load_async = mod.GetFunction("load_params_async");
+  // The list is well formed, its array does not fit the parameter
+  std::string bad = SaveParams({{"w", NDArray::Empty({8}, DLDataType{kDLFloat, 32, 1}, kCPU)}});
+  std::string good = SaveParams({{"w", Filled(3.0f)}});
+  load_async(TVMByteArray{bad.data(), bad.size()});
+  EXPECT_ANY_THROW(mod.GetFunction("get_input")("w"));
+  EXPECT_ANY_THROW(mod.GetFunction("set_input")("w", Filled(2.0f)));
+  // A new load, asynchronous or not, drops the error of the failed one
+  load_async(TVMByteArray{good.data(), good.size()});
+  NDArray w = mod.GetFunction("get_input")("w");
+  EXPECT_EQ(First(w), 3.0f);
+  load_async(TVMByteArray{bad.data(), bad.size()});
+  mod.GetFunction("load_params")(TVMByteArray{good.data(), good.size()});
+  EXPECT_EQ(First(exec->GetInput(exec->GetInputIndex("w"))), 3.0f);
+}
+
+#ifndef _WIN32
+TEST(GraphRuntime, WriteMappedParam) {
+  std::string path = std::string(testing::TempDir()) + "graph_runtime_mapped_params";
+  {
+    std::ofstream fs(path, std::ios::out | std::ios::binary);
+    fs << SaveParams({{"w", Filled(1.0f)}}, kAllocAlignment);
+  }
+  int num_releases = 0;
+  auto exec = CreateRuntime(Filled(0.0f), &num_releases);
+  Module mod(exec);
+  mod.GetFunction("load_params_mapped")(path);
+  int w_idx = exec->GetInputIndex("w");
+  EXPECT_EQ(First(exec->GetInput(w_idx)), 1.0f);
+  // The parameter is used in place, writing it does not reach the file
+  NDArray w2 = Filled(2.0f);
+  exec->SetInput(w_idx, const_cast<DLTensor*>(w2.operator->()));
+  EXPECT_EQ(First(exec->GetInput(w_idx)), 2.0f);
+  std::string blob;
+  LoadBinaryFromFile(path, &blob);
+  Map<String, NDArray> params = LoadParams(blob);
+  EXPECT_EQ(First(params["w"]), 1.0f);
+  std::remove(path.c_str());
+}
+#endif
+
+TEST(GraphRuntime, BatchedUploads) {
+  if (!HasOpenCL()) return;
+  setenv("TVM_GRAPH_RUNTIME_BATCH_COPIES", "1", 1);
+  auto exec = make_object<GraphRuntime>();
+  PackedFunc no_linked_params([](TVMArgs args, TVMRetValue* rv) { *rv = nullptr; });
+  exec->Init(kUploadGraph, Module(), {kCPU, kOpenCL}, no_linked_params);
+  unsetenv("TVM_GRAPH_RUNTIME_BATCH_COPIES");
+  Module mod(exec);
+  mod.GetFunction("set_input")("x", Filled(1.0f));
+  mod.GetFunction("set_input")("y", Filled(2.0f));
+  // Both copies are issued by the executor of copy_y, ordered after the stream of the caller
+  DeviceAPI* device = DeviceAPI::Get(kOpenCL);
+  TVMStreamHandle stream = device->CreateStream(kOpenCL);
+  device->SetStream(kOpenCL, stream);
+  mod.GetFunction("run")();
+  device->SetStream(kOpenCL, nullptr);
+  device->StreamSync(kOpenCL, stream);
+  device->FreeStream(kOpenCL, stream);
+  NDArray out_x = mod.GetFunction("get_output")(0);
+  NDArray out_y = mod.GetFunction("get_output")(1);
+  EXPECT_EQ(First(out_x.CopyTo(kCPU)), 1.0f);
+  EXPECT_EQ(First(out_y.CopyTo(kCPU)), 2.0f);
+}
+
+TEST(GraphRuntime, Pipeline) {
+  std::vector<TVMContext> contexts{kCPU};
+  if (HasOpenCL()) contexts.push_back(kOpenCL);
+  for (const TVMContext& ctx : contexts) {
+    auto exec = make_object<GraphRuntime>();
+    PackedFunc no_linked_params([](TVMArgs args, TVMRetValue* rv) { *rv = nullptr; });
+    exec->Init(kCopyGraph, Module(), {ctx}, no_linked_params);
+    Module mod(exec);
+    PackedFunc run_async = mod.GetFunction("run_async");
+    PackedFunc wait = mod.GetFunction("wait");
+    PackedFunc get_output = mod.GetFunction("get_pipeline_output");
+    EXPECT_ANY_THROW(run_async(Filled(1.0f)));
+    mod.GetFunction("init_pipeline")(2);
+    // The inputs are staged, the caller can overwrite them once the frame is submitted
+    NDArray x = Filled(1.0f);
+    int64_t first = run_async(x);
+    static_cast<float*>(x->data)[0] = 2.0f;
+    int64_t second = run_async(x);
+    EXPECT_EQ(First(get_output(first, 0)), 1.0f);
+    EXPECT_EQ(First(get_output(second, 0)), 2.0f);
+    // The third frame retires the first one to reuse its slot
+    int64_t third = run_async(Filled(3.0f));
+    wait(third);
+    EXPECT_EQ(First(get_output(third, 0)), 3.0f);
+    EXPECT_EQ(First(get_output(second, 0)), 2.0f);
+    EXPECT_ANY_THROW(wait(first));
+    EXPECT_ANY_THROW(wait(third + 1));
+  }
+}
+
+TEST(GraphRuntime, TextureArrayStorage) {
+  PackedFunc no_linked_params([](TVMArgs args, TVMRetValue* rv) { *rv = nullptr; });
+  // The images of an array cannot be shared by tensors of another batch
+  EXPECT_ANY_THROW(make_object<GraphRuntime>()->Init(ArrayGraph(1), Module(), {kCPU},
+                                                     no_linked_params));
+  if (!HasOpenCL()) return;
+  auto exec = make_object<GraphRuntime>();
+  exec->Init(ArrayGraph(2), Module(), {kOpenCL}, no_linked_params);
+  Module mod(exec);
+  DLDataType f32{kDLFloat, 32, 1};
+  std::vector<float> values(32);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i);
+  NDArray x = NDArray::Empty({2, 1, 2, 2, 4}, f32, kCPU);
+  x.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  mod.GetFunction("set_input")("x", x);
+  NDArray out = mod.GetFunction("get_output")(0);
+  std::vector<float> result(values.size());
+  out.CopyTo(kCPU).CopyToBytes(result.data(), result.size() * sizeof(float));
+  EXPECT_EQ(result, values);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/ndarray.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../src/runtime/contrib/json/json_runtime.h"
+
+using namespace tvm::runtime;
+using namespace tvm::runtime::json;
+
+namespace {
+
+// x -> k1 -> k2 -> k3 -> k4, the intermediates of k1, k2 and k3 are 4x4 float32
+const char* kChainGraph = R"({
+  "nodes": [
+    {"op": "input", "name": "x", "attrs": {"dtype": [["float32"]], "shape": [[[4, 4]]]}},
+    {"op": "kernel", "name": "k1", "inputs": [[0, 0, 0]],
+     "attrs": {"num_inputs": "1", "num_outputs": "1",
+               "dtype": [["float32"]], "shape": [[[4, 4]]]}},
+    {"op": "kernel", "name": "k2", "inputs": [[1, 0, 0]],
+     "attrs": {"num_inputs": "1", "num_outputs": "1",
+               "dtype": [["float32"]], "shape": [[[4, 4]]]}},
+    {"op": "kernel", "name": "k3", "inputs": [[2, 0, 0]],
+     "attrs": {"num_inputs": "1", "num_outputs": "1",
+               "dtype": [["float32"]], "shape": [[[4, 4]]]}},
+    {"op": "kernel", "name": "k4", "inputs": [[3, 0, 0]],
+     "attrs": {"num_inputs": "1", "num_outputs": "1",
+               "dtype": [["float32"]], "shape": [[[4, 4]]]}}
+  ],
+  "arg_nodes": [0],
+  "heads": [[4, 0, 0]],
+  "node_row_ptr": [0, 1, 2, 3, 4, 5]
+})";
+
+// A backend taking its intermediates from the scratch arena, recording where they are bound
+class ScratchRuntime : public JSONRuntimeBase {
+ public:
+  ScratchRuntime(const std::string& symbol_name, const std::string& graph_json,
+                 const Array<String> const_names)
+      : JSONRuntimeBase(symbol_name, graph_json, const_names) {}
+
+  void Init(const Array<NDArray>& consts) override { PlanScratch(); }
+
+  void Run() override {
+    bound.clear();
+    for (uint32_t eid = 0; eid < NumEntries(); ++eid) {
+      const DLTensor* tensor = data_entry_[eid];
+      bound.push_back(reinterpret_cast<uintptr_t>(tensor->data) + tensor->byte_offset);
+    }
+  }
+
+  size_t ScratchSize() const { return scratch_size_bytes_; }
+
+  std::vector<uintptr_t> bound;
+};
+
+}  // namespace
+
+TEST(JSONRuntime, ScratchReusedAfterLastRead) {
+  auto n = make_object<ScratchRuntime>("chain", kChainGraph, Array<String>());
+  ScratchRuntime* runtime = n.get();
+  Module mod(n);
+  mod.GetFunction("__init_chain")(Array<NDArray>());
+  // k1 is still read by k2 while k2 is written, k3 takes the memory of k1 back
+  EXPECT_EQ(runtime->ScratchSize(), 2U * kAllocAlignment);
+
+  TVMContext cpu = {kDLCPU, 0};
+  NDArray x = NDArray::Empty({4, 4}, DLDataType{kDLFloat, 32, 1}, cpu);
+  NDArray y = NDArray::Empty({4, 4}, DLDataType{kDLFloat, 32, 1}, cpu);
+  PackedFunc run = mod.GetFunction("chain");
+  run(x, y);
+  std::vector<uintptr_t> first = runtime->bound;
+  ASSERT_EQ(first.size(), 5U);
+  EXPECT_EQ(first[0], reinterpret_cast<uintptr_t>(x->data));
+  EXPECT_EQ(first[4], reinterpret_cast<uintptr_t>(y->data));
+  EXPECT_NE(first[1], first[2]);
+  EXPECT_EQ(first[1], first[3]);
+  EXPECT_EQ(first[2] - first[1], static_cast<uintptr_t>(kAllocAlignment));
+
+  // The arena is kept across calls on the same device
+  run(x, y);
+  EXPECT_EQ(runtime->bound, first);
+}
+
+TEST(JSONRuntime, NoScratchWithoutPlan) {
+  class UnplannedRuntime : public ScratchRuntime {
+   public:
+    using ScratchRuntime::ScratchRuntime;
+    void Init(const Array<NDArray>& consts) override {}
+  };
+  auto n = make_object<UnplannedRuntime>("chain", kChainGraph, Array<String>());
+  ScratchRuntime* runtime = n.get();
+  Module mod(n);
+  mod.GetFunction("__init_chain")(Array<NDArray>());
+  EXPECT_EQ(runtime->ScratchSize(), 0U);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/c_runtime_api.h>
+
+#include "../../src/runtime/memory_stats.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+// A device no allocator of the runtime uses, the counters only see the test
+TVMContext TestContext(int device_id) { return {kDLCPU, 1000 + device_id}; }
+
+}  // namespace
+
+TEST(MemoryStats, OffByDefault) {
+  MemoryStats stats;
+  int block = 0;
+  stats.Alloc(TestContext(0), MemoryKind::kGlobal, &block, 64);
+  MemoryStats::Counter counter = stats.Get(TestContext(0), MemoryKind::kGlobal);
+  EXPECT_EQ(counter.num_allocs, 0U);
+  EXPECT_EQ(counter.current, 0U);
+  stats.Free(TestContext(0), MemoryKind::kGlobal, &block);
+}
+
+TEST(MemoryStats, RecordWhenEnabled) {
+  MemoryStats stats;
+  stats.SetEnabled(true);
+  int a = 0, b = 0;
+  stats.Alloc(TestContext(1), MemoryKind::kGlobal, &a, 64);
+  stats.Alloc(TestContext(1), MemoryKind::kGlobal, &b, 32);
+  stats.Free(TestContext(1), MemoryKind::kGlobal, &a);
+  MemoryStats::Counter counter = stats.Get(TestContext(1), MemoryKind::kGlobal);
+  EXPECT_EQ(counter.num_allocs, 2U);
+  EXPECT_EQ(counter.num_live, 1U);
+  EXPECT_EQ(counter.current, 32U);
+  EXPECT_EQ(counter.peak, 96U);
+}
+
+TEST(MemoryStats, FreeAfterDisable) {
+  MemoryStats stats;
+  stats.SetEnabled(true);
+  int a = 0, b = 0;
+  stats.Alloc(TestContext(2), MemoryKind::kWorkspace, &a, 64);
+  stats.SetEnabled(false);
+  // Not recorded, but the allocation recorded before is still freed
+  stats.Alloc(TestContext(2), MemoryKind::kWorkspace, &b, 32);
+  stats.Free(TestContext(2), MemoryKind::kWorkspace, &a);
+  stats.Free(TestContext(2), MemoryKind::kWorkspace, &b);
+  MemoryStats::Counter counter = stats.Get(TestContext(2), MemoryKind::kWorkspace);
+  EXPECT_EQ(counter.num_allocs, 1U);
+  EXPECT_EQ(counter.num_live, 0U);
+  EXPECT_EQ(counter.current, 0U);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <vector>
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+const TVMContext kMetal = {kDLMetal, 0};
+const DLDataType kFloat32 = {kDLFloat, 32, 1};
+
+// Whether the runtime is built with Metal and has a device, the tests pass trivially if not
+bool HasMetal() {
+  if (Registry::Get("device_api.metal") == nullptr) return false;
+  TVMRetValue exist;
+  DeviceAPI::Get(kMetal)->GetAttr(kMetal, kExist, &exist);
+  return exist.type_code() != kTVMNullptr && static_cast<int>(exist);
+}
+
+NDArray Iota(int64_t size) {
+  NDArray array = NDArray::Empty({size}, kFloat32, kCPU);
+  for (int64_t i = 0; i < size; ++i) static_cast<float*>(array->data)[i] = i;
+  return array;
+}
+
+}  // namespace
+
+TEST(MetalRuntime, CopiesThroughPendingCommandBuffer) {
+  if (!HasMetal()) return;
+  // the device to device copies are blits of the pending command buffer, which the copy back
+  // to the host commits
+  NDArray a = Iota(1024).CopyTo(kMetal);
+  NDArray b = NDArray::Empty({1024}, kFloat32, kMetal);
+  NDArray c = NDArray::Empty({1024}, kFloat32, kMetal);
+  a.CopyTo(b);
+  b.CopyTo(c);
+  NDArray back = c.CopyTo(kCPU);
+  for (int i = 0; i < 1024; ++i) EXPECT_EQ(static_cast<float*>(back->data)[i], i);
+}
+
+TEST(MetalRuntime, FreeWithPendingCopies) {
+  if (!HasMetal()) return;
+  NDArray a = Iota(256).CopyTo(kMetal);
+  std::vector<NDArray> copies;
+  for (int i = 0; i < 300; ++i) {
+    copies.push_back(NDArray::Empty({256}, kFloat32, kMetal));
+    a.CopyTo(copies.back());
+  }
+  // freeing commits what is pending, the remaining copies are intact
+  copies.erase(copies.begin(), copies.begin() + 150);
+  NDArray back = copies.back().CopyTo(kCPU);
+  EXPECT_EQ(static_cast<float*>(back->data)[255], 255.0f);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/ndarray.h>
+
+#include <vector>
+
+using namespace tvm::runtime;
+
+namespace {
+
+const DLDataType kFloat32 = {kDLFloat, 32, 1};
+const TVMContext kCPU = {kDLCPU, 0};
+
+std::vector<int64_t> DLShape(const NDArray& array) {
+  return std::vector<int64_t>(array->shape, array->shape + array->ndim);
+}
+
+}  // namespace
+
+TEST(NDArray, ShapeOfEveryRank) {
+  // up to six dimensions are kept inline, the seventh goes to the heap
+  for (int ndim = 0; ndim <= 8; ++ndim) {
+    std::vector<int64_t> shape;
+    for (int i = 0; i < ndim; ++i) shape.push_back(i % 3 + 1);
+    NDArray array = NDArray::Empty(shape, kFloat32, kCPU);
+    EXPECT_EQ(array->ndim, ndim);
+    EXPECT_EQ(DLShape(array), shape);
+    EXPECT_EQ(array.Shape(), shape);
+    EXPECT_EQ(array->shape == nullptr, ndim == 0);
+  }
+}
+
+TEST(NDArray, ViewChangesRank) {
+  NDArray flat = NDArray::Empty({2 * 3 * 1 * 2 * 1 * 2 * 1 * 2}, kFloat32, kCPU);
+  std::vector<int64_t> wide{2, 3, 1, 2, 1, 2, 1, 2};
+  NDArray view = flat.CreateView(wide, kFloat32);
+  EXPECT_EQ(DLShape(view), wide);
+  EXPECT_EQ(view->data, flat->data);
+  NDArray narrow = view.CreateView({24, 2}, kFloat32);
+  EXPECT_EQ(DLShape(narrow), std::vector<int64_t>({24, 2}));
+  // the views do not share their shapes
+  EXPECT_EQ(DLShape(view), wide);
+  EXPECT_EQ(DLShape(flat), std::vector<int64_t>({48}));
+}
+
+TEST(NDArray, DLPackRoundTrip) {
+  for (const std::vector<int64_t>& shape :
+       {std::vector<int64_t>{4, 5}, std::vector<int64_t>{1, 2, 1, 2, 1, 2, 1}}) {
+    NDArray array = NDArray::Empty(shape, kFloat32, kCPU);
+    DLManagedTensor* managed = array.ToDLPack();
+    NDArray back = NDArray::FromDLPack(managed);
+    EXPECT_EQ(back->data, array->data);
+    EXPECT_EQ(DLShape(back), shape);
+    EXPECT_NE(back->shape, managed->dl_tensor.shape);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
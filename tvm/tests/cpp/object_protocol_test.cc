@@ -22,6 +22,8 @@
 #include <tvm/runtime/memory.h>
 #include <tvm/runtime/object.h>
 
+#include <thread>
+
 namespace tvm {
 namespace test {
 
@@ -96,6 +98,55 @@ TEST(ObjectHierachy, Basic) {
   ICHECK(refB.as<ObjB>() != nullptr);
 }
 
+TEST(ObjectPool, ReuseWithinScope) {
+  using namespace tvm::runtime;
+  ObjectPoolScope scope;
+  void* ptr = ObjectPool::Allocate(24);
+  ObjectPool::Free(ptr, 24);
+  // A block of the same size class comes back, another size class does not take it
+  void* other = ObjectPool::Allocate(200);
+  EXPECT_NE(other, ptr);
+  EXPECT_EQ(ObjectPool::Allocate(20), ptr);
+  ObjectPool::Free(ptr, 20);
+  ObjectPool::Free(other, 200);
+}
+
+TEST(ObjectPool, NoCacheOutsideScope) {
+  using namespace tvm::runtime;
+  void* in_scope;
+  {
+    ObjectPoolScope scope;
+    {
+      ObjectPoolScope nested;
+      in_scope = ObjectPool::Allocate(32);
+    }
+    // Memory allocated in a scope can be freed after it exits
+  }
+  ObjectPool::Free(in_scope, 32);
+  void* ptr = ObjectPool::Allocate(32);
+  ObjectPool::Free(ptr, 32);
+  void* next = ObjectPool::Allocate(32);
+  ObjectPool::Free(next, 32);
+  EXPECT_DEATH(ObjectPool::ExitScope(), "without a matching EnterScope");
+}
+
+TEST(ObjectPool, FreeAfterThreadScope) {
+  using namespace tvm::runtime;
+  void* ptr = nullptr;
+  std::thread thread([&ptr]() {
+    ObjectPoolScope scope;
+    ptr = ObjectPool::Allocate(64);
+  });
+  thread.join();
+  // Freed on another thread, which has no scope
+  ObjectPool::Free(ptr, 64);
+  std::thread other([]() {
+    ObjectPoolScope scope;
+    ObjectPool::Free(ObjectPool::Allocate(64), 64);
+  });
+  other.join();
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,406 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/memory_io.h>
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/profiling.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/runtime/meta_data.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kOpenCL = {kDLOpenCL, 0};
+
+// Whether the runtime is built with OpenCL and has a device, the tests pass trivially if not
+bool HasOpenCL() {
+  if (Registry::Get("device_api.opencl") == nullptr) return false;
+  TVMRetValue exist;
+  DeviceAPI::Get(kOpenCL)->GetAttr(kOpenCL, kExist, &exist);
+  return exist.type_code() != kTVMNullptr && static_cast<int>(exist);
+}
+
+// Copy `values` to the device and back through `stream`
+std::vector<float> RoundTrip(const std::vector<float>& values, TVMStreamHandle stream) {
+  int64_t size = static_cast<int64_t>(values.size());
+  DLDataType f32{kDLFloat, 32, 1};
+  NDArray host = NDArray::Empty({size}, f32, {kDLCPU, 0});
+  NDArray device = NDArray::Empty({size}, f32, kOpenCL);
+  NDArray back = NDArray::Empty({size}, f32, {kDLCPU, 0});
+  host.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  NDArray::CopyFromTo(host.operator->(), const_cast<DLTensor*>(device.operator->()), stream);
+  NDArray::CopyFromTo(device.operator->(), const_cast<DLTensor*>(back.operator->()), stream);
+  DeviceAPI::Get(kOpenCL)->StreamSync(kOpenCL, stream);
+  std::vector<float> result(values.size());
+  std::copy_n(static_cast<float*>(back->data), values.size(), result.begin());
+  return result;
+}
+
+// The luma of a 4x2 gray frame, its chroma planes follow at offsets 8 and 10
+const uint8_t kFrame[12] = {0, 51, 102, 153, 204, 255, 17, 34, 128, 128, 128, 128};
+
+// Convert kFrame rotated by `rotation` into a float32 input of `shape`, normalized to [0, 1]
+std::vector<float> YUVToRGB(const std::vector<int64_t>& shape, int rotation) {
+  NDArray frame = NDArray::Empty({12}, DLDataType{kDLUInt, 8, 1}, kOpenCL);
+  frame.CopyFromBytes(kFrame, sizeof(kFrame));
+  NDArray input = NDArray::Empty(shape, DLDataType{kDLFloat, 32, 1}, kOpenCL);
+  (*Registry::Get("tvm.contrib.opencl.yuv_to_rgb"))(frame, input, 4, 2, 0, 4, 8, 10, 2, 1,
+                                                    rotation, 0.0, 0.0, 0.0, 1.0, 1.0, 1.0);
+  std::vector<float> values(12);
+  input.CopyToBytes(values.data(), values.size() * sizeof(float));
+  return values;
+}
+
+bool IsProfiling() { return (*Registry::Get("device_api.opencl.IsProfiling"))(0); }
+
+// Two empty kernels in the joined source form of code generation, sorted by name
+const char* kTwoKernels =
+    "// Function: k1\n__kernel void k1(__global float* a) {}\n"
+    "// Function: k2\n__kernel void k2(__global float* a) {}\n";
+
+// A "cl" module of kTwoKernels loaded the way a compiled library loads it
+Module LoadTwoKernels() {
+  std::unordered_map<std::string, FunctionInfo> fmap;
+  for (const char* name : {"k1", "k2"}) {
+    fmap[name] = {name, {DLDataType{kTVMOpaqueHandle, 64, 1}}, {"blockIdx.x", "threadIdx.x"}};
+  }
+  std::string blob;
+  dmlc::MemoryStringStream writer(&blob);
+  writer.Write(std::string("cl"));
+  writer.Write(fmap);
+  writer.Write(std::string(kTwoKernels));
+  dmlc::MemoryStringStream reader(&blob);
+  return (*Registry::Get("runtime.module.loadbinary_opencl"))(static_cast<void*>(&reader));
+}
+
+// Save `mod` to a binary blob, and give the format it is saved in
+std::string SaveToBinary(const Module& mod, std::string* fmt) {
+  std::string blob;
+  dmlc::MemoryStringStream writer(&blob);
+  mod->SaveToBinary(&writer);
+  dmlc::MemoryStringStream reader(&blob);
+  reader.Read(fmt);
+  return blob;
+}
+
+Module LoadBinary(std::string blob) {
+  dmlc::MemoryStringStream reader(&blob);
+  return (*Registry::Get("runtime.module.loadbinary_opencl"))(static_cast<void*>(&reader));
+}
+
+}  // namespace
+
+TEST(OpenCLTimer, RestoreProfilingOnStop) {
+  if (!HasOpenCL()) return;
+  ASSERT_FALSE(IsProfiling());
+  Timer timer = Timer::Start(kOpenCL);
+  EXPECT_TRUE(IsProfiling());
+  timer->Stop();
+  EXPECT_FALSE(IsProfiling());
+  EXPECT_GE(timer->SyncAndGetElapsedNanos(), 0);
+}
+
+TEST(OpenCLTimer, OverlappingTimers) {
+  if (!HasOpenCL()) return;
+  Timer outer = Timer::Start(kOpenCL);
+  Timer inner = Timer::Start(kOpenCL);
+  outer->Stop();
+  // The inner timer still needs the profiling
+  EXPECT_TRUE(IsProfiling());
+  inner->Stop();
+  EXPECT_FALSE(IsProfiling());
+}
+
+TEST(OpenCLTimer, ReleaseProfilingOnDestruction) {
+  if (!HasOpenCL()) return;
+  { Timer timer = Timer::Start(kOpenCL); }
+  EXPECT_FALSE(IsProfiling());
+}
+
+TEST(OpenCLTimer, SwitchProfilingWhileCopying) {
+  if (!HasOpenCL()) return;
+  // The default queue is recreated by each timer, the copies issued meanwhile by another
+  // thread keep the queue they were issued on
+  std::atomic<bool> done{false};
+  std::thread copier([&done]() {
+    std::vector<float> values = {1.0f, 2.0f, 3.0f};
+    while (!done) EXPECT_EQ(RoundTrip(values, nullptr), values);
+  });
+  for (int i = 0; i < 20; ++i) {
+    Timer timer = Timer::Start(kOpenCL);
+    timer->Stop();
+  }
+  done = true;
+  copier.join();
+  EXPECT_FALSE(IsProfiling());
+}
+
+TEST(OpenCLTrace, StopRestoresProfiling) {
+  if (!HasOpenCL()) return;
+  ASSERT_FALSE(IsProfiling());
+  (*Registry::Get("profiling.trace_start.opencl"))(kOpenCL);
+  EXPECT_TRUE(IsProfiling());
+  (*Registry::Get("profiling.trace_label.opencl"))(String("node"));
+  std::string events = (*Registry::Get("profiling.trace_stop.opencl"))(kOpenCL);
+  EXPECT_FALSE(IsProfiling());
+  EXPECT_EQ(events.front(), '[');
+  EXPECT_EQ(events.back(), ']');
+}
+
+TEST(OpenCLQueue, HintedStream) {
+  if (!HasOpenCL()) return;
+  // hints the device does not support are dropped, the queue works either way
+  const PackedFunc& create = *Registry::Get("device_api.opencl.CreateHintedStream");
+  void* stream = create(0, String("low"), String("high"));
+  ASSERT_NE(stream, nullptr);
+  std::vector<float> values{1.0f, 2.0f, 3.0f};
+  EXPECT_EQ(RoundTrip(values, stream), values);
+  DeviceAPI::Get(kOpenCL)->FreeStream(kOpenCL, stream);
+  EXPECT_ANY_THROW(create(0, String("urgent"), String("")));
+}
+
+TEST(OpenCLQueue, OutOfOrderStream) {
+  if (!HasOpenCL()) return;
+  void* stream = (*Registry::Get("device_api.opencl.CreateOutOfOrderStream"))(0);
+  // null when the device has no out-of-order queues
+  if (stream == nullptr) return;
+  std::vector<float> values{4.0f, 5.0f};
+  EXPECT_EQ(RoundTrip(values, stream), values);
+  DeviceAPI::Get(kOpenCL)->FreeStream(kOpenCL, stream);
+}
+
+TEST(OpenCLQueue, NodeTracking) {
+  if (!HasOpenCL()) return;
+  const PackedFunc& begin = *Registry::Get("device_api.opencl.BeginNodes");
+  const PackedFunc& set_node = *Registry::Get("device_api.opencl.SetNode");
+  const PackedFunc& end = *Registry::Get("device_api.opencl.EndNodes");
+  uint32_t waits[] = {0};
+  EXPECT_ANY_THROW(set_node(0, static_cast<void*>(waits), 0));
+  begin(2);
+  EXPECT_ANY_THROW(begin(2));
+  // nodes without kernels complete with the nodes they wait for
+  set_node(0, static_cast<void*>(waits), 0);
+  set_node(1, static_cast<void*>(waits), 1);
+  EXPECT_ANY_THROW(set_node(2, static_cast<void*>(waits), 0));
+  end();
+  // the tracking is over, a new run starts
+  begin(1);
+  end();
+}
+
+TEST(OpenCLCamera, YUVToRGB) {
+  if (!HasOpenCL()) return;
+  // NCHW, the three channels of a gray pixel are its luma
+  std::vector<float> nchw = YUVToRGB({1, 3, 2, 4}, 0);
+  for (int c = 0; c < 3; ++c) {
+    for (int i = 0; i < 8; ++i) EXPECT_NEAR(nchw[c * 8 + i], kFrame[i] / 255.0f, 1e-3);
+  }
+  // NHWC of the frame rotated clockwise, 2 wide and 4 high
+  std::vector<float> nhwc = YUVToRGB({1, 4, 2, 3}, 90);
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 2; ++x) {
+      float luma = kFrame[(1 - x) * 4 + y] / 255.0f;
+      for (int c = 0; c < 3; ++c) EXPECT_NEAR(nhwc[(y * 2 + x) * 3 + c], luma, 1e-3);
+    }
+  }
+  EXPECT_ANY_THROW(YUVToRGB({1, 3, 2, 4}, 45));
+}
+
+TEST(OpenCLCamera, RejectInvalidBuffer) {
+  if (!HasOpenCL()) return;
+  const PackedFunc& import = *Registry::Get("device_api.opencl.ImportAndroidBuffer");
+  EXPECT_ANY_THROW(import(0, 0, 16, String("ahardwarebuffer")));
+}
+
+TEST(OpenCLCopy, TexturesOnDevice) {
+  if (!HasOpenCL()) return;
+  std::vector<int64_t> shape{1, 1, 3, 4, 4};
+  DLDataType f32{kDLFloat, 32, 1};
+  std::vector<float> values(48);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i);
+  NDArray host = NDArray::Empty(shape, f32, {kDLCPU, 0});
+  host.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  NDArray texture = NDArray::Empty(shape, f32, kOpenCL, String("texture"));
+  NDArray buffer = NDArray::Empty(shape, f32, kOpenCL);
+  NDArray weight = NDArray::Empty(shape, f32, kOpenCL, String("texture:weight"));
+  NDArray texture2 = NDArray::Empty(shape, f32, kOpenCL, String("texture"));
+  NDArray texture3 = NDArray::Empty(shape, f32, kOpenCL, String("texture"));
+  // image to buffer, buffer to image, image to image of another region through a staging
+  // buffer, and image to image of the same region
+  host.CopyTo(texture);
+  texture.CopyTo(buffer);
+  buffer.CopyTo(weight);
+  weight.CopyTo(texture2);
+  texture2.CopyTo(texture3);
+  for (const NDArray& array : {buffer, texture3}) {
+    NDArray back = array.CopyTo({kDLCPU, 0});
+    std::vector<float> result(values.size());
+    back.CopyToBytes(result.data(), result.size() * sizeof(float));
+    EXPECT_EQ(result, values);
+  }
+}
+
+TEST(OpenCLCopy, TextureViewOfLargerImage) {
+  if (!HasOpenCL()) return;
+  // A tensor of 2 rows planned into an image of 4 rows is copied through its rows only
+  DLDataType f32{kDLFloat, 32, 1};
+  NDArray texture = NDArray::Empty({1, 1, 4, 4, 4}, f32, kOpenCL, String("texture"));
+  std::vector<float> zeros(64, 0.0f);
+  texture.CopyFromBytes(zeros.data(), zeros.size() * sizeof(float));
+  NDArray view = texture.CreateView({1, 1, 2, 4, 4}, f32);
+  std::vector<float> values(32);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i + 1);
+  view.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  std::vector<float> result(values.size());
+  view.CopyToBytes(result.data(), result.size() * sizeof(float));
+  EXPECT_EQ(result, values);
+  std::vector<float> image(64);
+  texture.CopyToBytes(image.data(), image.size() * sizeof(float));
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), image.begin()));
+  EXPECT_TRUE(std::all_of(image.begin() + 32, image.end(), [](float v) { return v == 0.0f; }));
+}
+
+TEST(OpenCLTexture, HalfStorage) {
+  if (!HasOpenCL()) return;
+  // a float32 input stored in a texture of half floats
+  std::string graph = R"({"nodes": [{"op": "null", "name": "x", "inputs": []}],
+    "arg_nodes": [0], "node_row_ptr": [0, 1], "heads": [[0, 0, 0]],
+    "attrs": {"dltype": ["list_str", ["float32"]], "storage_id": ["list_int", [0]],
+              "storage_scope": ["list_str", ["texture"]],
+              "storage_dltype": ["list_str", ["float16"]],
+              "shape": ["list_shape", [[1, 1, 2, 2, 4]]]}})";
+  PackedFunc no_linked_params([](TVMArgs args, TVMRetValue* rv) { *rv = nullptr; });
+  Module mod = (*Registry::Get("tvm.graph_runtime.create"))(
+      graph, Module(), no_linked_params, static_cast<int>(kDLOpenCL), 0);
+  DLDataType f32{kDLFloat, 32, 1};
+  std::vector<float> values(16);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = 0.25f * i;
+  NDArray x = NDArray::Empty({1, 1, 2, 2, 4}, f32, {kDLCPU, 0});
+  x.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  mod.GetFunction("set_input")("x", x);
+  NDArray out = mod.GetFunction("get_output")(0);
+  EXPECT_EQ(out->dtype.bits, 32);
+  NDArray back = out.CopyTo({kDLCPU, 0});
+  std::vector<float> result(values.size());
+  back.CopyToBytes(result.data(), result.size() * sizeof(float));
+  // quarters up to 3.75 are exact in half floats
+  EXPECT_EQ(result, values);
+}
+
+TEST(OpenCLTexture, ArenaViews) {
+  if (!HasOpenCL()) return;
+  // Read once by the first texture view query of the process
+  setenv("TVM_OPENCL_TEXTURE_ARENA", "1", 1);
+  const int64_t height = 3, width = 5, channel = 4;
+  DLDataType f32{kDLFloat, 32, 1};
+  int64_t size = (*Registry::Get("device_api.opencl.TextureViewSize"))(kOpenCL, height, width,
+                                                                      channel, f32);
+  // The device cannot create images over buffers
+  if (size == 0) return;
+  const int64_t row_bytes = width * channel * sizeof(float);
+  ASSERT_GE(size, height * row_bytes);
+  NDArray arena = NDArray::Empty({2 * size}, DLDataType{kDLUInt, 8, 1}, kOpenCL);
+  const PackedFunc& fview = *Registry::Get("device_api.opencl.TextureView");
+  std::vector<float> values(height * width * channel);
+  for (int64_t k = 0; k < 2; ++k) {
+    NDArray view = fview(arena, k * size, height, width, channel, f32, String("texture"));
+    for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(1000 * k + i);
+    view.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  }
+  std::vector<uint8_t> bytes(2 * size);
+  arena.CopyToBytes(bytes.data(), bytes.size());
+  auto value_at = [&bytes](int64_t offset) {
+    float value;
+    std::copy_n(bytes.data() + offset, sizeof(float), reinterpret_cast<uint8_t*>(&value));
+    return value;
+  };
+  // The rows of the second view start at its offset, each a whole number of texels apart
+  const float second_row = static_cast<float>(1000 + width * channel);
+  int64_t pitch = row_bytes;
+  while (pitch * height <= size && value_at(size + pitch) != second_row) {
+    pitch += channel * sizeof(float);
+  }
+  ASSERT_LE(pitch * height, size);
+  for (int64_t k = 0; k < 2; ++k) {
+    for (int64_t row = 0; row < height; ++row) {
+      for (int64_t i = 0; i < width * channel; ++i) {
+        EXPECT_EQ(value_at(k * size + row * pitch + i * sizeof(float)),
+                  static_cast<float>(1000 * k + row * width * channel + i));
+      }
+    }
+  }
+}
+
+TEST(OpenCLModule, SaveJoinedSource) {
+  if (Registry::Get("runtime.module.loadbinary_opencl") == nullptr) return;
+  Module mod = LoadTwoKernels();
+  EXPECT_EQ(mod->GetSource("cl"), kTwoKernels);
+  // Older runtimes only load the joined source, so it is the default format
+  std::string fmt;
+  std::string blob = SaveToBinary(mod, &fmt);
+  EXPECT_EQ(fmt, "cl");
+  EXPECT_EQ(LoadBinary(blob)->GetSource("cl"), kTwoKernels);
+}
+
+TEST(OpenCLModule, SaveKernelTable) {
+  if (Registry::Get("runtime.module.loadbinary_opencl") == nullptr) return;
+  Module mod = LoadTwoKernels();
+  setenv("TVM_OPENCL_SAVE_SPLIT", "1", 1);
+  std::string fmt;
+  std::string blob = SaveToBinary(mod, &fmt);
+  unsetenv("TVM_OPENCL_SAVE_SPLIT");
+  EXPECT_EQ(fmt, "cl:split");
+  Module loaded = LoadBinary(blob);
+  EXPECT_EQ(loaded->GetSource("cl"), kTwoKernels);
+  // A module loaded from the table saves the joined source again
+  SaveToBinary(loaded, &fmt);
+  EXPECT_EQ(fmt, "cl");
+}
+
+TEST(OpenCLModule, KeepSourceOnceBuilt) {
+  if (!HasOpenCL()) return;
+  Module mod = LoadTwoKernels();
+  NDArray a = NDArray::Empty({64}, DLDataType{kDLFloat, 32, 1}, kOpenCL);
+  mod.GetFunction("k1")(a->data, 1, 64);
+  DeviceAPI::Get(kOpenCL)->StreamSync(kOpenCL, nullptr);
+  // The sources are only released with TVM_OPENCL_RELEASE_SOURCE=1
+  EXPECT_EQ(mod->GetSource("cl"), kTwoKernels);
+  std::string fmt;
+  SaveToBinary(mod, &fmt);
+  EXPECT_EQ(fmt, "cl");
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
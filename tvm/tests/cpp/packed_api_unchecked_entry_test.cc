@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/ir/transform.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+#include "../../src/runtime/graph/graph_runtime.h"
+#include "../../src/runtime/library_module.h"
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+// Build y = x + 1 over float32[4], with the unchecked entry when `unchecked`
+runtime::Module BuildAddOne(bool unchecked) {
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("tir.packed_api.unchecked_entry", Bool(unchecked));
+  With<transform::PassContext> scope(pass_ctx);
+  Tensor x = placeholder({4}, DataType::Float(32), "x");
+  Tensor y = compute({4}, [&x](const tir::Var& i) { return x(i) + 1.0f; }, "y");
+  Schedule s = create_schedule({y->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  return build(lower(s, {x, y}, "add_one", binds), Target("llvm"), Target());
+}
+
+runtime::NDArray Filled(float value, int64_t size = 4) {
+  auto array = runtime::NDArray::Empty({size}, DataType::Float(32), kCPU);
+  for (int64_t i = 0; i < size; ++i) static_cast<float*>(array->data)[i] = value;
+  return array;
+}
+
+// A graph of one add_one node
+const char* kGraph = R"({"nodes": [{"op": "null", "name": "x", "inputs": []},
+  {"op": "tvm_op", "name": "y", "attrs": {"func_name": "add_one", "num_inputs": "1",
+   "num_outputs": "1", "flatten_data": "0"}, "inputs": [[0, 0, 0]]}],
+  "arg_nodes": [0], "node_row_ptr": [0, 1, 2], "heads": [[1, 0, 0]],
+  "attrs": {"dltype": ["list_str", ["float32", "float32"]],
+            "storage_id": ["list_int", [0, 1]], "shape": ["list_shape", [[4], [4]]]}})";
+
+}  // namespace
+
+TEST(UncheckedEntry, Lowering) {
+  if (!HasLLVM()) return;
+  EXPECT_TRUE(BuildAddOne(false).GetFunction("add_one__tvm_unchecked", true) == nullptr);
+
+  runtime::Module mod = BuildAddOne(true);
+  runtime::PackedFunc unchecked = mod.GetFunction("add_one__tvm_unchecked", true);
+  ASSERT_TRUE(unchecked != nullptr);
+  runtime::NDArray out = Filled(0.0f);
+  unchecked(Filled(2.0f), out);
+  EXPECT_EQ(static_cast<float*>(out->data)[3], 3.0f);
+  // the usual entry keeps its checks
+  EXPECT_ANY_THROW(mod.GetFunction("add_one")(Filled(2.0f, 5), out));
+}
+
+TEST(UncheckedEntry, GraphRuntime) {
+  if (!HasLLVM()) return;
+  char dir[] = "/tmp/tvm_unchecked_entry_XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  std::string obj = std::string(dir) + "/lib.o", so = std::string(dir) + "/lib.so";
+  BuildAddOne(true)->SaveToFile(obj, "o");
+  // the raw entry is only looked up in shared libraries, skip without a linker
+  if (std::system(("cc -shared -o " + so + " " + obj).c_str()) == 0) {
+    runtime::Module lib = runtime::Module::LoadFromFile(so);
+    EXPECT_NE(runtime::GetLibraryPackedCFunc(lib, "add_one__tvm_unchecked"), nullptr);
+
+    auto exec = make_object<runtime::GraphRuntime>();
+    exec->Init(kGraph, lib, {kCPU}, runtime::PackedFunc());
+    // the first run validates the arguments, the next ones call the unchecked entry
+    for (int i = 0; i < 3; ++i) {
+      runtime::NDArray x = Filled(static_cast<float>(i));
+      exec->SetInput(0, const_cast<DLTensor*>(x.operator->()));
+      exec->Run();
+      EXPECT_EQ(static_cast<float*>(exec->GetOutput(0)->data)[0], i + 1.0f);
+    }
+    // the arguments only change through SetInputZeroCopy, which checks them
+    auto ints = runtime::NDArray::Empty({4}, DataType::Int(32), kCPU);
+    EXPECT_ANY_THROW(exec->SetInputZeroCopy(0, const_cast<DLTensor*>(ints.operator->())));
+  }
+  EXPECT_EQ(std::system((std::string("rm -rf ") + dir).c_str()), 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -22,6 +22,7 @@
 #include <tvm/support/logging.h>
 #include <tvm/support/parallel_for.h>
 
+#include <atomic>
 #include <vector>
 
 TEST(ParallelFor, Basic) {
@@ -119,6 +120,38 @@ TEST(ParallelFor, Exception) {
   ICHECK(exception);
 }
 
+TEST(ParallelForDynamic, Basic) {
+  using tvm::support::parallel_for_dynamic;
+
+  int a[1000];
+  std::atomic<int> calls(0);
+  parallel_for_dynamic(0, 1000, 4, [&a, &calls](int thread_id, int task_id) {
+    ICHECK_GE(thread_id, 0);
+    ICHECK_LT(thread_id, 4);
+    a[task_id] = task_id;
+    calls++;
+  });
+  ICHECK_EQ(calls.load(), 1000);
+  for (int i = 0; i < 1000; i++) {
+    ICHECK_EQ(a[i], i);
+  }
+
+  // An empty range runs nothing
+  parallel_for_dynamic(10, 10, 4, [](int thread_id, int task_id) { LOG(FATAL) << "error"; });
+}
+
+TEST(ParallelForDynamic, Exception) {
+  using tvm::support::parallel_for_dynamic;
+
+  bool exception = false;
+  try {
+    parallel_for_dynamic(0, 100, 4, [](int thread_id, int task_id) { LOG(FATAL) << "error"; });
+  } catch (const std::exception& e) {
+    exception = true;
+  }
+  ICHECK(exception);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
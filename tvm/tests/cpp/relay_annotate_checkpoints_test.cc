@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+Expr Add(const Expr& a, const Expr& b) { return GetFunc("relay.op._make.add")(a, b); }
+
+Expr Relu(const Expr& e) { return GetFunc("relay.op.nn._make.relu")(e); }
+
+Expr Dense(const Expr& x, const Expr& w) {
+  return GetFunc("relay.op.nn._make.dense")(x, w, PrimExpr(), DataType());
+}
+
+struct Checkpoints {
+  // the number of checkpoints
+  int count = 0;
+  // the number of calls to `op` inside and outside of the checkpoints
+  int op_inside = 0;
+  int op_outside = 0;
+};
+
+// Annotate the function of `body` with `policy` and count its checkpoints and calls to `op`
+Checkpoints Annotate(const Expr& body, const std::string& policy, const std::string& op) {
+  IRModule mod = IRModule::FromExpr(Function(FreeVars(body), body, Type(nullptr), {}));
+  mod = transform::AnnotateCheckpoints(policy)(transform::InferType()(mod));
+  Function func = Downcast<Function>(mod->Lookup("main"));
+  // every variable is still used in the scope of its binding
+  EXPECT_TRUE(WellFormed(func));
+  EXPECT_TRUE(FreeVars(func).empty());
+  Checkpoints result;
+  int inside_all = 0;
+  PostOrderVisit(func, [&](const Expr& e) {
+    const auto* call = e.as<CallNode>();
+    if (call == nullptr) return;
+    if (call->op == Op::Get("annotation.checkpoint")) {
+      ++result.count;
+      PostOrderVisit(call->args[0], [&](const Expr& inner) {
+        const auto* c = inner.as<CallNode>();
+        if (c != nullptr && c->op == Op::Get(op)) ++result.op_inside;
+      });
+    } else if (call->op == Op::Get(op)) {
+      ++inside_all;
+    }
+  });
+  result.op_outside = inside_all - result.op_inside;
+  return result;
+}
+
+}  // namespace
+
+TEST(AnnotateCheckpoints, SqrtSegments) {
+  Var x("x", TensorType({4}, DataType::Float(32)));
+  Expr e = x;
+  for (int i = 0; i < 9; ++i) e = Relu(e);
+  // segments of 3 of the 9 bindings
+  Checkpoints result = Annotate(e, "sqrt", "nn.relu");
+  EXPECT_EQ(result.count, 3);
+  EXPECT_EQ(result.op_inside, 9);
+  EXPECT_EQ(result.op_outside, 0);
+}
+
+TEST(AnnotateCheckpoints, CheapKeepsHeavyOps) {
+  Var x("x", TensorType({2, 8}, DataType::Float(32)));
+  Var w("w", TensorType({8, 8}, DataType::Float(32)));
+  Var b("b", TensorType({8}, DataType::Float(32)));
+  Expr first = Add(Relu(Dense(x, w)), b);
+  Expr second = Add(Relu(Dense(first, w)), b);
+  // the relu and add chains after each dense are recomputed, the dense outputs are kept
+  Checkpoints result = Annotate(second, "cheap", "nn.dense");
+  EXPECT_EQ(result.count, 2);
+  EXPECT_EQ(result.op_inside, 0);
+  EXPECT_EQ(result.op_outside, 2);
+}
+
+TEST(AnnotateCheckpoints, ResidualInOneSegment) {
+  Var x("x", TensorType({4}, DataType::Float(32)));
+  Expr r = Relu(x);
+  // r is used after the next binding, no segment may end between them
+  Checkpoints result = Annotate(Add(Relu(r), r), "cheap", "nn.relu");
+  EXPECT_EQ(result.count, 1);
+  EXPECT_EQ(result.op_inside, 2);
+}
+
+TEST(AnnotateCheckpoints, UnknownPolicy) {
+  Var x("x", TensorType({4}, DataType::Float(32)));
+  EXPECT_ANY_THROW(Annotate(Relu(Relu(x)), "all", "nn.relu"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/annotation.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const int kDSP = kDLHexagon;
+const int kGPU = kDLOpenCL;
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+Expr Add(const Expr& a, const Expr& b) { return GetFunc("relay.op._make.add")(a, b); }
+
+Expr Cast(const Expr& e, DataType dtype) { return GetFunc("relay.ir.cast")(e, dtype); }
+
+Expr OnDevice(const Expr& e, int device) {
+  auto attrs = make_object<OnDeviceAttrs>();
+  attrs->device_type = device;
+  return Call(Op::Get("on_device"), {e}, Attrs(attrs), {});
+}
+
+// A quantized add requantized to int32 with a bias, then a float16 tail:
+// add(int8) -> cast(int32) -> add(bias) -> cast(float16) -> add -> cast(float32)
+Expr Model(bool annotate_first) {
+  Var x("x", TensorType({4}, DataType::Int(8)));
+  Var bias("bias", TensorType({4}, DataType::Int(32)));
+  Expr q = Add(x, x);
+  if (annotate_first) q = OnDevice(q, kGPU);
+  Expr acc = Add(Cast(q, DataType::Int(32)), bias);
+  Expr half = Cast(acc, DataType::Float(16));
+  return Cast(Add(half, half), DataType::Float(32));
+}
+
+// The op and the device of every on_device annotation, in post order
+std::vector<std::pair<std::string, int>> Devices(const Expr& body, int float_device) {
+  IRModule mod = IRModule::FromExpr(Function(FreeVars(body), body, Type(nullptr), {}));
+  mod = transform::AnnotateDeviceByDType(kDSP, float_device)(transform::InferType()(mod));
+  std::vector<std::pair<std::string, int>> devices;
+  PostOrderVisit(mod->Lookup("main"), [&devices](const Expr& e) {
+    const auto* call = e.as<CallNode>();
+    if (call == nullptr || call->op != Op::Get("on_device")) return;
+    const auto* inner = call->args[0].as<CallNode>();
+    ICHECK(inner != nullptr);
+    devices.emplace_back(Downcast<Op>(inner->op)->name,
+                         call->attrs.as<OnDeviceAttrs>()->device_type);
+  });
+  return devices;
+}
+
+}  // namespace
+
+TEST(AnnotateDeviceByDType, SplitQuantizedAndFloat16) {
+  // the bias add is an integer op on the quantized part, the last cast produces float32
+  std::vector<std::pair<std::string, int>> expected{
+      {"add", kDSP}, {"cast", kDSP}, {"add", kDSP}, {"cast", kGPU}, {"add", kGPU}};
+  EXPECT_EQ(Devices(Model(false), kGPU), expected);
+}
+
+TEST(AnnotateDeviceByDType, FallbackFloat) {
+  // without a float device, the float16 ops are left to the fallback device
+  std::vector<std::pair<std::string, int>> expected{{"add", kDSP}, {"cast", kDSP}, {"add", kDSP}};
+  EXPECT_EQ(Devices(Model(false), 0), expected);
+}
+
+TEST(AnnotateDeviceByDType, KeepUserAnnotations) {
+  std::vector<std::pair<std::string, int>> expected{
+      {"add", kGPU}, {"cast", kDSP}, {"add", kDSP}, {"cast", kGPU}, {"add", kGPU}};
+  EXPECT_EQ(Devices(Model(true), kGPU), expected);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 #include <tvm/driver/driver_api.h>
 #include <tvm/ir/module.h>
+#include <tvm/node/structural_equal.h>
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/expr.h>
 #include <tvm/relay/op_attr_types.h>
@@ -33,6 +34,13 @@
 #include <tvm/topi/broadcast.h>
 #include <tvm/topi/generic/injective.h>
 
+#include <dirent.h>
+
+#include <cstdlib>
+#include <string>
+
+#include "../../src/relay/backend/compile_engine.h"
+
 using namespace tvm;
 using namespace tvm::relay;
 
@@ -72,6 +80,40 @@ TVM_REGISTER_GLOBAL("relay.backend.lower_call")
       return (*f)(outs, impl);
     });
 
+namespace {
+
+// Register test.strategy for add, once for all the tests
+void RegisterAddStrategy() {
+  static bool registered = false;
+  if (registered) return;
+  registered = true;
+  auto reg = tvm::runtime::Registry::Get("ir.RegisterOpAttr");
+  if (!reg) {
+    LOG(FATAL) << "no _Register";
+  }
+  auto fs = tvm::runtime::Registry::Get("test.strategy");
+  if (!fs) {
+    LOG(FATAL) << "No test_strategy registered.";
+  }
+  auto fgeneric = GenericFunc::Get("test.strategy_generic").set_default(*fs);
+  (*reg)("add", "FTVMStrategy", fgeneric, 10);
+  Array<Integer> dep;
+  dep.push_back(0);
+  (*reg)("add", "TShapeDataDependent", dep, 10);
+}
+
+// The number of files in a directory
+int CountFiles(const std::string& dir) {
+  int count = 0;
+  if (DIR* d = opendir(dir.c_str())) {
+    while (const dirent* entry = readdir(d)) count += entry->d_name[0] != '.';
+    closedir(d);
+  }
+  return count;
+}
+
+}  // namespace
+
 TEST(Relay, BuildModule) {
   auto tensor_type = relay::TensorType({2, 3}, DataType::Float(32));
   auto a = relay::Var("a", tensor_type);
@@ -95,19 +137,7 @@ TEST(Relay, BuildModule) {
     pC[i] = i + 2;
   }
   // get schedule
-  auto reg = tvm::runtime::Registry::Get("ir.RegisterOpAttr");
-  if (!reg) {
-    LOG(FATAL) << "no _Register";
-  }
-  auto fs = tvm::runtime::Registry::Get("test.strategy");
-  if (!fs) {
-    LOG(FATAL) << "No test_strategy registered.";
-  }
-  auto fgeneric = GenericFunc::Get("test.strategy_generic").set_default(*fs);
-  (*reg)("add", "FTVMStrategy", fgeneric, 10);
-  Array<Integer> dep;
-  dep.push_back(0);
-  (*reg)("add", "TShapeDataDependent", dep, 10);
+  RegisterAddStrategy();
   // build
   auto pfb = tvm::runtime::Registry::Get("relay.build_module._BuildModule");
   tvm::runtime::Module build_mod = (*pfb)();
@@ -181,6 +211,43 @@ TEST(Relay, GetExprRefCount) {
   ICHECK(ref_count[z.get()] == 1);
 }
 
+TEST(Relay, PersistentCompileCache) {
+  RegisterAddStrategy();
+  auto tensor_type = relay::TensorType({2, 3}, DataType::Float(32));
+  auto a = relay::Var("a", tensor_type);
+  auto b = relay::Var("b", tensor_type);
+  auto add = relay::Call(relay::Op::Get("add"), {a, b}, tvm::Attrs(), {});
+  auto mod = transform::InferType()(IRModule::FromExpr(relay::Function({a, b}, add, {}, {})));
+  CCacheKey key(Downcast<Function>(mod->Lookup("main")), Target("llvm"));
+  char dir[] = "/tmp/tvm_compile_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+
+  auto lower = [&key, &dir](int opt_level) {
+    auto pass_ctx = transform::PassContext::Create();
+    pass_ctx->opt_level = opt_level;
+    pass_ctx->config.Set("relay.backend.compile_cache_dir", String(dir));
+    With<transform::PassContext> ctx_scope(pass_ctx);
+    CompileEngine::Global()->Clear();
+    return CompileEngine::Global()->Lower(key);
+  };
+  CachedFunc lowered = lower(3);
+  EXPECT_EQ(CountFiles(dir), 1);
+  // Restored from the entry with its tensors, the cost estimates of the graph need them
+  CachedFunc restored = lower(3);
+  EXPECT_EQ(CountFiles(dir), 1);
+  ASSERT_EQ(restored->inputs.size(), 2U);
+  ASSERT_EQ(restored->outputs.size(), 1U);
+  EXPECT_TRUE(StructuralEqual()(restored->outputs[0]->shape, lowered->outputs[0]->shape));
+  EXPECT_NE(restored->func_name, lowered->func_name);
+  EXPECT_TRUE(restored->funcs->ContainGlobalVar(restored->func_name));
+  // The pass context options are part of the key
+  lower(2);
+  EXPECT_EQ(CountFiles(dir), 2);
+
+  CompileEngine::Global()->Clear();
+  EXPECT_EQ(std::system((std::string("rm -rf ") + dir).c_str()), 0);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+// The CMSIS-NN codegen is only built with USE_CMSISNN
+bool HasCMSISNN() {
+  return runtime::Registry::Get("relay.ext.cmsisnn.partition_for_cmsisnn") != nullptr;
+}
+
+template <typename T>
+Constant MakeConstant(DataType dtype, const std::vector<int64_t>& shape,
+                      const std::vector<T>& values) {
+  auto data = runtime::NDArray::Empty(shape, dtype, {kDLCPU, 0});
+  data.CopyFromBytes(values.data(), values.size() * sizeof(T));
+  return Constant(data);
+}
+
+template <typename T>
+Constant MakeScalar(DataType dtype, T value) {
+  return MakeConstant(dtype, {}, std::vector<T>{value});
+}
+
+// requantize(op) to int8, the op accumulating x * w with the scale 0.5
+Expr Requantize(const Expr& op) {
+  const auto* make = runtime::Registry::Get("relay.qnn.op._make.requantize");
+  return (*make)(op, MakeScalar(DataType::Float(32), 0.5f), MakeScalar(DataType::Int(32), 0),
+                 MakeScalar(DataType::Float(32), 1.0f), MakeScalar(DataType::Int(32), 0), -1,
+                 String("UPWARD"), DataType::Int(8));
+}
+
+// An int8 qnn.dense of 8 inputs and 4 units, with the kernel zero point `kernel_zero_point`
+Expr Dense(const Var& x, int32_t kernel_zero_point) {
+  const auto* make = runtime::Registry::Get("relay.qnn.op._make.dense");
+  Expr dense = (*make)(x, MakeConstant(DataType::Int(8), {4, 8}, std::vector<int8_t>(32, 1)),
+                       MakeScalar(DataType::Int(32), 0),
+                       MakeScalar(DataType::Int(32), kernel_zero_point),
+                       MakeScalar(DataType::Float(32), 0.5f), MakeScalar(DataType::Float(32), 1.0f),
+                       PrimExpr(4), DataType::Int(32));
+  return Requantize(dense);
+}
+
+IRModule Partition(const Var& x, const Expr& body) {
+  IRModule mod = IRModule::FromExpr(Function({x}, body, Type(), {}));
+  const auto* partition = runtime::Registry::Get("relay.ext.cmsisnn.partition_for_cmsisnn");
+  transform::Pass pass = (*partition)();
+  return pass(mod);
+}
+
+// The functions partitioned for CMSIS-NN
+std::vector<Function> CMSISNNFunctions(const IRModule& mod) {
+  std::vector<Function> funcs;
+  for (const auto& kv : mod->functions) {
+    if (const auto* func = kv.second.as<FunctionNode>()) {
+      if (func->GetAttr<String>(attr::kCompiler) == "cmsisnn") {
+        funcs.push_back(GetRef<Function>(func));
+      }
+    }
+  }
+  return funcs;
+}
+
+std::string Source(const Function& func) {
+  runtime::Module built = (*runtime::Registry::Get("relay.ext.cmsisnn"))(func);
+  return built->GetSource("c");
+}
+
+}  // namespace
+
+TEST(CMSISNN, Dense) {
+  if (!HasCMSISNN()) return;
+  Var x("x", TensorType({1, 8}, DataType::Int(8)));
+  std::vector<Function> funcs = CMSISNNFunctions(Partition(x, Dense(x, 0)));
+  ASSERT_EQ(funcs.size(), 1U);
+  std::string source = Source(funcs[0]);
+  EXPECT_NE(source.find("arm_fully_connected_s8("), std::string::npos);
+  // 0.5 is the Q31 multiplier 2^30 with no shift
+  EXPECT_NE(source.find("quant_params.multiplier = 1073741824;"), std::string::npos);
+  EXPECT_NE(source.find("quant_params.shift = 0;"), std::string::npos);
+  EXPECT_NE(source.find("cmsis_nn_dims filter_dims = {8, 1, 1, 4};"), std::string::npos);
+}
+
+TEST(CMSISNN, KernelZeroPointNotOffloaded) {
+  if (!HasCMSISNN()) return;
+  Var x("x", TensorType({1, 8}, DataType::Int(8)));
+  EXPECT_TRUE(CMSISNNFunctions(Partition(x, Dense(x, 1))).empty());
+}
+
+TEST(CMSISNN, Conv2DFilterInOHWI) {
+  if (!HasCMSISNN()) return;
+  Var x("x", TensorType({1, 4, 4, 2}, DataType::Int(8)));
+  // HWIO weights of a 1x1 convolution from 2 to 2 channels, w[i][o] = 1 + 2 * i + o
+  Constant w = MakeConstant(DataType::Int(8), {1, 1, 2, 2}, std::vector<int8_t>{1, 2, 3, 4});
+  const auto* make = runtime::Registry::Get("relay.qnn.op._make.conv2d");
+  Expr conv = (*make)(x, w, MakeScalar(DataType::Int(32), 0), MakeScalar(DataType::Int(32), 0),
+                      MakeScalar(DataType::Float(32), 0.5f), MakeScalar(DataType::Float(32), 1.0f),
+                      Array<PrimExpr>{1, 1}, Array<PrimExpr>{0, 0}, Array<PrimExpr>{1, 1}, 1,
+                      PrimExpr(2), Array<PrimExpr>{1, 1}, String("NHWC"), String("HWIO"),
+                      String(""), DataType::Int(32));
+  std::vector<Function> funcs = CMSISNNFunctions(Partition(x, Requantize(conv)));
+  ASSERT_EQ(funcs.size(), 1U);
+  std::string source = Source(funcs[0]);
+  EXPECT_NE(source.find("arm_convolve_wrapper_s8("), std::string::npos);
+  EXPECT_NE(source.find("_filter[4] = {\n    1, 3, 2, 4,\n};"), std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+
+#include <string>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+// A 1x1 convolution with `channels` output channels
+Expr Conv2D(const Expr& data, const Expr& weight, int channels, const std::string& data_layout,
+            const std::string& kernel_layout) {
+  return GetFunc("relay.op.nn._make.conv2d")(
+      data, weight, Array<PrimExpr>{1, 1}, Array<PrimExpr>{0, 0}, Array<PrimExpr>{1, 1}, 1,
+      PrimExpr(channels), Array<PrimExpr>{1, 1}, String(data_layout), String(kernel_layout),
+      String(""), DataType());
+}
+
+/*!
+ * \brief Three parallel convolutions of one input, combined by CombineParallelConv2D.
+ * \param data_shape The shape of the input.
+ * \param weight_shape The shape of the weight of each branch.
+ * \param channels The output channels of each branch.
+ * \param packed Whether the convolutions are in the NCHW4c layout, else in NCHW.
+ * \param target The target the pass runs under, if defined.
+ * \return The convolutions left after the pass.
+ */
+std::vector<Call> CombineBranches(const Array<PrimExpr>& data_shape,
+                                  const Array<PrimExpr>& weight_shape, int channels, bool packed,
+                                  const Target& target) {
+  Var x("x", TensorType(data_shape, DataType::Float(32)));
+  Array<Var> params{x};
+  Array<Expr> branches;
+  for (int i = 0; i < 3; ++i) {
+    params.push_back(Var("w" + std::to_string(i), TensorType(weight_shape, DataType::Float(32))));
+    branches.push_back(Conv2D(x, params.back(), channels, packed ? "NCHW4c" : "NCHW",
+                              packed ? "OIHW4o" : "OIHW"));
+  }
+  IRModule mod = IRModule::FromExpr(Function(params, Tuple(branches), Type(), {}));
+  auto seq = transform::Sequential(
+      {transform::InferType(), transform::CombineParallelConv2D(3), transform::InferType()});
+  if (target.defined()) {
+    With<Target> target_scope(target);
+    mod = seq(mod);
+  } else {
+    mod = seq(mod);
+  }
+  static const Op& conv2d = Op::Get("nn.conv2d");
+  std::vector<Call> convs;
+  PostOrderVisit(mod->Lookup("main"), [&convs](const Expr& expr) {
+    if (const auto* call = expr.as<CallNode>()) {
+      if (call->op == conv2d) convs.push_back(GetRef<Call>(call));
+    }
+  });
+  return convs;
+}
+
+const Target& Adreno() {
+  static Target target("opencl -device=adreno");
+  return target;
+}
+
+}  // namespace
+
+TEST(CombineParallelConv2D, PackedChannelBlocks) {
+  // The weights are concatenated along their outer O axis, and the combined convolution
+  // computes the 4 channels of each of the 3 branches
+  std::vector<Call> convs = CombineBranches({1, 1, 8, 8, 4}, {1, 4, 1, 1, 4}, 4, true, Adreno());
+  ASSERT_EQ(convs.size(), 1U);
+  EXPECT_EQ(Downcast<IntImm>(convs[0]->attrs.as<Conv2DAttrs>()->channels)->value, 12);
+  const auto* ttype = convs[0]->checked_type().as<TensorTypeNode>();
+  ASSERT_NE(ttype, nullptr);
+  ASSERT_EQ(ttype->shape.size(), 5U);
+  EXPECT_EQ(Downcast<IntImm>(ttype->shape[1])->value, 3);
+  EXPECT_EQ(Downcast<IntImm>(ttype->shape[4])->value, 4);
+}
+
+TEST(CombineParallelConv2D, UnpackedBranchesOfWholeTexels) {
+  // Branches of 6 channels would not start on a texel once packed by 4
+  EXPECT_EQ(CombineBranches({1, 4, 8, 8}, {6, 4, 1, 1}, 6, false, Adreno()).size(), 3U);
+  EXPECT_EQ(CombineBranches({1, 4, 8, 8}, {6, 4, 1, 1}, 6, false, Target()).size(), 1U);
+  std::vector<Call> convs = CombineBranches({1, 4, 8, 8}, {8, 4, 1, 1}, 8, false, Adreno());
+  ASSERT_EQ(convs.size(), 1U);
+  EXPECT_EQ(Downcast<IntImm>(convs[0]->attrs.as<Conv2DAttrs>()->channels)->value, 24);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
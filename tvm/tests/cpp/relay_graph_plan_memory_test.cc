@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/ir/transform.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+
+#include <functional>
+#include <set>
+#include <string>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+// A call of a primitive function of `make_body` with the argument `arg`
+Expr Primitive(const std::function<Expr(const Expr&)>& make_body, const Expr& arg) {
+  Var param("p0", Type());
+  Function primitive({param}, make_body(param), Type(), {});
+  return Call(WithAttr(std::move(primitive), attr::kPrimitive, Integer(1)), {arg});
+}
+
+struct Chain {
+  Function main;
+  // The calls in execution order
+  Array<Expr> calls;
+};
+
+/*!
+ * \brief A chain of two small calls, a call 1024 times larger and a small call reading it.
+ *  The token planner cannot reuse the small storage for the large tensor, which the greedy by
+ *  size planner places first.
+ */
+Chain SmallLargeChain() {
+  Var x("x", TensorType({1}, DataType::Float(32)));
+  auto negative = [](const Expr& p) { return GetFunc("relay.op._make.negative")(p); };
+  Expr a = Primitive(negative, x);
+  Expr b = Primitive(negative, a);
+  Expr c = Primitive(
+      [](const Expr& p) {
+        return GetFunc("relay.op._make.broadcast_to")(p, Array<Integer>{1024});
+      },
+      b);
+  Expr d = Primitive(
+      [](const Expr& p) {
+        return GetFunc("relay.op._make.sum")(p, Array<Integer>{0}, true, false);
+      },
+      c);
+  IRModule mod = transform::InferType()(IRModule::FromExpr(Function({x}, d, Type(), {})));
+  Chain chain;
+  chain.main = Downcast<Function>(mod->Lookup("main"));
+  for (Expr e = chain.main->body; e.as<CallNode>(); e = Downcast<Call>(e)->args[0]) {
+    chain.calls.insert(chain.calls.begin(), e);
+  }
+  return chain;
+}
+
+// The plan of `func` on the CPU by the planner `planner`
+Map<Expr, runtime::ADT> Plan(const Function& func, const std::string& planner) {
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("relay.backend.graph_memory_planner", String(planner));
+  With<transform::PassContext> ctx_scope(pass_ctx);
+  return GetFunc("relay.backend.GraphPlanMemory")(
+      func, Map<Integer, Target>({{Integer(kDLCPU), Target("llvm")}}));
+}
+
+int64_t StorageId(const Map<Expr, runtime::ADT>& plan, const Expr& expr) {
+  return Downcast<Array<Integer>>(plan[expr][0])[0]->value;
+}
+
+size_t NumStorage(const Map<Expr, runtime::ADT>& plan) {
+  std::set<int64_t> ids;
+  for (const auto& kv : plan) ids.insert(StorageId(plan, kv.first));
+  return ids.size();
+}
+
+}  // namespace
+
+TEST(GraphPlanMemory, GreedyBySize) {
+  Chain chain = SmallLargeChain();
+  ASSERT_EQ(chain.calls.size(), 4U);
+  Map<Expr, runtime::ADT> token = Plan(chain.main, "token");
+  Map<Expr, runtime::ADT> greedy = Plan(chain.main, "greedy_by_size");
+  EXPECT_LT(NumStorage(greedy), NumStorage(token));
+  // The tensors living at the same time, a call and its argument, never share storage
+  Expr x = chain.main->params[0];
+  Expr prev = x;
+  for (const Expr& call : chain.calls) {
+    EXPECT_NE(StorageId(greedy, call), StorageId(greedy, prev));
+    prev = call;
+  }
+  // The first small tensor is dead before the large one is computed
+  EXPECT_EQ(StorageId(greedy, chain.calls[0]), StorageId(greedy, chain.calls[2]));
+  // The input keeps its own storage, and the ids are numbered from 0
+  for (const Expr& call : chain.calls) {
+    EXPECT_NE(StorageId(greedy, call), StorageId(greedy, x));
+  }
+  for (const auto& kv : greedy) {
+    EXPECT_LT(StorageId(greedy, kv.first), static_cast<int64_t>(NumStorage(greedy)));
+  }
+}
+
+TEST(GraphPlanMemory, TokenIsDefault) {
+  Chain chain = SmallLargeChain();
+  Map<Expr, runtime::ADT> plan = GetFunc("relay.backend.GraphPlanMemory")(
+      chain.main, Map<Integer, Target>({{Integer(kDLCPU), Target("llvm")}}));
+  Map<Expr, runtime::ADT> token = Plan(chain.main, "token");
+  for (const auto& kv : token) {
+    EXPECT_EQ(StorageId(plan, kv.first), StorageId(token, kv.first));
+  }
+}
+
+TEST(GraphPlanMemory, UnknownPlanner) {
+  EXPECT_ANY_THROW(Plan(SmallLargeChain().main, "hill_climb"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
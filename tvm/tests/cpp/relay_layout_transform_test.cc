@@ -0,0 +1,114 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+Expr LayoutTransform(const Expr& data, const std::string& src, const std::string& dst) {
+  return GetFunc("relay.op._make.layout_transform")(data, String(src), String(dst));
+}
+
+Expr Relu(const Expr& data) { return GetFunc("relay.op.nn._make.relu")(data); }
+
+Expr Add(const Expr& lhs, const Expr& rhs) { return GetFunc("relay.op._make.add")(lhs, rhs); }
+
+Expr Concatenate(const Array<Expr>& fields, int axis) {
+  return GetFunc("relay.op._make.concatenate")(Tuple(fields), axis);
+}
+
+Var PackedInput(const std::string& name) {
+  return Var(name, TensorType({1, 2, 8, 8, 4}, DataType::Float(32)));
+}
+
+Function Propagate(const Expr& body) {
+  IRModule mod = IRModule::FromExpr(Function(FreeVars(body), body, Type(nullptr), {}));
+  mod = transform::InferType()(mod);
+  mod = transform::PropagateLayoutTransform()(mod);
+  return Downcast<Function>(mod->Lookup("main"));
+}
+
+int CountLayoutTransforms(const Function& f) {
+  static const Op& layout_transform_op = Op::Get("layout_transform");
+  int count = 0;
+  PostOrderVisit(f->body, [&count](const Expr& e) {
+    if (const auto* call = e.as<CallNode>()) count += call->op == layout_transform_op;
+  });
+  return count;
+}
+
+}  // namespace
+
+TEST(PropagateLayoutTransform, CancelRoundTrip) {
+  Var x = PackedInput("x");
+  Expr unpacked = LayoutTransform(x, "NCHW4c", "NCHW");
+  Function f = Propagate(LayoutTransform(Relu(unpacked), "NCHW", "NCHW4c"));
+  EXPECT_EQ(CountLayoutTransforms(f), 0);
+  EXPECT_EQ(f->checked_type().as<FuncTypeNode>()->ret_type.as<TensorTypeNode>()->shape.size(),
+            5U);
+}
+
+TEST(PropagateLayoutTransform, SinkThroughBinaryOp) {
+  Var x = PackedInput("x");
+  Var y = PackedInput("y");
+  Expr sum = Add(LayoutTransform(x, "NCHW4c", "NCHW"), LayoutTransform(y, "NCHW4c", "NCHW"));
+  // The two input transforms become one transform of the output
+  EXPECT_EQ(CountLayoutTransforms(Propagate(Relu(sum))), 1);
+}
+
+TEST(PropagateLayoutTransform, KeepSharedTransform) {
+  Var x = PackedInput("x");
+  Expr unpacked = LayoutTransform(x, "NCHW4c", "NCHW");
+  // Sinking the transform out of both users would add one
+  Expr body = Add(Relu(unpacked), unpacked);
+  EXPECT_EQ(CountLayoutTransforms(Propagate(body)), 1);
+}
+
+TEST(PropagateLayoutTransform, KeepConcatenateOfPackedAxis) {
+  Var x = PackedInput("x");
+  Var y = PackedInput("y");
+  // The channels are packed in NCHW4c, the concatenation stays in NCHW
+  Expr body = Concatenate(
+      {LayoutTransform(x, "NCHW4c", "NCHW"), LayoutTransform(y, "NCHW4c", "NCHW")}, 1);
+  EXPECT_EQ(CountLayoutTransforms(Propagate(body)), 2);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
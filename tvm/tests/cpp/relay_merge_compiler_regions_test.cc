@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/ir/transform.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/annotation.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+
+#include <set>
+#include <string>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+/*!
+ * \brief Merge the regions of an add of a 1x16 input with itself annotated for `compiler`.
+ * \param config The pass config options.
+ * \return The compilers of the annotations of the merged function.
+ */
+std::set<std::string> MergeAdd(const std::string& compiler, const Map<String, ObjectRef>& config) {
+  Var x("x", TensorType({1, 16}, DataType::Float(32)));
+  Expr begin = GetFunc("relay.op.annotation._make.compiler_begin")(x, String(compiler));
+  Expr add = GetFunc("relay.op._make.add")(begin, begin);
+  Expr end = GetFunc("relay.op.annotation._make.compiler_end")(add, String(compiler));
+  IRModule mod = transform::InferType()(IRModule::FromExpr(Function({x}, end, Type(), {})));
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config = config;
+  With<transform::PassContext> ctx_scope(pass_ctx);
+  transform::Pass merge = GetFunc("relay._transform.MergeCompilerRegions")();
+  mod = merge(mod);
+  std::set<std::string> compilers;
+  PostOrderVisit(mod->Lookup("main"), [&compilers](const Expr& e) {
+    const auto* call = e.as<CallNode>();
+    if (call == nullptr) return;
+    if (const auto* attrs = call->attrs.as<CompilerAttrs>()) compilers.insert(attrs->compiler);
+  });
+  return compilers;
+}
+
+}  // namespace
+
+TEST(MergeCompilerRegions, CostAwareIsOptIn) {
+  EXPECT_EQ(MergeAdd("test_target", {}), std::set<std::string>{"test_target"});
+}
+
+TEST(MergeCompilerRegions, DropLowIntensityRegion) {
+  // 16 flops over 128 boundary bytes
+  Map<String, ObjectRef> config{{"relay.MergeCompilerRegions.cost_aware", Bool(true)}};
+  EXPECT_EQ(MergeAdd("test_target", config), std::set<std::string>{"default"});
+  config.Set("relay.MergeCompilerRegions.min_flops_per_byte", Integer(0));
+  EXPECT_EQ(MergeAdd("test_target", config), std::set<std::string>{"test_target"});
+}
+
+TEST(MergeCompilerRegions, RegionCostHook) {
+  int64_t boundary_bytes = 0;
+  runtime::Registry::Register("relay.ext.test_costed.region_cost", true)
+      .set_body_typed([&boundary_bytes](Array<Expr> outputs, Integer bytes) {
+        EXPECT_EQ(outputs.size(), 1U);
+        boundary_bytes = bytes->value;
+        return Array<FloatImm>{FloatImm(DataType::Float(64), 1.0),
+                               FloatImm(DataType::Float(64), 2.0)};
+      });
+  // The hook keeps the region the intensity would drop
+  Map<String, ObjectRef> config{{"relay.MergeCompilerRegions.cost_aware", Bool(true)}};
+  EXPECT_EQ(MergeAdd("test_costed", config), std::set<std::string>{"test_costed"});
+  EXPECT_EQ(boundary_bytes, 128);
+  runtime::Registry::Remove("relay.ext.test_costed.region_cost");
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
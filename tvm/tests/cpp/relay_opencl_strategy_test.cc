@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/relay/attrs/algorithm.h>
+#include <tvm/relay/attrs/vision.h>
+#include <tvm/relay/op_strategy.h>
+#include <tvm/target/generic_func.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/stmt_functor.h>
+
+#include <string>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+// The implementations of the strategy `name` for an opencl target
+Array<OpImplementation> Implementations(const std::string& name, const Attrs& attrs,
+                                        const Array<te::Tensor>& inputs) {
+  Target target("opencl");
+  With<Target> scope(target);
+  OpStrategy strategy = GenericFunc::Get(name)(attrs, inputs, Type(), target);
+  Array<OpImplementation> impls;
+  for (const OpSpecialization& spec : strategy->specializations) {
+    for (const OpImplementation& impl : spec->implementations) impls.push_back(impl);
+  }
+  return impls;
+}
+
+// The implementation named `name`, undefined when there is none
+OpImplementation Find(const Array<OpImplementation>& impls, const std::string& name) {
+  for (const OpImplementation& impl : impls) {
+    if (impl->name == name) return impl;
+  }
+  return OpImplementation();
+}
+
+// The name of the packed function called by an extern op
+std::string ExternCall(const te::Tensor& out) {
+  const auto* op = out->op.as<te::ExternOpNode>();
+  if (op == nullptr) return "";
+  std::string name;
+  tir::PostOrderVisit(op->body, [&name](const ObjectRef& n) {
+    const auto* call = n.as<tir::CallNode>();
+    if (call != nullptr && call->op.same_as(tir::builtin::tvm_call_packed())) {
+      name = call->args[0].as<tir::StringImmNode>()->value;
+    }
+  });
+  return name;
+}
+
+// The inputs of non_max_suppression, max_output_size of type `max_output_size_dtype`
+Array<te::Tensor> NMSInputs(DataType max_output_size_dtype) {
+  return {te::placeholder({1, 100, 6}, DataType::Float(32), "data"),
+          te::placeholder({1}, DataType::Int(32), "valid_count"),
+          te::placeholder({1, 100}, DataType::Int(32), "indices"),
+          te::placeholder({}, max_output_size_dtype, "max_output_size"),
+          te::placeholder({}, DataType::Float(32), "iou_threshold")};
+}
+
+}  // namespace
+
+TEST(OpenCLStrategy, Argsort) {
+  auto attrs = make_object<ArgsortAttrs>();
+  attrs->axis = -1;
+  attrs->is_ascend = true;
+  attrs->dtype = DataType::Int(32);
+  te::Tensor input = te::placeholder({4, 100}, DataType::Float(32), "x");
+  OpImplementation impl = Find(Implementations("argsort_strategy", Attrs(attrs), {input}),
+                               "argsort.opencl");
+  ASSERT_TRUE(impl.defined());
+  EXPECT_GT(impl->plevel, 10);
+  Array<te::Tensor> outs = impl.Compute(Attrs(attrs), {input}, Type());
+  ASSERT_EQ(outs.size(), 1U);
+  EXPECT_EQ(outs[0]->dtype, DataType::Int(32));
+  EXPECT_EQ(ExternCall(outs[0]), "tvm.contrib.opencl.argsort");
+}
+
+TEST(OpenCLStrategy, ArgsortUnsupportedKey) {
+  auto attrs = make_object<ArgsortAttrs>();
+  attrs->axis = -1;
+  attrs->is_ascend = true;
+  attrs->dtype = DataType::Int(32);
+  te::Tensor input = te::placeholder({4, 100}, DataType::Float(16), "x");
+  EXPECT_FALSE(Find(Implementations("argsort_strategy", Attrs(attrs), {input}), "argsort.opencl")
+                   .defined());
+}
+
+TEST(OpenCLStrategy, Topk) {
+  auto attrs = make_object<TopKAttrs>();
+  attrs->k = Integer(5);
+  attrs->axis = 1;
+  attrs->is_ascend = false;
+  attrs->ret_type = "both";
+  attrs->dtype = DataType::Int(64);
+  te::Tensor input = te::placeholder({4, 100}, DataType::Int(32), "x");
+  OpImplementation impl =
+      Find(Implementations("topk_strategy", Attrs(attrs), {input}), "topk.opencl");
+  ASSERT_TRUE(impl.defined());
+  Array<te::Tensor> outs = impl.Compute(Attrs(attrs), {input}, Type());
+  ASSERT_EQ(outs.size(), 2U);
+  EXPECT_EQ(outs[0]->dtype, DataType::Int(32));
+  EXPECT_EQ(outs[1]->dtype, DataType::Int(64));
+  EXPECT_EQ(Downcast<IntImm>(outs[1]->shape[1])->value, 5);
+  EXPECT_EQ(ExternCall(outs[0]), "tvm.contrib.opencl.topk");
+}
+
+TEST(OpenCLStrategy, TopkDynamicK) {
+  auto attrs = make_object<TopKAttrs>();
+  attrs->axis = 1;
+  attrs->is_ascend = false;
+  attrs->ret_type = "indices";
+  attrs->dtype = DataType::Int(32);
+  te::Tensor input = te::placeholder({4, 100}, DataType::Float(32), "x");
+  EXPECT_FALSE(Find(Implementations("topk_strategy", Attrs(attrs), {input}), "topk.opencl")
+                   .defined());
+}
+
+TEST(OpenCLStrategy, GetValidCounts) {
+  auto attrs = make_object<GetValidCountsAttrs>();
+  attrs->id_index = 0;
+  attrs->score_index = 1;
+  Array<te::Tensor> inputs{te::placeholder({1, 100, 6}, DataType::Float(32), "data"),
+                           te::placeholder({}, DataType::Float(32), "score_threshold")};
+  OpImplementation impl = Find(Implementations("get_valid_counts_strategy", Attrs(attrs), inputs),
+                               "get_valid_counts.opencl");
+  ASSERT_TRUE(impl.defined());
+  Array<te::Tensor> outs = impl.Compute(Attrs(attrs), inputs, Type());
+  ASSERT_EQ(outs.size(), 3U);
+  EXPECT_EQ(outs[0]->shape.size(), 1U);
+  EXPECT_EQ(outs[2]->dtype, DataType::Int(32));
+  EXPECT_EQ(ExternCall(outs[0]), "tvm.contrib.opencl.get_valid_counts");
+}
+
+TEST(OpenCLStrategy, NonMaxSuppression) {
+  auto attrs = make_object<NonMaximumSuppressionAttrs>();
+  attrs->force_suppress = false;
+  attrs->top_k = -1;
+  attrs->coord_start = 2;
+  attrs->score_index = 1;
+  attrs->id_index = 0;
+  attrs->return_indices = false;
+  attrs->invalid_to_bottom = true;
+  Array<te::Tensor> inputs = NMSInputs(DataType::Int(32));
+  OpImplementation impl = Find(Implementations("nms_strategy", Attrs(attrs), inputs),
+                               "non_max_suppression.opencl");
+  ASSERT_TRUE(impl.defined());
+  Array<te::Tensor> outs = impl.Compute(Attrs(attrs), inputs, Type());
+  ASSERT_EQ(outs.size(), 1U);
+  EXPECT_EQ(ExternCall(outs[0]), "tvm.contrib.opencl.non_max_suppression");
+  // The scalars are passed as their data, the index tensor is not read
+  EXPECT_EQ(outs[0]->op.as<te::ExternOpNode>()->inputs.size(), 4U);
+}
+
+TEST(OpenCLStrategy, NonMaxSuppressionUnsupported) {
+  auto attrs = make_object<NonMaximumSuppressionAttrs>();
+  attrs->top_k = -1;
+  attrs->coord_start = 2;
+  attrs->score_index = 1;
+  attrs->id_index = 0;
+  attrs->return_indices = true;
+  EXPECT_FALSE(Find(Implementations("nms_strategy", Attrs(attrs), NMSInputs(DataType::Int(32))),
+                    "non_max_suppression.opencl")
+                   .defined());
+  attrs->return_indices = false;
+  EXPECT_FALSE(Find(Implementations("nms_strategy", Attrs(attrs), NMSInputs(DataType::Int(64))),
+                    "non_max_suppression.opencl")
+                   .defined());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -23,6 +23,7 @@
 #include <tvm/relay/expr.h>
 #include <tvm/relay/transform.h>
 #include <tvm/relay/type.h>
+#include <tvm/runtime/registry.h>
 #include <tvm/te/operation.h>
 
 TEST(Relay, SelfReference) {
@@ -42,6 +43,51 @@ TEST(Relay, SelfReference) {
   ICHECK(tvm::StructuralEqual()(type_fx->checked_type(), expected));
 }
 
+namespace {
+
+tvm::relay::Expr Add(const tvm::relay::Expr& lhs, const tvm::relay::Expr& rhs) {
+  return (*tvm::runtime::Registry::Get("relay.op._make.add"))(lhs, rhs);
+}
+
+tvm::relay::Expr Relu(const tvm::relay::Expr& data) {
+  return (*tvm::runtime::Registry::Get("relay.op.nn._make.relu"))(data);
+}
+
+tvm::relay::Type InferReturnType(const tvm::relay::Var& x, const tvm::relay::Expr& body,
+                                 bool incremental) {
+  using namespace tvm;
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("relay.InferType.incremental", Bool(incremental));
+  With<transform::PassContext> scope(pass_ctx);
+  auto mod = IRModule::FromExpr(relay::Function({x}, body, relay::Type(), {}));
+  mod = relay::transform::InferType()(mod);
+  return Downcast<relay::Function>(mod->Lookup("main"))->body->checked_type();
+}
+
+}  // namespace
+
+TEST(Relay, IncrementalInferType) {
+  using namespace tvm;
+  auto tensor_type = relay::TensorType({4}, DataType::Float(32));
+  auto x = relay::Var("x", tensor_type);
+  relay::Expr sum = Add(x, x);
+  ASSERT_TRUE(StructuralEqual()(InferReturnType(x, sum, false), tensor_type));
+  // A node rewritten on top of a typed subgraph is inferred again
+  relay::Expr relu = Relu(sum);
+  ICHECK(!relu->checked_type_.defined());
+  EXPECT_TRUE(StructuralEqual()(InferReturnType(x, relu, true), tensor_type));
+}
+
+TEST(Relay, InferTypeIgnoresStaleType) {
+  using namespace tvm;
+  auto tensor_type = relay::TensorType({4}, DataType::Float(32));
+  auto x = relay::Var("x", tensor_type);
+  relay::Expr sum = Add(x, x);
+  // A checked type set by hand by a pass, which the default inference does not trust
+  sum->checked_type_ = relay::TensorType({8}, DataType::Float(32));
+  EXPECT_TRUE(StructuralEqual()(InferReturnType(x, Relu(sum), false), tensor_type));
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
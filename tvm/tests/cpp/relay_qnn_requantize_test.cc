@@ -0,0 +1,177 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/relay/attrs/transform.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+template <typename T>
+Constant MakeConstant(DataType dtype, const std::vector<T>& values) {
+  auto data = runtime::NDArray::Empty({static_cast<int64_t>(values.size())}, dtype, {kDLCPU, 0});
+  data.CopyFromBytes(values.data(), values.size() * sizeof(T));
+  return Constant(data);
+}
+
+template <typename T>
+Constant MakeScalar(DataType dtype, T value) {
+  auto data = runtime::NDArray::Empty({}, dtype, {kDLCPU, 0});
+  data.CopyFromBytes(&value, sizeof(T));
+  return Constant(data);
+}
+
+// Round a value to one of the types the lowered requantize computes in
+double ToDataType(double value, DataType dtype) {
+  if (dtype.is_float()) return static_cast<float>(value);
+  return static_cast<double>(static_cast<int64_t>(value));
+}
+
+/*!
+ * \brief Evaluate the elementwise ops of a lowered requantize.
+ * \param expr The lowered expression, over constants.
+ * \param dtype The type of the result.
+ * \return The values.
+ */
+std::vector<double> Evaluate(const Expr& expr, DataType* dtype) {
+  if (const auto* constant = expr.as<ConstantNode>()) {
+    const runtime::NDArray& data = constant->data;
+    *dtype = data.DataType();
+    int64_t size = 1;
+    for (int i = 0; i < data->ndim; ++i) size *= data->shape[i];
+    std::vector<double> values;
+    for (int64_t i = 0; i < size; ++i) {
+      if (*dtype == DataType::Float(32)) {
+        values.push_back(static_cast<const float*>(data->data)[i]);
+      } else {
+        ICHECK(*dtype == DataType::Int(32));
+        values.push_back(static_cast<const int32_t*>(data->data)[i]);
+      }
+    }
+    return values;
+  }
+  const auto* call = expr.as<CallNode>();
+  ICHECK(call != nullptr) << "Unexpected " << expr;
+  std::string op = Downcast<Op>(call->op)->name;
+  std::vector<double> values = Evaluate(call->args[0], dtype);
+  if (op == "cast") {
+    *dtype = call->attrs.as<CastAttrs>()->dtype;
+  } else if (op == "round") {
+    for (double& value : values) value = std::round(value);
+  } else if (op == "clip") {
+    const auto* attrs = call->attrs.as<ClipAttrs>();
+    for (double& value : values) value = std::min(std::max(value, attrs->a_min), attrs->a_max);
+  } else {
+    DataType rhs_dtype;
+    std::vector<double> rhs = Evaluate(call->args[1], &rhs_dtype);
+    ICHECK(rhs_dtype == *dtype);
+    ICHECK_EQ(rhs.size(), 1U) << "Only scalar right hand sides are evaluated";
+    for (double& value : values) {
+      if (op == "add") {
+        value += rhs[0];
+      } else if (op == "subtract") {
+        value -= rhs[0];
+      } else {
+        ICHECK_EQ(op, "multiply") << "Unexpected op " << op;
+        value *= rhs[0];
+      }
+    }
+  }
+  for (double& value : values) value = ToDataType(value, *dtype);
+  return values;
+}
+
+// Lower a requantize of the data from scale 0.03 to scale 0.07 and zero point 3
+Expr LowerRequantize(const std::vector<int32_t>& data, DataType out_dtype) {
+  Expr call = (*runtime::Registry::Get("relay.qnn.op._make.requantize"))(
+      MakeConstant(DataType::Int(32), data), MakeScalar(DataType::Float(32), 0.03f),
+      MakeScalar(DataType::Int(32), 0), MakeScalar(DataType::Float(32), 0.07f),
+      MakeScalar(DataType::Int(32), 3), -1, String("UPWARD"), out_dtype);
+  const auto* node = call.as<CallNode>();
+  Array<Type> types;
+  types.push_back(TensorType({static_cast<int64_t>(data.size())}, DataType::Int(32)));
+  types.push_back(TensorType({}, DataType::Float(32)));
+  types.push_back(TensorType({}, DataType::Int(32)));
+  types.push_back(TensorType({}, DataType::Float(32)));
+  types.push_back(TensorType({}, DataType::Int(32)));
+  types.push_back(TensorType({static_cast<int64_t>(data.size())}, out_dtype));
+  auto fcanonicalize = Op::GetAttrMap<FTVMLegalize>("FTVMQnnCanonicalize");
+  return fcanonicalize[Downcast<Op>(node->op)](node->attrs, node->args, types);
+}
+
+bool UsesRound(const Expr& expr) {
+  bool found = false;
+  PostOrderVisit(expr, [&found](const Expr& e) {
+    if (const auto* call = e.as<CallNode>()) found |= call->op == Op::Get("round");
+  });
+  return found;
+}
+
+}  // namespace
+
+TEST(QnnRequantize, FloatLoweringIsOptIn) {
+  With<Target> target_scope(Target("opencl -device=adreno"));
+  EXPECT_FALSE(UsesRound(LowerRequantize({1, 2, 3}, DataType::Int(8))));
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("relay.qnn.texture_float_requantize", Bool(true));
+  With<transform::PassContext> ctx_scope(pass_ctx);
+  EXPECT_TRUE(UsesRound(LowerRequantize({1, 2, 3}, DataType::Int(8))));
+}
+
+TEST(QnnRequantize, FloatLoweringNumerics) {
+  // The multiplier 3/7 makes no ties, the float lowering is then exact for accumulators far
+  // beyond the range of convolutions over 8 bit data.
+  std::vector<int32_t> data;
+  for (int32_t q = -100000; q <= 100000; q += 13) data.push_back(q);
+  With<Target> target_scope(Target("opencl -device=adreno"));
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("relay.qnn.texture_float_requantize", Bool(true));
+  With<transform::PassContext> ctx_scope(pass_ctx);
+  for (DataType out_dtype : {DataType::Int(32), DataType::Int(8)}) {
+    DataType dtype;
+    std::vector<double> result = Evaluate(LowerRequantize(data, out_dtype), &dtype);
+    ASSERT_EQ(dtype, out_dtype);
+    ASSERT_EQ(result.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      double expected = std::round(data[i] * 3.0 / 7.0) + 3;
+      if (out_dtype == DataType::Int(8)) expected = std::min(std::max(expected, -128.0), 127.0);
+      ASSERT_EQ(result[i], expected) << "for " << data[i];
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/registry.h>
+
+#include <string>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+// An NHWC conv2d of `weight`, a HWIO kernel of 32 output channels
+Expr Conv2D(const Expr& data, const Var& weight, int kernel, int stride) {
+  return GetFunc("relay.op.nn._make.conv2d")(
+      data, weight, Array<IndexExpr>{stride, stride}, Array<IndexExpr>{0, 0, 0, 0},
+      Array<IndexExpr>{1, 1}, 1, IndexExpr(32), Array<IndexExpr>{kernel, kernel}, String("NHWC"),
+      String("HWIO"), String(""), DataType::Void());
+}
+
+Var Weight(const std::string& name, int kernel) {
+  return Var(name, TensorType({kernel, kernel, 16, 32}, DataType::Float(32)));
+}
+
+IRModule InferType(const Expr& body) {
+  IRModule mod = IRModule::FromExpr(Function(FreeVars(body), body, Type(nullptr), {}));
+  return transform::InferType()(mod);
+}
+
+// Convert the conv2d of "w1" with 8 non-zero 4x1 blocks
+Function ToSparse(const Expr& body) {
+  transform::Pass pass = GetFunc("relay._transform.Conv2dToSparse")(
+      Array<ObjectRef>{String("w1")}, Array<Array<PrimExpr>>{Array<PrimExpr>{8, 4, 1, 8, 9}});
+  IRModule mod = transform::InferType()(pass(InferType(body)));
+  return Downcast<Function>(mod->Lookup("main"));
+}
+
+int CountCalls(const Function& f, const std::string& name) {
+  const Op& op = Op::Get(name);
+  int count = 0;
+  PostOrderVisit(f->body, [&count, &op](const Expr& e) {
+    if (const auto* call = e.as<CallNode>()) count += call->op == op;
+  });
+  return count;
+}
+
+Var Input() { return Var("x", TensorType({1, 8, 8, 16}, DataType::Float(32))); }
+
+}  // namespace
+
+TEST(Conv2dToSparse, SearchWeights) {
+  Var x = Input();
+  Expr body = Tuple({Conv2D(x, Weight("w1", 1), 1, 1), Conv2D(x, Weight("w3", 3), 3, 1),
+                     Conv2D(x, Weight("s1", 1), 1, 2)});
+  Expr typed = Downcast<Function>(InferType(body)->Lookup("main"))->body;
+  Array<String> names = GetFunc("relay.analysis.search_conv2d_op_weight")(typed);
+  ASSERT_EQ(names.size(), 1U);
+  EXPECT_EQ(names[0], "w1");
+}
+
+TEST(Conv2dToSparse, Convert) {
+  Function f = ToSparse(Conv2D(Input(), Weight("w1", 1), 1, 1));
+  EXPECT_EQ(CountCalls(f, "nn.conv2d"), 0);
+  EXPECT_EQ(CountCalls(f, "nn.sparse_dense"), 1);
+  EXPECT_TRUE(StructuralEqual()(f->ret_type, TensorType({1, 8, 8, 32}, DataType::Float(32))));
+  // The dense weight is replaced by its BSR parts
+  ASSERT_EQ(f->params.size(), 4U);
+  EXPECT_EQ(f->params[1]->name_hint(), "w1.data");
+  EXPECT_EQ(f->params[2]->name_hint(), "w1.indices");
+  EXPECT_EQ(f->params[3]->name_hint(), "w1.indptr");
+}
+
+TEST(Conv2dToSparse, KeepOtherConvolutions) {
+  // Strided, or not a 1x1 kernel
+  Function f = ToSparse(Conv2D(Input(), Weight("w1", 1), 1, 2));
+  EXPECT_EQ(CountCalls(f, "nn.sparse_dense"), 0);
+  f = ToSparse(Conv2D(Input(), Weight("w1", 3), 3, 1));
+  EXPECT_EQ(CountCalls(f, "nn.sparse_dense"), 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
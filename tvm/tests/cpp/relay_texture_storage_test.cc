@@ -0,0 +1,255 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace {
+
+const runtime::PackedFunc& GetFunc(const std::string& name) {
+  const runtime::PackedFunc* f = runtime::Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+// A nearest resize of an NCHW4c tensor to 16x16
+Expr Resize(const Expr& data) {
+  return GetFunc("relay.op.image._make.resize")(data, Array<PrimExpr>{16, 16}, String("NCHW4c"),
+                                                String("nearest_neighbor"),
+                                                String("asymmetric"), DataType());
+}
+
+// A 1x1 NCHW4c convolution with `channels` output channels
+Expr Conv2D(const Expr& data, const Expr& weight, int channels = 4) {
+  return GetFunc("relay.op.nn._make.conv2d")(
+      data, weight, Array<PrimExpr>{1, 1}, Array<PrimExpr>{0, 0}, Array<PrimExpr>{1, 1}, 1,
+      PrimExpr(channels), Array<PrimExpr>{1, 1}, String("NCHW4c"), String("OIHW4o"), String(""),
+      DataType());
+}
+
+Expr MaxPool2D(const Expr& data) {
+  return GetFunc("relay.op.nn._make.max_pool2d")(data, Array<PrimExpr>{1, 1},
+                                                 Array<PrimExpr>{1, 1}, Array<PrimExpr>{0, 0},
+                                                 String("NCHW4c"), false);
+}
+
+const Target& Adreno() {
+  static Target target("opencl -device=adreno");
+  return target;
+}
+
+/*!
+ * \brief Whether the output of a primitive function is stored in a texture.
+ * \param make_body The body of the primitive function of its parameters.
+ * \param params The parameters.
+ */
+bool HasTextureOutput(const std::function<Expr(const Array<Var>&)>& make_body,
+                      const Array<Var>& params) {
+  Function primitive(params, make_body(params), Type(), {});
+  primitive = WithAttr(std::move(primitive), attr::kPrimitive, Integer(1));
+  Array<Var> outer;
+  Array<Expr> args;
+  for (const Var& param : params) {
+    outer.push_back(Var(param->name_hint(), param->type_annotation));
+    args.push_back(outer.back());
+  }
+  IRModule mod = transform::InferType()(IRModule::FromExpr(Function(outer, Call(primitive, args),
+                                                                   Type(), {})));
+  Function main = Downcast<Function>(mod->Lookup("main"));
+  Map<Expr, Array<String>> storage = GetFunc("relay.backend.opencl.adreno._CollectStorageInfo")(
+      main, Map<Expr, Integer>(), Map<Integer, Target>({{Integer(kDLOpenCL), Adreno()}}));
+  return storage.count(main->body) != 0;
+}
+
+// A call of a primitive function of `make_body` with the arguments `args`
+Expr Primitive(const std::function<Expr(const Array<Var>&)>& make_body, const Array<Expr>& args) {
+  Array<Var> params;
+  for (const Expr& arg : args) {
+    params.push_back(Var("p" + std::to_string(params.size()), Type()));
+  }
+  Function primitive(params, make_body(params), Type(), {});
+  return Call(WithAttr(std::move(primitive), attr::kPrimitive, Integer(1)), args);
+}
+
+/*!
+ * \brief Plan the memory of the concatenation of two 1x1 convolutions read by a third one.
+ * \param target The OpenCL target.
+ * \param concat The call of the concatenation in the planned function.
+ * \return The plan of the planned function.
+ */
+Map<Expr, runtime::ADT> PlanConcat(const Target& target, Call* concat) {
+  Var x("x", TensorType({1, 1, 8, 8, 4}, DataType::Float(32)));
+  Var w1("w1", TensorType({1, 4, 1, 1, 4}, DataType::Float(32)));
+  Var w2("w2", TensorType({1, 4, 1, 1, 4}, DataType::Float(32)));
+  Var w3("w3", TensorType({1, 8, 1, 1, 4}, DataType::Float(32)));
+  auto conv = [](const Array<Var>& p) { return Conv2D(p[0], p[1]); };
+  Expr a = Primitive(conv, {x, w1});
+  Expr b = Primitive(conv, {x, w2});
+  Expr cat = Primitive(
+      [](const Array<Var>& p) {
+        return GetFunc("relay.op._make.concatenate")(Tuple({p[0], p[1]}), 1);
+      },
+      {a, b});
+  Expr body = Primitive(conv, {cat, w3});
+  IRModule mod = transform::InferType()(
+      IRModule::FromExpr(Function({x, w1, w2, w3}, body, Type(), {})));
+  Function main = Downcast<Function>(mod->Lookup("main"));
+  *concat = Downcast<Call>(Downcast<Call>(main->body)->args[0]);
+  return GetFunc("relay.backend.GraphPlanMemory")(
+      main, Map<Integer, Target>({{Integer(kDLOpenCL), target}}));
+}
+
+int64_t StorageId(const Map<Expr, runtime::ADT>& plan, const Expr& expr) {
+  return Downcast<Array<Integer>>(plan[expr][0])[0]->value;
+}
+
+// The planned extent of the storage `id` in the report of GraphPlanMemoryStats, as (width, height)
+std::pair<int64_t, int64_t> StorageExtent(const Map<String, ObjectRef>& stats, int64_t id) {
+  for (const ObjectRef& item : Downcast<Array<ObjectRef>>(stats["storage"])) {
+    auto info = Downcast<Map<String, ObjectRef>>(item);
+    if (Downcast<Integer>(info["storage_id"])->value != id) continue;
+    return {Downcast<Integer>(info["width"])->value, Downcast<Integer>(info["height"])->value};
+  }
+  return {0, 0};
+}
+
+// The storage scope of `expr` annotated in `main` for `target`, empty if it is not annotated
+std::string StorageScope(const Function& main, const Target& target, const Expr& expr) {
+  Map<Expr, Array<String>> storage = GetFunc("relay.backend.opencl.adreno._CollectStorageInfo")(
+      main, Map<Expr, Integer>(), Map<Integer, Target>({{Integer(kDLOpenCL), target}}));
+  return storage.count(expr) ? std::string(storage[expr][0]) : std::string();
+}
+
+}  // namespace
+
+TEST(TextureStorage, ResizeFusedIntoConv) {
+  Var x("x", TensorType({1, 1, 8, 8, 4}, DataType::Float(32)));
+  Var w("w", TensorType({1, 4, 1, 1, 4}, DataType::Float(32)));
+  EXPECT_TRUE(HasTextureOutput([](const Array<Var>& p) { return Conv2D(Resize(p[0]), p[1]); },
+                               {x, w}));
+}
+
+TEST(TextureStorage, ResizeNotFusedIntoConv) {
+  // The resize is computed by the kernel of the pool, which has no texture input stage
+  Var x("x", TensorType({1, 1, 8, 8, 4}, DataType::Float(32)));
+  EXPECT_FALSE(HasTextureOutput([](const Array<Var>& p) { return MaxPool2D(Resize(p[0])); },
+                                {x}));
+}
+
+TEST(TextureStorage, ProducerFusionPolicyIsOptIn) {
+  Var x("x", TensorType({1, 1, 8, 8, 4}, DataType::Float(32)));
+  Var w("w", TensorType({1, 4, 1, 1, 4}, DataType::Float(32)));
+  Expr resize = Resize(x);
+  Expr conv = Conv2D(resize, w);
+  const auto& policy = GetFunc("relay.backend.opencl.adreno._ProducerFusionPolicy");
+  With<Target> target_scope(Adreno());
+  EXPECT_FALSE(static_cast<bool>(policy(resize, conv)));
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("relay.backend.texture_fuse_conv_input", Bool(true));
+  With<transform::PassContext> ctx_scope(pass_ctx);
+  EXPECT_TRUE(static_cast<bool>(policy(resize, conv)));
+  // Only the data input of a convolution is fused
+  EXPECT_FALSE(static_cast<bool>(policy(resize, MaxPool2D(resize))));
+}
+
+TEST(TextureStorage, ConcatInputsWriteRows) {
+  Call concat;
+  Map<Expr, runtime::ADT> plan =
+      PlanConcat(Target("opencl -device=adreno -texture_concat=1"), &concat);
+  ASSERT_EQ(plan[concat].size(), 4U);
+  EXPECT_EQ(Downcast<Array<String>>(plan[concat][2])[0], "texture");
+  // Both convolutions write 8 rows, one texel block of channels of 8 rows each
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(StorageId(plan, concat->args[i]), StorageId(plan, concat));
+    EXPECT_EQ(Downcast<Array<Integer>>(plan[concat->args[i]][3])[0]->value, 8 * i);
+  }
+  EXPECT_EQ(Downcast<Array<Integer>>(plan[concat][3])[0]->value, -1);
+}
+
+TEST(TextureStorage, ConcatIsOptIn) {
+  Call concat;
+  Map<Expr, runtime::ADT> plan = PlanConcat(Adreno(), &concat);
+  ASSERT_EQ(plan[concat].size(), 3U);
+  EXPECT_NE(StorageId(plan, concat->args[0]), StorageId(plan, concat));
+  EXPECT_NE(StorageId(plan, concat->args[1]), StorageId(plan, concat));
+}
+
+TEST(TextureStorage, FallbackScopeFollowsConsumers) {
+  // With images of at most 8 texels a side, [2, 1, 8, 1, 4] exceeds the 16 rows of the default
+  // texture but fits the NHWC and weight conventions, which the NCHW4c convolution cannot read
+  Var x("x", TensorType({2, 1, 8, 1, 4}, DataType::Float(32)));
+  Constant w(runtime::NDArray::Empty({1, 4, 1, 1, 4}, DataType::Float(32), {kDLCPU, 0}));
+  Expr body = Primitive([](const Array<Var>& p) { return Conv2D(p[0], p[1]); }, {x, w});
+  IRModule mod = transform::InferType()(IRModule::FromExpr(Function({x}, body, Type(), {})));
+  Function main = Downcast<Function>(mod->Lookup("main"));
+  Target target("opencl -device=adreno -texture_spatial_limit=8");
+  EXPECT_EQ(StorageScope(main, target, main->params[0]), "texture:array");
+  EXPECT_EQ(StorageScope(main, target, main->body), "texture:array");
+  // Only constants are held as weights
+  EXPECT_EQ(StorageScope(main, target, Downcast<Call>(main->body)->args[1]), "texture:weight");
+}
+
+TEST(TextureStorage, TexturesReusedByLiveness) {
+  Var x("x", TensorType({1, 1, 8, 8, 4}, DataType::Float(32)));
+  Var w1("w1", TensorType({1, 4, 1, 1, 4}, DataType::Float(32)));
+  Var w2("w2", TensorType({2, 4, 1, 1, 4}, DataType::Float(32)));
+  Var w3("w3", TensorType({1, 8, 1, 1, 4}, DataType::Float(32)));
+  auto conv = [](const Array<Var>& p) { return Conv2D(p[0], p[1]); };
+  Expr a = Primitive(conv, {x, w1});
+  Expr b = Primitive(conv, {a, w1});
+  Expr c = Primitive([](const Array<Var>& p) { return Conv2D(p[0], p[1], 8); }, {b, w2});
+  Expr d = Primitive(conv, {c, w3});
+  IRModule mod = transform::InferType()(
+      IRModule::FromExpr(Function({x, w1, w2, w3}, d, Type(), {})));
+  Function main = Downcast<Function>(mod->Lookup("main"));
+  Map<Integer, Target> targets({{Integer(kDLOpenCL), Adreno()}});
+  Map<Expr, runtime::ADT> plan = GetFunc("relay.backend.GraphPlanMemory")(main, targets);
+  Call d_call = Downcast<Call>(main->body);
+  Call c_call = Downcast<Call>(d_call->args[0]);
+  Call b_call = Downcast<Call>(c_call->args[0]);
+  Call a_call = Downcast<Call>(b_call->args[0]);
+  EXPECT_EQ(Downcast<Array<String>>(plan[a_call][2])[0], "texture");
+  // The 16 rows of the wider output of c grow the 8 rows of the dead output of a, and the
+  // output of the function takes over the texture of b
+  EXPECT_EQ(StorageId(plan, c_call), StorageId(plan, a_call));
+  EXPECT_EQ(StorageId(plan, d_call), StorageId(plan, b_call));
+  EXPECT_NE(StorageId(plan, a_call), StorageId(plan, b_call));
+  Map<String, ObjectRef> stats = GetFunc("relay.backend.GraphPlanMemoryStats")(main, targets);
+  EXPECT_EQ(StorageExtent(stats, StorageId(plan, a_call)), std::make_pair<int64_t, int64_t>(8, 16));
+  EXPECT_EQ(StorageExtent(stats, StorageId(plan, b_call)), std::make_pair<int64_t, int64_t>(8, 8));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -33,6 +33,8 @@
 #include <tvm/topi/broadcast.h>
 #include <tvm/topi/generic/injective.h>
 
+#include <atomic>
+
 using namespace tvm;
 
 TVM_REGISTER_GLOBAL("test.seq.strategy")
@@ -121,6 +123,31 @@ TEST(Relay, Sequential) {
   ICHECK(tvm::StructuralEqual()(f, expected));
 }
 
+TEST(Relay, ParallelFunctionPass) {
+  auto tensor_type = relay::TensorType({1, 2, 3}, DataType::Float(32));
+  IRModule mod;
+  for (const char* name : {"f0", "f1", "f2", "f3"}) {
+    auto x = relay::Var("x", tensor_type);
+    mod->Add(GlobalVar(name), relay::Function({x}, x, relay::Type(), {}));
+  }
+  auto pass_ctx = relay::transform::PassContext::Create();
+  pass_ctx->config.Set("relay.FunctionPass.num_threads", Integer(2));
+  std::atomic<int> num_calls{0};
+  std::atomic<int> num_outside_ctx{0};
+  auto pass_func = [&](relay::Function f, IRModule m, relay::transform::PassContext ctx) {
+    ++num_calls;
+    if (!relay::transform::PassContext::Current().same_as(ctx)) ++num_outside_ctx;
+    return f;
+  };
+  auto pass = relay::transform::CreateFunctionPass(pass_func, 0, "TestParallel", {});
+  {
+    tvm::With<relay::transform::PassContext> ctx_scope(pass_ctx);
+    mod = pass(mod);
+  }
+  EXPECT_EQ(num_calls, 4);
+  EXPECT_EQ(num_outside_ctx, 0);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,130 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../src/relay/op/memory/memory.h"
+#include "../../src/relay/op/vm/vm.h"
+#include "../../src/relay/transforms/pattern_utils.h"
+
+using namespace tvm;
+using namespace tvm::relay;
+
+namespace tvm {
+namespace relay {
+namespace transform {
+Pass StaticMemoryPlan();
+}  // namespace transform
+}  // namespace relay
+}  // namespace tvm
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+
+Expr Int64(int64_t value) { return MakeConstantScalar(DataType::Int(64), value); }
+
+// A chain of four kernels on 16 floats, each writing a tensor of its own 64 byte storage as
+// ManifestAlloc leaves them. The last tensor is returned, the others are only used by the next
+// kernel, so the first and third storage may share memory.
+Function KernelChain() {
+  Var a("a", TensorType({16}, DataType::Float(32)));
+  Function kernel({a}, a, TensorType({16}, DataType::Float(32)), {});
+  kernel = WithAttr(std::move(kernel), attr::kPrimitive, tvm::Integer(1));
+  Var x("x", TensorType({16}, DataType::Float(32)));
+  Expr shape = MakeConstantTensor(DataType::Int(64), {1}, std::vector<int64_t>{16});
+
+  std::vector<std::pair<Var, Expr>> bindings;
+  Expr input = x;
+  for (int i = 0; i < 4; ++i) {
+    Var storage("s" + std::to_string(i), Type(nullptr));
+    Var tensor("t" + std::to_string(i), Type(nullptr));
+    bindings.emplace_back(storage, AllocStorage(Int64(64), Int64(64), kCPU, DataType::Float(32)));
+    bindings.emplace_back(tensor,
+                          AllocTensor(storage, Int64(0), shape, DataType::Float(32), {16}));
+    bindings.emplace_back(Var("r" + std::to_string(i), Type(nullptr)),
+                          InvokeTVMOp(kernel, Tuple({input}), Tuple({tensor})));
+    input = tensor;
+  }
+  Expr body = input;
+  for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+    body = Let(it->first, it->second, body);
+  }
+  return Function({x}, body, Type(nullptr), {});
+}
+
+// The sizes of the storage allocations and the offsets of the tensor allocations
+void CollectAllocations(const Expr& expr, std::vector<int64_t>* sizes,
+                        std::vector<int64_t>* offsets) {
+  static const Op& alloc_storage_op = Op::Get("memory.alloc_storage");
+  static const Op& alloc_tensor_op = Op::Get("memory.alloc_tensor");
+  auto value = [](const Expr& e) {
+    return static_cast<const int64_t*>(e.as<ConstantNode>()->data->data)[0];
+  };
+  PostOrderVisit(expr, [&](const Expr& e) {
+    const auto* call = e.as<CallNode>();
+    if (call == nullptr) return;
+    if (call->op == alloc_storage_op) sizes->push_back(value(call->args[0]));
+    if (call->op == alloc_tensor_op) offsets->push_back(value(call->args[1]));
+  });
+}
+
+Function Plan(bool enabled) {
+  IRModule mod = IRModule::FromExpr(KernelChain());
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("relay.vm.static_memory_plan", Bool(enabled));
+  tvm::With<transform::PassContext> scope(pass_ctx);
+  mod = transform::StaticMemoryPlan()(mod);
+  return Downcast<Function>(mod->Lookup("main"));
+}
+
+}  // namespace
+
+TEST(StaticMemoryPlan, OffByDefault) {
+  std::vector<int64_t> sizes, offsets;
+  CollectAllocations(Plan(false)->body, &sizes, &offsets);
+  EXPECT_EQ(sizes, std::vector<int64_t>({64, 64, 64, 64}));
+  EXPECT_EQ(offsets, std::vector<int64_t>({0, 0, 0, 0}));
+}
+
+TEST(StaticMemoryPlan, CoalesceIntoArena) {
+  std::vector<int64_t> sizes, offsets;
+  CollectAllocations(Plan(true)->body, &sizes, &offsets);
+  // The returned tensor keeps its storage, the first and third tensors share a block
+  EXPECT_EQ(sizes, std::vector<int64_t>({128, 64}));
+  ASSERT_EQ(offsets.size(), 4U);
+  EXPECT_EQ(offsets[0], offsets[2]);
+  EXPECT_NE(offsets[0], offsets[1]);
+  EXPECT_EQ(offsets[3], 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
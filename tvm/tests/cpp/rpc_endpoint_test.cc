@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/runtime/rpc/rpc_endpoint.h"
+#include "../../src/support/socket.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+const PackedFunc& GetFunc(const std::string& name) {
+  const PackedFunc* f = Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+/*!
+ * \brief Serve the next connection to a local port with the RPC server loop of this process.
+ * \return The port.
+ */
+int ServeOnce() {
+  tvm::support::Socket::Startup();
+  auto listener = std::make_shared<tvm::support::TCPSocket>();
+  listener->Create();
+  int port = listener->TryBindHost("127.0.0.1", 9300, 9600);
+  listener->Listen();
+  std::thread([listener]() {
+    tvm::support::TCPSocket sock = listener->Accept();
+    listener->Close();
+    // The handshake of RPCConnectSocket, without a key on this side
+    int code, keylen;
+    ICHECK_EQ(sock.RecvAll(&code, sizeof(code)), sizeof(code));
+    ICHECK_EQ(sock.RecvAll(&keylen, sizeof(keylen)), sizeof(keylen));
+    std::string key(keylen, '\0');
+    if (keylen != 0) ICHECK_EQ(sock.RecvAll(&key[0], keylen), keylen);
+    code = kRPCMagic;
+    keylen = 0;
+    ICHECK_EQ(sock.SendAll(&code, sizeof(code)), sizeof(code));
+    ICHECK_EQ(sock.SendAll(&keylen, sizeof(keylen)), sizeof(keylen));
+    GetFunc("rpc.ServerLoop")(static_cast<int>(sock.sockfd));
+  }).detach();
+  return port;
+}
+
+// The CPU of the remote of `sess`
+TVMContext RemoteCPU(const Module& sess) {
+  int index = GetFunc("rpc.SessTableIndex")(sess);
+  return AddRPCSessionMask({kDLCPU, 0}, index);
+}
+
+std::vector<float> Pattern(size_t size, float offset) {
+  std::vector<float> values(size);
+  for (size_t i = 0; i < size; ++i) values[i] = static_cast<float>(i % 1013) + offset;
+  return values;
+}
+
+// Upload `values` to `remote` and download them back
+std::vector<float> RoundTrip(const std::vector<float>& values, NDArray remote) {
+  remote.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  std::vector<float> back(values.size());
+  remote.CopyToBytes(back.data(), back.size() * sizeof(float));
+  return back;
+}
+
+// Wait for `expected` callers of the same round, returns the number that arrived in time
+int Rendezvous(int round, int expected) {
+  static std::mutex mu;
+  static std::condition_variable cv;
+  static std::unordered_map<int, int> arrivals;
+  std::unique_lock<std::mutex> lock(mu);
+  ++arrivals[round];
+  cv.notify_all();
+  cv.wait_for(lock, std::chrono::seconds(10),
+              [round, expected]() { return arrivals[round] >= expected; });
+  return arrivals[round];
+}
+
+TVM_REGISTER_GLOBAL("test.rpc.Rendezvous").set_body_typed(Rendezvous);
+
+}  // namespace
+
+TEST(RPCEndpoint, ChunkedCopies) {
+  Module sess = GetFunc("rpc.Connect")("127.0.0.1", ServeOnce(), "");
+  // Past the 4 MB chunks, and not a multiple of them
+  for (size_t size : {size_t(1000), size_t(3) << 20, (size_t(5) << 20) + 7}) {
+    std::vector<float> values = Pattern(size, 0.5f);
+    NDArray remote = NDArray::Empty({static_cast<int64_t>(size)}, DLDataType{kDLFloat, 32, 1},
+                                    RemoteCPU(sess));
+    EXPECT_EQ(RoundTrip(values, remote), values);
+    // The server is in this process, its memory shows what was written
+    EXPECT_EQ(std::memcmp(remote->data, values.data(), size * sizeof(float)), 0);
+  }
+}
+
+TEST(RPCEndpoint, SkipUnchangedUploads) {
+  setenv("TVM_RPC_SKIP_UNCHANGED_UPLOADS", "1", 1);
+  Module sess = GetFunc("rpc.Connect")("127.0.0.1", ServeOnce(), "");
+  unsetenv("TVM_RPC_SKIP_UNCHANGED_UPLOADS");
+  size_t size = size_t(1) << 20;
+  NDArray remote = NDArray::Empty({static_cast<int64_t>(size)}, DLDataType{kDLFloat, 32, 1},
+                                  RemoteCPU(sess));
+  std::vector<float> values = Pattern(size, 0.0f);
+  EXPECT_EQ(RoundTrip(values, remote), values);
+  EXPECT_EQ(RoundTrip(values, remote), values);
+  // A change of a single element is uploaded
+  values[size / 2] += 1.0f;
+  EXPECT_EQ(RoundTrip(values, remote), values);
+  // As is a change made on the remote side
+  static_cast<float*>(remote->data)[0] = -1.0f;
+  EXPECT_EQ(RoundTrip(values, remote), values);
+}
+
+TEST(RPCEndpoint, MultiplexedSessionsRunConcurrently) {
+  Array<Module> sessions = GetFunc("rpc.ConnectMultiplexed")("127.0.0.1", ServeOnce(), "", 2);
+  ASSERT_EQ(sessions.size(), 2U);
+  // Each call only returns once the other one reached the server
+  std::vector<int> arrived(2);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace_back([&sessions, &arrived, i]() {
+      arrived[i] = sessions[i]->GetFunction("test.rpc.Rendezvous")(0, 2);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(arrived, std::vector<int>({2, 2}));
+}
+
+TEST(RPCEndpoint, MultiplexedCopies) {
+  Array<Module> sessions = GetFunc("rpc.ConnectMultiplexed")("127.0.0.1", ServeOnce(), "", 2);
+  // A copy spanning many frames on one stream, next to small ones on the other
+  std::vector<float> large = Pattern(size_t(3) << 20, 1.0f);
+  std::vector<float> large_back;
+  std::thread copy([&]() {
+    NDArray remote = NDArray::Empty({static_cast<int64_t>(large.size())},
+                                    DLDataType{kDLFloat, 32, 1}, RemoteCPU(sessions[0]));
+    large_back = RoundTrip(large, remote);
+  });
+  NDArray small = NDArray::Empty({64}, DLDataType{kDLFloat, 32, 1}, RemoteCPU(sessions[1]));
+  for (int i = 0; i < 16; ++i) {
+    std::vector<float> values = Pattern(64, static_cast<float>(i));
+    EXPECT_EQ(RoundTrip(values, small), values);
+  }
+  copy.join();
+  EXPECT_EQ(large_back, large);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <tvm/runtime/registry.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// The environment is part of the server application, not of the runtime library
+#include "../../apps/cpp_rpc/rpc_env.cc"
+
+using namespace tvm::runtime;
+
+namespace {
+
+const PackedFunc& GetFunc(const std::string& name) {
+  const PackedFunc* f = Registry::Get(name);
+  ICHECK(f != nullptr) << name << " is not registered";
+  return *f;
+}
+
+// Run the server environment in a fresh directory, with a cache of `cache_mb`
+class RPCEnvCache : public testing::Test {
+ protected:
+  void Init(const char* cache_mb) {
+    char dir[] = "/tmp/rpc_env_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    dir_ = dir;
+    ASSERT_EQ(chdir(dir), 0);
+    setenv("TVM_RPC_CACHE_SIZE_MB", cache_mb, 1);
+    env_.reset(new RPCEnv());
+    unsetenv("TVM_RPC_CACHE_SIZE_MB");
+  }
+
+  void TearDown() override {
+    env_.reset();
+    if (!dir_.empty()) ASSERT_EQ(system(("rm -rf " + dir_).c_str()), 0);
+  }
+
+  void Upload(const std::string& file_name, const std::string& data, const std::string& key) {
+    GetFunc("tvm.rpc.server.upload")(file_name, data, key);
+  }
+
+  bool Lookup(const std::string& key, const std::string& file_name) {
+    return GetFunc("tvm.rpc.server.cache_lookup")(key, file_name);
+  }
+
+  std::string Read(const std::string& file_name) {
+    std::ifstream fs(env_->GetPath(file_name), std::ios::binary);
+    std::ostringstream os;
+    os << fs.rdbuf();
+    return os.str();
+  }
+
+  std::string dir_;
+  std::unique_ptr<RPCEnv> env_;
+};
+
+}  // namespace
+
+TEST_F(RPCEnvCache, HitInLaterSession) {
+  Init("1");
+  std::string data(1000, 'a');
+  Upload("mod.so", data, ContentHash(data));
+  // The cache outlives the files of the session
+  env_->SetSession("next");
+  EXPECT_TRUE(Lookup(ContentHash(data), "copy.so"));
+  EXPECT_EQ(Read("copy.so"), data);
+  EXPECT_FALSE(Lookup(ContentHash(data + "b"), "other.so"));
+}
+
+TEST_F(RPCEnvCache, UntrustedKeys) {
+  Init("1");
+  std::string data(1000, 'a');
+  // A key which is not the hash of the content is not cached
+  Upload("mod.so", data, "0123456789abcdef");
+  EXPECT_FALSE(Lookup("0123456789abcdef", "copy.so"));
+  // Nor is a key leaving the cache directory looked up
+  EXPECT_FALSE(Lookup("../rpc/mod.so", "copy.so"));
+}
+
+TEST_F(RPCEnvCache, EvictLeastRecentlyUsed) {
+  Init("1");
+  std::string a(600 << 10, 'a'), b(600 << 10, 'b');
+  Upload("a.so", a, ContentHash(a));
+  // Mark a as used long ago, the modification times of the files order them
+  struct utimbuf old_time = {1, 1};
+  ASSERT_EQ(utime((dir_ + "/rpc_cache/" + ContentHash(a)).c_str(), &old_time), 0);
+  Upload("b.so", b, ContentHash(b));
+  EXPECT_FALSE(Lookup(ContentHash(a), "a2.so"));
+  EXPECT_TRUE(Lookup(ContentHash(b), "b2.so"));
+}
+
+TEST_F(RPCEnvCache, Disabled) {
+  Init("0");
+  std::string data(1000, 'a');
+  Upload("mod.so", data, ContentHash(data));
+  EXPECT_EQ(Read("mod.so"), data);
+  EXPECT_FALSE(Lookup(ContentHash(data), "copy.so"));
+}
+
+TEST_F(RPCEnvCache, SessionPaths) {
+  Init("0");
+  std::string root = env_->GetPath("mod.so");
+  // The sessions served by one process each write their own files
+  const PackedFunc& upload = GetFunc("tvm.rpc.server.upload");
+  env_->SetSession("s1");
+  upload("mod.so", "first");
+  env_->SetSession("s2");
+  upload("mod.so", "second");
+  EXPECT_EQ(Read("mod.so"), "second");
+  env_->SetSession("s1");
+  EXPECT_EQ(Read("mod.so"), "first");
+  EXPECT_NE(env_->GetPath("mod.so").find("/s1/mod.so"), std::string::npos);
+  env_->SetSession("");
+  EXPECT_EQ(env_->GetPath("mod.so"), root);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/arith/analyzer.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/te/schedule_pass.h>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+IterVar Axis(const Tensor& t, int i) { return t->op.as<ComputeOpNode>()->axis[i]; }
+
+// The constant extent of the bound inferred for the first axis of a stage
+int64_t InferredExtent(const Schedule& s, const Tensor& t) {
+  Map<IterVar, Range> bounds = InferBound(s.normalize());
+  PrimExpr extent = arith::Analyzer().Simplify(bounds[Axis(t, 0)]->extent);
+  const auto* imm = extent.as<IntImmNode>();
+  return imm != nullptr ? imm->value : -1;
+}
+
+// A producer of 64 elements and its consumer, split by 8 and bound to blocks and threads
+struct ThreadedPair {
+  ThreadedPair() {
+    Tensor A = placeholder({64}, DataType::Float(32), "A");
+    C = compute({64}, [&](Var i) { return A[i] + 1.0f; }, "C");
+    B = compute({64}, [&](Var i) { return C[i] * 2.0f; }, "B");
+    s = create_schedule({B->op});
+    s[B].split(Axis(B, 0), 8, &outer, &inner);
+    s[B].bind(outer, thread_axis(Range(nullptr), "blockIdx.x"));
+    s[B].bind(inner, thread_axis(Range(nullptr), "threadIdx.x"));
+  }
+  Tensor B, C;
+  Schedule s;
+  IterVar outer, inner;
+};
+
+}  // namespace
+
+TEST(InferBound, ComputeAtSplitReduction) {
+  Tensor A = placeholder({256}, DataType::Float(32), "A");
+  Tensor C = compute({256}, [&](Var i) { return A[i] * 2.0f; }, "C");
+  IterVar k = reduce_axis(Range(0, 4), "k");
+  Tensor B = compute({64}, [&](Var i) { return sum(C[i * 4 + k->var], {k}); }, "B");
+  Schedule s = create_schedule({B->op});
+  IterVar outer, inner;
+  s[B].split(Axis(B, 0), 8, &outer, &inner);
+  s[C].compute_at(s[B], outer);
+  // 8 outputs of 4 reduced inputs each
+  EXPECT_EQ(InferredExtent(s, C), 32);
+}
+
+TEST(InferBound, SharedRelaxedOverThreads) {
+  ThreadedPair pair;
+  pair.s[pair.C].set_scope("shared");
+  pair.s[pair.C].compute_at(pair.s[pair.B], pair.outer);
+  EXPECT_EQ(InferredExtent(pair.s, pair.C), 8);
+}
+
+TEST(InferBound, LocalPerThread) {
+  ThreadedPair pair;
+  pair.s[pair.C].set_scope("local");
+  pair.s[pair.C].compute_at(pair.s[pair.B], pair.inner);
+  EXPECT_EQ(InferredExtent(pair.s, pair.C), 1);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/memory_io.h>
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/ir/transform.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/function.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::runtime;
+
+namespace {
+
+// The TensorRT codegen and runtime module are only built with USE_TENSORRT_CODEGEN, the
+// TensorRT library is not needed to serialize the module
+bool HasTensorRTModule() {
+  return Registry::Get("runtime.tensorrt_runtime_create") != nullptr;
+}
+
+const uint64_t kEnginesMagic = 0x54525445ED6E1E5EULL;
+
+const char* kReluGraph = R"({
+  "nodes": [
+    {"op": "input", "name": "x", "attrs": {"dtype": [["float32"]], "shape": [[[1, 4]]]}},
+    {"op": "kernel", "name": "nn.relu", "inputs": [[0, 0, 0]],
+     "attrs": {"num_inputs": "1", "num_outputs": "1",
+               "dtype": [["float32"]], "shape": [[[1, 4]]]}}
+  ],
+  "arg_nodes": [0],
+  "heads": [[1, 0, 0]],
+  "node_row_ptr": [0, 1, 2]
+})";
+
+// The JSON module of the subgraph as the binaries saved before the engine table end
+void WriteJSONModule(dmlc::Stream* stream) {
+  stream->Write(std::string("tensorrt_0"));
+  stream->Write(std::string(kReluGraph));
+  stream->Write(std::vector<std::string>());
+}
+
+Module LoadBinary(dmlc::Stream* stream) {
+  return (*Registry::Get("runtime.module.loadbinary_tensorrt"))(static_cast<void*>(stream));
+}
+
+std::string SaveBinary(const Module& mod) {
+  std::string data;
+  dmlc::MemoryStringStream stream(&data);
+  mod->SaveToBinary(&stream);
+  return data;
+}
+
+// The JSON graph the TensorRT codegen serializes relu(x) into, without whitespace
+std::string CompileRelu() {
+  relay::Var x("x", relay::TensorType({1, 4}, DataType::Float(32)));
+  relay::Function func({x}, relay::Call(Op::Get("nn.relu"), {x}), Type(), {});
+  IRModule mod = relay::transform::InferType()(IRModule::FromExpr(func));
+  func = Downcast<relay::Function>(mod->Lookup("main"));
+  func = WithAttr(std::move(func), relay::attr::kCompiler, String("tensorrt"));
+  func = WithAttr(std::move(func), tvm::attr::kGlobalSymbol, String("tensorrt_0"));
+  Module lib = (*Registry::Get("relay.ext.tensorrt"))(func);
+  std::string json = lib->GetSource("json");
+  json.erase(std::remove_if(json.begin(), json.end(), ::isspace), json.end());
+  return json;
+}
+
+}  // namespace
+
+TEST(TensorRTCodegen, BatchProfilesAttribute) {
+  if (!HasTensorRTModule() || Registry::Get("relay.ext.tensorrt") == nullptr) return;
+  // The bounds are passed in the order given, the runtime sorts them
+  Map<String, ObjectRef> options{{"batch_profiles", Array<Integer>{32, 8}}};
+  transform::PassContext ctx = (*Registry::Get("transform.PassContext"))(
+      3, Array<String>(), Array<String>(), nullptr,
+      Map<String, ObjectRef>{{"relay.ext.tensorrt.options", options}});
+  {
+    With<transform::PassContext> scope(ctx);
+    EXPECT_NE(CompileRelu().find(R"("batch_profiles":[["32","8"]])"), std::string::npos);
+  }
+  // Without profiles every batch size gets an engine of its own
+  EXPECT_NE(CompileRelu().find(R"("batch_profiles":[[]])"), std::string::npos);
+}
+
+TEST(TensorRTRuntime, EnginesSavedWithModule) {
+  if (!HasTensorRTModule()) return;
+  std::string data;
+  dmlc::MemoryStringStream stream(&data);
+  WriteJSONModule(&stream);
+  stream.Write(kEnginesMagic);
+  stream.Write(static_cast<uint64_t>(1));
+  stream.Write(8);
+  stream.Write(std::string("plan"));
+  stream.Write(std::vector<std::string>{"x"});
+  stream.Write(std::vector<std::string>{"out"});
+  // The engines are kept until Init, a module saved again carries them along
+  stream.Seek(0);
+  Module mod = LoadBinary(&stream);
+  EXPECT_EQ(SaveBinary(mod), data);
+
+  // A module without built engines saves an empty table
+  Module created = (*Registry::Get("runtime.tensorrt_runtime_create"))(
+      String("tensorrt_0"), String(kReluGraph), Array<String>());
+  std::string empty;
+  dmlc::MemoryStringStream expected(&empty);
+  WriteJSONModule(&expected);
+  expected.Write(kEnginesMagic);
+  expected.Write(static_cast<uint64_t>(0));
+  EXPECT_EQ(SaveBinary(created), empty);
+}
+
+TEST(TensorRTRuntime, LoadBinaryWithoutEngines) {
+  if (!HasTensorRTModule()) return;
+  // A binary saved before the engine table, followed by the next module of the library
+  std::string data;
+  dmlc::MemoryStringStream stream(&data);
+  WriteJSONModule(&stream);
+  stream.Write(std::string("next"));
+  stream.Seek(0);
+  Module mod = LoadBinary(&stream);
+  EXPECT_EQ(mod->GetSource("json"), kReluGraph);
+  std::string next;
+  ASSERT_TRUE(stream.Read(&next));
+  EXPECT_EQ(next, "next");
+
+  // A binary ending with the JSON module
+  std::string last;
+  dmlc::MemoryStringStream last_stream(&last);
+  WriteJSONModule(&last_stream);
+  last_stream.Seek(0);
+  EXPECT_EQ(LoadBinary(&last_stream)->GetSource("json"), kReluGraph);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,212 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "../../src/runtime/texture.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+/*! \brief A device API serving textures from the host heap, counting the live ones. */
+class HostTextureAPI final : public DeviceAPI {
+ public:
+  void SetDevice(TVMContext ctx) final {}
+  void GetAttr(TVMContext ctx, DeviceAttrKind kind, TVMRetValue* rv) final {}
+  void* AllocDataSpace(TVMContext ctx, size_t nbytes, size_t alignment,
+                       DLDataType type_hint) final {
+    ++num_live;
+    return std::malloc(nbytes);
+  }
+  void* AllocDataSpace(TVMContext ctx, int ndim, const int64_t* shape, DLDataType dtype,
+                       Optional<String> mem_scope) final {
+    size_t nbytes = (dtype.bits * dtype.lanes + 7) / 8;
+    for (int i = 0; i < ndim; ++i) nbytes *= static_cast<size_t>(shape[i]);
+    ++num_live;
+    return std::malloc(nbytes);
+  }
+  void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    --num_live;
+    std::free(ptr);
+  }
+  void StreamSync(TVMContext ctx, TVMStreamHandle stream) final {}
+
+  int num_live{0};
+
+ protected:
+  void CopyDataFromTo(const void* from, size_t from_offset, void* to, size_t to_offset,
+                      size_t num_bytes, TVMContext ctx_from, TVMContext ctx_to,
+                      DLDataType type_hint, TVMStreamHandle stream) final {}
+};
+
+const TVMContext kCtx = {kDLCPU, 0};
+const DLDataType kHalf = {kDLFloat, 16, 1};
+const DLDataType kFloat = {kDLFloat, 32, 1};
+
+}  // namespace
+
+TEST(TextureWorkspacePlan, ReplayFirstRun) {
+  HostTextureAPI api;
+  TextureWorkspacePlan plan(&api);
+  plan.BeginRun();
+  void* a = plan.AllocTexture(kCtx, 8, 8, 4, kHalf);
+  EXPECT_TRUE(plan.FreeTexture(a));
+  // Served by the texture freed earlier in the run
+  void* b = plan.AllocTexture(kCtx, 4, 4, 4, kHalf);
+  EXPECT_EQ(a, b);
+  EXPECT_TRUE(plan.FreeTexture(b));
+  plan.EndRun();
+  EXPECT_EQ(api.num_live, 1);
+  for (int run = 0; run < 2; ++run) {
+    plan.BeginRun();
+    EXPECT_EQ(plan.AllocTexture(kCtx, 8, 8, 4, kHalf), a);
+    EXPECT_TRUE(plan.FreeTexture(a));
+    EXPECT_EQ(plan.AllocTexture(kCtx, 4, 4, 4, kHalf), a);
+    EXPECT_TRUE(plan.FreeTexture(a));
+    plan.EndRun();
+  }
+  EXPECT_EQ(api.num_live, 1);
+}
+
+TEST(TextureWorkspacePlan, DivergingRunReleasesTextures) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  {
+    std::mutex mu;
+    TextureWorkspacePlan plan(&api, &pool, &mu);
+    plan.BeginRun();
+    void* a = plan.AllocTexture(kCtx, 8, 8, 4, kHalf);
+    EXPECT_TRUE(plan.FreeTexture(a));
+    plan.EndRun();
+    plan.BeginRun();
+    EXPECT_EQ(plan.AllocTexture(kCtx, 16, 16, 4, kHalf), nullptr);
+    plan.EndRun();
+    // The texture of the plan is back in the pool, and no longer claimed by the plan
+    EXPECT_FALSE(plan.FreeTexture(a));
+    EXPECT_EQ(pool.AllocTexture(kCtx, 8, 8, 4, kHalf), a);
+    EXPECT_EQ(pool.GetStats(kCtx).hits, 1U);
+    pool.FreeTexture(kCtx, a);
+  }
+  EXPECT_EQ(api.num_live, 1);
+}
+
+TEST(TextureWorkspacePlan, ReleaseToPool) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  void* a;
+  {
+    TextureWorkspacePlan plan(&api, &pool);
+    plan.BeginRun();
+    a = plan.AllocTexture(kCtx, 8, 8, 4, kHalf);
+    plan.FreeTexture(a);
+    plan.EndRun();
+  }
+  // Another graph reuses the texture of the released plan
+  EXPECT_EQ(pool.AllocTexture(kCtx, 8, 8, 4, kHalf), a);
+  EXPECT_EQ(api.num_live, 1);
+  pool.FreeTexture(kCtx, a);
+}
+
+TEST(TexturePool, BestFitByArea) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  void* large = pool.AllocTexture(kCtx, 16, 16, 4, kHalf);
+  void* small = pool.AllocTexture(kCtx, 8, 8, 4, kHalf);
+  void* wide = pool.AllocTexture(kCtx, 32, 2, 4, kHalf);
+  pool.FreeTexture(kCtx, large);
+  pool.FreeTexture(kCtx, small);
+  pool.FreeTexture(kCtx, wide);
+  // The smallest block covering both extents, the wide one is smaller but too short
+  EXPECT_EQ(pool.AllocTexture(kCtx, 6, 6, 4, kHalf), small);
+  EXPECT_EQ(pool.AllocTexture(kCtx, 10, 10, 4, kHalf), large);
+  TexturePool::Stats stats = pool.GetStats(kCtx);
+  EXPECT_EQ(stats.hits, 2U);
+  EXPECT_EQ(stats.misses, 3U);
+  EXPECT_EQ(stats.bytes_wasted, ((64 - 36) + (256 - 100)) * 4 * 2U);
+  EXPECT_EQ(api.num_live, 3);
+}
+
+TEST(TexturePool, MatchTypeAndChannels) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  void* a = pool.AllocTexture(kCtx, 8, 8, 4, kFloat);
+  pool.FreeTexture(kCtx, a);
+  // Neither a half float nor a two channel request takes the float32 block
+  void* half = pool.AllocTexture(kCtx, 8, 8, 4, kHalf);
+  void* two = pool.AllocTexture(kCtx, 8, 8, 2, kFloat);
+  EXPECT_NE(half, a);
+  EXPECT_NE(two, a);
+  EXPECT_EQ(pool.GetStats(kCtx).hits, 0U);
+  EXPECT_EQ(pool.AllocTexture(kCtx, 8, 8, 4, kFloat), a);
+  EXPECT_EQ(pool.GetStats(kCtx).hits, 1U);
+}
+
+TEST(TexturePool, GrowLeastAddedArea) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  pool.FreeTexture(kCtx, pool.AllocTexture(kCtx, 8, 4, 4, kHalf));
+  // 8x4 grown to 8x8 adds less than a new 8x8 block
+  pool.AllocTexture(kCtx, 8, 8, 4, kHalf);
+  TexturePool::Stats stats = pool.GetStats(kCtx);
+  EXPECT_EQ(stats.grows, 1U);
+  EXPECT_EQ(stats.misses, 1U);
+  EXPECT_EQ(api.num_live, 1);
+}
+
+TEST(TexturePool, ReleasePastMaxFreeBytes) {
+  HostTextureAPI api;
+  TexturePool pool(kDLCPU, &api);
+  // One 8x8 half4 block is 512 bytes
+  pool.SetMaxFreeBytes(512);
+  void* a = pool.AllocTexture(kCtx, 8, 8, 4, kHalf);
+  void* b = pool.AllocTexture(kCtx, 8, 8, 4, kHalf);
+  pool.FreeTexture(kCtx, a);
+  pool.FreeTexture(kCtx, b);
+  EXPECT_EQ(pool.GetStats(kCtx).releases, 1U);
+  EXPECT_EQ(api.num_live, 1);
+}
+
+TEST(TextureFlattening, ImageArray) {
+  std::vector<int64_t> shape{2, 3, 4, 5, 4};
+  // One image of [C*H, W] per batch, instead of one image of [N*C*H, W]
+  auto array = ApplyTextureFlattening<int64_t>(shape, shape.size(), "texture:array");
+  EXPECT_EQ(array.depth, 2);
+  EXPECT_EQ(array.height, 12);
+  EXPECT_EQ(array.width, 5);
+  EXPECT_EQ(array.channel, 4);
+  auto image = ApplyTextureFlattening<int64_t>(shape, shape.size(), "texture");
+  EXPECT_EQ(image.depth, 1);
+  EXPECT_EQ(image.height, 24);
+  // A view fits arrays of as many images only
+  EXPECT_TRUE(TextureFitsShape(shape, {2, 3, 2, 5, 4}, "texture:array"));
+  EXPECT_FALSE(TextureFitsShape(shape, {1, 3, 4, 5, 4}, "texture:array"));
+  EXPECT_TRUE(TextureFitsShape(shape, {1, 3, 4, 5, 4}, "texture"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -19,8 +19,12 @@
 
 #include <gtest/gtest.h>
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <memory>
 #include <thread>
 
@@ -36,6 +40,34 @@ static FTVMParallelLambda atomic_add_task_id = [](int task_id, TVMParallelGroupE
   return 0;
 };
 
+// The number of runs of every task id, and the number of tasks of the launch
+struct TaskCounts {
+  std::atomic<int> runs[1024];
+  std::atomic<int> num_task{0};
+  TaskCounts() {
+    for (auto& r : runs) r = 0;
+  }
+  // Whether every task of the launch ran exactly once
+  bool RanOnce() const {
+    int n = num_task.load();
+    if (n < 1 || n > 1024) return false;
+    for (int i = 0; i < 1024; ++i) {
+      if (runs[i].load() != (i < n ? 1 : 0)) return false;
+    }
+    return true;
+  }
+};
+
+static FTVMParallelLambda count_task_id = [](int task_id, TVMParallelGroupEnv* penv,
+                                             void* cdata) -> int {
+  auto* counts = reinterpret_cast<TaskCounts*>(cdata);
+  counts->num_task = penv->num_task;
+  counts->runs[task_id].fetch_add(1);
+  // Uneven tasks, the first one of a worker is slow
+  if (task_id % 4 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  return 0;
+};
+
 TEST(ThreadingBackend, TVMBackendParallelLaunch) {
   std::atomic<size_t> acc(0);
   TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
@@ -64,6 +96,136 @@ TEST(ThreadingBackend, TVMBackendParallelLaunchMultipleThreads) {
   }
 }
 
+TEST(ThreadingBackend, SleepAndWake) {
+  // Run on a thread of its own, so that the pool is not shared with the other tests
+  std::thread t([]() {
+    for (const char* name : {"runtime.threadpool_sleep", "runtime.threadpool_wake"}) {
+      (*tvm::runtime::Registry::Get(name))();
+      for (int i = 0; i < 3; ++i) {
+        std::atomic<size_t> acc(0);
+        TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+        EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      }
+    }
+  });
+  t.join();
+}
+
+TEST(ThreadingBackend, AdaptiveSpin) {
+  // The pool of a new thread reads the limit, long gaps between the launches stop the spinning
+  setenv("TVM_THREAD_POOL_MAX_SPIN_IDLE_US", "1", 1);
+  std::thread t([]() {
+    for (int i = 0; i < 4; ++i) {
+      std::atomic<size_t> acc(0);
+      TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+      EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  t.join();
+  unsetenv("TVM_THREAD_POOL_MAX_SPIN_IDLE_US");
+}
+
+TEST(ThreadingBackend, WorkStealing) {
+  // The pool of a new thread reads the number of tasks per worker
+  setenv("TVM_THREAD_POOL_WORK_STEALING", "4", 1);
+  std::thread t([]() {
+    TaskCounts counts;
+    TVMBackendParallelLaunch(count_task_id, &counts, 0);
+    EXPECT_TRUE(counts.RanOnce());
+    int num_workers = tvm::runtime::threading::MaxConcurrency();
+    if (num_workers > 1) EXPECT_EQ(counts.num_task.load() % 4, 0);
+    TaskCounts fixed;
+    TVMBackendParallelLaunch(count_task_id, &fixed, 37);
+    EXPECT_TRUE(fixed.RanOnce());
+    if (num_workers > 1) EXPECT_EQ(fixed.num_task.load(), 37);
+  });
+  t.join();
+  unsetenv("TVM_THREAD_POOL_WORK_STEALING");
+}
+
+TEST(ThreadingBackend, WorkStealingNested) {
+  setenv("TVM_THREAD_POOL_WORK_STEALING", "2", 1);
+  std::thread t([]() {
+    // Every outer task launches a parallel sum from its worker
+    static FTVMParallelLambda nested = [](int task_id, TVMParallelGroupEnv* penv,
+                                          void* cdata) -> int {
+      return TVMBackendParallelLaunch(atomic_add_task_id, cdata, 0);
+    };
+    std::atomic<size_t> acc(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(nested, &acc, 8), 0);
+    EXPECT_EQ(acc.load(), 8 * N * (N - 1) / 2);
+  });
+  t.join();
+  unsetenv("TVM_THREAD_POOL_WORK_STEALING");
+}
+
+TEST(ThreadingBackend, Weighted) {
+  std::thread t([]() {
+    // mode 2 is the weighted mode, over all the cores
+    const auto* config = tvm::runtime::Registry::Get("runtime.config_threadpool");
+    ASSERT_NE(config, nullptr);
+    (*config)(2, 0);
+    // enough launches for the weights to be recalibrated from the uneven tasks
+    for (int i = 0; i < 80; ++i) {
+      TaskCounts counts;
+      ASSERT_EQ(TVMBackendParallelLaunch(count_task_id, &counts, 0), 0);
+      ASSERT_TRUE(counts.RanOnce()) << "launch " << i;
+      if (tvm::runtime::threading::MaxConcurrency() > 1) {
+        EXPECT_EQ(counts.num_task.load() % 8, 0);
+      }
+      std::atomic<size_t> acc(0);
+      ASSERT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0), 0);
+      ASSERT_EQ(acc.load(), N * (N - 1) / 2);
+    }
+  });
+  t.join();
+}
+
+TEST(ThreadingBackend, IsolatedPool) {
+  if (tvm::runtime::threading::MaxConcurrency() < 2) return;
+  const auto* create = tvm::runtime::Registry::Get("runtime.ThreadPoolCreate");
+  ASSERT_NE(create, nullptr);
+  tvm::runtime::ObjectRef pair = (*create)("0,1");
+  tvm::runtime::ObjectRef single = (*create)("0");
+  std::thread t([&]() {
+    tvm::runtime::threading::ThreadPoolScope outer(pair);
+    TaskCounts counts;
+    TVMBackendParallelLaunch(count_task_id, &counts, 0);
+    EXPECT_TRUE(counts.RanOnce());
+    EXPECT_EQ(counts.num_task.load(), 2);
+    {
+      tvm::runtime::threading::ThreadPoolScope inner(single);
+      TaskCounts one;
+      TVMBackendParallelLaunch(count_task_id, &one, 0);
+      EXPECT_TRUE(one.RanOnce());
+      EXPECT_EQ(one.num_task.load(), 1);
+    }
+    // the outer binding is back
+    TaskCounts again;
+    TVMBackendParallelLaunch(count_task_id, &again, 0);
+    EXPECT_EQ(again.num_task.load(), 2);
+  });
+  t.join();
+}
+
+TEST(ThreadingBackend, IsolatedPoolSharedByThreads) {
+  if (tvm::runtime::threading::MaxConcurrency() < 2) return;
+  tvm::runtime::ObjectRef pool = tvm::runtime::threading::CreateThreadPool({0, 1});
+  // the launches of both threads go to the same workers, one at a time
+  auto run = [&pool]() {
+    tvm::runtime::threading::ThreadPoolScope scope(pool);
+    for (int i = 0; i < 50; ++i) {
+      std::atomic<size_t> acc(0);
+      EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0), 0);
+      EXPECT_EQ(acc.load(), N * (N - 1) / 2);
+    }
+  };
+  std::thread t1(run), t2(run);
+  t1.join();
+  t2.join();
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/tir/builtin.h>
+
+#include <unordered_map>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+const int kLength = 8;
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+}  // namespace
+
+TEST(Dp4a, DefaultLowering) {
+  if (!HasLLVM()) return;
+  // out[i] = 5 + dot((i, i, i, i), (1, 2, 3, 4))
+  Tensor out = compute(
+      {kLength},
+      [](const tir::Var& i) {
+        PrimExpr a = tir::Broadcast(cast(DataType::Int(8), i), 4);
+        PrimExpr b = tir::Ramp(IntImm(DataType::Int(8), 1), IntImm(DataType::Int(8), 1), 4);
+        return tir::Call(DataType::Int(32), tir::builtin::dp4a(), {a, b, 5});
+      },
+      "out");
+  Schedule s = create_schedule({out->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  runtime::Module mod = build(lower(s, {out}, "dp4a", binds), Target("llvm"), Target());
+  runtime::NDArray result = runtime::NDArray::Empty({kLength}, DataType::Int(32), {kDLCPU, 0});
+  mod.GetFunction("dp4a")(result);
+  std::vector<int32_t> values(kLength);
+  result.CopyToBytes(values.data(), values.size() * sizeof(int32_t));
+  for (int i = 0; i < kLength; ++i) EXPECT_EQ(values[i], 5 + 10 * i);
+}
+
+TEST(Dp4a, RejectOtherLanes) {
+  const auto* lower = runtime::Registry::Get("tvm.intrin.rule.default.dp4a");
+  ASSERT_NE(lower, nullptr);
+  PrimExpr a = tir::Broadcast(IntImm(DataType::Int(8), 1), 8);
+  EXPECT_ANY_THROW((*lower)(tir::Call(DataType::Int(32), tir::builtin::dp4a(), {a, a, 0})));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <set>
+#include <string>
+
+using namespace tvm;
+using namespace tvm::tir;
+
+namespace {
+
+/*!
+ * \brief Lower the intrinsics of a function storing `value` of x and y, and give the names of
+ *  the extern functions it calls and whether it still divides.
+ */
+std::set<std::string> LowerExterns(const PrimExpr& value, const Var& x, const Var& y,
+                                   const Target& target, bool* divides) {
+  DataType t = x.dtype();
+  Var a("A", PointerType(PrimType(t)));
+  PrimExpr index = t.lanes() == 1 ? PrimExpr(0) : Ramp(0, 1, t.lanes());
+  Stmt body = Store(a, value, index, const_true(t.lanes()));
+  PrimFunc f({a, x, y}, body);
+  f = WithAttr(std::move(f), tvm::attr::kTarget, target);
+  IRModule mod = transform::LowerIntrin()(IRModule({{GlobalVar("f"), f}}));
+  std::set<std::string> names;
+  *divides = false;
+  PostOrderVisit(Downcast<PrimFunc>(mod->Lookup("f"))->body, [&](const ObjectRef& n) {
+    if (n.as<DivNode>() != nullptr) *divides = true;
+    const auto* call = n.as<CallNode>();
+    if (call != nullptr && call->op.same_as(builtin::call_pure_extern())) {
+      names.insert(call->args[0].as<StringImmNode>()->value);
+    }
+  });
+  return names;
+}
+
+Target FastMathOpenCL() {
+  return Target(Map<String, ObjectRef>{{"kind", String("opencl")}, {"fast-math", Bool(true)}});
+}
+
+}  // namespace
+
+TEST(LowerIntrin, OpenCLFastMath) {
+  Var x("x", DataType::Float(32));
+  Var y("y", DataType::Float(32));
+  bool divides;
+  std::set<std::string> names =
+      LowerExterns(exp(x) / y + sqrt(x) + sin(y), x, y, FastMathOpenCL(), &divides);
+  EXPECT_EQ(names, std::set<std::string>({"native_exp", "native_divide", "native_sqrt", "sin"}));
+  EXPECT_FALSE(divides);
+  names = LowerExterns(FloatImm(DataType::Float(32), 1) / x, x, y, FastMathOpenCL(), &divides);
+  EXPECT_EQ(names, std::set<std::string>({"native_recip"}));
+}
+
+TEST(LowerIntrin, OpenCLFastMathVector) {
+  Var x("x", DataType::Float(32, 4));
+  Var y("y", DataType::Float(32, 4));
+  bool divides;
+  std::set<std::string> names = LowerExterns(Broadcast(FloatImm(DataType::Float(32), 1), 4) / x,
+                                             x, y, FastMathOpenCL(), &divides);
+  EXPECT_EQ(names, std::set<std::string>({"native_recip"}));
+}
+
+TEST(LowerIntrin, OpenCLFastMathFloat16) {
+  Var x("x", DataType::Float(16));
+  Var y("y", DataType::Float(16));
+  bool divides;
+  std::set<std::string> names = LowerExterns(exp(x) / y, x, y, FastMathOpenCL(), &divides);
+  // the standard rules
+  EXPECT_EQ(names, std::set<std::string>({"exp"}));
+  EXPECT_TRUE(divides);
+}
+
+TEST(LowerIntrin, OpenCLWithoutFastMath) {
+  Var x("x", DataType::Float(32));
+  Var y("y", DataType::Float(32));
+  bool divides;
+  std::set<std::string> names = LowerExterns(exp(x) / y, x, y, Target("opencl"), &divides);
+  EXPECT_EQ(names, std::set<std::string>({"exp"}));
+  EXPECT_TRUE(divides);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
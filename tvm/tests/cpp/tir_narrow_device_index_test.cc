@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/buffer.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <functional>
+
+using namespace tvm;
+using namespace tvm::tir;
+
+namespace {
+
+/*!
+ * \brief Narrow a kernel storing into a buffer of n elements, launched on n blocks.
+ * \param index The store index of the block var.
+ * \return The store index after the pass.
+ */
+PrimExpr NarrowStoreIndex(const std::function<PrimExpr(const Var&)>& index) {
+  Var n("n", DataType::Int(64));
+  Buffer buf = decl_buffer({n}, DataType::Float(32), "A");
+  Var handle("A_handle", DataType::Handle());
+  IterVar bx(Range(make_zero(DataType::Int(64)), n), Var("blockIdx.x", DataType::Int(64)),
+             IterVarType::kThreadIndex, "blockIdx.x");
+  Stmt store = Store(buf->data, FloatImm(DataType::Float(32), 1), index(bx->var), const_true());
+  PrimFunc f({handle}, AttrStmt(bx, attr::thread_extent, n, store), VoidType(), {{handle, buf}});
+  f = WithAttr(std::move(f), tvm::attr::kTarget, Target("opencl -index_bits=32"));
+  IRModule mod({{GlobalVar("main"), f}});
+  mod = transform::NarrowDeviceIndex()(mod);
+  PrimExpr result;
+  PostOrderVisit(Downcast<PrimFunc>(mod->Lookup("main"))->body, [&result](const ObjectRef& n) {
+    if (const auto* op = n.as<StoreNode>()) result = op->index;
+  });
+  return result;
+}
+
+// The number of Add, Sub and Mul nodes of the expression with a dtype of the type code
+int CountRingOps(const PrimExpr& e, DLDataTypeCode code) {
+  int count = 0;
+  PostOrderVisit(e, [&count, code](const ObjectRef& n) {
+    if (n.as<AddNode>() || n.as<SubNode>() || n.as<MulNode>()) {
+      count += Downcast<PrimExpr>(n).dtype().code() == code;
+    }
+  });
+  return count;
+}
+
+}  // namespace
+
+TEST(NarrowDeviceIndex, WrapInUnsigned) {
+  // x * 2 does not fit int32 for a launch extent close to the limit, x * 2 - x does
+  PrimExpr index = NarrowStoreIndex([](const Var& x) { return x * 2 - x; });
+  ASSERT_TRUE(index.defined());
+  EXPECT_EQ(index.dtype(), DataType::Int(32));
+  const auto* cast = index.as<CastNode>();
+  ASSERT_NE(cast, nullptr);
+  EXPECT_EQ(cast->value.dtype(), DataType::UInt(32));
+  EXPECT_EQ(CountRingOps(index, kDLUInt), 2);
+  EXPECT_EQ(CountRingOps(index, kDLInt), 0);
+}
+
+TEST(NarrowDeviceIndex, FittingIndexStaysSigned) {
+  PrimExpr index = NarrowStoreIndex([](const Var& x) { return floordiv(x, 2) + 1; });
+  ASSERT_TRUE(index.defined());
+  EXPECT_EQ(index.dtype(), DataType::Int(32));
+  EXPECT_EQ(CountRingOps(index, kDLUInt), 0);
+  EXPECT_EQ(CountRingOps(index, kDLInt), 1);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
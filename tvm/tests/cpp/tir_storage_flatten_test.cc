@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/arith/analyzer.h>
+#include <tvm/ir/transform.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/te/schedule_pass.h>
+#include <tvm/tir/buffer.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <string>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+/*!
+ * \brief Flatten a transpose reading a 32x32 shared copy of its input down the columns.
+ * \param pad_shared_banks Whether to pad the rows of the shared buffers.
+ * \param align_factor The factor of a storage_align on the rows of the copy, none if 0.
+ * \return The number of elements allocated for the shared copy.
+ */
+int64_t SharedElements(bool pad_shared_banks, int align_factor = 0) {
+  Tensor a = placeholder({32, 32}, DataType::Float(32), "A");
+  Tensor b = compute({32, 32}, [&](Var i, Var j) { return a(j, i); }, "B");
+  Schedule s = create_schedule({b->op});
+  Tensor shared = s.cache_read(a, "shared", {b->op});
+  // threadIdx.x walks the rows of the shared copy
+  s[b].bind(b->op.as<ComputeOpNode>()->axis[0], thread_axis(Range(), "blockIdx.x"));
+  s[b].bind(b->op.as<ComputeOpNode>()->axis[1], thread_axis(Range(), "threadIdx.x"));
+  if (align_factor > 0) {
+    s[shared].storage_align(shared->op.as<ComputeOpNode>()->axis[0], align_factor, 0);
+  }
+  s = s.normalize();
+  tir::Stmt stmt = ScheduleOps(s, InferBound(s), false);
+  tir::Buffer a_buf = tir::decl_buffer(a->shape, a->dtype, "A");
+  tir::Buffer b_buf = tir::decl_buffer(b->shape, b->dtype, "B");
+  Map<Tensor, tir::Buffer> binds{{a, a_buf}, {b, b_buf}};
+  tir::PrimFunc func = SchedulePostProcToPrimFunc({a_buf, b_buf}, stmt, binds);
+  func = WithAttr(std::move(func), tvm::attr::kTarget, Target("opencl"));
+
+  auto pass_ctx = transform::PassContext::Create();
+  pass_ctx->config.Set("tir.StorageFlatten.pad_shared_banks", Bool(pad_shared_banks));
+  With<transform::PassContext> ctx_scope(pass_ctx);
+  IRModule mod = IRModule(Map<GlobalVar, BaseFunc>({{GlobalVar("main"), func}}));
+  mod = tir::transform::StorageFlatten(64)(mod);
+  int64_t elements = -1;
+  tir::PostOrderVisit(Downcast<tir::PrimFunc>(mod->Lookup("main"))->body,
+                      [&elements](const ObjectRef& n) {
+                        const auto* alloc = n.as<tir::AllocateNode>();
+                        if (alloc == nullptr || alloc->buffer_var->name_hint != "A.shared") {
+                          return;
+                        }
+                        arith::Analyzer analyzer;
+                        PrimExpr size = 1;
+                        for (const PrimExpr& extent : alloc->extents) size = size * extent;
+                        elements = Downcast<IntImm>(analyzer.Simplify(size))->value;
+                      });
+  return elements;
+}
+
+}  // namespace
+
+TEST(StorageFlatten, PadSharedBanksIsOptIn) { EXPECT_EQ(SharedElements(false), 32 * 32); }
+
+TEST(StorageFlatten, PadSharedColumns) {
+  // A pitch of 32 words hits one bank of the 32, padded to 33
+  EXPECT_EQ(SharedElements(true), 32 * 33);
+}
+
+TEST(StorageFlatten, ExplicitAlignKeepsLayout) {
+  // An explicit storage_align takes over the padding, a factor of 1 keeps the buffer dense
+  EXPECT_EQ(SharedElements(true, 1), 32 * 32);
+  EXPECT_EQ(SharedElements(true, 64), 32 * 64);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
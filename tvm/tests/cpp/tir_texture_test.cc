@@ -0,0 +1,235 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/ir/module.h>
+#include <tvm/target/target.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/tir/transform.h>
+
+#include <string>
+
+using namespace tvm;
+using namespace tvm::tir;
+
+namespace {
+
+Stmt StoreTexel(const Var& texture, int x, int y, float value) {
+  return Evaluate(Call(DataType::Handle(), builtin::texture2d_store(),
+                       {texture, x, y, Broadcast(FloatImm(DataType::Float(32), value), 4)}));
+}
+
+PrimExpr LoadTexel(const Var& texture, int x, int y) {
+  return Call(DataType::Float(32, 4), builtin::texture2d_load(), {texture, x, y});
+}
+
+// The number of calls of an op left in the function
+int CountCalls(const PrimFunc& f, const Op& op) {
+  int count = 0;
+  PostOrderVisit(f->body, [&count, &op](const ObjectRef& n) {
+    if (const auto* call = n.as<CallNode>()) count += call->op.same_as(op);
+  });
+  return count;
+}
+
+PrimFunc RemoveDeadTextureStore(const PrimFunc& f) {
+  IRModule mod({{GlobalVar("main"), f}});
+  mod = transform::RemoveDeadTextureStore()(mod);
+  return Downcast<PrimFunc>(mod->Lookup("main"));
+}
+
+PrimFunc TextureFlatten(const PrimFunc& f) {
+  IRModule mod({{GlobalVar("main"), f}});
+  mod = transform::TextureFlatten()(mod);
+  return Downcast<PrimFunc>(mod->Lookup("main"));
+}
+
+Var Texture(const std::string& name, DataType dtype = DataType::Float(32)) {
+  return Var(name, TextureType(dtype));
+}
+
+PrimExpr Alloca(int width, int height, int channel) {
+  return Call(DataType::Handle(), builtin::texture2d_alloca(), {width, height, channel});
+}
+
+// A stage writing `texture` then copying a texel of it into `out`
+Stmt Stage(const Var& texture, const Var& out, int width, int height, int channel = 4) {
+  Stmt copy = Evaluate(Call(DataType::Handle(), builtin::texture2d_store(),
+                            {out, 0, 0, LoadTexel(texture, 0, 0)}));
+  return LetStmt(texture, Alloca(width, height, channel),
+                 SeqStmt({StoreTexel(texture, 0, 0, 1.0f), copy}));
+}
+
+// The first texture2d_alloca left in the function
+const CallNode* FindAlloca(const PrimFunc& f) {
+  const CallNode* alloca = nullptr;
+  PostOrderVisit(f->body, [&alloca](const ObjectRef& n) {
+    const auto* call = n.as<CallNode>();
+    if (alloca == nullptr && call && call->op.same_as(builtin::texture2d_alloca())) {
+      alloca = call;
+    }
+  });
+  return alloca;
+}
+
+// An external [2, 1, 2, 2, 4] float tensor held in an array of 2 images
+Buffer ArrayBuffer(const std::string& name) {
+  return Buffer(Var(name, TextureType(PrimType(DataType::Float(32)))), DataType::Float(32),
+                {2, 1, 2, 2, 4}, {}, 0, name, "texture:array", -1, 0, BufferType::kDefault);
+}
+
+// The first call of an op left in the function
+const CallNode* FindCall(const PrimFunc& f, const Op& op) {
+  const CallNode* found = nullptr;
+  PostOrderVisit(f->body, [&found, &op](const ObjectRef& n) {
+    const auto* call = n.as<CallNode>();
+    if (found == nullptr && call && call->op.same_as(op)) found = call;
+  });
+  return found;
+}
+
+}  // namespace
+
+TEST(RemoveDeadTextureStore, UnreadTexture) {
+  Var out("out", DataType::Handle());
+  Var tmp("tmp", DataType::Handle());
+  Stmt alloc = LetStmt(tmp,
+                       Call(DataType::Handle(), builtin::texture2d_alloca(), {4, 4, 4}),
+                       SeqStmt({StoreTexel(tmp, 0, 0, 1.0f), StoreTexel(out, 0, 0, 2.0f)}));
+  PrimFunc f = RemoveDeadTextureStore(PrimFunc({out}, alloc));
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_alloca()), 0);
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_store()), 1);
+}
+
+TEST(RemoveDeadTextureStore, OverwrittenStore) {
+  Var out("out", DataType::Handle());
+  Stmt body = SeqStmt({StoreTexel(out, 0, 0, 1.0f), StoreTexel(out, 1, 0, 2.0f),
+                       StoreTexel(out, 0, 0, 3.0f)});
+  PrimFunc f = RemoveDeadTextureStore(PrimFunc({out}, body));
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_store()), 2);
+}
+
+TEST(RemoveDeadTextureStore, StoreReadBeforeOverwrite) {
+  Var out("out", DataType::Handle());
+  Var res("res", DataType::Handle());
+  Stmt read = Evaluate(Call(DataType::Handle(), builtin::texture2d_store(),
+                            {res, 0, 0, LoadTexel(out, 0, 0)}));
+  Stmt body = SeqStmt({StoreTexel(out, 0, 0, 1.0f), read, StoreTexel(out, 0, 0, 3.0f)});
+  PrimFunc f = RemoveDeadTextureStore(PrimFunc({out, res}, body));
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_store()), 3);
+}
+
+TEST(TextureFlatten, ShareDisjointStages) {
+  Var out("out", DataType::Handle());
+  Var a = Texture("a");
+  Var b = Texture("b");
+  PrimFunc f = TextureFlatten(PrimFunc({out}, SeqStmt({Stage(a, out, 4, 4), Stage(b, out, 8, 2)})));
+  ASSERT_EQ(CountCalls(f, builtin::texture2d_alloca()), 1);
+  // The shared texture is grown to the largest member
+  const CallNode* alloca = FindAlloca(f);
+  EXPECT_EQ(Downcast<IntImm>(alloca->args[0])->value, 8);
+  EXPECT_EQ(Downcast<IntImm>(alloca->args[1])->value, 4);
+  EXPECT_EQ(Downcast<IntImm>(alloca->args[2])->value, 4);
+  // Every access of b goes to the texture of a
+  PostOrderVisit(f->body, [&b](const ObjectRef& n) {
+    if (const auto* var = n.as<VarNode>()) EXPECT_NE(var, b.get());
+  });
+}
+
+TEST(TextureFlatten, KeepOverlappingStages) {
+  Var out("out", DataType::Handle());
+  Var a = Texture("a");
+  Var b = Texture("b");
+  auto copy = [&out](const Var& texture) {
+    return Evaluate(Call(DataType::Handle(), builtin::texture2d_store(),
+                         {out, 0, 0, LoadTexel(texture, 0, 0)}));
+  };
+  Stmt body = SeqStmt({StoreTexel(a, 0, 0, 1.0f), StoreTexel(b, 0, 0, 2.0f), copy(a), copy(b)});
+  body = LetStmt(a, Alloca(4, 4, 4), LetStmt(b, Alloca(4, 4, 4), body));
+  PrimFunc f = TextureFlatten(PrimFunc({out}, body));
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_alloca()), 2);
+}
+
+TEST(TextureFlatten, KeepMismatchedTextures) {
+  Var out("out", DataType::Handle());
+  Var a = Texture("a");
+  Var b = Texture("b", DataType::Float(16));
+  Var c = Texture("c");
+  PrimFunc f = TextureFlatten(
+      PrimFunc({out}, SeqStmt({Stage(a, out, 4, 4), Stage(b, out, 4, 4), Stage(c, out, 4, 4, 1)})));
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_alloca()), 3);
+}
+
+TEST(TextureFlatten, KeepEscapingTexture) {
+  Var out("out", DataType::Handle());
+  Var a = Texture("a");
+  Var b = Texture("b");
+  Stmt escape = LetStmt(a, Alloca(4, 4, 4),
+                        SeqStmt({StoreTexel(a, 0, 0, 1.0f),
+                                 Evaluate(Call(DataType::Int(32), builtin::tvm_call_packed(),
+                                               {StringImm("consume"), a}))}));
+  PrimFunc f = TextureFlatten(PrimFunc({out}, SeqStmt({escape, Stage(b, out, 4, 4)})));
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_alloca()), 2);
+}
+
+TEST(TextureFlatten, SpatialLimit) {
+  Var out("out", DataType::Handle());
+  Var a = Texture("a");
+  Var b = Texture("b");
+  PrimFunc f = PrimFunc({out}, SeqStmt({Stage(a, out, 4, 4), Stage(b, out, 8, 2)}));
+  f = WithAttr(std::move(f), tvm::attr::kTarget, Target("opencl -texture_spatial_limit=6"));
+  EXPECT_EQ(CountCalls(TextureFlatten(f), builtin::texture2d_alloca()), 2);
+}
+
+TEST(TextureFlatten, VectorizedImageArrayTexel) {
+  // b[1, 0, 1, 1, c] = a[1, 0, 1, 0, c] for the 4 channels c of a texel
+  Buffer a = ArrayBuffer("a");
+  Buffer b = ArrayBuffer("b");
+  Var c("c", DataType::Int(32));
+  PrimExpr load = BufferLoad(a, {1, 0, 1, 0, c});
+  Stmt body = For(c, 0, 4, ForKind::kVectorized, BufferStore(b, load, {1, 0, 1, 1, c}));
+  PrimFunc f({a->data, b->data}, body, VoidType(), {{a->data, a}, {b->data, b}});
+  IRModule mod({{GlobalVar("main"), f}});
+  mod = transform::VectorizeLoop()(transform::TextureFlatten()(mod));
+  f = Downcast<PrimFunc>(mod->Lookup("main"));
+  // The image, the column, the row, the image index and the channels of a single read and write
+  const CallNode* read = FindCall(f, builtin::texture2d_array_load());
+  const CallNode* write = FindCall(f, builtin::texture2d_array_store());
+  ASSERT_NE(read, nullptr);
+  ASSERT_NE(write, nullptr);
+  EXPECT_EQ(CountCalls(f, builtin::texture2d_array_load()), 1);
+  ASSERT_EQ(read->args.size(), 5U);
+  EXPECT_EQ(read->dtype.lanes(), 4);
+  EXPECT_TRUE(read->args[4].as<RampNode>());
+  EXPECT_TRUE(is_zero(read->args[1]));
+  EXPECT_TRUE(is_one(read->args[2]));
+  EXPECT_TRUE(is_one(read->args[3]));
+  ASSERT_EQ(write->args.size(), 5U);
+  EXPECT_TRUE(is_one(write->args[1]));
+  EXPECT_EQ(write->args[4].dtype().lanes(), 4);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
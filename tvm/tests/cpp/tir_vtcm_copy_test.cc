@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/tir/builtin.h>
+#include <tvm/tir/stmt_functor.h>
+
+#include <string>
+#include <unordered_map>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+// Lower C = B + 1 where B is a copy of A to VTCM marked with the vtcm_copy pragma
+IRModule LowerVTCMCopy() {
+  Tensor a = placeholder({8, 16}, DataType::Float(32), "A");
+  Tensor b = compute(
+      a->shape, [&a](PrimExpr i, PrimExpr j) { return a(i, j); }, "B");
+  Tensor c = compute(
+      a->shape, [&b](PrimExpr i, PrimExpr j) { return b(i, j) + 1.0f; }, "C");
+  Schedule s = create_schedule({c->op});
+  s[b].set_scope("vtcm");
+  s[b].pragma(b->op.as<ComputeOpNode>()->axis[0], "vtcm_copy");
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  return lower(s, {a, c}, "vtcm_copy", binds);
+}
+
+// The number of calls of the external function `name` in a lowered module
+int CountExternCalls(const IRModule& mod, const std::string& name) {
+  int count = 0;
+  for (const auto& kv : mod->functions) {
+    tir::PostOrderVisit(Downcast<tir::PrimFunc>(kv.second)->body,
+                        [&count, &name](const ObjectRef& n) {
+                          const auto* call = n.as<tir::CallNode>();
+                          if (call == nullptr || !call->op.same_as(tir::builtin::call_extern())) {
+                            return;
+                          }
+                          const auto* callee = call->args[0].as<tir::StringImmNode>();
+                          count += callee != nullptr && callee->value == name;
+                        });
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(InjectVTCMCopy, Hexagon) {
+  With<Target> target(Target("hexagon"));
+  IRModule mod = LowerVTCMCopy();
+  // One 2D copy of the 8 rows of 16 floats
+  EXPECT_EQ(CountExternCalls(mod, "TVMBackendHexagonDMACopy2D"), 1);
+}
+
+TEST(InjectVTCMCopy, OnlyForHexagon) {
+  EXPECT_EQ(CountExternCalls(LowerVTCMCopy(), "TVMBackendHexagonDMACopy2D"), 0);
+  With<Target> target(Target("llvm"));
+  EXPECT_EQ(CountExternCalls(LowerVTCMCopy(), "TVMBackendHexagonDMACopy2D"), 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/topi/cuda/depthwise_conv2d.h>
+#include <tvm/topi/nn.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+runtime::NDArray Fill(const std::vector<int64_t>& shape, int seed) {
+  auto array = runtime::NDArray::Empty(shape, DataType::Float(32), {kDLCPU, 0});
+  int64_t size = 1;
+  for (int64_t dim : shape) size *= dim;
+  for (int64_t i = 0; i < size; ++i) {
+    static_cast<float*>(array->data)[i] = static_cast<float>((i * 3 + seed) % 11) - 5;
+  }
+  return array;
+}
+
+}  // namespace
+
+TEST(DepthwiseConv2dNCHW4c, Compute) {
+  if (!HasLLVM()) return;
+  // 8 channels in 2 texels, a 3x3 kernel with a padding of 1 and a stride of 2
+  Tensor data = placeholder({1, 2, 6, 6, 4}, DataType::Float(32), "data");
+  Tensor weight = placeholder({2, 1, 3, 3, 4}, DataType::Float(32), "weight");
+  Tensor out = topi::depthwise_conv2d_NCHW4c(data, weight, 1, 1, 2, 2);
+  Schedule s = create_schedule({out->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  runtime::Module mod =
+      build(lower(s, {data, weight, out}, "conv", binds), Target("llvm"), Target());
+
+  runtime::NDArray d = Fill({1, 2, 6, 6, 4}, 1), w = Fill({2, 1, 3, 3, 4}, 2);
+  auto o = runtime::NDArray::Empty({1, 2, 3, 3, 4}, DataType::Float(32), {kDLCPU, 0});
+  mod.GetFunction("conv")(d, w, o);
+  const float* dv = static_cast<float*>(d->data);
+  const float* wv = static_cast<float*>(w->data);
+  const float* ov = static_cast<float*>(o->data);
+  for (int c = 0; c < 2; ++c) {
+    for (int h = 0; h < 3; ++h) {
+      for (int x = 0; x < 3; ++x) {
+        for (int v = 0; v < 4; ++v) {
+          float expected = 0;
+          for (int kh = 0; kh < 3; ++kh) {
+            for (int kw = 0; kw < 3; ++kw) {
+              int ih = h * 2 + kh - 1, iw = x * 2 + kw - 1;
+              if (ih < 0 || ih >= 6 || iw < 0 || iw >= 6) continue;
+              expected += dv[((c * 6 + ih) * 6 + iw) * 4 + v] * wv[((c * 3 + kh) * 3 + kw) * 4 + v];
+            }
+          }
+          EXPECT_EQ(ov[((c * 3 + h) * 3 + x) * 4 + v], expected);
+        }
+      }
+    }
+  }
+}
+
+TEST(DepthwiseConv2dNCHW4c, ScheduleFusesEpilogue) {
+  Target target("opencl");
+  Tensor data = placeholder({1, 8, 32, 32, 4}, DataType::Float(16), "data");
+  Tensor weight = placeholder({8, 1, 3, 3, 4}, DataType::Float(16), "weight");
+  Tensor conv = topi::depthwise_conv2d_NCHW4c(data, weight, 1, 1, 1, 1);
+  Tensor out = topi::relu<float>(conv);
+  Schedule s = topi::cuda::schedule_depthwise_conv2d_NCHW4c(target, {out});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  IRModule mod = lower(s, {data, weight, out}, "conv", binds);
+  std::vector<std::string> allocations;
+  int num_kernels = 0;
+  tir::PostOrderVisit(Downcast<tir::PrimFunc>(mod->Lookup("conv"))->body,
+                      [&](const ObjectRef& n) {
+                        if (const auto* alloc = n.as<tir::AllocateNode>()) {
+                          allocations.push_back(alloc->buffer_var->name_hint);
+                        }
+                        const auto* attr = n.as<tir::AttrStmtNode>();
+                        if (attr != nullptr && attr->attr_key == tir::attr::thread_extent &&
+                            Downcast<IterVar>(attr->node)->thread_tag == "blockIdx.z") {
+                          ++num_kernels;
+                        }
+                      });
+  // one kernel with the relu inlined, the input window, the weights and the accumulators in
+  // registers, and the padding read in place
+  EXPECT_EQ(num_kernels, 1);
+  EXPECT_EQ(allocations.size(), 3U);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
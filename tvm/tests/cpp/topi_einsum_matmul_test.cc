@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/topi/einsum.h>
+#include <tvm/topi/nn/batch_matmul.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+std::vector<int64_t> Shape(const Tensor& t) {
+  std::vector<int64_t> shape;
+  for (const PrimExpr& dim : t->shape) shape.push_back(Downcast<IntImm>(dim)->value);
+  return shape;
+}
+
+int64_t Size(const std::vector<int64_t>& shape) {
+  int64_t size = 1;
+  for (int64_t dim : shape) size *= dim;
+  return size;
+}
+
+// Small integers, exact in every data type of the tests
+std::vector<int> Values(int64_t size, int seed) {
+  std::vector<int> values(size);
+  for (int64_t i = 0; i < size; ++i) values[i] = static_cast<int>((i * 5 + seed) % 7) - 3;
+  return values;
+}
+
+template <typename T>
+runtime::NDArray ToArray(const Tensor& t, const std::vector<int>& values) {
+  auto array = runtime::NDArray::Empty(Shape(t), t->dtype, {kDLCPU, 0});
+  for (size_t i = 0; i < values.size(); ++i) static_cast<T*>(array->data)[i] = values[i];
+  return array;
+}
+
+// Run `out` on the CPU for the inputs `a` and `b` of elements of type TIn filled from `Values`
+template <typename TIn, typename TOut>
+std::vector<TOut> Run(const Tensor& a, const Tensor& b, const Tensor& out) {
+  Schedule s = create_schedule({out->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  runtime::Module mod = build(lower(s, {a, b, out}, "f", binds), Target("llvm"), Target());
+  auto result = runtime::NDArray::Empty(Shape(out), out->dtype, {kDLCPU, 0});
+  mod.GetFunction("f")(ToArray<TIn>(a, Values(Size(Shape(a)), 1)),
+                       ToArray<TIn>(b, Values(Size(Shape(b)), 2)), result);
+  std::vector<TOut> values(Size(Shape(out)));
+  result.CopyToBytes(values.data(), values.size() * sizeof(TOut));
+  return values;
+}
+
+}  // namespace
+
+TEST(EinsumAsMatmul, Unsupported) {
+  Tensor a = placeholder({4, 4}, DataType::Float(32), "a");
+  Tensor b = placeholder({4, 4}, DataType::Float(32), "b");
+  DataType f32 = DataType::Float(32);
+  EXPECT_TRUE(topi::einsum_as_matmul("ij,jk->ik", {a, b}, f32).defined());
+  EXPECT_FALSE(topi::einsum_as_matmul("ij->ji", {a}, f32).defined());
+  EXPECT_FALSE(topi::einsum_as_matmul("...j,jk->...k", {a, b}, f32).defined());
+  EXPECT_FALSE(topi::einsum_as_matmul("ii,ij->j", {a, b}, f32).defined());
+  // j is only summed over the first operand
+  EXPECT_FALSE(topi::einsum_as_matmul("ij,ik->ik", {a, b}, f32).defined());
+}
+
+TEST(EinsumAsMatmul, Attention) {
+  if (!HasLLVM()) return;
+  // the scores of an attention block, batch b and heads h, over d
+  Tensor q = placeholder({2, 3, 4, 8}, DataType::Float(32), "q");
+  Tensor k = placeholder({2, 3, 5, 8}, DataType::Float(32), "k");
+  Tensor out = topi::einsum_as_matmul("bhqd,bhkd->bhqk", {q, k}, DataType::Float(32));
+  ASSERT_TRUE(out.defined());
+  EXPECT_EQ(Shape(out), std::vector<int64_t>({2, 3, 4, 5}));
+  std::vector<float> result = Run<float, float>(q, k, out);
+  std::vector<int> qv = Values(2 * 3 * 4 * 8, 1), kv = Values(2 * 3 * 5 * 8, 2);
+  for (int bh = 0; bh < 6; ++bh) {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 5; ++j) {
+        float expected = 0;
+        for (int d = 0; d < 8; ++d) expected += qv[(bh * 4 + i) * 8 + d] * kv[(bh * 5 + j) * 8 + d];
+        EXPECT_EQ(result[(bh * 4 + i) * 5 + j], expected);
+      }
+    }
+  }
+}
+
+TEST(EinsumAsMatmul, TransposedOutput) {
+  if (!HasLLVM()) return;
+  Tensor a = placeholder({3, 4}, DataType::Float(32), "a");
+  Tensor b = placeholder({4, 5}, DataType::Float(32), "b");
+  Tensor out = topi::einsum_as_matmul("ij,jk->ki", {a, b}, DataType::Float(32));
+  ASSERT_TRUE(out.defined());
+  EXPECT_EQ(Shape(out), std::vector<int64_t>({5, 3}));
+  std::vector<float> result = Run<float, float>(a, b, out);
+  std::vector<int> av = Values(12, 1), bv = Values(20, 2);
+  for (int i = 0; i < 3; ++i) {
+    for (int k = 0; k < 5; ++k) {
+      float expected = 0;
+      for (int j = 0; j < 4; ++j) expected += av[i * 4 + j] * bv[j * 5 + k];
+      EXPECT_EQ(result[k * 3 + i], expected);
+    }
+  }
+}
+
+TEST(BatchMatmul, BroadcastInt8) {
+  if (!HasLLVM()) return;
+  Tensor x = placeholder({1, 2, 16}, DataType::Int(8), "x");
+  Tensor y = placeholder({3, 4, 16}, DataType::Int(8), "y");
+  Tensor out = topi::nn::batch_matmul(x, y, DataType::Int(32));
+  EXPECT_EQ(Shape(out), std::vector<int64_t>({3, 2, 4}));
+  std::vector<int32_t> result = Run<int8_t, int32_t>(x, y, out);
+  std::vector<int> xv = Values(2 * 16, 1), yv = Values(3 * 4 * 16, 2);
+  for (int b = 0; b < 3; ++b) {
+    for (int i = 0; i < 2; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        int expected = 0;
+        for (int k = 0; k < 16; ++k) expected += xv[i * 16 + k] * yv[(b * 4 + j) * 16 + k];
+        EXPECT_EQ(result[(b * 2 + i) * 4 + j], expected);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
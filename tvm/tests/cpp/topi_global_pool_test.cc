@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/tir/stmt_functor.h>
+#include <tvm/topi/cuda/pooling.h>
+#include <tvm/topi/nn/pooling.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+// Pool `values` of `shape` in two stages with chunks of 8 elements, on the CPU
+std::vector<float> Pool(const std::vector<float>& values, const std::vector<int64_t>& shape,
+                        topi::nn::PoolType type, const std::string& layout) {
+  Array<PrimExpr> x_shape;
+  for (int64_t dim : shape) x_shape.push_back(static_cast<int>(dim));
+  Tensor x = placeholder(x_shape, DataType::Float(32), "x");
+  Tensor out = topi::nn::global_pool_multistage(x, type, layout, 8);
+  Schedule s = create_schedule({out->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  runtime::Module mod = build(lower(s, {x, out}, "pool", binds), Target("llvm"), Target());
+
+  auto input = runtime::NDArray::Empty(shape, DataType::Float(32), {kDLCPU, 0});
+  input.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  std::vector<int64_t> out_shape;
+  for (const PrimExpr& dim : out->shape) out_shape.push_back(Downcast<IntImm>(dim)->value);
+  auto output = runtime::NDArray::Empty(out_shape, DataType::Float(32), {kDLCPU, 0});
+  mod.GetFunction("pool")(input, output);
+  std::vector<float> result(runtime::GetDataSize(*output.operator->()) / sizeof(float));
+  output.CopyToBytes(result.data(), result.size() * sizeof(float));
+  return result;
+}
+
+std::vector<float> Iota(size_t size) {
+  std::vector<float> values(size);
+  // not sorted, so that the maximum is not always the last element
+  for (size_t i = 0; i < size; ++i) values[i] = static_cast<float>((i * 7) % 37);
+  return values;
+}
+
+}  // namespace
+
+TEST(GlobalPoolMultistage, NCHW) {
+  if (!HasLLVM()) return;
+  // 35 elements per channel, the last chunk of 8 is partial
+  std::vector<float> values = Iota(2 * 5 * 7);
+  std::vector<float> avg = Pool(values, {1, 2, 5, 7}, topi::nn::kAvgPool, "NCHW");
+  std::vector<float> max = Pool(values, {1, 2, 5, 7}, topi::nn::kMaxPool, "NCHW");
+  ASSERT_EQ(avg.size(), 2U);
+  ASSERT_EQ(max.size(), 2U);
+  for (int c = 0; c < 2; ++c) {
+    auto begin = values.begin() + c * 35, end = begin + 35;
+    float sum = 0;
+    for (auto it = begin; it != end; ++it) sum += *it;
+    EXPECT_NEAR(avg[c], sum / 35, 1e-4);
+    EXPECT_EQ(max[c], *std::max_element(begin, end));
+  }
+}
+
+TEST(GlobalPoolMultistage, NCHW4c) {
+  if (!HasLLVM()) return;
+  std::vector<float> values = Iota(3 * 3 * 4);
+  std::vector<float> max = Pool(values, {1, 1, 3, 3, 4}, topi::nn::kMaxPool, "NCHW4c");
+  ASSERT_EQ(max.size(), 4U);
+  for (int c = 0; c < 4; ++c) {
+    float expected = values[c];
+    for (int i = 0; i < 9; ++i) expected = std::max(expected, values[i * 4 + c]);
+    EXPECT_EQ(max[c], expected);
+  }
+}
+
+TEST(GlobalPoolMultistage, ScheduleBindsBothStages) {
+  Target target("cuda");
+  Tensor x = placeholder({1, 64, 56, 56}, DataType::Float(32), "x");
+  Tensor out = topi::nn::global_pool_multistage(x, topi::nn::kAvgPool, "NCHW", 64);
+  Schedule s = topi::cuda::schedule_global_pool_multistage(target, {out});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  IRModule mod = lower(s, {x, out}, "pool", binds);
+  int num_threads = 0;
+  tir::PostOrderVisit(Downcast<tir::PrimFunc>(mod->Lookup("pool"))->body,
+                      [&num_threads](const ObjectRef& n) {
+                        const auto* attr = n.as<tir::AttrStmtNode>();
+                        if (attr == nullptr || attr->attr_key != tir::attr::thread_extent) return;
+                        if (Downcast<IterVar>(attr->node)->thread_tag == "threadIdx.x") {
+                          ++num_threads;
+                        }
+                      });
+  // the partials and the final reduction each run over all the threads
+  EXPECT_EQ(num_threads, 2);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
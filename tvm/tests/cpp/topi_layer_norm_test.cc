@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/topi/nn/layer_norm.h>
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+const int kRows = 2;
+const int kCols = 8;
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+runtime::NDArray FromVector(const std::vector<float>& values, const std::vector<int64_t>& shape) {
+  auto array = runtime::NDArray::Empty(shape, DataType::Float(32), {kDLCPU, 0});
+  array.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  return array;
+}
+
+// Normalize the rows of `data`, scaling by `gamma` and offsetting by `beta`
+std::vector<float> LayerNorm(const std::vector<float>& data, const std::vector<float>& gamma,
+                             const std::vector<float>& beta) {
+  Tensor x = placeholder({kRows, kCols}, DataType::Float(32), "x");
+  Tensor g = placeholder({kCols}, DataType::Float(32), "g");
+  Tensor b = placeholder({kCols}, DataType::Float(32), "b");
+  Tensor out = topi::nn::layer_norm(x, g, b, {1}, 1e-5);
+  Schedule s = create_schedule({out->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  runtime::Module mod =
+      build(lower(s, {x, g, b, out}, "layer_norm", binds), Target("llvm"), Target());
+
+  runtime::NDArray result = runtime::NDArray::Empty({kRows, kCols}, DataType::Float(32),
+                                                    {kDLCPU, 0});
+  mod.GetFunction("layer_norm")(FromVector(data, {kRows, kCols}), FromVector(gamma, {kCols}),
+                                FromVector(beta, {kCols}), result);
+  std::vector<float> values(kRows * kCols);
+  result.CopyToBytes(values.data(), values.size() * sizeof(float));
+  return values;
+}
+
+}  // namespace
+
+TEST(LayerNorm, LargeMean) {
+  if (!HasLLVM()) return;
+  // 0..7 over a mean of 1e4, the sum of squares minus the squared sum cancels in float32
+  std::vector<float> data;
+  for (int r = 0; r < kRows; ++r) {
+    for (int c = 0; c < kCols; ++c) data.push_back(10000.0f * (r + 1) + c);
+  }
+  std::vector<float> out = LayerNorm(data, std::vector<float>(kCols, 1.0f),
+                                     std::vector<float>(kCols, 0.0f));
+  // The variance of 0..7 is 5.25
+  for (int r = 0; r < kRows; ++r) {
+    for (int c = 0; c < kCols; ++c) {
+      EXPECT_NEAR(out[r * kCols + c], (c - 3.5) / std::sqrt(5.25 + 1e-5), 1e-3);
+    }
+  }
+}
+
+TEST(LayerNorm, ScaleAndOffset) {
+  if (!HasLLVM()) return;
+  std::vector<float> data;
+  for (int r = 0; r < kRows; ++r) {
+    for (int c = 0; c < kCols; ++c) data.push_back(c % 2 == 0 ? -1.0f : 1.0f);
+  }
+  std::vector<float> out = LayerNorm(data, std::vector<float>(kCols, 2.0f),
+                                     std::vector<float>(kCols, 0.5f));
+  for (int i = 0; i < kRows * kCols; ++i) {
+    EXPECT_NEAR(out[i], 2.0 * data[i] / std::sqrt(1.0 + 1e-5) + 0.5, 1e-4);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
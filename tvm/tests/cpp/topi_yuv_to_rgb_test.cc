@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/relay/attrs/image.h>
+#include <tvm/relay/op_strategy.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/target/generic_func.h>
+#include <tvm/target/target.h>
+#include <tvm/te/operation.h>
+#include <tvm/te/schedule.h>
+#include <tvm/topi/image/yuv_to_rgb.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace tvm;
+using namespace tvm::te;
+
+namespace {
+
+bool HasLLVM() { return runtime::Registry::Get("target.build.llvm") != nullptr; }
+
+Array<FloatImm> Floats(double a, double b, double c) {
+  return {FloatImm(DataType::Float(32), a), FloatImm(DataType::Float(32), b),
+          FloatImm(DataType::Float(32), c)};
+}
+
+// Convert a 2x2 frame of luma `y` and chroma `first`, `second` to a NCHW image
+std::vector<float> Convert(uint8_t y, uint8_t first, uint8_t second, const std::string& format,
+                           const Array<FloatImm>& mean, const Array<FloatImm>& stddev) {
+  Tensor frame = placeholder({1, 3, 2}, DataType::UInt(8), "frame");
+  Tensor out = topi::image::yuv_to_rgb(frame, {}, format, "NCHW", mean, stddev,
+                                       DataType::Float(32));
+  Schedule s = create_schedule({out->op});
+  std::unordered_map<Tensor, tir::Buffer> binds;
+  runtime::Module mod =
+      build(lower(s, {frame, out}, "yuv_to_rgb", binds), Target("llvm"), Target());
+
+  std::vector<uint8_t> bytes{y, y, y, y, first, second};
+  auto input = runtime::NDArray::Empty({1, 3, 2}, DataType::UInt(8), {kDLCPU, 0});
+  input.CopyFromBytes(bytes.data(), bytes.size());
+  auto result = runtime::NDArray::Empty({1, 3, 2, 2}, DataType::Float(32), {kDLCPU, 0});
+  mod.GetFunction("yuv_to_rgb")(input, result);
+  std::vector<float> values(12);
+  result.CopyToBytes(values.data(), values.size() * sizeof(float));
+  return values;
+}
+
+}  // namespace
+
+TEST(YUVToRGB, Normalize) {
+  if (!HasLLVM()) return;
+  // A neutral chroma gives a gray of the luma in every channel
+  std::vector<float> out = Convert(102, 128, 128, "NV21", Floats(0.1, 0.2, 0.3),
+                                   Floats(0.5, 0.25, 2.0));
+  const float gray = 102.0f / 255.0f;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NEAR(out[i], (gray - 0.1f) / 0.5f, 1e-5);
+    EXPECT_NEAR(out[4 + i], (gray - 0.2f) / 0.25f, 1e-5);
+    EXPECT_NEAR(out[8 + i], (gray - 0.3f) / 2.0f, 1e-5);
+  }
+}
+
+TEST(YUVToRGB, ChromaOrder) {
+  if (!HasLLVM()) return;
+  // NV21 stores V first, a high V raises red; NV12 reads the same byte as U, raising blue
+  std::vector<float> nv21 = Convert(100, 200, 128, "NV21", Floats(0, 0, 0), Floats(1, 1, 1));
+  std::vector<float> nv12 = Convert(100, 200, 128, "NV12", Floats(0, 0, 0), Floats(1, 1, 1));
+  EXPECT_NEAR(nv21[0], (100.0f + 1.402f * 72.0f) / 255.0f, 1e-5);
+  EXPECT_NEAR(nv21[8], 100.0f / 255.0f, 1e-5);
+  EXPECT_NEAR(nv12[0], 100.0f / 255.0f, 1e-5);
+  EXPECT_NEAR(nv12[8], (100.0f + 1.772f * 72.0f) / 255.0f, 1e-5);
+}
+
+TEST(YUVToRGB, Strategy) {
+  auto attrs = make_object<relay::YUVToRGBAttrs>();
+  attrs->format = "NV21";
+  attrs->layout = "NCHW4c";
+  attrs->mean = Floats(0, 0, 0);
+  attrs->stddev = Floats(1, 1, 1);
+  attrs->out_dtype = DataType::Float(32);
+  Tensor frame = placeholder({1, 6, 4}, DataType::UInt(8), "frame");
+  for (const char* name : {"llvm", "opencl"}) {
+    Target target(name);
+    With<Target> scope(target);
+    relay::OpStrategy strategy = GenericFunc::Get("yuv_to_rgb_strategy")(
+        relay::Attrs(attrs), Array<Tensor>{frame}, relay::Type(), target);
+    ASSERT_EQ(strategy->specializations.size(), 1U);
+    const auto& impls = strategy->specializations[0]->implementations;
+    ASSERT_EQ(impls.size(), 1U);
+    Array<Tensor> outs = impls[0].Compute(relay::Attrs(attrs), {frame}, relay::Type());
+    ASSERT_EQ(outs[0]->shape.size(), 5U);
+    EXPECT_TRUE(impls[0].Schedule(relay::Attrs(attrs), outs, target).defined());
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
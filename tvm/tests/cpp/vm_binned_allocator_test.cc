@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/vm/memory_manager.h>
+
+#include <cstdint>
+
+#include "../../src/runtime/vm/binned_allocator.h"
+
+using namespace tvm::runtime;
+using namespace tvm::runtime::vm;
+
+namespace {
+
+const TVMContext kCtx = {kDLCPU, 0};
+const DLDataType kByte = {kDLUInt, 8, 1};
+
+// The offset of `b` from `a` in bytes
+std::ptrdiff_t Distance(const Buffer& a, const Buffer& b) {
+  return static_cast<uint8_t*>(b.data) - static_cast<uint8_t*>(a.data);
+}
+
+}  // namespace
+
+TEST(BinnedAllocator, SplitAndCoalesce) {
+  BinnedAllocator alloc(kCtx, 0, 4096);
+  Buffer a = alloc.Alloc(1000, 64, kByte);
+  Buffer b = alloc.Alloc(1000, 64, kByte);
+  EXPECT_EQ(a.size, 1024U);
+  EXPECT_EQ(Distance(a, b), 1024);
+  EXPECT_EQ(alloc.GetStats().num_chunks, 1U);
+  EXPECT_EQ(alloc.GetStats().num_reuses, 1U);
+  alloc.Free(a);
+  alloc.Free(b);
+  // The freed blocks merge back into the whole chunk
+  Buffer c = alloc.Alloc(4096, 64, kByte);
+  EXPECT_EQ(c.data, a.data);
+  EXPECT_EQ(alloc.GetStats().num_chunks, 1U);
+  alloc.Free(c);
+}
+
+TEST(BinnedAllocator, BestFit) {
+  BinnedAllocator alloc(kCtx, 0, 8192);
+  Buffer a = alloc.Alloc(1024, 64, kByte);
+  Buffer b = alloc.Alloc(1024, 64, kByte);
+  Buffer c = alloc.Alloc(512, 64, kByte);
+  Buffer d = alloc.Alloc(1024, 64, kByte);
+  alloc.Free(a);
+  alloc.Free(c);
+  // The 512 B hole fits better than the 1 KiB one and the rest of the chunk
+  Buffer e = alloc.Alloc(400, 64, kByte);
+  EXPECT_EQ(e.data, c.data);
+  Buffer f = alloc.Alloc(1000, 64, kByte);
+  EXPECT_EQ(f.data, a.data);
+  for (const Buffer& buf : {b, d, e, f}) alloc.Free(buf);
+}
+
+TEST(BinnedAllocator, TrimPastLimit) {
+  BinnedAllocator alloc(kCtx, 4096, 4096);
+  Buffer a = alloc.Alloc(4096, 64, kByte);
+  Buffer b = alloc.Alloc(4096, 64, kByte);
+  // Memory in use is never released, the limit is exceeded
+  EXPECT_EQ(alloc.GetStats().reserved, 8192U);
+  EXPECT_EQ(alloc.UsedMemory(), 8192U);
+  alloc.Free(a);
+  EXPECT_EQ(alloc.GetStats().reserved, 4096U);
+  EXPECT_EQ(alloc.GetStats().num_trims, 1U);
+  alloc.Free(b);
+  // Within the limit the free chunk stays cached
+  EXPECT_EQ(alloc.GetStats().reserved, 4096U);
+  Buffer c = alloc.Alloc(2048, 64, kByte);
+  EXPECT_EQ(c.data, b.data);
+  alloc.Free(c);
+}
+
+TEST(BinnedAllocator, Stats) {
+  BinnedAllocator alloc(kCtx, 0, 4096);
+  Buffer a = alloc.Alloc(1, 64, kByte);
+  Buffer b = alloc.Alloc(3000, 64, kByte);
+  BinnedAllocator::Stats stats = alloc.GetStats();
+  EXPECT_EQ(stats.in_use, 256U + 3072U);
+  EXPECT_EQ(stats.num_allocs, 2U);
+  alloc.Free(a);
+  alloc.Free(b);
+  stats = alloc.GetStats();
+  EXPECT_EQ(stats.in_use, 0U);
+  EXPECT_EQ(stats.peak_in_use, 256U + 3072U);
+  EXPECT_EQ(stats.reserved, 4096U);
+}
+
+TEST(BinnedAllocator, MemoryManager) {
+  // A device id no other test allocates on
+  TVMContext ctx = {kDLCPU, 900};
+  Allocator* alloc = MemoryManager::GetOrCreateAllocator(ctx, kBinned);
+  ASSERT_EQ(alloc->type(), kBinned);
+  NDArray array = alloc->Empty({16, 16}, DLDataType{kDLFloat, 32, 1}, ctx);
+  const PackedFunc* stat = Registry::Get("runtime.vm.AllocatorStat");
+  ASSERT_NE(stat, nullptr);
+  int64_t in_use = (*stat)(static_cast<int>(kDLCPU), 900, "in_use");
+  EXPECT_EQ(in_use, 1024);
+  array = NDArray();
+  in_use = (*stat)(static_cast<int>(kDLCPU), 900, "in_use");
+  EXPECT_EQ(in_use, 0);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
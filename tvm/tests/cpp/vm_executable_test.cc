@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/memory_io.h>
+#include <gtest/gtest.h>
+#include <tvm/runtime/c_runtime_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/vm/executable.h>
+#include <tvm/runtime/vm/vm.h>
+
+#include <string>
+#include <vector>
+
+#include "../../src/runtime/vm/serialize_utils.h"
+
+using namespace tvm::runtime;
+using namespace tvm::runtime::vm;
+
+namespace {
+
+const TVMContext kCPU = {kDLCPU, 0};
+
+Executable* SaveAndLoad(const ObjectPtr<Executable>& exec, Module* loaded) {
+  TVMByteArray bytes = exec->Save();
+  *loaded = Executable::Load(std::string(bytes.data, bytes.size), Module());
+  return static_cast<Executable*>(loaded->operator->());
+}
+
+}  // namespace
+
+TEST(VMExecutable, SaveLoadConstants) {
+  auto exec = make_object<Executable>();
+  for (int n : {3, 5}) {
+    NDArray constant = NDArray::Empty({n}, DLDataType{kDLFloat, 32, 1}, kCPU);
+    for (int i = 0; i < n; ++i) static_cast<float*>(constant->data)[i] = n * 10 + i;
+    exec->constants.push_back(constant);
+    exec->const_device_type.push_back(kDLCPU);
+  }
+  Module loaded;
+  Executable* result = SaveAndLoad(exec, &loaded);
+  ASSERT_EQ(result->constants.size(), 2U);
+  for (int k = 0; k < 2; ++k) {
+    NDArray constant = Downcast<NDArray>(result->constants[k]);
+    int n = k == 0 ? 3 : 5;
+    ASSERT_EQ(constant->shape[0], n);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(static_cast<float*>(constant->data)[i], n * 10 + i);
+    }
+  }
+  EXPECT_EQ(result->const_device_type, exec->const_device_type);
+}
+
+TEST(VMExecutable, SaveLoadShapeFuncs) {
+  auto exec = make_object<Executable>();
+  exec->primitive_map = {{"shape_func", 0}, {"kernel", 1}};
+  exec->shape_funcs = {0};
+  Module loaded;
+  Executable* result = SaveAndLoad(exec, &loaded);
+  EXPECT_EQ(result->primitive_map, exec->primitive_map);
+  EXPECT_EQ(result->shape_funcs, exec->shape_funcs);
+}
+
+TEST(VMExecutable, LoadFormatVersion0) {
+  // A file of the format before the format version, its constants are not padded, it has no
+  // memory scope or shape function table, and `AllocStorage` has no memory scope field.
+  std::string code;
+  dmlc::MemoryStringStream strm(&code);
+  strm.Write(kTVMVMBytecodeMagic);
+  strm.Write(std::string(TVM_VERSION));
+  strm.Write(std::vector<std::string>{"main"});
+  NDArray constant = NDArray::Empty({2}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  static_cast<float*>(constant->data)[0] = 1.0f;
+  static_cast<float*>(constant->data)[1] = 2.0f;
+  uint64_t num_constants = 1;
+  strm.Write(num_constants);
+  constant.Save(&strm);
+  strm.Write(std::vector<Index>{kDLCPU});
+  strm.Write(std::vector<std::string>{"kernel"});
+  uint64_t num_functions = 1;
+  strm.Write(num_functions);
+  VMFunctionSerializer("main", 2, 2, {}, {}).Save(&strm);
+  VMInstructionSerializer(static_cast<Index>(Opcode::AllocStorage), {0, 64, kDLFloat, 32, 1,
+                                                                     kDLCPU, 1})
+      .Save(&strm);
+  VMInstructionSerializer(static_cast<Index>(Opcode::Ret), {1}).Save(&strm);
+
+  Module loaded = Executable::Load(code, Module());
+  auto* result = static_cast<Executable*>(loaded.operator->());
+  ASSERT_EQ(result->constants.size(), 1U);
+  EXPECT_EQ(static_cast<float*>(Downcast<NDArray>(result->constants[0])->data)[1], 2.0f);
+  EXPECT_EQ(result->primitive_map.at("kernel"), 0);
+  EXPECT_TRUE(result->shape_funcs.empty());
+  ASSERT_EQ(result->functions.size(), 1U);
+  const Instruction& alloc = result->functions[0].instructions[0];
+  ASSERT_EQ(alloc.op, Opcode::AllocStorage);
+  EXPECT_EQ(alloc.dst, 1);
+  EXPECT_EQ(alloc.alloc_storage.device_type, kDLCPU);
+  EXPECT_EQ(result->memory_scopes.at(alloc.alloc_storage.memory_scope), "global");
+}
+
+TEST(VMExecutable, SaveLoadMemoryScopes) {
+  auto exec = make_object<Executable>();
+  exec->global_map = {{"main", 0}};
+  exec->memory_scopes = {"global", "texture"};
+  DLDataType dtype{kDLFloat, 32, 1};
+  std::vector<Instruction> instructions = {Instruction::AllocStorage(0, 64, dtype, kDLCPU, 1, 1),
+                                           Instruction::Ret(1)};
+  exec->functions.push_back(VMFunction("main", {}, instructions, 2, {}));
+  Module loaded;
+  Executable* result = SaveAndLoad(exec, &loaded);
+  EXPECT_EQ(result->memory_scopes, exec->memory_scopes);
+  const Instruction& alloc = result->functions[0].instructions[0];
+  EXPECT_EQ(result->memory_scopes.at(alloc.alloc_storage.memory_scope), "texture");
+  EXPECT_EQ(alloc.dst, 1);
+}
+
+TEST(VMExecutable, ForkOutlivesVirtualMachine) {
+  auto exec = make_object<Executable>();
+  exec->global_map = {{"main", 0}};
+  NDArray constant = NDArray::Empty({1}, DLDataType{kDLFloat, 32, 1}, kCPU);
+  static_cast<float*>(constant->data)[0] = 7.0f;
+  exec->constants.push_back(constant);
+  exec->const_device_type.push_back(kDLCPU);
+  std::vector<Instruction> instructions = {Instruction::LoadConst(0, 0), Instruction::Ret(0)};
+  exec->functions.push_back(VMFunction("main", {}, instructions, 1, {}));
+
+  auto vm = make_object<VirtualMachine>();
+  vm->LoadExecutable(exec.get());
+  Module vm_mod(vm);
+  vm_mod.GetFunction("init")(static_cast<int>(kDLCPU), 0,
+                             static_cast<int>(AllocatorType::kPooled));
+  Module context = vm_mod.GetFunction("fork")();
+  // The context keeps the virtual machine and the executable alive
+  exec.reset();
+  vm_mod = Module();
+  vm.reset();
+  PackedFunc invoke = context.GetFunction("invoke");
+  for (int i = 0; i < 2; ++i) {
+    NDArray result = invoke("main");
+    EXPECT_EQ(static_cast<float*>(result->data)[0], 7.0f);
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
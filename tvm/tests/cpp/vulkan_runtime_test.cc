@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace tvm::runtime;
+
+namespace {
+
+const TVMContext kVulkan = {kDLVulkan, 0};
+const DLDataType kFloat32 = {kDLFloat, 32, 1};
+
+// Whether the runtime is built with Vulkan and has a device, the tests pass trivially if not
+bool HasVulkan() {
+  if (Registry::Get("device_api.vulkan") == nullptr) return false;
+  TVMRetValue exist;
+  DeviceAPI::Get(kVulkan)->GetAttr(kVulkan, kExist, &exist);
+  return exist.type_code() != kTVMNullptr && static_cast<int>(exist);
+}
+
+// Whether the device also has the storage images without format backing the texture scopes
+bool HasVulkanTextures() {
+  if (!HasVulkan()) return false;
+  try {
+    NDArray::Empty({1, 1, 1, 4}, kFloat32, kVulkan, String("texture"));
+  } catch (const dmlc::Error&) {
+    return false;
+  }
+  return true;
+}
+
+std::vector<float> Iota(size_t size, float start) {
+  std::vector<float> values(size);
+  for (size_t i = 0; i < size; ++i) values[i] = start + static_cast<float>(i);
+  return values;
+}
+
+std::vector<float> ToVector(const NDArray& array, size_t size) {
+  std::vector<float> values(size);
+  array.CopyToBytes(values.data(), values.size() * sizeof(float));
+  return values;
+}
+
+}  // namespace
+
+TEST(VulkanTexture, CopiesThroughImages) {
+  if (!HasVulkanTextures()) return;
+  std::vector<int64_t> shape{2, 1, 3, 4, 4};
+  std::vector<float> values = Iota(96, 0.0f);
+  NDArray texture = NDArray::Empty(shape, kFloat32, kVulkan, String("texture"));
+  NDArray buffer = NDArray::Empty(shape, kFloat32, kVulkan);
+  NDArray weight = NDArray::Empty(shape, kFloat32, kVulkan, String("texture:weight"));
+  NDArray weight2 = NDArray::Empty(shape, kFloat32, kVulkan, String("texture:weight"));
+  NDArray array = NDArray::Empty(shape, kFloat32, kVulkan, String("texture:array"));
+  // host to image, image to buffer, buffer to image and image to image of the same layout
+  texture.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  texture.CopyTo(buffer);
+  buffer.CopyTo(weight);
+  weight.CopyTo(weight2);
+  array.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  for (const NDArray& result : {texture, buffer, weight, weight2, array}) {
+    EXPECT_EQ(ToVector(result, values.size()), values);
+  }
+}
+
+TEST(VulkanTexture, ViewOfLargerImage) {
+  if (!HasVulkanTextures()) return;
+  // A tensor of 2 rows planned into an image of 4 rows is copied through its rows only
+  NDArray texture = NDArray::Empty({1, 1, 4, 4, 4}, kFloat32, kVulkan, String("texture"));
+  std::vector<float> zeros(64, 0.0f);
+  texture.CopyFromBytes(zeros.data(), zeros.size() * sizeof(float));
+  NDArray view = texture.CreateView({1, 1, 2, 4, 4}, kFloat32);
+  std::vector<float> values = Iota(32, 1.0f);
+  view.CopyFromBytes(values.data(), values.size() * sizeof(float));
+  EXPECT_EQ(ToVector(view, values.size()), values);
+  std::vector<float> image = ToVector(texture, 64);
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), image.begin()));
+  EXPECT_TRUE(std::all_of(image.begin() + 32, image.end(), [](float v) { return v == 0.0f; }));
+}
+
+TEST(VulkanCopy, UploadsInFlight) {
+  if (!HasVulkan()) return;
+  // More uploads than staging buffers in the ring, each larger than the last, from one host
+  // array overwritten as soon as the upload returns
+  const size_t kUploads = 10;
+  NDArray host = NDArray::Empty({int64_t(kUploads) * 4096}, kFloat32, {kDLCPU, 0});
+  std::vector<NDArray> arrays;
+  for (size_t i = 0; i < kUploads; ++i) {
+    int64_t size = static_cast<int64_t>(i + 1) * 4096;
+    std::vector<float> values = Iota(size, static_cast<float>(i));
+    NDArray staging = host.CreateView({size}, kFloat32);
+    staging.CopyFromBytes(values.data(), values.size() * sizeof(float));
+    NDArray array = NDArray::Empty({size}, kFloat32, kVulkan);
+    array.CopyFrom(staging);
+    arrays.push_back(array);
+  }
+  // A device copy after the uploads sees their data
+  NDArray last = NDArray::Empty({int64_t(kUploads) * 4096}, kFloat32, kVulkan);
+  arrays.back().CopyTo(last);
+  for (size_t i = 0; i < kUploads; ++i) {
+    EXPECT_EQ(ToVector(arrays[i], (i + 1) * 4096), Iota((i + 1) * 4096, static_cast<float>(i)));
+  }
+  std::vector<float> expected = Iota(kUploads * 4096, static_cast<float>(kUploads - 1));
+  EXPECT_EQ(ToVector(last, kUploads * 4096), expected);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
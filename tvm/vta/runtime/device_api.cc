@@ -25,6 +25,11 @@
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/registry.h>
 
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "../../src/runtime/workspace_pool.h"
 #include "runtime.h"
 
@@ -91,5 +96,54 @@ static TVM_ATTRIBUTE_UNUSED auto& __register_dev__ =
           DeviceAPI* ptr = VTADeviceAPI::Global();
           *rv = static_cast<void*>(ptr);
         });
+
+// The arguments each stream of the calling thread was recorded with, by key.
+// The streams are recorded per command handle, which is per thread as well.
+static std::unordered_map<std::string, std::vector<uint64_t>>* RecordedArgs() {
+  static thread_local std::unordered_map<std::string, std::vector<uint64_t>> args;
+  return &args;
+}
+
+// The values a recorded stream depends on: the data addresses of the arrays
+// and the scalars, which the generated instructions embed.
+static std::vector<uint64_t> ArgWords(const TVMArgs& args) {
+  std::vector<uint64_t> words;
+  for (int i = 0; i < args.num_args; ++i) {
+    int tcode = args.type_codes[i];
+    if (tcode == kTVMDLTensorHandle || tcode == kTVMNDArrayHandle) {
+      const DLTensor* t = args[i];
+      words.push_back(reinterpret_cast<uintptr_t>(t->data) + t->byte_offset);
+    } else {
+      words.push_back(static_cast<uint64_t>(args.values[i].v_int64));
+    }
+  }
+  return words;
+}
+
+// Wrap an operator so that its device stream is generated once under key
+// and replayed on every later call with the same arguments. A call with
+// other arguments records the stream again.
+TVM_REGISTER_GLOBAL("vta.runtime.record_replay")
+    .set_body_typed([](PackedFunc f, std::string key) {
+      return PackedFunc([f, key](TVMArgs args, TVMRetValue* rv) {
+        VTACommandHandle cmd = VTATLSCommandHandle();
+        std::vector<uint64_t> words = ArgWords(args);
+        auto* recorded = RecordedArgs();
+        auto it = recorded->find(key);
+        if (it != recorded->end() && it->second == words && VTAReplay(cmd, key.c_str()) == 0) {
+          return;
+        }
+        recorded->erase(key);
+        VTARecordBegin(cmd, key.c_str());
+        f.CallPacked(args, rv);
+        VTARecordEnd(cmd);
+        (*recorded)[key] = std::move(words);
+      });
+    });
+
+TVM_REGISTER_GLOBAL("vta.runtime.clear_records").set_body_typed([]() {
+  VTAClearRecords(VTATLSCommandHandle());
+  RecordedArgs()->clear();
+});
 }  // namespace runtime
 }  // namespace tvm
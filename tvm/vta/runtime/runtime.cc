@@ -35,6 +35,8 @@
 #include <cassert>
 #include <cstring>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace vta {
@@ -293,6 +295,8 @@ class BaseQueue {
     CHECK(fpga_buff_phy_);
     return fpga_buff_phy_;
   }
+  /*! \return Host address of the FPGA accessible buffer. */
+  void* fpga_buffer() const { return fpga_buff_; }
   /*! \return Whether there is pending information. */
   bool pending() const { return sram_begin_ != sram_end_; }
   /*! \brief Initialize the space of the buffer. */
@@ -437,14 +441,19 @@ class UopQueue : public BaseQueue<VTAUop> {
       // Update offset
       offset += ksize;
     }
+    flushed_bytes_ = offset;
     // Flush if we're using a shared memory system
     // and if interface is non-coherent
     if (!coherent_ && always_cache_) {
       VTAFlushCache(fpga_buff_, fpga_buff_phy_, offset);
     }
   }
+  /*! \return Number of bytes copied to the FPGA buffer by the last read barrier. */
+  uint32_t flushed_bytes() const { return flushed_bytes_; }
 
  private:
+  // Bytes copied by the last read barrier
+  uint32_t flushed_bytes_{0};
   // Cache pointer
   uint32_t cache_idx_{0};
   // Cached ring, sorted by sram_begin
@@ -903,7 +912,10 @@ class CommandQueue {
     CHECK(device_ != nullptr);
   }
 
-  ~CommandQueue() { VTADeviceFree(device_); }
+  ~CommandQueue() {
+    ClearRecords();
+    VTADeviceFree(device_);
+  }
 
   uint32_t GetElemBytes(uint32_t memory_id) {
     uint32_t elem_bytes = 0;
@@ -982,6 +994,9 @@ class CommandQueue {
     if (!(debug_flag_ & VTA_DEBUG_SKIP_READ_BARRIER)) {
       uint32_t elem_bytes = (elem_bits + 8 - 1) / 8;
       DataBuffer::FromHandle(buffer)->FlushCache(elem_bytes * start, elem_bytes * extent);
+      if (recording_ != nullptr) {
+        RecordBarrier(RecordedStep::kFlush, buffer, elem_bytes * start, elem_bytes * extent);
+      }
     }
   }
 
@@ -989,6 +1004,9 @@ class CommandQueue {
     if (!(debug_flag_ & VTA_DEBUG_SKIP_WRITE_BARRIER)) {
       uint32_t elem_bytes = (elem_bits + 8 - 1) / 8;
       DataBuffer::FromHandle(buffer)->InvalidateCache(elem_bytes * start, elem_bytes * extent);
+      if (recording_ != nullptr) {
+        RecordBarrier(RecordedStep::kInvalidate, buffer, elem_bytes * start, elem_bytes * extent);
+      }
     }
   }
 
@@ -1023,6 +1041,9 @@ class CommandQueue {
 
     // Make sure that we don't exceed contiguous physical memory limits
     CHECK(insn_queue_.count() * sizeof(VTAGenericInsn) < VTA_MAX_XFER);
+    if (recording_ != nullptr) {
+      RecordRun(wait_cycles);
+    }
     int timeout =
         VTADeviceRun(device_, insn_queue_.dram_phy_addr(), insn_queue_.count(), wait_cycles);
     CHECK_EQ(timeout, 0);
@@ -1031,6 +1052,60 @@ class CommandQueue {
     insn_queue_.Reset();
   }
 
+  /*!
+   * \brief Start capturing everything sent to the device under a key.
+   *  The capture must begin and end on a synchronized queue.
+   */
+  void RecordBegin(const std::string& key) {
+    CHECK(recording_ == nullptr) << "Already recording VTA stream " << recording_key_;
+    CHECK_EQ(insn_queue_.count(), 0U) << "VTA stream recording must start after a synchronize";
+    FreeSteps(&records_[key]);
+    recording_ = &records_[key];
+    recording_key_ = key;
+  }
+
+  void RecordEnd() {
+    CHECK(recording_ != nullptr) << "No VTA stream is being recorded";
+    CHECK_EQ(insn_queue_.count(), 0U)
+        << "VTA stream " << recording_key_ << " must end with VTASynchronize";
+    recording_ = nullptr;
+    recording_key_.clear();
+  }
+
+  /*!
+   * \brief Resubmit a recorded stream.
+   * \return Whether a stream was recorded under the key.
+   */
+  bool Replay(const std::string& key) {
+    auto it = records_.find(key);
+    if (it == records_.end() || recording_ != nullptr) return false;
+    CHECK_EQ(insn_queue_.count(), 0U) << "VTA stream replay must start after a synchronize";
+    for (const RecordedStep& step : it->second) {
+      switch (step.kind) {
+        case RecordedStep::kFlush:
+          step.buffer->FlushCache(step.offset, step.size);
+          break;
+        case RecordedStep::kInvalidate:
+          step.buffer->InvalidateCache(step.offset, step.size);
+          break;
+        case RecordedStep::kRun: {
+          int timeout = VTADeviceRun(device_, step.insn_phy, step.insn_count, step.wait_cycles);
+          CHECK_EQ(timeout, 0);
+          break;
+        }
+      }
+    }
+    return true;
+  }
+
+  void ClearRecords() {
+    CHECK(recording_ == nullptr) << "Cannot clear while recording VTA stream " << recording_key_;
+    for (auto& kv : records_) {
+      FreeSteps(&kv.second);
+    }
+    records_.clear();
+  }
+
   // Get record kernel
   UopKernel* record_kernel() const {
     CHECK(record_kernel_ != nullptr);
@@ -1178,6 +1253,85 @@ class CommandQueue {
   // Auto sync when instruction overflow
   void AutoSync() { this->Synchronize(1 << 31); }
 
+  /*! \brief One host action of a recorded stream, replayed in order. */
+  struct RecordedStep {
+    enum Kind { kFlush, kInvalidate, kRun } kind;
+    // Data buffer and byte range of a barrier
+    DataBuffer* buffer{nullptr};
+    uint32_t offset{0};
+    uint32_t size{0};
+    // Private copies of the instruction and micro-op streams of a run
+    void* insn_buff{nullptr};
+    void* uop_buff{nullptr};
+    vta_phy_addr_t insn_phy{0};
+    uint32_t insn_count{0};
+    uint32_t wait_cycles{0};
+  };
+
+  void RecordBarrier(RecordedStep::Kind kind, void* buffer, uint32_t offset, uint32_t size) {
+    RecordedStep step;
+    step.kind = kind;
+    step.buffer = DataBuffer::FromHandle(buffer);
+    step.offset = offset;
+    step.size = size;
+    recording_->push_back(step);
+  }
+
+  // Copy the streams about to be run into buffers owned by the record.
+  // The queue buffers are reused by the next synchronize, so the micro-op
+  // loads are rebased onto the private copy.
+  void RecordRun(uint32_t wait_cycles) {
+    RecordedStep step;
+    step.kind = RecordedStep::kRun;
+    step.wait_cycles = wait_cycles;
+    step.insn_count = insn_queue_.count();
+    std::vector<VTAGenericInsn> insns(insn_queue_.data(), insn_queue_.data() + step.insn_count);
+
+    uint32_t uop_bytes = uop_queue_.flushed_bytes();
+    if (uop_bytes != 0) {
+      step.uop_buff = VTAMemAlloc(uop_bytes, kBufferCoherent || kAlwaysCache);
+      CHECK(step.uop_buff != nullptr);
+      VTAMemCopyFromHost(step.uop_buff, uop_queue_.fpga_buffer(), uop_bytes);
+      vta_phy_addr_t uop_phy = VTAMemGetPhyAddr(step.uop_buff);
+      if (!kBufferCoherent && kAlwaysCache) {
+        VTAFlushCache(step.uop_buff, uop_phy, uop_bytes);
+      }
+      for (VTAGenericInsn& insn : insns) {
+        VTAMemInsn* mem = reinterpret_cast<VTAMemInsn*>(&insn);
+        if (mem->opcode == VTA_OPCODE_LOAD && mem->memory_type == VTA_MEM_ID_UOP &&
+            mem->x_size != 0) {
+          vta_phy_addr_t offset = mem->dram_base * sizeof(VTAUop) - uop_queue_.dram_phy_addr();
+          mem->dram_base = (uop_phy + offset) / sizeof(VTAUop);
+        }
+      }
+    }
+
+    uint32_t insn_bytes = step.insn_count * sizeof(VTAGenericInsn);
+    step.insn_buff = VTAMemAlloc(insn_bytes, kBufferCoherent || kAlwaysCache);
+    CHECK(step.insn_buff != nullptr);
+    VTAMemCopyFromHost(step.insn_buff, insns.data(), insn_bytes);
+    step.insn_phy = VTAMemGetPhyAddr(step.insn_buff);
+    if (!kBufferCoherent && kAlwaysCache) {
+      VTAFlushCache(step.insn_buff, step.insn_phy, insn_bytes);
+    }
+    recording_->push_back(step);
+  }
+
+  static void FreeSteps(std::vector<RecordedStep>* steps) {
+    for (const RecordedStep& step : *steps) {
+      if (step.insn_buff != nullptr) VTAMemFree(step.insn_buff);
+      if (step.uop_buff != nullptr) VTAMemFree(step.uop_buff);
+    }
+    steps->clear();
+  }
+
+  // Recorded streams by key
+  std::unordered_map<std::string, std::vector<RecordedStep>> records_;
+  // The stream being recorded, nullptr if not recording
+  std::vector<RecordedStep>* recording_{nullptr};
+  // Key of the stream being recorded
+  std::string recording_key_;
+
   // Internal debug flag
   int debug_flag_{0};
   // The kernel we are currently recording
@@ -1298,3 +1452,17 @@ int VTADepPop(VTACommandHandle cmd, int from_qid, int to_qid) {
 void VTASynchronize(VTACommandHandle cmd, uint32_t wait_cycles) {
   static_cast<vta::CommandQueue*>(cmd)->Synchronize(wait_cycles);
 }
+
+void VTARecordBegin(VTACommandHandle cmd, const char* key) {
+  static_cast<vta::CommandQueue*>(cmd)->RecordBegin(key);
+}
+
+void VTARecordEnd(VTACommandHandle cmd) { static_cast<vta::CommandQueue*>(cmd)->RecordEnd(); }
+
+int VTAReplay(VTACommandHandle cmd, const char* key) {
+  return static_cast<vta::CommandQueue*>(cmd)->Replay(key) ? 0 : -1;
+}
+
+void VTAClearRecords(VTACommandHandle cmd) {
+  static_cast<vta::CommandQueue*>(cmd)->ClearRecords();
+}
@@ -253,6 +253,40 @@ TVM_DLL int VTADepPop(VTACommandHandle cmd, int from_qid, int to_qid);
  */
 TVM_DLL void VTASynchronize(VTACommandHandle cmd, uint32_t wait_cycles);
 
+/*!
+ * \brief Start recording the device stream of the command handle.
+ *  Every instruction and micro-op stream submitted by VTASynchronize,
+ *  together with the read/write barriers around it, is kept under the
+ *  key until VTARecordEnd, so that VTAReplay can resubmit it without
+ *  generating the instructions again.
+ *  The replayed stream refers to the same DRAM buffers, so they must stay
+ *  allocated at the same addresses, as in a graph runtime with static
+ *  storage.
+ * \param cmd The VTA command handle.
+ * \param key The key of the recorded stream, replacing any previous one.
+ */
+TVM_DLL void VTARecordBegin(VTACommandHandle cmd, const char* key);
+
+/*!
+ * \brief Stop recording. The last command must have been VTASynchronize.
+ * \param cmd The VTA command handle.
+ */
+TVM_DLL void VTARecordEnd(VTACommandHandle cmd);
+
+/*!
+ * \brief Resubmit a recorded stream and wait until it finishes.
+ * \param cmd The VTA command handle.
+ * \param key The key of the recorded stream.
+ * \return 0 if the stream was replayed, -1 if nothing is recorded under key.
+ */
+TVM_DLL int VTAReplay(VTACommandHandle cmd, const char* key);
+
+/*!
+ * \brief Release all the recorded streams of the command handle.
+ * \param cmd The VTA command handle.
+ */
+TVM_DLL void VTAClearRecords(VTACommandHandle cmd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,6 +35,12 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
 #include "../../src/runtime/meta_data.h"
 #include "../../src/runtime/vulkan/vulkan_shader.h"
 #include "../../src/runtime/workspace_pool.h"
@@ -74,13 +80,37 @@ class WebGPUDeviceAPI : public DeviceAPI {
     }
   }
 
+  // The freed buffers are kept for the next allocations, as the pages of a WorkspacePool, so
+  // that the NDArrays of every run and every loaded graph do not create GPU buffers again.
   void* AllocDataSpace(TVMContext ctx, size_t nbytes, size_t alignment,
                        DLDataType type_hint) final {
+    nbytes = (nbytes + (kBufferPageSize - 1)) / kBufferPageSize * kBufferPageSize;
+    if (nbytes == 0) nbytes = kBufferPageSize;
+    // The smallest free buffer that fits, when it is at most twice as large
+    auto it = free_buffers_.lower_bound(nbytes);
+    if (it != free_buffers_.end() && it->first <= 2 * nbytes) {
+      void* ptr = it->second;
+      pooled_bytes_ -= it->first;
+      free_buffers_.erase(it);
+      return ptr;
+    }
     double ptr_number = alloc_space_(nbytes);
-    return reinterpret_cast<void*>(static_cast<int64_t>(ptr_number));
+    void* ptr = reinterpret_cast<void*>(static_cast<int64_t>(ptr_number));
+    buffer_size_[ptr] = nbytes;
+    return ptr;
   }
 
-  void FreeDataSpace(TVMContext ctx, void* ptr) final { return free_space_(ptr); }
+  void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    auto it = buffer_size_.find(ptr);
+    CHECK(it != buffer_size_.end()) << "Free of a buffer not allocated by the WebGPU device API";
+    if (pooled_bytes_ + it->second <= kMaxPooledBytes) {
+      pooled_bytes_ += it->second;
+      free_buffers_.emplace(it->second, ptr);
+      return;
+    }
+    buffer_size_.erase(it);
+    free_space_(ptr);
+  }
 
  protected:
   void CopyDataFromTo(const void* from, size_t from_offset, void* to, size_t to_offset, size_t size,
@@ -140,6 +170,16 @@ class WebGPUDeviceAPI : public DeviceAPI {
   }
 
  private:
+  /*! \brief The granularity of the buffer sizes, that of the WorkspacePool pages. */
+  static constexpr size_t kBufferPageSize = 4 << 10;
+  /*! \brief The most bytes of free buffers kept for reuse. */
+  static constexpr size_t kMaxPooledBytes = 256 << 20;
+  // the size of every live or pooled buffer.
+  std::unordered_map<void*, size_t> buffer_size_;
+  // the free buffers by size.
+  std::multimap<size_t, void*> free_buffers_;
+  // the bytes of the free buffers.
+  size_t pooled_bytes_{0};
   // NOTE: js return number as double.
   TypedPackedFunc<double(int64_t nbytes)> alloc_space_;
   TypedPackedFunc<void(void* ptr)> free_space_;
@@ -180,7 +220,26 @@ class WebGPUModuleNode final : public runtime::ModuleNode {
       TVMByteArray arr;
       arr.data = reinterpret_cast<char*>(it->second.data.data());
       arr.size = it->second.data.size() * sizeof(it->second.data[0]);
-      return create_shader_(os.str(), arr);
+      // The pipelines are created once per shader and function info, for all the modules
+      // loaded by the page, e.g. the graphs of several models or of several loads of one.
+      // The key holds the function info and a hash of the shader, the least recently used
+      // pipelines are dropped beyond kMaxCachedPipelines.
+      std::string key = os.str() + "#" + std::to_string(ShaderHash(arr.data, arr.size));
+      static std::list<std::pair<std::string, PackedFunc>> pipelines;
+      static std::unordered_map<std::string, decltype(pipelines)::iterator> index;
+      auto pit = index.find(key);
+      if (pit != index.end()) {
+        pipelines.splice(pipelines.begin(), pipelines, pit->second);
+        return pit->second->second;
+      }
+      PackedFunc f = create_shader_(os.str(), arr);
+      pipelines.emplace_front(key, f);
+      index.emplace(std::move(key), pipelines.begin());
+      if (pipelines.size() > kMaxCachedPipelines) {
+        index.erase(pipelines.back().first);
+        pipelines.pop_back();
+      }
+      return f;
     } else {
       return PackedFunc(nullptr);
     }
@@ -198,6 +257,18 @@ class WebGPUModuleNode final : public runtime::ModuleNode {
   }
 
  private:
+  /*! \brief The number of pipelines kept for the modules loaded by the page. */
+  static constexpr size_t kMaxCachedPipelines = 256;
+
+  // 64-bit FNV-1a hash of a shader, size_t is 32-bit in wasm.
+  static uint64_t ShaderHash(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ULL;
+    }
+    return hash;
+  }
+
   // function information table.
   std::unordered_map<std::string, VulkanShader> smap_;
   // function information table.